@@ -0,0 +1,32 @@
+#****************************************************************************
+#* Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+#* All rights reserved.
+#* See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+#****************************************************************************
+
+# Optional scalable allocator replacing malloc()/free() for the whole process
+# Enabled with SCALABLE_MALLOC set to "mimalloc", "tbbmalloc" or "jemalloc", and
+# SCALABLE_MALLOC_ROOT set to the install prefix of the library(eg /usr on Linux)
+# OpenCascade memory management goes through malloc() only with MMGT_OPT=0, which is then the
+# default(see Application::setOpenCascadeEnvironment())
+# On Windows, mimalloc also requires mimalloc-redirect.dll next to the executable
+isEmpty(SCALABLE_MALLOC) {
+    message(scalable malloc OFF)
+} else {
+    message(scalable malloc ON: $$SCALABLE_MALLOC)
+    !isEmpty(SCALABLE_MALLOC_ROOT):LIBS += -L$$SCALABLE_MALLOC_ROOT/lib
+    equals(SCALABLE_MALLOC, mimalloc) {
+        win*:LIBS += -lmimalloc-override
+        else:LIBS += -lmimalloc
+    } else:equals(SCALABLE_MALLOC, tbbmalloc) {
+        LIBS += -ltbbmalloc_proxy -ltbbmalloc
+    } else:equals(SCALABLE_MALLOC, jemalloc) {
+        LIBS += -ljemalloc
+    } else {
+        error(Unknown SCALABLE_MALLOC '$$SCALABLE_MALLOC')
+    }
+
+    # Linker must keep the library even if none of its symbols is used directly
+    *g++*|*clang*:QMAKE_LFLAGS += -Wl,--no-as-needed
+    DEFINES += MAYO_SCALABLE_MALLOC=\\\"$$SCALABLE_MALLOC\\\"
+}
@@ -0,0 +1,108 @@
+#****************************************************************************
+#* Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+#* All rights reserved.
+#* See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+#****************************************************************************
+
+# Headless file converter, links neither QtGui nor the OpenCascade visualization toolkits
+
+TEMPLATE = app
+TARGET = mayo-conv
+include(version.pri)
+
+QT = core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+*msvc* {
+    QMAKE_CXXFLAGS += /std:c++17
+}
+*g++*|*clang* {
+    QMAKE_CXXFLAGS += -std=c++17
+}
+*clang* {
+    # Silent Clang warnings about instantiation of variable 'Mayo::GenericProperty<T>::TypeName'
+    QMAKE_CXXFLAGS += -Wno-undefined-var-template
+}
+*clang-libc++* {
+    LIBS += -lc++fs
+}
+macx {
+    QMAKE_MACOSX_DEPLOYMENT_TARGET = 10.14
+}
+
+*win* {
+    LIBS += -lPsapi
+}
+
+INCLUDEPATH += \
+    src/3rdparty
+
+HEADERS += \
+    $$files(src/base/*.h) \
+    $$files(src/io_occ/*.h) \
+    $$files(src/io_ply/*.h) \
+    $$files(src/io_point_cloud/*.h) \
+    $$files(src/cli/*.h) \
+    $$files(src/conv/*.h) \
+
+SOURCES += \
+    $$files(src/base/*.cpp) \
+    $$files(src/io_occ/*.cpp) \
+    $$files(src/io_ply/*.cpp) \
+    $$files(src/io_point_cloud/*.cpp) \
+    $$files(src/cli/*.cpp) \
+    $$files(src/conv/*.cpp) \
+
+# OpenCascade
+include(opencascade.pri)
+message(OpenCascade version $$OCC_VERSION_STR)
+LIBS += -lTKernel -lTKMath -lTKBRep -lTKGeomBase -lTKGeomAlgo -lTKTopAlgo -lTKPrim -lTKMesh -lTKG2d -lTKG3d
+LIBS += -lTKShHealing -lTKBO -lTKBool -lTKHLR
+LIBS += -lTKXSBase
+LIBS += -lTKLCAF -lTKXCAF -lTKCAF -lTKVCAF
+LIBS += -lTKCDF -lTKBin -lTKBinL -lTKBinXCAF -lTKXml -lTKXmlL -lTKXmlXCAF
+# -- IGES support
+LIBS += -lTKIGES -lTKXDEIGES
+# -- STEP support
+LIBS += -lTKSTEP -lTKSTEP209 -lTKSTEPAttr -lTKSTEPBase -lTKXDESTEP
+# -- STL support
+LIBS += -lTKSTL
+# -- OBJ/glTF support
+minOpenCascadeVersion(7, 4, 0) {
+    LIBS += -lTKRWMesh
+} else {
+    SOURCES -= \
+        src/io_occ/io_occ_base_mesh.cpp \
+        src/io_occ/io_occ_gltf_reader.cpp \
+        src/io_occ/io_occ_obj.cpp
+}
+
+!minOpenCascadeVersion(7, 5, 0) {
+    SOURCES -= src/io_occ/io_occ_gltf_writer.cpp
+}
+
+# -- VRML support
+LIBS += -lTKVRML
+
+# zlib
+include(zlib.pri)
+contains(DEFINES, HAVE_ZLIB) {
+    HEADERS += $$files(src/io_3mf/*.h)
+    SOURCES += $$files(src/io_3mf/*.cpp)
+}
+
+# Scalable malloc
+include(malloc.pri)
+
+# gmio
+!isEmpty(GMIO_ROOT) {
+    HEADERS += $$files(src/io_gmio/*.h)
+    SOURCES += $$files(src/io_gmio/*.cpp)
+
+    INCLUDEPATH += $$GMIO_ROOT/include
+    LIBS += -L$$GMIO_ROOT/lib -lgmio_static -lzlibstatic
+    SOURCES += $$GMIO_ROOT/src/gmio_support/stream_qt.cpp
+    DEFINES += HAVE_GMIO
+}
@@ -51,7 +51,7 @@ macx {
 }
 
 *win* {
-    LIBS += -lUser32
+    LIBS += -lUser32 -lPsapi
 }
 
 INCLUDEPATH += \
@@ -61,6 +61,9 @@ INCLUDEPATH += \
 HEADERS += \
     $$files(src/base/*.h) \
     $$files(src/io_occ/*.h) \
+    $$files(src/io_ply/*.h) \
+    $$files(src/io_point_cloud/*.h) \
+    $$files(src/cli/*.h) \
     $$files(src/graphics/*.h) \
     $$files(src/gui/*.h) \
     $$files(src/app/*.h) \
@@ -68,6 +71,9 @@ HEADERS += \
 SOURCES += \
     $$files(src/base/*.cpp) \
     $$files(src/io_occ/*.cpp) \
+    $$files(src/io_ply/*.cpp) \
+    $$files(src/io_point_cloud/*.cpp) \
+    $$files(src/cli/*.cpp) \
     $$files(src/graphics/*.cpp) \
     $$files(src/gui/*.cpp) \
     $$files(src/app/*.cpp) \
@@ -155,6 +161,16 @@ minOpenCascadeVersion(7, 4, 0) {
 # -- VRML support
 LIBS += -lTKVRML
 
+# zlib
+include(zlib.pri)
+contains(DEFINES, HAVE_ZLIB) {
+    HEADERS += $$files(src/io_3mf/*.h)
+    SOURCES += $$files(src/io_3mf/*.cpp)
+}
+
+# Scalable malloc
+include(malloc.pri)
+
 CASCADE_LIST_OPTBIN_DIR = $$split(CASCADE_OPTBIN_DIRS, ;)
 for(binPath, CASCADE_LIST_OPTBIN_DIR) {
     lowerBinPath = $$lower($${binPath})
@@ -7,21 +7,42 @@
 #include "app_module.h"
 
 #include "../base/application.h"
-#include "../base/bnd_utils.h"
+#include "../base/brep_mesh_cache.h"
+#include "../base/brep_mesh_priorities.h"
+#include "../base/brep_mesh_quality.h"
 #include "../base/brep_utils.h"
+#include "../base/caf_utils.h"
+#include "../base/document.h"
+#include "../base/global.h"
 #include "../base/io_reader.h"
 #include "../base/io_writer.h"
 #include "../base/io_system.h"
+#include "../base/mesh_decimation.h"
+#include "../base/mesh_utils.h"
 #include "../base/occt_enums.h"
 #include "../base/settings.h"
+#include "../base/task_manager.h"
+#include "../base/task_progress.h"
 #include "../graphics/graphics_object_driver.h"
 #include "../gui/gui_application.h"
 #include "../gui/gui_document.h"
 
-#include <BRepBndLib.hxx>
+#include <BRepTools.hxx>
+#include <BRep_Builder.hxx>
+#include <TopLoc_Location.hxx>
+#include <TopTools_DataMapOfShapeInteger.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TDataXtd_Triangulation.hxx>
+#include <QtCore/QBuffer>
+#include <QtCore/QCryptographicHash>
 #include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QStandardPaths>
 #include <QtGui/QGuiApplication>
+#include <algorithm>
 #include <iterator>
+#include <mutex>
+#include <thread>
 
 namespace Mayo {
 
@@ -57,6 +78,20 @@ AppModule::AppModule(Application* app)
     this->unitSystemDecimals.setRange(1, 99);
     this->unitSystemDecimals.setSingleStep(1);
     this->unitSystemDecimals.setConstraintsEnabled(true);
+    // -- Tasks
+    this->taskPoolSize.setDescription(
+                tr("Maximum count of tasks(eg import of a file) running concurrently, others are "
+                   "queued until running ones are finished. Value 0 means the count of hardware threads"));
+    settings->addSetting(&this->taskPoolSize, this->groupId_system);
+    this->taskPoolSize.setRange(0, 1024);
+    this->taskPoolSize.setSingleStep(1);
+    this->taskPoolSize.setConstraintsEnabled(true);
+    this->fileReadAhead.setDescription(
+                tr("Read input files by large blocks on a worker thread while they are parsed, which "
+                   "speeds up the import of files located on slow storage(eg network shares). Applies "
+                   "to the formats whose readers parse streams(eg STEP, STL, PLY, BRep) and to "
+                   "compressed files"));
+    settings->addSetting(&this->fileReadAhead, this->groupId_system);
 
     // Application
     this->language.setDescription(
@@ -64,14 +99,38 @@ AppModule::AppModule(Application* app)
     this->linkWithDocumentSelector.setDescription(
                 tr("In case where multiple documents are opened, make sure the document displayed in "
                    "the 3D view corresponds to what is selected in the model tree"));
+    this->importDeduplicateGeometry.setDescription(
+                tr("When many files are imported at once, parts having the same geometry and color "
+                   "in different files are merged into a single shared part. They are then meshed "
+                   "once and displayed as instances"));
+    this->importViewerOnlyDocuments.setDescription(
+                tr("Documents of opened files don't keep any undo information(OCAF transactions and "
+                   "attribute deltas), which saves time and memory on large imports"));
+    this->autoReloadModifiedFiles.setDescription(
+                tr("When the file of an opened document is modified by another program, import it "
+                   "again in background. Camera, hidden and selected items are kept where matching"));
+    this->prefetchHoveredRecentFile.setDescription(
+                tr("Read in background the recent file under the mouse cursor in the home page, so "
+                   "opening it is faster. Consumes memory and CPU for files that may not be opened"));
+    this->restoreLastSession.setDescription(
+                tr("On exit, the opened documents are recorded along with their view camera, hidden "
+                   "and selected items. They are opened again on next start, view state being kept "
+                   "for files not modified meanwhile. Enable the mesh cache so shapes aren't meshed again"));
     settings->addSetting(&this->language, this->groupId_application);
     settings->addSetting(&this->recentFiles, this->groupId_application);
     settings->addSetting(&this->lastOpenDir, this->groupId_application);
     settings->addSetting(&this->lastSelectedFormatFilter, this->groupId_application);
     settings->addSetting(&this->linkWithDocumentSelector, this->groupId_application);
+    settings->addSetting(&this->importDeduplicateGeometry, this->groupId_application);
+    settings->addSetting(&this->importViewerOnlyDocuments, this->groupId_application);
+    settings->addSetting(&this->autoReloadModifiedFiles, this->groupId_application);
+    settings->addSetting(&this->prefetchHoveredRecentFile, this->groupId_application);
+    settings->addSetting(&this->restoreLastSession, this->groupId_application);
+    settings->addSetting(&this->lastSession, this->groupId_application);
     this->recentFiles.setUserVisible(false);
     this->lastOpenDir.setUserVisible(false);
     this->lastSelectedFormatFilter.setUserVisible(false);
+    this->lastSession.setUserVisible(false);
 
     // Meshing
     this->meshingQuality.setDescription(
@@ -88,10 +147,38 @@ AppModule::AppModule(Application* app)
                    "If activated, deflection used for the polygonalisation of each edge will be "
                    "`ChordalDeflection` &#215; `SizeOfEdge`. The deflection used for the faces will be "
                    "the maximum deflection of their edges."));
+    this->meshingTriangleBudget.setDescription(
+                tr("Targeted count of triangles(in thousands) for the BRep shapes imported at once, "
+                   "when meshing quality is `TriangleBudget`. Triangles of each face are "
+                   "estimated from its area and curvature, big shapes get more triangles than "
+                   "small ones"));
     settings->addSetting(&this->meshingQuality, this->groupId_meshing);
     settings->addSetting(&this->meshingChordalDeflection, this->groupId_meshing);
     settings->addSetting(&this->meshingAngularDeflection, this->groupId_meshing);
+    settings->addSetting(&this->meshingTriangleBudget, this->groupId_meshing);
+    this->meshingTriangleBudget.setRange(10, 1000 * 1000);
+    this->meshingTriangleBudget.setSingleStep(500);
+    this->meshingTriangleBudget.setConstraintsEnabled(true);
+    this->meshingCacheEnabled.setDescription(
+                tr("Save computed meshes in a cache, so they can be reused when the same file is "
+                   "opened again with the same meshing parameters"));
     settings->addSetting(&this->meshingRelative, this->groupId_meshing);
+    settings->addSetting(&this->meshingCacheEnabled, this->groupId_meshing);
+    this->meshingProgressive.setDescription(
+                tr("Display imported shapes as soon as possible with a very coarse mesh, the mesh "
+                   "is then refined in background with the current meshing parameters"));
+    settings->addSetting(&this->meshingProgressive, this->groupId_meshing);
+    this->meshingLevelOfDetails.setDescription(
+                tr("Compute coarser meshes in background, shapes appearing small in the 3D view "
+                   "are then displayed with less triangles\n\n"
+                   "Requires OpenCascade >= 7.6.0"));
+    settings->addSetting(&this->meshingLevelOfDetails, this->groupId_meshing);
+    this->meshingSinglePrecision.setDescription(
+                tr("Store the nodes of meshes(imported or computed from BRep shapes) in single "
+                   "precision, which halves their memory. Suitable for visualization, node "
+                   "coordinates are then rounded to about 7 significant digits\n\n"
+                   "Requires OpenCascade >= 7.6.0"));
+    settings->addSetting(&this->meshingSinglePrecision, this->groupId_meshing);
 
     // Graphics
     this->defaultShowOriginTrihedron.setDescription(
@@ -99,6 +186,67 @@ AppModule::AppModule(Application* app)
                    "This doesn't affect 3D view of currently opened documents"));
     settings->addSetting(&this->defaultShowOriginTrihedron, this->groupId_graphics);
     settings->addSetting(&this->instantZoomFactor, this->groupId_graphics);
+    this->viewInteractionCullingSize.setDescription(
+                tr("While the 3D view is rotated or panned, objects appearing smaller than this size "
+                   "(in pixels) are not drawn. Value 0 disables culling"));
+    settings->addSetting(&this->viewInteractionCullingSize, this->groupId_graphics);
+    this->viewInteractionCullingSize.setRange(0, 1000);
+    this->viewInteractionCullingSize.setSingleStep(1);
+    this->viewInteractionCullingSize.setConstraintsEnabled(true);
+    this->viewInteractionPlainShaded.setDescription(
+                tr("While the 3D view is rotated or panned, shapes are displayed without face "
+                   "boundaries"));
+    settings->addSetting(&this->viewInteractionPlainShaded, this->groupId_graphics);
+    this->graphicsMemoryBudget.setDescription(
+                tr("Maximum memory(in megabytes) of graphics presentations. When exceeded, presentations "
+                   "of hidden objects and of documents not currently viewed are released, least "
+                   "recently viewed first. They are computed again when shown. Value 0 means no limit"));
+    settings->addSetting(&this->graphicsMemoryBudget, this->groupId_graphics);
+    this->graphicsMemoryBudget.setRange(0, 1024 * 1024);
+    this->graphicsMemoryBudget.setSingleStep(256);
+    this->graphicsMemoryBudget.setConstraintsEnabled(true);
+    this->graphicsCompactHiddenMeshesDelay.setDescription(
+                tr("Delay(in seconds) after which the meshes of hidden objects are compressed in "
+                   "memory, about 3 times smaller. They are decompressed when shown again. Requires "
+                   "OpenCascade >= v7.6.0. Value 0 means no compression"));
+    settings->addSetting(&this->graphicsCompactHiddenMeshesDelay, this->groupId_graphics);
+    this->graphicsCompactHiddenMeshesDelay.setRange(0, 24 * 3600);
+    this->graphicsCompactHiddenMeshesDelay.setSingleStep(10);
+    this->graphicsCompactHiddenMeshesDelay.setConstraintsEnabled(true);
+    this->graphicsStaticBatching.setDescription(
+                tr("Merge the small parts instantiated once into a single object per color, so "
+                   "assemblies of thousands of parts are drawn much faster. Merged parts are always "
+                   "shaded and don't move when exploding the assembly. Applies to documents opened "
+                   "afterwards"));
+    settings->addSetting(&this->graphicsStaticBatching, this->groupId_graphics);
+    this->graphicsIdBufferPicking.setDescription(
+                tr("Detect the objects under the mouse cursor by reading an offscreen image of object "
+                   "identifiers, rendered once the 3D view stops moving. Faster than the default "
+                   "picking for scenes of thousands of parts. Selection of sub-shapes(faces, edges, "
+                   "vertices) isn't affected\n\n"
+                   "Requires OpenCascade >= 7.4.0"));
+    settings->addSetting(&this->graphicsIdBufferPicking, this->groupId_graphics);
+    this->graphicsSelectionOutline.setDescription(
+                tr("Draw selected objects with an outline instead of recoloring them, selecting big "
+                   "assemblies is then much faster. Selected sub-shapes(faces, edges, vertices) "
+                   "are still recolored\n\n"
+                   "Requires OpenCascade >= 7.5.0"));
+    settings->addSetting(&this->graphicsSelectionOutline, this->groupId_graphics);
+    this->graphicsTransparencyMethod.setDescription(
+                tr("Method used to render transparent objects(eg ghosted parts of assemblies)\n\n"
+                   "`Blended` is the fastest but wrong where transparent objects overlap. "
+                   "`WeightedOit` keeps a single pass whatever the count of overlapping objects. "
+                   "`DepthPeeling` is the most accurate but the slowest, requires OpenCascade >= 7.5.0"));
+    this->graphicsTransparencyMethod.mutableEnumeration().changeTrContext(AppModule::textIdContext());
+    settings->addSetting(&this->graphicsTransparencyMethod, this->groupId_graphics);
+    this->pointCloudPointBudget.setDescription(
+                tr("Maximum count of points(in thousands) drawn for the point clouds of a document. "
+                   "Parts of the clouds appearing the biggest in the 3D view are drawn first, the "
+                   "others are refined progressively when the view stops moving"));
+    settings->addSetting(&this->pointCloudPointBudget, this->groupId_graphics);
+    this->pointCloudPointBudget.setRange(100, 100 * 1000);
+    this->pointCloudPointBudget.setSingleStep(500);
+    this->pointCloudPointBudget.setConstraintsEnabled(true);
     // -- Clip planes
     this->clipPlanesCappingOn.setDescription(
                 tr("Enable capping of currently clipped graphics"));
@@ -110,40 +258,24 @@ AppModule::AppModule(Application* app)
     settings->addSetting(&this->meshDefaultsColor, this->sectionId_graphicsMeshDefaults);
     settings->addSetting(&this->meshDefaultsEdgeColor, this->sectionId_graphicsMeshDefaults);
     settings->addSetting(&this->meshDefaultsMaterial, this->sectionId_graphicsMeshDefaults);
+    this->meshDefaultsShowEdges.setDescription(
+                tr("Show the boundary edges and the crease edges of meshes"));
+    this->meshDefaultsEdgeCreaseAngle.setDescription(
+                tr("Minimum angle between two adjacent triangles for their common edge to be shown"));
     settings->addSetting(&this->meshDefaultsShowEdges, this->sectionId_graphicsMeshDefaults);
+    settings->addSetting(&this->meshDefaultsEdgeCreaseAngle, this->sectionId_graphicsMeshDefaults);
     settings->addSetting(&this->meshDefaultsShowNodes, this->sectionId_graphicsMeshDefaults);
-    // Import
+    // Import/export parameters are created on first use, see findFormatParameters()
     auto groupId_Import = settings->addGroup(textId("import"));
     for (const IO::Format& format : app->ioSystem()->readerFormats()) {
         auto sectionId_format = settings->addSection(groupId_Import, format.identifier);
-        const IO::FactoryReader* factory = app->ioSystem()->findFactoryReader(format);
-        std::unique_ptr<PropertyGroup> ptrGroup = factory->createProperties(format, settings);
-        if (ptrGroup) {
-            for (Property* property : ptrGroup->properties())
-                settings->addSetting(property, sectionId_format);
-
-            PropertyGroup* rawPtrGroup = ptrGroup.get();
-            settings->addResetFunction(sectionId_format, [=]{ rawPtrGroup->restoreDefaults(); });
-            m_mapFormatReaderParameters.insert({ format.identifier, rawPtrGroup });
-            m_vecPtrPropertyGroup.push_back(std::move(ptrGroup));
-        }
+        m_mapFormatReaderParameters.insert({ format.identifier, { sectionId_format } });
     }
 
-    // Export
     auto groupId_Export = settings->addGroup(textId("export"));
     for (const IO::Format& format : app->ioSystem()->writerFormats()) {
         auto sectionId_format = settings->addSection(groupId_Export, format.identifier);
-        const IO::FactoryWriter* factory = app->ioSystem()->findFactoryWriter(format);
-        std::unique_ptr<PropertyGroup> ptrGroup = factory->createProperties(format, settings);
-        if (ptrGroup) {
-            for (Property* property : ptrGroup->properties())
-                settings->addSetting(property, sectionId_format);
-
-            PropertyGroup* rawPtrGroup = ptrGroup.get();
-            settings->addResetFunction(sectionId_format, [=]{ rawPtrGroup->restoreDefaults(); });
-            m_mapFormatWriterParameters.insert({ format.identifier, ptrGroup.get() });
-            m_vecPtrPropertyGroup.push_back(std::move(ptrGroup));
-        }
+        m_mapFormatWriterParameters.insert({ format.identifier, { sectionId_format } });
     }
 
     // Register reset functions
@@ -151,22 +283,46 @@ AppModule::AppModule(Application* app)
         this->unitSystemDecimals.setValue(2);
         this->unitSystemSchema.setValue(UnitSystem::SI);
     });
+    settings->addResetFunction(this->groupId_system, [=]{
+        this->taskPoolSize.setValue(0);
+        this->fileReadAhead.setValue(false);
+    });
     settings->addResetFunction(this->groupId_application, [&]{
         this->language.setValue(enumLanguages.findValue("en"));
         this->recentFiles.setValue({});
         this->lastOpenDir.setValue(QString());
         this->lastSelectedFormatFilter.setValue(QString());
         this->linkWithDocumentSelector.setValue(true);
+        this->importDeduplicateGeometry.setValue(false);
+        this->importViewerOnlyDocuments.setValue(true);
+        this->autoReloadModifiedFiles.setValue(false);
+        this->prefetchHoveredRecentFile.setValue(false);
+        this->restoreLastSession.setValue(false);
+        this->lastSession.setValue({});
     });
     settings->addResetFunction(this->groupId_graphics, [=]{
         this->defaultShowOriginTrihedron.setValue(true);
         this->instantZoomFactor.setValue(5.);
+        this->viewInteractionCullingSize.setValue(0);
+        this->viewInteractionPlainShaded.setValue(false);
+        this->graphicsMemoryBudget.setValue(0);
+        this->graphicsCompactHiddenMeshesDelay.setValue(0);
+        this->graphicsStaticBatching.setValue(false);
+        this->graphicsIdBufferPicking.setValue(false);
+        this->graphicsSelectionOutline.setValue(false);
+        this->graphicsTransparencyMethod.setValue(TransparencyMethod::Blended);
+        this->pointCloudPointBudget.setValue(5000);
     });
     settings->addResetFunction(this->groupId_meshing, [&]{
         this->meshingQuality.setValue(BRepMeshQuality::Normal);
         this->meshingChordalDeflection.setQuantity(1 * Quantity_Millimeter);
         this->meshingAngularDeflection.setQuantity(20 * Quantity_Degree);
         this->meshingRelative.setValue(false);
+        this->meshingTriangleBudget.setValue(2000);
+        this->meshingCacheEnabled.setValue(false);
+        this->meshingProgressive.setValue(false);
+        this->meshingLevelOfDetails.setValue(false);
+        this->meshingSinglePrecision.setValue(false);
     });
     settings->addResetFunction(this->sectionId_graphicsClipPlanes, [=]{
         this->clipPlanesCappingOn.setValue(true);
@@ -178,6 +334,7 @@ AppModule::AppModule(Application* app)
         this->meshDefaultsEdgeColor.setValue(meshDefaults.edgeColor);
         this->meshDefaultsMaterial.setValue(meshDefaults.material);
         this->meshDefaultsShowEdges.setValue(meshDefaults.showEdges);
+        this->meshDefaultsEdgeCreaseAngle.setQuantity(meshDefaults.edgeCreaseAngle * Quantity_Radian);
         this->meshDefaultsShowNodes.setValue(meshDefaults.showNodes);
     });
 }
@@ -211,14 +368,61 @@ bool AppModule::excludeSettingPredicate(const Property& prop)
 
 const PropertyGroup* AppModule::findReaderParameters(const IO::Format& format) const
 {
-    auto it = m_mapFormatReaderParameters.find(format.identifier);
-    return it != m_mapFormatReaderParameters.cend() ? it->second : nullptr;
+    return this->findFormatParameters(format, FormatParametersType::Reader);
 }
 
 const PropertyGroup* AppModule::findWriterParameters(const IO::Format& format) const
 {
-    auto it = m_mapFormatWriterParameters.find(format.identifier);
-    return it != m_mapFormatWriterParameters.cend() ? it->second : nullptr;
+    return this->findFormatParameters(format, FormatParametersType::Writer);
+}
+
+void AppModule::createAllFormatParameters()
+{
+    for (const IO::Format& format : m_app->ioSystem()->readerFormats())
+        this->findFormatParameters(format, FormatParametersType::Reader);
+
+    for (const IO::Format& format : m_app->ioSystem()->writerFormats())
+        this->findFormatParameters(format, FormatParametersType::Writer);
+}
+
+PropertyGroup* AppModule::findFormatParameters(const IO::Format& format, FormatParametersType type) const
+{
+    // Might be called concurrently by import/export tasks
+    std::lock_guard<std::mutex> lock(m_mutexFormatParameters); MAYO_UNUSED(lock);
+    auto& mapFormatParameters =
+            type == FormatParametersType::Reader ? m_mapFormatReaderParameters : m_mapFormatWriterParameters;
+    auto it = mapFormatParameters.find(format.identifier);
+    if (it == mapFormatParameters.end())
+        return nullptr;
+
+    FormatParameters& params = it->second;
+    if (params.isCreated)
+        return params.ptrGroup;
+
+    // Stored values are loaded by Settings::addSetting()
+    params.isCreated = true;
+    Settings* settings = m_app->settings();
+    std::unique_ptr<PropertyGroup> ptrGroup;
+    if (type == FormatParametersType::Reader) {
+        const IO::FactoryReader* factory = m_app->ioSystem()->findFactoryReader(format);
+        ptrGroup = factory ? factory->createProperties(format, settings) : nullptr;
+    }
+    else {
+        const IO::FactoryWriter* factory = m_app->ioSystem()->findFactoryWriter(format);
+        ptrGroup = factory ? factory->createProperties(format, settings) : nullptr;
+    }
+
+    if (ptrGroup) {
+        for (Property* property : ptrGroup->properties())
+            settings->addSetting(property, params.sectionId);
+
+        PropertyGroup* rawPtrGroup = ptrGroup.get();
+        settings->addResetFunction(params.sectionId, [=]{ rawPtrGroup->restoreDefaults(); });
+        params.ptrGroup = rawPtrGroup;
+        m_vecPtrPropertyGroup.push_back(std::move(ptrGroup));
+    }
+
+    return params.ptrGroup;
 }
 
 QVariant AppModule::toVariant(const Property& prop) const
@@ -257,6 +461,7 @@ void AppModule::prependRecentFile(const FilePath& fp)
 {
     const RecentFile* ptrRecentFile = this->findRecentFile(fp);
     RecentFiles newRecentFiles = this->recentFiles.value();
+    std::vector<RecentFile> vecRemovedRecentFile;
     if (ptrRecentFile) {
         RecentFile& firstRecentFile = newRecentFiles.front();
         RecentFile& recentFile = newRecentFiles.at(ptrRecentFile - &this->recentFiles.value().front());
@@ -267,11 +472,15 @@ void AppModule::prependRecentFile(const FilePath& fp)
         recentFile.filepath = fp;
         newRecentFiles.insert(newRecentFiles.begin(), std::move(recentFile));
         constexpr int sizeLimit = 15;
-        while (newRecentFiles.size() > sizeLimit)
+        while (newRecentFiles.size() > sizeLimit) {
+            vecRemovedRecentFile.push_back(newRecentFiles.back());
             newRecentFiles.pop_back();
+        }
     }
 
     this->recentFiles.setValue(newRecentFiles);
+    for (const RecentFile& removedRecentFile : vecRemovedRecentFile)
+        this->removeUnusedRecentFileThumbnail(removedRecentFile);
 }
 
 const RecentFile* AppModule::findRecentFile(const FilePath& fp) const
@@ -299,109 +508,490 @@ void AppModule::recordRecentFileThumbnail(GuiDocument* guiDoc)
     if (!recentFile->isThumbnailOutOfSync())
         return;
 
-    RecentFile newRecentFile = *recentFile;
-    const bool okRecord = newRecentFile.recordThumbnail(guiDoc, this->recentFileThumbnailSize());
-    if (!okRecord)
+    // Only the rendering is done in the GUI thread, image encoding and file writing are left to a
+    // worker thread
+    const QImage imgThumbnail = RecentFile::renderThumbnail(guiDoc, this->recentFileThumbnailSize());
+    if (imgThumbnail.isNull())
         return;
 
-    const RecentFiles& listRecentFile = this->recentFiles.value();
-    RecentFiles newListRecentFile = listRecentFile;
-    const auto indexRecentFile = std::distance(&listRecentFile.front(), recentFile);
-    newListRecentFile.at(indexRecentFile) = newRecentFile;
-    this->recentFiles.setValue(newListRecentFile);
+    const FilePath recentFilePath = recentFile->filepath;
+    const int64_t timestamp = RecentFile::lastModifiedTimestamp(recentFilePath);
+    const FilePath dirPath = this->recentFileThumbnailCacheDirPath();
+    auto ptrThumbnailHash = std::make_shared<QByteArray>();
+    auto taskMgr = TaskManager::globalInstance();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress*) {
+        QByteArray pngData;
+        QBuffer buffer(&pngData);
+        buffer.open(QIODevice::WriteOnly);
+        if (!imgThumbnail.save(&buffer, "PNG"))
+            return;
+
+        // Files are named after their contents, identical thumbnails are written only once
+        RecentFile thumbnailRef;
+        thumbnailRef.thumbnailHash = QCryptographicHash::hash(pngData, QCryptographicHash::Sha1).toHex();
+        const FilePath thumbnailPath = thumbnailRef.thumbnailFilePath(dirPath);
+        if (!filepathIsRegularFile(thumbnailPath)) {
+            std::error_code ec;
+            std::filesystem::create_directories(dirPath, ec);
+            QFile file(filepathTo<QString>(thumbnailPath));
+            if (!file.open(QIODevice::WriteOnly) || file.write(pngData) != pngData.size())
+                return;
+        }
+
+        *ptrThumbnailHash = thumbnailRef.thumbnailHash;
+    });
+    auto connTaskEnded = std::make_shared<QMetaObject::Connection>();
+    *connTaskEnded = QObject::connect(
+                taskMgr, &TaskManager::ended,
+                this, [=](TaskId endedTaskId) {
+        if (endedTaskId != taskId)
+            return;
+
+        QObject::disconnect(*connTaskEnded);
+        const RecentFile* recentFile = this->findRecentFile(recentFilePath);
+        if (ptrThumbnailHash->isEmpty() || !recentFile)
+            return;
+
+        const RecentFiles& listRecentFile = this->recentFiles.value();
+        RecentFiles newListRecentFile = listRecentFile;
+        const auto indexRecentFile = std::distance(&listRecentFile.front(), recentFile);
+        RecentFile& newRecentFile = newListRecentFile.at(indexRecentFile);
+        const RecentFile oldRecentFile = newRecentFile;
+        newRecentFile.thumbnailHash = *ptrThumbnailHash;
+        newRecentFile.thumbnailTimestamp = timestamp;
+        this->recentFiles.setValue(newListRecentFile);
+        this->removeUnusedRecentFileThumbnail(oldRecentFile);
+    });
+    taskMgr->setTitle(taskId, tr("Save thumbnail"));
+    taskMgr->setPriority(taskId, TaskPriority::Background);
+    taskMgr->run(taskId);
 }
 
-void AppModule::recordRecentFileThumbnails(GuiApplication* guiApp)
+void AppModule::removeUnusedRecentFileThumbnail(const RecentFile& recentFile)
 {
-    if (!guiApp)
+    if (recentFile.thumbnailHash.isEmpty())
         return;
 
-    const RecentFiles& listRecentFile = this->recentFiles.value();
-    RecentFiles newListRecentFile = listRecentFile;
-    for (GuiDocument* guiDoc : guiApp->guiDocuments()) {
-        const RecentFile* recentFile = this->findRecentFile(guiDoc->document()->filePath());
-        if (!recentFile || !recentFile->isThumbnailOutOfSync())
-            continue; // Skip
-
-        RecentFile newRecentFile = *recentFile;
-        if (newRecentFile.recordThumbnail(guiDoc, this->recentFileThumbnailSize())) {
-            auto indexRecentFile = std::distance(&listRecentFile.front(), recentFile);
-            newListRecentFile.at(indexRecentFile) = newRecentFile;
+    for (const RecentFile& otherRecentFile : this->recentFiles.value()) {
+        if (otherRecentFile.thumbnailHash == recentFile.thumbnailHash)
+            return; // Still in use
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(recentFile.thumbnailFilePath(this->recentFileThumbnailCacheDirPath()), ec);
+}
+
+FilePath AppModule::recentFileThumbnailCacheDirPath() const
+{
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    return filepathFrom(cacheDir) / "thumbnails";
+}
+
+OccBRepMeshParameters AppModule::brepMeshParameters(const TopoDS_Shape& shape) const
+{
+    const double budgetDeflection = m_brepMeshBudgetDeflection;
+    if (this->meshingQuality == BRepMeshQuality::UserDefined)
+        return this->brepMeshUserDefinedParameters();
+    else if (this->meshingQuality == BRepMeshQuality::TriangleBudget && budgetDeflection > 0)
+        return BRepMeshBudget::shapeMeshParameters(budgetDeflection, BRepUtils::boundingBox(shape), this->brepMeshBudgetParameters());
+    else
+        return brepMeshQualityParameters(shape, this->meshingQuality);
+}
+
+OccBRepMeshParameters AppModule::brepMeshParameters(const TDF_Label& labelShape) const
+{
+    const double budgetDeflection = m_brepMeshBudgetDeflection;
+    if (this->meshingQuality == BRepMeshQuality::UserDefined)
+        return this->brepMeshUserDefinedParameters();
+    else if (this->meshingQuality == BRepMeshQuality::TriangleBudget && budgetDeflection > 0)
+        return BRepMeshBudget::shapeMeshParameters(budgetDeflection, AppModule::labelShapeBoundingBox(labelShape), this->brepMeshBudgetParameters());
+    else
+        return brepMeshQualityParameters(AppModule::labelShapeBoundingBox(labelShape), this->meshingQuality);
+}
+
+BRepMeshBudget::Parameters AppModule::brepMeshBudgetParameters() const
+{
+    BRepMeshBudget::Parameters params;
+    params.triangleCount = int64_t(this->meshingTriangleBudget.value()) * 1000;
+    return params;
+}
+
+OccBRepMeshParameters AppModule::brepMeshPreviewParameters(const TDF_Label& labelShape) const
+{
+    return brepMeshQualityParameters(AppModule::labelShapeBoundingBox(labelShape), BRepMeshQuality::VeryCoarse);
+}
+
+OccBRepMeshParameters AppModule::brepMeshUserDefinedParameters() const
+{
+    OccBRepMeshParameters params = brepMeshBaseParameters();
+    params.Deflection = UnitSystem::meters(this->meshingChordalDeflection.quantity());
+    params.Angle = UnitSystem::radians(this->meshingAngularDeflection.quantity());
+    params.Relative = this->meshingRelative;
+    return params;
+}
+
+Bnd_Box AppModule::labelShapeBoundingBox(const TDF_Label& label)
+{
+    DocumentPtr doc = Document::findFrom(label);
+    if (!doc.IsNull())
+        return doc->shapeBoundingBox(label);
+    else
+        return BRepUtils::boundingBox(XCaf::shape(label));
+}
+
+void AppModule::computeBRepMesh(const TopoDS_Shape& shape, TaskProgress* progress)
+{
+    BRepUtils::computeMesh(shape, this->brepMeshParameters(shape), progress);
+}
+
+void AppModule::computeBRepMesh(const TDF_Label& labelEntity, TaskProgress* progress)
+{
+    if (XCaf::isShape(labelEntity))
+        BRepUtils::computeMesh(XCaf::shape(labelEntity), this->brepMeshParameters(labelEntity), progress);
+}
+
+void AppModule::computeBRepMesh(
+        Span<const IO::System::ImportedFileEntities> spanFileEntities, TaskProgress* progress)
+{
+    this->computeBRepMesh(spanFileEntities, progress, false);
+}
+
+void AppModule::computeBRepMeshForDisplay(
+        Span<const IO::System::ImportedFileEntities> spanFileEntities, TaskProgress* progress)
+{
+    this->computeBRepMesh(spanFileEntities, progress, this->meshingProgressive);
+}
+
+bool AppModule::isImportPostProcessRequired(const IO::Format& format) const
+{
+    return IO::formatProvidesBRep(format) || this->meshingSinglePrecision;
+}
+
+void AppModule::computeBRepMesh(
+        Span<const IO::System::ImportedFileEntities> spanFileEntities,
+        TaskProgress* progress,
+        bool preview)
+{
+    if (this->meshingQuality == BRepMeshQuality::TriangleBudget && !preview) {
+        // Deflections depend on all the shapes of the batch, so the mesh cache isn't used
+        std::vector<TopoDS_Shape> vecShape;
+        for (const IO::System::ImportedFileEntities& fileEntities : spanFileEntities) {
+            for (const TDF_Label& labelEntity : fileEntities.seqEntity) {
+                if (XCaf::isShape(labelEntity))
+                    vecShape.push_back(XCaf::shape(labelEntity));
+            }
+        }
+
+        this->computeBRepMeshBudget(vecShape, progress);
+        if (!TaskProgress::isAbortRequested(progress))
+            this->applyMeshPrecision(spanFileEntities);
+
+        return;
+    }
+
+    const BRepMeshCache meshCache(this->brepMeshCacheDirPath());
+    struct CacheStore {
+        BRepMeshCache::Key key;
+        TopoDS_Shape shape;
+    };
+    std::vector<CacheStore> vecCacheStore;
+    std::vector<TopoDS_Shape> vecShape;
+    std::vector<OccBRepMeshParameters> vecParams;
+    for (const IO::System::ImportedFileEntities& fileEntities : spanFileEntities) {
+        QByteArray sourceHash;
+        if (this->meshingCacheEnabled)
+            sourceHash = BRepMeshCache::sourceHash(fileEntities.filepath);
+
+        // Bounding boxes of the entities are computed concurrently, then used by mesh parameters
+        std::vector<TDF_Label> vecLabelEntity;
+        for (const TDF_Label& labelEntity : fileEntities.seqEntity) {
+            if (XCaf::isShape(labelEntity))
+                vecLabelEntity.push_back(labelEntity);
+        }
+
+        DocumentPtr doc = !vecLabelEntity.empty() ? Document::findFrom(vecLabelEntity.front()) : DocumentPtr();
+        if (!doc.IsNull() && this->meshingQuality != BRepMeshQuality::UserDefined)
+            doc->cacheShapeBoundingBoxes(vecLabelEntity);
+
+        int shapeIndex = 0;
+        for (const TDF_Label& labelEntity : vecLabelEntity) {
+            const TopoDS_Shape shape = XCaf::shape(labelEntity);
+            const OccBRepMeshParameters params = this->brepMeshParameters(labelEntity);
+            const BRepMeshCache::Key cacheKey = { sourceHash, shapeIndex++, params };
+            if (!sourceHash.isEmpty()) {
+                if (meshCache.attachTriangulations(cacheKey, shape))
+                    continue;
+
+                // Preview triangulations must not be stored under the final parameters key
+                if (!preview)
+                    vecCacheStore.push_back({ cacheKey, shape });
+            }
+
+            vecShape.push_back(shape);
+            vecParams.push_back(preview ? this->brepMeshPreviewParameters(labelEntity) : params);
+        }
+    }
+
+    const std::vector<BRepUtils::MeshJob> vecJob = BRepUtils::createMeshJobs(vecShape, vecParams);
+    BRepUtils::computeMesh(vecJob, progress);
+    if (TaskProgress::isAbortRequested(progress))
+        return;
+
+    for (const CacheStore& store : vecCacheStore)
+        meshCache.storeTriangulations(store.key, store.shape);
+
+    // Cache stores the meshes in double precision, conversion comes afterwards
+    this->applyMeshPrecision(spanFileEntities);
+}
+
+void AppModule::computeBRepMeshBudget(Span<const TopoDS_Shape> spanShape, TaskProgress* progress)
+{
+    const BRepMeshBudget::Result result =
+            BRepMeshBudget::computeMesh(spanShape, this->brepMeshBudgetParameters(), progress);
+    if (result.globalDeflection > 0 && !TaskProgress::isAbortRequested(progress))
+        m_brepMeshBudgetDeflection = result.globalDeflection;
+}
+
+void AppModule::applyMeshPrecision(Span<const IO::System::ImportedFileEntities> spanFileEntities) const
+{
+    if (this->meshingSinglePrecision) {
+        for (const IO::System::ImportedFileEntities& fileEntities : spanFileEntities) {
+            for (const TDF_Label& labelEntity : fileEntities.seqEntity) {
+                if (XCaf::isShape(labelEntity)) {
+                    this->applyMeshPrecision(XCaf::shape(labelEntity));
+                }
+                else {
+                    auto attrTriangulation = CafUtils::findAttribute<TDataXtd_Triangulation>(labelEntity);
+                    if (!attrTriangulation.IsNull())
+                        attrTriangulation->Set(MeshUtils::singlePrecisionCopy(attrTriangulation->Get()));
+                }
+            }
         }
     }
+}
 
-    this->recentFiles.setValue(newListRecentFile);
+void AppModule::applyMeshPrecision(const TopoDS_Shape& shape) const
+{
+    if (this->meshingSinglePrecision)
+        BRepUtils::convertMeshToSinglePrecision(shape);
 }
 
-static QuantityLength shapeChordalDeflection(const TopoDS_Shape& shape)
+std::vector<TreeNodeId> AppModule::recomputeBRepMesh(
+        const DocumentPtr& doc, TaskProgress* progress, BRepMeshPriorities* priorities)
 {
-    // Excerpted from Prs3d::GetDeflection(...)
-    constexpr QuantityLength baseDeviation = 1 * Quantity_Millimeter;
+    std::vector<TreeNodeId> vecEntityTreeNodeId;
+    if (doc.IsNull())
+        return vecEntityTreeNodeId;
+
+    // Also serializes consecutive re-mesh requests on the same document
+    std::lock_guard<std::mutex> lock(doc->dataMutex()); MAYO_UNUSED(lock);
+    doc->compactTriangulations().expandAll();
+    if (this->meshingQuality == BRepMeshQuality::TriangleBudget) {
+        std::vector<TopoDS_Shape> vecShape;
+        for (int i = 0; i < doc->entityCount(); ++i) {
+            if (XCaf::isShape(doc->entityLabel(i))) {
+                vecShape.push_back(XCaf::shape(doc->entityLabel(i)));
+                vecEntityTreeNodeId.push_back(doc->entityTreeNodeId(i));
+            }
+        }
+
+        this->computeBRepMeshBudget(vecShape, progress);
+        for (const TopoDS_Shape& shape : vecShape)
+            this->applyMeshPrecision(shape);
+
+        return vecEntityTreeNodeId;
+    }
+
+    std::vector<TopoDS_Shape> vecFace;
+    std::vector<OccBRepMeshParameters> vecParams;
+    for (int i = 0; i < doc->entityCount(); ++i) {
+        const TDF_Label labelEntity = doc->entityLabel(i);
+        if (!XCaf::isShape(labelEntity))
+            continue;
+
+        const TopoDS_Shape shape = XCaf::shape(labelEntity);
+        const OccBRepMeshParameters params = this->brepMeshParameters(labelEntity);
+        const std::vector<TopoDS_Face> vecCoarseFace = BRepUtils::findCoarseMeshFaces(shape, params);
+        if (vecCoarseFace.empty())
+            continue;
+
+        // Neighbour faces are meshed again too, otherwise they would keep the old discretization
+        // of the shared edges and leave cracks along them
+        for (const TopoDS_Face& face : BRepUtils::addEdgeNeighbourFaces(shape, vecCoarseFace)) {
+            BRepTools::Clean(face);
+            vecFace.push_back(face);
+            vecParams.push_back(params);
+        }
 
-    Bnd_Box bndBox;
-    constexpr bool useTriangulation = true;
-    BRepBndLib::Add(shape, bndBox, !useTriangulation);
-    if (bndBox.IsVoid())
-        return baseDeviation;
+        vecEntityTreeNodeId.push_back(doc->entityTreeNodeId(i));
+    }
 
-    if (BndUtils::isOpen(bndBox)) {
-        if (!BndUtils::hasFinitePart(bndBox))
-            return baseDeviation;
+    const std::vector<BRepUtils::MeshJob> vecJob = BRepUtils::createMeshJobs(vecFace, vecParams);
+    if (priorities) {
+        this->computeBRepMeshPrioritized(vecJob, priorities, progress);
+        return vecEntityTreeNodeId;
+    }
 
-        bndBox = BndUtils::finitePart(bndBox);
+    BRepUtils::computeMesh(vecJob, progress);
+    if (this->meshingSinglePrecision && !vecFace.empty()) {
+        TopoDS_Compound compound;
+        BRep_Builder builder;
+        builder.MakeCompound(compound);
+        for (const TopoDS_Face& face : vecFace)
+            builder.Add(compound, face);
+
+        this->applyMeshPrecision(compound);
     }
 
-    const auto coords = BndBoxCoords::get(bndBox);
-    const gp_XYZ diag = coords.maxVertex().XYZ() - coords.minVertex().XYZ();
-    const double diagMaxComp = std::max({ diag.X(), diag.Y(), diag.Z() });
-    return 4 * diagMaxComp * baseDeviation;
+    return vecEntityTreeNodeId;
 }
 
-OccBRepMeshParameters AppModule::brepMeshParameters(const TopoDS_Shape& shape) const
+void AppModule::computeBRepMeshPrioritized(
+        Span<const BRepUtils::MeshJob> spanJob, BRepMeshPriorities* priorities, TaskProgress* progress)
 {
-    OccBRepMeshParameters params;
-    params.InParallel = true;
-#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
-    params.AllowQualityDecrease = true;
-#endif
-    if (this->meshingQuality == BRepMeshQuality::UserDefined) {
-        params.Deflection = UnitSystem::meters(this->meshingChordalDeflection.quantity());
-        params.Angle = UnitSystem::radians(this->meshingAngularDeflection.quantity());
-        params.Relative = this->meshingRelative;
+    // Faces of the parts, the first part wins for a face shared by many parts
+    TopTools_DataMapOfShapeInteger mapFacePart;
+    for (int i = 0; i < priorities->partCount(); ++i) {
+        BRepUtils::forEachSubFace(priorities->part(i), [&](const TopoDS_Face& face) {
+            mapFacePart.Bind(face.Located(TopLoc_Location()), i);
+        });
     }
-    else {
-        struct Coefficients {
-            double chordalDeflection;
-            double angularDeflection;
-        };
-        auto fnCoefficients = [](BRepMeshQuality meshQuality) -> Coefficients {
-            switch (meshQuality) {
-            case BRepMeshQuality::VeryCoarse: return { 8, 4 };
-            case BRepMeshQuality::Coarse: return { 4, 2 };
-            case BRepMeshQuality::Normal: return { 1, 1 };
-            case BRepMeshQuality::Precise: return { 1/4., 1/2. };
-            case BRepMeshQuality::VeryPrecise: return { 1/8., 1/4. };
-            case BRepMeshQuality::UserDefined: return { -1, -1 };
+
+    auto fnFacePart = [&](const TopoDS_Shape& face) {
+        const int* ptrPartIndex = mapFacePart.Seek(face.Located(TopLoc_Location()));
+        return ptrPartIndex ? *ptrPartIndex : -1;
+    };
+
+    // Jobs are made of faces, a part is done once all the jobs having some of its faces are done
+    // Job gets the priority of its most relevant part
+    std::vector<std::vector<int>> vecJobParts(spanJob.size());
+    std::vector<int> vecPartPendingJobCount(priorities->partCount(), 0);
+    for (unsigned i = 0; i < spanJob.size(); ++i) {
+        std::vector<int>& vecPartIndex = vecJobParts.at(i);
+        BRepUtils::forEachSubFace(spanJob[i].shape, [&](const TopoDS_Face& face) {
+            const int partIndex = fnFacePart(face);
+            const bool isPartFound =
+                    std::find(vecPartIndex.cbegin(), vecPartIndex.cend(), partIndex) != vecPartIndex.cend();
+            if (partIndex >= 0 && !isPartFound) {
+                vecPartIndex.push_back(partIndex);
+                ++vecPartPendingJobCount.at(partIndex);
             }
-            return { 1, 1 };
-        };
-        const Coefficients coeffs = fnCoefficients(this->meshingQuality);
-        params.Deflection = UnitSystem::meters(coeffs.chordalDeflection * shapeChordalDeflection(shape));
-        params.Angle = UnitSystem::radians(coeffs.angularDeflection * (20 * Quantity_Degree));
+        });
     }
 
-    return params;
+    std::mutex mutexPendingJobCount;
+    BRepUtils::MeshJobScheduling scheduling;
+    auto fnJobParts = [&](const BRepUtils::MeshJob& job) -> const std::vector<int>& {
+        return vecJobParts.at(&job - spanJob.data());
+    };
+    scheduling.fnPriority = [&](const BRepUtils::MeshJob& job) {
+        double priority = priorities->priority(-1);
+        for (int partIndex : fnJobParts(job))
+            priority = std::max(priority, priorities->priority(partIndex));
+
+        return priority;
+    };
+    scheduling.fnPriorityRevision = [=]{ return priorities->revision(); };
+    scheduling.fnJobDone = [&](const BRepUtils::MeshJob& job) {
+        // Conversion comes first, part must not be modified once reported
+        this->applyMeshPrecision(job.shape);
+        std::lock_guard<std::mutex> lock(mutexPendingJobCount); MAYO_UNUSED(lock);
+        for (int partIndex : fnJobParts(job)) {
+            if (--vecPartPendingJobCount.at(partIndex) == 0)
+                priorities->addPartDone(partIndex);
+        }
+    };
+    BRepUtils::computeMesh(spanJob, scheduling, progress);
 }
 
-void AppModule::computeBRepMesh(const TopoDS_Shape& shape, TaskProgress* progress)
+std::vector<OccBRepMeshParameters> AppModule::brepMeshLodParameters(const TDF_Label& labelShape) const
 {
-    BRepUtils::computeMesh(shape, this->brepMeshParameters(shape), progress);
+    // Each level is 4 times coarser than the previous one
+    std::vector<OccBRepMeshParameters> vecParams;
+    OccBRepMeshParameters params = this->brepMeshParameters(labelShape);
+    for (int i = 0; i < 2; ++i) {
+        params.Deflection *= 4;
+        params.Angle = std::min(params.Angle * 2, UnitSystem::radians(80 * Quantity_Degree));
+        vecParams.push_back(params);
+    }
+
+    return vecParams;
 }
 
-void AppModule::computeBRepMesh(const TDF_Label& labelEntity, TaskProgress* progress)
+std::vector<TreeNodeId> AppModule::computeBRepMeshLods(const DocumentPtr& doc, TaskProgress* progress)
 {
-    if (XCaf::isShape(labelEntity))
-        this->computeBRepMesh(XCaf::shape(labelEntity), progress);
+    std::vector<TreeNodeId> vecEntityTreeNodeId;
+    if (doc.IsNull())
+        return vecEntityTreeNodeId;
+
+    // Also serializes with re-mesh requests, which replace the triangulations
+    std::lock_guard<std::mutex> lock(doc->dataMutex()); MAYO_UNUSED(lock);
+    doc->compactTriangulations().expandAll();
+    std::vector<int> vecEntityIndex;
+    for (int i = 0; i < doc->entityCount(); ++i) {
+        if (XCaf::isShape(doc->entityLabel(i)))
+            vecEntityIndex.push_back(i);
+    }
+
+    const double entityPortionSize = 100. / std::max<size_t>(vecEntityIndex.size(), 1);
+    for (int i : vecEntityIndex) {
+        if (TaskProgress::isAbortRequested(progress))
+            break;
+
+        TaskProgress entityProgress(progress, entityPortionSize);
+        const TDF_Label labelEntity = doc->entityLabel(i);
+        BRepUtils::computeMeshLods(
+                    XCaf::shape(labelEntity), this->brepMeshLodParameters(labelEntity), &entityProgress);
+        this->applyMeshPrecision(XCaf::shape(labelEntity));
+        vecEntityTreeNodeId.push_back(doc->entityTreeNodeId(i));
+    }
+
+    return vecEntityTreeNodeId;
+}
+
+std::vector<TreeNodeId> AppModule::decimateMeshes(
+        const DocumentPtr& doc, double targetRatio, TaskProgress* progress)
+{
+    std::vector<TreeNodeId> vecEntityTreeNodeId;
+    if (doc.IsNull())
+        return vecEntityTreeNodeId;
+
+    // Presentations are built from the triangulation attributes, which are replaced here
+    std::lock_guard<std::mutex> lock(doc->dataMutex()); MAYO_UNUSED(lock);
+    doc->compactTriangulations().expandAll();
+    std::vector<opencascade::handle<TDataXtd_Triangulation>> vecAttrTriangulation;
+    std::vector<Handle_Poly_Triangulation> vecMesh;
+    for (int i = 0; i < doc->entityCount(); ++i) {
+        auto attrTriangulation = CafUtils::findAttribute<TDataXtd_Triangulation>(doc->entityLabel(i));
+        if (attrTriangulation.IsNull() || attrTriangulation->Get().IsNull())
+            continue;
+
+        vecAttrTriangulation.push_back(attrTriangulation);
+        vecMesh.push_back(attrTriangulation->Get());
+        vecEntityTreeNodeId.push_back(doc->entityTreeNodeId(i));
+    }
+
+    MeshDecimation::Parameters params;
+    params.targetRatio = targetRatio;
+    // Mesh entities are independent, no need to keep their open borders
+    params.preserveBorders = false;
+    const std::vector<Handle_Poly_Triangulation> vecDecimated =
+            MeshDecimation::decimated(vecMesh, params, progress);
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    for (size_t i = 0; i < vecAttrTriangulation.size(); ++i) {
+        const Handle_Poly_Triangulation& mesh = vecDecimated.at(i);
+        vecAttrTriangulation.at(i)->Set(this->meshingSinglePrecision ? MeshUtils::singlePrecisionCopy(mesh) : mesh);
+    }
+
+    return vecEntityTreeNodeId;
+}
+
+FilePath AppModule::brepMeshCacheDirPath() const
+{
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    return filepathFrom(cacheDir) / "brep_mesh";
 }
 
 AppModule* AppModule::get(const ApplicationPtr& app)
@@ -418,6 +1008,7 @@ void AppModule::onPropertyChanged(Property* prop)
             || prop == &this->meshDefaultsEdgeColor
             || prop == &this->meshDefaultsMaterial
             || prop == &this->meshDefaultsShowEdges
+            || prop == &this->meshDefaultsEdgeCreaseAngle
             || prop == &this->meshDefaultsShowNodes)
     {
         auto values = GraphicsMeshObjectDriver::defaultValues();
@@ -425,14 +1016,25 @@ void AppModule::onPropertyChanged(Property* prop)
         values.edgeColor = this->meshDefaultsEdgeColor.value();
         values.material = static_cast<Graphic3d_NameOfMaterial>(this->meshDefaultsMaterial.value());
         values.showEdges = this->meshDefaultsShowEdges.value();
+        values.edgeCreaseAngle = UnitSystem::radians(this->meshDefaultsEdgeCreaseAngle.quantity());
         values.showNodes = this->meshDefaultsShowNodes.value();
         GraphicsMeshObjectDriver::setDefaultValues(values);
     }
+    else if (prop == &this->taskPoolSize) {
+        if (this->taskPoolSize.value() > 0)
+            TaskManager::globalInstance()->setPoolSize(this->taskPoolSize);
+        else
+            TaskManager::globalInstance()->setPoolSize(std::thread::hardware_concurrency());
+    }
+    else if (prop == &this->fileReadAhead) {
+        m_app->ioSystem()->setFileReadAheadEnabled(this->fileReadAhead);
+    }
     else if (prop == &this->meshingQuality) {
         const bool isUserDefined = this->meshingQuality.value() == BRepMeshQuality::UserDefined;
         this->meshingChordalDeflection.setEnabled(isUserDefined);
         this->meshingAngularDeflection.setEnabled(isUserDefined);
         this->meshingRelative.setEnabled(isUserDefined);
+        this->meshingTriangleBudget.setEnabled(this->meshingQuality.value() == BRepMeshQuality::TriangleBudget);
     }
 
     PropertyGroup::onPropertyChanged(prop);
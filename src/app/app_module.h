@@ -9,7 +9,13 @@
 #include "recent_files.h"
 
 #include "../base/application_ptr.h"
+#include "../base/document_ptr.h"
 #include "../base/io_parameters_provider.h"
+#include "../base/io_system.h"
+#include "../base/brep_mesh_budget.h"
+#include "../base/brep_mesh_quality.h"
+#include "../base/brep_utils.h"
+#include "../base/libtree.h"
 #include "../base/occ_brep_mesh_parameters.h"
 #include "../base/occt_enums.h"
 #include "../base/property.h"
@@ -20,16 +26,21 @@
 #include "../base/settings_index.h"
 #include "../base/string_utils.h"
 #include "../base/unit_system.h"
+#include "../graphics/graphics_scene.h"
 
 #include <QtCore/QObject>
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
+class Bnd_Box;
 class TDF_Label;
 class TopoDS_Shape;
 
 namespace Mayo {
 
+class BRepMeshPriorities;
 class GuiApplication;
 class GuiDocument;
 
@@ -54,17 +65,67 @@ public:
 
     void prependRecentFile(const FilePath& fp);
     const RecentFile* findRecentFile(const FilePath& fp) const;
+    // Renders the thumbnail of 'guiDoc' if out of sync, PNG file is then written asynchronously in
+    // the thumbnail cache directory, named after the SHA-1 of its contents
     void recordRecentFileThumbnail(GuiDocument* guiDoc);
-    void recordRecentFileThumbnails(GuiApplication* guiApp);
     QSize recentFileThumbnailSize() const { return { 190, 150 }; }
+    FilePath recentFileThumbnailCacheDirPath() const;
 
+    // In 'TriangleBudget' quality mode, parameters are derived from the global deflection solved
+    // by the last budget meshing(see BRepMeshBudget), 'Normal' quality is used if none was done
     OccBRepMeshParameters brepMeshParameters(const TopoDS_Shape& shape) const;
+    // Same as above, but the bounding box of the shape is taken from the document cache
+    // See Document::shapeBoundingBox()
+    OccBRepMeshParameters brepMeshParameters(const TDF_Label& labelShape) const;
+    BRepMeshBudget::Parameters brepMeshBudgetParameters() const;
+    // Parameters of the very coarse mesh computed first in progressive meshing mode
+    OccBRepMeshParameters brepMeshPreviewParameters(const TDF_Label& labelShape) const;
     void computeBRepMesh(const TopoDS_Shape& shape, TaskProgress* progress = nullptr);
     void computeBRepMesh(const TDF_Label& labelEntity, TaskProgress* progress = nullptr);
+    // Meshes entities of all files in a single batch, see BRepUtils::createMeshJobs()
+    // Mesh cache is used if enabled, see BRepMeshCache
+    // Triangulations of the entities(meshes of shapes and mesh entities) are converted to single
+    // precision if 'meshingSinglePrecision' is on
+    void computeBRepMesh(
+            Span<const IO::System::ImportedFileEntities> spanFileEntities,
+            TaskProgress* progress = nullptr);
+    // Same as computeBRepMesh() but in progressive meshing mode entities which aren't in the
+    // mesh cache get a very coarse mesh, to be refined later with recomputeBRepMesh()
+    void computeBRepMeshForDisplay(
+            Span<const IO::System::ImportedFileEntities> spanFileEntities,
+            TaskProgress* progress = nullptr);
+    // Whether entities imported from 'format' have to be passed to computeBRepMeshForDisplay()
+    // BRep formats are meshed, mesh formats are converted to single precision if enabled
+    bool isImportPostProcessRequired(const IO::Format& format) const;
+    FilePath brepMeshCacheDirPath() const;
+    // Re-meshes BRep entities of 'doc' with current meshing parameters, only faces whose
+    // triangulation is coarser than the targeted deflection are re-tessellated, along with the
+    // faces sharing edges with them
+    // Document data mutex is held during the whole computation, presentations of the returned
+    // entities have to be recomputed afterwards
+    // In 'TriangleBudget' quality mode, all the BRep entities of 'doc' are meshed again so they
+    // share the triangle budget
+    // If 'priorities' isn't null then faces are meshed by decreasing priority of their part, each
+    // part being reported once all its faces are done(ignored in 'TriangleBudget' mode)
+    // Returns the tree node ids of the entities actually re-meshed
+    std::vector<TreeNodeId> recomputeBRepMesh(
+            const DocumentPtr& doc, TaskProgress* progress = nullptr, BRepMeshPriorities* priorities = nullptr);
+    // Parameters of the coarse levels of detail of shape meshes, ordered from finest to coarsest
+    std::vector<OccBRepMeshParameters> brepMeshLodParameters(const TDF_Label& labelShape) const;
+    // Computes the coarse mesh levels of detail of BRep entities of 'doc', see BRepUtils::computeMeshLods()
+    // Returns the tree node ids of the entities processed
+    std::vector<TreeNodeId> computeBRepMeshLods(const DocumentPtr& doc, TaskProgress* progress = nullptr);
+    // Replaces the triangulation of mesh entities of 'doc' by their decimated copy, see MeshDecimation
+    // Returns the tree node ids of the entities actually decimated
+    std::vector<TreeNodeId> decimateMeshes(
+            const DocumentPtr& doc, double targetRatio, TaskProgress* progress = nullptr);
 
     // from IO::ParametersProvider
+    // Parameters of a format are created and registered in settings on first request
     const PropertyGroup* findReaderParameters(const IO::Format& format) const override;
     const PropertyGroup* findWriterParameters(const IO::Format& format) const override;
+    // Required before all the settings are listed, eg by the options dialog
+    void createAllFormatParameters();
 
     // from PropertyValueConversion
     QVariant toVariant(const Property& prop) const override;
@@ -75,6 +136,8 @@ public:
     const Settings_SectionIndex sectionId_systemUnits;
     PropertyInt unitSystemDecimals{ this, textId("decimalCount") };
     PropertyEnum<UnitSystem::Schema> unitSystemSchema{ this, textId("schema") };
+    PropertyInt taskPoolSize{ this, textId("taskPoolSize") };
+    PropertyBool fileReadAhead{ this, textId("fileReadAhead") };
     // Application
     const Settings_GroupIndex groupId_application;
     PropertyEnumeration language;
@@ -82,17 +145,38 @@ public:
     PropertyQString lastOpenDir{ this, textId("lastOpenFolder") };
     PropertyQString lastSelectedFormatFilter{ this, textId("lastSelectedFormatFilter") };
     PropertyBool linkWithDocumentSelector{ this, textId("linkWithDocumentSelector") };
+    PropertyBool importDeduplicateGeometry{ this, textId("importDeduplicateGeometry") };
+    PropertyBool importViewerOnlyDocuments{ this, textId("importViewerOnlyDocuments") };
+    PropertyBool autoReloadModifiedFiles{ this, textId("autoReloadModifiedFiles") };
+    PropertyBool prefetchHoveredRecentFile{ this, textId("prefetchHoveredRecentFile") };
+    PropertyBool restoreLastSession{ this, textId("restoreLastSession") };
+    PropertyQByteArray lastSession{ this, textId("lastSession") }; // See Session::toBlob()
     // Meshing
     const Settings_GroupIndex groupId_meshing;
-    enum class BRepMeshQuality { VeryCoarse, Coarse, Normal, Precise, VeryPrecise, UserDefined };
+    using BRepMeshQuality = Mayo::BRepMeshQuality;
     PropertyEnum<BRepMeshQuality> meshingQuality{ this, textId("meshingQuality") };
     PropertyLength meshingChordalDeflection{ this, textId("meshingChordalDeflection") };
     PropertyAngle meshingAngularDeflection{ this, textId("meshingAngularDeflection") };
     PropertyBool meshingRelative{ this, textId("meshingRelative") };
+    PropertyInt meshingTriangleBudget{ this, textId("meshingTriangleBudget") }; // In thousands of triangles
+    PropertyBool meshingCacheEnabled{ this, textId("meshingCacheEnabled") };
+    PropertyBool meshingProgressive{ this, textId("meshingProgressive") };
+    PropertyBool meshingLevelOfDetails{ this, textId("meshingLevelOfDetails") };
+    PropertyBool meshingSinglePrecision{ this, textId("meshingSinglePrecision") };
     // Graphics
     const Settings_GroupIndex groupId_graphics;
     PropertyBool defaultShowOriginTrihedron{ this, textId("defaultShowOriginTrihedron") };
     PropertyDouble instantZoomFactor{ this, textId("instantZoomFactor") };
+    PropertyInt viewInteractionCullingSize{ this, textId("viewInteractionCullingSize") };
+    PropertyBool viewInteractionPlainShaded{ this, textId("viewInteractionPlainShaded") };
+    PropertyInt graphicsMemoryBudget{ this, textId("graphicsMemoryBudget") }; // In megabytes
+    PropertyInt graphicsCompactHiddenMeshesDelay{ this, textId("graphicsCompactHiddenMeshesDelay") }; // In seconds
+    PropertyBool graphicsStaticBatching{ this, textId("graphicsStaticBatching") };
+    PropertyBool graphicsIdBufferPicking{ this, textId("graphicsIdBufferPicking") };
+    PropertyBool graphicsSelectionOutline{ this, textId("graphicsSelectionOutline") };
+    using TransparencyMethod = GraphicsScene::TransparencyMethod;
+    PropertyEnum<TransparencyMethod> graphicsTransparencyMethod{ this, textId("graphicsTransparencyMethod") };
+    PropertyInt pointCloudPointBudget{ this, textId("pointCloudPointBudget") }; // In thousands of points
     // -- ClipPlanes
     const Settings_SectionIndex sectionId_graphicsClipPlanes;
     PropertyBool clipPlanesCappingOn{ this, textId("cappingOn") };
@@ -103,6 +187,7 @@ public:
     PropertyOccColor meshDefaultsEdgeColor{ this, textId("edgeColor") };
     PropertyEnumeration meshDefaultsMaterial{ this, textId("material"), OcctEnums::Graphic3d_NameOfMaterial() };
     PropertyBool meshDefaultsShowEdges{ this, textId("showEgesOn") };
+    PropertyAngle meshDefaultsEdgeCreaseAngle{ this, textId("edgeCreaseAngle") };
     PropertyBool meshDefaultsShowNodes{ this, textId("showNodesOn") };
 
 protected:
@@ -110,10 +195,40 @@ protected:
     void onPropertyChanged(Property* prop) override;
 
 private:
+    OccBRepMeshParameters brepMeshUserDefinedParameters() const;
+    // Bounding box of the shape of 'label', cached by the owner document if any
+    static Bnd_Box labelShapeBoundingBox(const TDF_Label& label);
+    void computeBRepMesh(
+            Span<const IO::System::ImportedFileEntities> spanFileEntities,
+            TaskProgress* progress,
+            bool preview);
+    // Meshes 'spanShape' within triangle budget, see BRepMeshBudget::computeMesh()
+    void computeBRepMeshBudget(Span<const TopoDS_Shape> spanShape, TaskProgress* progress);
+    // Computes jobs of faces along 'priorities', see recomputeBRepMesh()
+    void computeBRepMeshPrioritized(
+            Span<const BRepUtils::MeshJob> spanJob, BRepMeshPriorities* priorities, TaskProgress* progress);
+    // Converts triangulations of 'shape' to single precision if 'meshingSinglePrecision' is on
+    void applyMeshPrecision(const TopoDS_Shape& shape) const;
+    // Same as above for all the entities(shapes and mesh entities) of the imported files
+    void applyMeshPrecision(Span<const IO::System::ImportedFileEntities> spanFileEntities) const;
+    // Deletes thumbnail file of 'recentFile' if not shared by any current recent file
+    void removeUnusedRecentFileThumbnail(const RecentFile& recentFile);
+
+    enum class FormatParametersType { Reader, Writer };
+    PropertyGroup* findFormatParameters(const IO::Format& format, FormatParametersType type) const;
+
+    struct FormatParameters {
+        Settings_SectionIndex sectionId;
+        PropertyGroup* ptrGroup = nullptr;
+        bool isCreated = false;
+    };
+
     Application* m_app = nullptr;
-    std::vector<std::unique_ptr<PropertyGroup>> m_vecPtrPropertyGroup;
-    std::unordered_map<QByteArray, PropertyGroup*> m_mapFormatReaderParameters;
-    std::unordered_map<QByteArray, PropertyGroup*> m_mapFormatWriterParameters;
+    mutable std::vector<std::unique_ptr<PropertyGroup>> m_vecPtrPropertyGroup;
+    mutable std::unordered_map<QByteArray, FormatParameters> m_mapFormatReaderParameters;
+    mutable std::unordered_map<QByteArray, FormatParameters> m_mapFormatWriterParameters;
+    mutable std::mutex m_mutexFormatParameters;
+    std::atomic<double> m_brepMeshBudgetDeflection{ -1 }; // Solved by last budget meshing
 };
 
 } // namespace Mayo
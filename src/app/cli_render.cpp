@@ -0,0 +1,354 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "cli_render.h"
+
+#include "app_module.h"
+#include "../base/application.h"
+#include "../base/io_system.h"
+#include "../base/string_utils.h"
+#include "../base/task_manager.h"
+#include "../cli/cli_convert.h"
+#include "../graphics/v3d_view_camera_animation.h"
+#include "../gui/gui_application.h"
+#include "../gui/gui_document.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTimer>
+#include <QtCore/QtDebug>
+#include <QtGui/QImageWriter>
+
+#include <gsl/util>
+#include <Message.hxx>
+#include <TColStd_IndexedDataMapOfStringString.hxx>
+#include <gp.hxx>
+#include <gp_Ax1.hxx>
+#include <gp_Trsf.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <numeric>
+
+namespace Mayo {
+
+namespace {
+
+class Main { Q_DECLARE_TR_FUNCTIONS(Mayo::Main) };
+
+// Files imported in a document rendered into a single image
+struct CliRenderJob {
+    std::vector<FilePath> vecFilepath;
+    FilePath filepathImage;
+};
+
+// Helper to drive rendering jobs one after the other
+struct CliRenderHelper : public QObject {
+    TaskManager taskMgr;
+    GuiOffscreenRenderer renderer;
+    std::vector<CliRenderJob> vecJob;
+    std::function<void(size_t)> fnRunJob;
+    int failedJobCount = 0;
+};
+
+// Calls 'fn' once the graphics of all entities of 'guiDoc' are mapped, right away if so already
+void whenGraphicsMapped(GuiDocument* guiDoc, QObject* context, std::function<void()> fn)
+{
+    if (!guiDoc->isMappingEntityGraphics())
+        return fn();
+
+    auto conn = std::make_shared<QMetaObject::Connection>();
+    *conn = QObject::connect(guiDoc, &GuiDocument::entityGraphicsMapped, context, [=]{
+        if (guiDoc->isMappingEntityGraphics())
+            return;
+
+        QObject::disconnect(*conn);
+        fn();
+    });
+}
+
+// Imports files into a new document, then calls 'fnImported' in the GUI thread once the graphics
+// of all entities are mapped. On error, 'fnImported' is given a null GuiDocument and the error
+// message. Document is closed right after the call of 'fnImported'
+void asyncImportDocument(
+        GuiApplication* guiApp,
+        TaskManager* taskMgr,
+        const std::vector<FilePath>& vecFilepath,
+        QObject* context,
+        std::function<void(GuiDocument*, const QString&)> fnImported)
+{
+    const ApplicationPtr& app = guiApp->application();
+    const DocumentPtr doc = app->newDocument();
+    doc->setViewerOnly(true); // Imports are never undone by the CLI
+    GuiDocument* guiDoc = guiApp->findGuiDocument(doc);
+    auto fnFinished = [=](GuiDocument* importedGuiDoc, const QString& errorMessage) {
+        fnImported(importedGuiDoc, errorMessage);
+        app->closeDocument(doc);
+    };
+
+    auto errorCollect = std::make_shared<CliErrorMessageCollect>();
+    const TaskFuture<bool> future = app->ioSystem()->importInDocument()
+            .targetDocument(doc)
+            .withFilepaths(vecFilepath)
+            .withParametersProvider(AppModule::get(app))
+            .withEntitiesPostProcess([=](auto spanFileEntities, TaskProgress* progress) {
+                AppModule::get(app)->computeBRepMeshForDisplay(spanFileEntities, progress);
+            })
+            .withEntityPostProcessRequiredIf([=](const IO::Format& format) {
+                return AppModule::get(app)->isImportPostProcessRequired(format);
+            })
+            .withMessenger(errorCollect.get())
+            .executeAsync(taskMgr);
+    taskMgr->onReady(future, context, [=](const TaskFuture<bool>& result) {
+        if (!guiDoc || !result.hasValue() || !result.value()) {
+            const QString msg = result.hasError() ? result.errorMessage() : errorCollect->message;
+            return fnFinished(nullptr, msg.trimmed());
+        }
+
+        // Entities are mapped in the GUI thread, once imported
+        whenGraphicsMapped(guiDoc, context, [=]{ fnFinished(guiDoc, {}); });
+    });
+}
+
+// Camera keyframes of path 'name', the first one being the current camera of 'view'
+// Returns empty vector if 'name' is unknown
+std::vector<Handle_Graphic3d_Camera> cameraPathKeyFrames(const Handle_V3d_View& view, const QString& name)
+{
+    std::vector<Handle_Graphic3d_Camera> vecCamera;
+    auto fnAddCamera = [&](const std::function<void(const Handle_Graphic3d_Camera&)>& fnChange) {
+        Handle_Graphic3d_Camera camera = new Graphic3d_Camera;
+        camera->Copy(vecCamera.empty() ? view->Camera() : vecCamera.back());
+        if (fnChange)
+            fnChange(camera);
+
+        vecCamera.push_back(camera);
+    };
+
+    fnAddCamera(nullptr);
+    if (name == "orbit") {
+        // Quarter turns, as camera interpolation takes the shortest rotation
+        gp_Trsf trsf;
+        trsf.SetRotation(gp_Ax1(view->Camera()->Center(), gp::DZ()), M_PI / 2.);
+        for (int i = 0; i < 4; ++i)
+            fnAddCamera([=](const Handle_Graphic3d_Camera& camera) { camera->Transform(trsf); });
+    }
+    else if (name == "zoom") {
+        fnAddCamera([](const Handle_Graphic3d_Camera& camera) { camera->SetScale(camera->Scale() / 4.); });
+        fnAddCamera([](const Handle_Graphic3d_Camera& camera) { camera->SetScale(camera->Scale() * 4.); });
+    }
+    else {
+        return {};
+    }
+
+    return vecCamera;
+}
+
+// Minimum, mean, percentiles and maximum of 'vecValue' as JSON object
+QJsonObject statisticsJsonObject(std::vector<double> vecValue)
+{
+    QJsonObject jsonStats;
+    if (vecValue.empty())
+        return jsonStats;
+
+    std::sort(vecValue.begin(), vecValue.end());
+    // Nearest-rank method
+    auto fnPercentile = [&](double p) {
+        const size_t rank = size_t(std::ceil(p * vecValue.size()));
+        return vecValue.at(std::clamp<size_t>(rank, 1, vecValue.size()) - 1);
+    };
+
+    const double sum = std::accumulate(vecValue.cbegin(), vecValue.cend(), 0.);
+    jsonStats.insert("min", vecValue.front());
+    jsonStats.insert("mean", sum / vecValue.size());
+    jsonStats.insert("p50", fnPercentile(0.5));
+    jsonStats.insert("p90", fnPercentile(0.9));
+    jsonStats.insert("p95", fnPercentile(0.95));
+    jsonStats.insert("p99", fnPercentile(0.99));
+    jsonStats.insert("max", vecValue.back());
+    return jsonStats;
+}
+
+} // namespace
+
+void cli_asyncRenderDocuments(
+        GuiApplication* guiApp,
+        const CliRenderArguments& args,
+        std::function<void(int)> fnContinuation)
+{
+    auto helper = new CliRenderHelper; // Allocated on heap because current function is asynchronous
+    const GuiOffscreenRenderer::Options renderOptions = args.renderOptions;
+
+    // Helper function to exit current function
+    auto fnExit = [=](int retCode) {
+        helper->deleteLater();
+        fnContinuation(retCode);
+    };
+
+    // Check image format is supported
+    const FilePath fpImageSuffix = args.batchMode ? filepathFrom(args.batchImageSuffix) : args.filepathImage.extension();
+    const QByteArray imageFormat = filepathTo<QString>(fpImageSuffix).remove('.').toLower().toUtf8();
+    if (!QImageWriter::supportedImageFormats().contains(imageFormat)) {
+        qCritical().noquote() << Main::tr("Unsupported image format '%1'").arg(QString::fromUtf8(imageFormat));
+        return fnExit(EXIT_FAILURE);
+    }
+
+    // Create jobs, one per input file in batch mode
+    if (args.batchMode) {
+        for (const FilePath& fpInput : args.listFilepathToOpen) {
+            const FilePath dirOutput = !args.batchOutputDir.empty() ? args.batchOutputDir : fpInput.parent_path();
+            FilePath fpImage = dirOutput / fpInput.filename();
+            fpImage.replace_extension(filepathFrom(QString::fromUtf8(imageFormat)));
+            helper->vecJob.push_back({ { fpInput }, fpImage });
+        }
+    }
+    else {
+        helper->vecJob.push_back({ args.listFilepathToOpen, args.filepathImage });
+    }
+
+    // Suppress output from OpenCascade
+    Message::DefaultMessenger()->RemovePrinters(Message_Printer::get_type_descriptor());
+
+    // Jobs are run sequentially, rendering takes place in the GUI thread where the GL context lives
+    helper->fnRunJob = [=](size_t index) {
+        if (index >= helper->vecJob.size())
+            return fnExit(helper->failedJobCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+
+        const CliRenderJob& job = helper->vecJob.at(index);
+        const FilePath fpImage = job.filepathImage;
+
+        // Helper function to report the job and continue with next one
+        auto fnJobFinished = [=](bool ok, const QString& msg) {
+            if (ok) {
+                qInfo().noquote() << msg;
+            }
+            else {
+                qCritical().noquote() << msg;
+                ++helper->failedJobCount;
+            }
+
+            QTimer::singleShot(0, helper, [=]{ helper->fnRunJob(index + 1); });
+        };
+
+        asyncImportDocument(
+                    guiApp, &helper->taskMgr, job.vecFilepath, helper,
+                    [=](GuiDocument* guiDoc, const QString& errorMessage)
+        {
+            if (!guiDoc)
+                return fnJobFinished(false, errorMessage);
+
+            const QString strFilepathImage = filepathTo<QString>(fpImage);
+            const QImage img = helper->renderer.render(guiDoc, renderOptions);
+            if (img.isNull())
+                fnJobFinished(false, Main::tr("Failed to render %1").arg(strFilepathImage));
+            else if (!img.save(strFilepathImage, imageFormat.constData()))
+                fnJobFinished(false, Main::tr("Failed to write image %1").arg(strFilepathImage));
+            else
+                fnJobFinished(true, Main::tr("Rendered %1").arg(strFilepathImage));
+        });
+    };
+
+    helper->fnRunJob(0);
+}
+
+void cli_asyncBenchmarkView(
+        GuiApplication* guiApp,
+        const CliBenchViewArguments& args,
+        std::function<void(int)> fnContinuation)
+{
+    auto helper = new CliRenderHelper; // Allocated on heap because current function is asynchronous
+
+    // Helper function to exit current function
+    auto fnExit = [=](int retCode) {
+        helper->deleteLater();
+        fnContinuation(retCode);
+    };
+
+    // Suppress output from OpenCascade
+    Message::DefaultMessenger()->RemovePrinters(Message_Printer::get_type_descriptor());
+
+    asyncImportDocument(
+                guiApp, &helper->taskMgr, args.listFilepathToOpen, helper,
+                [=](GuiDocument* guiDoc, const QString& errorMessage)
+    {
+        if (!guiDoc) {
+            qCritical().noquote() << errorMessage;
+            return fnExit(EXIT_FAILURE);
+        }
+
+        guiDoc->graphicsScene()->clearSelection();
+        guiDoc->setViewTrihedronMode(GuiDocument::ViewTrihedronMode::None);
+        if (guiDoc->isOriginTrihedronVisible())
+            guiDoc->toggleOriginTrihedronVisibility();
+
+        Handle_V3d_View view = helper->renderer.createView(guiDoc, args.renderOptions);
+        auto _ = gsl::finally([=]{ guiDoc->graphicsScene()->v3dViewer()->SetViewOff(view); });
+        view->ChangeRenderingParams().CollectedStats = Graphic3d_RenderingParams::PerfCounters_Extended;
+
+        const std::vector<Handle_Graphic3d_Camera> vecKeyCamera = cameraPathKeyFrames(view, args.cameraPath);
+        if (vecKeyCamera.empty()) {
+            qCritical().noquote() << Main::tr("Invalid camera path '%1', expected \"orbit\" or \"zoom\"").arg(args.cameraPath);
+            return fnExit(EXIT_FAILURE);
+        }
+
+        // Camera steps are driven explicitly(not by wall-clock time), so all frames are rendered
+        // whatever their duration and the camera path is the same on each run
+        std::vector<double> vecFrameTime;
+        std::vector<double> vecCpuTime;
+        V3dViewCameraAnimation cameraAnimation(view);
+        cameraAnimation.setDuration(10000);
+        cameraAnimation.setRedrawFunction([&]{
+            QElapsedTimer timer;
+            timer.start();
+            const std::clock_t cpuStart = std::clock();
+            view->Redraw();
+            vecCpuTime.push_back(double(std::clock() - cpuStart) * 1000. / CLOCKS_PER_SEC);
+            vecFrameTime.push_back(timer.nsecsElapsed() / 1e6);
+        });
+
+        // First frames are excluded, they compile shaders and upload buffers to the GPU
+        const int warmUpFrameCount = 10;
+        const int frameCount = std::max(args.frameCount, 1);
+        const int segmentCount = int(vecKeyCamera.size()) - 1;
+        for (int i = -warmUpFrameCount; i < frameCount; ++i) {
+            const double pathPos = frameCount > 1 ? segmentCount * std::max(i, 0) / double(frameCount - 1) : 0.;
+            const int segment = std::min(int(pathPos), segmentCount - 1);
+            cameraAnimation.setCameraStart(vecKeyCamera.at(segment));
+            cameraAnimation.setCameraEnd(vecKeyCamera.at(segment + 1));
+            cameraAnimation.setCurrentTime(int((pathPos - segment) * cameraAnimation.duration()));
+        }
+
+        auto fnEraseWarmUp = [=](std::vector<double>& vec) {
+            vec.erase(vec.begin(), vec.begin() + std::min<size_t>(warmUpFrameCount, vec.size()));
+        };
+        fnEraseWarmUp(vecFrameTime);
+        fnEraseWarmUp(vecCpuTime);
+
+        TColStd_IndexedDataMapOfStringString dictStats;
+        view->StatisticInformation(dictStats);
+        QJsonObject jsonCounters;
+        for (int i = 1; i <= dictStats.Extent(); ++i)
+            jsonCounters.insert(StringUtils::fromUtf8(dictStats.FindKey(i)), StringUtils::fromUtf8(dictStats.FindFromIndex(i)));
+
+        QJsonObject jsonBench;
+        jsonBench.insert("path", args.cameraPath);
+        jsonBench.insert("frames", frameCount);
+        jsonBench.insert("width", args.renderOptions.size.width());
+        jsonBench.insert("height", args.renderOptions.size.height());
+        jsonBench.insert("frameTime", statisticsJsonObject(vecFrameTime));
+        jsonBench.insert("cpuTime", statisticsJsonObject(vecCpuTime));
+        jsonBench.insert("counters", jsonCounters);
+        std::cout << QJsonDocument(jsonBench).toJson(QJsonDocument::Compact).toStdString() << std::endl;
+        fnExit(EXIT_SUCCESS);
+    });
+}
+
+} // namespace Mayo
@@ -0,0 +1,65 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/filepath.h"
+#include "../gui/gui_offscreen_renderer.h"
+
+#include <QtCore/QString>
+#include <functional>
+#include <vector>
+
+namespace Mayo {
+
+class GuiApplication;
+
+// Arguments of CLI rendering, filled from the command-line by the executable
+struct CliRenderArguments {
+    std::vector<FilePath> listFilepathToOpen;
+    // Image where input files are rendered together, they are imported into a single document
+    FilePath filepathImage;
+    // Batch mode: each input file is rendered separately into "<output dir>/<file name>.<suffix>"
+    // Output directory defaults to the directory of the input file
+    bool batchMode = false;
+    QString batchImageSuffix;
+    FilePath batchOutputDir;
+    GuiOffscreenRenderer::Options renderOptions;
+};
+
+// Asynchronously renders input file(s) listed in 'args' into image file(s), no window is shown
+// Documents are imported and displayed as in GUI mode, one at a time, then rendered and closed. All
+// the renderings share the same offscreen GL context
+// Calls 'fnContinuation' at the end of execution
+void cli_asyncRenderDocuments(
+        GuiApplication* guiApp,
+        const CliRenderArguments& args,
+        std::function<void(int)> fnContinuation);
+
+// Arguments of CLI view benchmark, filled from the command-line by the executable
+struct CliBenchViewArguments {
+    std::vector<FilePath> listFilepathToOpen;
+    QString cameraPath = "orbit"; // "orbit"(full turn around vertical axis) or "zoom"(zoom in then out)
+    int frameCount = 600;
+    GuiOffscreenRenderer::Options renderOptions;
+};
+
+// Asynchronously imports input file(s) listed in 'args' into a single document, then renders its
+// view along a deterministic camera path, no window is shown. Statistics are then printed on
+// standard output as a JSON object, example:
+//     {"path":"orbit","frames":600,"width":800,"height":600,
+//      "frameTime":{"min":2.1,"mean":2.6,"p50":2.5,"p90":3.1,"p95":3.4,"p99":4.2,"max":6.8},
+//      "cpuTime":{...},"counters":{"Triangles":"1204350",...}}
+// Times are in milliseconds, excluding a few warm-up frames. "frameTime" is the wall-clock time
+// of each redraw, "cpuTime" the CPU time consumed by the process during the redraw. "counters"
+// are the OpenCascade rendering statistics(see Graphic3d_RenderingParams::PerfCounters_Extended)
+// Calls 'fnContinuation' at the end of execution
+void cli_asyncBenchmarkView(
+        GuiApplication* guiApp,
+        const CliBenchViewArguments& args,
+        std::function<void(int)> fnContinuation);
+
+} // namespace Mayo
@@ -0,0 +1,207 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "deferred_shapes_load_queue.h"
+
+#include "../base/application.h"
+#include "../base/caf_utils.h"
+#include "../base/deferred_shape_loader.h"
+#include "../base/document.h"
+#include "../base/global.h"
+#include "../base/task_manager.h"
+#include "../gui/gui_application.h"
+#include "../gui/gui_document.h"
+
+#include <XCAFDoc_ShapeTool.hxx>
+#include <algorithm>
+#include <mutex>
+#include <unordered_set>
+
+namespace Mayo {
+
+DeferredShapesLoadQueue::DeferredShapesLoadQueue(GuiApplication* guiApp, QObject* parent)
+    : QObject(parent),
+      m_guiApp(guiApp)
+{
+    auto app = guiApp->application();
+    QObject::connect(
+                app.get(), &Application::documentEntityAdded,
+                this, &DeferredShapesLoadQueue::onDocumentEntityAdded);
+    QObject::connect(
+                app.get(), &Application::documentEntitiesAdded,
+                this, &DeferredShapesLoadQueue::onDocumentEntityAdded);
+    QObject::connect(
+                app.get(), &Application::documentAboutToClose,
+                this, &DeferredShapesLoadQueue::onDocumentAboutToClose);
+    QObject::connect(guiApp, &GuiApplication::guiDocumentAdded, this, [=](GuiDocument* guiDoc) {
+        QObject::connect(
+                    guiDoc, &GuiDocument::productGraphicsReleased,
+                    this, [=](const std::vector<TDF_Label>& vecLabelProduct) {
+            this->unloadProducts(guiDoc->document(), vecLabelProduct);
+        });
+    });
+}
+
+void DeferredShapesLoadQueue::prioritize(const DocumentTreeNode& node)
+{
+    if (node.isValid()) {
+        const TreeNodeId nodeId = node.id();
+        this->prioritize(node.document(), Span<const TreeNodeId>(&nodeId, 1));
+    }
+}
+
+void DeferredShapesLoadQueue::prioritize(const DocumentPtr& doc, Span<const TreeNodeId> spanNodeId)
+{
+    if (m_queue.empty() || doc.IsNull())
+        return;
+
+    std::unordered_set<TDF_Label> setLabelProduct;
+    const Tree<TDF_Label>& modelTree = doc->modelTree();
+    for (TreeNodeId nodeId : spanNodeId) {
+        traverseTree(nodeId, modelTree, [&](TreeNodeId id) {
+            const TDF_Label& nodeLabel = modelTree.nodeData(id);
+            setLabelProduct.insert(XCaf::isShapeReference(nodeLabel) ? XCaf::shapeReferred(nodeLabel) : nodeLabel);
+        });
+    }
+
+    // Prioritized products keep their relative order
+    auto itPartition = std::stable_partition(m_queue.begin(), m_queue.end(), [&](const Entry& entry) {
+        return entry.doc == doc && setLabelProduct.find(entry.labelProduct) != setLabelProduct.cend();
+    });
+    for (auto it = m_queue.begin(); it != itPartition; ++it)
+        it->isRequested = true;
+
+    // Queue might be idle, waiting for products loaded only on demand
+    this->runNext();
+}
+
+void DeferredShapesLoadQueue::unloadProducts(const DocumentPtr& doc, Span<const TDF_Label> spanLabelProduct)
+{
+    GuiDocument* guiDoc = m_guiApp->findGuiDocument(doc);
+    if (!guiDoc)
+        return;
+
+    for (const TDF_Label& labelProduct : spanLabelProduct) {
+        auto itEntry = m_mapLabelUnloadable.find(labelProduct);
+        if (itEntry == m_mapLabelUnloadable.end() || itEntry->second.doc != doc)
+            continue;
+
+        Entry entry = itEntry->second;
+        m_mapLabelUnloadable.erase(itEntry);
+        const TopoDS_Shape shape = entry.loader->unloadedShape(labelProduct);
+        if (shape.IsNull())
+            continue;
+
+        {
+            std::lock_guard<std::mutex> lock(doc->dataMutex()); MAYO_UNUSED(lock);
+            doc->xcaf().shapeTool()->SetShape(labelProduct, shape);
+            doc->invalidateShapeBoundingBox(labelProduct);
+        }
+
+        // Graphics objects must no longer refer to the loaded shape
+        guiDoc->updateProductGraphics(labelProduct);
+        entry.isRequested = false;
+        m_queue.push_back(std::move(entry));
+    }
+}
+
+void DeferredShapesLoadQueue::onDocumentEntityAdded(const DocumentPtr& doc)
+{
+    std::vector<std::shared_ptr<DeferredShapeLoader>> vecLoader;
+    {
+        std::lock_guard<std::mutex> lock(doc->dataMutex()); MAYO_UNUSED(lock);
+        vecLoader = doc->deferredShapeLoaders();
+    }
+
+    for (const std::shared_ptr<DeferredShapeLoader>& loader : vecLoader) {
+        if (!m_setLoaderQueued.insert(loader.get()).second)
+            continue;
+
+        for (const TDF_Label& labelProduct : loader->deferredProducts())
+            m_queue.push_back({ doc, labelProduct, loader });
+    }
+
+    this->runNext();
+}
+
+void DeferredShapesLoadQueue::onDocumentAboutToClose(const DocumentPtr& doc)
+{
+    m_queue.erase(
+                std::remove_if(
+                    m_queue.begin(), m_queue.end(), [&](const Entry& entry) { return entry.doc == doc; }),
+                m_queue.end());
+    for (auto it = m_mapLabelUnloadable.begin(); it != m_mapLabelUnloadable.end();) {
+        if (it->second.doc == doc)
+            it = m_mapLabelUnloadable.erase(it);
+        else
+            ++it;
+    }
+
+    for (const std::shared_ptr<DeferredShapeLoader>& loader : doc->deferredShapeLoaders())
+        m_setLoaderQueued.erase(loader.get());
+}
+
+void DeferredShapesLoadQueue::runNext()
+{
+    // One product at a time, so prioritize() still applies to all the products not loaded yet
+    if (m_isTaskRunning)
+        return;
+
+    auto itEntry = std::find_if(m_queue.begin(), m_queue.end(), [](const Entry& entry) {
+        return entry.isRequested || entry.loader->isLoadedInBackground();
+    });
+    if (itEntry == m_queue.end())
+        return;
+
+    const Entry entry = *itEntry;
+    m_queue.erase(itEntry);
+    m_isTaskRunning = true;
+    auto taskMgr = TaskManager::globalInstance();
+    auto loadedShape = std::make_shared<TopoDS_Shape>();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        *loadedShape = entry.loader->loadShape(entry.labelProduct, progress);
+        if (loadedShape->IsNull() || entry.loader->isShapeTriangulated())
+            return;
+
+        if (m_fnComputeBRepMesh && !TaskProgress::isAbortRequested(progress))
+            m_fnComputeBRepMesh(*loadedShape, progress);
+    });
+    auto connTaskEnded = std::make_shared<QMetaObject::Connection>();
+    *connTaskEnded = QObject::connect(taskMgr, &TaskManager::ended, this, [=](TaskId endedTaskId) {
+        if (endedTaskId != taskId)
+            return;
+
+        QObject::disconnect(*connTaskEnded);
+        m_isTaskRunning = false;
+        this->applyLoadedShape(entry, *loadedShape);
+        this->runNext();
+    });
+    taskMgr->setTitle(taskId, tr("Load shape") + " - " + CafUtils::labelAttrStdName(entry.labelProduct));
+    taskMgr->setPriority(taskId, TaskPriority::Background);
+    taskMgr->run(taskId);
+}
+
+void DeferredShapesLoadQueue::applyLoadedShape(const Entry& entry, const TopoDS_Shape& shape)
+{
+    GuiDocument* guiDoc = m_guiApp->findGuiDocument(entry.doc);
+    if (shape.IsNull() || !guiDoc)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(entry.doc->dataMutex()); MAYO_UNUSED(lock);
+        entry.doc->xcaf().shapeTool()->SetShape(entry.labelProduct, shape);
+        entry.doc->invalidateShapeBoundingBox(entry.labelProduct);
+    }
+
+    if (!entry.loader->unloadedShape(entry.labelProduct).IsNull())
+        m_mapLabelUnloadable.insert({ entry.labelProduct, entry });
+
+    guiDoc->updateProductGraphics(entry.labelProduct);
+    guiDoc->graphicsScene()->redraw();
+    emit this->productShapeLoaded(entry.doc, entry.labelProduct);
+}
+
+} // namespace Mayo
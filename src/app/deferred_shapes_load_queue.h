@@ -0,0 +1,80 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/caf_utils.h"
+#include "../base/document_ptr.h"
+#include "../base/document_tree_node.h"
+#include "../base/span.h"
+#include "../base/task_common.h"
+
+#include <QtCore/QObject>
+#include <TDF_Label.hxx>
+#include <TopoDS_Shape.hxx>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Mayo {
+
+class DeferredShapeLoader;
+class GuiApplication;
+class TaskProgress;
+
+// Loads in background the product shapes deferred by readers(see DeferredShapeLoader), for all
+// the documents of a GuiApplication
+// Products are loaded one at a time in document order, unless requested earlier with
+// prioritize(). Once loaded and meshed, the shape is set to the product label in the GUI thread
+// and the graphics of the instances are recomputed
+// Products of loaders not working in background(see DeferredShapeLoader::isLoadedInBackground())
+// are loaded only once prioritized. Their shapes are unloaded when the GUI document releases the
+// graphics of the products, and queued again
+class DeferredShapesLoadQueue : public QObject {
+    Q_OBJECT
+public:
+    using FunctionComputeBRepMesh = std::function<void(const TopoDS_Shape&, TaskProgress*)>;
+
+    DeferredShapesLoadQueue(GuiApplication* guiApp, QObject* parent = nullptr);
+
+    void setFunctionComputeBRepMesh(FunctionComputeBRepMesh fn) { m_fnComputeBRepMesh = std::move(fn); }
+
+    // Moves to the front of the queue the products found under the tree nodes(deep traversal)
+    void prioritize(const DocumentTreeNode& node);
+    void prioritize(const DocumentPtr& doc, Span<const TreeNodeId> spanNodeId);
+
+    // Restores the placeholder shapes of the loaded products, if supported by their loaders
+    void unloadProducts(const DocumentPtr& doc, Span<const TDF_Label> spanLabelProduct);
+
+    int pendingCount() const { return int(m_queue.size()); }
+
+signals:
+    void productShapeLoaded(const Mayo::DocumentPtr& doc, const TDF_Label& labelProduct);
+
+private:
+    struct Entry {
+        DocumentPtr doc;
+        TDF_Label labelProduct;
+        std::shared_ptr<DeferredShapeLoader> loader;
+        bool isRequested = false; // Product was prioritized
+    };
+
+    void onDocumentEntityAdded(const DocumentPtr& doc);
+    void onDocumentAboutToClose(const DocumentPtr& doc);
+    void runNext();
+    void applyLoadedShape(const Entry& entry, const TopoDS_Shape& shape);
+
+    GuiApplication* m_guiApp = nullptr;
+    FunctionComputeBRepMesh m_fnComputeBRepMesh;
+    std::deque<Entry> m_queue;
+    std::unordered_map<TDF_Label, Entry> m_mapLabelUnloadable; // Loaded products that can be unloaded
+    std::unordered_set<const DeferredShapeLoader*> m_setLoaderQueued;
+    bool m_isTaskRunning = false;
+};
+
+} // namespace Mayo
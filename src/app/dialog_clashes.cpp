@@ -0,0 +1,66 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "dialog_clashes.h"
+
+#include "../base/application.h"
+#include "../base/application_item_selection_model.h"
+#include "../base/document.h"
+#include "../gui/gui_application.h"
+#include "ui_dialog_clashes.h"
+
+namespace Mayo {
+
+DialogClashes::DialogClashes(GuiApplication* guiApp, QWidget* parent)
+    : QDialog(parent),
+      m_ui(new Ui_DialogClashes),
+      m_guiApp(guiApp)
+{
+    m_ui->setupUi(this);
+    QObject::connect(
+                m_ui->treeWidget_Clashes, &QTreeWidget::itemClicked,
+                this, &DialogClashes::onClashItemClicked);
+}
+
+DialogClashes::~DialogClashes()
+{
+    delete m_ui;
+}
+
+void DialogClashes::load(const DocumentPtr& doc, const std::vector<ClashDetection::Clash>& vecClash)
+{
+    m_doc = doc;
+    m_vecClash = vecClash;
+    m_ui->treeWidget_Clashes->clear();
+    const Tree<TDF_Label>& modelTree = doc->modelTree();
+    for (size_t i = 0; i < vecClash.size(); ++i) {
+        const ClashDetection::Clash& clash = vecClash.at(i);
+        auto item = new QTreeWidgetItem(m_ui->treeWidget_Clashes);
+        item->setText(0, doc->labelName(modelTree.nodeData(clash.firstNodeId)));
+        item->setText(1, doc->labelName(modelTree.nodeData(clash.secondNodeId)));
+        item->setData(0, Qt::UserRole, int(i));
+    }
+
+    m_ui->label_Count->setText(tr("%n clash(es) found", nullptr, int(vecClash.size())));
+}
+
+void DialogClashes::onClashItemClicked(QTreeWidgetItem* item, int column)
+{
+    Q_UNUSED(column);
+    // Document may have been closed meanwhile
+    if (m_guiApp->application()->findIndexOfDocument(m_doc) == -1)
+        return;
+
+    const ClashDetection::Clash& clash = m_vecClash.at(item->data(0, Qt::UserRole).toInt());
+    ApplicationItem vecAppItem[] = {
+        DocumentTreeNode(m_doc, clash.firstNodeId),
+        DocumentTreeNode(m_doc, clash.secondNodeId)
+    };
+    m_guiApp->selectionModel()->clear();
+    m_guiApp->selectionModel()->add(vecAppItem);
+}
+
+} // namespace Mayo
@@ -0,0 +1,38 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/clash_detection.h"
+#include "../base/document_ptr.h"
+
+#include <QtWidgets/QDialog>
+#include <vector>
+class QTreeWidgetItem;
+
+namespace Mayo {
+
+class GuiApplication;
+
+// Lists the clashing pairs of parts of a document, clicking a pair selects both parts
+class DialogClashes : public QDialog {
+    Q_OBJECT
+public:
+    DialogClashes(GuiApplication* guiApp, QWidget* parent = nullptr);
+    ~DialogClashes();
+
+    void load(const DocumentPtr& doc, const std::vector<ClashDetection::Clash>& vecClash);
+
+private:
+    void onClashItemClicked(QTreeWidgetItem* item, int column);
+
+    class Ui_DialogClashes* m_ui = nullptr;
+    GuiApplication* m_guiApp = nullptr;
+    DocumentPtr m_doc;
+    std::vector<ClashDetection::Clash> m_vecClash;
+};
+
+} // namespace Mayo
@@ -19,6 +19,8 @@
 #include "widgets_utils.h"
 #include "ui_dialog_inspect_xde.h"
 
+#include <QtWidgets/QScrollBar>
+
 #include <TDF_AttributeIterator.hxx>
 #include <TDF_ChildIterator.hxx>
 #include <TDF_LabelSequence.hxx>
@@ -53,6 +55,7 @@
 #  include <XCAFDoc_VisMaterialTool.hxx>
 #endif
 
+#include <optional>
 #include <sstream>
 
 namespace Mayo {
@@ -63,88 +66,67 @@ enum TreeWidgetItemRole {
     TreeWidgetItem_TdfLabelRole = Qt::UserRole + 1
 };
 
-static void loadLabelAttributes(const TDF_Label& label, QTreeWidgetItem* treeItem)
+// Name of the attribute type, cheap to get so it can be called for every attribute of a label
+static QString attributeTypeName(const Handle_TDF_Attribute& ptrAttr)
 {
-    for (TDF_AttributeIterator it(label); it.More(); it.Next()) {
-        const Handle_TDF_Attribute ptrAttr = it.Value();
-        const Standard_GUID& attrId = ptrAttr->ID();
-        QString text;
-        QString value;
-        if (attrId == TDataStd_Name::GetID()) {
-            const auto& name = static_cast<const TDataStd_Name&>(*ptrAttr);
-            text = "TDataStd_Name";
-            value = StringUtils::fromUtf16(name.Get());
-        }
-#if 0
-        else if (attrId == TDataStd_TreeNode::GetID()) {
-            const auto& node = static_cast<const TDataStd_TreeNode&>(*ptrAttr);
-            text = QString("TDataStd_TreeNode [%1]").arg(area.Get());
-        }
-#endif
-        else if (attrId == XCAFDoc_Area::GetID()) {
-            const auto& area = static_cast<const XCAFDoc_Area&>(*ptrAttr);
-            text = "XCAFDoc_Area";
-            value = StringUtils::text(
-                        area.Get(), AppModule::get(Application::instance())->defaultTextOptions());
-        }
-        else if (attrId == XCAFDoc_Centroid::GetID()) {
-            const auto& centroid = static_cast<const XCAFDoc_Centroid&>(*ptrAttr);
-            text = "XCAFDoc_Centroid";
-            value = StringUtils::text(
-                        centroid.Get(), AppModule::get(Application::instance())->defaultTextOptions());
-        }
-        else if (attrId == XCAFDoc_Volume::GetID()) {
-            const auto& volume = static_cast<const XCAFDoc_Volume&>(*ptrAttr);
-            text = "XCAFDoc_Volume";
-            value = StringUtils::text(
-                        volume.Get(), AppModule::get(Application::instance())->defaultTextOptions());
-        }
-        else if (attrId == XCAFDoc_Color::GetID()) {
-            const auto& color = static_cast<const XCAFDoc_Color&>(*ptrAttr);
-            text = "XCAFDoc_Color";
-            value = StringUtils::text(color.GetColor());
-        }
-        else if (attrId == XCAFDoc_Location::GetID()) {
-            const auto& location = static_cast<const XCAFDoc_Location&>(*ptrAttr);
-            text = "XCAFDoc_Location";
-            value = StringUtils::text(
-                        location.Get().Transformation(),
-                        AppModule::get(Application::instance())->defaultTextOptions());
-        }
-        else if (attrId == TNaming_NamedShape::GetID()) {
-            const auto& namedShape = static_cast<const TNaming_NamedShape&>(*ptrAttr);
-            text = "TNaming_NamedShape";
-            value = DialogInspectXde::tr("ShapeType=%1, Evolution=%2")
-                    .arg(MetaEnum::name(namedShape.Get().ShapeType()).data())
-                    .arg(MetaEnum::name(namedShape.Evolution()).data());
-        }
-        else {
-            std::stringstream sstream;
-            ptrAttr->Dump(sstream);
-            QString strDump = QString::fromStdString(sstream.str());
-
-            int i = 0;
-            while (i < strDump.size() && strDump.at(i).isSpace()) ++i;
-
-            const int wordStart = i;
-            while (i < strDump.size() && !strDump.at(i).isSpace()) ++i;
-
-            const int wordEnd = i;
-            while (i < strDump.size() && strDump.at(i).isSpace()) ++i;
-
-            const int dataStart = i;
-            text = wordStart < strDump.size() ?
-                        strDump.mid(wordStart, wordEnd - wordStart) :
-                        QStringLiteral("??");
-            strDump = strDump.right(strDump.size() - dataStart);
-            value = strDump.replace(QChar('\n'), QString("  "));
-        }
+    return QString::fromUtf8(ptrAttr->DynamicType()->Name());
+}
 
-        auto attrTreeItem = new QTreeWidgetItem;
-        attrTreeItem->setText(0, text);
-        attrTreeItem->setText(1, value);
-        treeItem->addChild(attrTreeItem);
+// Text of the value held by the attribute, std::nullopt when the attribute type isn't handled
+static std::optional<QString> attributeValueText(const Handle_TDF_Attribute& ptrAttr)
+{
+    const Standard_GUID& attrId = ptrAttr->ID();
+    if (attrId == TDataStd_Name::GetID()) {
+        const auto& name = static_cast<const TDataStd_Name&>(*ptrAttr);
+        return StringUtils::fromUtf16(name.Get());
+    }
+    else if (attrId == XCAFDoc_Area::GetID()) {
+        const auto& area = static_cast<const XCAFDoc_Area&>(*ptrAttr);
+        return StringUtils::text(area.Get(), AppModule::get(Application::instance())->defaultTextOptions());
+    }
+    else if (attrId == XCAFDoc_Centroid::GetID()) {
+        const auto& centroid = static_cast<const XCAFDoc_Centroid&>(*ptrAttr);
+        return StringUtils::text(centroid.Get(), AppModule::get(Application::instance())->defaultTextOptions());
+    }
+    else if (attrId == XCAFDoc_Volume::GetID()) {
+        const auto& volume = static_cast<const XCAFDoc_Volume&>(*ptrAttr);
+        return StringUtils::text(volume.Get(), AppModule::get(Application::instance())->defaultTextOptions());
     }
+    else if (attrId == XCAFDoc_Color::GetID()) {
+        const auto& color = static_cast<const XCAFDoc_Color&>(*ptrAttr);
+        return StringUtils::text(color.GetColor());
+    }
+    else if (attrId == XCAFDoc_Location::GetID()) {
+        const auto& location = static_cast<const XCAFDoc_Location&>(*ptrAttr);
+        return StringUtils::text(
+                    location.Get().Transformation(),
+                    AppModule::get(Application::instance())->defaultTextOptions());
+    }
+    else if (attrId == TNaming_NamedShape::GetID()) {
+        const auto& namedShape = static_cast<const TNaming_NamedShape&>(*ptrAttr);
+        return DialogInspectXde::tr("ShapeType=%1, Evolution=%2")
+                .arg(MetaEnum::name(namedShape.Get().ShapeType()).data())
+                .arg(MetaEnum::name(namedShape.Evolution()).data());
+    }
+
+    return {};
+}
+
+// Text of the attribute value extracted from TDF_Attribute::Dump(), that is everything after the
+// first word(generally the attribute type name)
+static QString attributeDumpValueText(const Handle_TDF_Attribute& ptrAttr)
+{
+    std::stringstream sstream;
+    ptrAttr->Dump(sstream);
+    QString strDump = QString::fromStdString(sstream.str());
+
+    int i = 0;
+    while (i < strDump.size() && strDump.at(i).isSpace()) ++i;
+    while (i < strDump.size() && !strDump.at(i).isSpace()) ++i;
+    while (i < strDump.size() && strDump.at(i).isSpace()) ++i;
+
+    strDump = strDump.right(strDump.size() - i);
+    return strDump.replace(QChar('\n'), QString("  "));
 }
 
 static QTreeWidgetItem* createPropertyTreeItem(const QString& text)
@@ -593,16 +575,20 @@ static void loadLabel(const TDF_Label& label, QTreeWidgetItem* treeItem)
     const QString stdName = CafUtils::labelAttrStdName(label);
     if (!stdName.isEmpty())
         treeItem->setText(0, treeItem->text(0) + " " + stdName);
+
+    // Children are loaded when the item gets expanded
+    if (label.HasChild())
+        treeItem->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
 }
 
-static void deepLoadChildrenLabels(const TDF_Label& label, QTreeWidgetItem* treeItem)
+static void loadChildrenLabels(const TDF_Label& label, QTreeWidgetItem* treeItem)
 {
     for (TDF_ChildIterator it(label, Standard_False); it.More(); it.Next()) {
-        const TDF_Label childLabel = it.Value();
         auto childTreeItem = new QTreeWidgetItem(treeItem);
-        loadLabel(childLabel, childTreeItem);
-        deepLoadChildrenLabels(childLabel, childTreeItem);
+        loadLabel(it.Value(), childTreeItem);
     }
+
+    treeItem->setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicatorWhenChildless);
 }
 
 } // namespace Internal
@@ -617,6 +603,16 @@ DialogInspectXde::DialogInspectXde(QWidget *parent)
     QObject::connect(
                 m_ui->treeWidget_Document, &QTreeWidget::itemClicked,
                 this, &DialogInspectXde::onLabelTreeWidgetItemClicked);
+    QObject::connect(
+                m_ui->treeWidget_Document, &QTreeWidget::itemExpanded,
+                this, &DialogInspectXde::onLabelTreeWidgetItemExpanded);
+
+    // Attribute values are formatted only when their tree item is visible
+    auto fnLoadVisibleAttributeValues = [=]{ this->loadVisibleAttributeValues(); };
+    QTreeWidget* treeProps = m_ui->treeWidget_LabelProps;
+    QObject::connect(treeProps, &QTreeWidget::itemExpanded, this, fnLoadVisibleAttributeValues);
+    QObject::connect(treeProps->verticalScrollBar(), &QScrollBar::valueChanged, this, fnLoadVisibleAttributeValues);
+    QObject::connect(treeProps->verticalScrollBar(), &QScrollBar::rangeChanged, this, fnLoadVisibleAttributeValues);
 }
 
 DialogInspectXde::~DialogInspectXde()
@@ -637,7 +633,7 @@ void DialogInspectXde::load(const Handle_TDocStd_Document& doc)
         const TDF_Label label = doc->Main();
         auto treeItem = new QTreeWidgetItem;
         Internal::loadLabel(label, treeItem);
-        Internal::deepLoadChildrenLabels(label, treeItem);
+        Internal::loadChildrenLabels(label, treeItem);
         m_ui->treeWidget_Document->addTopLevelItem(treeItem);
         treeItem->setExpanded(true);
     }
@@ -648,11 +644,17 @@ void DialogInspectXde::onLabelTreeWidgetItemClicked(QTreeWidgetItem *item, int /
     const QVariant varLabel = item->data(0, Internal::TreeWidgetItem_TdfLabelRole);
     if (varLabel.isValid()) {
         m_ui->treeWidget_LabelProps->clear();
+        m_mapItemAttribute.clear();
         const TDF_Label label = varLabel.value<TDF_Label>();
         if (label.HasAttribute()) {
             auto itemAttrs = new QTreeWidgetItem;
             itemAttrs->setText(0, tr("Attributes"));
-            Internal::loadLabelAttributes(label, itemAttrs);
+            for (TDF_AttributeIterator it(label); it.More(); it.Next()) {
+                auto attrTreeItem = new QTreeWidgetItem(itemAttrs);
+                attrTreeItem->setText(0, Internal::attributeTypeName(it.Value()));
+                m_mapItemAttribute.insert({ attrTreeItem, it.Value() });
+            }
+
             m_ui->treeWidget_LabelProps->addTopLevelItem(itemAttrs);
         }
 
@@ -689,8 +691,46 @@ void DialogInspectXde::onLabelTreeWidgetItemClicked(QTreeWidgetItem *item, int /
     }
 
     m_ui->treeWidget_LabelProps->expandAll();
+    this->loadVisibleAttributeValues();
     for (int i = 0; i < m_ui->treeWidget_LabelProps->columnCount(); ++i)
         m_ui->treeWidget_LabelProps->resizeColumnToContents(i);
 }
 
+void DialogInspectXde::onLabelTreeWidgetItemExpanded(QTreeWidgetItem* item)
+{
+    const QVariant varLabel = item->data(0, Internal::TreeWidgetItem_TdfLabelRole);
+    if (varLabel.isValid() && item->childCount() == 0)
+        Internal::loadChildrenLabels(varLabel.value<TDF_Label>(), item);
+}
+
+void DialogInspectXde::loadVisibleAttributeValues()
+{
+    if (m_mapItemAttribute.empty())
+        return;
+
+    QTreeWidget* treeProps = m_ui->treeWidget_LabelProps;
+    const int viewportHeight = treeProps->viewport()->height();
+    QTreeWidgetItem* item = treeProps->itemAt(0, 0);
+    while (item && treeProps->visualItemRect(item).top() < viewportHeight) {
+        auto itAttr = m_mapItemAttribute.find(item);
+        if (itAttr != m_mapItemAttribute.end()) {
+            const Handle_TDF_Attribute& ptrAttr = itAttr->second;
+            std::optional<QString> value = Internal::attributeValueText(ptrAttr);
+            if (!value) {
+                // Attribute dumps are costly to produce and parse, keep them for later use
+                auto itDump = m_mapAttributeDumpValue.find(ptrAttr);
+                if (itDump == m_mapAttributeDumpValue.end())
+                    itDump = m_mapAttributeDumpValue.insert({ ptrAttr, Internal::attributeDumpValueText(ptrAttr) }).first;
+
+                value = itDump->second;
+            }
+
+            item->setText(1, value.value());
+            m_mapItemAttribute.erase(itAttr);
+        }
+
+        item = treeProps->itemBelow(item);
+    }
+}
+
 } // namespace Mayo
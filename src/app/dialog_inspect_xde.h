@@ -6,8 +6,12 @@
 
 #pragma once
 
+#include "../base/tkernel_utils.h"
+
 #include <QtWidgets/QDialog>
+#include <TDF_Attribute.hxx>
 #include <TDocStd_Document.hxx>
+#include <unordered_map>
 class QTreeWidgetItem;
 
 namespace Mayo {
@@ -22,9 +26,14 @@ public:
 
 private:
     void onLabelTreeWidgetItemClicked(QTreeWidgetItem* item, int column);
+    void onLabelTreeWidgetItemExpanded(QTreeWidgetItem* item);
+    void loadVisibleAttributeValues();
 
     class Ui_DialogInspectXde* m_ui = nullptr;
     Handle_TDocStd_Document m_doc;
+    // Attribute tree items whose value text is not yet formatted
+    std::unordered_map<QTreeWidgetItem*, Handle_TDF_Attribute> m_mapItemAttribute;
+    std::unordered_map<Handle_TDF_Attribute, QString> m_mapAttributeDumpValue;
 };
 
 } // namespace Mayo
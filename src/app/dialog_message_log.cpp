@@ -0,0 +1,80 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "dialog_message_log.h"
+
+#include <QtCore/QTime>
+#include <QtWidgets/QDialogButtonBox>
+#include <QtWidgets/QPlainTextEdit>
+#include <QtWidgets/QPushButton>
+#include <QtWidgets/QVBoxLayout>
+
+namespace Mayo {
+
+namespace Internal {
+
+static QString messageTypeText(Messenger::MessageType msgType)
+{
+    switch (msgType) {
+    case Messenger::MessageType::Trace: return DialogMessageLog::tr("Trace");
+    case Messenger::MessageType::Info: return DialogMessageLog::tr("Info");
+    case Messenger::MessageType::Warning: return DialogMessageLog::tr("Warning");
+    case Messenger::MessageType::Error: return DialogMessageLog::tr("Error");
+    }
+
+    return {};
+}
+
+} // namespace Internal
+
+DialogMessageLog::DialogMessageLog(QWidget* parent)
+    : QDialog(parent),
+      m_textEdit(new QPlainTextEdit(this))
+{
+    this->setWindowTitle(tr("Message Log"));
+    this->resize(640, 360);
+    m_textEdit->setReadOnly(true);
+    m_textEdit->setMaximumBlockCount(10000);
+    m_textEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
+
+    auto btnBox = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    QPushButton* btnClear = btnBox->addButton(tr("Clear"), QDialogButtonBox::ResetRole);
+    QObject::connect(btnClear, &QPushButton::clicked, this, &DialogMessageLog::clear);
+    QObject::connect(btnBox, &QDialogButtonBox::rejected, this, &QDialog::hide);
+
+    auto mainLayout = new QVBoxLayout;
+    mainLayout->addWidget(m_textEdit);
+    mainLayout->addWidget(btnBox);
+    this->setLayout(mainLayout);
+}
+
+void DialogMessageLog::appendMessages(const std::vector<MessengerQtSignal::Message>& vecMessage)
+{
+    // Lines of a batch are appended with a single call, so the document layout is updated once
+    const QString strTime = QTime::currentTime().toString(Qt::ISODate);
+    QString strBatch;
+    for (const MessengerQtSignal::Message& msg : vecMessage) {
+        if (msg.type == Messenger::MessageType::Trace)
+            continue;
+
+        if (!strBatch.isEmpty())
+            strBatch += '\n';
+
+        strBatch += strTime + " [" + Internal::messageTypeText(msg.type) + "] " + msg.text;
+        if (msg.count > 1)
+            strBatch += tr(" (repeated %1 times)").arg(msg.count);
+    }
+
+    if (!strBatch.isEmpty())
+        m_textEdit->appendPlainText(strBatch);
+}
+
+void DialogMessageLog::clear()
+{
+    m_textEdit->clear();
+}
+
+} // namespace Mayo
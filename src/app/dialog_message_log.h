@@ -0,0 +1,31 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/messenger.h"
+
+#include <QtWidgets/QDialog>
+#include <vector>
+class QPlainTextEdit;
+
+namespace Mayo {
+
+// Scrollable log of all the application messages, fed in batch by MessengerQtSignal
+// Oldest lines are discarded beyond a maximum count
+class DialogMessageLog : public QDialog {
+    Q_OBJECT
+public:
+    DialogMessageLog(QWidget* parent = nullptr);
+
+    void appendMessages(const std::vector<MessengerQtSignal::Message>& vecMessage);
+    void clear();
+
+private:
+    QPlainTextEdit* m_textEdit = nullptr;
+};
+
+} // namespace Mayo
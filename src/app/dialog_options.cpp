@@ -212,6 +212,10 @@ DialogOptions::DialogOptions(Settings* settings, QWidget* parent)
     QObject::connect(m_settings, &Settings::changed, this, [=](const Property* property) {
         this->syncEditor(CppUtils::findValue(property, m_mapSettingEditor));
     });
+    QObject::connect(m_settings, &Settings::changedMany, this, [=](Span<Property* const> properties) {
+        for (const Property* property : properties)
+            this->syncEditor(CppUtils::findValue(property, m_mapSettingEditor));
+    });
 
     // When a setting is clicked in the "right-side" view then scroll to and select corresponding
     // tree item in the "left-side" view
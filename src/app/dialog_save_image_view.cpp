@@ -16,11 +16,16 @@
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QPushButton>
+#include <Graphic3d_GraphicDriver.hxx>
+#include <algorithm>
 
 namespace Mayo {
 
 namespace Internal {
 
+// Maximum width/height of the offscreen framebuffer used to render image tiles
+static const int MaxTileSize = 2048;
+
 static QImage qtImageTemp(const Image_PixMap& occImg)
 {
     const QImage img(occImg.Data(),
@@ -133,14 +138,23 @@ void DialogSaveImageView::preview()
 bool DialogSaveImageView::createImageView(Image_PixMap* img) const
 {
     img->SetTopDown(true);
-    const bool ok =
-            m_view->ToPixMap(
-                *img,
-                m_ui->edit_Width->value(),
-                m_ui->edit_Height->value(),
-                Graphic3d_BT_RGBA,
-                m_ui->checkBox_KeepRatio->isChecked());
-    return ok;
+    V3d_ImageDumpOptions dumpOptions;
+    dumpOptions.Width = m_ui->edit_Width->value();
+    dumpOptions.Height = m_ui->edit_Height->value();
+    dumpOptions.BufferType = Graphic3d_BT_RGBA;
+    dumpOptions.ToAdjustAspect = m_ui->checkBox_KeepRatio->isChecked();
+    // Large images are rendered as a grid of sub-frustum tiles, so the offscreen framebuffer stays
+    // within GPU limits and its memory is proportional to one tile
+    const Handle_Graphic3d_GraphicDriver& driver = m_view->Viewer()->Driver();
+    const int maxTileSize =
+            std::min(driver->InquireLimit(Graphic3d_TypeOfLimit_MaxViewDumpSizeX),
+                     driver->InquireLimit(Graphic3d_TypeOfLimit_MaxViewDumpSizeY));
+    const int tileSize =
+            maxTileSize > 0 ? std::min(Internal::MaxTileSize, maxTileSize) : Internal::MaxTileSize;
+    if (dumpOptions.Width > tileSize || dumpOptions.Height > tileSize)
+        dumpOptions.TileSize = tileSize;
+
+    return m_view->ToPixMap(*img, dumpOptions);
 }
 
 } // namespace Mayo
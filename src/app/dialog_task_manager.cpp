@@ -7,6 +7,7 @@
 #include "dialog_task_manager.h"
 
 #include "../base/application.h"
+#include "../base/perf_stats.h"
 #include "../base/settings.h"
 #include "../base/string_utils.h"
 #include "../base/task_manager.h"
@@ -18,6 +19,7 @@
 #include <QtWidgets/QLabel>
 #include <QtWidgets/QProgressBar>
 #include <QtWidgets/QToolButton>
+#include <chrono>
 
 namespace Mayo {
 
@@ -32,6 +34,7 @@ public:
     QLabel* m_label = nullptr;
     QProgressBar* m_progress = nullptr;
     QToolButton* m_interruptBtn = nullptr;
+    QLabel* m_labelPerfStats = nullptr; // Breakdown of task timings, see PerfStats
 
     void createUnboundedProgressTimer();
     void stopUnboundedProgressTimer();
@@ -52,7 +55,8 @@ DialogTaskManager::TaskWidget::TaskWidget(QWidget* parent)
     : QWidget(parent),
       m_label(new QLabel(this)),
       m_progress(new QProgressBar(this)),
-      m_interruptBtn(new QToolButton(this))
+      m_interruptBtn(new QToolButton(this)),
+      m_labelPerfStats(new QLabel(this))
 {
     QFont labelFont = m_label->font();
     labelFont.setBold(true);
@@ -69,7 +73,9 @@ DialogTaskManager::TaskWidget::TaskWidget(QWidget* parent)
     auto mainLayout = new QVBoxLayout;
     mainLayout->addWidget(m_label);
     mainLayout->addLayout(progressLayout);
+    mainLayout->addWidget(m_labelPerfStats);
     mainLayout->setSpacing(0);
+    m_labelPerfStats->setVisible(false);
     this->setLayout(mainLayout);
 }
 
@@ -171,7 +177,30 @@ void DialogTaskManager::onTaskProgress(TaskId taskId, int percent)
             widget->createUnboundedProgressTimer();
             widget->m_progress->setTextVisible(false);
         }
+
+        this->updateTaskPerfStats(taskId);
+    }
+}
+
+void DialogTaskManager::updateTaskPerfStats(TaskId taskId)
+{
+    TaskWidget* widget = this->taskWidget(taskId);
+    const PerfStats* stats = PerfStats::isEnabled() ? m_taskMgr->perfStats(taskId) : nullptr;
+    if (!widget || !stats)
+        return;
+
+    QStringList listStageText;
+    for (const PerfStats::Stage& stage : stats->stages()) {
+        const auto durationMs = std::chrono::duration_cast<std::chrono::milliseconds>(stage.totalDuration);
+        QString text = tr("%1: %2ms").arg(QString::fromStdString(stage.name)).arg(durationMs.count());
+        if (stage.callCount > 1)
+            text += tr(" (%1 calls, %2 threads)").arg(stage.callCount).arg(stage.threadCount);
+
+        listStageText.push_back(text);
     }
+
+    widget->m_labelPerfStats->setText(listStageText.join('\n'));
+    widget->m_labelPerfStats->setVisible(!listStageText.isEmpty());
 }
 
 void DialogTaskManager::onTaskProgressStep(TaskId taskId, const QString& name)
@@ -29,6 +29,7 @@ private:
     void onTaskEnded(TaskId taskId);
     void onTaskProgress(TaskId taskId, int percent);
     void onTaskProgressStep(TaskId taskId, const QString& name);
+    void updateTaskPerfStats(TaskId taskId);
     void interruptTask();
 
     class Ui_DialogTaskManager* m_ui = nullptr;
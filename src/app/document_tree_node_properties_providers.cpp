@@ -9,6 +9,7 @@
 #include "../base/caf_utils.h"
 #include "../base/document.h"
 #include "../base/document_tree_node.h"
+#include "../base/mesh_quality_analysis.h"
 #include "../base/mesh_utils.h"
 #include "../base/meta_enum.h"
 #include "../base/string_utils.h"
@@ -18,17 +19,76 @@
 
 namespace Mayo {
 
+namespace {
+
+// Mesh quality of an entity, shown once it was analyzed(see Document::meshQualityReport())
+class MeshQualityProperties {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::MeshQualityProperties)
+public:
+    MeshQualityProperties(PropertyGroup* group) : m_group(group) {}
+
+    // Returns false if 'report' is null, properties have then to be removed from the group
+    bool load(const MeshQualityAnalysis::Report* report)
+    {
+        if (!report)
+            return false;
+
+        m_propertyDegenerateTriangles.setValue(report->degenerateTriangleCount);
+        m_propertySliverTriangles.setValue(report->sliverTriangleCount);
+        m_propertyBoundaryEdges.setValue(report->boundaryEdgeCount);
+        m_propertyNonManifoldEdges.setValue(report->nonManifoldEdgeCount);
+        m_propertyInconsistentEdges.setValue(report->inconsistentEdgeCount);
+        m_propertyDuplicateNodes.setValue(report->duplicateNodeCount);
+        m_propertyMaxAspectRatio.setValue(report->maxAspectRatio);
+        // Classes are written as "<=1.5:n <=2:n ... >20:n"
+        QStringList listClass;
+        const auto& bounds = MeshQualityAnalysis::AspectRatioClassBounds;
+        for (int i = 0; i < MeshQualityAnalysis::AspectRatioClassCount; ++i) {
+            const QString strBound =
+                    i < MeshQualityAnalysis::AspectRatioClassCount - 1 ?
+                        QString("<=%1").arg(bounds[i]) :
+                        QString(">%1").arg(bounds[i - 1]);
+            listClass.push_back(strBound + ":" + QString::number(report->aspectRatioHistogram[i]));
+        }
+
+        m_propertyAspectRatioHistogram.setValue(listClass.join(' '));
+        return true;
+    }
+
+    std::vector<Property*> properties() {
+        return {
+            &m_propertyDegenerateTriangles, &m_propertySliverTriangles, &m_propertyBoundaryEdges,
+            &m_propertyNonManifoldEdges, &m_propertyInconsistentEdges, &m_propertyDuplicateNodes,
+            &m_propertyMaxAspectRatio, &m_propertyAspectRatioHistogram
+        };
+    }
+
+private:
+    PropertyGroup* m_group = nullptr;
+    PropertyInt m_propertyDegenerateTriangles{ m_group, textId("DegenerateTriangles") };
+    PropertyInt m_propertySliverTriangles{ m_group, textId("SliverTriangles") };
+    PropertyInt m_propertyBoundaryEdges{ m_group, textId("BoundaryEdges") };
+    PropertyInt m_propertyNonManifoldEdges{ m_group, textId("NonManifoldEdges") };
+    PropertyInt m_propertyInconsistentEdges{ m_group, textId("InconsistentOrientationEdges") };
+    PropertyInt m_propertyDuplicateNodes{ m_group, textId("DuplicateNodes") };
+    PropertyDouble m_propertyMaxAspectRatio{ m_group, textId("MaxAspectRatio") };
+    PropertyQString m_propertyAspectRatioHistogram{ m_group, textId("AspectRatioHistogram") };
+};
+
+} // namespace
+
 class XCaf_DocumentTreeNodePropertiesProvider::Properties : public PropertyGroupSignals {
     MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::XCaf_DocumentTreeNodeProperties)
 public:
     Properties(const DocumentTreeNode& treeNode)
-        : m_label(treeNode.label())
+        : m_document(treeNode.document()),
+          m_label(treeNode.label())
     {
         const TDF_Label& label = m_label;
         const XCaf& xcaf = treeNode.document()->xcaf();
 
         // Name
-        m_propertyName.setValue(CafUtils::labelAttrStdName(label));
+        m_propertyName.setValue(m_document->labelName(label));
 
         // Shape type
         const TopAbs_ShapeEnum shapeType = XCAFDoc_ShapeTool::GetShape(label).ShapeType();
@@ -90,7 +150,7 @@ public:
         // Referred entity's properties
         if (XCaf::isShapeReference(label)) {
             m_labelReferred = XCaf::shapeReferred(label);
-            m_propertyReferredName.setValue(CafUtils::labelAttrStdName(m_labelReferred));
+            m_propertyReferredName.setValue(m_document->labelName(m_labelReferred));
             auto validProps = XCaf::validationProperties(m_labelReferred);
             m_propertyReferredValidationCentroid.setValue(validProps.centroid);
             if (!validProps.hasCentroid)
@@ -117,6 +177,12 @@ public:
             this->removeProperty(&m_propertyReferredColor);
         }
 
+        // Mesh quality of the face triangulations, for entities only
+        if (!m_meshQuality.load(m_document->findMeshQualityReport(label).get())) {
+            for (Property* prop : m_meshQuality.properties())
+                this->removeProperty(prop);
+        }
+
         for (Property* prop : this->properties())
             prop->setUserReadOnly(true);
 
@@ -127,9 +193,9 @@ public:
     void onPropertyChanged(Property* prop) override
     {
         if (prop == &m_propertyName)
-            CafUtils::setLabelAttrStdName(m_label, m_propertyName.value());
+            m_document->setLabelName(m_label, m_propertyName.value());
         else if (prop == &m_propertyReferredName)
-            CafUtils::setLabelAttrStdName(m_labelReferred, m_propertyReferredName.value());
+            m_document->setLabelName(m_labelReferred, m_propertyReferredName.value());
 
         PropertyGroupSignals::onPropertyChanged(prop);
     }
@@ -149,8 +215,10 @@ public:
     PropertyArea m_propertyReferredValidationArea{ this, textId("ProductArea") };
     PropertyVolume m_propertyReferredValidationVolume{ this, textId("ProductVolume") };
 
+    DocumentPtr m_document;
     TDF_Label m_label;
     TDF_Label m_labelReferred;
+    MeshQualityProperties m_meshQuality{ this };
 };
 
 bool XCaf_DocumentTreeNodePropertiesProvider::supports(const DocumentTreeNode& treeNode) const
@@ -179,8 +247,14 @@ public:
 
         m_propertyNodeCount.setValue(!polyTri.IsNull() ? polyTri->NbNodes() : 0);
         m_propertyTriangleCount.setValue(!polyTri.IsNull() ? polyTri->NbTriangles() : 0);
-        m_propertyArea.setQuantity(MeshUtils::triangulationArea(polyTri) * Quantity_SquaredMillimeter);
-        m_propertyVolume.setQuantity(MeshUtils::triangulationVolume(polyTri) * Quantity_CubicMillimeter);
+        const MeshUtils::TriangulationProperties meshProps = MeshUtils::triangulationProperties(polyTri);
+        m_propertyArea.setQuantity(meshProps.area * Quantity_SquaredMillimeter);
+        m_propertyVolume.setQuantity(meshProps.volume * Quantity_CubicMillimeter);
+        m_propertyCentroid.setValue(meshProps.centroid);
+        if (!m_meshQuality.load(treeNode.document()->findMeshQualityReport(treeNode.label()).get())) {
+            for (Property* prop : m_meshQuality.properties())
+                this->removeProperty(prop);
+        }
         for (Property* property : this->properties())
             property->setUserReadOnly(true);
     }
@@ -189,6 +263,8 @@ public:
     PropertyInt m_propertyTriangleCount{ this, textId("TriangleCount") };
     PropertyArea m_propertyArea{ this, textId("Area") };
     PropertyVolume m_propertyVolume{ this, textId("Volume") };
+    PropertyOccPnt m_propertyCentroid{ this, textId("Centroid") };
+    MeshQualityProperties m_meshQuality{ this };
 };
 
 bool Mesh_DocumentTreeNodePropertiesProvider::supports(const DocumentTreeNode& treeNode) const
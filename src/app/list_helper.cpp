@@ -67,6 +67,8 @@ QVariant Model::data(const QModelIndex& index, int role) const
     switch (role) {
     case Qt::DisplayRole:
         return item->name;
+    case Qt::ToolTipRole:
+        return !item->toolTip.isEmpty() ? QVariant(item->toolTip) : QVariant();
     case RoleItemPtr:
         return QVariant::fromValue(const_cast<ModelItem*>(item));
     case RoleItemImage: {
@@ -21,6 +21,7 @@ struct ModelItem {
     QString name;
     QString description;
     QString imageUrl;
+    QString toolTip;
     QTextOption::WrapMode textWrapMode = QTextOption::NoWrap;
 };
 
@@ -5,17 +5,25 @@
 ****************************************************************************/
 
 #include "../base/application.h"
+#include "../base/cross_section.h"
 #include "../base/document_tree_node_properties_provider.h"
+#include "../base/global.h"
 #include "../base/io_system.h"
-#include "../base/messenger.h"
 #include "../base/settings.h"
-#include "../base/task_manager.h"
+#include "../io_3mf/io_3mf.h"
 #include "../io_gmio/io_gmio.h"
 #include "../io_occ/io_occ.h"
+#include "../io_ply/io_ply.h"
+#include "../io_point_cloud/io_point_cloud.h"
+#include "../cli/cli_convert.h"
+#include "../cli/cli_options.h"
+#include "../cli/cli_process_pool.h"
+#include "../cli/cli_serve.h"
+#include "../cli/console.h"
 #include "../graphics/graphics_object_driver.h"
 #include "../gui/gui_application.h"
 #include "app_module.h"
-#include "console.h"
+#include "cli_render.h"
 #include "document_tree_node_properties_providers.h"
 #include "mainwindow.h"
 #include "theme.h"
@@ -26,19 +34,15 @@
 
 #include <QtCore/QtDebug>
 #include <QtCore/QCommandLineParser>
-#include <QtCore/QDir>
 #include <QtCore/QSettings>
 #include <QtCore/QTimer>
 #include <QtCore/QTranslator>
+#include <QtGui/QGuiApplication>
 #include <QtWidgets/QApplication>
 
-#include <Message.hxx>
-
 #include <cstdlib>
-#include <iostream>
-#include <iomanip>
+#include <cstring>
 #include <memory>
-#include <unordered_map>
 
 #ifdef Q_OS_WIN
 #  include <windows.h> // For AttachConsole(), etc.
@@ -50,10 +54,16 @@ class Main { Q_DECLARE_TR_FUNCTIONS(Mayo::Main) };
 
 struct CommandLineArguments {
     QString themeName;
-    FilePath filepathSettings;
-    std::vector<FilePath> listFilepathToExport;
-    std::vector<FilePath> listFilepathToOpen;
-    bool cliProgressReport = true;
+    CliCommandLineArguments cli;
+    FilePath filepathSections;
+    QString sectionAxis;
+    QString sectionCount;
+    QString renderTarget;
+    QString renderSize;
+    QString renderView;
+    FilePath filepathBenchView;
+    QString benchCameraPath;
+    QString benchFrameCount;
 };
 
 static CommandLineArguments processCommandLine()
@@ -73,23 +83,68 @@ static CommandLineArguments processCommandLine()
                 Main::tr("name"));
     cmdParser.addOption(cmdOptionTheme);
 
-    const QCommandLineOption cmdFileSettings(
-                QStringList{ "s", "settings" },
-                Main::tr("Settings file(INI format) to load at startup"),
+    // Options of conversion operations, shared with mayo-conv
+    const CliOptions cliOptions;
+    cliOptions.addTo(&cmdParser);
+
+    const QCommandLineOption cmdSections(
+                QStringList{ "sections" },
+                Main::tr("Export evenly spaced cross-sections of opened files(SVG or DXF), each section "
+                         "is written into \"<base name>_<index>.<suffix>\"(eg. --sections out/cut.svg)"),
                 Main::tr("filepath"));
-    cmdParser.addOption(cmdFileSettings);
+    cmdParser.addOption(cmdSections);
+
+    const QCommandLineOption cmdSectionAxis(
+                QStringList{ "section-axis" },
+                Main::tr("Axis orthogonal to the section planes(x|y|z), default is z(requires --sections)"),
+                Main::tr("axis"));
+    cmdParser.addOption(cmdSectionAxis);
+
+    const QCommandLineOption cmdSectionCount(
+                QStringList{ "section-count" },
+                Main::tr("Count of cross-sections, default is 10(requires --sections)"),
+                Main::tr("count"));
+    cmdParser.addOption(cmdSectionCount);
+
+    const QCommandLineOption cmdRender(
+                QStringList{ "render" },
+                Main::tr("Render opened files into an image file without showing any window(eg. "
+                         "--render out.png). In batch mode, the image suffix of each input file "
+                         "(eg. --batch dir/*.step --render png)"),
+                Main::tr("filepath"));
+    cmdParser.addOption(cmdRender);
+
+    const QCommandLineOption cmdRenderSize(
+                QStringList{ "size" },
+                Main::tr("Size in pixels of the rendered images, default is 800x600(requires --render or --bench-view)"),
+                Main::tr("WxH"));
+    cmdParser.addOption(cmdRenderSize);
+
+    const QCommandLineOption cmdRenderView(
+                QStringList{ "view" },
+                Main::tr("Camera orientation of the rendered images(iso|front|back|left|right|top|bottom), "
+                         "default is iso(requires --render or --bench-view)"),
+                Main::tr("name"));
+    cmdParser.addOption(cmdRenderView);
 
-    const QCommandLineOption cmdFileToExport(
-                QStringList{ "e", "export" },
-                Main::tr("Export opened files into an output file, can be repeated for different "
-                         "formats(eg. -e file.stp -e file.igs...)"),
+    const QCommandLineOption cmdBenchView(
+                QStringList{ "bench-view" },
+                Main::tr("Render a file along a camera path without showing any window, then print "
+                         "frame-time statistics as a JSON object(eg. --bench-view file.step --path orbit --frames 600)"),
                 Main::tr("filepath"));
-    cmdParser.addOption(cmdFileToExport);
+    cmdParser.addOption(cmdBenchView);
 
-    const QCommandLineOption cmdCliNoProgress(
-                QStringList{ "no-progress" },
-                Main::tr("Disable progress reporting in console output(CLI-mode only)"));
-    cmdParser.addOption(cmdCliNoProgress);
+    const QCommandLineOption cmdBenchCameraPath(
+                QStringList{ "path" },
+                Main::tr("Camera path of the benchmark(orbit|zoom), default is orbit(requires --bench-view)"),
+                Main::tr("name"));
+    cmdParser.addOption(cmdBenchCameraPath);
+
+    const QCommandLineOption cmdBenchFrameCount(
+                QStringList{ "frames" },
+                Main::tr("Count of frames rendered by the benchmark, default is 600(requires --bench-view)"),
+                Main::tr("count"));
+    cmdParser.addOption(cmdBenchFrameCount);
 
     cmdParser.addPositionalArgument(
                 Main::tr("files"),
@@ -99,52 +154,27 @@ static CommandLineArguments processCommandLine()
     cmdParser.process(QCoreApplication::arguments());
 
     // Retrieve arguments
+    args.cli = cliOptions.parse(cmdParser);
     args.themeName = "dark";
     if (cmdParser.isSet(cmdOptionTheme))
         args.themeName = cmdParser.value(cmdOptionTheme);
 
-    if (cmdParser.isSet(cmdFileSettings))
-        args.filepathSettings = filepathFrom(cmdParser.value(cmdFileSettings));
+    if (cmdParser.isSet(cmdSections))
+        args.filepathSections = filepathFrom(cmdParser.value(cmdSections));
 
-    if (cmdParser.isSet(cmdFileToExport)) {
-        for (const QString& strFilepath : cmdParser.values(cmdFileToExport))
-            args.listFilepathToExport.push_back(filepathFrom(strFilepath));
-    }
-
-    for (const QString& posArg : cmdParser.positionalArguments())
-        args.listFilepathToOpen.push_back(filepathFrom(posArg));
-
-    args.cliProgressReport = !cmdParser.isSet(cmdCliNoProgress);
+    args.sectionAxis = cmdParser.value(cmdSectionAxis);
+    args.sectionCount = cmdParser.value(cmdSectionCount);
+    args.renderTarget = cmdParser.value(cmdRender);
+    args.renderSize = cmdParser.value(cmdRenderSize);
+    args.renderView = cmdParser.value(cmdRenderView);
+    if (cmdParser.isSet(cmdBenchView))
+        args.filepathBenchView = filepathFrom(cmdParser.value(cmdBenchView));
 
+    args.benchCameraPath = cmdParser.value(cmdBenchCameraPath);
+    args.benchFrameCount = cmdParser.value(cmdBenchFrameCount);
     return args;
 }
 
-static void qtMessageHandler(QtMsgType type, const QMessageLogContext& /*context*/, const QString& msg)
-{
-    const std::string localMsg = consoleToPrintable(msg);
-//    const char* file = context.file ? context.file : "";
-//    const char* function = context.function ? context.function : "";
-    switch (type) {
-    case QtDebugMsg:
-#ifndef NDEBUG
-        std::cout << "DEBUG: " << localMsg << std::endl;
-#endif
-        break;
-    case QtInfoMsg:
-        std::cout << "INFO: " << localMsg << std::endl;
-        break;
-    case QtWarningMsg:
-        std::cerr << "WARNING: " << localMsg << std::endl;
-        break;
-    case QtCriticalMsg:
-        std::cerr << "CRITICAL: " << localMsg << std::endl;
-        break;
-    case QtFatalMsg:
-        std::cerr << "FATAL: " << localMsg << std::endl;
-        break;
-    }
-}
-
 static std::unique_ptr<Theme> globalTheme;
 
 // Declared in theme.h
@@ -170,10 +200,20 @@ static void initBase(QCoreApplication* qtApp)
     }
 
     // Register I/O objects
+    // gmio factories first so they take precedence for STL, see GmioStlReader/GmioStlWriter
+    app->ioSystem()->addFactoryReader(IO::GmioFactoryReader::create());
+    app->ioSystem()->addFactoryWriter(IO::GmioFactoryWriter::create());
     app->ioSystem()->addFactoryReader(std::make_unique<IO::OccFactoryReader>());
     app->ioSystem()->addFactoryWriter(std::make_unique<IO::OccFactoryWriter>());
-    app->ioSystem()->addFactoryWriter(IO::GmioFactoryWriter::create());
+    app->ioSystem()->addFactoryReader(std::make_unique<IO::PlyFactoryReader>());
+    app->ioSystem()->addFactoryWriter(std::make_unique<IO::PlyFactoryWriter>());
+    app->ioSystem()->addFactoryReader(std::make_unique<IO::PointCloudFactoryReader>());
+    app->ioSystem()->addFactoryWriter(IO::ThreeMfFactoryWriter::create());
     IO::addPredefinedFormatProbes(app->ioSystem());
+    IO::addPredefinedMetadataScanners(app->ioSystem());
+    // Initialize OpenCascade translators in background, so the first import/export is faster
+    const IO::Format arrayWarmUpFormat[] = { IO::Format_STEP, IO::Format_IGES };
+    app->ioSystem()->warmUpAsync(arrayWarmUpFormat);
 
     // Register providers to query document tree node properties
     app->documentTreeNodePropertiesProviderTable()->addProvider(
@@ -195,193 +235,7 @@ static void initGui(GuiApplication* guiApp)
     // Register Graphics entity drivers
     guiApp->graphicsObjectDriverTable()->addDriver(std::make_unique<GraphicsShapeObjectDriver>());
     guiApp->graphicsObjectDriverTable()->addDriver(std::make_unique<GraphicsMeshObjectDriver>());
-}
-
-// Asynchronously exports input file(s) listed in 'args'
-// Calls 'fnContinuation' at the end of execution
-static void cli_asyncExportDocuments(
-        Application* app, const CommandLineArguments& args, std::function<void(int)> fnContinuation)
-{
-    struct TaskStatus {
-        std::atomic<bool> finished = {};
-        std::atomic<bool> success = {};
-    };
-
-    struct Helper : public QObject {
-        // Task manager object dedicated to the scope of current function
-        TaskManager taskMgr;
-        // Counter decremented for each export task finished, when 0 is reached then quit
-        std::atomic<int> exportTaskCount = {};
-        // Mapping between a task id and the task status
-        std::unordered_map<TaskId, std::unique_ptr<TaskStatus>> mapTaskStatus;
-        // Mapping between a task id and corresponding width of the progress line in console
-        std::unordered_map<TaskId, int> mapTaskLineWidth;
-        // Count of progress lines in console after last call to fnPrintProgress()
-        int lastPrintProgressLineCount = 0;
-    };
-
-    // Collects emitted error messages into a single string object
-    struct ErrorMessageCollect : public Messenger {
-        QString message;
-        void emitMessage(MessageType msgType, const QString& text) override {
-            if (msgType == MessageType::Error)
-                message += text + " ";
-        }
-    };
-
-    auto helper = new Helper; // Allocated on heap because current function is asynchronous
-    auto taskMgr = &helper->taskMgr;
-    auto appModule = AppModule::get(app);
-
-    // Helper function to exit current function
-    auto fnExit = [=](int retCode) {
-        helper->deleteLater();
-        fnContinuation(retCode);
-    };
-    // Helper function to print in console the progress info of current function
-    auto fnPrintProgress = [=]{
-        consoleCursorMoveUp(helper->lastPrintProgressLineCount);
-        helper->lastPrintProgressLineCount = 0;
-        std::cout << "\r";
-        taskMgr->foreachTask([=](TaskId taskId) {
-            const std::string strMessage = consoleToPrintable(taskMgr->title(taskId).replace('\n', ' '));
-            int lineWidth = strMessage.size();
-            const bool taskFinished = helper->mapTaskStatus.at(taskId)->finished;
-            const bool taskSuccess = helper->mapTaskStatus.at(taskId)->success;
-            if (taskFinished && !taskSuccess) {
-                consoleSetTextColor(ConsoleColor::Red);
-                std::cout << strMessage;
-                consoleSetTextColor(ConsoleColor::Default);
-            }
-            else {
-                const int progress = taskMgr->progress(taskId);
-                if (progress >= 100)
-                    consoleSetTextColor(ConsoleColor::Green);
-
-                std::cout << std::setfill(' ') << std::right << std::setw(3) << progress << "% ";
-                std::cout << strMessage;
-                lineWidth += 5;
-                if (progress >= 100)
-                    consoleSetTextColor(ConsoleColor::Default);
-            }
-
-            const int printWidth = consoleWidth();
-            auto itLineFound = helper->mapTaskLineWidth.find(taskId);
-            const int lineWidthOld = itLineFound != helper->mapTaskLineWidth.cend() ? itLineFound->second : printWidth - 1;
-            for (int i = 0; i < (lineWidthOld - lineWidth); ++i)
-                std::cout << ' ';
-
-            helper->mapTaskLineWidth.insert_or_assign(taskId, lineWidth);
-            helper->lastPrintProgressLineCount += printWidth > 0 ? (lineWidth / printWidth) + 1 : 1;
-            std::cout << "\n";
-        });
-        std::cout.flush();
-    };
-
-    // Show progress/traces corresponding to task events
-    QObject::connect(taskMgr, &TaskManager::started, app, [=](TaskId taskId) {
-        if (args.cliProgressReport)
-            fnPrintProgress();
-        else
-            qInfo() << taskMgr->title(taskId);
-    });
-    QObject::connect(taskMgr, &TaskManager::ended, app, [=](TaskId taskId) {
-        if (args.cliProgressReport) {
-            fnPrintProgress();
-        }
-        else {
-            if (helper->mapTaskStatus.at(taskId)->success)
-                qInfo() << taskMgr->title(taskId);
-            else
-                qCritical() << taskMgr->title(taskId);
-        }
-    });
-    QObject::connect(taskMgr, &TaskManager::progressChanged, app, [=]{
-        if (args.cliProgressReport)
-            fnPrintProgress();
-    });
-
-    helper->exportTaskCount = int(args.listFilepathToExport.size());
-    QObject::connect(taskMgr, &TaskManager::ended, app, [=]{
-        if (helper->exportTaskCount == 0) {
-            bool okExport = true;
-            for (const auto& mapPair : helper->mapTaskStatus) {
-                const TaskStatus* status = mapPair.second.get();
-                okExport = okExport && status->success;
-            }
-
-            fnExit(okExport ? EXIT_SUCCESS : EXIT_FAILURE);
-        }
-    });
-
-    // If export operation targets some mesh format then force meshing of imported BRep shapes
-    bool brepMeshRequired = false;
-    for (const FilePath& filepath : args.listFilepathToExport) {
-        const IO::Format format = app->ioSystem()->probeFormat(filepath);
-        brepMeshRequired = IO::formatProvidesMesh(format);
-        if (brepMeshRequired)
-            break; // Interrupt
-    }
-
-    // Suppress output from OpenCascade
-    Message::DefaultMessenger()->RemovePrinters(Message_Printer::get_type_descriptor());
-
-    // Execute import operation(synchronous)
-    DocumentPtr doc = app->newDocument();
-    bool okImport = true;
-    const TaskId importTaskId = taskMgr->newTask([&](TaskProgress* progress) {
-            ErrorMessageCollect errorCollect;
-            okImport = app->ioSystem()->importInDocument()
-                .targetDocument(doc)
-                .withFilepaths(args.listFilepathToOpen)
-                .withParametersProvider(appModule)
-                .withEntityPostProcess([=](TDF_Label labelEntity, TaskProgress* progress) {
-                    appModule->computeBRepMesh(labelEntity, progress);
-                })
-                .withEntityPostProcessRequiredIf([=](const IO::Format&){ return brepMeshRequired; })
-                .withEntityPostProcessInfoProgress(20, Main::tr("Mesh BRep shapes"))
-                .withMessenger(&errorCollect)
-                .withTaskProgress(progress)
-                .execute();
-            taskMgr->setTitle(progress->taskId(), okImport ? Main::tr("Imported") : errorCollect.message);
-            helper->mapTaskStatus.at(progress->taskId())->success = okImport;
-            helper->mapTaskStatus.at(progress->taskId())->finished = true;
-    });
-    helper->mapTaskStatus.insert({ importTaskId, std::make_unique<TaskStatus>() });
-    taskMgr->setTitle(importTaskId, Main::tr("Importing..."));
-    taskMgr->exec(importTaskId, TaskAutoDestroy::Off);
-    if (!okImport)
-        return fnExit(EXIT_FAILURE); // Error
-
-    // Run export operations(asynchronous)
-    for (const FilePath& filepath : args.listFilepathToExport) {
-        const QString strFilename = filepathTo<QString>(filepath.filename());
-        const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
-                ErrorMessageCollect errorCollect;
-                const IO::Format format = app->ioSystem()->probeFormat(filepath);
-                const ApplicationItem appItems[] = { doc };
-                const bool okExport = app->ioSystem()->exportApplicationItems()
-                            .targetFile(filepath)
-                            .targetFormat(format)
-                            .withItems(appItems)
-                            .withParameters(appModule->findWriterParameters(format))
-                            .withMessenger(&errorCollect)
-                            .withTaskProgress(progress)
-                            .execute();
-                const QString msg = okExport ? Main::tr("Exported %1").arg(strFilename) : errorCollect.message;
-                taskMgr->setTitle(progress->taskId(), msg);
-                helper->mapTaskStatus.at(progress->taskId())->success = okExport;
-                helper->mapTaskStatus.at(progress->taskId())->finished = true;
-                --(helper->exportTaskCount);
-        });
-        helper->mapTaskStatus.insert({ taskId, std::make_unique<TaskStatus>() });
-        taskMgr->setTitle(taskId, Main::tr("Exporting %1...").arg(strFilename));
-    }
-
-    taskMgr->foreachTask([=](TaskId taskId) {
-        if (taskId != importTaskId)
-            taskMgr->run(taskId, TaskAutoDestroy::Off);
-    });
+    guiApp->graphicsObjectDriverTable()->addDriver(std::make_unique<GraphicsPointCloudObjectDriver>());
 }
 
 // Initializes and runs Mayo application
@@ -389,22 +243,16 @@ static int runApp(QCoreApplication* qtApp)
 {
     const CommandLineArguments args = processCommandLine();
 
-    // Helper function: print critical message and exit application with code failure
-    auto fnCriticalExit = [](const QString& msg) {
-        qCritical().noquote() << msg;
-        std::exit(EXIT_FAILURE);
-    };
-
     // Helper function: load application settings from INI file(if provided) otherwise use the
     // application regular storage(eg registry on Windows)
     auto fnLoadAppSettings = [&](Settings* appSettings) {
-        if (args.filepathSettings.empty()) {
+        if (args.cli.filepathSettings.empty()) {
             appSettings->load();
         }
         else {
-            const QString strFilepathSettings = filepathTo<QString>(args.filepathSettings);
-            if (!filepathIsRegularFile(args.filepathSettings))
-                fnCriticalExit(Main::tr("Failed to load settings file '%1'").arg(strFilepathSettings));
+            const QString strFilepathSettings = filepathTo<QString>(args.cli.filepathSettings);
+            if (!filepathIsRegularFile(args.cli.filepathSettings))
+                cli_criticalExit(Main::tr("Failed to load settings file '%1'").arg(strFilepathSettings));
 
             QSettings fileSettings(strFilepathSettings, QSettings::IniFormat);
             appSettings->loadFrom(fileSettings, &AppModule::excludeSettingPredicate);
@@ -419,25 +267,182 @@ static int runApp(QCoreApplication* qtApp)
     auto appModule = new AppModule(app);
     app->settings()->setPropertyValueConversion(*appModule);
 
+    // Settings are loaded once for all modes, values of import/export parameters are kept pending
+    // until their format is used(see AppModule::findReaderParameters())
+    app->settings()->resetAll();
+    fnLoadAppSettings(app->settings());
+
+    // Overrides are applied after loading, they aren't applied in GUI mode because settings are
+    // saved on exit
+    const bool isCliMode =
+            args.cli.serveMode || args.cli.batchMode || !args.cli.convert.listFilepathToExport.empty()
+            || !args.filepathSections.empty() || !args.renderTarget.isEmpty() || !args.filepathBenchView.empty();
+    if (isCliMode)
+        cli_applySettingOverrides(app->settings(), args.cli.listSettingOverride);
+
+    const CliInstrumentationScope instrumentationScope(args.cli);
+
     // Process CLI
-    if (!args.listFilepathToExport.empty()) {
-        if (args.listFilepathToOpen.empty())
-            fnCriticalExit(Main::tr("No input files -> nothing to export"));
+    CliConvertArguments cliArgs = args.cli.convert;
+    cliArgs.filepathSections = args.filepathSections;
+    if (!args.filepathSections.empty()
+            && CrossSection::fileFormat(args.filepathSections) == CrossSection::FileFormat::Unknown)
+    {
+        const QString strFilepathSections = filepathTo<QString>(args.filepathSections);
+        cli_criticalExit(Main::tr("Invalid section file '%1', expected .svg or .dxf suffix").arg(strFilepathSections));
+    }
+
+    if (!args.sectionAxis.isEmpty()) {
+        cliArgs.sectionAxis = QStringList({ "x", "y", "z" }).indexOf(args.sectionAxis.toLower());
+        if (cliArgs.sectionAxis < 0)
+            cli_criticalExit(Main::tr("Invalid section axis '%1', expected x|y|z").arg(args.sectionAxis));
+    }
+
+    if (!args.sectionCount.isEmpty()) {
+        bool ok = false;
+        cliArgs.sectionCount = args.sectionCount.toInt(&ok);
+        if (!ok || cliArgs.sectionCount <= 0)
+            cli_criticalExit(Main::tr("Invalid count of sections '%1'").arg(args.sectionCount));
+    }
+
+    if (args.filepathSections.empty() && (!args.sectionAxis.isEmpty() || !args.sectionCount.isEmpty()))
+        cli_criticalExit(Main::tr("Options --section-axis and --section-count require --sections"));
+
+    CliConvertServices cliServices;
+    cliServices.parametersProvider = appModule;
+    cliServices.fnComputeBRepMesh = [=](auto spanFileEntities, TaskProgress* progress) {
+        appModule->computeBRepMesh(spanFileEntities, progress);
+    };
+    cliServices.taskPoolSize = appModule->taskPoolSize;
+    cliServices.taskTimeLimit = args.cli.taskTimeLimit;
+    cliServices.taskMemoryLimit = args.cli.taskMemoryLimit;
+    const CliProcessPoolOptions& poolOptions = args.cli.processPool;
+
+    // Offscreen rendering, done after conversions(if any)
+    CliRenderArguments renderArgs;
+    renderArgs.listFilepathToOpen = args.cli.convert.listFilepathToOpen;
+    renderArgs.batchMode = args.cli.batchMode;
+    renderArgs.batchOutputDir = args.cli.convert.batchOutputDir;
+    if (args.cli.batchMode)
+        renderArgs.batchImageSuffix = args.renderTarget;
+    else
+        renderArgs.filepathImage = filepathFrom(args.renderTarget);
+
+    if (!args.renderSize.isEmpty()) {
+        const QStringList listSizeItem = args.renderSize.toLower().split('x');
+        bool okWidth = false;
+        bool okHeight = false;
+        if (listSizeItem.size() == 2) {
+            renderArgs.renderOptions.size.setWidth(listSizeItem.at(0).toInt(&okWidth));
+            renderArgs.renderOptions.size.setHeight(listSizeItem.at(1).toInt(&okHeight));
+        }
+
+        if (!okWidth || !okHeight || renderArgs.renderOptions.size.isEmpty())
+            cli_criticalExit(Main::tr("Invalid image size '%1', expected WxH(eg. 800x600)").arg(args.renderSize));
+    }
+
+    renderArgs.renderOptions.viewOrientation = V3d_XposYnegZpos;
+    if (!args.renderView.isEmpty()) {
+        renderArgs.renderOptions.viewOrientation =
+                GuiOffscreenRenderer::viewOrientationFromName(args.renderView.toStdString());
+        if (!renderArgs.renderOptions.viewOrientation)
+            cli_criticalExit(Main::tr("Invalid view '%1', expected iso|front|back|left|right|top|bottom").arg(args.renderView));
+    }
+
+    const bool hasRenderOptions = !args.renderSize.isEmpty() || !args.renderView.isEmpty();
+    if (args.renderTarget.isEmpty() && args.filepathBenchView.empty() && hasRenderOptions)
+        cli_criticalExit(Main::tr("Options --size and --view require --render or --bench-view"));
+
+    if (!args.renderTarget.isEmpty() && args.cli.serveMode)
+        cli_criticalExit(Main::tr("Option --render can't be used with --serve"));
+
+    auto fnRenderThenExit = [=](int retcode) {
+        if (retcode != EXIT_SUCCESS || args.renderTarget.isEmpty())
+            return qtApp->exit(retcode);
+
+        // All renderings share the graphic driver of GuiApplication
+        auto guiApp = new GuiApplication(app);
+        initGui(guiApp);
+        cli_asyncRenderDocuments(guiApp, renderArgs, [=](int retcode) { qtApp->exit(retcode); });
+    };
+
+    // View benchmark, exclusive of other CLI modes
+    if (!args.filepathBenchView.empty()) {
+        CliBenchViewArguments benchArgs;
+        benchArgs.listFilepathToOpen = args.cli.convert.listFilepathToOpen;
+        benchArgs.listFilepathToOpen.insert(benchArgs.listFilepathToOpen.begin(), args.filepathBenchView);
+        benchArgs.renderOptions = renderArgs.renderOptions;
+        if (!args.benchCameraPath.isEmpty())
+            benchArgs.cameraPath = args.benchCameraPath;
+
+        if (!args.benchFrameCount.isEmpty()) {
+            bool ok = false;
+            benchArgs.frameCount = args.benchFrameCount.toInt(&ok);
+            if (!ok || benchArgs.frameCount <= 0)
+                cli_criticalExit(Main::tr("Invalid count of frames '%1'").arg(args.benchFrameCount));
+        }
+
+        QTimer::singleShot(0, qtApp, [=]{
+            auto guiApp = new GuiApplication(app);
+            initGui(guiApp);
+            cli_asyncBenchmarkView(guiApp, benchArgs, [=](int retcode) { qtApp->exit(retcode); });
+        });
+        return qtApp->exec();
+    }
 
-        app->settings()->resetAll();
-        fnLoadAppSettings(app->settings());
+    if (args.filepathBenchView.empty() && (!args.benchCameraPath.isEmpty() || !args.benchFrameCount.isEmpty()))
+        cli_criticalExit(Main::tr("Options --path and --frames require --bench-view"));
+
+    if (args.cli.serveMode) {
         QTimer::singleShot(0, qtApp, [=]{
-            cli_asyncExportDocuments(app, args, [=](int retcode) { qtApp->exit(retcode); });
+            auto fnContinuation = [=](int retcode) { qtApp->exit(retcode); };
+            if (poolOptions.workerCount > 0)
+                cli_asyncServeConversionJobsInProcessPool(poolOptions, fnContinuation);
+            else
+                cli_asyncServeConversionJobs(app, cliServices, fnContinuation);
         });
         return qtApp->exec();
     }
 
+    if (args.cli.batchMode) {
+        if (args.cli.convert.listFilepathToOpen.empty())
+            cli_criticalExit(Main::tr("No input files -> nothing to convert"));
+
+        if (args.cli.convert.listBatchTargetSuffix.empty() && args.renderTarget.isEmpty())
+            cli_criticalExit(Main::tr("No output formats specified with --to"));
+
+        QTimer::singleShot(0, qtApp, [=]{
+            if (args.cli.convert.listBatchTargetSuffix.empty())
+                fnRenderThenExit(EXIT_SUCCESS);
+            else if (poolOptions.workerCount > 0)
+                cli_asyncBatchConvertDocumentsInProcessPool(app, cliArgs, poolOptions, fnRenderThenExit);
+            else
+                cli_asyncBatchConvertDocuments(app, cliArgs, cliServices, fnRenderThenExit);
+        });
+        return qtApp->exec();
+    }
+
+    if (!args.cli.convert.listFilepathToExport.empty() || !args.filepathSections.empty()) {
+        if (args.cli.convert.listFilepathToOpen.empty())
+            cli_criticalExit(Main::tr("No input files -> nothing to export"));
+
+        QTimer::singleShot(0, qtApp, [=]{
+            cli_asyncExportDocuments(app, cliArgs, cliServices, fnRenderThenExit);
+        });
+        return qtApp->exec();
+    }
+
+    if (!args.renderTarget.isEmpty()) {
+        if (args.cli.convert.listFilepathToOpen.empty())
+            cli_criticalExit(Main::tr("No input files -> nothing to render"));
+
+        QTimer::singleShot(0, qtApp, [=]{ fnRenderThenExit(EXIT_SUCCESS); });
+        return qtApp->exec();
+    }
+
     // Initialize Gui application
     auto guiApp = new GuiApplication(app);
     initGui(guiApp);
-    QObject::connect(
-                guiApp, &GuiApplication::guiDocumentErased,
-                appModule, &AppModule::recordRecentFileThumbnail);
 
     // Register WidgetModelTreeBuilter prototypes
     WidgetModelTree::addPrototypeBuilder(std::make_unique<WidgetModelTreeBuilder_Mesh>());
@@ -446,23 +451,26 @@ static int runApp(QCoreApplication* qtApp)
     // Create theme
     globalTheme.reset(createTheme(args.themeName));
     if (!globalTheme)
-        fnCriticalExit(Main::tr("Failed to load theme '%1'").arg(args.themeName));
+        cli_criticalExit(Main::tr("Failed to load theme '%1'").arg(args.themeName));
 
     mayoTheme()->setup();
 
+    // Changed settings are persisted shortly, not only on exit
+    app->settings()->setAutoSaveDelay(1000);
+
     // Create MainWindow
-    app->settings()->loadProperty(app->settings()->findProperty(&appModule->recentFiles));
     MainWindow mainWindow(guiApp);
     mainWindow.setWindowTitle(QCoreApplication::applicationName());
     mainWindow.show();
-    if (!args.listFilepathToOpen.empty()) {
-        QTimer::singleShot(0, [&]{ mainWindow.openDocumentsFromList(args.listFilepathToOpen); });
+    if (!args.cli.convert.listFilepathToOpen.empty()) {
+        QTimer::singleShot(0, [&]{ mainWindow.openDocumentsFromList(args.cli.convert.listFilepathToOpen); });
+    }
+    else {
+        QTimer::singleShot(0, [&]{ mainWindow.restoreSession(); });
     }
 
-    app->settings()->resetAll();
-    fnLoadAppSettings(app->settings());
     const int code = qtApp->exec();
-    appModule->recordRecentFileThumbnails(guiApp);
+    mainWindow.saveSession();
     app->settings()->save();
     return code;
 }
@@ -480,23 +488,34 @@ static void onQtAppExit()
 
 int main(int argc, char* argv[])
 {
-    qInstallMessageHandler(&Mayo::qtMessageHandler);
+    qInstallMessageHandler(&Mayo::cli_qtMessageHandler);
     qAddPostRoutine(&Mayo::onQtAppExit);
 
     auto fnArgEqual = [](const char* arg, const char* option) { return std::strcmp(arg, option) == 0; };
+    bool isAppRenderMode = false;
     for (int i = 1; i < argc; ++i) {
         const char* arg = argv[i];
-        if (fnArgEqual(arg, "-e") || fnArgEqual(arg, "--export")
+        if (fnArgEqual(arg, "-e") || fnArgEqual(arg, "--export") || fnArgEqual(arg, "--batch")
+                || fnArgEqual(arg, "--serve")
                 || fnArgEqual(arg, "-h") || fnArgEqual(arg, "--help")
                 || fnArgEqual(arg, "-v") || fnArgEqual(arg, "--version"))
         {
             Mayo::isAppCliMode = true;
-            break;
         }
+
+        // Offscreen rendering requires a GL context, hence QGuiApplication
+        if (fnArgEqual(arg, "--render") || fnArgEqual(arg, "--bench-view"))
+            isAppRenderMode = true;
     }
 
-    std::unique_ptr<QCoreApplication> ptrApp(
-            Mayo::isAppCliMode ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
+    Mayo::isAppCliMode = Mayo::isAppCliMode || isAppRenderMode;
+    std::unique_ptr<QCoreApplication> ptrApp;
+    if (isAppRenderMode)
+        ptrApp.reset(new QGuiApplication(argc, argv));
+    else if (Mayo::isAppCliMode)
+        ptrApp.reset(new QCoreApplication(argc, argv));
+    else
+        ptrApp.reset(new QApplication(argc, argv));
 
 #if defined(Q_OS_WIN) && defined(NDEBUG)
     if (Mayo::isAppCliMode) {
@@ -9,25 +9,42 @@
 
 #include "../base/application.h"
 #include "../base/application_item_selection_model.h"
+#include "../base/caf_utils.h"
+#include "../base/clash_detection.h"
 #include "../base/cpp_utils.h"
 #include "../base/document.h"
+#include "../base/document_tree_node.h"
 #include "../base/global.h"
+#include "../base/io_export_split.h"
 #include "../base/io_format.h"
 #include "../base/io_system.h"
+#include "../base/memory_stats.h"
 #include "../base/messenger.h"
+#include "../base/part_bvh.h"
+#include "../base/perf_stats.h"
+#include "../base/property_builtins.h"
 #include "../base/settings.h"
+#include "../base/shape_distance.h"
+#include "../base/string_utils.h"
 #include "../base/task_manager.h"
+#include "../graphics/graphics_batched_object.h"
 #include "../graphics/graphics_object_driver.h"
 #include "../graphics/graphics_utils.h"
+#include "../graphics/v3d_view_camera_animation.h"
+#include "../gui/document_file_watcher.h"
 #include "../gui/gui_application.h"
 #include "../gui/gui_document.h"
 #include "../gui/gui_document_list_model.h"
 #include "app_module.h"
+#include "deferred_shapes_load_queue.h"
 #include "dialog_about.h"
+#include "dialog_clashes.h"
 #include "dialog_inspect_xde.h"
+#include "dialog_message_log.h"
 #include "dialog_options.h"
 #include "dialog_save_image_view.h"
 #include "dialog_task_manager.h"
+#include "session.h"
 #include "document_tree_node_properties_providers.h"
 #include "item_view_buttons.h"
 #include "theme.h"
@@ -53,8 +70,14 @@
 #include <QtWidgets/QActionGroup>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QFileDialog>
+#include <QtWidgets/QInputDialog>
 #include <QtDebug>
+#include <TDataXtd_Triangulation.hxx>
 
+#include <gsl/util>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
 #include <unordered_set>
 
 namespace Mayo {
@@ -76,6 +99,18 @@ static IO::Format formatFromFilter(const QString& filter)
     return IO::Format_Unknown;
 }
 
+// Native Mayo documents are opened directly, other files are imported in a new document
+static bool isMayoDocumentFile(const FilePath& fp)
+{
+    const FilePath ext = fp.extension();
+    return ext == ".myb" || ext == ".myx";
+}
+
+static QString mayoDocumentFileFilter()
+{
+    return MainWindow::tr("Mayo Document(*.myb *.myx)");
+}
+
 // TODO: move in Options
 struct ImportExportSettings {
     FilePath openDir;
@@ -118,6 +153,9 @@ struct OpenFileNames {
             listFormatFilter += IO::System::fileFilter(format);
 
         const QString allFilesFilter = MainWindow::tr("All files(*.*)");
+        if (option == OpenFileNames::GetMany)
+            listFormatFilter.append(mayoDocumentFileFilter());
+
         listFormatFilter.append(allFilesFilter);
         const QString dlgTitle = MainWindow::tr("Select Part File");
         const QString dlgOpenDir = filepathTo<QString>(result.lastIoSettings.openDir);
@@ -158,23 +196,132 @@ static void prependRecentFile(const FilePath& fp)
     appModule->prependRecentFile(fp);
 }
 
-static void handleMessage(Messenger::MessageType msgType, const QString& text, QWidget* mainWnd)
-{
-    switch (msgType) {
-    case Messenger::MessageType::Trace:
-        break;
-    case Messenger::MessageType::Info:
-        WidgetMessageIndicator::showMessage(text, mainWnd);
-        break;
-    case Messenger::MessageType::Warning:
-        WidgetsUtils::asyncMsgBoxWarning(mainWnd, MainWindow::tr("Warning"), text);
-        break;
-    case Messenger::MessageType::Error:
-        WidgetsUtils::asyncMsgBoxCritical(mainWnd, MainWindow::tr("Error"), text);
-        break;
+// Reports a batch of messages, see MessengerQtSignal::messagesBatched()
+// Only the last info message is shown by the indicator. A single warning/error is shown in a
+// message box, many of them are listed in the message log instead(so popups don't pile up)
+static void handleMessages(
+        const std::vector<MessengerQtSignal::Message>& vecMessage,
+        QWidget* mainWnd,
+        DialogMessageLog* dlgMessageLog)
+{
+    const MessengerQtSignal::Message* lastInfo = nullptr;
+    const MessengerQtSignal::Message* lastIssue = nullptr;
+    int issueCount = 0;
+    for (const MessengerQtSignal::Message& msg : vecMessage) {
+        if (msg.type == Messenger::MessageType::Info) {
+            lastInfo = &msg;
+        }
+        else if (msg.type == Messenger::MessageType::Warning || msg.type == Messenger::MessageType::Error) {
+            lastIssue = &msg;
+            issueCount += msg.count;
+        }
+    }
+
+    if (lastInfo)
+        WidgetMessageIndicator::showMessage(lastInfo->text, mainWnd);
+
+    if (issueCount == 0 || dlgMessageLog->isVisible())
+        return;
+
+    if (issueCount == 1) {
+        if (lastIssue->type == Messenger::MessageType::Warning)
+            WidgetsUtils::asyncMsgBoxWarning(mainWnd, MainWindow::tr("Warning"), lastIssue->text);
+        else
+            WidgetsUtils::asyncMsgBoxCritical(mainWnd, MainWindow::tr("Error"), lastIssue->text);
+    }
+    else {
+        dlgMessageLog->show();
+    }
+}
+
+// Prints in console the timings collected by the task owning 'progress', as a JSON object
+// Does nothing if instrumentation is disabled(see command-line option --perf-stats)
+static void printTaskPerfStats(const TaskProgress* progress)
+{
+    const PerfStats* stats = PerfStats::of(progress);
+    if (stats && !stats->isEmpty()) {
+        const QString taskTitle = progress->taskManager()->title(progress->taskId());
+        qInfo().noquote() << QString::fromStdString(stats->toJson(taskTitle.toStdString()));
     }
 }
 
+// Read-only view of the memory estimated for a document tree node, see MemoryAccounting
+class MemoryStatsProperties : public PropertyGroupSignals {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::MemoryStatsProperties)
+public:
+    MemoryStatsProperties(const MemoryStats& stats, const QLocale& locale)
+    {
+        m_propertyBRepGeometry.setValue(StringUtils::bytesText(stats.brepGeometry, locale));
+        m_propertyTriangulation.setValue(StringUtils::bytesText(stats.triangulation, locale));
+        m_propertyOcafData.setValue(StringUtils::bytesText(stats.ocafData, locale));
+        m_propertyPresentation.setValue(StringUtils::bytesText(stats.presentation, locale));
+        m_propertySelection.setValue(StringUtils::bytesText(stats.selection, locale));
+        m_propertyTotal.setValue(StringUtils::bytesText(stats.total(), locale));
+        for (Property* prop : this->properties())
+            prop->setUserReadOnly(true);
+    }
+
+    PropertyQString m_propertyBRepGeometry{ this, textId("BRepGeometry") };
+    PropertyQString m_propertyTriangulation{ this, textId("Triangulation") };
+    PropertyQString m_propertyOcafData{ this, textId("OcafData") };
+    PropertyQString m_propertyPresentation{ this, textId("Presentation") };
+    PropertyQString m_propertySelection{ this, textId("Selection") };
+    PropertyQString m_propertyTotal{ this, textId("Total") };
+};
+
+// Read-only view of the mass properties computed for a shape tree node, see MassProperties
+class MassPropertiesProperties : public PropertyGroupSignals {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::MassPropertiesProperties)
+public:
+    MassPropertiesProperties(const MassProperties& massProps, const StringUtils::TextOptions& textOptions)
+    {
+        m_propertyVolume.setQuantity(massProps.volume * Quantity_CubicMillimeter);
+        m_propertyArea.setQuantity(massProps.area * Quantity_SquaredMillimeter);
+        m_propertyCentroid.setValue(massProps.centroid);
+        m_propertyPrincipalMoments.setValue(
+                    QString("%1  %2  %3").arg(
+                        StringUtils::text(massProps.principalMoments[0], textOptions),
+                        StringUtils::text(massProps.principalMoments[1], textOptions),
+                        StringUtils::text(massProps.principalMoments[2], textOptions)));
+        for (Property* prop : this->properties())
+            prop->setUserReadOnly(true);
+    }
+
+    PropertyVolume m_propertyVolume{ this, textId("Volume") };
+    PropertyArea m_propertyArea{ this, textId("Area") };
+    PropertyOccPnt m_propertyCentroid{ this, textId("Centroid") };
+    PropertyQString m_propertyPrincipalMoments{ this, textId("PrincipalMomentsOfInertia") };
+};
+
+// Read-only view of the minimum distance computed between two shape tree nodes, see ShapeDistance
+class ShapeDistanceProperties : public PropertyGroupSignals {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::ShapeDistanceProperties)
+public:
+    ShapeDistanceProperties(const ShapeDistance& distance)
+    {
+        m_propertyDistance.setQuantity(distance.value * Quantity_Millimeter);
+        m_propertyPoint1.setValue(distance.pnt1);
+        m_propertyPoint2.setValue(distance.pnt2);
+        m_propertyExact.setValue(distance.isExact);
+        for (Property* prop : this->properties())
+            prop->setUserReadOnly(true);
+    }
+
+    PropertyLength m_propertyDistance{ this, textId("Distance") };
+    PropertyOccPnt m_propertyPoint1{ this, textId("Point1") };
+    PropertyOccPnt m_propertyPoint2{ this, textId("Point2") };
+    PropertyBool m_propertyExact{ this, textId("Exact") };
+};
+
+// Shape of 'node' in world space, ie moved by the absolute location of the parent node
+TopoDS_Shape worldShape(const DocumentTreeNode& node)
+{
+    const DocumentPtr& doc = node.document();
+    const TreeNodeId parentId = doc->modelTree().nodeParent(node.id());
+    const TopoDS_Shape shape = XCaf::shape(node.label());
+    return parentId != 0 ? shape.Moved(doc->xcaf().shapeAbsoluteLocation(parentId)) : shape;
+}
+
 } // namespace Internal
 
 MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
@@ -217,6 +364,8 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
     m_ui->actionToggleFullscreen->setChecked(this->isFullScreen());
     m_ui->actionToggleOriginTrihedron->setChecked(false);
     m_ui->actionTogglePerformanceStats->setChecked(false);
+    m_ui->actionGhostNonSelected->setChecked(false);
+    m_ui->actionHighlightMeshProblems->setChecked(false);
 
     mayoTheme()->setupHeaderComboBox(m_ui->combo_LeftContents);
     mayoTheme()->setupHeaderComboBox(m_ui->combo_GuiDocuments);
@@ -245,6 +394,12 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
     QObject::connect(
                 m_ui->actionExportSelectedItems, &QAction::triggered,
                 this, &MainWindow::exportSelectedItems);
+    QObject::connect(
+                m_ui->actionExportSelectedItemsSeparately, &QAction::triggered,
+                this, &MainWindow::exportSelectedItemsSeparately);
+    QObject::connect(
+                m_ui->actionSaveDocumentAs, &QAction::triggered,
+                this, &MainWindow::saveCurrentDocumentAs);
     QObject::connect(
                 m_ui->actionCloseDoc, &QAction::triggered,
                 this, &MainWindow::closeCurrentDocument);
@@ -286,6 +441,12 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
     QObject::connect(
                 m_ui->actionTogglePerformanceStats, &QAction::toggled,
                 this, &MainWindow::toggleCurrentDocPerformanceStats);
+    QObject::connect(
+                m_ui->actionGhostNonSelected, &QAction::toggled,
+                this, &MainWindow::toggleCurrentDocGhostNonSelected);
+    QObject::connect(
+                m_ui->actionHighlightMeshProblems, &QAction::toggled,
+                this, &MainWindow::toggleCurrentDocMeshProblemsHighlight);
     QObject::connect(
                 m_ui->actionZoomIn, &QAction::triggered,
                 this, &MainWindow::zoomInCurrentDoc);
@@ -299,6 +460,15 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
     QObject::connect(
                 m_ui->actionInspectXDE, &QAction::triggered,
                 this, &MainWindow::inspectXde);
+    QObject::connect(
+                m_ui->actionDecimateMeshes, &QAction::triggered,
+                this, &MainWindow::decimateCurrentDocMeshes);
+    QObject::connect(
+                m_ui->actionDetectClashes, &QAction::triggered,
+                this, &MainWindow::detectCurrentDocClashes);
+    QObject::connect(
+                m_ui->actionAnalyzeMeshQuality, &QAction::triggered,
+                this, &MainWindow::analyzeCurrentDocMeshQuality);
     QObject::connect(
                 m_ui->actionOptions, &QAction::triggered,
                 this, &MainWindow::editOptions);
@@ -316,6 +486,9 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
     QObject::connect(
                 m_ui->actionToggleLeftSidebar, &QAction::toggled,
                 this, &MainWindow::toggleLeftSidebar);
+    QObject::connect(
+                m_ui->actionShowMessageLog, &QAction::triggered,
+                this, &MainWindow::showMessageLog);
     QObject::connect(m_ui->actionPreviousDoc, &QAction::triggered, [=]{
         this->setCurrentDocumentIndex(this->currentDocumentIndex() - 1);
     });
@@ -328,6 +501,7 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
     QObject::connect(
                 this, &MainWindow::currentDocumentIndexChanged,
                 this, &MainWindow::onCurrentDocumentIndexChanged);
+    m_ui->widget_FileSystem->setIoSystem(guiApp->application()->ioSystem());
     QObject::connect(
                 m_ui->widget_FileSystem, &WidgetFileSystem::locationActivated,
                 this, &MainWindow::onWidgetFileSystemLocationActivated);
@@ -342,20 +516,64 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
     QObject::connect(
                 guiApp, &GuiApplication::guiDocumentAdded,
                 this, &MainWindow::onGuiDocumentAdded);
-    QObject::connect(
-                guiApp, &GuiApplication::guiDocumentErased,
-                this, &MainWindow::onGuiDocumentErased);
     QObject::connect(
                 guiApp->selectionModel(), &ApplicationItemSelectionModel::changed,
                 this, &MainWindow::onApplicationItemSelectionChanged);
     QObject::connect(
                 m_ui->listView_OpenedDocuments, &QListView::clicked,
                 [=](const QModelIndex& index) { this->setCurrentDocumentIndex(index.row()); });
+    // Messages are drained in batch at fixed interval, so a storm of messages emitted by tasks
+    // (eg errors of many imported files) doesn't flood the event queue
+    m_dlgMessageLog = new DialogMessageLog(this);
+    auto messenger = MessengerQtSignal::defaultInstance();
+    messenger->setBatchInterval(100);
     QObject::connect(
-                MessengerQtSignal::defaultInstance(), &MessengerQtSignal::message,
-                this, [=](Messenger::MessageType msgType, const QString& text) {
-        Internal::handleMessage(msgType, text, this);
+                messenger, &MessengerQtSignal::messagesBatched,
+                this, [=](const std::vector<MessengerQtSignal::Message>& vecMessage) {
+        m_dlgMessageLog->appendMessages(vecMessage);
+        Internal::handleMessages(vecMessage, this, m_dlgMessageLog);
     });
+    // Settings changed together(eg reset of a group) are handled at once, so documents are
+    // meshed again only once even if several meshing settings were changed
+    auto fnOnSettingsChanged = [=](Span<Property* const> settings) {
+        auto appModule = AppModule::get(guiApp->application());
+        auto fnContains = [=](const Property& setting) {
+            return std::find(settings.begin(), settings.end(), &setting) != settings.end();
+        };
+        if (fnContains(appModule->meshingQuality)
+                || fnContains(appModule->meshingChordalDeflection)
+                || fnContains(appModule->meshingAngularDeflection)
+                || fnContains(appModule->meshingRelative)
+                || fnContains(appModule->meshingTriangleBudget))
+        {
+            this->recomputeDocumentsBRepMesh();
+        }
+
+        if (fnContains(appModule->graphicsMemoryBudget))
+            m_guiApp->setGraphicsMemoryBudget(int64_t(appModule->graphicsMemoryBudget) * 1024 * 1024);
+
+        if (fnContains(appModule->graphicsCompactHiddenMeshesDelay))
+            m_guiApp->setHiddenMeshesCompactionDelay(std::chrono::seconds(appModule->graphicsCompactHiddenMeshesDelay));
+
+        if (fnContains(appModule->graphicsStaticBatching))
+            m_guiApp->setStaticBatchingEnabled(appModule->graphicsStaticBatching);
+
+        if (fnContains(appModule->autoReloadModifiedFiles))
+            m_guiApp->documentFileWatcher()->setEnabled(appModule->autoReloadModifiedFiles);
+
+        if (fnContains(appModule->meshingLevelOfDetails)) {
+            for (GuiDocument* guiDoc : m_guiApp->guiDocuments()) {
+                if (appModule->meshingLevelOfDetails)
+                    this->computeDocumentBRepMeshLods(guiDoc);
+                else
+                    guiDoc->resetMeshLods();
+            }
+        }
+    };
+    QObject::connect(
+                guiApp->application()->settings(), &Settings::changed,
+                this, [=](Property* setting) { fnOnSettingsChanged(Span<Property* const>(&setting, 1)); });
+    QObject::connect(guiApp->application()->settings(), &Settings::changedMany, this, fnOnSettingsChanged);
     // Creation of annex objects
     {
         // Opened documents GUI
@@ -379,6 +597,47 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
 
     new DialogTaskManager(TaskManager::globalInstance(), this);
 
+    // Shapes deferred by readers are loaded in background, products that get expanded in the
+    // model tree or shown are loaded first
+    auto deferredShapesQueue = new DeferredShapesLoadQueue(guiApp, this);
+    deferredShapesQueue->setFunctionComputeBRepMesh([=](const TopoDS_Shape& shape, TaskProgress* progress) {
+        AppModule::get(guiApp->application())->computeBRepMesh(shape, progress);
+    });
+    QObject::connect(
+                m_ui->widget_ModelTree, &WidgetModelTree::documentTreeNodeExpanded,
+                deferredShapesQueue, [=](const DocumentTreeNode& node) {
+        deferredShapesQueue->prioritize(node);
+    });
+    QObject::connect(guiApp, &GuiApplication::guiDocumentAdded, deferredShapesQueue, [=](GuiDocument* guiDoc) {
+        QObject::connect(
+                    guiDoc, &GuiDocument::nodesVisibilityChanged,
+                    deferredShapesQueue, [=](const std::unordered_map<TreeNodeId, Qt::CheckState>& mapNodeId) {
+            std::vector<TreeNodeId> vecNodeIdShown;
+            for (const auto& [nodeId, state] : mapNodeId) {
+                if (state != Qt::Unchecked)
+                    vecNodeIdShown.push_back(nodeId);
+            }
+
+            deferredShapesQueue->prioritize(guiDoc->document(), vecNodeIdShown);
+        });
+    });
+
+    // Cached mass properties become obsolete when shapes are loaded, and invalid when the owner
+    // document is closed
+    QObject::connect(deferredShapesQueue, &DeferredShapesLoadQueue::productShapeLoaded, this, [=]{
+        m_mapLabelMassProperties.clear();
+    });
+    QObject::connect(
+                guiApp->application().get(), &Application::documentAboutToClose,
+                this, [=](const DocumentPtr& doc) {
+        for (auto it = m_mapLabelMassProperties.begin(); it != m_mapLabelMassProperties.end();) {
+            if (it->first.Data() == doc->GetData().get())
+                it = m_mapLabelMassProperties.erase(it);
+            else
+                ++it;
+        }
+    });
+
     // BEWARE MainWindow::onGuiDocumentAdded() must be called before
     // MainWindow::onCurrentDocumentIndexChanged()
     auto guiDocModel = new GuiDocumentListModel(guiApp, this);
@@ -393,6 +652,12 @@ MainWindow::MainWindow(GuiApplication* guiApp, QWidget *parent)
     this->onLeftContentsPageChanged(m_ui->stack_LeftContents->currentIndex());
     this->updateControlsActivation();
     m_ui->widget_MouseCoords->hide();
+    m_guiApp->setGraphicsMemoryBudget(
+                int64_t(AppModule::get(guiApp->application())->graphicsMemoryBudget) * 1024 * 1024);
+    m_guiApp->setHiddenMeshesCompactionDelay(
+                std::chrono::seconds(AppModule::get(guiApp->application())->graphicsCompactHiddenMeshesDelay));
+    m_guiApp->setStaticBatchingEnabled(AppModule::get(guiApp->application())->graphicsStaticBatching);
+    this->setupDocumentFileWatcher();
 
     this->onCurrentDocumentIndexChanged(-1);
 }
@@ -497,22 +762,30 @@ void MainWindow::importInCurrentDoc()
                 .targetDocument(widgetGuiDoc->guiDocument()->document())
                 .withFilepaths(resFileNames.listFilepath)
                 .withParametersProvider(AppModule::get(app))
-                .withEntityPostProcess([=](TDF_Label labelEntity, TaskProgress* progress) {
-                        AppModule::get(app)->computeBRepMesh(labelEntity, progress);
+                .withEntitiesPostProcess([=](auto spanFileEntities, TaskProgress* progress) {
+                        AppModule::get(app)->computeBRepMeshForDisplay(spanFileEntities, progress);
+                })
+                .withEntityPostProcessRequiredIf([=](const IO::Format& format) {
+                        return AppModule::get(app)->isImportPostProcessRequired(format);
                 })
-                .withEntityPostProcessRequiredIf(&IO::formatProvidesBRep)
                 .withEntityPostProcessInfoProgress(20, tr("Mesh BRep shapes"))
+                .withGeometryDeduplication(AppModule::get(app)->importDeduplicateGeometry.value())
                 .withMessenger(messenger)
                 .withTaskProgress(progress)
                 .execute();
         if (okImport)
             messenger->emitInfo(tr("Import time: %1ms").arg(chrono.elapsed()));
+
+        Internal::printTaskPerfStats(progress);
     });
     const QString taskTitle =
             resFileNames.listFilepath.size() > 1 ?
                 tr("Import") :
                 filepathTo<QString>(resFileNames.listFilepath.front().stem());
     taskMgr->setTitle(taskId, taskTitle);
+    const DocumentPtr doc = widgetGuiDoc->guiDocument()->document();
+    this->refineBRepMeshOnTaskEnded(taskId, [=]{ return doc; });
+    taskMgr->setPriority(taskId, TaskPriority::Interactive);
     taskMgr->run(taskId);
     for (const FilePath& fp : resFileNames.listFilepath)
         Internal::prependRecentFile(fp);
@@ -540,6 +813,8 @@ void MainWindow::exportSelectedItems()
     lastSettings.openDir = filepathFrom(strFilepath);
     auto taskMgr = TaskManager::globalInstance();
     const IO::Format format = Internal::formatFromFilter(lastSettings.selectedFilter);
+    // Selection can change while the export is running, the task works on a copy
+    const ApplicationItemsSnapshot itemsSnapshot(m_guiApp->selectionModel()->selectedItems());
     const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
         QTime chrono;
         chrono.start();
@@ -548,19 +823,269 @@ void MainWindow::exportSelectedItems()
                 app->ioSystem()->exportApplicationItems()
                 .targetFile(filepathFrom(strFilepath))
                 .targetFormat(format)
-                .withItems(m_guiApp->selectionModel()->selectedItems())
+                .withItems(itemsSnapshot)
                 .withParameters(AppModule::get(app)->findWriterParameters(format))
                 .withMessenger(messenger)
                 .withTaskProgress(progress)
                 .execute();
         if (okExport)
             messenger->emitInfo(tr("Export time: %1ms").arg(chrono.elapsed()));
+
+        Internal::printTaskPerfStats(progress);
     });
     taskMgr->setTitle(taskId, QFileInfo(strFilepath).fileName());
     taskMgr->run(taskId);
     Internal::ImportExportSettings::save(lastSettings);
 }
 
+void MainWindow::exportSelectedItemsSeparately()
+{
+    auto app = m_guiApp->application();
+    const QStringList listMode = { tr("Each leaf part"), tr("Each top-level product") };
+    bool ok = false;
+    const QString strMode = QInputDialog::getItem(
+                this, tr("Export each item separately"), tr("Split mode"), listMode, 0, false, &ok);
+    if (!ok)
+        return;
+
+    QStringList listWriterFileFilter;
+    for (const IO::Format& format : app->ioSystem()->writerFormats())
+        listWriterFileFilter.append(IO::System::fileFilter(format));
+
+    auto lastSettings = Internal::ImportExportSettings::load();
+    const QString strFilepath =
+            QFileDialog::getSaveFileName(
+                this,
+                tr("Select Output File Template(%name%: name of the part, %path%: parent assemblies)"),
+                filepathTo<QString>(lastSettings.openDir),
+                listWriterFileFilter.join(QLatin1String(";;")),
+                &lastSettings.selectedFilter);
+    if (strFilepath.isEmpty())
+        return;
+
+    lastSettings.openDir = filepathFrom(strFilepath);
+    const IO::Format format = Internal::formatFromFilter(lastSettings.selectedFilter);
+    const IO::ExportSplitMode splitMode =
+            strMode == listMode.front() ? IO::ExportSplitMode::LeafParts : IO::ExportSplitMode::TopLevelProducts;
+    const ApplicationItemsSnapshot itemsSnapshot(m_guiApp->selectionModel()->selectedItems());
+    const std::vector<IO::ExportSplitTarget> vecTarget =
+            IO::ExportSplitUtils::split(itemsSnapshot.items(), splitMode, filepathFrom(strFilepath));
+    Internal::ImportExportSettings::save(lastSettings);
+    if (vecTarget.empty())
+        return;
+
+    // Writers modifying the items data must run one at a time
+    const PropertyGroup* params = AppModule::get(app)->findWriterParameters(format);
+    bool isWriterExclusive = false;
+    std::unique_ptr<IO::Writer> writer = app->ioSystem()->createWriter(format);
+    if (writer) {
+        writer->applyProperties(params);
+        isWriterExclusive = writer->modifiesItemsData();
+    }
+
+    // Each task has its own writer, already computed triangulations of the shapes are shared
+    auto taskMgr = TaskManager::globalInstance();
+    for (const IO::ExportSplitTarget& target : vecTarget) {
+        const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+            // Template %path% gives sub-directories
+            std::error_code ec;
+            std::filesystem::create_directories(target.filepath.parent_path(), ec);
+            const ApplicationItem appItems[] = { target.item };
+            app->ioSystem()->exportApplicationItems()
+                    .targetFile(target.filepath)
+                    .targetFormat(format)
+                    .withItems(appItems)
+                    .withParameters(params)
+                    .withMessenger(MessengerQtSignal::defaultInstance())
+                    .withTaskProgress(progress)
+                    .execute();
+            MAYO_UNUSED(itemsSnapshot); // Data of the items is kept until all the tasks are over
+        });
+        taskMgr->setTitle(taskId, filepathTo<QString>(target.filepath.filename()));
+        if (isWriterExclusive)
+            taskMgr->setWeight(taskId, taskMgr->poolSize());
+
+        taskMgr->run(taskId);
+    }
+}
+
+void MainWindow::saveCurrentDocumentAs()
+{
+    auto widgetGuiDoc = this->currentWidgetGuiDocument();
+    if (!widgetGuiDoc)
+        return;
+
+    const DocumentPtr doc = widgetGuiDoc->guiDocument()->document();
+    // Suggest the location of the imported file, with the suffix of a Mayo document
+    FilePath fpInitial = doc->filePath();
+    if (fpInitial.empty())
+        fpInitial = filepathFrom(doc->name());
+
+    if (!Internal::isMayoDocumentFile(fpInitial))
+        fpInitial.replace_extension(".myb");
+
+    const QString strFilepath =
+            QFileDialog::getSaveFileName(
+                this,
+                tr("Save Document"),
+                filepathTo<QString>(fpInitial),
+                tr("Binary Mayo Document(*.myb)") + ";;" + tr("XML Mayo Document(*.myx)"));
+    if (strFilepath.isEmpty())
+        return;
+
+    auto app = m_guiApp->application();
+    auto taskMgr = TaskManager::globalInstance();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        QTime chrono;
+        chrono.start();
+        // Storage format follows the file suffix
+        const Document::Format docFormat =
+                QFileInfo(strFilepath).suffix() == "myx" ? Document::Format::Xml : Document::Format::Binary;
+        // Triangulations mustn't be replaced while they are written
+        std::lock_guard<std::mutex> lock(doc->dataMutex()); MAYO_UNUSED(lock);
+        doc->compactTriangulations().expandAll();
+        doc->ChangeStorageFormat(Document::toNameFormat(docFormat));
+        const PCDM_StoreStatus status = app->saveDocumentAs(doc, strFilepath, progress);
+        auto messenger = MessengerQtSignal::defaultInstance();
+        if (status == PCDM_SS_OK)
+            messenger->emitInfo(tr("Save time: %1ms").arg(chrono.elapsed()));
+        else
+            messenger->emitError(tr("Failed to save document '%1'(error %2)").arg(strFilepath).arg(int(status)));
+    });
+    taskMgr->setTitle(taskId, QFileInfo(strFilepath).fileName());
+    taskMgr->run(taskId);
+    Internal::prependRecentFile(filepathFrom(strFilepath));
+}
+
+void MainWindow::recomputeDocumentsBRepMesh()
+{
+    for (GuiDocument* guiDoc : m_guiApp->guiDocuments())
+        this->recomputeDocumentBRepMesh(guiDoc);
+}
+
+void MainWindow::recomputeDocumentBRepMesh(GuiDocument* guiDoc)
+{
+    auto app = m_guiApp->application();
+    auto taskMgr = TaskManager::globalInstance();
+    struct RemeshResult {
+        std::vector<TreeNodeId> vecEntityTreeNodeId;
+        QMetaObject::Connection connTaskEnded;
+    };
+    auto result = std::make_shared<RemeshResult>();
+    const DocumentPtr doc = guiDoc->document();
+    // Parts in view are meshed first, and displayed as soon as they're done
+    const std::shared_ptr<BRepMeshPriorities> priorities = guiDoc->beginMeshPriorities();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        result->vecEntityTreeNodeId = AppModule::get(app)->recomputeBRepMesh(doc, progress, priorities.get());
+    });
+    // Presentations must be recomputed in the GUI thread, once the task is over
+    result->connTaskEnded = QObject::connect(
+                taskMgr, &TaskManager::ended,
+                guiDoc, [=](TaskId endedTaskId) {
+        if (endedTaskId != taskId)
+            return;
+
+        QObject::disconnect(result->connTaskEnded);
+        const std::unordered_set<GraphicsObjectPtr> setGfxRecomputed = guiDoc->endMeshPriorities(priorities);
+        std::unordered_set<GraphicsBatchedObject*> setGfxBatched;
+        for (TreeNodeId entityTreeNodeId : result->vecEntityTreeNodeId) {
+            guiDoc->foreachGraphicsObject(entityTreeNodeId, [&](GraphicsObjectPtr gfxObject) {
+                GraphicsBatchedObject* gfxBatched = GraphicsBatchedObject::fromMember(gfxObject);
+                if (gfxBatched)
+                    setGfxBatched.insert(gfxBatched);
+                else if (setGfxRecomputed.find(gfxObject) == setGfxRecomputed.cend())
+                    guiDoc->graphicsScene()->recomputeObjectPresentation(gfxObject);
+            });
+        }
+
+        // Batches merge the triangulations of their members, once for all the members
+        for (GraphicsBatchedObject* gfxBatched : setGfxBatched) {
+            gfxBatched->prepare();
+            guiDoc->graphicsScene()->recomputeObjectPresentation(gfxBatched);
+        }
+
+        // Quality reports of re-meshed entities are outdated
+        for (TreeNodeId entityTreeNodeId : result->vecEntityTreeNodeId)
+            doc->invalidateMeshQualityReport(doc->modelTree().nodeData(entityTreeNodeId));
+
+        if (!result->vecEntityTreeNodeId.empty() && guiDoc->isMeshProblemsHighlighted())
+            guiDoc->updateMeshProblemsHighlight();
+        else if (!result->vecEntityTreeNodeId.empty())
+            guiDoc->graphicsScene()->redraw();
+
+        // Re-meshed faces lost their levels of detail
+        if (AppModule::get(app)->meshingLevelOfDetails)
+            this->computeDocumentBRepMeshLods(guiDoc);
+    });
+    taskMgr->setTitle(taskId, tr("Mesh BRep shapes") + " - " + doc->name());
+    // Meshing already keeps all hardware threads busy, don't run it along other heavy tasks
+    taskMgr->setWeight(taskId, taskMgr->poolSize());
+    taskMgr->setPriority(taskId, TaskPriority::Background);
+    taskMgr->run(taskId);
+}
+
+void MainWindow::computeDocumentBRepMeshLods(GuiDocument* guiDoc)
+{
+    auto app = m_guiApp->application();
+    auto taskMgr = TaskManager::globalInstance();
+    const DocumentPtr doc = guiDoc->document();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        AppModule::get(app)->computeBRepMeshLods(doc, progress);
+    });
+    auto connTaskEnded = std::make_shared<QMetaObject::Connection>();
+    *connTaskEnded = QObject::connect(
+                taskMgr, &TaskManager::ended,
+                guiDoc, [=](TaskId endedTaskId) {
+        if (endedTaskId != taskId)
+            return;
+
+        QObject::disconnect(*connTaskEnded);
+        guiDoc->updateMeshLods();
+    });
+    taskMgr->setTitle(taskId, tr("Mesh levels of detail") + " - " + doc->name());
+    taskMgr->setWeight(taskId, taskMgr->poolSize());
+    taskMgr->setPriority(taskId, TaskPriority::Background);
+    taskMgr->run(taskId);
+}
+
+void MainWindow::refineBRepMeshOnTaskEnded(TaskId taskId, std::function<DocumentPtr()> fnDocument)
+{
+    auto app = m_guiApp->application();
+    auto appModule = AppModule::get(app);
+    if (!appModule->meshingProgressive && !appModule->meshingLevelOfDetails)
+        return;
+
+    // Refinement is followed by the computation of levels of detail, see recomputeDocumentBRepMesh()
+    auto fnProcess = [=](GuiDocument* guiDoc) {
+        if (appModule->meshingProgressive)
+            this->recomputeDocumentBRepMesh(guiDoc);
+        else
+            this->computeDocumentBRepMeshLods(guiDoc);
+    };
+
+    TaskManager::globalInstance()->onEnded(taskId, this, [=]{
+        GuiDocument* guiDoc = m_guiApp->findGuiDocument(fnDocument());
+        if (!guiDoc)
+            return;
+
+        if (!guiDoc->isMappingEntityGraphics()) {
+            fnProcess(guiDoc);
+            return;
+        }
+
+        // Triangulations must not be replaced while presentations are built from them
+        auto connMapped = std::make_shared<QMetaObject::Connection>();
+        *connMapped = QObject::connect(
+                    guiDoc, &GuiDocument::entityGraphicsMapped,
+                    this, [=]{
+            if (!guiDoc->isMappingEntityGraphics()) {
+                QObject::disconnect(*connMapped);
+                fnProcess(guiDoc);
+            }
+        });
+    });
+}
+
 void MainWindow::quitApp()
 {
     QApplication::quit();
@@ -585,6 +1110,27 @@ void MainWindow::toggleCurrentDocPerformanceStats()
     }
 }
 
+void MainWindow::toggleCurrentDocGhostNonSelected(bool on)
+{
+    WidgetGuiDocument* widget = this->currentWidgetGuiDocument();
+    GuiDocument* guiDoc = widget ? widget->guiDocument() : nullptr;
+    if (guiDoc) {
+        GraphicsScene* gfxScene = guiDoc->graphicsScene();
+        if (on)
+            gfxScene->ghostNonSelectedObjects(0.85);
+        else
+            gfxScene->unghostObjects();
+    }
+}
+
+void MainWindow::toggleCurrentDocMeshProblemsHighlight(bool on)
+{
+    WidgetGuiDocument* widget = this->currentWidgetGuiDocument();
+    GuiDocument* guiDoc = widget ? widget->guiDocument() : nullptr;
+    if (guiDoc)
+        guiDoc->setMeshProblemsHighlighted(on);
+}
+
 void MainWindow::zoomInCurrentDoc()
 {
     this->currentWidgetGuiDocument()->controller()->zoomIn();
@@ -597,6 +1143,7 @@ void MainWindow::zoomOutCurrentDoc()
 
 void MainWindow::editOptions()
 {
+    AppModule::get(m_guiApp->application())->createAllFormatParameters();
     auto dlg = new DialogOptions(m_guiApp->application()->settings(), this);
     WidgetsUtils::asyncDialogExec(dlg);
 }
@@ -626,6 +1173,168 @@ void MainWindow::inspectXde()
     }
 }
 
+void MainWindow::decimateCurrentDocMeshes()
+{
+    auto widgetGuiDoc = this->currentWidgetGuiDocument();
+    if (!widgetGuiDoc)
+        return;
+
+    bool ok = false;
+    const double pctRatio = QInputDialog::getDouble(
+                this,
+                tr("Decimate meshes"),
+                tr("Targeted count of triangles(%)"),
+                50., 1., 99., 0, &ok);
+    if (!ok)
+        return;
+
+    auto app = m_guiApp->application();
+    auto taskMgr = TaskManager::globalInstance();
+    struct DecimateResult {
+        std::vector<TreeNodeId> vecEntityTreeNodeId;
+        QMetaObject::Connection connTaskEnded;
+    };
+    auto result = std::make_shared<DecimateResult>();
+    GuiDocument* guiDoc = widgetGuiDoc->guiDocument();
+    const DocumentPtr doc = guiDoc->document();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        result->vecEntityTreeNodeId = AppModule::get(app)->decimateMeshes(doc, pctRatio / 100., progress);
+    });
+    // Graphics objects still refer to the previous triangulations, they have to be updated in
+    // the GUI thread once the task is over
+    result->connTaskEnded = QObject::connect(
+                taskMgr, &TaskManager::ended,
+                guiDoc, [=](TaskId endedTaskId) {
+        if (endedTaskId != taskId)
+            return;
+
+        QObject::disconnect(result->connTaskEnded);
+        for (TreeNodeId entityTreeNodeId : result->vecEntityTreeNodeId) {
+            const TDF_Label labelEntity = DocumentTreeNode(doc, entityTreeNodeId).label();
+            auto attrTriangulation = CafUtils::findAttribute<TDataXtd_Triangulation>(labelEntity);
+            if (attrTriangulation.IsNull())
+                continue;
+
+            guiDoc->foreachGraphicsObject(entityTreeNodeId, [=](GraphicsObjectPtr gfxObject) {
+                GraphicsMeshObjectDriver::setObjectMesh(gfxObject, attrTriangulation->Get());
+                guiDoc->graphicsScene()->recomputeObjectPresentation(gfxObject);
+            });
+        }
+
+        if (!result->vecEntityTreeNodeId.empty())
+            guiDoc->graphicsScene()->redraw();
+    });
+    taskMgr->setTitle(taskId, tr("Decimate meshes") + " - " + doc->name());
+    taskMgr->run(taskId);
+}
+
+void MainWindow::detectCurrentDocClashes()
+{
+    auto widgetGuiDoc = this->currentWidgetGuiDocument();
+    if (!widgetGuiDoc)
+        return;
+
+    auto taskMgr = TaskManager::globalInstance();
+    struct ClashesResult {
+        std::vector<ClashDetection::Clash> vecClash;
+        bool isAborted = false;
+        QMetaObject::Connection connTaskEnded;
+    };
+    auto result = std::make_shared<ClashesResult>();
+    GuiDocument* guiDoc = widgetGuiDoc->guiDocument();
+    const DocumentPtr doc = guiDoc->document();
+    // Task works on a copy of the BVH, graphics of the document may change meanwhile
+    auto ptrBvh = std::make_shared<PartBvh>(guiDoc->partBvh());
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        std::lock_guard<std::mutex> lock(doc->dataMutex()); MAYO_UNUSED(lock);
+        doc->compactTriangulations().expandAll();
+        result->vecClash = ClashDetection::findClashes(doc, *ptrBvh, progress);
+        result->isAborted = progress->isAbortRequested();
+    });
+    result->connTaskEnded = QObject::connect(
+                taskMgr, &TaskManager::ended,
+                this, [=](TaskId endedTaskId) {
+        if (endedTaskId != taskId)
+            return;
+
+        QObject::disconnect(result->connTaskEnded);
+        if (result->isAborted || m_guiApp->application()->findIndexOfDocument(doc) == -1)
+            return;
+
+        auto dlg = new DialogClashes(m_guiApp, this);
+        dlg->load(doc, result->vecClash);
+        WidgetsUtils::asyncDialogExec(dlg);
+    });
+    taskMgr->setTitle(taskId, tr("Detect clashes") + " - " + doc->name());
+    taskMgr->run(taskId);
+}
+
+void MainWindow::analyzeCurrentDocMeshQuality()
+{
+    auto widgetGuiDoc = this->currentWidgetGuiDocument();
+    if (!widgetGuiDoc)
+        return;
+
+    auto taskMgr = TaskManager::globalInstance();
+    struct MeshQualityResult {
+        std::vector<std::shared_ptr<const MeshQualityAnalysis::Report>> vecReport; // Per entity
+        bool isAborted = false;
+        QMetaObject::Connection connTaskEnded;
+    };
+    auto result = std::make_shared<MeshQualityResult>();
+    const DocumentPtr doc = widgetGuiDoc->guiDocument()->document();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        std::lock_guard<std::mutex> lock(doc->dataMutex()); MAYO_UNUSED(lock);
+        doc->compactTriangulations().expandAll();
+        const int entityCount = doc->entityCount();
+        for (int i = 0; i < entityCount && !progress->isAbortRequested(); ++i) {
+            result->vecReport.push_back(doc->meshQualityReport(doc->entityLabel(i)));
+            progress->setValue(((i + 1) * 100) / entityCount);
+        }
+
+        result->isAborted = progress->isAbortRequested();
+    });
+    result->connTaskEnded = QObject::connect(
+                taskMgr, &TaskManager::ended,
+                this, [=](TaskId endedTaskId) {
+        if (endedTaskId != taskId)
+            return;
+
+        QObject::disconnect(result->connTaskEnded);
+        if (result->isAborted || m_guiApp->application()->findIndexOfDocument(doc) == -1)
+            return;
+
+        int problemEntityCount = 0;
+        for (unsigned i = 0; i < result->vecReport.size(); ++i) {
+            const MeshQualityAnalysis::Report& report = *result->vecReport.at(i);
+            if (!report.hasProblems())
+                continue;
+
+            ++problemEntityCount;
+            const QString entityName = CafUtils::labelAttrStdName(doc->entityLabel(i));
+            MessengerQtSignal::defaultInstance()->emitInfo(
+                        tr("%1: %2 degenerate and %3 sliver triangles, %4 non-manifold edges, "
+                           "%5 inconsistent edges, %6 boundary edges, %7 duplicate nodes")
+                        .arg(entityName)
+                        .arg(report.degenerateTriangleCount)
+                        .arg(report.sliverTriangleCount)
+                        .arg(report.nonManifoldEdgeCount)
+                        .arg(report.inconsistentEdgeCount)
+                        .arg(report.boundaryEdgeCount)
+                        .arg(report.duplicateNodeCount));
+        }
+
+        if (problemEntityCount == 0)
+            MessengerQtSignal::defaultInstance()->emitInfo(tr("No mesh problem found"));
+
+        GuiDocument* guiDoc = m_guiApp->findGuiDocument(doc);
+        if (guiDoc)
+            guiDoc->updateMeshProblemsHighlight();
+    });
+    taskMgr->setTitle(taskId, tr("Analyze mesh quality") + " - " + doc->name());
+    taskMgr->run(taskId);
+}
+
 void MainWindow::toggleFullscreen()
 {
     if (this->isFullScreen()) {
@@ -640,6 +1349,13 @@ void MainWindow::toggleFullscreen()
     }
 }
 
+void MainWindow::showMessageLog()
+{
+    m_dlgMessageLog->show();
+    m_dlgMessageLog->raise();
+    m_dlgMessageLog->activateWindow();
+}
+
 void MainWindow::toggleLeftSidebar()
 {
     const bool isVisible = m_ui->widget_Left->isVisible();
@@ -662,6 +1378,9 @@ void MainWindow::onApplicationItemSelectionChanged()
     WidgetModelTree* uiModelTree = m_ui->widget_ModelTree;
     WidgetPropertiesEditor* uiProps = m_ui->widget_Properties;
 
+    // Panel is laid out once, when all groups are added
+    uiProps->setUpdatesEnabled(false);
+    auto _ = gsl::finally([=]{ uiProps->setUpdatesEnabled(true); });
     uiProps->clear();
     Span<const ApplicationItem> spanAppItem = m_guiApp->selectionModel()->selectedItems();
     if (spanAppItem.size() == 1) {
@@ -673,9 +1392,9 @@ void MainWindow::onApplicationItemSelectionChanged()
             PropertyGroupSignals* dataProps = m_ptrCurrentNodeDataProperties.get();
             if (dataProps) {
                 uiProps->editProperties(dataProps, uiProps->addGroup(tr("Data")));
-                QObject::connect(dataProps, &PropertyGroupSignals::propertyChanged, this, [=]{
-                    uiModelTree->refreshItemText(item);
-                });
+                auto fnRefreshItemText = [=]{ uiModelTree->refreshItemText(item); };
+                QObject::connect(dataProps, &PropertyGroupSignals::propertyChanged, this, fnRefreshItemText);
+                QObject::connect(dataProps, &PropertyGroupSignals::propertiesChanged, this, fnRefreshItemText);
             }
 
             GuiDocument* guiDoc = m_guiApp->findGuiDocument(item.document());
@@ -689,11 +1408,22 @@ void MainWindow::onApplicationItemSelectionChanged()
                 GraphicsObjectBasePropertyGroup* gfxProps = m_ptrCurrentNodeGraphicsProperties.get();
                 if (gfxProps) {
                     uiProps->editProperties(gfxProps, uiProps->addGroup(tr("Graphics")));
-                    QObject::connect(gfxProps, &PropertyGroupSignals::propertyChanged, this, [=]{
-                        guiDoc->graphicsScene()->redraw();
-                    });
+                    auto fnRedraw = [=]{ guiDoc->graphicsScene()->redraw(); };
+                    QObject::connect(gfxProps, &PropertyGroupSignals::propertyChanged, this, fnRedraw);
+                    QObject::connect(gfxProps, &PropertyGroupSignals::propertiesChanged, this, fnRedraw);
                 }
             }
+
+            // Shared data(eg products of assembly components) is accounted once
+            MemoryAccounting memAccounting;
+            memAccounting.addTreeNode(item.document(), docTreeNode.id());
+            guiDoc->addMemoryStats(docTreeNode.id(), &memAccounting);
+            m_ptrCurrentNodeMemoryProperties = std::make_unique<Internal::MemoryStatsProperties>(
+                        memAccounting.stats(), m_guiApp->application()->settings()->locale());
+            uiProps->editProperties(m_ptrCurrentNodeMemoryProperties.get(), uiProps->addGroup(tr("Memory")));
+
+            if (XCaf::isShape(docTreeNode.label()))
+                this->showNodeMassProperties(docTreeNode);
         }
 
         auto app = m_guiApp->application();
@@ -703,14 +1433,153 @@ void MainWindow::onApplicationItemSelectionChanged()
                 this->setCurrentDocumentIndex(index);
         }
     }
-    else {
-        // TODO
-        uiProps->clear();
+    else if (spanAppItem.size() > 1) {
+        // Graphics properties are aggregated over the selected items, values differing from one
+        // item to the other are "mixed". Edits apply to all objects, followed by a single redraw
+        std::vector<GraphicsObjectPtr> vecGfxObject;
+        std::vector<GuiDocument*> vecGuiDoc;
+        for (const ApplicationItem& item : spanAppItem) {
+            GuiDocument* guiDoc = item.isDocumentTreeNode() ? m_guiApp->findGuiDocument(item.document()) : nullptr;
+            if (!guiDoc)
+                continue;
+
+            guiDoc->foreachGraphicsObject(item.documentTreeNode().id(), [&](GraphicsObjectPtr gfxObject) {
+                vecGfxObject.push_back(std::move(gfxObject));
+            });
+            if (std::find(vecGuiDoc.cbegin(), vecGuiDoc.cend(), guiDoc) == vecGuiDoc.cend())
+                vecGuiDoc.push_back(guiDoc);
+        }
+
+        // Objects of an assembly and of its selected components are shared
+        auto fnObjectLess = [](const GraphicsObjectPtr& lhs, const GraphicsObjectPtr& rhs) { return lhs.get() < rhs.get(); };
+        std::sort(vecGfxObject.begin(), vecGfxObject.end(), fnObjectLess);
+        vecGfxObject.erase(std::unique(vecGfxObject.begin(), vecGfxObject.end()), vecGfxObject.end());
+        auto commonGfxDriver = GraphicsObjectDriver::getCommon(vecGfxObject);
+        if (commonGfxDriver && !vecGfxObject.empty()) {
+            m_ptrCurrentNodeGraphicsProperties = commonGfxDriver->properties(vecGfxObject);
+            GraphicsObjectBasePropertyGroup* gfxProps = m_ptrCurrentNodeGraphicsProperties.get();
+            if (gfxProps) {
+                const QString groupName = tr("Graphics(%1 items)").arg(spanAppItem.size());
+                uiProps->editProperties(gfxProps, uiProps->addGroup(groupName));
+                auto fnRedraw = [=]{
+                    for (GuiDocument* guiDoc : vecGuiDoc)
+                        guiDoc->graphicsScene()->redraw();
+                };
+                QObject::connect(gfxProps, &PropertyGroupSignals::propertyChanged, this, fnRedraw);
+                QObject::connect(gfxProps, &PropertyGroupSignals::propertiesChanged, this, fnRedraw);
+            }
+        }
+
+        if (spanAppItem.size() == 2) {
+            const DocumentTreeNode& docTreeNode1 = spanAppItem[0].documentTreeNode();
+            const DocumentTreeNode& docTreeNode2 = spanAppItem[1].documentTreeNode();
+            if (docTreeNode1.isValid() && docTreeNode2.isValid()
+                    && XCaf::isShape(docTreeNode1.label()) && XCaf::isShape(docTreeNode2.label()))
+            {
+                this->showNodesDistance(docTreeNode1, docTreeNode2);
+            }
+        }
     }
 
     this->updateControlsActivation();
 }
 
+void MainWindow::showNodeMassProperties(const DocumentTreeNode& node)
+{
+    auto fnAddPropertiesGroup = [=](const MassProperties& massProps) {
+        WidgetPropertiesEditor* uiProps = m_ui->widget_Properties;
+        const StringUtils::TextOptions textOptions =
+                AppModule::get(m_guiApp->application())->defaultTextOptions();
+        m_ptrCurrentNodeMassProperties = std::make_unique<Internal::MassPropertiesProperties>(massProps, textOptions);
+        uiProps->editProperties(m_ptrCurrentNodeMassProperties.get(), uiProps->addGroup(tr("Mass properties")));
+    };
+
+    const TDF_Label label = node.label();
+    auto itCached = m_mapLabelMassProperties.find(label);
+    if (itCached != m_mapLabelMassProperties.cend()) {
+        fnAddPropertiesGroup(itCached->second);
+        return;
+    }
+
+    // Computation is useless for the previously selected node
+    auto taskMgr = TaskManager::globalInstance();
+    if (m_massPropertiesTaskId)
+        taskMgr->requestAbort(m_massPropertiesTaskId.value());
+
+    auto ptrMassProps = std::make_shared<MassProperties>();
+    const TopoDS_Shape shape = XCaf::shape(label);
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        *ptrMassProps = MassProperties::compute(shape, progress);
+    });
+    m_massPropertiesTaskId = taskId;
+    auto connTaskEnded = std::make_shared<QMetaObject::Connection>();
+    *connTaskEnded = QObject::connect(taskMgr, &TaskManager::ended, this, [=](TaskId endedTaskId) {
+        if (endedTaskId != taskId)
+            return;
+
+        QObject::disconnect(*connTaskEnded);
+        const bool isAborted = m_massPropertiesTaskId != taskId;
+        if (!isAborted)
+            m_massPropertiesTaskId.reset();
+
+        // Document may have been closed meanwhile, then its labels must not be retained
+        auto app = m_guiApp->application();
+        if (isAborted || app->findIndexOfDocument(node.document()) == -1)
+            return;
+
+        m_mapLabelMassProperties.insert({ label, *ptrMassProps });
+        Span<const ApplicationItem> spanAppItem = m_guiApp->selectionModel()->selectedItems();
+        if (spanAppItem.size() == 1 && spanAppItem.front().documentTreeNode() == node)
+            fnAddPropertiesGroup(*ptrMassProps);
+    });
+    taskMgr->setTitle(taskId, tr("Mass properties") + " - " + CafUtils::labelAttrStdName(label));
+    taskMgr->run(taskId);
+}
+
+void MainWindow::showNodesDistance(const DocumentTreeNode& node1, const DocumentTreeNode& node2)
+{
+    // Computation is useless for the previously selected nodes
+    auto taskMgr = TaskManager::globalInstance();
+    if (m_shapeDistanceTaskId)
+        taskMgr->requestAbort(m_shapeDistanceTaskId.value());
+
+    auto ptrDistance = std::make_shared<ShapeDistance>();
+    const TopoDS_Shape shape1 = Internal::worldShape(node1);
+    const TopoDS_Shape shape2 = Internal::worldShape(node2);
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        *ptrDistance = ShapeDistance::compute(shape1, shape2, progress);
+    });
+    m_shapeDistanceTaskId = taskId;
+    auto connTaskEnded = std::make_shared<QMetaObject::Connection>();
+    *connTaskEnded = QObject::connect(taskMgr, &TaskManager::ended, this, [=](TaskId endedTaskId) {
+        if (endedTaskId != taskId)
+            return;
+
+        QObject::disconnect(*connTaskEnded);
+        const bool isAborted = m_shapeDistanceTaskId != taskId;
+        if (!isAborted)
+            m_shapeDistanceTaskId.reset();
+
+        if (isAborted || ptrDistance->value < 0)
+            return;
+
+        Span<const ApplicationItem> spanAppItem = m_guiApp->selectionModel()->selectedItems();
+        if (spanAppItem.size() == 2
+                && spanAppItem[0].documentTreeNode() == node1
+                && spanAppItem[1].documentTreeNode() == node2)
+        {
+            WidgetPropertiesEditor* uiProps = m_ui->widget_Properties;
+            m_ptrCurrentNodesDistanceProperties = std::make_unique<Internal::ShapeDistanceProperties>(*ptrDistance);
+            uiProps->editProperties(m_ptrCurrentNodesDistanceProperties.get(), uiProps->addGroup(tr("Minimum distance")));
+        }
+    });
+    taskMgr->setTitle(
+                taskId,
+                tr("Minimum distance") + " - "
+                + CafUtils::labelAttrStdName(node1.label()) + " / " + CafUtils::labelAttrStdName(node2.label()));
+    taskMgr->run(taskId);
+}
+
 void MainWindow::onOperationFinished(bool ok, const QString &msg)
 {
     if (ok)
@@ -730,19 +1599,100 @@ void MainWindow::onGuiDocumentAdded(GuiDocument* guiDoc)
         guiDoc->graphicsScene()->redraw();
     }
 
-    QObject::connect(app->settings(), &Settings::changed, this, [=](Property* setting) {
+    guiDoc->graphicsScene()->setIdBufferPickingEnabled(appModule->graphicsIdBufferPicking);
+    guiDoc->graphicsScene()->setTransparencyMethod(appModule->graphicsTransparencyMethod);
+    guiDoc->graphicsScene()->setSelectionOutlineEnabled(appModule->graphicsSelectionOutline);
+
+    auto fnOnSettingChanged = [=](Property* setting) {
         if (setting == &appModule->instantZoomFactor)
             widget->controller()->setInstantZoomFactor(appModule->instantZoomFactor);
+        else if (setting == &appModule->graphicsIdBufferPicking)
+            guiDoc->graphicsScene()->setIdBufferPickingEnabled(appModule->graphicsIdBufferPicking);
+        else if (setting == &appModule->graphicsTransparencyMethod)
+            guiDoc->graphicsScene()->setTransparencyMethod(appModule->graphicsTransparencyMethod);
+        else if (setting == &appModule->graphicsSelectionOutline)
+            guiDoc->graphicsScene()->setSelectionOutlineEnabled(appModule->graphicsSelectionOutline);
+    };
+    QObject::connect(app->settings(), &Settings::changed, this, fnOnSettingChanged);
+    QObject::connect(app->settings(), &Settings::changedMany, this, [=](Span<Property* const> settings) {
+        for (Property* setting : settings)
+            fnOnSettingChanged(setting);
     });
 
     V3dViewController* ctrl = widget->controller();
+    auto fnUpdateMeshLods = [=]{
+        if (appModule->meshingLevelOfDetails)
+            guiDoc->updateMeshLods();
+    };
+    auto fnBeginViewInteraction = [=]{
+        GuiDocument::ViewInteractionOptions options;
+        options.cullingPixelSize = appModule->viewInteractionCullingSize;
+        options.plainShaded = appModule->viewInteractionPlainShaded;
+        guiDoc->beginViewInteraction(options);
+    };
+    QObject::connect(ctrl, &V3dViewController::viewScaled, guiDoc, fnUpdateMeshLods);
+    QObject::connect(ctrl, &V3dViewController::dynamicActionEnded, guiDoc, fnUpdateMeshLods);
+    // Pending meshing work follows the view camera
+    QObject::connect(ctrl, &V3dViewController::viewScaled, guiDoc, &GuiDocument::updateMeshPriorities);
+    QObject::connect(ctrl, &V3dViewController::dynamicActionEnded, guiDoc, &GuiDocument::updateMeshPriorities);
+    // Point clouds are refined by steps, each step loading a bounded count of points so the view
+    // stays responsive. Next step is scheduled as long as nodes are pending
+    auto timerPointCloudLods = new QTimer(guiDoc);
+    timerPointCloudLods->setSingleShot(true);
+    timerPointCloudLods->setInterval(50);
+    QObject::connect(timerPointCloudLods, &QTimer::timeout, guiDoc, [=]{
+        if (ctrl->hasCurrentDynamicAction())
+            return; // Resumed by dynamicActionEnded
+
+        const uint64_t pointBudget = uint64_t(appModule->pointCloudPointBudget.value()) * 1000;
+        if (guiDoc->updatePointCloudLods(pointBudget))
+            timerPointCloudLods->start();
+    });
+    auto fnUpdatePointCloudLods = [=]{ timerPointCloudLods->start(); };
+    QObject::connect(ctrl, &V3dViewController::viewScaled, guiDoc, fnUpdatePointCloudLods);
+    QObject::connect(ctrl, &V3dViewController::dynamicActionEnded, guiDoc, fnUpdatePointCloudLods);
+    QObject::connect(guiDoc, &GuiDocument::entityGraphicsMapped, guiDoc, fnUpdatePointCloudLods);
+    QObject::connect(
+                ctrl, &V3dViewController::dynamicActionStarted,
+                guiDoc, [=](V3dViewController::DynamicAction action) {
+        if (action == V3dViewController::DynamicAction::Rotation
+                || action == V3dViewController::DynamicAction::Panning)
+        {
+            fnBeginViewInteraction();
+        }
+    });
+    QObject::connect(ctrl, &V3dViewController::dynamicActionEnded, guiDoc, &GuiDocument::endViewInteraction);
+    // Hidden lines come after mesh levels of detail, as both need the document data
+    QObject::connect(ctrl, &V3dViewController::dynamicActionEnded, guiDoc, &GuiDocument::updateHiddenLines);
+    // Camera animations are drawn with the fast interaction mode as well
+    QObject::connect(
+                guiDoc->viewCameraAnimation(), &QAbstractAnimation::stateChanged,
+                guiDoc, [=](QAbstractAnimation::State newState) {
+        if (newState == QAbstractAnimation::Running) {
+            fnBeginViewInteraction();
+        }
+        else if (newState == QAbstractAnimation::Stopped && !ctrl->hasCurrentDynamicAction()) {
+            guiDoc->endViewInteraction();
+            guiDoc->updateMeshPriorities();
+            fnUpdateMeshLods();
+            fnUpdatePointCloudLods();
+            guiDoc->updateHiddenLines();
+        }
+    });
+    // Thumbnail is recorded as soon as document graphics are complete, not when closing document
+    QObject::connect(guiDoc, &GuiDocument::entityGraphicsMapped, this, [=]{
+        if (!guiDoc->isMappingEntityGraphics())
+            appModule->recordRecentFileThumbnail(guiDoc);
+    });
     QObject::connect(ctrl, &V3dViewController::mouseMoved, [=](const QPoint& pos2d) {
-        guiDoc->graphicsScene()->highlightAt(pos2d, widget->guiDocument()->v3dView());
-        auto selector = guiDoc->graphicsScene()->mainSelector();
-        selector->Pick(pos2d.x(), pos2d.y(), guiDoc->v3dView());
+        // Picking done by highlightAt() is reused, nothing to update when it was skipped
+        if (!guiDoc->graphicsScene()->highlightAt(pos2d, widget->guiDocument()->v3dView()))
+            return;
+
+        const std::optional<gp_Pnt> pickedPos3d = guiDoc->graphicsScene()->currentHighlightedPoint();
         const gp_Pnt pos3d =
-                selector->NbPicked() > 0 ?
-                    selector->PickedPoint(1) :
+                pickedPos3d ?
+                    pickedPos3d.value() :
                     GraphicsUtils::V3dView_to3dPosition(guiDoc->v3dView(), pos2d.x(), pos2d.y());
         m_ui->label_ValuePosX->setText(QString::number(pos3d.X(), 'f', 3));
         m_ui->label_ValuePosY->setText(QString::number(pos3d.Y(), 'f', 3));
@@ -755,11 +1705,6 @@ void MainWindow::onGuiDocumentAdded(GuiDocument* guiDoc)
     QTimer::singleShot(0, this, [=]{ this->setCurrentDocumentIndex(newDocIndex); });
 }
 
-void MainWindow::onGuiDocumentErased(GuiDocument* guiDoc)
-{
-    AppModule::get(m_guiApp->application())->recordRecentFileThumbnail(guiDoc);
-}
-
 void MainWindow::onWidgetFileSystemLocationActivated(const QFileInfo& loc)
 {
     this->openDocument(filepathFrom(loc));
@@ -788,6 +1733,8 @@ void MainWindow::onLeftContentsPageChanged(int pageId)
 void MainWindow::onCurrentDocumentIndexChanged(int idx)
 {
     m_ui->stack_GuiDocuments->setCurrentIndex(idx);
+    WidgetGuiDocument* widgetGuiDoc = this->currentWidgetGuiDocument();
+    m_guiApp->setActiveGuiDocument(widgetGuiDoc ? widgetGuiDoc->guiDocument() : nullptr);
     QAbstractItemView* view = m_ui->listView_OpenedDocuments;
     view->setCurrentIndex(view->model()->index(idx, 0));
 
@@ -826,6 +1773,16 @@ void MainWindow::onCurrentDocumentIndexChanged(int idx)
             QSignalBlocker sigBlk(m_ui->actionTogglePerformanceStats); Q_UNUSED(sigBlk);
             m_ui->actionTogglePerformanceStats->setChecked(guiDoc->v3dView()->ChangeRenderingParams().ToShowStats);
         }
+        // Sync action with current ghosting status
+        {
+            QSignalBlocker sigBlk(m_ui->actionGhostNonSelected); Q_UNUSED(sigBlk);
+            m_ui->actionGhostNonSelected->setChecked(guiDoc->graphicsScene()->hasGhostedObjects());
+        }
+        // Sync action with current highlight status of mesh problems
+        {
+            QSignalBlocker sigBlk(m_ui->actionHighlightMeshProblems); Q_UNUSED(sigBlk);
+            m_ui->actionHighlightMeshProblems->setChecked(guiDoc->isMeshProblemsHighlighted());
+        }
         // Sync menu with current projection type
         {
             const Graphic3d_Camera::Projection viewProjectionType =
@@ -843,6 +1800,8 @@ void MainWindow::onCurrentDocumentIndexChanged(int idx)
     else {
         m_ui->actionToggleOriginTrihedron->setChecked(false);
         m_ui->actionTogglePerformanceStats->setChecked(false);
+        m_ui->actionGhostNonSelected->setChecked(false);
+        m_ui->actionHighlightMeshProblems->setChecked(false);
     }
  }
 
@@ -854,7 +1813,7 @@ void MainWindow::closeCurrentDocument()
 void MainWindow::closeDocument(WidgetGuiDocument* widget)
 {
     if (widget) {
-        const DocumentPtr& doc = widget->guiDocument()->document();
+        const DocumentPtr doc = widget->guiDocument()->document();
         m_ui->stack_GuiDocuments->removeWidget(widget);
         widget->deleteLater();
         m_guiApp->application()->closeDocument(doc);
@@ -896,40 +1855,67 @@ void MainWindow::openDocumentsFromList(Span<const FilePath> listFilePath)
 {
     auto app = m_guiApp->application();
     auto taskMgr = TaskManager::globalInstance();
-    static std::mutex mutexApp;
     for (const FilePath& fp : listFilePath) {
         const DocumentPtr docPtr = app->findDocumentByLocation(fp);
-        if (docPtr.IsNull()) {
+        if (docPtr.IsNull() && Internal::isMayoDocumentFile(fp)) {
+            auto ptrDoc = std::make_shared<DocumentPtr>();
             const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
                 QTime chrono;
                 chrono.start();
-                DocumentPtr doc;
-                {
-                    std::lock_guard<std::mutex> lock(mutexApp); MAYO_UNUSED(lock);
-                    doc = app->newDocument();
-                }
-
-                doc->setName(filepathTo<QString>(fp.stem()));
-                doc->setFilePath(fp);
+                PCDM_ReaderStatus readStatus = PCDM_RS_OK;
+                *ptrDoc = app->openDocument(filepathTo<QString>(fp), &readStatus, progress);
+                if (!ptrDoc->IsNull())
+                    (*ptrDoc)->setViewerOnly(AppModule::get(app)->importViewerOnlyDocuments.value());
 
+                auto messenger = MessengerQtSignal::defaultInstance();
+                if (readStatus == PCDM_RS_OK)
+                    messenger->emitInfo(tr("Open time: %1ms").arg(chrono.elapsed()));
+                else
+                    messenger->emitError(tr("Failed to open document '%1'(error %2)").arg(filepathTo<QString>(fp)).arg(int(readStatus)));
+            });
+            taskMgr->setTitle(taskId, filepathTo<QString>(fp.stem()));
+            // Stored triangulations are reused, coarse ones are refined as for imported files
+            this->refineBRepMeshOnTaskEnded(taskId, [=]{ return *ptrDoc; });
+            this->restoreViewStateOnTaskEnded(taskId, fp, [=]{ return *ptrDoc; });
+            taskMgr->setPriority(taskId, TaskPriority::Interactive);
+            taskMgr->run(taskId);
+            Internal::prependRecentFile(fp);
+        }
+        else if (docPtr.IsNull()) {
+            // Document is created in the main thread before the import task is dispatched, this
+            // way Application signals are emitted there and the task only fills the document
+            const DocumentPtr doc = app->newDocument();
+            doc->setViewerOnly(AppModule::get(app)->importViewerOnlyDocuments.value());
+            doc->setName(filepathTo<QString>(fp.stem()));
+            doc->setFilePath(fp);
+            const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+                QTime chrono;
+                chrono.start();
                 auto messenger = MessengerQtSignal::defaultInstance();
                 const bool okImport =
                         app->ioSystem()->importInDocument()
                         .targetDocument(doc)
                         .withFilepath(fp)
                         .withParametersProvider(AppModule::get(app))
-                        .withEntityPostProcess([=](TDF_Label labelEntity, TaskProgress* progress) {
-                                AppModule::get(app)->computeBRepMesh(labelEntity, progress);
+                        .withEntitiesPostProcess([=](auto spanFileEntities, TaskProgress* progress) {
+                                AppModule::get(app)->computeBRepMeshForDisplay(spanFileEntities, progress);
+                        })
+                        .withEntityPostProcessRequiredIf([=](const IO::Format& format) {
+                                return AppModule::get(app)->isImportPostProcessRequired(format);
                         })
-                        .withEntityPostProcessRequiredIf(&IO::formatProvidesBRep)
                         .withEntityPostProcessInfoProgress(20, tr("Mesh BRep shapes"))
                         .withMessenger(messenger)
                         .withTaskProgress(progress)
                         .execute();
                 if (okImport)
                     messenger->emitInfo(tr("Import time: %1ms").arg(chrono.elapsed()));
+
+                Internal::printTaskPerfStats(progress);
             });
             taskMgr->setTitle(taskId, filepathTo<QString>(fp.stem()));
+            this->refineBRepMeshOnTaskEnded(taskId, [=]{ return doc; });
+            this->restoreViewStateOnTaskEnded(taskId, fp, [=]{ return doc; });
+            taskMgr->setPriority(taskId, TaskPriority::Interactive);
             taskMgr->run(taskId);
             Internal::prependRecentFile(fp);
         }
@@ -940,6 +1926,120 @@ void MainWindow::openDocumentsFromList(Span<const FilePath> listFilePath)
     }
 }
 
+void MainWindow::saveSession()
+{
+    auto appModule = AppModule::get(m_guiApp->application());
+    if (!appModule->restoreLastSession) {
+        appModule->lastSession.setValue({});
+        return;
+    }
+
+    const WidgetGuiDocument* widgetCurrent = this->currentWidgetGuiDocument();
+    const DocumentPtr currentDoc = widgetCurrent ? widgetCurrent->guiDocument()->document() : DocumentPtr();
+    appModule->lastSession.setValue(Session::capture(m_guiApp, currentDoc).toBlob());
+}
+
+void MainWindow::restoreSession()
+{
+    auto app = m_guiApp->application();
+    auto appModule = AppModule::get(app);
+    if (!appModule->restoreLastSession)
+        return;
+
+    const Session session = Session::fromBlob(appModule->lastSession.value());
+    std::vector<FilePath> vecFilepath;
+    for (const Session::Document& sessionDoc : session.vecDocument) {
+        if (!filepathIsRegularFile(sessionDoc.filepath))
+            continue;
+
+        // Tree nodes may not match any more if the file was modified
+        if (!sessionDoc.isOutOfSync())
+            m_mapPendingViewState.insert({ sessionDoc.filepath.native(), sessionDoc.viewState });
+
+        vecFilepath.push_back(sessionDoc.filepath);
+    }
+
+    this->openDocumentsFromList(vecFilepath);
+
+    // Documents of imported files are created right away, Mayo documents once read
+    if (session.currentDocumentIndex >= 0) {
+        const FilePath& fpCurrent = session.vecDocument.at(session.currentDocumentIndex).filepath;
+        const DocumentPtr docCurrent = app->findDocumentByLocation(fpCurrent);
+        if (!docCurrent.IsNull())
+            this->setCurrentDocumentIndex(app->findIndexOfDocument(docCurrent));
+    }
+}
+
+void MainWindow::restoreViewStateOnTaskEnded(TaskId taskId, const FilePath& fp, std::function<DocumentPtr()> fnDocument)
+{
+    if (m_mapPendingViewState.find(fp.native()) == m_mapPendingViewState.cend())
+        return;
+
+    auto fnRestore = [=](GuiDocument* guiDoc) {
+        auto it = m_mapPendingViewState.find(fp.native());
+        if (it != m_mapPendingViewState.end()) {
+            it->second.restore(guiDoc);
+            m_mapPendingViewState.erase(it);
+        }
+    };
+
+    TaskManager::globalInstance()->onEnded(taskId, this, [=]{
+        GuiDocument* guiDoc = m_guiApp->findGuiDocument(fnDocument());
+        if (!guiDoc) {
+            m_mapPendingViewState.erase(fp.native());
+            return;
+        }
+
+        if (!guiDoc->isMappingEntityGraphics()) {
+            fnRestore(guiDoc);
+            return;
+        }
+
+        // Camera would be reset by the "fit all" done when graphics of an entity are mapped
+        auto connMapped = std::make_shared<QMetaObject::Connection>();
+        *connMapped = QObject::connect(
+                    guiDoc, &GuiDocument::entityGraphicsMapped,
+                    this, [=]{
+            if (!guiDoc->isMappingEntityGraphics()) {
+                QObject::disconnect(*connMapped);
+                fnRestore(guiDoc);
+            }
+        });
+    });
+}
+
+void MainWindow::setupDocumentFileWatcher()
+{
+    auto app = m_guiApp->application();
+    DocumentFileWatcher* watcher = m_guiApp->documentFileWatcher();
+    watcher->setImportFunction([=](DocumentFileWatcher::ReloadContext* context, TaskProgress* progress) {
+        const FilePath& fp = context->filepath;
+        if (Internal::isMayoDocumentFile(fp))
+            return false; // Saved by Mayo itself, nothing to reload
+
+        auto messenger = MessengerQtSignal::defaultInstance();
+        auto op = app->ioSystem()->importInDocument();
+        op.targetDocument(context->doc)
+                .withFilepath(fp)
+                .withParametersProvider(AppModule::get(app))
+                .withEntityPostProcessRequiredIf([=](const IO::Format& format) {
+                        return AppModule::get(app)->isImportPostProcessRequired(format);
+                })
+                .withEntityPostProcessInfoProgress(20, tr("Mesh BRep shapes"))
+                .withMessenger(messenger)
+                .withTaskProgress(progress);
+        DocumentFileWatcher::withReimportDiff(op, context, [=](auto spanFileEntities, TaskProgress* progress) {
+            AppModule::get(app)->computeBRepMeshForDisplay(spanFileEntities, progress);
+        });
+        const bool okImport = op.execute();
+        if (okImport)
+            messenger->emitInfo(tr("Reloaded '%1'").arg(filepathTo<QString>(fp)));
+
+        return okImport;
+    });
+    watcher->setEnabled(AppModule::get(app)->autoReloadModifiedFiles);
+}
+
 void MainWindow::updateControlsActivation()
 {
     const QWidget* currMainPage = m_ui->stack_Main->currentWidget();
@@ -956,9 +2056,14 @@ void MainWindow::updateControlsActivation()
     m_ui->actionDisplayMode->setEnabled(!appDocumentsEmpty);
     m_ui->actionToggleOriginTrihedron->setEnabled(!appDocumentsEmpty);
     m_ui->actionTogglePerformanceStats->setEnabled(!appDocumentsEmpty);
+    m_ui->actionGhostNonSelected->setEnabled(!appDocumentsEmpty);
+    m_ui->actionHighlightMeshProblems->setEnabled(!appDocumentsEmpty);
     m_ui->actionZoomIn->setEnabled(!appDocumentsEmpty);
     m_ui->actionZoomOut->setEnabled(!appDocumentsEmpty);
     m_ui->actionSaveImageView->setEnabled(!appDocumentsEmpty);
+    m_ui->actionDecimateMeshes->setEnabled(!appDocumentsEmpty);
+    m_ui->actionDetectClashes->setEnabled(!appDocumentsEmpty);
+    m_ui->actionAnalyzeMeshQuality->setEnabled(!appDocumentsEmpty);
     m_ui->actionCloseDoc->setEnabled(!appDocumentsEmpty);
     m_ui->actionCloseAllDocuments->setEnabled(!appDocumentsEmpty);
     m_ui->actionCloseAllExcept->setEnabled(!appDocumentsEmpty);
@@ -966,6 +2071,8 @@ void MainWindow::updateControlsActivation()
     m_ui->actionPreviousDoc->setEnabled(!appDocumentsEmpty && currentDocIndex > 0);
     m_ui->actionNextDoc->setEnabled(!appDocumentsEmpty && currentDocIndex < appDocumentsCount - 1);
     m_ui->actionExportSelectedItems->setEnabled(!appDocumentsEmpty);
+    m_ui->actionExportSelectedItemsSeparately->setEnabled(!appDocumentsEmpty);
+    m_ui->actionSaveDocumentAs->setEnabled(!appDocumentsEmpty);
     m_ui->actionToggleLeftSidebar->setEnabled(newMainPage != m_ui->page_MainHome);
     m_ui->combo_GuiDocuments->setEnabled(!appDocumentsEmpty);
 
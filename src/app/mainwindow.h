@@ -6,16 +6,26 @@
 
 #pragma once
 
+#include "../base/caf_utils.h"
+#include "../base/document_ptr.h"
 #include "../base/filepath.h"
+#include "../base/mass_properties.h"
 #include "../base/property.h"
+#include "../base/task_common.h"
 #include "../graphics/graphics_object_base_property_group.h"
+#include "../gui/gui_document_view_state.h"
 #include <QtWidgets/QMainWindow>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <unordered_map>
 class QFileInfo;
 
 namespace Mayo {
 
+class DialogMessageLog;
 class Document;
+class DocumentTreeNode;
 class GuiApplication;
 class GuiDocument;
 class WidgetGuiDocument;
@@ -29,6 +39,13 @@ public:
     void openDocument(const FilePath& fp);
     void openDocumentsFromList(Span<const FilePath> listFilePath);
 
+    // Records the opened documents in setting AppModule::lastSession, to be called on exit
+    // Session is cleared if AppModule::restoreLastSession is off
+    void saveSession();
+    // Opens the documents of the last session, does nothing if AppModule::restoreLastSession is off
+    // View state of a document is restored once its graphics are mapped, see Session
+    void restoreSession();
+
     bool eventFilter(QObject* watched, QEvent* event) override;
 
 signals:
@@ -45,30 +62,61 @@ private:
     void openDocuments();
     void importInCurrentDoc();
     void exportSelectedItems();
+    // One file per part(or top-level product) of the selected items, written by parallel tasks
+    void exportSelectedItemsSeparately();
+    void saveCurrentDocumentAs();
     void closeCurrentDocument();
     void closeAllDocumentsExceptCurrent();
     void closeAllDocuments();
     void quitApp();
+
+    void recomputeDocumentsBRepMesh();
+    void recomputeDocumentBRepMesh(GuiDocument* guiDoc);
+    void computeDocumentBRepMeshLods(GuiDocument* guiDoc);
+    // Once task 'taskId' is over, the preview meshes of document 'fnDocument()' are refined in
+    // progressive meshing mode, then mesh levels of detail are computed if enabled
+    // This waits for the graphics of the document to be mapped
+    void refineBRepMeshOnTaskEnded(TaskId taskId, std::function<DocumentPtr()> fnDocument);
+    // Applies the view state pending for file 'fp'(see restoreSession()) once the graphics of the
+    // document opened by task 'taskId' are mapped
+    void restoreViewStateOnTaskEnded(TaskId taskId, const FilePath& fp, std::function<DocumentPtr()> fnDocument);
+    // Documents are reloaded with the same import options as openDocumentsFromList()
+    void setupDocumentFileWatcher();
     // -- Display menu
     void toggleCurrentDocOriginTrihedron();
     void toggleCurrentDocPerformanceStats();
+    void toggleCurrentDocGhostNonSelected(bool on);
+    void toggleCurrentDocMeshProblemsHighlight(bool on);
     void zoomInCurrentDoc();
     void zoomOutCurrentDoc();
     // -- Tools menu
     void editOptions();
     void saveImageView();
     void inspectXde();
+    void decimateCurrentDocMeshes();
+    // Finds the parts of the current document crossing each other in a background task, then
+    // lists them in a dialog
+    void detectCurrentDocClashes();
+    // Computes the quality reports of the entities of the current document in a background task,
+    // see Document::meshQualityReport(). Entities having problems are reported as info messages
+    void analyzeCurrentDocMeshQuality();
     // -- Window menu
     void toggleFullscreen();
     void toggleLeftSidebar();
+    void showMessageLog();
     // -- Help menu
     void aboutMayo();
     void reportbug();
 
     void onApplicationItemSelectionChanged();
+    // Adds to the properties panel the mass properties of 'node', they are computed once in a
+    // background task then cached per label
+    void showNodeMassProperties(const DocumentTreeNode& node);
+    // Adds to the properties panel the minimum distance between 'node1' and 'node2', computed in a
+    // background task
+    void showNodesDistance(const DocumentTreeNode& node1, const DocumentTreeNode& node2);
     void onOperationFinished(bool ok, const QString& msg);
     void onGuiDocumentAdded(GuiDocument* guiDoc);
-    void onGuiDocumentErased(GuiDocument* guiDoc);
     void onWidgetFileSystemLocationActivated(const QFileInfo& loc);
     void onLeftContentsPageChanged(int pageId);
     void onCurrentDocumentIndexChanged(int idx);
@@ -92,8 +140,17 @@ private:
     GuiApplication* m_guiApp = nullptr;
     class Ui_MainWindow* m_ui = nullptr;
     Qt::WindowStates m_previousWindowState = Qt::WindowNoState;
+    DialogMessageLog* m_dlgMessageLog = nullptr;
     std::unique_ptr<PropertyGroupSignals> m_ptrCurrentNodeDataProperties;
     std::unique_ptr<GraphicsObjectBasePropertyGroup> m_ptrCurrentNodeGraphicsProperties;
+    std::unique_ptr<PropertyGroupSignals> m_ptrCurrentNodeMemoryProperties;
+    std::unique_ptr<PropertyGroupSignals> m_ptrCurrentNodeMassProperties;
+    std::unordered_map<TDF_Label, MassProperties> m_mapLabelMassProperties;
+    std::optional<TaskId> m_massPropertiesTaskId;
+    std::unique_ptr<PropertyGroupSignals> m_ptrCurrentNodesDistanceProperties;
+    std::optional<TaskId> m_shapeDistanceTaskId;
+    // View states of the documents being opened by restoreSession(), key is the native file path
+    std::unordered_map<FilePath::string_type, GuiDocumentViewState> m_mapPendingViewState;
 };
 
 } // namespace Mayo
@@ -6,106 +6,75 @@
 
 #include "recent_files.h"
 
-#include "occt_window.h"
 #include "theme.h"
-#include "../graphics/graphics_utils.h"
-#include "../gui/gui_document.h"
-#include "../gui/qtgui_utils.h"
+#include "../gui/gui_offscreen_renderer.h"
 
-#include <gsl/util>
-//#include <QtGui/QOffscreenSurface>
-#include <QtGui/QWindow>
-#include <Aspect_NeutralWindow.hxx>
+#include <QtCore/QFileInfo>
+#include <QtGui/QPixmap>
+#include <chrono>
 
 namespace Mayo {
 
-static int64_t lastModifiedTimestamp(const FilePath& fp)
+int64_t RecentFile::lastModifiedTimestamp(const FilePath& fp)
 {
     // Qt: QFileInfo(filepath).lastModified().toSecsSinceEpoch();
-    const auto lastModifiedTime = std::filesystem::last_write_time(fp).time_since_epoch();
+    std::error_code ec;
+    const auto lastModifiedTime = std::filesystem::last_write_time(fp, ec).time_since_epoch();
+    if (ec)
+        return 0;
+
     return std::chrono::duration_cast<std::chrono::seconds>(lastModifiedTime).count();
 }
 
-bool RecentFile::recordThumbnail(GuiDocument* guiDoc, QSize size)
+RecentFile::FileInfo RecentFile::queryFileInfo(const FilePath& fp)
 {
-    if (!guiDoc)
-        return false;
-
-    if (!filepathEquivalent(this->filepath, guiDoc->document()->filePath()))
-        return false;
-
-    if (this->thumbnailTimestamp != lastModifiedTimestamp(this->filepath)) {
-        const GuiDocument::ViewTrihedronMode onEntryTrihedronMode = guiDoc->viewTrihedronMode();
-        const bool onEntryOriginTrihedronVisible = guiDoc->isOriginTrihedronVisible();
-        const QColor bkgColor = mayoTheme()->color(Theme::Color::Palette_Window);
-        Handle_V3d_View view = guiDoc->graphicsScene()->createV3dView();
-        view->ChangeRenderingParams().IsAntialiasingEnabled = true;
-        view->ChangeRenderingParams().NbMsaaSamples = 4;
-        view->SetBackgroundColor(QtGuiUtils::toPreferredColorSpace(bkgColor));
-
-        auto _ = gsl::finally([=]{
-            guiDoc->graphicsScene()->v3dViewer()->SetViewOff(view);
-            guiDoc->setViewTrihedronMode(onEntryTrihedronMode);
-            if (guiDoc->isOriginTrihedronVisible() != onEntryOriginTrihedronVisible)
-                guiDoc->toggleOriginTrihedronVisibility();
-        });
-
-        guiDoc->graphicsScene()->clearSelection();
-        guiDoc->setViewTrihedronMode(GuiDocument::ViewTrihedronMode::None);
-        if (guiDoc->isOriginTrihedronVisible())
-            guiDoc->toggleOriginTrihedronVisibility();
-
-        QWindow window; // TODO Use a pure offscreen window instead
-        window.setBaseSize(size);
-        window.create();
-        Handle_Aspect_NeutralWindow hWnd = new Aspect_NeutralWindow;
-        hWnd->SetSize(size.width(), size.height());
-        hWnd->SetNativeHandle(Aspect_Drawable(window.winId()));
-        view->SetWindow(hWnd);
-
-        GraphicsUtils::V3dView_fitAll(view);
-
-        Image_PixMap pixmap;
-        pixmap.SetTopDown(true);
-        V3d_ImageDumpOptions dumpOptions;
-        dumpOptions.BufferType = Graphic3d_BT_RGB;
-        dumpOptions.Width = size.width();
-        dumpOptions.Height = size.height();
-        bool ok = view->ToPixMap(pixmap, dumpOptions);
-        if (!ok)
-            return false;
-
-        const QImage img(pixmap.Data(),
-                         int(pixmap.Width()),
-                         int(pixmap.Height()),
-                         int(pixmap.SizeRowBytes()),
-                         QImage::Format_RGB888);
-        if (img.isNull())
-            return false;
-
-        this->thumbnail = QPixmap::fromImage(img);
-        this->thumbnailTimestamp = lastModifiedTimestamp(this->filepath);
-    }
-
-    return true;
+    FileInfo info;
+    const auto fi = filepathTo<QFileInfo>(fp);
+    info.exists = fi.exists();
+    if (!info.exists)
+        return info;
+
+    info.size = fi.size();
+    info.birthTime = fi.birthTime();
+    info.lastModified = fi.lastModified();
+    info.lastRead = fi.lastRead();
+    info.lastModifiedTimestamp = RecentFile::lastModifiedTimestamp(fp);
+    return info;
 }
 
 bool RecentFile::isThumbnailOutOfSync() const
 {
-    return this->thumbnailTimestamp != lastModifiedTimestamp(this->filepath);
+    return this->thumbnailTimestamp != RecentFile::lastModifiedTimestamp(this->filepath);
+}
+
+FilePath RecentFile::thumbnailFilePath(const FilePath& dirPath) const
+{
+    if (this->thumbnailHash.isEmpty())
+        return {};
+
+    return dirPath / (this->thumbnailHash.toStdString() + ".png");
+}
+
+QImage RecentFile::renderThumbnail(GuiDocument* guiDoc, QSize size)
+{
+    GuiOffscreenRenderer::Options options;
+    options.size = size;
+    options.backgroundColor = mayoTheme()->color(Theme::Color::Palette_Window);
+    GuiOffscreenRenderer renderer;
+    return renderer.render(guiDoc, options);
 }
 
 bool operator==(const RecentFile& lhs, const RecentFile& rhs)
 {
     return lhs.filepath == rhs.filepath
-            && lhs.thumbnail.cacheKey() == rhs.thumbnail.cacheKey()
+            && lhs.thumbnailHash == rhs.thumbnailHash
             && lhs.thumbnailTimestamp == rhs.thumbnailTimestamp;
 }
 
 QDataStream& operator<<(QDataStream& stream, const RecentFile& recentFile)
 {
     stream << filepathTo<QString>(recentFile.filepath);
-    stream << recentFile.thumbnail;
+    stream << recentFile.thumbnailHash;
     stream << qint64(recentFile.thumbnailTimestamp);
     return stream;
 }
@@ -115,13 +84,19 @@ QDataStream& operator>>(QDataStream& stream, RecentFile& recentFile)
     QString strFilepath;
     stream >> strFilepath;
     recentFile.filepath = filepathFrom(strFilepath);
-    stream >> recentFile.thumbnail;
+    stream >> recentFile.thumbnailHash;
     stream >> reinterpret_cast<qint64&>(recentFile.thumbnailTimestamp);
     return stream;
 }
 
+// Written before the count of recent files, older streams(thumbnails stored inline) start with the
+// count of recent files which is far below these markers
+static const uint32_t RecentFilesStreamMarker_v2 = 0xFF000002; // No thumbnail hash
+static const uint32_t RecentFilesStreamMarker_v3 = 0xFF000003;
+
 QDataStream& operator<<(QDataStream& stream, const RecentFiles& recentFiles)
 {
+    stream << RecentFilesStreamMarker_v3;
     stream << uint32_t(recentFiles.size());
     for (const RecentFile& recent : recentFiles)
         stream << recent;
@@ -131,12 +106,34 @@ QDataStream& operator<<(QDataStream& stream, const RecentFiles& recentFiles)
 
 QDataStream& operator>>(QDataStream& stream, RecentFiles& recentFiles)
 {
-    uint32_t count = 0;
-    stream >> count;
+    uint32_t marker = 0;
+    stream >> marker;
+    const bool isLegacyStream =
+            marker != RecentFilesStreamMarker_v2 && marker != RecentFilesStreamMarker_v3;
+    uint32_t count = marker;
+    if (!isLegacyStream)
+        stream >> count;
+
     recentFiles.clear();
     for (uint32_t i = 0; i < count; ++i) {
         RecentFile recent;
-        stream >> recent;
+        if (marker == RecentFilesStreamMarker_v3) {
+            stream >> recent;
+        }
+        else {
+            // Thumbnail isn't kept, it will be rendered again into the cache
+            QString strFilepath;
+            stream >> strFilepath;
+            recent.filepath = filepathFrom(strFilepath);
+            if (isLegacyStream) {
+                QPixmap thumbnail;
+                stream >> thumbnail;
+            }
+
+            qint64 thumbnailTimestamp;
+            stream >> thumbnailTimestamp;
+        }
+
         recentFiles.push_back(std::move(recent));
     }
 
@@ -9,8 +9,11 @@
 #include "../base/filepath.h"
 #include "../base/property_builtins.h"
 
+#include <QtCore/QByteArray>
+#include <QtCore/QDateTime>
 #include <QtCore/QMetaType>
-#include <QtGui/QPixmap>
+#include <QtCore/QSize>
+#include <QtGui/QImage>
 #include <vector>
 class QDataStream;
 
@@ -18,12 +21,36 @@ namespace Mayo {
 
 class GuiDocument;
 
+// Thumbnails aren't stored along with recent files but in a content-addressed cache directory as
+// PNG files, see RecentFile::thumbnailFilePath()
 struct RecentFile {
     FilePath filepath;
-    QPixmap thumbnail;
-    int64_t thumbnailTimestamp = 0;
-    bool recordThumbnail(GuiDocument* guiDoc, QSize size);
+    QByteArray thumbnailHash; // Hexadecimal SHA-1 of the thumbnail PNG data, empty if none
+    int64_t thumbnailTimestamp = 0; // Last modification time of the file when thumbnail was saved
     bool isThumbnailOutOfSync() const;
+
+    // Path of the thumbnail file in cache directory 'dirPath', empty if there is no thumbnail
+    FilePath thumbnailFilePath(const FilePath& dirPath) const;
+
+    static int64_t lastModifiedTimestamp(const FilePath& fp);
+
+    // Attributes of a recent file as found on the file system
+    struct FileInfo {
+        bool exists = false;
+        int64_t size = 0;
+        QDateTime birthTime;
+        QDateTime lastModified;
+        QDateTime lastRead;
+        int64_t lastModifiedTimestamp = 0; // Same as RecentFile::lastModifiedTimestamp()
+    };
+
+    // Queries file system attributes of 'fp'. This may block for a long time(eg unreachable network
+    // drive), so it should be called from a worker thread
+    static FileInfo queryFileInfo(const FilePath& fp);
+
+    // Renders the 3D scene of 'guiDoc' into an offscreen buffer at resolution 'size'
+    // Must be called from the GUI thread, returned image can then be saved from any thread
+    static QImage renderThumbnail(GuiDocument* guiDoc, QSize size);
 };
 
 using RecentFiles = std::vector<RecentFile>;
@@ -0,0 +1,96 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "session.h"
+
+#include "recent_files.h"
+#include "../base/application.h"
+#include "../base/document.h"
+#include "../gui/gui_application.h"
+#include "../gui/gui_document.h"
+
+#include <QtCore/QDataStream>
+
+namespace Mayo {
+
+// Written first so a blob of another format is detected
+static const uint32_t SessionStreamMarker_v1 = 0x4D534E01;
+
+bool Session::Document::isOutOfSync() const
+{
+    return RecentFile::lastModifiedTimestamp(this->filepath) != this->lastModifiedTimestamp;
+}
+
+Session Session::capture(GuiApplication* guiApp, const DocumentPtr& currentDoc)
+{
+    Session session;
+    for (Application::DocumentIterator it(guiApp->application()); it.hasNext(); it.next()) {
+        const DocumentPtr& doc = it.current();
+        GuiDocument* guiDoc = guiApp->findGuiDocument(doc);
+        if (!guiDoc || doc->filePath().empty() || !filepathIsRegularFile(doc->filePath()))
+            continue;
+
+        if (doc == currentDoc)
+            session.currentDocumentIndex = int(session.vecDocument.size());
+
+        Session::Document sessionDoc;
+        sessionDoc.filepath = doc->filePath();
+        sessionDoc.lastModifiedTimestamp = RecentFile::lastModifiedTimestamp(doc->filePath());
+        sessionDoc.viewState = GuiDocumentViewState::save(guiDoc);
+        session.vecDocument.push_back(std::move(sessionDoc));
+    }
+
+    return session;
+}
+
+QByteArray Session::toBlob() const
+{
+    QByteArray blob;
+    QDataStream stream(&blob, QIODevice::WriteOnly);
+    stream << SessionStreamMarker_v1;
+    stream << int32_t(this->currentDocumentIndex);
+    stream << uint32_t(this->vecDocument.size());
+    for (const Session::Document& doc : this->vecDocument) {
+        stream << filepathTo<QString>(doc.filepath);
+        stream << qint64(doc.lastModifiedTimestamp);
+        stream << doc.viewState;
+    }
+
+    return blob;
+}
+
+Session Session::fromBlob(const QByteArray& blob)
+{
+    QDataStream stream(blob);
+    uint32_t marker = 0;
+    stream >> marker;
+    if (marker != SessionStreamMarker_v1)
+        return {};
+
+    Session session;
+    int32_t currentDocumentIndex = -1;
+    uint32_t count = 0;
+    stream >> currentDocumentIndex >> count;
+    for (uint32_t i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        Session::Document doc;
+        QString strFilepath;
+        qint64 lastModifiedTimestamp = 0;
+        stream >> strFilepath >> lastModifiedTimestamp >> doc.viewState;
+        doc.filepath = filepathFrom(strFilepath);
+        doc.lastModifiedTimestamp = lastModifiedTimestamp;
+        session.vecDocument.push_back(std::move(doc));
+    }
+
+    if (stream.status() != QDataStream::Ok)
+        return {};
+
+    if (currentDocumentIndex >= 0 && currentDocumentIndex < int(session.vecDocument.size()))
+        session.currentDocumentIndex = currentDocumentIndex;
+
+    return session;
+}
+
+} // namespace Mayo
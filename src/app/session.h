@@ -0,0 +1,45 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/filepath.h"
+#include "../gui/gui_document_view_state.h"
+
+#include <QtCore/QByteArray>
+#include <vector>
+
+namespace Mayo {
+
+class GuiApplication;
+
+// Snapshot of the documents opened in the application, recorded on exit so they can be opened
+// again on next start(see AppModule::restoreLastSession)
+// Documents are read again from their files, meshing is then served by the mesh cache if enabled
+// (see BRepMeshCache). View state of a document is restored only if its file wasn't modified
+struct Session {
+    struct Document {
+        FilePath filepath;
+        int64_t lastModifiedTimestamp = 0; // See RecentFile::lastModifiedTimestamp()
+        GuiDocumentViewState viewState;
+        bool isOutOfSync() const;
+    };
+
+    std::vector<Document> vecDocument;
+    int currentDocumentIndex = -1; // Index in 'vecDocument'
+
+    bool isEmpty() const { return this->vecDocument.empty(); }
+
+    // Documents without file location(eg new document never saved) are skipped
+    // 'currentDoc' is the document displayed in main window, can be null
+    static Session capture(GuiApplication* guiApp, const DocumentPtr& currentDoc);
+
+    // Binary form stored in settings, invalid blob gives an empty session
+    QByteArray toBlob() const;
+    static Session fromBlob(const QByteArray& blob);
+};
+
+} // namespace Mayo
@@ -44,6 +44,7 @@ public:
         Back,
         Next,
         Multiple,
+        SplitViews,
         Camera,
         LeftSidebar,
         BackSquare,
@@ -8,15 +8,25 @@
 
 #include "../base/application.h"
 #include "../base/bnd_utils.h"
+#include "../base/cross_section.h"
+#include "../base/document.h"
+#include "../base/global.h"
 #include "../base/math_utils.h"
+#include "../base/messenger.h"
 #include "../base/settings.h"
+#include "../base/task_manager.h"
 #include "../base/tkernel_utils.h"
+#include "../graphics/graphics_scene.h"
 #include "../graphics/graphics_utils.h"
+#include "../gui/gui_document.h"
 #include "app_module.h"
 #include "ui_widget_clip_planes.h"
 
 #include <algorithm>
+#include <mutex>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtWidgets/QFileDialog>
 #include <Bnd_Box.hxx>
 #include <Graphic3d_ClipPlane.hxx>
 #include <Graphic3d_Texture2Dmanual.hxx>
@@ -24,10 +34,12 @@
 
 namespace Mayo {
 
-WidgetClipPlanes::WidgetClipPlanes(const Handle_V3d_View& view3d, QWidget* parent)
+WidgetClipPlanes::WidgetClipPlanes(GuiDocument* guiDoc, QWidget* parent)
     : QWidget(parent),
       m_ui(new Ui_WidgetClipPlanes),
-      m_view(view3d)
+      m_guiDoc(guiDoc),
+      m_view(guiDoc->v3dView()),
+      m_gfxScene(guiDoc->graphicsScene())
 {
     m_ui->setupUi(this);
     this->createPlaneCappingTexture();
@@ -66,43 +78,58 @@ WidgetClipPlanes::WidgetClipPlanes(const Handle_V3d_View& view3d, QWidget* paren
     const auto appModule = AppModule::get(Application::instance());
     for (ClipPlaneData& data : m_vecClipPlaneData) {
         data.ui.widget_Control->setEnabled(data.ui.check_On->isChecked());
+        data.capping = data.graphics->Clone();
+        data.capping->SetCapping(appModule->clipPlanesCappingOn.value());
+        data.graphics->SetCapping(false);
         this->connectUi(&data);
-        data.graphics->SetCapping(appModule->clipPlanesCappingOn.value());
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
-        data.graphics->SetCappingColor(fnGetCappingColor(data));
+        data.capping->SetCappingColor(fnGetCappingColor(data));
 #else
         Graphic3d_MaterialAspect cappingMaterial(Graphic3d_NOM_STEEL);
         cappingMaterial.SetColor(fnGetCappingColor(data));
-        data.graphics->SetCappingMaterial(cappingMaterial);
+        data.capping->SetCappingMaterial(cappingMaterial);
 #endif
         if (!m_textureCapping.IsNull() && appModule->clipPlanesCappingHatchOn.value())
-            data.graphics->SetCappingTexture(m_textureCapping);
+            data.capping->SetCappingTexture(m_textureCapping);
     }
 
     const auto settings = Application::instance()->settings();
-    QObject::connect(settings, &Settings::changed, this, [=](Property* property) {
-        if (property == &appModule->clipPlanesCappingOn) {
-            for (ClipPlaneData& data : m_vecClipPlaneData)
-                data.graphics->SetCapping(appModule->clipPlanesCappingOn.value());
-
-            m_view->Redraw();
-        }
-        else if (property == &appModule->clipPlanesCappingHatchOn) {
+    auto fnOnSettingsChanged = [=](Span<Property* const> properties) {
+        auto fnContains = [=](const Property& property) {
+            return std::find(properties.begin(), properties.end(), &property) != properties.end();
+        };
+        const bool isCappingChanged = fnContains(appModule->clipPlanesCappingOn);
+        const bool isCappingHatchChanged = fnContains(appModule->clipPlanesCappingHatchOn);
+        if (isCappingHatchChanged) {
             Handle_Graphic3d_TextureMap hatchTexture;
             if (!m_textureCapping.IsNull() && appModule->clipPlanesCappingHatchOn.value())
                 hatchTexture = m_textureCapping;
 
             for (ClipPlaneData& data : m_vecClipPlaneData)
-                data.graphics->SetCappingTexture(hatchTexture);
+                data.capping->SetCappingTexture(hatchTexture);
+        }
 
-            m_view->Redraw();
+        if (isCappingChanged) {
+            for (ClipPlaneData& data : m_vecClipPlaneData)
+                this->updateCapping(&data);
         }
+
+        if (isCappingChanged || isCappingHatchChanged)
+            m_gfxScene->redraw();
+    };
+    QObject::connect(settings, &Settings::changed, this, [=](Property* property) {
+        fnOnSettingsChanged(Span<Property* const>(&property, 1));
     });
+    QObject::connect(settings, &Settings::changedMany, this, fnOnSettingsChanged);
     m_ui->widget_CustomDir->setVisible(false);
+    QObject::connect(m_ui->btn_ExportSection, &QAbstractButton::clicked, this, &WidgetClipPlanes::exportSection);
 }
 
 WidgetClipPlanes::~WidgetClipPlanes()
 {
+    for (ClipPlaneData& data : m_vecClipPlaneData)
+        this->clearCapping(&data);
+
     delete m_ui;
 }
 
@@ -117,17 +144,23 @@ void WidgetClipPlanes::setRanges(const Bnd_Box& bndBox)
         data.ui.check_On->setEnabled(!isBndBoxVoid);
         if (isBndBoxVoid)
             data.ui.check_On->setChecked(false);
+
+        this->updateCapping(&data); // Objects may have been added
     }
 
-    m_view->Redraw();
+    this->updateExportSectionEnabled();
+
+    m_gfxScene->redraw();
 }
 
 void WidgetClipPlanes::setClippingOn(bool on)
 {
-    for (ClipPlaneData& data : m_vecClipPlaneData)
+    for (ClipPlaneData& data : m_vecClipPlaneData) {
         data.graphics->SetOn(on ? data.ui.check_On->isChecked() : false);
+        this->updateCapping(&data);
+    }
 
-    m_view->Redraw();
+    m_gfxScene->redraw();
 }
 
 void WidgetClipPlanes::connectUi(ClipPlaneData* data)
@@ -141,7 +174,8 @@ void WidgetClipPlanes::connectUi(ClipPlaneData* data)
     QObject::connect(ui.check_On, &QCheckBox::clicked, this, [=](bool on) {
         ui.widget_Control->setEnabled(on);
         this->setPlaneOn(gfx, on);
-        m_view->Redraw();
+        this->updatePlaneGraphics(data);
+        this->updateExportSectionEnabled();
     });
 
     if (data->ui.customXDirSpin()) {
@@ -165,7 +199,16 @@ void WidgetClipPlanes::connectUi(ClipPlaneData* data)
         const double dPct = ui.spinValueToSliderValue(pos);
         posSlider->setValue(qRound(dPct));
         GraphicsUtils::Gpx3dClipPlane_setPosition(gfx, pos);
-        m_view->Redraw();
+        this->updatePlaneGraphics(data);
+    });
+
+    QObject::connect(posSlider, &QAbstractSlider::sliderPressed, this, [=]{
+        data->isDragging = true;
+        this->updatePlaneGraphics(data);
+    });
+    QObject::connect(posSlider, &QAbstractSlider::sliderReleased, this, [=]{
+        data->isDragging = false;
+        this->updatePlaneGraphics(data);
     });
 
     QObject::connect(posSlider, &QSlider::valueChanged, this, [=](int pct) {
@@ -173,14 +216,14 @@ void WidgetClipPlanes::connectUi(ClipPlaneData* data)
         QSignalBlocker sigBlock(posSpin); Q_UNUSED(sigBlock);
         posSpin->setValue(pos);
         GraphicsUtils::Gpx3dClipPlane_setPosition(gfx, pos);
-        m_view->Redraw();
+        this->updatePlaneGraphics(data);
     });
 
     QObject::connect(ui.inverseBtn(), &QAbstractButton::clicked, this, [=]{
         const gp_Dir invNormal = gfx->ToPlane().Axis().Direction().Reversed();
         GraphicsUtils::Gpx3dClipPlane_setNormal(gfx, invNormal);
         GraphicsUtils::Gpx3dClipPlane_setPosition(gfx, data->ui.posSpin()->value());
-        m_view->Redraw();
+        this->updatePlaneGraphics(data);
     });
 
     // Custom plane normal
@@ -198,7 +241,7 @@ void WidgetClipPlanes::connectUi(ClipPlaneData* data)
                 const auto bbc = BndBoxCoords::get(m_bndBox);
                 this->setPlaneRange(data, MathUtils::planeRange(bbc, normal));
                 GraphicsUtils::Gpx3dClipPlane_setNormal(gfx, normal);
-                m_view->Redraw();
+                this->updatePlaneGraphics(data);
             }
         });
     };
@@ -248,6 +291,67 @@ void WidgetClipPlanes::setPlaneRange(ClipPlaneData* data, const Range& range)
     }
 }
 
+void WidgetClipPlanes::updateCapping(ClipPlaneData* data)
+{
+    const auto appModule = AppModule::get(Application::instance());
+    const Handle_Graphic3d_ClipPlane& capping = data->capping;
+    capping->SetEquation(data->graphics->GetEquation());
+    capping->SetOn(true);
+    if (!data->graphics->IsOn() || !appModule->clipPlanesCappingOn.value()) {
+        this->clearCapping(data);
+        return;
+    }
+
+    // Reduced pass while dragging: objects keep the capping plane, but no capping is drawn
+    capping->SetCapping(!data->isDragging);
+    if (data->isDragging)
+        return;
+
+    // Objects whose bounding box is fully on one side of the plane don't need capping
+    const gp_Pln plane = capping->ToPlane();
+    std::vector<GraphicsObjectPtr> vecCappedObject;
+    m_gfxScene->foreachDisplayedObject([&](const GraphicsObjectPtr& object) {
+        if (!m_gfxScene->isObjectClipPlaneSensitive(object))
+            return;
+
+        const Bnd_Box bndBox = GraphicsUtils::AisObject_boundingBox(object);
+        if (!bndBox.IsVoid() && !bndBox.IsOut(plane))
+            vecCappedObject.push_back(object);
+    });
+
+    auto fnLess = [](const GraphicsObjectPtr& lhs, const GraphicsObjectPtr& rhs) {
+        return lhs.get() < rhs.get();
+    };
+    std::sort(vecCappedObject.begin(), vecCappedObject.end(), fnLess);
+    std::vector<GraphicsObjectPtr>& vecPrevCappedObject = data->vecCappedObject;
+    // Both vectors are sorted, so assignment changes are found with binary searches
+    for (const GraphicsObjectPtr& object : vecPrevCappedObject) {
+        if (!std::binary_search(vecCappedObject.cbegin(), vecCappedObject.cend(), object, fnLess))
+            object->RemoveClipPlane(capping);
+    }
+
+    for (const GraphicsObjectPtr& object : vecCappedObject) {
+        if (!std::binary_search(vecPrevCappedObject.cbegin(), vecPrevCappedObject.cend(), object, fnLess))
+            object->AddClipPlane(capping);
+    }
+
+    vecPrevCappedObject = std::move(vecCappedObject);
+}
+
+void WidgetClipPlanes::clearCapping(ClipPlaneData* data)
+{
+    for (const GraphicsObjectPtr& object : data->vecCappedObject)
+        object->RemoveClipPlane(data->capping);
+
+    data->vecCappedObject.clear();
+}
+
+void WidgetClipPlanes::updatePlaneGraphics(ClipPlaneData* data)
+{
+    this->updateCapping(data);
+    m_gfxScene->redraw();
+}
+
 void WidgetClipPlanes::createPlaneCappingTexture()
 {
     if (!m_textureCapping.IsNull())
@@ -271,6 +375,65 @@ void WidgetClipPlanes::createPlaneCappingTexture()
 #endif
 }
 
+void WidgetClipPlanes::exportSection()
+{
+    auto itData = std::find_if(m_vecClipPlaneData.cbegin(), m_vecClipPlaneData.cend(), [](const ClipPlaneData& data) {
+        return data.ui.check_On->isChecked();
+    });
+    if (itData == m_vecClipPlaneData.cend())
+        return;
+
+    const QString strFilepath = QFileDialog::getSaveFileName(
+                this,
+                tr("Select Output File"),
+                QString(),
+                tr("SVG files(*.svg);;DXF files(*.dxf)"));
+    if (strFilepath.isEmpty())
+        return;
+
+    // Visible parts whose box is crossed by the plane, ie not fully on one side of it
+    const gp_Pln plane = itData->graphics->ToPlane();
+    gp_Pln planeReversed = plane;
+    planeReversed.SetAxis(plane.Axis().Reversed());
+    const gp_Pln planes[] = { plane, planeReversed };
+    std::vector<TreeNodeId> vecPartId = m_guiDoc->partBvh().findInFrustum(planes);
+    auto itEnd = std::remove_if(vecPartId.begin(), vecPartId.end(), [=](TreeNodeId partId) {
+        return m_guiDoc->nodeVisibleState(partId) == Qt::Unchecked;
+    });
+    vecPartId.erase(itEnd, vecPartId.end());
+
+    auto taskMgr = TaskManager::globalInstance();
+    const DocumentPtr doc = m_guiDoc->document();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        auto messenger = MessengerQtSignal::defaultInstance();
+        std::vector<CrossSection::PartSection> vecSection;
+        {
+            std::lock_guard<std::mutex> lock(doc->dataMutex()); MAYO_UNUSED(lock);
+            doc->compactTriangulations().expandAll();
+            vecSection = CrossSection::compute(doc, vecPartId, plane, {}, progress);
+        }
+
+        if (progress->isAbortRequested())
+            return;
+
+        if (!CrossSection::writeFile(filepathFrom(strFilepath), plane, vecSection))
+            messenger->emitError(tr("Failed to write section file '%1'").arg(strFilepath));
+        else
+            messenger->emitInfo(tr("Section of %1 parts exported").arg(int(vecSection.size())));
+    });
+    taskMgr->setTitle(taskId, tr("Export section") + " - " + QFileInfo(strFilepath).fileName());
+    taskMgr->run(taskId);
+}
+
+void WidgetClipPlanes::updateExportSectionEnabled()
+{
+    const bool hasActivePlane = std::any_of(
+                m_vecClipPlaneData.cbegin(), m_vecClipPlaneData.cend(), [](const ClipPlaneData& data) {
+        return data.ui.check_On->isChecked();
+    });
+    m_ui->btn_ExportSection->setEnabled(hasActivePlane);
+}
+
 WidgetClipPlanes::UiClipPlane::UiClipPlane(QCheckBox* checkOn, QWidget* widgetControl)
     : check_On(checkOn), widget_Control(widgetControl)
 { }
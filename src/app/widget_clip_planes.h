@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include "../graphics/graphics_object_ptr.h"
+
 #include <QtWidgets/QWidget>
 #include <Bnd_Box.hxx>
 #include <Graphic3d_ClipPlane.hxx>
@@ -19,10 +21,13 @@ class QAbstractButton;
 
 namespace Mayo {
 
+class GraphicsScene;
+class GuiDocument;
+
 class WidgetClipPlanes : public QWidget {
     Q_OBJECT
 public:
-    WidgetClipPlanes(const Handle_V3d_View& view3d, QWidget* parent = nullptr);
+    WidgetClipPlanes(GuiDocument* guiDoc, QWidget* parent = nullptr);
     ~WidgetClipPlanes();
 
     void setRanges(const Bnd_Box& box);
@@ -45,8 +50,12 @@ private:
     };
 
     struct ClipPlaneData {
-        Handle_Graphic3d_ClipPlane graphics;
+        Handle_Graphic3d_ClipPlane graphics; // Added to the view, clipping only
         UiClipPlane ui;
+        // Same plane with capping enabled, added only to the objects the plane actually crosses
+        Handle_Graphic3d_ClipPlane capping;
+        std::vector<GraphicsObjectPtr> vecCappedObject;
+        bool isDragging = false;
     };
 
     using Range = std::pair<double, double>;
@@ -56,10 +65,22 @@ private:
     void setPlaneOn(const Handle_Graphic3d_ClipPlane& plane, bool on);
     void setPlaneRange(ClipPlaneData* data, const Range& range);
 
+    // Synchronizes capping plane with clipping plane and assigns it to the crossed objects
+    // While the plane slider is dragged, capping is turned off to keep interaction fast
+    void updateCapping(ClipPlaneData* data);
+    void clearCapping(ClipPlaneData* data);
+    void updatePlaneGraphics(ClipPlaneData* data); // Capping update and redraw
+
     void createPlaneCappingTexture();
 
+    // Exports in a background task the section of the visible parts by the first active plane
+    void exportSection();
+    void updateExportSectionEnabled();
+
     class Ui_WidgetClipPlanes* m_ui;
+    GuiDocument* m_guiDoc = nullptr;
     Handle_V3d_View m_view;
+    GraphicsScene* m_gfxScene = nullptr;
     std::vector<ClipPlaneData> m_vecClipPlaneData;
     Bnd_Box m_bndBox;
     Handle_Graphic3d_TextureMap m_textureCapping;
@@ -18,6 +18,13 @@ WidgetExplodeAssembly::WidgetExplodeAssembly(GuiDocument* guiDoc, QWidget* paren
       m_guiDoc(guiDoc)
 {
     m_ui->setupUi(this);
+    m_ui->combo_Mode->setCurrentIndex(
+                m_guiDoc->explodingMode() == GuiDocument::ExplodingMode::Hierarchical ? 1 : 0);
+
+    QObject::connect(m_ui->combo_Mode, qOverload<int>(&QComboBox::currentIndexChanged), this, [=](int index) {
+        m_guiDoc->setExplodingMode(
+                    index == 1 ? GuiDocument::ExplodingMode::Hierarchical : GuiDocument::ExplodingMode::Flat);
+    });
 
     QObject::connect(m_ui->slider_Factor, &QSlider::valueChanged, this, [=](int pct) {
         QSignalBlocker sigBlock(m_ui->edit_Factor);
@@ -6,9 +6,11 @@
 
 #include "widget_file_system.h"
 
+#include "../base/filepath.h"
+#include "../base/io_system.h"
 #include "../base/string_utils.h"
+#include "../base/task_progress.h"
 
-#include <QtCore/QDateTime>
 #include <QtCore/QDir>
 #include <QtCore/QFileInfo>
 #include <QtWidgets/QBoxLayout>
@@ -23,6 +25,10 @@ static QString absolutePath(const QFileInfo& fi)
     return fi.isDir() ? fi.absoluteFilePath() : fi.absolutePath();
 }
 
+// Count of entries listed(or probed) before they are handed over to the GUI thread
+static const size_t ListingChunkSize = 256;
+static const size_t ProbingChunkSize = 32;
+
 } // namespace Internal
 
 WidgetFileSystem::WidgetFileSystem(QWidget* parent)
@@ -41,6 +47,14 @@ WidgetFileSystem::WidgetFileSystem(QWidget* parent)
     QObject::connect(
                 m_treeWidget, &QTreeWidget::itemActivated,
                 this, &WidgetFileSystem::onTreeItemActivated);
+
+    // Bounded budget of threads, so listing and probing don't saturate the file system
+    m_taskMgr.setPoolSize(2);
+}
+
+WidgetFileSystem::~WidgetFileSystem()
+{
+    this->abortPendingTasks();
 }
 
 QFileInfo WidgetFileSystem::currentLocation() const
@@ -63,40 +77,204 @@ void WidgetFileSystem::setLocation(const QFileInfo& fiLoc)
         }
     }
     else {
+        this->abortPendingTasks();
         m_treeWidget->clear();
-        QTreeWidgetItem* itemToBeSelected = nullptr;
-        QList<QTreeWidgetItem*> listItem;
-        if (fiLoc.exists()) {
+        m_treeWidget->headerItem()->setText(0, fiLoc.dir().dirName());
+        m_location = fiLoc; // Used to select the entry once listed
+        const unsigned locationGeneration = ++m_locationGeneration;
+        const TaskId taskId = m_taskMgr.newTask([=](TaskProgress* progress) {
             const QDir dir(pathLoc);
+            if (!dir.exists())
+                return;
+
             const QFileInfoList listEntryFileInfo =
                     dir.entryInfoList(
                         QDir::Files | QDir::AllDirs | QDir::NoDot,
                         QDir::DirsFirst);
+            // Size and last modification time require a stat() call per entry, slow on network
+            // shares, so entries are handed over by chunks
+            std::vector<Entry> vecEntry;
             for (const QFileInfo& fi : listEntryFileInfo) {
-                auto item = new QTreeWidgetItem;
-                if (fi.fileName() != QLatin1String(".")) {
-                    item->setText(0, fi.fileName());
-                    item->setIcon(0, m_fileIconProvider.icon(fi));
-                    const QString itemTooltip =
-                            tr("%1\nSize: %2\nLast modified: %3")
-                            .arg(QDir::toNativeSeparators(fi.absoluteFilePath()))
-                            .arg(StringUtils::bytesText(fi.size()))
-                            .arg(fi.lastModified().toString(Qt::SystemLocaleShortDate));
-                    item->setToolTip(0, itemTooltip);
-                    if (fi.fileName() == fiLoc.fileName())
-                        itemToBeSelected = item;
+                if (progress->isAbortRequested())
+                    return;
+
+                vecEntry.push_back({ fi.fileName(), fi.absoluteFilePath(), fi.isDir(), fi.size(), fi.lastModified() });
+                if (vecEntry.size() >= Internal::ListingChunkSize) {
+                    QMetaObject::invokeMethod(this, [=]{
+                        this->addEntries(locationGeneration, vecEntry, false);
+                    }, Qt::QueuedConnection);
+                    vecEntry.clear();
                 }
-                listItem.push_back(item);
             }
-        }
-        m_treeWidget->addTopLevelItems(listItem);
-        m_treeWidget->headerItem()->setText(0, fiLoc.dir().dirName());
-        if (itemToBeSelected != nullptr)
-            itemToBeSelected->setSelected(true);
+
+            QMetaObject::invokeMethod(this, [=]{
+                this->addEntries(locationGeneration, vecEntry, true);
+            }, Qt::QueuedConnection);
+        });
+        m_vecTaskId.push_back(taskId);
+        m_taskMgr.run(taskId);
     }
+
     m_location = fiLoc;
 }
 
+void WidgetFileSystem::setIoSystem(const IO::System* ioSystem)
+{
+    m_ioSystem = ioSystem;
+}
+
+void WidgetFileSystem::abortPendingTasks()
+{
+    for (TaskId taskId : m_vecTaskId)
+        m_taskMgr.requestAbort(taskId);
+
+    m_vecTaskId.clear();
+}
+
+void WidgetFileSystem::addEntries(
+        unsigned locationGeneration, const std::vector<Entry>& vecEntry, bool isListingDone)
+{
+    if (locationGeneration != m_locationGeneration)
+        return; // Location changed meanwhile
+
+    QTreeWidgetItem* itemToBeSelected = nullptr;
+    QList<QTreeWidgetItem*> listItem;
+    for (const Entry& entry : vecEntry) {
+        auto item = new QTreeWidgetItem;
+        item->setText(0, entry.fileName);
+        // Icon from the type of entry, the file system isn't accessed in the GUI thread
+        item->setIcon(0, m_fileIconProvider.icon(entry.isDir ? QFileIconProvider::Folder : QFileIconProvider::File));
+        if (entry.fileName != QLatin1String("..")) {
+            const QString itemTooltip =
+                    tr("%1\nSize: %2\nLast modified: %3")
+                    .arg(QDir::toNativeSeparators(entry.absoluteFilePath))
+                    .arg(StringUtils::bytesText(entry.size))
+                    .arg(entry.lastModified.toString(Qt::SystemLocaleShortDate));
+            item->setToolTip(0, itemTooltip);
+            if (!entry.isDir)
+                item->setData(0, Qt::UserRole, entry.absoluteFilePath);
+
+            if (entry.fileName == m_location.fileName())
+                itemToBeSelected = item;
+        }
+
+        listItem.push_back(item);
+    }
+
+    m_treeWidget->addTopLevelItems(listItem);
+    if (itemToBeSelected != nullptr)
+        itemToBeSelected->setSelected(true);
+
+    if (isListingDone && m_ioSystem)
+        this->startFormatProbing();
+}
+
+void WidgetFileSystem::startFormatProbing()
+{
+    std::vector<std::pair<int, QString>> vecFileItem;
+    for (int i = 0; i < m_treeWidget->topLevelItemCount(); ++i) {
+        const QVariant filepath = m_treeWidget->topLevelItem(i)->data(0, Qt::UserRole);
+        if (filepath.isValid())
+            vecFileItem.push_back({ i, filepath.toString() });
+    }
+
+    const IO::System* ioSystem = m_ioSystem;
+    const unsigned locationGeneration = m_locationGeneration;
+    const TaskId taskId = m_taskMgr.newTask([=](TaskProgress* progress) {
+        std::vector<EntryFormat> vecEntryFormat;
+        for (const auto& [index, filepath] : vecFileItem) {
+            if (progress->isAbortRequested())
+                return;
+
+            vecEntryFormat.push_back({ index, ioSystem->probeFormat(filepathFrom(filepath)) });
+            if (vecEntryFormat.size() >= Internal::ProbingChunkSize || index == vecFileItem.back().first) {
+                QMetaObject::invokeMethod(this, [=]{
+                    this->setEntryFormats(locationGeneration, vecEntryFormat);
+                }, Qt::QueuedConnection);
+                vecEntryFormat.clear();
+            }
+        }
+
+        // Metadata scans may read whole files(eg entity count of STEP files), so they come after
+        // all formats are known and each result is handed over as soon as available
+        for (const auto& [index, filepath] : vecFileItem) {
+            if (progress->isAbortRequested())
+                return;
+
+            const std::optional<IO::System::FileMetadata> metadata = ioSystem->scanMetadata(filepathFrom(filepath));
+            if (metadata) {
+                const EntryMetadata entryMetadata = { index, metadata.value() };
+                QMetaObject::invokeMethod(this, [=]{
+                    this->setEntryMetadata(locationGeneration, entryMetadata);
+                }, Qt::QueuedConnection);
+            }
+        }
+    }, TaskPriority::Background);
+    m_vecTaskId.push_back(taskId);
+    m_taskMgr.run(taskId);
+}
+
+void WidgetFileSystem::setEntryFormats(
+        unsigned locationGeneration, const std::vector<EntryFormat>& vecEntryFormat)
+{
+    if (locationGeneration != m_locationGeneration)
+        return; // Location changed meanwhile
+
+    const QColor unsupportedColor = this->palette().color(QPalette::Disabled, QPalette::Text);
+    for (const auto& [index, format] : vecEntryFormat) {
+        QTreeWidgetItem* item = m_treeWidget->topLevelItem(index);
+        if (!item)
+            continue;
+
+        const bool isSupported = format != IO::Format_Unknown && m_ioSystem->findFactoryReader(format);
+        if (isSupported)
+            item->setToolTip(0, item->toolTip(0) + tr("\nFormat: %1").arg(format.name));
+        else
+            item->setForeground(0, unsupportedColor);
+    }
+}
+
+void WidgetFileSystem::setEntryMetadata(unsigned locationGeneration, const EntryMetadata& entryMetadata)
+{
+    if (locationGeneration != m_locationGeneration)
+        return; // Location changed meanwhile
+
+    QTreeWidgetItem* item = m_treeWidget->topLevelItem(entryMetadata.first);
+    if (item)
+        item->setToolTip(0, item->toolTip(0) + "\n" + WidgetFileSystem::fileMetadataText(entryMetadata.second));
+}
+
+QString WidgetFileSystem::fileMetadataText(const IO::System::FileMetadata& metadata)
+{
+    QStringList listLine;
+    auto fnAddLine = [&](const QString& label, const QString& value) {
+        if (!value.trimmed().isEmpty())
+            listLine.push_back(label.arg(value.trimmed()));
+    };
+    fnAddLine(tr("Name: %1"), metadata.name);
+    fnAddLine(tr("Description: %1"), metadata.description);
+    fnAddLine(tr("Schema: %1"), metadata.schemas.join(", "));
+    fnAddLine(tr("Authoring system: %1"), metadata.authoringSystem);
+    fnAddLine(tr("Preprocessor: %1"), metadata.preprocessorVersion);
+    fnAddLine(tr("Author: %1"), metadata.author);
+    fnAddLine(tr("Organization: %1"), metadata.organization);
+    fnAddLine(tr("Timestamp: %1"), metadata.timestamp);
+    if (metadata.entityCount >= 0)
+        fnAddLine(tr("Entities: %1"), QString::number(metadata.entityCount));
+
+    if (!metadata.productNames.empty()) {
+        // Assemblies may have thousands of products, only the first ones are listed
+        constexpr int maxProductCount = 5;
+        QString strProducts = metadata.productNames.mid(0, maxProductCount).join(", ");
+        if (metadata.productNames.size() > maxProductCount)
+            strProducts += tr(" (+%1 more)").arg(metadata.productNames.size() - maxProductCount);
+
+        fnAddLine(tr("Products: %1"), strProducts);
+    }
+
+    return listLine.join('\n');
+}
+
 void WidgetFileSystem::onTreeItemActivated(QTreeWidgetItem* item, int column)
 {
     if (item != nullptr && column == 0) {
@@ -6,31 +6,71 @@
 
 #pragma once
 
+#include "../base/io_system.h"
+#include "../base/task_manager.h"
+
+#include <QtCore/QDateTime>
 #include <QtCore/QFileInfo>
 #include <QtWidgets/QWidget>
 #include <QtWidgets/QFileIconProvider>
+#include <utility>
+#include <vector>
 class QTreeWidget;
 class QTreeWidgetItem;
 
 namespace Mayo {
 
+// Lists the entries of a directory, the location being typically the one of the current document
+// Directories are listed in background and entries are added by chunks, so slow file systems(eg
+// network shares) don't freeze the UI
 class WidgetFileSystem : public QWidget {
     Q_OBJECT
 public:
     WidgetFileSystem(QWidget* parent = nullptr);
+    ~WidgetFileSystem();
 
     QFileInfo currentLocation() const;
     void setLocation(const QFileInfo& fiLoc);
 
+    // I/O system used to probe the format of the files once listed, this is done in background as
+    // well. Files whose format isn't supported by any reader are greyed out
+    // Metadata of supported files(see IO::System::scanMetadata()) are then added to tooltips
+    // No probing if null(default)
+    void setIoSystem(const IO::System* ioSystem);
+
+    // Multi-line text of 'metadata', fields not provided are skipped
+    static QString fileMetadataText(const IO::System::FileMetadata& metadata);
+
 signals:
     void locationActivated(const QFileInfo& loc);
 
 private:
+    struct Entry {
+        QString fileName;
+        QString absoluteFilePath;
+        bool isDir;
+        qint64 size;
+        QDateTime lastModified;
+    };
+    using EntryFormat = std::pair<int, IO::Format>; // Index of item and format of its file
+    using EntryMetadata = std::pair<int, IO::System::FileMetadata>;
+
     void onTreeItemActivated(QTreeWidgetItem* item, int column);
+    void abortPendingTasks();
+    void addEntries(unsigned locationGeneration, const std::vector<Entry>& vecEntry, bool isListingDone);
+    void startFormatProbing();
+    void setEntryFormats(unsigned locationGeneration, const std::vector<EntryFormat>& vecEntryFormat);
+    void setEntryMetadata(unsigned locationGeneration, const EntryMetadata& entryMetadata);
 
     QTreeWidget* m_treeWidget = nullptr;
     QFileInfo m_location;
     QFileIconProvider m_fileIconProvider;
+    const IO::System* m_ioSystem = nullptr;
+    // Tasks of previous locations are aborted, results they still deliver are discarded thanks to
+    // the generation number of the location
+    TaskManager m_taskMgr;
+    std::vector<TaskId> m_vecTaskId;
+    unsigned m_locationGeneration = 0;
 };
 
 } // namespace Mayo
@@ -9,6 +9,7 @@
 #include "../graphics/graphics_utils.h"
 #include "../graphics/v3d_view_camera_animation.h"
 #include "../gui/gui_document.h"
+#include "../gui/qtgui_utils.h"
 #include "button_flat.h"
 #include "theme.h"
 #include "widget_clip_planes.h"
@@ -18,9 +19,11 @@
 #include "widgets_utils.h"
 
 #include <QtCore/QtDebug>
+#include <QtCore/QTimer>
 #include <QtGui/QPainter>
 #include <QtGui/QGuiApplication>
 #include <QtWidgets/QBoxLayout>
+#include <QtWidgets/QGridLayout>
 #include <QtWidgets/QMenu>
 #include <QtWidgets/QProxyStyle>
 #include <QtWidgets/QWidgetAction>
@@ -83,9 +86,10 @@ WidgetGuiDocument::WidgetGuiDocument(GuiDocument* guiDoc, QWidget* parent)
       m_controller(new WidgetOccViewController(m_qtOccView))
 {
     {
-        auto layout = new QVBoxLayout;
+        auto layout = new QGridLayout;
         layout->setContentsMargins(0, 0, 0, 0);
-        layout->addWidget(m_qtOccView);
+        layout->setSpacing(2);
+        layout->addWidget(m_qtOccView, 0, 0);
         this->setLayout(layout);
     }
 
@@ -94,6 +98,8 @@ WidgetGuiDocument::WidgetGuiDocument(GuiDocument* guiDoc, QWidget* parent)
     m_btnEditClipping->setCheckable(true);
     m_btnExplode = Internal::createViewBtn(this, Theme::Icon::Multiple, tr("Explode assemblies"));
     m_btnExplode->setCheckable(true);
+    m_btnSplitViews = Internal::createViewBtn(this, Theme::Icon::SplitViews, tr("Split views"));
+    m_btnSplitViews->setCheckable(true);
 
     QObject::connect(m_btnFitAll, &ButtonFlat::clicked, this, [=]{
         m_guiDoc->runViewCameraAnimation(&GraphicsUtils::V3dView_fitAll);
@@ -104,6 +110,9 @@ WidgetGuiDocument::WidgetGuiDocument(GuiDocument* guiDoc, QWidget* parent)
     QObject::connect(
                 m_btnExplode, &ButtonFlat::checked,
                 this, &WidgetGuiDocument::toggleWidgetExplode);
+    QObject::connect(
+                m_btnSplitViews, &ButtonFlat::checked,
+                this, &WidgetGuiDocument::toggleSplitViews);
     QObject::connect(
                 m_controller, &V3dViewController::dynamicActionStarted,
                 m_guiDoc, &GuiDocument::stopViewCameraAnimation);
@@ -117,6 +126,11 @@ WidgetGuiDocument::WidgetGuiDocument(GuiDocument* guiDoc, QWidget* parent)
                 m_guiDoc->graphicsScene()->select();
         }
     });
+    QObject::connect(
+                m_controller, &V3dViewController::rubberBandSelectionRequested,
+                this, [=](const QPoint& posStart, const QPoint& posEnd) {
+        m_guiDoc->graphicsScene()->selectInRect(posStart, posEnd, m_guiDoc->v3dView());
+    });
     QObject::connect(m_controller, &WidgetOccViewController::multiSelectionToggled, this, [=](bool on) {
         m_guiDoc->graphicsScene()->setSelectionMode(
                     on ? GraphicsScene::SelectionMode::Multi : GraphicsScene::SelectionMode::Single);
@@ -125,6 +139,7 @@ WidgetGuiDocument::WidgetGuiDocument(GuiDocument* guiDoc, QWidget* parent)
                 m_guiDoc, &GuiDocument::viewTrihedronModeChanged,
                 this, &WidgetGuiDocument::recreateViewControls);
 
+    m_guiDoc->graphicsScene()->setRedrawInterval(QtGuiUtils::screenFrameInterval());
     this->recreateViewControls();
 }
 
@@ -150,7 +165,7 @@ void WidgetGuiDocument::toggleWidgetClipPlanes(bool on)
     if (!m_widgetClipPlanes) {
         if (on) {
             auto panel = new Internal::PanelView3d(this);
-            auto widget = new WidgetClipPlanes(m_guiDoc->v3dView(), panel);
+            auto widget = new WidgetClipPlanes(m_guiDoc, panel);
             WidgetsUtils::addContentsWidget(panel, widget);
             panel->show();
             panel->adjustSize();
@@ -194,6 +209,76 @@ void WidgetGuiDocument::toggleWidgetExplode(bool on)
         m_btnEditClipping->setChecked(false);
 }
 
+void WidgetGuiDocument::toggleSplitViews(bool on)
+{
+    if (on == !m_vecSecondaryView.empty())
+        return;
+
+    auto gridLayout = static_cast<QGridLayout*>(this->layout());
+    if (on) {
+        struct ViewCreationData {
+            V3d_TypeOfOrientation proj;
+            int row;
+            int column;
+        };
+        const ViewCreationData viewCreationData[] = {
+            { V3d_Zpos, 0, 1 }, // Top
+            { V3d_Yneg, 1, 0 }, // Front
+            { V3d_Xpos, 1, 1 }  // Right
+        };
+        GraphicsScene* gfxScene = m_guiDoc->graphicsScene();
+        for (const ViewCreationData& viewData : viewCreationData) {
+            const Handle_V3d_View view = m_guiDoc->createSecondaryV3dView(viewData.proj);
+            auto widget = new WidgetOccView(view, this);
+            auto controller = new WidgetOccViewController(widget);
+            gridLayout->addWidget(widget, viewData.row, viewData.column);
+            QObject::connect(controller, &V3dViewController::mouseMoved, this, [=](const QPoint& pos) {
+                gfxScene->highlightAt(pos, view);
+            });
+            // Actions(eg view cube clicks) are bound to the main view, only selection is done
+            QObject::connect(controller, &V3dViewController::mouseClicked, this, [=](Qt::MouseButton btn) {
+                if (btn == Qt::MouseButton::LeftButton)
+                    gfxScene->select();
+            });
+            QObject::connect(
+                        controller, &V3dViewController::rubberBandSelectionRequested,
+                        this, [=](const QPoint& posStart, const QPoint& posEnd) {
+                gfxScene->selectInRect(posStart, posEnd, view);
+            });
+            QObject::connect(controller, &WidgetOccViewController::multiSelectionToggled, this, [=](bool on) {
+                gfxScene->setSelectionMode(
+                            on ? GraphicsScene::SelectionMode::Multi : GraphicsScene::SelectionMode::Single);
+            });
+            m_vecSecondaryView.push_back({ widget, controller });
+        }
+
+        // View window is created when the widget gets shown
+        QTimer::singleShot(0, this, [=]{
+            for (const SecondaryView& secondaryView : m_vecSecondaryView) {
+                if (!secondaryView.widget->v3dView()->Window().IsNull())
+                    GraphicsUtils::V3dView_fitAll(secondaryView.widget->v3dView());
+            }
+
+            gfxScene->redraw();
+        });
+    }
+    else {
+        for (const SecondaryView& secondaryView : m_vecSecondaryView) {
+            gridLayout->removeWidget(secondaryView.widget);
+            m_guiDoc->destroySecondaryV3dView(secondaryView.widget->v3dView());
+            delete secondaryView.controller;
+            delete secondaryView.widget;
+        }
+
+        m_vecSecondaryView.clear();
+    }
+
+    gridLayout->activate();
+    this->layoutViewControls();
+    this->layoutWidgetPanel(m_widgetClipPlanes);
+    this->layoutWidgetPanel(m_widgetExplodeAsm);
+}
+
 void WidgetGuiDocument::layoutWidgetPanel(QWidget* panel)
 {
     auto fnPanelPos = [=](QWidget* panel) -> QPoint {
@@ -205,12 +290,12 @@ void WidgetGuiDocument::layoutWidgetPanel(QWidget* panel)
         case Qt::TopLeftCorner:
             return QPoint(margin, this->viewControlsRect().bottom() + margin);
         case Qt::TopRightCorner:
-            return QPoint(this->width() - panel->width(),
+            return QPoint(m_qtOccView->width() - panel->width(),
                           this->viewControlsRect().bottom() + margin);
         case Qt::BottomLeftCorner:
             return QPoint(margin, this->viewControlsRect().top() - panel->height() - margin);
         case Qt::BottomRightCorner:
-            return QPoint(this->width() - panel->width(),
+            return QPoint(m_qtOccView->width() - panel->width(),
                           this->viewControlsRect().top() - panel->height() - margin);
         } // endswitch
 
@@ -295,7 +380,7 @@ void WidgetGuiDocument::recreateViewControls()
 QRect WidgetGuiDocument::viewControlsRect() const
 {
     const QRect rectFirstBtn = m_btnFitAll->frameGeometry();
-    const QRect rectLastBtn = m_btnExplode->frameGeometry();
+    const QRect rectLastBtn = m_btnSplitViews->frameGeometry();
     QRect rect;
     rect.setCoords(
                 rectFirstBtn.left(), rectFirstBtn.top(),
@@ -310,20 +395,23 @@ void WidgetGuiDocument::layoutViewControls()
         if (m_guiDoc->viewTrihedronMode() == GuiDocument::ViewTrihedronMode::AisViewCube) {
             const int btnSize = m_btnFitAll->width();
             const int viewCubeBndSize = m_guiDoc->aisViewCubeBoundingSize();
-            const int ctrlCount = 2 + m_vecWidgetForViewProj.size();
+            const int ctrlCount = 3 + m_vecWidgetForViewProj.size();
             const int ctrlWidth = ctrlCount * btnSize + (ctrlCount - 1) * margin;
             const int ctrlHeight = btnSize;
             const int ctrlXOffset = (viewCubeBndSize - ctrlWidth) / 2;
+            // View cube is drawn in the corner of the main view, not of the split views area
+            const int viewWidth = m_qtOccView->width();
+            const int viewHeight = m_qtOccView->height();
             switch (m_guiDoc->viewTrihedronCorner()) {
             case Qt::TopLeftCorner:
                 return { ctrlXOffset, viewCubeBndSize + margin };
             case Qt::TopRightCorner:
-                return { this->width() - viewCubeBndSize + ctrlXOffset, viewCubeBndSize + margin };
+                return { viewWidth - viewCubeBndSize + ctrlXOffset, viewCubeBndSize + margin };
             case Qt::BottomLeftCorner:
-                return { ctrlXOffset, this->height() - viewCubeBndSize - margin - ctrlHeight };
+                return { ctrlXOffset, viewHeight - viewCubeBndSize - margin - ctrlHeight };
             case Qt::BottomRightCorner:
-                return { this->width() - viewCubeBndSize + ctrlXOffset,
-                         this->height() - viewCubeBndSize - margin - ctrlHeight };
+                return { viewWidth - viewCubeBndSize + ctrlXOffset,
+                         viewHeight - viewCubeBndSize - margin - ctrlHeight };
             } // endswitch
         }
 
@@ -339,6 +427,7 @@ void WidgetGuiDocument::layoutViewControls()
 
     WidgetsUtils::moveWidgetRightTo(m_btnEditClipping, widgetLast, margin);
     WidgetsUtils::moveWidgetRightTo(m_btnExplode, m_btnEditClipping, margin);
+    WidgetsUtils::moveWidgetRightTo(m_btnSplitViews, m_btnExplode, margin);
 }
 
 } // namespace Mayo
@@ -35,6 +35,8 @@ protected:
 private:
     void toggleWidgetClipPlanes(bool on);
     void toggleWidgetExplode(bool on);
+    // 2x2 layout: main view with top, front and right secondary views sharing its graphics scene
+    void toggleSplitViews(bool on);
 
     void recreateViewControls();
     QRect viewControlsRect() const;
@@ -44,6 +46,11 @@ private:
     GuiDocument* m_guiDoc = nullptr;
     WidgetOccView* m_qtOccView = nullptr;
     WidgetOccViewController* m_controller = nullptr;
+    struct SecondaryView {
+        WidgetOccView* widget = nullptr;
+        WidgetOccViewController* controller = nullptr;
+    };
+    std::vector<SecondaryView> m_vecSecondaryView;
     WidgetClipPlanes* m_widgetClipPlanes = nullptr;
     WidgetExplodeAssembly* m_widgetExplodeAsm = nullptr;
     QRect m_rectControls;
@@ -51,6 +58,7 @@ private:
     ButtonFlat* m_btnFitAll = nullptr;
     ButtonFlat* m_btnEditClipping = nullptr;
     ButtonFlat* m_btnExplode = nullptr;
+    ButtonFlat* m_btnSplitViews = nullptr;
     std::vector<QWidget*> m_vecWidgetForViewProj;
 };
 
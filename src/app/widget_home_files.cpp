@@ -9,18 +9,24 @@
 #include "../base/application.h"
 #include "../base/settings.h"
 #include "../base/string_utils.h"
+#include "../base/task_manager.h"
 #include "../gui/gui_application.h"
 #include "../gui/gui_document.h"
 #include "app_module.h"
 #include "theme.h"
+#include "widget_file_system.h"
 
 #include <QtCore/QtDebug>
 #include <QtCore/QDir>
 #include <QtCore/QFileInfo>
+#include <QtCore/QTimer>
 #include <QtGui/QPixmapCache>
 #include <QtWidgets/QFileIconProvider>
 #include <QtWidgets/QVBoxLayout>
 #include <algorithm>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
 
 namespace Mayo {
 
@@ -28,8 +34,11 @@ namespace {
 
 struct HomeFileItem : public ListHelper::ModelItem {
     enum class Type { None, New, Open, RecentFile };
+    // State of the file system query of a recent file, see HomeFilesModel::startFileInfoQueries()
+    enum class FileStatus { Pending, Available, NotFound, TimedOut };
     Type type = Type::None;
     FilePath filepath;
+    FileStatus fileStatus = FileStatus::Pending;
 };
 
 class HomeFilesModel : public ListHelper::Model {
@@ -62,6 +71,36 @@ public:
             storage->m_items.push_back(std::move(item));
         }
 
+        // File system queries may hang(eg unreachable network drive), a few workers are enough
+        // as each query is then bounded by a timeout
+        m_taskMgr.setPoolSize(4);
+        QObject::connect(&m_taskMgr, &TaskManager::started, this, [=](TaskId taskId) {
+            auto it = m_mapTaskFilepath.find(taskId);
+            if (it == m_mapTaskFilepath.end())
+                return;
+
+            // Timeout is counted from the start of the query, not while it's waiting in the queue
+            const FilePath fp = it->second;
+            m_mapTaskFilepath.erase(it);
+            QTimer::singleShot(FileInfoTimeout_ms, this, [=]{
+                const int row = this->findRecentFileRow(fp);
+                if (row >= 0 && m_storage->m_items.at(row).fileStatus == HomeFileItem::FileStatus::Pending)
+                    this->setRecentFileItemInfo(row, HomeFileItem::FileStatus::TimedOut, {});
+            });
+        });
+
+        // Speculative reads are not time-critical, one at a time is enough
+        m_prefetchTaskMgr.setPoolSize(1);
+        QObject::connect(&m_prefetchTaskMgr, &TaskManager::ended, this, [=](TaskId taskId) {
+            if (taskId == m_prefetchTaskId)
+                m_prefetchTaskId = 0;
+
+            // Warm reader is released once expired if the file wasn't opened meanwhile
+            IO::System* ioSystem = Application::instance()->ioSystem();
+            const auto delay = ioSystem->prefetchKeepAliveTime() + std::chrono::seconds(1);
+            QTimer::singleShot(delay, this, [=]{ ioSystem->purgeExpiredPrefetches(); });
+        });
+
         this->reloadRecentFiles();
         this->setStorage(std::move(storage));
     }
@@ -82,9 +121,16 @@ public:
         else {
             auto appModule = AppModule::get(Application::instance());
             const RecentFile* recentFile = appModule ? appModule->findRecentFile(filepathFrom(url)) : nullptr;
-            pixmap = recentFile ? recentFile->thumbnail : QPixmap();
+            // Thumbnail is decoded only when the item gets painted for the first time
+            if (recentFile && !recentFile->thumbnailHash.isEmpty()) {
+                const FilePath thumbnailPath =
+                        recentFile->thumbnailFilePath(appModule->recentFileThumbnailCacheDirPath());
+                pixmap.load(filepathTo<QString>(thumbnailPath));
+            }
+
+            // Generic icon, QFileInfo(url) would access the file system from the GUI thread
             if (pixmap.isNull()) {
-                const QIcon icon = m_fileIconProvider.icon(QFileInfo(url));
+                const QIcon icon = m_fileIconProvider.icon(QFileIconProvider::File);
                 pixmap = fnPixmap(icon, 64, 64);
             }
         }
@@ -99,6 +145,37 @@ public:
         this->endResetModel();
     }
 
+    // Recent file item at 'row' whose file was found to exist, null otherwise
+    const HomeFileItem* availableRecentFileItem(int row) const {
+        if (row < 0 || row >= int(m_storage->m_items.size()))
+            return nullptr;
+
+        const HomeFileItem& item = m_storage->m_items.at(row);
+        const bool isAvailable =
+                item.type == HomeFileItem::Type::RecentFile
+                && item.fileStatus == HomeFileItem::FileStatus::Available;
+        return isAvailable ? &item : nullptr;
+    }
+
+    // Reads recent file 'fp' in background, so opening it then only pays for the transfer, see
+    // IO::System::prefetchFile(). Prefetch of another file still running is aborted
+    void startFilePrefetch(const FilePath& fp) {
+        if (m_prefetchTaskId != 0) {
+            if (fp == m_prefetchFilepath)
+                return;
+
+            m_prefetchTaskMgr.requestAbort(m_prefetchTaskId);
+        }
+
+        auto app = Application::instance();
+        const IO::ParametersProvider* parametersProvider = AppModule::get(app);
+        m_prefetchFilepath = fp;
+        m_prefetchTaskId = m_prefetchTaskMgr.newTask([=](TaskProgress* progress) {
+            app->ioSystem()->prefetchFile(fp, parametersProvider, progress);
+        }, TaskPriority::Background);
+        m_prefetchTaskMgr.run(m_prefetchTaskId);
+    }
+
 private:
     void reloadRecentFiles() {
         auto app = Application::instance();
@@ -107,7 +184,101 @@ private:
         if (m_cacheRecentFiles == listRecentFile)
             return;
 
+        // Thumbnails may have changed, drop them so they get loaded again on demand
+        for (const RecentFile& recentFile : m_cacheRecentFiles)
+            QPixmapCache::remove(filepathTo<QString>(recentFile.filepath));
+
         m_storage->m_items.erase(m_storage->m_items.begin() + 2, m_storage->m_items.end());
+        m_mapTaskFilepath.clear();
+        for (const RecentFile& recentFile : listRecentFile) {
+            HomeFileItem item;
+            // Only path strings are used here, file attributes are queried in worker threads
+            const auto fi = filepathTo<QFileInfo>(recentFile.filepath);
+            item.name = fi.fileName();
+            item.type = HomeFileItem::Type::RecentFile;
+            item.textWrapMode = QTextOption::WrapAtWordBoundaryOrAnywhere;
+            item.imageUrl = filepathTo<QString>(recentFile.filepath);
+            item.filepath = recentFile.filepath;
+            item.description = this->recentFileDescription(item, {});
+            m_storage->m_items.push_back(std::move(item));
+        }
+
+        this->startFileInfoQueries();
+        m_cacheRecentFiles = listRecentFile;
+    }
+
+    // Queries file system attributes of all recent files, one task per file
+    // Item descriptions are placeholders until results are received in the GUI thread
+    void startFileInfoQueries() {
+        for (const HomeFileItem& item : m_storage->m_items) {
+            if (item.type != HomeFileItem::Type::RecentFile)
+                continue;
+
+            const FilePath fp = item.filepath;
+            auto future = m_taskMgr.newTaskFuture(
+                        [=](TaskProgress*) { return RecentFile::queryFileInfo(fp); },
+                        {},
+                        TaskPriority::Background
+            );
+            m_mapTaskFilepath.insert({ future.taskId(), fp });
+            m_taskMgr.onReady(future, this, [=](const TaskFuture<RecentFile::FileInfo>& ready) {
+                // Model may have been reloaded meanwhile, item is then looked up again
+                const int row = this->findRecentFileRow(fp);
+                if (row < 0)
+                    return;
+
+                if (ready.hasValue() && ready.value().exists) {
+                    this->setRecentFileItemInfo(row, HomeFileItem::FileStatus::Available, ready.value());
+                    this->startFileMetadataScan(fp);
+                }
+                else {
+                    this->setRecentFileItemInfo(row, HomeFileItem::FileStatus::NotFound, {});
+                }
+            });
+            m_taskMgr.run(future.taskId());
+        }
+    }
+
+    // Metadata(eg STEP header) of an available recent file is shown as the tooltip of its item
+    void startFileMetadataScan(const FilePath& fp) {
+        const IO::System* ioSystem = Application::instance()->ioSystem();
+        auto future = m_taskMgr.newTaskFuture(
+                    [=](TaskProgress*) { return ioSystem->scanMetadata(fp); },
+                    {},
+                    TaskPriority::Background
+        );
+        m_taskMgr.onReady(future, this, [=](const TaskFuture<std::optional<IO::System::FileMetadata>>& ready) {
+            const int row = this->findRecentFileRow(fp);
+            if (row < 0 || !ready.hasValue() || !ready.value())
+                return;
+
+            HomeFileItem& item = m_storage->m_items.at(row);
+            item.toolTip = WidgetFileSystem::fileMetadataText(ready.value().value());
+            const QModelIndex indexItem = this->index(row);
+            emit this->dataChanged(indexItem, indexItem);
+        });
+        m_taskMgr.run(future.taskId());
+    }
+
+    // Late results are still applied: a query that timed out may finally succeed
+    void setRecentFileItemInfo(int row, HomeFileItem::FileStatus status, const RecentFile::FileInfo& info) {
+        HomeFileItem& item = m_storage->m_items.at(row);
+        item.fileStatus = status;
+        item.description = this->recentFileDescription(item, info);
+        const QModelIndex indexItem = this->index(row);
+        emit this->dataChanged(indexItem, indexItem);
+    }
+
+    int findRecentFileRow(const FilePath& fp) const {
+        const auto& items = m_storage->m_items;
+        auto itFound = std::find_if(items.cbegin(), items.cend(), [&](const HomeFileItem& item) {
+            return item.type == HomeFileItem::Type::RecentFile && item.filepath == fp;
+        });
+        return itFound != items.cend() ? int(itFound - items.cbegin()) : -1;
+    }
+
+    QString recentFileDescription(const HomeFileItem& item, const RecentFile::FileInfo& info) const {
+        auto app = Application::instance();
         auto fnToString = [=](const QDateTime& dateTime) {
             const QString strTime = dateTime.time().toString("HH:mm");
             const QDate date = dateTime.date();
@@ -131,41 +302,59 @@ private:
                 return WidgetHomeFiles::tr("%1 %2").arg(strDate, strTime);
             }
         };
-        for (const RecentFile& recentFile : listRecentFile) {
-            HomeFileItem item;
-            const auto fi = filepathTo<QFileInfo>(recentFile.filepath);
-            item.name = fi.fileName();
-            item.type = HomeFileItem::Type::RecentFile;
-            item.description =
-                    WidgetHomeFiles::tr(
+
+        const QString strDirPath = QDir::toNativeSeparators(filepathTo<QFileInfo>(item.filepath).absolutePath());
+        switch (item.fileStatus) {
+        case HomeFileItem::FileStatus::Pending: {
+            const QString strPlaceholder = QStringLiteral("...");
+            return WidgetHomeFiles::tr(
+                        "%1\n\n"
+                        "Size: %2\n\n"
+                        "Created: %2\n"
+                        "Modified: %2\n"
+                        "Read: %2\n")
+                    .arg(strDirPath, strPlaceholder);
+        }
+        case HomeFileItem::FileStatus::NotFound:
+            return WidgetHomeFiles::tr("%1\n\nFile not found").arg(strDirPath);
+        case HomeFileItem::FileStatus::TimedOut:
+            return WidgetHomeFiles::tr("%1\n\nFile not reachable(timeout)").arg(strDirPath);
+        case HomeFileItem::FileStatus::Available:
+            return WidgetHomeFiles::tr(
                         "%1\n\n"
                         "Size: %2\n\n"
                         "Created: %3\n"
                         "Modified: %4\n"
                         "Read: %5\n")
-                    .arg(QDir::toNativeSeparators(fi.absolutePath()))
-                    .arg(StringUtils::bytesText(fi.size(), app->settings()->locale()))
-                    .arg(fnToString(fi.birthTime()))
-                    .arg(fnToString(fi.lastModified()))
-                    .arg(fnToString(fi.lastRead()))
+                    .arg(strDirPath)
+                    .arg(StringUtils::bytesText(info.size, app->settings()->locale()))
+                    .arg(fnToString(info.birthTime))
+                    .arg(fnToString(info.lastModified))
+                    .arg(fnToString(info.lastRead))
                     ;
-            item.textWrapMode = QTextOption::WrapAtWordBoundaryOrAnywhere;
-            item.imageUrl = filepathTo<QString>(recentFile.filepath);
-            item.filepath = recentFile.filepath;
-            m_storage->m_items.push_back(std::move(item));
         }
 
-        m_cacheRecentFiles = listRecentFile;
+        return {};
     }
 
+    static constexpr int FileInfoTimeout_ms = 3000;
     static constexpr const char ImageId_NewDocument[] = "NewDocument_beae5f60-78a5-4b4e-8875-2dcebdbb4c58";
     static constexpr const char ImageId_OpenDocuments[] = "OpenDocuments_945b1913-59fb-4150-9000-f66332f850fe";
 
     QFileIconProvider m_fileIconProvider;
     RecentFiles m_cacheRecentFiles;
     ListHelper::DefaultModelStorage<HomeFileItem>* m_storage = nullptr;
+    TaskManager m_taskMgr;
+    std::unordered_map<TaskId, FilePath> m_mapTaskFilepath; // File queries not yet started
+    TaskManager m_prefetchTaskMgr;
+    TaskId m_prefetchTaskId = 0;
+    FilePath m_prefetchFilepath;
 };
 
+// Delay the mouse must rest on a recent file item before it's prefetched, so items just crossed by
+// the mouse aren't read
+constexpr int PrefetchHoverDelay_ms = 300;
+
 class HomeFilesDelegate : public ListHelper::ItemDelegate {
 public:
     HomeFilesDelegate(WidgetHomeFiles* widget)
@@ -214,10 +403,35 @@ WidgetHomeFiles::WidgetHomeFiles(QWidget* parent)
     m_gridDelegate->setItemPixmapSize(appModule->recentFileThumbnailSize());
     m_gridView->setItemDelegate(m_gridDelegate);
 
+    // Speculative read of the recent file under the mouse, once the mouse rests on it
+    auto timerPrefetch = new QTimer(this);
+    timerPrefetch->setSingleShot(true);
+    timerPrefetch->setInterval(PrefetchHoverDelay_ms);
+    auto ptrHoveredFilepath = std::make_shared<FilePath>();
+    QObject::connect(m_gridView, &QAbstractItemView::entered, this, [=](const QModelIndex& index) {
+        timerPrefetch->stop();
+        if (!appModule->prefetchHoveredRecentFile)
+            return;
+
+        const std::optional<QModelIndex> sourceIndex = m_gridModel.mapToSource(index);
+        const HomeFileItem* item = sourceIndex ? model->availableRecentFileItem(sourceIndex->row()) : nullptr;
+        if (item) {
+            *ptrHoveredFilepath = item->filepath;
+            timerPrefetch->start();
+        }
+    });
+    QObject::connect(timerPrefetch, &QTimer::timeout, this, [=]{
+        model->startFilePrefetch(*ptrHoveredFilepath);
+    });
+
     QObject::connect(app->settings(), &Settings::changed, this, [=](const Property* setting) {
         if (setting == &appModule->recentFiles)
             model->reload();
     });
+    QObject::connect(app->settings(), &Settings::changedMany, this, [=](Span<Property* const> settings) {
+        if (std::find(settings.begin(), settings.end(), &appModule->recentFiles) != settings.end())
+            model->reload();
+    });
 }
 
 void WidgetHomeFiles::resizeEvent(QResizeEvent* event)
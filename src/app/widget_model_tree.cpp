@@ -9,8 +9,11 @@
 #include "../base/application.h"
 #include "../base/application_item_selection_model.h"
 #include "../base/document.h"
+#include "../base/global.h"
 #include "../base/settings.h"
 #include "../base/string_utils.h"
+#include "../base/task_manager.h"
+#include "../base/tree_name_index.h"
 #include "../gui/gui_application.h"
 #include "item_view_buttons.h"
 #include "theme.h"
@@ -18,12 +21,13 @@
 
 #include <QtCore/QtDebug>
 #include <QtCore/QMetaType>
+#include <QtWidgets/QLineEdit>
 #include <QtWidgets/QTreeWidget>
-#include <QtWidgets/QTreeWidgetItemIterator>
 
 #include <gsl/util>
 #include <cassert>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
 Q_DECLARE_METATYPE(Mayo::DocumentPtr)
@@ -158,12 +162,46 @@ WidgetModelTree::WidgetModelTree(QWidget* widget)
                 modelTreeBtns, &ItemViewButtons::buttonClicked,
                 this, [=](int btnId, const QModelIndex& index) {
         if (btnId == idBtnRemove && index.isValid()) {
-            const QTreeWidgetItem* treeItem = m_ui->treeWidget_Model->itemFromIndex(index);
+            QTreeWidgetItem* treeItem = m_ui->treeWidget_Model->itemFromIndex(index);
             const DocumentTreeNode entityNode = Internal::treeItemDocumentTreeNode(treeItem);
-            entityNode.document()->destroyEntity(entityNode.id());
+            if (!treeItem->isSelected()) {
+                entityNode.document()->destroyEntity(entityNode.id());
+                return;
+            }
+
+            // Remove all the selected entities of the document at once
+            std::vector<TreeNodeId> vecEntityId;
+            for (const QTreeWidgetItem* selectedItem : m_ui->treeWidget_Model->selectedItems()) {
+                if (Internal::treeItemType(selectedItem) != Internal::TreeItemType_DocumentEntity)
+                    continue;
+
+                const DocumentTreeNode selectedNode = Internal::treeItemDocumentTreeNode(selectedItem);
+                if (selectedNode.document() == entityNode.document())
+                    vecEntityId.push_back(selectedNode.id());
+            }
+
+            entityNode.document()->destroyEntities(vecEntityId);
         }
     });
 
+    // Children of tree items are created on demand
+    QObject::connect(
+                m_ui->treeWidget_Model, &QTreeWidget::itemExpanded,
+                this, [=](QTreeWidgetItem* treeItem) {
+        this->fetchTreeItemChildren(treeItem);
+        if (WidgetModelTree::holdsDocumentTreeNode(treeItem))
+            emit this->documentTreeNodeExpanded(Internal::treeItemDocumentTreeNode(treeItem));
+    });
+
+    // Search box filters the tree to the paths of nodes whose name contains the text, "Enter" key
+    // selects all these nodes
+    QObject::connect(
+                m_ui->lineEdit_Search, &QLineEdit::textChanged,
+                this, &WidgetModelTree::applySearchFilter);
+    QObject::connect(
+                m_ui->lineEdit_Search, &QLineEdit::returnPressed,
+                this, &WidgetModelTree::selectSearchResults);
+
     this->connectTreeModelDataChanged(true);
 }
 
@@ -183,6 +221,12 @@ void WidgetModelTree::refreshItemText(const ApplicationItem& appItem)
     else if (appItem.isDocumentTreeNode()) {
         const DocumentTreeNode& node = appItem.documentTreeNode();
         QTreeWidgetItem* treeItemDocItem = this->findTreeItem(node);
+        if (!treeItemDocItem) {
+            // Tree item not created yet, refresh the existing items of the owning entity
+            const TreeNodeId entityId = node.document()->modelTree().nodeRoot(node.id());
+            treeItemDocItem = this->findTreeItem(DocumentTreeNode(node.document(), entityId));
+        }
+
         if (treeItemDocItem)
             this->findSupportBuilder(node)->refreshTextTreeItem(node, treeItemDocItem);
     }
@@ -210,9 +254,15 @@ void WidgetModelTree::registerGuiApplication(GuiApplication* guiApp)
     QObject::connect(
                 app.get(), &Application::documentEntityAdded,
                 this, &WidgetModelTree::onDocumentEntityAdded);
+    QObject::connect(
+                app.get(), &Application::documentEntitiesAdded,
+                this, &WidgetModelTree::onDocumentEntitiesAdded);
     QObject::connect(
                 app.get(), &Application::documentEntityAboutToBeDestroyed,
                 this, &WidgetModelTree::onDocumentEntityAboutToBeDestroyed);
+    QObject::connect(
+                app.get(), &Application::documentEntitiesAboutToBeDestroyed,
+                this, &WidgetModelTree::onDocumentEntitiesAboutToBeDestroyed);
 
     QObject::connect(m_guiApp, &GuiApplication::guiDocumentAdded, this, [=](GuiDocument* guiDoc) {
         QObject::connect(
@@ -289,6 +339,8 @@ void WidgetModelTree::onDocumentAdded(const DocumentPtr& doc)
 
 void WidgetModelTree::onDocumentAboutToClose(const DocumentPtr& doc)
 {
+    m_mapDocumentVecTreeItem.erase(doc->identifier());
+    this->discardNameIndex(doc, false);
     delete this->findTreeItem(doc);
 }
 
@@ -304,6 +356,7 @@ QTreeWidgetItem* WidgetModelTree::loadDocumentEntity(const DocumentTreeNode& nod
     Expects(node.isEntity());
     auto treeItem = this->findSupportBuilder(node)->createTreeItem(node);
     Internal::setTreeItemDocumentTreeNode(treeItem, node);
+    this->indexTreeItem(treeItem);
     return treeItem;
 }
 
@@ -320,15 +373,107 @@ QTreeWidgetItem* WidgetModelTree::findTreeItem(const DocumentPtr& doc) const
 
 QTreeWidgetItem* WidgetModelTree::findTreeItem(const DocumentTreeNode& node) const
 {
-    QTreeWidgetItem* treeItemDoc = this->findTreeItem(node.document());
-    if (treeItemDoc) {
-        for (QTreeWidgetItemIterator it(treeItemDoc); *it; ++it) {
-            if (Internal::treeItemDocumentTreeNode(*it) == node)
-                return *it;
+    if (!node.isValid())
+        return nullptr;
+
+    auto itVecTreeItem = m_mapDocumentVecTreeItem.find(node.document()->identifier());
+    if (itVecTreeItem == m_mapDocumentVecTreeItem.cend())
+        return nullptr;
+
+    const std::vector<QTreeWidgetItem*>& vecTreeItem = itVecTreeItem->second;
+    return node.id() < vecTreeItem.size() ? vecTreeItem.at(node.id()) : nullptr;
+}
+
+QTreeWidgetItem* WidgetModelTree::fetchTreeItem(const DocumentTreeNode& node)
+{
+    QTreeWidgetItem* treeItem = this->findTreeItem(node);
+    if (treeItem || !node.isValid())
+        return treeItem;
+
+    // Tree item not created yet: fetch children of the items along the path entity -> node
+    const Tree<TDF_Label>& modelTree = node.document()->modelTree();
+    std::vector<TreeNodeId> vecPathNodeId;
+    for (TreeNodeId id = node.id(); id != 0; id = modelTree.nodeParent(id))
+        vecPathNodeId.push_back(id);
+
+    treeItem = this->findTreeItem(DocumentTreeNode(node.document(), vecPathNodeId.back()));
+    if (!treeItem)
+        return nullptr;
+
+    for (auto it = std::next(vecPathNodeId.crbegin()); it != vecPathNodeId.crend(); ++it) {
+        this->fetchTreeItemChildren(treeItem);
+        for (int i = 0; i < treeItem->childCount(); ++i) {
+            QTreeWidgetItem* childItem = treeItem->child(i);
+            if (Internal::treeItemDocumentTreeNode(childItem).id() == *it) {
+                treeItem = childItem;
+                break;
+            }
         }
+
+        // Note: model tree nodes not found are merged into their parent item(eg XDE referred shapes)
     }
 
-    return nullptr;
+    return Internal::treeItemDocumentTreeNode(treeItem) == node ? treeItem : nullptr;
+}
+
+void WidgetModelTree::fetchTreeItemChildren(QTreeWidgetItem* treeItem)
+{
+    if (!treeItem || !WidgetModelTree::holdsDocumentTreeNode(treeItem))
+        return;
+
+    const DocumentTreeNode node = Internal::treeItemDocumentTreeNode(treeItem);
+    WidgetModelTreeBuilder* builder = this->findSupportBuilder(node);
+    if (!builder->canFetchMore(treeItem))
+        return;
+
+    // Check states of the new items are already in sync with GuiDocument
+    this->connectTreeModelDataChanged(false);
+    auto _ = gsl::finally([=]{ this->connectTreeModelDataChanged(true); });
+    builder->fetchMore(treeItem);
+    for (int i = 0; i < treeItem->childCount(); ++i)
+        this->indexTreeItem(treeItem->child(i));
+}
+
+void WidgetModelTree::indexTreeItem(QTreeWidgetItem* treeItem)
+{
+    const DocumentTreeNode node = Internal::treeItemDocumentTreeNode(treeItem);
+    if (!node.isValid())
+        return;
+
+    std::vector<QTreeWidgetItem*>& vecTreeItem = m_mapDocumentVecTreeItem[node.document()->identifier()];
+    if (node.id() >= vecTreeItem.size()) {
+        const size_t nodeCount = node.document()->modelTree().nodeCount();
+        vecTreeItem.resize(std::max<size_t>(nodeCount, node.id()) + 1, nullptr);
+    }
+
+    vecTreeItem.at(node.id()) = treeItem;
+}
+
+// Removes from the index 'treeItemRoot' and all its descendant items
+void WidgetModelTree::unindexTreeItems(QTreeWidgetItem* treeItemRoot)
+{
+    if (!treeItemRoot || !WidgetModelTree::holdsDocumentTreeNode(treeItemRoot))
+        return;
+
+    const DocumentPtr doc = Internal::treeItemDocumentTreeNode(treeItemRoot).document();
+    auto itVecTreeItem = m_mapDocumentVecTreeItem.find(doc->identifier());
+    if (itVecTreeItem == m_mapDocumentVecTreeItem.end())
+        return;
+
+    std::vector<QTreeWidgetItem*>& vecTreeItem = itVecTreeItem->second;
+    auto fnUnindex = [&](const QTreeWidgetItem* treeItem) {
+        const TreeNodeId nodeId = Internal::treeItemDocumentTreeNode(treeItem).id();
+        if (nodeId < vecTreeItem.size() && vecTreeItem.at(nodeId) == treeItem)
+            vecTreeItem.at(nodeId) = nullptr;
+    };
+    std::vector<const QTreeWidgetItem*> vecTreeItemStack = { treeItemRoot };
+    while (!vecTreeItemStack.empty()) {
+        const QTreeWidgetItem* treeItem = vecTreeItemStack.back();
+        vecTreeItemStack.pop_back();
+        fnUnindex(treeItem);
+        for (int i = 0; i < treeItem->childCount(); ++i)
+            vecTreeItemStack.push_back(treeItem->child(i));
+    }
 }
 
 WidgetModelTreeBuilder* WidgetModelTree::findSupportBuilder(const DocumentPtr& doc) const
@@ -352,18 +497,43 @@ WidgetModelTreeBuilder* WidgetModelTree::findSupportBuilder(const DocumentTreeNo
 
 void WidgetModelTree::onDocumentEntityAdded(const DocumentPtr& doc, TreeNodeId entityId)
 {
-    QTreeWidgetItem* treeDocEntity = this->loadDocumentEntity({ doc, entityId });
+    this->onDocumentEntitiesAdded(doc, { entityId });
+}
+
+void WidgetModelTree::onDocumentEntitiesAdded(const DocumentPtr& doc, const std::vector<TreeNodeId>& vecEntityId)
+{
+    QList<QTreeWidgetItem*> listTreeDocEntity;
+    for (TreeNodeId entityId : vecEntityId)
+        listTreeDocEntity.push_back(this->loadDocumentEntity({ doc, entityId }));
+
     QTreeWidgetItem* treeDoc = this->findTreeItem(doc);
     if (treeDoc) {
-        treeDoc->addChild(treeDocEntity);
+        treeDoc->addChildren(listTreeDocEntity);
         treeDoc->setExpanded(true);
     }
+
+    this->discardNameIndex(doc, false);
+    if (!m_ui->lineEdit_Search->text().trimmed().isEmpty())
+        this->applySearchFilter();
 }
 
 void WidgetModelTree::onDocumentEntityAboutToBeDestroyed(const DocumentPtr& doc, TreeNodeId entityId)
 {
-    QTreeWidgetItem* treeItem = this->findTreeItem({ doc, entityId });
-    delete treeItem;
+    this->onDocumentEntitiesAboutToBeDestroyed(doc, { entityId });
+}
+
+void WidgetModelTree::onDocumentEntitiesAboutToBeDestroyed(const DocumentPtr& doc, const std::vector<TreeNodeId>& vecEntityId)
+{
+    for (TreeNodeId entityId : vecEntityId) {
+        QTreeWidgetItem* treeItem = this->findTreeItem({ doc, entityId });
+        this->unindexTreeItems(treeItem);
+        delete treeItem;
+    }
+
+    // Pending index build reads the model tree of the entity, wait before it gets destroyed
+    this->discardNameIndex(doc, true);
+    if (!m_ui->lineEdit_Search->text().trimmed().isEmpty())
+        this->applySearchFilter();
 }
 
 //void WidgetModelTree::onDocumentItemPropertyChanged(
@@ -400,26 +570,48 @@ void WidgetModelTree::onTreeWidgetDocumentSelectionChanged(
 void WidgetModelTree::onApplicationItemSelectionModelChanged(
         Span<const ApplicationItem> selected, Span<const ApplicationItem> deselected)
 {
+    // All changes are applied with a single select() call per kind and a single repaint
+    Internal::TreeWidget* treeWidget = m_ui->treeWidget_Model;
     this->connectTreeWidgetDocumentSelectionChanged(false);
-    auto _ = gsl::finally([=] { this->connectTreeWidgetDocumentSelectionChanged(true); });
+    treeWidget->setUpdatesEnabled(false);
+    auto _ = gsl::finally([=] {
+        treeWidget->setUpdatesEnabled(true);
+        this->connectTreeWidgetDocumentSelectionChanged(true);
+    });
 
-    auto fnSetSelected = [=](Span<const ApplicationItem> spanAppItem, bool on) {
+    QTreeWidgetItem* treeItemLastSelected = nullptr;
+    auto fnItemSelection = [&](Span<const ApplicationItem> spanAppItem, bool on) {
+        QItemSelection selection;
         for (const ApplicationItem& appItem : spanAppItem) {
             if (!appItem.isDocumentTreeNode())
                 continue;
 
-            QTreeWidgetItem* treeItem = this->findTreeItem(appItem.documentTreeNode());
+            QTreeWidgetItem* treeItem =
+                    on ? this->fetchTreeItem(appItem.documentTreeNode())
+                       : this->findTreeItem(appItem.documentTreeNode());
             if (!treeItem)
                 continue;
 
-            treeItem->setSelected(on);
+            const QModelIndex index = treeWidget->indexFromItem(treeItem);
+            selection.select(index, index);
             if (on)
-                m_ui->treeWidget_Model->scrollToItem(treeItem);
+                treeItemLastSelected = treeItem;
         }
+
+        return selection;
     };
 
-    fnSetSelected(selected, true);
-    fnSetSelected(deselected, false);
+    const QItemSelection selectionOn = fnItemSelection(selected, true);
+    const QItemSelection selectionOff = fnItemSelection(deselected, false);
+    QItemSelectionModel* selectionModel = treeWidget->selectionModel();
+    if (!selectionOn.isEmpty())
+        selectionModel->select(selectionOn, QItemSelectionModel::Select | QItemSelectionModel::Rows);
+
+    if (!selectionOff.isEmpty())
+        selectionModel->select(selectionOff, QItemSelectionModel::Deselect | QItemSelectionModel::Rows);
+
+    if (treeItemLastSelected)
+        treeWidget->scrollToItem(treeItemLastSelected);
 }
 
 void WidgetModelTree::connectTreeModelDataChanged(bool on)
@@ -477,21 +669,161 @@ void WidgetModelTree::onNodesVisibilityChanged(
     if (!treeItemDoc)
         return;
 
+    // Check states are changed with view updates suspended, so the tree is repainted once
+    QTreeWidget* treeWidget = m_ui->treeWidget_Model;
     this->connectTreeModelDataChanged(false);
-    auto _ = gsl::finally([=]{ this->connectTreeModelDataChanged(true); });
+    treeWidget->setUpdatesEnabled(false);
+    auto _ = gsl::finally([=]{
+        treeWidget->setUpdatesEnabled(true);
+        this->connectTreeModelDataChanged(true);
+    });
+
+    const DocumentPtr doc = guiDoc->document();
+    for (const auto& [nodeId, checkState] : mapNodeId) {
+        QTreeWidgetItem* treeItem = this->findTreeItem(DocumentTreeNode(doc, nodeId));
+        if (treeItem)
+            treeItem->setCheckState(0, checkState);
+    }
+}
+
+void WidgetModelTree::applySearchFilter()
+{
+    // Tree items are created for the first results only, so large result sets stay responsive
+    constexpr int MaxFetchedResultCount = 1000;
+    const QString text = m_ui->lineEdit_Search->text().trimmed();
+    Internal::TreeWidget* treeWidget = m_ui->treeWidget_Model;
+    treeWidget->setUpdatesEnabled(false);
+    auto _ = gsl::finally([=]{ treeWidget->setUpdatesEnabled(true); });
+    for (int i = 0; i < treeWidget->topLevelItemCount(); ++i) {
+        QTreeWidgetItem* treeItemDoc = treeWidget->topLevelItem(i);
+        const DocumentPtr doc = Internal::treeItemDocument(treeItemDoc);
+        const TreeNameIndex* nameIndex = !text.isEmpty() ? this->findNameIndex(doc) : nullptr;
+        if (!text.isEmpty() && !nameIndex)
+            continue; // Filter is applied once the name index is built
+
+        // Nodes along the paths entity -> result are visible
+        const Tree<TDF_Label>& modelTree = doc->modelTree();
+        std::vector<bool> vecNodeVisible;
+        if (nameIndex) {
+            vecNodeVisible.resize(modelTree.nodeCount() + 1, false);
+            int fetchedResultCount = 0;
+            for (TreeNodeId nodeId : nameIndex->find(text)) {
+                for (TreeNodeId id = nodeId; id != 0 && !vecNodeVisible.at(id); id = modelTree.nodeParent(id))
+                    vecNodeVisible.at(id) = true;
+
+                if (fetchedResultCount++ >= MaxFetchedResultCount)
+                    continue;
+
+                // Node might be merged into its parent item(eg XDE referred shapes)
+                QTreeWidgetItem* treeItem = this->fetchTreeItem(DocumentTreeNode(doc, nodeId));
+                for (TreeNodeId id = nodeId; !treeItem && id != 0; id = modelTree.nodeParent(id))
+                    treeItem = this->findTreeItem(DocumentTreeNode(doc, id));
+
+                for (QTreeWidgetItem* parentItem = treeItem ? treeItem->parent() : nullptr;
+                     parentItem != nullptr && !parentItem->isExpanded();
+                     parentItem = parentItem->parent())
+                {
+                    parentItem->setExpanded(true);
+                }
+            }
+        }
+
+        auto fnIsItemVisible = [&](const QTreeWidgetItem* treeItem) {
+            const TreeNodeId id = Internal::treeItemDocumentTreeNode(treeItem).id();
+            return !nameIndex || (id < vecNodeVisible.size() && vecNodeVisible.at(id));
+        };
+        std::vector<QTreeWidgetItem*> vecTreeItemStack = { treeItemDoc };
+        while (!vecTreeItemStack.empty()) {
+            QTreeWidgetItem* treeItem = vecTreeItemStack.back();
+            vecTreeItemStack.pop_back();
+            for (int iChild = 0; iChild < treeItem->childCount(); ++iChild) {
+                QTreeWidgetItem* childItem = treeItem->child(iChild);
+                const bool isVisible = fnIsItemVisible(childItem);
+                childItem->setHidden(!isVisible);
+                if (isVisible)
+                    vecTreeItemStack.push_back(childItem);
+            }
+        }
+    }
+}
+
+void WidgetModelTree::selectSearchResults()
+{
+    const QString text = m_ui->lineEdit_Search->text().trimmed();
+    if (text.isEmpty() || !m_guiApp)
+        return;
 
-    auto localMapNodeId = mapNodeId;
-    for (QTreeWidgetItemIterator it(treeItemDoc); *it; ++it) {
-        QTreeWidgetItem* treeItem = *it;
-        const DocumentTreeNode docTreeNode = Internal::treeItemDocumentTreeNode(treeItem);
-        auto itNodeVisibleState = localMapNodeId.find(docTreeNode.id());
-        if (itNodeVisibleState != localMapNodeId.cend()) {
-            treeItem->setCheckState(0, itNodeVisibleState->second);
-            localMapNodeId.erase(itNodeVisibleState);
+    std::vector<ApplicationItem> vecAppItem;
+    for (int i = 0; i < m_ui->treeWidget_Model->topLevelItemCount(); ++i) {
+        const DocumentPtr doc = Internal::treeItemDocument(m_ui->treeWidget_Model->topLevelItem(i));
+        const TreeNameIndex* nameIndex = this->findNameIndex(doc);
+        if (nameIndex) {
+            for (TreeNodeId nodeId : nameIndex->find(text))
+                vecAppItem.emplace_back(DocumentTreeNode(doc, nodeId));
         }
+    }
 
-        if (localMapNodeId.empty())
+    m_guiApp->selectionModel()->clear();
+    m_guiApp->selectionModel()->add(vecAppItem);
+}
+
+// Returns null if the name index of 'doc' isn't available yet, its build is then started
+const TreeNameIndex* WidgetModelTree::findNameIndex(const DocumentPtr& doc)
+{
+    auto itNameIndex = m_mapDocumentNameIndex.find(doc->identifier());
+    if (itNameIndex != m_mapDocumentNameIndex.cend())
+        return itNameIndex->second.get();
+
+    this->buildNameIndex(doc);
+    return nullptr;
+}
+
+void WidgetModelTree::buildNameIndex(const DocumentPtr& doc)
+{
+    const Document::Identifier docId = doc->identifier();
+    if (m_mapDocumentNameIndexTask.find(docId) != m_mapDocumentNameIndexTask.cend())
+        return; // Build in progress
+
+    auto taskMgr = TaskManager::globalInstance();
+    auto nameIndex = std::make_shared<TreeNameIndex>();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        std::lock_guard<std::mutex> lock(doc->dataMutex()); MAYO_UNUSED(lock);
+        *nameIndex = TreeNameIndex::fromModelTree(doc, progress);
+    });
+    auto connTaskEnded = std::make_shared<QMetaObject::Connection>();
+    *connTaskEnded = QObject::connect(
+                taskMgr, &TaskManager::ended,
+                this, [=](TaskId endedTaskId) {
+        if (endedTaskId != taskId)
             return;
+
+        QObject::disconnect(*connTaskEnded);
+        auto itTask = m_mapDocumentNameIndexTask.find(docId);
+        if (itTask == m_mapDocumentNameIndexTask.end() || itTask->second != taskId)
+            return; // Build was discarded(eg document modified or closed)
+
+        m_mapDocumentNameIndexTask.erase(itTask);
+        m_mapDocumentNameIndex.insert_or_assign(docId, nameIndex);
+        this->applySearchFilter();
+    });
+    m_mapDocumentNameIndexTask.insert({ docId, taskId });
+    taskMgr->setTitle(taskId, tr("Index names") + " - " + doc->name());
+    taskMgr->setPriority(taskId, TaskPriority::Background);
+    taskMgr->run(taskId);
+}
+
+// Name index of 'doc' is rebuilt on next search, pending build gets aborted
+void WidgetModelTree::discardNameIndex(const DocumentPtr& doc, bool waitForTask)
+{
+    m_mapDocumentNameIndex.erase(doc->identifier());
+    auto itTask = m_mapDocumentNameIndexTask.find(doc->identifier());
+    if (itTask != m_mapDocumentNameIndexTask.end()) {
+        auto taskMgr = TaskManager::globalInstance();
+        taskMgr->requestAbort(itTask->second);
+        if (waitForTask)
+            taskMgr->waitForDone(itTask->second);
+
+        m_mapDocumentNameIndexTask.erase(itTask);
     }
 }
 
@@ -8,6 +8,7 @@
 
 #include "../base/application_item.h"
 #include "../base/property.h"
+#include "../base/task_common.h"
 #include "../gui/gui_document.h"
 
 #include <QtWidgets/QWidget>
@@ -17,10 +18,13 @@ class QTreeWidget;
 class QTreeWidgetItem;
 
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace Mayo {
 
 class GuiApplication;
+class TreeNameIndex;
 class WidgetModelTreeBuilder;
 
 struct WidgetModelTree_UserActions {
@@ -54,12 +58,17 @@ public:
     static bool holdsDocument(const QTreeWidgetItem* treeItem);
     static bool holdsDocumentTreeNode(const QTreeWidgetItem* treeItem);
 
+signals:
+    void documentTreeNodeExpanded(const Mayo::DocumentTreeNode& node);
+
 private:
     void onDocumentAdded(const DocumentPtr& doc);
     void onDocumentAboutToClose(const DocumentPtr& doc);
     void onDocumentNameChanged(const DocumentPtr& doc, const QString& name);
     void onDocumentEntityAdded(const DocumentPtr& doc, TreeNodeId entityId);
+    void onDocumentEntitiesAdded(const DocumentPtr& doc, const std::vector<TreeNodeId>& vecEntityId);
     void onDocumentEntityAboutToBeDestroyed(const DocumentPtr& doc, TreeNodeId entityId);
+    void onDocumentEntitiesAboutToBeDestroyed(const DocumentPtr& doc, const std::vector<TreeNodeId>& vecEntityId);
 
     void onTreeWidgetDocumentSelectionChanged(
             const QItemSelection& selected, const QItemSelection& deselected);
@@ -78,6 +87,16 @@ private:
 
     QTreeWidgetItem* findTreeItem(const DocumentPtr& doc) const;
     QTreeWidgetItem* findTreeItem(const DocumentTreeNode& node) const;
+    QTreeWidgetItem* fetchTreeItem(const DocumentTreeNode& node);
+    void fetchTreeItemChildren(QTreeWidgetItem* treeItem);
+    void indexTreeItem(QTreeWidgetItem* treeItem);
+    void unindexTreeItems(QTreeWidgetItem* treeItemRoot);
+
+    void applySearchFilter();
+    void selectSearchResults();
+    const TreeNameIndex* findNameIndex(const DocumentPtr& doc);
+    void buildNameIndex(const DocumentPtr& doc);
+    void discardNameIndex(const DocumentPtr& doc, bool waitForTask);
 
     WidgetModelTreeBuilder* findSupportBuilder(const DocumentPtr& doc) const;
     WidgetModelTreeBuilder* findSupportBuilder(const DocumentTreeNode& entityNode) const;
@@ -88,6 +107,11 @@ private:
     QString m_refItemTextTemplate;
     QMetaObject::Connection m_connTreeModelDataChanged;
     QMetaObject::Connection m_connTreeWidgetDocumentSelectionChanged;
+    // Tree items indexed by model tree node, per document. Null for items not created yet
+    std::unordered_map<Document::Identifier, std::vector<QTreeWidgetItem*>> m_mapDocumentVecTreeItem;
+    // Indexes of node names per document for the search box, built on demand in background tasks
+    std::unordered_map<Document::Identifier, std::shared_ptr<const TreeNameIndex>> m_mapDocumentNameIndex;
+    std::unordered_map<Document::Identifier, TaskId> m_mapDocumentNameIndexTask;
 };
 
 } // namespace Mayo
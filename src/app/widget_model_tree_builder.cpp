@@ -28,7 +28,7 @@ void WidgetModelTreeBuilder::refreshTextTreeItem(const DocumentPtr& doc, QTreeWi
 
 void WidgetModelTreeBuilder::refreshTextTreeItem(const DocumentTreeNode& node, QTreeWidgetItem* treeItem)
 {
-    treeItem->setText(0, WidgetModelTreeBuilder::labelText(node.label()));
+    treeItem->setText(0, WidgetModelTreeBuilder::labelText(node.document()->labelName(node.label())));
 }
 
 QTreeWidgetItem* WidgetModelTreeBuilder::createTreeItem(const DocumentPtr& doc)
@@ -43,7 +43,7 @@ QTreeWidgetItem* WidgetModelTreeBuilder::createTreeItem(const DocumentPtr& doc)
 QTreeWidgetItem* WidgetModelTreeBuilder::createTreeItem(const DocumentTreeNode& node)
 {
     auto treeItem = new QTreeWidgetItem;
-    treeItem->setText(0, WidgetModelTreeBuilder::labelText(node.label()));
+    treeItem->setText(0, WidgetModelTreeBuilder::labelText(node.document()->labelName(node.label())));
     treeItem->setFlags(treeItem->flags() | Qt::ItemIsUserCheckable);
     treeItem->setCheckState(0, Qt::Checked);
     return treeItem;
@@ -66,7 +66,9 @@ QString WidgetModelTreeBuilder::labelText(const QString& label)
 
 QString WidgetModelTreeBuilder::labelText(const TDF_Label& label)
 {
-    return WidgetModelTreeBuilder::labelText(CafUtils::labelAttrStdName(label));
+    const DocumentPtr doc = Document::findFrom(label);
+    const QString name = !doc.IsNull() ? doc->labelName(label) : CafUtils::labelAttrStdName(label);
+    return WidgetModelTreeBuilder::labelText(name);
 }
 
 } // namespace Mayo
@@ -33,6 +33,11 @@ public:
     virtual QTreeWidgetItem* createTreeItem(const DocumentPtr& doc);
     virtual QTreeWidgetItem* createTreeItem(const DocumentTreeNode& node);
 
+    // Lazy population: children of 'treeItem' are created only when fetchMore() is called, which
+    // happens typically when the item gets expanded
+    virtual bool canFetchMore(const QTreeWidgetItem* /*treeItem*/) const { return false; }
+    virtual void fetchMore(QTreeWidgetItem* /*treeItem*/) {}
+
     QTreeWidget* treeWidget() const { return m_treeWidget; }
     void setTreeWidget(QTreeWidget* tree) { m_treeWidget = tree; }
 
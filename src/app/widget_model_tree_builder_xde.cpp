@@ -16,9 +16,6 @@
 #include <QtWidgets/QTreeWidget>
 #include <QtWidgets/QTreeWidgetItemIterator>
 
-#include <unordered_map>
-#include <unordered_set>
-
 namespace Mayo {
 
 class WidgetModelTreeBuilder_Xde::Module : public QObject, public PropertyGroup {
@@ -83,36 +80,71 @@ bool WidgetModelTreeBuilder_Xde::supportsDocumentTreeNode(const DocumentTreeNode
 void WidgetModelTreeBuilder_Xde::refreshTextTreeItem(
         const DocumentTreeNode& node, QTreeWidgetItem* treeItem)
 {
+    // Tree items are created lazily, so only the existing ones need to be refreshed. The others
+    // will get up-to-date text on creation
     const TDF_Label labelNode = node.label();
-    TDF_LabelSequence seqLabelRefresh;
+    TDF_Label labelProduct;
     if (XCaf::isShapeReference(labelNode)
             && m_module->instanceNameTemplate().contains("%product"))
     {
-        XCAFDoc_ShapeTool::GetUsers(
-                    XCaf::shapeReferred(labelNode),
-                    seqLabelRefresh,
-                    false /* don't get sub children */);
-    }
-    else {
-        seqLabelRefresh.Append(labelNode);
+        labelProduct = XCaf::shapeReferred(labelNode);
     }
 
-    for (const TDF_Label& labelRefresh : seqLabelRefresh) {
-        QTreeWidgetItem* treeItemLabel = this->findTreeItem(treeItem, labelRefresh);
-        if (treeItemLabel)
-            this->refreshXdeAssemblyNodeItemText(treeItemLabel);
+    for (QTreeWidgetItemIterator it(treeItem); *it; ++it) {
+        if (!WidgetModelTree::holdsDocumentTreeNode(*it))
+            continue;
+
+        const TDF_Label itLabel = WidgetModelTree::documentTreeNode(*it).label();
+        if (itLabel == labelNode
+                || (!labelProduct.IsNull()
+                    && XCaf::isShapeReference(itLabel)
+                    && XCaf::shapeReferred(itLabel) == labelProduct))
+        {
+            this->refreshXdeAssemblyNodeItemText(*it);
+        }
     }
 }
 
 QTreeWidgetItem* WidgetModelTreeBuilder_Xde::createTreeItem(const DocumentTreeNode& node)
 {
     Expects(this->supportsDocumentTreeNode(node));
-    return this->buildXdeTree(nullptr, node);
+    QTreeWidgetItem* parentTreeItem = nullptr;
+    return this->createXdeTreeItem(parentTreeItem, node);
+}
+
+bool WidgetModelTreeBuilder_Xde::canFetchMore(const QTreeWidgetItem* treeItem) const
+{
+    return treeItem->childCount() == 0
+            && treeItem->childIndicatorPolicy() == QTreeWidgetItem::ShowIndicator;
+}
+
+void WidgetModelTreeBuilder_Xde::fetchMore(QTreeWidgetItem* treeItem)
+{
+    if (!this->canFetchMore(treeItem))
+        return;
+
+    const DocumentTreeNode node = WidgetModelTree::documentTreeNode(treeItem);
+    const DocumentPtr doc = node.document();
+    const Tree<TDF_Label>& modelTree = doc->modelTree();
+    QList<QTreeWidgetItem*> listChildItem;
+    visitDirectChildren(this->contentsNodeId(node), modelTree, [&](TreeNodeId childId) {
+        QTreeWidgetItem* parentTreeItem = nullptr;
+        const DocumentTreeNode childNode(doc, childId);
+        QTreeWidgetItem* childItem = this->createXdeTreeItem(parentTreeItem, childNode);
+        if (childItem->flags() & Qt::ItemIsUserCheckable)
+            childItem->setCheckState(0, this->childCheckState(treeItem, childNode));
+
+        listChildItem.push_back(childItem);
+    });
+
+    treeItem->setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicatorWhenChildless);
+    treeItem->addChildren(listChildItem);
 }
 
 // BEWARE Not thread-safe, should be called from main(GUI) thread
 void WidgetModelTreeBuilder_Xde::registerGuiApplication(GuiApplication* guiApp)
 {
+    m_guiApp = guiApp;
     m_module = Module::get(guiApp->application());
     if (!m_module)
         m_module = new Module(guiApp->application());
@@ -150,7 +182,7 @@ QTreeWidgetItem* WidgetModelTreeBuilder_Xde::guiCreateXdeTreeNode(
         QTreeWidgetItem* guiParentNode, const DocumentTreeNode& node)
 {
     auto guiNode = new QTreeWidgetItem(guiParentNode);
-    const QString stdName = CafUtils::labelAttrStdName(node.label());
+    const QString stdName = node.document()->labelName(node.label());
     guiNode->setText(0, stdName);
     WidgetModelTree::setDocumentTreeNode(guiNode, node);
     const QIcon icon = Module::shapeIcon(node.label());
@@ -160,56 +192,59 @@ QTreeWidgetItem* WidgetModelTreeBuilder_Xde::guiCreateXdeTreeNode(
     return guiNode;
 }
 
-QTreeWidgetItem* WidgetModelTreeBuilder_Xde::buildXdeTree(
-        QTreeWidgetItem* treeItem, const DocumentTreeNode& node)
+QTreeWidgetItem* WidgetModelTreeBuilder_Xde::createXdeTreeItem(
+        QTreeWidgetItem* parentTreeItem, const DocumentTreeNode& node)
 {
-    Expects(node.isEntity());
+    const Tree<TDF_Label>& modelTree = node.document()->modelTree();
+    const TreeNodeId contentsId = this->contentsNodeId(node);
+    QTreeWidgetItem* guiNode = nullptr;
+    if (m_isMergeXdeReferredShapeOn) {
+        // Reference node and its referred shape node are merged into a single tree item
+        const TDF_Label& nodeLabel = node.label();
+        const TDF_Label& contentsLabel = modelTree.nodeData(contentsId);
+        guiNode = new QTreeWidgetItem(parentTreeItem);
+        if (XCaf::isShapeReference(nodeLabel))
+            guiNode->setText(0, this->referenceItemText(node.document(), nodeLabel, contentsLabel));
+        else
+            guiNode->setText(0, node.document()->labelName(nodeLabel));
+
+        WidgetModelTree::setDocumentTreeNode(guiNode, node);
+        const QIcon icon = Module::shapeIcon(contentsLabel);
+        if (!icon.isNull())
+            guiNode->setIcon(0, icon);
+
+        guiNode->setFlags(guiNode->flags() | Qt::ItemIsUserCheckable);
+        guiNode->setCheckState(0, Qt::Checked);
+    }
+    else {
+        guiNode = ThisType::guiCreateXdeTreeNode(parentTreeItem, node);
+    }
 
-    std::unordered_map<TreeNodeId, QTreeWidgetItem*> mapNodeIdToTreeItem;
-    std::unordered_set<TreeNodeId> setReferenceNodeId;
-    const DocumentPtr doc = node.document();
-    const Tree<TDF_Label>& modelTree = doc->modelTree();
-    traverseTree(node.id(), modelTree, [&](TreeNodeId itNodeId) {
-        const TreeNodeId nodeParentId = modelTree.nodeParent(itNodeId);
-        auto itParentFound = mapNodeIdToTreeItem.find(nodeParentId);
-        QTreeWidgetItem* guiParentNode =
-                itParentFound != mapNodeIdToTreeItem.end() ? itParentFound->second : treeItem;
-        if (m_isMergeXdeReferredShapeOn) {
-            const TDF_Label& nodeLabel = modelTree.nodeData(itNodeId);
-            if (XCaf::isShapeReference(nodeLabel)) {
-                mapNodeIdToTreeItem[itNodeId] = guiParentNode;
-                setReferenceNodeId.insert(itNodeId);
-            }
-            else {
-                auto guiNode = new QTreeWidgetItem(guiParentNode);
-                QString guiNodeText = CafUtils::labelAttrStdName(nodeLabel);
-                TreeNodeId guiNodeId = itNodeId;
-                if (setReferenceNodeId.find(nodeParentId) != setReferenceNodeId.cend()) {
-                    const TDF_Label& refLabel = modelTree.nodeData(nodeParentId);
-                    guiNodeText = this->referenceItemText(refLabel, nodeLabel);
-                    guiNodeId = nodeParentId;
-                    if (!guiParentNode)
-                        mapNodeIdToTreeItem[nodeParentId] = guiNode;
-                }
-
-                guiNode->setText(0, guiNodeText);
-                WidgetModelTree::setDocumentTreeNode(guiNode, DocumentTreeNode(doc, guiNodeId));
-                const QIcon icon = Module::shapeIcon(nodeLabel);
-                if (!icon.isNull())
-                    guiNode->setIcon(0, icon);
-
-                guiNode->setFlags(guiNode->flags() | Qt::ItemIsUserCheckable);
-                guiNode->setCheckState(0, Qt::Checked);
-                mapNodeIdToTreeItem[itNodeId] = guiNode;
-            }
-        }
-        else {
-            auto guiNode = ThisType::guiCreateXdeTreeNode(guiParentNode, { doc, itNodeId });
-            mapNodeIdToTreeItem[itNodeId] = guiNode;
-        }
-    });
+    // Children items will be created on demand by fetchMore()
+    if (contentsId != 0 && !modelTree.nodeIsLeaf(contentsId))
+        guiNode->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+
+    return guiNode;
+}
+
+// Returns the model tree node whose children are displayed under the tree item of 'node'
+TreeNodeId WidgetModelTreeBuilder_Xde::contentsNodeId(const DocumentTreeNode& node) const
+{
+    if (m_isMergeXdeReferredShapeOn && XCaf::isShapeReference(node.label()))
+        return node.document()->modelTree().nodeChildFirst(node.id());
 
-    return mapNodeIdToTreeItem.find(node.id())->second;
+    return node.id();
+}
+
+Qt::CheckState WidgetModelTreeBuilder_Xde::childCheckState(
+        const QTreeWidgetItem* parentTreeItem, const DocumentTreeNode& node) const
+{
+    const Qt::CheckState parentCheckState = parentTreeItem->checkState(0);
+    if (parentCheckState != Qt::PartiallyChecked)
+        return parentCheckState;
+
+    const GuiDocument* guiDoc = m_guiApp ? m_guiApp->findGuiDocument(node.document()) : nullptr;
+    return guiDoc ? guiDoc->nodeVisibleState(node.id()) : Qt::Checked;
 }
 
 QByteArray WidgetModelTreeBuilder_Xde::instanceNameFormat() const
@@ -233,6 +268,7 @@ std::unique_ptr<WidgetModelTreeBuilder> WidgetModelTreeBuilder_Xde::clone() cons
 {
     auto builder = std::make_unique<WidgetModelTreeBuilder_Xde>();
     builder->m_module = this->m_module;
+    builder->m_guiApp = this->m_guiApp;
     builder->m_isMergeXdeReferredShapeOn = this->m_isMergeXdeReferredShapeOn;
     return builder;
 }
@@ -244,19 +280,19 @@ void WidgetModelTreeBuilder_Xde::refreshXdeAssemblyNodeItemText(QTreeWidgetItem*
     if (XCaf::isShapeReference(label)) {
         const TDF_Label& instanceLabel = label;
         const TDF_Label productLabel = XCaf::shapeReferred(instanceLabel);
-        const QString itemText = this->referenceItemText(instanceLabel, productLabel);
+        const QString itemText = this->referenceItemText(docTreeNode.document(), instanceLabel, productLabel);
         item->setText(0, itemText);
     }
     else {
-        item->setText(0, CafUtils::labelAttrStdName(label));
+        item->setText(0, docTreeNode.document()->labelName(label));
     }
 }
 
 QString WidgetModelTreeBuilder_Xde::referenceItemText(
-        const TDF_Label& instanceLabel, const TDF_Label& productLabel) const
+        const DocumentPtr& doc, const TDF_Label& instanceLabel, const TDF_Label& productLabel) const
 {
-    const QString instanceName = CafUtils::labelAttrStdName(instanceLabel).trimmed();
-    const QString productName = CafUtils::labelAttrStdName(productLabel).trimmed();
+    const QString instanceName = doc->labelName(instanceLabel).trimmed();
+    const QString productName = doc->labelName(productLabel).trimmed();
     const QByteArray strTemplate = Module::toInstanceNameTemplate(m_module->instanceNameFormat);
     QString itemText = QString::fromUtf8(strTemplate);
     itemText.replace("%instance", instanceName)
@@ -264,19 +300,4 @@ QString WidgetModelTreeBuilder_Xde::referenceItemText(
     return itemText;
 }
 
-QTreeWidgetItem* WidgetModelTreeBuilder_Xde::findTreeItem(
-        QTreeWidgetItem* parentTreeItem, const TDF_Label& label) const
-{
-    if (!parentTreeItem)
-        return nullptr;
-
-    for (QTreeWidgetItemIterator it(parentTreeItem); *it; ++it) {
-        const DocumentTreeNode node = WidgetModelTree::documentTreeNode(*it);
-        if (node.label() == label)
-            return *it;
-    }
-
-    return nullptr;
-}
-
 } // namespace Mayo
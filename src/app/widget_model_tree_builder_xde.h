@@ -18,6 +18,9 @@ public:
     void refreshTextTreeItem(const DocumentTreeNode& node, QTreeWidgetItem* treeItem) override;
     QTreeWidgetItem* createTreeItem(const DocumentTreeNode& node) override;
 
+    bool canFetchMore(const QTreeWidgetItem* treeItem) const override;
+    void fetchMore(QTreeWidgetItem* treeItem) override;
+
     void registerGuiApplication(GuiApplication* guiApp) override;
     WidgetModelTree_UserActions createUserActions(QObject* parent) override;
 
@@ -31,15 +34,18 @@ private:
     static QTreeWidgetItem* guiCreateXdeTreeNode(
             QTreeWidgetItem* guiParentNode, const DocumentTreeNode& node);
 
-    QTreeWidgetItem* buildXdeTree(QTreeWidgetItem* treeItem, const DocumentTreeNode& node);
+    QTreeWidgetItem* createXdeTreeItem(QTreeWidgetItem* parentTreeItem, const DocumentTreeNode& node);
+    TreeNodeId contentsNodeId(const DocumentTreeNode& node) const;
+    Qt::CheckState childCheckState(const QTreeWidgetItem* parentTreeItem, const DocumentTreeNode& node) const;
     void refreshXdeAssemblyNodeItemText(QTreeWidgetItem* item);
-    QString referenceItemText(const TDF_Label& instanceLabel, const TDF_Label& productLabel) const;
-    QTreeWidgetItem* findTreeItem(QTreeWidgetItem* parentTreeItem, const TDF_Label& label) const;
+    QString referenceItemText(
+            const DocumentPtr& doc, const TDF_Label& instanceLabel, const TDF_Label& productLabel) const;
 
     QByteArray instanceNameFormat() const;
     void setInstanceNameFormat(const QByteArray& format);
 
     Module* m_module = nullptr;
+    GuiApplication* m_guiApp = nullptr;
     bool m_isMergeXdeReferredShapeOn = true;
 };
 
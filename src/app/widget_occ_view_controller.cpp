@@ -6,6 +6,7 @@
 
 #include "widget_occ_view_controller.h"
 #include "widget_occ_view.h"
+#include "../gui/qtgui_utils.h"
 
 #include <QtCore/QDebug>
 #include <QtGui/QBitmap>
@@ -62,6 +63,7 @@ WidgetOccViewController::WidgetOccViewController(WidgetOccView* widgetView)
       m_widgetView(widgetView)
 {
     widgetView->installEventFilter(this);
+    this->setMouseMovedInterval(QtGuiUtils::screenFrameInterval());
 }
 
 bool WidgetOccViewController::eventFilter(QObject* watched, QEvent* event)
@@ -130,7 +132,18 @@ bool WidgetOccViewController::eventFilter(QObject* watched, QEvent* event)
         const QPoint currPos = m_widgetView->mapFromGlobal(mouseEvent->globalPos());
         const QPoint prevPos = m_prevPos;
         m_prevPos = currPos;
-        if (mouseEvent->buttons() == Qt::LeftButton) {
+        if (mouseEvent->buttons() == Qt::LeftButton
+                && (mouseEvent->modifiers() & Qt::ControlModifier || this->isRubberBandSelectionStarted()))
+        {
+            if (!this->isRubberBandSelectionStarted()) {
+                this->setViewCursor(Qt::CrossCursor);
+                this->startDynamicAction(DynamicAction::RubberBandSelection);
+                m_posRubberBandStart = prevPos;
+            }
+
+            this->drawRubberBand(m_posRubberBandStart, currPos);
+        }
+        else if (mouseEvent->buttons() == Qt::LeftButton) {
             if (!this->isRotationStarted()) {
                 this->setViewCursor(Internal::rotateCursor());
                 this->startDynamicAction(DynamicAction::Rotation);
@@ -157,7 +170,7 @@ bool WidgetOccViewController::eventFilter(QObject* watched, QEvent* event)
             this->drawRubberBand(m_posRubberBandStart, currPos);
         }
         else {
-            emit mouseMoved(currPos);
+            this->notifyMouseMoved(currPos);
         }
 
         break;
@@ -170,6 +183,11 @@ bool WidgetOccViewController::eventFilter(QObject* watched, QEvent* event)
             this->windowFitAll(m_posRubberBandStart, currPos);
             this->hideRubberBand();
         }
+        else if (this->isRubberBandSelectionStarted()) {
+            const QPoint currPos = m_widgetView->mapFromGlobal(mouseEvent->globalPos());
+            this->hideRubberBand();
+            emit rubberBandSelectionRequested(m_posRubberBandStart, currPos);
+        }
 
         this->setViewCursor(Qt::ArrowCursor);
         this->stopDynamicAction();
@@ -7,6 +7,7 @@
 #include "widget_properties_editor.h"
 #include "ui_widget_properties_editor.h"
 
+#include <deque>
 #include <vector>
 
 namespace Mayo {
@@ -21,12 +22,17 @@ public:
     QTreeWidgetItem* addLineWidgetItem(QWidget* widget, int height);
     QTreeWidgetItem* findTreeItem(const Property* property) const;
     bool hasGroup(const WidgetPropertiesEditor::Group* group) const;
+    QTreeWidgetItem* takePooledItem();
+    void poolItem(QTreeWidgetItem* treeItem);
 
     Ui_WidgetPropertiesEditor* ui = nullptr;
     PropertyItemDelegate* itemDelegate = nullptr;
     std::vector<Property*> vecProperty;
     std::vector<QWidget*> vecLineWidget;
-    std::vector<WidgetPropertiesEditor::Group> vecGroup;
+    std::deque<WidgetPropertiesEditor::Group> vecGroup; // Deque so pointers to groups stay valid
+    // Group and property items detached by clear(), reused afterwards instead of being allocated
+    // again each time the edited properties change(eg on selection change)
+    std::vector<QTreeWidgetItem*> vecPooledItem;
 };
 
 WidgetPropertiesEditor::WidgetPropertiesEditor(QWidget *parent)
@@ -44,6 +50,9 @@ WidgetPropertiesEditor::WidgetPropertiesEditor(QWidget *parent)
 
 WidgetPropertiesEditor::~WidgetPropertiesEditor()
 {
+    for (QTreeWidgetItem* treeItem : d->vecPooledItem)
+        delete treeItem;
+
     delete d->ui;
     delete d;
 }
@@ -51,10 +60,11 @@ WidgetPropertiesEditor::~WidgetPropertiesEditor()
 WidgetPropertiesEditor::Group* WidgetPropertiesEditor::addGroup(const QString& name)
 {
     Group grp = {};
-    grp.treeItem = new QTreeWidgetItem;
+    grp.treeItem = d->takePooledItem();
     grp.treeItem->setText(0, name);
-    grp.treeItem->setFirstColumnSpanned(true);
+    grp.treeItem->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
     d->ui->treeWidget_Browser->addTopLevelItem(grp.treeItem);
+    grp.treeItem->setFirstColumnSpanned(true);
     grp.treeItem->setExpanded(true);
     d->vecGroup.push_back(grp);
     return &d->vecGroup.back();
@@ -95,7 +105,25 @@ void WidgetPropertiesEditor::clear()
     d->vecProperty.clear();
     d->vecLineWidget.clear();
     d->vecGroup.clear();
-    d->ui->treeWidget_Browser->clear();
+    QTreeWidget* treeWidget = d->ui->treeWidget_Browser;
+    treeWidget->setUpdatesEnabled(false);
+    while (treeWidget->topLevelItemCount() > 0) {
+        const int index = treeWidget->topLevelItemCount() - 1;
+        // Line widgets can't be reused, their items are deleted along with them
+        const bool isLineWidgetItem = treeWidget->itemWidget(treeWidget->topLevelItem(index), 0) != nullptr;
+        QTreeWidgetItem* treeItem = treeWidget->takeTopLevelItem(index);
+        if (isLineWidgetItem) {
+            delete treeItem;
+        }
+        else {
+            for (QTreeWidgetItem* childItem : treeItem->takeChildren())
+                d->poolItem(childItem);
+
+            d->poolItem(treeItem);
+        }
+    }
+
+    treeWidget->setUpdatesEnabled(true);
 }
 
 void WidgetPropertiesEditor::setPropertyEnabled(const Property* prop, bool on)
@@ -156,7 +184,7 @@ void WidgetPropertiesEditor::Private::createQtProperty(
         Property* property, QTreeWidgetItem* parentItem)
 {
     this->vecProperty.push_back(property);
-    auto itemProp = new QTreeWidgetItem;
+    QTreeWidgetItem* itemProp = this->takePooledItem();
     const QString labelSpacer = parentItem ? "       " : "";
     itemProp->setText(0, labelSpacer + property->label());
     itemProp->setData(1, Qt::DisplayRole, QVariant::fromValue<Property*>(property));
@@ -203,4 +231,22 @@ bool WidgetPropertiesEditor::Private::hasGroup(const Group *group) const
             && group->treeItem->treeWidget() == ui->treeWidget_Browser;
 }
 
+QTreeWidgetItem* WidgetPropertiesEditor::Private::takePooledItem()
+{
+    if (this->vecPooledItem.empty())
+        return new QTreeWidgetItem;
+
+    QTreeWidgetItem* treeItem = this->vecPooledItem.back();
+    this->vecPooledItem.pop_back();
+    return treeItem;
+}
+
+void WidgetPropertiesEditor::Private::poolItem(QTreeWidgetItem* treeItem)
+{
+    // Pooled items must not refer to properties, these are about to be destroyed
+    treeItem->setText(0, QString());
+    treeItem->setData(1, Qt::DisplayRole, QVariant());
+    this->vecPooledItem.push_back(treeItem);
+}
+
 } // namespace Mayo
@@ -6,7 +6,9 @@
 
 #include "application.h"
 #include "document_tree_node_properties_provider.h"
+#include "global.h"
 #include "io_system.h"
+#include "occ_progress_indicator.h"
 #include "property_builtins.h"
 #include "qmeta_quantity_color.h"
 #include "settings.h"
@@ -15,6 +17,7 @@
 
 #include <BinXCAFDrivers_DocumentRetrievalDriver.hxx>
 #include <BinXCAFDrivers_DocumentStorageDriver.hxx>
+#include <Message.hxx>
 #include <XCAFApp_Application.hxx>
 #include <XmlXCAFDrivers_DocumentRetrievalDriver.hxx>
 #include <XmlXCAFDrivers_DocumentStorageDriver.hxx>
@@ -28,8 +31,13 @@
 #include <QtCore/QSettings>
 #include <QtCore/QtDebug>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace Mayo {
 
@@ -46,13 +54,99 @@ public:
 struct Application::Private {
     std::atomic<Document::Identifier> m_seqDocumentIdentifier = {};
     std::unordered_map<Document::Identifier, DocumentPtr> m_mapIdentifierDocument;
+    // Index of documents by canonical file path, see locationKey()
+    std::unordered_map<FilePath::string_type, Document::Identifier> m_mapLocationDocument;
+    std::unordered_map<Document::Identifier, FilePath::string_type> m_mapDocumentLocation;
+    // Serializes openDocument() which can be called from worker threads: OpenCascade document
+    // retrieval isn't reentrant and the document tables above are modified
+    std::mutex m_mutexOpenDocument;
+
+    static FilePath::string_type locationKey(const FilePath& fp);
+    void indexDocumentLocation(const DocumentPtr& doc);
+    void unindexDocumentLocation(Document::Identifier docIdent);
+    void releaseDocumentDataAsync(const DocumentPtr& doc);
+    void waitForDocumentDataReleased();
+    // Releases of closed documents still running, see Application::closeDocument()
+    std::vector<std::future<void>> m_vecFutureDocumentRelease;
+    std::mutex m_mutexDocumentRelease;
     Settings m_settings;
     IO::System m_ioSystem;
     DocumentTreeNodePropertiesProviderTable m_documentTreeNodePropertiesProviderTable;
 };
 
+// Canonical form of 'fp', so equivalent paths(relative, with "..", symbolic links) give the
+// same key. Trailing part of the path that doesn't exist is normalized lexically
+FilePath::string_type Application::Private::locationKey(const FilePath& fp)
+{
+    if (fp.empty())
+        return {};
+
+    std::error_code ec;
+    FilePath fpCanonical = std::filesystem::weakly_canonical(fp, ec);
+    if (ec)
+        fpCanonical = fp.lexically_normal();
+
+    return fpCanonical.native();
+}
+
+void Application::Private::indexDocumentLocation(const DocumentPtr& doc)
+{
+    this->unindexDocumentLocation(doc->identifier());
+    FilePath::string_type key = locationKey(doc->filePath());
+    if (!key.empty()) {
+        m_mapLocationDocument.insert_or_assign(key, doc->identifier());
+        m_mapDocumentLocation.insert({ doc->identifier(), std::move(key) });
+    }
+}
+
+void Application::Private::unindexDocumentLocation(Document::Identifier docIdent)
+{
+    auto itLocation = m_mapDocumentLocation.find(docIdent);
+    if (itLocation == m_mapDocumentLocation.end())
+        return;
+
+    // Location might be used by another document too, index entry is removed only if it's owned
+    auto itDoc = m_mapLocationDocument.find(itLocation->second);
+    if (itDoc != m_mapLocationDocument.end() && itDoc->second == docIdent)
+        m_mapLocationDocument.erase(itDoc);
+
+    m_mapDocumentLocation.erase(itLocation);
+}
+
+// Attributes of 'doc'(shapes, triangulations, names, ...) are forgotten by a worker thread
+// Document must be closed, so it isn't referenced anymore by the application or the GUI
+void Application::Private::releaseDocumentDataAsync(const DocumentPtr& doc)
+{
+    std::lock_guard<std::mutex> lock(m_mutexDocumentRelease); MAYO_UNUSED(lock);
+    m_vecFutureDocumentRelease.erase(
+                std::remove_if(
+                    m_vecFutureDocumentRelease.begin(),
+                    m_vecFutureDocumentRelease.end(),
+                    [](const std::future<void>& future) {
+                        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                    }),
+                m_vecFutureDocumentRelease.end());
+    m_vecFutureDocumentRelease.push_back(std::async(std::launch::async, [docReleased = doc]() mutable {
+        // Background users of the data(eg export of an items snapshot) must be done
+        docReleased->waitForDataUnused();
+        docReleased->Main().Root().ForgetAllAttributes(true/*clearChildren*/);
+        // Document object itself is deleted here if this was the last reference
+        docReleased.Nullify();
+    }));
+}
+
+void Application::Private::waitForDocumentDataReleased()
+{
+    std::lock_guard<std::mutex> lock(m_mutexDocumentRelease); MAYO_UNUSED(lock);
+    for (std::future<void>& future : m_vecFutureDocumentRelease)
+        future.wait();
+
+    m_vecFutureDocumentRelease.clear();
+}
+
 Application::~Application()
 {
+    d->waitForDocumentDataReleased();
     delete d;
 }
 
@@ -62,10 +156,18 @@ const ApplicationPtr& Application::instance()
     if (appPtr.IsNull()) {
         appPtr = new Application;
         const char strFougueCopyright[] = "Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>";
+        // Triangulations of faces are stored in binary documents, so they are displayed straight
+        // after being opened instead of being re-meshed
+        opencascade::handle<BinXCAFDrivers_DocumentStorageDriver> binStorageDriver =
+                new BinXCAFDrivers_DocumentStorageDriver;
+        binStorageDriver->SetWithTriangles(Message::DefaultMessenger(), true);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+        binStorageDriver->SetWithNormals(Message::DefaultMessenger(), true);
+#endif
         appPtr->DefineFormat(
                     Document::NameFormatBinary, qUtf8Printable(tr("Binary Mayo Document Format")), "myb",
                     new Document::FormatBinaryRetrievalDriver,
-                    new BinXCAFDrivers_DocumentStorageDriver);
+                    binStorageDriver);
         appPtr->DefineFormat(
                     Document::NameFormatXml, qUtf8Printable(tr("XML Mayo Document Format")), "myx",
                     new Document::FormatXmlRetrievalDriver,
@@ -73,6 +175,7 @@ const ApplicationPtr& Application::instance()
 
         qRegisterMetaType<TreeNodeId>("Mayo::TreeNodeId");
         qRegisterMetaType<TreeNodeId>("TreeNodeId");
+        qRegisterMetaType<std::vector<TreeNodeId>>("std::vector<Mayo::TreeNodeId>");
         qRegisterMetaType<DocumentPtr>("Mayo::DocumentPtr");
         qRegisterMetaType<DocumentPtr>("DocumentPtr");
     }
@@ -93,19 +196,46 @@ DocumentPtr Application::newDocument(Document::Format docFormat)
     return DocumentPtr::DownCast(stdDoc);
 }
 
-DocumentPtr Application::openDocument(const QString& filePath, PCDM_ReaderStatus* ptrReadStatus)
+DocumentPtr Application::openDocument(
+        const QString& filePath, PCDM_ReaderStatus* ptrReadStatus, TaskProgress* progress)
 {
+    std::lock_guard<std::mutex> lock(d->m_mutexOpenDocument); MAYO_UNUSED(lock);
     Handle_TDocStd_Document stdDoc;
+    Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
     const PCDM_ReaderStatus readStatus =
-            this->Open(StringUtils::toUtf16<TCollection_ExtendedString>(filePath), stdDoc);
+            this->Open(
+                StringUtils::toUtf16<TCollection_ExtendedString>(filePath),
+                stdDoc,
+                TKernelUtils::start(indicator));
     if (ptrReadStatus)
         *ptrReadStatus = readStatus;
 
     DocumentPtr doc = DocumentPtr::DownCast(stdDoc);
+    if (!doc.IsNull()) {
+        const FilePath fp = filepathFrom(filePath);
+        doc->setName(filepathTo<QString>(fp.stem()));
+        doc->setFilePath(fp);
+    }
+
     this->addDocument(doc);
     return doc;
 }
 
+PCDM_StoreStatus Application::saveDocumentAs(
+        const DocumentPtr& doc, const QString& filePath, TaskProgress* progress)
+{
+    Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
+    const PCDM_StoreStatus storeStatus =
+            this->SaveAs(
+                doc,
+                StringUtils::toUtf16<TCollection_ExtendedString>(filePath),
+                TKernelUtils::start(indicator));
+    if (storeStatus == PCDM_SS_OK)
+        doc->setFilePath(filepathFrom(filePath));
+
+    return storeStatus;
+}
+
 DocumentPtr Application::findDocumentByIndex(int docIndex) const
 {
     Handle_TDocStd_Document doc;
@@ -121,13 +251,9 @@ DocumentPtr Application::findDocumentByIdentifier(Document::Identifier docIdent)
 
 DocumentPtr Application::findDocumentByLocation(const FilePath& location) const
 {
-    for (const auto& mapPair : d->m_mapIdentifierDocument) {
-        const DocumentPtr& docPtr = mapPair.second;
-        if (filepathEquivalent(docPtr->filePath(), location))
-            return docPtr;
-    }
-
-    return DocumentPtr();
+    const FilePath::string_type key = Private::locationKey(location);
+    auto itFound = !key.empty() ? d->m_mapLocationDocument.find(key) : d->m_mapLocationDocument.end();
+    return itFound != d->m_mapLocationDocument.cend() ? this->findDocumentByIdentifier(itFound->second) : DocumentPtr();
 }
 
 int Application::findIndexOfDocument(const DocumentPtr& doc) const
@@ -142,7 +268,15 @@ int Application::findIndexOfDocument(const DocumentPtr& doc) const
 
 void Application::closeDocument(const DocumentPtr& doc)
 {
-    TDocStd_Application::Close(doc);
+    // Take a reference, 'doc' might be owned by an object deleted on signal documentAboutToClose()
+    DocumentPtr docClosed = doc;
+    TDocStd_Application::Close(docClosed);
+    d->releaseDocumentDataAsync(docClosed);
+}
+
+void Application::waitForClosedDocumentsReleased()
+{
+    d->waitForDocumentDataReleased();
 }
 
 Settings* Application::settings() const
@@ -162,6 +296,13 @@ DocumentTreeNodePropertiesProviderTable* Application::documentTreeNodeProperties
 
 void Application::setOpenCascadeEnvironment(const QString& settingsFilepath)
 {
+#ifdef MAYO_SCALABLE_MALLOC
+    // OpenCascade has no way to plug a custom Standard_MMgrRoot, but Standard_MMgrRaw forwards to
+    // malloc(), which is replaced by the scalable allocator. Option can still be set in settings
+    if (qEnvironmentVariableIsEmpty("MMGT_OPT"))
+        qputenv("MMGT_OPT", "0");
+#endif
+
     const QFileInfo fiSettingsFilepath(settingsFilepath);
     if (!fiSettingsFilepath.exists() || !fiSettingsFilepath.isReadable()) {
         qDebug().noquote() << tr("'%1' doesn't exist or is not readable").arg(settingsFilepath);
@@ -225,6 +366,23 @@ void Application::setOpenCascadeEnvironment(const QString& settingsFilepath)
     }
 }
 
+QString Application::openCascadeMemoryManager()
+{
+    // See Standard_MMgrFactory in OpenCascade source file Standard.cxx, MMGT_OPT=2 falls back
+    // to the raw manager if OpenCascade was built without TBB
+    QString malloc = "malloc";
+#ifdef MAYO_SCALABLE_MALLOC
+    malloc = MAYO_SCALABLE_MALLOC;
+#endif
+    const int mmgtOpt = qEnvironmentVariableIntValue("MMGT_OPT");
+    if (mmgtOpt == 1)
+        return "optimized";
+    else if (mmgtOpt == 2)
+        return "tbb";
+    else
+        return "raw/" + malloc;
+}
+
 void Application::NewDocument(
         const TCollection_ExtendedString& /*format*/,
         opencascade::handle<TDocStd_Document>& outDocument)
@@ -260,6 +418,17 @@ void Application::notifyDocumentAboutToClose(Document::Identifier docIdent)
     if (itFound != d->m_mapIdentifierDocument.end()) {
         emit this->documentAboutToClose(itFound->second);
         d->m_mapIdentifierDocument.erase(itFound);
+        d->unindexDocumentLocation(docIdent);
+    }
+}
+
+void Application::notifyDocumentFilePathChanged(Document::Identifier docIdent)
+{
+    // Documents not added yet(eg being opened) are indexed later by addDocument()
+    auto itFound = d->m_mapIdentifierDocument.find(docIdent);
+    if (itFound != d->m_mapIdentifierDocument.end()) {
+        d->indexDocumentLocation(itFound->second);
+        emit this->documentFilePathChanged(itFound->second);
     }
 }
 
@@ -268,8 +437,11 @@ void Application::addDocument(const DocumentPtr& doc)
     if (!doc.IsNull()) {
         doc->setIdentifier(d->m_seqDocumentIdentifier.fetch_add(1));
         d->m_mapIdentifierDocument.insert({ doc->identifier(), doc });
+        d->indexDocumentLocation(doc);
         this->InitDocument(doc);
         doc->initXCaf();
+        // Documents opened from file already contain entities
+        doc->rebuildModelTree();
 
         QObject::connect(
                     doc.get(), &Document::nameChanged,
@@ -277,9 +449,15 @@ void Application::addDocument(const DocumentPtr& doc)
         QObject::connect(
                     doc.get(), &Document::entityAdded,
                     this, [=](TreeNodeId entityId) { emit this->documentEntityAdded(doc, entityId); });
+        QObject::connect(
+                    doc.get(), &Document::entitiesAdded,
+                    this, [=](const std::vector<TreeNodeId>& vecEntityId) { emit this->documentEntitiesAdded(doc, vecEntityId); });
         QObject::connect(
                     doc.get(), &Document::entityAboutToBeDestroyed,
                     this, [=](TreeNodeId entityId) { emit this->documentEntityAboutToBeDestroyed(doc, entityId); });
+        QObject::connect(
+                    doc.get(), &Document::entitiesAboutToBeDestroyed,
+                    this, [=](const std::vector<TreeNodeId>& vecEntityId) { emit this->documentEntitiesAboutToBeDestroyed(doc, vecEntityId); });
 //      QObject::connect(
 //                  doc, &Document::itemPropertyChanged,
 //                  this, &Application::documentItemPropertyChanged);
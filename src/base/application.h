@@ -9,11 +9,13 @@
 #include "application_ptr.h"
 #include "document.h"
 #include <CDF_DirectoryIterator.hxx>
+#include <PCDM_StoreStatus.hxx>
 
 namespace Mayo {
 
 class Settings;
 class DocumentTreeNodePropertiesProviderTable;
+class TaskProgress;
 
 namespace IO { class System; }
 
@@ -37,19 +39,35 @@ public:
 
     int documentCount() const;
     DocumentPtr newDocument(Document::Format docFormat = Document::Format::Binary);
-    DocumentPtr openDocument(const QString& filePath, PCDM_ReaderStatus* ptrReadStatus = nullptr);
+    // Opens Mayo document(binary or XML) stored at 'filePath', entities are mapped in the model tree
+    // before the document is published with signal documentAdded()
+    DocumentPtr openDocument(
+            const QString& filePath,
+            PCDM_ReaderStatus* ptrReadStatus = nullptr,
+            TaskProgress* progress = nullptr);
+    // Stores 'doc' at 'filePath' along with the triangulations of its shapes
+    PCDM_StoreStatus saveDocumentAs(
+            const DocumentPtr& doc, const QString& filePath, TaskProgress* progress = nullptr);
     DocumentPtr findDocumentByIndex(int docIndex) const;
     DocumentPtr findDocumentByIdentifier(Document::Identifier docIdent) const;
     DocumentPtr findDocumentByLocation(const FilePath& location) const;
     int findIndexOfDocument(const DocumentPtr& doc) const;
 
+    // Closed document is detached at once from the application(signal documentAboutToClose() is
+    // emitted), its data is then released by a background thread
     void closeDocument(const DocumentPtr& doc);
+    // Blocks until the data of all closed documents was released
+    void waitForClosedDocumentsReleased();
 
     Settings* settings() const;
     IO::System* ioSystem() const;
     DocumentTreeNodePropertiesProviderTable* documentTreeNodePropertiesProviderTable() const;
 
     static void setOpenCascadeEnvironment(const QString& settingsFilepath);
+    // Memory manager of OpenCascade(behind Standard::Allocate()) as selected by variable MMGT_OPT
+    // Example: "raw/mimalloc" for malloc() replaced by the allocator linked with malloc.pri
+    // Only meaningful if MMGT_OPT wasn't changed since the first OpenCascade allocation
+    static QString openCascadeMemoryManager();
 
 public: //  from TDocStd_Application
     void NewDocument(
@@ -69,14 +87,18 @@ signals:
     void documentAdded(const Mayo::DocumentPtr& doc);
     void documentAboutToClose(const Mayo::DocumentPtr& doc);
     void documentNameChanged(const Mayo::DocumentPtr& doc, const QString& name);
+    void documentFilePathChanged(const Mayo::DocumentPtr& doc);
     void documentEntityAdded(const Mayo::DocumentPtr& doc, Mayo::TreeNodeId entityId);
+    void documentEntitiesAdded(const Mayo::DocumentPtr& doc, const std::vector<Mayo::TreeNodeId>& vecEntityId);
     void documentEntityAboutToBeDestroyed(const Mayo::DocumentPtr& doc, Mayo::TreeNodeId entityId);
+    void documentEntitiesAboutToBeDestroyed(const Mayo::DocumentPtr& doc, const std::vector<Mayo::TreeNodeId>& vecEntityId);
 
 private: // Implementation
     friend class Document;
 
     Application();
     void notifyDocumentAboutToClose(Document::Identifier docIdent);
+    void notifyDocumentFilePathChanged(Document::Identifier docIdent);
     void addDocument(const DocumentPtr& doc);
 
     struct Private;
@@ -6,6 +6,8 @@
 
 #include "application_item.h"
 
+#include <unordered_set>
+
 namespace Mayo {
 
 ApplicationItem::ApplicationItem(const DocumentPtr& doc)
@@ -54,4 +56,23 @@ bool ApplicationItem::operator==(const ApplicationItem& other) const
             && m_docTreeNode.id() == other.m_docTreeNode.id();
 }
 
+ApplicationItemsSnapshot::ApplicationItemsSnapshot(Span<const ApplicationItem> spanItem)
+{
+    auto data = std::make_shared<Data>();
+    data->vecItem.assign(spanItem.begin(), spanItem.end());
+    std::unordered_set<const Document*> setDoc;
+    for (const ApplicationItem& item : data->vecItem) {
+        const DocumentPtr doc = item.document();
+        if (doc && setDoc.insert(doc.get()).second)
+            data->vecDocumentDataUse.push_back(doc->acquireDataUse());
+    }
+
+    m_data = std::move(data);
+}
+
+Span<const ApplicationItem> ApplicationItemsSnapshot::items() const
+{
+    return m_data ? Span<const ApplicationItem>(m_data->vecItem) : Span<const ApplicationItem>();
+}
+
 } // namespace Mayo
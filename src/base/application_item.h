@@ -8,6 +8,10 @@
 
 #include "document.h"
 #include "document_tree_node.h"
+#include "span.h"
+
+#include <memory>
+#include <vector>
 
 namespace Mayo {
 
@@ -31,4 +35,24 @@ private:
     DocumentTreeNode m_docTreeNode;
 };
 
+// Immutable copy of application items, cheap to copy as the items are shared
+// Meant to be passed to background tasks(eg export) while the source items keep changing(eg the
+// selection). The data of the referenced documents is kept until the last copy of the snapshot is
+// destroyed, even if the documents are closed meanwhile
+class ApplicationItemsSnapshot {
+public:
+    ApplicationItemsSnapshot() = default;
+    explicit ApplicationItemsSnapshot(Span<const ApplicationItem> spanItem);
+
+    Span<const ApplicationItem> items() const;
+    bool empty() const { return this->items().empty(); }
+
+private:
+    struct Data {
+        std::vector<ApplicationItem> vecItem;
+        std::vector<std::shared_ptr<void>> vecDocumentDataUse; // One per distinct document
+    };
+    std::shared_ptr<const Data> m_data;
+};
+
 } // namespace Mayo
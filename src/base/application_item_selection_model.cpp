@@ -6,23 +6,9 @@
 
 #include "application_item_selection_model.h"
 
-namespace Mayo {
-
-namespace Internal {
-
-static bool hasApplicationItem(Span<ApplicationItem> vec, const ApplicationItem& item)
-{
-    auto itFound = std::find(vec.begin(), vec.end(), item);
-    return itFound != vec.end();
-}
-
-static std::vector<ApplicationItem>::iterator findApplicationItem(
-        std::vector<ApplicationItem>& vec, const ApplicationItem& item)
-{
-    return std::find(vec.begin(), vec.end(), item);
-}
+#include <algorithm>
 
-} // namespace Internal
+namespace Mayo {
 
 ApplicationItemSelectionModel::ApplicationItemSelectionModel(QObject* parent)
     : QObject(parent)
@@ -36,12 +22,12 @@ Span<const ApplicationItem> ApplicationItemSelectionModel::selectedItems() const
 
 bool ApplicationItemSelectionModel::isSelected(const ApplicationItem& item)
 {
-    return Internal::hasApplicationItem(m_vecSelectedItem, item);
+    return m_setSelectedItem.find(item) != m_setSelectedItem.end();
 }
 
 void ApplicationItemSelectionModel::add(const ApplicationItem& item)
 {
-    if (!Internal::hasApplicationItem(m_vecSelectedItem, item)) {
+    if (m_setSelectedItem.insert(item).second) {
         m_vecSelectedItem.push_back(item);
         std::vector<ApplicationItem> vecItem = { item };
         emit changed(vecItem, {});
@@ -51,8 +37,9 @@ void ApplicationItemSelectionModel::add(const ApplicationItem& item)
 void ApplicationItemSelectionModel::add(Span<ApplicationItem> vecItem)
 {
     std::vector<ApplicationItem> signalVecItem;
+    m_setSelectedItem.reserve(m_setSelectedItem.size() + vecItem.size());
     for (const ApplicationItem& item : vecItem) {
-        if (!Internal::hasApplicationItem(m_vecSelectedItem, item)) {
+        if (m_setSelectedItem.insert(item).second) {
             m_vecSelectedItem.push_back(item);
             signalVecItem.push_back(item);
         }
@@ -64,8 +51,8 @@ void ApplicationItemSelectionModel::add(Span<ApplicationItem> vecItem)
 
 void ApplicationItemSelectionModel::remove(const ApplicationItem& item)
 {
-    auto itFound = Internal::findApplicationItem(m_vecSelectedItem, item);
-    if (itFound != m_vecSelectedItem.end()) {
+    if (m_setSelectedItem.erase(item) != 0) {
+        auto itFound = std::find(m_vecSelectedItem.begin(), m_vecSelectedItem.end(), item);
         m_vecSelectedItem.erase(itFound);
         std::vector<ApplicationItem> vecItem = { item };
         emit changed({}, vecItem);
@@ -75,16 +62,23 @@ void ApplicationItemSelectionModel::remove(const ApplicationItem& item)
 void ApplicationItemSelectionModel::remove(Span<ApplicationItem> vecItem)
 {
     std::vector<ApplicationItem> signalVecItem;
+    std::unordered_set<ApplicationItem, ItemHasher> setRemovedItem;
     for (const ApplicationItem& item : vecItem) {
-        auto itFound = Internal::findApplicationItem(m_vecSelectedItem, item);
-        if (itFound != m_vecSelectedItem.end()) {
-            m_vecSelectedItem.erase(itFound);
+        if (m_setSelectedItem.erase(item) != 0) {
+            setRemovedItem.insert(item);
             signalVecItem.push_back(item);
         }
     }
 
-    if (!signalVecItem.empty())
+    if (!signalVecItem.empty()) {
+        // Single pass over the selection, remaining items keep their order
+        auto itNewEnd = std::remove_if(
+                    m_vecSelectedItem.begin(), m_vecSelectedItem.end(), [&](const ApplicationItem& item) {
+            return setRemovedItem.find(item) != setRemovedItem.end();
+        });
+        m_vecSelectedItem.erase(itNewEnd, m_vecSelectedItem.end());
         emit changed({}, signalVecItem);
+    }
 }
 
 void ApplicationItemSelectionModel::clear()
@@ -93,8 +87,20 @@ void ApplicationItemSelectionModel::clear()
         // Warning: slots connected to changed() signal may indirectly access m_vecSelectedItem
         const auto vecDeselectedItem = m_vecSelectedItem;
         m_vecSelectedItem.clear();
+        m_setSelectedItem.clear();
         emit changed({}, vecDeselectedItem);
     }
 }
 
+size_t ApplicationItemSelectionModel::ItemHasher::operator()(const ApplicationItem& item) const
+{
+    // Note: for a document item the tree node is null, so its id is 0
+    const DocumentTreeNode& node = item.documentTreeNode();
+    size_t hash = std::hash<const void*>{}(item.isDocument() ? item.document().get() : nullptr);
+    auto fnCombine = [&](size_t value) { hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2); };
+    fnCombine(std::hash<const void*>{}(node.document().get()));
+    fnCombine(std::hash<TreeNodeId>{}(node.id()));
+    return hash;
+}
+
 } // namespace Mayo
@@ -9,6 +9,8 @@
 #include "application_item.h"
 #include "span.h"
 #include <QtCore/QObject>
+#include <unordered_set>
+#include <vector>
 
 namespace Mayo {
 
@@ -34,7 +36,14 @@ signals:
     void changed(Span<const ApplicationItem> selected, Span<const ApplicationItem> deselected);
 
 private:
+    // Hash on (document, tree node id), consistent with ApplicationItem::operator==()
+    struct ItemHasher {
+        size_t operator()(const ApplicationItem& item) const;
+    };
+
+    // Vector keeps the selection order, set provides O(1) membership
     std::vector<ApplicationItem> m_vecSelectedItem;
+    std::unordered_set<ApplicationItem, ItemHasher> m_setSelectedItem;
 };
 
 } // namespace Mayo
@@ -0,0 +1,378 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "async_file_stream.h"
+#include "global.h"
+
+#include <QtCore/QtGlobal>
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+
+#if defined(Q_OS_UNIX)
+#  include <fcntl.h>
+#endif
+
+namespace Mayo {
+
+namespace {
+
+std::FILE* openFileSequential(const FilePath& filepath)
+{
+#if defined(Q_OS_WIN)
+    // "S" flag of the CRT: sequential access hint, ie FILE_FLAG_SEQUENTIAL_SCAN of CreateFile()
+    std::FILE* file = _wfopen(filepath.c_str(), L"rbS");
+#else
+    std::FILE* file = std::fopen(filepath.c_str(), "rb");
+#endif
+    if (!file)
+        return nullptr;
+
+    // Data is read by large blocks, the buffer of the C library would just add a copy
+    std::setvbuf(file, nullptr, _IONBF, 0);
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MACOS)
+    // Kernel read-ahead window is enlarged(doubled on Linux)
+    ::posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return file;
+}
+
+bool seekFile(std::FILE* file, uint64_t pos)
+{
+#if defined(Q_OS_WIN)
+    return _fseeki64(file, int64_t(pos), SEEK_SET) == 0;
+#else
+    return fseeko(file, off_t(pos), SEEK_SET) == 0;
+#endif
+}
+
+uint64_t fileSize(const FilePath& filepath)
+{
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(filepath, ec);
+    return !ec ? uint64_t(size) : 0;
+}
+
+} // namespace
+
+ReadAheadInputBuffer::ReadAheadInputBuffer(const FilePath& filepath, size_t blockSize, int queuedBlockCount)
+    : m_file(openFileSequential(filepath)),
+      m_fileSize(fileSize(filepath)),
+      m_blockSize(std::max<size_t>(blockSize, 1)),
+      m_queuedBlockCount(size_t(std::max(queuedBlockCount, 1)))
+{
+    if (m_file)
+        this->start(0);
+    else
+        this->setError("Can't open file");
+}
+
+ReadAheadInputBuffer::~ReadAheadInputBuffer()
+{
+    this->stop();
+    if (m_file)
+        std::fclose(m_file);
+}
+
+bool ReadAheadInputBuffer::hasError() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MAYO_UNUSED(lock);
+    return !m_errorMessage.empty();
+}
+
+std::string ReadAheadInputBuffer::errorMessage() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MAYO_UNUSED(lock);
+    return m_errorMessage;
+}
+
+ReadAheadInputBuffer::int_type ReadAheadInputBuffer::underflow()
+{
+    if (this->gptr() < this->egptr())
+        return traits_type::to_int_type(*this->gptr());
+
+    if (!m_thread.joinable())
+        return traits_type::eof();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condBlockPushed.wait(lock, [=]{ return !m_queueBlock.empty() || m_isFinished; });
+    if (m_queueBlock.empty())
+        return traits_type::eof();
+
+    m_currentBlockPos += m_currentBlock.size();
+    m_currentBlock = std::move(m_queueBlock.front());
+    m_queueBlock.pop_front();
+    lock.unlock();
+    m_condBlockPopped.notify_one();
+
+    char* ptr = m_currentBlock.data();
+    this->setg(ptr, ptr, ptr + m_currentBlock.size());
+    return traits_type::to_int_type(*ptr);
+}
+
+ReadAheadInputBuffer::pos_type ReadAheadInputBuffer::seekoff(
+        off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if (!(which & std::ios_base::in) || !m_file)
+        return pos_type(off_type(-1));
+
+    const uint64_t currentPos = m_currentBlockPos + uint64_t(this->gptr() - this->eback());
+    int64_t pos = off;
+    if (dir == std::ios_base::cur)
+        pos += int64_t(currentPos);
+    else if (dir == std::ios_base::end)
+        pos += int64_t(m_fileSize);
+
+    return this->seekpos(pos_type(off_type(pos)), which);
+}
+
+ReadAheadInputBuffer::pos_type ReadAheadInputBuffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    const auto offset = off_type(pos);
+    if (!(which & std::ios_base::in) || !m_file || offset < 0 || uint64_t(offset) > m_fileSize)
+        return pos_type(off_type(-1));
+
+    // Position within the current block, typically tellg() or a short move backward
+    const uint64_t targetPos = uint64_t(offset);
+    if (targetPos >= m_currentBlockPos && targetPos < m_currentBlockPos + m_currentBlock.size()) {
+        char* ptr = m_currentBlock.data();
+        this->setg(ptr, ptr + (targetPos - m_currentBlockPos), ptr + m_currentBlock.size());
+        return pos;
+    }
+
+    // Blocks read ahead are discarded
+    this->stop();
+    this->start(targetPos);
+    return pos;
+}
+
+void ReadAheadInputBuffer::start(uint64_t pos)
+{
+    m_queueBlock.clear();
+    m_currentBlock.clear();
+    m_currentBlockPos = pos;
+    this->setg(nullptr, nullptr, nullptr);
+    m_isFinished = false;
+    m_isStopRequested = false;
+    m_thread = std::thread([=]{ this->run(pos); });
+}
+
+void ReadAheadInputBuffer::stop()
+{
+    if (!m_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        MAYO_UNUSED(lock);
+        m_isStopRequested = true;
+    }
+
+    m_condBlockPopped.notify_one();
+    m_thread.join();
+}
+
+void ReadAheadInputBuffer::run(uint64_t pos)
+{
+    if (!seekFile(m_file, pos))
+        this->setError("File seek failed");
+
+    while (!this->hasError()) {
+        std::string block(m_blockSize, '\0');
+        const size_t readCount = std::fread(block.data(), 1, block.size(), m_file);
+        if (readCount < block.size() && std::ferror(m_file))
+            this->setError("File read failed");
+
+        if (readCount == 0)
+            break;
+
+        block.resize(readCount);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condBlockPopped.wait(lock, [=]{
+            return m_isStopRequested || m_queueBlock.size() < m_queuedBlockCount;
+        });
+        if (m_isStopRequested)
+            break;
+
+        m_queueBlock.push_back(std::move(block));
+        lock.unlock();
+        m_condBlockPushed.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        MAYO_UNUSED(lock);
+        m_isFinished = true;
+    }
+
+    m_condBlockPushed.notify_one();
+}
+
+void ReadAheadInputBuffer::setError(std::string_view msg)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MAYO_UNUSED(lock);
+    m_errorMessage = msg;
+}
+
+AsyncOutputBuffer::AsyncOutputBuffer(std::ostream& sink, size_t blockSize)
+    : m_sink(sink),
+      m_blockSize(std::max<size_t>(blockSize, 1))
+{
+    m_currentBlock.resize(m_blockSize);
+    m_pendingBlock.reserve(m_blockSize);
+    char* ptr = m_currentBlock.data();
+    this->setp(ptr, ptr + m_currentBlock.size());
+    m_thread = std::thread([=]{ this->run(); });
+}
+
+AsyncOutputBuffer::~AsyncOutputBuffer()
+{
+    this->sync();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        MAYO_UNUSED(lock);
+        m_isStopRequested = true;
+    }
+
+    m_condBlockSubmitted.notify_one();
+    m_thread.join();
+}
+
+bool AsyncOutputBuffer::hasError() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MAYO_UNUSED(lock);
+    return m_hasError;
+}
+
+AsyncOutputBuffer::int_type AsyncOutputBuffer::overflow(int_type ch)
+{
+    this->submitBlock();
+    if (this->hasError())
+        return traits_type::eof();
+
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *this->pptr() = traits_type::to_char_type(ch);
+        this->pbump(1);
+    }
+
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize AsyncOutputBuffer::xsputn(const char* data, std::streamsize count)
+{
+    std::streamsize writtenCount = 0;
+    while (writtenCount < count) {
+        if (this->pptr() == this->epptr()) {
+            this->submitBlock();
+            if (this->hasError())
+                break;
+        }
+
+        const auto chunkSize = std::min<std::streamsize>(count - writtenCount, this->epptr() - this->pptr());
+        std::memcpy(this->pptr(), data + writtenCount, size_t(chunkSize));
+        this->pbump(int(chunkSize));
+        writtenCount += chunkSize;
+    }
+
+    return writtenCount;
+}
+
+int AsyncOutputBuffer::sync()
+{
+    // Synchronization point: data is in 'sink' once returned, so errors can be reported
+    this->submitBlock();
+    if (!this->waitBlockWritten())
+        return -1;
+
+    return m_sink.flush().good() ? 0 : -1;
+}
+
+void AsyncOutputBuffer::run()
+{
+    for (;;) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condBlockSubmitted.wait(lock, [=]{ return m_isPending || m_isStopRequested; });
+        if (!m_isPending)
+            return; // Stop requested
+
+        lock.unlock();
+        // Block is owned by the worker thread until 'm_isPending' is reset
+        m_sink.write(m_pendingBlock.data(), std::streamsize(m_pendingBlock.size()));
+        const bool okWrite = m_sink.good();
+        lock.lock();
+        m_hasError = m_hasError || !okWrite;
+        m_isPending = false;
+        lock.unlock();
+        m_condBlockWritten.notify_one();
+    }
+}
+
+void AsyncOutputBuffer::submitBlock()
+{
+    const auto size = size_t(this->pptr() - this->pbase());
+    if (size == 0 || !this->waitBlockWritten())
+        return;
+
+    // Buffers are swapped, the worker thread being idle. Capacities are kept by resize()
+    m_pendingBlock.swap(m_currentBlock);
+    m_pendingBlock.resize(size);
+    m_currentBlock.resize(m_blockSize);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        MAYO_UNUSED(lock);
+        m_isPending = true;
+    }
+
+    m_condBlockSubmitted.notify_one();
+    char* ptr = m_currentBlock.data();
+    this->setp(ptr, ptr + m_currentBlock.size());
+}
+
+bool AsyncOutputBuffer::waitBlockWritten()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condBlockWritten.wait(lock, [=]{ return !m_isPending; });
+    return !m_hasError;
+}
+
+ReadAheadInputStream::ReadAheadInputStream(const FilePath& filepath)
+    : std::istream(nullptr),
+      m_buffer(filepath)
+{
+    this->rdbuf(&m_buffer);
+    if (!m_buffer.isOpen())
+        this->setstate(std::ios_base::failbit);
+}
+
+AsyncOutputStream::AsyncOutputStream(std::ostream& sink)
+    : std::ostream(nullptr),
+      m_buffer(sink)
+{
+    this->rdbuf(&m_buffer);
+}
+
+AsyncFileOutputStream::AsyncFileOutputStream(const FilePath& filepath)
+    : std::ostream(nullptr),
+      m_file(filepath, std::ios::out | std::ios::binary),
+      m_buffer(m_file)
+{
+    this->rdbuf(&m_buffer);
+    if (!m_file.is_open())
+        this->setstate(std::ios_base::failbit);
+}
+
+bool AsyncFileOutputStream::close()
+{
+    const bool okFlush = this->flush().good();
+    m_file.close();
+    return okFlush && !m_buffer.hasError() && m_file.good();
+}
+
+} // namespace Mayo
@@ -0,0 +1,154 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "filepath.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace Mayo {
+
+// Read-only stream buffer over file 'filepath', large blocks are read ahead on a worker thread so
+// the I/O latency(eg network shares) overlaps with the parsing of the data by the stream reader
+// File is opened with the sequential access hint of the platform(posix_fadvise(), or the "S" mode
+// of the Windows CRT which maps to FILE_FLAG_SEQUENTIAL_SCAN)
+// Seeking is supported, read-ahead then restarts from the new position
+class ReadAheadInputBuffer : public std::streambuf {
+public:
+    static constexpr size_t DefaultBlockSize = 1024 * 1024;
+    static constexpr int DefaultQueuedBlockCount = 8;
+
+    ReadAheadInputBuffer(
+            const FilePath& filepath,
+            size_t blockSize = DefaultBlockSize,
+            int queuedBlockCount = DefaultQueuedBlockCount);
+    ~ReadAheadInputBuffer();
+
+    bool isOpen() const { return m_file != nullptr; }
+
+    // Error message set by the worker thread, eg read failure
+    // Should be checked after the stream was read, as an error just ends the stream prematurely
+    bool hasError() const;
+    std::string errorMessage() const;
+
+protected:
+    int_type underflow() override;
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+private:
+    void start(uint64_t pos);
+    void stop();
+    void run(uint64_t pos);
+    void setError(std::string_view msg);
+
+    std::FILE* m_file = nullptr;
+    uint64_t m_fileSize = 0;
+    size_t m_blockSize = DefaultBlockSize;
+    size_t m_queuedBlockCount = DefaultQueuedBlockCount;
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condBlockPushed;
+    std::condition_variable m_condBlockPopped;
+    std::deque<std::string> m_queueBlock;
+    std::string m_currentBlock; // Exposed as get area
+    uint64_t m_currentBlockPos = 0; // Position of 'm_currentBlock' in the file
+    std::string m_errorMessage;
+    bool m_isFinished = false;
+    bool m_isStopRequested = false;
+};
+
+// Write-only stream buffer forwarding data to 'sink' on a worker thread, with double buffering:
+// the writer fills a block while the previous one is being written into 'sink'
+// Blocks are written once full, or on sync()(eg std::ostream::flush()). Seeking isn't supported
+class AsyncOutputBuffer : public std::streambuf {
+public:
+    static constexpr size_t DefaultBlockSize = 1024 * 1024;
+
+    AsyncOutputBuffer(std::ostream& sink, size_t blockSize = DefaultBlockSize);
+    ~AsyncOutputBuffer();
+
+    // Whether writing into 'sink' failed, the data written afterwards is then discarded
+    bool hasError() const;
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+    int sync() override;
+
+private:
+    void run();
+    // Hands the current block over to the worker thread, once the previous one is written
+    void submitBlock();
+    // Blocks until the worker thread is idle, returns false on error
+    bool waitBlockWritten();
+
+    std::ostream& m_sink;
+    size_t m_blockSize = DefaultBlockSize;
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condBlockSubmitted;
+    std::condition_variable m_condBlockWritten;
+    std::string m_currentBlock; // Exposed as put area
+    std::string m_pendingBlock; // Being written by the worker thread
+    bool m_isPending = false;
+    bool m_hasError = false;
+    bool m_isStopRequested = false;
+};
+
+// Input stream over ReadAheadInputBuffer
+class ReadAheadInputStream : public std::istream {
+public:
+    ReadAheadInputStream(const FilePath& filepath);
+
+    const ReadAheadInputBuffer& buffer() const { return m_buffer; }
+
+private:
+    ReadAheadInputBuffer m_buffer;
+};
+
+// Output stream over AsyncOutputBuffer, data is flushed into 'sink' on destruction
+class AsyncOutputStream : public std::ostream {
+public:
+    AsyncOutputStream(std::ostream& sink);
+
+    const AsyncOutputBuffer& buffer() const { return m_buffer; }
+
+private:
+    AsyncOutputBuffer m_buffer;
+};
+
+// Output stream into file 'filepath' over AsyncOutputBuffer, so data is formatted by the writer
+// while the previous block is written into the file
+// close() must be called to know whether all data could be written
+class AsyncFileOutputStream : public std::ostream {
+public:
+    AsyncFileOutputStream(const FilePath& filepath);
+
+    bool isOpen() const { return m_file.is_open(); }
+
+    // Writes the pending data then closes the file, returns false if some write failed
+    bool close();
+
+private:
+    std::ofstream m_file; // Declared first, so it outlives 'm_buffer'
+    AsyncOutputBuffer m_buffer;
+};
+
+} // namespace Mayo
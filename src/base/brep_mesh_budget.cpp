@@ -0,0 +1,298 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "brep_mesh_budget.h"
+#include "bnd_utils.h"
+#include "brep_mesh_quality.h"
+#include "brep_utils.h"
+#include "cpp_utils.h"
+#include "job_arena.h"
+#include "task_progress.h"
+
+#include <BRepAdaptor_Surface.hxx>
+#include <BRepGProp.hxx>
+#include <BRepLProp_SLProps.hxx>
+#include <BRepTools.hxx>
+#include <BRep_Tool.hxx>
+#include <GProp_GProps.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Precision.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <TopTools_MapOfShape.hxx>
+#include <algorithm>
+#include <cmath>
+
+namespace Mayo {
+
+namespace {
+
+// Faces without location nor orientation, so instances of the same face are found once
+void addUniqueFaces(const TopoDS_Shape& shape, TopTools_IndexedMapOfShape* ptrMapFace)
+{
+    BRepUtils::forEachSubFace(shape, [=](const TopoDS_Face& face) {
+        ptrMapFace->Add(face.Located(TopLoc_Location()).Oriented(TopAbs_FORWARD));
+    });
+}
+
+double shapeSize(const Bnd_Box& shapeBndBox)
+{
+    Bnd_Box bndBox = shapeBndBox;
+    if (bndBox.IsVoid())
+        return 0;
+
+    if (BndUtils::isOpen(bndBox)) {
+        if (!BndUtils::hasFinitePart(bndBox))
+            return 0;
+
+        bndBox = BndUtils::finitePart(bndBox);
+    }
+
+    const auto coords = BndBoxCoords::get(bndBox);
+    const gp_XYZ diag = coords.maxVertex().XYZ() - coords.minVertex().XYZ();
+    return std::max({ diag.X(), diag.Y(), diag.Z() });
+}
+
+BRepMeshBudget::ShapeEstimate::Face estimateFace(const TopoDS_Face& face)
+{
+    BRepMeshBudget::ShapeEstimate::Face faceEstimate = {};
+    for (TopExp_Explorer expl(face, TopAbs_EDGE); expl.More(); expl.Next())
+        ++faceEstimate.edgeCount;
+
+    GProp_GProps props;
+    BRepGProp::SurfaceProperties(face, props);
+    faceEstimate.area = std::abs(props.Mass());
+
+    const BRepAdaptor_Surface surface(face, false);
+    if (surface.GetType() == GeomAbs_Plane)
+        return faceEstimate;
+
+    // Curvatures sampled on a grid of the parametric bounds of the face
+    constexpr int sampleCount = 3;
+    double u1, u2, v1, v2;
+    BRepTools::UVBounds(face, u1, u2, v1, v2);
+    BRepLProp_SLProps lprops(surface, 2, Precision::Confusion());
+    double curvatureSum = 0;
+    int curvatureCount = 0;
+    for (int i = 0; i < sampleCount; ++i) {
+        for (int j = 0; j < sampleCount; ++j) {
+            const double u = u1 + (i + 0.5) * (u2 - u1) / sampleCount;
+            const double v = v1 + (j + 0.5) * (v2 - v1) / sampleCount;
+            lprops.SetParameters(u, v);
+            if (lprops.IsCurvatureDefined()) {
+                curvatureSum += std::max(std::abs(lprops.MaxCurvature()), std::abs(lprops.MinCurvature()));
+                ++curvatureCount;
+            }
+        }
+    }
+
+    faceEstimate.curvature = curvatureCount > 0 ? curvatureSum / curvatureCount : 0.;
+    return faceEstimate;
+}
+
+// Removes the triangulations of the faces having a surface, so they are all meshed again
+void cleanMeshes(const TopoDS_Shape& shape)
+{
+    TopTools_IndexedMapOfShape mapFace(1, JobArena::current());
+    addUniqueFaces(shape, &mapFace);
+    for (int i = 1; i <= mapFace.Extent(); ++i) {
+        const TopoDS_Face& face = TopoDS::Face(mapFace.FindKey(i));
+        if (!BRep_Tool::Surface(face).IsNull())
+            BRepTools::Clean(face);
+    }
+}
+
+OccBRepMeshParameters meshParameters(double deflection, const BRepMeshBudget::Parameters& params)
+{
+    OccBRepMeshParameters meshParams = brepMeshBaseParameters();
+    meshParams.Deflection = deflection;
+    meshParams.Angle = params.angularDeflection;
+    return meshParams;
+}
+
+} // namespace
+
+BRepMeshBudget::ShapeEstimate BRepMeshBudget::estimate(const TopoDS_Shape& shape)
+{
+    ShapeEstimate shapeEstimate;
+    shapeEstimate.size = shapeSize(BRepUtils::boundingBox(shape));
+    TopTools_IndexedMapOfShape mapFace(1, JobArena::current());
+    addUniqueFaces(shape, &mapFace);
+    std::vector<TopoDS_Face> vecSurfaceFace;
+    for (int i = 1; i <= mapFace.Extent(); ++i) {
+        const TopoDS_Face& face = TopoDS::Face(mapFace.FindKey(i));
+        if (!BRep_Tool::Surface(face).IsNull()) {
+            vecSurfaceFace.push_back(face);
+        }
+        else {
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+            shapeEstimate.fixedTriangleCount += !triangulation.IsNull() ? triangulation->NbTriangles() : 0;
+        }
+    }
+
+    shapeEstimate.vecFace.resize(vecSurfaceFace.size());
+    CppUtils::parallelFor(int(vecSurfaceFace.size()), [&](int i) {
+        shapeEstimate.vecFace.at(i) = estimateFace(vecSurfaceFace.at(i));
+    });
+    return shapeEstimate;
+}
+
+double BRepMeshBudget::estimatedTriangleCount(
+        const ShapeEstimate& estimate, double deflection, double angularDeflection)
+{
+    // Length of the triangle edges is bounded by the chordal deflection('sagitta' of an arc of
+    // curvature k is about k*h^2/8) and by the angular deflection(angle between normals is about k*h)
+    // Triangles are assumed to be equilateral, faces are at least split along their edges
+    constexpr double equilateralAreaFactor = 0.4330127018922193; // sqrt(3)/4
+    double count = double(estimate.fixedTriangleCount);
+    for (const ShapeEstimate::Face& face : estimate.vecFace) {
+        const double boundaryCount = 2. * std::max(face.edgeCount, 1);
+        if (face.curvature <= Precision::Confusion() || face.area <= 0) {
+            count += boundaryCount;
+            continue;
+        }
+
+        const double hChordal = std::sqrt(8 * deflection / face.curvature);
+        const double hAngular = angularDeflection / face.curvature;
+        const double h = std::min(hChordal, hAngular);
+        count += std::max(boundaryCount, face.area / (equilateralAreaFactor * h * h));
+    }
+
+    return count;
+}
+
+double BRepMeshBudget::shapeDeflection(double globalDeflection, double shapeSize, const Parameters& params)
+{
+    if (shapeSize <= 0)
+        return globalDeflection;
+
+    return std::min(globalDeflection, params.maxRelativeDeflection * shapeSize);
+}
+
+OccBRepMeshParameters BRepMeshBudget::shapeMeshParameters(
+        double globalDeflection, const Bnd_Box& shapeBndBox, const Parameters& params)
+{
+    const double deflection = BRepMeshBudget::shapeDeflection(globalDeflection, shapeSize(shapeBndBox), params);
+    return meshParameters(deflection, params);
+}
+
+double BRepMeshBudget::solveGlobalDeflection(Span<const ShapeEstimate> spanEstimate, const Parameters& params)
+{
+    double maxShapeSize = 0;
+    for (const ShapeEstimate& estimate : spanEstimate)
+        maxShapeSize = std::max(maxShapeSize, estimate.size);
+
+    if (maxShapeSize <= 0)
+        return -1;
+
+    auto fnTotalCount = [&](double globalDeflection) {
+        double count = 0;
+        for (const ShapeEstimate& estimate : spanEstimate) {
+            const double deflection = BRepMeshBudget::shapeDeflection(globalDeflection, estimate.size, params);
+            count += BRepMeshBudget::estimatedTriangleCount(estimate, deflection, params.angularDeflection);
+        }
+
+        return count;
+    };
+
+    // Estimated count decreases as deflection increases, deflection of all the shapes is clamped
+    // beyond 'highDeflection'
+    const double targetCount = double(std::max<int64_t>(params.triangleCount, 1));
+    double highDeflection = params.maxRelativeDeflection * maxShapeSize;
+    double lowDeflection = 1e-6 * highDeflection;
+    if (fnTotalCount(highDeflection) >= targetCount)
+        return highDeflection;
+
+    if (fnTotalCount(lowDeflection) <= targetCount)
+        return lowDeflection;
+
+    // Bisection in log scale, deflections spanning several orders of magnitude
+    for (int i = 0; i < 64; ++i) {
+        const double midDeflection = std::sqrt(lowDeflection * highDeflection);
+        const double count = fnTotalCount(midDeflection);
+        if (std::abs(count / targetCount - 1) < params.tolerance / 4)
+            return midDeflection;
+
+        if (count > targetCount)
+            lowDeflection = midDeflection;
+        else
+            highDeflection = midDeflection;
+    }
+
+    return std::sqrt(lowDeflection * highDeflection);
+}
+
+BRepMeshBudget::Result BRepMeshBudget::computeMesh(
+        Span<const TopoDS_Shape> spanShape, const Parameters& params, TaskProgress* progress)
+{
+    Result result;
+    std::vector<ShapeEstimate> vecEstimate;
+    {
+        TaskProgress estimateProgress(progress, 10);
+        for (const TopoDS_Shape& shape : spanShape) {
+            if (TaskProgress::isAbortRequested(progress))
+                return result;
+
+            vecEstimate.push_back(BRepMeshBudget::estimate(shape));
+            estimateProgress.setValue(int((vecEstimate.size() * 100) / spanShape.size()));
+        }
+    }
+
+    result.globalDeflection = BRepMeshBudget::solveGlobalDeflection(vecEstimate, params);
+    if (result.globalDeflection <= 0)
+        return result;
+
+    auto fnMesh = [&](double globalDeflection, TaskProgress* meshProgress) {
+        std::vector<OccBRepMeshParameters> vecParams;
+        for (size_t i = 0; i < spanShape.size(); ++i) {
+            const double deflection = BRepMeshBudget::shapeDeflection(globalDeflection, vecEstimate.at(i).size, params);
+            vecParams.push_back(meshParameters(deflection, params));
+            cleanMeshes(spanShape[i]);
+        }
+
+        const std::vector<BRepUtils::MeshJob> vecJob = BRepUtils::createMeshJobs(spanShape, vecParams);
+        BRepUtils::computeMesh(vecJob, meshProgress);
+        return BRepMeshBudget::triangleCount(spanShape);
+    };
+
+    {
+        TaskProgress meshProgress(progress, 60);
+        result.triangleCount = fnMesh(result.globalDeflection, &meshProgress);
+    }
+
+    // Triangle count is about inversely proportional to deflection, correct it once
+    const double targetCount = double(std::max<int64_t>(params.triangleCount, 1));
+    const double ratio = result.triangleCount / targetCount;
+    if (std::abs(ratio - 1) > params.tolerance && result.triangleCount > 0
+            && !TaskProgress::isAbortRequested(progress))
+    {
+        TaskProgress meshProgress(progress, 30);
+        result.globalDeflection *= std::clamp(ratio, 0.01, 100.);
+        result.triangleCount = fnMesh(result.globalDeflection, &meshProgress);
+    }
+
+    return result;
+}
+
+int64_t BRepMeshBudget::triangleCount(Span<const TopoDS_Shape> spanShape)
+{
+    int64_t count = 0;
+    TopTools_MapOfShape mapFace(1, JobArena::current());
+    for (const TopoDS_Shape& shape : spanShape) {
+        BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+            if (!mapFace.Add(face.Located(TopLoc_Location()).Oriented(TopAbs_FORWARD)))
+                return;
+
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+            count += !triangulation.IsNull() ? triangulation->NbTriangles() : 0;
+        });
+    }
+
+    return count;
+}
+
+} // namespace Mayo
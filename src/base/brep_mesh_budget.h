@@ -0,0 +1,79 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "occ_brep_mesh_parameters.h"
+#include "span.h"
+
+#include <Bnd_Box.hxx>
+#include <TopoDS_Shape.hxx>
+#include <cstdint>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// BRep meshing driven by a global count of triangles(ie "triangle budget")
+// Triangle count of each face is estimated from its area and curvature for a given deflection,
+// then the deflection is solved so that the estimated count of all the shapes matches the budget
+// Shapes share the same chordal deflection, so big shapes get more triangles than small ones as
+// they do on screen. Deflection of a shape is clamped to a ratio of its size, so that small shapes
+// remain recognizable
+struct BRepMeshBudget {
+    struct Parameters {
+        int64_t triangleCount = 2000000;
+        // Accepted relative deviation of the actual triangle count from 'triangleCount'
+        double tolerance = 0.1;
+        double angularDeflection = 0.3490658503988659; // 20 degrees, in radians
+        // Maximum ratio of the chordal deflection of a shape to its size(largest extent of its
+        // bounding box)
+        double maxRelativeDeflection = 0.03;
+    };
+
+    // Estimation data of the distinct faces of a shape
+    struct ShapeEstimate {
+        struct Face {
+            double area;
+            double curvature; // Mean of the maximum absolute curvatures sampled on the surface
+            int edgeCount;
+        };
+
+        double size = 0; // Largest extent of the bounding box
+        std::vector<Face> vecFace;
+        int64_t fixedTriangleCount = 0; // Triangles of faces without surface(mesh-only faces)
+    };
+
+    // Instances of the same face are estimated once, faces are sampled concurrently
+    static ShapeEstimate estimate(const TopoDS_Shape& shape);
+    static double estimatedTriangleCount(const ShapeEstimate& estimate, double deflection, double angularDeflection);
+
+    // Chordal deflection of a shape of size 'shapeSize', given the global deflection
+    static double shapeDeflection(double globalDeflection, double shapeSize, const Parameters& params);
+    static OccBRepMeshParameters shapeMeshParameters(
+            double globalDeflection, const Bnd_Box& shapeBndBox, const Parameters& params);
+
+    // Global deflection such that the estimated triangle count of all the shapes is about
+    // 'params.triangleCount'. Returns -1 if there's nothing to mesh
+    static double solveGlobalDeflection(Span<const ShapeEstimate> spanEstimate, const Parameters& params);
+
+    struct Result {
+        double globalDeflection = -1;
+        int64_t triangleCount = 0;
+    };
+
+    // Meshes 'spanShape' in a single batch(see BRepUtils::createMeshJobs()), current triangulations
+    // of the faces are replaced. If the actual triangle count deviates from the budget by more
+    // than 'params.tolerance' then the global deflection is corrected and shapes are meshed again
+    static Result computeMesh(
+            Span<const TopoDS_Shape> spanShape, const Parameters& params, TaskProgress* progress = nullptr);
+
+    // Count of triangles of the distinct faces of 'spanShape'
+    static int64_t triangleCount(Span<const TopoDS_Shape> spanShape);
+};
+
+} // namespace Mayo
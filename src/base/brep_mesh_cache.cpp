@@ -0,0 +1,259 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "brep_mesh_cache.h"
+#include "brep_utils.h"
+#include "job_arena.h"
+
+#include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <TopTools_MapOfShape.hxx>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+#include <initializer_list>
+#include <vector>
+
+namespace Mayo {
+
+namespace {
+
+constexpr quint32 entryMagicNumber = 0x4d594d43; // "MYMC"
+constexpr quint32 entryVersion = 1;
+constexpr QDataStream::Version entryStreamVersion = QDataStream::Qt_5_6;
+
+// Faces of 'shape' without locations, instances of the same face are found once
+std::vector<TopoDS_Face> uniqueFaces(const TopoDS_Shape& shape)
+{
+    std::vector<TopoDS_Face> vecFace;
+    TopTools_MapOfShape mapFace(1, JobArena::current());
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        const TopoDS_Shape faceUnlocated = face.Located(TopLoc_Location());
+        if (mapFace.Add(faceUnlocated))
+            vecFace.push_back(TopoDS::Face(faceUnlocated));
+    });
+    return vecFace;
+}
+
+// Sub-shape counts stored in entries, checked to detect a shape not matching a cache entry
+struct TopologyCounts {
+    quint32 faceCount = 0;
+    quint32 edgeCount = 0;
+    quint32 vertexCount = 0;
+
+    bool operator==(const TopologyCounts& other) const {
+        return this->faceCount == other.faceCount
+                && this->edgeCount == other.edgeCount
+                && this->vertexCount == other.vertexCount;
+    }
+};
+
+TopologyCounts topologyCounts(const TopoDS_Shape& shape, const std::vector<TopoDS_Face>& vecFace)
+{
+    TopTools_IndexedMapOfShape mapEdge(1, JobArena::current());
+    TopTools_IndexedMapOfShape mapVertex(1, JobArena::current());
+    TopExp::MapShapes(shape, TopAbs_EDGE, mapEdge);
+    TopExp::MapShapes(shape, TopAbs_VERTEX, mapVertex);
+    return { quint32(vecFace.size()), quint32(mapEdge.Extent()), quint32(mapVertex.Extent()) };
+}
+
+} // namespace
+
+BRepMeshCache::BRepMeshCache(const FilePath& dirPath)
+    : m_dirPath(dirPath)
+{
+}
+
+QByteArray BRepMeshCache::sourceHash(const FilePath& fp)
+{
+    QFile file(filepathTo<QString>(fp));
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file))
+        return {};
+
+    return hash.result();
+}
+
+FilePath BRepMeshCache::entryFilePath(const Key& key) const
+{
+    QByteArray bytesKey;
+    QDataStream stream(&bytesKey, QIODevice::WriteOnly);
+    stream << key.sourceHash
+           << qint32(key.shapeIndex)
+           << key.params.Deflection
+           << key.params.Angle
+           << bool(key.params.Relative);
+    const QByteArray keyHash = QCryptographicHash::hash(bytesKey, QCryptographicHash::Sha1);
+    return m_dirPath / (keyHash.toHex().toStdString() + ".mayomesh");
+}
+
+bool BRepMeshCache::attachTriangulations(const Key& key, const TopoDS_Shape& shape) const
+{
+    QFile file(filepathTo<QString>(this->entryFilePath(key)));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(entryStreamVersion);
+    quint32 magicNumber = 0;
+    quint32 version = 0;
+    stream >> magicNumber >> version;
+    if (magicNumber != entryMagicNumber || version != entryVersion)
+        return false;
+
+    const std::vector<TopoDS_Face> vecFace = uniqueFaces(shape);
+    TopologyCounts entryCounts;
+    stream >> entryCounts.faceCount >> entryCounts.edgeCount >> entryCounts.vertexCount;
+    if (!(entryCounts == topologyCounts(shape, vecFace)))
+        return false;
+
+    // Entry matches the key and the topology but its data is corrupted, it's removed so the
+    // caller meshes the shape and stores a valid entry again
+    auto fnEvict = [&]{
+        file.close();
+        file.remove();
+        return false;
+    };
+
+    // Read all triangulations before assigning them, so 'shape' is left untouched on error
+    std::vector<Handle_Poly_Triangulation> vecTriangulation;
+    vecTriangulation.reserve(vecFace.size());
+    for (unsigned i = 0; i < vecFace.size(); ++i) {
+        qint32 nodeCount = 0;
+        qint32 triangleCount = 0;
+        bool hasUvNodes = false;
+        double deflection = 0.;
+        stream >> nodeCount >> triangleCount >> hasUvNodes >> deflection;
+        if (stream.status() != QDataStream::Ok || nodeCount < 0 || triangleCount < 0)
+            return fnEvict();
+
+        // Protect against corrupted entry, so no huge arrays get allocated
+        const qint64 nodesSize = qint64(nodeCount) * 3 * sizeof(double);
+        const qint64 trianglesSize = qint64(triangleCount) * 3 * sizeof(qint32);
+        if (nodesSize + trianglesSize > file.size() - file.pos())
+            return fnEvict();
+
+        // A face triangulation has at least one triangle, or is empty(face wasn't meshed)
+        if ((nodeCount == 0) != (triangleCount == 0) || (nodeCount > 0 && nodeCount < 3))
+            return fnEvict();
+
+        if (nodeCount == 0) {
+            vecTriangulation.push_back({});
+            continue;
+        }
+
+        Handle_Poly_Triangulation triangulation =
+                new Poly_Triangulation(nodeCount, triangleCount, hasUvNodes);
+        triangulation->Deflection(deflection);
+        TColgp_Array1OfPnt& vecNode = triangulation->ChangeNodes();
+        for (int iNode = 1; iNode <= nodeCount; ++iNode) {
+            double x, y, z;
+            stream >> x >> y >> z;
+            vecNode.ChangeValue(iNode).SetCoord(x, y, z);
+        }
+
+        if (hasUvNodes) {
+            TColgp_Array1OfPnt2d& vecUvNode = triangulation->ChangeUVNodes();
+            for (int iNode = 1; iNode <= nodeCount; ++iNode) {
+                double u, v;
+                stream >> u >> v;
+                vecUvNode.ChangeValue(iNode).SetCoord(u, v);
+            }
+        }
+
+        Poly_Array1OfTriangle& vecTriangle = triangulation->ChangeTriangles();
+        for (int iTri = 1; iTri <= triangleCount; ++iTri) {
+            qint32 n1, n2, n3;
+            stream >> n1 >> n2 >> n3;
+            // Node indices are used as is by mesh consumers, out of range ones would crash later
+            for (qint32 n : { n1, n2, n3 }) {
+                if (n < 1 || n > nodeCount)
+                    return fnEvict();
+            }
+
+            vecTriangle.ChangeValue(iTri).Set(n1, n2, n3);
+        }
+
+        vecTriangulation.push_back(triangulation);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+        return fnEvict();
+
+    BRep_Builder builder;
+    for (unsigned i = 0; i < vecFace.size(); ++i) {
+        if (!vecTriangulation.at(i).IsNull())
+            builder.UpdateFace(vecFace.at(i), vecTriangulation.at(i));
+    }
+
+    return true;
+}
+
+bool BRepMeshCache::storeTriangulations(const Key& key, const TopoDS_Shape& shape) const
+{
+    std::error_code ec;
+    std::filesystem::create_directories(m_dirPath, ec);
+    QSaveFile file(filepathTo<QString>(this->entryFilePath(key)));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(entryStreamVersion);
+    stream << entryMagicNumber << entryVersion;
+    const std::vector<TopoDS_Face> vecFace = uniqueFaces(shape);
+    const TopologyCounts counts = topologyCounts(shape, vecFace);
+    stream << counts.faceCount << counts.edgeCount << counts.vertexCount;
+    for (const TopoDS_Face& face : vecFace) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        if (triangulation.IsNull() || !loc.IsIdentity()) {
+            stream << qint32(0) << qint32(0) << false << 0.;
+            continue;
+        }
+
+        const int nodeCount = triangulation->NbNodes();
+        const int triangleCount = triangulation->NbTriangles();
+        stream << qint32(nodeCount)
+               << qint32(triangleCount)
+               << bool(triangulation->HasUVNodes())
+               << triangulation->Deflection();
+        for (int iNode = 1; iNode <= nodeCount; ++iNode) {
+            const gp_Pnt pnt = triangulation->Node(iNode);
+            stream << pnt.X() << pnt.Y() << pnt.Z();
+        }
+
+        if (triangulation->HasUVNodes()) {
+            const TColgp_Array1OfPnt2d& vecUvNode = triangulation->UVNodes();
+            for (int iNode = 1; iNode <= nodeCount; ++iNode) {
+                const gp_Pnt2d& uv = vecUvNode.Value(iNode);
+                stream << uv.X() << uv.Y();
+            }
+        }
+
+        const Poly_Array1OfTriangle& vecTriangle = triangulation->Triangles();
+        for (int iTri = 1; iTri <= triangleCount; ++iTri) {
+            int n1, n2, n3;
+            vecTriangle.Value(iTri).Get(n1, n2, n3);
+            stream << qint32(n1) << qint32(n2) << qint32(n3);
+        }
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+} // namespace Mayo
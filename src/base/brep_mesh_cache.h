@@ -0,0 +1,50 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "filepath.h"
+#include "occ_brep_mesh_parameters.h"
+
+#include <TopoDS_Shape.hxx>
+#include <QtCore/QByteArray>
+
+namespace Mayo {
+
+// Persistent cache of BRep face triangulations, each entry is a compact binary file stored in
+// the cache directory
+// An entry is identified by the contents of the source file(eg a STEP file), the index of the
+// shape within that file and the mesh parameters
+class BRepMeshCache {
+public:
+    struct Key {
+        QByteArray sourceHash; // See BRepMeshCache::sourceHash()
+        int shapeIndex = 0;
+        OccBRepMeshParameters params;
+    };
+
+    BRepMeshCache(const FilePath& dirPath);
+    const FilePath& dirPath() const { return m_dirPath; }
+
+    // Returns hash of the contents of file 'fp', empty if the file can't be read
+    static QByteArray sourceHash(const FilePath& fp);
+
+    FilePath entryFilePath(const Key& key) const;
+
+    // Assigns cached triangulations to the faces of 'shape'
+    // Returns false if no entry exists for 'key' or entry doesn't match the topology of 'shape'
+    // Entry with invalid data(eg triangle node index out of [1, nodeCount]) is removed and false
+    // is returned, 'shape' is then left untouched and has to be meshed again
+    bool attachTriangulations(const Key& key, const TopoDS_Shape& shape) const;
+
+    // Saves the triangulations of the faces of 'shape' in entry identified by 'key'
+    bool storeTriangulations(const Key& key, const TopoDS_Shape& shape) const;
+
+private:
+    FilePath m_dirPath;
+};
+
+} // namespace Mayo
@@ -0,0 +1,63 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "brep_mesh_priorities.h"
+#include "global.h"
+
+#include <TopLoc_Location.hxx>
+#include <limits>
+
+namespace Mayo {
+
+BRepMeshPriorities::BRepMeshPriorities(std::vector<TopoDS_Shape>&& vecPart)
+    : m_vecPart(std::move(vecPart)),
+      m_vecPriority(m_vecPart.size(), 0.)
+{
+    for (int i = 0; i < int(m_vecPart.size()); ++i)
+        m_mapPartIndex.Bind(m_vecPart.at(i).Located(TopLoc_Location()), i);
+}
+
+int BRepMeshPriorities::findPart(const TopoDS_Shape& shape) const
+{
+    const int* ptrPartIndex = m_mapPartIndex.Seek(shape.Located(TopLoc_Location()));
+    return ptrPartIndex ? *ptrPartIndex : -1;
+}
+
+double BRepMeshPriorities::priority(int partIndex) const
+{
+    if (partIndex < 0 || partIndex >= this->partCount())
+        return std::numeric_limits<double>::lowest();
+
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    return m_vecPriority.at(partIndex);
+}
+
+void BRepMeshPriorities::setPriorities(Span<const double> spanPriority)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+        m_vecPriority.assign(spanPriority.begin(), spanPriority.end());
+        m_vecPriority.resize(m_vecPart.size(), 0.);
+    }
+
+    ++m_revision;
+}
+
+void BRepMeshPriorities::addPartDone(int partIndex)
+{
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    m_vecPartDoneIndex.push_back(partIndex);
+}
+
+std::vector<int> BRepMeshPriorities::takePartsDone()
+{
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    std::vector<int> vecPartIndex;
+    vecPartIndex.swap(m_vecPartDoneIndex);
+    return vecPartIndex;
+}
+
+} // namespace Mayo
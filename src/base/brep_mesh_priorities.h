@@ -0,0 +1,54 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "span.h"
+
+#include <TopTools_DataMapOfShapeInteger.hxx>
+#include <TopoDS_Shape.hxx>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace Mayo {
+
+// Meshing priorities of parts, as seen by the user(eg parts visible in the 3D view first)
+// Priorities are changed by a thread(eg GUI thread when the view camera moves) while mesh jobs
+// are picked by worker threads, see BRepUtils::MeshJobScheduling. Worker threads also report the
+// parts whose meshing is complete, so they can be displayed without waiting for the other ones
+class BRepMeshPriorities {
+public:
+    // Parts are identified by their TShape, location and orientation are ignored
+    BRepMeshPriorities(std::vector<TopoDS_Shape>&& vecPart);
+
+    int partCount() const { return int(m_vecPart.size()); }
+    const TopoDS_Shape& part(int partIndex) const { return m_vecPart.at(partIndex); }
+    // Returns -1 if 'shape' isn't a part
+    int findPart(const TopoDS_Shape& shape) const;
+
+    // Functions below are thread-safe
+
+    // Priority of part index -1 is lower than the one of any part
+    double priority(int partIndex) const;
+    // 'spanPriority' is indexed by part, revision is incremented
+    void setPriorities(Span<const double> spanPriority);
+    int revision() const { return m_revision; }
+
+    void addPartDone(int partIndex);
+    // Parts reported since the previous call
+    std::vector<int> takePartsDone();
+
+private:
+    std::vector<TopoDS_Shape> m_vecPart;
+    TopTools_DataMapOfShapeInteger m_mapPartIndex;
+    mutable std::mutex m_mutex;
+    std::vector<double> m_vecPriority;
+    std::atomic<int> m_revision = 0;
+    std::vector<int> m_vecPartDoneIndex;
+};
+
+} // namespace Mayo
@@ -0,0 +1,83 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "brep_mesh_quality.h"
+#include "bnd_utils.h"
+#include "brep_utils.h"
+#include "unit_system.h"
+
+#include <algorithm>
+
+namespace Mayo {
+
+namespace {
+
+QuantityLength shapeChordalDeflection(const Bnd_Box& shapeBndBox)
+{
+    // Excerpted from Prs3d::GetDeflection(...)
+    constexpr QuantityLength baseDeviation = 1 * Quantity_Millimeter;
+
+    Bnd_Box bndBox = shapeBndBox;
+    if (bndBox.IsVoid())
+        return baseDeviation;
+
+    if (BndUtils::isOpen(bndBox)) {
+        if (!BndUtils::hasFinitePart(bndBox))
+            return baseDeviation;
+
+        bndBox = BndUtils::finitePart(bndBox);
+    }
+
+    const auto coords = BndBoxCoords::get(bndBox);
+    const gp_XYZ diag = coords.maxVertex().XYZ() - coords.minVertex().XYZ();
+    const double diagMaxComp = std::max({ diag.X(), diag.Y(), diag.Z() });
+    return 4 * diagMaxComp * baseDeviation;
+}
+
+} // namespace
+
+OccBRepMeshParameters brepMeshBaseParameters()
+{
+    OccBRepMeshParameters params;
+    params.InParallel = true;
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    params.AllowQualityDecrease = true;
+#endif
+    return params;
+}
+
+OccBRepMeshParameters brepMeshQualityParameters(const TopoDS_Shape& shape, BRepMeshQuality quality)
+{
+    return brepMeshQualityParameters(BRepUtils::boundingBox(shape), quality);
+}
+
+OccBRepMeshParameters brepMeshQualityParameters(const Bnd_Box& shapeBndBox, BRepMeshQuality quality)
+{
+    struct Coefficients {
+        double chordalDeflection;
+        double angularDeflection;
+    };
+    auto fnCoefficients = [](BRepMeshQuality quality) -> Coefficients {
+        switch (quality) {
+        case BRepMeshQuality::VeryCoarse: return { 8, 4 };
+        case BRepMeshQuality::Coarse: return { 4, 2 };
+        case BRepMeshQuality::Normal: return { 1, 1 };
+        case BRepMeshQuality::Precise: return { 1/4., 1/2. };
+        case BRepMeshQuality::VeryPrecise: return { 1/8., 1/4. };
+        case BRepMeshQuality::UserDefined: return { -1, -1 };
+        // Solved for a batch of shapes, 'Normal' is the fallback for a shape alone
+        case BRepMeshQuality::TriangleBudget: return { 1, 1 };
+        }
+        return { 1, 1 };
+    };
+    const Coefficients coeffs = fnCoefficients(quality);
+    OccBRepMeshParameters params = brepMeshBaseParameters();
+    params.Deflection = UnitSystem::meters(coeffs.chordalDeflection * shapeChordalDeflection(shapeBndBox));
+    params.Angle = UnitSystem::radians(coeffs.angularDeflection * (20 * Quantity_Degree));
+    return params;
+}
+
+} // namespace Mayo
@@ -0,0 +1,28 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "occ_brep_mesh_parameters.h"
+#include <Bnd_Box.hxx>
+#include <TopoDS_Shape.hxx>
+
+namespace Mayo {
+
+// Predefined levels of BRep meshing quality
+// 'UserDefined' means deflections are explicitly provided, so it has no predefined parameters
+// 'TriangleBudget' means deflections are solved from a global count of triangles(see BRepMeshBudget)
+enum class BRepMeshQuality { VeryCoarse, Coarse, Normal, Precise, VeryPrecise, UserDefined, TriangleBudget };
+
+// Parameters common to all meshing qualities(parallel meshing, ...)
+OccBRepMeshParameters brepMeshBaseParameters();
+
+// Parameters for predefined 'quality', deflections are relative to the bounding box of 'shape'
+OccBRepMeshParameters brepMeshQualityParameters(const TopoDS_Shape& shape, BRepMeshQuality quality);
+// Same as above, with the bounding box of the shape already known(eg Document::shapeBoundingBox())
+OccBRepMeshParameters brepMeshQualityParameters(const Bnd_Box& shapeBndBox, BRepMeshQuality quality);
+
+} // namespace Mayo
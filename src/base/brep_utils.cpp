@@ -6,17 +6,46 @@
 
 #include "brep_utils.h"
 
+#include "cpp_utils.h"
 #include "global.h"
+#include "job_arena.h"
+#include "mesh_utils.h"
+#include "task_progress.h"
 #include "tkernel_utils.h"
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
 #  include "occ_progress_indicator.h"
 #endif
 
+#include <BRepBndLib.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
 #include <BRepMesh_IncrementalMesh.hxx>
 #include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <Bnd_Box.hxx>
+#include <Poly_PolygonOnTriangulation.hxx>
+#include <Poly_Triangulation.hxx>
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+#  include <Poly_ListOfTriangulation.hxx>
+#endif
+#include <Precision.hxx>
 #include <BRepTools.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <TopTools_DataMapOfShapeInteger.hxx>
+#include <TopTools_DataMapOfShapeListOfShape.hxx>
+#include <TopTools_MapOfShape.hxx>
+#include <gsl/assert>
+#include <algorithm>
+#include <atomic>
 #include <climits>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <optional>
 #include <sstream>
+#include <thread>
+#include <unordered_set>
 
 namespace Mayo {
 
@@ -59,4 +88,535 @@ void BRepUtils::computeMesh(
     MAYO_UNUSED(mesher);
 }
 
+std::vector<BRepUtils::MeshJob> BRepUtils::createMeshJobs(
+        Span<const TopoDS_Shape> spanShape, Span<const OccBRepMeshParameters> spanParams)
+{
+    Expects(spanShape.size() == spanParams.size());
+
+    // Collect unique non-compound shapes, locations are dropped so instances are found once
+    struct MeshUnit {
+        TopoDS_Shape shape;
+        int paramsIndex;
+    };
+    std::vector<MeshUnit> vecUnit;
+    TopTools_MapOfShape mapUnitShape(1, JobArena::current());
+    std::function<void(const TopoDS_Shape&, int)> fnAddUnits;
+    fnAddUnits = [&](const TopoDS_Shape& shape, int paramsIndex) {
+        if (shape.IsNull())
+            return;
+
+        if (shape.ShapeType() == TopAbs_COMPOUND) {
+            for (TopoDS_Iterator it(shape); it.More(); it.Next())
+                fnAddUnits(it.Value(), paramsIndex);
+        }
+        else {
+            const TopoDS_Shape shapeUnlocated = shape.Located(TopLoc_Location());
+            if (mapUnitShape.Add(shapeUnlocated))
+                vecUnit.push_back({ shapeUnlocated, paramsIndex });
+        }
+    };
+    for (unsigned i = 0; i < spanShape.size(); ++i)
+        fnAddUnits(spanShape[i], int(i));
+
+    // Group units sharing edges(union-find), they can't be meshed concurrently
+    std::vector<int> vecUnitParent(vecUnit.size());
+    std::iota(vecUnitParent.begin(), vecUnitParent.end(), 0);
+    auto fnFindRoot = [&](int i) {
+        while (vecUnitParent.at(i) != i) {
+            vecUnitParent.at(i) = vecUnitParent.at(vecUnitParent.at(i));
+            i = vecUnitParent.at(i);
+        }
+
+        return i;
+    };
+    TopTools_DataMapOfShapeInteger mapEdgeUnit(1, JobArena::current());
+    for (int i = 0; i < int(vecUnit.size()); ++i) {
+        for (TopExp_Explorer expl(vecUnit.at(i).shape, TopAbs_EDGE); expl.More(); expl.Next()) {
+            const TopoDS_Shape edgeUnlocated = expl.Current().Located(TopLoc_Location());
+            const int* ptrUnitIndex = mapEdgeUnit.Seek(edgeUnlocated);
+            if (!ptrUnitIndex)
+                mapEdgeUnit.Bind(edgeUnlocated, i);
+            else if (fnFindRoot(*ptrUnitIndex) != fnFindRoot(i))
+                vecUnitParent.at(fnFindRoot(i)) = fnFindRoot(*ptrUnitIndex);
+        }
+    }
+
+    // Create jobs, a job made of many units gets a compound shape
+    std::vector<MeshJob> vecJob;
+    std::vector<int> vecRootJobIndex(vecUnit.size(), -1);
+    BRep_Builder builder;
+    for (int i = 0; i < int(vecUnit.size()); ++i) {
+        const MeshUnit& unit = vecUnit.at(i);
+        int& jobIndex = vecRootJobIndex.at(fnFindRoot(i));
+        if (jobIndex < 0) {
+            jobIndex = int(vecJob.size());
+            vecJob.push_back({ unit.shape, spanParams[unit.paramsIndex] });
+            continue;
+        }
+
+        MeshJob& job = vecJob.at(jobIndex);
+        if (job.shape.ShapeType() != TopAbs_COMPOUND) {
+            TopoDS_Compound comp;
+            builder.MakeCompound(comp);
+            builder.Add(comp, job.shape);
+            job.shape = comp;
+        }
+
+        builder.Add(job.shape, unit.shape);
+    }
+
+    return vecJob;
+}
+
+void BRepUtils::computeMesh(Span<const MeshJob> spanJob, TaskProgress* progress)
+{
+    BRepUtils::computeMesh(spanJob, MeshJobScheduling{}, progress);
+}
+
+void BRepUtils::computeMesh(
+        Span<const MeshJob> spanJob, const MeshJobScheduling& scheduling, TaskProgress* progress)
+{
+    const int jobCount = int(spanJob.size());
+    const int threadCount = std::max(int(std::thread::hardware_concurrency()), 1);
+    const int workerCount = std::clamp(jobCount, 1, threadCount);
+    // Let OpenCascade mesher parallelize on faces when jobs can't keep all threads busy
+    const bool allowMesherInParallel = jobCount < threadCount;
+
+    // Pending jobs in reverse order, next job is at the back
+    std::vector<int> vecPendingJobIndex(jobCount);
+    std::iota(vecPendingJobIndex.rbegin(), vecPendingJobIndex.rend(), 0);
+    std::vector<double> vecJobPriority;
+    std::optional<int> priorityRevision;
+    std::mutex mutexPending;
+    auto fnNextJobIndex = [&]() -> int {
+        std::lock_guard<std::mutex> lock(mutexPending); MAYO_UNUSED(lock);
+        if (vecPendingJobIndex.empty())
+            return -1;
+
+        if (scheduling.fnPriority) {
+            const int revision = scheduling.fnPriorityRevision ? scheduling.fnPriorityRevision() : 0;
+            if (!priorityRevision || *priorityRevision != revision) {
+                vecJobPriority.resize(jobCount);
+                for (int i : vecPendingJobIndex)
+                    vecJobPriority.at(i) = scheduling.fnPriority(spanJob[i]);
+
+                // Stable sort keeps the reverse sequence of jobs having the same priority
+                std::stable_sort(
+                            vecPendingJobIndex.begin(), vecPendingJobIndex.end(),
+                            [&](int lhs, int rhs) { return vecJobPriority.at(lhs) < vecJobPriority.at(rhs); });
+                priorityRevision = revision;
+            }
+        }
+
+        const int jobIndex = vecPendingJobIndex.back();
+        vecPendingJobIndex.pop_back();
+        return jobIndex;
+    };
+
+    std::atomic<int> jobDoneCount = 0;
+    std::mutex mutexProgress;
+    auto fnWorker = [&]{
+        for (int i = fnNextJobIndex(); i >= 0; i = fnNextJobIndex()) {
+            if (TaskProgress::isAbortRequested(progress))
+                return;
+
+            const MeshJob& job = spanJob[i];
+            OccBRepMeshParameters params = job.params;
+            params.InParallel = params.InParallel && allowMesherInParallel;
+            BRepUtils::computeMesh(job.shape, params);
+            if (scheduling.fnJobDone)
+                scheduling.fnJobDone(job);
+
+            const int doneCount = ++jobDoneCount;
+            if (progress) {
+                std::lock_guard<std::mutex> lock(mutexProgress);
+                const int pct = (doneCount * 100) / jobCount;
+                if (pct > progress->value())
+                    progress->setValue(pct);
+            }
+        }
+    };
+
+    std::vector<std::future<void>> vecFutureWorker;
+    for (int i = 1; i < workerCount; ++i)
+        vecFutureWorker.push_back(std::async(std::launch::async, fnWorker));
+
+    fnWorker(); // Calling thread is also a worker
+    for (std::future<void>& futureWorker : vecFutureWorker)
+        futureWorker.get();
+}
+
+std::vector<TopoDS_Face> BRepUtils::findCoarseMeshFaces(
+        const TopoDS_Shape& shape, const OccBRepMeshParameters& params)
+{
+    std::vector<TopoDS_Face> vecFace;
+    TopTools_MapOfShape mapFaceVisited(1, JobArena::current());
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        const TopoDS_Face faceUnlocated = TopoDS::Face(face.Located(TopLoc_Location()));
+        if (!mapFaceVisited.Add(faceUnlocated))
+            return; // Skip
+
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        if (triangulation.IsNull()) {
+            vecFace.push_back(faceUnlocated);
+            return;
+        }
+
+        double targetDeflection = params.Deflection;
+        if (params.Relative) {
+            // Same scaling as BRepMesh: deflection is relative to the size of the face
+            Bnd_Box bndBox;
+            BRepBndLib::Add(faceUnlocated, bndBox, false);
+            if (!bndBox.IsVoid()) {
+                double xMin, yMin, zMin, xMax, yMax, zMax;
+                bndBox.Get(xMin, yMin, zMin, xMax, yMax, zMax);
+                targetDeflection *= std::max({ xMax - xMin, yMax - yMin, zMax - zMin });
+            }
+        }
+
+        if (triangulation->Deflection() > targetDeflection + Precision::Confusion())
+            vecFace.push_back(faceUnlocated);
+    });
+
+    return vecFace;
+}
+
+std::vector<TopoDS_Face> BRepUtils::addEdgeNeighbourFaces(
+        const TopoDS_Shape& shape, Span<const TopoDS_Face> spanFace)
+{
+    // Unlocated faces of 'shape' by unlocated edge
+    TopTools_DataMapOfShapeListOfShape mapEdgeFaces;
+    TopTools_MapOfShape mapFaceVisited(1, JobArena::current());
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        const TopoDS_Shape faceUnlocated = face.Located(TopLoc_Location());
+        if (!mapFaceVisited.Add(faceUnlocated))
+            return; // Skip
+
+        for (TopExp_Explorer expl(faceUnlocated, TopAbs_EDGE); expl.More(); expl.Next()) {
+            const TopoDS_Shape edgeUnlocated = expl.Current().Located(TopLoc_Location());
+            TopTools_ListOfShape* ptrListFace = mapEdgeFaces.ChangeSeek(edgeUnlocated);
+            if (!ptrListFace) {
+                mapEdgeFaces.Bind(edgeUnlocated, TopTools_ListOfShape());
+                ptrListFace = mapEdgeFaces.ChangeSeek(edgeUnlocated);
+            }
+
+            ptrListFace->Append(faceUnlocated);
+        }
+    });
+
+    std::vector<TopoDS_Face> vecFace;
+    TopTools_MapOfShape mapFaceAdded;
+    for (const TopoDS_Face& face : spanFace) {
+        const TopoDS_Face faceUnlocated = TopoDS::Face(face.Located(TopLoc_Location()));
+        if (mapFaceAdded.Add(faceUnlocated))
+            vecFace.push_back(faceUnlocated);
+    }
+
+    for (const TopoDS_Face& face : spanFace) {
+        for (TopExp_Explorer expl(face.Located(TopLoc_Location()), TopAbs_EDGE); expl.More(); expl.Next()) {
+            const TopTools_ListOfShape* ptrListFace =
+                    mapEdgeFaces.Seek(expl.Current().Located(TopLoc_Location()));
+            if (!ptrListFace)
+                continue;
+
+            for (const TopoDS_Shape& neighbourFace : *ptrListFace) {
+                if (mapFaceAdded.Add(neighbourFace))
+                    vecFace.push_back(TopoDS::Face(neighbourFace));
+            }
+        }
+    }
+
+    return vecFace;
+}
+
+void BRepUtils::computeMeshLods(
+        const TopoDS_Shape& shape,
+        Span<const OccBRepMeshParameters> spanLodParams,
+        TaskProgress* progress)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    // Explorer positions of the unique faces, same positions are used to find the faces of copies
+    std::vector<int> vecFaceIndex;
+    std::vector<TopoDS_Face> vecFace;
+    std::vector<Poly_ListOfTriangulation> vecFaceLods;
+    TopTools_MapOfShape mapFaceVisited(1, JobArena::current());
+    int faceIndex = 0;
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        const int index = faceIndex++;
+        const TopoDS_Face faceUnlocated = TopoDS::Face(face.Located(TopLoc_Location()));
+        if (!mapFaceVisited.Add(faceUnlocated))
+            return; // Skip
+
+        TopLoc_Location loc;
+        const Poly_ListOfTriangulation& listTriangulation = BRep_Tool::Triangulations(face, loc);
+        if (listTriangulation.IsEmpty() || listTriangulation.First().IsNull())
+            return; // Face not meshed, there is no level 0
+
+        vecFaceIndex.push_back(index);
+        vecFace.push_back(faceUnlocated);
+        vecFaceLods.emplace_back();
+        vecFaceLods.back().Append(listTriangulation.First());
+    });
+
+    const double lodPortionSize = 100. / std::max<size_t>(spanLodParams.size(), 1);
+    for (const OccBRepMeshParameters& params : spanLodParams) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        TaskProgress lodProgress(progress, lodPortionSize);
+        const TopoDS_Shape shapeCopy = BRepBuilderAPI_Copy(shape, false/*copyGeom*/, false/*copyMesh*/).Shape();
+        const std::vector<MeshJob> vecJob = BRepUtils::createMeshJobs(
+                    Span<const TopoDS_Shape>(&shapeCopy, 1), Span<const OccBRepMeshParameters>(&params, 1));
+        BRepUtils::computeMesh(vecJob, &lodProgress);
+        std::vector<TopoDS_Face> vecFaceCopy;
+        BRepUtils::forEachSubFace(shapeCopy, [&](const TopoDS_Face& face) { vecFaceCopy.push_back(face); });
+        for (unsigned i = 0; i < vecFaceIndex.size(); ++i) {
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation& triangulation =
+                    BRep_Tool::Triangulation(vecFaceCopy.at(vecFaceIndex.at(i)), loc);
+            // Keep levels dense, a face which failed to mesh gets the previous level
+            vecFaceLods.at(i).Append(!triangulation.IsNull() ? triangulation : vecFaceLods.at(i).Last());
+        }
+    }
+
+    if (TaskProgress::isAbortRequested(progress))
+        return;
+
+    BRep_Builder builder;
+    for (unsigned i = 0; i < vecFace.size(); ++i)
+        builder.UpdateFace(vecFace.at(i), vecFaceLods.at(i), vecFaceLods.at(i).First());
+#else
+    MAYO_UNUSED(shape);
+    MAYO_UNUSED(spanLodParams);
+    MAYO_UNUSED(progress);
+#endif
+}
+
+int BRepUtils::meshLodCount(const TopoDS_Shape& shape)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    TopExp_Explorer expFace(shape, TopAbs_FACE);
+    if (expFace.More()) {
+        TopLoc_Location loc;
+        return BRep_Tool::Triangulations(TopoDS::Face(expFace.Current()), loc).Size();
+    }
+#else
+    MAYO_UNUSED(shape);
+#endif
+    return 0;
+}
+
+int BRepUtils::activeMeshLod(const TopoDS_Shape& shape)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    TopExp_Explorer expFace(shape, TopAbs_FACE);
+    if (!expFace.More())
+        return 0;
+
+    TopLoc_Location loc;
+    const TopoDS_Face& face = TopoDS::Face(expFace.Current());
+    const Handle_Poly_Triangulation& activeTriangulation = BRep_Tool::Triangulation(face, loc);
+    int lod = 0;
+    for (const Handle_Poly_Triangulation& triangulation : BRep_Tool::Triangulations(face, loc)) {
+        if (triangulation == activeTriangulation)
+            return lod;
+
+        ++lod;
+    }
+#else
+    MAYO_UNUSED(shape);
+#endif
+    return 0;
+}
+
+bool BRepUtils::activateMeshLod(const TopoDS_Shape& shape, int lod)
+{
+    bool changed = false;
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    BRep_Builder builder;
+    TopTools_MapOfShape mapFaceVisited(1, JobArena::current());
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        const TopoDS_Face faceUnlocated = TopoDS::Face(face.Located(TopLoc_Location()));
+        if (!mapFaceVisited.Add(faceUnlocated))
+            return; // Skip
+
+        TopLoc_Location loc;
+        // Copy, the list owned by the face is reset by UpdateFace()
+        const Poly_ListOfTriangulation listTriangulation = BRep_Tool::Triangulations(face, loc);
+        if (listTriangulation.Size() <= 1)
+            return;
+
+        const int lodClamped = std::clamp(lod, 0, listTriangulation.Size() - 1);
+        auto itTriangulation = listTriangulation.cbegin();
+        std::advance(itTriangulation, lodClamped);
+        if (*itTriangulation != BRep_Tool::Triangulation(face, loc)) {
+            builder.UpdateFace(faceUnlocated, listTriangulation, *itTriangulation);
+            changed = true;
+        }
+    });
+#else
+    MAYO_UNUSED(shape);
+    MAYO_UNUSED(lod);
+#endif
+    return changed;
+}
+
+void BRepUtils::optimizeMeshVertexCache(const TopoDS_Shape& shape, TaskProgress* progress)
+{
+    std::vector<Handle_Poly_Triangulation> vecTriangulation;
+    std::unordered_set<Handle_Poly_Triangulation> setTriangulation;
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        if (!triangulation.IsNull() && setTriangulation.insert(triangulation).second)
+            vecTriangulation.push_back(triangulation);
+    });
+
+    const int triangulationCount = int(vecTriangulation.size());
+    std::atomic<int> doneCount = 0;
+    std::mutex mutexProgress;
+    CppUtils::parallelFor(triangulationCount, [&](int i) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        MeshUtils::optimizeVertexCache(vecTriangulation.at(i));
+        const int count = ++doneCount;
+        if (progress) {
+            std::lock_guard<std::mutex> lock(mutexProgress);
+            const int pct = (count * 100) / triangulationCount;
+            if (pct > progress->value())
+                progress->setValue(pct);
+        }
+    });
+}
+
+void BRepUtils::convertMeshToSinglePrecision(const TopoDS_Shape& shape)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    std::vector<TopoDS_Face> vecFace;
+    TopTools_MapOfShape mapFaceVisited(1, JobArena::current());
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        const TopoDS_Face faceUnlocated = TopoDS::Face(face.Located(TopLoc_Location()));
+        if (mapFaceVisited.Add(faceUnlocated))
+            vecFace.push_back(faceUnlocated);
+    });
+
+    struct FaceConversion {
+        Poly_ListOfTriangulation listTriangulation; // Source triangulations
+        Poly_ListOfTriangulation listCopy;
+        Handle_Poly_Triangulation activeCopy;
+        bool changed = false;
+    };
+    std::vector<FaceConversion> vecConversion(vecFace.size());
+    CppUtils::parallelFor(int(vecFace.size()), [&](int i) {
+        FaceConversion& conv = vecConversion.at(i);
+        TopLoc_Location loc;
+        conv.listTriangulation = BRep_Tool::Triangulations(vecFace.at(i), loc);
+        const Handle_Poly_Triangulation& activeTriangulation = BRep_Tool::Triangulation(vecFace.at(i), loc);
+        for (const Handle_Poly_Triangulation& triangulation : conv.listTriangulation) {
+            const Handle_Poly_Triangulation copy = MeshUtils::singlePrecisionCopy(triangulation);
+            conv.listCopy.Append(copy);
+            conv.changed = conv.changed || copy != triangulation;
+            if (triangulation == activeTriangulation)
+                conv.activeCopy = copy;
+        }
+    });
+
+    // Edges are shared by faces, so they are updated sequentially
+    BRep_Builder builder;
+    for (unsigned i = 0; i < vecFace.size(); ++i) {
+        const TopoDS_Face& face = vecFace.at(i);
+        const FaceConversion& conv = vecConversion.at(i);
+        if (!conv.changed)
+            continue;
+
+        TopLoc_Location loc;
+        BRep_Tool::Triangulation(face, loc);
+        auto itCopy = conv.listCopy.cbegin();
+        for (const Handle_Poly_Triangulation& triangulation : conv.listTriangulation) {
+            const Handle_Poly_Triangulation& copy = *itCopy;
+            ++itCopy;
+            if (copy == triangulation)
+                continue;
+
+            for (TopExp_Explorer expl(face, TopAbs_EDGE); expl.More(); expl.Next()) {
+                const TopoDS_Edge& edge = TopoDS::Edge(expl.Current());
+                const Handle_Poly_PolygonOnTriangulation polygon =
+                        BRep_Tool::PolygonOnTriangulation(edge, triangulation, loc);
+                if (polygon.IsNull())
+                    continue; // Edge has no polygon on this triangulation
+
+                const Handle_Poly_PolygonOnTriangulation nullPolygon;
+                if (BRep_Tool::IsClosed(edge, triangulation, loc)) {
+                    // Seam edge, polygons of both orientations
+                    const Handle_Poly_PolygonOnTriangulation polygonReversed =
+                            BRep_Tool::PolygonOnTriangulation(TopoDS::Edge(edge.Reversed()), triangulation, loc);
+                    builder.UpdateEdge(edge, nullPolygon, triangulation, loc);
+                    builder.UpdateEdge(edge, polygon, polygonReversed, copy, loc);
+                }
+                else {
+                    builder.UpdateEdge(edge, nullPolygon, triangulation, loc);
+                    builder.UpdateEdge(edge, polygon, copy, loc);
+                }
+            }
+        }
+
+        builder.UpdateFace(face, conv.listCopy, conv.activeCopy);
+    }
+#else
+    MAYO_UNUSED(shape);
+#endif
+}
+
+Bnd_Box BRepUtils::boundingBox(const TopoDS_Shape& shape)
+{
+    Bnd_Box bndBox;
+    bool hasFace = false;
+    constexpr bool useTriangulation = true;
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        hasFace = true;
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+        // Deferred triangulations(eg glTF late data not loaded yet) only know their bounding box
+        if (!triangulation.IsNull() && triangulation->NbNodes() == 0 && triangulation->HasCachedMinMax()) {
+            const Bnd_Box& cachedBndBox = triangulation->CachedMinMax();
+            bndBox.Add(loc.IsIdentity() ? cachedBndBox : cachedBndBox.Transformed(loc.Transformation()));
+            return;
+        }
+#endif
+
+        if (triangulation.IsNull() || triangulation->NbNodes() == 0) {
+            BRepBndLib::Add(face, bndBox, !useTriangulation);
+            return;
+        }
+
+        // Separate min/max accumulators per coordinate, so the loop can be vectorized
+        // Nodes are read with Node(), so single precision triangulations are supported
+        const gp_XYZ firstCoords = triangulation->Node(1).XYZ();
+        double xmin = firstCoords.X(), ymin = firstCoords.Y(), zmin = firstCoords.Z();
+        double xmax = xmin, ymax = ymin, zmax = zmin;
+        for (int i = 1; i <= triangulation->NbNodes(); ++i) {
+            const gp_XYZ coords = triangulation->Node(i).XYZ();
+            xmin = std::min(xmin, coords.X());
+            ymin = std::min(ymin, coords.Y());
+            zmin = std::min(zmin, coords.Z());
+            xmax = std::max(xmax, coords.X());
+            ymax = std::max(ymax, coords.Y());
+            zmax = std::max(zmax, coords.Z());
+        }
+
+        Bnd_Box faceBndBox;
+        faceBndBox.Update(xmin, ymin, zmin, xmax, ymax, zmax);
+        faceBndBox.Enlarge(triangulation->Deflection()); // As BRepBndLib::Add()
+        bndBox.Add(loc.IsIdentity() ? faceBndBox : faceBndBox.Transformed(loc.Transformation()));
+    });
+
+    if (!hasFace)
+        BRepBndLib::Add(shape, bndBox, !useTriangulation);
+
+    return bndBox;
+}
+
 } // namespace Mayo
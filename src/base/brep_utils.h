@@ -7,11 +7,18 @@
 #pragma once
 
 #include "occ_brep_mesh_parameters.h"
+#include "span.h"
 
+#include <BRep_Tool.hxx>
+#include <Bnd_Box.hxx>
+#include <Poly_Triangulation.hxx>
 #include <TopoDS_Face.hxx>
 #include <TopExp_Explorer.hxx>
 #include <TopoDS.hxx>
+#include <gp_Trsf.hxx>
+#include <functional>
 #include <string>
+#include <vector>
 
 namespace Mayo {
 
@@ -25,6 +32,19 @@ struct BRepUtils {
     template<typename FUNC>
     static void forEachSubFace(const TopoDS_Shape& shape, FUNC fn);
 
+    // Triangulation with location and orientation of the owner face(if any), as exported by mesh
+    // writers
+    struct FaceTriangulation {
+        Handle_Poly_Triangulation triangulation;
+        gp_Trsf trsf;
+        bool isReversed = false;
+    };
+
+    // Calls 'fn(FaceTriangulation)' for each face of 'shape', faces not meshed or with empty
+    // triangulation are skipped
+    template<typename FUNC>
+    static void forEachFaceTriangulation(const TopoDS_Shape& shape, FUNC fn);
+
     static bool moreComplex(TopAbs_ShapeEnum lhs, TopAbs_ShapeEnum rhs);
 
     static int hashCode(const TopoDS_Shape& shape);
@@ -36,6 +56,83 @@ struct BRepUtils {
             const TopoDS_Shape& shape,
             const OccBRepMeshParameters& params,
             TaskProgress* progress = nullptr);
+
+    // Unit of work for batch meshing, shapes of distinct jobs don't share any edge
+    struct MeshJob {
+        TopoDS_Shape shape;
+        OccBRepMeshParameters params;
+    };
+
+    // Splits shapes into independent mesh jobs, each shape being associated to its parameters:
+    //   - compounds are exploded, so the work can be balanced between sub-shapes
+    //   - instances of the same shape(ie same TShape but distinct locations) are meshed once,
+    //     with the parameters of the first shape they're found in
+    //   - sub-shapes sharing edges are meshed by the same job
+    static std::vector<MeshJob> createMeshJobs(
+            Span<const TopoDS_Shape> spanShape, Span<const OccBRepMeshParameters> spanParams);
+
+    // Computes jobs concurrently, each worker thread picks the next pending job as soon as it's
+    // done with the previous one
+    static void computeMesh(Span<const MeshJob> spanJob, TaskProgress* progress = nullptr);
+
+    // Order of the mesh jobs, by default they are picked in sequence
+    struct MeshJobScheduling {
+        // Pending jobs are picked by decreasing priority, ties are kept in sequence
+        std::function<double(const MeshJob&)> fnPriority;
+        // Priorities of pending jobs are evaluated again each time this returns a new value(eg
+        // view camera moved)
+        std::function<int()> fnPriorityRevision;
+        // Called by the worker thread once the job is computed
+        std::function<void(const MeshJob&)> fnJobDone;
+    };
+    static void computeMesh(
+            Span<const MeshJob> spanJob, const MeshJobScheduling& scheduling, TaskProgress* progress = nullptr);
+
+    // Finds the faces of 'shape' lacking triangulation or whose triangulation deflection is coarser
+    // than the one targeted by 'params'. Each face is reported once, regardless of its instances
+    static std::vector<TopoDS_Face> findCoarseMeshFaces(
+            const TopoDS_Shape& shape, const OccBRepMeshParameters& params);
+
+    // Faces of 'spanFace' followed by the faces of 'shape' sharing some edge with them, so they can
+    // be meshed again together without cracks along the edges(see findCoarseMeshFaces())
+    // Locations are ignored, each face is reported once and unlocated
+    static std::vector<TopoDS_Face> addEdgeNeighbourFaces(
+            const TopoDS_Shape& shape, Span<const TopoDS_Face> spanFace);
+
+    // -- Mesh levels of detail(LOD)
+    // Each face keeps its current triangulation as level 0, followed by one coarser triangulation
+    // per item of 'spanLodParams'. Coarse meshes are computed on a copy of 'shape', so its faces
+    // are only modified once all levels are available
+    // Requires OpenCascade >= v7.6.0(multiple triangulations per face), does nothing otherwise
+    static void computeMeshLods(
+            const TopoDS_Shape& shape,
+            Span<const OccBRepMeshParameters> spanLodParams,
+            TaskProgress* progress = nullptr);
+
+    // Count of triangulations and index of the active one, both for the first face of 'shape'
+    static int meshLodCount(const TopoDS_Shape& shape);
+    static int activeMeshLod(const TopoDS_Shape& shape);
+
+    // Makes level 'lod'(clamped to available levels) the active triangulation of all faces of
+    // 'shape'. Returns true if any face was changed, ie the presentations have to be recomputed
+    static bool activateMeshLod(const TopoDS_Shape& shape, int lod);
+
+    // Reorders in place the triangles of the face triangulations of 'shape' for GPU vertex cache
+    // locality, see MeshUtils::optimizeVertexCache(). Each triangulation is processed once,
+    // regardless of its face instances, and triangulations are processed concurrently
+    static void optimizeMeshVertexCache(const TopoDS_Shape& shape, TaskProgress* progress = nullptr);
+
+    // Replaces the face triangulations of 'shape'(all levels of detail) by their single precision
+    // copy, see MeshUtils::singlePrecisionCopy(). Polygons on triangulation of the edges are
+    // moved to the copies, so the double precision triangulations are released
+    // Copies are created concurrently, each triangulation is processed once
+    // Requires OpenCascade >= v7.6.0(mixed precision node arrays), does nothing otherwise
+    static void convertMeshToSinglePrecision(const TopoDS_Shape& shape);
+
+    // Bounding box of 'shape', faces having a triangulation are bounded by their triangulation
+    // nodes which is much faster than bounding the underlying surfaces. Faces without
+    // triangulation, and shapes without any face, are bounded from their geometry
+    static Bnd_Box boundingBox(const TopoDS_Shape& shape);
 };
 
 
@@ -67,4 +164,15 @@ void BRepUtils::forEachSubFace(const TopoDS_Shape& shape, FUNC fn)
         fn(TopoDS::Face(expl.Current()));
 }
 
+template<typename FUNC>
+void BRepUtils::forEachFaceTriangulation(const TopoDS_Shape& shape, FUNC fn)
+{
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        if (!triangulation.IsNull() && triangulation->NbTriangles() > 0)
+            fn(FaceTriangulation{ triangulation, loc.Transformation(), face.Orientation() == TopAbs_REVERSED });
+    });
+}
+
 } // namespace Mayo
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include "hash_utils.h"
+
 #include <TDF_Label.hxx>
 #include <TDF_LabelSequence.hxx>
 #include <QtCore/QString>
@@ -37,8 +39,8 @@ namespace std {
 //! Specialization of C++11 std::hash<> functor for TDF_Label
 template<> struct hash<TDF_Label> {
     inline size_t operator()(const TDF_Label& lbl) const {
-        return TDF_LabelMapHasher::HashCode(lbl, INT_MAX);
-        // return qHash(Mayo::CafUtils::labelTag(lbl));
+        // HashCode() is derived from the address of the label node
+        return Mayo::HashUtils::mix(TDF_LabelMapHasher::HashCode(lbl, INT_MAX));
     }
 };
 
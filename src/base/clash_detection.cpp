@@ -0,0 +1,327 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "clash_detection.h"
+#include "brep_utils.h"
+#include "cpp_utils.h"
+#include "document.h"
+#include "part_bvh.h"
+#include "task_progress.h"
+
+#include <BRep_Tool.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Precision.hxx>
+#include <Standard_Real.hxx>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace Mayo {
+
+namespace {
+
+struct Triangle {
+    std::array<gp_XYZ, 3> vertices;
+    BndBoxCoords box;
+};
+
+BndBoxCoords triangleBox(const std::array<gp_XYZ, 3>& vertices)
+{
+    const gp_XYZ& p1 = vertices[0];
+    const gp_XYZ& p2 = vertices[1];
+    const gp_XYZ& p3 = vertices[2];
+    return {
+        std::min({ p1.X(), p2.X(), p3.X() }),
+        std::min({ p1.Y(), p2.Y(), p3.Y() }),
+        std::min({ p1.Z(), p2.Z(), p3.Z() }),
+        std::max({ p1.X(), p2.X(), p3.X() }),
+        std::max({ p1.Y(), p2.Y(), p3.Y() }),
+        std::max({ p1.Z(), p2.Z(), p3.Z() })
+    };
+}
+
+bool boxesOverlap(const BndBoxCoords& lhs, const BndBoxCoords& rhs)
+{
+    return lhs.xmin <= rhs.xmax && rhs.xmin <= lhs.xmax
+            && lhs.ymin <= rhs.ymax && rhs.ymin <= lhs.ymax
+            && lhs.zmin <= rhs.zmax && rhs.zmin <= lhs.zmax;
+}
+
+// Triangles of the faces of 'shape', in the frame of the shape
+std::vector<Triangle> shapeTriangles(const TopoDS_Shape& shape)
+{
+    std::vector<Triangle> vecTriangle;
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        if (triangulation.IsNull())
+            return;
+
+        const gp_Trsf& trsf = loc.Transformation();
+        const Poly_Array1OfTriangle& vecTriangleIndices = triangulation->Triangles();
+        for (int i = vecTriangleIndices.Lower(); i <= vecTriangleIndices.Upper(); ++i) {
+            int n1, n2, n3;
+            vecTriangleIndices.Value(i).Get(n1, n2, n3);
+            Triangle triangle;
+            triangle.vertices = {
+                triangulation->Node(n1).XYZ(), triangulation->Node(n2).XYZ(), triangulation->Node(n3).XYZ()
+            };
+            if (!loc.IsIdentity()) {
+                for (gp_XYZ& coords : triangle.vertices)
+                    trsf.Transforms(coords);
+            }
+
+            triangle.box = triangleBox(triangle.vertices);
+            vecTriangle.push_back(std::move(triangle));
+        }
+    });
+
+    return vecTriangle;
+}
+
+// Triangles of 'vecProductTriangle' located by 'trsf' and whose world box intersects 'worldBox'
+// Candidates are selected in the product frame, so only the kept triangles are transformed
+std::vector<Triangle> trianglesInBox(
+        const std::vector<Triangle>& vecProductTriangle, const gp_Trsf& trsf, const BndBoxCoords& worldBox)
+{
+    const bool isIdentity = trsf.Form() == gp_Identity;
+    Bnd_Box localBndBox;
+    localBndBox.Update(worldBox.xmin, worldBox.ymin, worldBox.zmin, worldBox.xmax, worldBox.ymax, worldBox.zmax);
+    if (!isIdentity)
+        localBndBox = localBndBox.Transformed(trsf.Inverted());
+
+    const BndBoxCoords localBox = BndBoxCoords::get(localBndBox);
+    std::vector<Triangle> vecTriangle;
+    for (const Triangle& productTriangle : vecProductTriangle) {
+        if (!boxesOverlap(productTriangle.box, localBox))
+            continue;
+
+        Triangle triangle = productTriangle;
+        if (!isIdentity) {
+            for (gp_XYZ& coords : triangle.vertices)
+                trsf.Transforms(coords);
+
+            triangle.box = triangleBox(triangle.vertices);
+            if (!boxesOverlap(triangle.box, worldBox))
+                continue;
+        }
+
+        vecTriangle.push_back(std::move(triangle));
+    }
+
+    return vecTriangle;
+}
+
+// Whether some triangle of 'vecTriangleA' crosses a triangle of 'vecTriangleB'
+// Sweep along X axis: triangles are visited by increasing xmin, each one is only tested against
+// the triangles of the other set whose X extent is still "active"
+bool trianglesClash(const std::vector<Triangle>& vecTriangleA, const std::vector<Triangle>& vecTriangleB)
+{
+    struct Event {
+        double xmin;
+        const Triangle* triangle;
+        int set;
+    };
+
+    std::vector<Event> vecEvent;
+    vecEvent.reserve(vecTriangleA.size() + vecTriangleB.size());
+    for (const Triangle& triangle : vecTriangleA)
+        vecEvent.push_back({ triangle.box.xmin, &triangle, 0 });
+
+    for (const Triangle& triangle : vecTriangleB)
+        vecEvent.push_back({ triangle.box.xmin, &triangle, 1 });
+
+    std::sort(vecEvent.begin(), vecEvent.end(), [](const Event& lhs, const Event& rhs) {
+        return lhs.xmin < rhs.xmin;
+    });
+
+    std::vector<const Triangle*> vecActive[2];
+    for (const Event& event : vecEvent) {
+        const Triangle* triangle = event.triangle;
+        std::vector<const Triangle*>& vecOtherActive = vecActive[1 - event.set];
+        // Remove triangles ending before the current one
+        auto itEnd = std::remove_if(vecOtherActive.begin(), vecOtherActive.end(), [=](const Triangle* other) {
+            return other->box.xmax < event.xmin;
+        });
+        vecOtherActive.erase(itEnd, vecOtherActive.end());
+        for (const Triangle* other : vecOtherActive) {
+            if (boxesOverlap(triangle->box, other->box)
+                    && ClashDetection::trianglesIntersect(triangle->vertices.data(), other->vertices.data()))
+            {
+                return true;
+            }
+        }
+
+        vecActive[event.set].push_back(triangle);
+    }
+
+    return false;
+}
+
+} // namespace
+
+std::vector<ClashDetection::Clash> ClashDetection::findClashes(
+        const DocumentPtr& doc, const PartBvh& bvh, TaskProgress* progress)
+{
+    const std::vector<std::pair<PartBvh::Item, PartBvh::Item>> vecPair = bvh.findOverlappingPairs();
+    if (vecPair.empty())
+        return {};
+
+    // Leaf node of a part, the part node refers to it when it's a shape reference
+    const Tree<TDF_Label>& modelTree = doc->modelTree();
+    auto fnPartLeaf = [&](TreeNodeId partId) {
+        return !modelTree.nodeIsLeaf(partId) ? modelTree.nodeChildFirst(partId) : partId;
+    };
+
+    // Triangles are extracted once per product, whatever the count of its instances
+    std::unordered_map<TDF_Label, uint32_t> mapLabelProductIndex;
+    std::vector<TDF_Label> vecProductLabel;
+    auto fnAddProduct = [&](TreeNodeId partId) {
+        const TDF_Label& label = modelTree.nodeData(fnPartLeaf(partId));
+        auto itInserted = mapLabelProductIndex.insert({ label, uint32_t(vecProductLabel.size()) });
+        if (itInserted.second)
+            vecProductLabel.push_back(label);
+    };
+    for (const auto& pair : vecPair) {
+        fnAddProduct(pair.first.nodeId);
+        fnAddProduct(pair.second.nodeId);
+    }
+
+    std::vector<std::vector<Triangle>> vecProductTriangles(vecProductLabel.size());
+    CppUtils::parallelFor(int(vecProductLabel.size()), [&](int i) {
+        if (!TaskProgress::isAbortRequested(progress))
+            vecProductTriangles.at(i) = shapeTriangles(XCaf::shape(vecProductLabel.at(i)));
+    });
+
+    auto fnPartTrsf = [&](TreeNodeId partId) {
+        const TreeNodeId leafId = fnPartLeaf(partId);
+        return !modelTree.nodeIsRoot(leafId) ? doc->xcaf().shapeAbsoluteLocation(leafId).Transformation() : gp_Trsf();
+    };
+    auto fnPartProductTriangles = [&](TreeNodeId partId) -> const std::vector<Triangle>& {
+        const TDF_Label& label = modelTree.nodeData(fnPartLeaf(partId));
+        return vecProductTriangles.at(mapLabelProductIndex.at(label));
+    };
+
+    // Narrow phase, only triangles within the overlap of the part boxes can cross each other
+    const int pairCount = int(vecPair.size());
+    std::vector<char> vecPairClash(vecPair.size(), 0);
+    std::atomic<int> doneCount = 0;
+    std::mutex mutexProgress;
+    CppUtils::parallelFor(pairCount, [&](int i) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        const PartBvh::Item& itemA = vecPair.at(i).first;
+        const PartBvh::Item& itemB = vecPair.at(i).second;
+        const BndBoxCoords overlapBox = {
+            std::max(itemA.box.xmin, itemB.box.xmin),
+            std::max(itemA.box.ymin, itemB.box.ymin),
+            std::max(itemA.box.zmin, itemB.box.zmin),
+            std::min(itemA.box.xmax, itemB.box.xmax),
+            std::min(itemA.box.ymax, itemB.box.ymax),
+            std::min(itemA.box.zmax, itemB.box.zmax)
+        };
+        const std::vector<Triangle> vecTriangleA =
+                trianglesInBox(fnPartProductTriangles(itemA.nodeId), fnPartTrsf(itemA.nodeId), overlapBox);
+        if (!vecTriangleA.empty()) {
+            const std::vector<Triangle> vecTriangleB =
+                    trianglesInBox(fnPartProductTriangles(itemB.nodeId), fnPartTrsf(itemB.nodeId), overlapBox);
+            vecPairClash.at(i) = trianglesClash(vecTriangleA, vecTriangleB) ? 1 : 0;
+        }
+
+        const int count = ++doneCount;
+        if (progress) {
+            std::lock_guard<std::mutex> lock(mutexProgress);
+            const int pct = (count * 100) / pairCount;
+            if (pct > progress->value())
+                progress->setValue(pct);
+        }
+    });
+
+    std::vector<Clash> vecClash;
+    for (size_t i = 0; i < vecPair.size(); ++i) {
+        if (vecPairClash.at(i))
+            vecClash.push_back({ vecPair.at(i).first.nodeId, vecPair.at(i).second.nodeId });
+    }
+
+    return vecClash;
+}
+
+bool ClashDetection::trianglesIntersect(const gp_XYZ triA[3], const gp_XYZ triB[3])
+{
+    const double tolerance = Precision::Confusion();
+    // Signed distances of the vertices of 'tri' to the plane of 'triPlane', snapped to zero within
+    // tolerance. Returns false if plane is degenerated
+    auto fnPlaneDistances = [=](const gp_XYZ triPlane[3], const gp_XYZ tri[3], gp_XYZ* normal, double dist[3]) {
+        *normal = (triPlane[1] - triPlane[0]).Crossed(triPlane[2] - triPlane[0]);
+        const double normalLength = normal->Modulus();
+        if (normalLength <= gp::Resolution())
+            return false;
+
+        normal->Divide(normalLength);
+        for (int i = 0; i < 3; ++i) {
+            dist[i] = normal->Dot(tri[i] - triPlane[0]);
+            if (std::abs(dist[i]) < tolerance)
+                dist[i] = 0.;
+        }
+
+        return true;
+    };
+    // Triangle is fully on one side of the plane, or touching it
+    auto fnOneSide = [](const double dist[3]) {
+        return (dist[0] >= 0 && dist[1] >= 0 && dist[2] >= 0)
+                || (dist[0] <= 0 && dist[1] <= 0 && dist[2] <= 0);
+    };
+
+    gp_XYZ normalA;
+    gp_XYZ normalB;
+    double distB[3]; // Distances of triB vertices to plane of triA
+    double distA[3]; // Distances of triA vertices to plane of triB
+    if (!fnPlaneDistances(triA, triB, &normalA, distB) || fnOneSide(distB))
+        return false;
+
+    if (!fnPlaneDistances(triB, triA, &normalB, distA) || fnOneSide(distA))
+        return false;
+
+    // Both triangles cross the intersection line of the planes, project them on the coordinate
+    // axis the most aligned with that line
+    const gp_XYZ lineDir = normalA.Crossed(normalB);
+    const double absDir[] = { std::abs(lineDir.X()), std::abs(lineDir.Y()), std::abs(lineDir.Z()) };
+    const int axis = int(std::max_element(std::begin(absDir), std::end(absDir)) - std::begin(absDir));
+    // Interval of the triangle on the line, bounded by the vertices lying on the other plane and
+    // the points where edges cross that plane. There are exactly two of them as the triangle
+    // has vertices strictly on both sides
+    auto fnInterval = [=](const gp_XYZ tri[3], const double dist[3]) {
+        double tmin = RealLast();
+        double tmax = RealFirst();
+        auto fnAdd = [&](double t) {
+            tmin = std::min(tmin, t);
+            tmax = std::max(tmax, t);
+        };
+        for (int i = 0; i < 3; ++i) {
+            const int j = (i + 1) % 3;
+            const double pi = tri[i].Coord(axis + 1);
+            const double pj = tri[j].Coord(axis + 1);
+            if (dist[i] == 0)
+                fnAdd(pi);
+            else if (dist[i] * dist[j] < 0)
+                fnAdd(pi + (pj - pi) * dist[i] / (dist[i] - dist[j]));
+        }
+
+        return std::make_pair(tmin, tmax);
+    };
+
+    const auto intervalA = fnInterval(triA, distA);
+    const auto intervalB = fnInterval(triB, distB);
+    // Strict overlap, intervals sharing only an end point means triangles are in contact
+    return intervalA.first + tolerance < intervalB.second && intervalB.first + tolerance < intervalA.second;
+}
+
+} // namespace Mayo
@@ -0,0 +1,40 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "document_ptr.h"
+#include "libtree.h"
+
+#include <gp_XYZ.hxx>
+#include <vector>
+
+namespace Mayo {
+
+class PartBvh;
+class TaskProgress;
+
+// Interference detection between the parts of a document
+// Broad phase finds the pairs of parts whose boxes overlap(see PartBvh), narrow phase tests the
+// triangles of both parts lying in the overlap box. Pairs are tested concurrently
+struct ClashDetection {
+    struct Clash {
+        TreeNodeId firstNodeId;
+        TreeNodeId secondNodeId;
+    };
+
+    // Parts are tested with their face triangulations, parts not meshed can't clash
+    // Triangles in contact(ie touching within Precision::Confusion()) don't clash, so parts in
+    // flush contact aren't reported
+    // Requires Document::dataMutex() to be held when called outside of the main thread
+    static std::vector<Clash> findClashes(
+            const DocumentPtr& doc, const PartBvh& bvh, TaskProgress* progress = nullptr);
+
+    // Whether triangles 'triA' and 'triB' cross each other(Moller's interval overlap test)
+    static bool trianglesIntersect(const gp_XYZ triA[3], const gp_XYZ triB[3]);
+};
+
+} // namespace Mayo
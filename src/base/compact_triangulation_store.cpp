@@ -0,0 +1,139 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "compact_triangulation_store.h"
+#include "brep_utils.h"
+#include "cpp_utils.h"
+#include "global.h"
+
+#include <BRep_Tool.hxx>
+#include <Standard_Version.hxx>
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+#  include <Poly_ListOfTriangulation.hxx>
+#endif
+#include <unordered_set>
+
+namespace Mayo {
+
+namespace {
+
+// Single triangulations of the faces of 'shape', a triangulation shared by many faces is found once
+std::vector<Handle_Poly_Triangulation> faceTriangulations(const TopoDS_Shape& shape)
+{
+    std::vector<Handle_Poly_Triangulation> vecTriangulation;
+    std::unordered_set<const Poly_Triangulation*> setTriangulation;
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+        if (BRep_Tool::Triangulations(face, loc).Size() > 1)
+            return;
+#endif
+
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        if (!triangulation.IsNull() && setTriangulation.insert(triangulation.get()).second)
+            vecTriangulation.push_back(triangulation);
+    });
+
+    return vecTriangulation;
+}
+
+} // namespace
+
+int CompactTriangulationStore::compact(const TopoDS_Shape& shape)
+{
+    std::vector<Entry> vecEntry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+        for (const Handle_Poly_Triangulation& triangulation : faceTriangulations(shape)) {
+            if (m_mapEntry.find(triangulation.get()) == m_mapEntry.cend())
+                vecEntry.push_back({ triangulation, {} });
+        }
+    }
+
+    CppUtils::parallelFor(int(vecEntry.size()), [&](int i) {
+        Entry& entry = vecEntry.at(i);
+        entry.data = MeshCompression::compress(entry.triangulation);
+        if (!entry.data.isEmpty())
+            MeshCompression::releaseArrays(entry.triangulation);
+    });
+
+    int count = 0;
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    for (Entry& entry : vecEntry) {
+        if (!entry.data.isEmpty()) {
+            const Poly_Triangulation* key = entry.triangulation.get();
+            m_mapEntry.insert({ key, std::move(entry) });
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+void CompactTriangulationStore::expand(Span<const TopoDS_Shape> spanShape)
+{
+    std::vector<Entry> vecEntry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+        if (m_mapEntry.empty())
+            return;
+
+        for (const TopoDS_Shape& shape : spanShape) {
+            for (const Handle_Poly_Triangulation& triangulation : faceTriangulations(shape)) {
+                auto itEntry = m_mapEntry.find(triangulation.get());
+                if (itEntry != m_mapEntry.end()) {
+                    vecEntry.push_back(std::move(itEntry->second));
+                    m_mapEntry.erase(itEntry);
+                }
+            }
+        }
+    }
+
+    this->expand(std::move(vecEntry));
+}
+
+void CompactTriangulationStore::expandAll()
+{
+    std::vector<Entry> vecEntry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+        for (auto& pairEntry : m_mapEntry)
+            vecEntry.push_back(std::move(pairEntry.second));
+
+        m_mapEntry.clear();
+    }
+
+    this->expand(std::move(vecEntry));
+}
+
+bool CompactTriangulationStore::isEmpty() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    return m_mapEntry.empty();
+}
+
+bool CompactTriangulationStore::isCompacted(const Handle_Poly_Triangulation& triangulation) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    return m_mapEntry.find(triangulation.get()) != m_mapEntry.cend();
+}
+
+int64_t CompactTriangulationStore::compressedMemorySize(const Handle_Poly_Triangulation& triangulation) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    auto itEntry = m_mapEntry.find(triangulation.get());
+    return itEntry != m_mapEntry.cend() ? itEntry->second.data.memorySize() : 0;
+}
+
+void CompactTriangulationStore::expand(std::vector<Entry>&& vecEntry)
+{
+    CppUtils::parallelFor(int(vecEntry.size()), [&](int i) {
+        const Entry& entry = vecEntry.at(i);
+        MeshCompression::decompress(entry.data, entry.triangulation);
+    });
+}
+
+} // namespace Mayo
@@ -0,0 +1,52 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "mesh_compression.h"
+#include "span.h"
+
+#include <TopoDS_Shape.hxx>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace Mayo {
+
+// Keeps compressed the face triangulations of shapes not currently used(eg hidden in the 3D view),
+// see MeshCompression. Triangulation objects stay attached to their faces with empty arrays, so
+// any reader of compacted shapes has to expand them first
+// Faces with many triangulations(levels of detail) are left as is
+// Functions are thread-safe, but triangulations must not be read while they're compacted or
+// expanded(see Document::dataMutex())
+class CompactTriangulationStore {
+public:
+    // Compresses the triangulations of the faces of 'shape', each triangulation is stored once
+    // Returns the count of triangulations compacted
+    int compact(const TopoDS_Shape& shape);
+
+    // Restores the compacted triangulations of 'spanShape', faces are decompressed concurrently
+    void expand(Span<const TopoDS_Shape> spanShape);
+    void expandAll();
+
+    bool isEmpty() const;
+    bool isCompacted(const Handle_Poly_Triangulation& triangulation) const;
+    // Memory of the compressed data of 'triangulation', 0 if not compacted
+    int64_t compressedMemorySize(const Handle_Poly_Triangulation& triangulation) const;
+
+private:
+    struct Entry {
+        Handle_Poly_Triangulation triangulation;
+        MeshCompression::Data data;
+    };
+
+    void expand(std::vector<Entry>&& vecEntry);
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<const Poly_Triangulation*, Entry> m_mapEntry;
+};
+
+} // namespace Mayo
@@ -6,22 +6,49 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace Mayo {
 
 class CppUtils {
 public:
-    template<typename KEY, typename VALUE, typename... EXTRAS>
-    static VALUE findValue(const KEY& key, const std::unordered_map<KEY, VALUE, EXTRAS...>& hashmap) {
+    // Works with std::unordered_map and FlatHashMap
+    template<typename HASHMAP>
+    static typename HASHMAP::mapped_type findValue(const typename HASHMAP::key_type& key, const HASHMAP& hashmap) {
         auto it = hashmap.find(key);
-        const VALUE defaultValue = {};
+        const typename HASHMAP::mapped_type defaultValue = {};
         return it != hashmap.cend() ? it->second : defaultValue;
     }
 
     static void toggle(bool& value) {
         value = !value;
     }
+
+    // Runs function fn(i) for all i in [0, count) over worker threads, indices are picked in
+    // increasing order. Calling thread is also a worker
+    template<typename FUNCTION>
+    static void parallelFor(int count, FUNCTION fn) {
+        const int threadCount = std::max(int(std::thread::hardware_concurrency()), 1);
+        const int workerCount = std::clamp(count, 1, threadCount);
+        std::atomic<int> indexSeq = 0;
+        auto fnWorker = [&]{
+            for (int i = indexSeq++; i < count; i = indexSeq++)
+                fn(i);
+        };
+
+        std::vector<std::future<void>> vecFutureWorker;
+        for (int i = 1; i < workerCount; ++i)
+            vecFutureWorker.push_back(std::async(std::launch::async, fnWorker));
+
+        fnWorker();
+        for (std::future<void>& futureWorker : vecFutureWorker)
+            futureWorker.get();
+    }
 };
 
 } // namespace Mayo
@@ -0,0 +1,311 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "cross_section.h"
+#include "brep_utils.h"
+#include "caf_utils.h"
+#include "cpp_utils.h"
+#include "document.h"
+#include "task_progress.h"
+#include "tkernel_utils.h"
+
+#include <BRepAdaptor_Curve.hxx>
+#include <BRepAlgoAPI_Section.hxx>
+#include <BRep_Tool.hxx>
+#include <GCPnts_TangentialDeflection.hxx>
+#include <Precision.hxx>
+#include <Standard_Real.hxx>
+#include <TDataXtd_Triangulation.hxx>
+#include <TopoDS.hxx>
+#include <gp_XY.hxx>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fstream>
+#include <locale>
+#include <mutex>
+#include <ostream>
+
+namespace Mayo {
+
+namespace {
+
+// Coordinates of 'pnt' in the 2D frame of 'plane'
+gp_XY planeCoords(const gp_Pln& plane, const gp_Pnt& pnt)
+{
+    const gp_Ax3& pos = plane.Position();
+    const gp_XYZ vec = pnt.XYZ() - pos.Location().XYZ();
+    return { vec.Dot(pos.XDirection().XYZ()), vec.Dot(pos.YDirection().XYZ()) };
+}
+
+void addEdgeSegments(
+        const TopoDS_Edge& edge, double deflection, std::vector<CrossSection::Segment>* ptrVecSegment)
+{
+    if (BRep_Tool::Degenerated(edge))
+        return;
+
+    const BRepAdaptor_Curve curve(edge);
+    const GCPnts_TangentialDeflection discr(curve, 0.1 /*angularDeflection*/, deflection);
+    for (int i = 2; i <= discr.NbPoints(); ++i)
+        ptrVecSegment->push_back({ discr.Value(i - 1), discr.Value(i) });
+}
+
+// Exact section of 'shape' by 'plane', section edges are discretized with 'deflection'
+std::vector<CrossSection::Segment> sectionShape(const TopoDS_Shape& shape, const gp_Pln& plane, double deflection)
+{
+    std::vector<CrossSection::Segment> vecSegment;
+    BRepAlgoAPI_Section section(shape, plane, false);
+    section.Approximation(true);
+    section.Build();
+    if (!section.IsDone())
+        return vecSegment;
+
+    BRepUtils::forEachSubShape(section.Shape(), TopAbs_EDGE, [&](const TopoDS_Shape& edge) {
+        addEdgeSegments(TopoDS::Edge(edge), deflection, &vecSegment);
+    });
+    return vecSegment;
+}
+
+// Whether all the faces of 'shape' are meshed and 'shape' has at least one face
+bool hasTriangulation(const TopoDS_Shape& shape)
+{
+    bool hasFace = false;
+    bool allMeshed = true;
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        hasFace = true;
+        allMeshed = allMeshed && !BRep_Tool::Triangulation(face, loc).IsNull();
+    });
+    return hasFace && allMeshed;
+}
+
+void writeSvg(std::ostream& ostr, const gp_Pln& plane, Span<const CrossSection::PartSection> spanSection)
+{
+    double xmin = RealLast();
+    double ymin = RealLast();
+    double xmax = RealFirst();
+    double ymax = RealFirst();
+    for (const CrossSection::PartSection& partSection : spanSection) {
+        for (const CrossSection::Segment& segment : partSection.vecSegment) {
+            for (const gp_Pnt& pnt : { segment.start, segment.end }) {
+                const gp_XY coords = planeCoords(plane, pnt);
+                xmin = std::min(xmin, coords.X());
+                xmax = std::max(xmax, coords.X());
+                ymin = std::min(ymin, coords.Y());
+                ymax = std::max(ymax, coords.Y());
+            }
+        }
+    }
+
+    if (xmin > xmax) // No segments
+        xmin = ymin = xmax = ymax = 0.;
+
+    // SVG Y axis is pointing down, so Y coordinates are negated
+    const double margin = std::max(std::max(xmax - xmin, ymax - ymin) * 0.02, 1.);
+    const double width = xmax - xmin + 2 * margin;
+    const double height = ymax - ymin + 2 * margin;
+    ostr << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+         << "<svg xmlns=\"http://www.w3.org/2000/svg\""
+         << " width=\"" << width << "mm\" height=\"" << height << "mm\""
+         << " viewBox=\"" << xmin - margin << " " << -ymax - margin << " " << width << " " << height << "\">\n";
+    for (const CrossSection::PartSection& partSection : spanSection) {
+        const Quantity_Color color = partSection.hasColor ? partSection.color : Quantity_Color(Quantity_NOC_BLACK);
+        ostr << "<path fill=\"none\" stroke=\"" << TKernelUtils::colorToHex(color) << "\""
+             << " stroke-width=\"1\" vector-effect=\"non-scaling-stroke\" d=\"";
+        for (const CrossSection::Segment& segment : partSection.vecSegment) {
+            const gp_XY start = planeCoords(plane, segment.start);
+            const gp_XY end = planeCoords(plane, segment.end);
+            ostr << "M" << start.X() << " " << -start.Y() << "L" << end.X() << " " << -end.Y();
+        }
+
+        ostr << "\"/>\n";
+    }
+
+    ostr << "</svg>\n";
+}
+
+void writeDxf(std::ostream& ostr, const gp_Pln& plane, Span<const CrossSection::PartSection> spanSection)
+{
+    // Minimal ASCII DXF : entities only, colors are stored as 24-bit "true color"(group code 420)
+    ostr << "0\nSECTION\n2\nENTITIES\n";
+    for (const CrossSection::PartSection& partSection : spanSection) {
+        const Quantity_Color color = partSection.hasColor ? partSection.color : Quantity_Color(Quantity_NOC_BLACK);
+        const int trueColor =
+                (int(color.Red() * 255) << 16) | (int(color.Green() * 255) << 8) | int(color.Blue() * 255);
+        for (const CrossSection::Segment& segment : partSection.vecSegment) {
+            const gp_XY start = planeCoords(plane, segment.start);
+            const gp_XY end = planeCoords(plane, segment.end);
+            ostr << "0\nLINE\n8\n0\n"
+                 << "420\n" << trueColor << "\n"
+                 << "10\n" << start.X() << "\n20\n" << start.Y() << "\n30\n0\n"
+                 << "11\n" << end.X() << "\n21\n" << end.Y() << "\n31\n0\n";
+        }
+    }
+
+    ostr << "0\nENDSEC\n0\nEOF\n";
+}
+
+} // namespace
+
+std::vector<CrossSection::PartSection> CrossSection::compute(
+        const DocumentPtr& doc,
+        Span<const TreeNodeId> spanPartId,
+        const gp_Pln& plane,
+        const Parameters& params,
+        TaskProgress* progress)
+{
+    const Tree<TDF_Label>& modelTree = doc->modelTree();
+    auto fnPartLeaf = [&](TreeNodeId partId) {
+        return !modelTree.nodeIsLeaf(partId) ? modelTree.nodeChildFirst(partId) : partId;
+    };
+
+    const int partCount = int(spanPartId.size());
+    std::vector<PartSection> vecPartSection(spanPartId.size());
+    std::atomic<int> doneCount = 0;
+    std::mutex mutexProgress;
+    CppUtils::parallelFor(partCount, [&](int i) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        const TreeNodeId partId = spanPartId[i];
+        const TreeNodeId leafId = fnPartLeaf(partId);
+        const TDF_Label& label = modelTree.nodeData(leafId);
+        const gp_Trsf trsf =
+                !modelTree.nodeIsRoot(leafId) ? doc->xcaf().shapeAbsoluteLocation(leafId).Transformation() : gp_Trsf();
+        PartSection& partSection = vecPartSection.at(i);
+        partSection.partId = partId;
+        auto attrTriangulation = CafUtils::findAttribute<TDataXtd_Triangulation>(label);
+        if (!attrTriangulation.IsNull()) {
+            partSection.vecSegment = CrossSection::sliceTriangulation(attrTriangulation->Get(), trsf, plane);
+        }
+        else {
+            const TopoDS_Shape shape = XCaf::shape(label);
+            if (params.useTriangulation && hasTriangulation(shape)) {
+                BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+                    TopLoc_Location loc;
+                    const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+                    const auto vecSegment = CrossSection::sliceTriangulation(
+                                triangulation, trsf * loc.Transformation(), plane);
+                    partSection.vecSegment.insert(partSection.vecSegment.end(), vecSegment.begin(), vecSegment.end());
+                });
+            }
+            else if (!shape.IsNull()) {
+                partSection.vecSegment = sectionShape(shape.Moved(TopLoc_Location(trsf)), plane, params.curveDeflection);
+            }
+        }
+
+        const XCaf::ShapeStyle& style = doc->xcaf().shapeStyle(partId);
+        partSection.hasColor = style.hasColor;
+        partSection.color = style.color;
+        const int count = ++doneCount;
+        if (progress) {
+            std::lock_guard<std::mutex> lock(mutexProgress);
+            const int pct = (count * 100) / partCount;
+            if (pct > progress->value())
+                progress->setValue(pct);
+        }
+    });
+
+    auto itEnd = std::remove_if(vecPartSection.begin(), vecPartSection.end(), [](const PartSection& partSection) {
+        return partSection.vecSegment.empty();
+    });
+    vecPartSection.erase(itEnd, vecPartSection.end());
+    return vecPartSection;
+}
+
+std::vector<CrossSection::Segment> CrossSection::sliceTriangulation(
+        const Handle_Poly_Triangulation& triangulation, const gp_Trsf& trsf, const gp_Pln& plane)
+{
+    std::vector<Segment> vecSegment;
+    if (triangulation.IsNull())
+        return vecSegment;
+
+    // Plane is brought to the frame of the triangulation, so nodes don't need to be transformed
+    const gp_Pln localPlane = trsf.Form() != gp_Identity ? plane.Transformed(trsf.Inverted()) : plane;
+    const gp_XYZ planeLoc = localPlane.Location().XYZ();
+    const gp_XYZ planeNormal = localPlane.Axis().Direction().XYZ();
+    auto fnSignedDistance = [&](const gp_XYZ& coords) { return planeNormal.Dot(coords - planeLoc); };
+
+    const Poly_Array1OfTriangle& vecTriangleIndices = triangulation->Triangles();
+    for (int i = vecTriangleIndices.Lower(); i <= vecTriangleIndices.Upper(); ++i) {
+        int n[3];
+        vecTriangleIndices.Value(i).Get(n[0], n[1], n[2]);
+        const gp_XYZ nodes[] = {
+            triangulation->Node(n[0]).XYZ(), triangulation->Node(n[1]).XYZ(), triangulation->Node(n[2]).XYZ()
+        };
+        const double dist[] = { fnSignedDistance(nodes[0]), fnSignedDistance(nodes[1]), fnSignedDistance(nodes[2]) };
+        // Nodes lying on the plane are considered above, so an edge is crossed at most once and
+        // a triangle with an edge on the plane gives a single segment(shared with the neighbour
+        // triangle below)
+        const bool above[] = { dist[0] >= 0, dist[1] >= 0, dist[2] >= 0 };
+        if (above[0] == above[1] && above[1] == above[2])
+            continue;
+
+        // Vertex alone on its side of the plane
+        const int iAlone = above[0] == above[1] ? 2 : (above[0] == above[2] ? 1 : 0);
+        const int j = (iAlone + 1) % 3;
+        const int k = (iAlone + 2) % 3;
+        auto fnCrossing = [&](int a, int b) {
+            const double t = dist[a] / (dist[a] - dist[b]);
+            gp_XYZ coords = nodes[a] + (nodes[b] - nodes[a]) * t;
+            trsf.Transforms(coords);
+            return gp_Pnt(coords);
+        };
+        const Segment segment = { fnCrossing(iAlone, j), fnCrossing(iAlone, k) };
+        // Triangle touching the plane at a single node
+        if (segment.start.SquareDistance(segment.end) > Precision::SquareConfusion())
+            vecSegment.push_back(segment);
+    }
+
+    return vecSegment;
+}
+
+CrossSection::FileFormat CrossSection::fileFormat(const FilePath& filepath)
+{
+    std::string suffix = filepath.extension().u8string();
+    std::transform(suffix.begin(), suffix.end(), suffix.begin(), [](char c) { return char(std::tolower(c)); });
+    if (suffix == ".svg")
+        return FileFormat::Svg;
+    else if (suffix == ".dxf")
+        return FileFormat::Dxf;
+    else
+        return FileFormat::Unknown;
+}
+
+bool CrossSection::write(
+        std::ostream& ostr, FileFormat format, const gp_Pln& plane, Span<const PartSection> spanSection)
+{
+    // Decimal separator must be '.' whatever the application locale
+    ostr.imbue(std::locale::classic());
+    ostr.precision(9);
+    switch (format) {
+    case FileFormat::Svg:
+        writeSvg(ostr, plane, spanSection);
+        break;
+    case FileFormat::Dxf:
+        writeDxf(ostr, plane, spanSection);
+        break;
+    case FileFormat::Unknown:
+        return false;
+    }
+
+    return ostr.good();
+}
+
+bool CrossSection::writeFile(const FilePath& filepath, const gp_Pln& plane, Span<const PartSection> spanSection)
+{
+    const FileFormat format = CrossSection::fileFormat(filepath);
+    if (format == FileFormat::Unknown)
+        return false;
+
+    std::ofstream ofs(filepath, std::ios::out | std::ios::binary);
+    if (!ofs.is_open())
+        return false;
+
+    return CrossSection::write(ofs, format, plane, spanSection);
+}
+
+} // namespace Mayo
@@ -0,0 +1,76 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "document_ptr.h"
+#include "filepath.h"
+#include "libtree.h"
+#include "span.h"
+
+#include <gp_Pln.hxx>
+#include <gp_Pnt.hxx>
+#include <gp_Trsf.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Quantity_Color.hxx>
+#include <iosfwd>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Planar cross-section of the parts of a document, ie the curves where a plane cuts them
+// Parts are sectioned concurrently. BRep parts are intersected exactly with BRepAlgoAPI_Section,
+// then the section edges are discretized. Mesh parts(entities with a triangulation attribute) are
+// sliced triangle by triangle, which is also the fast path for BRep parts if their faces are meshed
+struct CrossSection {
+    struct Segment {
+        gp_Pnt start;
+        gp_Pnt end;
+    };
+
+    struct PartSection {
+        TreeNodeId partId = 0; // Model tree node of the part instance(see PartBvh::Item)
+        bool hasColor = false;
+        Quantity_Color color; // Effective color of the part(see XCaf::shapeStyle())
+        std::vector<Segment> vecSegment; // World coordinates, lying on the section plane
+    };
+
+    struct Parameters {
+        // Slice the face triangulations of BRep parts instead of computing the exact section
+        // Parts without triangulation are sectioned exactly anyway
+        bool useTriangulation = false;
+        // Maximum distance between the exact section curves and their polylines
+        double curveDeflection = 0.05;
+    };
+
+    // Sections of the parts 'spanPartId' by 'plane', parts not crossed by the plane are skipped
+    // Requires Document::dataMutex() to be held when called outside of the main thread
+    static std::vector<PartSection> compute(
+            const DocumentPtr& doc,
+            Span<const TreeNodeId> spanPartId,
+            const gp_Pln& plane,
+            const Parameters& params,
+            TaskProgress* progress = nullptr);
+
+    // Segments where 'plane' cuts the triangles of 'triangulation' located by 'trsf'
+    static std::vector<Segment> sliceTriangulation(
+            const Handle_Poly_Triangulation& triangulation, const gp_Trsf& trsf, const gp_Pln& plane);
+
+    enum class FileFormat { Unknown, Svg, Dxf };
+    // Format from the suffix of 'filepath'(.svg or .dxf)
+    static FileFormat fileFormat(const FilePath& filepath);
+
+    // Writes sections in the 2D frame of 'plane'(X and Y directions of its position), each part
+    // is drawn with its color. Coordinates are in millimeters
+    static bool write(
+            std::ostream& ostr, FileFormat format, const gp_Pln& plane, Span<const PartSection> spanSection);
+    static bool writeFile(
+            const FilePath& filepath, const gp_Pln& plane, Span<const PartSection> spanSection);
+};
+
+} // namespace Mayo
@@ -0,0 +1,378 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "decompression_stream.h"
+#include "global.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+#ifdef HAVE_ZLIB
+#  include <zlib.h>
+#endif
+
+namespace Mayo {
+
+namespace {
+
+constexpr size_t InputChunkSize = 256 * 1024;
+constexpr size_t OutputBlockSize = 256 * 1024;
+constexpr size_t MaxQueuedBlockCount = 16;
+
+constexpr uint32_t ZipLocalHeaderSignature = 0x04034b50;
+constexpr size_t ZipLocalHeaderSize = 30;
+constexpr uint16_t ZipMethodStored = 0;
+constexpr uint16_t ZipMethodDeflated = 8;
+constexpr uint16_t ZipFlagDataDescriptor = 1 << 3;
+
+uint16_t readLe16(const char* bytes)
+{
+    auto ubytes = reinterpret_cast<const uint8_t*>(bytes);
+    return uint16_t(ubytes[0] | (ubytes[1] << 8));
+}
+
+uint32_t readLe32(const char* bytes)
+{
+    auto ubytes = reinterpret_cast<const uint8_t*>(bytes);
+    return uint32_t(ubytes[0])
+            | (uint32_t(ubytes[1]) << 8)
+            | (uint32_t(ubytes[2]) << 16)
+            | (uint32_t(ubytes[3]) << 24);
+}
+
+// Fixed-size part of a zip local file header, followed by the entry name and extra field
+struct ZipLocalHeader {
+    uint16_t flags = 0;
+    uint16_t method = 0;
+    uint32_t compressedSize = 0;
+    uint32_t uncompressedSize = 0;
+    uint16_t nameLength = 0;
+    uint16_t extraLength = 0;
+
+    size_t fullSize() const { return ZipLocalHeaderSize + this->nameLength + this->extraLength; }
+};
+
+bool parseZipLocalHeader(std::string_view data, ZipLocalHeader* ptrHeader)
+{
+    if (data.size() < ZipLocalHeaderSize || readLe32(data.data()) != ZipLocalHeaderSignature)
+        return false;
+
+    ptrHeader->flags = readLe16(data.data() + 6);
+    ptrHeader->method = readLe16(data.data() + 8);
+    ptrHeader->compressedSize = readLe32(data.data() + 18);
+    ptrHeader->uncompressedSize = readLe32(data.data() + 22);
+    ptrHeader->nameLength = readLe16(data.data() + 26);
+    ptrHeader->extraLength = readLe16(data.data() + 28);
+    return true;
+}
+
+} // namespace
+
+bool DecompressionUtils::isAvailable()
+{
+#ifdef HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+CompressionFormat DecompressionUtils::probe(std::string_view header)
+{
+    if (header.size() >= 2 && uint8_t(header[0]) == 0x1f && uint8_t(header[1]) == 0x8b)
+        return CompressionFormat::Gzip;
+
+    if (header.size() >= 4 && readLe32(header.data()) == ZipLocalHeaderSignature)
+        return CompressionFormat::Zip;
+
+    return CompressionFormat::None;
+}
+
+CompressionFormat DecompressionUtils::probeFile(const FilePath& filepath)
+{
+    std::ifstream ifs(filepath, std::ios::in | std::ios::binary);
+    char header[4] = {};
+    ifs.read(header, sizeof(header));
+    return DecompressionUtils::probe(std::string_view(header, size_t(ifs.gcount())));
+}
+
+std::string DecompressionUtils::decompressHead(
+        std::string_view data, CompressionFormat format, size_t maxSize, FilePath* ptrInnerName)
+{
+    std::string_view compressedData = data;
+    bool isRawDeflate = false;
+    if (format == CompressionFormat::Zip) {
+        ZipLocalHeader header;
+        if (!parseZipLocalHeader(data, &header) || data.size() < header.fullSize())
+            return {};
+
+        if (ptrInnerName)
+            *ptrInnerName = std::filesystem::u8path(data.substr(ZipLocalHeaderSize, header.nameLength));
+
+        compressedData = data.substr(header.fullSize());
+        if (header.method == ZipMethodStored)
+            return std::string(compressedData.substr(0, maxSize));
+        else if (header.method != ZipMethodDeflated)
+            return {};
+
+        isRawDeflate = true;
+    }
+    else if (format != CompressionFormat::Gzip) {
+        return {};
+    }
+
+#ifdef HAVE_ZLIB
+    z_stream zs = {};
+    if (inflateInit2(&zs, isRawDeflate ? -MAX_WBITS : MAX_WBITS + 16) != Z_OK)
+        return {};
+
+    std::string result(maxSize, '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressedData.data()));
+    zs.avail_in = uInt(compressedData.size());
+    zs.next_out = reinterpret_cast<Bytef*>(result.data());
+    zs.avail_out = uInt(result.size());
+    const int ret = inflate(&zs, Z_SYNC_FLUSH);
+    result.resize(maxSize - zs.avail_out);
+    inflateEnd(&zs);
+    // Z_BUF_ERROR: input is a truncated excerpt of the compressed data, which is expected here
+    if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+        return {};
+
+    return result;
+#else
+    return {};
+#endif
+}
+
+uint64_t DecompressionUtils::uncompressedSizeHint(
+        std::string_view head, std::string_view tail, CompressionFormat format)
+{
+    if (format == CompressionFormat::Gzip) {
+        return tail.size() >= 4 ? readLe32(tail.data() + tail.size() - 4) : 0;
+    }
+    else if (format == CompressionFormat::Zip) {
+        ZipLocalHeader header;
+        const bool sizeKnown =
+                parseZipLocalHeader(head, &header)
+                && (header.flags & ZipFlagDataDescriptor) == 0
+                && header.uncompressedSize != 0xFFFFFFFF; // Zip64
+        return sizeKnown ? header.uncompressedSize : 0;
+    }
+
+    return 0;
+}
+
+FilePath DecompressionUtils::innerFilepath(const FilePath& filepath)
+{
+    std::string suffix = filepath.extension().u8string();
+    std::transform(suffix.begin(), suffix.end(), suffix.begin(), [](char c) {
+        return char(std::tolower(static_cast<unsigned char>(c)));
+    });
+    if (suffix == ".gz" || suffix == ".gzip" || suffix == ".z" || suffix == ".zip")
+        return FilePath(filepath).replace_extension();
+
+    // Suffix with trailing "z", eg ".stpZ" or ".stlz"
+    if (suffix.size() > 2 && suffix.back() == 'z') {
+        const std::string innerSuffix = filepath.extension().u8string();
+        return FilePath(filepath).replace_extension(
+                    std::filesystem::u8path(innerSuffix.substr(0, innerSuffix.size() - 1)));
+    }
+
+    return filepath;
+}
+
+DecompressionInputBuffer::DecompressionInputBuffer(std::istream& source, CompressionFormat format)
+    : m_source(source),
+      m_format(format)
+{
+    m_thread = std::thread([=]{ this->run(); });
+}
+
+DecompressionInputBuffer::~DecompressionInputBuffer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        MAYO_UNUSED(lock);
+        m_isStopRequested = true;
+    }
+
+    m_condBlockPopped.notify_one();
+    m_thread.join();
+}
+
+bool DecompressionInputBuffer::hasError() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MAYO_UNUSED(lock);
+    return !m_errorMessage.empty();
+}
+
+std::string DecompressionInputBuffer::errorMessage() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MAYO_UNUSED(lock);
+    return m_errorMessage;
+}
+
+DecompressionInputBuffer::int_type DecompressionInputBuffer::underflow()
+{
+    if (this->gptr() < this->egptr())
+        return traits_type::to_int_type(*this->gptr());
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condBlockPushed.wait(lock, [=]{ return !m_queueBlock.empty() || m_isFinished; });
+    if (m_queueBlock.empty())
+        return traits_type::eof();
+
+    m_currentBlock = std::move(m_queueBlock.front());
+    m_queueBlock.pop_front();
+    lock.unlock();
+    m_condBlockPopped.notify_one();
+
+    char* ptr = m_currentBlock.data();
+    this->setg(ptr, ptr, ptr + m_currentBlock.size());
+    return traits_type::to_int_type(*ptr);
+}
+
+void DecompressionInputBuffer::run()
+{
+    auto fnFinish = [=]{
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            MAYO_UNUSED(lock);
+            m_isFinished = true;
+        }
+
+        m_condBlockPushed.notify_one();
+    };
+
+    bool isRawDeflate = false;
+    if (m_format == CompressionFormat::Zip) {
+        std::string headerBytes(ZipLocalHeaderSize, '\0');
+        m_source.read(headerBytes.data(), headerBytes.size());
+        ZipLocalHeader header;
+        if (!parseZipLocalHeader(headerBytes, &header)) {
+            this->setError("Invalid zip entry header");
+            return fnFinish();
+        }
+
+        m_source.ignore(header.nameLength + header.extraLength);
+        if (header.method == ZipMethodStored) {
+            if (header.flags & ZipFlagDataDescriptor) {
+                this->setError("Unsupported zip entry(stored data of unknown size)");
+                return fnFinish();
+            }
+
+            // No compression, data is just forwarded
+            uint64_t remainingSize = header.compressedSize;
+            while (remainingSize > 0) {
+                std::string block(std::min<uint64_t>(remainingSize, OutputBlockSize), '\0');
+                m_source.read(block.data(), block.size());
+                block.resize(size_t(m_source.gcount()));
+                if (block.empty()) {
+                    this->setError("Unexpected end of zip data");
+                    break;
+                }
+
+                remainingSize -= block.size();
+                if (!this->pushBlock(std::move(block)))
+                    break;
+            }
+
+            return fnFinish();
+        }
+        else if (header.method != ZipMethodDeflated) {
+            this->setError("Unsupported zip compression method");
+            return fnFinish();
+        }
+
+        isRawDeflate = true;
+    }
+
+#ifdef HAVE_ZLIB
+    z_stream zs = {};
+    if (inflateInit2(&zs, isRawDeflate ? -MAX_WBITS : MAX_WBITS + 16) != Z_OK) {
+        this->setError("Decompression initialization failed");
+        return fnFinish();
+    }
+
+    std::string inputChunk(InputChunkSize, '\0');
+    for (;;) {
+        if (zs.avail_in == 0) {
+            m_source.read(inputChunk.data(), inputChunk.size());
+            const auto readCount = m_source.gcount();
+            if (readCount <= 0) {
+                this->setError("Unexpected end of compressed data");
+                break;
+            }
+
+            zs.next_in = reinterpret_cast<Bytef*>(inputChunk.data());
+            zs.avail_in = uInt(readCount);
+        }
+
+        std::string block(OutputBlockSize, '\0');
+        zs.next_out = reinterpret_cast<Bytef*>(block.data());
+        zs.avail_out = uInt(block.size());
+        const int ret = inflate(&zs, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            this->setError(zs.msg ? zs.msg : "Corrupted compressed data");
+            break;
+        }
+
+        block.resize(OutputBlockSize - zs.avail_out);
+        if (!block.empty() && !this->pushBlock(std::move(block)))
+            break;
+
+        if (ret == Z_STREAM_END) {
+            // Gzip data can be a concatenation of members, zip entry ends here
+            const bool hasMoreData =
+                    zs.avail_in > 0 || m_source.peek() != std::istream::traits_type::eof();
+            if (m_format == CompressionFormat::Zip || !hasMoreData)
+                break;
+
+            inflateReset(&zs);
+        }
+    }
+
+    inflateEnd(&zs);
+#else
+    MAYO_UNUSED(isRawDeflate);
+    this->setError("Decompression isn't supported(zlib is missing)");
+#endif
+    fnFinish();
+}
+
+bool DecompressionInputBuffer::pushBlock(std::string&& block)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condBlockPopped.wait(lock, [=]{
+        return m_isStopRequested || m_queueBlock.size() < MaxQueuedBlockCount;
+    });
+    if (m_isStopRequested)
+        return false;
+
+    m_queueBlock.push_back(std::move(block));
+    lock.unlock();
+    m_condBlockPushed.notify_one();
+    return true;
+}
+
+void DecompressionInputBuffer::setError(std::string_view msg)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MAYO_UNUSED(lock);
+    m_errorMessage = msg;
+}
+
+DecompressionInputStream::DecompressionInputStream(std::istream& source, CompressionFormat format)
+    : std::istream(nullptr),
+      m_buffer(source, format)
+{
+    this->rdbuf(&m_buffer);
+}
+
+} // namespace Mayo
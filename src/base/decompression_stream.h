@@ -0,0 +1,103 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "filepath.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace Mayo {
+
+// Compressed container wrapping the actual data of an input file
+enum class CompressionFormat {
+    None,
+    Gzip, // Single file, also used by .stpZ
+    Zip   // Only the first entry of the archive is considered
+};
+
+struct DecompressionUtils {
+    // Whether decompression is supported by this build(requires zlib)
+    static bool isAvailable();
+
+    // Container identified from the first bytes of some data
+    static CompressionFormat probe(std::string_view header);
+    static CompressionFormat probeFile(const FilePath& filepath);
+
+    // Decompresses the start of 'data'(beginning of the compressed container) up to 'maxSize'
+    // bytes. 'ptrInnerName' receives the name of the compressed file when the container stores
+    // it(zip entry), otherwise it's left unchanged
+    // Returns empty data on error
+    static std::string decompressHead(
+            std::string_view data, CompressionFormat format, size_t maxSize, FilePath* ptrInnerName = nullptr);
+
+    // Uncompressed size as stored by the container, or 0 if unknown
+    // 'head' is the start of the compressed data(zip stores the size in the entry header) and
+    // 'tail' its end(gzip stores the size modulo 2^32 in the trailer)
+    static uint64_t uncompressedSizeHint(std::string_view head, std::string_view tail, CompressionFormat format);
+
+    // Name of the file held by a compressed container named 'filepath', eg "part.stp" for
+    // "part.stp.gz" or "part.stpZ"
+    static FilePath innerFilepath(const FilePath& filepath);
+};
+
+// Read-only stream buffer decompressing 'source' on a worker thread, so decompression overlaps
+// with the parsing of the data by the stream reader
+// Decompressed blocks are queued up to some limit, the worker waits for the reader beyond that
+// Seeking isn't supported
+class DecompressionInputBuffer : public std::streambuf {
+public:
+    DecompressionInputBuffer(std::istream& source, CompressionFormat format);
+    ~DecompressionInputBuffer();
+
+    // Error message set by the worker thread, eg corrupted data
+    // Should be checked after the stream was read, as an error just ends the stream prematurely
+    bool hasError() const;
+    std::string errorMessage() const;
+
+protected:
+    int_type underflow() override;
+
+private:
+    void run();
+    // Pushes a decompressed block, false if stop was requested
+    bool pushBlock(std::string&& block);
+    void setError(std::string_view msg);
+
+    std::istream& m_source;
+    CompressionFormat m_format = CompressionFormat::None;
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condBlockPushed;
+    std::condition_variable m_condBlockPopped;
+    std::deque<std::string> m_queueBlock;
+    std::string m_currentBlock; // Exposed as get area
+    std::string m_errorMessage;
+    bool m_isFinished = false;
+    bool m_isStopRequested = false;
+};
+
+// Input stream over DecompressionInputBuffer
+class DecompressionInputStream : public std::istream {
+public:
+    DecompressionInputStream(std::istream& source, CompressionFormat format);
+
+    const DecompressionInputBuffer& buffer() const { return m_buffer; }
+
+private:
+    DecompressionInputBuffer m_buffer;
+};
+
+} // namespace Mayo
@@ -0,0 +1,45 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <TDF_Label.hxx>
+#include <TopoDS_Shape.hxx>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Translates on demand the shapes of products a reader imported as empty placeholders, eg the
+// structure-only transfer of a STEP file. Loaders are attached to the document, see
+// Document::addDeferredShapeLoader()
+class DeferredShapeLoader {
+public:
+    virtual ~DeferredShapeLoader() = default;
+
+    // Product labels whose shape isn't translated yet, in document order
+    virtual std::vector<TDF_Label> deferredProducts() const = 0;
+
+    // Translates the shape of product 'labelProduct'
+    // The document isn't modified, so this can be called from a worker thread. Concurrent calls
+    // are serialized. Returns a null shape on failure
+    virtual TopoDS_Shape loadShape(const TDF_Label& labelProduct, TaskProgress* progress = nullptr) = 0;
+
+    // Whether products are loaded ahead of any demand. If not, only the products requested by the
+    // application(eg shown in the 3D view) are loaded
+    virtual bool isLoadedInBackground() const { return true; }
+
+    // Whether the shapes returned by loadShape() are already triangulated(eg mesh formats), so
+    // no BRep mesh has to be computed
+    virtual bool isShapeTriangulated() const { return false; }
+
+    // Placeholder shape to be restored when the loaded shape of 'labelProduct' is released, so the
+    // product can be loaded again later. Returns a null shape if releasing isn't supported
+    virtual TopoDS_Shape unloadedShape(const TDF_Label& /*labelProduct*/) const { return {}; }
+};
+
+} // namespace Mayo
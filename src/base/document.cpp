@@ -5,9 +5,14 @@
 ****************************************************************************/
 
 #include "application.h"
+#include "brep_utils.h"
 #include "caf_utils.h"
+#include "cpp_utils.h"
+#include "deferred_shape_loader.h"
 #include "document.h"
+#include "global.h"
 #include <TDF_ChildIterator.hxx>
+#include <TDataXtd_Triangulation.hxx>
 #include <TDF_TagSource.hxx>
 #include <XCAFDoc_DocumentTool.hxx>
 #include <set>
@@ -46,6 +51,24 @@ const FilePath& Document::filePath() const
 void Document::setFilePath(const FilePath& fp)
 {
     m_filePath = fp;
+    Application::instance()->notifyDocumentFilePathChanged(m_identifier);
+}
+
+void Document::setViewerOnly(bool on)
+{
+    m_isViewerOnly = on;
+    if (!on)
+        return;
+
+    // Attributes modified outside of any transaction aren't backed up, see TDF_Attribute::Backup()
+    if (this->HasOpenCommand())
+        this->AbortCommand();
+
+    this->ClearUndos();
+    this->ClearRedos();
+    this->SetUndoLimit(0);
+    this->SetNestedTransactionMode(false);
+    this->SetModificationMode(false);
 }
 
 const char* Document::toNameFormat(Document::Format format)
@@ -100,21 +123,43 @@ DocumentTreeNode Document::entityTreeNode(int index) const
 void Document::rebuildModelTree()
 {
     m_modelTree.clear();
-    const bool xcafIsNull = m_xcaf.isNull();
-    if (!xcafIsNull) {
-        for (const TDF_Label& label : m_xcaf.topLevelFreeShapes())
-            m_xcaf.deepBuildAssemblyTree(0, label);
+    m_mapEntityLabelTreeNodeId.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_mutexLabelName); MAYO_UNUSED(lock);
+        m_mapLabelName.clear();
+        m_setInternedName.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutexShapeBndBox); MAYO_UNUSED(lock);
+        m_mapLabelShapeBndBox.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutexMeshQuality); MAYO_UNUSED(lock);
+        m_mapLabelMeshQuality.clear();
     }
 
+    m_xcaf.invalidateAbsoluteLocations();
+    m_xcaf.invalidateShapeStyles();
+    const bool xcafIsNull = m_xcaf.isNull();
+    if (!xcafIsNull)
+        m_xcaf.deepBuildAssemblyTrees(m_xcaf.topLevelFreeShapes());
+
     constexpr bool allLevels = true;
     for (TDF_ChildIterator it(this->rootLabel(), !allLevels); it.More(); it.Next()) {
         const TDF_Label childLabel = it.Value();
         if (!CafUtils::isNullOrEmpty(childLabel)
                 && (xcafIsNull || childLabel != this->Main())) // Not XCAF Main label
         {
-            m_modelTree.appendChild(0, childLabel);
+            const TreeNodeId nodeId = m_modelTree.appendChild(0, childLabel);
+            m_mapEntityLabelTreeNodeId.insert({ childLabel, nodeId });
         }
     }
+
+    m_xcaf.resolveShapeStyles(0);
+
+    this->internLabelNames(0);
 }
 
 DocumentPtr Document::findFrom(const TDF_Label& label)
@@ -122,6 +167,115 @@ DocumentPtr Document::findFrom(const TDF_Label& label)
     return DocumentPtr::DownCast(TDocStd_Document::Get(label));
 }
 
+QString Document::labelName(const TDF_Label& label) const
+{
+    std::lock_guard<std::mutex> lock(m_mutexLabelName); MAYO_UNUSED(lock);
+    auto itFound = m_mapLabelName.find(label);
+    if (itFound != m_mapLabelName.cend())
+        return itFound->second;
+
+    // Label not in the model tree, or tree not built yet
+    const QString name = this->internName(CafUtils::labelAttrStdName(label));
+    m_mapLabelName.insert({ label, name });
+    return name;
+}
+
+void Document::setLabelName(const TDF_Label& label, const QString& name)
+{
+    CafUtils::setLabelAttrStdName(label, name);
+    std::lock_guard<std::mutex> lock(m_mutexLabelName); MAYO_UNUSED(lock);
+    m_mapLabelName.insert_or_assign(label, this->internName(name));
+}
+
+Bnd_Box Document::shapeBoundingBox(const TDF_Label& label) const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutexShapeBndBox); MAYO_UNUSED(lock);
+        auto itFound = m_mapLabelShapeBndBox.find(label);
+        if (itFound != m_mapLabelShapeBndBox.cend())
+            return itFound->second;
+    }
+
+    // Computed without holding the lock, so boxes of distinct labels are computed concurrently
+    const Bnd_Box bndBox = BRepUtils::boundingBox(XCaf::shape(label));
+    if (!bndBox.IsVoid()) {
+        std::lock_guard<std::mutex> lock(m_mutexShapeBndBox); MAYO_UNUSED(lock);
+        m_mapLabelShapeBndBox.insert({ label, bndBox });
+    }
+
+    return bndBox;
+}
+
+void Document::cacheShapeBoundingBoxes(Span<const TDF_Label> spanLabel) const
+{
+    CppUtils::parallelFor(int(spanLabel.size()), [=](int i) {
+        this->shapeBoundingBox(spanLabel[i]);
+    });
+}
+
+void Document::invalidateShapeBoundingBox(const TDF_Label& label)
+{
+    std::lock_guard<std::mutex> lock(m_mutexShapeBndBox); MAYO_UNUSED(lock);
+    m_mapLabelShapeBndBox.erase(label);
+    for (int i = 0; i < this->entityCount(); ++i)
+        m_mapLabelShapeBndBox.erase(this->entityLabel(i));
+}
+
+std::shared_ptr<const MeshQualityAnalysis::Report> Document::meshQualityReport(const TDF_Label& label) const
+{
+    auto report = this->findMeshQualityReport(label);
+    if (report)
+        return report;
+
+    // Computed without holding the lock, as for shapeBoundingBox()
+    auto attrTriangulation = CafUtils::findAttribute<TDataXtd_Triangulation>(label);
+    report = std::make_shared<MeshQualityAnalysis::Report>(
+                !attrTriangulation.IsNull() ?
+                    MeshQualityAnalysis::analyze(attrTriangulation->Get()) :
+                    MeshQualityAnalysis::analyze(XCaf::shape(label)));
+    std::lock_guard<std::mutex> lock(m_mutexMeshQuality); MAYO_UNUSED(lock);
+    m_mapLabelMeshQuality.insert_or_assign(label, report);
+    return report;
+}
+
+std::shared_ptr<const MeshQualityAnalysis::Report> Document::findMeshQualityReport(const TDF_Label& label) const
+{
+    std::lock_guard<std::mutex> lock(m_mutexMeshQuality); MAYO_UNUSED(lock);
+    auto itFound = m_mapLabelMeshQuality.find(label);
+    return itFound != m_mapLabelMeshQuality.cend() ? itFound->second : nullptr;
+}
+
+void Document::invalidateMeshQualityReport(const TDF_Label& label)
+{
+    std::lock_guard<std::mutex> lock(m_mutexMeshQuality); MAYO_UNUSED(lock);
+    m_mapLabelMeshQuality.erase(label);
+}
+
+// Fills the name table with the labels of the subtree 'rootId', whole model tree if 'rootId' is null
+void Document::internLabelNames(TreeNodeId rootId)
+{
+    std::lock_guard<std::mutex> lock(m_mutexLabelName); MAYO_UNUSED(lock);
+    auto fnInternNodeName = [=](TreeNodeId id) {
+        const TDF_Label& label = m_modelTree.nodeData(id);
+        if (m_mapLabelName.find(label) == m_mapLabelName.cend())
+            m_mapLabelName.insert({ label, this->internName(CafUtils::labelAttrStdName(label)) });
+    };
+    if (rootId != 0)
+        traverseTree(rootId, m_modelTree, fnInternNodeName);
+    else
+        traverseTree_unorder(m_modelTree, fnInternNodeName);
+}
+
+// Returns the string of the name table equal to 'name', so identical names share their data
+// Requires m_mutexLabelName to be held
+QString Document::internName(const QString& name) const
+{
+    if (name.isEmpty())
+        return name;
+
+    return *m_setInternedName.insert(name).first;
+}
+
 TDF_Label Document::newEntityLabel()
 {
     Handle_TDF_TagSource tagSrc = CafUtils::findAttribute<TDF_TagSource>(this->rootLabel());
@@ -132,27 +286,86 @@ TDF_Label Document::newEntityLabel()
     return this->rootLabel().NewChild();
 }
 
+TreeNodeId Document::findEntityTreeNodeId(const TDF_Label& label) const
+{
+    auto it = m_mapEntityLabelTreeNodeId.find(label);
+    return it != m_mapEntityLabelTreeNodeId.end() ? it->second : 0;
+}
+
 void Document::addEntityTreeNode(const TDF_Label& label)
+{
+    const TreeNodeId nodeId = this->buildEntityTreeNode(label);
+    if (nodeId != 0)
+        emit this->entityAdded(nodeId);
+}
+
+void Document::addEntityTreeNodes(Span<const TDF_Label> spanLabel)
+{
+    std::vector<TreeNodeId> vecNodeId;
+    vecNodeId.reserve(spanLabel.size());
+    m_mapEntityLabelTreeNodeId.reserve(m_mapEntityLabelTreeNodeId.size() + spanLabel.size());
+    for (const TDF_Label& label : spanLabel) {
+        const TreeNodeId nodeId = this->buildEntityTreeNode(label);
+        if (nodeId != 0)
+            vecNodeId.push_back(nodeId);
+    }
+
+    if (!vecNodeId.empty())
+        emit this->entitiesAdded(vecNodeId);
+}
+
+// Builds the model tree of new entity 'label', returns 0 if 'label' doesn't belong to this
+// document or is already an entity
+TreeNodeId Document::buildEntityTreeNode(const TDF_Label& label)
 {
     // Check if 'label' belongs to current document
     if (Document::findFrom(label).get() != this)
-        return;
+        return 0;
 
     // Check if 'label' is not already there inside model tree
-    for (int i = 0; i < this->entityCount(); ++i) {
-        if (this->entityLabel(i) == label)
-            return;
-    }
+    if (m_mapEntityLabelTreeNodeId.count(label) != 0)
+        return 0;
 
     // TODO Allow custom population of the model tree for the new entity
     const TreeNodeId nodeId = m_xcaf.deepBuildAssemblyTree(0, label);
-    emit this->entityAdded(nodeId);
+    m_xcaf.resolveShapeStyles(nodeId);
+    this->internLabelNames(nodeId);
+    m_mapEntityLabelTreeNodeId.insert({ label, nodeId });
+    return nodeId;
+}
+
+std::shared_ptr<void> Document::acquireDataUse() const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutexDataUse); MAYO_UNUSED(lock);
+        ++m_dataUseCount;
+    }
 
-#if 0
-    // Remove 'label'
-    label.ForgetAllAttributes();
-    label.Nullify();
-#endif
+    // Token references the document, so it can't be deleted while the data is used
+    DocumentPtr doc(const_cast<Document*>(this));
+    return std::shared_ptr<void>(nullptr, [=](void*) {
+        std::lock_guard<std::mutex> lock(doc->m_mutexDataUse); MAYO_UNUSED(lock);
+        if (--doc->m_dataUseCount == 0)
+            doc->m_condDataUnused.notify_all();
+    });
+}
+
+void Document::waitForDataUnused() const
+{
+    std::unique_lock<std::mutex> lock(m_mutexDataUse);
+    m_condDataUnused.wait(lock, [=]{ return m_dataUseCount == 0; });
+}
+
+bool Document::isDataInUse() const
+{
+    std::lock_guard<std::mutex> lock(m_mutexDataUse); MAYO_UNUSED(lock);
+    return m_dataUseCount > 0;
+}
+
+void Document::addDeferredShapeLoader(const std::shared_ptr<DeferredShapeLoader>& loader)
+{
+    if (loader)
+        m_vecDeferredShapeLoader.push_back(loader);
 }
 
 void Document::destroyEntity(TreeNodeId entityTreeNodeId)
@@ -164,11 +377,37 @@ void Document::destroyEntity(TreeNodeId entityTreeNodeId)
         return;
 
     emit this->entityAboutToBeDestroyed(entityTreeNodeId);
+    m_mapEntityLabelTreeNodeId.erase(entityLabel);
+    this->invalidateMeshQualityReport(entityLabel);
     entityLabel.ForgetAllAttributes();
     entityLabel.Nullify();
     m_modelTree.removeRoot(entityTreeNodeId);
 }
 
+void Document::destroyEntities(Span<const TreeNodeId> spanEntityTreeNodeId)
+{
+    std::vector<TreeNodeId> vecEntityTreeNodeId;
+    for (TreeNodeId entityTreeNodeId : spanEntityTreeNodeId) {
+        Expects(this->modelTree().nodeIsRoot(entityTreeNodeId));
+        const TDF_Label entityLabel = m_modelTree.nodeData(entityTreeNodeId);
+        if (!CafUtils::isNullOrEmpty(entityLabel))
+            vecEntityTreeNodeId.push_back(entityTreeNodeId);
+    }
+
+    if (vecEntityTreeNodeId.empty())
+        return;
+
+    emit this->entitiesAboutToBeDestroyed(vecEntityTreeNodeId);
+    for (TreeNodeId entityTreeNodeId : vecEntityTreeNodeId) {
+        TDF_Label entityLabel = m_modelTree.nodeData(entityTreeNodeId);
+        m_mapEntityLabelTreeNodeId.erase(entityLabel);
+        this->invalidateMeshQualityReport(entityLabel);
+        entityLabel.ForgetAllAttributes();
+        entityLabel.Nullify();
+        m_modelTree.removeRoot(entityTreeNodeId);
+    }
+}
+
 void Document::BeforeClose()
 {
     TDocStd_Document::BeforeClose();
@@ -6,16 +6,30 @@
 
 #pragma once
 
+#include "caf_utils.h"
+#include "compact_triangulation_store.h"
 #include "document_ptr.h"
 #include "document_tree_node.h"
 #include "filepath.h"
+#include "flat_hash_map.h"
 #include "libtree.h"
+#include "mesh_quality_analysis.h"
+#include "qtcore_hfuncs.h"
+#include "span.h"
 #include "xcaf.h"
+#include <Bnd_Box.hxx>
 #include <QtCore/QObject>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace Mayo {
 
 class Application;
+class DeferredShapeLoader;
 class DocumentTreeNode;
 
 class Document : public QObject, public TDocStd_Document {
@@ -36,6 +50,12 @@ public:
     const FilePath& filePath() const;
     void setFilePath(const FilePath& fp);
 
+    // Viewer-only document: OCAF undo is disabled(undo limit 0, pending command aborted) as well as
+    // nested transactions and modification tracking, so attribute changes don't record any delta
+    // No command must be opened on such document, imported data can't be undone
+    bool isViewerOnly() const { return m_isViewerOnly; }
+    void setViewerOnly(bool on);
+
     static const char NameFormatBinary[];
     static const char NameFormatXml[];
     static const char* toNameFormat(Format format);
@@ -59,14 +79,75 @@ public:
 
     static DocumentPtr findFrom(const TDF_Label& label);
 
+    // Name(TDataStd_Name attribute) of 'label', names of the model tree labels are interned when
+    // the tree is built. Returned string shares its data with the name table, copies are cheap
+    // Safe to be called from any thread
+    QString labelName(const TDF_Label& label) const;
+    // Changes the name attribute of 'label' and its entry in the name table
+    void setLabelName(const TDF_Label& label, const QString& name);
+
+    // Bounding box of XCaf::shape(label), computed once with BRepUtils::boundingBox() then cached
+    // Void boxes aren't cached, as the shape might not be loaded yet(see DeferredShapeLoader)
+    // Safe to be called from any thread
+    Bnd_Box shapeBoundingBox(const TDF_Label& label) const;
+    // Computes concurrently the bounding boxes of 'spanLabel' which aren't cached yet
+    void cacheShapeBoundingBoxes(Span<const TDF_Label> spanLabel) const;
+    // To be called when the shape of 'label' is changed. Cached boxes of the entities are also
+    // discarded, as they might contain that shape
+    void invalidateShapeBoundingBox(const TDF_Label& label);
+
+    // Quality report of the mesh of entity 'label'(its triangulation attribute, or else the face
+    // triangulations of its shape), computed once with MeshQualityAnalysis::analyze() then cached
+    // Safe to be called from any thread
+    std::shared_ptr<const MeshQualityAnalysis::Report> meshQualityReport(const TDF_Label& label) const;
+    // Cached report of 'label', null if not computed yet
+    std::shared_ptr<const MeshQualityAnalysis::Report> findMeshQualityReport(const TDF_Label& label) const;
+    // To be called when the mesh of 'label' is changed(eg BRep shape meshed again)
+    void invalidateMeshQualityReport(const TDF_Label& label);
+
+    // Tree node of the entity whose label is 'label', 0 if none
+    TreeNodeId findEntityTreeNodeId(const TDF_Label& label) const;
+
     TDF_Label newEntityLabel();
     void addEntityTreeNode(const TDF_Label& label);
+    // Same as addEntityTreeNode() for many labels, signal entitiesAdded() is emitted once instead
+    // of entityAdded() for each entity
+    void addEntityTreeNodes(Span<const TDF_Label> spanLabel);
     void destroyEntity(TreeNodeId entityTreeNodeId);
+    // Same as destroyEntity() for many entities, signal entitiesAboutToBeDestroyed() is emitted
+    // once instead of entityAboutToBeDestroyed() for each entity
+    void destroyEntities(Span<const TreeNodeId> spanEntityTreeNodeId);
+
+    // Mutex to be held when document data is modified outside of the main thread(eg file transfer)
+    std::mutex& dataMutex() const { return m_dataMutex; }
+
+    // Token held by a background user of the document data(eg export task), the data of a closed
+    // document is released only once all the tokens are destroyed, see Application::closeDocument()
+    // Safe to be called from any thread
+    std::shared_ptr<void> acquireDataUse() const;
+    // Blocks until all the tokens returned by acquireDataUse() are destroyed
+    void waitForDataUnused() const;
+    // Whether some token returned by acquireDataUse() is alive
+    bool isDataInUse() const;
+
+    // Triangulations of the shapes compacted while not displayed, see CompactTriangulationStore
+    // Background users reading the triangulations of all entities(eg save, export, meshing) have
+    // to expand them first, with dataMutex() held
+    CompactTriangulationStore& compactTriangulations() const { return m_compactTriangulations; }
+
+    // Loaders of the product shapes whose translation was deferred by readers
+    // Requires dataMutex() to be held when called outside of the main thread
+    void addDeferredShapeLoader(const std::shared_ptr<DeferredShapeLoader>& loader);
+    const std::vector<std::shared_ptr<DeferredShapeLoader>>& deferredShapeLoaders() const {
+        return m_vecDeferredShapeLoader;
+    }
 
 signals:
     void nameChanged(const QString& name);
     void entityAdded(Mayo::TreeNodeId entityTreeNodeId);
+    void entitiesAdded(const std::vector<Mayo::TreeNodeId>& vecEntityTreeNodeId);
     void entityAboutToBeDestroyed(Mayo::TreeNodeId entityTreeNodeId);
+    void entitiesAboutToBeDestroyed(const std::vector<Mayo::TreeNodeId>& vecEntityTreeNodeId);
     //void itemPropertyChanged(DocumentItem* docItem, Property* prop);
 
 public: // -- from TDocStd_Document
@@ -86,12 +167,33 @@ private:
     Document();
     void initXCaf();
     void setIdentifier(Identifier ident) { m_identifier = ident; }
+    void internLabelNames(TreeNodeId rootId);
+    QString internName(const QString& name) const;
+    TreeNodeId buildEntityTreeNode(const TDF_Label& label);
 
     Identifier m_identifier = -1;
     QString m_name;
     FilePath m_filePath;
+    bool m_isViewerOnly = false;
     XCaf m_xcaf;
     Tree<TDF_Label> m_modelTree;
+    FlatHashMap<TDF_Label, TreeNodeId> m_mapEntityLabelTreeNodeId; // Index of the model tree roots
+    mutable std::mutex m_dataMutex;
+    mutable std::mutex m_mutexDataUse;
+    mutable std::condition_variable m_condDataUnused;
+    mutable int m_dataUseCount = 0;
+    mutable CompactTriangulationStore m_compactTriangulations;
+    std::vector<std::shared_ptr<DeferredShapeLoader>> m_vecDeferredShapeLoader;
+    // Name table, see labelName()
+    mutable std::mutex m_mutexLabelName;
+    mutable std::unordered_map<TDF_Label, QString> m_mapLabelName;
+    mutable std::unordered_set<QString> m_setInternedName;
+    // Bounding box cache, see shapeBoundingBox()
+    mutable std::mutex m_mutexShapeBndBox;
+    mutable std::unordered_map<TDF_Label, Bnd_Box> m_mapLabelShapeBndBox;
+    // Mesh quality cache, see meshQualityReport()
+    mutable std::mutex m_mutexMeshQuality;
+    mutable std::unordered_map<TDF_Label, std::shared_ptr<const MeshQualityAnalysis::Report>> m_mapLabelMeshQuality;
 };
 
 } // namespace Mayo
@@ -0,0 +1,209 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "hash_utils.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Mayo {
+
+// Open-addressing hash map with linear probing, items are stored contiguously in a single array
+// Lookups of small keys/values(eg ids, labels, handles) are much more cache-friendly than with
+// std::unordered_map, which allocates a node per item
+// Result of 'Hash' is mixed with HashUtils::mix(), so it doesn't need to be well distributed
+// Erasure shifts the following items backward(no tombstones). Any insertion or erasure invalidates
+// iterators and references
+// Key and Value must be default-constructible and movable
+template<typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<Key, Value>; // Key must not be modified through iterators
+
+    template<bool IsConst> class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using MapPointer = std::conditional_t<IsConst, const FlatHashMap*, FlatHashMap*>;
+
+        Iterator() = default;
+        Iterator(MapPointer map, size_t pos) : m_map(map), m_pos(pos) { this->skipUnused(); }
+        operator Iterator<true>() const { return Iterator<true>(m_map, m_pos); }
+
+        reference operator*() const { return m_map->m_vecItem[m_pos]; }
+        pointer operator->() const { return &m_map->m_vecItem[m_pos]; }
+        Iterator& operator++() { ++m_pos; this->skipUnused(); return *this; }
+        Iterator operator++(int) { Iterator it = *this; ++(*this); return it; }
+
+        size_t position() const { return m_pos; }
+        template<bool C> bool operator==(const Iterator<C>& other) const { return m_pos == other.position(); }
+        template<bool C> bool operator!=(const Iterator<C>& other) const { return m_pos != other.position(); }
+
+    private:
+        void skipUnused() {
+            while (m_map && m_pos < m_map->m_vecUsed.size() && !m_map->m_vecUsed[m_pos])
+                ++m_pos;
+        }
+
+        MapPointer m_map = nullptr;
+        size_t m_pos = 0;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatHashMap() = default;
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, this->capacity()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, this->capacity()); }
+    const_iterator cbegin() const { return this->begin(); }
+    const_iterator cend() const { return this->end(); }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    size_t capacity() const { return m_vecUsed.size(); }
+
+    void clear() {
+        m_vecItem.clear();
+        m_vecUsed.clear();
+        m_size = 0;
+    }
+
+    void reserve(size_t count) {
+        const size_t newCapacity = FlatHashMap::capacityFor(count);
+        if (newCapacity > this->capacity())
+            this->rehash(newCapacity);
+    }
+
+    iterator find(const Key& key) { return iterator(this, this->findPos(key)); }
+    const_iterator find(const Key& key) const { return const_iterator(this, this->findPos(key)); }
+    size_t count(const Key& key) const { return this->findPos(key) != this->capacity() ? 1 : 0; }
+
+    std::pair<iterator, bool> insert(const value_type& item) {
+        return this->emplaceKey(item.first, item.second);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& item) {
+        return this->emplaceKey(std::move(item.first), std::move(item.second));
+    }
+
+    template<typename... Args> std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        return this->emplaceKey(key, std::forward<Args>(args)...);
+    }
+
+    Value& operator[](const Key& key) {
+        return this->emplaceKey(key).first->second;
+    }
+
+    size_t erase(const Key& key) {
+        const size_t pos = this->findPos(key);
+        if (pos == this->capacity())
+            return 0;
+
+        const size_t mask = this->capacity() - 1;
+        size_t posHole = pos;
+        for (size_t posNext = (posHole + 1) & mask; m_vecUsed[posNext]; posNext = (posNext + 1) & mask) {
+            // Item can fill the hole if its ideal slot isn't in the cyclic range ]posHole, posNext]
+            const size_t posIdeal = this->idealPos(m_vecItem[posNext].first);
+            if (((posNext - posIdeal) & mask) >= ((posNext - posHole) & mask)) {
+                m_vecItem[posHole] = std::move(m_vecItem[posNext]);
+                posHole = posNext;
+            }
+        }
+
+        m_vecItem[posHole] = value_type();
+        m_vecUsed[posHole] = false;
+        --m_size;
+        return 1;
+    }
+
+private:
+    // Power of two, maximum load factor is 3/4
+    static size_t capacityFor(size_t count) {
+        size_t capacity = 16;
+        while (count * 4 > capacity * 3)
+            capacity *= 2;
+
+        return capacity;
+    }
+
+    size_t idealPos(const Key& key) const {
+        return HashUtils::mix(Hash{}(key)) & (this->capacity() - 1);
+    }
+
+    // Returns capacity() if not found
+    size_t findPos(const Key& key) const {
+        if (m_size == 0)
+            return this->capacity();
+
+        const size_t mask = this->capacity() - 1;
+        for (size_t pos = this->idealPos(key); m_vecUsed[pos]; pos = (pos + 1) & mask) {
+            if (KeyEqual{}(m_vecItem[pos].first, key))
+                return pos;
+        }
+
+        return this->capacity();
+    }
+
+    size_t freePos(const Key& key) const {
+        const size_t mask = this->capacity() - 1;
+        size_t pos = this->idealPos(key);
+        while (m_vecUsed[pos])
+            pos = (pos + 1) & mask;
+
+        return pos;
+    }
+
+    template<typename K, typename... Args> std::pair<iterator, bool> emplaceKey(K&& key, Args&&... args) {
+        const size_t posFound = this->findPos(key);
+        if (posFound != this->capacity())
+            return { iterator(this, posFound), false };
+
+        if (FlatHashMap::capacityFor(m_size + 1) > this->capacity())
+            this->rehash(std::max(FlatHashMap::capacityFor(m_size + 1), 2 * this->capacity()));
+
+        const size_t pos = this->freePos(key);
+        m_vecItem[pos] = value_type(std::forward<K>(key), Value(std::forward<Args>(args)...));
+        m_vecUsed[pos] = true;
+        ++m_size;
+        return { iterator(this, pos), true };
+    }
+
+    void rehash(size_t newCapacity) {
+        std::vector<value_type> vecOldItem(newCapacity);
+        std::vector<uint8_t> vecOldUsed(newCapacity, false);
+        m_vecItem.swap(vecOldItem);
+        m_vecUsed.swap(vecOldUsed);
+        for (size_t i = 0; i < vecOldUsed.size(); ++i) {
+            if (vecOldUsed[i]) {
+                const size_t pos = this->freePos(vecOldItem[i].first);
+                m_vecItem[pos] = std::move(vecOldItem[i]);
+                m_vecUsed[pos] = true;
+            }
+        }
+    }
+
+    std::vector<value_type> m_vecItem;
+    std::vector<uint8_t> m_vecUsed;
+    size_t m_size = 0;
+};
+
+} // namespace Mayo
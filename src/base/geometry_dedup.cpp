@@ -0,0 +1,276 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "geometry_dedup.h"
+#include "brep_utils.h"
+#include "caf_utils.h"
+#include "cpp_utils.h"
+#include "document.h"
+#include "global.h"
+#include "task_progress.h"
+
+#include <BRepAdaptor_Surface.hxx>
+#include <BRepGProp.hxx>
+#include <Bnd_Box.hxx>
+#include <GProp_GProps.hxx>
+#include <TDataStd_TreeNode.hxx>
+#include <TNaming_Builder.hxx>
+#include <TopExp.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <XCAFDoc.hxx>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Mayo {
+
+namespace {
+
+int64_t roundedValue(double value, double quantum)
+{
+    return std::llround(value / quantum);
+}
+
+struct Product {
+    TDF_Label label;
+    int fileIndex;
+    std::vector<TDF_Label> vecComponent; // Referring to the product
+    GeometryDedup::Fingerprint fingerprint;
+    bool hasColor = false;
+    Quantity_Color color;
+};
+
+// Three int64 so colors are compared exactly, without rounding issues of Quantity_Color::IsEqual()
+std::tuple<bool, int64_t, int64_t, int64_t> productColorKey(const Product& product)
+{
+    if (!product.hasColor)
+        return { false, 0, 0, 0 };
+
+    const double quantum = 1 / 255.;
+    return {
+        true,
+        roundedValue(product.color.Red(), quantum),
+        roundedValue(product.color.Green(), quantum),
+        roundedValue(product.color.Blue(), quantum)
+    };
+}
+
+// Makes component 'lblComponent' refer to product 'lblProduct', location is unchanged
+void redirectComponent(const TDF_Label& lblComponent, const TDF_Label& lblProduct)
+{
+    Handle_TDataStd_TreeNode refNode;
+    if (lblComponent.FindAttribute(XCAFDoc::ShapeRefGUID(), refNode)) {
+        refNode->Remove();
+        Handle_TDataStd_TreeNode mainNode = TDataStd_TreeNode::Set(lblProduct, XCAFDoc::ShapeRefGUID());
+        mainNode->Append(refNode);
+    }
+
+    const TopLoc_Location loc = XCaf::shapeReferenceLocation(lblComponent);
+    TNaming_Builder builder(lblComponent);
+    builder.Generated(XCaf::shape(lblProduct).Moved(loc));
+}
+
+} // namespace
+
+bool GeometryDedup::Fingerprint::operator==(const Fingerprint& other) const
+{
+    return this->arrayShapeCount == other.arrayShapeCount
+            && this->arrayBoxCoord == other.arrayBoxCoord
+            && this->area == other.area
+            && this->volume == other.volume
+            && this->vecFace == other.vecFace;
+}
+
+bool GeometryDedup::Fingerprint::operator<(const Fingerprint& other) const
+{
+    return std::tie(this->arrayShapeCount, this->arrayBoxCoord, this->area, this->volume, this->vecFace)
+            < std::tie(other.arrayShapeCount, other.arrayBoxCoord, other.area, other.volume, other.vecFace);
+}
+
+GeometryDedup::Fingerprint GeometryDedup::fingerprint(const TopoDS_Shape& shape, double linearTolerance)
+{
+    Fingerprint fp;
+    if (shape.IsNull())
+        return fp;
+
+    const TopAbs_ShapeEnum arrayShapeType[] = {
+        TopAbs_SOLID, TopAbs_SHELL, TopAbs_FACE, TopAbs_WIRE, TopAbs_EDGE, TopAbs_VERTEX
+    };
+    for (unsigned i = 0; i < fp.arrayShapeCount.size(); ++i) {
+        TopTools_IndexedMapOfShape mapShape;
+        TopExp::MapShapes(shape, arrayShapeType[i], mapShape);
+        fp.arrayShapeCount.at(i) = mapShape.Extent();
+    }
+
+    const Bnd_Box box = BRepUtils::boundingBox(shape);
+    if (box.IsVoid())
+        return fp;
+
+    double xmin, ymin, zmin, xmax, ymax, zmax;
+    box.Get(xmin, ymin, zmin, xmax, ymax, zmax);
+    const double arrayCoord[] = { xmin, ymin, zmin, xmax, ymax, zmax };
+    for (unsigned i = 0; i < fp.arrayBoxCoord.size(); ++i)
+        fp.arrayBoxCoord.at(i) = roundedValue(arrayCoord[i], linearTolerance);
+
+    const double size = std::max(std::sqrt(box.SquareExtent()), linearTolerance);
+    const double areaQuantum = linearTolerance * size;
+    const double volumeQuantum = linearTolerance * size * size;
+
+    GProp_GProps shapeAreaProps;
+    BRepGProp::SurfaceProperties(shape, shapeAreaProps);
+    fp.area = roundedValue(shapeAreaProps.Mass(), areaQuantum);
+    if (fp.arrayShapeCount.front() > 0) {
+        GProp_GProps shapeVolumeProps;
+        BRepGProp::VolumeProperties(shape, shapeVolumeProps);
+        fp.volume = roundedValue(std::abs(shapeVolumeProps.Mass()), volumeQuantum);
+    }
+
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        GProp_GProps faceProps;
+        BRepGProp::SurfaceProperties(face, faceProps);
+        const BRepAdaptor_Surface surface(face, false);
+        fp.vecFace.push_back({ int(surface.GetType()), roundedValue(faceProps.Mass(), areaQuantum) });
+    });
+    std::sort(fp.vecFace.begin(), fp.vecFace.end());
+    return fp;
+}
+
+std::vector<GeometryDedup::Fingerprint> GeometryDedup::computeFingerprints(
+        Span<const TopoDS_Shape> spanShape,
+        double linearTolerance,
+        TaskProgress* progress,
+        int progressMax)
+{
+    // Shapes are independent, so fingerprints can be computed concurrently
+    const int shapeCount = int(spanShape.size());
+    const int progressMin = progress ? progress->value() : 0;
+    std::vector<Fingerprint> vecFingerprint(spanShape.size());
+    std::atomic<int> doneCount = 0;
+    std::mutex mutexProgress;
+    CppUtils::parallelFor(shapeCount, [&](int i) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        vecFingerprint.at(i) = GeometryDedup::fingerprint(spanShape[i], linearTolerance);
+        const int count = ++doneCount;
+        if (progress) {
+            std::lock_guard<std::mutex> lock(mutexProgress);
+            MAYO_UNUSED(lock);
+            const int pct = progressMin + (count * (progressMax - progressMin)) / shapeCount;
+            if (pct > progress->value())
+                progress->setValue(pct);
+        }
+    });
+
+    return vecFingerprint;
+}
+
+int GeometryDedup::mergeProducts(
+        const DocumentPtr& doc,
+        Span<const TDF_LabelSequence> spanFileEntities,
+        double linearTolerance,
+        TaskProgress* progress)
+{
+    if (doc.IsNull() || spanFileEntities.size() < 2)
+        return 0;
+
+    // Collect the products of each file along with the components referring to them
+    std::vector<Product> vecProduct;
+    std::unordered_map<TDF_Label, int> mapProductIndex;
+    std::unordered_set<TDF_Label> setAssemblyVisited; // Sub-assemblies can be instantiated many times
+    std::function<void(const TDF_Label&, int)> fnCollectProducts;
+    fnCollectProducts = [&](const TDF_Label& label, int fileIndex) {
+        if (!setAssemblyVisited.insert(label).second)
+            return;
+
+        for (const TDF_Label& lblComponent : XCaf::shapeComponents(label)) {
+            const TDF_Label lblReferred = XCaf::shapeReferred(lblComponent);
+            if (XCaf::isShapeAssembly(lblReferred)) {
+                fnCollectProducts(lblReferred, fileIndex);
+                continue;
+            }
+
+            // Products having styled sub-shapes are kept as is
+            if (!XCaf::isShapeSimple(lblReferred) || !XCaf::shapeSubs(lblReferred).IsEmpty())
+                continue;
+
+#if OCC_VERSION_HEX >= 0x070500
+            if (doc->xcaf().visMaterialTool()->IsSetShapeMaterial(lblReferred))
+                continue;
+#endif
+
+            auto [it, isNew] = mapProductIndex.insert({ lblReferred, int(vecProduct.size()) });
+            if (isNew) {
+                Product product;
+                product.label = lblReferred;
+                product.fileIndex = fileIndex;
+                product.hasColor = doc->xcaf().hasShapeColor(lblReferred);
+                product.color = doc->xcaf().shapeColor(lblReferred);
+                vecProduct.push_back(std::move(product));
+            }
+
+            vecProduct.at(it->second).vecComponent.push_back(lblComponent);
+        }
+    };
+    for (unsigned i = 0; i < spanFileEntities.size(); ++i) {
+        for (const TDF_Label& labelEntity : spanFileEntities[i]) {
+            if (XCaf::isShapeAssembly(labelEntity))
+                fnCollectProducts(labelEntity, int(i));
+        }
+    }
+
+    std::vector<TopoDS_Shape> vecProductShape;
+    vecProductShape.reserve(vecProduct.size());
+    for (const Product& product : vecProduct)
+        vecProductShape.push_back(XCaf::shape(product.label));
+
+    std::vector<Fingerprint> vecFingerprint =
+            GeometryDedup::computeFingerprints(vecProductShape, linearTolerance, progress, 90);
+    for (unsigned i = 0; i < vecProduct.size(); ++i)
+        vecProduct.at(i).fingerprint = std::move(vecFingerprint.at(i));
+
+    if (TaskProgress::isAbortRequested(progress))
+        return 0;
+
+    // Products are visited in file order, so a duplicate is mapped to the first occurrence
+    using ProductKey = std::pair<Fingerprint, std::tuple<bool, int64_t, int64_t, int64_t>>;
+    std::map<ProductKey, int> mapKeyProductIndex;
+    int mergedCount = 0;
+    Handle_XCAFDoc_ShapeTool shapeTool = doc->xcaf().shapeTool();
+    for (int i = 0; i < int(vecProduct.size()); ++i) {
+        const Product& product = vecProduct.at(i);
+        if (product.fingerprint.vecFace.empty())
+            continue;
+
+        auto [it, isNew] = mapKeyProductIndex.insert({ { product.fingerprint, productColorKey(product) }, i });
+        const Product& productFirst = vecProduct.at(it->second);
+        // Identical products within the same file are distinct on purpose, keep them
+        if (isNew || productFirst.fileIndex == product.fileIndex)
+            continue;
+
+        for (const TDF_Label& lblComponent : product.vecComponent)
+            redirectComponent(lblComponent, productFirst.label);
+
+        if (shapeTool->RemoveShape(product.label))
+            ++mergedCount;
+    }
+
+    if (mergedCount > 0)
+        shapeTool->UpdateAssemblies();
+
+    if (progress)
+        progress->setValue(100);
+
+    return mergedCount;
+}
+
+} // namespace Mayo
@@ -0,0 +1,72 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "document_ptr.h"
+#include "span.h"
+
+#include <TDF_LabelSequence.hxx>
+#include <TopoDS_Shape.hxx>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Merges the identical products transferred from several files into a document, so standard
+// components instantiated across files share the same XCAF label and shape(meshed once, grouped
+// by the instanced display)
+// Products are the simple shapes referred by assembly components. Two products are identical if
+// their geometry fingerprints and their colors are equal
+struct GeometryDedup {
+    // Topology and geometry properties of a shape, lengths are rounded to some tolerance so
+    // shapes written by different exporters can still match
+    struct Fingerprint {
+        // Count of solids, shells, faces, wires, edges and vertices
+        std::array<int, 6> arrayShapeCount = {};
+        // Rounded bounding box {xmin, ymin, zmin, xmax, ymax, zmax}
+        std::array<int64_t, 6> arrayBoxCoord = {};
+        int64_t area = 0;
+        int64_t volume = 0;
+        // Surface type and rounded area of each face, sorted so face ordering doesn't matter
+        std::vector<std::pair<int, int64_t>> vecFace;
+
+        bool operator==(const Fingerprint& other) const;
+        bool operator<(const Fingerprint& other) const;
+    };
+
+    // 'linearTolerance' is the rounding quantum of lengths, areas and volumes are rounded to
+    // 'linearTolerance' times the bounding box diagonal(and its square)
+    static Fingerprint fingerprint(const TopoDS_Shape& shape, double linearTolerance);
+
+    // Computes concurrently the fingerprints of independent shapes, item 'i' of the returned array
+    // being the fingerprint of spanShape[i]
+    // 'progress' is advanced from its current value up to 'progressMax' as shapes are processed.
+    // On abort the fingerprints not computed yet are left empty
+    static std::vector<Fingerprint> computeFingerprints(
+            Span<const TopoDS_Shape> spanShape,
+            double linearTolerance,
+            TaskProgress* progress = nullptr,
+            int progressMax = 100);
+
+    // Redirects the components referring to a product of some file to the identical product
+    // found first in another file. Duplicate products no longer referred are then removed from
+    // the document
+    // 'spanFileEntities' holds the entities transferred from each file, they must not be part of
+    // the model tree yet(ie before Document::addEntityTreeNode())
+    // Returns the count of products removed
+    static int mergeProducts(
+            const DocumentPtr& doc,
+            Span<const TDF_LabelSequence> spanFileEntities,
+            double linearTolerance,
+            TaskProgress* progress = nullptr);
+};
+
+} // namespace Mayo
@@ -0,0 +1,32 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Mayo {
+
+struct HashUtils {
+    // Finalizer of the SplitMix64 generator: every bit of 'value' affects every bit of the result
+    // Raw pointers and sequential ids have poor entropy in their low bits(alignment), which are
+    // the ones selecting the bucket of a hash table
+    static constexpr size_t mix(uint64_t value) {
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ull;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebull;
+        value ^= value >> 31;
+        return static_cast<size_t>(value);
+    }
+
+    static size_t mixPointer(const void* ptr) {
+        return mix(reinterpret_cast<uintptr_t>(ptr));
+    }
+};
+
+} // namespace Mayo
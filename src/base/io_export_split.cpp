@@ -0,0 +1,149 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_export_split.h"
+#include "caf_utils.h"
+#include "document.h"
+#include "xcaf.h"
+
+#include <unordered_set>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+const char templateName[] = "%name%";
+const char templatePath[] = "%path%";
+
+// Name usable as a file name on any platform
+QString toFilename(const QString& name)
+{
+    QString filename = name.trimmed();
+    for (QChar& c : filename) {
+        if (c.unicode() < 32 || QStringLiteral("/\\:*?\"<>|").contains(c))
+            c = '_';
+    }
+
+    return !filename.isEmpty() ? filename : QStringLiteral("item");
+}
+
+} // namespace
+
+std::vector<ExportSplitTarget> ExportSplitUtils::split(
+        Span<const ApplicationItem> spanAppItem, ExportSplitMode mode, const FilePath& filepathTemplate)
+{
+    std::vector<ExportSplitTarget> vecTarget;
+    if (mode == ExportSplitMode::None)
+        return vecTarget;
+
+    FilePath fpTemplate = filepathTemplate;
+    if (!ExportSplitUtils::isFilepathTemplate(fpTemplate)) {
+        const QString strStem = filepathTo<QString>(fpTemplate.stem());
+        const QString strExtension = filepathTo<QString>(fpTemplate.extension());
+        fpTemplate.replace_filename(filepathFrom(strStem + "_" + templateName + strExtension));
+    }
+
+    std::unordered_set<TDF_Label> setLabelDone;
+    std::unordered_set<FilePath::string_type> setFilepath;
+    auto fnAddTarget = [&](const DocumentPtr& doc, TreeNodeId nodeId) {
+        const Tree<TDF_Label>& modelTree = doc->modelTree();
+        const TDF_Label& label = modelTree.nodeData(nodeId);
+        if (!setLabelDone.insert(label).second)
+            return; // Product already exported through another instance
+
+        // Instance nodes are skipped, as their child node is the product of the same name
+        QStringList listParentName;
+        for (TreeNodeId id = modelTree.nodeParent(nodeId); id != 0; id = modelTree.nodeParent(id)) {
+            const TDF_Label& parentLabel = modelTree.nodeData(id);
+            if (!XCaf::isShapeReference(parentLabel))
+                listParentName.push_front(doc->labelName(parentLabel));
+        }
+
+        const FilePath fpExpanded =
+                ExportSplitUtils::expandFilepathTemplate(fpTemplate, doc->labelName(label), listParentName);
+        FilePath fp = fpExpanded;
+        for (int i = 2; !setFilepath.insert(fp.native()).second; ++i) {
+            const QString strStem = filepathTo<QString>(fpExpanded.stem());
+            const QString strExtension = filepathTo<QString>(fpExpanded.extension());
+            fp = fpExpanded.parent_path() / filepathFrom(QString("%1_%2%3").arg(strStem).arg(i).arg(strExtension));
+        }
+
+        vecTarget.push_back({ DocumentTreeNode(doc, nodeId), fp });
+    };
+
+    auto fnSplitNode = [&](const DocumentPtr& doc, TreeNodeId nodeId) {
+        const Tree<TDF_Label>& modelTree = doc->modelTree();
+        if (mode == ExportSplitMode::LeafParts) {
+            traverseTree(nodeId, modelTree, [&](TreeNodeId id) {
+                if (modelTree.nodeIsLeaf(id))
+                    fnAddTarget(doc, id);
+            });
+        }
+        else if (modelTree.nodeIsLeaf(nodeId)) {
+            fnAddTarget(doc, nodeId);
+        }
+        else {
+            for (TreeNodeId id = modelTree.nodeChildFirst(nodeId); id != 0; id = modelTree.nodeSiblingNext(id)) {
+                const bool isInstance = XCaf::isShapeReference(modelTree.nodeData(id)) && !modelTree.nodeIsLeaf(id);
+                fnAddTarget(doc, isInstance ? modelTree.nodeChildFirst(id) : id);
+            }
+        }
+    };
+
+    for (const ApplicationItem& item : spanAppItem) {
+        if (item.isDocument()) {
+            const DocumentPtr doc = item.document();
+            for (int i = 0; i < doc->entityCount(); ++i)
+                fnSplitNode(doc, doc->entityTreeNodeId(i));
+        }
+        else if (item.isDocumentTreeNode()) {
+            const DocumentTreeNode& node = item.documentTreeNode();
+            fnSplitNode(node.document(), node.id());
+        }
+    }
+
+    return vecTarget;
+}
+
+bool ExportSplitUtils::isFilepathTemplate(const FilePath& fp)
+{
+    const QString str = filepathTo<QString>(fp);
+    return str.contains(templateName) || str.contains(templatePath);
+}
+
+FilePath ExportSplitUtils::expandFilepathTemplate(
+        const FilePath& filepathTemplate, const QString& name, const QStringList& listParentName)
+{
+    QStringList listParentFilename;
+    for (const QString& parentName : listParentName)
+        listParentFilename.push_back(toFilename(parentName));
+
+    QString str = filepathTo<QString>(filepathTemplate);
+    str.replace(templateName, toFilename(name));
+    if (listParentFilename.isEmpty()) {
+        // Avoid "%path%/name" giving the absolute path "/name"
+        str.replace(QString(templatePath) + "/", QString());
+        str.replace(QString(templatePath) + "\\", QString());
+    }
+
+    str.replace(templatePath, listParentFilename.join('/'));
+    return filepathFrom(str).lexically_normal();
+}
+
+ExportSplitMode ExportSplitUtils::modeFromString(const QString& str)
+{
+    if (str.compare(QLatin1String("parts"), Qt::CaseInsensitive) == 0)
+        return ExportSplitMode::LeafParts;
+
+    if (str.compare(QLatin1String("products"), Qt::CaseInsensitive) == 0)
+        return ExportSplitMode::TopLevelProducts;
+
+    return ExportSplitMode::None;
+}
+
+} // namespace IO
+} // namespace Mayo
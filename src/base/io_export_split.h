@@ -0,0 +1,52 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "application_item.h"
+#include "filepath.h"
+#include "span.h"
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <vector>
+
+namespace Mayo {
+namespace IO {
+
+// How application items are split when each one is exported into its own file
+enum class ExportSplitMode {
+    None,
+    LeafParts, // One file per distinct leaf part, a part shared by instances is written once
+    TopLevelProducts // One file per distinct direct child of the entities(entity itself if it's a part)
+};
+
+struct ExportSplitTarget {
+    ApplicationItem item;
+    FilePath filepath;
+};
+
+struct ExportSplitUtils {
+    // Items of 'spanAppItem'(documents or tree nodes) split according to 'mode', file paths of the
+    // targets are given by 'filepathTemplate' where:
+    //     %name% is replaced by the name of the part or product
+    //     %path% is replaced by the names of the parent assemblies, as sub-directories
+    // "_%name%" is appended to the file stem if the template has no such placeholder. File paths
+    // of distinct targets having the same name are made unique with a numeric suffix
+    // Returns an empty vector if 'mode' is ExportSplitMode::None
+    static std::vector<ExportSplitTarget> split(
+            Span<const ApplicationItem> spanAppItem, ExportSplitMode mode, const FilePath& filepathTemplate);
+
+    static bool isFilepathTemplate(const FilePath& fp);
+    static FilePath expandFilepathTemplate(
+            const FilePath& filepathTemplate, const QString& name, const QStringList& listParentName);
+
+    // Parses "parts" or "products", returns ExportSplitMode::None for any other string
+    static ExportSplitMode modeFromString(const QString& str);
+};
+
+} // namespace IO
+} // namespace Mayo
@@ -34,6 +34,11 @@ const Format Format_OBJ = { "OBJ", "Wavefront OBJ", { "obj" } };
 const Format Format_GLTF = { "GLTF", "glTF(GL Transmission Format)", { "gltf", "glb" } };
 const Format Format_VRML = { "VRML", "VRML(ISO/CEI 14772-2)", { "wrl", "wrz", "vrml" } };
 const Format Format_AMF = { "AMF", "Additive manufacturing file format(ISO/ASTM 52915:2016)", { "amf" } };
+const Format Format_3MF = { "3MF", "3D Manufacturing Format", { "3mf" } };
+const Format Format_PLY = { "PLY", "PLY(Polygon File Format)", { "ply" } };
+const Format Format_XYZ = { "XYZ", "XYZ point cloud", { "xyz" } };
+const Format Format_PTS = { "PTS", "Leica PTS point cloud", { "pts" } };
+const Format Format_LAS = { "LAS", "LAS(ASPRS LiDAR data exchange)", { "las" } };
 
 bool formatProvidesBRep(const Format& format);
 bool formatProvidesMesh(const Format& format);
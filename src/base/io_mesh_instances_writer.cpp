@@ -0,0 +1,240 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_mesh_instances_writer.h"
+
+#include "application_item.h"
+#include "brep_utils.h"
+#include "caf_utils.h"
+#include "document.h"
+#include "flat_hash_map.h"
+#include "math_utils.h"
+#include "task_progress.h"
+
+#include <BRep_Tool.hxx>
+#include <TDataXtd_Triangulation.hxx>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+// Packs RGB components of 'color' into a single integer, used as hash key to find materials
+uint64_t packedColor(const Quantity_Color& color)
+{
+    constexpr uint64_t maxComponent = (uint64_t(1) << 21) - 1;
+    auto fnPackComponent = [=](double value) {
+        return uint64_t(std::round(std::clamp(value, 0., 1.) * maxComponent));
+    };
+    return fnPackComponent(color.Red())
+            | (fnPackComponent(color.Green()) << 21)
+            | (fnPackComponent(color.Blue()) << 42);
+}
+
+} // namespace
+
+bool MeshInstancesWriter::transfer(Span<const ApplicationItem> spanAppItem, TaskProgress* progress)
+{
+    m_vecMaterial.clear();
+    m_mapColorMaterialId.clear();
+    m_vecMesh.clear();
+    m_vecObject.clear();
+    m_vecInstance.clear();
+
+    Material defaultMaterial = {};
+    defaultMaterial.id = 0;
+    defaultMaterial.color.SetValues(Quantity_NOC_WHITE);
+    defaultMaterial.isColor = true;
+    m_mapColorMaterialId.insert({ packedColor(defaultMaterial.color), defaultMaterial.id });
+    m_vecMaterial.push_back(std::move(defaultMaterial));
+
+    // Leaf nodes are products, so all instances of a product with the same effective style share
+    // the same object and meshes
+    struct StyledObject {
+        uint32_t styleIndex;
+        int objectId;
+    };
+    FlatHashMap<TDF_Label, std::vector<StyledObject>> mapLabelVecObject;
+    auto fnFindObjectId = [&](const TDF_Label& label, uint32_t styleIndex) {
+        auto it = mapLabelVecObject.find(label);
+        if (it != mapLabelVecObject.cend()) {
+            for (const StyledObject& object : it->second) {
+                if (object.styleIndex == styleIndex)
+                    return object.objectId;
+            }
+        }
+
+        return -1;
+    };
+
+    // Stack of the nodes from tree root to the node being visited, maintained during pre-order
+    // traversal so absolute names and locations are built incrementally from parent ones
+    struct NodePath {
+        TreeNodeId id;
+        TopLoc_Location absoluteLoc;
+        std::string absoluteName; // Names from the node up to tree root, separated with '/'
+    };
+    std::vector<NodePath> vecNodePath;
+    const Document* ptrDoc = nullptr; // Document of the application item being transferred
+    auto fnPushNodePath = [&](const Tree<TDF_Label>& modelTree, TreeNodeId id) {
+        const TreeNodeId parentId = modelTree.nodeParent(id);
+        while (!vecNodePath.empty() && vecNodePath.back().id != parentId)
+            vecNodePath.pop_back();
+
+        const TDF_Label& nodeLabel = modelTree.nodeData(id);
+        const QString name = ptrDoc->labelName(nodeLabel);
+        NodePath nodePath;
+        nodePath.id = id;
+        nodePath.absoluteName = !name.trimmed().isEmpty() ? name.toStdString() : "anonymous";
+        nodePath.absoluteLoc = XCaf::shapeReferenceLocation(nodeLabel);
+        if (!vecNodePath.empty()) {
+            const NodePath& parentPath = vecNodePath.back();
+            nodePath.absoluteName += '/' + parentPath.absoluteName;
+            nodePath.absoluteLoc = parentPath.absoluteLoc * nodePath.absoluteLoc;
+        }
+
+        vecNodePath.push_back(std::move(nodePath));
+    };
+
+    auto fnCreateObject = [&](const Tree<TDF_Label>& modelTree, TreeNodeId id) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        if (modelTree.nodeIsLeaf(id)) {
+            const TDF_Label& nodeLabel = modelTree.nodeData(id);
+            const XCaf& xcaf = ptrDoc->xcaf();
+            const uint32_t styleIndex = xcaf.shapeStyleIndex(id);
+            int objectId = fnFindObjectId(nodeLabel, styleIndex);
+            if (objectId == -1) {
+                objectId = this->createObject(nodeLabel, xcaf.shapeStyleAt(styleIndex));
+                if (objectId == -1)
+                    return;
+
+                mapLabelVecObject[nodeLabel].push_back({ styleIndex, objectId });
+            }
+
+            const TreeNodeId parentId = modelTree.nodeParent(id);
+            while (!vecNodePath.empty() && vecNodePath.back().id != parentId)
+                vecNodePath.pop_back();
+
+            if (!vecNodePath.empty()) {
+                const NodePath& parentPath = vecNodePath.back();
+                Instance instance;
+                instance.objectId = objectId;
+                instance.trsf = parentPath.absoluteLoc * XCaf::shapeReferenceLocation(nodeLabel);
+                instance.name = parentPath.absoluteName;
+                m_vecInstance.push_back(std::move(instance));
+            }
+        }
+        else {
+            fnPushNodePath(modelTree, id);
+        }
+    };
+
+    for (const ApplicationItem& appItem : spanAppItem) {
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+
+        const int appItemIndex = &appItem - &spanAppItem.front();
+        if (progress)
+            progress->setValue(MathUtils::mappedValue(appItemIndex, 0, spanAppItem.size() - 1, 0, 100));
+        ptrDoc = appItem.document().get();
+        const Tree<TDF_Label>& modelTree = ptrDoc->modelTree();
+        if (appItem.isDocument()) {
+            traverseTree(modelTree, [&](TreeNodeId id) { fnCreateObject(modelTree, id); });
+        }
+        else if (appItem.isDocumentTreeNode()) {
+            // Ancestors of the tree node contribute to absolute names and locations
+            const TreeNodeId startId = appItem.documentTreeNode().id();
+            std::vector<TreeNodeId> vecAncestorId;
+            for (TreeNodeId it = modelTree.nodeParent(startId); it != 0; it = modelTree.nodeParent(it))
+                vecAncestorId.push_back(it);
+
+            std::for_each(vecAncestorId.crbegin(), vecAncestorId.crend(), [&](TreeNodeId ancestorId) {
+                fnPushNodePath(modelTree, ancestorId);
+            });
+            traverseTree(startId, modelTree, [&](TreeNodeId id) { fnCreateObject(modelTree, id); });
+        }
+
+        vecNodePath.clear();
+    }
+
+    return true;
+}
+
+int MeshInstancesWriter::createObject(const TDF_Label& labelShape, const XCaf::ShapeStyle& style)
+{
+    // Object meshes
+    const int meshCount = int(m_vecMesh.size());
+
+    auto fnAddMesh = [&](const Handle_Poly_Triangulation& polyTri, const TopLoc_Location& loc, bool isReversed) {
+        if (!polyTri.IsNull()) {
+            Mesh mesh;
+            mesh.id = int(m_vecMesh.size());
+            mesh.triangulation = polyTri;
+            mesh.location = loc;
+            mesh.isReversed = isReversed;
+            // TODO mesh.materialId = ?
+            m_vecMesh.push_back(std::move(mesh));
+        }
+    };
+
+    // -- Shape ?
+    const TopoDS_Shape shape = XCaf::shape(labelShape);
+    if (!shape.IsNull()) {
+        BRepUtils::forEachSubFace(shape, [=](const TopoDS_Face& face){
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation& polyTri = BRep_Tool::Triangulation(face, loc);
+            fnAddMesh(polyTri, loc, face.Orientation() == TopAbs_REVERSED);
+        });
+    }
+
+    // -- Triangulation ?
+    auto attrPolyTri = CafUtils::findAttribute<TDataXtd_Triangulation>(labelShape);
+    if (!attrPolyTri.IsNull()) {
+        fnAddMesh(attrPolyTri->Get(), TopLoc_Location(), false);
+    }
+
+    if (m_vecMesh.size() == meshCount)
+        return -1;
+
+    // Object material
+    int materialId = -1;
+    if (style.hasColor) {
+        const Quantity_Color& color = style.color;
+        const uint64_t colorKey = packedColor(color);
+        auto itColor = m_mapColorMaterialId.find(colorKey);
+        if (itColor != m_mapColorMaterialId.cend()) {
+            materialId = itColor->second;
+        }
+        else {
+            materialId = m_vecMaterial.size();
+            Material material;
+            material.id = materialId;
+            material.color = color;
+            material.isColor = true;
+            m_vecMaterial.push_back(std::move(material));
+            m_mapColorMaterialId.insert({ colorKey, materialId });
+        }
+    }
+
+    // Add object
+    DocumentPtr doc = Document::findFrom(labelShape);
+    Object object;
+    object.id = m_vecObject.size();
+    object.firstMeshId = meshCount;
+    object.lastMeshId = m_vecMesh.size() - 1;
+    object.name = (doc ? doc->labelName(labelShape) : CafUtils::labelAttrStdName(labelShape)).toStdString();
+    object.materialId = materialId;
+    m_vecObject.push_back(std::move(object));
+    return m_vecObject.back().id;
+}
+
+} // namespace IO
+} // namespace Mayo
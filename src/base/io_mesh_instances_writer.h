@@ -0,0 +1,76 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "io_writer.h"
+#include "xcaf.h"
+
+#include <Poly_Triangulation.hxx>
+#include <Quantity_Color.hxx>
+#include <TopLoc_Location.hxx>
+#include <gp_Trsf.hxx>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Mayo {
+namespace IO {
+
+// Base of writers exporting meshes as objects placed by instances, like additive manufacturing
+// formats(eg AMF, 3MF)
+// Leaf nodes of the model tree are products, so all instances of a product with the same
+// effective style share the same object and meshes
+class MeshInstancesWriter : public Writer {
+public:
+    bool transfer(Span<const ApplicationItem> spanAppItem, TaskProgress* progress) override;
+
+protected:
+    struct Instance {
+        int objectId = -1;
+        gp_Trsf trsf;
+        std::string name;
+    };
+
+    // Material 0 is the default one(white)
+    struct Material {
+        int id = -1;
+        Quantity_Color color;
+        bool isColor = false;
+    };
+
+    // Meshes of an object are [firstMeshId, lastMeshId]
+    struct Object {
+        int id = -1;
+        int firstMeshId = 0;
+        int lastMeshId = -1;
+        int materialId = -1;
+        std::string name;
+    };
+
+    struct Mesh {
+        int id = -1;
+        Handle_Poly_Triangulation triangulation;
+        TopLoc_Location location;
+        bool isReversed = false; // Orientation of the owner face
+        int materialId = -1;
+    };
+
+    std::vector<Material> m_vecMaterial;
+    std::vector<Mesh> m_vecMesh;
+    std::vector<Object> m_vecObject;
+    std::vector<Instance> m_vecInstance;
+
+private:
+    int createObject(const TDF_Label& labelShape, const XCaf::ShapeStyle& style);
+
+    std::unordered_map<uint64_t, int> m_mapColorMaterialId; // Key is a packed RGB color
+};
+
+} // namespace IO
+} // namespace Mayo
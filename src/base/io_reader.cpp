@@ -0,0 +1,49 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_reader.h"
+#include "stream_utils.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QTemporaryFile>
+#include <istream>
+
+namespace Mayo {
+namespace IO {
+
+Reader::~Reader()
+{
+    this->removeSpoolFile();
+}
+
+bool Reader::readStream(std::istream& istr, const FilePath& name, TaskProgress* progress)
+{
+    this->removeSpoolFile();
+
+    // File suffix is kept, some readers depend on it
+    const QString strSuffix = filepathTo<QString>(name.extension());
+    QTemporaryFile file(QDir::tempPath() + "/mayo_stream_XXXXXX" + strSuffix);
+    file.setAutoRemove(false);
+    if (!file.open())
+        return false;
+
+    m_spoolFilepath = filepathFrom(file.fileName());
+    const bool okCopy = StreamUtils::copy(istr, &file);
+    file.close();
+    return okCopy && this->readFile(m_spoolFilepath, progress);
+}
+
+void Reader::removeSpoolFile()
+{
+    if (!m_spoolFilepath.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(m_spoolFilepath, ec);
+        m_spoolFilepath.clear();
+    }
+}
+
+} // namespace IO
+} // namespace Mayo
@@ -11,6 +11,7 @@
 #include "io_format.h"
 #include "span.h"
 #include <TDF_LabelSequence.hxx>
+#include <iosfwd>
 #include <memory>
 
 namespace Mayo {
@@ -22,10 +23,31 @@ namespace IO {
 
 class Reader {
 public:
-    virtual ~Reader() = default;
+    virtual ~Reader();
     virtual bool readFile(const FilePath& fp, TaskProgress* progress) = 0;
+
+    // Reads data from stream 'istr'(eg standard input, pipe), 'name' identifies the data and is
+    // used like the file path of readFile()(eg naming of entities), it can be empty
+    // Default implementation copies the stream into a temporary file passed to readFile(), the
+    // file is kept until the reader is destroyed. Readers able to parse streams override this
+    virtual bool readStream(std::istream& istr, const FilePath& name, TaskProgress* progress);
+    // Whether readStream() parses the stream itself, ie without any temporary file
+    virtual bool readsStream() const { return false; }
+
     virtual TDF_LabelSequence transfer(DocumentPtr doc, TaskProgress* progress) = 0;
     virtual void applyProperties(const PropertyGroup* /*params*/) {}
+
+    // Clears the data of the previous read/transfer and restores the default parameters, so the
+    // reader can be reused for other inputs(see System::takeReader())
+    // Returns false if the reader can't be reused, which is the default
+    virtual bool resetSession() { return false; }
+
+protected:
+    // Removes the temporary file created by readStream(), if any
+    void removeSpoolFile();
+
+private:
+    FilePath m_spoolFilepath; // Temporary file created by readStream()
 };
 
 class FactoryReader {
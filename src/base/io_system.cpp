@@ -6,22 +6,36 @@
 
 #include "io_system.h"
 
+#include "async_file_stream.h"
+#include "decompression_stream.h"
 #include "document.h"
+#include "geometry_dedup.h"
+#include "global.h"
 #include "io_parameters_provider.h"
 #include "io_reader.h"
 #include "io_writer.h"
 #include "messenger.h"
+#include "perf_stats.h"
+#include "stream_utils.h"
 #include "string_utils.h"
 #include "task_manager.h"
 #include "task_progress.h"
 
+#include <QtCore/QFile>
+
 #include <algorithm>
-#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <future>
+#include <istream>
 #include <locale>
 #include <mutex>
-#include <regex>
+#include <string>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 namespace Mayo {
@@ -46,37 +60,267 @@ bool containsFormat(Span<const Format> spanFormat, const Format& format)
     return itFormat != spanFormat.end();
 }
 
+// Thread-safe FIFO queue, items are pushed by producer threads and popped by one consumer
+template<typename T>
+class CompletionQueue {
+public:
+    void push(T item) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push_back(std::move(item));
+        }
+
+        m_cond.notify_one();
+    }
+
+    // Waits until an item is available or 'timeout' is expired
+    // Returns true if an item was popped and stored in 'ptrItem'
+    template<typename DURATION>
+    bool waitPop(T* ptrItem, DURATION timeout) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_cond.wait_for(lock, timeout, [=]{ return !m_queue.empty(); }))
+            return false;
+
+        *ptrItem = std::move(m_queue.front());
+        m_queue.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<T> m_queue;
+};
+
 } // namespace
 
 void System::addFormatProbe(const FormatProbe& probe)
 {
+    this->clearFormatProbeCache();
     m_vecFormatProbe.push_back(probe);
 }
 
 Format System::probeFormat(const FilePath& filepath) const
 {
-    std::ifstream file;
-    file.open(filepath);
-    if (file.is_open()) {
-        std::array<char, 2048> buff;
-        buff.fill(0);
-        file.read(buff.data(), buff.size());
+    std::error_code ec;
+    const auto lastWriteTime = std::filesystem::last_write_time(filepath, ec);
+    const uint64_t fileSize = !ec ? std::filesystem::file_size(filepath, ec) : 0;
+    const bool isCacheable = !ec;
+    if (isCacheable) {
+        std::lock_guard<std::mutex> lock(m_mutexFormatProbeCache);
+        auto it = m_mapFormatProbeCache.find(filepath.native());
+        if (it != m_mapFormatProbeCache.cend()
+                && it->second.lastWriteTime == lastWriteTime
+                && it->second.fileSize == fileSize)
+        {
+            return it->second.format;
+        }
+    }
+
+    const Format format = this->probeFormatUncached(filepath);
+    if (isCacheable) {
+        std::lock_guard<std::mutex> lock(m_mutexFormatProbeCache);
+        m_mapFormatProbeCache[filepath.native()] = { lastWriteTime, fileSize, format };
+    }
+
+    return format;
+}
+
+void System::clearFormatProbeCache()
+{
+    std::lock_guard<std::mutex> lock(m_mutexFormatProbeCache);
+    m_mapFormatProbeCache.clear();
+}
+
+void System::addMetadataScanner(const Format& format, const MetadataScanner& scanner)
+{
+    this->clearMetadataCache();
+    m_vecMetadataScanner.push_back({ format, scanner });
+}
+
+std::optional<System::FileMetadata> System::scanMetadata(const FilePath& filepath) const
+{
+    std::error_code ec;
+    const auto lastWriteTime = std::filesystem::last_write_time(filepath, ec);
+    const uint64_t fileSize = !ec ? std::filesystem::file_size(filepath, ec) : 0;
+    if (ec)
+        return {};
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutexMetadataCache);
+        auto it = m_mapMetadataCache.find(filepath.native());
+        if (it != m_mapMetadataCache.cend()
+                && it->second.lastWriteTime == lastWriteTime
+                && it->second.fileSize == fileSize)
+        {
+            return it->second.metadata;
+        }
+    }
+
+    std::optional<FileMetadata> metadata;
+    const Format format = this->probeFormat(filepath);
+    auto itScanner = std::find_if(
+                m_vecMetadataScanner.cbegin(),
+                m_vecMetadataScanner.cend(),
+                [&](const std::pair<Format, MetadataScanner>& pair) { return pair.first == format; }
+    );
+    if (itScanner != m_vecMetadataScanner.cend()) {
+        FileMetadata data;
+        data.format = format;
+        std::ifstream ifs(filepath, std::ios::in | std::ios::binary);
+        const CompressionFormat compression = DecompressionUtils::probeFile(filepath);
+        bool okScan = false;
+        if (compression != CompressionFormat::None && DecompressionUtils::isAvailable()) {
+            DecompressionInputStream istr(ifs, compression);
+            okScan = itScanner->second(istr, &data) && !istr.buffer().hasError();
+        }
+        else if (ifs.is_open()) {
+            okScan = itScanner->second(ifs, &data);
+        }
+
+        if (okScan)
+            metadata = std::move(data);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutexMetadataCache);
+    m_mapMetadataCache[filepath.native()] = { lastWriteTime, fileSize, metadata };
+    return metadata;
+}
+
+void System::clearMetadataCache()
+{
+    std::lock_guard<std::mutex> lock(m_mutexMetadataCache);
+    m_mapMetadataCache.clear();
+}
+
+Format System::probeFormat(std::istream& istr, const FilePath& nameHint) const
+{
+    const std::streampos pos = istr.tellg();
+    if (pos == std::streampos(-1))
+        return Format_Unknown;
+
+    istr.seekg(0, std::ios_base::end);
+    const std::streampos posEnd = istr.tellg();
+    istr.seekg(pos);
+    const uint64_t size = posEnd > pos ? uint64_t(posEnd - pos) : 0;
+
+    FormatProbeInput probeInput = {};
+    probeInput.filepath = nameHint;
+    probeInput.contentsWindow.resize(int(std::min(size, ProbeWindowSize)));
+    istr.read(probeInput.contentsWindow.data(), probeInput.contentsWindow.size());
+    probeInput.contentsWindow.resize(int(istr.gcount()));
+    istr.clear();
+    istr.seekg(pos);
+
+    const std::string_view head(probeInput.contentsWindow.constData(), probeInput.contentsWindow.size());
+    const CompressionFormat compression = DecompressionUtils::probe(head);
+    if (compression != CompressionFormat::None && DecompressionUtils::isAvailable()) {
+        char tail[4] = {};
+        if (size >= sizeof(tail)) {
+            istr.seekg(-std::streamoff(sizeof(tail)), std::ios_base::end);
+            istr.read(tail, sizeof(tail));
+            istr.clear();
+            istr.seekg(pos);
+        }
+
+        return this->probeFormatCompressed(nameHint, head, std::string_view(tail, sizeof(tail)), compression);
+    }
+
+    probeInput.contentsBegin = probeInput.contentsWindow.left(int(ProbeExcerptSize));
+    probeInput.contentsBegin.append(int(ProbeExcerptSize) - probeInput.contentsBegin.size(), '\0');
+    probeInput.hintFullSize = size;
+    const Format format = this->probeFormatContents(probeInput);
+    return format != Format_Unknown ? format : this->probeFormatSuffix(nameHint);
+}
+
+Format System::probeFormatUncached(const FilePath& filepath) const
+{
+    QFile file(filepathTo<QString>(filepath));
+    if (file.open(QIODevice::ReadOnly)) {
+        const uint64_t fileSize = file.size();
+        const uint64_t windowSize = std::min(fileSize, ProbeWindowSize);
+        // Map the file window instead of copying it, fallback to regular read if mapping fails
+        QByteArray bytesWindow;
+        const uchar* mappedWindow = windowSize > 0 ? file.map(0, windowSize) : nullptr;
+        if (!mappedWindow)
+            bytesWindow = file.read(windowSize);
+
         FormatProbeInput probeInput = {};
         probeInput.filepath = filepath;
-        probeInput.contentsBegin = QByteArray::fromRawData(buff.data(), buff.size());
-        probeInput.hintFullSize = std::filesystem::file_size(filepath);
-        for (const FormatProbe& fnProbe : m_vecFormatProbe) {
-            const Format format = fnProbe(probeInput);
-            if (format != Format_Unknown)
-                return format;
+        if (mappedWindow) {
+            auto charWindow = reinterpret_cast<const char*>(mappedWindow);
+            probeInput.contentsWindow = QByteArray::fromRawData(charWindow, int(windowSize));
+        }
+        else {
+            probeInput.contentsWindow = bytesWindow;
         }
+
+        const std::string_view head(probeInput.contentsWindow.constData(), probeInput.contentsWindow.size());
+        const CompressionFormat compression = DecompressionUtils::probe(head);
+        if (compression != CompressionFormat::None && DecompressionUtils::isAvailable()) {
+            QByteArray bytesTail;
+            if (fileSize <= windowSize) {
+                bytesTail = probeInput.contentsWindow;
+            }
+            else if (file.seek(fileSize - 4)) {
+                bytesTail = file.read(4);
+            }
+
+            const std::string_view tail(bytesTail.constData(), bytesTail.size());
+            return this->probeFormatCompressed(filepath, head, tail, compression);
+        }
+
+        probeInput.contentsBegin = probeInput.contentsWindow.left(int(ProbeExcerptSize));
+        probeInput.contentsBegin.append(int(ProbeExcerptSize) - probeInput.contentsBegin.size(), '\0');
+        probeInput.hintFullSize = fileSize;
+        const Format format = this->probeFormatContents(probeInput);
+        if (format != Format_Unknown)
+            return format;
     }
 
+    return this->probeFormatSuffix(filepath);
+}
+
+Format System::probeFormatContents(const FormatProbeInput& input) const
+{
+    for (const FormatProbe& fnProbe : m_vecFormatProbe) {
+        const Format format = fnProbe(input);
+        if (format != Format_Unknown)
+            return format;
+    }
+
+    return Format_Unknown;
+}
+
+Format System::probeFormatCompressed(
+        const FilePath& filepath,
+        std::string_view head,
+        std::string_view tail,
+        CompressionFormat compression) const
+{
+    FilePath innerFilepath = DecompressionUtils::innerFilepath(filepath);
+    const std::string innerHead =
+            DecompressionUtils::decompressHead(head, compression, ProbeWindowSize, &innerFilepath);
+    FormatProbeInput probeInput = {};
+    probeInput.filepath = innerFilepath;
+    probeInput.contentsWindow = QByteArray::fromRawData(innerHead.data(), int(innerHead.size()));
+    probeInput.contentsBegin = probeInput.contentsWindow.left(int(ProbeExcerptSize));
+    probeInput.contentsBegin.append(int(ProbeExcerptSize) - probeInput.contentsBegin.size(), '\0');
+    probeInput.hintFullSize = DecompressionUtils::uncompressedSizeHint(head, tail, compression);
+    const Format format = this->probeFormatContents(probeInput);
+    return format != Format_Unknown ? format : this->probeFormatSuffix(innerFilepath);
+}
+
+Format System::probeFormatSuffix(const FilePath& filepath) const
+{
     // Try to guess from file suffix
     QString fileSuffix = filepathTo<QString>(filepath.extension());
     if (fileSuffix.startsWith('.'))
         fileSuffix.remove(0, 1);
 
+    if (fileSuffix.isEmpty())
+        return Format_Unknown;
+
     auto fnMatchFileSuffix = [=](const Format& format) {
         return format.fileSuffixes.contains(fileSuffix, Qt::CaseInsensitive);
     };
@@ -167,6 +411,296 @@ std::unique_ptr<Writer> System::createWriter(const Format& format) const
     return {};
 }
 
+namespace {
+
+// Maximum count of instances kept by a pool, matches the count of tasks that can run concurrently
+size_t maxPooledCount()
+{
+    return std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+}
+
+template<typename T>
+std::unique_ptr<T> takePooled(const Format& format, std::unordered_map<std::string, std::vector<std::unique_ptr<T>>>& mapPool)
+{
+    auto it = mapPool.find(format.identifier.toStdString());
+    if (it == mapPool.end() || it->second.empty())
+        return {};
+
+    std::unique_ptr<T> ptr = std::move(it->second.back());
+    it->second.pop_back();
+    return ptr;
+}
+
+template<typename T>
+void recyclePooled(
+        const Format& format,
+        std::unique_ptr<T> ptr,
+        std::unordered_map<std::string, std::vector<std::unique_ptr<T>>>& mapPool)
+{
+    auto& vecPooled = mapPool[format.identifier.toStdString()];
+    if (vecPooled.size() < maxPooledCount())
+        vecPooled.push_back(std::move(ptr));
+}
+
+} // namespace
+
+System::~System()
+{
+    if (m_futureWarmUp.valid())
+        m_futureWarmUp.wait();
+}
+
+std::unique_ptr<Reader> System::takeReader(const Format& format) const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutexPool);
+        std::unique_ptr<Reader> reader = takePooled(format, m_mapPooledReaders);
+        if (reader)
+            return reader;
+    }
+
+    return this->createReader(format);
+}
+
+std::unique_ptr<Writer> System::takeWriter(const Format& format) const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutexPool);
+        std::unique_ptr<Writer> writer = takePooled(format, m_mapPooledWriters);
+        if (writer)
+            return writer;
+    }
+
+    return this->createWriter(format);
+}
+
+void System::recycleReader(const Format& format, std::unique_ptr<Reader> reader) const
+{
+    // Reset is done outside of the lock, it may release lots of data
+    if (!reader || !reader->resetSession())
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutexPool);
+    recyclePooled(format, std::move(reader), m_mapPooledReaders);
+}
+
+void System::recycleWriter(const Format& format, std::unique_ptr<Writer> writer) const
+{
+    if (!writer || !writer->resetSession())
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutexPool);
+    recyclePooled(format, std::move(writer), m_mapPooledWriters);
+}
+
+void System::warmUpAsync(Span<const Format> formats)
+{
+    if (m_futureWarmUp.valid())
+        m_futureWarmUp.wait();
+
+    std::vector<Format> vecFormat(formats.begin(), formats.end());
+    m_futureWarmUp = std::async(std::launch::async, [this, vecFormat]{
+        for (const Format& format : vecFormat) {
+            // Only pooled if reusable, otherwise creation still initialized the translator
+            this->recycleReader(format, this->createReader(format));
+            this->recycleWriter(format, this->createWriter(format));
+        }
+    });
+}
+
+bool System::prefetchFile(
+        const FilePath& filepath,
+        const ParametersProvider* parametersProvider,
+        TaskProgress* progress)
+{
+    std::error_code ec;
+    const auto lastWriteTime = std::filesystem::last_write_time(filepath, ec);
+    const uint64_t fileSize = !ec ? std::filesystem::file_size(filepath, ec) : 0;
+    if (ec || DecompressionUtils::probeFile(filepath) != CompressionFormat::None)
+        return false;
+
+    std::vector<std::pair<Format, std::unique_ptr<Reader>>> vecReleased;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexPrefetch);
+        vecReleased = this->popExpiredPrefetches();
+        auto it = m_mapPrefetch.find(filepath.native());
+        if (it != m_mapPrefetch.end()) {
+            PrefetchEntry& entry = it->second;
+            if (!entry.reader)
+                return false; // Being prefetched by another call
+
+            if (entry.lastWriteTime == lastWriteTime
+                    && entry.fileSize == fileSize
+                    && entry.parametersProvider == parametersProvider)
+            {
+                entry.expiryTime = std::chrono::steady_clock::now() + m_prefetchKeepAliveTime;
+                return true;
+            }
+
+            vecReleased.push_back({ entry.format, std::move(entry.reader) });
+            m_mapPrefetch.erase(it);
+        }
+
+        // Discard the least recently prefetched files, the ones being read are left as is
+        while (int(m_mapPrefetch.size()) >= m_prefetchCapacity) {
+            auto itOldest = m_mapPrefetch.end();
+            for (auto itEntry = m_mapPrefetch.begin(); itEntry != m_mapPrefetch.end(); ++itEntry) {
+                if (itEntry->second.reader
+                        && (itOldest == m_mapPrefetch.end() || itEntry->second.expiryTime < itOldest->second.expiryTime))
+                {
+                    itOldest = itEntry;
+                }
+            }
+
+            if (itOldest == m_mapPrefetch.end())
+                break;
+
+            vecReleased.push_back({ itOldest->second.format, std::move(itOldest->second.reader) });
+            m_mapPrefetch.erase(itOldest);
+        }
+
+        if (int(m_mapPrefetch.size()) >= m_prefetchCapacity)
+            return false;
+
+        PrefetchEntry entry;
+        entry.lastWriteTime = lastWriteTime;
+        entry.fileSize = fileSize;
+        entry.parametersProvider = parametersProvider;
+        m_mapPrefetch.insert({ filepath.native(), std::move(entry) });
+    }
+
+    for (auto& [releasedFormat, releasedReader] : vecReleased)
+        this->recycleReader(releasedFormat, std::move(releasedReader));
+
+    const Format format = this->probeFormat(filepath);
+    std::unique_ptr<Reader> reader = format != Format_Unknown ? this->takeReader(format) : nullptr;
+    bool okRead = false;
+    if (reader) {
+        if (parametersProvider)
+            reader->applyProperties(parametersProvider->findReaderParameters(format));
+
+        TaskProgress* readProgress = progress ? progress : nullTaskProgress();
+        okRead = reader->readFile(filepath, readProgress) && !TaskProgress::isAbortRequested(readProgress);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutexPrefetch);
+        auto it = m_mapPrefetch.find(filepath.native());
+        if (it != m_mapPrefetch.end()) {
+            if (okRead) {
+                it->second.format = format;
+                it->second.reader = std::move(reader);
+                it->second.expiryTime = std::chrono::steady_clock::now() + m_prefetchKeepAliveTime;
+            }
+            else {
+                m_mapPrefetch.erase(it);
+            }
+        }
+    }
+
+    m_condPrefetch.notify_all();
+    if (reader) // Read failed
+        this->recycleReader(format, std::move(reader));
+
+    return okRead;
+}
+
+void System::purgeExpiredPrefetches()
+{
+    std::vector<std::pair<Format, std::unique_ptr<Reader>>> vecReleased;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexPrefetch);
+        vecReleased = this->popExpiredPrefetches();
+    }
+
+    for (auto& [format, reader] : vecReleased)
+        this->recycleReader(format, std::move(reader));
+}
+
+void System::clearPrefetches()
+{
+    std::vector<std::pair<Format, std::unique_ptr<Reader>>> vecReleased;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexPrefetch);
+        for (auto it = m_mapPrefetch.begin(); it != m_mapPrefetch.end(); ) {
+            if (it->second.reader) {
+                vecReleased.push_back({ it->second.format, std::move(it->second.reader) });
+                it = m_mapPrefetch.erase(it);
+            }
+            else {
+                ++it; // Being read, discarded by takePrefetchedReader() or once expired
+            }
+        }
+    }
+
+    for (auto& [format, reader] : vecReleased)
+        this->recycleReader(format, std::move(reader));
+}
+
+std::unique_ptr<Reader> System::takePrefetchedReader(
+        const FilePath& filepath,
+        const ParametersProvider* parametersProvider,
+        Format* ptrFormat)
+{
+    std::error_code ec;
+    const auto lastWriteTime = std::filesystem::last_write_time(filepath, ec);
+    const uint64_t fileSize = !ec ? std::filesystem::file_size(filepath, ec) : 0;
+    if (ec)
+        return {};
+
+    std::unique_ptr<Reader> reader;
+    Format format = Format_Unknown;
+    bool isUsable = false;
+    {
+        std::unique_lock<std::mutex> lock(m_mutexPrefetch);
+        auto it = m_mapPrefetch.find(filepath.native());
+        if (it == m_mapPrefetch.end())
+            return {};
+
+        m_condPrefetch.wait(lock, [&]{
+            it = m_mapPrefetch.find(filepath.native());
+            return it == m_mapPrefetch.end() || it->second.reader;
+        });
+        if (it == m_mapPrefetch.end())
+            return {}; // Prefetch failed or aborted
+
+        const PrefetchEntry& entry = it->second;
+        isUsable =
+                entry.lastWriteTime == lastWriteTime
+                && entry.fileSize == fileSize
+                && entry.parametersProvider == parametersProvider
+                && entry.expiryTime >= std::chrono::steady_clock::now();
+        format = entry.format;
+        reader = std::move(it->second.reader);
+        m_mapPrefetch.erase(it);
+    }
+
+    if (!isUsable) {
+        this->recycleReader(format, std::move(reader));
+        return {};
+    }
+
+    *ptrFormat = format;
+    return reader;
+}
+
+std::vector<std::pair<Format, std::unique_ptr<Reader>>> System::popExpiredPrefetches()
+{
+    std::vector<std::pair<Format, std::unique_ptr<Reader>>> vecExpired;
+    const auto now = std::chrono::steady_clock::now();
+    for (auto it = m_mapPrefetch.begin(); it != m_mapPrefetch.end(); ) {
+        if (it->second.reader && it->second.expiryTime < now) {
+            vecExpired.push_back({ it->second.format, std::move(it->second.reader) });
+            it = m_mapPrefetch.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    return vecExpired;
+}
+
 QString System::fileFilter(const Format& format)
 {
     if (format == Format_Unknown)
@@ -193,14 +727,38 @@ bool System::importInDocument(const Args_ImportInDocument& args)
 {
     // NOTE
     // Maybe STEP/IGES CAF ReadFile() can be run concurrently(they should)
-    // But concurrent calls to Transfer() to the same target Document must be serialized
+    // But concurrent calls to Transfer() to the same target Document must be serialized, this is
+    // why transfers are all executed in the calling thread
 
     DocumentPtr doc = args.targetDocument;
-    const auto listFilepath = args.filepaths;
+    const auto listFilepath =
+            args.inputStream ? Span<const FilePath>(&args.inputStreamName, 1) : args.filepaths;
     TaskProgress* rootProgress = args.progress ? args.progress : nullTaskProgress();
     Messenger* messenger = args.messenger ? args.messenger : nullMessenger();
+    PerfStats* perfStats = PerfStats::of(args.progress);
+    if (perfStats)
+        perfStats->addCounter("io.files", listFilepath.size());
+
+    std::atomic<bool> ok = true;
+
+    // Pipes can't be rewound after format probing, so their data is gathered in memory first
+    std::istream* inputStream = args.inputStream;
+    std::string inputStreamData;
+    std::unique_ptr<StreamUtils::MemoryInputBuffer> inputStreamBuffer;
+    std::unique_ptr<std::istream> inputStreamMemory;
+    if (inputStream && !StreamUtils::isSeekable(*inputStream)) {
+        PerfScopedTimer timer(perfStats, "io.streamGather");
+        if (!StreamUtils::readAll(*inputStream, &inputStreamData)) {
+            messenger->emitError(tr("Error during import of '%1'\n%2")
+                                 .arg(filepathTo<QString>(args.inputStreamName), tr("Stream read problem")));
+            return false;
+        }
 
-    bool ok = true;
+        inputStreamBuffer = std::make_unique<StreamUtils::MemoryInputBuffer>(
+                    inputStreamData.data(), inputStreamData.size());
+        inputStreamMemory = std::make_unique<std::istream>(inputStreamBuffer.get());
+        inputStream = inputStreamMemory.get();
+    }
 
     using ReaderPtr = std::unique_ptr<Reader>;
     struct TaskData {
@@ -210,12 +768,22 @@ bool System::importInDocument(const Args_ImportInDocument& args)
         TaskProgress* progress = nullptr;
         TaskId taskId = 0;
         TDF_LabelSequence seqTransferredEntity;
+        std::promise<void> promiseTransferred;
+        std::future<void> futureTransferred;
         bool readSuccess = false;
         bool transferred = false;
     };
 
+    // Batch post-processing of many files is executed once all files are transferred, otherwise
+    // post-processing is part of the read/transfer task of each file
+    const bool isPostProcessBatched = args.entitiesPostProcess && listFilepath.size() > 1;
+    // Deduplication needs all files transferred, post-processing of shared products then can't
+    // be run per file(concurrent meshing of the same shape), so it's deferred as well
+    const bool isDedupRequired = args.deduplicateGeometry && listFilepath.size() > 1;
+    const bool isPostProcessDeferred = isPostProcessBatched || isDedupRequired;
     auto fnEntityPostProcessRequired = [&](const Format& format) {
-        if (args.entityPostProcess && args.entityPostProcessRequiredIf)
+        const bool hasPostProcess = args.entityPostProcess || args.entitiesPostProcess;
+        if (hasPostProcess && args.entityPostProcessRequiredIf)
             return args.entityPostProcessRequiredIf(format);
         else
             return false;
@@ -229,17 +797,49 @@ bool System::importInDocument(const Args_ImportInDocument& args)
         fnAddError(fp, errorMsg);
         return false;
     };
+    auto fnStreamCompression = [](std::istream& istr) {
+        const std::streampos pos = istr.tellg();
+        char header[4] = {};
+        istr.read(header, sizeof(header));
+        const auto readCount = istr.gcount();
+        istr.clear();
+        istr.seekg(pos);
+        return DecompressionUtils::probe(std::string_view(header, size_t(readCount)));
+    };
+    auto fnReadPortionSize = [&](const Format& format) {
+        int portionSize = 40;
+        if (!isPostProcessDeferred && fnEntityPostProcessRequired(format))
+            portionSize *= (100 - args.entityPostProcessProgressSize) / 100.;
+
+        return portionSize;
+    };
     auto fnReadFile = [&](TaskData& taskData) {
-        taskData.fileFormat = this->probeFormat(taskData.filepath);
+        if (!inputStream) {
+            taskData.reader = this->takePrefetchedReader(taskData.filepath, args.parametersProvider, &taskData.fileFormat);
+            if (taskData.reader) {
+                // File was already read, see prefetchFile()
+                TaskProgress progress(taskData.progress, fnReadPortionSize(taskData.fileFormat), tr("Reading file"));
+                progress.setValue(100);
+                if (perfStats)
+                    perfStats->addCounter("io.prefetchHits");
+
+                return true;
+            }
+        }
+
+        {
+            PerfScopedTimer timer(perfStats, "io.probe");
+            taskData.fileFormat =
+                    inputStream ?
+                        this->probeFormat(*inputStream, taskData.filepath) :
+                        this->probeFormat(taskData.filepath);
+        }
+
         if (taskData.fileFormat == Format_Unknown)
             return fnReadFileError(taskData.filepath, tr("Unknown format"));
 
-        int portionSize = 40;
-        if (fnEntityPostProcessRequired(taskData.fileFormat))
-            portionSize *= (100 - args.entityPostProcessProgressSize) / 100.;
-
-        TaskProgress progress(taskData.progress, portionSize, tr("Reading file"));
-        taskData.reader = this->createReader(taskData.fileFormat);
+        TaskProgress progress(taskData.progress, fnReadPortionSize(taskData.fileFormat), tr("Reading file"));
+        taskData.reader = this->takeReader(taskData.fileFormat);
         if (!taskData.reader)
             return fnReadFileError(taskData.filepath, tr("No supporting reader"));
 
@@ -248,24 +848,65 @@ bool System::importInDocument(const Args_ImportInDocument& args)
                         args.parametersProvider->findReaderParameters(taskData.fileFormat));
         }
 
-        if (!taskData.reader->readFile(taskData.filepath, &progress))
-            return fnReadFileError(taskData.filepath, tr("File read problem"));
+        PerfScopedTimer timer(perfStats, "io.read");
+        const CompressionFormat compression =
+                inputStream ? fnStreamCompression(*inputStream) : DecompressionUtils::probeFile(taskData.filepath);
+        if (compression != CompressionFormat::None && DecompressionUtils::isAvailable()) {
+            // Reader is fed while data is decompressed on a worker thread
+            std::unique_ptr<std::istream> fileStream;
+            if (!inputStream && m_isFileReadAheadEnabled)
+                fileStream = std::make_unique<ReadAheadInputStream>(taskData.filepath);
+            else if (!inputStream)
+                fileStream = std::make_unique<std::ifstream>(taskData.filepath, std::ios::in | std::ios::binary);
+
+            DecompressionInputStream istr(inputStream ? *inputStream : *fileStream, compression);
+            const FilePath innerFilepath = DecompressionUtils::innerFilepath(taskData.filepath);
+            const bool okRead = taskData.reader->readStream(istr, innerFilepath, &progress);
+            if (istr.buffer().hasError()) {
+                const QString errorMsg = QString::fromStdString(istr.buffer().errorMessage());
+                return fnReadFileError(taskData.filepath, tr("Decompression problem\n%1").arg(errorMsg));
+            }
+
+            if (!okRead)
+                return fnReadFileError(taskData.filepath, tr("File read problem"));
+        }
+        else if (!inputStream && m_isFileReadAheadEnabled && taskData.reader->readsStream()) {
+            // Reader is fed while next blocks of the file are read on a worker thread
+            ReadAheadInputStream istr(taskData.filepath);
+            const bool okRead = taskData.reader->readStream(istr, taskData.filepath, &progress);
+            if (istr.buffer().hasError()) {
+                const QString errorMsg = QString::fromStdString(istr.buffer().errorMessage());
+                return fnReadFileError(taskData.filepath, tr("File read problem\n%1").arg(errorMsg));
+            }
+
+            if (!okRead)
+                return fnReadFileError(taskData.filepath, tr("File read problem"));
+        }
+        else {
+            const bool okRead =
+                    inputStream ?
+                        taskData.reader->readStream(*inputStream, taskData.filepath, &progress) :
+                        taskData.reader->readFile(taskData.filepath, &progress);
+            if (!okRead)
+                return fnReadFileError(taskData.filepath, tr("File read problem"));
+        }
 
         return taskData.reader.get() != nullptr;
     };
     auto fnTransfer = [&](TaskData& taskData) {
         int portionSize = 60;
-        if (fnEntityPostProcessRequired(taskData.fileFormat))
+        if (!isPostProcessDeferred && fnEntityPostProcessRequired(taskData.fileFormat))
             portionSize *= (100 - args.entityPostProcessProgressSize) / 100.;
 
         TaskProgress progress(taskData.progress, portionSize, tr("Transferring file"));
         if (taskData.reader && !TaskProgress::isAbortRequested(&progress)) {
+            PerfScopedTimer timer(perfStats, "io.transfer");
             taskData.seqTransferredEntity = taskData.reader->transfer(doc, &progress);
             if (taskData.seqTransferredEntity.IsEmpty())
                 fnAddError(taskData.filepath, tr("File transfer problem"));
         }
 
-        taskData.transferred = true;
+        this->recycleReader(taskData.fileFormat, std::move(taskData.reader));
     };
     auto fnPostProcess = [&](TaskData& taskData) {
         if (!fnEntityPostProcessRequired(taskData.fileFormat))
@@ -275,6 +916,13 @@ bool System::importInDocument(const Args_ImportInDocument& args)
                     taskData.progress,
                     args.entityPostProcessProgressSize,
                     args.entityPostProcessProgressStep);
+        PerfScopedTimer timer(perfStats, "io.postProcess");
+        if (args.entitiesPostProcess) {
+            const ImportedFileEntities fileEntities = { taskData.filepath, taskData.seqTransferredEntity };
+            args.entitiesPostProcess(Span<const ImportedFileEntities>(&fileEntities, 1), &progress);
+            return;
+        }
+
         const double subPortionSize = 100. / double(taskData.seqTransferredEntity.Size());
         for (const TDF_Label& labelEntity : taskData.seqTransferredEntity) {
             TaskProgress subProgress(&progress, subPortionSize);
@@ -282,8 +930,20 @@ bool System::importInDocument(const Args_ImportInDocument& args)
         }
     };
     auto fnAddModelTreeEntities = [&](TaskData& taskData) {
-        for (const TDF_Label& labelEntity : taskData.seqTransferredEntity)
-            doc->addEntityTreeNode(labelEntity);
+        PerfScopedTimer timer(perfStats, "io.treeBuild");
+        if (perfStats)
+            perfStats->addCounter("io.entities", taskData.seqTransferredEntity.Size());
+
+        std::vector<TDF_Label> vecLabelEntity;
+        vecLabelEntity.reserve(taskData.seqTransferredEntity.Size());
+        for (const TDF_Label& labelEntity : taskData.seqTransferredEntity) {
+            if (!args.entityFilter || args.entityFilter(labelEntity))
+                vecLabelEntity.push_back(labelEntity);
+            else
+                TDF_Label(labelEntity).ForgetAllAttributes();
+        }
+
+        doc->addEntityTreeNodes(vecLabelEntity);
     };
 
     if (listFilepath.size() == 1) { // Single file case
@@ -298,43 +958,142 @@ bool System::importInDocument(const Args_ImportInDocument& args)
         }
     }
     else { // Many files case
+        // Pipeline: reader tasks run concurrently and push their completion in a queue consumed by
+        // the calling thread, which serializes the transfers to the target document.
+        // Once transferred, entities are post-processed back in the reader task, concurrently
+        // with the next transfers
         std::vector<TaskData> vecTaskData;
         vecTaskData.resize(listFilepath.size());
 
+        enum class StageDone { Read, PostProcess };
+        struct StageEvent {
+            TaskData* taskData;
+            StageDone stage;
+        };
+        CompletionQueue<StageEvent> queueStageDone;
+
         TaskManager childTaskManager;
-        QObject::connect(&childTaskManager, &TaskManager::progressChanged, [&](TaskId, int) {
-            rootProgress->setValue(childTaskManager.globalProgress());
+        const double readTransferPortion =
+                isPostProcessDeferred ? (100 - args.entityPostProcessProgressSize) / 100. : 1.;
+        auto connProgress = QObject::connect(
+                    &childTaskManager, &TaskManager::progressChanged, [&](TaskId, int) {
+            rootProgress->setValue(childTaskManager.globalProgress() * readTransferPortion);
         });
 
-        // Read files
+        // Read files and post-process transferred entities
         for (TaskData& taskData : vecTaskData) {
             taskData.filepath = listFilepath[&taskData - &vecTaskData.front()];
+            taskData.futureTransferred = taskData.promiseTransferred.get_future();
             taskData.taskId = childTaskManager.newTask([&](TaskProgress* progressChild) {
                 taskData.progress = progressChild;
                 taskData.readSuccess = fnReadFile(taskData);
+                queueStageDone.push({ &taskData, StageDone::Read });
+                if (!taskData.readSuccess || isPostProcessDeferred)
+                    return;
+
+                taskData.futureTransferred.wait();
+                if (!TaskProgress::isAbortRequested(progressChild))
+                    fnPostProcess(taskData);
+
+                queueStageDone.push({ &taskData, StageDone::PostProcess });
             });
         }
 
         for (const TaskData& taskData : vecTaskData)
             childTaskManager.run(taskData.taskId, TaskAutoDestroy::Off);
 
-        // Transfer to document
+        // Transfer to document as soon as a file is read, add entities once post-processed
+        auto fnReleaseTask = [](TaskData& taskData) {
+            if (!taskData.transferred) {
+                taskData.transferred = true;
+                taskData.promiseTransferred.set_value();
+            }
+        };
         int taskDataCount = vecTaskData.size();
         while (taskDataCount > 0 && !rootProgress->isAbortRequested()) {
-            auto it = std::find_if(vecTaskData.begin(), vecTaskData.end(), [&](const TaskData& taskData) {
-                return !taskData.transferred && childTaskManager.waitForDone(taskData.taskId, 25);
-            });
+            StageEvent event = {};
+            // Timeout is only there to get a chance to check abort requests
+            if (!queueStageDone.waitPop(&event, std::chrono::milliseconds(100)))
+                continue;
 
-            if (it != vecTaskData.end()) {
-                if (it->readSuccess) {
-                    fnTransfer(*it);
-                    fnPostProcess(*it);
-                    fnAddModelTreeEntities(*it);
-                }
+            TaskData& taskData = *event.taskData;
+            if (event.stage == StageDone::Read) {
+                if (taskData.readSuccess)
+                    fnTransfer(taskData);
+
+                if (!taskData.readSuccess || isPostProcessDeferred)
+                    --taskDataCount;
 
+                fnReleaseTask(taskData);
+            }
+            else if (event.stage == StageDone::PostProcess) {
+                fnAddModelTreeEntities(taskData);
                 --taskDataCount;
             }
         } // endwhile
+
+        // Abort case: unblock reader tasks still waiting for transfer
+        if (rootProgress->isAbortRequested()) {
+            for (TaskData& taskData : vecTaskData) {
+                childTaskManager.requestAbort(taskData.taskId);
+                fnReleaseTask(taskData);
+            }
+        }
+
+        // Merge identical products, post-process entities of all files in a single batch, then
+        // add them to the model tree
+        if (isPostProcessDeferred && !rootProgress->isAbortRequested()) {
+            for (const TaskData& taskData : vecTaskData)
+                childTaskManager.waitForDone(taskData.taskId);
+
+            QObject::disconnect(connProgress);
+            if (isDedupRequired) {
+                std::vector<TDF_LabelSequence> vecSeqEntity;
+                for (const TaskData& taskData : vecTaskData)
+                    vecSeqEntity.push_back(taskData.seqTransferredEntity);
+
+                PerfScopedTimer timer(perfStats, "io.dedup");
+                const int mergedCount = GeometryDedup::mergeProducts(
+                            doc, vecSeqEntity, args.deduplicateGeometryTolerance);
+                if (perfStats)
+                    perfStats->addCounter("io.dedupProducts", mergedCount);
+            }
+
+            std::vector<ImportedFileEntities> vecFileEntities;
+            for (const TaskData& taskData : vecTaskData) {
+                const bool isRequired = fnEntityPostProcessRequired(taskData.fileFormat);
+                if (isRequired && !taskData.seqTransferredEntity.IsEmpty())
+                    vecFileEntities.push_back({ taskData.filepath, taskData.seqTransferredEntity });
+            }
+
+            if (args.entitiesPostProcess || args.entityPostProcess) {
+                TaskProgress progress(
+                            rootProgress,
+                            args.entityPostProcessProgressSize,
+                            args.entityPostProcessProgressStep);
+                PerfScopedTimer timer(perfStats, "io.postProcess");
+                if (args.entitiesPostProcess) {
+                    args.entitiesPostProcess(vecFileEntities, &progress);
+                }
+                else {
+                    // Entities are post-processed one after another, as products may be shared
+                    int entityCount = 0;
+                    for (const ImportedFileEntities& fileEntities : vecFileEntities)
+                        entityCount += fileEntities.seqEntity.Size();
+
+                    const double subPortionSize = 100. / double(entityCount);
+                    for (const ImportedFileEntities& fileEntities : vecFileEntities) {
+                        for (const TDF_Label& labelEntity : fileEntities.seqEntity) {
+                            TaskProgress subProgress(&progress, subPortionSize);
+                            args.entityPostProcess(labelEntity, &subProgress);
+                        }
+                    }
+                }
+            }
+
+            for (TaskData& taskData : vecTaskData)
+                fnAddModelTreeEntities(taskData);
+        }
     }
 
     return ok;
@@ -354,13 +1113,27 @@ bool System::exportApplicationItems(const Args_ExportApplicationItems& args)
         return false;
     };
 
-    std::unique_ptr<Writer> writer = this->createWriter(args.targetFormat);
+    PerfStats* perfStats = PerfStats::of(args.progress);
+    std::unique_ptr<Writer> writer = this->takeWriter(args.targetFormat);
     if (!writer)
         return fnError(tr("No supporting writer"));
 
     writer->applyProperties(args.parameters);
+    {
+        // Triangulations compacted while hidden are read by the writers, they're restored first
+        std::unordered_set<const Document*> setDoc;
+        for (const ApplicationItem& item : args.applicationItems) {
+            const DocumentPtr doc = item.document();
+            if (doc && setDoc.insert(doc.get()).second) {
+                std::lock_guard<std::mutex> lock(doc->dataMutex()); MAYO_UNUSED(lock);
+                doc->compactTriangulations().expandAll();
+            }
+        }
+    }
+
     {
         TaskProgress transferProgress(progress, 40, tr("Transfer"));
+        PerfScopedTimer timer(perfStats, "io.writerTransfer");
         const bool okTransfer = writer->transfer(args.applicationItems, &transferProgress);
         if (!okTransfer)
             return fnError(tr("File transfer problem"));
@@ -368,11 +1141,16 @@ bool System::exportApplicationItems(const Args_ExportApplicationItems& args)
 
     {
         TaskProgress writeProgress(progress, 60, tr("Write"));
-        const bool okWriteFile = writer->writeFile(args.targetFilepath, &writeProgress);
+        PerfScopedTimer timer(perfStats, "io.write");
+        const bool okWriteFile =
+                args.targetStream ?
+                    writer->writeStream(*args.targetStream, &writeProgress) :
+                    writer->writeFile(args.targetFilepath, &writeProgress);
         if (!okWriteFile)
             return fnError(tr("File write problem"));
     }
 
+    this->recycleWriter(args.targetFormat, std::move(writer));
     return true;
 }
 
@@ -382,6 +1160,12 @@ System::Operation_ExportApplicationItems::targetFile(const FilePath& filepath) {
     return *this;
 }
 
+System::Operation_ExportApplicationItems&
+System::Operation_ExportApplicationItems::targetStream(std::ostream* ostr) {
+    m_args.targetStream = ostr;
+    return *this;
+}
+
 System::Operation_ExportApplicationItems&
 System::Operation_ExportApplicationItems::targetFormat(const Format& format) {
     m_args.targetFormat = format;
@@ -394,6 +1178,13 @@ System::Operation_ExportApplicationItems::withItems(Span<const ApplicationItem>
     return *this;
 }
 
+System::Operation_ExportApplicationItems&
+System::Operation_ExportApplicationItems::withItems(const ApplicationItemsSnapshot& snapshot) {
+    m_itemsSnapshot = snapshot;
+    m_args.applicationItems = m_itemsSnapshot.items();
+    return *this;
+}
+
 System::Operation_ExportApplicationItems&
 System::Operation_ExportApplicationItems::withParameters(const PropertyGroup* parameters) {
     m_args.parameters = parameters;
@@ -416,6 +1207,21 @@ bool System::Operation_ExportApplicationItems::execute() {
     return m_system.exportApplicationItems(m_args);
 }
 
+TaskFuture<bool> System::Operation_ExportApplicationItems::executeAsync(TaskManager* taskMgr, TaskPriority priority)
+{
+    System* system = &m_system;
+    Args_ExportApplicationItems args = m_args;
+    const ApplicationItemsSnapshot itemsSnapshot =
+            m_itemsSnapshot.empty() ? ApplicationItemsSnapshot(m_args.applicationItems) : m_itemsSnapshot;
+    const TaskFuture<bool> future = taskMgr->newTaskFuture([=](TaskProgress* progress) mutable {
+        args.applicationItems = itemsSnapshot.items();
+        args.progress = progress;
+        return system->exportApplicationItems(args);
+    }, {}, priority);
+    taskMgr->run(future.taskId());
+    return future;
+}
+
 System::Operation_ExportApplicationItems::Operation_ExportApplicationItems(System& system)
     : m_system(system)
 {
@@ -469,6 +1275,13 @@ System::Operation_ImportInDocument::withEntityPostProcess(std::function<void (TD
     return *this;
 }
 
+System::Operation_ImportInDocument::Operation&
+System::Operation_ImportInDocument::withEntitiesPostProcess(std::function<void(Span<const ImportedFileEntities>, TaskProgress*)> fn)
+{
+    m_args.entitiesPostProcess = std::move(fn);
+    return *this;
+}
+
 System::Operation_ImportInDocument::Operation&
 System::Operation_ImportInDocument::withEntityPostProcessRequiredIf(std::function<bool(const Format&)> fn)
 {
@@ -484,10 +1297,46 @@ System::Operation_ImportInDocument::withEntityPostProcessInfoProgress(int progre
     return *this;
 }
 
+System::Operation_ImportInDocument::Operation&
+System::Operation_ImportInDocument::withEntityFilter(std::function<bool(const TDF_Label&)> fn)
+{
+    m_args.entityFilter = std::move(fn);
+    return *this;
+}
+
+System::Operation_ImportInDocument::Operation&
+System::Operation_ImportInDocument::withGeometryDeduplication(bool on)
+{
+    m_args.deduplicateGeometry = on;
+    return *this;
+}
+
+System::Operation_ImportInDocument::Operation&
+System::Operation_ImportInDocument::withInputStream(std::istream* istr, const FilePath& name)
+{
+    m_args.inputStream = istr;
+    m_args.inputStreamName = name;
+    return *this;
+}
+
 bool System::Operation_ImportInDocument::execute() {
     return m_system.importInDocument(m_args);
 }
 
+TaskFuture<bool> System::Operation_ImportInDocument::executeAsync(TaskManager* taskMgr, TaskPriority priority)
+{
+    System* system = &m_system;
+    Args_ImportInDocument args = m_args;
+    const std::vector<FilePath> vecFilepath(m_args.filepaths.begin(), m_args.filepaths.end());
+    const TaskFuture<bool> future = taskMgr->newTaskFuture([=](TaskProgress* progress) mutable {
+        args.filepaths = vecFilepath;
+        args.progress = progress;
+        return system->importInDocument(args);
+    }, {}, priority);
+    taskMgr->run(future.taskId());
+    return future;
+}
+
 System::Operation_ImportInDocument::Operation_ImportInDocument(System& system)
     : m_system(system)
 {
@@ -507,6 +1356,33 @@ auto findFirstNonSpace(const QByteArray& str) {
     return std::find_if_not(str.cbegin(), str.cend(), isSpace);
 }
 
+// Matches line [itBegin, itEnd) against regex ^\s*(v|vt|vn|vp|surf)\s+[-\+]?[0-9\.]+\s
+// 'isLineComplete' indicates the line is followed by a newline character(ie matches final \s)
+bool matchObjVertexStatement(
+        QByteArray::const_iterator itBegin, QByteArray::const_iterator itEnd, bool isLineComplete)
+{
+    auto itChar = std::find_if_not(itBegin, itEnd, isSpace);
+    const auto itKeywordEnd = std::find_if(itChar, itEnd, isSpace);
+    const std::string_view keyword(itChar, itKeywordEnd - itChar);
+    if (keyword != "v" && keyword != "vt" && keyword != "vn" && keyword != "vp" && keyword != "surf")
+        return false;
+
+    itChar = std::find_if_not(itKeywordEnd, itEnd, isSpace);
+    if (itChar == itKeywordEnd)
+        return false; // No space after keyword
+
+    if (itChar != itEnd && (*itChar == '-' || *itChar == '+'))
+        ++itChar;
+
+    const auto itNumberEnd = std::find_if_not(itChar, itEnd, [](char c) {
+        return (c >= '0' && c <= '9') || c == '.';
+    });
+    if (itNumberEnd == itChar)
+        return false; // No number
+
+    return itNumberEnd != itEnd ? isSpace(*itNumberEnd) : isLineComplete;
+}
+
 } // namespace
 
 Format probeFormat_STEP(const System::FormatProbeInput& input)
@@ -552,11 +1428,16 @@ Format probeFormat_IGES(const System::FormatProbeInput& input)
 
 Format probeFormat_OCCBREP(const System::FormatProbeInput& input)
 {
-    // regex : ^\s*DBRep_DrawableShape
+    // regex : ^\s*(DBRep_DrawableShape|CASCADE Topology V|Open CASCADE Topology V)
+    // Note: binary BRep files(BinTools) start with "Open CASCADE Topology V[1-3]"
     auto itContentsBegin = findFirstNonSpace(input.contentsBegin);
-    constexpr std::string_view occBRepToken = "DBRep_DrawableShape";
-    if (matchToken(itContentsBegin, occBRepToken))
-        return Format_OCCBREP;
+    constexpr std::string_view occBRepTokens[] = {
+        "DBRep_DrawableShape", "CASCADE Topology V", "Open CASCADE Topology V"
+    };
+    for (std::string_view occBRepToken : occBRepTokens) {
+        if (matchToken(itContentsBegin, occBRepToken))
+            return Format_OCCBREP;
+    }
 
     return Format_Unknown;
 }
@@ -595,14 +1476,370 @@ Format probeFormat_STL(const System::FormatProbeInput& input)
 
 Format probeFormat_OBJ(const System::FormatProbeInput& input)
 {
+    // Scan all lines for a vertex statement
+    // regex : ^\s*(v|vt|vn|vp|surf)\s+[-\+]?[0-9\.]+\s
+    const QByteArray& sample = input.contentsBegin;
+    const auto itSampleEnd = std::find(sample.cbegin(), sample.cend(), '\0'); // Skip zero-padding
+    auto itLine = sample.cbegin();
+    while (itLine != itSampleEnd) {
+        const auto itLineEnd = std::find(itLine, itSampleEnd, '\n');
+        const bool isLineComplete = itLineEnd != itSampleEnd;
+        if (matchObjVertexStatement(itLine, itLineEnd, isLineComplete))
+            return Format_OBJ;
+
+        itLine = isLineComplete ? itLineEnd + 1 : itLineEnd;
+    }
+
+    return Format_Unknown;
+}
+
+Format probeFormat_PLY(const System::FormatProbeInput& input)
+{
+    // regex : ^ply\r?\n
     const QByteArray& sample = input.contentsBegin;
-    const std::regex rx{ R"("^\s*(v|vt|vn|vp|surf)\s+[-\+]?[0-9\.]+\s")" };
-    if (std::regex_search(sample.cbegin(), sample.cend(), rx))
-        return Format_OBJ;
+    if (sample.startsWith("ply\n") || sample.startsWith("ply\r\n"))
+        return Format_PLY;
+
+    return Format_Unknown;
+}
+
+Format probeFormat_LAS(const System::FormatProbeInput& input)
+{
+    // File signature of the public header block
+    if (input.contentsBegin.startsWith("LASF"))
+        return Format_LAS;
 
     return Format_Unknown;
 }
 
+namespace {
+
+// Minimal reader of ISO 10303-21 syntax working on a stream buffer, characters are consumed one
+// by one so the data is never entirely loaded in memory
+class StepStreamReader {
+public:
+    StepStreamReader(std::istream& istr) : m_buffer(istr.rdbuf()) {}
+
+    // Skips white spaces and comments, returns the next character(not consumed) or EOF
+    int peekToken() {
+        for (;;) {
+            const int c = m_buffer->sgetc();
+            if (c == std::char_traits<char>::eof())
+                return c;
+
+            if (c == '/') {
+                m_buffer->sbumpc();
+                if (m_buffer->sgetc() != '*') {
+                    m_buffer->sungetc();
+                    return c;
+                }
+
+                this->skipComment();
+            }
+            else if (isSpace(char(c))) {
+                m_buffer->sbumpc();
+            }
+            else {
+                return c;
+            }
+        }
+    }
+
+    // Reads characters up to the end of the current statement(ie ';' outside strings and comments)
+    // Characters are appended to 'text' if not null, up to 'maxSize'. Returns false on EOF
+    bool readStatement(std::string* text, size_t maxSize = 64 * 1024) {
+        constexpr int eof = std::char_traits<char>::eof();
+        auto fnAppend = [=](int c) {
+            if (text && text->size() < maxSize)
+                text->push_back(char(c));
+        };
+        for (int c = m_buffer->sbumpc(); c != eof; c = m_buffer->sbumpc()) {
+            if (c == ';') {
+                return true;
+            }
+            else if (c == '\'') {
+                // String, quote is escaped by doubling it
+                fnAppend(c);
+                for (c = m_buffer->sbumpc(); c != eof; c = m_buffer->sbumpc()) {
+                    fnAppend(c);
+                    if (c == '\'') {
+                        if (m_buffer->sgetc() != '\'')
+                            break;
+
+                        fnAppend(m_buffer->sbumpc());
+                    }
+                }
+            }
+            else if (c == '/' && m_buffer->sgetc() == '*') {
+                m_buffer->sbumpc();
+                this->skipComment();
+            }
+            else {
+                fnAppend(c);
+            }
+        }
+
+        return false;
+    }
+
+    // Reads characters while 'fnPredicate' is true, appends them to 'text' up to 'maxSize'
+    template<typename PREDICATE>
+    void readWhile(std::string* text, PREDICATE fnPredicate, size_t maxSize = 256) {
+        for (int c = m_buffer->sgetc(); c != std::char_traits<char>::eof(); c = m_buffer->sgetc()) {
+            if (!fnPredicate(char(c)))
+                break;
+
+            if (text->size() < maxSize)
+                text->push_back(char(c));
+
+            m_buffer->sbumpc();
+        }
+    }
+
+private:
+    void skipComment() {
+        // Assume "/*" is consumed
+        int cPrev = 0;
+        for (int c = m_buffer->sbumpc(); c != std::char_traits<char>::eof(); c = m_buffer->sbumpc()) {
+            if (cPrev == '*' && c == '/')
+                return;
+
+            cPrev = c;
+        }
+    }
+
+    std::streambuf* m_buffer = nullptr;
+};
+
+std::string_view trimmed(std::string_view str)
+{
+    while (!str.empty() && isSpace(str.front()))
+        str.remove_prefix(1);
+
+    while (!str.empty() && isSpace(str.back()))
+        str.remove_suffix(1);
+
+    return str;
+}
+
+// Keyword of entity 'text', ie the identifier before the list of parameters
+std::string_view stepKeyword(std::string_view text)
+{
+    return trimmed(text.substr(0, text.find('(')));
+}
+
+// Decodes a STEP string literal(quotes excluded), handling control directives \S\, \X\, \X2\
+// and \X4\. Other characters are taken as UTF-8, which is what most exporters actually write
+QString decodeStepString(std::string_view str)
+{
+    QString result;
+    std::string strPlain;
+    auto fnFlushPlain = [&]{
+        result += QString::fromStdString(strPlain);
+        strPlain.clear();
+    };
+    auto fnHexValue = [](std::string_view hex) {
+        uint32_t value = 0;
+        for (char c : hex) {
+            value <<= 4;
+            if (c >= '0' && c <= '9')
+                value |= c - '0';
+            else if (c >= 'A' && c <= 'F')
+                value |= c - 'A' + 10;
+            else if (c >= 'a' && c <= 'f')
+                value |= c - 'a' + 10;
+        }
+
+        return value;
+    };
+
+    size_t pos = 0;
+    while (pos < str.size()) {
+        const char c = str.at(pos);
+        if (c == '\'' && pos + 1 < str.size() && str.at(pos + 1) == '\'') {
+            strPlain += '\'';
+            pos += 2;
+        }
+        else if (c == '\\' && str.substr(pos, 2) == "\\\\") {
+            strPlain += '\\';
+            pos += 2;
+        }
+        else if (c == '\\' && str.substr(pos, 3) == "\\S\\" && pos + 3 < str.size()) {
+            fnFlushPlain();
+            result += QChar(uchar(str.at(pos + 3)) + 128);
+            pos += 4;
+        }
+        else if (c == '\\' && str.substr(pos, 3) == "\\X\\" && pos + 5 <= str.size()) {
+            fnFlushPlain();
+            result += QChar(fnHexValue(str.substr(pos + 3, 2)));
+            pos += 5;
+        }
+        else if (c == '\\' && (str.substr(pos, 4) == "\\X2\\" || str.substr(pos, 4) == "\\X4\\")) {
+            fnFlushPlain();
+            const size_t digitCount = str.at(pos + 2) == '2' ? 4 : 8;
+            const size_t posEnd = str.find("\\X0\\", pos + 4);
+            const std::string_view hex = str.substr(pos + 4, posEnd - (pos + 4));
+            for (size_t i = 0; i + digitCount <= hex.size(); i += digitCount) {
+                const char32_t codePoint = fnHexValue(hex.substr(i, digitCount));
+                result += QString::fromUcs4(&codePoint, 1);
+            }
+
+            pos = posEnd != std::string_view::npos ? posEnd + 4 : str.size();
+        }
+        else if (c == '\\' && str.substr(pos, 2) == "\\P" && pos + 3 < str.size()) {
+            pos += 4; // Code page switch(\PA\ to \PI\), ignored
+        }
+        else {
+            strPlain += c;
+            ++pos;
+        }
+    }
+
+    fnFlushPlain();
+    return result;
+}
+
+// Decoded strings of each parameter of entity 'text'. Strings nested in lists are collected with
+// their top-level parameter, eg "('a',('b','c'),#3)" gives { {"a"}, {"b", "c"}, {} }
+std::vector<QStringList> stepParameterStrings(std::string_view text)
+{
+    std::vector<QStringList> vecParam;
+    size_t pos = text.find('(');
+    if (pos == std::string_view::npos)
+        return vecParam;
+
+    int depth = 0;
+    while (pos < text.size()) {
+        const char c = text.at(pos);
+        if (c == '(') {
+            if (++depth == 1)
+                vecParam.emplace_back();
+        }
+        else if (c == ')') {
+            if (--depth == 0)
+                break;
+        }
+        else if (c == ',' && depth == 1) {
+            vecParam.emplace_back();
+        }
+        else if (c == '\'') {
+            size_t posEnd = pos + 1;
+            while (posEnd < text.size()) {
+                if (text.at(posEnd) == '\'') {
+                    if (posEnd + 1 < text.size() && text.at(posEnd + 1) == '\'')
+                        ++posEnd; // Escaped quote
+                    else
+                        break;
+                }
+
+                ++posEnd;
+            }
+
+            vecParam.back().push_back(decodeStepString(text.substr(pos + 1, posEnd - pos - 1)));
+            pos = posEnd;
+        }
+
+        ++pos;
+    }
+
+    return vecParam;
+}
+
+QString joinNonEmpty(const QStringList& list, const QString& separator)
+{
+    QStringList listNonEmpty;
+    for (const QString& str : list) {
+        if (!str.trimmed().isEmpty())
+            listNonEmpty.push_back(str);
+    }
+
+    return listNonEmpty.join(separator);
+}
+
+} // namespace
+
+bool scanMetadata_STEP(std::istream& istr, System::FileMetadata* metadata)
+{
+    StepStreamReader reader(istr);
+    std::string text;
+    auto fnReadKeywordStatement = [&]{
+        text.clear();
+        reader.peekToken();
+        return reader.readStatement(&text);
+    };
+
+    if (!fnReadKeywordStatement() || trimmed(text) != "ISO-10303-21")
+        return false;
+
+    if (!fnReadKeywordStatement() || trimmed(text) != "HEADER")
+        return false;
+
+    // HEADER section
+    auto fnParamString = [](const std::vector<QStringList>& vecParam, size_t index) {
+        return index < vecParam.size() ? joinNonEmpty(vecParam.at(index), ", ") : QString();
+    };
+    while (fnReadKeywordStatement() && trimmed(text) != "ENDSEC") {
+        const std::string_view keyword = stepKeyword(text);
+        const std::vector<QStringList> vecParam = stepParameterStrings(text);
+        if (keyword == "FILE_DESCRIPTION") {
+            metadata->description = !vecParam.empty() ? joinNonEmpty(vecParam.front(), "\n") : QString();
+        }
+        else if (keyword == "FILE_NAME") {
+            metadata->name = fnParamString(vecParam, 0);
+            metadata->timestamp = fnParamString(vecParam, 1);
+            metadata->author = fnParamString(vecParam, 2);
+            metadata->organization = fnParamString(vecParam, 3);
+            metadata->preprocessorVersion = fnParamString(vecParam, 4);
+            metadata->authoringSystem = fnParamString(vecParam, 5);
+        }
+        else if (keyword == "FILE_SCHEMA") {
+            metadata->schemas = !vecParam.empty() ? vecParam.front() : QStringList();
+        }
+    }
+
+    // DATA section(s): only PRODUCT entities are parsed, others are skipped up to ';'
+    int64_t entityCount = 0;
+    constexpr int eof = std::char_traits<char>::eof();
+    for (int c = reader.peekToken(); c != eof; c = reader.peekToken()) {
+        text.clear();
+        if (c == '#') {
+            ++entityCount;
+            // Instance name and entity keyword, eg "#12=PRODUCT"
+            reader.readWhile(&text, [](char ch) { return ch != '(' && ch != ';' && ch != '\''; });
+            const size_t posEqual = text.find('=');
+            const std::string_view keyword =
+                    posEqual != std::string::npos ?
+                        trimmed(std::string_view(text).substr(posEqual + 1)) :
+                        std::string_view();
+            if (keyword == "PRODUCT") {
+                text.clear();
+                if (!reader.readStatement(&text))
+                    break;
+
+                // PRODUCT(id, name, description, frame_of_reference)
+                const std::vector<QStringList> vecParam = stepParameterStrings(text);
+                QString name = fnParamString(vecParam, 1);
+                if (name.isEmpty())
+                    name = fnParamString(vecParam, 0);
+
+                if (!name.isEmpty())
+                    metadata->productNames.push_back(name);
+            }
+            else if (!reader.readStatement(nullptr)) {
+                break;
+            }
+        }
+        else {
+            // Section keywords, eg "DATA", "ENDSEC", "END-ISO-10303-21"
+            if (!reader.readStatement(&text) || trimmed(text) == "END-ISO-10303-21")
+                break;
+        }
+    }
+
+    metadata->entityCount = entityCount;
+    return true;
+}
+
 void addPredefinedFormatProbes(System* system)
 {
     if (!system)
@@ -612,8 +1849,18 @@ void addPredefinedFormatProbes(System* system)
     system->addFormatProbe(probeFormat_IGES);
     system->addFormatProbe(probeFormat_OCCBREP);
     system->addFormatProbe(probeFormat_STL);
+    system->addFormatProbe(probeFormat_PLY); // Strict magic, checked before lenient OBJ scan
+    system->addFormatProbe(probeFormat_LAS);
     system->addFormatProbe(probeFormat_OBJ);
 }
 
+void addPredefinedMetadataScanners(System* system)
+{
+    if (!system)
+        return;
+
+    system->addMetadataScanner(Format_STEP, scanMetadata_STEP);
+}
+
 } // namespace IO
 } // namespace Mayo
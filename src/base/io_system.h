@@ -13,14 +13,28 @@
 #include "io_writer.h"
 #include "property.h"
 #include "span.h"
+#include "task_future.h"
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QStringList>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <future>
+#include <iosfwd>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace Mayo {
 
+enum class CompressionFormat;
 class Messenger;
+class TaskManager;
 class TaskProgress;
 
 namespace IO {
@@ -32,16 +46,53 @@ class ParametersProvider;
 class System {
     Q_DECLARE_TR_FUNCTIONS(Mayo::IO::System)
 public:
-    ~System() = default;
+    ~System();
 
     struct FormatProbeInput {
         FilePath filepath;
-        QByteArray contentsBegin; // Excerpt of the file(from start)
+        QByteArray contentsBegin; // Excerpt of the file(from start), zero-padded to ProbeExcerptSize
+        QByteArray contentsWindow; // Larger excerpt(from start), memory-mapped when possible
         uint64_t hintFullSize; // Full file size in bytes
     };
+    static constexpr uint64_t ProbeExcerptSize = 2048;
+    static constexpr uint64_t ProbeWindowSize = 1024 * 1024;
     using FormatProbe = std::function<Format (const FormatProbeInput&)>;
     void addFormatProbe(const FormatProbe& probe);
+    // Probed formats are cached, key is file path + last modification time. So a file is probed
+    // only once unless it's modified
+    // Files compressed with gzip or zip are probed on their first decompressed block, the format
+    // returned is the one of the compressed file
+    // Thread-safe: can be called concurrently(eg from import tasks)
     Format probeFormat(const FilePath& filepath) const;
+    // Probes the data of 'istr' from its current position, which is restored afterwards. So the
+    // stream must be seekable. 'nameHint' is used to guess the format from its suffix
+    Format probeFormat(std::istream& istr, const FilePath& nameHint = {}) const;
+    void clearFormatProbeCache();
+
+    // Descriptive data of a file found by a quick scan of its contents, without importing it(eg
+    // STEP header and products). Texts are decoded and meant to be displayed, empty if unknown
+    struct FileMetadata {
+        Format format = Format_Unknown;
+        QString name;
+        QString description;
+        QString timestamp;
+        QString author;
+        QString organization;
+        QString authoringSystem;
+        QString preprocessorVersion;
+        QStringList schemas;
+        QStringList productNames;
+        int64_t entityCount = -1; // Negative if unknown
+    };
+    // Scans 'istr' from its current position, returns false if data isn't of the expected format
+    using MetadataScanner = std::function<bool (std::istream& istr, FileMetadata* metadata)>;
+    void addMetadataScanner(const Format& format, const MetadataScanner& scanner);
+    // Finds the format of 'filepath'(see probeFormat()) then scans the file with the matching
+    // scanner, compressed files are scanned on the fly. Empty if no scanner or the scan failed
+    // Results are cached, key is file path + last modification time
+    // Thread-safe: can be called concurrently(eg from file browsing tasks)
+    std::optional<FileMetadata> scanMetadata(const FilePath& filepath) const;
+    void clearMetadataCache();
 
     void addFactoryReader(std::unique_ptr<FactoryReader> ptr);
     void addFactoryWriter(std::unique_ptr<FactoryWriter> ptr);
@@ -52,20 +103,88 @@ public:
     std::unique_ptr<Reader> createReader(const Format& format) const;
     std::unique_ptr<Writer> createWriter(const Format& format) const;
 
+    // Pools of reusable readers/writers, one per format
+    // take*() returns a pooled instance if any, otherwise a new one is created
+    // recycle*() resets the session of the instance(see Reader::resetSession()) and puts it back
+    // in the pool, it's just deleted if it isn't reusable or the pool is full
+    // Thread-safe: can be called concurrently(eg from import/export tasks)
+    std::unique_ptr<Reader> takeReader(const Format& format) const;
+    std::unique_ptr<Writer> takeWriter(const Format& format) const;
+    void recycleReader(const Format& format, std::unique_ptr<Reader> reader) const;
+    void recycleWriter(const Format& format, std::unique_ptr<Writer> writer) const;
+
+    // Creates on a worker thread the readers/writers of 'formats' and puts them in the pools, so
+    // the underlying translators(eg OpenCascade STEP/IGES controllers and their static variables)
+    // are initialized before the first import/export
+    // Should be called once all factories are added
+    void warmUpAsync(Span<const Format> formats);
+
+    // Speculative read of file 'filepath'(format probe then Reader::readFile()), so a later
+    // importInDocument() of the same unmodified file only pays for the transfer
+    // The read reader is kept "warm" for prefetchKeepAliveTime(), it's used by the import only if
+    // 'parametersProvider' is also the one of the import. Import of a file being prefetched waits
+    // for the prefetch to finish. Compressed files aren't prefetched
+    // Returns true if a warm reader is available for 'filepath' once done
+    // Thread-safe: meant to be called from a low-priority task, abortable with 'progress'
+    bool prefetchFile(
+            const FilePath& filepath,
+            const ParametersProvider* parametersProvider,
+            TaskProgress* progress = nullptr);
+    // Warm readers hold all the data of their file, so only a few are kept(the least recently
+    // prefetched are discarded first)
+    int prefetchCapacity() const { return m_prefetchCapacity; }
+    void setPrefetchCapacity(int count) { m_prefetchCapacity = count; }
+    // Default is 30s
+    std::chrono::milliseconds prefetchKeepAliveTime() const { return m_prefetchKeepAliveTime; }
+    void setPrefetchKeepAliveTime(std::chrono::milliseconds duration) { m_prefetchKeepAliveTime = duration; }
+    // Expired warm readers are discarded on each call to prefetchFile(), this function allows to
+    // release them regularly(eg with a timer)
+    void purgeExpiredPrefetches();
+    void clearPrefetches();
+
+    // Input files of importInDocument() are read through ReadAheadInputStream, so I/O overlaps with
+    // parsing. Applies to the readers parsing streams(see Reader::readsStream()) and to compressed
+    // files. Meant for slow storage(eg network shares), readers may otherwise map local files in
+    // memory. Default is false
+    bool isFileReadAheadEnabled() const { return m_isFileReadAheadEnabled; }
+    void setFileReadAheadEnabled(bool on) { m_isFileReadAheadEnabled = on; }
+
     Span<const Format> readerFormats() const { return m_vecReaderFormat; }
     Span<const Format> writerFormats() const { return m_vecWriterFormat; }
     static QString fileFilter(const Format& format);
 
     // Import service
 
+    // Entities transferred into target document from a file
+    struct ImportedFileEntities {
+        FilePath filepath;
+        TDF_LabelSequence seqEntity;
+    };
+
     struct Args_ImportInDocument {
         DocumentPtr targetDocument;
         Span<const FilePath> filepaths; // The files to be imported in target document
         const ParametersProvider* parametersProvider = nullptr;
         std::function<void(TDF_Label, TaskProgress*)> entityPostProcess;
+        // Alternative to 'entityPostProcess': called once with all the transferred entities(of
+        // all files), so the work can be shared and balanced between entities(eg meshing)
+        std::function<void(Span<const ImportedFileEntities>, TaskProgress*)> entitiesPostProcess;
         std::function<bool(const Format&)> entityPostProcessRequiredIf;
         int entityPostProcessProgressSize = 0;
         QString entityPostProcessProgressStep;
+        // Called after post-processing for each transferred entity, the ones for which it returns
+        // false are removed from the document instead of being added to the model tree(eg entities
+        // identical to some already in the document)
+        std::function<bool(const TDF_Label&)> entityFilter;
+        // Identical products of the files are merged once all files are transferred, see
+        // GeometryDedup::mergeProducts(). Post-processing is then deferred after deduplication
+        bool deduplicateGeometry = false;
+        double deduplicateGeometryTolerance = 1e-4;
+        // Data read from a stream(eg standard input) instead of 'filepaths', see
+        // Reader::readStream(). Data of non-seekable streams(eg pipes) is first gathered in memory
+        // so the format can be probed
+        std::istream* inputStream = nullptr;
+        FilePath inputStreamName; // Naming of entities, hint to probe the format
         Messenger* messenger = nullptr;
         TaskProgress* progress = nullptr;
     };
@@ -76,6 +195,7 @@ public:
     struct Args_ExportApplicationItems {
         Span<const ApplicationItem> applicationItems;
         FilePath targetFilepath;
+        std::ostream* targetStream = nullptr; // Written instead of 'targetFilepath' if not null
         Format targetFormat = Format_Unknown;
         const PropertyGroup* parameters = nullptr;
         Messenger* messenger = nullptr;
@@ -94,12 +214,22 @@ public:
 
         // Post-processing executed before adding entities into Document
         Operation& withEntityPostProcess(std::function<void(TDF_Label, TaskProgress*)> fn);
+        Operation& withEntitiesPostProcess(std::function<void(Span<const ImportedFileEntities>, TaskProgress*)> fn);
         Operation& withEntityPostProcessRequiredIf(std::function<bool(const Format&)> fn);
         Operation& withEntityPostProcessInfoProgress(int progressSize, const QString& progressStep);
+        Operation& withEntityFilter(std::function<bool(const TDF_Label&)> fn);
+
+        Operation& withGeometryDeduplication(bool on);
+        Operation& withInputStream(std::istream* istr, const FilePath& name = {});
 
         Operation& withMessenger(Messenger* messenger);
         Operation& withTaskProgress(TaskProgress* progress);
         bool execute();
+        // Executes the operation in a task created and run by 'taskMgr', whose result is the one
+        // of execute(). Option withTaskProgress() is ignored, progress is the one of the task
+        // File paths are copied, other options(eg messenger, input stream) must stay valid until
+        // the task is ended. Use TaskManager::onReady() to resume in the GUI thread
+        TaskFuture<bool> executeAsync(TaskManager* taskMgr, TaskPriority priority = TaskPriority::Normal);
 
     private:
         friend class System;
@@ -114,28 +244,91 @@ public:
     struct Operation_ExportApplicationItems {
         using Operation = Operation_ExportApplicationItems;
         Operation& targetFile(const FilePath& filepath);
+        Operation& targetStream(std::ostream* ostr);
         Operation& targetFormat(const Format& format);
         Operation& withItems(Span<const ApplicationItem> appItems);
+        // Items are kept by the operation, so it can be executed later by a worker thread
+        Operation& withItems(const ApplicationItemsSnapshot& snapshot);
         Operation& withParameters(const PropertyGroup* parameters);
         Operation& withMessenger(Messenger* messenger);
         Operation& withTaskProgress(TaskProgress* progress);
         bool execute();
+        // Same as Operation_ImportInDocument::executeAsync(), items are kept by the task
+        TaskFuture<bool> executeAsync(TaskManager* taskMgr, TaskPriority priority = TaskPriority::Normal);
 
     private:
         friend class System;
         Operation_ExportApplicationItems(System& system);
         System& m_system;
         Args_ExportApplicationItems m_args;
+        ApplicationItemsSnapshot m_itemsSnapshot;
     };
     Operation_ExportApplicationItems exportApplicationItems();
 
     // Implementation
 private:
+    Format probeFormatUncached(const FilePath& filepath) const;
+    Format probeFormatContents(const FormatProbeInput& input) const;
+    // Probes the format of the file compressed in 'head'(start of the compressed data) and 'tail'
+    // (end of the compressed data)
+    Format probeFormatCompressed(
+            const FilePath& filepath,
+            std::string_view head,
+            std::string_view tail,
+            CompressionFormat compression) const;
+    Format probeFormatSuffix(const FilePath& filepath) const;
+
+    struct FormatProbeCacheEntry {
+        std::filesystem::file_time_type lastWriteTime;
+        uint64_t fileSize;
+        Format format;
+    };
+
+    struct PrefetchEntry {
+        std::filesystem::file_time_type lastWriteTime;
+        uint64_t fileSize;
+        const ParametersProvider* parametersProvider;
+        Format format = Format_Unknown;
+        std::unique_ptr<Reader> reader; // Null while the file is being read
+        std::chrono::steady_clock::time_point expiryTime;
+    };
+
+    // Takes the warm reader of 'filepath' if any, waits if the file is being prefetched
+    std::unique_ptr<Reader> takePrefetchedReader(
+            const FilePath& filepath,
+            const ParametersProvider* parametersProvider,
+            Format* ptrFormat);
+    // Removes the expired warm readers from 'm_mapPrefetch' and returns them, so they are
+    // recycled once the mutex is unlocked(release of the read data may take time)
+    // 'm_mutexPrefetch' must be locked
+    std::vector<std::pair<Format, std::unique_ptr<Reader>>> popExpiredPrefetches();
+
+    struct MetadataCacheEntry {
+        std::filesystem::file_time_type lastWriteTime;
+        uint64_t fileSize;
+        std::optional<FileMetadata> metadata;
+    };
+
     std::vector<FormatProbe> m_vecFormatProbe;
+    std::vector<std::pair<Format, MetadataScanner>> m_vecMetadataScanner;
+    mutable std::mutex m_mutexMetadataCache;
+    mutable std::unordered_map<FilePath::string_type, MetadataCacheEntry> m_mapMetadataCache;
+    mutable std::mutex m_mutexFormatProbeCache;
+    mutable std::unordered_map<FilePath::string_type, FormatProbeCacheEntry> m_mapFormatProbeCache;
     std::vector<Format> m_vecReaderFormat;
     std::vector<Format> m_vecWriterFormat;
     std::vector<std::unique_ptr<FactoryReader>> m_vecFactoryReader;
     std::vector<std::unique_ptr<FactoryWriter>> m_vecFactoryWriter;
+    mutable std::mutex m_mutexPool;
+    mutable std::unordered_map<std::string, std::vector<std::unique_ptr<Reader>>> m_mapPooledReaders;
+    mutable std::unordered_map<std::string, std::vector<std::unique_ptr<Writer>>> m_mapPooledWriters;
+    std::future<void> m_futureWarmUp;
+    std::mutex m_mutexPrefetch;
+    std::condition_variable m_condPrefetch;
+    std::unordered_map<FilePath::string_type, PrefetchEntry> m_mapPrefetch;
+    int m_prefetchCapacity = 2;
+    std::chrono::milliseconds m_prefetchKeepAliveTime = std::chrono::seconds(30);
+    bool m_isFileReadAheadEnabled = false;
 };
 
 // Predefined
@@ -144,7 +337,14 @@ Format probeFormat_IGES(const System::FormatProbeInput& input);
 Format probeFormat_OCCBREP(const System::FormatProbeInput& input);
 Format probeFormat_STL(const System::FormatProbeInput& input);
 Format probeFormat_OBJ(const System::FormatProbeInput& input);
+Format probeFormat_PLY(const System::FormatProbeInput& input);
+Format probeFormat_LAS(const System::FormatProbeInput& input);
 void addPredefinedFormatProbes(System* system);
 
+// Streaming scan of STEP(ISO 10303-21) data: HEADER section is parsed, then DATA sections are
+// skimmed to count entity instances and collect names of PRODUCT entities
+bool scanMetadata_STEP(std::istream& istr, System::FileMetadata* metadata);
+void addPredefinedMetadataScanners(System* system);
+
 } // namespace IO
 } // namespace Mayo
@@ -0,0 +1,32 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_writer.h"
+#include "stream_utils.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QTemporaryFile>
+#include <ostream>
+
+namespace Mayo {
+namespace IO {
+
+bool Writer::writeStream(std::ostream& ostr, TaskProgress* progress)
+{
+    // File is created(and removed) by QTemporaryFile, its name is then reused by writeFile()
+    QTemporaryFile file(QDir::tempPath() + "/mayo_stream_XXXXXX");
+    if (!file.open())
+        return false;
+
+    file.close();
+    if (!this->writeFile(filepathFrom(file.fileName()), progress))
+        return false;
+
+    return file.open() && StreamUtils::copy(&file, ostr);
+}
+
+} // namespace IO
+} // namespace Mayo
@@ -9,6 +9,7 @@
 #include "filepath.h"
 #include "io_format.h"
 #include "span.h"
+#include <iosfwd>
 #include <memory>
 
 namespace Mayo {
@@ -24,7 +25,23 @@ public:
     virtual ~Writer() = default;
     virtual bool transfer(Span<const ApplicationItem> appItems, TaskProgress* progress) = 0;
     virtual bool writeFile(const FilePath& fp, TaskProgress* progress) = 0;
+
+    // Writes data into stream 'ostr'(eg standard output, pipe)
+    // Default implementation calls writeFile() with a temporary file then copies it into the
+    // stream. Writers able to serialize into streams override this
+    virtual bool writeStream(std::ostream& ostr, TaskProgress* progress);
+
     virtual void applyProperties(const PropertyGroup* /*params*/) {}
+
+    // Whether writing changes data of the application items(eg order of mesh triangles) with the
+    // current properties. Such writer mustn't run concurrently with other writers of the same items,
+    // whereas writers only reading data can run in parallel
+    virtual bool modifiesItemsData() const { return false; }
+
+    // Clears the data of the previous transfer/write and restores the default parameters, so the
+    // writer can be reused for other outputs(see System::takeWriter())
+    // Returns false if the writer can't be reused, which is the default
+    virtual bool resetSession() { return false; }
 };
 
 class FactoryWriter {
@@ -0,0 +1,78 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "job_arena.h"
+#include "global.h"
+
+#include <mutex>
+#include <vector>
+
+namespace Mayo {
+
+namespace {
+
+constexpr size_t JobArenaBlockSize = 1024 * 1024;
+
+struct JobArenaPool {
+    std::mutex mutex;
+    std::vector<Handle_NCollection_IncAllocator> vecArena;
+};
+
+JobArenaPool& globalPool()
+{
+    static JobArenaPool pool;
+    return pool;
+}
+
+Handle_NCollection_IncAllocator& threadArena()
+{
+    thread_local Handle_NCollection_IncAllocator arena;
+    return arena;
+}
+
+} // namespace
+
+JobArena::Scope::Scope()
+    : m_previousArena(threadArena())
+{
+    {
+        JobArenaPool& pool = globalPool();
+        std::lock_guard<std::mutex> lock(pool.mutex); MAYO_UNUSED(lock);
+        if (!pool.vecArena.empty()) {
+            m_arena = pool.vecArena.back();
+            pool.vecArena.pop_back();
+        }
+    }
+
+    if (m_arena.IsNull())
+        m_arena = new NCollection_IncAllocator(JobArenaBlockSize);
+
+    threadArena() = m_arena;
+}
+
+JobArena::Scope::~Scope()
+{
+    threadArena() = m_previousArena;
+    // Blocks are kept, so next job allocates without calling the memory manager
+    m_arena->Reset(false);
+    JobArenaPool& pool = globalPool();
+    std::lock_guard<std::mutex> lock(pool.mutex); MAYO_UNUSED(lock);
+    pool.vecArena.push_back(std::move(m_arena));
+}
+
+const Handle_NCollection_IncAllocator& JobArena::current()
+{
+    return threadArena();
+}
+
+int JobArena::pooledCount()
+{
+    JobArenaPool& pool = globalPool();
+    std::lock_guard<std::mutex> lock(pool.mutex); MAYO_UNUSED(lock);
+    return int(pool.vecArena.size());
+}
+
+} // namespace Mayo
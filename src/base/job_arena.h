@@ -0,0 +1,41 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <NCollection_IncAllocator.hxx>
+
+namespace Mayo {
+
+// Incremental allocator(arena) shared by the scratch collections of a job, eg one import+export
+// of a batch conversion. Single deallocations are no-ops, the whole memory is released at once
+// when the job ends and the arena is then recycled for the next job
+// Arena is bound to the thread running the job: collections filled by other threads(eg meshing
+// workers) must not use it, and it must not be used by objects outliving the job
+class JobArena {
+public:
+    // Binds an arena of the pool to the calling thread for the lifetime of the object
+    class Scope {
+    public:
+        Scope();
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Handle_NCollection_IncAllocator m_arena;
+        Handle_NCollection_IncAllocator m_previousArena; // In case of nested scopes
+    };
+
+    // Arena bound to the calling thread, null if none. Null is accepted by NCollection containers
+    // which then use the common allocator
+    static const Handle_NCollection_IncAllocator& current();
+
+    // Count of arenas kept for reuse
+    static int pooledCount();
+};
+
+} // namespace Mayo
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "cpp_utils.h"
 #include "span.h"
 #include <algorithm>
 #include <vector>
@@ -28,26 +29,54 @@ public:
     bool nodeIsRoot(TreeNodeId id) const;
     bool nodeIsLeaf(TreeNodeId id) const;
     Span<const TreeNodeId> roots() const;
+    size_t nodeCount() const; // Including nodes marked as 'deleted'
+
+    // Whether nodes were appended in pre-order(eg depth-first building), in that case every subtree
+    // is the contiguous range of identifiers [id, nodeSubTreeEnd(id))
+    bool hasPreOrderLayout() const { return m_hasPreOrderLayout; }
+    // Identifier following the last node of the subtree of 'id', valid only with pre-order layout
+    TreeNodeId nodeSubTreeEnd(TreeNodeId id) const;
+
+    // Node item of a bulk append, 'depth' is relative to the parent node of the range(0 for the
+    // direct children)
+    struct PreOrderNode {
+        unsigned depth;
+        T data;
+    };
 
     void clear();
+    void reserve(size_t nodeCount);
     TreeNodeId appendChild(TreeNodeId parentId, const T& data);
     TreeNodeId appendChild(TreeNodeId parentId, T&& data);
+    // Appends the nodes listed in pre-order by 'spanNode', returns identifier of the first new node
+    TreeNodeId appendChildren(TreeNodeId parentId, Span<const PreOrderNode> spanNode);
+    // Moves all the nodes of 'other' into this tree, roots of 'other' become children of 'parentId'
+    // Node identifiers of 'other' are shifted by the returned offset
+    TreeNodeId appendTree(TreeNodeId parentId, Tree<T>&& other);
     void removeRoot(TreeNodeId id);
+    // Reclaims the nodes marked as 'deleted', returns the table mapping old node identifiers to the
+    // new ones(0 for deleted nodes). Beware all identifiers held outside the tree must be remapped
+    std::vector<TreeNodeId> compact();
 
 private:
-    struct TreeNode {
+    // Topology of the nodes is stored separately from node data(structure of arrays), so traversals
+    // only touch contiguous link records
+    struct TreeNodeLinks {
         TreeNodeId siblingPrevious;
         TreeNodeId siblingNext;
         TreeNodeId childFirst;
         TreeNodeId childLast;
         TreeNodeId parent;
-        T data;
-        bool isDeleted;
+        TreeNodeId subTreeEnd;
     };
 
     template<typename U, typename FN>
     friend void traverseTree_unorder(const Tree<U>& tree, const FN& callback);
 
+    template<typename U, typename FN>
+    friend void traverseTree_unorder(
+            TreeNodeId idBegin, TreeNodeId idEnd, const Tree<U>& tree, const FN& callback);
+
     template<typename U, typename FN>
     friend void traverseTree_preOrder(TreeNodeId node, const Tree<U>& tree, const FN& callback);
 
@@ -58,19 +87,28 @@ private:
     friend void visitDirectChildren(TreeNodeId id, const Tree<U>& tree, const FN& callback);
 
     TreeNodeId lastNodeId() const;
-    TreeNode* ptrNode(TreeNodeId id);
-    const TreeNode* ptrNode(TreeNodeId id) const;
-    TreeNode* appendChild(TreeNodeId parentId);
+    TreeNodeLinks* ptrLinks(TreeNodeId id);
+    const TreeNodeLinks* ptrLinks(TreeNodeId id) const;
+    TreeNodeId appendNode(TreeNodeId parentId);
+    void linkChild(TreeNodeId parentId, TreeNodeId nodeId);
+    void extendSubTreeEnds(TreeNodeId parentId, TreeNodeId firstNewId, TreeNodeId idEnd);
     bool isNodeDeleted(TreeNodeId id) const;
+    TreeNodeId nodeChildFirstNotDeleted(TreeNodeId id) const;
+    TreeNodeId nodeSiblingNextNotDeleted(TreeNodeId id) const;
 
-    std::vector<TreeNode> m_vecNode;
+    std::vector<TreeNodeLinks> m_vecNodeLinks;
+    std::vector<T> m_vecNodeData;
+    std::vector<bool> m_vecNodeDeleted;
     std::vector<TreeNodeId> m_vecRoot;
+    bool m_hasPreOrderLayout = true;
 };
 
 // Fastest tree traversal, but nodes are visited unordered
 template<typename T, typename FN>
 void traverseTree_unorder(const Tree<T>& tree, const FN& callback);
 
+// Note: traversal functions are iterative, so there is no recursion whatever the tree depth
+
 template<typename T, typename FN>
 void traverseTree_preOrder(const Tree<T>& tree, const FN& callback);
 
@@ -94,6 +132,51 @@ void traverseTree(TreeNodeId id, const Tree<T>& tree, const FN& callback);
 template<typename U, typename FN>
 void visitDirectChildren(TreeNodeId id, const Tree<U>& tree, const FN& callback);
 
+// Same as traverseTree_unorder() but restricted to the identifiers in range [idBegin, idEnd)
+template<typename T, typename FN>
+void traverseTree_unorder(TreeNodeId idBegin, TreeNodeId idEnd, const Tree<T>& tree, const FN& callback);
+
+// Note: parallel traversal functions split the nodes into chunks of 'grainSize' nodes processed
+//       concurrently(see CppUtils::parallelFor()), they run sequentially below 'grainSize' nodes.
+//       Callbacks are called from several threads at once, so they must only read the tree and
+//       write to separate slots(eg vector items indexed by node identifier)
+
+// Default count of nodes per chunk of the parallel traversals
+constexpr TreeNodeId TreeParallelGrainSize = 1024;
+
+// Same as traverseTree_unorder() but nodes are visited concurrently
+template<typename T, typename FN>
+void traverseTree_parallel(const Tree<T>& tree, const FN& callback, TreeNodeId grainSize = TreeParallelGrainSize);
+
+// Visits concurrently the subtree of 'id', nodes are visited unordered
+template<typename T, typename FN>
+void traverseTree_parallel(
+        TreeNodeId id, const Tree<T>& tree, const FN& callback, TreeNodeId grainSize = TreeParallelGrainSize);
+
+// Maps each node with 'fnMap(TreeNodeId) -> R' and reduces the mapped values with
+// 'fnReduce(R, R) -> R'. Values are reduced in node identifier order, so 'fnReduce' only needs to
+// be associative
+template<typename T, typename R, typename FN_MAP, typename FN_REDUCE>
+R reduceTree(
+        const Tree<T>& tree,
+        const R& identity,
+        const FN_MAP& fnMap,
+        const FN_REDUCE& fnReduce,
+        TreeNodeId grainSize = TreeParallelGrainSize);
+
+// Computes concurrently 'fnSubtree(TreeNodeId) -> R' for the independent subtrees 'spanId', then
+// merges the results in 'spanId' order with 'fnMerge(R, R) -> R' starting from 'init'
+// Subtrees are processed sequentially when their total node count is known(pre-order layout) and
+// less than 'grainSize'
+template<typename T, typename R, typename FN_SUBTREE, typename FN_MERGE>
+R mapSubtrees(
+        const Tree<T>& tree,
+        Span<const TreeNodeId> spanId,
+        R init,
+        const FN_SUBTREE& fnSubtree,
+        const FN_MERGE& fnMerge,
+        TreeNodeId grainSize = TreeParallelGrainSize);
+
 // --
 // -- Implementation
 // --
@@ -101,28 +184,28 @@ void visitDirectChildren(TreeNodeId id, const Tree<U>& tree, const FN& callback)
 template<typename T> Tree<T>::Tree() {}
 
 template<typename T> TreeNodeId Tree<T>::nodeSiblingPrevious(TreeNodeId id) const {
-    const TreeNode* node = this->ptrNode(id);
-    return node ? node->siblingPrevious : 0;
+    const TreeNodeLinks* links = this->ptrLinks(id);
+    return links ? links->siblingPrevious : 0;
 }
 
 template<typename T> TreeNodeId Tree<T>::nodeSiblingNext(TreeNodeId id) const {
-    const TreeNode* node = this->ptrNode(id);
-    return node ? node->siblingNext : 0;
+    const TreeNodeLinks* links = this->ptrLinks(id);
+    return links ? links->siblingNext : 0;
 }
 
 template<typename T> TreeNodeId Tree<T>::nodeChildFirst(TreeNodeId id) const {
-    const TreeNode* node = this->ptrNode(id);
-    return node ? node->childFirst : 0;
+    const TreeNodeLinks* links = this->ptrLinks(id);
+    return links ? links->childFirst : 0;
 }
 
 template<typename T> TreeNodeId Tree<T>::nodeChildLast(TreeNodeId id) const {
-    const TreeNode* node = this->ptrNode(id);
-    return node ? node->childLast : 0;
+    const TreeNodeLinks* links = this->ptrLinks(id);
+    return links ? links->childLast : 0;
 }
 
 template<typename T> TreeNodeId Tree<T>::nodeParent(TreeNodeId id) const {
-    const TreeNode* node = this->ptrNode(id);
-    return node ? node->parent : 0;
+    const TreeNodeLinks* links = this->ptrLinks(id);
+    return links ? links->parent : 0;
 }
 
 template<typename T> TreeNodeId Tree<T>::nodeRoot(TreeNodeId id) const {
@@ -134,109 +217,279 @@ template<typename T> TreeNodeId Tree<T>::nodeRoot(TreeNodeId id) const {
 
 template<typename T> const T& Tree<T>::nodeData(TreeNodeId id) const {
     static const T nullObject = {};
-    const TreeNode* node = this->ptrNode(id);
-    return node ? node->data : nullObject;
+    return id != 0 && id <= m_vecNodeData.size() ? m_vecNodeData[id - 1] : nullObject;
 }
 
 template<typename T> bool Tree<T>::nodeIsRoot(TreeNodeId id) const {
-    const TreeNode* node = this->ptrNode(id);
-    return node ? node->parent == 0 : false;
+    const TreeNodeLinks* links = this->ptrLinks(id);
+    return links ? links->parent == 0 : false;
 }
 
 template<typename T> bool Tree<T>::nodeIsLeaf(TreeNodeId id) const {
     return this->nodeChildFirst(id) == 0;
 }
 
+template<typename T> TreeNodeId Tree<T>::nodeSubTreeEnd(TreeNodeId id) const {
+    const TreeNodeLinks* links = this->ptrLinks(id);
+    return links ? links->subTreeEnd : 0;
+}
+
 template<typename T> void Tree<T>::clear()
 {
-    m_vecNode.clear();
+    m_vecNodeLinks.clear();
+    m_vecNodeData.clear();
+    m_vecNodeDeleted.clear();
     m_vecRoot.clear();
+    m_hasPreOrderLayout = true;
+}
+
+template<typename T> void Tree<T>::reserve(size_t nodeCount)
+{
+    m_vecNodeLinks.reserve(nodeCount);
+    m_vecNodeData.reserve(nodeCount);
+    m_vecNodeDeleted.reserve(nodeCount);
+}
+
+template<typename T> size_t Tree<T>::nodeCount() const
+{
+    return m_vecNodeLinks.size();
 }
 
 template<typename T>
 TreeNodeId Tree<T>::appendChild(TreeNodeId parentId, const T& data)
 {
-    TreeNode* node = this->appendChild(parentId);
-    node->data = data;
-    return this->lastNodeId();
+    m_vecNodeData.push_back(data);
+    return this->appendNode(parentId);
 }
 
 template<typename T>
 TreeNodeId Tree<T>::appendChild(TreeNodeId parentId, T&& data)
 {
-    TreeNode* node = this->appendChild(parentId);
-    node->data = std::forward<T>(data);
-    return this->lastNodeId();
+    m_vecNodeData.push_back(std::forward<T>(data));
+    return this->appendNode(parentId);
 }
 
+// Appends links of the node whose data was just pushed
 template<typename T>
-typename Tree<T>::TreeNode* Tree<T>::appendChild(TreeNodeId parentId)
+TreeNodeId Tree<T>::appendNode(TreeNodeId parentId)
 {
-    m_vecNode.push_back({});
+    m_vecNodeLinks.push_back({});
+    m_vecNodeDeleted.push_back(false);
     const TreeNodeId nodeId = this->lastNodeId();
-    TreeNode* node = &m_vecNode.back();
-    node->parent = parentId;
-    node->siblingPrevious = this->nodeChildLast(parentId);
+    m_vecNodeLinks.back().subTreeEnd = nodeId + 1;
+    this->linkChild(parentId, nodeId);
+    this->extendSubTreeEnds(parentId, nodeId, nodeId + 1);
+    return nodeId;
+}
+
+template<typename T>
+TreeNodeId Tree<T>::appendChildren(TreeNodeId parentId, Span<const PreOrderNode> spanNode)
+{
+    const TreeNodeId firstId = this->lastNodeId() + 1;
+    this->reserve(this->nodeCount() + spanNode.size());
+    // Parent identifier for each depth of the current branch
+    std::vector<TreeNodeId> vecBranchNodeId = { parentId };
+    for (const PreOrderNode& node : spanNode) {
+        Expects(node.depth < vecBranchNodeId.size());
+        const TreeNodeId nodeId = this->appendChild(vecBranchNodeId.at(node.depth), node.data);
+        vecBranchNodeId.resize(node.depth + 1);
+        vecBranchNodeId.push_back(nodeId);
+    }
+
+    return firstId;
+}
+
+template<typename T>
+TreeNodeId Tree<T>::appendTree(TreeNodeId parentId, Tree<T>&& other)
+{
+    const TreeNodeId offset = this->lastNodeId();
+    auto fnShiftId = [=](TreeNodeId id) { return id != 0 ? id + offset : 0; };
+    this->reserve(this->nodeCount() + other.nodeCount());
+    for (TreeNodeLinks& links : other.m_vecNodeLinks) {
+        links.siblingPrevious = fnShiftId(links.siblingPrevious);
+        links.siblingNext = fnShiftId(links.siblingNext);
+        links.childFirst = fnShiftId(links.childFirst);
+        links.childLast = fnShiftId(links.childLast);
+        links.parent = fnShiftId(links.parent);
+        links.subTreeEnd = fnShiftId(links.subTreeEnd);
+        m_vecNodeLinks.push_back(links);
+    }
+
+    for (T& data : other.m_vecNodeData)
+        m_vecNodeData.push_back(std::move(data));
+
+    m_vecNodeDeleted.insert(
+                m_vecNodeDeleted.end(), other.m_vecNodeDeleted.cbegin(), other.m_vecNodeDeleted.cend());
+    for (TreeNodeId otherRootId : other.m_vecRoot)
+        this->linkChild(parentId, otherRootId + offset);
+
+    m_hasPreOrderLayout = m_hasPreOrderLayout && other.m_hasPreOrderLayout;
+    this->extendSubTreeEnds(parentId, offset + 1, this->lastNodeId() + 1);
+    other.clear();
+    return offset;
+}
+
+template<typename T>
+void Tree<T>::linkChild(TreeNodeId parentId, TreeNodeId nodeId)
+{
+    TreeNodeLinks* links = this->ptrLinks(nodeId);
+    links->parent = parentId;
+    links->siblingPrevious = this->nodeChildLast(parentId);
+    links->siblingNext = 0;
     if (parentId != 0) {
-        TreeNode* parentNode = this->ptrNode(parentId);
-        if (parentNode->childFirst == 0)
-            parentNode->childFirst = nodeId;
+        TreeNodeLinks* parentLinks = this->ptrLinks(parentId);
+        if (parentLinks->childFirst == 0)
+            parentLinks->childFirst = nodeId;
 
-        if (parentNode->childLast != 0)
-            this->ptrNode(parentNode->childLast)->siblingNext = nodeId;
+        if (parentLinks->childLast != 0)
+            this->ptrLinks(parentLinks->childLast)->siblingNext = nodeId;
 
-        parentNode->childLast = nodeId;
+        parentLinks->childLast = nodeId;
     }
     else {
         m_vecRoot.push_back(nodeId);
     }
+}
 
-    return node;
+// Nodes [firstNewId, idEnd) were appended under 'parentId': extends the subtree ranges of 'parentId'
+// and its ancestors. Pre-order layout is lost if one of them doesn't end just before 'firstNewId'
+template<typename T>
+void Tree<T>::extendSubTreeEnds(TreeNodeId parentId, TreeNodeId firstNewId, TreeNodeId idEnd)
+{
+    for (TreeNodeId id = parentId; id != 0 && m_hasPreOrderLayout; id = this->nodeParent(id)) {
+        TreeNodeLinks* links = this->ptrLinks(id);
+        if (links->subTreeEnd == firstNewId)
+            links->subTreeEnd = idEnd;
+        else
+            m_hasPreOrderLayout = false;
+    }
 }
 
 template<typename T> bool Tree<T>::isNodeDeleted(TreeNodeId id) const
 {
-    const typename Tree<T>::TreeNode* ptrNode = this->ptrNode(id);
-    return !ptrNode || ptrNode->isDeleted;
+    return id == 0 || id > m_vecNodeDeleted.size() || m_vecNodeDeleted[id - 1];
+}
+
+template<typename T> TreeNodeId Tree<T>::nodeChildFirstNotDeleted(TreeNodeId id) const
+{
+    TreeNodeId itChild = this->nodeChildFirst(id);
+    while (itChild != 0 && this->isNodeDeleted(itChild))
+        itChild = this->nodeSiblingNext(itChild);
+
+    return itChild;
+}
+
+template<typename T> TreeNodeId Tree<T>::nodeSiblingNextNotDeleted(TreeNodeId id) const
+{
+    TreeNodeId itSibling = this->nodeSiblingNext(id);
+    while (itSibling != 0 && this->isNodeDeleted(itSibling))
+        itSibling = this->nodeSiblingNext(itSibling);
+
+    return itSibling;
 }
 
 template<typename T> void Tree<T>::removeRoot(TreeNodeId id)
 {
     Expects(this->nodeIsRoot(id));
 
-    // TODO Mark all children nodes as 'deleted'
     auto it = std::find(m_vecRoot.begin(), m_vecRoot.end(), id);
     if (it != m_vecRoot.end()) {
-        TreeNode* node = this->ptrNode(id);
-        Expects(node != nullptr);
-        node->isDeleted = true;
+        std::vector<TreeNodeId> vecSubTreeNodeId;
+        traverseTree_preOrder(id, *this, [&](TreeNodeId subId) { vecSubTreeNodeId.push_back(subId); });
+        for (TreeNodeId subId : vecSubTreeNodeId)
+            m_vecNodeDeleted[subId - 1] = true;
+
         m_vecRoot.erase(it);
     }
 }
 
+template<typename T> std::vector<TreeNodeId> Tree<T>::compact()
+{
+    const size_t oldNodeCount = this->nodeCount();
+    std::vector<TreeNodeId> vecIdRemap(oldNodeCount + 1, 0);
+    TreeNodeId newId = 0;
+    for (size_t i = 0; i < oldNodeCount; ++i) {
+        if (!m_vecNodeDeleted[i])
+            vecIdRemap.at(i + 1) = ++newId;
+    }
+
+    // Live nodes are only linked to live nodes, deleted subtrees being removed as a whole
+    auto fnRemap = [&](TreeNodeId id) { return vecIdRemap.at(id); };
+    size_t iNew = 0;
+    for (size_t i = 0; i < oldNodeCount; ++i) {
+        if (m_vecNodeDeleted[i])
+            continue;
+
+        TreeNodeLinks links = m_vecNodeLinks.at(i);
+        links.siblingPrevious = fnRemap(links.siblingPrevious);
+        links.siblingNext = fnRemap(links.siblingNext);
+        links.childFirst = fnRemap(links.childFirst);
+        links.childLast = fnRemap(links.childLast);
+        links.parent = fnRemap(links.parent);
+        links.subTreeEnd = TreeNodeId(iNew + 2); // Recomputed below
+        m_vecNodeLinks.at(iNew) = links;
+        if (iNew != i)
+            m_vecNodeData.at(iNew) = std::move(m_vecNodeData.at(i));
+
+        ++iNew;
+    }
+
+    m_vecNodeLinks.resize(iNew);
+    m_vecNodeLinks.shrink_to_fit();
+    m_vecNodeData.erase(m_vecNodeData.begin() + iNew, m_vecNodeData.end());
+    m_vecNodeData.shrink_to_fit();
+    m_vecNodeDeleted.assign(iNew, false);
+    m_vecNodeDeleted.shrink_to_fit();
+    for (TreeNodeId& rootId : m_vecRoot)
+        rootId = fnRemap(rootId);
+
+    // Relative order of the nodes is kept, so does the pre-order layout
+    if (m_hasPreOrderLayout) {
+        for (TreeNodeId id = this->lastNodeId(); id != 0; --id) {
+            const TreeNodeLinks& links = m_vecNodeLinks.at(id - 1);
+            if (links.parent != 0) {
+                TreeNodeLinks& parentLinks = m_vecNodeLinks.at(links.parent - 1);
+                parentLinks.subTreeEnd = std::max(parentLinks.subTreeEnd, links.subTreeEnd);
+            }
+        }
+    }
+
+    return vecIdRemap;
+}
+
 template<typename T> Span<const TreeNodeId> Tree<T>::roots() const {
     return m_vecRoot;
 }
 
 template<typename T> TreeNodeId Tree<T>::lastNodeId() const {
-    return static_cast<TreeNodeId>(m_vecNode.size());
+    return static_cast<TreeNodeId>(m_vecNodeLinks.size());
 }
 
 template<typename T>
-typename Tree<T>::TreeNode* Tree<T>::ptrNode(TreeNodeId id) {
-    return id != 0 && id <= m_vecNode.size() ? &m_vecNode.at(id - 1) : nullptr;
+typename Tree<T>::TreeNodeLinks* Tree<T>::ptrLinks(TreeNodeId id) {
+    return id != 0 && id <= m_vecNodeLinks.size() ? &m_vecNodeLinks[id - 1] : nullptr;
 }
 
 template<typename T>
-const typename Tree<T>::TreeNode* Tree<T>::ptrNode(TreeNodeId id) const {
-    return id != 0 && id <= m_vecNode.size() ? &m_vecNode.at(id - 1) : nullptr;
+const typename Tree<T>::TreeNodeLinks* Tree<T>::ptrLinks(TreeNodeId id) const {
+    return id != 0 && id <= m_vecNodeLinks.size() ? &m_vecNodeLinks[id - 1] : nullptr;
 }
 
 template<typename T, typename FN>
 void traverseTree_unorder(const Tree<T>& tree, const FN& callback)
 {
-    for (const typename Tree<T>::TreeNode& node : tree.m_vecNode) {
-        const TreeNodeId id = (&node - &tree.m_vecNode.front()) + 1;
+    const TreeNodeId lastId = tree.lastNodeId();
+    for (TreeNodeId id = 1; id <= lastId; ++id) {
+        if (!tree.isNodeDeleted(id))
+            callback(id);
+    }
+}
+
+template<typename T, typename FN>
+void traverseTree_unorder(TreeNodeId idBegin, TreeNodeId idEnd, const Tree<T>& tree, const FN& callback)
+{
+    const TreeNodeId lastId = tree.lastNodeId();
+    for (TreeNodeId id = std::max(idBegin, TreeNodeId(1)); id < idEnd && id <= lastId; ++id) {
         if (!tree.isNodeDeleted(id))
             callback(id);
     }
@@ -261,10 +514,32 @@ void traverseTree_preOrder(const Tree<T>& tree, const FN& callback) {
 template<typename T, typename FN>
 void traverseTree_preOrder(TreeNodeId id, const Tree<T>& tree, const FN& callback)
 {
-    if (!tree.isNodeDeleted(id)) {
-        callback(id);
-        for (auto it = tree.nodeChildFirst(id); it != 0; it = tree.nodeSiblingNext(it))
-            traverseTree_preOrder(it, tree, callback);
+    if (tree.isNodeDeleted(id))
+        return;
+
+    if (tree.hasPreOrderLayout()) {
+        // Subtree is a contiguous range, deleted nodes being whole subtrees
+        const TreeNodeId idEnd = tree.nodeSubTreeEnd(id);
+        for (TreeNodeId it = id; it < idEnd; ++it) {
+            if (!tree.isNodeDeleted(it))
+                callback(it);
+        }
+
+        return;
+    }
+
+    TreeNodeId it = id;
+    while (it != 0) {
+        callback(it);
+        // Next node is the first child, otherwise the next sibling of the nearest ancestor
+        TreeNodeId itNext = tree.nodeChildFirstNotDeleted(it);
+        while (itNext == 0 && it != id) {
+            itNext = tree.nodeSiblingNextNotDeleted(it);
+            if (itNext == 0)
+                it = tree.nodeParent(it);
+        }
+
+        it = itNext;
     }
 }
 
@@ -277,11 +552,27 @@ void traverseTree_postOrder(const Tree<T>& tree, const FN& callback) {
 template<typename T, typename FN>
 void traverseTree_postOrder(TreeNodeId id, const Tree<T>& tree, const FN& callback)
 {
-    if (!tree.isNodeDeleted(id)) {
-        for (auto it = tree.nodeChildFirst(id); it != 0; it = tree.nodeSiblingNext(it))
-            traverseTree_postOrder(it, tree, callback);
+    if (tree.isNodeDeleted(id))
+        return;
 
-        callback(id);
+    auto fnDeepestFirstChild = [&](TreeNodeId itNode) {
+        TreeNodeId itChild = tree.nodeChildFirstNotDeleted(itNode);
+        while (itChild != 0) {
+            itNode = itChild;
+            itChild = tree.nodeChildFirstNotDeleted(itNode);
+        }
+
+        return itNode;
+    };
+
+    TreeNodeId it = fnDeepestFirstChild(id);
+    for (;;) {
+        callback(it);
+        if (it == id)
+            return;
+
+        const TreeNodeId itSibling = tree.nodeSiblingNextNotDeleted(it);
+        it = itSibling != 0 ? fnDeepestFirstChild(itSibling) : tree.nodeParent(it);
     }
 }
 
@@ -297,4 +588,125 @@ void visitDirectChildren(TreeNodeId id, const Tree<U>& tree, const FN& callback)
     }
 }
 
+namespace Internal {
+
+// Splits [idxBegin, idxEnd) into chunks of 'grainSize' items, calls 'fnChunk(chunkIndex, begin, end)'
+// concurrently for each chunk. Returns the count of chunks
+template<typename FN>
+int parallelForTreeChunks(TreeNodeId idxBegin, TreeNodeId idxEnd, TreeNodeId grainSize, const FN& fnChunk)
+{
+    if (idxEnd <= idxBegin)
+        return 0;
+
+    grainSize = std::max(grainSize, TreeNodeId(1));
+    const TreeNodeId count = idxEnd - idxBegin;
+    const int chunkCount = int((count + grainSize - 1) / grainSize);
+    if (chunkCount == 1) {
+        fnChunk(0, idxBegin, idxEnd);
+        return 1;
+    }
+
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        const TreeNodeId chunkBegin = idxBegin + TreeNodeId(iChunk) * grainSize;
+        fnChunk(iChunk, chunkBegin, std::min(chunkBegin + grainSize, idxEnd));
+    });
+    return chunkCount;
+}
+
+} // namespace Internal
+
+template<typename T, typename FN>
+void traverseTree_parallel(const Tree<T>& tree, const FN& callback, TreeNodeId grainSize)
+{
+    const TreeNodeId idEnd = TreeNodeId(tree.nodeCount()) + 1;
+    Internal::parallelForTreeChunks(1, idEnd, grainSize, [&](int, TreeNodeId chunkBegin, TreeNodeId chunkEnd) {
+        traverseTree_unorder(chunkBegin, chunkEnd, tree, callback);
+    });
+}
+
+template<typename T, typename FN>
+void traverseTree_parallel(TreeNodeId id, const Tree<T>& tree, const FN& callback, TreeNodeId grainSize)
+{
+    if (tree.hasPreOrderLayout()) {
+        // Subtree is a contiguous range, deleted nodes being whole subtrees
+        const TreeNodeId idEnd = tree.nodeSubTreeEnd(id);
+        Internal::parallelForTreeChunks(id, idEnd, grainSize, [&](int, TreeNodeId chunkBegin, TreeNodeId chunkEnd) {
+            traverseTree_unorder(chunkBegin, chunkEnd, tree, callback);
+        });
+        return;
+    }
+
+    std::vector<TreeNodeId> vecId;
+    traverseTree_preOrder(id, tree, [&](TreeNodeId itId) { vecId.push_back(itId); });
+    const TreeNodeId idCount = TreeNodeId(vecId.size());
+    Internal::parallelForTreeChunks(0, idCount, grainSize, [&](int, TreeNodeId chunkBegin, TreeNodeId chunkEnd) {
+        for (TreeNodeId i = chunkBegin; i < chunkEnd; ++i)
+            callback(vecId[i]);
+    });
+}
+
+template<typename T, typename R, typename FN_MAP, typename FN_REDUCE>
+R reduceTree(
+        const Tree<T>& tree,
+        const R& identity,
+        const FN_MAP& fnMap,
+        const FN_REDUCE& fnReduce,
+        TreeNodeId grainSize)
+{
+    // Wrapped so that std::vector<bool> specialization can't be involved(not safe concurrently)
+    struct ChunkResult { R value; };
+    const TreeNodeId idEnd = TreeNodeId(tree.nodeCount()) + 1;
+    grainSize = std::max(grainSize, TreeNodeId(1));
+    std::vector<ChunkResult> vecChunkResult((tree.nodeCount() + grainSize - 1) / grainSize, ChunkResult{ identity });
+    Internal::parallelForTreeChunks(1, idEnd, grainSize, [&](int iChunk, TreeNodeId chunkBegin, TreeNodeId chunkEnd) {
+        R& chunkResult = vecChunkResult[iChunk].value;
+        traverseTree_unorder(chunkBegin, chunkEnd, tree, [&](TreeNodeId id) {
+            chunkResult = fnReduce(std::move(chunkResult), fnMap(id));
+        });
+    });
+
+    R result = identity;
+    for (ChunkResult& chunkResult : vecChunkResult)
+        result = fnReduce(std::move(result), std::move(chunkResult.value));
+
+    return result;
+}
+
+template<typename T, typename R, typename FN_SUBTREE, typename FN_MERGE>
+R mapSubtrees(
+        const Tree<T>& tree,
+        Span<const TreeNodeId> spanId,
+        R init,
+        const FN_SUBTREE& fnSubtree,
+        const FN_MERGE& fnMerge,
+        TreeNodeId grainSize)
+{
+    bool isSequential = spanId.size() <= 1;
+    if (!isSequential && tree.hasPreOrderLayout()) {
+        size_t nodeCount = 0;
+        for (TreeNodeId id : spanId)
+            nodeCount += tree.nodeSubTreeEnd(id) - std::min(id, tree.nodeSubTreeEnd(id));
+
+        isSequential = nodeCount < grainSize;
+    }
+
+    if (isSequential) {
+        for (TreeNodeId id : spanId)
+            init = fnMerge(std::move(init), fnSubtree(id));
+
+        return init;
+    }
+
+    // Wrapped so that std::vector<bool> specialization can't be involved(not safe concurrently)
+    struct SubtreeResult { R value; };
+    std::vector<SubtreeResult> vecSubtreeResult(spanId.size(), SubtreeResult{ init });
+    CppUtils::parallelFor(int(spanId.size()), [&](int i) {
+        vecSubtreeResult[i].value = fnSubtree(spanId[i]);
+    });
+    for (SubtreeResult& subtreeResult : vecSubtreeResult)
+        init = fnMerge(std::move(init), std::move(subtreeResult.value));
+
+    return init;
+}
+
 } // namespace Mayo
@@ -0,0 +1,37 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "mapped_file.h"
+
+namespace Mayo {
+
+bool MappedFile::open(const FilePath& filepath)
+{
+    m_data = nullptr;
+    m_size = 0;
+    m_fileContents.clear();
+    m_file.close();
+    m_file.setFileName(filepathTo<QString>(filepath));
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = m_file.size();
+    const uchar* data = size > 0 ? m_file.map(0, size) : nullptr;
+    if (!data && size > 0) {
+        // Memory mapping not supported, fallback to regular read
+        m_fileContents = m_file.readAll();
+        if (m_fileContents.size() != size)
+            return false;
+
+        data = reinterpret_cast<const uchar*>(m_fileContents.constData());
+    }
+
+    m_data = reinterpret_cast<const char*>(data);
+    m_size = size;
+    return true;
+}
+
+} // namespace Mayo
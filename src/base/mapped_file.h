@@ -0,0 +1,35 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "filepath.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <cstdint>
+
+namespace Mayo {
+
+// Read-only contents of a file, memory-mapped if supported or else read entirely in memory(eg
+// some network file systems)
+// Data stays valid until the MappedFile object is destroyed
+class MappedFile {
+public:
+    // Returns false if the file can't be opened or read, data() is null for an empty file
+    bool open(const FilePath& filepath);
+
+    const char* data() const { return m_data; }
+    int64_t size() const { return m_size; }
+
+private:
+    QFile m_file;
+    QByteArray m_fileContents;
+    const char* m_data = nullptr;
+    int64_t m_size = 0;
+};
+
+} // namespace Mayo
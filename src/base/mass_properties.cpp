@@ -0,0 +1,81 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "mass_properties.h"
+#include "cpp_utils.h"
+#include "math_utils.h"
+#include "task_progress.h"
+
+#include <BRepGProp.hxx>
+#include <GProp_GProps.hxx>
+#include <GProp_PrincipalProps.hxx>
+#include <TopExp.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace Mayo {
+
+MassProperties MassProperties::compute(const TopoDS_Shape& shape, TaskProgress* progress)
+{
+    MassProperties massProps;
+    if (shape.IsNull())
+        return massProps;
+
+    TopTools_IndexedMapOfShape mapSolid;
+    TopTools_IndexedMapOfShape mapFace;
+    TopExp::MapShapes(shape, TopAbs_SOLID, mapSolid);
+    TopExp::MapShapes(shape, TopAbs_FACE, mapFace);
+
+    // Items [0, solidCount) are solids, next ones are faces
+    const int solidCount = mapSolid.Extent();
+    const int itemCount = solidCount + mapFace.Extent();
+    std::vector<GProp_GProps> vecItemProps(itemCount);
+    auto fnComputeItem = [&](int i) {
+        if (i < solidCount)
+            BRepGProp::VolumeProperties(mapSolid.FindKey(i + 1), vecItemProps.at(i));
+        else
+            BRepGProp::SurfaceProperties(mapFace.FindKey(i - solidCount + 1), vecItemProps.at(i));
+    };
+
+    // Items are processed by batches so progress and abort requests are handled from this thread
+    const int batchSize = 4 * std::max(int(std::thread::hardware_concurrency()), 1);
+    for (int iBatch = 0; iBatch < itemCount; iBatch += batchSize) {
+        if (TaskProgress::isAbortRequested(progress))
+            return {};
+
+        const int batchItemCount = std::min(batchSize, itemCount - iBatch);
+        CppUtils::parallelFor(batchItemCount, [&](int i) { fnComputeItem(iBatch + i); });
+        if (progress)
+            progress->setValue(MathUtils::mappedValue(iBatch + batchItemCount, 0, itemCount, 0, 100));
+    }
+
+    GProp_GProps volumeProps;
+    for (int i = 0; i < solidCount; ++i)
+        volumeProps.Add(vecItemProps.at(i));
+
+    GProp_GProps surfaceProps;
+    for (int i = solidCount; i < itemCount; ++i)
+        surfaceProps.Add(vecItemProps.at(i));
+
+    const GProp_GProps& mainProps = solidCount > 0 ? volumeProps : surfaceProps;
+    massProps.volume = volumeProps.Mass();
+    massProps.area = surfaceProps.Mass();
+    if (mainProps.Mass() > 0.) {
+        massProps.centroid = mainProps.CentreOfMass();
+        massProps.matrixOfInertia = mainProps.MatrixOfInertia();
+        const GProp_PrincipalProps principalProps = mainProps.PrincipalProperties();
+        principalProps.Moments(
+                    massProps.principalMoments[0],
+                    massProps.principalMoments[1],
+                    massProps.principalMoments[2]);
+    }
+
+    return massProps;
+}
+
+} // namespace Mayo
@@ -0,0 +1,30 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <gp_Mat.hxx>
+#include <gp_Pnt.hxx>
+#include <TopoDS_Shape.hxx>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Global properties of a shape computed from its exact geometry, with density of 1
+struct MassProperties {
+    double volume = 0.; // Sum of the volumes of the solids
+    double area = 0.; // Sum of the areas of the faces
+    gp_Pnt centroid; // Center of mass of the solids, or of the faces if there is no solid
+    gp_Mat matrixOfInertia; // At centroid
+    double principalMoments[3] = {}; // Principal moments of inertia
+
+    // Computes properties of 'shape', solids and faces are processed in parallel
+    // Returns null properties if abort is requested on 'progress'
+    static MassProperties compute(const TopoDS_Shape& shape, TaskProgress* progress = nullptr);
+};
+
+} // namespace Mayo
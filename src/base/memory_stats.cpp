@@ -0,0 +1,277 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "memory_stats.h"
+#include "document.h"
+#include "xcaf.h"
+
+#include <BRep_CurveRepresentation.hxx>
+#include <BRep_ListIteratorOfListOfCurveRepresentation.hxx>
+#include <BRep_TEdge.hxx>
+#include <BRep_TFace.hxx>
+#include <Geom_BezierCurve.hxx>
+#include <Geom_BezierSurface.hxx>
+#include <Geom_BSplineCurve.hxx>
+#include <Geom_BSplineSurface.hxx>
+#include <Geom_OffsetCurve.hxx>
+#include <Geom_OffsetSurface.hxx>
+#include <Geom_RectangularTrimmedSurface.hxx>
+#include <Geom_SweptSurface.hxx>
+#include <Geom_TrimmedCurve.hxx>
+#include <Geom2d_BezierCurve.hxx>
+#include <Geom2d_BSplineCurve.hxx>
+#include <Geom2d_OffsetCurve.hxx>
+#include <Geom2d_TrimmedCurve.hxx>
+#include <Poly_Polygon3D.hxx>
+#include <Poly_PolygonOnTriangulation.hxx>
+#include <Standard_Version.hxx>
+#include <TDataStd_Name.hxx>
+#include <TDataXtd_Triangulation.hxx>
+#include <TDF_AttributeIterator.hxx>
+#include <TDF_ChildIterator.hxx>
+#include <TDF_LabelNode.hxx>
+#include <TNaming_NamedShape.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <locale>
+#include <sstream>
+
+namespace Mayo {
+
+namespace {
+
+int64_t typeSize(const Handle_Standard_Transient& object)
+{
+    return object ? int64_t(object->DynamicType()->Size()) : 0;
+}
+
+// Poles, weights and knots(with multiplicities)
+template<typename POINT>
+int64_t splineArraysSize(int poleCount, bool isRational, int knotCount)
+{
+    int64_t size = poleCount * int64_t(sizeof(POINT));
+    if (isRational)
+        size += poleCount * int64_t(sizeof(double));
+
+    size += knotCount * int64_t(sizeof(double) + sizeof(int));
+    return size;
+}
+
+} // namespace
+
+int64_t MemoryStats::total() const
+{
+    return this->brepGeometry + this->triangulation + this->ocafData + this->presentation + this->selection;
+}
+
+MemoryStats& MemoryStats::operator+=(const MemoryStats& other)
+{
+    this->brepGeometry += other.brepGeometry;
+    this->triangulation += other.triangulation;
+    this->ocafData += other.ocafData;
+    this->presentation += other.presentation;
+    this->selection += other.selection;
+    return *this;
+}
+
+std::string MemoryStats::toJson() const
+{
+    std::ostringstream ostr;
+    ostr.imbue(std::locale::classic());
+    ostr << "{\"brepGeometry\":" << this->brepGeometry
+         << ",\"triangulation\":" << this->triangulation
+         << ",\"ocafData\":" << this->ocafData
+         << ",\"presentation\":" << this->presentation
+         << ",\"selection\":" << this->selection
+         << ",\"total\":" << this->total()
+         << '}';
+    return ostr.str();
+}
+
+void MemoryAccounting::addShape(const TopoDS_Shape& shape)
+{
+    if (shape.IsNull() || !this->markVisited(shape.TShape().get()))
+        return;
+
+    m_stats.brepGeometry += typeSize(shape.TShape());
+    if (shape.ShapeType() == TopAbs_FACE) {
+        auto tface = Handle_BRep_TFace::DownCast(shape.TShape());
+        this->addSurface(tface->Surface());
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+        for (const Handle_Poly_Triangulation& triangulation : tface->Triangulations())
+            this->addTriangulation(triangulation);
+#else
+        this->addTriangulation(tface->Triangulation());
+#endif
+    }
+    else if (shape.ShapeType() == TopAbs_EDGE) {
+        auto tedge = Handle_BRep_TEdge::DownCast(shape.TShape());
+        for (BRep_ListIteratorOfListOfCurveRepresentation it(tedge->Curves()); it.More(); it.Next()) {
+            const Handle_BRep_CurveRepresentation& curveRep = it.Value();
+            m_stats.brepGeometry += typeSize(curveRep);
+            if (curveRep->IsCurve3D()) {
+                this->addCurve(curveRep->Curve3D());
+            }
+            else if (curveRep->IsCurveOnSurface()) {
+                this->addCurve(curveRep->PCurve());
+                if (curveRep->IsCurveOnClosedSurface())
+                    this->addCurve(curveRep->PCurve2());
+            }
+            else if (curveRep->IsPolygon3D()) {
+                const Handle_Poly_Polygon3D& polygon = curveRep->Polygon3D();
+                if (polygon && this->markVisited(polygon.get()))
+                    m_stats.triangulation += typeSize(polygon) + polygon->NbNodes() * int64_t(sizeof(gp_Pnt));
+            }
+            else if (curveRep->IsPolygonOnTriangulation()) {
+                auto fnAddPolygon = [=](const Handle_Poly_PolygonOnTriangulation& polygon) {
+                    if (polygon && this->markVisited(polygon.get()))
+                        m_stats.triangulation += typeSize(polygon) + polygon->NbNodes() * int64_t(sizeof(int));
+                };
+                fnAddPolygon(curveRep->PolygonOnTriangulation());
+                if (curveRep->IsPolygonOnClosedTriangulation())
+                    fnAddPolygon(curveRep->PolygonOnTriangulation2());
+            }
+        }
+    }
+
+    for (TopoDS_Iterator it(shape, false, false); it.More(); it.Next()) {
+        // List node holding the sub-shape
+        m_stats.brepGeometry += sizeof(TopoDS_Shape) + sizeof(void*);
+        this->addShape(it.Value());
+    }
+}
+
+void MemoryAccounting::addCurve(const Handle_Geom_Curve& curve)
+{
+    if (!this->markVisited(curve.get()))
+        return;
+
+    m_stats.brepGeometry += typeSize(curve);
+    if (auto bspline = Handle_Geom_BSplineCurve::DownCast(curve)) {
+        m_stats.brepGeometry += splineArraysSize<gp_Pnt>(
+                    bspline->NbPoles(), bspline->IsRational(), bspline->NbKnots());
+    }
+    else if (auto bezier = Handle_Geom_BezierCurve::DownCast(curve)) {
+        m_stats.brepGeometry += splineArraysSize<gp_Pnt>(bezier->NbPoles(), bezier->IsRational(), 0);
+    }
+    else if (auto trimmed = Handle_Geom_TrimmedCurve::DownCast(curve)) {
+        this->addCurve(trimmed->BasisCurve());
+    }
+    else if (auto offset = Handle_Geom_OffsetCurve::DownCast(curve)) {
+        this->addCurve(offset->BasisCurve());
+    }
+}
+
+void MemoryAccounting::addCurve(const Handle_Geom2d_Curve& curve)
+{
+    if (!this->markVisited(curve.get()))
+        return;
+
+    m_stats.brepGeometry += typeSize(curve);
+    if (auto bspline = Handle_Geom2d_BSplineCurve::DownCast(curve)) {
+        m_stats.brepGeometry += splineArraysSize<gp_Pnt2d>(
+                    bspline->NbPoles(), bspline->IsRational(), bspline->NbKnots());
+    }
+    else if (auto bezier = Handle_Geom2d_BezierCurve::DownCast(curve)) {
+        m_stats.brepGeometry += splineArraysSize<gp_Pnt2d>(bezier->NbPoles(), bezier->IsRational(), 0);
+    }
+    else if (auto trimmed = Handle_Geom2d_TrimmedCurve::DownCast(curve)) {
+        this->addCurve(trimmed->BasisCurve());
+    }
+    else if (auto offset = Handle_Geom2d_OffsetCurve::DownCast(curve)) {
+        this->addCurve(offset->BasisCurve());
+    }
+}
+
+void MemoryAccounting::addSurface(const Handle_Geom_Surface& surface)
+{
+    if (!this->markVisited(surface.get()))
+        return;
+
+    m_stats.brepGeometry += typeSize(surface);
+    if (auto bspline = Handle_Geom_BSplineSurface::DownCast(surface)) {
+        m_stats.brepGeometry += splineArraysSize<gp_Pnt>(
+                    bspline->NbUPoles() * bspline->NbVPoles(),
+                    bspline->IsURational() || bspline->IsVRational(),
+                    bspline->NbUKnots() + bspline->NbVKnots());
+    }
+    else if (auto bezier = Handle_Geom_BezierSurface::DownCast(surface)) {
+        m_stats.brepGeometry += splineArraysSize<gp_Pnt>(
+                    bezier->NbUPoles() * bezier->NbVPoles(),
+                    bezier->IsURational() || bezier->IsVRational(),
+                    0);
+    }
+    else if (auto trimmed = Handle_Geom_RectangularTrimmedSurface::DownCast(surface)) {
+        this->addSurface(trimmed->BasisSurface());
+    }
+    else if (auto offset = Handle_Geom_OffsetSurface::DownCast(surface)) {
+        this->addSurface(offset->BasisSurface());
+    }
+    else if (auto swept = Handle_Geom_SweptSurface::DownCast(surface)) {
+        this->addCurve(swept->BasisCurve());
+    }
+}
+
+void MemoryAccounting::addTriangulation(const Handle_Poly_Triangulation& triangulation)
+{
+    if (!this->markVisited(triangulation.get()))
+        return;
+
+    const int64_t nodeCount = triangulation->NbNodes();
+    m_stats.triangulation += typeSize(triangulation);
+    m_stats.triangulation += nodeCount * sizeof(gp_Pnt);
+    m_stats.triangulation += triangulation->NbTriangles() * int64_t(sizeof(Poly_Triangle));
+    if (triangulation->HasUVNodes())
+        m_stats.triangulation += nodeCount * sizeof(gp_Pnt2d);
+
+    if (triangulation->HasNormals())
+        m_stats.triangulation += nodeCount * 3 * sizeof(float);
+
+    // Arrays of a compacted triangulation are empty, its compressed data is accounted instead
+    if (m_ptrCompactTriangulations)
+        m_stats.triangulation += m_ptrCompactTriangulations->compressedMemorySize(triangulation);
+}
+
+void MemoryAccounting::addLabel(const TDF_Label& label)
+{
+    if (label.IsNull() || !m_setVisitedLabel.insert(label).second)
+        return;
+
+    m_stats.ocafData += sizeof(TDF_LabelNode);
+    for (TDF_AttributeIterator it(label); it.More(); it.Next()) {
+        const Handle_TDF_Attribute attr = it.Value();
+        m_stats.ocafData += typeSize(attr);
+        if (auto attrNamedShape = Handle_TNaming_NamedShape::DownCast(attr))
+            this->addShape(attrNamedShape->Get());
+        else if (auto attrTriangulation = Handle_TDataXtd_Triangulation::DownCast(attr))
+            this->addTriangulation(attrTriangulation->Get());
+        else if (auto attrName = Handle_TDataStd_Name::DownCast(attr))
+            m_stats.ocafData += attrName->Get().Length() * int64_t(sizeof(Standard_ExtCharacter));
+    }
+
+    for (TDF_ChildIterator it(label); it.More(); it.Next())
+        this->addLabel(it.Value());
+}
+
+void MemoryAccounting::addTreeNode(const DocumentPtr& doc, TreeNodeId nodeId)
+{
+    m_ptrCompactTriangulations = !doc->compactTriangulations().isEmpty() ? &doc->compactTriangulations() : nullptr;
+    const Tree<TDF_Label>& modelTree = doc->modelTree();
+    traverseTree(nodeId, modelTree, [&](TreeNodeId id) {
+        const TDF_Label& label = modelTree.nodeData(id);
+        this->addLabel(label);
+        if (XCaf::isShapeReference(label))
+            this->addLabel(XCaf::shapeReferred(label));
+    });
+    m_ptrCompactTriangulations = nullptr;
+}
+
+void MemoryAccounting::addDocument(const DocumentPtr& doc)
+{
+    for (int i = 0; i < doc->entityCount(); ++i)
+        this->addTreeNode(doc, doc->entityTreeNodeId(i));
+}
+
+} // namespace Mayo
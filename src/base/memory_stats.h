@@ -0,0 +1,79 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "caf_utils.h"
+#include "document_ptr.h"
+#include "libtree.h"
+
+#include <Geom_Curve.hxx>
+#include <Geom_Surface.hxx>
+#include <Geom2d_Curve.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TDF_Label.hxx>
+#include <TopoDS_Shape.hxx>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+
+namespace Mayo {
+
+class CompactTriangulationStore;
+
+// Estimation of memory used by document data, in bytes
+// Sizes are computed from object types and array lengths, allocator overheads are ignored
+struct MemoryStats {
+    int64_t brepGeometry = 0; // Topology(TShape objects) and geometry(curves, surfaces)
+    int64_t triangulation = 0; // Poly_Triangulation nodes/triangles, polygons on triangulation
+    int64_t ocafData = 0; // Labels and attributes, excluding shapes and triangulations
+    int64_t presentation = 0; // Primitive arrays of graphics presentations
+    int64_t selection = 0; // Sensitive entities along with their BVH trees
+
+    int64_t total() const;
+    MemoryStats& operator+=(const MemoryStats& other);
+
+    // Example: {"brepGeometry":1024,"triangulation":2048,"ocafData":512,"presentation":0,
+    //           "selection":0,"total":3584}
+    std::string toJson() const;
+};
+
+// Accumulates memory estimations into a MemoryStats object
+// Data shared by several objects(eg TShape referenced by many instances) is accounted only once,
+// so the usage of a whole document is the sum of its entities visited with the same accounting
+class MemoryAccounting {
+public:
+    const MemoryStats& stats() const { return m_stats; }
+    MemoryStats& stats() { return m_stats; }
+
+    void addShape(const TopoDS_Shape& shape);
+    void addCurve(const Handle_Geom_Curve& curve);
+    void addCurve(const Handle_Geom2d_Curve& curve);
+    void addSurface(const Handle_Geom_Surface& surface);
+    void addTriangulation(const Handle_Poly_Triangulation& triangulation);
+
+    // Attributes of 'label' and of its sub-labels, shapes and triangulations included
+    void addLabel(const TDF_Label& label);
+
+    // Labels of the document tree node and of all its children, including the referred
+    // labels(ie shape products shared by assembly components)
+    void addTreeNode(const DocumentPtr& doc, TreeNodeId nodeId);
+
+    // Adds all the entities of 'doc'
+    // Compressed data of the compacted triangulations is accounted as triangulation memory
+    void addDocument(const DocumentPtr& doc);
+
+    // Returns true if 'ptr' is visited for the first time, ie its memory has to be accounted
+    bool markVisited(const void* ptr) { return ptr && m_setVisited.insert(ptr).second; }
+
+private:
+    MemoryStats m_stats;
+    std::unordered_set<const void*> m_setVisited;
+    std::unordered_set<TDF_Label> m_setVisitedLabel;
+    const CompactTriangulationStore* m_ptrCompactTriangulations = nullptr; // While visiting a document
+};
+
+} // namespace Mayo
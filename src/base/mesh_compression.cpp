@@ -0,0 +1,263 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "mesh_compression.h"
+#include "global.h"
+
+#include <Standard_Version.hxx>
+#include <algorithm>
+#include <cmath>
+
+namespace Mayo {
+
+namespace {
+
+constexpr double QuantizedMax = 65535.;
+
+uint16_t quantized(double value, double valueMin, double step)
+{
+    if (step <= 0.)
+        return 0;
+
+    return uint16_t(std::clamp(std::round((value - valueMin) / step), 0., QuantizedMax));
+}
+
+double quantizedStep(double valueMin, double valueMax)
+{
+    return (valueMax - valueMin) / QuantizedMax;
+}
+
+uint16_t quantizedUnit(double value) // 'value' in [-1,1]
+{
+    return uint16_t(std::clamp(std::round((value + 1.) * 0.5 * QuantizedMax), 0., QuantizedMax));
+}
+
+double unquantizedUnit(uint16_t q)
+{
+    return (q / QuantizedMax) * 2. - 1.;
+}
+
+double signNotNull(double value)
+{
+    return value >= 0. ? 1. : -1.;
+}
+
+// Zigzag mapping of signed integers, so small negative values get short encodings
+uint32_t zigzagEncoded(int32_t value)
+{
+    return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+int32_t zigzagDecoded(uint32_t value)
+{
+    return int32_t(value >> 1) ^ -int32_t(value & 1);
+}
+
+// Little-endian base 128(LEB128)
+void appendVarint(std::vector<uint8_t>* ptrBytes, uint32_t value)
+{
+    while (value >= 0x80) {
+        ptrBytes->push_back(uint8_t(value | 0x80));
+        value >>= 7;
+    }
+
+    ptrBytes->push_back(uint8_t(value));
+}
+
+uint32_t readVarint(const uint8_t** ptrIt)
+{
+    uint32_t value = 0;
+    int shift = 0;
+    uint8_t byte = 0;
+    do {
+        byte = *(*ptrIt)++;
+        value |= uint32_t(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    return value;
+}
+
+} // namespace
+
+int64_t MeshCompression::Data::memorySize() const
+{
+    return int64_t(sizeof(Data))
+            + int64_t(this->vecNode.size() + this->vecUVNode.size() + this->vecNormal.size()) * sizeof(uint16_t)
+            + int64_t(this->vecTriangleBytes.size());
+}
+
+MeshCompression::Data MeshCompression::compress(const Handle_Poly_Triangulation& triangulation)
+{
+    Data data;
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    if (triangulation.IsNull() || triangulation->NbNodes() == 0)
+        return data;
+
+    const int nodeCount = triangulation->NbNodes();
+    const int triangleCount = triangulation->NbTriangles();
+    data.nodeCount = nodeCount;
+    data.triangleCount = triangleCount;
+    data.isDoublePrecision = triangulation->IsDoublePrecision();
+
+    // Nodes
+    gp_XYZ nodeMax = triangulation->Node(1).XYZ();
+    data.nodeMin = nodeMax;
+    for (int i = 2; i <= nodeCount; ++i) {
+        const gp_XYZ node = triangulation->Node(i).XYZ();
+        for (int c = 1; c <= 3; ++c) {
+            data.nodeMin.SetCoord(c, std::min(data.nodeMin.Coord(c), node.Coord(c)));
+            nodeMax.SetCoord(c, std::max(nodeMax.Coord(c), node.Coord(c)));
+        }
+    }
+
+    for (int c = 1; c <= 3; ++c)
+        data.nodeStep.SetCoord(c, quantizedStep(data.nodeMin.Coord(c), nodeMax.Coord(c)));
+
+    data.vecNode.reserve(3 * nodeCount);
+    for (int i = 1; i <= nodeCount; ++i) {
+        const gp_XYZ node = triangulation->Node(i).XYZ();
+        for (int c = 1; c <= 3; ++c)
+            data.vecNode.push_back(quantized(node.Coord(c), data.nodeMin.Coord(c), data.nodeStep.Coord(c)));
+    }
+
+    // UV nodes
+    if (triangulation->HasUVNodes()) {
+        gp_XY uvMax = triangulation->UVNode(1).XY();
+        data.uvMin = uvMax;
+        for (int i = 2; i <= nodeCount; ++i) {
+            const gp_XY uv = triangulation->UVNode(i).XY();
+            data.uvMin.SetCoord(std::min(data.uvMin.X(), uv.X()), std::min(data.uvMin.Y(), uv.Y()));
+            uvMax.SetCoord(std::max(uvMax.X(), uv.X()), std::max(uvMax.Y(), uv.Y()));
+        }
+
+        data.uvStep.SetCoord(quantizedStep(data.uvMin.X(), uvMax.X()), quantizedStep(data.uvMin.Y(), uvMax.Y()));
+        data.vecUVNode.reserve(2 * nodeCount);
+        for (int i = 1; i <= nodeCount; ++i) {
+            const gp_XY uv = triangulation->UVNode(i).XY();
+            data.vecUVNode.push_back(quantized(uv.X(), data.uvMin.X(), data.uvStep.X()));
+            data.vecUVNode.push_back(quantized(uv.Y(), data.uvMin.Y(), data.uvStep.Y()));
+        }
+    }
+
+    // Normals, octahedron projected on plane z=0 then lower half folded over the upper one
+    if (triangulation->HasNormals()) {
+        data.vecNormal.reserve(2 * nodeCount);
+        for (int i = 1; i <= nodeCount; ++i) {
+            gp_Vec3f normal;
+            triangulation->Normal(i, normal);
+            const double sumAbs = std::abs(normal.x()) + std::abs(normal.y()) + std::abs(normal.z());
+            double px = sumAbs > 0. ? normal.x() / sumAbs : 0.;
+            double py = sumAbs > 0. ? normal.y() / sumAbs : 0.;
+            if (normal.z() < 0.f) {
+                const double foldedX = (1. - std::abs(py)) * signNotNull(px);
+                const double foldedY = (1. - std::abs(px)) * signNotNull(py);
+                px = foldedX;
+                py = foldedY;
+            }
+
+            data.vecNormal.push_back(quantizedUnit(px));
+            data.vecNormal.push_back(quantizedUnit(py));
+        }
+    }
+
+    // Triangles, first node is relative to the first node of the previous triangle and the others
+    // are relative to the first node
+    data.vecTriangleBytes.reserve(3 * triangleCount);
+    int prevNode1 = 0;
+    for (int i = 1; i <= triangleCount; ++i) {
+        int n1, n2, n3;
+        triangulation->Triangle(i).Get(n1, n2, n3);
+        appendVarint(&data.vecTriangleBytes, zigzagEncoded(n1 - prevNode1));
+        appendVarint(&data.vecTriangleBytes, zigzagEncoded(n2 - n1));
+        appendVarint(&data.vecTriangleBytes, zigzagEncoded(n3 - n1));
+        prevNode1 = n1;
+    }
+
+    data.vecTriangleBytes.shrink_to_fit();
+#else
+    MAYO_UNUSED(triangulation);
+#endif
+    return data;
+}
+
+void MeshCompression::decompress(const Data& data, const Handle_Poly_Triangulation& triangulation)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    if (triangulation.IsNull() || data.isEmpty())
+        return;
+
+    MeshCompression::releaseArrays(triangulation);
+    // Has to be set before the node arrays are allocated
+    triangulation->SetDoublePrecision(data.isDoublePrecision);
+    triangulation->ResizeNodes(data.nodeCount, false);
+    triangulation->ResizeTriangles(data.triangleCount, false);
+    for (int i = 1; i <= data.nodeCount; ++i) {
+        const uint16_t* q = &data.vecNode.at(3 * (i - 1));
+        triangulation->SetNode(i, gp_Pnt(
+                                   data.nodeMin.X() + q[0] * data.nodeStep.X(),
+                                   data.nodeMin.Y() + q[1] * data.nodeStep.Y(),
+                                   data.nodeMin.Z() + q[2] * data.nodeStep.Z()));
+    }
+
+    if (!data.vecUVNode.empty()) {
+        triangulation->AddUVNodes();
+        for (int i = 1; i <= data.nodeCount; ++i) {
+            const uint16_t* q = &data.vecUVNode.at(2 * (i - 1));
+            triangulation->SetUVNode(i, gp_Pnt2d(
+                                         data.uvMin.X() + q[0] * data.uvStep.X(),
+                                         data.uvMin.Y() + q[1] * data.uvStep.Y()));
+        }
+    }
+
+    if (!data.vecNormal.empty()) {
+        triangulation->AddNormals();
+        for (int i = 1; i <= data.nodeCount; ++i) {
+            const uint16_t* q = &data.vecNormal.at(2 * (i - 1));
+            double x = unquantizedUnit(q[0]);
+            double y = unquantizedUnit(q[1]);
+            const double z = 1. - std::abs(x) - std::abs(y);
+            if (z < 0.) {
+                const double unfoldedX = (1. - std::abs(y)) * signNotNull(x);
+                const double unfoldedY = (1. - std::abs(x)) * signNotNull(y);
+                x = unfoldedX;
+                y = unfoldedY;
+            }
+
+            const double length = std::sqrt(x * x + y * y + z * z);
+            triangulation->SetNormal(i, gp_Vec3f(float(x / length), float(y / length), float(z / length)));
+        }
+    }
+
+    const uint8_t* itByte = data.vecTriangleBytes.data();
+    int prevNode1 = 0;
+    for (int i = 1; i <= data.triangleCount; ++i) {
+        const int n1 = prevNode1 + zigzagDecoded(readVarint(&itByte));
+        const int n2 = n1 + zigzagDecoded(readVarint(&itByte));
+        const int n3 = n1 + zigzagDecoded(readVarint(&itByte));
+        triangulation->SetTriangle(i, Poly_Triangle(n1, n2, n3));
+        prevNode1 = n1;
+    }
+#else
+    MAYO_UNUSED(data);
+    MAYO_UNUSED(triangulation);
+#endif
+}
+
+void MeshCompression::releaseArrays(const Handle_Poly_Triangulation& triangulation)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    if (triangulation.IsNull())
+        return;
+
+    // Deflection and mesh purpose are kept
+    triangulation->Clear();
+#else
+    MAYO_UNUSED(triangulation);
+#endif
+}
+
+} // namespace Mayo
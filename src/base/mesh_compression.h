@@ -0,0 +1,54 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <Poly_Triangulation.hxx>
+#include <gp_XY.hxx>
+#include <gp_XYZ.hxx>
+#include <cstdint>
+#include <vector>
+
+namespace Mayo {
+
+// Lossy compact encoding of the arrays of a Poly_Triangulation, meant to keep in memory the meshes
+// which aren't currently used(eg meshes of hidden shapes):
+//   - node coordinates are quantized to 16 bits within the bounding box of the nodes, and so are
+//     UV nodes within their bounds
+//   - normals are octahedral encoded on 2x16 bits
+//   - node indices of a triangle are delta encoded and stored as variable-length integers
+// Requires OpenCascade >= v7.6.0(resizable triangulation arrays), does nothing otherwise
+struct MeshCompression {
+    struct Data {
+        int nodeCount = 0;
+        int triangleCount = 0;
+        bool isDoublePrecision = true;
+        // Decoded node is 'nodeMin + q*nodeStep' where 'q' is the quantized coordinates
+        gp_XYZ nodeMin;
+        gp_XYZ nodeStep;
+        gp_XY uvMin;
+        gp_XY uvStep;
+        std::vector<uint16_t> vecNode; // 3 items per node
+        std::vector<uint16_t> vecUVNode; // 2 items per node, empty if no UV nodes
+        std::vector<uint16_t> vecNormal; // 2 items per node, empty if no normals
+        std::vector<uint8_t> vecTriangleBytes;
+
+        bool isEmpty() const { return this->nodeCount == 0; }
+        int64_t memorySize() const;
+    };
+
+    static Data compress(const Handle_Poly_Triangulation& triangulation);
+
+    // Allocates the arrays of 'triangulation' and fills them from 'data', attributes not encoded
+    // (eg deflection) are left unchanged
+    static void decompress(const Data& data, const Handle_Poly_Triangulation& triangulation);
+
+    // Releases the arrays of 'triangulation'(nodes, triangles, UV nodes and normals), so once
+    // compressed it keeps its identity(eg for polygons on triangulation) but no longer its data
+    static void releaseArrays(const Handle_Poly_Triangulation& triangulation);
+};
+
+} // namespace Mayo
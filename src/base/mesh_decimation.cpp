@@ -0,0 +1,490 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "mesh_decimation.h"
+
+#include "cpp_utils.h"
+#include "task_progress.h"
+
+#include <gp_XYZ.hxx>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+namespace Mayo {
+
+namespace {
+
+// Symmetric 4x4 matrix of a quadric, stored as its 10 distinct coefficients
+class Quadric {
+public:
+    Quadric() = default;
+
+    // Fundamental error quadric of plane a*x + b*y + c*z + d = 0
+    Quadric(double a, double b, double c, double d)
+        : m{ a*a, a*b, a*c, a*d, b*b, b*c, b*d, c*c, c*d, d*d }
+    {}
+
+    Quadric operator+(const Quadric& other) const {
+        Quadric q;
+        for (int i = 0; i < 10; ++i)
+            q.m[i] = m[i] + other.m[i];
+
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& other) {
+        for (int i = 0; i < 10; ++i)
+            m[i] += other.m[i];
+
+        return *this;
+    }
+
+    // Determinant of the 3x3 matrix made of the coefficients at the specified indices
+    double det(int a11, int a12, int a13, int a21, int a22, int a23, int a31, int a32, int a33) const {
+        return m[a11]*m[a22]*m[a33] + m[a13]*m[a21]*m[a32] + m[a12]*m[a23]*m[a31]
+                - m[a13]*m[a22]*m[a31] - m[a11]*m[a23]*m[a32] - m[a12]*m[a21]*m[a33];
+    }
+
+    // Sum of squared distances from 'p' to the planes of the quadric
+    double error(const gp_XYZ& p) const {
+        const double x = p.X();
+        const double y = p.Y();
+        const double z = p.Z();
+        return m[0]*x*x + 2*m[1]*x*y + 2*m[2]*x*z + 2*m[3]*x
+                + m[4]*y*y + 2*m[5]*y*z + 2*m[6]*y
+                + m[7]*z*z + 2*m[8]*z
+                + m[9];
+    }
+
+private:
+    double m[10] = {};
+};
+
+// Normalizes 'v' in place, returns false if 'v' is too small
+bool normalize(gp_XYZ* v)
+{
+    const double length = v->Modulus();
+    if (length <= 1e-300)
+        return false;
+
+    v->Divide(length);
+    return true;
+}
+
+class Decimator {
+public:
+    Decimator(const Poly_Triangulation& mesh, const MeshDecimation::Parameters& params)
+        : m_params(params)
+    {
+        m_vecVertex.resize(mesh.NbNodes());
+        for (int i = 0; i < mesh.NbNodes(); ++i)
+            m_vecVertex[i].p = mesh.Node(i + 1).XYZ();
+
+        const Poly_Array1OfTriangle& vecTriangle = mesh.Triangles();
+        m_vecTriangle.reserve(mesh.NbTriangles());
+        for (int i = 0; i < mesh.NbTriangles(); ++i) {
+            int n1, n2, n3;
+            vecTriangle.Value(i + 1).Get(n1, n2, n3);
+            if (n1 == n2 || n2 == n3 || n3 == n1)
+                continue; // Skip degenerated triangle
+
+            Triangle triangle;
+            triangle.v[0] = n1 - 1;
+            triangle.v[1] = n2 - 1;
+            triangle.v[2] = n3 - 1;
+            m_vecTriangle.push_back(triangle);
+        }
+    }
+
+    void run(TaskProgress* progress);
+    Handle_Poly_Triangulation result() const;
+
+private:
+    struct Vertex {
+        gp_XYZ p;
+        Quadric q;
+        int refBegin = 0;
+        int refCount = 0;
+        bool isBorder = false;
+    };
+
+    struct Triangle {
+        int v[3];
+        double err[4]; // Errors of the three edges, then the minimum of them
+        gp_XYZ normal;
+        bool isDeleted = false;
+        bool isDirty = false;
+    };
+
+    // Reference from a vertex to one of its triangles
+    struct Ref {
+        int iTriangle;
+        int iCorner; // Index of the vertex in the triangle
+    };
+
+    void updateMesh(int iteration);
+    double collapseError(int iVertex1, int iVertex2, gp_XYZ* ptrResult) const;
+    bool isFlipped(const gp_XYZ& p, int i1, const Vertex& v0, std::vector<bool>* ptrVecDeleted) const;
+    void updateTriangles(int i0, const Vertex& v, const std::vector<bool>& vecDeleted);
+
+    MeshDecimation::Parameters m_params;
+    std::vector<Vertex> m_vecVertex;
+    std::vector<Triangle> m_vecTriangle;
+    std::vector<Ref> m_vecRef;
+    int m_deletedTriangleCount = 0;
+};
+
+void Decimator::run(TaskProgress* progress)
+{
+    const int triangleCount = int(m_vecTriangle.size());
+    const int targetCount = std::max(int(std::round(triangleCount * m_params.targetRatio)), 1);
+    std::vector<bool> vecDeleted0;
+    std::vector<bool> vecDeleted1;
+    m_deletedTriangleCount = 0;
+    // Aggressiveness of the error threshold growth, lower values give better quality but need
+    // more iterations
+    constexpr double aggressiveness = 7.;
+    constexpr int maxIterationCount = 100;
+    for (int iteration = 0; iteration < maxIterationCount; ++iteration) {
+        if (triangleCount - m_deletedTriangleCount <= targetCount)
+            break;
+
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        if (progress) {
+            const int pct = (m_deletedTriangleCount * 100) / std::max(triangleCount - targetCount, 1);
+            progress->setValue(pct);
+        }
+
+        // Deleted triangles are purged from time to time
+        if (iteration % 5 == 0)
+            this->updateMesh(iteration);
+
+        for (Triangle& triangle : m_vecTriangle)
+            triangle.isDirty = false;
+
+        // Edges whose error is below the threshold are collapsed, threshold grows at each iteration
+        const double threshold = 1e-9 * std::pow(double(iteration + 3), aggressiveness);
+        if (m_params.maxError > 0 && threshold > m_params.maxError)
+            break;
+
+        for (Triangle& triangle : m_vecTriangle) {
+            if (triangle.err[3] > threshold || triangle.isDeleted || triangle.isDirty)
+                continue;
+
+            for (int j = 0; j < 3; ++j) {
+                if (triangle.err[j] >= threshold)
+                    continue;
+
+                const int i0 = triangle.v[j];
+                const int i1 = triangle.v[(j + 1) % 3];
+                Vertex& v0 = m_vecVertex[i0];
+                const Vertex& v1 = m_vecVertex[i1];
+                if (m_params.preserveBorders ? (v0.isBorder || v1.isBorder) : (v0.isBorder != v1.isBorder))
+                    continue;
+
+                gp_XYZ p;
+                this->collapseError(i0, i1, &p);
+                vecDeleted0.resize(v0.refCount);
+                vecDeleted1.resize(v1.refCount);
+                if (this->isFlipped(p, i1, v0, &vecDeleted0) || this->isFlipped(p, i0, v1, &vecDeleted1))
+                    continue;
+
+                // Collapse edge v0-v1 into v0
+                v0.p = p;
+                v0.q += v1.q;
+                const int refBegin = int(m_vecRef.size());
+                this->updateTriangles(i0, v0, vecDeleted0);
+                this->updateTriangles(i0, v1, vecDeleted1);
+                const int refCount = int(m_vecRef.size()) - refBegin;
+                if (refCount <= v0.refCount) {
+                    // Reuse the reference slots of v0
+                    std::copy(m_vecRef.begin() + refBegin, m_vecRef.end(), m_vecRef.begin() + v0.refBegin);
+                    m_vecRef.resize(refBegin);
+                }
+                else {
+                    v0.refBegin = refBegin;
+                }
+
+                v0.refCount = refCount;
+                break;
+            }
+
+            if (triangleCount - m_deletedTriangleCount <= targetCount)
+                break;
+        }
+    }
+}
+
+Handle_Poly_Triangulation Decimator::result() const
+{
+    std::vector<int> vecNewVertexIndex(m_vecVertex.size(), -1);
+    int triangleCount = 0;
+    int vertexCount = 0;
+    for (const Triangle& triangle : m_vecTriangle) {
+        if (triangle.isDeleted)
+            continue;
+
+        ++triangleCount;
+        for (int iVertex : triangle.v) {
+            if (vecNewVertexIndex[iVertex] < 0)
+                vecNewVertexIndex[iVertex] = vertexCount++;
+        }
+    }
+
+    Handle_Poly_Triangulation mesh = new Poly_Triangulation(vertexCount, triangleCount, false);
+    TColgp_Array1OfPnt& vecNode = mesh->ChangeNodes();
+    for (int i = 0; i < int(m_vecVertex.size()); ++i) {
+        if (vecNewVertexIndex[i] >= 0)
+            vecNode.ChangeValue(vecNewVertexIndex[i] + 1) = gp_Pnt(m_vecVertex[i].p);
+    }
+
+    Poly_Array1OfTriangle& vecTriangle = mesh->ChangeTriangles();
+    int iTriangle = 1;
+    for (const Triangle& triangle : m_vecTriangle) {
+        if (!triangle.isDeleted) {
+            vecTriangle.ChangeValue(iTriangle++).Set(
+                        vecNewVertexIndex[triangle.v[0]] + 1,
+                        vecNewVertexIndex[triangle.v[1]] + 1,
+                        vecNewVertexIndex[triangle.v[2]] + 1);
+        }
+    }
+
+    return mesh;
+}
+
+void Decimator::updateMesh(int iteration)
+{
+    if (iteration > 0) {
+        auto itEnd = std::remove_if(
+                    m_vecTriangle.begin(), m_vecTriangle.end(), [](const Triangle& triangle) {
+            return triangle.isDeleted;
+        });
+        m_vecTriangle.erase(itEnd, m_vecTriangle.end());
+        m_deletedTriangleCount = 0;
+    }
+
+    // Initial quadrics are the sums of the plane quadrics of the triangles around each vertex
+    if (iteration == 0) {
+        for (Triangle& triangle : m_vecTriangle) {
+            const gp_XYZ& p0 = m_vecVertex[triangle.v[0]].p;
+            const gp_XYZ& p1 = m_vecVertex[triangle.v[1]].p;
+            const gp_XYZ& p2 = m_vecVertex[triangle.v[2]].p;
+            gp_XYZ normal = (p1 - p0).Crossed(p2 - p0);
+            normalize(&normal);
+            triangle.normal = normal;
+            const Quadric q(normal.X(), normal.Y(), normal.Z(), -normal.Dot(p0));
+            for (int iVertex : triangle.v)
+                m_vecVertex[iVertex].q += q;
+        }
+
+        for (Triangle& triangle : m_vecTriangle) {
+            gp_XYZ p;
+            for (int j = 0; j < 3; ++j)
+                triangle.err[j] = this->collapseError(triangle.v[j], triangle.v[(j + 1) % 3], &p);
+
+            triangle.err[3] = std::min({ triangle.err[0], triangle.err[1], triangle.err[2] });
+        }
+    }
+
+    // Rebuild references from vertices to triangles
+    for (Vertex& vertex : m_vecVertex) {
+        vertex.refBegin = 0;
+        vertex.refCount = 0;
+    }
+
+    for (const Triangle& triangle : m_vecTriangle) {
+        for (int iVertex : triangle.v)
+            ++m_vecVertex[iVertex].refCount;
+    }
+
+    int refBegin = 0;
+    for (Vertex& vertex : m_vecVertex) {
+        vertex.refBegin = refBegin;
+        refBegin += vertex.refCount;
+        vertex.refCount = 0;
+    }
+
+    m_vecRef.resize(m_vecTriangle.size() * 3);
+    for (int i = 0; i < int(m_vecTriangle.size()); ++i) {
+        const Triangle& triangle = m_vecTriangle[i];
+        for (int j = 0; j < 3; ++j) {
+            Vertex& vertex = m_vecVertex[triangle.v[j]];
+            m_vecRef[vertex.refBegin + vertex.refCount] = { i, j };
+            ++vertex.refCount;
+        }
+    }
+
+    // Border vertices have at least one neighbor vertex shared by a single triangle
+    if (iteration == 0) {
+        std::vector<int> vecNeighborCount;
+        std::vector<int> vecNeighborId;
+        for (const Vertex& vertex : m_vecVertex) {
+            vecNeighborCount.clear();
+            vecNeighborId.clear();
+            for (int k = 0; k < vertex.refCount; ++k) {
+                const Triangle& triangle = m_vecTriangle[m_vecRef[vertex.refBegin + k].iTriangle];
+                for (int iVertex : triangle.v) {
+                    auto itFound = std::find(vecNeighborId.begin(), vecNeighborId.end(), iVertex);
+                    if (itFound == vecNeighborId.end()) {
+                        vecNeighborId.push_back(iVertex);
+                        vecNeighborCount.push_back(1);
+                    }
+                    else {
+                        ++vecNeighborCount[itFound - vecNeighborId.begin()];
+                    }
+                }
+            }
+
+            for (int j = 0; j < int(vecNeighborId.size()); ++j) {
+                if (vecNeighborCount[j] == 1)
+                    m_vecVertex[vecNeighborId[j]].isBorder = true;
+            }
+        }
+    }
+}
+
+double Decimator::collapseError(int iVertex1, int iVertex2, gp_XYZ* ptrResult) const
+{
+    const Vertex& v1 = m_vecVertex[iVertex1];
+    const Vertex& v2 = m_vecVertex[iVertex2];
+    const Quadric q = v1.q + v2.q;
+    const bool isBorder = v1.isBorder && v2.isBorder;
+    const double det = q.det(0, 1, 2, 1, 4, 5, 2, 5, 7);
+    if (std::abs(det) > 1e-12 && !isBorder) {
+        // Optimal position is the minimum of the quadric
+        *ptrResult = gp_XYZ(
+                    -1 / det * q.det(1, 2, 3, 4, 5, 6, 5, 7, 8),
+                    1 / det * q.det(0, 2, 3, 1, 5, 6, 2, 7, 8),
+                    -1 / det * q.det(0, 1, 3, 1, 4, 6, 2, 5, 8));
+        return q.error(*ptrResult);
+    }
+
+    // Singular quadric: best of end points and middle
+    const gp_XYZ pMiddle = (v1.p + v2.p) / 2.;
+    const double error1 = q.error(v1.p);
+    const double error2 = q.error(v2.p);
+    const double error3 = q.error(pMiddle);
+    const double error = std::min({ error1, error2, error3 });
+    if (error == error1)
+        *ptrResult = v1.p;
+    else if (error == error2)
+        *ptrResult = v2.p;
+    else
+        *ptrResult = pMiddle;
+
+    return error;
+}
+
+// Checks if moving vertex 'v0' to 'p' would flip or degenerate one of its triangles
+// Triangles shared with vertex 'i1' are flagged in 'ptrVecDeleted', they vanish with the collapse
+bool Decimator::isFlipped(
+        const gp_XYZ& p, int i1, const Vertex& v0, std::vector<bool>* ptrVecDeleted) const
+{
+    for (int k = 0; k < v0.refCount; ++k) {
+        const Ref& ref = m_vecRef[v0.refBegin + k];
+        const Triangle& triangle = m_vecTriangle[ref.iTriangle];
+        if (triangle.isDeleted)
+            continue;
+
+        const int id1 = triangle.v[(ref.iCorner + 1) % 3];
+        const int id2 = triangle.v[(ref.iCorner + 2) % 3];
+        if (id1 == i1 || id2 == i1) {
+            (*ptrVecDeleted)[k] = true;
+            continue;
+        }
+
+        gp_XYZ d1 = m_vecVertex[id1].p - p;
+        gp_XYZ d2 = m_vecVertex[id2].p - p;
+        if (!normalize(&d1) || !normalize(&d2))
+            return true;
+
+        if (std::abs(d1.Dot(d2)) > 0.999)
+            return true;
+
+        gp_XYZ normal = d1.Crossed(d2);
+        normalize(&normal);
+        (*ptrVecDeleted)[k] = false;
+        if (normal.Dot(triangle.normal) < 0.2)
+            return true;
+    }
+
+    return false;
+}
+
+// Makes the triangles of 'v' refer to vertex 'i0' and appends their references, or deletes them
+// if flagged in 'vecDeleted'
+void Decimator::updateTriangles(int i0, const Vertex& v, const std::vector<bool>& vecDeleted)
+{
+    for (int k = 0; k < v.refCount; ++k) {
+        const Ref ref = m_vecRef[v.refBegin + k];
+        Triangle& triangle = m_vecTriangle[ref.iTriangle];
+        if (triangle.isDeleted)
+            continue;
+
+        if (vecDeleted[k]) {
+            triangle.isDeleted = true;
+            ++m_deletedTriangleCount;
+            continue;
+        }
+
+        triangle.v[ref.iCorner] = i0;
+        triangle.isDirty = true;
+        gp_XYZ p;
+        for (int j = 0; j < 3; ++j)
+            triangle.err[j] = this->collapseError(triangle.v[j], triangle.v[(j + 1) % 3], &p);
+
+        triangle.err[3] = std::min({ triangle.err[0], triangle.err[1], triangle.err[2] });
+        m_vecRef.push_back(ref);
+    }
+}
+
+} // namespace
+
+Handle_Poly_Triangulation MeshDecimation::decimated(
+        const Handle_Poly_Triangulation& mesh, const Parameters& params, TaskProgress* progress)
+{
+    if (!mesh || mesh->NbTriangles() < 2 || params.targetRatio >= 1.)
+        return mesh;
+
+    Decimator decimator(*mesh, params);
+    decimator.run(progress);
+    if (TaskProgress::isAbortRequested(progress))
+        return mesh;
+
+    Handle_Poly_Triangulation result = decimator.result();
+    result->Deflection(mesh->Deflection());
+    return result;
+}
+
+std::vector<Handle_Poly_Triangulation> MeshDecimation::decimated(
+        Span<const Handle_Poly_Triangulation> spanMesh, const Parameters& params, TaskProgress* progress)
+{
+    const int meshCount = int(spanMesh.size());
+    std::vector<Handle_Poly_Triangulation> vecResult(spanMesh.begin(), spanMesh.end());
+    std::atomic<int> doneCount = 0;
+    std::mutex mutexProgress;
+    CppUtils::parallelFor(meshCount, [&](int i) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        vecResult.at(i) = MeshDecimation::decimated(spanMesh[i], params);
+        const int count = ++doneCount;
+        if (progress) {
+            std::lock_guard<std::mutex> lock(mutexProgress);
+            const int pct = (count * 100) / meshCount;
+            if (pct > progress->value())
+                progress->setValue(pct);
+        }
+    });
+
+    return vecResult;
+}
+
+} // namespace Mayo
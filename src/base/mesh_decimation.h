@@ -0,0 +1,44 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "span.h"
+#include <Poly_Triangulation.hxx>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Mesh simplification by iterative edge collapses, ordered by quadric error metric(Garland-Heckbert)
+struct MeshDecimation {
+    struct Parameters {
+        // Targeted count of triangles relative to the input count, in ]0,1]
+        double targetRatio = 0.5;
+        // Maximum quadric error(squared distance) of a collapse, ignored if <= 0
+        // Decimation stops before reaching 'targetRatio' if no collapse satisfies this bound
+        double maxError = 0.;
+        // Nodes on open borders are kept, so adjacent meshes(eg faces of a shape) stay connected
+        bool preserveBorders = true;
+    };
+
+    // Returns the decimated copy of 'mesh', or 'mesh' itself if there's nothing to decimate
+    // Normals and UV coordinates aren't kept
+    static Handle_Poly_Triangulation decimated(
+            const Handle_Poly_Triangulation& mesh,
+            const Parameters& params,
+            TaskProgress* progress = nullptr);
+
+    // Same as decimated() but for multiple independent meshes, processed concurrently
+    // Returned array has the same size and order as 'spanMesh'
+    static std::vector<Handle_Poly_Triangulation> decimated(
+            Span<const Handle_Poly_Triangulation> spanMesh,
+            const Parameters& params,
+            TaskProgress* progress = nullptr);
+};
+
+} // namespace Mayo
@@ -0,0 +1,52 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "mesh_node_colors.h"
+
+#include <TDataStd_IntegerArray.hxx>
+
+namespace Mayo {
+
+const Standard_GUID& MeshNodeColors::attributeId()
+{
+    static const Standard_GUID guid("6c5ab1c2-3f0e-4b4a-9d5e-2a8f7e61c0d4");
+    return guid;
+}
+
+void MeshNodeColors::set(const TDF_Label& label, Span<const uint32_t> spanRgb)
+{
+    label.ForgetAttribute(MeshNodeColors::attributeId());
+    if (spanRgb.empty())
+        return;
+
+    const int count = int(spanRgb.size());
+    Handle_TDataStd_IntegerArray attr = TDataStd_IntegerArray::Set(label, MeshNodeColors::attributeId(), 1, count);
+    TColStd_Array1OfInteger& array = attr->Array()->ChangeArray1();
+    for (int i = 0; i < count; ++i)
+        array.ChangeValue(i + 1) = int(spanRgb[i] & 0xFFFFFF);
+}
+
+std::vector<uint32_t> MeshNodeColors::get(const TDF_Label& label)
+{
+    Handle_TDataStd_IntegerArray attr;
+    if (!label.FindAttribute(MeshNodeColors::attributeId(), attr) || attr->Array().IsNull())
+        return {};
+
+    const TColStd_Array1OfInteger& array = attr->Array()->Array1();
+    std::vector<uint32_t> vecRgb;
+    vecRgb.reserve(array.Length());
+    for (int i = array.Lower(); i <= array.Upper(); ++i)
+        vecRgb.push_back(uint32_t(array.Value(i)));
+
+    return vecRgb;
+}
+
+bool MeshNodeColors::has(const TDF_Label& label)
+{
+    return label.IsAttribute(MeshNodeColors::attributeId());
+}
+
+} // namespace Mayo
@@ -0,0 +1,40 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "span.h"
+
+#include <Standard_GUID.hxx>
+#include <TDF_Label.hxx>
+#include <cstdint>
+#include <vector>
+
+namespace Mayo {
+
+// Colors at the nodes of a mesh entity(TDataXtd_Triangulation attribute), which Poly_Triangulation
+// can't store itself
+// Colors are packed as 0xRRGGBB values, index 0 is for the first node of the triangulation. They
+// are stored in a TDataStd_IntegerArray attribute of the entity label, identified by attributeId()
+struct MeshNodeColors {
+    static const Standard_GUID& attributeId();
+
+    static uint32_t packRgb(uint8_t r, uint8_t g, uint8_t b) {
+        return (uint32_t(r) << 16) | (uint32_t(g) << 8) | uint32_t(b);
+    }
+    static uint8_t red(uint32_t rgb) { return uint8_t(rgb >> 16); }
+    static uint8_t green(uint32_t rgb) { return uint8_t(rgb >> 8); }
+    static uint8_t blue(uint32_t rgb) { return uint8_t(rgb); }
+
+    // Replaces the node colors of 'label', removes them if 'spanRgb' is empty
+    static void set(const TDF_Label& label, Span<const uint32_t> spanRgb);
+
+    // Returns empty array if 'label' has no node colors
+    static std::vector<uint32_t> get(const TDF_Label& label);
+    static bool has(const TDF_Label& label);
+};
+
+} // namespace Mayo
@@ -0,0 +1,268 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "mesh_quality_analysis.h"
+#include "brep_utils.h"
+#include "cpp_utils.h"
+#include "mesh_utils.h"
+
+#include <BRep_Tool.hxx>
+#include <Standard_Real.hxx>
+#include <TopoDS_Face.hxx>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+
+namespace Mayo {
+
+namespace {
+
+// Count of triangles checked at once by a worker thread
+constexpr int QualityChunkTriangleCount = 4096;
+
+struct ChunkReport {
+    int degenerateCount = 0;
+    int sliverCount = 0;
+    std::array<int, MeshQualityAnalysis::AspectRatioClassCount> aspectRatioHistogram = {};
+    double maxAspectRatio = 0.;
+};
+
+int aspectRatioClass(double ratio)
+{
+    const auto& bounds = MeshQualityAnalysis::AspectRatioClassBounds;
+    return int(std::upper_bound(std::begin(bounds), std::end(bounds), ratio) - std::begin(bounds));
+}
+
+// Node ids outside the triangulation are ignored by MeshUtils::edgeSides(), such triangles are
+// reported as degenerate
+bool hasValidNodes(const Poly_Triangulation& triangulation, int n1, int n2, int n3)
+{
+    const int nodeCount = triangulation.NbNodes();
+    auto fnIsValid = [=](int nodeId) { return 1 <= nodeId && nodeId <= nodeCount; };
+    return fnIsValid(n1) && fnIsValid(n2) && fnIsValid(n3);
+}
+
+// Checks shape of the triangles, 'vecProblem' gets 1 at the index of offending triangles
+std::vector<ChunkReport> checkTriangles(
+        const Poly_Triangulation& triangulation,
+        const MeshQualityAnalysis::Parameters& params,
+        std::vector<char>* ptrVecProblem)
+{
+    const int triangleCount = triangulation.NbTriangles();
+    const Poly_Array1OfTriangle& vecTriangle = triangulation.Triangles();
+    const int chunkCount = (triangleCount + QualityChunkTriangleCount - 1) / QualityChunkTriangleCount;
+    std::vector<ChunkReport> vecChunkReport(chunkCount);
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        ChunkReport& chunkReport = vecChunkReport.at(iChunk);
+        const int iBegin = iChunk * QualityChunkTriangleCount;
+        const int iEnd = std::min(iBegin + QualityChunkTriangleCount, triangleCount);
+        for (int i = iBegin; i < iEnd; ++i) {
+            int n1, n2, n3;
+            vecTriangle.Value(i + 1).Get(n1, n2, n3);
+            const double ratio =
+                    n1 != n2 && n2 != n3 && n3 != n1 && hasValidNodes(triangulation, n1, n2, n3) ?
+                        MeshQualityAnalysis::triangleAspectRatio(
+                            triangulation.Node(n1).XYZ(), triangulation.Node(n2).XYZ(), triangulation.Node(n3).XYZ()) :
+                        RealLast();
+            if (ratio == RealLast()) {
+                ++chunkReport.degenerateCount;
+                (*ptrVecProblem)[i] = 1;
+                continue;
+            }
+
+            ++chunkReport.aspectRatioHistogram[aspectRatioClass(ratio)];
+            chunkReport.maxAspectRatio = std::max(chunkReport.maxAspectRatio, ratio);
+            if (ratio > params.sliverAspectRatio) {
+                ++chunkReport.sliverCount;
+                (*ptrVecProblem)[i] = 1;
+            }
+        }
+    });
+
+    return vecChunkReport;
+}
+
+// Classifies the edges of the triangles, triangles along non-manifold and inconsistent edges are
+// added to 'vecProblem'
+void checkEdges(const Handle_Poly_Triangulation& triangulation, MeshQualityAnalysis::Report* report, std::vector<char>* ptrVecProblem)
+{
+    const MeshUtils::EdgeSides edgeSides = MeshUtils::edgeSides(triangulation);
+    struct ChunkResult {
+        int boundaryCount = 0;
+        int nonManifoldCount = 0;
+        int inconsistentCount = 0;
+        std::vector<int> vecProblemTriangle;
+    };
+    const int edgeCount = edgeSides.edgeCount();
+    const int chunkCount = (edgeCount + QualityChunkTriangleCount - 1) / QualityChunkTriangleCount;
+    std::vector<ChunkResult> vecChunkResult(chunkCount);
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        ChunkResult& result = vecChunkResult.at(iChunk);
+        const int iBegin = iChunk * QualityChunkTriangleCount;
+        const int iEnd = std::min(iBegin + QualityChunkTriangleCount, edgeCount);
+        for (int iEdge = iBegin; iEdge < iEnd; ++iEdge) {
+            const Span<const MeshUtils::TriangleSide> spanSide = edgeSides.sidesOfEdge(iEdge);
+            const bool isNonManifold = spanSide.size() > 2;
+            // Neighbour triangles with consistent orientation run their common edge in opposite directions
+            const bool isInconsistent = spanSide.size() == 2 && spanSide[0].reversed == spanSide[1].reversed;
+            result.boundaryCount += spanSide.size() == 1 ? 1 : 0;
+            result.nonManifoldCount += isNonManifold ? 1 : 0;
+            result.inconsistentCount += isInconsistent ? 1 : 0;
+            if (isNonManifold || isInconsistent) {
+                for (const MeshUtils::TriangleSide& side : spanSide)
+                    result.vecProblemTriangle.push_back(side.triangle);
+            }
+        }
+    });
+
+    for (const ChunkResult& result : vecChunkResult) {
+        report->boundaryEdgeCount += result.boundaryCount;
+        report->nonManifoldEdgeCount += result.nonManifoldCount;
+        report->inconsistentEdgeCount += result.inconsistentCount;
+        for (int iTriangle : result.vecProblemTriangle)
+            (*ptrVecProblem)[iTriangle] = 1;
+    }
+}
+
+// Nodes falling in the same cell of a grid whose cell size is 'tolerance' are duplicates
+int countDuplicateNodes(const Poly_Triangulation& triangulation, double tolerance)
+{
+    using CellKey = std::tuple<int64_t, int64_t, int64_t>;
+    const int nodeCount = triangulation.NbNodes();
+    std::vector<CellKey> vecNodeCell(nodeCount);
+    const double invTolerance = 1. / std::max(tolerance, Precision::Confusion());
+    auto fnCellCoord = [=](double v) { return int64_t(std::floor(v * invTolerance)); };
+    const int chunkCount = (nodeCount + QualityChunkTriangleCount - 1) / QualityChunkTriangleCount;
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        const int iBegin = iChunk * QualityChunkTriangleCount;
+        const int iEnd = std::min(iBegin + QualityChunkTriangleCount, nodeCount);
+        for (int i = iBegin; i < iEnd; ++i) {
+            const gp_XYZ coords = triangulation.Node(i + 1).XYZ();
+            vecNodeCell[i] = { fnCellCoord(coords.X()), fnCellCoord(coords.Y()), fnCellCoord(coords.Z()) };
+        }
+    });
+
+    std::sort(vecNodeCell.begin(), vecNodeCell.end());
+    int duplicateCount = 0;
+    for (size_t i = 1; i < vecNodeCell.size(); ++i)
+        duplicateCount += vecNodeCell.at(i) == vecNodeCell.at(i - 1) ? 1 : 0;
+
+    return duplicateCount;
+}
+
+void mergeReport(MeshQualityAnalysis::Report* target, const MeshQualityAnalysis::Report& report)
+{
+    target->nodeCount += report.nodeCount;
+    target->triangleCount += report.triangleCount;
+    target->degenerateTriangleCount += report.degenerateTriangleCount;
+    target->sliverTriangleCount += report.sliverTriangleCount;
+    target->nonManifoldEdgeCount += report.nonManifoldEdgeCount;
+    target->inconsistentEdgeCount += report.inconsistentEdgeCount;
+    for (int i = 0; i < MeshQualityAnalysis::AspectRatioClassCount; ++i)
+        target->aspectRatioHistogram[i] += report.aspectRatioHistogram[i];
+
+    target->maxAspectRatio = std::max(target->maxAspectRatio, report.maxAspectRatio);
+    target->vecProblemTriangle.insert(
+                target->vecProblemTriangle.end(),
+                report.vecProblemTriangle.cbegin(),
+                report.vecProblemTriangle.cend());
+}
+
+} // namespace
+
+bool MeshQualityAnalysis::Report::hasProblems() const
+{
+    return this->degenerateTriangleCount > 0
+            || this->sliverTriangleCount > 0
+            || this->boundaryEdgeCount > 0
+            || this->nonManifoldEdgeCount > 0
+            || this->inconsistentEdgeCount > 0
+            || this->duplicateNodeCount > 0;
+}
+
+MeshQualityAnalysis::Report MeshQualityAnalysis::analyze(
+        const Handle_Poly_Triangulation& triangulation, const Parameters& params)
+{
+    Report report;
+    if (!triangulation || triangulation->NbTriangles() <= 0)
+        return report;
+
+    report.nodeCount = triangulation->NbNodes();
+    report.triangleCount = triangulation->NbTriangles();
+    std::vector<char> vecProblem(report.triangleCount, 0);
+    for (const ChunkReport& chunkReport : checkTriangles(*triangulation, params, &vecProblem)) {
+        report.degenerateTriangleCount += chunkReport.degenerateCount;
+        report.sliverTriangleCount += chunkReport.sliverCount;
+        for (int i = 0; i < AspectRatioClassCount; ++i)
+            report.aspectRatioHistogram[i] += chunkReport.aspectRatioHistogram[i];
+
+        report.maxAspectRatio = std::max(report.maxAspectRatio, chunkReport.maxAspectRatio);
+    }
+
+    checkEdges(triangulation, &report, &vecProblem);
+    report.duplicateNodeCount = countDuplicateNodes(*triangulation, params.duplicateNodeTolerance);
+    const Poly_Array1OfTriangle& vecTriangle = triangulation->Triangles();
+    for (int i = 0; i < report.triangleCount; ++i) {
+        if (!vecProblem.at(i))
+            continue;
+
+        int n1, n2, n3;
+        vecTriangle.Value(i + 1).Get(n1, n2, n3);
+        if (!hasValidNodes(*triangulation, n1, n2, n3))
+            continue;
+
+        report.vecProblemTriangle.push_back({
+            triangulation->Node(n1).XYZ(), triangulation->Node(n2).XYZ(), triangulation->Node(n3).XYZ()
+        });
+    }
+
+    return report;
+}
+
+MeshQualityAnalysis::Report MeshQualityAnalysis::analyze(const TopoDS_Shape& shape, const Parameters& params)
+{
+    std::vector<TopoDS_Face> vecFace;
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) { vecFace.push_back(face); });
+    std::vector<Report> vecFaceReport(vecFace.size());
+    CppUtils::parallelFor(int(vecFace.size()), [&](int i) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(vecFace.at(i), loc);
+        Report& faceReport = vecFaceReport.at(i);
+        faceReport = MeshQualityAnalysis::analyze(triangulation, params);
+        if (!loc.IsIdentity()) {
+            const gp_Trsf& trsf = loc.Transformation();
+            for (std::array<gp_XYZ, 3>& triangle : faceReport.vecProblemTriangle) {
+                for (gp_XYZ& coords : triangle)
+                    trsf.Transforms(coords);
+            }
+        }
+    });
+
+    Report report;
+    for (const Report& faceReport : vecFaceReport)
+        mergeReport(&report, faceReport);
+
+    return report;
+}
+
+double MeshQualityAnalysis::triangleAspectRatio(const gp_XYZ& p1, const gp_XYZ& p2, const gp_XYZ& p3)
+{
+    const double l1 = (p2 - p1).Modulus();
+    const double l2 = (p3 - p2).Modulus();
+    const double l3 = (p1 - p3).Modulus();
+    const double lmax = std::max({ l1, l2, l3 });
+    // Twice the area
+    const double crossNorm = (p2 - p1).Crossed(p3 - p1).Modulus();
+    // Height on the longest edge below confusion
+    if (lmax <= Precision::Confusion() || crossNorm <= Precision::Confusion() * lmax)
+        return RealLast();
+
+    // lmax / inradius is lmax * perimeter / (2 * area), it's 2 * sqrt(3) for an equilateral triangle
+    return (lmax * (l1 + l2 + l3)) / (crossNorm * 2 * std::sqrt(3.));
+}
+
+} // namespace Mayo
@@ -0,0 +1,65 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <Poly_Triangulation.hxx>
+#include <Precision.hxx>
+#include <TopoDS_Shape.hxx>
+#include <gp_XYZ.hxx>
+#include <array>
+#include <vector>
+
+namespace Mayo {
+
+// Quality checks of triangle meshes, meant to triage bad scans or tessellations
+// Triangles are checked concurrently by chunks, edges are classified from the triangle sides
+// grouped by MeshUtils::edgeSides()
+struct MeshQualityAnalysis {
+    struct Parameters {
+        // Triangles whose aspect ratio is greater are reported as slivers
+        double sliverAspectRatio = 10.;
+        // Nodes closer than this distance are reported as duplicates
+        double duplicateNodeTolerance = Precision::Confusion();
+    };
+
+    // Upper bounds of the classes of the aspect ratio histogram, the last class gets the greater
+    // ratios
+    static constexpr int AspectRatioClassCount = 7;
+    static constexpr double AspectRatioClassBounds[AspectRatioClassCount - 1] = { 1.5, 2., 3., 5., 10., 20. };
+
+    struct Report {
+        int nodeCount = 0;
+        int triangleCount = 0;
+        int degenerateTriangleCount = 0; // Null area, or some node repeated
+        int sliverTriangleCount = 0; // Aspect ratio greater than Parameters::sliverAspectRatio
+        int boundaryEdgeCount = 0; // Used by a single triangle
+        int nonManifoldEdgeCount = 0; // Used by more than two triangles
+        int inconsistentEdgeCount = 0; // Used by two triangles running it in the same direction
+        int duplicateNodeCount = 0; // Coincident with another node of lower index
+        // Count of triangles per class of aspect ratio, degenerate triangles are excluded
+        std::array<int, AspectRatioClassCount> aspectRatioHistogram = {};
+        double maxAspectRatio = 0.;
+        // Degenerate and sliver triangles, plus the ones along non-manifold or inconsistent edges
+        // Vertices are in the frame of the analyzed triangulation(or shape)
+        std::vector<std::array<gp_XYZ, 3>> vecProblemTriangle;
+
+        bool hasProblems() const;
+    };
+
+    static Report analyze(const Handle_Poly_Triangulation& triangulation, const Parameters& params = {});
+
+    // Face triangulations of 'shape' are analyzed concurrently, then reports are merged
+    // Boundary edges and duplicate nodes aren't reported: faces are meshed independently, so
+    // their triangulations don't share the nodes along the face boundaries
+    static Report analyze(const TopoDS_Shape& shape, const Parameters& params = {});
+
+    // Ratio of the longest edge to the radius of the inscribed circle, normalized so that an
+    // equilateral triangle has ratio 1. Returns RealLast() for a degenerate triangle
+    static double triangleAspectRatio(const gp_XYZ& p1, const gp_XYZ& p2, const gp_XYZ& p3);
+};
+
+} // namespace Mayo
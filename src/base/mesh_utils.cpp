@@ -5,11 +5,243 @@
 ****************************************************************************/
 
 #include "mesh_utils.h"
+#include "cpp_utils.h"
+#include "global.h"
 #include <QtCore/QtGlobal>
+#include <NCollection_Vec3.hxx>
+#include <Standard_Version.hxx>
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+#  include <TShort_HArray1OfShortReal.hxx>
+#endif
+#include <algorithm>
+#include <cfloat>
 #include <cmath>
+#include <iterator>
+#include <limits>
+#include <tuple>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define MAYO_MESH_UTILS_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#  include <arm_neon.h>
+#  define MAYO_MESH_UTILS_NEON
+#endif
 
 namespace Mayo {
 
+namespace {
+
+// Count of triangles in a chunk of work, so SoA buffers of a chunk fit in CPU cache
+constexpr int MeshChunkTriangleCount = 4096;
+
+// Minimal squared length of a vector to be normalized
+constexpr float MeshMinSquareLength = FLT_MIN;
+
+#if defined(MAYO_MESH_UTILS_SSE2)
+using Float4 = __m128;
+Float4 f4Load(const float* ptr) { return _mm_loadu_ps(ptr); }
+void f4Store(float* ptr, Float4 v) { _mm_storeu_ps(ptr, v); }
+Float4 f4Set(float value) { return _mm_set1_ps(value); }
+Float4 f4Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+Float4 f4Sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+Float4 f4Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+Float4 f4Div(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+Float4 f4Sqrt(Float4 v) { return _mm_sqrt_ps(v); }
+// Returns "a > b ? v : 0" for each lane
+Float4 f4SelectGreater(Float4 a, Float4 b, Float4 v) { return _mm_and_ps(_mm_cmpgt_ps(a, b), v); }
+#elif defined(MAYO_MESH_UTILS_NEON)
+using Float4 = float32x4_t;
+Float4 f4Load(const float* ptr) { return vld1q_f32(ptr); }
+void f4Store(float* ptr, Float4 v) { vst1q_f32(ptr, v); }
+Float4 f4Set(float value) { return vdupq_n_f32(value); }
+Float4 f4Add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+Float4 f4Sub(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+Float4 f4Mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+Float4 f4Div(Float4 a, Float4 b) { return vdivq_f32(a, b); }
+Float4 f4Sqrt(Float4 v) { return vsqrtq_f32(v); }
+// Returns "a > b ? v : 0" for each lane
+Float4 f4SelectGreater(Float4 a, Float4 b, Float4 v) { return vbslq_f32(vcgtq_f32(a, b), v, vdupq_n_f32(0.f)); }
+#endif
+
+// Compensated summation(Kahan-Babuska/Neumaier variant)
+class CompensatedSum {
+public:
+    void add(double value) {
+        const double sum = m_sum + value;
+        if (std::abs(m_sum) >= std::abs(value))
+            m_compensation += (m_sum - sum) + value;
+        else
+            m_compensation += (value - sum) + m_sum;
+
+        m_sum = sum;
+    }
+
+    void add(const CompensatedSum& other) {
+        this->add(other.m_sum);
+        this->add(other.m_compensation);
+    }
+
+    double value() const { return m_sum + m_compensation; }
+
+private:
+    double m_sum = 0.;
+    double m_compensation = 0.;
+};
+
+// Partial results of MeshUtils::triangulationProperties() for a chunk of triangles
+struct MeshChunkProperties {
+    CompensatedSum area;
+    CompensatedSum volume;
+    CompensatedSum areaMoment[3];
+    CompensatedSum volumeMoment[3];
+    Bnd_Box boundingBox;
+
+    void add(const MeshChunkProperties& other) {
+        this->area.add(other.area);
+        this->volume.add(other.volume);
+        for (int i = 0; i < 3; ++i) {
+            this->areaMoment[i].add(other.areaMoment[i]);
+            this->volumeMoment[i].add(other.volumeMoment[i]);
+        }
+
+        this->boundingBox.Add(other.boundingBox);
+    }
+};
+
+// Triangle vertices of a chunk, as structure of arrays
+struct MeshChunkVertices {
+    std::vector<float> coords[9]; // x1, y1, z1, x2, ... z3
+    int count = 0;
+};
+
+void gatherChunkVertices(const Poly_Triangulation& triangulation, int iTriangleBegin, int count, MeshChunkVertices* chunk)
+{
+    chunk->count = count;
+    for (std::vector<float>& vec : chunk->coords)
+        vec.resize(count);
+
+    const Poly_Array1OfTriangle& vecTriangle = triangulation.Triangles();
+    for (int i = 0; i < count; ++i) {
+        int nodeIds[3];
+        vecTriangle.Value(iTriangleBegin + i + 1).Get(nodeIds[0], nodeIds[1], nodeIds[2]);
+        for (int j = 0; j < 3; ++j) {
+            const gp_XYZ xyz = triangulation.Node(nodeIds[j]).XYZ();
+            chunk->coords[j * 3][i] = float(xyz.X());
+            chunk->coords[j * 3 + 1][i] = float(xyz.Y());
+            chunk->coords[j * 3 + 2][i] = float(xyz.Z());
+        }
+    }
+}
+
+// Computes n = (v2 - v1) ^ (v3 - v1) for each triangle of the chunk, so |n| is twice the area
+void crossProductKernel(const MeshChunkVertices& chunk, float* nx, float* ny, float* nz)
+{
+    const float* x1 = chunk.coords[0].data();
+    const float* y1 = chunk.coords[1].data();
+    const float* z1 = chunk.coords[2].data();
+    const float* x2 = chunk.coords[3].data();
+    const float* y2 = chunk.coords[4].data();
+    const float* z2 = chunk.coords[5].data();
+    const float* x3 = chunk.coords[6].data();
+    const float* y3 = chunk.coords[7].data();
+    const float* z3 = chunk.coords[8].data();
+    int i = 0;
+#if defined(MAYO_MESH_UTILS_SSE2) || defined(MAYO_MESH_UTILS_NEON)
+    for (; i + 4 <= chunk.count; i += 4) {
+        const Float4 ux = f4Sub(f4Load(x2 + i), f4Load(x1 + i));
+        const Float4 uy = f4Sub(f4Load(y2 + i), f4Load(y1 + i));
+        const Float4 uz = f4Sub(f4Load(z2 + i), f4Load(z1 + i));
+        const Float4 vx = f4Sub(f4Load(x3 + i), f4Load(x1 + i));
+        const Float4 vy = f4Sub(f4Load(y3 + i), f4Load(y1 + i));
+        const Float4 vz = f4Sub(f4Load(z3 + i), f4Load(z1 + i));
+        f4Store(nx + i, f4Sub(f4Mul(uy, vz), f4Mul(uz, vy)));
+        f4Store(ny + i, f4Sub(f4Mul(uz, vx), f4Mul(ux, vz)));
+        f4Store(nz + i, f4Sub(f4Mul(ux, vy), f4Mul(uy, vx)));
+    }
+#endif
+
+    for (; i < chunk.count; ++i) {
+        const float ux = x2[i] - x1[i];
+        const float uy = y2[i] - y1[i];
+        const float uz = z2[i] - z1[i];
+        const float vx = x3[i] - x1[i];
+        const float vy = y3[i] - y1[i];
+        const float vz = z3[i] - z1[i];
+        nx[i] = uy * vz - uz * vy;
+        ny[i] = uz * vx - ux * vz;
+        nz[i] = ux * vy - uy * vx;
+    }
+}
+
+// Normalizes vectors in-place, vectors too small are set to null
+void normalizeKernel(float* x, float* y, float* z, int count)
+{
+    int i = 0;
+#if defined(MAYO_MESH_UTILS_SSE2) || defined(MAYO_MESH_UTILS_NEON)
+    const Float4 minSqrLength = f4Set(MeshMinSquareLength);
+    for (; i + 4 <= count; i += 4) {
+        const Float4 vx = f4Load(x + i);
+        const Float4 vy = f4Load(y + i);
+        const Float4 vz = f4Load(z + i);
+        const Float4 sqrLength = f4Add(f4Add(f4Mul(vx, vx), f4Mul(vy, vy)), f4Mul(vz, vz));
+        // Division by zero gives inf/nan lanes, they are then masked
+        const Float4 length = f4Sqrt(sqrLength);
+        f4Store(x + i, f4SelectGreater(sqrLength, minSqrLength, f4Div(vx, length)));
+        f4Store(y + i, f4SelectGreater(sqrLength, minSqrLength, f4Div(vy, length)));
+        f4Store(z + i, f4SelectGreater(sqrLength, minSqrLength, f4Div(vz, length)));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        const float sqrLength = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+        const float invLength = sqrLength > MeshMinSquareLength ? 1.f / std::sqrt(sqrLength) : 0.f;
+        x[i] *= invLength;
+        y[i] *= invLength;
+        z[i] *= invLength;
+    }
+}
+
+// Computes cross products of all triangles, each chunk of triangles is a task
+MeshUtils::VectorArrays triangleCrossProducts(const Poly_Triangulation& triangulation, bool normalize)
+{
+    MeshUtils::VectorArrays vecNormal;
+    const int triangleCount = triangulation.NbTriangles();
+    vecNormal.resize(triangleCount);
+    const int chunkCount = (triangleCount + MeshChunkTriangleCount - 1) / MeshChunkTriangleCount;
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        const int iTriangleBegin = iChunk * MeshChunkTriangleCount;
+        const int count = std::min(MeshChunkTriangleCount, triangleCount - iTriangleBegin);
+        MeshChunkVertices chunk;
+        gatherChunkVertices(triangulation, iTriangleBegin, count, &chunk);
+        float* nx = vecNormal.x.data() + iTriangleBegin;
+        float* ny = vecNormal.y.data() + iTriangleBegin;
+        float* nz = vecNormal.z.data() + iTriangleBegin;
+        crossProductKernel(chunk, nx, ny, nz);
+        if (normalize)
+            normalizeKernel(nx, ny, nz, count);
+    });
+
+    return vecNormal;
+}
+
+// Normalizes all vectors, each chunk of vectors is a task
+void normalizeVectors(MeshUtils::VectorArrays* vectors)
+{
+    const int count = vectors->size();
+    const int chunkCount = (count + MeshChunkTriangleCount - 1) / MeshChunkTriangleCount;
+    CppUtils::parallelFor(chunkCount, [=](int iChunk) {
+        const int iBegin = iChunk * MeshChunkTriangleCount;
+        normalizeKernel(
+                    vectors->x.data() + iBegin,
+                    vectors->y.data() + iBegin,
+                    vectors->z.data() + iBegin,
+                    std::min(MeshChunkTriangleCount, count - iBegin));
+    });
+}
+
+} // namespace
+
 double MeshUtils::triangleSignedVolume(const gp_XYZ& p1, const gp_XYZ& p2, const gp_XYZ& p3)
 {
     return p1.Dot(p2.Crossed(p3)) / 6.0f;
@@ -31,42 +263,693 @@ double MeshUtils::triangleArea(const gp_XYZ& p1, const gp_XYZ& p2, const gp_XYZ&
 
 double MeshUtils::triangulationVolume(const Handle_Poly_Triangulation& triangulation)
 {
+    return MeshUtils::triangulationProperties(triangulation).volume;
+}
+
+double MeshUtils::triangulationArea(const Handle_Poly_Triangulation& triangulation)
+{
+    return MeshUtils::triangulationProperties(triangulation).area;
+}
+
+MeshUtils::TriangulationProperties MeshUtils::triangulationProperties(const Handle_Poly_Triangulation& triangulation)
+{
+    TriangulationProperties props;
     if (!triangulation)
-        return 0;
+        return props;
 
-    double volume = 0;
-    const TColgp_Array1OfPnt& vecNode = triangulation->Nodes();
-    // TODO Parallelize computation
-    for (const Poly_Triangle& tri : triangulation->Triangles()) {
-        int v1, v2, v3;
-        tri.Get(v1, v2, v3);
-        volume += MeshUtils::triangleSignedVolume(
-                    vecNode.Value(v1).Coord(),
-                    vecNode.Value(v2).Coord(),
-                    vecNode.Value(v3).Coord());
+    const Poly_Array1OfTriangle& vecTriangle = triangulation->Triangles();
+    const int triangleCount = triangulation->NbTriangles();
+    const int nodeCount = triangulation->NbNodes();
+    // Chunks cover the triangles and nodes(for the bounding box) in the same pass
+    const int itemCount = std::max(triangleCount, nodeCount);
+    const int chunkCount = (itemCount + MeshChunkTriangleCount - 1) / MeshChunkTriangleCount;
+    std::vector<MeshChunkProperties> vecChunkProps(chunkCount);
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        MeshChunkProperties& chunkProps = vecChunkProps.at(iChunk);
+        const int iBegin = iChunk * MeshChunkTriangleCount;
+        const int iTriangleEnd = std::min(iBegin + MeshChunkTriangleCount, triangleCount);
+        for (int i = iBegin; i < iTriangleEnd; ++i) {
+            int n1, n2, n3;
+            vecTriangle.Value(i + 1).Get(n1, n2, n3);
+            const gp_XYZ p1 = triangulation->Node(n1).XYZ();
+            const gp_XYZ p2 = triangulation->Node(n2).XYZ();
+            const gp_XYZ p3 = triangulation->Node(n3).XYZ();
+            const double area = MeshUtils::triangleArea(p1, p2, p3);
+            const double volume = MeshUtils::triangleSignedVolume(p1, p2, p3);
+            const gp_XYZ sumPnt = p1 + p2 + p3;
+            chunkProps.area.add(area);
+            chunkProps.volume.add(volume);
+            for (int j = 0; j < 3; ++j) {
+                // Centroid of tetrahedron(origin, p1, p2, p3) is sumPnt/4, the one of triangle is sumPnt/3
+                chunkProps.areaMoment[j].add(area * sumPnt.Coord(j + 1));
+                chunkProps.volumeMoment[j].add(volume * sumPnt.Coord(j + 1));
+            }
+        }
+
+        const int iNodeEnd = std::min(iBegin + MeshChunkTriangleCount, nodeCount);
+        for (int i = iBegin; i < iNodeEnd; ++i)
+            chunkProps.boundingBox.Add(triangulation->Node(i + 1));
+    });
+
+    MeshChunkProperties sumProps;
+    for (const MeshChunkProperties& chunkProps : vecChunkProps)
+        sumProps.add(chunkProps);
+
+    const double signedVolume = sumProps.volume.value();
+    props.area = sumProps.area.value();
+    props.volume = std::abs(signedVolume);
+    props.boundingBox = sumProps.boundingBox;
+    if (props.volume > std::numeric_limits<double>::min()) {
+        for (int j = 0; j < 3; ++j)
+            props.centroid.SetCoord(j + 1, sumProps.volumeMoment[j].value() / (4 * signedVolume));
+    }
+    else if (props.area > std::numeric_limits<double>::min()) {
+        for (int j = 0; j < 3; ++j)
+            props.centroid.SetCoord(j + 1, sumProps.areaMoment[j].value() / (3 * props.area));
     }
 
-    return std::abs(volume);
+    return props;
 }
 
-double MeshUtils::triangulationArea(const Handle_Poly_Triangulation& triangulation)
+MeshUtils::VectorArrays MeshUtils::triangleNormals(const Handle_Poly_Triangulation& triangulation)
+{
+    if (!triangulation)
+        return {};
+
+    return triangleCrossProducts(*triangulation, true);
+}
+
+MeshUtils::VectorArrays MeshUtils::nodeNormals(const Handle_Poly_Triangulation& triangulation)
+{
+    if (!triangulation)
+        return {};
+
+    // Cross product norm is twice the area of the triangle, so it's already the weighted normal
+    const VectorArrays vecTriangleNormal = triangleCrossProducts(*triangulation, false);
+    VectorArrays vecNodeNormal;
+    vecNodeNormal.resize(triangulation->NbNodes());
+    // Accumulation is sequential: it's bound by memory and keeps the summation order(and so the
+    // result) deterministic
+    const Poly_Array1OfTriangle& vecTriangle = triangulation->Triangles();
+    for (int i = 0; i < vecTriangleNormal.size(); ++i) {
+        int nodeIds[3];
+        vecTriangle.Value(i + 1).Get(nodeIds[0], nodeIds[1], nodeIds[2]);
+        for (int nodeId : nodeIds) {
+            vecNodeNormal.x[nodeId - 1] += vecTriangleNormal.x[i];
+            vecNodeNormal.y[nodeId - 1] += vecTriangleNormal.y[i];
+            vecNodeNormal.z[nodeId - 1] += vecTriangleNormal.z[i];
+        }
+    }
+
+    normalizeVectors(&vecNodeNormal);
+    return vecNodeNormal;
+}
+
+namespace {
+
+// Size of the vertex cache simulated by vertexCacheTriangleOrder(), larger than most actual caches
+// but the resulting order also performs well on smaller ones
+constexpr int VertexCacheSize = 32;
+
+// Score of a vertex, see https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+float vertexCacheScore(int cachePos, int remainingTriangleCount)
+{
+    if (remainingTriangleCount == 0)
+        return -1.f; // No triangle left to add
+
+    float score = 0.f;
+    if (cachePos >= 0) {
+        if (cachePos < 3) {
+            // Vertex used by the last triangle, fixed score so strips aren't favored over fans
+            score = 0.75f;
+        }
+        else {
+            const float scaler = 1.f / (VertexCacheSize - 3);
+            score = std::pow(1.f - (cachePos - 3) * scaler, 1.5f);
+        }
+    }
+
+    // Bonus for vertices with few triangles left, so they are finished off quickly
+    score += 2.f * std::pow(float(remainingTriangleCount), -0.5f);
+    return score;
+}
+
+// Returns the triangle indices in the order they have to be drawn
+// 'vecIndex' holds the 0-based node indices of triangles, 3 per triangle
+std::vector<int> vertexCacheTriangleOrder(const std::vector<int>& vecIndex, int nodeCount)
+{
+    const int triangleCount = int(vecIndex.size() / 3);
+    // Triangles around each node, as compressed adjacency arrays
+    std::vector<int> vecNodeTriangleOffset(nodeCount + 1, 0);
+    for (int index : vecIndex)
+        ++vecNodeTriangleOffset[index + 1];
+
+    for (int i = 0; i < nodeCount; ++i)
+        vecNodeTriangleOffset[i + 1] += vecNodeTriangleOffset[i];
+
+    std::vector<int> vecNodeTriangle(vecIndex.size());
+    std::vector<int> vecNodeTriangleCount(nodeCount, 0); // Count of triangles not yet added
+    for (int iTriangle = 0; iTriangle < triangleCount; ++iTriangle) {
+        for (int k = 0; k < 3; ++k) {
+            const int iNode = vecIndex[iTriangle * 3 + k];
+            vecNodeTriangle[vecNodeTriangleOffset[iNode] + vecNodeTriangleCount[iNode]++] = iTriangle;
+        }
+    }
+
+    std::vector<int> vecNodeCachePos(nodeCount, -1);
+    std::vector<float> vecNodeScore(nodeCount);
+    for (int iNode = 0; iNode < nodeCount; ++iNode)
+        vecNodeScore[iNode] = vertexCacheScore(-1, vecNodeTriangleCount[iNode]);
+
+    std::vector<float> vecTriangleScore(triangleCount, 0.f);
+    for (int iTriangle = 0; iTriangle < triangleCount; ++iTriangle) {
+        for (int k = 0; k < 3; ++k)
+            vecTriangleScore[iTriangle] += vecNodeScore[vecIndex[iTriangle * 3 + k]];
+    }
+
+    std::vector<bool> vecTriangleAdded(triangleCount, false);
+    std::vector<int> vecTriangleOrder;
+    vecTriangleOrder.reserve(triangleCount);
+    int cache[VertexCacheSize + 3];
+    int cacheSize = 0;
+    int iBestTriangle = -1;
+    int iNextTriangle = 0; // Fallback when cached vertices have no triangle left
+    while (int(vecTriangleOrder.size()) < triangleCount) {
+        if (iBestTriangle < 0) {
+            while (vecTriangleAdded[iNextTriangle])
+                ++iNextTriangle;
+
+            iBestTriangle = iNextTriangle;
+        }
+
+        vecTriangleAdded[iBestTriangle] = true;
+        vecTriangleOrder.push_back(iBestTriangle);
+        const int* triNodes = &vecIndex[iBestTriangle * 3];
+        for (int k = 0; k < 3; ++k) {
+            const int iNode = triNodes[k];
+            int* itBegin = &vecNodeTriangle[vecNodeTriangleOffset[iNode]];
+            int* itEnd = itBegin + vecNodeTriangleCount[iNode];
+            int* itFound = std::find(itBegin, itEnd, iBestTriangle);
+            if (itFound != itEnd) {
+                std::swap(*itFound, *(itEnd - 1));
+                --vecNodeTriangleCount[iNode];
+            }
+        }
+
+        // Nodes of the added triangle go to the front of the cache(LRU)
+        int newCache[VertexCacheSize + 3];
+        int newCacheSize = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (std::find(newCache, newCache + newCacheSize, triNodes[k]) == newCache + newCacheSize)
+                newCache[newCacheSize++] = triNodes[k];
+        }
+
+        for (int i = 0; i < cacheSize; ++i) {
+            if (std::find(triNodes, triNodes + 3, cache[i]) == triNodes + 3)
+                newCache[newCacheSize++] = cache[i];
+        }
+
+        // Update scores of the nodes whose cache position changed, including the evicted ones
+        for (int i = 0; i < newCacheSize; ++i) {
+            const int iNode = newCache[i];
+            const int cachePos = i < VertexCacheSize ? i : -1;
+            vecNodeCachePos[iNode] = cachePos;
+            const float score = vertexCacheScore(cachePos, vecNodeTriangleCount[iNode]);
+            const float scoreDelta = score - vecNodeScore[iNode];
+            vecNodeScore[iNode] = score;
+            const int* itTriangle = &vecNodeTriangle[vecNodeTriangleOffset[iNode]];
+            for (int j = 0; j < vecNodeTriangleCount[iNode]; ++j)
+                vecTriangleScore[itTriangle[j]] += scoreDelta;
+        }
+
+        // Next triangle is the best one around cached nodes
+        iBestTriangle = -1;
+        float bestScore = -1.f;
+        cacheSize = std::min(newCacheSize, VertexCacheSize);
+        for (int i = 0; i < cacheSize; ++i) {
+            const int iNode = newCache[i];
+            cache[i] = iNode;
+            const int* itTriangle = &vecNodeTriangle[vecNodeTriangleOffset[iNode]];
+            for (int j = 0; j < vecNodeTriangleCount[iNode]; ++j) {
+                const int iTriangle = itTriangle[j];
+                if (vecTriangleScore[iTriangle] > bestScore) {
+                    bestScore = vecTriangleScore[iTriangle];
+                    iBestTriangle = iTriangle;
+                }
+            }
+        }
+    }
+
+    return vecTriangleOrder;
+}
+
+// Returns the 0-based node indices of the triangles of 'triangulation', 3 per triangle
+std::vector<int> triangulationIndices(const Poly_Triangulation& triangulation)
+{
+    const Poly_Array1OfTriangle& vecTriangle = triangulation.Triangles();
+    std::vector<int> vecIndex(std::size_t(triangulation.NbTriangles()) * 3);
+    for (int i = 0; i < triangulation.NbTriangles(); ++i) {
+        int n1, n2, n3;
+        vecTriangle.Value(i + 1).Get(n1, n2, n3);
+        vecIndex[i * 3] = n1 - 1;
+        vecIndex[i * 3 + 1] = n2 - 1;
+        vecIndex[i * 3 + 2] = n3 - 1;
+    }
+
+    return vecIndex;
+}
+
+} // namespace
+
+void MeshUtils::optimizeVertexCache(const Handle_Poly_Triangulation& triangulation)
+{
+    if (!triangulation || triangulation->NbTriangles() < 2)
+        return;
+
+    const Poly_Array1OfTriangle vecTriangle = triangulation->Triangles(); // Copy
+    const std::vector<int> vecTriangleOrder =
+            vertexCacheTriangleOrder(triangulationIndices(*triangulation), triangulation->NbNodes());
+    Poly_Array1OfTriangle& vecNewTriangle = triangulation->ChangeTriangles();
+    for (int i = 0; i < int(vecTriangleOrder.size()); ++i)
+        vecNewTriangle.ChangeValue(i + 1) = vecTriangle.Value(vecTriangleOrder[i] + 1);
+}
+
+Handle_Poly_Triangulation MeshUtils::vertexCacheOptimized(const Handle_Poly_Triangulation& triangulation)
 {
     if (!triangulation)
-        return 0;
+        return {};
+
+    const int nodeCount = triangulation->NbNodes();
+    const int triangleCount = triangulation->NbTriangles();
+    const std::vector<int> vecIndex = triangulationIndices(*triangulation);
+    const std::vector<int> vecTriangleOrder = vertexCacheTriangleOrder(vecIndex, nodeCount);
+
+    // Nodes are renumbered in order of first use, unused nodes go last
+    std::vector<int> vecOldToNewNode(nodeCount, -1);
+    std::vector<int> vecNewToOldNode;
+    vecNewToOldNode.reserve(nodeCount);
+    for (int iTriangle : vecTriangleOrder) {
+        for (int k = 0; k < 3; ++k) {
+            const int iNode = vecIndex[iTriangle * 3 + k];
+            if (vecOldToNewNode[iNode] < 0) {
+                vecOldToNewNode[iNode] = int(vecNewToOldNode.size());
+                vecNewToOldNode.push_back(iNode);
+            }
+        }
+    }
+
+    for (int iNode = 0; iNode < nodeCount; ++iNode) {
+        if (vecOldToNewNode[iNode] < 0) {
+            vecOldToNewNode[iNode] = int(vecNewToOldNode.size());
+            vecNewToOldNode.push_back(iNode);
+        }
+    }
+
+    const bool hasUV = triangulation->HasUVNodes();
+    Handle_Poly_Triangulation newTriangulation = new Poly_Triangulation(nodeCount, triangleCount, hasUV);
+    newTriangulation->Deflection(triangulation->Deflection());
+    for (int i = 0; i < nodeCount; ++i) {
+        const int iOldNode = vecNewToOldNode[i] + 1;
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+        newTriangulation->SetNode(i + 1, triangulation->Node(iOldNode));
+        if (hasUV)
+            newTriangulation->SetUVNode(i + 1, triangulation->UVNode(iOldNode));
+#else
+        newTriangulation->ChangeNodes().ChangeValue(i + 1) = triangulation->Nodes().Value(iOldNode);
+        if (hasUV)
+            newTriangulation->ChangeUVNodes().ChangeValue(i + 1) = triangulation->UVNodes().Value(iOldNode);
+#endif
+    }
+
+    if (triangulation->HasNormals()) {
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+        newTriangulation->AddNormals();
+        for (int i = 0; i < nodeCount; ++i) {
+            gp_Vec3f normal;
+            triangulation->Normal(vecNewToOldNode[i] + 1, normal);
+            newTriangulation->SetNormal(i + 1, normal);
+        }
+#else
+        const TShort_Array1OfShortReal& vecNormal = triangulation->Normals();
+        Handle_TShort_HArray1OfShortReal vecNewNormal = new TShort_HArray1OfShortReal(1, 3 * nodeCount);
+        for (int i = 0; i < nodeCount; ++i) {
+            for (int j = 0; j < 3; ++j)
+                vecNewNormal->SetValue(i * 3 + j + 1, vecNormal.Value(vecNewToOldNode[i] * 3 + j + 1));
+        }
+
+        newTriangulation->SetNormals(vecNewNormal);
+#endif
+    }
+
+    Poly_Array1OfTriangle& vecNewTriangle = newTriangulation->ChangeTriangles();
+    for (int i = 0; i < triangleCount; ++i) {
+        const int* triNodes = &vecIndex[vecTriangleOrder[i] * 3];
+        vecNewTriangle.ChangeValue(i + 1).Set(
+                    vecOldToNewNode[triNodes[0]] + 1,
+                    vecOldToNewNode[triNodes[1]] + 1,
+                    vecOldToNewNode[triNodes[2]] + 1);
+    }
+
+    return newTriangulation;
+}
+
+namespace {
+
+// Count of node ranges where triangle sides are hashed, by a task each. Triangulations not bigger
+// than a chunk use a single range
+constexpr int EdgeSidePartitionCount = 64;
+
+} // namespace
+
+Span<const MeshUtils::TriangleSide> MeshUtils::EdgeSides::sidesOfEdge(int iEdge) const
+{
+    const int iBegin = this->vecEdgeSideBegin.at(iEdge);
+    const int iEnd = this->vecEdgeSideBegin.at(iEdge + 1);
+    return Span<const TriangleSide>(this->vecSide.data() + iBegin, iEnd - iBegin);
+}
+
+MeshUtils::EdgeSides MeshUtils::edgeSides(const Handle_Poly_Triangulation& triangulation)
+{
+    EdgeSides edgeSides;
+    if (!triangulation || triangulation->NbTriangles() <= 0)
+        return edgeSides;
+
+    const int triangleCount = triangulation->NbTriangles();
+    const int nodeCount = triangulation->NbNodes();
+    const Poly_Array1OfTriangle& vecTriangle = triangulation->Triangles();
+    const int partitionCount = triangleCount > MeshChunkTriangleCount ? EdgeSidePartitionCount : 1;
+    const int partitionNodeCount = std::max((nodeCount + partitionCount - 1) / partitionCount, 1);
+    const int chunkCount = (triangleCount + MeshChunkTriangleCount - 1) / MeshChunkTriangleCount;
+
+    // Sides of the triangles are scattered by chunk into the partitions of their first node
+    struct ChunkSides {
+        std::vector<std::vector<TriangleSide>> vecPartitionSide;
+        int invalidTriangleCount = 0;
+    };
+    std::vector<ChunkSides> vecChunkSides(chunkCount);
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        ChunkSides& chunkSides = vecChunkSides.at(iChunk);
+        chunkSides.vecPartitionSide.resize(partitionCount);
+        const int iBegin = iChunk * MeshChunkTriangleCount;
+        const int iEnd = std::min(iBegin + MeshChunkTriangleCount, triangleCount);
+        for (int i = iBegin; i < iEnd; ++i) {
+            int nodeIds[3];
+            vecTriangle.Value(i + 1).Get(nodeIds[0], nodeIds[1], nodeIds[2]);
+            auto fnIsValidNode = [=](int nodeId) { return 1 <= nodeId && nodeId <= nodeCount; };
+            if (!std::all_of(std::cbegin(nodeIds), std::cend(nodeIds), fnIsValidNode)) {
+                ++chunkSides.invalidTriangleCount;
+                continue;
+            }
+
+            for (int j = 0; j < 3; ++j) {
+                const int nStart = nodeIds[j];
+                const int nEnd = nodeIds[(j + 1) % 3];
+                if (nStart == nEnd)
+                    continue;
+
+                const int n1 = std::min(nStart, nEnd);
+                const TriangleSide side = { n1, std::max(nStart, nEnd), i, nStart > nEnd };
+                chunkSides.vecPartitionSide[(n1 - 1) / partitionNodeCount].push_back(side);
+            }
+        }
+    });
 
-    double area = 0;
+    // Sides sharing the same nodes are adjacent once sorted, the triangle index keeps the order
+    // deterministic
+    struct PartitionEdges {
+        std::vector<TriangleSide> vecSide;
+        std::vector<int> vecEdgeSideBegin; // Relative to the partition
+    };
+    std::vector<PartitionEdges> vecPartitionEdges(partitionCount);
+    CppUtils::parallelFor(partitionCount, [&](int iPartition) {
+        PartitionEdges& partition = vecPartitionEdges.at(iPartition);
+        std::vector<TriangleSide>& vecSide = partition.vecSide;
+        for (const ChunkSides& chunkSides : vecChunkSides) {
+            const std::vector<TriangleSide>& vecChunkSide = chunkSides.vecPartitionSide.at(iPartition);
+            vecSide.insert(vecSide.end(), vecChunkSide.cbegin(), vecChunkSide.cend());
+        }
+
+        std::sort(vecSide.begin(), vecSide.end(), [](const TriangleSide& lhs, const TriangleSide& rhs) {
+            return std::tie(lhs.node1, lhs.node2, lhs.triangle) < std::tie(rhs.node1, rhs.node2, rhs.triangle);
+        });
+        for (size_t i = 0; i < vecSide.size(); ++i) {
+            if (i == 0 || vecSide.at(i).node1 != vecSide.at(i - 1).node1 || vecSide.at(i).node2 != vecSide.at(i - 1).node2)
+                partition.vecEdgeSideBegin.push_back(int(i));
+        }
+    });
+
+    // Partitions are concatenated in node order
+    std::vector<int> vecPartitionSideOffset(partitionCount + 1, 0);
+    std::vector<int> vecPartitionEdgeOffset(partitionCount + 1, 0);
+    for (int i = 0; i < partitionCount; ++i) {
+        const PartitionEdges& partition = vecPartitionEdges.at(i);
+        vecPartitionSideOffset[i + 1] = vecPartitionSideOffset[i] + int(partition.vecSide.size());
+        vecPartitionEdgeOffset[i + 1] = vecPartitionEdgeOffset[i] + int(partition.vecEdgeSideBegin.size());
+    }
+
+    edgeSides.vecSide.resize(vecPartitionSideOffset.back());
+    edgeSides.vecEdgeSideBegin.resize(vecPartitionEdgeOffset.back() + 1);
+    edgeSides.vecEdgeSideBegin.back() = vecPartitionSideOffset.back();
+    CppUtils::parallelFor(partitionCount, [&](int iPartition) {
+        const PartitionEdges& partition = vecPartitionEdges.at(iPartition);
+        const int sideOffset = vecPartitionSideOffset.at(iPartition);
+        std::copy(partition.vecSide.cbegin(), partition.vecSide.cend(), edgeSides.vecSide.begin() + sideOffset);
+        auto itEdgeSideBegin = edgeSides.vecEdgeSideBegin.begin() + vecPartitionEdgeOffset.at(iPartition);
+        for (int iSide : partition.vecEdgeSideBegin)
+            *itEdgeSideBegin++ = sideOffset + iSide;
+    });
+
+    for (const ChunkSides& chunkSides : vecChunkSides)
+        edgeSides.invalidTriangleCount += chunkSides.invalidTriangleCount;
+
+    return edgeSides;
+}
+
+std::vector<MeshUtils::Edge> MeshUtils::featureEdges(
+        const Handle_Poly_Triangulation& triangulation, double creaseAngle)
+{
+    if (!triangulation || triangulation->NbTriangles() <= 0)
+        return {};
+
+    const VectorArrays vecTriangleNormal = MeshUtils::triangleNormals(triangulation);
+    const EdgeSides edgeSides = MeshUtils::edgeSides(triangulation);
+    const double cosCreaseAngle = std::cos(creaseAngle);
+    auto fnIsCrease = [&](int iTri1, int iTri2) {
+        const double dot =
+                vecTriangleNormal.x[iTri1] * vecTriangleNormal.x[iTri2]
+                + vecTriangleNormal.y[iTri1] * vecTriangleNormal.y[iTri2]
+                + vecTriangleNormal.z[iTri1] * vecTriangleNormal.z[iTri2];
+        // Normal of a degenerated triangle is null, it doesn't make a crease
+        return dot != 0. && dot < cosCreaseAngle;
+    };
+
+    const int edgeCount = edgeSides.edgeCount();
+    const int chunkCount = (edgeCount + MeshChunkTriangleCount - 1) / MeshChunkTriangleCount;
+    std::vector<std::vector<Edge>> vecChunkEdges(chunkCount);
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        const int iBegin = iChunk * MeshChunkTriangleCount;
+        const int iEnd = std::min(iBegin + MeshChunkTriangleCount, edgeCount);
+        for (int iEdge = iBegin; iEdge < iEnd; ++iEdge) {
+            const Span<const TriangleSide> spanSide = edgeSides.sidesOfEdge(iEdge);
+            if (spanSide.size() != 2 || fnIsCrease(spanSide[0].triangle, spanSide[1].triangle))
+                vecChunkEdges.at(iChunk).push_back({ spanSide[0].node1, spanSide[0].node2 });
+        }
+    });
+
+    std::vector<Edge> vecEdge;
+    for (const std::vector<Edge>& vecChunkEdge : vecChunkEdges)
+        vecEdge.insert(vecEdge.end(), vecChunkEdge.cbegin(), vecChunkEdge.cend());
+
+    return vecEdge;
+}
+
+Handle_Poly_Triangulation MeshUtils::smoothNormals(
+        const Handle_Poly_Triangulation& triangulation, double creaseAngle)
+{
+    if (!triangulation || triangulation->NbTriangles() <= 0)
+        return triangulation;
+
+    const int nodeCount = triangulation->NbNodes();
+    const int triangleCount = triangulation->NbTriangles();
+    const std::vector<int> vecIndex = triangulationIndices(*triangulation);
+    const VectorArrays vecTriangleNormal = triangleCrossProducts(*triangulation, true);
+    // Cross product norm is twice the area of the triangle, so it's already the weighted normal
+    const VectorArrays vecTriangleWeightedNormal = triangleCrossProducts(*triangulation, false);
+
+    // Corners(ie positions in 'vecIndex') around each node, in increasing order
+    std::vector<int> vecNodeCornerBegin(nodeCount + 1, 0);
+    for (int iNode : vecIndex)
+        ++vecNodeCornerBegin[iNode + 1];
+
+    for (int i = 0; i < nodeCount; ++i)
+        vecNodeCornerBegin[i + 1] += vecNodeCornerBegin[i];
+
+    std::vector<int> vecNodeCorner(vecIndex.size());
+    {
+        std::vector<int> vecNodeCornerEnd(vecNodeCornerBegin.cbegin(), vecNodeCornerBegin.cend() - 1);
+        for (int iCorner = 0; iCorner < int(vecIndex.size()); ++iCorner)
+            vecNodeCorner[vecNodeCornerEnd[vecIndex[iCorner]]++] = iCorner;
+    }
+
+    // Normal at a corner is the weighted sum of the normals of the triangles around the node which
+    // make an angle not greater than 'creaseAngle' with the triangle of the corner. Nodes are then
+    // split: corners of a node sharing the same normal share a vertex
+    // Arrays below are indexed like 'vecNodeCorner'
+    const float cosCreaseAngle = float(std::cos(creaseAngle));
+    std::vector<NCollection_Vec3<float>> vecCornerNormal(vecIndex.size());
+    std::vector<int> vecCornerGroup(vecIndex.size()); // Vertex index relative to the node
+    std::vector<int> vecNodeGroupCount(nodeCount, 0);
+    const int nodeChunkCount = (nodeCount + MeshChunkTriangleCount - 1) / MeshChunkTriangleCount;
+    CppUtils::parallelFor(nodeChunkCount, [&](int iChunk) {
+        const int iNodeBegin = iChunk * MeshChunkTriangleCount;
+        const int iNodeEnd = std::min(iNodeBegin + MeshChunkTriangleCount, nodeCount);
+        for (int iNode = iNodeBegin; iNode < iNodeEnd; ++iNode) {
+            const int iBegin = vecNodeCornerBegin[iNode];
+            const int iEnd = vecNodeCornerBegin[iNode + 1];
+            int groupCount = 0;
+            for (int i = iBegin; i < iEnd; ++i) {
+                const int iTri = vecNodeCorner[i] / 3;
+                NCollection_Vec3<float> normal(0.f, 0.f, 0.f);
+                for (int j = iBegin; j < iEnd; ++j) {
+                    const int jTri = vecNodeCorner[j] / 3;
+                    const float dot =
+                            vecTriangleNormal.x[iTri] * vecTriangleNormal.x[jTri]
+                            + vecTriangleNormal.y[iTri] * vecTriangleNormal.y[jTri]
+                            + vecTriangleNormal.z[iTri] * vecTriangleNormal.z[jTri];
+                    if (j == i || dot >= cosCreaseAngle) {
+                        normal.x() += vecTriangleWeightedNormal.x[jTri];
+                        normal.y() += vecTriangleWeightedNormal.y[jTri];
+                        normal.z() += vecTriangleWeightedNormal.z[jTri];
+                    }
+                }
+
+                const float sqrLength = normal.SquareModulus();
+                if (sqrLength > MeshMinSquareLength)
+                    normal /= std::sqrt(sqrLength);
+
+                int group = -1;
+                for (int j = iBegin; j < i && group < 0; ++j) {
+                    if (vecCornerNormal[j] == normal)
+                        group = vecCornerGroup[j];
+                }
+
+                vecCornerNormal[i] = normal;
+                vecCornerGroup[i] = group >= 0 ? group : groupCount++;
+            }
+
+            vecNodeGroupCount[iNode] = groupCount;
+        }
+    });
+
+    // Vertices of a node are consecutive, nodes not used by any triangle are dropped
+    std::vector<int> vecNodeFirstVertex(nodeCount + 1, 0);
+    for (int i = 0; i < nodeCount; ++i)
+        vecNodeFirstVertex[i + 1] = vecNodeFirstVertex[i] + vecNodeGroupCount[i];
+
+    const int vertexCount = vecNodeFirstVertex.back();
+    Handle_Poly_Triangulation newTriangulation = new Poly_Triangulation(vertexCount, triangleCount, false);
+    newTriangulation->Deflection(triangulation->Deflection());
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    newTriangulation->AddNormals();
+#else
+    TColgp_Array1OfPnt& vecNewNode = newTriangulation->ChangeNodes();
     const TColgp_Array1OfPnt& vecNode = triangulation->Nodes();
-    // TODO Parallelize computation
-    for (const Poly_Triangle& tri : triangulation->Triangles()) {
-        int v1, v2, v3;
-        tri.Get(v1, v2, v3);
-        area += MeshUtils::triangleArea(
-                    vecNode.Value(v1).Coord(),
-                    vecNode.Value(v2).Coord(),
-                    vecNode.Value(v3).Coord());
+    Handle_TShort_HArray1OfShortReal vecNewNormal = new TShort_HArray1OfShortReal(1, 3 * vertexCount);
+#endif
+    std::vector<int> vecCornerVertex(vecIndex.size());
+    CppUtils::parallelFor(nodeChunkCount, [&](int iChunk) {
+        const int iNodeBegin = iChunk * MeshChunkTriangleCount;
+        const int iNodeEnd = std::min(iNodeBegin + MeshChunkTriangleCount, nodeCount);
+        for (int iNode = iNodeBegin; iNode < iNodeEnd; ++iNode) {
+            for (int i = vecNodeCornerBegin[iNode]; i < vecNodeCornerBegin[iNode + 1]; ++i) {
+                const int iVertex = vecNodeFirstVertex[iNode] + vecCornerGroup[i];
+                vecCornerVertex[vecNodeCorner[i]] = iVertex;
+                const NCollection_Vec3<float>& normal = vecCornerNormal[i];
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+                newTriangulation->SetNode(iVertex + 1, triangulation->Node(iNode + 1));
+                newTriangulation->SetNormal(iVertex + 1, normal);
+#else
+                vecNewNode.ChangeValue(iVertex + 1) = vecNode.Value(iNode + 1);
+                for (int j = 0; j < 3; ++j)
+                    vecNewNormal->SetValue(iVertex * 3 + j + 1, normal[j]);
+#endif
+            }
+        }
+    });
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+    newTriangulation->SetNormals(vecNewNormal);
+#endif
+    Poly_Array1OfTriangle& vecNewTriangle = newTriangulation->ChangeTriangles();
+    for (int i = 0; i < triangleCount; ++i) {
+        vecNewTriangle.ChangeValue(i + 1).Set(
+                    vecCornerVertex[i * 3] + 1,
+                    vecCornerVertex[i * 3 + 1] + 1,
+                    vecCornerVertex[i * 3 + 2] + 1);
     }
 
-    return area;
+    return newTriangulation;
+}
+
+bool MeshUtils::isSinglePrecision(const Handle_Poly_Triangulation& triangulation)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    return !triangulation.IsNull() && !triangulation->IsDoublePrecision();
+#else
+    MAYO_UNUSED(triangulation);
+    return false;
+#endif
+}
+
+Handle_Poly_Triangulation MeshUtils::singlePrecisionCopy(const Handle_Poly_Triangulation& triangulation)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    if (triangulation.IsNull() || !triangulation->IsDoublePrecision())
+        return triangulation;
+
+    const int nodeCount = triangulation->NbNodes();
+    const int triangleCount = triangulation->NbTriangles();
+    const bool hasUV = triangulation->HasUVNodes();
+    const bool hasNormals = triangulation->HasNormals();
+    Handle_Poly_Triangulation newTriangulation = new Poly_Triangulation;
+    // Has to be set before the node arrays are allocated
+    newTriangulation->SetDoublePrecision(false);
+    newTriangulation->ResizeNodes(nodeCount, false);
+    newTriangulation->ResizeTriangles(triangleCount, false);
+    if (hasUV)
+        newTriangulation->AddUVNodes();
+
+    if (hasNormals)
+        newTriangulation->AddNormals();
+
+    newTriangulation->Deflection(triangulation->Deflection());
+    newTriangulation->SetMeshPurpose(triangulation->MeshPurpose());
+    const int itemCount = std::max(nodeCount, triangleCount);
+    const int chunkCount = (itemCount + MeshChunkTriangleCount - 1) / MeshChunkTriangleCount;
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        const int iBegin = iChunk * MeshChunkTriangleCount;
+        const int iNodeEnd = std::min(iBegin + MeshChunkTriangleCount, nodeCount);
+        for (int i = iBegin + 1; i <= iNodeEnd; ++i) {
+            newTriangulation->SetNode(i, triangulation->Node(i));
+            if (hasUV)
+                newTriangulation->SetUVNode(i, triangulation->UVNode(i));
+
+            if (hasNormals) {
+                gp_Vec3f normal;
+                triangulation->Normal(i, normal);
+                newTriangulation->SetNormal(i, normal);
+            }
+        }
+
+        const int iTriangleEnd = std::min(iBegin + MeshChunkTriangleCount, triangleCount);
+        for (int i = iBegin + 1; i <= iTriangleEnd; ++i)
+            newTriangulation->SetTriangle(i, triangulation->Triangle(i));
+    });
+
+    return newTriangulation;
+#else
+    return triangulation;
+#endif
 }
 
 // Adapted from http://cs.smith.edu/~jorourke/Code/polyorient.C
@@ -6,7 +6,12 @@
 
 #pragma once
 
+#include "span.h"
+
+#include <Bnd_Box.hxx>
 #include <Poly_Triangulation.hxx>
+#include <gp_Pnt.hxx>
+#include <vector>
 class gp_XYZ;
 
 namespace Mayo {
@@ -18,6 +23,98 @@ struct MeshUtils {
     static double triangulationVolume(const Handle_Poly_Triangulation& triangulation);
     static double triangulationArea(const Handle_Poly_Triangulation& triangulation);
 
+    struct TriangulationProperties {
+        double area = 0.;
+        double volume = 0.; // Absolute value
+        // Center of mass of the enclosed volume, or of the surface if volume is null(open mesh)
+        gp_Pnt centroid;
+        Bnd_Box boundingBox;
+    };
+
+    // Computes all properties in a single traversal of the triangulation
+    // Triangles are processed concurrently by chunks, sums are compensated(Kahan-Babuska) and
+    // chunk results are reduced in order, so the result doesn't depend on thread scheduling
+    static TriangulationProperties triangulationProperties(const Handle_Poly_Triangulation& triangulation);
+
+    // Single-precision vectors stored as separate arrays of coordinates(structure of arrays)
+    // Note: index 0 is for the first triangle/node of the triangulation
+    struct VectorArrays {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        int size() const { return int(x.size()); }
+        void resize(int count) { x.resize(count); y.resize(count); z.resize(count); }
+    };
+
+    // Computes unit normal of each triangle, normal of degenerated triangle is the null vector
+    // Computation runs concurrently on ranges of triangles, with SIMD instructions(SSE2/NEON) if
+    // available
+    static VectorArrays triangleNormals(const Handle_Poly_Triangulation& triangulation);
+
+    // Computes unit normal of each node, as the area-weighted sum of normals of the triangles
+    // around the node
+    static VectorArrays nodeNormals(const Handle_Poly_Triangulation& triangulation);
+
+    // Reorders triangles in place for locality in the post-transform vertex cache of GPUs(Forsyth's
+    // linear-speed algorithm). Node indices aren't changed, so data referencing nodes(eg polygons
+    // on triangulation) stays valid
+    static void optimizeVertexCache(const Handle_Poly_Triangulation& triangulation);
+
+    // Returns a copy of 'triangulation' with triangles ordered as by optimizeVertexCache() and
+    // nodes(with normals and UV) renumbered by first use, for vertex fetch locality
+    static Handle_Poly_Triangulation vertexCacheOptimized(const Handle_Poly_Triangulation& triangulation);
+
+    // Returns a copy of 'triangulation' with normals at nodes for smooth shading. Normal at a
+    // triangle corner is the area-weighted average of the normals of the triangles around the
+    // node, not counting the ones making an angle greater than 'creaseAngle'(radians). So nodes
+    // are duplicated along crease edges, each copy having its own normal
+    // Corners are processed concurrently on ranges of nodes
+    static Handle_Poly_Triangulation smoothNormals(const Handle_Poly_Triangulation& triangulation, double creaseAngle);
+
+    // Returns a copy of 'triangulation' storing nodes and UV nodes in single precision, which
+    // halves their memory. Normals are single precision in any case
+    // Returns 'triangulation' itself if already single precision, or with OpenCascade < 7.6 where
+    // node arrays are always double precision
+    // Nodes of the copy must be read with Node(), not with the deprecated Nodes() array
+    static bool isSinglePrecision(const Handle_Poly_Triangulation& triangulation);
+    static Handle_Poly_Triangulation singlePrecisionCopy(const Handle_Poly_Triangulation& triangulation);
+
+    // Edge between two nodes, ids are the ones of Poly_Triangulation(ie starting at 1)
+    struct Edge {
+        int node1; // Lowest id
+        int node2;
+    };
+
+    // Side of a triangle, node ids are the ones of Poly_Triangulation(ie starting at 1)
+    struct TriangleSide {
+        int node1; // Lowest id
+        int node2;
+        int triangle; // Zero-based index
+        bool reversed; // Triangle runs the side from node2 to node1
+    };
+
+    // Sides of the triangles of a triangulation, grouped by the edge they lie on
+    struct EdgeSides {
+        // Sides of an edge are contiguous and sorted by triangle index, edges are sorted by node ids
+        std::vector<TriangleSide> vecSide;
+        // Position in 'vecSide' of the first side of each edge, followed by the count of sides
+        std::vector<int> vecEdgeSideBegin;
+        // Triangles having a node id outside [1, NbNodes()], their sides are ignored
+        int invalidTriangleCount = 0;
+
+        int edgeCount() const { return vecEdgeSideBegin.empty() ? 0 : int(vecEdgeSideBegin.size()) - 1; }
+        Span<const TriangleSide> sidesOfEdge(int iEdge) const;
+    };
+
+    // Returns the sides of the triangles of 'triangulation' grouped by edge, sides whose both ends
+    // are the same node are ignored. Sides are hashed concurrently on ranges of nodes
+    static EdgeSides edgeSides(const Handle_Poly_Triangulation& triangulation);
+
+    // Returns the boundary edges(used by a single triangle), non-manifold edges(used by more than
+    // two triangles) and crease edges(dihedral angle greater than 'creaseAngle' in radians) of
+    // 'triangulation', sorted by node ids(see edgeSides())
+    static std::vector<Edge> featureEdges(const Handle_Poly_Triangulation& triangulation, double creaseAngle);
+
     enum class Orientation {
         Unknown,
         Clockwise,
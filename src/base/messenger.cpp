@@ -5,6 +5,11 @@
 ****************************************************************************/
 
 #include "messenger.h"
+#include "qtcore_hfuncs.h"
+
+#include <QtCore/QTimer>
+#include <algorithm>
+#include <unordered_map>
 
 namespace Mayo {
 
@@ -34,13 +39,101 @@ MessengerQtSignal::MessengerQtSignal(QObject* parent)
     static bool metaTypesRegistered = false;
     if (!metaTypesRegistered) {
         qRegisterMetaType<MessageType>("Messenger::MessageType");
+        qRegisterMetaType<std::vector<Message>>("std::vector<Mayo::MessengerQtSignal::Message>");
         metaTypesRegistered = true;
     }
 }
 
+MessengerQtSignal::~MessengerQtSignal()
+{
+    QueueNode* node = m_queueHead.exchange(nullptr);
+    while (node) {
+        QueueNode* next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
 void MessengerQtSignal::emitMessage(MessageType msgType, const QString& text)
 {
-    emit this->message(msgType, text);
+    if (m_batchInterval.load(std::memory_order_relaxed) <= 0) {
+        emit this->message(msgType, text);
+        return;
+    }
+
+    auto node = new QueueNode{ { msgType, text }, nullptr };
+    node->next = m_queueHead.load(std::memory_order_relaxed);
+    while (!m_queueHead.compare_exchange_weak(
+               node->next, node, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+void MessengerQtSignal::setBatchInterval(int msecs)
+{
+    m_batchInterval = std::max(msecs, 0);
+    if (m_batchInterval > 0) {
+        if (!m_timerDrain) {
+            m_timerDrain = new QTimer(this);
+            QObject::connect(m_timerDrain, &QTimer::timeout, this, &MessengerQtSignal::drainQueue);
+        }
+
+        m_timerDrain->start(m_batchInterval);
+    }
+    else if (m_timerDrain) {
+        m_timerDrain->stop();
+        this->drainQueue(); // Messages still queued
+    }
+}
+
+void MessengerQtSignal::setMaxMessagesPerSecond(int count)
+{
+    m_maxMessagesPerSecond = std::max(count, 1);
+}
+
+void MessengerQtSignal::drainQueue()
+{
+    QueueNode* node = m_queueHead.exchange(nullptr, std::memory_order_acquire);
+    if (!node)
+        return;
+
+    // Queue is a stack, newest message first
+    std::vector<QueueNode*> vecNode;
+    for (; node; node = node->next)
+        vecNode.push_back(node);
+
+    std::vector<Message> vecMessage;
+    std::unordered_map<QString, size_t> mapKeyMessageIndex;
+    for (auto it = vecNode.rbegin(); it != vecNode.rend(); ++it) {
+        Message& msg = (*it)->message;
+        const QString key = QString::number(int(msg.type)) + ':' + msg.text;
+        auto itIndex = mapKeyMessageIndex.find(key);
+        if (itIndex != mapKeyMessageIndex.end()) {
+            ++(vecMessage.at(itIndex->second).count);
+        }
+        else {
+            mapKeyMessageIndex.insert({ key, vecMessage.size() });
+            vecMessage.push_back(std::move(msg));
+        }
+
+        delete *it;
+    }
+
+    emit this->messagesBatched(vecMessage);
+
+    const auto timeNow = std::chrono::steady_clock::now();
+    if (timeNow - m_rateWindowStart >= std::chrono::seconds(1)) {
+        m_rateWindowStart = timeNow;
+        m_rateWindowCount = 0;
+    }
+
+    for (const Message& msg : vecMessage) {
+        if (m_rateWindowCount >= m_maxMessagesPerSecond)
+            break;
+
+        emit this->message(msg.type, msg.text);
+        ++m_rateWindowCount;
+    }
 }
 
 MessengerQtSignal* MessengerQtSignal::defaultInstance()
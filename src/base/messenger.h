@@ -7,7 +7,11 @@
 #pragma once
 
 #include <QtCore/QObject>
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <vector>
+class QTimer;
 
 namespace Mayo {
 
@@ -30,13 +34,51 @@ public:
 class MessengerQtSignal : public QObject, public Messenger {
     Q_OBJECT
 public:
+    struct Message {
+        MessageType type = MessageType::Trace;
+        QString text;
+        int count = 1; // Count of identical messages coalesced
+    };
+
     MessengerQtSignal(QObject* parent = nullptr);
+    ~MessengerQtSignal();
+
+    // Safe to be called from any thread
     void emitMessage(MessageType msgType, const QString& text) override;
 
+    // Batch mode: messages are pushed in a lock-free queue, which is drained every 'msecs' by the
+    // thread of this object. Identical messages of a batch are coalesced, then signaled at once
+    // with messagesBatched(). Signal message() is still emitted but at most
+    // maxMessagesPerSecond() times per second, exceeding messages are only in messagesBatched()
+    // Batch mode is disabled if 'msecs' is 0(default), each message is then signaled right away
+    // from the emitting thread
+    // Must be called from the thread of this object
+    void setBatchInterval(int msecs);
+    int batchInterval() const { return m_batchInterval; }
+
+    int maxMessagesPerSecond() const { return m_maxMessagesPerSecond; }
+    void setMaxMessagesPerSecond(int count);
+
     static MessengerQtSignal* defaultInstance();
 
 signals:
     void message(Messenger::MessageType msgType, const QString& text);
+    void messagesBatched(const std::vector<Mayo::MessengerQtSignal::Message>& vecMessage);
+
+private:
+    void drainQueue();
+
+    struct QueueNode {
+        Message message;
+        QueueNode* next = nullptr;
+    };
+    // Producers push at the head, the consumer takes the whole list at once so there's no ABA issue
+    std::atomic<QueueNode*> m_queueHead = nullptr;
+    std::atomic<int> m_batchInterval = 0;
+    int m_maxMessagesPerSecond = 20;
+    QTimer* m_timerDrain = nullptr;
+    std::chrono::steady_clock::time_point m_rateWindowStart;
+    int m_rateWindowCount = 0; // Count of signals message() emitted since m_rateWindowStart
 };
 
 // Provides facility to construct a Messenger object from a lambda
@@ -63,3 +105,4 @@ private:
 
 #include <QtCore/QMetaType>
 Q_DECLARE_METATYPE(Mayo::Messenger::MessageType)
+Q_DECLARE_METATYPE(Mayo::MessengerQtSignal::Message)
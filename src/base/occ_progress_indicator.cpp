@@ -5,7 +5,6 @@
 ****************************************************************************/
 
 #include "occ_progress_indicator.h"
-#include "string_utils.h"
 #include "task_progress.h"
 
 namespace Mayo {
@@ -22,33 +21,64 @@ OccProgressIndicator::OccProgressIndicator(TaskProgress* progress)
 void OccProgressIndicator::Show(const Message_ProgressScope& scope, const bool isForce)
 {
     if (m_progress) {
-        if (scope.Name() && (scope.Name() != m_lastStepName || isForce)) {
-            m_progress->setStep(QString::fromUtf8(scope.Name()));
-            m_lastStepName = scope.Name();
-        }
-
         const double pc = this->GetPosition(); // Always within [0,1]
-        const int val = pc * 100;
-        if (m_lastProgress != val || isForce) {
-            m_progress->setValue(val);
-            m_lastProgress = val;
-        }
+        this->forwardToTaskProgress(scope.Name(), int(pc * 100), isForce);
     }
 }
 #else
-bool OccProgressIndicator::Show(const bool /*force*/)
+bool OccProgressIndicator::Show(const bool force)
 {
     if (m_progress) {
-        m_progress->setStep(StringUtils::fromUtf8(this->GetScope(1).GetName()));
+        // Scope names are kept by the indicator until the scope is closed
+        const Handle_TCollection_HAsciiString& name = this->GetScope(1).GetName();
         const double pc = this->GetPosition(); // Always within [0,1]
-        const int val = pc * 100;
-        m_progress->setValue(val);
+        this->forwardToTaskProgress(!name.IsNull() ? name->ToCString() : nullptr, int(pc * 100), force);
     }
 
     return true;
 }
 #endif
 
+void OccProgressIndicator::forwardToTaskProgress(const char* stepName, int value, bool isForce)
+{
+    if (stepName)
+        m_pendingStepName = stepName;
+
+    int pendingProgress = m_pendingProgress.load();
+    while (value > pendingProgress && !m_pendingProgress.compare_exchange_weak(pendingProgress, value)) {
+    }
+
+    if (isForce)
+        m_isForcePending = true;
+
+    // Forwarding thread may have missed updates done just before it released the mutex, so loop
+    // until the pending state is forwarded or another thread takes over
+    bool isStateForwarded = false;
+    while (!isStateForwarded) {
+        if (!m_mutexForward.try_lock())
+            return;
+
+        std::lock_guard<std::mutex> lock(m_mutexForward, std::adopt_lock);
+        const bool force = m_isForcePending.exchange(false);
+        const char* pendingStepName = m_pendingStepName;
+        if (pendingStepName && (pendingStepName != m_lastStepName || force)) {
+            m_progress->setStep(QString::fromUtf8(pendingStepName));
+            m_lastStepName = pendingStepName;
+        }
+
+        const int pendingValue = m_pendingProgress;
+        if (pendingValue >= 0 && (pendingValue != m_lastProgress || force)) {
+            m_progress->setValue(pendingValue);
+            m_lastProgress = pendingValue;
+        }
+
+        isStateForwarded =
+                m_pendingStepName.load() == m_lastStepName
+                && m_pendingProgress.load() == m_lastProgress
+                && !m_isForcePending;
+    }
+}
+
 bool OccProgressIndicator::UserBreak()
 {
     return TaskProgress::isAbortRequested(m_progress);
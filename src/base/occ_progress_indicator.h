@@ -9,10 +9,18 @@
 #include "tkernel_utils.h"
 #include <Message_ProgressIndicator.hxx>
 
+#include <atomic>
+#include <mutex>
+
 namespace Mayo {
 
 class TaskProgress;
 
+// Bridges OpenCascade progress to TaskProgress
+// Show() can be called concurrently by OpenCascade parallel algorithms(eg meshing, translators):
+// progress value and step name are accumulated atomically, and only one thread at a time
+// forwards them to TaskProgress. Other threads just return, their updates being picked up by the
+// forwarding thread
 class OccProgressIndicator : public Message_ProgressIndicator {
 public:
     OccProgressIndicator(TaskProgress* progress);
@@ -26,7 +34,15 @@ public:
 #endif
 
 private:
+    void forwardToTaskProgress(const char* stepName, int value, bool isForce);
+
     TaskProgress* m_progress = nullptr;
+    // Latest state reported by OpenCascade, values never decrease
+    std::atomic<const char*> m_pendingStepName = nullptr;
+    std::atomic<int> m_pendingProgress = -1;
+    std::atomic<bool> m_isForcePending = false;
+    // State forwarded to TaskProgress, only accessed by the thread owning m_mutexForward
+    std::mutex m_mutexForward;
     const char* m_lastStepName = nullptr;
     int m_lastProgress = -1;
 };
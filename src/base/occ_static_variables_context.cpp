@@ -0,0 +1,136 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "occ_static_variables_context.h"
+#include "occ_static_variables_rollback.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace Mayo {
+namespace IO {
+
+struct OccStaticVariablesScope::Private {
+    // Process-wide state of the static variables changed by active scopes
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cond;
+        OccStaticVariablesContext activeContext; // Union of the contexts of active scopes
+        std::unique_ptr<OccStaticVariablesRollback> ptrRollback;
+        int activeScopeCount = 0;
+        int waitingScopeCount = 0;
+    };
+
+    static State& state()
+    {
+        static State state;
+        return state;
+    }
+};
+
+void OccStaticVariablesContext::change(const char* strKey, int newValue)
+{
+    this->setRecord(strKey, StaticVariableRecord::Value(newValue));
+}
+
+void OccStaticVariablesContext::change(const char* strKey, double newValue)
+{
+    this->setRecord(strKey, StaticVariableRecord::Value(newValue));
+}
+
+void OccStaticVariablesContext::change(const char* strKey, std::string_view newValue)
+{
+    this->setRecord(strKey, StaticVariableRecord::Value(std::string(newValue)));
+}
+
+void OccStaticVariablesContext::setRecord(const char* strKey, StaticVariableRecord::Value&& value)
+{
+    auto itRecord = std::find_if(m_vecRecord.begin(), m_vecRecord.end(), [=](const auto& record) {
+        return record.strKey == strKey;
+    });
+    if (itRecord != m_vecRecord.end())
+        itRecord->value = std::move(value);
+    else
+        m_vecRecord.push_back({ strKey, std::move(value) });
+}
+
+bool OccStaticVariablesContext::isCompatible(const OccStaticVariablesContext& other) const
+{
+    for (const StaticVariableRecord& record : m_vecRecord) {
+        const StaticVariableRecord* otherRecord = other.findRecord(record.strKey);
+        if (otherRecord && otherRecord->value != record.value)
+            return false;
+    }
+
+    return true;
+}
+
+const OccStaticVariablesContext::StaticVariableRecord*
+OccStaticVariablesContext::findRecord(std::string_view strKey) const
+{
+    for (const StaticVariableRecord& record : m_vecRecord) {
+        if (record.strKey == strKey)
+            return &record;
+    }
+
+    return nullptr;
+}
+
+OccStaticVariablesScope::OccStaticVariablesScope(const OccStaticVariablesContext& context)
+{
+    Private::State& state = Private::state();
+    std::unique_lock<std::mutex> lock(state.mutex);
+    // New compatible scopes don't overtake waiting ones, so a conflicting scope can't be starved
+    const bool canEnterNow =
+            state.activeScopeCount == 0
+            || (state.waitingScopeCount == 0 && state.activeContext.isCompatible(context));
+    if (!canEnterNow) {
+        ++state.waitingScopeCount;
+        state.cond.wait(lock, [&]{
+            return state.activeScopeCount == 0 || state.activeContext.isCompatible(context);
+        });
+        --state.waitingScopeCount;
+    }
+
+    if (!state.ptrRollback)
+        state.ptrRollback = std::make_unique<OccStaticVariablesRollback>();
+
+    OccStaticVariablesRollback* rollback = state.ptrRollback.get();
+    for (const auto& record : context.m_vecRecord) {
+        if (state.activeContext.findRecord(record.strKey))
+            continue; // Already applied by a compatible scope
+
+        const char* strKey = record.strKey.c_str();
+        if (std::holds_alternative<int>(record.value))
+            rollback->change(strKey, std::get<int>(record.value));
+        else if (std::holds_alternative<double>(record.value))
+            rollback->change(strKey, std::get<double>(record.value));
+        else if (std::holds_alternative<std::string>(record.value))
+            rollback->change(strKey, std::string_view(std::get<std::string>(record.value)));
+
+        state.activeContext.m_vecRecord.push_back(record);
+    }
+
+    ++state.activeScopeCount;
+}
+
+OccStaticVariablesScope::~OccStaticVariablesScope()
+{
+    Private::State& state = Private::state();
+    std::unique_lock<std::mutex> lock(state.mutex);
+    --state.activeScopeCount;
+    if (state.activeScopeCount == 0) {
+        state.ptrRollback.reset(); // Restore previous values of static variables
+        state.activeContext.m_vecRecord.clear();
+        lock.unlock();
+        state.cond.notify_all();
+    }
+}
+
+} // namespace IO
+} // namespace Mayo
@@ -0,0 +1,71 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace Mayo {
+namespace IO {
+
+// Snapshot of OpenCascade static variables(see Interface_Static) values required by some
+// translation work(eg reading a STEP file)
+// Values are not applied until an OccStaticVariablesScope object is created for the context
+class OccStaticVariablesContext {
+public:
+    void change(const char* strKey, int newValue);
+    void change(const char* strKey, double newValue);
+    void change(const char* strKey, std::string_view newValue);
+
+    // Whether this context and 'other' don't request distinct values for the same variable
+    bool isCompatible(const OccStaticVariablesContext& other) const;
+
+private:
+    friend class OccStaticVariablesScope;
+
+    struct StaticVariableRecord {
+        using Value = std::variant<int, double, std::string>;
+
+        std::string strKey;
+        Value value;
+    };
+
+    void setRecord(const char* strKey, StaticVariableRecord::Value&& value);
+    const StaticVariableRecord* findRecord(std::string_view strKey) const;
+
+    std::vector<StaticVariableRecord> m_vecRecord;
+};
+
+// Applies the values of an OccStaticVariablesContext for the lifetime of the scope object
+// Scopes having compatible contexts are active concurrently: N translations sharing the same
+// parameters run in parallel. A scope whose context conflicts with the active values blocks until
+// all active scopes are released, then previous values of static variables are restored and the
+// new context gets applied
+//
+// Typical usage:
+//     OccStaticVariablesContext context;
+//     context.change("read.step.product.context", 1);
+//     {
+//         OccStaticVariablesScope scope(context);
+//         // Read STEP file(s) ...
+//     }
+class OccStaticVariablesScope {
+public:
+    OccStaticVariablesScope(const OccStaticVariablesContext& context);
+    ~OccStaticVariablesScope();
+
+    OccStaticVariablesScope(const OccStaticVariablesScope&) = delete;
+    OccStaticVariablesScope& operator=(const OccStaticVariablesScope&) = delete;
+
+private:
+    struct Private;
+};
+
+} // namespace IO
+} // namespace Mayo
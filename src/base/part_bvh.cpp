@@ -0,0 +1,326 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "part_bvh.h"
+#include "cpp_utils.h"
+#include "document.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace Mayo {
+
+namespace {
+
+constexpr uint32_t MaxLeafItemCount = 4;
+
+BndBoxCoords unitedBox(const BndBoxCoords& lhs, const BndBoxCoords& rhs)
+{
+    return {
+        std::min(lhs.xmin, rhs.xmin), std::min(lhs.ymin, rhs.ymin), std::min(lhs.zmin, rhs.zmin),
+        std::max(lhs.xmax, rhs.xmax), std::max(lhs.ymax, rhs.ymax), std::max(lhs.zmax, rhs.zmax)
+    };
+}
+
+double boxCenterCoord(const BndBoxCoords& box, int axis)
+{
+    switch (axis) {
+    case 0: return (box.xmin + box.xmax) / 2.;
+    case 1: return (box.ymin + box.ymax) / 2.;
+    default: return (box.zmin + box.zmax) / 2.;
+    }
+}
+
+bool boxesOverlap(const BndBoxCoords& lhs, const BndBoxCoords& rhs)
+{
+    return lhs.xmin <= rhs.xmax && rhs.xmin <= lhs.xmax
+            && lhs.ymin <= rhs.ymax && rhs.ymin <= lhs.ymax
+            && lhs.zmin <= rhs.zmax && rhs.zmin <= lhs.zmax;
+}
+
+// Slab test, 'invDir' is the inverse of ray direction components
+// Returns distance along the ray where it enters 'box', or a negative value if ray misses box
+double rayBoxDistance(const BndBoxCoords& box, const gp_XYZ& origin, const gp_XYZ& invDir)
+{
+    auto fnSlab = [](double bmin, double bmax, double o, double inv) {
+        const double t1 = (bmin - o) * inv;
+        const double t2 = (bmax - o) * inv;
+        return std::make_pair(std::min(t1, t2), std::max(t1, t2));
+    };
+    const auto [txmin, txmax] = fnSlab(box.xmin, box.xmax, origin.X(), invDir.X());
+    const auto [tymin, tymax] = fnSlab(box.ymin, box.ymax, origin.Y(), invDir.Y());
+    const auto [tzmin, tzmax] = fnSlab(box.zmin, box.zmax, origin.Z(), invDir.Z());
+    const double tmin = std::max({ txmin, tymin, tzmin, 0. });
+    const double tmax = std::min({ txmax, tymax, tzmax });
+    return tmin <= tmax ? tmin : -1.;
+}
+
+// Box is outside of the half-space if its vertex the farthest along the plane normal is outside
+bool boxOutsideHalfSpace(const BndBoxCoords& box, const gp_Pln& plane)
+{
+    const gp_XYZ normal = plane.Axis().Direction().XYZ();
+    const gp_XYZ farthest(
+                normal.X() >= 0 ? box.xmax : box.xmin,
+                normal.Y() >= 0 ? box.ymax : box.ymin,
+                normal.Z() >= 0 ? box.zmax : box.zmin);
+    return normal.Dot(farthest - plane.Location().XYZ()) < 0;
+}
+
+// Appends the nodes bounding items [first, last), items are reordered so each leaf node refers to
+// a contiguous range. Split is done at the median of box centers, along the largest axis
+void buildNodes(PartBvh::EntityTree* tree, uint32_t first, uint32_t last)
+{
+    std::vector<PartBvh::Item>& vecItem = tree->vecItem;
+    const auto nodeIndex = uint32_t(tree->vecNode.size());
+    tree->vecNode.push_back({});
+    BndBoxCoords box = vecItem.at(first).box;
+    BndBoxCoords centerBox = { 0, 0, 0, 0, 0, 0 };
+    for (uint32_t i = first; i < last; ++i) {
+        const BndBoxCoords& itemBox = vecItem.at(i).box;
+        box = unitedBox(box, itemBox);
+        const gp_Pnt center = itemBox.center();
+        const BndBoxCoords pntBox = { center.X(), center.Y(), center.Z(), center.X(), center.Y(), center.Z() };
+        centerBox = i != first ? unitedBox(centerBox, pntBox) : pntBox;
+    }
+
+    tree->vecNode.at(nodeIndex).box = box;
+    if (last - first <= MaxLeafItemCount) {
+        tree->vecNode.at(nodeIndex).index = first;
+        tree->vecNode.at(nodeIndex).itemCount = last - first;
+        return;
+    }
+
+    const double extents[] = {
+        centerBox.xmax - centerBox.xmin, centerBox.ymax - centerBox.ymin, centerBox.zmax - centerBox.zmin
+    };
+    const int axis = int(std::max_element(std::begin(extents), std::end(extents)) - std::begin(extents));
+    const uint32_t middle = first + (last - first) / 2;
+    std::nth_element(
+                vecItem.begin() + first, vecItem.begin() + middle, vecItem.begin() + last,
+                [=](const PartBvh::Item& lhs, const PartBvh::Item& rhs) {
+        return boxCenterCoord(lhs.box, axis) < boxCenterCoord(rhs.box, axis);
+    });
+    buildNodes(tree, first, middle);
+    tree->vecNode.at(nodeIndex).index = uint32_t(tree->vecNode.size());
+    tree->vecNode.at(nodeIndex).itemCount = 0;
+    buildNodes(tree, middle, last);
+}
+
+} // namespace
+
+PartBvh::EntityTree PartBvh::buildEntityTree(const DocumentPtr& doc, TreeNodeId entityTreeNodeId)
+{
+    EntityTree tree;
+    tree.entityTreeNodeId = entityTreeNodeId;
+    const Tree<TDF_Label>& modelTree = doc->modelTree();
+    std::vector<TreeNodeId> vecLeafId;
+    traverseTree(entityTreeNodeId, modelTree, [&](TreeNodeId id) {
+        if (modelTree.nodeIsLeaf(id))
+            vecLeafId.push_back(id);
+    });
+
+    // Box of each part is its product box moved to the part location, both are cached
+    std::vector<Bnd_Box> vecLeafBndBox(vecLeafId.size());
+    CppUtils::parallelFor(int(vecLeafId.size()), [&](int i) {
+        const TreeNodeId leafId = vecLeafId.at(i);
+        const Bnd_Box productBndBox = doc->shapeBoundingBox(modelTree.nodeData(leafId));
+        if (!productBndBox.IsVoid() && !modelTree.nodeIsRoot(leafId)) {
+            const TopLoc_Location loc = doc->xcaf().shapeAbsoluteLocation(leafId);
+            vecLeafBndBox.at(i) = productBndBox.Transformed(loc.Transformation());
+        }
+        else {
+            vecLeafBndBox.at(i) = productBndBox;
+        }
+    });
+
+    for (size_t i = 0; i < vecLeafId.size(); ++i) {
+        const Bnd_Box& bndBox = vecLeafBndBox.at(i);
+        if (bndBox.IsVoid())
+            continue;
+
+        // Same convention as graphics objects: instance of a product is the node referring to it
+        TreeNodeId partId = vecLeafId.at(i);
+        const TreeNodeId parentId = modelTree.nodeParent(partId);
+        if (parentId != 0 && XCaf::isShapeReference(modelTree.nodeData(parentId)))
+            partId = parentId;
+
+        tree.vecItem.push_back({ partId, BndBoxCoords::get(bndBox) });
+    }
+
+    if (!tree.vecItem.empty()) {
+        tree.vecNode.reserve(2 * (tree.vecItem.size() / MaxLeafItemCount) + 1);
+        buildNodes(&tree, 0, uint32_t(tree.vecItem.size()));
+    }
+
+    return tree;
+}
+
+void PartBvh::addEntity(EntityTree&& tree)
+{
+    this->removeEntity(tree.entityTreeNodeId);
+    m_vecEntityTree.push_back(std::move(tree));
+}
+
+void PartBvh::addEntity(const DocumentPtr& doc, TreeNodeId entityTreeNodeId)
+{
+    this->addEntity(PartBvh::buildEntityTree(doc, entityTreeNodeId));
+}
+
+void PartBvh::removeEntity(TreeNodeId entityTreeNodeId)
+{
+    auto itRemoved = std::remove_if(
+                m_vecEntityTree.begin(), m_vecEntityTree.end(), [=](const EntityTree& tree) {
+        return tree.entityTreeNodeId == entityTreeNodeId;
+    });
+    m_vecEntityTree.erase(itRemoved, m_vecEntityTree.end());
+}
+
+size_t PartBvh::partCount() const
+{
+    size_t count = 0;
+    for (const EntityTree& tree : m_vecEntityTree)
+        count += tree.vecItem.size();
+
+    return count;
+}
+
+Bnd_Box PartBvh::boundingBox() const
+{
+    Bnd_Box bndBox;
+    for (const EntityTree& tree : m_vecEntityTree) {
+        if (!tree.vecNode.empty()) {
+            const BndBoxCoords& box = tree.vecNode.front().box;
+            bndBox.Update(box.xmin, box.ymin, box.zmin, box.xmax, box.ymax, box.zmax);
+        }
+    }
+
+    return bndBox;
+}
+
+// Calls 'fnItem' for each item whose box and parent node boxes pass 'fnNodeTest'
+template<typename NODE_TEST, typename ITEM_FN>
+void PartBvh::visit(NODE_TEST fnNodeTest, ITEM_FN fnItem) const
+{
+    std::vector<uint32_t> stackNodeIndex;
+    for (const EntityTree& tree : m_vecEntityTree) {
+        if (tree.vecNode.empty())
+            continue;
+
+        stackNodeIndex.push_back(0);
+        while (!stackNodeIndex.empty()) {
+            const uint32_t nodeIndex = stackNodeIndex.back();
+            stackNodeIndex.pop_back();
+            const Node& node = tree.vecNode.at(nodeIndex);
+            if (!fnNodeTest(node.box))
+                continue;
+
+            if (node.itemCount > 0) {
+                for (uint32_t i = node.index; i < node.index + node.itemCount; ++i) {
+                    const Item& item = tree.vecItem.at(i);
+                    if (fnNodeTest(item.box))
+                        fnItem(item);
+                }
+            }
+            else {
+                stackNodeIndex.push_back(node.index);
+                stackNodeIndex.push_back(nodeIndex + 1);
+            }
+        }
+    }
+}
+
+std::vector<std::pair<PartBvh::Item, PartBvh::Item>> PartBvh::findOverlappingPairs() const
+{
+    std::vector<std::pair<Item, Item>> vecPair;
+    std::vector<uint32_t> stackNodeIndex;
+    for (size_t i = 0; i < m_vecEntityTree.size(); ++i) {
+        const EntityTree& tree = m_vecEntityTree.at(i);
+        for (size_t itemIndex = 0; itemIndex < tree.vecItem.size(); ++itemIndex) {
+            const Item& item = tree.vecItem.at(itemIndex);
+            // Items of previous trees were already paired with this one
+            for (size_t j = i; j < m_vecEntityTree.size(); ++j) {
+                const EntityTree& otherTree = m_vecEntityTree.at(j);
+                if (otherTree.vecNode.empty())
+                    continue;
+
+                stackNodeIndex.push_back(0);
+                while (!stackNodeIndex.empty()) {
+                    const uint32_t nodeIndex = stackNodeIndex.back();
+                    stackNodeIndex.pop_back();
+                    const Node& node = otherTree.vecNode.at(nodeIndex);
+                    if (!boxesOverlap(node.box, item.box))
+                        continue;
+
+                    if (node.itemCount == 0) {
+                        stackNodeIndex.push_back(node.index);
+                        stackNodeIndex.push_back(nodeIndex + 1);
+                        continue;
+                    }
+
+                    for (uint32_t k = node.index; k < node.index + node.itemCount; ++k) {
+                        const Item& otherItem = otherTree.vecItem.at(k);
+                        const bool isPairOrdered = j > i || k > itemIndex;
+                        if (isPairOrdered && boxesOverlap(item.box, otherItem.box))
+                            vecPair.push_back({ item, otherItem });
+                    }
+                }
+            }
+        }
+    }
+
+    return vecPair;
+}
+
+std::vector<TreeNodeId> PartBvh::findInBox(const Bnd_Box& box) const
+{
+    std::vector<TreeNodeId> vecNodeId;
+    if (box.IsVoid())
+        return vecNodeId;
+
+    const BndBoxCoords coords = BndBoxCoords::get(box);
+    this->visit(
+                [&](const BndBoxCoords& nodeBox) { return boxesOverlap(nodeBox, coords); },
+                [&](const Item& item) { vecNodeId.push_back(item.nodeId); });
+    return vecNodeId;
+}
+
+std::vector<TreeNodeId> PartBvh::findAlongRay(const gp_Ax1& ray) const
+{
+    const gp_XYZ origin = ray.Location().XYZ();
+    const gp_XYZ dir = ray.Direction().XYZ();
+    // Division by zero gives infinity, which is expected by the slab test
+    const gp_XYZ invDir(1. / dir.X(), 1. / dir.Y(), 1. / dir.Z());
+    std::vector<std::pair<double, TreeNodeId>> vecHit;
+    this->visit(
+                [&](const BndBoxCoords& nodeBox) { return rayBoxDistance(nodeBox, origin, invDir) >= 0; },
+                [&](const Item& item) {
+        vecHit.push_back({ rayBoxDistance(item.box, origin, invDir), item.nodeId });
+    });
+    std::sort(vecHit.begin(), vecHit.end());
+    std::vector<TreeNodeId> vecNodeId;
+    vecNodeId.reserve(vecHit.size());
+    for (const auto& hit : vecHit)
+        vecNodeId.push_back(hit.second);
+
+    return vecNodeId;
+}
+
+std::vector<TreeNodeId> PartBvh::findInFrustum(Span<const gp_Pln> spanPlane) const
+{
+    std::vector<TreeNodeId> vecNodeId;
+    auto fnInside = [=](const BndBoxCoords& nodeBox) {
+        for (const gp_Pln& plane : spanPlane) {
+            if (boxOutsideHalfSpace(nodeBox, plane))
+                return false;
+        }
+
+        return true;
+    };
+    this->visit(fnInside, [&](const Item& item) { vecNodeId.push_back(item.nodeId); });
+    return vecNodeId;
+}
+
+} // namespace Mayo
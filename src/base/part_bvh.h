@@ -0,0 +1,75 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "bnd_utils.h"
+#include "document_ptr.h"
+#include "libtree.h"
+#include "span.h"
+
+#include <Bnd_Box.hxx>
+#include <gp_Ax1.hxx>
+#include <gp_Pln.hxx>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Mayo {
+
+// Bounding volume hierarchy(BVH) of the parts of a document, ie the leaf instances of the model
+// tree bounded by their world-space box
+// There is one hierarchy per entity, so entities can be added and removed independently
+// Boxes of the parts are computed from Document::shapeBoundingBox() and the absolute locations
+// cached by XCaf
+class PartBvh {
+public:
+    struct Node {
+        BndBoxCoords box;
+        uint32_t index; // First item if leaf node, otherwise right child(left child is next node)
+        uint32_t itemCount; // Zero if not a leaf node
+    };
+
+    struct Item {
+        TreeNodeId nodeId; // Model tree node of the part instance
+        BndBoxCoords box;
+    };
+
+    // Hierarchy of a single entity, can be built from any thread
+    struct EntityTree {
+        TreeNodeId entityTreeNodeId = 0;
+        std::vector<Node> vecNode; // Root node comes first
+        std::vector<Item> vecItem;
+    };
+
+    static EntityTree buildEntityTree(const DocumentPtr& doc, TreeNodeId entityTreeNodeId);
+
+    void addEntity(EntityTree&& tree);
+    void addEntity(const DocumentPtr& doc, TreeNodeId entityTreeNodeId);
+    void removeEntity(TreeNodeId entityTreeNodeId);
+    void clear() { m_vecEntityTree.clear(); }
+
+    size_t partCount() const;
+    Bnd_Box boundingBox() const;
+
+    // Pairs of distinct parts whose boxes intersect, each pair is reported once
+    std::vector<std::pair<Item, Item>> findOverlappingPairs() const;
+    // Parts whose box intersects 'box'
+    std::vector<TreeNodeId> findInBox(const Bnd_Box& box) const;
+    // Parts whose box is crossed by 'ray', sorted by increasing distance along the ray
+    std::vector<TreeNodeId> findAlongRay(const gp_Ax1& ray) const;
+    // Parts whose box isn't fully outside of the half-spaces defined by 'spanPlane', the normal of
+    // each plane(ie direction of its axis) points to the inside of the frustum
+    std::vector<TreeNodeId> findInFrustum(Span<const gp_Pln> spanPlane) const;
+
+private:
+    template<typename NODE_TEST, typename ITEM_FN>
+    void visit(NODE_TEST fnNodeTest, ITEM_FN fnItem) const;
+
+    std::vector<EntityTree> m_vecEntityTree;
+};
+
+} // namespace Mayo
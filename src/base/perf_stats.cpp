@@ -0,0 +1,175 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "perf_stats.h"
+#include "global.h"
+#include "string_utils.h"
+#include "task_manager.h"
+#include "task_progress.h"
+#include "trace_recorder.h"
+
+#include <algorithm>
+#include <locale>
+#include <sstream>
+
+namespace Mayo {
+
+namespace {
+
+double toMilliseconds(std::chrono::nanoseconds duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+} // namespace
+
+std::atomic<bool> PerfStats::s_enabled = false;
+
+void PerfStats::setEnabled(bool on)
+{
+    s_enabled.store(on, std::memory_order_relaxed);
+}
+
+PerfStats* PerfStats::global()
+{
+    static PerfStats stats;
+    return &stats;
+}
+
+PerfStats* PerfStats::of(const TaskProgress* progress)
+{
+    if (!PerfStats::isEnabled() || !progress || !progress->taskManager())
+        return nullptr;
+
+    return progress->taskManager()->perfStats(progress->taskId());
+}
+
+void PerfStats::addStageDuration(std::string_view name, std::chrono::nanoseconds duration)
+{
+    const std::thread::id threadId = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    auto it = std::find_if(
+                m_vecStageRecord.begin(), m_vecStageRecord.end(),
+                [=](const StageRecord& record) { return record.stage.name == name; });
+    if (it == m_vecStageRecord.end()) {
+        m_vecStageRecord.push_back({});
+        it = m_vecStageRecord.end() - 1;
+        it->stage.name = name;
+    }
+
+    Stage& stage = it->stage;
+    ++stage.callCount;
+    stage.totalDuration += duration;
+    stage.maxDuration = std::max(stage.maxDuration, duration);
+    if (std::find(it->vecThreadId.cbegin(), it->vecThreadId.cend(), threadId) == it->vecThreadId.cend()) {
+        it->vecThreadId.push_back(threadId);
+        stage.threadCount = int(it->vecThreadId.size());
+    }
+}
+
+void PerfStats::addCounter(std::string_view name, int64_t delta)
+{
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    auto it = std::find_if(
+                m_vecCounter.begin(), m_vecCounter.end(),
+                [=](const Counter& counter) { return counter.name == name; });
+    if (it != m_vecCounter.end())
+        it->value += delta;
+    else
+        m_vecCounter.push_back({ std::string(name), delta });
+}
+
+std::vector<PerfStats::Stage> PerfStats::stages() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    std::vector<Stage> vecStage;
+    vecStage.reserve(m_vecStageRecord.size());
+    for (const StageRecord& record : m_vecStageRecord)
+        vecStage.push_back(record.stage);
+
+    return vecStage;
+}
+
+std::vector<PerfStats::Counter> PerfStats::counters() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    return m_vecCounter;
+}
+
+bool PerfStats::isEmpty() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    return m_vecStageRecord.empty() && m_vecCounter.empty();
+}
+
+void PerfStats::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    m_vecStageRecord.clear();
+    m_vecCounter.clear();
+}
+
+std::string PerfStats::toJson(std::string_view name) const
+{
+    const std::vector<Stage> vecStage = this->stages();
+    const std::vector<Counter> vecCounter = this->counters();
+    std::ostringstream ostr;
+    ostr.imbue(std::locale::classic());
+    ostr << '{';
+    if (!name.empty()) {
+        ostr << "\"name\":";
+        ostr << StringUtils::jsonQuoted(name);
+        ostr << ',';
+    }
+
+    ostr << "\"stages\":[";
+    for (const Stage& stage : vecStage) {
+        if (&stage != &vecStage.front())
+            ostr << ',';
+
+        ostr << "{\"name\":";
+        ostr << StringUtils::jsonQuoted(stage.name);
+        ostr << ",\"calls\":" << stage.callCount
+             << ",\"totalMs\":" << toMilliseconds(stage.totalDuration)
+             << ",\"maxMs\":" << toMilliseconds(stage.maxDuration)
+             << ",\"threads\":" << stage.threadCount
+             << '}';
+    }
+
+    ostr << "],\"counters\":[";
+    for (const Counter& counter : vecCounter) {
+        if (&counter != &vecCounter.front())
+            ostr << ',';
+
+        ostr << "{\"name\":";
+        ostr << StringUtils::jsonQuoted(counter.name);
+        ostr << ",\"value\":" << counter.value << '}';
+    }
+
+    ostr << "]}";
+    return ostr.str();
+}
+
+PerfScopedTimer::PerfScopedTimer(PerfStats* stats, std::string_view stageName)
+    : m_stats(PerfStats::isEnabled() ? stats : nullptr),
+      m_stageName(stageName)
+{
+    if (m_stats)
+        m_startTime = std::chrono::steady_clock::now();
+}
+
+PerfScopedTimer::~PerfScopedTimer()
+{
+    if (!m_stats)
+        return;
+
+    const auto endTime = std::chrono::steady_clock::now();
+    m_stats->addStageDuration(m_stageName, endTime - m_startTime);
+    if (TraceRecorder::isRecording())
+        TraceRecorder::global()->addScope(m_stageName, m_startTime, endTime);
+}
+
+} // namespace Mayo
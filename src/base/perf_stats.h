@@ -0,0 +1,93 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Collector of timed stages and counters, identified by name("io.read", "io.transfer", ...)
+// Records can be added concurrently from any thread
+// Instrumentation is globally disabled by default, see setEnabled()
+class PerfStats {
+public:
+    struct Stage {
+        std::string name;
+        int callCount = 0;
+        std::chrono::nanoseconds totalDuration = {};
+        std::chrono::nanoseconds maxDuration = {};
+        int threadCount = 0; // Count of distinct threads that recorded the stage
+    };
+
+    struct Counter {
+        std::string name;
+        int64_t value = 0;
+    };
+
+    // When disabled, PerfScopedTimer objects don't read the clock and of() returns nullptr
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool on);
+
+    // Collector for records not bound to a task(eg in the GUI thread)
+    static PerfStats* global();
+    // Collector of the task owning 'progress', nullptr if instrumentation is disabled
+    static PerfStats* of(const TaskProgress* progress);
+
+    void addStageDuration(std::string_view name, std::chrono::nanoseconds duration);
+    void addCounter(std::string_view name, int64_t delta = 1);
+
+    // Stages and counters are returned in order of first record
+    std::vector<Stage> stages() const;
+    std::vector<Counter> counters() const;
+    bool isEmpty() const;
+    void clear();
+
+    // Example: {"name":"Import","stages":[{"name":"io.read","calls":2,"totalMs":12.5,"maxMs":8.1,
+    //           "threads":2}],"counters":[{"name":"io.files","value":2}]}
+    // Key "name" is omitted if 'name' is empty
+    std::string toJson(std::string_view name = {}) const;
+
+private:
+    struct StageRecord {
+        Stage stage;
+        std::vector<std::thread::id> vecThreadId;
+    };
+
+    static std::atomic<bool> s_enabled;
+    mutable std::mutex m_mutex;
+    std::vector<StageRecord> m_vecStageRecord;
+    std::vector<Counter> m_vecCounter;
+};
+
+// Adds the time elapsed during its lifetime as a stage of some PerfStats object, and as a scope
+// event of TraceRecorder::global() if recording
+// Does nothing if 'stats' is null or instrumentation is disabled
+class PerfScopedTimer {
+public:
+    PerfScopedTimer(PerfStats* stats, std::string_view stageName);
+    ~PerfScopedTimer();
+
+    // Disable copy
+    PerfScopedTimer(const PerfScopedTimer&) = delete;
+    PerfScopedTimer& operator=(const PerfScopedTimer&) = delete;
+
+private:
+    PerfStats* m_stats = nullptr;
+    std::string_view m_stageName;
+    std::chrono::steady_clock::time_point m_startTime;
+};
+
+} // namespace Mayo
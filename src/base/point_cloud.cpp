@@ -0,0 +1,303 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "point_cloud.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QTemporaryFile>
+#include <Standard_GUID.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace Mayo {
+
+PointCloud::PointCloud(const Options& options)
+    : m_options(options)
+{
+    m_options.nodeGridSize = std::clamp(m_options.nodeGridSize, 1, 1024);
+    m_options.maxDepth = std::max(m_options.maxDepth, 0);
+}
+
+PointCloud::~PointCloud()
+{
+}
+
+void PointCloud::setBoundsHint(const Bnd_Box& bndBox)
+{
+    m_bndBoxHint = bndBox;
+}
+
+void PointCloud::addPoints(Span<const gp_Pnt> spanPnt, Span<const uint32_t> spanRgb)
+{
+    if (spanPnt.empty())
+        return;
+
+    const bool hasRgb = !spanRgb.empty() && spanRgb.size() == spanPnt.size();
+    m_hasColors = m_hasColors || hasRgb;
+    if (m_rootNodeId < 0) {
+        Bnd_Box bndBox = m_bndBoxHint;
+        if (bndBox.IsVoid()) {
+            for (const gp_Pnt& pnt : spanPnt)
+                bndBox.Add(pnt);
+        }
+
+        this->initRoot(bndBox);
+    }
+
+    for (unsigned i = 0; i < spanPnt.size(); ++i) {
+        const gp_Pnt& pnt = spanPnt[i];
+        m_bndBox.Add(pnt);
+        while (!this->rootContains(pnt))
+            this->growRoot(pnt);
+
+        this->insertPoint(pnt, hasRgb ? spanRgb[i] : 0xFFFFFF);
+    }
+
+    m_pointCount += spanPnt.size();
+    if (m_inMemoryPointCount > m_options.maxInMemoryPointCount)
+        this->spillToPageFile();
+}
+
+void PointCloud::finishBuild()
+{
+    for (NodeStorage& storage : m_vecNodeStorage)
+        std::vector<uint64_t>().swap(storage.vecCellBits);
+
+    if (m_pageFile)
+        m_pageFile->flush();
+}
+
+std::vector<PointCloud::Point> PointCloud::nodePoints(int nodeId) const
+{
+    const NodeStorage& storage = m_vecNodeStorage.at(nodeId);
+    std::vector<Point> vecPoint;
+    vecPoint.reserve(m_vecNode.at(nodeId).pointCount);
+    if (!storage.vecSegment.empty()) {
+        std::lock_guard<std::mutex> lock(m_pageFileMutex);
+        for (const PageSegment& segment : storage.vecSegment) {
+            const size_t pos = vecPoint.size();
+            vecPoint.resize(pos + segment.count);
+            const qint64 byteCount = qint64(segment.count) * qint64(sizeof(Point));
+            if (!m_pageFile->seek(segment.offset)
+                    || m_pageFile->read(reinterpret_cast<char*>(vecPoint.data() + pos), byteCount) != byteCount)
+            {
+                vecPoint.resize(pos); // Page file unreadable, points are dropped
+            }
+        }
+    }
+
+    vecPoint.insert(vecPoint.end(), storage.vecPoint.cbegin(), storage.vecPoint.cend());
+    return vecPoint;
+}
+
+int PointCloud::newNode(const gp_Pnt& center, double halfSize)
+{
+    Node node;
+    node.center = center;
+    node.halfSize = halfSize;
+    m_vecNode.push_back(node);
+    m_vecNodeStorage.emplace_back();
+    return int(m_vecNode.size()) - 1;
+}
+
+void PointCloud::initRoot(const Bnd_Box& bndBox)
+{
+    gp_Pnt center;
+    double halfSize = 1.;
+    if (!bndBox.IsVoid()) {
+        const gp_Pnt pntMin = bndBox.CornerMin();
+        const gp_Pnt pntMax = bndBox.CornerMax();
+        center.SetXYZ(pntMin.XYZ().Added(pntMax.XYZ()).Divided(2.));
+        const double maxExtent = std::max({
+                pntMax.X() - pntMin.X(), pntMax.Y() - pntMin.Y(), pntMax.Z() - pntMin.Z() });
+        // Slightly enlarged so the extreme points fall inside
+        if (maxExtent > 0)
+            halfSize = maxExtent * 0.5 * 1.001;
+    }
+
+    m_origin = center;
+    m_rootNodeId = this->newNode(center, halfSize);
+}
+
+void PointCloud::growRoot(const gp_Pnt& pnt)
+{
+    // New root has twice the size, extended toward 'pnt'. Previous root becomes one of its children
+    // Points already inserted are kept where they are, the new root sampling starts empty
+    const Node rootPrev = m_vecNode.at(m_rootNodeId);
+    const double h = rootPrev.halfSize;
+    const gp_Pnt center(
+                rootPrev.center.X() + (pnt.X() >= rootPrev.center.X() ? h : -h),
+                rootPrev.center.Y() + (pnt.Y() >= rootPrev.center.Y() ? h : -h),
+                rootPrev.center.Z() + (pnt.Z() >= rootPrev.center.Z() ? h : -h));
+    const int octant =
+            (rootPrev.center.X() >= center.X() ? 1 : 0)
+            | (rootPrev.center.Y() >= center.Y() ? 2 : 0)
+            | (rootPrev.center.Z() >= center.Z() ? 4 : 0);
+    const int rootId = this->newNode(center, 2 * h);
+    m_vecNode.at(rootId).children[octant] = m_rootNodeId;
+    m_rootNodeId = rootId;
+}
+
+bool PointCloud::rootContains(const gp_Pnt& pnt) const
+{
+    const Node& root = m_vecNode.at(m_rootNodeId);
+    return std::abs(pnt.X() - root.center.X()) <= root.halfSize
+            && std::abs(pnt.Y() - root.center.Y()) <= root.halfSize
+            && std::abs(pnt.Z() - root.center.Z()) <= root.halfSize;
+}
+
+void PointCloud::insertPoint(const gp_Pnt& pnt, uint32_t rgb)
+{
+    const int gridSize = m_options.nodeGridSize;
+    const uint64_t cellCount = uint64_t(gridSize) * gridSize * gridSize;
+    auto fnCellCoord = [=](double v, double vMin, double cellSize) {
+        return std::clamp(int((v - vMin) / cellSize), 0, gridSize - 1);
+    };
+
+    int nodeId = m_rootNodeId;
+    int depth = 0;
+    for (;;) {
+        const Node& node = m_vecNode[nodeId];
+        if (depth >= m_options.maxDepth)
+            break;
+
+        const double cellSize = (2 * node.halfSize) / gridSize;
+        const int ix = fnCellCoord(pnt.X(), node.center.X() - node.halfSize, cellSize);
+        const int iy = fnCellCoord(pnt.Y(), node.center.Y() - node.halfSize, cellSize);
+        const int iz = fnCellCoord(pnt.Z(), node.center.Z() - node.halfSize, cellSize);
+        const uint64_t cellId = (uint64_t(iz) * gridSize + iy) * gridSize + ix;
+        std::vector<uint64_t>& vecCellBits = m_vecNodeStorage[nodeId].vecCellBits;
+        if (vecCellBits.empty())
+            vecCellBits.resize((cellCount + 63) / 64, 0);
+
+        uint64_t& cellBits = vecCellBits[cellId / 64];
+        const uint64_t cellMask = uint64_t(1) << (cellId % 64);
+        if (!(cellBits & cellMask)) {
+            cellBits |= cellMask;
+            break;
+        }
+
+        // Cell already taken, point goes down to the child node
+        const int octant =
+                (pnt.X() >= node.center.X() ? 1 : 0)
+                | (pnt.Y() >= node.center.Y() ? 2 : 0)
+                | (pnt.Z() >= node.center.Z() ? 4 : 0);
+        int childId = node.children[octant];
+        if (childId < 0) {
+            const double q = node.halfSize / 2.;
+            const gp_Pnt childCenter(
+                        node.center.X() + ((octant & 1) ? q : -q),
+                        node.center.Y() + ((octant & 2) ? q : -q),
+                        node.center.Z() + ((octant & 4) ? q : -q));
+            childId = this->newNode(childCenter, q); // Invalidates 'node'
+            m_vecNode[nodeId].children[octant] = childId;
+        }
+
+        nodeId = childId;
+        ++depth;
+    }
+
+    Point point;
+    point.x = float(pnt.X() - m_origin.X());
+    point.y = float(pnt.Y() - m_origin.Y());
+    point.z = float(pnt.Z() - m_origin.Z());
+    point.rgb = rgb & 0xFFFFFF;
+    m_vecNodeStorage[nodeId].vecPoint.push_back(point);
+    ++m_vecNode[nodeId].pointCount;
+    ++m_inMemoryPointCount;
+}
+
+void PointCloud::spillToPageFile()
+{
+    if (!m_pageFile) {
+        m_pageFile = std::make_unique<QTemporaryFile>(QDir::tempPath() + "/mayo_pointcloud_XXXXXX.bin");
+        if (!m_pageFile->open()) {
+            m_pageFile.reset();
+            return; // Points are kept in memory
+        }
+    }
+
+    // Biggest node buffers are written first, until half of the budget is reached
+    std::vector<int> vecNodeId(m_vecNodeStorage.size());
+    std::iota(vecNodeId.begin(), vecNodeId.end(), 0);
+    std::sort(vecNodeId.begin(), vecNodeId.end(), [=](int lhs, int rhs) {
+        return m_vecNodeStorage[lhs].vecPoint.size() > m_vecNodeStorage[rhs].vecPoint.size();
+    });
+
+    std::lock_guard<std::mutex> lock(m_pageFileMutex);
+    const uint64_t targetCount = m_options.maxInMemoryPointCount / 2;
+    for (int nodeId : vecNodeId) {
+        if (m_inMemoryPointCount <= targetCount)
+            break;
+
+        NodeStorage& storage = m_vecNodeStorage[nodeId];
+        if (storage.vecPoint.empty())
+            break;
+
+        PageSegment segment;
+        segment.offset = m_pageFile->size();
+        segment.count = uint32_t(storage.vecPoint.size());
+        const qint64 byteCount = qint64(segment.count) * qint64(sizeof(Point));
+        if (!m_pageFile->seek(segment.offset)
+                || m_pageFile->write(reinterpret_cast<const char*>(storage.vecPoint.data()), byteCount) != byteCount)
+        {
+            return; // Disk full or similar, remaining points are kept in memory
+        }
+
+        storage.vecSegment.push_back(segment);
+        m_inMemoryPointCount -= segment.count;
+        std::vector<Point>().swap(storage.vecPoint);
+    }
+}
+
+const Standard_GUID& PointCloudAttribute::GetID()
+{
+    static const Standard_GUID guid("3f1d6c9e-8a57-4e0b-b2c4-71e95d0a8f36");
+    return guid;
+}
+
+Handle_PointCloudAttribute PointCloudAttribute::Set(const TDF_Label& label, const PointCloudPtr& cloud)
+{
+    Handle_PointCloudAttribute attr;
+    if (!label.FindAttribute(PointCloudAttribute::GetID(), attr)) {
+        attr = new PointCloudAttribute;
+        label.AddAttribute(attr);
+    }
+
+    attr->Backup();
+    attr->m_cloud = cloud;
+    return attr;
+}
+
+const Standard_GUID& PointCloudAttribute::ID() const
+{
+    return PointCloudAttribute::GetID();
+}
+
+void PointCloudAttribute::Restore(const opencascade::handle<TDF_Attribute>& with)
+{
+    auto attr = Handle_PointCloudAttribute::DownCast(with);
+    if (attr)
+        m_cloud = attr->m_cloud;
+}
+
+opencascade::handle<TDF_Attribute> PointCloudAttribute::NewEmpty() const
+{
+    return new PointCloudAttribute;
+}
+
+void PointCloudAttribute::Paste(
+        const opencascade::handle<TDF_Attribute>& into,
+        const opencascade::handle<TDF_RelocationTable>&) const
+{
+    auto attr = Handle_PointCloudAttribute::DownCast(into);
+    if (attr)
+        attr->m_cloud = m_cloud;
+}
+
+} // namespace Mayo
@@ -0,0 +1,143 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "span.h"
+
+#include <Bnd_Box.hxx>
+#include <TDF_Attribute.hxx>
+#include <TDF_Label.hxx>
+#include <gp_Pnt.hxx>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class QTemporaryFile;
+
+namespace Mayo {
+
+class PointCloudAttribute;
+DEFINE_STANDARD_HANDLE(PointCloudAttribute, TDF_Attribute)
+
+// Octree of points built by streaming, so clouds bigger than the available memory can be loaded
+// Each node keeps a spatially uniform subset of the points falling in its cube: the cube is split
+// in a grid of cells and a point is taken by the first node(from the root) whose cell is still
+// empty. Rejected points go down to the child nodes. Points of a node are so a coarse level of
+// detail of the points of its sub-tree
+// Once the count of points in memory exceeds a budget, points of the biggest nodes are moved out
+// to a temporary page file, they are read back on demand by nodePoints()
+class PointCloud {
+public:
+    // Coordinates are relative to origin(), color is packed as 0xRRGGBB
+    struct Point {
+        float x;
+        float y;
+        float z;
+        uint32_t rgb;
+    };
+
+    struct Node {
+        gp_Pnt center;
+        double halfSize = 0; // Half length of the cube edges
+        int children[8] = { -1, -1, -1, -1, -1, -1, -1, -1 }; // Index of child nodes, -1 if none
+        uint64_t pointCount = 0; // Points held by this node only, not by the sub-tree
+    };
+
+    struct Options {
+        int nodeGridSize = 32; // Count of cells along each axis of a node cube
+        int maxDepth = 20; // Nodes at this depth accept all points
+        uint64_t maxInMemoryPointCount = 32 * 1000 * 1000;
+    };
+
+    PointCloud(const Options& options = {});
+    ~PointCloud();
+
+    PointCloud(const PointCloud&) = delete;
+    PointCloud& operator=(const PointCloud&) = delete;
+
+    // -- Building, not thread-safe
+    // Expected bounds of the points, optional. Used to size the root node, which is otherwise
+    // deduced from the first points and grown as needed
+    void setBoundsHint(const Bnd_Box& bndBox);
+    // 'spanRgb' is either empty or of same size as 'spanPnt'
+    void addPoints(Span<const gp_Pnt> spanPnt, Span<const uint32_t> spanRgb);
+    // Releases the data needed only while building
+    void finishBuild();
+
+    // -- Queries
+    const gp_Pnt& origin() const { return m_origin; }
+    const Bnd_Box& boundingBox() const { return m_bndBox; }
+    uint64_t pointCount() const { return m_pointCount; }
+    bool hasColors() const { return m_hasColors; }
+
+    int rootNodeId() const { return m_rootNodeId; }
+    int nodeCount() const { return int(m_vecNode.size()); }
+    const Node& node(int nodeId) const { return m_vecNode.at(nodeId); }
+
+    // Points of node 'nodeId', read back from the page file if needed. Thread-safe
+    std::vector<Point> nodePoints(int nodeId) const;
+    // Count of points currently held in memory(not moved to the page file)
+    uint64_t inMemoryPointCount() const { return m_inMemoryPointCount; }
+
+private:
+    struct PageSegment {
+        int64_t offset;
+        uint32_t count;
+    };
+
+    struct NodeStorage {
+        std::vector<Point> vecPoint; // In memory
+        std::vector<PageSegment> vecSegment; // In page file
+        std::vector<uint64_t> vecCellBits; // Occupancy of the grid cells, while building
+    };
+
+    int newNode(const gp_Pnt& center, double halfSize);
+    void initRoot(const Bnd_Box& bndBox);
+    void growRoot(const gp_Pnt& pnt);
+    bool rootContains(const gp_Pnt& pnt) const;
+    void insertPoint(const gp_Pnt& pnt, uint32_t rgb);
+    void spillToPageFile();
+
+    Options m_options;
+    gp_Pnt m_origin;
+    Bnd_Box m_bndBox;
+    Bnd_Box m_bndBoxHint;
+    uint64_t m_pointCount = 0;
+    uint64_t m_inMemoryPointCount = 0;
+    bool m_hasColors = false;
+    int m_rootNodeId = -1;
+    std::vector<Node> m_vecNode;
+    std::vector<NodeStorage> m_vecNodeStorage;
+    std::unique_ptr<QTemporaryFile> m_pageFile;
+    mutable std::mutex m_pageFileMutex;
+};
+
+using PointCloudPtr = std::shared_ptr<PointCloud>;
+
+// Holds a PointCloud object on a label of a document
+class PointCloudAttribute : public TDF_Attribute {
+public:
+    static const Standard_GUID& GetID();
+    static Handle_PointCloudAttribute Set(const TDF_Label& label, const PointCloudPtr& cloud);
+
+    const PointCloudPtr& get() const { return m_cloud; }
+
+    const Standard_GUID& ID() const override;
+    void Restore(const opencascade::handle<TDF_Attribute>& with) override;
+    opencascade::handle<TDF_Attribute> NewEmpty() const override;
+    void Paste(const opencascade::handle<TDF_Attribute>& into,
+               const opencascade::handle<TDF_RelocationTable>& table) const override;
+
+    DEFINE_STANDARD_RTTI_INLINE(PointCloudAttribute, TDF_Attribute)
+
+private:
+    PointCloudPtr m_cloud; // Shared, point clouds are never modified once built
+};
+
+} // namespace Mayo
@@ -0,0 +1,84 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "process_utils.h"
+#include "global.h"
+
+#include <QtCore/QtGlobal>
+
+#if defined(Q_OS_WIN)
+#  include <windows.h>
+#  include <psapi.h>
+#elif defined(Q_OS_MACOS)
+#  include <libproc.h>
+#  include <unistd.h>
+#elif defined(Q_OS_UNIX)
+#  include <unistd.h>
+#  include <fstream>
+#  include <string>
+#endif
+
+namespace Mayo {
+
+namespace {
+
+#if defined(Q_OS_LINUX)
+// Second field of /proc/<pid>/statm is the count of resident pages
+int64_t linuxResidentMemorySize(const std::string& statmPath)
+{
+    std::ifstream ifs(statmPath);
+    int64_t sizePages = 0;
+    int64_t residentPages = 0;
+    if (!(ifs >> sizePages >> residentPages))
+        return -1;
+
+    return residentPages * int64_t(sysconf(_SC_PAGESIZE));
+}
+#endif
+
+} // namespace
+
+int64_t ProcessUtils::residentMemorySize(int64_t pid)
+{
+#if defined(Q_OS_WIN)
+    HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, DWORD(pid));
+    if (!hProcess)
+        return -1;
+
+    PROCESS_MEMORY_COUNTERS counters = {};
+    const BOOL ok = GetProcessMemoryInfo(hProcess, &counters, sizeof(counters));
+    CloseHandle(hProcess);
+    return ok ? int64_t(counters.WorkingSetSize) : -1;
+#elif defined(Q_OS_MACOS)
+    proc_taskinfo info = {};
+    const int size = proc_pidinfo(int(pid), PROC_PIDTASKINFO, 0, &info, sizeof(info));
+    return size == int(sizeof(info)) ? int64_t(info.pti_resident_size) : -1;
+#elif defined(Q_OS_LINUX)
+    return linuxResidentMemorySize("/proc/" + std::to_string(pid) + "/statm");
+#else
+    MAYO_UNUSED(pid);
+    return -1;
+#endif
+}
+
+int64_t ProcessUtils::currentResidentMemorySize()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return -1;
+
+    return int64_t(counters.WorkingSetSize);
+#elif defined(Q_OS_LINUX)
+    return linuxResidentMemorySize("/proc/self/statm");
+#elif defined(Q_OS_UNIX)
+    return ProcessUtils::residentMemorySize(getpid());
+#else
+    return -1;
+#endif
+}
+
+} // namespace Mayo
@@ -0,0 +1,22 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+namespace Mayo {
+
+struct ProcessUtils {
+    // Resident memory(working set on Windows) of process 'pid', in bytes
+    // Returns -1 if unknown, eg process doesn't exist or platform isn't supported
+    static int64_t residentMemorySize(int64_t pid);
+
+    // Resident memory of the calling process, in bytes(-1 if unknown)
+    static int64_t currentResidentMemorySize();
+};
+
+} // namespace Mayo
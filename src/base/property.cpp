@@ -37,6 +37,10 @@ void PropertyGroup::onPropertyEnabled(Property* prop, bool on)
         m_parentGroup->onPropertyEnabled(prop, on);
 }
 
+void PropertyGroup::onPropertiesChanged(Span<Property* const>)
+{
+}
+
 Result<void> PropertyGroup::isPropertyValid(const Property*) const
 {
     return Result<void>::ok();
@@ -52,6 +56,34 @@ bool PropertyGroup::isPropertyChangedBlocked() const
     return m_propertyChangedBlocked;
 }
 
+void PropertyGroup::beginPropertyChangedBatch()
+{
+    ++m_propertyChangedBatchDepth;
+}
+
+void PropertyGroup::endPropertyChangedBatch()
+{
+    Expects(m_propertyChangedBatchDepth > 0);
+    if (--m_propertyChangedBatchDepth == 0 && !m_vecPropertyChangedInBatch.empty()) {
+        // Callback may start a new batch, so the recorded properties are moved out first
+        const std::vector<Property*> vecProp = std::move(m_vecPropertyChangedInBatch);
+        m_vecPropertyChangedInBatch.clear();
+        this->onPropertiesChanged(vecProp);
+    }
+}
+
+bool PropertyGroup::recordPropertyChangedInBatch(Property* prop)
+{
+    if (!this->isPropertyChangedBatchActive())
+        return false;
+
+    auto& vecProp = m_vecPropertyChangedInBatch;
+    if (std::find(vecProp.cbegin(), vecProp.cend(), prop) == vecProp.cend())
+        vecProp.push_back(prop);
+
+    return true;
+}
+
 void PropertyGroup::addProperty(Property* prop)
 {
     Expects(prop != nullptr);
@@ -132,6 +164,20 @@ PropertyChangedBlocker::~PropertyChangedBlocker()
 }
 
 
+PropertyChangedBatch::PropertyChangedBatch(PropertyGroup* group)
+    : m_group(group)
+{
+    if (m_group)
+        m_group->beginPropertyChangedBatch();
+}
+
+PropertyChangedBatch::~PropertyChangedBatch()
+{
+    if (m_group)
+        m_group->endPropertyChangedBatch();
+}
+
+
 PropertyGroupSignals::PropertyGroupSignals(QObject* parent)
     : QObject(parent)
 {
@@ -140,7 +186,14 @@ PropertyGroupSignals::PropertyGroupSignals(QObject* parent)
 void PropertyGroupSignals::onPropertyChanged(Property* prop)
 {
     PropertyGroup::onPropertyChanged(prop);
-    emit propertyChanged(prop);
+    if (!this->recordPropertyChangedInBatch(prop))
+        emit propertyChanged(prop);
+}
+
+void PropertyGroupSignals::onPropertiesChanged(Span<Property* const> props)
+{
+    PropertyGroup::onPropertiesChanged(props);
+    emit propertiesChanged(props);
 }
 
 } // namespace Mayo
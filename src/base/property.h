@@ -40,20 +40,35 @@ protected:
     // Callback executed when Property "enabled" status was changed
     virtual void onPropertyEnabled(Property* prop, bool on);
 
+    // Callback executed when the outermost batch of property changes is ended(see
+    // PropertyChangedBatch), with the properties recorded during the batch
+    // Each property is listed once, in the order of its first change
+    virtual void onPropertiesChanged(Span<Property* const> props);
+
     virtual Result<void> isPropertyValid(const Property* prop) const;
 
     void blockPropertyChanged(bool on);
     bool isPropertyChangedBlocked() const;
 
+    void beginPropertyChangedBatch();
+    void endPropertyChangedBatch();
+    bool isPropertyChangedBatchActive() const { return m_propertyChangedBatchDepth > 0; }
+    // Adds 'prop' to the properties changed during the current batch
+    // Returns false if there is no active batch, then nothing is done
+    bool recordPropertyChangedInBatch(Property* prop);
+
     void addProperty(Property* prop);
     void removeProperty(Property* prop);
 
 private:
     friend class Property;
     friend struct PropertyChangedBlocker;
+    friend struct PropertyChangedBatch;
     PropertyGroup* m_parentGroup = nullptr;
     std::vector<Property*> m_properties; // TODO Replace by QVarLengthArray<Property*> ?
     bool m_propertyChangedBlocked = false;
+    int m_propertyChangedBatchDepth = 0;
+    std::vector<Property*> m_vecPropertyChangedInBatch;
 };
 
 // Exception-safe wrapper around PropertyGroup::blockPropertyChanged()
@@ -69,6 +84,17 @@ struct PropertyChangedBlocker {
             Mayo::PropertyChangedBlocker __Mayo_PropertyChangedBlocker(group); \
             Q_UNUSED(__Mayo_PropertyChangedBlocker);
 
+// Exception-safe wrapper around PropertyGroup::beginPropertyChangedBatch() and
+// PropertyGroup::endPropertyChangedBatch()
+// Groups supporting batches(eg Settings, PropertyGroupSignals) then send a single notification
+// for all the properties changed during the lifetime of the PropertyChangedBatch object, instead
+// of one notification per change. Batches can be nested
+struct PropertyChangedBatch {
+    PropertyChangedBatch(PropertyGroup* group);
+    ~PropertyChangedBatch();
+    PropertyGroup* const m_group = nullptr;
+};
+
 class Property {
 public:
     Property(PropertyGroup* group, const TextId& name);
@@ -125,9 +151,12 @@ public:
 
 signals:
     void propertyChanged(Property* prop);
+    // Emitted instead of propertyChanged() for properties changed within a PropertyChangedBatch
+    void propertiesChanged(Mayo::Span<Mayo::Property* const> props);
 
 protected:
     void onPropertyChanged(Property* prop) override;
+    void onPropertiesChanged(Span<Property* const> props) override;
 };
 
 
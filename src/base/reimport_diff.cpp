@@ -0,0 +1,331 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "reimport_diff.h"
+#include "document.h"
+#include "task_progress.h"
+
+#include <BRepAdaptor_Surface.hxx>
+#include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <Poly_PolygonOnTriangulation.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <TopoDS.hxx>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace Mayo {
+
+namespace {
+
+bool locationsEqual(const TopLoc_Location& lhs, const TopLoc_Location& rhs)
+{
+    const gp_Trsf lhsTrsf = lhs.Transformation();
+    const gp_Trsf rhsTrsf = rhs.Transformation();
+    for (int row = 1; row <= 3; ++row) {
+        for (int col = 1; col <= 4; ++col) {
+            if (std::abs(lhsTrsf.Value(row, col) - rhsTrsf.Value(row, col)) > 1e-12)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// Copies the triangulations of the faces of 'shapeSrc' to the faces of 'shapeDst', which must be
+// topologically identical. Nothing is copied if faces don't pair up in exploration order
+bool copyTriangulations(const TopoDS_Shape& shapeSrc, const TopoDS_Shape& shapeDst)
+{
+    TopTools_IndexedMapOfShape mapFaceSrc;
+    TopTools_IndexedMapOfShape mapFaceDst;
+    TopExp::MapShapes(shapeSrc, TopAbs_FACE, mapFaceSrc);
+    TopExp::MapShapes(shapeDst, TopAbs_FACE, mapFaceDst);
+    if (mapFaceSrc.Extent() == 0 || mapFaceSrc.Extent() != mapFaceDst.Extent())
+        return false;
+
+    // Check all faces first, so triangulations are copied for all faces or none
+    for (int i = 1; i <= mapFaceSrc.Extent(); ++i) {
+        const TopoDS_Face& faceSrc = TopoDS::Face(mapFaceSrc.FindKey(i));
+        const TopoDS_Face& faceDst = TopoDS::Face(mapFaceDst.FindKey(i));
+        TopLoc_Location locSrc;
+        if (BRep_Tool::Triangulation(faceSrc, locSrc).IsNull())
+            return false;
+
+        if (!locationsEqual(faceSrc.Location(), faceDst.Location()))
+            return false;
+
+        if (BRepAdaptor_Surface(faceSrc, false).GetType() != BRepAdaptor_Surface(faceDst, false).GetType())
+            return false;
+    }
+
+    BRep_Builder builder;
+    for (int i = 1; i <= mapFaceSrc.Extent(); ++i) {
+        const TopoDS_Face& faceSrc = TopoDS::Face(mapFaceSrc.FindKey(i));
+        const TopoDS_Face& faceDst = TopoDS::Face(mapFaceDst.FindKey(i));
+        TopLoc_Location locSrc;
+        const Handle_Poly_Triangulation triangulation = BRep_Tool::Triangulation(faceSrc, locSrc);
+        builder.UpdateFace(faceDst, triangulation);
+
+        // Edge polygons on the triangulation, without them the mesher would consider the face
+        // out of date
+        TopExp_Explorer explEdgeSrc(faceSrc, TopAbs_EDGE);
+        TopExp_Explorer explEdgeDst(faceDst, TopAbs_EDGE);
+        for (; explEdgeSrc.More() && explEdgeDst.More(); explEdgeSrc.Next(), explEdgeDst.Next()) {
+            const TopoDS_Edge& edgeSrc = TopoDS::Edge(explEdgeSrc.Current());
+            const TopoDS_Edge& edgeDst = TopoDS::Edge(explEdgeDst.Current());
+            if (BRep_Tool::IsClosed(edgeSrc, faceSrc)) {
+                const TopoDS_Edge edgeSrcFwd = TopoDS::Edge(edgeSrc.Oriented(TopAbs_FORWARD));
+                const TopoDS_Edge edgeSrcRev = TopoDS::Edge(edgeSrc.Oriented(TopAbs_REVERSED));
+                const Handle_Poly_PolygonOnTriangulation polygonFwd =
+                        BRep_Tool::PolygonOnTriangulation(edgeSrcFwd, triangulation, locSrc);
+                const Handle_Poly_PolygonOnTriangulation polygonRev =
+                        BRep_Tool::PolygonOnTriangulation(edgeSrcRev, triangulation, locSrc);
+                if (!polygonFwd.IsNull() && !polygonRev.IsNull()) {
+                    const TopoDS_Edge edgeDstFwd = TopoDS::Edge(edgeDst.Oriented(TopAbs_FORWARD));
+                    builder.UpdateEdge(edgeDstFwd, polygonFwd, polygonRev, triangulation, faceDst.Location());
+                }
+            }
+            else {
+                const Handle_Poly_PolygonOnTriangulation polygon =
+                        BRep_Tool::PolygonOnTriangulation(edgeSrc, triangulation, locSrc);
+                if (!polygon.IsNull())
+                    builder.UpdateEdge(edgeDst, polygon, triangulation, faceDst.Location());
+            }
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+ReimportDiff::ReimportDiff(const DocumentPtr& doc, double linearTolerance)
+    : m_doc(doc),
+      m_linearTolerance(linearTolerance)
+{
+}
+
+void ReimportDiff::compare(
+        Span<const TDF_Label> spanPreviousEntity,
+        Span<const TDF_Label> spanNewEntity,
+        TaskProgress* progress)
+{
+    m_previousSide = {};
+    m_newSide = {};
+    m_unchangedProductCount = 0;
+    m_vecPreviousProductIndex.clear();
+    m_mapIdenticalEntity.clear();
+    {
+        TaskProgress subProgress(progress, 45);
+        this->describeEntities(spanPreviousEntity, &m_previousSide, &subProgress);
+    }
+
+    {
+        TaskProgress subProgress(progress, 45);
+        this->describeEntities(spanNewEntity, &m_newSide, &subProgress);
+    }
+
+    if (TaskProgress::isAbortRequested(progress))
+        return;
+
+    // Match products by path, then compare them
+    std::unordered_map<std::string, int> mapPathPreviousProductIndex;
+    for (int i = 0; i < int(m_previousSide.vecProduct.size()); ++i)
+        mapPathPreviousProductIndex.insert({ m_previousSide.vecProduct.at(i).path, i });
+
+    m_vecPreviousProductIndex.resize(m_newSide.vecProduct.size(), -1);
+    for (int i = 0; i < int(m_newSide.vecProduct.size()); ++i) {
+        const Product& productNew = m_newSide.vecProduct.at(i);
+        auto it = mapPathPreviousProductIndex.find(productNew.path);
+        if (it == mapPathPreviousProductIndex.cend())
+            continue;
+
+        const Product& productPrevious = m_previousSide.vecProduct.at(it->second);
+        if (productNew.isMatchable
+                && productPrevious.isMatchable
+                && !productNew.fingerprint.vecFace.empty()
+                && productNew.styleKey == productPrevious.styleKey
+                && productNew.fingerprint == productPrevious.fingerprint)
+        {
+            m_vecPreviousProductIndex.at(i) = it->second;
+            ++m_unchangedProductCount;
+        }
+    }
+
+    // Identical entities: same structure and their products are pairwise unchanged
+    std::unordered_map<std::string, std::vector<const Entity*>> mapKeyPreviousEntities;
+    for (const Entity& entity : m_previousSide.vecEntity)
+        mapKeyPreviousEntities[entity.structureKey].push_back(&entity);
+
+    for (const Entity& entityNew : m_newSide.vecEntity) {
+        auto it = mapKeyPreviousEntities.find(entityNew.structureKey);
+        if (it == mapKeyPreviousEntities.end())
+            continue;
+
+        std::vector<const Entity*>& vecCandidate = it->second;
+        auto itIdentical = std::find_if(vecCandidate.begin(), vecCandidate.end(), [&](const Entity* entityPrevious) {
+            if (entityPrevious->vecProductIndex.size() != entityNew.vecProductIndex.size())
+                return false;
+
+            for (unsigned j = 0; j < entityNew.vecProductIndex.size(); ++j) {
+                const int previousProductIndex = m_vecPreviousProductIndex.at(entityNew.vecProductIndex.at(j));
+                if (previousProductIndex != entityPrevious->vecProductIndex.at(j))
+                    return false;
+            }
+
+            return true;
+        });
+        if (itIdentical != vecCandidate.end()) {
+            m_mapIdenticalEntity.insert({ entityNew.label, (*itIdentical)->label });
+            vecCandidate.erase(itIdentical);
+        }
+    }
+
+    if (progress)
+        progress->setValue(100);
+}
+
+int ReimportDiff::carryOverTriangulations()
+{
+    int count = 0;
+    for (int i = 0; i < int(m_vecPreviousProductIndex.size()); ++i) {
+        const int previousProductIndex = m_vecPreviousProductIndex.at(i);
+        if (previousProductIndex < 0)
+            continue;
+
+        const TopoDS_Shape shapePrevious = XCaf::shape(m_previousSide.vecProduct.at(previousProductIndex).label);
+        const TopoDS_Shape shapeNew = XCaf::shape(m_newSide.vecProduct.at(i).label);
+        if (copyTriangulations(shapePrevious, shapeNew))
+            ++count;
+    }
+
+    return count;
+}
+
+TDF_Label ReimportDiff::findIdenticalPreviousEntity(const TDF_Label& labelNewEntity) const
+{
+    auto it = m_mapIdenticalEntity.find(labelNewEntity);
+    return it != m_mapIdenticalEntity.cend() ? it->second : TDF_Label();
+}
+
+void ReimportDiff::describeEntities(Span<const TDF_Label> spanEntity, Side* side, TaskProgress* progress)
+{
+    // Products are identified by their label, so products instantiated many times(or shared by
+    // several entities) are described once. Path is the one of the first instance found
+    std::unordered_map<TDF_Label, int> mapProductIndex;
+    for (const TDF_Label& labelEntity : spanEntity) {
+        Entity entity;
+        entity.label = labelEntity;
+        std::unordered_map<int, int> mapEntityProductSlot;
+        auto fnProductSlot = [&](const TDF_Label& lblProduct, const std::string& path) {
+            auto [it, isNew] = mapProductIndex.insert({ lblProduct, int(side->vecProduct.size()) });
+            if (isNew) {
+                Product product;
+                product.label = lblProduct;
+                product.path = path;
+                product.styleKey = this->labelStyleKey(lblProduct);
+                for (const TDF_Label& lblSub : XCaf::shapeSubs(lblProduct))
+                    product.styleKey += "/" + this->labelStyleKey(lblSub);
+
+                product.isMatchable = XCaf::isShapeSimple(lblProduct);
+#if OCC_VERSION_HEX >= 0x070500
+                // Materials are not compared
+                if (m_doc->xcaf().visMaterialTool()->IsSetShapeMaterial(lblProduct))
+                    product.isMatchable = false;
+#endif
+                side->vecProduct.push_back(std::move(product));
+            }
+
+            auto [itSlot, isNewSlot] = mapEntityProductSlot.insert({ it->second, int(entity.vecProductIndex.size()) });
+            if (isNewSlot)
+                entity.vecProductIndex.push_back(it->second);
+
+            return itSlot->second;
+        };
+
+        std::function<void(const TDF_Label&, const std::string&)> fnDescribe;
+        fnDescribe = [&](const TDF_Label& label, const std::string& path) {
+            entity.structureKey += this->labelStyleKey(label);
+            if (!XCaf::isShapeAssembly(label)) {
+                entity.structureKey += "P" + std::to_string(fnProductSlot(label, path));
+                return;
+            }
+
+            // Components sharing the same names are numbered in order of appearance
+            std::unordered_map<std::string, int> mapNameCount;
+            entity.structureKey += "{";
+            for (const TDF_Label& lblComponent : XCaf::shapeComponents(label)) {
+                const TDF_Label lblReferred = XCaf::shapeReferred(lblComponent);
+                const std::string name =
+                        CafUtils::labelAttrStdName(lblComponent).toStdString()
+                        + ">" + CafUtils::labelAttrStdName(lblReferred).toStdString();
+                const int index = mapNameCount[name]++;
+                entity.structureKey +=
+                        name
+                        + "@" + this->locationKey(XCaf::shapeReferenceLocation(lblComponent))
+                        + this->labelStyleKey(lblComponent);
+                fnDescribe(lblReferred, path + "/" + name + "#" + std::to_string(index));
+            }
+
+            entity.structureKey += "}";
+        };
+
+        const std::string entityName = CafUtils::labelAttrStdName(labelEntity).toStdString();
+        entity.structureKey = entityName;
+        fnDescribe(labelEntity, "/" + entityName);
+        side->vecEntity.push_back(std::move(entity));
+    }
+
+    // Only matchable products get a fingerprint
+    std::vector<Product*> vecMatchableProduct;
+    std::vector<TopoDS_Shape> vecMatchableShape;
+    for (Product& product : side->vecProduct) {
+        if (product.isMatchable) {
+            vecMatchableProduct.push_back(&product);
+            vecMatchableShape.push_back(XCaf::shape(product.label));
+        }
+    }
+
+    std::vector<GeometryDedup::Fingerprint> vecFingerprint =
+            GeometryDedup::computeFingerprints(vecMatchableShape, m_linearTolerance, progress);
+    for (unsigned i = 0; i < vecMatchableProduct.size(); ++i)
+        vecMatchableProduct.at(i)->fingerprint = std::move(vecFingerprint.at(i));
+}
+
+std::string ReimportDiff::labelStyleKey(const TDF_Label& label) const
+{
+    if (!m_doc->xcaf().hasShapeColor(label))
+        return {};
+
+    // Integers so colors are compared exactly, without rounding issues of Quantity_Color::IsEqual()
+    const Quantity_Color color = m_doc->xcaf().shapeColor(label);
+    return "(" + std::to_string(std::lround(color.Red() * 255))
+            + "," + std::to_string(std::lround(color.Green() * 255))
+            + "," + std::to_string(std::lround(color.Blue() * 255)) + ")";
+}
+
+std::string ReimportDiff::locationKey(const TopLoc_Location& loc) const
+{
+    if (loc.IsIdentity())
+        return {};
+
+    const gp_Trsf trsf = loc.Transformation();
+    std::string key;
+    for (int row = 1; row <= 3; ++row) {
+        for (int col = 1; col <= 4; ++col) {
+            const double quantum = col == 4 ? m_linearTolerance : 1e-9;
+            key += std::to_string(std::llround(trsf.Value(row, col) / quantum)) + ",";
+        }
+    }
+
+    return key;
+}
+
+} // namespace Mayo
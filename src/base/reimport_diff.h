@@ -0,0 +1,91 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "caf_utils.h"
+#include "document_ptr.h"
+#include "geometry_dedup.h"
+#include "span.h"
+
+#include <TopLoc_Location.hxx>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Compares the entities transferred again from a modified file with the entities previously
+// transferred from that file, so data of the unchanged parts is reused instead of being computed
+// again(eg meshing, graphics mapping)
+// Products(the simple shapes of entities) are matched by the path of names leading to them from
+// the entity root, then they are unchanged if their geometry fingerprints(see
+// GeometryDedup::Fingerprint) and colors are equal
+// Entities are identical if they have the same structure(names, component locations and colors)
+// and all their products are unchanged
+class ReimportDiff {
+public:
+    // 'linearTolerance' is the rounding quantum of lengths, see GeometryDedup::fingerprint()
+    ReimportDiff(const DocumentPtr& doc, double linearTolerance = 1e-4);
+
+    // Matches entities 'spanNewEntity' against entities 'spanPreviousEntity', both must belong to
+    // the document of this object. New entities must not be post-processed yet(ie not meshed)
+    void compare(
+            Span<const TDF_Label> spanPreviousEntity,
+            Span<const TDF_Label> spanNewEntity,
+            TaskProgress* progress = nullptr);
+
+    int unchangedProductCount() const { return m_unchangedProductCount; }
+    int changedProductCount() const { return int(m_newSide.vecProduct.size()) - m_unchangedProductCount; }
+
+    // Copies the face triangulations(and edge polygons) of unchanged previous products onto the
+    // matching new products, so meshing the new entities skips these products
+    // Faces are paired in exploration order, a product is skipped if its faces don't pair up(eg
+    // different surface types)
+    // Returns the count of products whose triangulations were carried over
+    int carryOverTriangulations();
+
+    // Returns the previous entity identical to 'labelNewEntity', null label if none
+    // A previous entity is found identical to at most one new entity
+    TDF_Label findIdenticalPreviousEntity(const TDF_Label& labelNewEntity) const;
+
+private:
+    struct Product {
+        TDF_Label label;
+        std::string path;
+        std::string styleKey;
+        bool isMatchable = true;
+        GeometryDedup::Fingerprint fingerprint;
+    };
+
+    struct Entity {
+        TDF_Label label;
+        std::string structureKey;
+        std::vector<int> vecProductIndex; // In order of first appearance in the entity
+    };
+
+    struct Side {
+        std::vector<Product> vecProduct;
+        std::vector<Entity> vecEntity;
+    };
+
+    void describeEntities(Span<const TDF_Label> spanEntity, Side* side, TaskProgress* progress);
+    std::string labelStyleKey(const TDF_Label& label) const;
+    std::string locationKey(const TopLoc_Location& loc) const;
+
+    DocumentPtr m_doc;
+    double m_linearTolerance = 1e-4;
+    Side m_previousSide;
+    Side m_newSide;
+    int m_unchangedProductCount = 0;
+    // Index of the matching previous product, or -1 if changed. Indexed by new product index
+    std::vector<int> m_vecPreviousProductIndex;
+    std::unordered_map<TDF_Label, TDF_Label> m_mapIdenticalEntity; // New entity -> previous one
+};
+
+} // namespace Mayo
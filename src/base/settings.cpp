@@ -5,10 +5,16 @@
 ****************************************************************************/
 
 #include "settings.h"
+#include "qtcore_hfuncs.h"
 
 #include <QtCore/QSettings>
+#include <QtCore/QTimer>
 #include <gsl/util>
+#include <algorithm>
+#include <future>
 #include <regex>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace Mayo {
 
@@ -76,26 +82,70 @@ public:
         const QString settingPath = sectionPath + "/" + QString::fromUtf8(propertyKey);
         if (source.contains(settingPath)) {
             const QVariant value = source.value(settingPath);
-            m_propValueConverter->fromVariant(property, value);
+            if (&source == &m_settings)
+                this->loadValue(property, value);
+            else
+                m_propValueConverter->fromVariant(property, value);
         }
     }
 
+    // Assigns a value already stored(or overriden for this run only), so it's not recorded as an
+    // unsaved change
+    bool loadValue(Property* property, const QVariant& value)
+    {
+        const bool wasLoadingValue = m_isLoadingValue;
+        m_isLoadingValue = true;
+        auto _ = gsl::finally([=]{ m_isLoadingValue = wasLoadingValue; });
+        return m_propValueConverter->fromVariant(property, value);
+    }
+
+    void recordChangedSetting(Property* property)
+    {
+        if (m_isLoadingValue || m_mapSettingPath.find(property) == m_mapSettingPath.cend())
+            return;
+
+        m_setChangedSetting.insert(property);
+        if (m_autoSaveDelay > 0 && !m_timerAutoSave->isActive())
+            m_timerAutoSave->start(m_autoSaveDelay);
+    }
+
+    void waitForSaveChanges()
+    {
+        if (m_futureSaveChanges.valid())
+            m_futureSaveChanges.wait();
+    }
+
     QSettings m_settings;
     QLocale m_locale;
+    // Values loaded for settings not added yet, indexed by path "group/section/property"
+    std::unordered_map<QString, QVariant> m_mapPendingValue;
+    Settings::ExcludePropertyPredicate m_fnPendingValueExclude;
     std::vector<Settings_Group> m_vecGroup;
     std::vector<SectionResetFunction> m_vecSectionResetFn;
     const PropertyValueConversion m_defaultPropValueConverter;
     const PropertyValueConversion* m_propValueConverter = nullptr;
+    // Paths "group/section/property" of the added settings
+    std::unordered_map<const Property*, QString> m_mapSettingPath;
+    // Settings changed since last save
+    std::unordered_set<Property*> m_setChangedSetting;
+    bool m_isLoadingValue = false;
+    int m_autoSaveDelay = 0;
+    QTimer* m_timerAutoSave = nullptr;
+    std::future<void> m_futureSaveChanges;
 };
 
 Settings::Settings(QObject* parent)
     : QObject(parent),
       d(new Private)
 {
+    d->m_timerAutoSave = new QTimer(this);
+    d->m_timerAutoSave->setSingleShot(true);
+    QObject::connect(d->m_timerAutoSave, &QTimer::timeout, this, &Settings::saveChanges);
 }
 
 Settings::~Settings()
 {
+    d->waitForSaveChanges();
     delete d;
 }
 
@@ -106,15 +156,54 @@ void Settings::load()
 
 void Settings::loadFrom(const QSettings& source, const ExcludePropertyPredicate& fnExclude)
 {
+    PropertyChangedBatch batch(this);
+    std::unordered_set<QString> setSettingPath;
     for (const Settings_Group& group : d->m_vecGroup) {
         for (const Settings_Section& section : group.vecSection) {
             const QString sectionPath = d->sectionPath(group, section);
             for (const Settings_Setting& setting : section.vecSetting) {
+                setSettingPath.insert(sectionPath + "/" + QString::fromUtf8(setting.property->name().key));
                 if (!fnExclude || !fnExclude(*setting.property))
                     d->loadPropertyFrom(source, sectionPath, setting.property);
             }
         }
     }
+
+    d->m_mapPendingValue.clear();
+    d->m_fnPendingValueExclude = fnExclude;
+    for (const QString& key : source.allKeys()) {
+        if (setSettingPath.find(key) == setSettingPath.cend())
+            d->m_mapPendingValue.insert({ key, source.value(key) });
+    }
+}
+
+bool Settings::applyValue(const QString& settingPath, const QVariant& value)
+{
+    QString path = settingPath;
+    const QStringList listPathPart = settingPath.split('/');
+    if (listPathPart.size() == 2) {
+        for (const Settings_Group& group : d->m_vecGroup) {
+            if (group.identifier.key == listPathPart.at(0).toUtf8()
+                    && !group.vecSection.empty() && group.vecSection.front().isDefault)
+            {
+                path = d->sectionPath(group, group.vecSection.front()) + "/" + listPathPart.at(1);
+                break; // Interrupt
+            }
+        }
+    }
+
+    for (const Settings_Group& group : d->m_vecGroup) {
+        for (const Settings_Section& section : group.vecSection) {
+            const QString sectionPath = d->sectionPath(group, section);
+            for (const Settings_Setting& setting : section.vecSetting) {
+                if (sectionPath + "/" + QString::fromUtf8(setting.property->name().key) == path)
+                    return d->loadValue(setting.property, value);
+            }
+        }
+    }
+
+    d->m_mapPendingValue.insert_or_assign(path, value);
+    return true;
 }
 
 void Settings::loadProperty(Settings::SettingIndex index)
@@ -138,10 +227,58 @@ QVariant Settings::findValueFromKey(const QString& strKey) const
 
 void Settings::save()
 {
+    d->waitForSaveChanges();
+    d->m_timerAutoSave->stop();
+    d->m_setChangedSetting.clear();
     this->saveAs(&d->m_settings);
     d->m_settings.sync();
 }
 
+void Settings::saveChanges()
+{
+    d->m_timerAutoSave->stop();
+    if (d->m_setChangedSetting.empty())
+        return;
+
+    // Values are converted in the calling thread, only the writing to storage is deferred
+    std::vector<std::pair<QString, QVariant>> vecPathValue;
+    for (const Property* prop : d->m_setChangedSetting)
+        vecPathValue.push_back({ d->m_mapSettingPath.at(prop), d->m_propValueConverter->toVariant(*prop) });
+
+    d->m_setChangedSetting.clear();
+    // Previous writing must be over, so storage ends with the latest values
+    d->waitForSaveChanges();
+    const QString storageFileName = d->m_settings.fileName();
+    const QSettings::Format storageFormat = d->m_settings.format();
+    d->m_futureSaveChanges = std::async(std::launch::async, [=]{
+        // QSettings is reentrant, distinct objects can be used from distinct threads
+        QSettings storage(storageFileName, storageFormat);
+        for (const auto& [path, value] : vecPathValue)
+            storage.setValue(path, value);
+
+        storage.sync();
+    });
+}
+
+bool Settings::hasUnsavedChanges() const
+{
+    return !d->m_setChangedSetting.empty();
+}
+
+int Settings::autoSaveDelay() const
+{
+    return d->m_autoSaveDelay;
+}
+
+void Settings::setAutoSaveDelay(int msecs)
+{
+    d->m_autoSaveDelay = std::max(msecs, 0);
+    if (d->m_autoSaveDelay == 0)
+        d->m_timerAutoSave->stop();
+    else if (!d->m_setChangedSetting.empty() && !d->m_timerAutoSave->isActive())
+        d->m_timerAutoSave->start(d->m_autoSaveDelay);
+}
+
 void Settings::saveAs(QSettings* target, const ExcludePropertyPredicate& fnExclude)
 {
     if (!target)
@@ -340,17 +477,31 @@ Settings::SettingIndex Settings::addSetting(Property* property, SectionIndex ind
     section.vecSetting.push_back({});
     Settings_Setting& setting = section.vecSetting.back();
     setting.property = property;
+    const QString settingPath = d->sectionPath(index) + "/" + QString::fromUtf8(property->name().key);
+    d->m_mapSettingPath.insert_or_assign(property, settingPath);
+    if (!d->m_mapPendingValue.empty()) {
+        auto itPending = d->m_mapPendingValue.find(settingPath);
+        if (itPending != d->m_mapPendingValue.end()) {
+            if (!d->m_fnPendingValueExclude || !d->m_fnPendingValueExclude(*property))
+                d->loadValue(property, itPending->second);
+
+            d->m_mapPendingValue.erase(itPending);
+        }
+    }
+
     return SettingIndex(index, int(section.vecSetting.size()) - 1);
 }
 
 void Settings::resetAll()
 {
+    PropertyChangedBatch batch(this);
     for (const SectionResetFunction& sectionResetFn : d->m_vecSectionResetFn)
         sectionResetFn.fnReset();
 }
 
 void Settings::resetGroup(GroupIndex index)
 {
+    PropertyChangedBatch batch(this);
     for (const SectionResetFunction& sectionResetFn : d->m_vecSectionResetFn) {
         if (sectionResetFn.sectionId.group() == index)
             sectionResetFn.fnReset();
@@ -359,6 +510,7 @@ void Settings::resetGroup(GroupIndex index)
 
 void Settings::resetSection(SectionIndex index)
 {
+    PropertyChangedBatch batch(this);
     for (const SectionResetFunction& sectionResetFn : d->m_vecSectionResetFn) {
         if (sectionResetFn.sectionId == index)
             sectionResetFn.fnReset();
@@ -389,7 +541,15 @@ void Settings::setLocale(const QLocale& locale)
 void Settings::onPropertyChanged(Property* prop)
 {
     PropertyGroup::onPropertyChanged(prop);
-    emit this->changed(prop);
+    d->recordChangedSetting(prop);
+    if (!this->recordPropertyChangedInBatch(prop))
+        emit this->changed(prop);
+}
+
+void Settings::onPropertiesChanged(Span<Property* const> props)
+{
+    PropertyGroup::onPropertiesChanged(props);
+    emit this->changedMany(props);
 }
 
 void Settings::onPropertyEnabled(Property* prop, bool on)
@@ -29,15 +29,32 @@ public:
     Settings(QObject* parent = nullptr);
     ~Settings();
 
+    // Stored values of settings not added yet are kept, so they are loaded when the corresponding
+    // settings get added(see addSetting()). This allows registration of settings on first use
     void load();
     void loadProperty(SettingIndex index);
     QVariant findValueFromKey(const QString& strKey) const;
+    // Writes all settings to storage, synchronously
     void save();
+    // Writes to storage only the settings changed since last save, in a background thread
+    void saveChanges();
+    bool hasUnsavedChanges() const;
+
+    // Delay(in milliseconds) after which saveChanges() is called once a setting gets changed
+    // Default is 0, meaning changes are not saved automatically
+    int autoSaveDelay() const;
+    void setAutoSaveDelay(int msecs);
 
     void loadPropertyFrom(const QSettings& source, SettingIndex index);
     void loadFrom(const QSettings& source, const ExcludePropertyPredicate& fnExclude = nullptr);
     void saveAs(QSettings* target, const ExcludePropertyPredicate& fnExclude = nullptr);
 
+    // Assigns 'value' to the setting identified by 'settingPath'("group/section/property", or
+    // "group/property" for the default section of a group). If the setting isn't added yet then
+    // the value is kept pending as values read by loadFrom(), so it must be called after loadFrom()
+    // Returns false if the value couldn't be converted
+    bool applyValue(const QString& settingPath, const QVariant& value);
+
     const PropertyValueConversion& propertyValueConversion() const;
     void setPropertyValueConversion(const PropertyValueConversion& conv);
 
@@ -65,6 +82,8 @@ public:
     SettingIndex addSetting(Property* property, GroupIndex index);
     SettingIndex addSetting(Property* property, SectionIndex index);
 
+    // Reset functions are run within a PropertyChangedBatch, so changed() isn't emitted but
+    // changedMany() is emitted once at the end
     void resetAll();
     void resetGroup(GroupIndex index);
     void resetSection(SectionIndex index);
@@ -77,11 +96,15 @@ public:
 
 signals:
     void changed(Mayo::Property* setting);
+    // Emitted instead of changed() for settings changed within a PropertyChangedBatch
+    // (see resetAll(), loadFrom(), ...)
+    void changedMany(Mayo::Span<Mayo::Property* const> settings);
     void enabled(Mayo::Property* setting, bool on);
 
 protected:
     void onPropertyChanged(Property* prop) override;
     void onPropertyEnabled(Property* prop, bool on) override;
+    void onPropertiesChanged(Span<Property* const> props) override;
 
 private:
     class Private;
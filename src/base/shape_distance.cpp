@@ -0,0 +1,449 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "shape_distance.h"
+#include "bnd_utils.h"
+#include "brep_utils.h"
+#include "clash_detection.h"
+#include "cpp_utils.h"
+#include "global.h"
+#include "task_progress.h"
+
+#include <BRepExtrema_DistShapeShape.hxx>
+#include <BRep_Tool.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Standard_Real.hxx>
+#include <TopoDS_Face.hxx>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Mayo {
+
+namespace {
+
+constexpr uint32_t MaxLeafTriangleCount = 8;
+// Exact measurement is bounded to the closest face pairs, in case of many faces almost at the
+// same distance(eg parallel planar faces meshed with lots of triangles)
+constexpr size_t MaxRefinedFacePairCount = 64;
+
+struct Triangle {
+    gp_XYZ vertices[3];
+    BndBoxCoords box;
+    uint32_t faceIndex;
+};
+
+struct BvhNode {
+    BndBoxCoords box;
+    uint32_t index; // First triangle if leaf node, otherwise right child(left child is next node)
+    uint32_t itemCount; // Zero if not a leaf node
+};
+
+// Triangles of the faces of a shape in world space, with their BVH
+struct ShapeMesh {
+    std::vector<TopoDS_Face> vecFace;
+    std::vector<double> vecFaceDeflection;
+    double maxDeflection = 0.;
+    bool hasNotMeshedFace = false;
+    std::vector<Triangle> vecTriangle;
+    std::vector<BvhNode> vecNode; // Root node comes first
+};
+
+BndBoxCoords unitedBox(const BndBoxCoords& lhs, const BndBoxCoords& rhs)
+{
+    return {
+        std::min(lhs.xmin, rhs.xmin), std::min(lhs.ymin, rhs.ymin), std::min(lhs.zmin, rhs.zmin),
+        std::max(lhs.xmax, rhs.xmax), std::max(lhs.ymax, rhs.ymax), std::max(lhs.zmax, rhs.zmax)
+    };
+}
+
+double boxesDistance(const BndBoxCoords& lhs, const BndBoxCoords& rhs)
+{
+    const double dx = std::max({ 0., lhs.xmin - rhs.xmax, rhs.xmin - lhs.xmax });
+    const double dy = std::max({ 0., lhs.ymin - rhs.ymax, rhs.ymin - lhs.ymax });
+    const double dz = std::max({ 0., lhs.zmin - rhs.zmax, rhs.zmin - lhs.zmax });
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+void buildNodes(ShapeMesh* mesh, uint32_t first, uint32_t last)
+{
+    std::vector<Triangle>& vecTriangle = mesh->vecTriangle;
+    const auto nodeIndex = uint32_t(mesh->vecNode.size());
+    mesh->vecNode.push_back({});
+    BndBoxCoords box = vecTriangle.at(first).box;
+    for (uint32_t i = first + 1; i < last; ++i)
+        box = unitedBox(box, vecTriangle.at(i).box);
+
+    mesh->vecNode.at(nodeIndex).box = box;
+    if (last - first <= MaxLeafTriangleCount) {
+        mesh->vecNode.at(nodeIndex).index = first;
+        mesh->vecNode.at(nodeIndex).itemCount = last - first;
+        return;
+    }
+
+    const double extents[] = { box.xmax - box.xmin, box.ymax - box.ymin, box.zmax - box.zmin };
+    const int axis = int(std::max_element(std::begin(extents), std::end(extents)) - std::begin(extents));
+    const uint32_t middle = first + (last - first) / 2;
+    std::nth_element(
+                vecTriangle.begin() + first, vecTriangle.begin() + middle, vecTriangle.begin() + last,
+                [=](const Triangle& lhs, const Triangle& rhs) {
+        return lhs.vertices[0].Coord(axis + 1) < rhs.vertices[0].Coord(axis + 1);
+    });
+    buildNodes(mesh, first, middle);
+    mesh->vecNode.at(nodeIndex).index = uint32_t(mesh->vecNode.size());
+    mesh->vecNode.at(nodeIndex).itemCount = 0;
+    buildNodes(mesh, middle, last);
+}
+
+ShapeMesh shapeMesh(const TopoDS_Shape& shape)
+{
+    ShapeMesh mesh;
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        if (triangulation.IsNull()) {
+            mesh.hasNotMeshedFace = true;
+            return;
+        }
+
+        const auto faceIndex = uint32_t(mesh.vecFace.size());
+        mesh.vecFace.push_back(face);
+        mesh.vecFaceDeflection.push_back(triangulation->Deflection());
+        mesh.maxDeflection = std::max(mesh.maxDeflection, triangulation->Deflection());
+        const gp_Trsf& trsf = loc.Transformation();
+        const Poly_Array1OfTriangle& vecTriangleIndices = triangulation->Triangles();
+        for (int i = vecTriangleIndices.Lower(); i <= vecTriangleIndices.Upper(); ++i) {
+            int n[3];
+            vecTriangleIndices.Value(i).Get(n[0], n[1], n[2]);
+            Triangle triangle;
+            triangle.faceIndex = faceIndex;
+            for (int j = 0; j < 3; ++j) {
+                triangle.vertices[j] = triangulation->Node(n[j]).XYZ();
+                if (!loc.IsIdentity())
+                    trsf.Transforms(triangle.vertices[j]);
+            }
+
+            const gp_XYZ& p1 = triangle.vertices[0];
+            const gp_XYZ& p2 = triangle.vertices[1];
+            const gp_XYZ& p3 = triangle.vertices[2];
+            triangle.box = {
+                std::min({ p1.X(), p2.X(), p3.X() }),
+                std::min({ p1.Y(), p2.Y(), p3.Y() }),
+                std::min({ p1.Z(), p2.Z(), p3.Z() }),
+                std::max({ p1.X(), p2.X(), p3.X() }),
+                std::max({ p1.Y(), p2.Y(), p3.Y() }),
+                std::max({ p1.Z(), p2.Z(), p3.Z() })
+            };
+            mesh.vecTriangle.push_back(triangle);
+        }
+    });
+
+    if (!mesh.vecTriangle.empty())
+        buildNodes(&mesh, 0, uint32_t(mesh.vecTriangle.size()));
+
+    return mesh;
+}
+
+// Closest point to 'p' on triangle (a, b, c), see "Real-Time Collision Detection" by C. Ericson
+gp_XYZ closestPointOnTriangle(const gp_XYZ& p, const gp_XYZ& a, const gp_XYZ& b, const gp_XYZ& c)
+{
+    const gp_XYZ ab = b - a;
+    const gp_XYZ ac = c - a;
+    const gp_XYZ ap = p - a;
+    const double d1 = ab.Dot(ap);
+    const double d2 = ac.Dot(ap);
+    if (d1 <= 0 && d2 <= 0)
+        return a;
+
+    const gp_XYZ bp = p - b;
+    const double d3 = ab.Dot(bp);
+    const double d4 = ac.Dot(bp);
+    if (d3 >= 0 && d4 <= d3)
+        return b;
+
+    const double vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0)
+        return a + ab * (d1 / (d1 - d3));
+
+    const gp_XYZ cp = p - c;
+    const double d5 = ab.Dot(cp);
+    const double d6 = ac.Dot(cp);
+    if (d6 >= 0 && d5 <= d6)
+        return c;
+
+    const double vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0)
+        return a + ac * (d2 / (d2 - d6));
+
+    const double va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    const double sum = va + vb + vc;
+    if (sum <= 0) // Degenerated triangle
+        return a;
+
+    return a + ab * (vb / sum) + ac * (vc / sum);
+}
+
+// Closest points of segments [p1, q1] and [p2, q2], see "Real-Time Collision Detection"
+std::pair<gp_XYZ, gp_XYZ> closestPointsOnSegments(
+        const gp_XYZ& p1, const gp_XYZ& q1, const gp_XYZ& p2, const gp_XYZ& q2)
+{
+    const double eps = gp::Resolution();
+    const gp_XYZ d1 = q1 - p1;
+    const gp_XYZ d2 = q2 - p2;
+    const gp_XYZ r = p1 - p2;
+    const double a = d1.SquareModulus();
+    const double e = d2.SquareModulus();
+    const double f = d2.Dot(r);
+    double s = 0.;
+    double t = 0.;
+    if (a <= eps && e > eps) {
+        t = std::clamp(f / e, 0., 1.);
+    }
+    else if (a > eps) {
+        const double c = d1.Dot(r);
+        if (e <= eps) {
+            s = std::clamp(-c / a, 0., 1.);
+        }
+        else {
+            const double b = d1.Dot(d2);
+            const double denom = a * e - b * b;
+            s = denom != 0 ? std::clamp((b * f - c * e) / denom, 0., 1.) : 0.;
+            t = (b * s + f) / e;
+            if (t < 0.) {
+                t = 0.;
+                s = std::clamp(-c / a, 0., 1.);
+            }
+            else if (t > 1.) {
+                t = 1.;
+                s = std::clamp((b - c) / a, 0., 1.);
+            }
+        }
+    }
+
+    return { p1 + d1 * s, p2 + d2 * t };
+}
+
+struct TrianglesDistance {
+    double value;
+    gp_XYZ pnt1;
+    gp_XYZ pnt2;
+};
+
+// Minimum distance between two triangles: zero if they cross each other, otherwise it's reached
+// at a vertex of one triangle or between two edges
+TrianglesDistance trianglesDistance(const Triangle& tri1, const Triangle& tri2)
+{
+    const gp_XYZ* v1 = tri1.vertices;
+    const gp_XYZ* v2 = tri2.vertices;
+    if (ClashDetection::trianglesIntersect(v1, v2)) {
+        // Points are indicative only, they aren't computed on the intersection
+        const gp_XYZ pnt = closestPointOnTriangle(v1[0], v2[0], v2[1], v2[2]);
+        return { 0., pnt, pnt };
+    }
+
+    double minSqDist = RealLast();
+    TrianglesDistance result = { 0., {}, {} };
+    auto fnCheck = [&](const gp_XYZ& pnt1, const gp_XYZ& pnt2) {
+        const double sqDist = (pnt2 - pnt1).SquareModulus();
+        if (sqDist < minSqDist) {
+            minSqDist = sqDist;
+            result.pnt1 = pnt1;
+            result.pnt2 = pnt2;
+        }
+    };
+    for (int i = 0; i < 3; ++i) {
+        fnCheck(v1[i], closestPointOnTriangle(v1[i], v2[0], v2[1], v2[2]));
+        fnCheck(closestPointOnTriangle(v2[i], v1[0], v1[1], v1[2]), v2[i]);
+        for (int j = 0; j < 3; ++j) {
+            const auto pnts = closestPointsOnSegments(v1[i], v1[(i + 1) % 3], v2[j], v2[(j + 1) % 3]);
+            fnCheck(pnts.first, pnts.second);
+        }
+    }
+
+    result.value = std::sqrt(minSqDist);
+    return result;
+}
+
+ShapeDistance exactDistance(const TopoDS_Shape& shape1, const TopoDS_Shape& shape2)
+{
+    ShapeDistance distance;
+    BRepExtrema_DistShapeShape distShapeShape(shape1, shape2);
+    if (distShapeShape.IsDone() && distShapeShape.NbSolution() > 0) {
+        distance.value = distShapeShape.Value();
+        distance.pnt1 = distShapeShape.PointOnShape1(1);
+        distance.pnt2 = distShapeShape.PointOnShape2(1);
+        distance.isExact = true;
+    }
+
+    return distance;
+}
+
+} // namespace
+
+ShapeDistance ShapeDistance::compute(const TopoDS_Shape& shape1, const TopoDS_Shape& shape2, TaskProgress* progress)
+{
+    if (shape1.IsNull() || shape2.IsNull())
+        return {};
+
+    const ShapeMesh mesh1 = shapeMesh(shape1);
+    const ShapeMesh mesh2 = shapeMesh(shape2);
+    if (mesh1.hasNotMeshedFace || mesh2.hasNotMeshedFace || mesh1.vecNode.empty() || mesh2.vecNode.empty())
+        return exactDistance(shape1, shape2);
+
+    // Leaves of the first BVH are processed concurrently, the closest to the second shape first so
+    // the minimum distance found so far quickly prunes the traversals
+    std::vector<uint32_t> vecLeaf1;
+    for (uint32_t i = 0; i < mesh1.vecNode.size(); ++i) {
+        if (mesh1.vecNode.at(i).itemCount > 0)
+            vecLeaf1.push_back(i);
+    }
+
+    const BndBoxCoords& rootBox2 = mesh2.vecNode.front().box;
+    std::sort(vecLeaf1.begin(), vecLeaf1.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return boxesDistance(mesh1.vecNode.at(lhs).box, rootBox2) < boxesDistance(mesh1.vecNode.at(rhs).box, rootBox2);
+    });
+
+    // Face pairs are candidates for exact measurement if their triangles are within the
+    // triangulation error of the minimum distance
+    const double margin = mesh1.maxDeflection + mesh2.maxDeflection;
+    ShapeDistance approxDistance;
+    std::atomic<double> minDistance = RealLast();
+    std::unordered_map<uint64_t, double> mapFacePairDistance;
+    std::mutex mutexResult;
+    const int leafCount = int(vecLeaf1.size());
+    std::atomic<int> doneCount = 0;
+    std::mutex mutexProgress;
+    CppUtils::parallelFor(leafCount, [&](int i) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        const BvhNode& leaf1 = mesh1.vecNode.at(vecLeaf1.at(i));
+        std::unordered_map<uint64_t, double> mapLocalFacePairDistance;
+        std::vector<uint32_t> stackNodeIndex = { 0 };
+        while (!stackNodeIndex.empty()) {
+            const uint32_t nodeIndex2 = stackNodeIndex.back();
+            stackNodeIndex.pop_back();
+            const BvhNode& node2 = mesh2.vecNode.at(nodeIndex2);
+            if (boxesDistance(leaf1.box, node2.box) > minDistance + 2 * margin)
+                continue;
+
+            if (node2.itemCount == 0) {
+                stackNodeIndex.push_back(node2.index);
+                stackNodeIndex.push_back(nodeIndex2 + 1);
+                continue;
+            }
+
+            for (uint32_t k1 = leaf1.index; k1 < leaf1.index + leaf1.itemCount; ++k1) {
+                const Triangle& tri1 = mesh1.vecTriangle.at(k1);
+                for (uint32_t k2 = node2.index; k2 < node2.index + node2.itemCount; ++k2) {
+                    const Triangle& tri2 = mesh2.vecTriangle.at(k2);
+                    if (boxesDistance(tri1.box, tri2.box) > minDistance + 2 * margin)
+                        continue;
+
+                    const TrianglesDistance dist = trianglesDistance(tri1, tri2);
+                    if (dist.value < minDistance) {
+                        std::lock_guard<std::mutex> lock(mutexResult); MAYO_UNUSED(lock);
+                        if (dist.value < minDistance) {
+                            minDistance = dist.value;
+                            approxDistance.value = dist.value;
+                            approxDistance.pnt1 = dist.pnt1;
+                            approxDistance.pnt2 = dist.pnt2;
+                        }
+                    }
+
+                    if (dist.value <= minDistance + 2 * margin) {
+                        const uint64_t key = (uint64_t(tri1.faceIndex) << 32) | tri2.faceIndex;
+                        auto itInserted = mapLocalFacePairDistance.insert({ key, dist.value });
+                        if (!itInserted.second)
+                            itInserted.first->second = std::min(itInserted.first->second, dist.value);
+                    }
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutexResult); MAYO_UNUSED(lock);
+            for (const auto& keyValue : mapLocalFacePairDistance) {
+                auto itInserted = mapFacePairDistance.insert(keyValue);
+                if (!itInserted.second)
+                    itInserted.first->second = std::min(itInserted.first->second, keyValue.second);
+            }
+        }
+
+        const int count = ++doneCount;
+        if (progress) {
+            std::lock_guard<std::mutex> lock(mutexProgress);
+            const int pct = (count * 50) / leafCount;
+            if (pct > progress->value())
+                progress->setValue(pct);
+        }
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    // Exact distance between faces F1 and F2 is at least their triangle distance minus the
+    // deflection of both faces, and the minimum is at most the approximate one plus 'margin'
+    struct FacePair {
+        uint32_t faceIndex1;
+        uint32_t faceIndex2;
+        double approxDistance;
+    };
+    std::vector<FacePair> vecFacePair;
+    for (const auto& keyValue : mapFacePairDistance) {
+        const auto faceIndex1 = uint32_t(keyValue.first >> 32);
+        const auto faceIndex2 = uint32_t(keyValue.first & 0xFFFFFFFF);
+        const double faceMargin = mesh1.vecFaceDeflection.at(faceIndex1) + mesh2.vecFaceDeflection.at(faceIndex2);
+        if (keyValue.second <= approxDistance.value + margin + faceMargin)
+            vecFacePair.push_back({ faceIndex1, faceIndex2, keyValue.second });
+    }
+
+    std::sort(vecFacePair.begin(), vecFacePair.end(), [](const FacePair& lhs, const FacePair& rhs) {
+        return lhs.approxDistance < rhs.approxDistance;
+    });
+    if (vecFacePair.size() > MaxRefinedFacePairCount)
+        vecFacePair.resize(MaxRefinedFacePairCount);
+
+    const int facePairCount = int(vecFacePair.size());
+    std::vector<ShapeDistance> vecFacePairDistance(vecFacePair.size());
+    doneCount = 0;
+    CppUtils::parallelFor(facePairCount, [&](int i) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        const FacePair& facePair = vecFacePair.at(i);
+        vecFacePairDistance.at(i) = exactDistance(
+                    mesh1.vecFace.at(facePair.faceIndex1), mesh2.vecFace.at(facePair.faceIndex2));
+        const int count = ++doneCount;
+        if (progress) {
+            std::lock_guard<std::mutex> lock(mutexProgress);
+            const int pct = 50 + (count * 50) / facePairCount;
+            if (pct > progress->value())
+                progress->setValue(pct);
+        }
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    ShapeDistance distance = approxDistance;
+    for (const ShapeDistance& facePairDistance : vecFacePairDistance) {
+        if (facePairDistance.isExact && (!distance.isExact || facePairDistance.value < distance.value))
+            distance = facePairDistance;
+    }
+
+    return distance;
+}
+
+} // namespace Mayo
@@ -0,0 +1,32 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <gp_Pnt.hxx>
+#include <TopoDS_Shape.hxx>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Minimum distance between two shapes
+// Distance is first approximated from the face triangulations, with a BVH-vs-BVH traversal of
+// their triangles. Then only the pairs of faces whose triangles are within the approximation
+// error of the minimum are measured on exact geometry(BRepExtrema_DistShapeShape)
+struct ShapeDistance {
+    double value = -1.; // Negative if not computed
+    gp_Pnt pnt1; // Closest point on first shape
+    gp_Pnt pnt2; // Closest point on second shape
+    bool isExact = false; // False if 'value' is only the triangulation-based approximation
+
+    // Shapes having faces without triangulation are measured directly on exact geometry
+    // Returns null distance if abort is requested on 'progress'
+    static ShapeDistance compute(
+            const TopoDS_Shape& shape1, const TopoDS_Shape& shape2, TaskProgress* progress = nullptr);
+};
+
+} // namespace Mayo
@@ -0,0 +1,102 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "stream_utils.h"
+
+#include <QtCore/QIODevice>
+#include <vector>
+
+namespace Mayo {
+
+namespace {
+constexpr std::streamsize StreamChunkSize = 1024 * 1024;
+} // namespace
+
+bool StreamUtils::copy(std::istream& istr, QIODevice* device)
+{
+    if (!device)
+        return false;
+
+    std::vector<char> buffer(StreamChunkSize);
+    while (istr) {
+        istr.read(buffer.data(), StreamChunkSize);
+        const qint64 count = istr.gcount();
+        if (count > 0 && device->write(buffer.data(), count) != count)
+            return false;
+    }
+
+    return !istr.bad();
+}
+
+bool StreamUtils::copy(QIODevice* device, std::ostream& ostr)
+{
+    if (!device)
+        return false;
+
+    std::vector<char> buffer(StreamChunkSize);
+    while (ostr) {
+        const qint64 count = device->read(buffer.data(), StreamChunkSize);
+        if (count < 0)
+            return false;
+
+        if (count == 0)
+            break;
+
+        ostr.write(buffer.data(), count);
+    }
+
+    ostr.flush();
+    return ostr.good();
+}
+
+bool StreamUtils::readAll(std::istream& istr, std::string* ptrData)
+{
+    std::vector<char> buffer(StreamChunkSize);
+    while (istr) {
+        istr.read(buffer.data(), StreamChunkSize);
+        ptrData->append(buffer.data(), size_t(istr.gcount()));
+    }
+
+    return !istr.bad();
+}
+
+bool StreamUtils::isSeekable(std::istream& istr)
+{
+    return istr.rdbuf() && istr.rdbuf()->pubseekoff(0, std::ios_base::cur, std::ios_base::in) != std::streampos(-1);
+}
+
+StreamUtils::MemoryInputBuffer::MemoryInputBuffer(const char* data, size_t size)
+{
+    // Get area is never written through, std::streambuf just lacks a const interface
+    char* begin = const_cast<char*>(data);
+    this->setg(begin, begin, begin + size);
+}
+
+std::streambuf::pos_type StreamUtils::MemoryInputBuffer::seekoff(
+        off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if (!(which & std::ios_base::in))
+        return pos_type(off_type(-1));
+
+    off_type pos = off;
+    if (dir == std::ios_base::cur)
+        pos += this->gptr() - this->eback();
+    else if (dir == std::ios_base::end)
+        pos += this->egptr() - this->eback();
+
+    if (pos < 0 || pos > this->egptr() - this->eback())
+        return pos_type(off_type(-1));
+
+    this->setg(this->eback(), this->eback() + pos, this->egptr());
+    return pos_type(pos);
+}
+
+std::streambuf::pos_type StreamUtils::MemoryInputBuffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return this->seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+} // namespace Mayo
@@ -0,0 +1,44 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+class QIODevice;
+
+namespace Mayo {
+
+// Helpers around standard streams, eg to expose data already in memory as std::istream
+struct StreamUtils {
+    // Copies the remaining data of 'istr' into 'device', by chunks
+    static bool copy(std::istream& istr, QIODevice* device);
+    static bool copy(QIODevice* device, std::ostream& ostr);
+
+    // Appends the remaining data of 'istr' to 'ptrData'
+    static bool readAll(std::istream& istr, std::string* ptrData);
+
+    // Whether 'istr' supports seeking, which is not the case of pipes
+    static bool isSeekable(std::istream& istr);
+
+    class MemoryInputBuffer;
+};
+
+// Read-only stream buffer over data owned by the caller, so it can be read with std::istream
+// without any copy. Seeking is supported
+class StreamUtils::MemoryInputBuffer : public std::streambuf {
+public:
+    MemoryInputBuffer(const char* data, size_t size);
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+};
+
+} // namespace Mayo
@@ -6,22 +6,110 @@
 
 #include "string_utils.h"
 
+#include "global.h"
 #include "unit_system.h"
 #include <gp_Trsf.hxx>
 #include <Precision.hxx>
 #include <Quantity_Color.hxx>
+#include <Standard_CLocaleSentry.hxx>
+#include <QtCore/QVarLengthArray>
+#include <algorithm>
 #include <cctype>
+#include <cstdio>
+#include <initializer_list>
+#include <unordered_map>
 
 namespace Mayo {
 
-static QString valueText(double value, const StringUtils::TextOptions& opt)
+namespace {
+
+// Text buffer living on the stack for usual sizes, QString is built only once at the end
+using TextBuffer = QVarLengthArray<QChar, 256>;
+
+// Number characters of a locale, cached as querying QLocale for each value is not free
+struct LocaleChars {
+    QLocale locale;
+    QChar decimalPoint;
+    QChar groupSeparator;
+    QChar negativeSign;
+    QChar zeroDigit;
+    bool omitGroupSeparator;
+};
+
+const LocaleChars& localeChars(const QLocale& locale)
+{
+    thread_local LocaleChars chars = {};
+    thread_local bool isCacheValid = false;
+    if (!isCacheValid || chars.locale != locale) {
+        chars.locale = locale;
+        chars.decimalPoint = locale.decimalPoint();
+        chars.groupSeparator = locale.groupSeparator();
+        chars.negativeSign = locale.negativeSign();
+        chars.zeroDigit = locale.zeroDigit();
+        chars.omitGroupSeparator = locale.numberOptions() & QLocale::OmitGroupSeparator;
+        isCacheValid = true;
+    }
+
+    return chars;
+}
+
+// Unit symbols are UTF8 string literals owned by UnitSystem, so the pointer is a valid key
+const QString& unitText(const char* strUnit)
+{
+    thread_local std::unordered_map<const char*, QString> mapUnitText;
+    auto it = mapUnitText.find(strUnit);
+    if (it == mapUnitText.end())
+        it = mapUnitText.emplace(strUnit, QString::fromUtf8(strUnit)).first;
+
+    return it->second;
+}
+
+// Translated format strings, looked up once per thread
+const QString& coordsFormat()
+{
+    thread_local const QString format = StringUtils::tr("(%1 %2 %3)");
+    return format;
+}
+
+const QString& trsfFormat()
+{
+    thread_local const QString format = StringUtils::tr("[%1; %2%3; %4]");
+    return format;
+}
+
+void appendText(TextBuffer* buff, const QString& str)
+{
+    buff->append(str.constData(), str.size());
+}
+
+// Appends 'format' where place markers %1..%9 are replaced by the corresponding 'args'
+void appendFormatted(TextBuffer* buff, const QString& format, std::initializer_list<const TextBuffer*> args)
+{
+    const QChar* itChar = format.constBegin();
+    const QChar* itEnd = format.constEnd();
+    while (itChar != itEnd) {
+        if (*itChar == QChar('%') && (itChar + 1) != itEnd) {
+            const int iArg = (itChar + 1)->digitValue() - 1;
+            if (iArg >= 0 && iArg < int(args.size())) {
+                const TextBuffer* arg = *(args.begin() + iArg);
+                buff->append(arg->constData(), arg->size());
+                itChar += 2;
+                continue;
+            }
+        }
+
+        buff->append(*itChar);
+        ++itChar;
+    }
+}
+
+QString valueText_QLocale(double value, const StringUtils::TextOptions& opt)
 {
     auto fnLastChar = [](const QString& str) {
         return !str.isEmpty() ? str.at(str.size() - 1) : QChar();
     };
 
-    const double c = std::abs(value) < Precision::Confusion() ? 0. : value;
-    QString str = opt.locale.toString(c, 'f', opt.unitDecimals);
+    QString str = opt.locale.toString(value, 'f', opt.unitDecimals);
     const QChar chDecPnt = opt.locale.decimalPoint();
     const int posPnt = str.indexOf(chDecPnt);
     if (posPnt != -1) { // Remove useless trailing zeroes
@@ -35,38 +123,107 @@ static QString valueText(double value, const StringUtils::TextOptions& opt)
     return str;
 }
 
-static QString coordsText(const gp_XYZ& coords, const StringUtils::TextOptions& opt)
+// Same output as valueText_QLocale() but without any heap allocation for usual values
+void appendValueText(TextBuffer* buff, double value, const StringUtils::TextOptions& opt)
+{
+    const double c = std::abs(value) < Precision::Confusion() ? 0. : value;
+    // snprintf() rounds exactly like QLocale::toString(), its decimal point depends on C locale
+    // so any non-digit character after the integral part is considered as the decimal point
+    char strC[64];
+    const int lenC = std::snprintf(strC, sizeof(strC), "%.*f", std::max(opt.unitDecimals, 0), c);
+    const char* itDigit = strC[0] == '-' ? strC + 1 : strC;
+    int lenInt = 0;
+    while (std::isdigit(static_cast<unsigned char>(itDigit[lenInt])))
+        ++lenInt;
+
+    int lenDecimals = lenC - int(itDigit - strC) - lenInt - 1;
+    while (lenDecimals > 0 && itDigit[lenInt + lenDecimals] == '0')
+        --lenDecimals; // Remove useless trailing zeroes
+
+    const bool isNegative = itDigit != strC;
+    const bool isZero = lenDecimals <= 0 && lenInt == 1 && itDigit[0] == '0';
+    if (lenC <= 0 || lenC >= int(sizeof(strC)) || (isNegative && isZero)) {
+        // Let QLocale handle unusual cases(huge values, "-0" rounding, ...)
+        appendText(buff, valueText_QLocale(c, opt));
+        return;
+    }
+
+    const LocaleChars& chars = localeChars(opt.locale);
+    auto fnAppendDigit = [&](char digit) {
+        buff->append(QChar(ushort(chars.zeroDigit.unicode() + (digit - '0'))));
+    };
+
+    if (isNegative)
+        buff->append(chars.negativeSign);
+
+    for (int i = 0; i < lenInt; ++i) {
+        // Qt5 groups integral digits by three
+        if (i > 0 && !chars.omitGroupSeparator && (lenInt - i) % 3 == 0)
+            buff->append(chars.groupSeparator);
+
+        fnAppendDigit(itDigit[i]);
+    }
+
+    if (lenDecimals > 0) {
+        buff->append(chars.decimalPoint);
+        for (int i = 0; i < lenDecimals; ++i)
+            fnAppendDigit(itDigit[lenInt + 1 + i]);
+    }
+}
+
+void appendCoordsText(TextBuffer* buff, const gp_XYZ& coords, const StringUtils::TextOptions& opt)
 {
-    const QString strX = valueText(coords.X(), opt);
-    const QString strY = valueText(coords.Y(), opt);
-    const QString strZ = valueText(coords.Z(), opt);
-    return StringUtils::tr("(%1 %2 %3)").arg(strX, strY, strZ);
+    TextBuffer strX, strY, strZ;
+    appendValueText(&strX, coords.X(), opt);
+    appendValueText(&strY, coords.Y(), opt);
+    appendValueText(&strZ, coords.Z(), opt);
+    appendFormatted(buff, coordsFormat(), { &strX, &strY, &strZ });
 }
 
-static QString pntCoordText(double coord, const StringUtils::TextOptions& opt)
+void appendPntCoordText(TextBuffer* buff, double coord, const StringUtils::TextOptions& opt)
 {
     const UnitSystem::TranslateResult trCoord =
             UnitSystem::translate(opt.unitSchema, coord * Quantity_Millimeter);
-    const QString strValue = valueText(trCoord.value, opt);
-    return strValue + trCoord.strUnit;
+    appendValueText(buff, trCoord.value, opt);
+    if (trCoord.strUnit)
+        appendText(buff, unitText(trCoord.strUnit));
+}
+
+void appendPntText(TextBuffer* buff, const gp_Pnt& pos, const StringUtils::TextOptions& opt)
+{
+    TextBuffer strX, strY, strZ;
+    appendPntCoordText(&strX, pos.X(), opt);
+    appendPntCoordText(&strY, pos.Y(), opt);
+    appendPntCoordText(&strZ, pos.Z(), opt);
+    appendFormatted(buff, coordsFormat(), { &strX, &strY, &strZ });
 }
 
+QString toQString(const TextBuffer& buff)
+{
+    return QString(buff.constData(), buff.size());
+}
+
+} // namespace
+
 QString StringUtils::text(double value, const TextOptions& opt)
 {
-    return valueText(value, opt);
+    TextBuffer buff;
+    appendValueText(&buff, value, opt);
+    return toQString(buff);
 }
 
 QString StringUtils::text(const gp_Pnt& pos, const TextOptions& opt)
 {
-    const QString strX = pntCoordText(pos.X(), opt);
-    const QString strY = pntCoordText(pos.Y(), opt);
-    const QString strZ = pntCoordText(pos.Z(), opt);
-    return tr("(%1 %2 %3)").arg(strX, strY, strZ);
+    TextBuffer buff;
+    appendPntText(&buff, pos, opt);
+    return toQString(buff);
 }
 
 QString StringUtils::text(const gp_Dir& dir, const TextOptions& opt)
 {
-    return coordsText(dir.XYZ(), opt);
+    TextBuffer buff;
+    appendCoordsText(&buff, dir.XYZ(), opt);
+    return toQString(buff);
 }
 
 QString StringUtils::text(const gp_Trsf& trsf, const TextOptions& opt)
@@ -76,11 +233,16 @@ QString StringUtils::text(const gp_Trsf& trsf, const TextOptions& opt)
     trsf.GetRotation(axisRotation, angleRotation);
     const UnitSystem::TranslateResult trAngleRotation =
             UnitSystem::degrees(angleRotation * Quantity_Radian);
-    return tr("[%1; %2%3; %4]").arg(
-                coordsText(axisRotation, opt),
-                valueText(trAngleRotation.value, opt),
-                QString::fromUtf8(trAngleRotation.strUnit),
-                StringUtils::text(gp_Pnt(trsf.TranslationPart()), opt));
+    TextBuffer strAxis, strAngle, strAngleUnit, strTranslation;
+    appendCoordsText(&strAxis, axisRotation, opt);
+    appendValueText(&strAngle, trAngleRotation.value, opt);
+    if (trAngleRotation.strUnit)
+        appendText(&strAngleUnit, unitText(trAngleRotation.strUnit));
+
+    appendPntText(&strTranslation, gp_Pnt(trsf.TranslationPart()), opt);
+    TextBuffer buff;
+    appendFormatted(&buff, trsfFormat(), { &strAxis, &strAngle, &strAngleUnit, &strTranslation });
+    return toQString(buff);
 }
 
 QString StringUtils::text(const Quantity_Color& color, const QString& format)
@@ -137,6 +299,57 @@ QString StringUtils::fromUtf8(const Handle_TCollection_HAsciiString& str) {
     return StringUtils::fromUtf8(str ? str->String() : TCollection_AsciiString());
 }
 
+std::string StringUtils::jsonQuoted(std::string_view str)
+{
+    std::string strQuoted;
+    strQuoted.reserve(str.size() + 2);
+    strQuoted += '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            strQuoted += '\\';
+            strQuoted += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            const char hexDigits[] = "0123456789abcdef";
+            strQuoted += "\\u00";
+            strQuoted += hexDigits[(c >> 4) & 0xF];
+            strQuoted += hexDigits[c & 0xF];
+        }
+        else {
+            strQuoted += c;
+        }
+    }
+
+    strQuoted += '"';
+    return strQuoted;
+}
+
+int StringUtils::formatNumber(char* buff, int buffSize, double value, std::chars_format fmt, int precision)
+{
+#if __cpp_lib_to_chars
+    const std::to_chars_result res = std::to_chars(buff, buff + buffSize, value, fmt, precision);
+    return res.ec == std::errc() ? int(res.ptr - buff) : 0;
+#else
+    const char* format = "%.*g";
+    if (fmt == std::chars_format::scientific)
+        format = "%.*e";
+    else if (fmt == std::chars_format::fixed)
+        format = "%.*f";
+
+    const Standard_CLocaleSentry cLocale;
+    MAYO_UNUSED(cLocale);
+    const int len = std::snprintf(buff, size_t(buffSize), format, precision, value);
+    return len > 0 && len < buffSize ? len : 0;
+#endif
+}
+
+void StringUtils::appendNumber(std::string* dst, double value, std::chars_format fmt, int precision)
+{
+    char buff[64];
+    const int len = StringUtils::formatNumber(buff, int(sizeof(buff)), value, fmt, precision);
+    dst->append(buff, size_t(len));
+}
+
 QString StringUtils::fromUtf8(std::string_view str) {
     return QString::fromUtf8(str.data(), str.size());
 }
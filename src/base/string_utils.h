@@ -13,6 +13,7 @@
 #include <TCollection_AsciiString.hxx>
 #include <TCollection_ExtendedString.hxx>
 #include <TCollection_HAsciiString.hxx>
+#include <charconv>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -47,6 +48,15 @@ public:
 
     static void append(QString* dst, const QString& str, const QLocale& locale = QLocale());
 
+    // Returns 'str' enclosed in double quotes, escaped as a JSON string
+    static std::string jsonQuoted(std::string_view str);
+
+    // Writes 'value' into 'buff' as std::to_chars() does, decimal point is always '.' whatever the
+    // C locale(Qt sets it to the user locale on Unix). Meant for the numbers of text file formats
+    // Returns the count of characters written, 0 if 'buffSize' is too small
+    static int formatNumber(char* buff, int buffSize, double value, std::chars_format fmt, int precision);
+    static void appendNumber(std::string* dst, double value, std::chars_format fmt, int precision);
+
     // Qt/OpenCascade string conversion
     template<typename OTHER_STRING_TYPE>
     static OTHER_STRING_TYPE toUtf8(const QString& str);
@@ -13,4 +13,12 @@ namespace Mayo {
 using TaskId = uint64_t;
 enum class TaskAutoDestroy { On, Off };
 
+// Scheduling class of a task, queued tasks of higher priority are started first
+// Running background tasks are preempted at progress checkpoints while tasks of higher priority
+// are waiting for room in the thread pool
+enum class TaskPriority { Background, Normal, Interactive };
+
+// Resource limit of a task whose exceeding caused the task to be aborted
+enum class TaskLimit { None, Time, Memory };
+
 } // namespace Mayo
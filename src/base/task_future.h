@@ -0,0 +1,113 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "task_common.h"
+
+#include <QtCore/QString>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace Mayo {
+
+class TaskManager;
+
+// Result of a task created with TaskManager::newTaskFuture(), available once the task is ended
+// Result is either a value returned by the job, an error(exception thrown by the job) or abort
+// The future is a shared handle, copies refer to the same result which outlives the task
+// Note: T can't be void, use TaskManager::newTask() instead
+template<typename T>
+class TaskFuture {
+public:
+    enum class Status { Pending, Value, Error, Aborted };
+
+    TaskFuture() = default; // Invalid future, not attached to any task
+    bool isValid() const { return d != nullptr; }
+
+    TaskId taskId() const { return d ? d->taskId : TaskId(0); }
+
+    Status status() const {
+        if (!d)
+            return Status::Pending;
+
+        std::lock_guard<std::mutex> lock(d->mutex);
+        return d->status;
+    }
+
+    bool isReady() const { return this->status() != Status::Pending; }
+    bool hasValue() const { return this->status() == Status::Value; }
+    bool hasError() const { return this->status() == Status::Error; }
+    bool isAborted() const { return this->status() == Status::Aborted; }
+
+    // Blocks until the result is available, at most 'msecs' if >= 0
+    // Result is 'Aborted' if the task is destroyed without being run
+    // Returns whether the result is available
+    bool waitForReady(int msecs = -1) const {
+        if (!d)
+            return false;
+
+        std::unique_lock<std::mutex> lock(d->mutex);
+        auto fnReady = [=]{ return d->status != Status::Pending; };
+        if (msecs < 0) {
+            d->condition.wait(lock, fnReady);
+            return true;
+        }
+
+        return d->condition.wait_for(lock, std::chrono::milliseconds(msecs), fnReady);
+    }
+
+    // Value returned by the job, undefined if hasValue() is false
+    // Safe to be called without lock as the result is never modified once available
+    const T& value() const { return *d->value; }
+
+    // Message of the exception thrown by the job, empty if hasError() is false
+    const QString& errorMessage() const { return d->errorMessage; }
+
+private:
+    struct State {
+        TaskId taskId = 0;
+        mutable std::mutex mutex;
+        std::condition_variable condition;
+        Status status = Status::Pending;
+        std::optional<T> value;
+        QString errorMessage;
+    };
+
+    // Called once by the task, from the thread running the job
+    void setResult(Status status, std::optional<T>&& value, const QString& errorMessage) {
+        {
+            std::lock_guard<std::mutex> lock(d->mutex);
+            d->value = std::move(value);
+            d->errorMessage = errorMessage;
+            d->status = status;
+        }
+
+        d->condition.notify_all();
+    }
+
+    // Called once the job of the task is destroyed, the result is aborted if the job wasn't run
+    // (eg task destroyed before run, or TaskManager deleted with the task not run)
+    void abortIfPending() {
+        {
+            std::lock_guard<std::mutex> lock(d->mutex);
+            if (d->status != Status::Pending)
+                return;
+
+            d->status = Status::Aborted;
+        }
+
+        d->condition.notify_all();
+    }
+
+    friend class TaskManager;
+    std::shared_ptr<State> d;
+};
+
+} // namespace Mayo
@@ -6,15 +6,34 @@
 
 #include "task_manager.h"
 #include "math_utils.h"
+#include "process_utils.h"
+#include "trace_recorder.h"
 
 #include <QtCore/QtDebug>
 #include <QtCore/QCoreApplication>
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <stdexcept>
 
 namespace Mayo {
 
+namespace {
+
+// Task being run by the pool worker of the current thread
+thread_local const Task* threadPoolTask = nullptr;
+
+int64_t steadyClockMsecs()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
 TaskManager::TaskManager(QObject* parent)
-    : QObject(parent)
+    : QObject(parent),
+      m_slotChunks(new std::atomic<Slot*>[SlotChunkMaxCount])
 {
     static bool staticTypesRegistered = false;
     if (!staticTypesRegistered) {
@@ -22,21 +41,40 @@ TaskManager::TaskManager(QObject* parent)
         qRegisterMetaType<TaskId>("TaskId");
         staticTypesRegistered = true;
     }
+
+    for (uint32_t i = 0; i < SlotChunkMaxCount; ++i)
+        m_slotChunks[i] = nullptr;
+
+    m_poolSize = std::max(int(std::thread::hardware_concurrency()), 1);
+    if (TraceRecorder::isRecording())
+        TraceRecorder::global()->attach(this);
 }
 
 TaskManager::~TaskManager()
 {
     // Make sure all tasks are really finished
-    for (const auto& mapPair : m_mapEntity) {
-        const std::unique_ptr<Entity>& ptrEntity = mapPair.second;
-        if (ptrEntity->control.valid())
-            ptrEntity->control.wait();
+    this->foreachTask([=](TaskId id) { this->waitEntity(this->findEntity(id)); });
+
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        m_poolStopRequested = true;
+    }
+
+    m_poolCondition.notify_all();
+    for (std::thread& worker : m_vecPoolWorker)
+        worker.join();
+
+    {
+        std::lock_guard<std::mutex> lock(m_watchdogMutex);
+        m_watchdogStopRequested = true;
     }
 
-    // Erase the task from its container before destruction, this will allow TaskProgress destructor
-    // to behave correctly(it calls TaskProgress::setValue())
-    for (auto it = m_mapEntity.begin(); it != m_mapEntity.end(); )
-        it = m_mapEntity.erase(it);
+    m_watchdogCondition.notify_all();
+    if (m_watchdog.joinable())
+        m_watchdog.join();
+
+    for (uint32_t i = 0; i < SlotChunkMaxCount; ++i)
+        delete[] m_slotChunks[i].load();
 }
 
 TaskManager* TaskManager::globalInstance()
@@ -48,15 +86,91 @@ TaskManager* TaskManager::globalInstance()
     return global;
 }
 
-TaskId TaskManager::newTask(TaskJob fn)
+TaskId TaskManager::newTask(TaskJob fn, TaskPriority priority)
+{
+    std::lock_guard<std::mutex> lock(m_registryMutex);
+    uint32_t index = 0;
+    if (!m_vecFreeSlotIndex.empty()) {
+        index = m_vecFreeSlotIndex.back();
+        m_vecFreeSlotIndex.pop_back();
+    }
+    else {
+        index = m_slotCount.load(std::memory_order_relaxed);
+        const uint32_t chunkIndex = index / SlotChunkSize;
+        if (chunkIndex >= SlotChunkMaxCount)
+            throw std::length_error("TaskManager capacity exceeded");
+
+        if (!m_slotChunks[chunkIndex].load(std::memory_order_relaxed))
+            m_slotChunks[chunkIndex].store(new Slot[SlotChunkSize], std::memory_order_release);
+
+        // Publish the new slot only once its chunk is available
+        m_slotCount.store(index + 1, std::memory_order_release);
+    }
+
+    Slot* slot = this->findSlot(index);
+    const uint32_t generation = slot->generation.load(std::memory_order_relaxed) + 1;
+    const TaskId taskId = (TaskId(generation) << 32) | index;
+    Entity* entity = &slot->entity;
+    entity->task.m_id = taskId;
+    entity->task.m_fn = std::move(fn);
+    entity->task.m_manager = this;
+    entity->taskProgress.setTask(&entity->task);
+    entity->taskProgress.reset();
+    entity->title.clear();
+    entity->perfStats.clear();
+    entity->weight = 1;
+    entity->priority = priority;
+    entity->isFinished = false;
+    entity->autoDestroy = TaskAutoDestroy::On;
+    entity->isQueued = false;
+    entity->isDone = false;
+    entity->timeLimit = 0;
+    entity->memoryLimit = 0;
+    entity->timeStarted = 0;
+    entity->limitExceeded = TaskLimit::None;
+    entity->isEndSignaled = false;
+    {
+        std::lock_guard<std::mutex> lockPool(m_poolMutex);
+        entity->pendingDependencyCount = 0;
+        entity->isHeld = false;
+        entity->isEnded = false;
+        entity->vecDependent.clear();
+    }
+
+    slot->generation.store(generation, std::memory_order_release);
+    return taskId;
+}
+
+TaskId TaskManager::newTask(TaskJob fn, const std::vector<TaskId>& vecDependency, TaskPriority priority)
+{
+    const TaskId taskId = this->newTask(std::move(fn), priority);
+    Entity* entity = this->findEntity(taskId);
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    for (TaskId dependencyId : vecDependency) {
+        Entity* dependency = this->findEntity(dependencyId);
+        if (dependency && dependency != entity && !dependency->isEnded) {
+            dependency->vecDependent.push_back(taskId);
+            ++entity->pendingDependencyCount;
+        }
+    }
+
+    return taskId;
+}
+
+TaskId TaskManager::continueWith(TaskId id, TaskJob fn, TaskAutoDestroy autoDestroy)
+{
+    const TaskId taskId = this->newTask(std::move(fn), { id }, this->priority(id));
+    this->run(taskId, autoDestroy);
+    return taskId;
+}
+
+TaskId TaskManager::whenAll(const std::vector<TaskId>& vecId, TaskJob fn, TaskAutoDestroy autoDestroy)
 {
-    const TaskId taskId = m_taskIdSeq.fetch_add(1);
-    std::unique_ptr<Entity> ptrEntity(new Entity);
-    ptrEntity->task.m_id = taskId;
-    ptrEntity->task.m_fn = std::move(fn);
-    ptrEntity->task.m_manager = this;
-    ptrEntity->taskProgress.setTask(&ptrEntity->task);
-    m_mapEntity.insert({ taskId, std::move(ptrEntity) });
+    if (!fn)
+        fn = [](TaskProgress*) {};
+
+    const TaskId taskId = this->newTask(std::move(fn), vecId);
+    this->run(taskId, autoDestroy);
     return taskId;
 }
 
@@ -68,8 +182,21 @@ void TaskManager::run(TaskId id, TaskAutoDestroy autoDestroy)
         return;
 
     entity->isFinished = false;
+    entity->isEndSignaled = false;
     entity->autoDestroy = autoDestroy;
-    entity->control = std::async([=]{ this->execEntity(entity); });
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        entity->isQueued = true;
+        entity->isDone = false;
+        entity->isEnded = false;
+        // Task is queued by releaseDependents() once its last dependency is ended
+        if (entity->pendingDependencyCount > 0)
+            entity->isHeld = true;
+        else
+            this->enqueueEntity(entity);
+    }
+
+    m_poolCondition.notify_all();
 }
 
 void TaskManager::exec(TaskId id, TaskAutoDestroy autoDestroy)
@@ -80,80 +207,258 @@ void TaskManager::exec(TaskId id, TaskAutoDestroy autoDestroy)
         return;
 
     entity->isFinished = false;
+    entity->isEndSignaled = false;
     entity->autoDestroy = autoDestroy;
+    {
+        std::unique_lock<std::mutex> lock(m_poolMutex);
+        entity->isEnded = false;
+        m_poolCondition.wait(lock, [=]{ return entity->pendingDependencyCount == 0; });
+    }
+
     this->execEntity(entity);
 }
 
+int TaskManager::poolSize() const
+{
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    return m_poolSize;
+}
+
+void TaskManager::setPoolSize(int size)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        m_poolSize = std::max(size, 1);
+        // Create missing workers for tasks already queued
+        const int pendingCount = int(m_poolQueue.size());
+        const int newWorkerCount = std::min(
+                    pendingCount - m_poolIdleWorkerCount, m_poolSize - this->poolWorkerCount());
+        for (int i = 0; i < newWorkerCount; ++i)
+            this->addPoolWorker();
+    }
+
+    m_poolCondition.notify_all();
+}
+
+int TaskManager::weight(TaskId id) const
+{
+    const Entity* entity = this->findEntity(id);
+    if (!entity)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    return entity->weight;
+}
+
+void TaskManager::setWeight(TaskId id, int weight)
+{
+    Entity* entity = this->findEntity(id);
+    if (entity) {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        entity->weight = std::max(weight, 1);
+    }
+}
+
+TaskPriority TaskManager::priority(TaskId id) const
+{
+    const Entity* entity = this->findEntity(id);
+    if (!entity)
+        return TaskPriority::Normal;
+
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    return entity->priority;
+}
+
+void TaskManager::setPriority(TaskId id, TaskPriority priority)
+{
+    Entity* entity = this->findEntity(id);
+    if (entity) {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        if (!entity->isQueued || entity->isDone)
+            entity->priority = priority;
+    }
+}
+
 bool TaskManager::waitForDone(TaskId id, int msecs)
 {
     Entity* entity = this->findEntity(id);
     if (!entity)
         return true;
 
-    if (!entity->control.valid())
-        return true;
+    return this->waitEntity(entity, msecs);
+}
 
-    if (msecs < 0) {
-        entity->control.wait();
-        return true;
-    }
+void TaskManager::onEnded(TaskId id, QObject* context, std::function<void()> fn)
+{
+    // Called at most once, from the signal ended() or the "already ended" case below. Both are
+    // executed in the thread of 'context'
+    auto conn = std::make_shared<QMetaObject::Connection>();
+    auto isCalled = std::make_shared<bool>(false);
+    auto fnCall = [=]{
+        if (*isCalled)
+            return;
+
+        *isCalled = true;
+        QObject::disconnect(*conn);
+        fn();
+    };
+    *conn = QObject::connect(this, &TaskManager::ended, context, [=](TaskId endedId) {
+        if (endedId == id)
+            fnCall();
+    });
 
-    return entity->control.wait_for(std::chrono::milliseconds(msecs)) == std::future_status::ready;
+    // Task destroyed means it's ended
+    const Entity* entity = this->findEntity(id);
+    if (!entity || entity->isEndSignaled)
+        QMetaObject::invokeMethod(context, fnCall, Qt::QueuedConnection);
 }
 
 void TaskManager::requestAbort(TaskId id)
+{
+    {
+        // Prevents the slot to be recycled meanwhile
+        std::lock_guard<std::mutex> lock(m_registryMutex);
+        Entity* entity = this->findEntity(id);
+        if (!entity)
+            return;
+
+        entity->taskProgress.requestAbort();
+    }
+
+    {
+        // Wake up the task if it's preempted, see preemptionPoint()
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+    }
+
+    m_poolCondition.notify_all();
+    emit this->abortRequested(id);
+}
+
+void TaskManager::setTimeLimit(TaskId id, int64_t msecs)
 {
     Entity* entity = this->findEntity(id);
     if (entity) {
-        emit this->abortRequested(id);
-        entity->taskProgress.requestAbort();
+        entity->timeLimit = std::max(msecs, int64_t(0));
+        if (msecs > 0)
+            this->startWatchdog();
     }
 }
 
+void TaskManager::setMemoryLimit(TaskId id, int64_t bytes)
+{
+    Entity* entity = this->findEntity(id);
+    if (entity) {
+        entity->memoryLimit = std::max(bytes, int64_t(0));
+        if (bytes > 0)
+            this->startWatchdog();
+    }
+}
+
+TaskLimit TaskManager::limitExceeded(TaskId id) const
+{
+    const Entity* entity = this->findEntity(id);
+    return entity ? entity->limitExceeded.load() : TaskLimit::None;
+}
+
 int TaskManager::progress(TaskId id) const
 {
     const Entity* entity = this->findEntity(id);
-    return entity ? entity->taskProgress.value() : 0;
+    const int value = entity ? entity->taskProgress.value() : 0;
+    // Slot might have been recycled meanwhile
+    return this->findEntity(id) == entity ? value : 0;
 }
 
 int TaskManager::globalProgress() const
 {
     int taskAccumPct = 0;
-    for (const auto& mapPair : m_mapEntity) {
-        const std::unique_ptr<Entity>& ptrEntity = mapPair.second;
-        if (ptrEntity->taskProgress.value() > 0)
-            taskAccumPct += ptrEntity->taskProgress.value();
-    }
+    int taskCount = 0;
+    this->foreachTask([&](TaskId id) {
+        const int taskPct = this->progress(id);
+        if (taskPct > 0)
+            taskAccumPct += taskPct;
+
+        ++taskCount;
+    });
 
-    const int taskCount = m_mapEntity.size();
     const int newGlobalPct = MathUtils::mappedValue(taskAccumPct, 0, taskCount * 100, 0, 100);
     //qDebug() << "taskCount=" << taskCount << " taskAccumPct=" << taskAccumPct << " newGlobalPct=" << newGlobalPct;
     return newGlobalPct;
 }
 
+void TaskManager::setProgressSignalInterval(int msecs)
+{
+    m_progressSignalInterval = std::max(msecs, 0);
+}
+
 QString TaskManager::title(TaskId id) const
 {
+    std::lock_guard<std::mutex> lock(m_registryMutex);
     const Entity* entity = this->findEntity(id);
     return entity ? entity->title : QString();
 }
 
 void TaskManager::setTitle(TaskId id, const QString& title)
 {
+    std::lock_guard<std::mutex> lock(m_registryMutex);
     Entity* entity = this->findEntity(id);
     if (entity)
         entity->title = title;
 }
 
+PerfStats* TaskManager::perfStats(TaskId id)
+{
+    Entity* entity = this->findEntity(id);
+    return entity ? &entity->perfStats : nullptr;
+}
+
+TaskManager::Slot* TaskManager::findSlot(uint32_t index) const
+{
+    if (index >= m_slotCount.load(std::memory_order_acquire))
+        return nullptr;
+
+    Slot* chunk = m_slotChunks[index / SlotChunkSize].load(std::memory_order_acquire);
+    return &chunk[index % SlotChunkSize];
+}
+
+TaskId TaskManager::slotTaskId(uint32_t index) const
+{
+    const Slot* slot = this->findSlot(index);
+    const uint32_t generation = slot ? slot->generation.load(std::memory_order_acquire) : 0;
+    if (generation % 2 == 0)
+        return InvalidTaskId; // Slot is free
+
+    return (TaskId(generation) << 32) | index;
+}
+
 TaskManager::Entity* TaskManager::findEntity(TaskId id)
 {
-    auto it = m_mapEntity.find(id);
-    return it != m_mapEntity.end() ? it->second.get() : nullptr;
+    return const_cast<Entity*>(static_cast<const TaskManager*>(this)->findEntity(id));
 }
 
 const TaskManager::Entity* TaskManager::findEntity(TaskId id) const
 {
-    auto it = m_mapEntity.find(id);
-    return it != m_mapEntity.cend() ? it->second.get() : nullptr;
+    const uint32_t generation = uint32_t(id >> 32);
+    if (generation % 2 == 0)
+        return nullptr;
+
+    const Slot* slot = this->findSlot(uint32_t(id & 0xFFFFFFFF));
+    if (!slot || slot->generation.load(std::memory_order_acquire) != generation)
+        return nullptr;
+
+    return &slot->entity;
+}
+
+void TaskManager::destroyEntity(TaskId id)
+{
+    std::lock_guard<std::mutex> lock(m_registryMutex);
+    Slot* slot = this->findSlot(uint32_t(id & 0xFFFFFFFF));
+    if (!slot || slot->generation.load(std::memory_order_relaxed) != uint32_t(id >> 32))
+        return;
+
+    // Release resources captured by the job, other fields are reset on slot reuse
+    slot->entity.task.m_fn = {};
+    slot->generation.fetch_add(1, std::memory_order_release);
+    m_vecFreeSlotIndex.push_back(uint32_t(id & 0xFFFFFFFF));
 }
 
 void TaskManager::execEntity(Entity* entity)
@@ -162,30 +467,263 @@ void TaskManager::execEntity(Entity* entity)
         return;
 
     emit this->started(entity->task.id());
+    entity->timeStarted = steadyClockMsecs();
     const TaskJob& fn = entity->task.job();
     fn(&entity->taskProgress);
+    entity->timeStarted = 0;
     if (!entity->taskProgress.isAbortRequested())
         entity->taskProgress.setValue(100);
 
+    // Flag is set before emission, so onEnded() can't miss the signal
+    entity->isEndSignaled = true;
     emit this->ended(entity->task.id());
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        this->releaseDependents(entity);
+    }
+
+    m_poolCondition.notify_all();
     entity->isFinished = true;
 }
 
-void TaskManager::cleanGarbage()
+bool TaskManager::waitEntity(Entity* entity, int msecs)
+{
+    std::unique_lock<std::mutex> lock(m_poolMutex);
+    auto fnDone = [=]{ return !entity->isQueued || entity->isDone; };
+    if (msecs < 0) {
+        m_poolCondition.wait(lock, fnDone);
+        return true;
+    }
+
+    return m_poolCondition.wait_for(lock, std::chrono::milliseconds(msecs), fnDone);
+}
+
+// Inserts 'entity' in the pool queue, creating a worker if needed
+// Requires m_poolMutex to be held
+void TaskManager::enqueueEntity(Entity* entity)
+{
+    // Queue is kept sorted by priority, tasks of same priority are in submission order
+    auto itInsert = std::find_if(m_poolQueue.begin(), m_poolQueue.end(), [=](const Entity* queued) {
+        return queued->priority < entity->priority;
+    });
+    m_poolQueue.insert(itInsert, entity);
+    if (entity->priority != TaskPriority::Background)
+        ++m_poolQueuedForegroundCount;
+
+    const int pendingCount = int(m_poolQueue.size());
+    if (pendingCount > m_poolIdleWorkerCount && this->poolWorkerCount() < m_poolSize)
+        this->addPoolWorker();
+}
+
+// Count of pool worker threads not exited
+// Requires m_poolMutex to be held
+int TaskManager::poolWorkerCount() const
+{
+    return int(m_vecPoolWorker.size() - m_vecPoolWorkerExitedId.size());
+}
+
+// Whether there are more workers than needed, ie more than the pool size once preempted workers
+// are excluded. This happens when a worker created by preemptionPoint() is no longer required
+// Requires m_poolMutex to be held
+bool TaskManager::isPoolWorkerSurplus() const
 {
-    auto it = m_mapEntity.begin();
-    while (it != m_mapEntity.end()) {
-        Entity* entity = it->second.get();
-        if (entity->isFinished && entity->autoDestroy == TaskAutoDestroy::On) {
-            if (entity->control.valid())
-                entity->control.wait();
+    return this->poolWorkerCount() > m_poolSize + m_poolPreemptedCount;
+}
 
-            it = m_mapEntity.erase(it);
+// Requires m_poolMutex to be held
+void TaskManager::addPoolWorker()
+{
+    // Threads of exited workers are joined, they don't need m_poolMutex anymore
+    for (std::thread::id exitedId : m_vecPoolWorkerExitedId) {
+        auto itWorker = std::find_if(
+                    m_vecPoolWorker.begin(), m_vecPoolWorker.end(), [=](const std::thread& worker) {
+            return worker.get_id() == exitedId;
+        });
+        if (itWorker != m_vecPoolWorker.end()) {
+            itWorker->join();
+            m_vecPoolWorker.erase(itWorker);
         }
-        else {
-            ++it;
+    }
+
+    m_vecPoolWorkerExitedId.clear();
+    m_vecPoolWorker.emplace_back([=]{ this->runPoolWorker(); });
+}
+
+// Called once the job of 'entity' is executed, dependent tasks whose dependencies are all ended
+// get queued if they were submitted with run()
+// Requires m_poolMutex to be held, m_poolCondition has to be notified afterwards
+void TaskManager::releaseDependents(Entity* entity)
+{
+    entity->isEnded = true;
+    for (TaskId dependentId : entity->vecDependent) {
+        Entity* dependent = this->findEntity(dependentId);
+        if (!dependent || --(dependent->pendingDependencyCount) > 0)
+            continue;
+
+        if (dependent->isHeld) {
+            dependent->isHeld = false;
+            this->enqueueEntity(dependent);
+        }
+    }
+
+    entity->vecDependent.clear();
+}
+
+void TaskManager::runPoolWorker()
+{
+    std::unique_lock<std::mutex> lock(m_poolMutex);
+    while (true) {
+        // Tasks are admitted in queue order(ie priority then submission order), so a heavy task
+        // can't be starved by lighter ones
+        auto fnFrontWeight = [=]{ return std::min(m_poolQueue.front()->weight, m_poolSize); };
+        ++m_poolIdleWorkerCount;
+        m_poolCondition.wait(lock, [=]{
+            return m_poolStopRequested
+                    || this->isPoolWorkerSurplus()
+                    || (!m_poolQueue.empty() && m_poolRunningWeight + fnFrontWeight() <= m_poolSize);
+        });
+        --m_poolIdleWorkerCount;
+        if (m_poolStopRequested)
+            return;
+
+        if (this->isPoolWorkerSurplus()) {
+            // Thread is joined later by addPoolWorker() or ~TaskManager()
+            m_vecPoolWorkerExitedId.push_back(std::this_thread::get_id());
+            return;
         }
+
+        Entity* entity = m_poolQueue.front();
+        entity->poolWeight = fnFrontWeight();
+        m_poolQueue.pop_front();
+        if (entity->priority != TaskPriority::Background)
+            --m_poolQueuedForegroundCount;
+
+        m_poolRunningWeight += entity->poolWeight;
+        if (m_poolPreemptedCount > 0)
+            m_poolCondition.notify_all(); // Preempted tasks might resume now
+
+        lock.unlock();
+        threadPoolTask = &entity->task;
+        this->execEntity(entity);
+        threadPoolTask = nullptr;
+        lock.lock();
+        m_poolRunningWeight -= entity->poolWeight;
+        entity->isDone = true;
+        m_poolCondition.notify_all();
     }
 }
 
+// Whether the first queued task isn't a background one and can't be admitted in the pool
+// Requires m_poolMutex to be held
+bool TaskManager::isPoolForegroundStarved() const
+{
+    if (m_poolQueue.empty())
+        return false;
+
+    const Entity* entity = m_poolQueue.front();
+    return entity->priority != TaskPriority::Background
+            && m_poolRunningWeight + std::min(entity->weight, m_poolSize) > m_poolSize;
+}
+
+// Called at progress checkpoints of 'task', from any thread
+// A background task run by a pool worker gives back its weight in the pool while foreground tasks
+// are starved, and waits until they are admitted
+void TaskManager::preemptionPoint(const Task* task)
+{
+    if (m_poolQueuedForegroundCount.load(std::memory_order_relaxed) == 0)
+        return;
+
+    // Only the worker thread of the task is blocked, not the helper threads it may have spawned
+    if (threadPoolTask != task)
+        return;
+
+    Entity* entity = this->findEntity(task->id());
+    std::unique_lock<std::mutex> lock(m_poolMutex);
+    if (!entity || entity->priority != TaskPriority::Background || !this->isPoolForegroundStarved())
+        return;
+
+    const int weight = entity->poolWeight;
+    m_poolRunningWeight -= weight;
+    // Current worker is blocked, make sure another one can admit the starved task
+    // That extra worker exits once the preempted task resumes, see isPoolWorkerSurplus()
+    if (m_poolIdleWorkerCount == 0)
+        this->addPoolWorker();
+
+    ++m_poolPreemptedCount;
+    m_poolCondition.notify_all();
+    m_poolCondition.wait(lock, [=]{
+        if (m_poolStopRequested || entity->taskProgress.isAbortRequested())
+            return true;
+
+        const bool isForegroundQueued =
+                !m_poolQueue.empty() && m_poolQueue.front()->priority != TaskPriority::Background;
+        return !isForegroundQueued && m_poolRunningWeight + weight <= m_poolSize;
+    });
+    --m_poolPreemptedCount;
+    m_poolRunningWeight += weight;
+    if (this->isPoolWorkerSurplus())
+        m_poolCondition.notify_all(); // Wake up the surplus worker so it exits
+}
+
+void TaskManager::startWatchdog()
+{
+    std::lock_guard<std::mutex> lock(m_watchdogMutex);
+    if (!m_watchdog.joinable() && !m_watchdogStopRequested)
+        m_watchdog = std::thread([=]{ this->runWatchdog(); });
+}
+
+// Periodically checks the resource limits of running tasks, tasks exceeding a limit are requested
+// to abort. This is honored by jobs at progress checkpoints, and by OpenCascade algorithms through
+// OccProgressIndicator::UserBreak()
+void TaskManager::runWatchdog()
+{
+    std::unique_lock<std::mutex> lock(m_watchdogMutex);
+    while (!m_watchdogStopRequested) {
+        m_watchdogCondition.wait_for(lock, std::chrono::milliseconds(100));
+        if (m_watchdogStopRequested)
+            return;
+
+        lock.unlock();
+        const int64_t timeNow = steadyClockMsecs();
+        int64_t memoryUsed = -1; // Read lazily, only if a running task has a memory limit
+        this->foreachTask([&](TaskId id) {
+            Entity* entity = this->findEntity(id);
+            const int64_t timeStarted = entity ? entity->timeStarted.load() : 0;
+            if (timeStarted == 0 || entity->limitExceeded != TaskLimit::None)
+                return;
+
+            TaskLimit limit = TaskLimit::None;
+            const int64_t timeLimit = entity->timeLimit;
+            const int64_t memoryLimit = entity->memoryLimit;
+            if (timeLimit > 0 && timeNow - timeStarted > timeLimit) {
+                limit = TaskLimit::Time;
+            }
+            else if (memoryLimit > 0) {
+                if (memoryUsed < 0)
+                    memoryUsed = ProcessUtils::currentResidentMemorySize();
+
+                if (memoryUsed > memoryLimit)
+                    limit = TaskLimit::Memory;
+            }
+
+            if (limit != TaskLimit::None) {
+                entity->limitExceeded = limit;
+                this->requestAbort(id);
+            }
+        });
+        lock.lock();
+    }
+}
+
+void TaskManager::cleanGarbage()
+{
+    this->foreachTask([=](TaskId id) {
+        Entity* entity = this->findEntity(id);
+        if (entity && entity->isFinished && entity->autoDestroy == TaskAutoDestroy::On) {
+            this->waitEntity(entity);
+            this->destroyEntity(id);
+        }
+    });
+}
+
 } // namespace Mayo
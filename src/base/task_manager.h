@@ -6,14 +6,24 @@
 
 #pragma once
 
+#include "global.h"
+#include "perf_stats.h"
 #include "task.h"
+#include "task_future.h"
 #include "task_progress.h"
 
 #include <QtCore/QObject>
 #include <atomic>
-#include <future>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
 #include <memory>
-#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace Mayo {
 
@@ -24,23 +34,106 @@ public:
     ~TaskManager();
     static TaskManager* globalInstance();
 
-    TaskId newTask(TaskJob fn);
+    TaskId newTask(TaskJob fn, TaskPriority priority = TaskPriority::Normal);
+    // Same as newTask() but the task is started only once all tasks 'vecDependency' are ended,
+    // whatever their outcome(eg aborted). Until then, run() holds the task outside of the thread
+    // pool so it doesn't occupy any worker. Dependencies already ended or destroyed are ignored
+    // Note: dependencies have to be run, otherwise the task would never start
+    TaskId newTask(
+            TaskJob fn, const std::vector<TaskId>& vecDependency, TaskPriority priority = TaskPriority::Normal);
+    // Creates and runs a task started once task 'id' is ended, with the same priority
+    TaskId continueWith(TaskId id, TaskJob fn, TaskAutoDestroy autoDestroy = TaskAutoDestroy::On);
+    // Creates and runs a task started once all tasks 'vecId' are ended, optional 'fn' is its job
+    // Waiting for the returned task(or its signal ended()) is waiting for all tasks 'vecId'
+    TaskId whenAll(
+            const std::vector<TaskId>& vecId, TaskJob fn = {}, TaskAutoDestroy autoDestroy = TaskAutoDestroy::On);
+    // Same as newTask(fn, vecDependency, priority) but job 'fn' returns a value(eg T fn(TaskProgress*))
+    // which is provided by the returned future once the task is ended. An exception thrown by
+    // 'fn' is reported as an error by the future, which is aborted if the task was requested so
+    // Note: the task still has to be submitted with run() or exec()
+    template<typename FUNCTION>
+    auto newTaskFuture(
+            FUNCTION fn,
+            const std::vector<TaskId>& vecDependency = {},
+            TaskPriority priority = TaskPriority::Normal)
+        -> TaskFuture<std::invoke_result_t<FUNCTION, TaskProgress*>>;
+
+    // Creates and runs a task started once 'future' is ready, whose job 'fn' is given the value of
+    // 'future'(eg U fn(const T&, TaskProgress*)). Error or abort of 'future' is propagated to the
+    // returned future without calling 'fn'
+    template<typename T, typename FUNCTION>
+    auto continueWith(
+            const TaskFuture<T>& future, FUNCTION fn, TaskAutoDestroy autoDestroy = TaskAutoDestroy::On)
+        -> TaskFuture<std::invoke_result_t<FUNCTION, const T&, TaskProgress*>>;
+
+    // Calls 'fn' in the thread of 'context' once task 'id' is ended(ie after signal ended()), or
+    // right away(but queued) if the task is already ended. Typically used to resume in the GUI
+    // thread, nothing is called if 'context' is destroyed meanwhile
+    void onEnded(TaskId id, QObject* context, std::function<void()> fn);
+    // Same as onEnded() with the task of 'future', 'fn' is given the ready future
+    // (eg void fn(const TaskFuture<T>&))
+    template<typename T, typename FUNCTION>
+    void onReady(const TaskFuture<T>& future, QObject* context, FUNCTION fn) {
+        this->onEnded(future.taskId(), context, [=]{ fn(future); });
+    }
+
+    // Queues the task, it's started as soon as its dependencies are ended and the thread pool
+    // admits it(see poolSize())
     void run(TaskId id, TaskAutoDestroy autoDestroy = TaskAutoDestroy::On);
-    void exec(TaskId id, TaskAutoDestroy autoDestroy = TaskAutoDestroy::On); // Synchronous
+    // Synchronous, blocks until dependencies are ended
+    void exec(TaskId id, TaskAutoDestroy autoDestroy = TaskAutoDestroy::On);
+
+    // Maximum sum of the weights of tasks running concurrently, others are queued until running
+    // tasks are finished. Default is the count of hardware threads
+    int poolSize() const;
+    void setPoolSize(int size);
+
+    // Weight of the task regarding poolSize(), default is 1
+    // A task whose weight is greater than poolSize() is run alone
+    int weight(TaskId id) const;
+    void setWeight(TaskId id, int weight);
+
+    // Has no effect on a task already queued with run()
+    TaskPriority priority(TaskId id) const;
+    void setPriority(TaskId id, TaskPriority priority);
 
     int progress(TaskId id) const;
     int globalProgress() const;
 
+    // Minimum interval between two signals progressChanged() for the same task, in milliseconds
+    // First and 100% values are always signaled. Default is 50ms, 0 disables throttling
+    int progressSignalInterval() const { return m_progressSignalInterval; }
+    void setProgressSignalInterval(int msecs);
+
     QString title(TaskId id) const;
     void setTitle(TaskId id, const QString& title);
 
+    // Per-task timings and counters, cleared when the task is created. Null if task doesn't exist
+    PerfStats* perfStats(TaskId id);
+
     bool waitForDone(TaskId id, int msecs = -1);
     void requestAbort(TaskId id);
 
+    // Resource limits of a task, checked by a watchdog thread while the task is running
+    // The task is requested to abort(see requestAbort()) as soon as a limit is exceeded, which is
+    // then reported by limitExceeded()
+    // Time limit is the maximum duration of the task in milliseconds, counted from its start. No
+    // limit if <= 0
+    void setTimeLimit(TaskId id, int64_t msecs);
+    // Memory limit is compared to the resident memory of the whole process(there's no per-task
+    // accounting), in bytes. No limit if <= 0
+    void setMemoryLimit(TaskId id, int64_t bytes);
+    TaskLimit limitExceeded(TaskId id) const;
+
+    // Tasks are iterated in creation order, safe to be called from any thread
     template<typename FUNCTION>
-    void foreachTask(FUNCTION fn) {
-        for (const auto& mapPair : m_mapEntity)
-            fn(mapPair.first);
+    void foreachTask(FUNCTION fn) const {
+        const uint32_t slotCount = m_slotCount.load(std::memory_order_acquire);
+        for (uint32_t index = 0; index < slotCount; ++index) {
+            const TaskId id = this->slotTaskId(index);
+            if (id != InvalidTaskId)
+                fn(id);
+        }
     }
 
 signals:
@@ -55,18 +148,170 @@ private:
         Task task;
         TaskProgress taskProgress;
         QString title;
-        std::future<void> control;
+        PerfStats perfStats;
+        int weight = 1;
+        TaskPriority priority = TaskPriority::Normal;
         std::atomic<bool> isFinished = false;
         TaskAutoDestroy autoDestroy = TaskAutoDestroy::On;
+        // Guarded by TaskManager::m_poolMutex
+        bool isQueued = false; // Task was submitted to the pool with run()
+        bool isDone = false; // Pool worker won't access the task anymore
+        int poolWeight = 0; // Weight admitted in the pool while running
+        int pendingDependencyCount = 0; // Count of dependencies not ended yet
+        bool isHeld = false; // Task was submitted with run() but waits for its dependencies
+        bool isEnded = false; // Job was executed, dependents were released
+        std::atomic<bool> isEndSignaled = false; // Signal ended() was emitted(or is being)
+        std::vector<TaskId> vecDependent; // Tasks depending on this one
+        // Read by the watchdog thread
+        std::atomic<int64_t> timeLimit = 0; // msecs
+        std::atomic<int64_t> memoryLimit = 0; // bytes
+        std::atomic<int64_t> timeStarted = 0; // msecs since steady clock epoch, 0 if not running
+        std::atomic<TaskLimit> limitExceeded = TaskLimit::None;
     };
 
+    // Registry of tasks, made of slots allocated by chunks. Chunks are never moved nor freed until
+    // TaskManager destruction, so lookup of tasks is lock-free and safe from any thread
+    // Slots are recycled, TaskId is made of the slot index(low 32 bits) and the slot generation
+    // (high 32 bits) so a stale TaskId doesn't match the task reusing the slot
+    struct Slot {
+        std::atomic<uint32_t> generation = 0; // Odd when the slot is used by a task
+        Entity entity;
+    };
+
+    static constexpr TaskId InvalidTaskId = std::numeric_limits<TaskId>::max();
+    static constexpr uint32_t SlotChunkSize = 256;
+    static constexpr uint32_t SlotChunkMaxCount = 4096;
+
+    Slot* findSlot(uint32_t index) const;
+    TaskId slotTaskId(uint32_t index) const;
     Entity* findEntity(TaskId id);
     const Entity* findEntity(TaskId id) const;
+    void destroyEntity(TaskId id);
     void execEntity(Entity* entity);
+    bool waitEntity(Entity* entity, int msecs = -1);
+    void enqueueEntity(Entity* entity);
+    void releaseDependents(Entity* entity);
     void cleanGarbage();
+    void runPoolWorker();
+    int poolWorkerCount() const;
+    bool isPoolWorkerSurplus() const;
+    void addPoolWorker();
+    bool isPoolForegroundStarved() const;
+    void preemptionPoint(const Task* task);
+    void startWatchdog();
+    void runWatchdog();
+
+    // Shared by the copies of the job of 'future', marks it as aborted on destruction of the last
+    // copy if the job wasn't run
+    template<typename T>
+    static std::shared_ptr<void> makeFuturePendingGuard(const TaskFuture<T>& future);
+    template<typename T, typename FUNCTION>
+    static void setFutureResult(TaskFuture<T>* future, TaskProgress* progress, FUNCTION fnValue);
 
-    std::atomic<TaskId> m_taskIdSeq = {};
-    std::unordered_map<TaskId, std::unique_ptr<Entity>> m_mapEntity;
+    friend class TaskProgress;
+
+    std::atomic<int> m_progressSignalInterval = 50;
+
+    // Guards slot allocation/recycling and task titles
+    mutable std::mutex m_registryMutex;
+    std::unique_ptr<std::atomic<Slot*>[]> m_slotChunks;
+    std::atomic<uint32_t> m_slotCount = 0;
+    std::vector<uint32_t> m_vecFreeSlotIndex;
+
+    // Thread pool, workers are created on demand up to the pool size(plus the count of workers
+    // blocked by preemptionPoint())
+    mutable std::mutex m_poolMutex;
+    std::condition_variable m_poolCondition;
+    std::deque<Entity*> m_poolQueue;
+    std::vector<std::thread> m_vecPoolWorker;
+    std::vector<std::thread::id> m_vecPoolWorkerExitedId; // Workers exited but not joined yet
+    int m_poolSize = 1;
+    int m_poolRunningWeight = 0;
+    int m_poolIdleWorkerCount = 0;
+    // Count of queued tasks with priority higher than background, read without lock at progress
+    // checkpoints
+    std::atomic<int> m_poolQueuedForegroundCount = 0;
+    int m_poolPreemptedCount = 0;
+    bool m_poolStopRequested = false;
+
+    // Watchdog of task resource limits, created on first call to setTimeLimit()/setMemoryLimit()
+    std::mutex m_watchdogMutex;
+    std::condition_variable m_watchdogCondition;
+    std::thread m_watchdog;
+    bool m_watchdogStopRequested = false;
 };
 
+
+
+// --
+// -- Implementation
+// --
+
+template<typename FUNCTION>
+auto TaskManager::newTaskFuture(FUNCTION fn, const std::vector<TaskId>& vecDependency, TaskPriority priority)
+    -> TaskFuture<std::invoke_result_t<FUNCTION, TaskProgress*>>
+{
+    using T = std::invoke_result_t<FUNCTION, TaskProgress*>;
+    TaskFuture<T> future;
+    future.d = std::make_shared<typename TaskFuture<T>::State>();
+    const std::shared_ptr<void> pendingGuard = TaskManager::makeFuturePendingGuard(future);
+    future.d->taskId = this->newTask([=](TaskProgress* progress) mutable {
+        MAYO_UNUSED(pendingGuard);
+        TaskFuture<T> result = future;
+        TaskManager::setFutureResult(&result, progress, [&]{ return fn(progress); });
+    }, vecDependency, priority);
+    return future;
+}
+
+template<typename T, typename FUNCTION>
+auto TaskManager::continueWith(const TaskFuture<T>& future, FUNCTION fn, TaskAutoDestroy autoDestroy)
+    -> TaskFuture<std::invoke_result_t<FUNCTION, const T&, TaskProgress*>>
+{
+    using U = std::invoke_result_t<FUNCTION, const T&, TaskProgress*>;
+    using Status = typename TaskFuture<U>::Status;
+    TaskFuture<U> next;
+    next.d = std::make_shared<typename TaskFuture<U>::State>();
+    const std::shared_ptr<void> pendingGuard = TaskManager::makeFuturePendingGuard(next);
+    next.d->taskId = this->newTask([=](TaskProgress* progress) mutable {
+        MAYO_UNUSED(pendingGuard);
+        TaskFuture<U> result = next;
+        if (future.hasError())
+            result.setResult(Status::Error, {}, future.errorMessage());
+        else if (!future.hasValue())
+            result.setResult(Status::Aborted, {}, {});
+        else
+            TaskManager::setFutureResult(&result, progress, [&]{ return fn(future.value(), progress); });
+    }, { future.taskId() }, this->priority(future.taskId()));
+    this->run(next.taskId(), autoDestroy);
+    return next;
+}
+
+template<typename T>
+std::shared_ptr<void> TaskManager::makeFuturePendingGuard(const TaskFuture<T>& future)
+{
+    return std::shared_ptr<void>(nullptr, [=](void*) { TaskFuture<T>(future).abortIfPending(); });
+}
+
+template<typename T, typename FUNCTION>
+void TaskManager::setFutureResult(TaskFuture<T>* future, TaskProgress* progress, FUNCTION fnValue)
+{
+    using Status = typename TaskFuture<T>::Status;
+    if (TaskProgress::isAbortRequested(progress))
+        return future->setResult(Status::Aborted, {}, {});
+
+    try {
+        std::optional<T> value = fnValue();
+        if (TaskProgress::isAbortRequested(progress))
+            future->setResult(Status::Aborted, {}, {});
+        else
+            future->setResult(Status::Value, std::move(value), {});
+    }
+    catch (const std::exception& err) {
+        future->setResult(Status::Error, {}, QString::fromUtf8(err.what()));
+    }
+    catch (...) {
+        future->setResult(Status::Error, {}, TaskManager::tr("Unknown error"));
+    }
+}
+
 } // namespace Mayo
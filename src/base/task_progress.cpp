@@ -5,10 +5,12 @@
 ****************************************************************************/
 
 #include "task_progress.h"
+#include "global.h"
 #include "task.h"
 #include "task_manager.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <limits>
 
@@ -45,24 +47,74 @@ TaskManager* TaskProgress::taskManager() const
 
 void TaskProgress::setValue(int pct)
 {
-    if (m_isAbortRequested)
+    if (this->isAbortRequested())
         return;
 
-    const int valueOnEntry = m_value;
-    m_value = std::clamp(pct, 0, 100);
-    if (m_value != 0 && m_value == valueOnEntry)
+    if (m_task)
+        m_task->manager()->preemptionPoint(m_task);
+
+    const int64_t scaledValueNew = std::clamp(pct, 0, 100) * ValueScale;
+    const int64_t scaledValueOld = m_scaledValue.exchange(scaledValueNew);
+    if (scaledValueNew != 0 && scaledValueNew == scaledValueOld)
+        return;
+
+    this->onScaledValueChanged(scaledValueOld, scaledValueNew);
+}
+
+void TaskProgress::addScaledValue(int64_t delta)
+{
+    if (this->isAbortRequested())
         return;
 
+    const int64_t scaledValueOld = m_scaledValue.fetch_add(delta);
+    this->onScaledValueChanged(scaledValueOld, scaledValueOld + delta);
+}
+
+void TaskProgress::onScaledValueChanged(int64_t scaledValueOld, int64_t scaledValueNew)
+{
+    const int pct = int(std::clamp<int64_t>(scaledValueNew / ValueScale, 0, 100));
+    m_value = pct;
     if (m_parent) {
-        const int valueDeltaInParent = std::round((m_value - valueOnEntry) * (m_portionSize / 100.));
-        m_parent->setValue(m_parent->value() + valueDeltaInParent);
+        const double portionRatio = m_portionSize / 100.;
+        const auto deltaInParent = std::llround((scaledValueNew - scaledValueOld) * portionRatio);
+        if (deltaInParent != 0)
+            m_parent->addScaledValue(deltaInParent);
     }
     else {
-        if (m_task)
-            emit m_task->manager()->progressChanged(m_task->id(), m_value);
+        this->emitValueChanged(pct);
     }
 }
 
+void TaskProgress::emitValueChanged(int pct)
+{
+    if (!m_task)
+        return;
+
+    TaskManager* taskMgr = m_task->manager();
+    const int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    const int lastValue = m_lastSignalValue;
+    // First and final values are always signaled
+    const bool isForced = lastValue < 0 || (pct == 100 && lastValue != 100);
+    if (!isForced) {
+        if (pct == lastValue)
+            return;
+
+        int64_t lastTime = m_lastSignalTime;
+        if (now - lastTime < taskMgr->progressSignalInterval())
+            return;
+
+        if (!m_lastSignalTime.compare_exchange_strong(lastTime, now))
+            return; // Another thread is signaling
+    }
+    else {
+        m_lastSignalTime = now;
+    }
+
+    m_lastSignalValue = pct;
+    emit taskMgr->progressChanged(m_task->id(), pct);
+}
+
 void TaskProgress::setStep(const QString& title)
 {
     m_step = title;
@@ -85,4 +137,34 @@ void TaskProgress::requestAbort()
     m_isAbortRequested = true;
 }
 
+void TaskProgress::reset()
+{
+    m_scaledValue = 0;
+    m_value = 0;
+    m_step.clear();
+    m_isAbortRequested = false;
+    m_lastSignalTime = 0;
+    m_lastSignalValue = -1;
+}
+
+TaskChunkProgress::TaskChunkProgress(TaskProgress* progress, int chunkCount, int pctBegin, int pctEnd)
+    : m_progress(progress),
+      m_chunkCount(std::max(chunkCount, 1)),
+      m_pctBegin(pctBegin),
+      m_pctEnd(pctEnd)
+{
+}
+
+void TaskChunkProgress::chunkDone()
+{
+    const int doneCount = ++m_chunkDoneCount;
+    if (m_progress) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        MAYO_UNUSED(lock);
+        const int pct = m_pctBegin + ((m_pctEnd - m_pctBegin) * doneCount) / m_chunkCount;
+        if (pct > m_progress->value())
+            m_progress->setValue(pct);
+    }
+}
+
 } // namespace Mayo
@@ -9,6 +9,8 @@
 #include "task_common.h"
 #include <QtCore/QString>
 #include <atomic>
+#include <cstdint>
+#include <mutex>
 
 namespace Mayo {
 
@@ -25,6 +27,10 @@ public:
     TaskManager* taskManager() const;
 
     // Value in [0,100]
+    // Changes are accumulated atomically into parent progress, so sibling progress objects can be
+    // updated from distinct threads. Signal TaskManager::progressChanged() is throttled, see
+    // TaskManager::progressSignalInterval()
+    // setValue() is also a preemption checkpoint for background tasks, see TaskPriority
     int value() const { return m_value; }
     void setValue(int pct);
 
@@ -35,7 +41,11 @@ public:
     const TaskProgress* parent() const { return m_parent; }
     TaskProgress* parent() { return m_parent; }
 
-    bool isAbortRequested() const { return m_isAbortRequested; }
+    // Abort request of the task is visible from all child progress objects, whatever the thread
+    // Long operations should poll it at each chunk of work and then return early
+    bool isAbortRequested() const {
+        return m_isAbortRequested || (m_parent && m_parent->isAbortRequested());
+    }
     static bool isAbortRequested(const TaskProgress* progress);
 
     // Disable copy
@@ -45,17 +55,45 @@ public:
     TaskProgress& operator=(TaskProgress&&) = delete;
 
 private:
+    // Fixed-point scale of m_scaledValue, so small contributions of children aren't lost
+    static constexpr int64_t ValueScale = 10000;
+
     void setTask(const Task* task);
     void requestAbort();
+    void reset();
+    void addScaledValue(int64_t delta);
+    void onScaledValueChanged(int64_t scaledValueOld, int64_t scaledValueNew);
+    void emitValueChanged(int pct);
 
     friend class TaskManager;
 
     TaskProgress* m_parent = nullptr;
     const Task* m_task = nullptr;
     double m_portionSize = -1;
+    std::atomic<int64_t> m_scaledValue = 0;
     std::atomic<int> m_value = 0;
     QString m_step;
-    bool m_isAbortRequested = false;
+    std::atomic<bool> m_isAbortRequested = false;
+    // Coalescing of TaskManager::progressChanged() signals, only used by root progress
+    std::atomic<int64_t> m_lastSignalTime = 0;
+    std::atomic<int> m_lastSignalValue = -1;
+};
+
+// Reports to 'progress' the chunks of work done concurrently, mapped to [pctBegin, pctEnd]
+// chunkDone() can be called from any thread, progress value never decreases
+class TaskChunkProgress {
+public:
+    TaskChunkProgress(TaskProgress* progress, int chunkCount, int pctBegin, int pctEnd);
+
+    void chunkDone();
+
+private:
+    TaskProgress* m_progress = nullptr;
+    int m_chunkCount = 1;
+    int m_pctBegin = 0;
+    int m_pctEnd = 100;
+    std::atomic<int> m_chunkDoneCount = 0;
+    std::mutex m_mutex;
 };
 
 } // namespace Mayo
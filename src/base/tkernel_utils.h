@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include "hash_utils.h"
+
 #include <Quantity_Color.hxx>
 #include <Standard_Handle.hxx>
 #include <Standard_Version.hxx>
@@ -53,7 +55,7 @@ namespace std {
 // Specialization of C++11 std::hash<> functor for opencascade::handle<> objects
 template<typename T> struct hash<opencascade::handle<T>> {
     inline std::size_t operator()(const opencascade::handle<T>& hnd) const {
-        return hash<T*>{}(hnd.get());
+        return Mayo::HashUtils::mixPointer(hnd.get());
     }
 };
 
@@ -0,0 +1,167 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "trace_recorder.h"
+#include "global.h"
+#include "string_utils.h"
+#include "task_manager.h"
+
+#include <fstream>
+#include <locale>
+#include <sstream>
+
+namespace Mayo {
+
+std::atomic<bool> TraceRecorder::s_recording = false;
+
+TraceRecorder* TraceRecorder::global()
+{
+    static TraceRecorder recorder;
+    return &recorder;
+}
+
+void TraceRecorder::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+        m_startTime = Clock::now();
+        m_vecEvent.clear();
+        m_mapThreadIndex.clear();
+    }
+
+    s_recording.store(true, std::memory_order_relaxed);
+}
+
+void TraceRecorder::stop()
+{
+    s_recording.store(false, std::memory_order_relaxed);
+}
+
+void TraceRecorder::attach(TaskManager* taskMgr)
+{
+    auto fnTaskName = [=](TaskId id) {
+        const QString title = taskMgr->title(id);
+        return !title.isEmpty() ? title.toStdString() : "Task #" + std::to_string(id & 0xFFFFFFFF);
+    };
+
+    // Connections without context object: slots are called in the thread emitting the signal
+    QObject::connect(taskMgr, &TaskManager::started, [=](TaskId id) {
+        if (TraceRecorder::isRecording())
+            this->addEvent('B', fnTaskName(id), "task");
+    });
+    QObject::connect(taskMgr, &TaskManager::ended, [=](TaskId id) {
+        if (TraceRecorder::isRecording())
+            this->addEvent('E', fnTaskName(id), "task");
+    });
+    QObject::connect(taskMgr, &TaskManager::progressStep, [=](TaskId, const QString& stepTitle) {
+        if (TraceRecorder::isRecording() && !stepTitle.isEmpty())
+            this->addEvent('i', stepTitle.toStdString(), "step");
+    });
+    QObject::connect(taskMgr, &TaskManager::progressChanged, [=](TaskId id, int pct) {
+        if (TraceRecorder::isRecording())
+            this->addEvent('C', fnTaskName(id), "progress", pct);
+    });
+}
+
+void TraceRecorder::addScope(std::string_view name, Clock::time_point startTime, Clock::time_point endTime)
+{
+    if (!TraceRecorder::isRecording())
+        return;
+
+    Event event = {};
+    event.phase = 'X';
+    event.name = name;
+    event.category = "scope";
+    event.timestamp = this->toTimestamp(startTime);
+    event.duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+    this->addEvent(std::move(event));
+}
+
+int TraceRecorder::eventCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    return int(m_vecEvent.size());
+}
+
+std::string TraceRecorder::toJson() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    std::ostringstream ostr;
+    ostr.imbue(std::locale::classic());
+    ostr << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    ostr << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Mayo\"}}";
+    for (const auto& [threadId, index] : m_mapThreadIndex) {
+        MAYO_UNUSED(threadId);
+        ostr << ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << index
+             << ",\"args\":{\"name\":\"Thread " << index << "\"}}";
+    }
+
+    for (const Event& event : m_vecEvent) {
+        ostr << ",\n{\"ph\":\"" << event.phase << '"'
+             << ",\"name\":" << StringUtils::jsonQuoted(event.name)
+             << ",\"cat\":\"" << event.category << '"'
+             << ",\"pid\":1,\"tid\":" << event.threadIndex
+             << ",\"ts\":" << event.timestamp;
+        if (event.phase == 'X')
+            ostr << ",\"dur\":" << event.duration;
+        else if (event.phase == 'i')
+            ostr << ",\"s\":\"t\"";
+        else if (event.phase == 'C')
+            ostr << ",\"args\":{\"value\":" << event.value << '}';
+
+        ostr << '}';
+    }
+
+    ostr << "\n]}\n";
+    return ostr.str();
+}
+
+bool TraceRecorder::writeFile(const FilePath& filepath) const
+{
+    std::ofstream fstr(filepath, std::ios::out | std::ios::binary);
+    if (!fstr.is_open())
+        return false;
+
+    fstr << this->toJson();
+    return fstr.good();
+}
+
+void TraceRecorder::addEvent(char phase, std::string name, const char* category, int value)
+{
+    Event event = {};
+    event.phase = phase;
+    event.name = std::move(name);
+    event.category = category;
+    event.timestamp = this->toTimestamp(Clock::now());
+    event.value = value;
+    this->addEvent(std::move(event));
+}
+
+void TraceRecorder::addEvent(Event&& event)
+{
+    const std::thread::id threadId = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+    event.threadIndex = this->threadIndex(threadId);
+    m_vecEvent.push_back(std::move(event));
+}
+
+int64_t TraceRecorder::toTimestamp(Clock::time_point time) const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(time - m_startTime).count();
+}
+
+int TraceRecorder::threadIndex(std::thread::id threadId)
+{
+    auto it = m_mapThreadIndex.find(threadId);
+    if (it != m_mapThreadIndex.end())
+        return it->second;
+
+    const int index = int(m_mapThreadIndex.size()) + 1;
+    m_mapThreadIndex.insert({ threadId, index });
+    return index;
+}
+
+} // namespace Mayo
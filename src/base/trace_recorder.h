@@ -0,0 +1,74 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "filepath.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Mayo {
+
+class TaskManager;
+
+// Records a timeline of task events and instrumentation scopes(see PerfScopedTimer), along with
+// thread ids and timestamps in microseconds. Timeline is written in the Chrome trace event format,
+// which can be opened with chrome://tracing or https://ui.perfetto.dev
+// Task managers created while recording are automatically attached
+class TraceRecorder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static TraceRecorder* global();
+
+    static bool isRecording() { return s_recording.load(std::memory_order_relaxed); }
+    // Clears previous events, timestamps are relative to this call
+    void start();
+    void stop();
+
+    // Captures signals started(), progressStep(), progressChanged() and ended() of 'taskMgr'
+    // Signals are handled in the emitting thread, so task events get the id of the worker thread
+    void attach(TaskManager* taskMgr);
+
+    // Adds an event with a duration("complete" event), recorded in the calling thread
+    void addScope(std::string_view name, Clock::time_point startTime, Clock::time_point endTime);
+
+    int eventCount() const;
+    std::string toJson() const;
+    bool writeFile(const FilePath& filepath) const;
+
+private:
+    struct Event {
+        char phase; // 'B': begin, 'E': end, 'X': complete, 'i': instant, 'C': counter
+        std::string name;
+        const char* category;
+        int threadIndex;
+        int64_t timestamp; // Microseconds
+        int64_t duration; // Microseconds, 'X' events only
+        int value; // 'C' events only
+    };
+
+    void addEvent(char phase, std::string name, const char* category, int value = 0);
+    void addEvent(Event&& event);
+    int64_t toTimestamp(Clock::time_point time) const;
+    int threadIndex(std::thread::id threadId); // Requires m_mutex locked
+
+    static std::atomic<bool> s_recording;
+    mutable std::mutex m_mutex;
+    Clock::time_point m_startTime;
+    std::vector<Event> m_vecEvent;
+    std::unordered_map<std::thread::id, int> m_mapThreadIndex;
+};
+
+} // namespace Mayo
@@ -0,0 +1,86 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "tree_name_index.h"
+#include "document.h"
+#include "math_utils.h"
+#include "task_progress.h"
+
+namespace Mayo {
+
+void TreeNameIndex::add(TreeNodeId nodeId, const QString& name)
+{
+    const auto entryIndex = uint32_t(m_vecEntry.size());
+    m_vecEntry.push_back({ nodeId, name.toCaseFolded() });
+    const QString& entryName = m_vecEntry.back().name;
+    for (int i = 0; i + 3 <= entryName.size(); ++i) {
+        std::vector<uint32_t>& vecEntry = m_mapTrigramVecEntry[TreeNameIndex::trigramKey(entryName.constData() + i)];
+        // Trigram might occur many times in the same name
+        if (vecEntry.empty() || vecEntry.back() != entryIndex)
+            vecEntry.push_back(entryIndex);
+    }
+}
+
+TreeNameIndex TreeNameIndex::fromModelTree(const DocumentPtr& doc, TaskProgress* progress)
+{
+    TreeNameIndex index;
+    const Tree<TDF_Label>& modelTree = doc->modelTree();
+    const size_t nodeCount = modelTree.nodeCount();
+    index.m_vecEntry.reserve(nodeCount);
+    traverseTree_unorder(modelTree, [&](TreeNodeId id) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        index.add(id, doc->labelName(modelTree.nodeData(id)));
+        if (progress && id % 1024 == 0)
+            progress->setValue(int(MathUtils::mappedValue(id, 0, double(nodeCount), 0, 100)));
+    });
+
+    return index;
+}
+
+std::vector<TreeNodeId> TreeNameIndex::find(const QString& text) const
+{
+    const QString query = text.toCaseFolded();
+    if (query.isEmpty())
+        return {};
+
+    // Candidates are the names containing the least frequent trigram of the query
+    const std::vector<uint32_t>* ptrVecCandidate = nullptr;
+    for (int i = 0; i + 3 <= query.size(); ++i) {
+        auto itFound = m_mapTrigramVecEntry.find(TreeNameIndex::trigramKey(query.constData() + i));
+        if (itFound == m_mapTrigramVecEntry.cend())
+            return {}; // Trigram isn't contained in any name
+
+        if (!ptrVecCandidate || itFound->second.size() < ptrVecCandidate->size())
+            ptrVecCandidate = &itFound->second;
+    }
+
+    std::vector<TreeNodeId> vecNodeId;
+    auto fnCheckEntry = [&](const Entry& entry) {
+        if (entry.name.contains(query))
+            vecNodeId.push_back(entry.nodeId);
+    };
+    if (ptrVecCandidate) {
+        for (uint32_t entryIndex : *ptrVecCandidate)
+            fnCheckEntry(m_vecEntry.at(entryIndex));
+    }
+    else {
+        for (const Entry& entry : m_vecEntry)
+            fnCheckEntry(entry);
+    }
+
+    return vecNodeId;
+}
+
+uint64_t TreeNameIndex::trigramKey(const QChar* chars)
+{
+    return (uint64_t(chars[0].unicode()) << 32)
+            | (uint64_t(chars[1].unicode()) << 16)
+            | uint64_t(chars[2].unicode());
+}
+
+} // namespace Mayo
@@ -0,0 +1,51 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "document_ptr.h"
+#include "libtree.h"
+
+#include <QtCore/QString>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Index of tree node names, for case-insensitive substring search
+// Names are indexed by trigrams: a query of three characters or more only checks the names
+// sharing its least frequent trigram, shorter queries check all names
+class TreeNameIndex {
+public:
+    void add(TreeNodeId nodeId, const QString& name);
+
+    // Indexes names of all nodes of the model tree of 'doc', returns early if abort of 'progress'
+    // is requested
+    static TreeNameIndex fromModelTree(const DocumentPtr& doc, TaskProgress* progress = nullptr);
+
+    // Nodes whose name contains 'text', in the order they were added
+    std::vector<TreeNodeId> find(const QString& text) const;
+
+    size_t size() const { return m_vecEntry.size(); }
+    bool empty() const { return m_vecEntry.empty(); }
+
+private:
+    struct Entry {
+        TreeNodeId nodeId;
+        QString name; // Case folded
+    };
+
+    static uint64_t trigramKey(const QChar* chars);
+
+    std::vector<Entry> m_vecEntry;
+    // Indexes in m_vecEntry of the names containing a trigram, in increasing order
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_mapTrigramVecEntry;
+};
+
+} // namespace Mayo
@@ -6,16 +6,37 @@
 
 #include "xcaf.h"
 
+#include "cpp_utils.h"
+
 #include <TDocStd_Document.hxx>
 #include <TDF_AttributeIterator.hxx>
+#include <TDF_ChildIterator.hxx>
+#include <TDF_TagSource.hxx>
 #include <XCAFDoc_Area.hxx>
 #include <XCAFDoc_Centroid.hxx>
 #include <XCAFDoc_DocumentTool.hxx>
 #include <XCAFDoc_Volume.hxx>
-#include <set>
+#include <algorithm>
+#include <cmath>
 
 namespace Mayo {
 
+namespace {
+
+// Packs RGB components of 'color' into a single integer, used as hash key to find styles
+uint64_t packedColor(const Quantity_Color& color)
+{
+    constexpr uint64_t maxComponent = (uint64_t(1) << 21) - 1;
+    auto fnPackComponent = [=](double value) {
+        return uint64_t(std::round(std::clamp(value, 0., 1.) * maxComponent));
+    };
+    return fnPackComponent(color.Red())
+            | (fnPackComponent(color.Green()) << 21)
+            | (fnPackComponent(color.Blue()) << 42);
+}
+
+} // namespace
+
 bool XCaf::isNull() const
 {
     Handle_TDocStd_Document doc = TDocStd_Document::Get(m_labelMain);
@@ -195,6 +216,9 @@ TDF_Label XCaf::shapeReferred(const TDF_Label& lbl)
 TopLoc_Location XCaf::shapeAbsoluteLocation(TreeNodeId nodeId) const
 {
     Expects(m_modelTree != nullptr);
+    if (nodeId < m_vecAbsoluteLocation.size())
+        return m_vecAbsoluteLocation.at(nodeId);
+
     return XCaf::shapeAbsoluteLocation(*m_modelTree, nodeId);
 }
 
@@ -212,6 +236,16 @@ TopLoc_Location XCaf::shapeAbsoluteLocation(const Tree<TDF_Label>& modelTree, Tr
     return absoluteLoc;
 }
 
+uint32_t XCaf::shapeStyleIndex(TreeNodeId nodeId) const
+{
+    return nodeId < m_vecNodeStyleIndex.size() ? m_vecNodeStyleIndex.at(nodeId) : 0;
+}
+
+const XCaf::ShapeStyle& XCaf::shapeStyle(TreeNodeId nodeId) const
+{
+    return m_vecShapeStyle.at(this->shapeStyleIndex(nodeId));
+}
+
 XCaf::ValidationProperties XCaf::validationProperties(const TDF_Label& lbl)
 {
     ValidationProperties props = {};
@@ -241,44 +275,196 @@ XCaf::ValidationProperties XCaf::validationProperties(const TDF_Label& lbl)
     return props;
 }
 
-TDF_LabelSequence XCaf::diffTopLevelFreeShapes(const TDF_LabelSequence& seqOther) const
+int XCaf::shapesTagWatermark() const
 {
-    const TDF_LabelSequence& seqBefore = seqOther;
-    const TDF_LabelSequence seqAfter = this->topLevelFreeShapes();
-    std::set<int> setBeforeTag;
-    const TDF_Label firstBeforeLabel = !seqBefore.IsEmpty() ? seqBefore.First() : TDF_Label();
-    for (const TDF_Label& label : seqBefore) {
-        Expects(firstBeforeLabel.IsNull() || label.Depth() == firstBeforeLabel.Depth());
-        setBeforeTag.insert(label.Tag());
+    Handle_XCAFDoc_ShapeTool tool = this->shapeTool();
+    if (!tool)
+        return 0;
+
+    // Children of the shapes label are created with TDF_TagSource::NewChild()
+    Handle_TDF_TagSource tagSrc;
+    if (tool->Label().FindAttribute(TDF_TagSource::GetID(), tagSrc))
+        return tagSrc->Get();
+
+    int lastTag = 0;
+    for (TDF_ChildIterator it(tool->Label()); it.More(); it.Next())
+        lastTag = std::max(lastTag, it.Value().Tag());
+
+    return lastTag;
+}
+
+TDF_LabelSequence XCaf::topLevelFreeShapesAfter(int watermark) const
+{
+    TDF_LabelSequence seq;
+    Handle_XCAFDoc_ShapeTool tool = this->shapeTool();
+    if (!tool)
+        return seq;
+
+    auto fnAppendIfFreeShape = [&](const TDF_Label& label) {
+        if (!label.IsNull() && XCaf::isShape(label) && XCaf::isShapeFree(label))
+            seq.Append(label);
+    };
+    const TDF_Label labelShapes = tool->Label();
+    Handle_TDF_TagSource tagSrc;
+    if (labelShapes.FindAttribute(TDF_TagSource::GetID(), tagSrc)) {
+        // Lookup of children by increasing tags is amortized, TDF_Label keeps the last found child
+        for (int tag = watermark + 1; tag <= tagSrc->Get(); ++tag)
+            fnAppendIfFreeShape(labelShapes.FindChild(tag, false));
     }
+    else {
+        for (TDF_ChildIterator it(labelShapes); it.More(); it.Next()) {
+            if (it.Value().Tag() > watermark)
+                fnAppendIfFreeShape(it.Value());
+        }
+    }
+
+    return seq;
+}
+
+void XCaf::resolveShapeStyles(TreeNodeId firstNodeId)
+{
+    Expects(m_modelTree != nullptr);
+    const Tree<TDF_Label>& modelTree = *m_modelTree;
+    const TreeNodeId lastNodeId = TreeNodeId(modelTree.nodeCount());
+    m_vecNodeStyleIndex.resize(lastNodeId + 1, 0);
+    const Handle_XCAFDoc_ColorTool colorTool = this->colorTool();
+    auto fnFindColor = [&](const TDF_Label& label, Quantity_Color* ptrColor) {
+        return colorTool
+                && (colorTool->GetColor(label, XCAFDoc_ColorGen, *ptrColor)
+                    || colorTool->GetColor(label, XCAFDoc_ColorSurf, *ptrColor)
+                    || colorTool->GetColor(label, XCAFDoc_ColorCurv, *ptrColor));
+    };
+    // Color attributes lookups are read-only, so they are done concurrently for the new subtrees
+    struct NodeColor {
+        bool found = false;
+        Quantity_Color color;
+    };
+    std::vector<NodeColor> vecNodeColor(lastNodeId + 1);
+    for (TreeNodeId rootId : modelTree.roots()) {
+        if (rootId < firstNodeId)
+            continue;
+
+        traverseTree_parallel(rootId, modelTree, [&](TreeNodeId id) {
+            NodeColor& nodeColor = vecNodeColor[id];
+            nodeColor.found = fnFindColor(modelTree.nodeData(id), &nodeColor.color);
+        });
+    }
+
+    // Node identifiers are assigned in depth-first order, so the style of a parent node is always
+    // resolved before the styles of its children
+    std::vector<bool> vecHasInstanceColor(lastNodeId + 1, false);
+    for (TreeNodeId id = std::max(firstNodeId, TreeNodeId(1)); id <= lastNodeId; ++id) {
+        const TreeNodeId parentId = modelTree.nodeParent(id);
+        uint32_t styleIndex = parentId != 0 ? m_vecNodeStyleIndex.at(parentId) : 0;
+        // Color of an instance overrides the color of the referred product
+        const bool parentHasInstanceColor = vecHasInstanceColor.at(parentId);
+        const TDF_Label& label = modelTree.nodeData(id);
+        const NodeColor& nodeColor = vecNodeColor.at(id);
+        if (!parentHasInstanceColor && nodeColor.found) {
+            const Quantity_Color& color = nodeColor.color;
+            auto itInserted = m_mapColorStyleIndex.insert({ packedColor(color), 0 });
+            if (itInserted.second) { // New style
+                itInserted.first->second = uint32_t(m_vecShapeStyle.size());
+                m_vecShapeStyle.push_back({ true, color });
+            }
+
+            styleIndex = itInserted.first->second;
+            vecHasInstanceColor[id] = XCaf::isShapeReference(label);
+        }
 
-    TDF_LabelSequence seqDiff;
-    for (const TDF_Label& label : seqAfter) {
-        Expects(firstBeforeLabel.IsNull() || label.Depth() == firstBeforeLabel.Depth());
-        if (setBeforeTag.find(label.Tag()) == setBeforeTag.cend())
-            seqDiff.Append(label);
+        m_vecNodeStyleIndex[id] = styleIndex;
     }
+}
 
-    return seqDiff;
+void XCaf::invalidateShapeStyles()
+{
+    m_vecShapeStyle.resize(1); // Keep the "no style" entry
+    m_vecNodeStyleIndex.clear();
+    m_mapColorStyleIndex.clear();
 }
 
 TreeNodeId XCaf::deepBuildAssemblyTree(TreeNodeId parentNode, const TDF_Label& label)
 {
     Expects(m_modelTree != nullptr);
+    return XCaf::deepBuildAssemblyTree(parentNode, label, m_modelTree, &m_vecAbsoluteLocation);
+}
+
+void XCaf::deepBuildAssemblyTrees(const TDF_LabelSequence& seqLabel)
+{
+    Expects(m_modelTree != nullptr);
+
+    // Independent subtrees are the top-level shapes, or the components when there is a single
+    // top-level assembly(which is the common case)
+    struct SubTree {
+        TreeNodeId parentNode;
+        TDF_Label label;
+        Tree<TDF_Label> tree;
+        std::vector<TopLoc_Location> vecAbsoluteLocation;
+    };
+    std::vector<SubTree> vecSubTree;
+    for (const TDF_Label& label : seqLabel) {
+        if (seqLabel.Size() == 1 && XCaf::isShapeAssembly(label)) {
+            const TreeNodeId node = m_modelTree->appendChild(0, label);
+            if (node >= m_vecAbsoluteLocation.size())
+                m_vecAbsoluteLocation.resize(node + 1);
+
+            m_vecAbsoluteLocation[node] = XCaf::shapeReferenceLocation(label);
+            for (const TDF_Label& child : XCaf::shapeComponents(label))
+                vecSubTree.push_back({ node, child, {}, {} });
+        }
+        else {
+            vecSubTree.push_back({ 0, label, {}, {} });
+        }
+    }
+
+    CppUtils::parallelFor(int(vecSubTree.size()), [&](int i) {
+        SubTree& subTree = vecSubTree.at(i);
+        XCaf::deepBuildAssemblyTree(0, subTree.label, &subTree.tree, &subTree.vecAbsoluteLocation);
+    });
+
+    // Merge in order, so node identifiers are the same as with sequential depth-first building
+    for (SubTree& subTree : vecSubTree) {
+        const TopLoc_Location parentLoc =
+                subTree.parentNode != 0 ?
+                    this->shapeAbsoluteLocation(subTree.parentNode) :
+                    TopLoc_Location();
+        const TreeNodeId offset = m_modelTree->appendTree(subTree.parentNode, std::move(subTree.tree));
+        const size_t subTreeLocCount = subTree.vecAbsoluteLocation.size();
+        m_vecAbsoluteLocation.resize(std::max(m_vecAbsoluteLocation.size(), offset + subTreeLocCount));
+        for (size_t id = 1; id < subTreeLocCount; ++id)
+            m_vecAbsoluteLocation[offset + id] = parentLoc * subTree.vecAbsoluteLocation.at(id);
+    }
+}
 
-    const TreeNodeId node = m_modelTree->appendChild(parentNode, label);
+TreeNodeId XCaf::deepBuildAssemblyTree(
+        TreeNodeId parentNode,
+        const TDF_Label& label,
+        Tree<TDF_Label>* ptrModelTree,
+        std::vector<TopLoc_Location>* ptrVecAbsoluteLocation)
+{
+    const TreeNodeId node = ptrModelTree->appendChild(parentNode, label);
+    // Parent node is built first, so its absolute location is already cached
+    std::vector<TopLoc_Location>& vecAbsoluteLocation = *ptrVecAbsoluteLocation;
+    const TopLoc_Location parentLoc =
+            parentNode != 0 && parentNode < vecAbsoluteLocation.size() ?
+                vecAbsoluteLocation.at(parentNode) :
+                XCaf::shapeAbsoluteLocation(*ptrModelTree, parentNode);
+    if (node >= vecAbsoluteLocation.size())
+        vecAbsoluteLocation.resize(node + 1);
+
+    vecAbsoluteLocation[node] = parentLoc * XCaf::shapeReferenceLocation(label);
     if (XCaf::isShapeAssembly(label)) {
         for (const TDF_Label& child : XCaf::shapeComponents(label))
-            this->deepBuildAssemblyTree(node, child);
+            XCaf::deepBuildAssemblyTree(node, child, ptrModelTree, ptrVecAbsoluteLocation);
     }
     else if (XCaf::isShapeReference(label)) {
         const TDF_Label referred = XCaf::shapeReferred(label);
-        this->deepBuildAssemblyTree(node, referred);
+        XCaf::deepBuildAssemblyTree(node, referred, ptrModelTree, ptrVecAbsoluteLocation);
     }
 #if 0
     else if (XCaf::isShapeSimple(label)) {
         for (const TDF_Label& child : XCaf::shapeSubs(label))
-            this->deepBuildAssemblyTree(node, child);
+            XCaf::deepBuildAssemblyTree(node, child, ptrModelTree, ptrVecAbsoluteLocation);
     }
 #endif
 
@@ -15,6 +15,9 @@
 #if OCC_VERSION_HEX >= 0x070500
 #  include <XCAFDoc_VisMaterialTool.hxx>
 #endif
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
 
 namespace Mayo {
 
@@ -30,6 +33,13 @@ public:
         QuantityVolume volume;
     };
 
+    // Effective style of a model tree node: its own style, or the one inherited from the closest
+    // parent node(instance, assembly) having a style
+    struct ShapeStyle {
+        bool hasColor = false;
+        Quantity_Color color;
+    };
+
     bool isNull() const;
 
     Handle_XCAFDoc_ShapeTool shapeTool() const;
@@ -55,26 +65,58 @@ public:
     bool hasShapeColor(const TDF_Label& lbl) const;
     Quantity_Color shapeColor(const TDF_Label& lbl) const;
 
+    // Cached version, locations are computed once when the model tree is built
     TopLoc_Location shapeAbsoluteLocation(TreeNodeId nodeId) const;
     static TopLoc_Location shapeAbsoluteLocation(const Tree<TDF_Label>& modelTree, TreeNodeId nodeId);
     static TopLoc_Location shapeReferenceLocation(const TDF_Label& lbl);
     static TDF_Label shapeReferred(const TDF_Label& lbl);
 
+    // Cached version, styles are resolved once when the model tree is built
+    // Nodes with the same effective style share the same index in the style table, index 0 is
+    // for nodes without any style
+    uint32_t shapeStyleIndex(TreeNodeId nodeId) const;
+    const ShapeStyle& shapeStyle(TreeNodeId nodeId) const;
+    const ShapeStyle& shapeStyleAt(uint32_t styleIndex) const { return m_vecShapeStyle.at(styleIndex); }
+    size_t shapeStyleCount() const { return m_vecShapeStyle.size(); }
+
     static ValidationProperties validationProperties(const TDF_Label& lbl);
 
-    // Returns labels of the top-level free shapes that were not found in 'seqOther'
-    TDF_LabelSequence diffTopLevelFreeShapes(const TDF_LabelSequence& seqOther) const;
+    // Tag of the last label created under the shapes label, 0 if none
+    // Shapes added afterwards(eg by a file transfer) get greater tags, see topLevelFreeShapesAfter()
+    int shapesTagWatermark() const;
+    // Returns labels of the top-level free shapes whose tag is greater than 'watermark'
+    // Cost is proportional to the count of labels created after 'watermark', not to the count of
+    // shapes in the document
+    TDF_LabelSequence topLevelFreeShapesAfter(int watermark) const;
 
 private:
     XCaf() = default;
 
     TreeNodeId deepBuildAssemblyTree(TreeNodeId parentNode, const TDF_Label& label);
+    // Builds the trees of 'seqLabel' as model tree roots, independent subtrees are built in parallel
+    void deepBuildAssemblyTrees(const TDF_LabelSequence& seqLabel);
+    // Doesn't access XCaf members, so can be called concurrently on separate trees
+    static TreeNodeId deepBuildAssemblyTree(
+            TreeNodeId parentNode,
+            const TDF_Label& label,
+            Tree<TDF_Label>* ptrModelTree,
+            std::vector<TopLoc_Location>* ptrVecAbsoluteLocation);
     void setLabelMain(const TDF_Label& labelMain) { m_labelMain = labelMain; }
     void setModelTree(Tree<TDF_Label>& modelTree) { m_modelTree = &modelTree; }
+    void invalidateAbsoluteLocations() { m_vecAbsoluteLocation.clear(); }
+    // Resolves styles of the model tree nodes from 'firstNodeId' up to the last one
+    void resolveShapeStyles(TreeNodeId firstNodeId);
+    void invalidateShapeStyles();
 
     friend class Document;
     TDF_Label m_labelMain;
     Tree<TDF_Label>* m_modelTree = nullptr;
+    // Absolute locations of the model tree nodes, indexed by TreeNodeId
+    std::vector<TopLoc_Location> m_vecAbsoluteLocation;
+    // Style table, and index in the style table of the model tree nodes(indexed by TreeNodeId)
+    std::vector<ShapeStyle> m_vecShapeStyle = { ShapeStyle{} };
+    std::vector<uint32_t> m_vecNodeStyleIndex;
+    std::unordered_map<uint64_t, uint32_t> m_mapColorStyleIndex; // Key is a packed RGB color
 };
 
 } // namespace Mayo
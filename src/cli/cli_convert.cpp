@@ -0,0 +1,849 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "cli_convert.h"
+#include "console.h"
+#include "../base/application.h"
+#include "../base/bnd_utils.h"
+#include "../base/caf_utils.h"
+#include "../base/cross_section.h"
+#include "../base/document.h"
+#include "../base/global.h"
+#include "../base/io_export_split.h"
+#include "../base/io_writer.h"
+#include "../base/job_arena.h"
+#include "../base/memory_stats.h"
+#include "../base/part_bvh.h"
+#include "../base/perf_stats.h"
+#include "../base/string_utils.h"
+#include "../base/task_manager.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTimer>
+#include <QtCore/QtDebug>
+#ifdef Q_OS_WIN
+#  include <fcntl.h>
+#  include <io.h>
+#  include <cstdio>
+#endif
+
+#include <Message.hxx>
+#include <gp.hxx>
+#include <gp_Ax3.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Mayo {
+
+namespace {
+
+// Messages keep the translation context they had in Mayo's main.cpp
+class Main { Q_DECLARE_TR_FUNCTIONS(Mayo::Main) };
+
+// Set when exported data is written on standard output, console text then goes to standard error
+std::atomic<bool> cliStdoutReserved = {};
+
+std::ostream& cliTextOutput()
+{
+    return cliStdoutReserved ? std::cerr : std::cout;
+}
+
+// Whether 'fp' stands for standard input/output on the command-line: "-", optionally prefixed
+// with a format suffix as in "stl:-"(format of the output can't be guessed otherwise)
+bool cliIsStdStream(const FilePath& fp, QString* ptrSuffix = nullptr)
+{
+    const QString str = filepathTo<QString>(fp);
+    if (str != "-" && !str.endsWith(":-"))
+        return false;
+
+    if (ptrSuffix)
+        *ptrSuffix = str.chopped(str.size() > 1 ? 2 : 1);
+
+    return true;
+}
+
+// Standard streams are opened in text mode on Windows, line endings would be converted
+void cliSetStdStreamBinaryMode(FILE* file)
+{
+#ifdef Q_OS_WIN
+    _setmode(_fileno(file), _O_BINARY);
+#else
+    MAYO_UNUSED(file);
+#endif
+}
+
+// Size in bytes of file 'fp', 0 if it can't be retrieved(eg not existing)
+int64_t cliFileSize(const FilePath& fp)
+{
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(fp, ec);
+    return !ec ? int64_t(size) : 0;
+}
+
+// Status of a task run in CLI mode
+struct CliTaskStatus {
+    bool started = false; // Only accessed from the main thread
+    std::atomic<bool> finished = {};
+    std::atomic<bool> success = {};
+    // Reported with CliConvertArguments::jsonlProgressReport
+    int index = 0; // Position of the task in creation order
+    std::chrono::steady_clock::time_point timeStarted; // Only accessed from the main thread
+    QString stage; // Only accessed from the main thread
+    std::atomic<int64_t> bytesRead = {};
+    std::atomic<int64_t> bytesWritten = {};
+};
+
+// Helper object shared by CLI asynchronous operations
+struct CliTaskHelper : public QObject {
+    // Task manager object dedicated to the scope of the CLI operation
+    TaskManager taskMgr;
+    // Mapping between a task id and the task status, tasks missing(eg continuations created with
+    // TaskManager::whenAll()) aren't reported
+    std::unordered_map<TaskId, std::unique_ptr<CliTaskStatus>> mapTaskStatus;
+    // Progress lines in console, in task start order. Only lines marked dirty are redrawn
+    struct ProgressLine {
+        TaskId taskId;
+        bool isDirty = true;
+        int width = -1; // Printed width, -1 if not printed yet
+        int rowCount = 0; // Count of console rows occupied by the line
+    };
+    std::vector<ProgressLine> vecProgressLine;
+    std::unordered_map<TaskId, size_t> mapTaskProgressLine;
+    int progressPrintWidth = -1; // Console width when progress lines were printed
+    QTimer* progressRefreshTimer = nullptr;
+    // Resource limits applied to each task created with newTask()
+    int64_t taskTimeLimit = 0;
+    int64_t taskMemoryLimit = 0;
+
+    TaskId newTask(const QString& title, TaskJob fn) {
+        const TaskId taskId = this->taskMgr.newTask(std::move(fn));
+        auto status = std::make_unique<CliTaskStatus>();
+        status->index = int(this->mapTaskStatus.size());
+        this->mapTaskStatus.insert({ taskId, std::move(status) });
+        this->taskMgr.setTitle(taskId, title);
+        this->taskMgr.setTimeLimit(taskId, this->taskTimeLimit);
+        this->taskMgr.setMemoryLimit(taskId, this->taskMemoryLimit);
+        return taskId;
+    }
+
+    // Failure of a task aborted by an exceeded limit is reported as such, whatever 'title' is
+    void setTaskFinished(TaskId taskId, bool success, const QString& title) {
+        const TaskLimit limit = this->taskMgr.limitExceeded(taskId);
+        if (limit != TaskLimit::None) {
+            const QString taskTitle = this->taskMgr.title(taskId);
+            this->taskMgr.setTitle(taskId, taskTitle + ": " + cli_taskLimitExceededMessage(limit));
+            success = false;
+        }
+        else {
+            this->taskMgr.setTitle(taskId, title);
+        }
+
+        this->mapTaskStatus.at(taskId)->success = success;
+        this->mapTaskStatus.at(taskId)->finished = true;
+    }
+
+    // Accumulates the count of bytes read/written by a task, safe to be called from any thread
+    void addTaskBytes(TaskId taskId, int64_t bytesRead, int64_t bytesWritten) {
+        this->mapTaskStatus.at(taskId)->bytesRead += bytesRead;
+        this->mapTaskStatus.at(taskId)->bytesWritten += bytesWritten;
+    }
+
+    // Prints in console the timings collected by each task, one JSON object per line
+    void printPerfStats() {
+        if (!PerfStats::isEnabled())
+            return;
+
+        this->taskMgr.foreachTask([=](TaskId taskId) {
+            const PerfStats* stats = this->taskMgr.perfStats(taskId);
+            if (stats && !stats->isEmpty())
+                cliTextOutput() << stats->toJson(this->taskMgr.title(taskId).toStdString()) << std::endl;
+        });
+    }
+
+    bool isTaskReported(TaskId taskId) const {
+        return this->mapTaskStatus.find(taskId) != this->mapTaskStatus.cend();
+    }
+
+    bool allTasksSucceeded() const {
+        for (const auto& mapPair : this->mapTaskStatus) {
+            if (!mapPair.second->success)
+                return false;
+        }
+
+        return true;
+    }
+
+    // Marks progress line of 'taskId' to be redrawn at next call to printProgress()
+    void markProgressDirty(TaskId taskId) {
+        auto itLine = this->mapTaskProgressLine.find(taskId);
+        if (itLine != this->mapTaskProgressLine.end()) {
+            this->vecProgressLine.at(itLine->second).isDirty = true;
+        }
+        else {
+            this->mapTaskProgressLine.insert({ taskId, this->vecProgressLine.size() });
+            this->vecProgressLine.push_back({ taskId });
+        }
+    }
+
+    // Redraws in console the dirty progress lines of started tasks, with a single write
+    // Cursor is expected to be below the last progress line
+    void printProgress() {
+        auto itFirstDirty = std::find_if(
+                    this->vecProgressLine.begin(), this->vecProgressLine.end(), [](const ProgressLine& line) {
+            return line.isDirty;
+        });
+        const int printWidth = consoleWidth();
+        if (itFirstDirty == this->vecProgressLine.end() && printWidth == this->progressPrintWidth)
+            return;
+
+        // Lines are reflowed by the console when its width changes, redraw everything
+        if (printWidth != this->progressPrintWidth) {
+            itFirstDirty = this->vecProgressLine.begin();
+            for (ProgressLine& line : this->vecProgressLine)
+                line.isDirty = true;
+        }
+
+        this->progressPrintWidth = printWidth;
+        auto fnRowCount = [=](int width) { return printWidth > 0 ? (width / printWidth) + 1 : 1; };
+        int rowCountBelow = 0; // Count of console rows from the first dirty line up to the cursor
+        for (auto it = itFirstDirty; it != this->vecProgressLine.end(); ++it)
+            rowCountBelow += it->rowCount;
+
+        ConsoleOutputBuffer output;
+        output.cursorMoveUp(rowCountBelow);
+        for (auto it = itFirstDirty; it != this->vecProgressLine.end(); ++it) {
+            ProgressLine& line = *it;
+            if (!line.isDirty) {
+                output.append(line.rowCount, '\n'); // Skip line
+                continue;
+            }
+
+            output.append("\r");
+            const TaskId taskId = line.taskId;
+            const std::string strMessage = consoleToPrintable(this->taskMgr.title(taskId).replace('\n', ' '));
+            int lineWidth = strMessage.size();
+            const bool taskFinished = this->mapTaskStatus.at(taskId)->finished;
+            const bool taskSuccess = this->mapTaskStatus.at(taskId)->success;
+            if (taskFinished && !taskSuccess) {
+                output.setTextColor(ConsoleColor::Red);
+                output.append(strMessage);
+                output.setTextColor(ConsoleColor::Default);
+            }
+            else {
+                const int progress = this->taskMgr.progress(taskId);
+                if (progress >= 100)
+                    output.setTextColor(ConsoleColor::Green);
+
+                const std::string strProgress = std::to_string(progress);
+                output.append(std::max(3 - int(strProgress.size()), 0), ' ');
+                output.append(strProgress + "% ");
+                output.append(strMessage);
+                lineWidth += 5;
+                if (progress >= 100)
+                    output.setTextColor(ConsoleColor::Default);
+            }
+
+            // Overwrite the remaining characters of the previous print
+            const int lineWidthOld = line.width >= 0 ? line.width : printWidth - 1;
+            output.append(std::max(lineWidthOld - lineWidth, 0), ' ');
+            // Rows occupied by a line never shrink, other lines would have to move up
+            const int rowCountPrinted = fnRowCount(std::max(lineWidth, lineWidthOld));
+            const int rowCount = std::max(rowCountPrinted, line.rowCount);
+            output.append(1 + rowCount - rowCountPrinted, '\n');
+            // Growing line overlaps the next ones, which then have to be redrawn
+            if (rowCount != line.rowCount && line.rowCount > 0) {
+                for (auto itNext = std::next(it); itNext != this->vecProgressLine.end(); ++itNext)
+                    itNext->isDirty = true;
+            }
+
+            line.width = lineWidth;
+            line.rowCount = rowCount;
+            line.isDirty = false;
+        }
+    }
+
+    // Starts redraw of dirty progress lines at fixed rate
+    void startProgressRefresh() {
+        if (this->progressRefreshTimer)
+            return;
+
+        this->progressRefreshTimer = new QTimer(this);
+        QObject::connect(this->progressRefreshTimer, &QTimer::timeout, this, [=]{ this->printProgress(); });
+        this->progressRefreshTimer->start(100);
+    }
+
+    // Prints in console the JSON object of a task event, see CliConvertArguments::jsonlProgressReport
+    void printJsonEvent(TaskId taskId, const char* eventName, QJsonObject event = {}) {
+        const CliTaskStatus* status = this->mapTaskStatus.at(taskId).get();
+        const auto elapsed = std::chrono::steady_clock::now() - status->timeStarted;
+        event.insert("id", status->index);
+        event.insert("event", QString::fromUtf8(eventName));
+        event.insert("elapsed", qint64(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()));
+        cliTextOutput() << QJsonDocument(event).toJson(QJsonDocument::Compact).toStdString() << std::endl;
+    }
+
+    // Reports task events as JSON objects, progress events being throttled by the task manager
+    void connectTaskJsonReport() {
+        this->taskMgr.setProgressSignalInterval(250);
+        QObject::connect(&this->taskMgr, &TaskManager::started, this, [=](TaskId taskId) {
+            if (!this->isTaskReported(taskId))
+                return;
+
+            CliTaskStatus* status = this->mapTaskStatus.at(taskId).get();
+            status->started = true;
+            status->timeStarted = std::chrono::steady_clock::now();
+            this->printJsonEvent(taskId, "started", {{ "title", this->taskMgr.title(taskId) }});
+        });
+        QObject::connect(&this->taskMgr, &TaskManager::progressStep, this, [=](TaskId taskId, const QString& stepTitle) {
+            if (this->isTaskReported(taskId))
+                this->mapTaskStatus.at(taskId)->stage = stepTitle;
+        });
+        QObject::connect(&this->taskMgr, &TaskManager::progressChanged, this, [=](TaskId taskId, int percent) {
+            if (!this->isTaskReported(taskId))
+                return;
+
+            QJsonObject event{{ "progress", percent }};
+            const QString& stage = this->mapTaskStatus.at(taskId)->stage;
+            if (!stage.isEmpty())
+                event.insert("stage", stage);
+
+            this->printJsonEvent(taskId, "progress", event);
+        });
+        QObject::connect(&this->taskMgr, &TaskManager::ended, this, [=](TaskId taskId) {
+            if (!this->isTaskReported(taskId))
+                return;
+
+            const CliTaskStatus* status = this->mapTaskStatus.at(taskId).get();
+            this->printJsonEvent(taskId, "finished", {
+                { "success", bool(status->success) },
+                { "message", this->taskMgr.title(taskId).trimmed() },
+                { "bytesRead", qint64(status->bytesRead) },
+                { "bytesWritten", qint64(status->bytesWritten) }
+            });
+        });
+    }
+
+    // Shows progress/traces corresponding to task events
+    void connectTaskReport(const CliConvertArguments& args) {
+        if (args.jsonlProgressReport)
+            return this->connectTaskJsonReport();
+
+        const bool cliProgressReport = args.cliProgressReport;
+        if (cliProgressReport)
+            this->startProgressRefresh();
+
+        QObject::connect(&this->taskMgr, &TaskManager::started, this, [=](TaskId taskId) {
+            if (!this->isTaskReported(taskId))
+                return;
+
+            this->mapTaskStatus.at(taskId)->started = true;
+            if (cliProgressReport)
+                this->markProgressDirty(taskId);
+            else
+                qInfo() << this->taskMgr.title(taskId);
+        });
+        QObject::connect(&this->taskMgr, &TaskManager::ended, this, [=](TaskId taskId) {
+            if (!this->isTaskReported(taskId))
+                return;
+
+            if (cliProgressReport) {
+                // Final state is printed right away, operation might exit afterwards
+                this->markProgressDirty(taskId);
+                this->printProgress();
+            }
+            else {
+                if (this->mapTaskStatus.at(taskId)->success)
+                    qInfo() << this->taskMgr.title(taskId);
+                else
+                    qCritical() << this->taskMgr.title(taskId);
+            }
+        });
+        QObject::connect(&this->taskMgr, &TaskManager::progressChanged, this, [=](TaskId taskId) {
+            if (cliProgressReport && this->isTaskReported(taskId))
+                this->markProgressDirty(taskId);
+        });
+    }
+};
+
+} // namespace
+
+void cli_asyncExportDocuments(
+        Application* app,
+        const CliConvertArguments& args,
+        const CliConvertServices& services,
+        std::function<void(int)> fnContinuation)
+{
+    auto helper = new CliTaskHelper; // Allocated on heap because current function is asynchronous
+    helper->taskTimeLimit = services.taskTimeLimit;
+    helper->taskMemoryLimit = services.taskMemoryLimit;
+    auto taskMgr = &helper->taskMgr;
+    const IO::ParametersProvider* paramsProvider = services.parametersProvider;
+    const CliConvertServices::FunctionComputeBRepMesh fnComputeBRepMesh = services.fnComputeBRepMesh;
+
+    // Helper function to exit current function
+    auto fnExit = [=](int retCode) {
+        helper->printPerfStats();
+        helper->deleteLater();
+        fnContinuation(retCode);
+    };
+
+    // Progress lines would be mixed with exported data written on standard output
+    CliConvertArguments reportArgs = args;
+    int stdoutTargetCount = 0;
+    for (const FilePath& filepath : args.listFilepathToExport)
+        stdoutTargetCount += cliIsStdStream(filepath) ? 1 : 0;
+
+    if (stdoutTargetCount > 0) {
+        cliStdoutReserved = true;
+        reportArgs.cliProgressReport = false;
+        cliSetStdStreamBinaryMode(stdout);
+    }
+
+    helper->connectTaskReport(reportArgs);
+
+    // Probe target formats once. If any of them is a mesh format then imported BRep shapes are
+    // meshed in a single pass at import, shared by all the export tasks
+    struct ExportTarget {
+        FilePath filepath;
+        bool isStdout = false;
+        IO::Format format;
+        const PropertyGroup* params = nullptr;
+        bool exclusive = false; // Writer modifies document data, it must run alone
+    };
+    std::vector<ExportTarget> vecTarget;
+    bool brepMeshRequired = false;
+    for (const FilePath& filepath : args.listFilepathToExport) {
+        ExportTarget target;
+        target.filepath = filepath;
+        QString stdoutSuffix;
+        target.isStdout = cliIsStdStream(filepath, &stdoutSuffix);
+        if (target.isStdout) {
+            for (const IO::Format& format : app->ioSystem()->writerFormats()) {
+                if (format.fileSuffixes.contains(stdoutSuffix, Qt::CaseInsensitive))
+                    target.format = format;
+            }
+        }
+        else {
+            target.format = app->ioSystem()->probeFormat(filepath);
+        }
+
+        target.params = paramsProvider ? paramsProvider->findWriterParameters(target.format) : nullptr;
+        std::unique_ptr<IO::Writer> writer = app->ioSystem()->createWriter(target.format);
+        if (writer) {
+            writer->applyProperties(target.params);
+            target.exclusive = writer->modifiesItemsData();
+        }
+
+        brepMeshRequired = brepMeshRequired || IO::formatProvidesMesh(target.format);
+        vecTarget.push_back(std::move(target));
+    }
+
+    if (stdoutTargetCount > 1) {
+        qCritical() << Main::tr("Only one output can be written on standard output");
+        return fnExit(EXIT_FAILURE);
+    }
+
+    for (const ExportTarget& target : vecTarget) {
+        if (target.isStdout && args.exportSplitMode != IO::ExportSplitMode::None) {
+            qCritical() << Main::tr("Standard output can't be written when exporting each item separately");
+            return fnExit(EXIT_FAILURE);
+        }
+
+        if (target.isStdout && target.format == IO::Format_Unknown) {
+            qCritical() << Main::tr("Format of standard output must be specified with a file suffix(eg. stl:-)");
+            return fnExit(EXIT_FAILURE);
+        }
+    }
+
+    // Input "-" is standard input, imported after the files
+    std::vector<FilePath> vecFilepathToOpen;
+    bool hasStdinInput = false;
+    for (const FilePath& filepath : args.listFilepathToOpen) {
+        if (cliIsStdStream(filepath))
+            hasStdinInput = true;
+        else
+            vecFilepathToOpen.push_back(filepath);
+    }
+
+    if (hasStdinInput)
+        cliSetStdStreamBinaryMode(stdin);
+
+    // Suppress output from OpenCascade
+    Message::DefaultMessenger()->RemovePrinters(Message_Printer::get_type_descriptor());
+
+    // Execute import operation(synchronous)
+    DocumentPtr doc = app->newDocument();
+    doc->setViewerOnly(true); // Imports are never undone by the CLI
+    bool okImport = true;
+    const TaskId importTaskId = helper->newTask(Main::tr("Importing..."), [&](TaskProgress* progress) {
+            CliErrorMessageCollect errorCollect;
+            auto fnImportOperation = [&](TaskProgress* importProgress) {
+                return app->ioSystem()->importInDocument()
+                    .targetDocument(doc)
+                    .withParametersProvider(paramsProvider)
+                    .withEntitiesPostProcess([=](auto spanFileEntities, TaskProgress* progress) {
+                        if (fnComputeBRepMesh)
+                            fnComputeBRepMesh(spanFileEntities, progress);
+                    })
+                    .withEntityPostProcessRequiredIf([=](const IO::Format&){ return brepMeshRequired; })
+                    .withEntityPostProcessInfoProgress(20, Main::tr("Mesh BRep shapes"))
+                    .withMessenger(&errorCollect)
+                    .withTaskProgress(importProgress);
+            };
+            const int importCount = (!vecFilepathToOpen.empty() ? 1 : 0) + (hasStdinInput ? 1 : 0);
+            if (!vecFilepathToOpen.empty()) {
+                TaskProgress filesProgress(progress, 100 / importCount);
+                okImport = fnImportOperation(&filesProgress).withFilepaths(vecFilepathToOpen).execute();
+                for (const FilePath& filepath : vecFilepathToOpen)
+                    helper->addTaskBytes(progress->taskId(), cliFileSize(filepath), 0);
+            }
+
+            if (okImport && hasStdinInput) {
+                TaskProgress stdinProgress(progress, 100 / importCount);
+                okImport = fnImportOperation(&stdinProgress).withInputStream(&std::cin, "stdin").execute();
+            }
+
+            helper->setTaskFinished(
+                        progress->taskId(), okImport, okImport ? Main::tr("Imported") : errorCollect.message);
+    });
+    taskMgr->exec(importTaskId, TaskAutoDestroy::Off);
+    if (!okImport)
+        return fnExit(EXIT_FAILURE); // Error
+
+    if (args.memoryStats)
+        cli_printDocumentMemoryStats(doc);
+
+    // Run export operations(asynchronous)
+    // Writers only reading the document run in parallel. Exclusive writers get the full weight of
+    // the pool, they are queued first so they run one at a time before the parallel ones
+    std::stable_partition(vecTarget.begin(), vecTarget.end(), [](const ExportTarget& target) {
+        return target.exclusive;
+    });
+    std::vector<TaskId> vecExportTaskId;
+    auto fnAddExportTask = [&](const ExportTarget& target, const ApplicationItem& item, const FilePath& filepath) {
+        const QString strFilename = filepathTo<QString>(filepath.filename());
+        const QString taskTitle = Main::tr("Exporting %1...").arg(strFilename);
+        const bool isSplitTarget = args.exportSplitMode != IO::ExportSplitMode::None;
+        const TaskId taskId = helper->newTask(taskTitle, [=](TaskProgress* progress) {
+                CliErrorMessageCollect errorCollect;
+                if (isSplitTarget && filepath.has_parent_path()) {
+                    // Template %path% gives sub-directories
+                    std::error_code ec;
+                    std::filesystem::create_directories(filepath.parent_path(), ec);
+                }
+
+                const ApplicationItem appItems[] = { item };
+                const bool okExport = app->ioSystem()->exportApplicationItems()
+                            .targetFile(filepath)
+                            .targetStream(target.isStdout ? &std::cout : nullptr)
+                            .targetFormat(target.format)
+                            .withItems(appItems)
+                            .withParameters(target.params)
+                            .withMessenger(&errorCollect)
+                            .withTaskProgress(progress)
+                            .execute();
+                if (okExport && !target.isStdout)
+                    helper->addTaskBytes(progress->taskId(), 0, cliFileSize(filepath));
+
+                const QString msg = okExport ? Main::tr("Exported %1").arg(strFilename) : errorCollect.message;
+                helper->setTaskFinished(progress->taskId(), okExport, msg);
+        });
+        if (target.exclusive)
+            taskMgr->setWeight(taskId, taskMgr->poolSize());
+
+        vecExportTaskId.push_back(taskId);
+    };
+
+    // In split mode, each part(or product) is written by its own task and writer. Triangulations
+    // were computed once at import, they're shared by all the writers
+    for (const ExportTarget& target : vecTarget) {
+        if (args.exportSplitMode == IO::ExportSplitMode::None) {
+            fnAddExportTask(target, doc, target.filepath);
+        }
+        else {
+            const ApplicationItem appItems[] = { doc };
+            for (const IO::ExportSplitTarget& splitTarget : IO::ExportSplitUtils::split(appItems, args.exportSplitMode, target.filepath))
+                fnAddExportTask(target, splitTarget.item, splitTarget.filepath);
+        }
+    }
+
+    // Each cross-section is computed and written by its own task
+    if (!args.filepathSections.empty()) {
+        PartBvh bvh;
+        for (int i = 0; i < doc->entityCount(); ++i)
+            bvh.addEntity(doc, doc->entityTreeNodeId(i));
+
+        const Bnd_Box bndBox = bvh.boundingBox();
+        if (bndBox.IsVoid()) {
+            qCritical() << Main::tr("No parts to section");
+            return fnExit(EXIT_FAILURE);
+        }
+
+        // Section frames, so that drawings are as seen from the right, the front and the top
+        const gp_Ax3 axisFrames[] = {
+            gp_Ax3(gp::Origin(), gp::DX(), gp::DY()),
+            gp_Ax3(gp::Origin(), -gp::DY(), gp::DX()),
+            gp_Ax3(gp::Origin(), gp::DZ(), gp::DX())
+        };
+        const int axis = args.sectionAxis;
+        const auto bbc = BndBoxCoords::get(bndBox);
+        const double axisMin = bbc.minVertex().Coord(axis + 1);
+        const double axisMax = bbc.maxVertex().Coord(axis + 1);
+        const FilePath& filepathTemplate = args.filepathSections;
+        const int indexWidth = QString::number(args.sectionCount).size();
+        for (int i = 0; i < args.sectionCount; ++i) {
+            gp_Ax3 frame = axisFrames[axis];
+            gp_XYZ location = gp::Origin().XYZ();
+            location.SetCoord(axis + 1, axisMin + (i + 0.5) * (axisMax - axisMin) / args.sectionCount);
+            frame.SetLocation(location);
+            const gp_Pln plane(frame);
+            gp_Pln planeReversed = plane;
+            planeReversed.SetAxis(plane.Axis().Reversed());
+            const gp_Pln planes[] = { plane, planeReversed };
+            const std::vector<TreeNodeId> vecPartId = bvh.findInFrustum(planes);
+            const QString strIndex = QString("%1").arg(i, indexWidth, 10, QChar('0'));
+            FilePath filepath =
+                    filepathTemplate.parent_path()
+                    / filepathFrom(filepathTo<QString>(filepathTemplate.stem()) + "_" + strIndex);
+            filepath += filepathTemplate.extension();
+            const QString strFilename = filepathTo<QString>(filepath.filename());
+            const TaskId taskId = helper->newTask(Main::tr("Sectioning %1...").arg(strFilename), [=](TaskProgress* progress) {
+                const auto vecSection = CrossSection::compute(doc, vecPartId, plane, {}, progress);
+                const bool okWrite = !progress->isAbortRequested()
+                        && CrossSection::writeFile(filepath, plane, vecSection);
+                if (okWrite)
+                    helper->addTaskBytes(progress->taskId(), 0, cliFileSize(filepath));
+
+                const QString msg = okWrite ?
+                            Main::tr("Exported %1").arg(strFilename) :
+                            Main::tr("Failed to write section %1").arg(strFilename);
+                helper->setTaskFinished(progress->taskId(), okWrite, msg);
+            });
+            vecExportTaskId.push_back(taskId);
+        }
+    }
+
+    if (vecExportTaskId.empty()) {
+        qCritical() << Main::tr("No items to export");
+        return fnExit(EXIT_FAILURE);
+    }
+
+    // Quit once all export tasks are ended
+    const TaskId exportsEndedTaskId = taskMgr->whenAll(vecExportTaskId);
+    QObject::connect(taskMgr, &TaskManager::ended, helper, [=](TaskId taskId) {
+        if (taskId == exportsEndedTaskId)
+            fnExit(helper->allTasksSucceeded() ? EXIT_SUCCESS : EXIT_FAILURE);
+    });
+    for (TaskId taskId : vecExportTaskId)
+        taskMgr->run(taskId, TaskAutoDestroy::Off);
+}
+
+void cli_asyncBatchConvertDocuments(
+        Application* app,
+        const CliConvertArguments& args,
+        const CliConvertServices& services,
+        std::function<void(int)> fnContinuation)
+{
+    auto helper = new CliTaskHelper; // Allocated on heap because current function is asynchronous
+    helper->taskTimeLimit = services.taskTimeLimit;
+    helper->taskMemoryLimit = services.taskMemoryLimit;
+    auto taskMgr = &helper->taskMgr;
+    const IO::ParametersProvider* paramsProvider = services.parametersProvider;
+    const CliConvertServices::FunctionComputeBRepMesh fnComputeBRepMesh = services.fnComputeBRepMesh;
+
+    // Helper function to exit current function
+    auto fnExit = [=](int retCode) {
+        helper->printPerfStats();
+        helper->deleteLater();
+        fnContinuation(retCode);
+    };
+
+    // Find target formats from file suffixes
+    std::vector<IO::Format> vecTargetFormat;
+    bool brepMeshRequired = false;
+    for (const QString& suffix : args.listBatchTargetSuffix) {
+        const Span<const IO::Format> spanWriterFormat = app->ioSystem()->writerFormats();
+        auto itFormat = std::find_if(
+                    spanWriterFormat.begin(), spanWriterFormat.end(), [=](const IO::Format& format) {
+            return format.fileSuffixes.contains(suffix, Qt::CaseInsensitive);
+        });
+        if (itFormat == spanWriterFormat.end()) {
+            qCritical().noquote() << Main::tr("No supported output format for '%1'").arg(suffix);
+            return fnExit(EXIT_FAILURE);
+        }
+
+        vecTargetFormat.push_back(*itFormat);
+        brepMeshRequired = brepMeshRequired || IO::formatProvidesMesh(*itFormat);
+    }
+
+    // Suppress output from OpenCascade
+    Message::DefaultMessenger()->RemovePrinters(Message_Printer::get_type_descriptor());
+
+    if (services.taskPoolSize > 0)
+        taskMgr->setPoolSize(services.taskPoolSize);
+
+    // Create one "import+exports" task per input file. All tasks are submitted upfront, the thread
+    // pool of the task manager limits the count of them running at a time
+    static std::mutex mutexApp;
+    const QStringList listTargetSuffix = args.listBatchTargetSuffix; // Implicitly shared by tasks
+    const bool memoryStats = args.memoryStats;
+    std::vector<TaskId> vecTaskId;
+    for (const FilePath& fpInput : args.listFilepathToOpen) {
+        const QString strInputFilename = filepathTo<QString>(fpInput.filename());
+        const FilePath dirOutput = !args.batchOutputDir.empty() ? args.batchOutputDir : fpInput.parent_path();
+        const TaskId taskId = helper->newTask(strInputFilename, [=](TaskProgress* progress) {
+            const JobArena::Scope arenaScope; // Scratch memory of the job is released at once
+            DocumentPtr doc;
+            {
+                std::lock_guard<std::mutex> lock(mutexApp); MAYO_UNUSED(lock);
+                doc = app->newDocument();
+                doc->setViewerOnly(true);
+            }
+
+            CliErrorMessageCollect errorCollect;
+            const int exportCount = int(vecTargetFormat.size());
+            const int importPortionSize = exportCount > 0 ? 50 : 100;
+            bool ok = false;
+            {
+                TaskProgress importProgress(progress, importPortionSize, Main::tr("Importing"));
+                ok = app->ioSystem()->importInDocument()
+                        .targetDocument(doc)
+                        .withFilepath(fpInput)
+                        .withParametersProvider(paramsProvider)
+                        .withEntitiesPostProcess([=](auto spanFileEntities, TaskProgress* progress) {
+                            if (fnComputeBRepMesh)
+                                fnComputeBRepMesh(spanFileEntities, progress);
+                        })
+                        .withEntityPostProcessRequiredIf([=](const IO::Format&){ return brepMeshRequired; })
+                        .withEntityPostProcessInfoProgress(20, Main::tr("Mesh BRep shapes"))
+                        .withMessenger(&errorCollect)
+                        .withTaskProgress(&importProgress)
+                        .execute();
+                helper->addTaskBytes(progress->taskId(), cliFileSize(fpInput), 0);
+            }
+
+            for (int i = 0; ok && i < exportCount; ++i) {
+                const IO::Format& format = vecTargetFormat.at(i);
+                FilePath fpOutput = dirOutput / fpInput.filename();
+                fpOutput.replace_extension(filepathFrom(listTargetSuffix.at(i)));
+
+                if (filepathEquivalent(fpOutput, fpInput)) {
+                    errorCollect.message = Main::tr("Output file %1 would overwrite input")
+                            .arg(filepathTo<QString>(fpOutput));
+                    ok = false;
+                    break; // Interrupt
+                }
+
+                const int exportPortionSize = (100 - importPortionSize) / exportCount;
+                TaskProgress exportProgress(progress, exportPortionSize, Main::tr("Exporting"));
+                const ApplicationItem appItems[] = { doc };
+                ok = app->ioSystem()->exportApplicationItems()
+                        .targetFile(fpOutput)
+                        .targetFormat(format)
+                        .withItems(appItems)
+                        .withParameters(paramsProvider ? paramsProvider->findWriterParameters(format) : nullptr)
+                        .withMessenger(&errorCollect)
+                        .withTaskProgress(&exportProgress)
+                        .execute();
+                if (ok)
+                    helper->addTaskBytes(progress->taskId(), 0, cliFileSize(fpOutput));
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutexApp); MAYO_UNUSED(lock);
+                if (ok && memoryStats)
+                    cli_printDocumentMemoryStats(doc);
+
+                app->closeDocument(doc);
+            }
+
+            const QString msg = ok ? Main::tr("Converted %1").arg(strInputFilename) : errorCollect.message;
+            helper->setTaskFinished(progress->taskId(), ok, msg);
+        });
+        vecTaskId.push_back(taskId);
+    }
+
+    helper->connectTaskReport(args);
+    // Quit once all conversion tasks are ended
+    const TaskId allEndedTaskId = taskMgr->whenAll(vecTaskId);
+    QObject::connect(taskMgr, &TaskManager::ended, helper, [=](TaskId taskId) {
+        if (taskId == allEndedTaskId)
+            fnExit(helper->allTasksSucceeded() ? EXIT_SUCCESS : EXIT_FAILURE);
+    });
+    for (TaskId taskId : vecTaskId)
+        taskMgr->run(taskId, TaskAutoDestroy::Off);
+}
+
+QString cli_taskLimitExceededMessage(TaskLimit limit)
+{
+    switch (limit) {
+    case TaskLimit::None: return {};
+    case TaskLimit::Time: return Main::tr("Time limit exceeded");
+    case TaskLimit::Memory: return Main::tr("Memory limit exceeded");
+    }
+
+    return {};
+}
+
+void cli_printDocumentMemoryStats(const DocumentPtr& doc)
+{
+    MemoryAccounting docAccounting;
+    std::string strJson = "{\"document\":" + StringUtils::jsonQuoted(doc->name().toStdString());
+    strJson += ",\"entities\":[";
+    for (int i = 0; i < doc->entityCount(); ++i) {
+        MemoryAccounting entityAccounting;
+        entityAccounting.addTreeNode(doc, doc->entityTreeNodeId(i));
+        docAccounting.addTreeNode(doc, doc->entityTreeNodeId(i));
+        const QString entityName = CafUtils::labelAttrStdName(doc->entityLabel(i));
+        strJson += i > 0 ? "," : "";
+        strJson += "{\"name\":" + StringUtils::jsonQuoted(entityName.toStdString());
+        strJson += ",\"memory\":" + entityAccounting.stats().toJson() + "}";
+    }
+
+    strJson += "],\"total\":" + docAccounting.stats().toJson() + "}";
+    cliTextOutput() << strJson << std::endl;
+}
+
+void cli_qtMessageHandler(QtMsgType type, const QMessageLogContext& /*context*/, const QString& msg)
+{
+    const std::string localMsg = consoleToPrintable(msg);
+//    const char* file = context.file ? context.file : "";
+//    const char* function = context.function ? context.function : "";
+    switch (type) {
+    case QtDebugMsg:
+#ifndef NDEBUG
+        cliTextOutput() << "DEBUG: " << localMsg << std::endl;
+#endif
+        break;
+    case QtInfoMsg:
+        cliTextOutput() << "INFO: " << localMsg << std::endl;
+        break;
+    case QtWarningMsg:
+        std::cerr << "WARNING: " << localMsg << std::endl;
+        break;
+    case QtCriticalMsg:
+        std::cerr << "CRITICAL: " << localMsg << std::endl;
+        break;
+    case QtFatalMsg:
+        std::cerr << "FATAL: " << localMsg << std::endl;
+        break;
+    }
+}
+
+} // namespace Mayo
@@ -0,0 +1,109 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/application_ptr.h"
+#include "../base/document_ptr.h"
+#include "../base/filepath.h"
+#include "../base/io_export_split.h"
+#include "../base/io_parameters_provider.h"
+#include "../base/io_system.h"
+#include "../base/messenger.h"
+#include "../base/span.h"
+#include "../base/task_common.h"
+
+#include <QtCore/QStringList>
+#include <QtCore/QtGlobal>
+#include <functional>
+#include <vector>
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Arguments of CLI conversion operations, filled from the command-line by the executable
+struct CliConvertArguments {
+    std::vector<FilePath> listFilepathToOpen;
+    std::vector<FilePath> listFilepathToExport;
+    // Each part(or product) is exported separately, export file paths are then templates(see
+    // IO::ExportSplitUtils::split())
+    IO::ExportSplitMode exportSplitMode = IO::ExportSplitMode::None;
+    QStringList listBatchTargetSuffix;
+    FilePath batchOutputDir;
+    bool cliProgressReport = true;
+    // Progress and results are written as JSON objects, one per line(takes precedence over
+    // cliProgressReport). Example:
+    //     {"id":0,"event":"started","title":"in.step","elapsed":0}
+    //     {"id":0,"event":"progress","progress":42,"stage":"Importing","elapsed":120}
+    //     {"id":0,"event":"finished","success":true,"message":"...","elapsed":800,
+    //      "bytesRead":1024,"bytesWritten":2048}
+    // "id" is the index of the task, in creation order. "elapsed" is in milliseconds since the start
+    // of the task. Messages of failed tasks are the error messages collected during the task
+    bool jsonlProgressReport = false;
+    bool memoryStats = false;
+    // Evenly spaced cross-sections of the imported document(see CrossSection), written into
+    // "<dir>/<base name>_<index>.<svg|dxf>". Planes are orthogonal to axis 'sectionAxis'(0=X,
+    // 1=Y, 2=Z), section i is at "min + (i + 0.5) * (max - min) / sectionCount" along that axis
+    FilePath filepathSections;
+    int sectionAxis = 2;
+    int sectionCount = 10;
+};
+
+// Services required by CLI conversion operations, provided by the module of the executable
+// (eg AppModule for Mayo, a lean settings-only module for mayo-conv)
+struct CliConvertServices {
+    using FunctionComputeBRepMesh =
+        std::function<void(Span<const IO::System::ImportedFileEntities>, TaskProgress*)>;
+
+    const IO::ParametersProvider* parametersProvider = nullptr;
+    FunctionComputeBRepMesh fnComputeBRepMesh;
+    int taskPoolSize = 0; // If <= 0 then the default pool size of TaskManager is used
+    // Resource limits of each conversion task, a task exceeding them is aborted and reported as
+    // failed(see TaskManager::setTimeLimit() and TaskManager::setMemoryLimit())
+    int64_t taskTimeLimit = 0; // Milliseconds, no limit if <= 0
+    int64_t taskMemoryLimit = 0; // Resident memory of the process in bytes, no limit if <= 0
+};
+
+// Collects emitted error messages into a single string object
+struct CliErrorMessageCollect : public Messenger {
+    QString message;
+    void emitMessage(MessageType msgType, const QString& text) override {
+        if (msgType == MessageType::Error)
+            message += text + " ";
+    }
+};
+
+// Asynchronously exports input file(s) listed in 'args' into a single document
+// Cross-sections of the document are also written if CliConvertArguments::filepathSections is set
+// Calls 'fnContinuation' at the end of execution
+void cli_asyncExportDocuments(
+        Application* app,
+        const CliConvertArguments& args,
+        const CliConvertServices& services,
+        std::function<void(int)> fnContinuation);
+
+// Asynchronously converts each input file listed in 'args' into the target formats, independently
+// Input files are processed by the bounded thread pool of a task manager, sized to the count of
+// cores. Each document is closed as soon as its exports are finished, so memory stays bounded
+// Calls 'fnContinuation' at the end of execution
+void cli_asyncBatchConvertDocuments(
+        Application* app,
+        const CliConvertArguments& args,
+        const CliConvertServices& services,
+        std::function<void(int)> fnContinuation);
+
+// Error message of a task aborted because 'limit' was exceeded
+QString cli_taskLimitExceededMessage(TaskLimit limit);
+
+// Prints in console the memory estimated for each entity of 'doc', as a JSON object
+// Example: {"document":"Anonymous","entities":[{"name":"Part","memory":{...}}],"total":{...}}
+void cli_printDocumentMemoryStats(const DocumentPtr& doc);
+
+// Qt message handler printing messages in console, with a prefix telling their type
+void cli_qtMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg);
+
+} // namespace Mayo
@@ -0,0 +1,285 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "cli_options.h"
+#include "../base/io_export_split.h"
+#include "../base/perf_stats.h"
+#include "../base/settings.h"
+#include "../base/trace_recorder.h"
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QtDebug>
+
+#include <cstdlib>
+#include <initializer_list>
+
+namespace Mayo {
+
+namespace {
+
+// Messages keep the translation context they had in Mayo's main.cpp
+class Main { Q_DECLARE_TR_FUNCTIONS(Mayo::Main) };
+
+} // namespace
+
+CliOptions::CliOptions()
+    : m_fileSettings(
+          QStringList{ "s", "settings" },
+          Main::tr("Settings file(INI format) to load at startup"),
+          Main::tr("filepath")),
+      m_setting(
+          QStringList{ "set" },
+          Main::tr("Override a setting for this conversion run only, can be repeated(eg. --set "
+                   "meshing/meshingQuality=Precise --set export/STL/targetFormat=Binary)"),
+          Main::tr("path=value")),
+      m_fileToExport(
+          QStringList{ "e", "export" },
+          Main::tr("Export input files into an output file, can be repeated for different "
+                   "formats(eg. -e file.stp -e file.igs...). Standard output is written with "
+                   "\"<suffix>:-\"(eg. -e stl:-), standard input is read with input file \"-\""),
+          Main::tr("filepath")),
+      m_exportSplit(
+          QStringList{ "split" },
+          Main::tr("Export each part separately(\"parts\") or each top-level product(\"products\"), "
+                   "export file paths are templates where %name% is the part name and %path% "
+                   "the names of its parent assemblies(eg. --split parts -e lib/%path%/%name%.stl)"),
+          Main::tr("mode")),
+      m_noProgress(
+          QStringList{ "no-progress" },
+          Main::tr("Disable progress reporting of conversions in console output")),
+      m_progress(
+          QStringList{ "progress" },
+          Main::tr("Format of progress reporting of conversions in console output: \"console\"(default), "
+                   "\"none\" or \"jsonl\"(one JSON object per task event)"),
+          Main::tr("mode")),
+      m_batch(
+          QStringList{ "batch" },
+          Main::tr("Convert each input file independently into the formats specified with "
+                   "--to(eg. --batch dir/*.step --to glb,stl)")),
+      m_batchTo(
+          QStringList{ "to" },
+          Main::tr("Comma-separated list of output file suffixes(batch mode only)"),
+          Main::tr("suffixes")),
+      m_batchOutputDir(
+          QStringList{ "output-dir" },
+          Main::tr("Directory where output files are written, default is the directory of "
+                   "each input file(batch mode only)"),
+          Main::tr("dirpath")),
+      m_perfStats(
+          QStringList{ "perf-stats" },
+          Main::tr("Collect timings of import/export stages, printed in console output as a JSON "
+                   "object per task")),
+      m_memoryStats(
+          QStringList{ "memory-stats" },
+          Main::tr("Print in console output the memory estimated for each imported entity, as "
+                   "a JSON object per converted document")),
+      m_fileTrace(
+          QStringList{ "trace" },
+          Main::tr("Record the timeline of tasks and write it on exit into a file(Chrome trace "
+                   "event format, can be opened with https://ui.perfetto.dev)"),
+          Main::tr("filepath")),
+      m_serve(
+          QStringList{ "serve" },
+          Main::tr("Run conversion jobs read from standard input as JSON objects(one per line), "
+                   "progress and results are written on standard output")),
+      m_workers(
+          QStringList{ "workers" },
+          Main::tr("Dispatch conversion jobs(batch and serve modes) to a pool of worker processes, "
+                   "so translators run in parallel and a crashing job doesn't stop the other ones"),
+          Main::tr("count")),
+      m_workerMemoryLimit(
+          QStringList{ "worker-memory-limit" },
+          Main::tr("Resident memory in megabytes above which a worker process is restarted, its "
+                   "running job being reported as failed(requires --workers)"),
+          Main::tr("MB")),
+      m_taskTimeLimit(
+          QStringList{ "task-timeout" },
+          Main::tr("Maximum duration in seconds of each conversion task(export, batch and serve "
+                   "modes), a task running longer is aborted and reported as failed"),
+          Main::tr("seconds")),
+      m_taskMemoryLimit(
+          QStringList{ "task-memory-limit" },
+          Main::tr("Resident memory in megabytes above which running conversion tasks are aborted "
+                   "and reported as failed"),
+          Main::tr("MB"))
+{
+}
+
+void CliOptions::addTo(QCommandLineParser* parser) const
+{
+    for (const QCommandLineOption* option : {
+            &m_fileSettings, &m_setting, &m_fileToExport, &m_exportSplit, &m_noProgress, &m_progress,
+            &m_batch, &m_batchTo, &m_batchOutputDir, &m_perfStats, &m_memoryStats, &m_fileTrace,
+            &m_serve, &m_workers, &m_workerMemoryLimit, &m_taskTimeLimit, &m_taskMemoryLimit })
+    {
+        parser->addOption(*option);
+    }
+}
+
+CliCommandLineArguments CliOptions::parse(const QCommandLineParser& parser) const
+{
+    CliCommandLineArguments args;
+    if (parser.isSet(m_fileSettings))
+        args.filepathSettings = filepathFrom(parser.value(m_fileSettings));
+
+    args.listSettingOverride = parser.values(m_setting);
+
+    for (const QString& strFilepath : parser.values(m_fileToExport))
+        args.convert.listFilepathToExport.push_back(filepathFrom(strFilepath));
+
+    if (parser.isSet(m_exportSplit)) {
+        const QString strSplitMode = parser.value(m_exportSplit);
+        args.convert.exportSplitMode = IO::ExportSplitUtils::modeFromString(strSplitMode);
+        if (args.convert.exportSplitMode == IO::ExportSplitMode::None)
+            cli_criticalExit(Main::tr("Invalid split mode '%1', expected \"parts\" or \"products\"").arg(strSplitMode));
+    }
+
+    for (const QString& posArg : parser.positionalArguments()) {
+        // Expand wildcards, in case the shell didn't do it(eg on Windows)
+        const QFileInfo posArgInfo(posArg);
+        if (posArgInfo.fileName().contains('*') || posArgInfo.fileName().contains('?')) {
+            const QDir dir = posArgInfo.dir();
+            for (const QString& fileName : dir.entryList({ posArgInfo.fileName() }, QDir::Files, QDir::Name))
+                args.convert.listFilepathToOpen.push_back(filepathFrom(dir.filePath(fileName)));
+        }
+        else {
+            args.convert.listFilepathToOpen.push_back(filepathFrom(posArg));
+        }
+    }
+
+    const QString progressMode = parser.value(m_progress);
+    if (!progressMode.isEmpty() && !QStringList({ "console", "none", "jsonl" }).contains(progressMode))
+        cli_criticalExit(Main::tr("Invalid progress mode '%1', expected \"console\", \"none\" or \"jsonl\"").arg(progressMode));
+
+    args.convert.cliProgressReport = !parser.isSet(m_noProgress) && progressMode != "none";
+    args.convert.jsonlProgressReport = progressMode == "jsonl";
+    args.batchMode = parser.isSet(m_batch);
+    if (parser.isSet(m_batchTo)) {
+        for (const QString& suffix : parser.value(m_batchTo).split(',')) {
+            if (!suffix.trimmed().isEmpty())
+                args.convert.listBatchTargetSuffix.push_back(suffix.trimmed());
+        }
+    }
+
+    if (parser.isSet(m_batchOutputDir)) {
+        args.convert.batchOutputDir = filepathFrom(parser.value(m_batchOutputDir));
+        const QFileInfo outputDirInfo = filepathTo<QFileInfo>(args.convert.batchOutputDir);
+        if (!outputDirInfo.isDir())
+            cli_criticalExit(Main::tr("Output directory '%1' doesn't exist").arg(outputDirInfo.filePath()));
+    }
+
+    args.perfStats = parser.isSet(m_perfStats);
+    args.convert.memoryStats = parser.isSet(m_memoryStats);
+    if (parser.isSet(m_fileTrace))
+        args.filepathTrace = filepathFrom(parser.value(m_fileTrace));
+
+    args.serveMode = parser.isSet(m_serve);
+
+    // Process-pool mode, workers get the same settings
+    const QString strWorkerCount = parser.value(m_workers);
+    if (!strWorkerCount.isEmpty()) {
+        bool ok = false;
+        args.processPool.workerCount = strWorkerCount.toInt(&ok);
+        if (!ok || args.processPool.workerCount <= 0)
+            cli_criticalExit(Main::tr("Invalid count of workers '%1'").arg(strWorkerCount));
+
+        if (!args.serveMode && !args.batchMode)
+            cli_criticalExit(Main::tr("Option --workers requires --batch or --serve"));
+    }
+
+    const QString strWorkerMemoryLimit = parser.value(m_workerMemoryLimit);
+    if (!strWorkerMemoryLimit.isEmpty()) {
+        bool ok = false;
+        const qint64 memoryLimitMB = strWorkerMemoryLimit.toLongLong(&ok);
+        if (!ok || memoryLimitMB <= 0)
+            cli_criticalExit(Main::tr("Invalid worker memory limit '%1'").arg(strWorkerMemoryLimit));
+
+        if (args.processPool.workerCount <= 0)
+            cli_criticalExit(Main::tr("Option --worker-memory-limit requires --workers"));
+
+        args.processPool.workerMemoryLimit = memoryLimitMB * 1024 * 1024;
+    }
+
+    // Resource limits of conversion tasks, also applied by workers in process-pool mode
+    const QString strTaskTimeLimit = parser.value(m_taskTimeLimit);
+    if (!strTaskTimeLimit.isEmpty()) {
+        bool ok = false;
+        const qint64 timeLimitSecs = strTaskTimeLimit.toLongLong(&ok);
+        if (!ok || timeLimitSecs <= 0)
+            cli_criticalExit(Main::tr("Invalid task timeout '%1'").arg(strTaskTimeLimit));
+
+        args.taskTimeLimit = timeLimitSecs * 1000;
+        args.processPool.workerArguments << "--task-timeout" << strTaskTimeLimit;
+    }
+
+    const QString strTaskMemoryLimit = parser.value(m_taskMemoryLimit);
+    if (!strTaskMemoryLimit.isEmpty()) {
+        bool ok = false;
+        const qint64 memoryLimitMB = strTaskMemoryLimit.toLongLong(&ok);
+        if (!ok || memoryLimitMB <= 0)
+            cli_criticalExit(Main::tr("Invalid task memory limit '%1'").arg(strTaskMemoryLimit));
+
+        args.taskMemoryLimit = memoryLimitMB * 1024 * 1024;
+        args.processPool.workerArguments << "--task-memory-limit" << strTaskMemoryLimit;
+    }
+
+    if (!args.filepathSettings.empty())
+        args.processPool.workerArguments << "--settings" << filepathTo<QString>(args.filepathSettings);
+
+    for (const QString& strOverride : args.listSettingOverride)
+        args.processPool.workerArguments << "--set" << strOverride;
+
+    if (args.perfStats)
+        args.processPool.workerArguments << "--perf-stats";
+
+    return args;
+}
+
+void cli_criticalExit(const QString& msg)
+{
+    qCritical().noquote() << msg;
+    std::exit(EXIT_FAILURE);
+}
+
+void cli_applySettingOverrides(Settings* settings, const QStringList& listSettingOverride)
+{
+    for (const QString& strOverride : listSettingOverride) {
+        const int posEqual = strOverride.indexOf('=');
+        if (posEqual <= 0)
+            cli_criticalExit(Main::tr("Invalid setting override '%1', expected path=value").arg(strOverride));
+
+        const QString settingPath = strOverride.left(posEqual).trimmed();
+        const QString settingValue = strOverride.mid(posEqual + 1);
+        if (!settings->applyValue(settingPath, settingValue))
+            cli_criticalExit(Main::tr("Invalid value for setting '%1'").arg(settingPath));
+    }
+}
+
+CliInstrumentationScope::CliInstrumentationScope(const CliCommandLineArguments& args)
+    : m_filepathTrace(args.filepathTrace)
+{
+    // Instrumentation scopes are required by the trace
+    PerfStats::setEnabled(args.perfStats || !m_filepathTrace.empty());
+    if (!m_filepathTrace.empty())
+        TraceRecorder::global()->start();
+}
+
+CliInstrumentationScope::~CliInstrumentationScope()
+{
+    if (!TraceRecorder::isRecording())
+        return;
+
+    TraceRecorder::global()->stop();
+    if (!TraceRecorder::global()->writeFile(m_filepathTrace)) {
+        const QString strFilepathTrace = filepathTo<QString>(m_filepathTrace);
+        qCritical().noquote() << Main::tr("Failed to write trace file '%1'").arg(strFilepathTrace);
+    }
+}
+
+} // namespace Mayo
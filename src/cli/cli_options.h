@@ -0,0 +1,100 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/filepath.h"
+#include "cli_convert.h"
+#include "cli_process_pool.h"
+
+#include <QtCore/QCommandLineOption>
+#include <QtCore/QStringList>
+#include <cstdint>
+
+class QCommandLineParser;
+
+namespace Mayo {
+
+class Settings;
+
+// Arguments of the command-line options shared by the executables(see CliOptions)
+struct CliCommandLineArguments {
+    FilePath filepathSettings;
+    QStringList listSettingOverride;
+    // Input files are the positional arguments, wildcards being expanded
+    CliConvertArguments convert;
+    bool batchMode = false;
+    bool serveMode = false;
+    bool perfStats = false;
+    FilePath filepathTrace;
+    // Workers get the settings, overrides and resource limits of the current run
+    CliProcessPoolOptions processPool;
+    int64_t taskTimeLimit = 0; // Milliseconds, no limit if <= 0
+    int64_t taskMemoryLimit = 0; // Resident memory of the process in bytes, no limit if <= 0
+};
+
+// Command-line options of conversion operations, shared by Mayo and mayo-conv: settings and
+// overrides, export, batch, serve and process-pool modes, instrumentation and resource limits
+// Executables add their own options and positional arguments to the same parser:
+//     QCommandLineParser parser;
+//     const CliOptions cliOptions;
+//     cliOptions.addTo(&parser);
+//     parser.addPositionalArgument(...);
+//     parser.process(QCoreApplication::arguments());
+//     const CliCommandLineArguments args = cliOptions.parse(parser);
+class CliOptions {
+public:
+    CliOptions();
+
+    void addTo(QCommandLineParser* parser) const;
+
+    // Retrieves the arguments of the shared options and the input files from the processed 'parser'
+    // Invalid values exit the process with code failure(see cli_criticalExit())
+    CliCommandLineArguments parse(const QCommandLineParser& parser) const;
+
+private:
+    QCommandLineOption m_fileSettings;
+    QCommandLineOption m_setting;
+    QCommandLineOption m_fileToExport;
+    QCommandLineOption m_exportSplit;
+    QCommandLineOption m_noProgress;
+    QCommandLineOption m_progress;
+    QCommandLineOption m_batch;
+    QCommandLineOption m_batchTo;
+    QCommandLineOption m_batchOutputDir;
+    QCommandLineOption m_perfStats;
+    QCommandLineOption m_memoryStats;
+    QCommandLineOption m_fileTrace;
+    QCommandLineOption m_serve;
+    QCommandLineOption m_workers;
+    QCommandLineOption m_workerMemoryLimit;
+    QCommandLineOption m_taskTimeLimit;
+    QCommandLineOption m_taskMemoryLimit;
+};
+
+// Prints critical message 'msg' and exits the process with code failure
+[[noreturn]] void cli_criticalExit(const QString& msg);
+
+// Applies the "path=value" items of 'listSettingOverride' to 'settings', exits the process with
+// code failure if an item is invalid
+// Values of import/export parameters are kept pending(see Settings::applyValue())
+void cli_applySettingOverrides(Settings* settings, const QStringList& listSettingOverride);
+
+// Enables the instrumentation requested by the command-line(PerfStats and TraceRecorder) for the
+// lifetime of the object, the trace being written on destruction
+class CliInstrumentationScope {
+public:
+    CliInstrumentationScope(const CliCommandLineArguments& args);
+    ~CliInstrumentationScope();
+
+    CliInstrumentationScope(const CliInstrumentationScope&) = delete;
+    CliInstrumentationScope& operator=(const CliInstrumentationScope&) = delete;
+
+private:
+    FilePath m_filepathTrace;
+};
+
+} // namespace Mayo
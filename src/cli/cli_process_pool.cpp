@@ -0,0 +1,358 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "cli_process_pool.h"
+#include "../base/application.h"
+#include "../base/filepath.h"
+#include "../base/io_system.h"
+#include "../base/process_utils.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QMetaObject>
+#include <QtCore/QProcess>
+#include <QtCore/QTimer>
+#include <QtCore/QtDebug>
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Mayo {
+
+namespace {
+
+// Messages keep the translation context they had in Mayo's main.cpp
+class Main { Q_DECLARE_TR_FUNCTIONS(Mayo::Main) };
+
+// Job to be run by a worker, 'line' is the JSON object as expected by the serve mode
+struct CliPoolJob {
+    QString id;
+    QByteArray line;
+};
+
+// Dispatches jobs to worker processes and collects their events
+// Deletes itself once all jobs are finished and workers are stopped, just after calling 'fnDone'
+class CliProcessPool : public QObject {
+public:
+    using FunctionEvent = std::function<void(const QJsonObject&, const QByteArray&)>;
+
+    CliProcessPool(const CliProcessPoolOptions& options, FunctionEvent fnEvent, std::function<void()> fnDone)
+        : m_options(options),
+          m_fnEvent(std::move(fnEvent)),
+          m_fnDone(std::move(fnDone))
+    {
+        for (int i = 0; i < std::max(options.workerCount, 1); ++i)
+            m_vecWorker.push_back(std::make_unique<Worker>());
+
+        if (options.workerMemoryLimit > 0) {
+            auto timer = new QTimer(this);
+            QObject::connect(timer, &QTimer::timeout, this, [=]{ this->checkWorkersMemory(); });
+            timer->start(250);
+        }
+
+        for (const std::unique_ptr<Worker>& worker : m_vecWorker)
+            this->startWorker(worker.get());
+    }
+
+    void submitJob(CliPoolJob job) {
+        if (m_hasFailedStart)
+            return this->reportJobFailure(job.id, Main::tr("No worker process available"));
+
+        m_queueJob.push_back(std::move(job));
+        this->dispatchJobs();
+    }
+
+    // No more jobs will be submitted, workers are stopped once all jobs are finished
+    void closeInput() {
+        m_inputClosed = true;
+        this->stopIfDone();
+    }
+
+private:
+    struct Worker {
+        QProcess* process = nullptr;
+        QByteArray bufferStdout; // Incomplete line of standard output
+        QString jobId;
+        bool busy = false;
+        QString killReason;
+    };
+
+    void startWorker(Worker* worker) {
+        auto process = new QProcess(this);
+        worker->process = process;
+        worker->bufferStdout.clear();
+        worker->busy = false;
+        worker->killReason.clear();
+        // Warnings and errors of the worker are printed by the supervisor "as is"
+        process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        QObject::connect(process, &QProcess::readyReadStandardOutput, this, [=]{
+            this->onWorkerOutput(worker);
+        });
+        QObject::connect(
+                    process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                    this, [=](int exitCode, QProcess::ExitStatus exitStatus) {
+            this->onWorkerFinished(worker, process, exitCode, exitStatus);
+        });
+        QObject::connect(process, &QProcess::errorOccurred, this, [=](QProcess::ProcessError error) {
+            if (error == QProcess::FailedToStart)
+                this->onWorkerFailedToStart(worker, process);
+        });
+
+        process->start(QCoreApplication::applicationFilePath(), m_options.workerArguments + QStringList{ "--serve" });
+    }
+
+    void dispatchJobs() {
+        for (const std::unique_ptr<Worker>& worker : m_vecWorker) {
+            if (m_queueJob.empty())
+                return;
+
+            if (worker->busy || !worker->process || worker->process->state() == QProcess::NotRunning)
+                continue;
+
+            CliPoolJob job = std::move(m_queueJob.front());
+            m_queueJob.pop_front();
+            worker->jobId = job.id;
+            worker->busy = true;
+            worker->process->write(job.line + '\n');
+        }
+    }
+
+    void onWorkerOutput(Worker* worker) {
+        worker->bufferStdout += worker->process->readAllStandardOutput();
+        int posLineEnd = worker->bufferStdout.indexOf('\n');
+        while (posLineEnd >= 0) {
+            const QByteArray line = worker->bufferStdout.left(posLineEnd).trimmed();
+            worker->bufferStdout.remove(0, posLineEnd + 1);
+            if (!line.isEmpty())
+                this->onWorkerEvent(worker, line);
+
+            posLineEnd = worker->bufferStdout.indexOf('\n');
+        }
+    }
+
+    void onWorkerEvent(Worker* worker, const QByteArray& line) {
+        const QJsonObject event = QJsonDocument::fromJson(line).object();
+        if (event.isEmpty())
+            return; // Not an event, maybe some output of OpenCascade
+
+        // Events "finished" and "error" end the processing of the job line sent to the worker
+        const QString eventName = event.value("event").toString();
+        const bool isJobEnded = eventName == "finished" || eventName == "error";
+        if (isJobEnded) {
+            worker->busy = false;
+            worker->jobId.clear();
+        }
+
+        m_fnEvent(event, line);
+        if (isJobEnded) {
+            this->dispatchJobs();
+            this->stopIfDone();
+        }
+    }
+
+    void onWorkerFinished(Worker* worker, QProcess* process, int exitCode, QProcess::ExitStatus exitStatus) {
+        if (worker->process != process)
+            return;
+
+        if (worker->busy) {
+            QString message = worker->killReason;
+            if (message.isEmpty() && exitStatus == QProcess::CrashExit)
+                message = Main::tr("Worker process crashed");
+            else if (message.isEmpty())
+                message = Main::tr("Worker process exited with code %1").arg(exitCode);
+
+            this->reportJobFailure(worker->jobId, message);
+        }
+
+        process->deleteLater();
+        worker->process = nullptr;
+        worker->busy = false;
+        if (m_stopping) {
+            this->onWorkerStopped();
+        }
+        else {
+            this->startWorker(worker);
+            this->dispatchJobs();
+            this->stopIfDone();
+        }
+    }
+
+    void onWorkerFailedToStart(Worker* worker, QProcess* process) {
+        if (worker->process != process)
+            return;
+
+        qCritical().noquote() << Main::tr("Failed to start worker process: %1").arg(process->errorString());
+        process->deleteLater();
+        worker->process = nullptr;
+        m_hasFailedStart = true;
+        // Jobs can't be run, no other attempt is made
+        while (!m_queueJob.empty()) {
+            this->reportJobFailure(m_queueJob.front().id, Main::tr("No worker process available"));
+            m_queueJob.pop_front();
+        }
+
+        this->stopIfDone();
+    }
+
+    void reportJobFailure(const QString& jobId, const QString& message) {
+        const QJsonObject event{
+            { "id", jobId }, { "event", "finished" }, { "success", false }, { "message", message }
+        };
+        m_fnEvent(event, QJsonDocument(event).toJson(QJsonDocument::Compact));
+    }
+
+    void checkWorkersMemory() {
+        for (const std::unique_ptr<Worker>& worker : m_vecWorker) {
+            if (!worker->busy || !worker->process || !worker->killReason.isEmpty())
+                continue;
+
+            const int64_t memorySize = ProcessUtils::residentMemorySize(worker->process->processId());
+            if (memorySize > m_options.workerMemoryLimit) {
+                worker->killReason = Main::tr("Worker process exceeded memory limit(%1 MB)")
+                        .arg(m_options.workerMemoryLimit / (1024 * 1024));
+                worker->process->kill();
+            }
+        }
+    }
+
+    void stopIfDone() {
+        if (m_stopping || !m_inputClosed || !m_queueJob.empty())
+            return;
+
+        for (const std::unique_ptr<Worker>& worker : m_vecWorker) {
+            if (worker->busy)
+                return;
+        }
+
+        // Workers in serve mode exit once their standard input is closed
+        m_stopping = true;
+        for (const std::unique_ptr<Worker>& worker : m_vecWorker) {
+            if (worker->process)
+                worker->process->closeWriteChannel();
+        }
+
+        this->onWorkerStopped();
+    }
+
+    void onWorkerStopped() {
+        const bool allStopped = std::all_of(m_vecWorker.cbegin(), m_vecWorker.cend(), [](const auto& worker) {
+            return worker->process == nullptr;
+        });
+        if (allStopped && !m_doneNotified) {
+            m_doneNotified = true;
+            m_fnDone();
+            this->deleteLater();
+        }
+    }
+
+    CliProcessPoolOptions m_options;
+    FunctionEvent m_fnEvent;
+    std::function<void()> m_fnDone;
+    std::vector<std::unique_ptr<Worker>> m_vecWorker;
+    std::deque<CliPoolJob> m_queueJob;
+    bool m_inputClosed = false;
+    bool m_stopping = false;
+    bool m_hasFailedStart = false;
+    bool m_doneNotified = false;
+};
+
+} // namespace
+
+void cli_asyncServeConversionJobsInProcessPool(
+        const CliProcessPoolOptions& options, std::function<void(int)> fnContinuation)
+{
+    // Allocated on heap because current function is asynchronous
+    auto pool = new CliProcessPool(
+                options,
+                [](const QJsonObject& /*event*/, const QByteArray& line) {
+                    std::cout << line.toStdString() << std::endl;
+                },
+                [=]{ fnContinuation(EXIT_SUCCESS); });
+
+    // Standard input is read by a dedicated thread(blocking reads), jobs are submitted in the main
+    // thread
+    auto threadStdin = new std::thread([=]{
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue; // Skip blank line
+
+            const QByteArray jobLine = QByteArray::fromStdString(line).trimmed();
+            const QString jobId = QJsonDocument::fromJson(jobLine).object().value("id").toString();
+            QMetaObject::invokeMethod(pool, [=]{ pool->submitJob({ jobId, jobLine }); }, Qt::QueuedConnection);
+        }
+
+        QMetaObject::invokeMethod(pool, [=]{ pool->closeInput(); }, Qt::QueuedConnection);
+    });
+    QObject::connect(pool, &QObject::destroyed, [=]{
+        threadStdin->join();
+        delete threadStdin;
+    });
+}
+
+void cli_asyncBatchConvertDocumentsInProcessPool(
+        Application* app,
+        const CliConvertArguments& args,
+        const CliProcessPoolOptions& options,
+        std::function<void(int)> fnContinuation)
+{
+    // Output formats are checked upfront, as in cli_asyncBatchConvertDocuments()
+    for (const QString& suffix : args.listBatchTargetSuffix) {
+        const Span<const IO::Format> spanWriterFormat = app->ioSystem()->writerFormats();
+        auto itFormat = std::find_if(
+                    spanWriterFormat.begin(), spanWriterFormat.end(), [=](const IO::Format& format) {
+            return format.fileSuffixes.contains(suffix, Qt::CaseInsensitive);
+        });
+        if (itFormat == spanWriterFormat.end()) {
+            qCritical().noquote() << Main::tr("No supported output format for '%1'").arg(suffix);
+            return fnContinuation(EXIT_FAILURE);
+        }
+    }
+
+    auto failureCount = std::make_shared<int>(0);
+    auto pool = new CliProcessPool(
+                options,
+                [=](const QJsonObject& event, const QByteArray& /*line*/) {
+                    const QString eventName = event.value("event").toString();
+                    const QString message = event.value("message").toString();
+                    if (eventName == "finished" && event.value("success").toBool()) {
+                        qInfo().noquote() << message;
+                    }
+                    else if (eventName == "finished" || eventName == "error") {
+                        ++(*failureCount);
+                        qCritical().noquote() << event.value("id").toString() + ": " + message;
+                    }
+                },
+                [=]{ fnContinuation(*failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE); });
+
+    for (const FilePath& fpInput : args.listFilepathToOpen) {
+        const FilePath dirOutput = !args.batchOutputDir.empty() ? args.batchOutputDir : fpInput.parent_path();
+        QJsonArray jsonOutputs;
+        for (const QString& suffix : args.listBatchTargetSuffix) {
+            FilePath fpOutput = dirOutput / fpInput.filename();
+            fpOutput.replace_extension(filepathFrom(suffix));
+            jsonOutputs.append(filepathTo<QString>(fpOutput));
+        }
+
+        const QString jobId = filepathTo<QString>(fpInput);
+        const QJsonObject jsonJob{
+            { "id", jobId }, { "input", filepathTo<QString>(fpInput) }, { "outputs", jsonOutputs }
+        };
+        pool->submitJob({ jobId, QJsonDocument(jsonJob).toJson(QJsonDocument::Compact) });
+    }
+
+    pool->closeInput();
+}
+
+} // namespace Mayo
@@ -0,0 +1,45 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "cli_convert.h"
+
+#include <QtCore/QStringList>
+#include <cstdint>
+#include <functional>
+
+namespace Mayo {
+
+// Options of the process-pool mode, where conversion jobs are dispatched to worker processes
+// Workers run the current executable in serve mode(see cli_asyncServeConversionJobs()), each one
+// being given a single job at a time. This escapes the global state of OpenCascade translators
+// (eg static variables of STEP/IGES), which only allows one of them at a time per process, and
+// isolates the supervisor from crashes
+struct CliProcessPoolOptions {
+    int workerCount = 0; // Process-pool mode is enabled if > 0
+    // Resident memory in bytes above which a worker is killed and restarted, no limit if <= 0
+    int64_t workerMemoryLimit = 0;
+    // Command-line arguments of workers(eg settings), option "--serve" is appended
+    QStringList workerArguments;
+};
+
+// Same as cli_asyncServeConversionJobs() but jobs read from standard input are dispatched to the
+// pool of worker processes, events of the workers are forwarded on standard output
+// A worker crashing or exceeding the memory limit is restarted, its running job is then reported
+// with {"id":"...","event":"finished","success":false,"message":"..."}
+void cli_asyncServeConversionJobsInProcessPool(
+        const CliProcessPoolOptions& options, std::function<void(int)> fnContinuation);
+
+// Same as cli_asyncBatchConvertDocuments() but each input file is converted by a worker process
+// Results are reported in console once each file is converted
+void cli_asyncBatchConvertDocumentsInProcessPool(
+        Application* app,
+        const CliConvertArguments& args,
+        const CliProcessPoolOptions& options,
+        std::function<void(int)> fnContinuation);
+
+} // namespace Mayo
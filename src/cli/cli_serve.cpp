@@ -0,0 +1,382 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "cli_serve.h"
+#include "../base/application.h"
+#include "../base/application_item.h"
+#include "../base/document.h"
+#include "../base/global.h"
+#include "../base/io_reader.h"
+#include "../base/io_writer.h"
+#include "../base/job_arena.h"
+#include "../base/perf_stats.h"
+#include "../base/property.h"
+#include "../base/settings.h"
+#include "../base/task_manager.h"
+#include "../base/task_progress.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QMetaObject>
+
+#include <Message.hxx>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace Mayo {
+
+namespace {
+
+class Main { Q_DECLARE_TR_FUNCTIONS(Mayo::Main) };
+
+// Conversion job read from standard input
+struct CliServeJob {
+    QString id;
+    FilePath filepathInput;
+    std::vector<FilePath> vecFilepathOutput;
+    QJsonObject readerParameters;
+    QJsonObject writerParameters; // Keyed by format identifier
+    // Written by the task running the job, read once the task has ended
+    bool success = false;
+    QString message;
+    QByteArray jsonPerfStats;
+};
+
+// Provides the parameters of a job: reader parameters overridden for the input format, parameters
+// of the base provider otherwise
+struct CliServeJobParametersProvider : public IO::ParametersProvider {
+    const IO::ParametersProvider* baseProvider = nullptr;
+    IO::Format readerFormat = IO::Format_Unknown;
+    const PropertyGroup* readerGroup = nullptr;
+
+    const PropertyGroup* findReaderParameters(const IO::Format& format) const override {
+        if (this->readerGroup && format == this->readerFormat)
+            return this->readerGroup;
+
+        return this->baseProvider ? this->baseProvider->findReaderParameters(format) : nullptr;
+    }
+
+    const PropertyGroup* findWriterParameters(const IO::Format& format) const override {
+        return this->baseProvider ? this->baseProvider->findWriterParameters(format) : nullptr;
+    }
+};
+
+Property* findPropertyByKey(const PropertyGroup* group, const QString& key)
+{
+    for (Property* prop : group->properties()) {
+        if (QString::fromUtf8(prop->name().key) == key)
+            return prop;
+    }
+
+    return nullptr;
+}
+
+// Returns a new group of parameters for 'format' initialized with values of 'baseGroup' then with
+// the values of 'overrides'. Returns null if 'overrides' is empty(ie 'baseGroup' can be used as is)
+// or on error, in the latter case 'ptrError' is assigned
+template<typename FACTORY>
+std::unique_ptr<PropertyGroup> createOverridenParameters(
+        const FACTORY* factory,
+        const IO::Format& format,
+        const PropertyGroup* baseGroup,
+        const QJsonObject& overrides,
+        const PropertyValueConversion& conv,
+        QString* ptrError)
+{
+    if (overrides.isEmpty())
+        return {};
+
+    std::unique_ptr<PropertyGroup> ptrGroup = factory ? factory->createProperties(format, nullptr) : nullptr;
+    if (!ptrGroup) {
+        *ptrError = Main::tr("Format %1 has no parameters").arg(QString::fromUtf8(format.identifier));
+        return {};
+    }
+
+    if (baseGroup) {
+        for (Property* prop : ptrGroup->properties()) {
+            const Property* baseProp = findPropertyByKey(baseGroup, QString::fromUtf8(prop->name().key));
+            if (baseProp)
+                conv.fromVariant(prop, conv.toVariant(*baseProp));
+        }
+    }
+
+    for (auto it = overrides.begin(); it != overrides.end(); ++it) {
+        Property* prop = findPropertyByKey(ptrGroup.get(), it.key());
+        if (!prop) {
+            *ptrError = Main::tr("Unknown parameter '%1' for format %2")
+                    .arg(it.key(), QString::fromUtf8(format.identifier));
+            return {};
+        }
+
+        if (!conv.fromVariant(prop, it.value().toVariant())) {
+            *ptrError = Main::tr("Invalid value for parameter '%1'").arg(it.key());
+            return {};
+        }
+    }
+
+    return ptrGroup;
+}
+
+// Helper object shared by the asynchronous operations of the serve mode
+struct CliServeHelper : public QObject {
+    Application* app = nullptr;
+    CliConvertServices services;
+    std::function<void(int)> fnContinuation;
+    TaskManager taskMgr;
+    std::unordered_map<TaskId, std::unique_ptr<CliServeJob>> mapTaskJob;
+    std::thread threadStdin;
+    std::mutex mutexApp;
+    bool stdinClosed = false;
+
+    // Writes 'event' on standard output, only called from the main thread
+    void writeEvent(const QString& jobId, const char* eventName, QJsonObject event = {}) {
+        event.insert("id", jobId);
+        event.insert("event", QString::fromUtf8(eventName));
+        std::cout << QJsonDocument(event).toJson(QJsonDocument::Compact).toStdString() << std::endl;
+    }
+
+    void exitIfDone() {
+        if (!this->stdinClosed || !this->mapTaskJob.empty())
+            return;
+
+        if (this->threadStdin.joinable())
+            this->threadStdin.join();
+
+        this->deleteLater();
+        this->fnContinuation(EXIT_SUCCESS);
+    }
+
+    // Parses 'line' and submits the conversion job it describes
+    void submitJob(const std::string& line) {
+        QJsonParseError jsonError;
+        const QJsonDocument jsonDoc = QJsonDocument::fromJson(QByteArray::fromStdString(line), &jsonError);
+        const QJsonObject jsonJob = jsonDoc.object();
+        auto job = std::make_unique<CliServeJob>();
+        job->id = jsonJob.value("id").toString();
+        if (jsonError.error != QJsonParseError::NoError || !jsonDoc.isObject())
+            return this->writeEvent(job->id, "error", {{ "message", Main::tr("Invalid JSON object") }});
+
+        job->filepathInput = filepathFrom(jsonJob.value("input").toString());
+        for (const QJsonValue& jsonOutput : jsonJob.value("outputs").toArray())
+            job->vecFilepathOutput.push_back(filepathFrom(jsonOutput.toString()));
+
+        job->readerParameters = jsonJob.value("readerParameters").toObject();
+        job->writerParameters = jsonJob.value("writerParameters").toObject();
+        if (job->filepathInput.empty())
+            return this->writeEvent(job->id, "error", {{ "message", Main::tr("No input file") }});
+
+        if (job->vecFilepathOutput.empty())
+            return this->writeEvent(job->id, "error", {{ "message", Main::tr("No output files") }});
+
+        CliServeJob* ptrJob = job.get();
+        const TaskId taskId = this->taskMgr.newTask([=](TaskProgress* progress) {
+            this->runJob(ptrJob, progress);
+        });
+        this->taskMgr.setTimeLimit(taskId, this->services.taskTimeLimit);
+        this->taskMgr.setMemoryLimit(taskId, this->services.taskMemoryLimit);
+        this->mapTaskJob.insert({ taskId, std::move(job) });
+        this->taskMgr.run(taskId);
+    }
+
+    // Imports then exports the files of 'job', executed by a thread of the task manager pool
+    void runJob(CliServeJob* job, TaskProgress* progress) {
+        const PropertyValueConversion& conv = this->app->settings()->propertyValueConversion();
+        IO::System* ioSystem = this->app->ioSystem();
+        const IO::ParametersProvider* baseProvider = this->services.parametersProvider;
+        CliServeJobParametersProvider jobProvider;
+        jobProvider.baseProvider = baseProvider;
+
+        // Reader parameters overridden by the job
+        std::unique_ptr<PropertyGroup> ptrReaderGroup;
+        if (!job->readerParameters.isEmpty()) {
+            jobProvider.readerFormat = ioSystem->probeFormat(job->filepathInput);
+            ptrReaderGroup = createOverridenParameters(
+                        ioSystem->findFactoryReader(jobProvider.readerFormat),
+                        jobProvider.readerFormat,
+                        baseProvider ? baseProvider->findReaderParameters(jobProvider.readerFormat) : nullptr,
+                        job->readerParameters,
+                        conv,
+                        &job->message);
+            if (!ptrReaderGroup)
+                return;
+
+            jobProvider.readerGroup = ptrReaderGroup.get();
+        }
+
+        // Writer parameters overridden by the job
+        std::vector<IO::Format> vecOutputFormat;
+        std::vector<std::unique_ptr<PropertyGroup>> vecPtrWriterGroup;
+        bool brepMeshRequired = false;
+        for (const FilePath& fpOutput : job->vecFilepathOutput) {
+            const IO::Format format = ioSystem->probeFormat(fpOutput);
+            if (format == IO::Format_Unknown) {
+                job->message = Main::tr("No supported output format for '%1'").arg(filepathTo<QString>(fpOutput));
+                return;
+            }
+
+            const QJsonObject overrides = job->writerParameters.value(QString::fromUtf8(format.identifier)).toObject();
+            std::unique_ptr<PropertyGroup> ptrGroup = createOverridenParameters(
+                        ioSystem->findFactoryWriter(format),
+                        format,
+                        baseProvider ? baseProvider->findWriterParameters(format) : nullptr,
+                        overrides,
+                        conv,
+                        &job->message);
+            if (!overrides.isEmpty() && !ptrGroup)
+                return;
+
+            vecOutputFormat.push_back(format);
+            vecPtrWriterGroup.push_back(std::move(ptrGroup));
+            brepMeshRequired = brepMeshRequired || IO::formatProvidesMesh(format);
+        }
+
+        const JobArena::Scope arenaScope; // Scratch memory of the job is released at once
+        DocumentPtr doc;
+        {
+            std::lock_guard<std::mutex> lock(this->mutexApp); MAYO_UNUSED(lock);
+            doc = this->app->newDocument();
+            doc->setViewerOnly(true); // Imports are never undone by the CLI
+        }
+
+        CliErrorMessageCollect errorCollect;
+        const int exportCount = int(vecOutputFormat.size());
+        const CliConvertServices::FunctionComputeBRepMesh fnComputeBRepMesh = this->services.fnComputeBRepMesh;
+        bool ok = false;
+        {
+            TaskProgress importProgress(progress, 50, Main::tr("Importing"));
+            ok = ioSystem->importInDocument()
+                    .targetDocument(doc)
+                    .withFilepath(job->filepathInput)
+                    .withParametersProvider(&jobProvider)
+                    .withEntitiesPostProcess([=](auto spanFileEntities, TaskProgress* progress) {
+                        if (fnComputeBRepMesh)
+                            fnComputeBRepMesh(spanFileEntities, progress);
+                    })
+                    .withEntityPostProcessRequiredIf([=](const IO::Format&){ return brepMeshRequired; })
+                    .withEntityPostProcessInfoProgress(20, Main::tr("Mesh BRep shapes"))
+                    .withMessenger(&errorCollect)
+                    .withTaskProgress(&importProgress)
+                    .execute();
+        }
+
+        for (int i = 0; ok && i < exportCount; ++i) {
+            const IO::Format& format = vecOutputFormat.at(i);
+            const FilePath& fpOutput = job->vecFilepathOutput.at(i);
+            if (filepathEquivalent(fpOutput, job->filepathInput)) {
+                errorCollect.message = Main::tr("Output file %1 would overwrite input")
+                        .arg(filepathTo<QString>(fpOutput));
+                ok = false;
+                break; // Interrupt
+            }
+
+            const PropertyGroup* writerGroup = vecPtrWriterGroup.at(i).get();
+            if (!writerGroup)
+                writerGroup = jobProvider.findWriterParameters(format);
+
+            TaskProgress exportProgress(progress, 50 / exportCount, Main::tr("Exporting"));
+            const ApplicationItem appItems[] = { doc };
+            ok = ioSystem->exportApplicationItems()
+                    .targetFile(fpOutput)
+                    .targetFormat(format)
+                    .withItems(appItems)
+                    .withParameters(writerGroup)
+                    .withMessenger(&errorCollect)
+                    .withTaskProgress(&exportProgress)
+                    .execute();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutexApp); MAYO_UNUSED(lock);
+            this->app->closeDocument(doc);
+        }
+
+        const TaskLimit limit = this->taskMgr.limitExceeded(progress->taskId());
+        if (limit != TaskLimit::None) {
+            ok = false;
+            errorCollect.message = cli_taskLimitExceededMessage(limit);
+        }
+
+        job->success = ok;
+        job->message = ok ? Main::tr("Converted %1").arg(filepathTo<QString>(job->filepathInput.filename()))
+                          : errorCollect.message.trimmed();
+        // Task entity might be destroyed when signal TaskManager::ended() is received
+        const PerfStats* stats = this->taskMgr.perfStats(progress->taskId());
+        if (stats && !stats->isEmpty())
+            job->jsonPerfStats = QByteArray::fromStdString(stats->toJson());
+    }
+
+    void connectTaskEvents() {
+        QObject::connect(&this->taskMgr, &TaskManager::started, this, [=](TaskId taskId) {
+            auto it = this->mapTaskJob.find(taskId);
+            if (it != this->mapTaskJob.end())
+                this->writeEvent(it->second->id, "started");
+        });
+        QObject::connect(&this->taskMgr, &TaskManager::progressChanged, this, [=](TaskId taskId, int percent) {
+            auto it = this->mapTaskJob.find(taskId);
+            if (it != this->mapTaskJob.end())
+                this->writeEvent(it->second->id, "progress", {{ "progress", percent }});
+        });
+        QObject::connect(&this->taskMgr, &TaskManager::ended, this, [=](TaskId taskId) {
+            auto it = this->mapTaskJob.find(taskId);
+            if (it == this->mapTaskJob.end())
+                return;
+
+            const CliServeJob* job = it->second.get();
+            QJsonObject event{{ "success", job->success }, { "message", job->message }};
+            if (!job->jsonPerfStats.isEmpty())
+                event.insert("perfStats", QJsonDocument::fromJson(job->jsonPerfStats).object());
+
+            this->writeEvent(job->id, "finished", event);
+            this->mapTaskJob.erase(it);
+            this->exitIfDone();
+        });
+    }
+};
+
+} // namespace
+
+void cli_asyncServeConversionJobs(
+        Application* app, const CliConvertServices& services, std::function<void(int)> fnContinuation)
+{
+    auto helper = new CliServeHelper; // Allocated on heap because current function is asynchronous
+    helper->app = app;
+    helper->services = services;
+    helper->fnContinuation = std::move(fnContinuation);
+    if (services.taskPoolSize > 0)
+        helper->taskMgr.setPoolSize(services.taskPoolSize);
+
+    // Suppress output from OpenCascade, standard output is reserved to job events
+    Message::DefaultMessenger()->RemovePrinters(Message_Printer::get_type_descriptor());
+
+    helper->connectTaskEvents();
+
+    // Standard input is read by a dedicated thread(blocking reads), lines are processed in the main
+    // thread
+    helper->threadStdin = std::thread([=]{
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue; // Skip blank line
+
+            QMetaObject::invokeMethod(helper, [=]{ helper->submitJob(line); }, Qt::QueuedConnection);
+        }
+
+        QMetaObject::invokeMethod(helper, [=]{
+            helper->stdinClosed = true;
+            helper->exitIfDone();
+        }, Qt::QueuedConnection);
+    });
+}
+
+} // namespace Mayo
@@ -0,0 +1,30 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "cli_convert.h"
+
+namespace Mayo {
+
+// Asynchronously runs conversion jobs read from standard input, the application being initialized
+// only once for all jobs. Each line of input is a JSON object describing a job:
+//     {"id":"job1","input":"in.step","outputs":["out.glb","out.stl"],
+//      "readerParameters":{"key":value,...},"writerParameters":{"GLTF":{"key":value,...},...}}
+// "writerParameters" is keyed by format identifier. Parameter values have the same form as in
+// settings files and override the values provided by 'services'
+// Jobs are run concurrently by the bounded thread pool of a task manager(see
+// CliConvertServices::taskPoolSize). Events are written on standard output, one JSON object per line:
+//     {"id":"job1","event":"started"}
+//     {"id":"job1","event":"progress","progress":42}
+//     {"id":"job1","event":"finished","success":true,"message":"..."}
+// Invalid input lines are reported with {"id":"...","event":"error","message":"..."}
+// A job exceeding the resource limits of 'services' is aborted and reported as failed
+// Calls 'fnContinuation' when standard input is closed and all jobs are finished
+void cli_asyncServeConversionJobs(
+        Application* app, const CliConvertServices& services, std::function<void(int)> fnContinuation);
+
+} // namespace Mayo
@@ -16,11 +16,34 @@
 #else
 #  include <sys/ioctl.h> //ioctl() and TIOCGWINSZ
 #  include <unistd.h>    // for STDOUT_FILENO
-#  include <iostream>
 #endif
 
+#include <iostream>
+
 namespace Mayo {
 
+namespace {
+
+#if !defined(Q_OS_WIN) && !defined(__EMSCRIPTEN__)
+const char* ansiTextColorCode(ConsoleColor color, bool isBrightText)
+{
+    switch (color) {
+    case ConsoleColor::Black: return isBrightText ? "\e[30;1m" : "\e[30m";
+    case ConsoleColor::Red: return isBrightText ? "\e[31;1m" : "\e[31m";
+    case ConsoleColor::Green: return isBrightText ? "\e[32;1m" : "\e[32m";
+    case ConsoleColor::Yellow: return isBrightText ? "\e[33;1m" : "\e[33m";
+    case ConsoleColor::Blue: return isBrightText ? "\e[34;1m" : "\e[34m";
+    case ConsoleColor::Magenta: return isBrightText ? "\e[35;1m" : "\e[35m";
+    case ConsoleColor::Cyan: return isBrightText ? "\e[36;1m" : "\e[36m";
+    case ConsoleColor::White: return isBrightText ? "\e[37;1m" : "\e[37m";
+    case ConsoleColor::Default:
+    default: return "\e[0m";
+    }
+}
+#endif
+
+} // namespace
+
 void consoleSetTextColor(ConsoleColor color)
 {
     constexpr bool isBrightText = true;
@@ -54,21 +77,7 @@ void consoleSetTextColor(ConsoleColor color)
     MAYO_UNUSED(color);
     MAYO_UNUSED(isBrightText);
 #else
-    auto fnCode = [](ConsoleColor color, bool isBrightText) {
-        switch (color) {
-        case ConsoleColor::Black: return isBrightText ? "\e[30;1m" : "\e[30m";
-        case ConsoleColor::Red: return isBrightText ? "\e[31;1m" : "\e[31m";
-        case ConsoleColor::Green: return isBrightText ? "\e[32;1m" : "\e[32m";
-        case ConsoleColor::Yellow: return isBrightText ? "\e[33;1m" : "\e[33m";
-        case ConsoleColor::Blue: return isBrightText ? "\e[34;1m" : "\e[34m";
-        case ConsoleColor::Magenta: return isBrightText ? "\e[35;1m" : "\e[35m";
-        case ConsoleColor::Cyan: return isBrightText ? "\e[36;1m" : "\e[36m";
-        case ConsoleColor::White: return isBrightText ? "\e[37;1m" : "\e[37m";
-        case ConsoleColor::Default:
-        default: return "\e[0m";
-        }
-    };
-    std::cout << fnCode(color, isBrightText);
+    std::cout << ansiTextColorCode(color, isBrightText);
 #endif
 }
 
@@ -152,4 +161,37 @@ std::string consoleToPrintable(const QString& str)
 #endif
 }
 
+void ConsoleOutputBuffer::setTextColor(ConsoleColor color)
+{
+#if defined(Q_OS_WIN) || defined(__EMSCRIPTEN__)
+    this->flush();
+    consoleSetTextColor(color);
+#else
+    m_buffer += ansiTextColorCode(color, true);
+#endif
+}
+
+void ConsoleOutputBuffer::cursorMoveUp(int lines)
+{
+    if (lines == 0)
+        return;
+
+#ifdef Q_OS_WIN
+    this->flush();
+    consoleCursorMoveUp(lines);
+#else
+    m_buffer += "\033[" + std::to_string(lines) + "A";
+#endif
+}
+
+void ConsoleOutputBuffer::flush()
+{
+    if (m_buffer.empty())
+        return;
+
+    std::cout.write(m_buffer.data(), m_buffer.size());
+    std::cout.flush();
+    m_buffer.clear();
+}
+
 } // namespace Mayo
@@ -8,6 +8,7 @@
 
 #include <QtCore/QString>
 #include <string>
+#include <string_view>
 #include <utility>
 
 namespace Mayo {
@@ -38,4 +39,22 @@ void consoleSendEnterKey();
 // Returns 'str' converted to a "guaranteed" printable string
 std::string consoleToPrintable(const QString& str);
 
+// Console output accumulated in memory then written on standard output with a single write
+// Text color and cursor movements are escape sequences embedded in the buffer, except on Windows
+// where they require console API calls(pending text is then written first)
+class ConsoleOutputBuffer {
+public:
+    ~ConsoleOutputBuffer() { this->flush(); }
+
+    void append(std::string_view text) { m_buffer += text; }
+    void append(int count, char c) { m_buffer.append(count, c); }
+    void setTextColor(ConsoleColor color);
+    void cursorMoveUp(int lines);
+
+    void flush();
+
+private:
+    std::string m_buffer;
+};
+
 } // namespace Mayo
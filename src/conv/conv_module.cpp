@@ -0,0 +1,157 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "conv_module.h"
+#include "../base/application.h"
+#include "../base/brep_mesh_budget.h"
+#include "../base/brep_utils.h"
+#include "../base/global.h"
+#include "../base/io_reader.h"
+#include "../base/io_writer.h"
+#include "../base/settings.h"
+#include "../base/xcaf.h"
+
+namespace Mayo {
+
+ConvModule::ConvModule(Application* app)
+    : groupId_system(app->settings()->addGroup(QByteArrayLiteral("system"))),
+      groupId_meshing(app->settings()->addGroup(QByteArrayLiteral("meshing"))),
+      m_app(app)
+{
+    Settings* settings = app->settings();
+
+    // System
+    settings->addSetting(&this->taskPoolSize, this->groupId_system);
+    this->taskPoolSize.setRange(0, 1024);
+    this->taskPoolSize.setConstraintsEnabled(true);
+
+    // Meshing
+    settings->addSetting(&this->meshingQuality, this->groupId_meshing);
+    settings->addSetting(&this->meshingChordalDeflection, this->groupId_meshing);
+    settings->addSetting(&this->meshingAngularDeflection, this->groupId_meshing);
+    settings->addSetting(&this->meshingRelative, this->groupId_meshing);
+    settings->addSetting(&this->meshingTriangleBudget, this->groupId_meshing);
+    this->meshingTriangleBudget.setRange(10, 1000 * 1000);
+    this->meshingTriangleBudget.setConstraintsEnabled(true);
+
+    // Import/export parameters are created on first use, see findFormatParameters()
+    auto groupId_Import = settings->addGroup(QByteArrayLiteral("import"));
+    for (const IO::Format& format : app->ioSystem()->readerFormats()) {
+        auto sectionId_format = settings->addSection(groupId_Import, format.identifier);
+        m_mapFormatReaderParameters.insert({ format.identifier, { sectionId_format } });
+    }
+
+    auto groupId_Export = settings->addGroup(QByteArrayLiteral("export"));
+    for (const IO::Format& format : app->ioSystem()->writerFormats()) {
+        auto sectionId_format = settings->addSection(groupId_Export, format.identifier);
+        m_mapFormatWriterParameters.insert({ format.identifier, { sectionId_format } });
+    }
+
+    // Register reset functions
+    settings->addResetFunction(this->groupId_system, [=]{
+        this->taskPoolSize.setValue(0);
+    });
+    settings->addResetFunction(this->groupId_meshing, [=]{
+        this->meshingQuality.setValue(BRepMeshQuality::Normal);
+        this->meshingChordalDeflection.setQuantity(1 * Quantity_Millimeter);
+        this->meshingAngularDeflection.setQuantity(20 * Quantity_Degree);
+        this->meshingRelative.setValue(false);
+        this->meshingTriangleBudget.setValue(2000);
+    });
+}
+
+const PropertyGroup* ConvModule::findReaderParameters(const IO::Format& format) const
+{
+    return this->findFormatParameters(format, FormatParametersType::Reader);
+}
+
+const PropertyGroup* ConvModule::findWriterParameters(const IO::Format& format) const
+{
+    return this->findFormatParameters(format, FormatParametersType::Writer);
+}
+
+OccBRepMeshParameters ConvModule::brepMeshParameters(const TopoDS_Shape& shape) const
+{
+    if (this->meshingQuality == BRepMeshQuality::UserDefined) {
+        OccBRepMeshParameters params = brepMeshBaseParameters();
+        params.Deflection = UnitSystem::meters(this->meshingChordalDeflection.quantity());
+        params.Angle = UnitSystem::radians(this->meshingAngularDeflection.quantity());
+        params.Relative = this->meshingRelative;
+        return params;
+    }
+    else {
+        return brepMeshQualityParameters(shape, this->meshingQuality);
+    }
+}
+
+void ConvModule::computeBRepMesh(
+        Span<const IO::System::ImportedFileEntities> spanFileEntities, TaskProgress* progress)
+{
+    std::vector<TopoDS_Shape> vecShape;
+    std::vector<OccBRepMeshParameters> vecParams;
+    for (const IO::System::ImportedFileEntities& fileEntities : spanFileEntities) {
+        for (const TDF_Label& labelEntity : fileEntities.seqEntity) {
+            if (!XCaf::isShape(labelEntity))
+                continue;
+
+            const TopoDS_Shape shape = XCaf::shape(labelEntity);
+            vecShape.push_back(shape);
+            vecParams.push_back(this->brepMeshParameters(shape));
+        }
+    }
+
+    if (this->meshingQuality == BRepMeshQuality::TriangleBudget) {
+        BRepMeshBudget::Parameters budgetParams;
+        budgetParams.triangleCount = int64_t(this->meshingTriangleBudget.value()) * 1000;
+        BRepMeshBudget::computeMesh(vecShape, budgetParams, progress);
+        return;
+    }
+
+    const std::vector<BRepUtils::MeshJob> vecJob = BRepUtils::createMeshJobs(vecShape, vecParams);
+    BRepUtils::computeMesh(vecJob, progress);
+}
+
+PropertyGroup* ConvModule::findFormatParameters(const IO::Format& format, FormatParametersType type) const
+{
+    // Might be called concurrently by import/export tasks
+    std::lock_guard<std::mutex> lock(m_mutexFormatParameters); MAYO_UNUSED(lock);
+    auto& mapFormatParameters =
+            type == FormatParametersType::Reader ? m_mapFormatReaderParameters : m_mapFormatWriterParameters;
+    auto it = mapFormatParameters.find(format.identifier);
+    if (it == mapFormatParameters.end())
+        return nullptr;
+
+    FormatParameters& params = it->second;
+    if (params.isCreated)
+        return params.ptrGroup;
+
+    // Values loaded from settings file are applied by Settings::addSetting()
+    params.isCreated = true;
+    Settings* settings = m_app->settings();
+    std::unique_ptr<PropertyGroup> ptrGroup;
+    if (type == FormatParametersType::Reader) {
+        const IO::FactoryReader* factory = m_app->ioSystem()->findFactoryReader(format);
+        ptrGroup = factory ? factory->createProperties(format, settings) : nullptr;
+    }
+    else {
+        const IO::FactoryWriter* factory = m_app->ioSystem()->findFactoryWriter(format);
+        ptrGroup = factory ? factory->createProperties(format, settings) : nullptr;
+    }
+
+    if (ptrGroup) {
+        for (Property* property : ptrGroup->properties())
+            settings->addSetting(property, params.sectionId);
+
+        PropertyGroup* rawPtrGroup = ptrGroup.get();
+        settings->addResetFunction(params.sectionId, [=]{ rawPtrGroup->restoreDefaults(); });
+        params.ptrGroup = rawPtrGroup;
+        m_vecPtrPropertyGroup.push_back(std::move(ptrGroup));
+    }
+
+    return params.ptrGroup;
+}
+
+} // namespace Mayo
@@ -0,0 +1,75 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/application_ptr.h"
+#include "../base/brep_mesh_quality.h"
+#include "../base/io_parameters_provider.h"
+#include "../base/io_system.h"
+#include "../base/property.h"
+#include "../base/property_builtins.h"
+#include "../base/property_enumeration.h"
+#include "../base/qtcore_hfuncs.h"
+#include "../base/settings_index.h"
+#include "../base/unit_system.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class TopoDS_Shape;
+
+namespace Mayo {
+
+class TaskProgress;
+
+// Module of the mayo-conv executable, lean counterpart of Mayo's AppModule
+// Only settings relevant to file conversion are registered, keys are the same as in Mayo so a
+// settings file exported from Mayo can be used as is
+class ConvModule : public PropertyGroup, public IO::ParametersProvider {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::ConvModule)
+public:
+    ConvModule(Application* app);
+
+    // from IO::ParametersProvider
+    // Parameters are created on first use, so settings are only built for the formats involved
+    const PropertyGroup* findReaderParameters(const IO::Format& format) const override;
+    const PropertyGroup* findWriterParameters(const IO::Format& format) const override;
+
+    OccBRepMeshParameters brepMeshParameters(const TopoDS_Shape& shape) const;
+    void computeBRepMesh(Span<const IO::System::ImportedFileEntities> spanFileEntities, TaskProgress* progress);
+
+    // System
+    const Settings_GroupIndex groupId_system;
+    PropertyInt taskPoolSize{ this, textId("taskPoolSize") };
+    // Meshing
+    const Settings_GroupIndex groupId_meshing;
+    PropertyEnum<BRepMeshQuality> meshingQuality{ this, textId("meshingQuality") };
+    PropertyLength meshingChordalDeflection{ this, textId("meshingChordalDeflection") };
+    PropertyAngle meshingAngularDeflection{ this, textId("meshingAngularDeflection") };
+    PropertyBool meshingRelative{ this, textId("meshingRelative") };
+    PropertyInt meshingTriangleBudget{ this, textId("meshingTriangleBudget") }; // In thousands of triangles
+
+private:
+    enum class FormatParametersType { Reader, Writer };
+    PropertyGroup* findFormatParameters(const IO::Format& format, FormatParametersType type) const;
+
+    struct FormatParameters {
+        Settings_SectionIndex sectionId;
+        PropertyGroup* ptrGroup = nullptr;
+        bool isCreated = false;
+    };
+
+    Application* m_app = nullptr;
+    mutable std::mutex m_mutexFormatParameters;
+    mutable std::unordered_map<QByteArray, FormatParameters> m_mapFormatReaderParameters;
+    mutable std::unordered_map<QByteArray, FormatParameters> m_mapFormatWriterParameters;
+    mutable std::vector<std::unique_ptr<PropertyGroup>> m_vecPtrPropertyGroup;
+};
+
+} // namespace Mayo
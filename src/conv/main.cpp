@@ -0,0 +1,145 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+// Entry point of mayo-conv, the headless file converter
+// Only QtCore is initialized: no GUI, no OpenGL, no theme and no translation files, so it can run
+// on nodes without display and starts faster than Mayo in CLI mode
+
+#include "../base/application.h"
+#include "../base/filepath.h"
+#include "../base/io_system.h"
+#include "../base/settings.h"
+#include "../cli/cli_convert.h"
+#include "../cli/cli_options.h"
+#include "../cli/cli_process_pool.h"
+#include "../cli/cli_serve.h"
+#include "../io_3mf/io_3mf.h"
+#include "../io_gmio/io_gmio.h"
+#include "../io_occ/io_occ.h"
+#include "../io_ply/io_ply.h"
+#include "../io_point_cloud/io_point_cloud.h"
+#include "conv_module.h"
+#include "version.h"
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QSettings>
+#include <QtCore/QTimer>
+
+#include <memory>
+
+namespace Mayo {
+
+class Conv { Q_DECLARE_TR_FUNCTIONS(Mayo::Conv) };
+
+static CliCommandLineArguments processCommandLine()
+{
+    // Configure command-line parser
+    QCommandLineParser cmdParser;
+    cmdParser.setApplicationDescription(
+                Conv::tr("mayo-conv, headless 3D file converter based on OpenCascade"));
+    cmdParser.addHelpOption();
+    cmdParser.addVersionOption();
+
+    const CliOptions cliOptions;
+    cliOptions.addTo(&cmdParser);
+
+    cmdParser.addPositionalArgument(
+                Conv::tr("files"),
+                Conv::tr("Input files to convert"),
+                Conv::tr("files..."));
+
+    cmdParser.process(QCoreApplication::arguments());
+    return cliOptions.parse(cmdParser);
+}
+
+// Initializes and runs the converter
+static int runConv(QCoreApplication* qtApp)
+{
+    const CliCommandLineArguments args = processCommandLine();
+    if (!args.serveMode) {
+        if (args.convert.listFilepathToOpen.empty())
+            cli_criticalExit(Conv::tr("No input files -> nothing to convert"));
+
+        if (args.batchMode && args.convert.listBatchTargetSuffix.empty())
+            cli_criticalExit(Conv::tr("No output formats specified with --to"));
+
+        if (!args.batchMode && args.convert.listFilepathToExport.empty())
+            cli_criticalExit(Conv::tr("No output files specified with --export"));
+    }
+
+    // Initialize Base application, only the I/O system is required
+    Application::setOpenCascadeEnvironment("opencascade.conf");
+    auto app = Application::instance().get();
+    // gmio factories first so they take precedence for STL, see GmioStlReader/GmioStlWriter
+    app->ioSystem()->addFactoryReader(IO::GmioFactoryReader::create());
+    app->ioSystem()->addFactoryWriter(IO::GmioFactoryWriter::create());
+    app->ioSystem()->addFactoryReader(std::make_unique<IO::OccFactoryReader>());
+    app->ioSystem()->addFactoryWriter(std::make_unique<IO::OccFactoryWriter>());
+    app->ioSystem()->addFactoryReader(std::make_unique<IO::PlyFactoryReader>());
+    app->ioSystem()->addFactoryWriter(std::make_unique<IO::PlyFactoryWriter>());
+    app->ioSystem()->addFactoryReader(std::make_unique<IO::PointCloudFactoryReader>());
+    app->ioSystem()->addFactoryWriter(IO::ThreeMfFactoryWriter::create());
+    IO::addPredefinedFormatProbes(app->ioSystem());
+    // Initialize OpenCascade translators in background, so the first import/export is faster
+    const IO::Format arrayWarmUpFormat[] = { IO::Format_STEP, IO::Format_IGES };
+    app->ioSystem()->warmUpAsync(arrayWarmUpFormat);
+
+    // Settings are only loaded from the file provided with --settings, values of import/export
+    // parameters are kept pending until their format is used
+    auto convModule = new ConvModule(app);
+    app->settings()->resetAll();
+    if (!args.filepathSettings.empty()) {
+        const QString strFilepathSettings = filepathTo<QString>(args.filepathSettings);
+        if (!filepathIsRegularFile(args.filepathSettings))
+            cli_criticalExit(Conv::tr("Failed to load settings file '%1'").arg(strFilepathSettings));
+
+        QSettings fileSettings(strFilepathSettings, QSettings::IniFormat);
+        app->settings()->loadFrom(fileSettings);
+    }
+
+    // Overrides are applied after loading, values of import/export parameters are kept pending
+    cli_applySettingOverrides(app->settings(), args.listSettingOverride);
+    const CliInstrumentationScope instrumentationScope(args);
+
+    CliConvertServices cliServices;
+    cliServices.parametersProvider = convModule;
+    cliServices.fnComputeBRepMesh = [=](auto spanFileEntities, TaskProgress* progress) {
+        convModule->computeBRepMesh(spanFileEntities, progress);
+    };
+    cliServices.taskPoolSize = convModule->taskPoolSize;
+    cliServices.taskTimeLimit = args.taskTimeLimit;
+    cliServices.taskMemoryLimit = args.taskMemoryLimit;
+    const CliProcessPoolOptions& poolOptions = args.processPool;
+
+    QTimer::singleShot(0, qtApp, [=]{
+        auto fnContinuation = [=](int retcode) { qtApp->exit(retcode); };
+        if (args.serveMode && poolOptions.workerCount > 0)
+            cli_asyncServeConversionJobsInProcessPool(poolOptions, fnContinuation);
+        else if (args.serveMode)
+            cli_asyncServeConversionJobs(app, cliServices, fnContinuation);
+        else if (args.batchMode && poolOptions.workerCount > 0)
+            cli_asyncBatchConvertDocumentsInProcessPool(app, args.convert, poolOptions, fnContinuation);
+        else if (args.batchMode)
+            cli_asyncBatchConvertDocuments(app, args.convert, cliServices, fnContinuation);
+        else
+            cli_asyncExportDocuments(app, args.convert, cliServices, fnContinuation);
+    });
+    return qtApp->exec();
+}
+
+} // namespace Mayo
+
+int main(int argc, char* argv[])
+{
+    qInstallMessageHandler(&Mayo::cli_qtMessageHandler);
+    QCoreApplication qtApp(argc, argv);
+    QCoreApplication::setOrganizationName("Fougue Ltd");
+    QCoreApplication::setOrganizationDomain("www.fougue.pro");
+    QCoreApplication::setApplicationName("mayo-conv");
+    QCoreApplication::setApplicationVersion(QString::fromUtf8(Mayo::strVersion));
+    return Mayo::runConv(&qtApp);
+}
@@ -0,0 +1,405 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "graphics_batched_object.h"
+
+#include "../base/brep_utils.h"
+#include "../base/cpp_utils.h"
+#include "../base/mesh_utils.h"
+
+#include <AIS_InteractiveContext.hxx>
+#include <BRep_Tool.hxx>
+#include <Graphic3d_AspectFillArea3d.hxx>
+#include <Graphic3d_Group.hxx>
+#include <Select3D_SensitivePrimitiveArray.hxx>
+#include <SelectMgr_EntityOwner.hxx>
+#include <TopoDS.hxx>
+#include <gp_Vec.hxx>
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+#  include <TShort_Array1OfShortReal.hxx>
+#endif
+#include <algorithm>
+#include <cstring>
+
+namespace Mayo {
+
+namespace {
+
+Graphic3d_Vec3 toVec3(const gp_XYZ& coords)
+{
+    return Graphic3d_Vec3(float(coords.X()), float(coords.Y()), float(coords.Z()));
+}
+
+gp_XYZ nodeNormal(const Poly_Triangulation& triangulation, int nodeId)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    gp_Vec3f normal;
+    triangulation.Normal(nodeId, normal);
+    return gp_XYZ(normal.x(), normal.y(), normal.z());
+#else
+    const TShort_Array1OfShortReal& vecNormal = triangulation.Normals();
+    const int i = (nodeId - 1) * 3 + vecNormal.Lower();
+    return gp_XYZ(vecNormal.Value(i), vecNormal.Value(i + 1), vecNormal.Value(i + 2));
+#endif
+}
+
+} // namespace
+
+class GraphicsBatchedObject::MemberOwner : public SelectMgr_EntityOwner {
+public:
+    MemberOwner(const Handle_SelectMgr_SelectableObject& batch, int partIndex)
+        : SelectMgr_EntityOwner(batch),
+          m_partIndex(partIndex)
+    {}
+
+    int partIndex() const { return m_partIndex; }
+
+    DEFINE_STANDARD_RTTI_INLINE(GraphicsBatchedObject::MemberOwner, SelectMgr_EntityOwner)
+
+private:
+    int m_partIndex = -1;
+};
+
+GraphicsBatchedObject::GraphicsBatchedObject(const Quantity_Color& color)
+    : m_color(color)
+{
+    this->SetDisplayMode(AIS_Shaded);
+    this->SetAutoHilight(false);
+}
+
+GraphicsObjectPtr GraphicsBatchedObject::addMember(const TopoDS_Shape& shape, const TopLoc_Location& loc)
+{
+    opencascade::handle<Member> member = new Member(this, shape);
+    member->m_partIndex = int(m_vecPart.size());
+    Part part;
+    part.member = member;
+    part.owner = new MemberOwner(this, member->m_partIndex);
+    part.shape = shape.Moved(loc);
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        TopLoc_Location locFace;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, locFace);
+        if (triangulation)
+            m_triangleCount += triangulation->NbTriangles();
+    });
+
+    m_vecPart.push_back(std::move(part));
+    return member;
+}
+
+GraphicsObjectPtr GraphicsBatchedObject::member(int i) const
+{
+    return m_vecPart.at(i).member;
+}
+
+void GraphicsBatchedObject::prepare()
+{
+    // Ranges of the parts are computed first, so the parts can then be filled concurrently
+    struct PartFace {
+        Handle_Poly_Triangulation triangulation;
+        gp_Trsf trsf;
+        bool isReversed;
+    };
+    std::vector<std::vector<PartFace>> vecPartFaces(m_vecPart.size());
+    int vertexCount = 0;
+    int indexCount = 0;
+    for (size_t i = 0; i < m_vecPart.size(); ++i) {
+        Part& part = m_vecPart.at(i);
+        part.vertexFirst = vertexCount;
+        part.indexFirst = indexCount;
+        BRepUtils::forEachSubFace(part.shape, [&](const TopoDS_Face& face) {
+            TopLoc_Location locFace;
+            const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, locFace);
+            if (!triangulation || triangulation->NbTriangles() <= 0)
+                return;
+
+            const bool isReversed = face.Orientation() == TopAbs_REVERSED;
+            vecPartFaces.at(i).push_back({ triangulation, locFace.Transformation(), isReversed });
+            vertexCount += triangulation->NbNodes();
+            indexCount += 3 * triangulation->NbTriangles();
+        });
+        part.vertexCount = vertexCount - part.vertexFirst;
+        part.indexCount = indexCount - part.indexFirst;
+    }
+
+    m_triangles.Nullify();
+    if (indexCount <= 0)
+        return;
+
+    Handle_Graphic3d_ArrayOfTriangles triangles = new Graphic3d_ArrayOfTriangles(vertexCount, indexCount, true);
+    Graphic3d_Buffer* attribs = triangles->Attributes().get();
+    attribs->NbElements = vertexCount;
+    const size_t normalOffset = attribs->AttributeOffset(1);
+    Graphic3d_IndexBuffer* indices = triangles->Indices().get();
+    indices->NbElements = indexCount;
+    CppUtils::parallelFor(int(m_vecPart.size()), [&](int i) {
+        const Part& part = m_vecPart.at(i);
+        int iVertex = part.vertexFirst;
+        int iIndex = part.indexFirst;
+        for (const PartFace& partFace : vecPartFaces.at(i)) {
+            const Poly_Triangulation& triangulation = *partFace.triangulation;
+            // Normals are computed by the presentation of the shapes if missing, do it locally
+            // as triangulations can be shared with other objects
+            MeshUtils::VectorArrays vecNodeNormal;
+            if (!triangulation.HasNormals())
+                vecNodeNormal = MeshUtils::nodeNormals(partFace.triangulation);
+
+            const double normalSign = partFace.isReversed ? -1. : 1.;
+            for (int n = 1; n <= triangulation.NbNodes(); ++n) {
+                const int iNodeVertex = iVertex + n - 1;
+                const gp_Pnt pnt = triangulation.Node(n).Transformed(partFace.trsf);
+                attribs->ChangeValue<Graphic3d_Vec3>(iNodeVertex) = toVec3(pnt.XYZ());
+                gp_Vec normal = triangulation.HasNormals() ?
+                            gp_Vec(nodeNormal(triangulation, n)) :
+                            gp_Vec(vecNodeNormal.x[n - 1], vecNodeNormal.y[n - 1], vecNodeNormal.z[n - 1]);
+                normal.Transform(partFace.trsf);
+                const double normalLength = normal.Magnitude();
+                if (normalLength > 0.)
+                    normal *= normalSign / normalLength;
+
+                *reinterpret_cast<Graphic3d_Vec3*>(attribs->changeValue(iNodeVertex) + normalOffset) =
+                        toVec3(normal.XYZ());
+            }
+
+            for (int t = 1; t <= triangulation.NbTriangles(); ++t) {
+                int n1, n2, n3;
+                triangulation.Triangle(t).Get(n1, n2, n3);
+                if (partFace.isReversed)
+                    std::swap(n2, n3);
+
+                indices->SetIndex(iIndex++, iVertex + n1 - 1);
+                indices->SetIndex(iIndex++, iVertex + n2 - 1);
+                indices->SetIndex(iIndex++, iVertex + n3 - 1);
+            }
+
+            iVertex += triangulation.NbNodes();
+        }
+    });
+
+    m_triangles = triangles;
+}
+
+bool GraphicsBatchedObject::isMemberVisible(const GraphicsObjectPtr& member) const
+{
+    const int index = this->partIndex(member);
+    return index >= 0 ? m_vecPart.at(index).isVisible : false;
+}
+
+void GraphicsBatchedObject::setMemberVisible(const GraphicsObjectPtr& member, bool on)
+{
+    const int index = this->partIndex(member);
+    if (index >= 0 && m_vecPart.at(index).isVisible != on) {
+        m_vecPart.at(index).isVisible = on;
+        m_isMembersVisibilityChanged = true;
+    }
+}
+
+void GraphicsBatchedObject::updateMembersVisibility()
+{
+    if (!m_isMembersVisibilityChanged)
+        return;
+
+    m_isMembersVisibilityChanged = false;
+    const Handle_AIS_InteractiveContext context = this->GetContext();
+    if (context)
+        context->Redisplay(this, false);
+}
+
+GraphicsBatchedObject* GraphicsBatchedObject::fromMember(const GraphicsObjectPtr& object)
+{
+    auto member = opencascade::handle<Member>::DownCast(object);
+    return member ? member->batch() : nullptr;
+}
+
+GraphicsObjectPtr GraphicsBatchedObject::memberFromOwner(const GraphicsOwnerPtr& owner)
+{
+    auto memberOwner = opencascade::handle<MemberOwner>::DownCast(owner);
+    if (!memberOwner)
+        return {};
+
+    auto batch = static_cast<const GraphicsBatchedObject*>(memberOwner->Selectable().get());
+    return batch ? batch->member(memberOwner->partIndex()) : GraphicsObjectPtr();
+}
+
+bool GraphicsBatchedObject::AcceptDisplayMode(const int mode) const
+{
+    return mode == AIS_Shaded;
+}
+
+void GraphicsBatchedObject::ComputeSelection(const opencascade::handle<SelectMgr_Selection>& sel, const int mode)
+{
+    if (mode != 0 || !m_triangles)
+        return;
+
+    // One sensitive entity per member over its range of the merged buffers, no data is copied
+    for (const Part& part : m_vecPart) {
+        if (!part.isVisible || part.indexCount <= 0)
+            continue;
+
+        opencascade::handle<Select3D_SensitivePrimitiveArray> sensitive =
+                new Select3D_SensitivePrimitiveArray(part.owner);
+        const bool ok = sensitive->InitTriangulation(
+                    m_triangles->Attributes(),
+                    m_triangles->Indices(),
+                    TopLoc_Location(),
+                    part.indexFirst,
+                    part.indexFirst + part.indexCount - 1);
+        if (ok)
+            sel->Add(sensitive);
+    }
+}
+
+void GraphicsBatchedObject::HilightSelected(
+        const opencascade::handle<PrsMgr_PresentationManager3d>& prsMgr,
+        const SelectMgr_SequenceOfOwner& seqOwner)
+{
+    std::vector<int> vecPartIndex;
+    for (const Handle_SelectMgr_EntityOwner& owner : seqOwner) {
+        auto memberOwner = opencascade::handle<MemberOwner>::DownCast(owner);
+        if (memberOwner && memberOwner->Selectable() == this)
+            vecPartIndex.push_back(memberOwner->partIndex());
+    }
+
+    std::sort(vecPartIndex.begin(), vecPartIndex.end());
+    const Handle_AIS_InteractiveContext context = this->GetContext();
+    const opencascade::handle<Prs3d_Drawer> style =
+            this->HilightAttributes() ? this->HilightAttributes() :
+                                        (context ? context->SelectionStyle() : opencascade::handle<Prs3d_Drawer>());
+    this->displayHighlight(prsMgr, this->GetSelectPresentation(prsMgr), style, vecPartIndex);
+}
+
+void GraphicsBatchedObject::HilightOwnerWithColor(
+        const opencascade::handle<PrsMgr_PresentationManager3d>& prsMgr,
+        const opencascade::handle<Prs3d_Drawer>& style,
+        const opencascade::handle<SelectMgr_EntityOwner>& owner)
+{
+    auto memberOwner = opencascade::handle<MemberOwner>::DownCast(owner);
+    if (!memberOwner)
+        return;
+
+    this->displayHighlight(prsMgr, this->GetHilightPresentation(prsMgr), style, { memberOwner->partIndex() });
+}
+
+void GraphicsBatchedObject::Compute(
+        const opencascade::handle<PrsMgr_PresentationManager3d>&,
+        const opencascade::handle<Prs3d_Presentation>& prs,
+        const int mode)
+{
+    if (mode != AIS_Shaded || !m_triangles)
+        return;
+
+    std::vector<int> vecVisiblePartIndex;
+    for (int i = 0; i < int(m_vecPart.size()); ++i) {
+        if (m_vecPart.at(i).isVisible)
+            vecVisiblePartIndex.push_back(i);
+    }
+
+    // Merged buffers are used as is while all the members are visible
+    const Handle_Graphic3d_ArrayOfTriangles triangles =
+            vecVisiblePartIndex.size() == m_vecPart.size() ?
+                m_triangles :
+                this->createPartTriangles(vecVisiblePartIndex);
+    if (!triangles)
+        return;
+
+    const Graphic3d_MaterialAspect material(Graphic3d_NOM_PLASTIC);
+    opencascade::handle<Graphic3d_AspectFillArea3d> aspect = new Graphic3d_AspectFillArea3d(
+                Aspect_IS_SOLID, m_color, m_color, Aspect_TOL_SOLID, 1., material, material);
+    aspect->SetEdgeOff();
+    opencascade::handle<Graphic3d_Group> group = prs->NewGroup();
+    group->SetGroupPrimitivesAspect(aspect);
+    group->AddPrimitiveArray(triangles);
+}
+
+int GraphicsBatchedObject::partIndex(const GraphicsObjectPtr& member) const
+{
+    auto batchMember = opencascade::handle<Member>::DownCast(member);
+    if (!batchMember || batchMember->batch() != this)
+        return -1;
+
+    return batchMember->m_partIndex;
+}
+
+Handle_Graphic3d_ArrayOfTriangles GraphicsBatchedObject::createPartTriangles(
+        const std::vector<int>& vecPartIndex) const
+{
+    if (!m_triangles)
+        return {};
+
+    int vertexCount = 0;
+    int indexCount = 0;
+    for (int iPart : vecPartIndex) {
+        vertexCount += m_vecPart.at(iPart).vertexCount;
+        indexCount += m_vecPart.at(iPart).indexCount;
+    }
+
+    if (indexCount <= 0)
+        return {};
+
+    // Vertex layout is the same as the merged buffer, vertices of a part are copied at once
+    Handle_Graphic3d_ArrayOfTriangles triangles = new Graphic3d_ArrayOfTriangles(vertexCount, indexCount, true);
+    const Graphic3d_Buffer* srcAttribs = m_triangles->Attributes().get();
+    const Graphic3d_IndexBuffer* srcIndices = m_triangles->Indices().get();
+    Graphic3d_Buffer* attribs = triangles->Attributes().get();
+    Graphic3d_IndexBuffer* indices = triangles->Indices().get();
+    attribs->NbElements = vertexCount;
+    indices->NbElements = indexCount;
+    int iVertex = 0;
+    int iIndex = 0;
+    for (int iPart : vecPartIndex) {
+        const Part& part = m_vecPart.at(iPart);
+        std::memcpy(attribs->changeValue(iVertex),
+                    srcAttribs->value(part.vertexFirst),
+                    size_t(part.vertexCount) * srcAttribs->Stride);
+        const int vertexShift = iVertex - part.vertexFirst;
+        for (int i = 0; i < part.indexCount; ++i)
+            indices->SetIndex(iIndex++, srcIndices->Index(part.indexFirst + i) + vertexShift);
+
+        iVertex += part.vertexCount;
+    }
+
+    return triangles;
+}
+
+void GraphicsBatchedObject::displayHighlight(
+        const opencascade::handle<PrsMgr_PresentationManager3d>& prsMgr,
+        const opencascade::handle<Prs3d_Presentation>& prs,
+        const opencascade::handle<Prs3d_Drawer>& style,
+        const std::vector<int>& vecPartIndex)
+{
+    if (!prs || !style)
+        return;
+
+    prs->Clear();
+    const Handle_Graphic3d_ArrayOfTriangles triangles = this->createPartTriangles(vecPartIndex);
+    if (!triangles)
+        return;
+
+    const Graphic3d_MaterialAspect material(Graphic3d_NOM_PLASTIC);
+    opencascade::handle<Graphic3d_AspectFillArea3d> aspect = new Graphic3d_AspectFillArea3d(
+                Aspect_IS_SOLID, style->Color(), style->Color(), Aspect_TOL_SOLID, 1., material, material);
+    aspect->SetEdgeOff();
+    opencascade::handle<Graphic3d_Group> group = prs->NewGroup();
+    group->SetGroupPrimitivesAspect(aspect);
+    group->AddPrimitiveArray(triangles);
+    prs->SetZLayer(style->ZLayer() != Graphic3d_ZLayerId_UNKNOWN ? style->ZLayer() : this->ZLayer());
+    if (prsMgr->IsImmediateModeOn())
+        prsMgr->AddToImmediateList(prs);
+    else
+        prs->Display();
+}
+
+GraphicsBatchedObject::Member::Member(GraphicsBatchedObject* batch, const TopoDS_Shape& shape)
+    : m_batch(batch),
+      m_shape(shape)
+{
+}
+
+opencascade::handle<SelectMgr_EntityOwner> GraphicsBatchedObject::Member::GlobalSelOwner() const
+{
+    return m_batch && m_partIndex >= 0 ? m_batch->m_vecPart.at(m_partIndex).owner : Handle_SelectMgr_EntityOwner();
+}
+
+} // namespace Mayo
@@ -0,0 +1,161 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "graphics_object_ptr.h"
+#include "graphics_owner_ptr.h"
+#include "../base/tkernel_utils.h"
+
+#include <AIS_InteractiveObject.hxx>
+#include <Graphic3d_ArrayOfTriangles.hxx>
+#include <PrsMgr_PresentationManager3d.hxx>
+#include <Quantity_Color.hxx>
+#include <SelectMgr_Selection.hxx>
+#include <TopLoc_Location.hxx>
+#include <TopoDS_Shape.hxx>
+#include <vector>
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+#  include <Prs3d_Projector.hxx>
+#endif
+
+namespace Mayo {
+
+// Single interactive object drawing the triangulations of several static parts sharing the same
+// style, merged into one vertex buffer so they take a single draw call
+// Each part is a member object which isn't displayed on its own: visibility, picking and highlight
+// of a member are resolved through the range of triangles it owns in the merged buffer
+// Parts are always drawn shaded(display mode AIS_Shaded) and don't follow object transformations
+class GraphicsBatchedObject : public AIS_InteractiveObject {
+public:
+    class Member;
+
+    GraphicsBatchedObject(const Quantity_Color& color);
+
+    const Quantity_Color& color() const { return m_color; }
+
+    // Adds part 'shape' located at 'loc', returns the graphics object of the part
+    // Faces of 'shape' are expected to be triangulated, buffers are built by prepare()
+    GraphicsObjectPtr addMember(const TopoDS_Shape& shape, const TopLoc_Location& loc);
+
+    int memberCount() const { return int(m_vecPart.size()); }
+    GraphicsObjectPtr member(int i) const;
+    // Count of triangles of the members added so far
+    int triangleCount() const { return m_triangleCount; }
+
+    // Merges the triangulations of the members, can be called from a worker thread if the object
+    // isn't displayed yet. Has to be called again if a member shape was changed
+    void prepare();
+
+    bool isMemberVisible(const GraphicsObjectPtr& member) const;
+    // Presentation and selection are outdated until updateMembersVisibility() is called, so bulk
+    // changes get them recomputed once
+    void setMemberVisible(const GraphicsObjectPtr& member, bool on);
+    void updateMembersVisibility();
+
+    // Returns the batch owning graphics 'object', or null if 'object' isn't a batch member
+    static GraphicsBatchedObject* fromMember(const GraphicsObjectPtr& object);
+    // Returns the member picked through 'owner', or null if 'owner' isn't owned by a batch
+    static GraphicsObjectPtr memberFromOwner(const GraphicsOwnerPtr& owner);
+
+    bool AcceptDisplayMode(const int mode) const override;
+    void ComputeSelection(const opencascade::handle<SelectMgr_Selection>& sel, const int mode) override;
+
+    // Owners aren't auto-highlighted, only the triangles of the members are drawn
+    void HilightSelected(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& prsMgr,
+            const SelectMgr_SequenceOfOwner& seqOwner) override;
+    void HilightOwnerWithColor(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& prsMgr,
+            const opencascade::handle<Prs3d_Drawer>& style,
+            const opencascade::handle<SelectMgr_EntityOwner>& owner) override;
+
+    DEFINE_STANDARD_RTTI_INLINE(GraphicsBatchedObject, AIS_InteractiveObject)
+
+protected:
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& prsMgr,
+            const opencascade::handle<Prs3d_Presentation>& prs,
+            const int mode) override;
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+    void Compute(
+            const opencascade::handle<Prs3d_Projector>&,
+            const opencascade::handle<Prs3d_Presentation>&) override
+    {}
+#endif
+
+private:
+    class MemberOwner;
+
+    struct Part {
+        GraphicsObjectPtr member;
+        opencascade::handle<SelectMgr_EntityOwner> owner; // MemberOwner
+        TopoDS_Shape shape; // Located
+        bool isVisible = true;
+        // Ranges in the merged buffers
+        int vertexFirst = 0;
+        int vertexCount = 0;
+        int indexFirst = 0;
+        int indexCount = 0;
+    };
+
+    int partIndex(const GraphicsObjectPtr& member) const;
+    // Triangles of the parts 'vecPartIndex'(in increasing order), taken from the merged buffers
+    Handle_Graphic3d_ArrayOfTriangles createPartTriangles(const std::vector<int>& vecPartIndex) const;
+    void displayHighlight(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& prsMgr,
+            const opencascade::handle<Prs3d_Presentation>& prs,
+            const opencascade::handle<Prs3d_Drawer>& style,
+            const std::vector<int>& vecPartIndex);
+
+    Quantity_Color m_color;
+    std::vector<Part> m_vecPart;
+    int m_triangleCount = 0;
+    Handle_Graphic3d_ArrayOfTriangles m_triangles; // All the members, null if not prepared
+    bool m_isMembersVisibilityChanged = false;
+};
+
+// Stands for a part of the batch in the application(model tree node mapping, visibility, selection)
+class GraphicsBatchedObject::Member : public AIS_InteractiveObject {
+public:
+    Member(GraphicsBatchedObject* batch, const TopoDS_Shape& shape);
+
+    // Batch is still known while the member is hidden
+    GraphicsBatchedObject* batch() const { return m_batch; }
+    // Part shape, not located
+    const TopoDS_Shape& shape() const { return m_shape; }
+
+    // Owner of the member triangles within the selection of the batch
+    opencascade::handle<SelectMgr_EntityOwner> GlobalSelOwner() const override;
+
+    void ComputeSelection(const opencascade::handle<SelectMgr_Selection>&, const int) override {}
+
+    DEFINE_STANDARD_RTTI_INLINE(GraphicsBatchedObject::Member, AIS_InteractiveObject)
+
+protected:
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>&,
+            const opencascade::handle<Prs3d_Presentation>&,
+            const int) override
+    {}
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+    void Compute(
+            const opencascade::handle<Prs3d_Projector>&,
+            const opencascade::handle<Prs3d_Presentation>&) override
+    {}
+#endif
+
+private:
+    friend class GraphicsBatchedObject;
+    GraphicsBatchedObject* m_batch = nullptr;
+    TopoDS_Shape m_shape;
+    int m_partIndex = -1;
+};
+
+} // namespace Mayo
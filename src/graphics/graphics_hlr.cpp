@@ -0,0 +1,81 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "graphics_hlr.h"
+
+#include <Graphic3d_Group.hxx>
+#include <HLRAlgo_EdgeIterator.hxx>
+#include <HLRAlgo_Projector.hxx>
+#include <HLRBRep_PolyAlgo.hxx>
+#include <Prs3d_LineAspect.hxx>
+#include <TopLoc_Location.hxx>
+#include <gp_Ax2.hxx>
+
+namespace Mayo {
+
+Handle_Graphic3d_ArrayOfSegments GraphicsHlr::visibleEdges(
+        const TopoDS_Shape& shape, const gp_Trsf& trsf, const gp_Dir& viewProj)
+{
+    if (shape.IsNull())
+        return {};
+
+    opencascade::handle<HLRBRep_PolyAlgo> algo = new HLRBRep_PolyAlgo;
+    algo->Load(trsf.Form() != gp_Identity ? shape.Moved(TopLoc_Location(trsf)) : shape);
+    // Z axis of the projector frame points to the eye
+    algo->Projector(HLRAlgo_Projector(gp_Ax2(gp::Origin(), viewProj)));
+    algo->Update();
+
+    // Visible parts of the edges, smooth edges are dropped unless they are outlines(as
+    // StdPrs_HLRPolyShape does)
+    std::vector<gp_XYZ> vecPnt;
+    HLRAlgo_EdgeStatus status;
+    HLRAlgo_EdgeIterator itEdge;
+    TopoDS_Shape edgeShape;
+    for (algo->InitHide(); algo->MoreHide(); algo->NextHide()) {
+        bool reg1, regn, outl, intl;
+        const HLRAlgo_BiPoint::PointsT& points = algo->Hide(status, edgeShape, reg1, regn, outl, intl);
+        if (regn && !outl)
+            continue;
+
+        for (itEdge.InitVisible(status); itEdge.MoreVisible(); itEdge.NextVisible()) {
+            double start, end;
+            float tolStart, tolEnd;
+            itEdge.Visible(start, tolStart, end, tolEnd);
+            vecPnt.push_back(points.Pnt1 * (1. - start) + points.Pnt2 * start);
+            vecPnt.push_back(points.Pnt1 * (1. - end) + points.Pnt2 * end);
+        }
+    }
+
+    if (vecPnt.empty())
+        return {};
+
+    Handle_Graphic3d_ArrayOfSegments edges = new Graphic3d_ArrayOfSegments(int(vecPnt.size()));
+    for (const gp_XYZ& pnt : vecPnt)
+        edges->AddVertex(gp_Pnt(pnt));
+
+    return edges;
+}
+
+GraphicsHlrObject::GraphicsHlrObject()
+{
+    myDrawer->SetLineAspect(new Prs3d_LineAspect(Quantity_NOC_BLACK, Aspect_TOL_SOLID, 1.));
+}
+
+void GraphicsHlrObject::Compute(
+        const opencascade::handle<PrsMgr_PresentationManager3d>&,
+        const opencascade::handle<Prs3d_Presentation>& prs,
+        const int)
+{
+    if (m_vecEdges.empty())
+        return;
+
+    opencascade::handle<Graphic3d_Group> group = prs->NewGroup();
+    group->SetGroupPrimitivesAspect(myDrawer->LineAspect()->Aspect());
+    for (const Handle_Graphic3d_ArrayOfSegments& edges : m_vecEdges)
+        group->AddPrimitiveArray(edges);
+}
+
+} // namespace Mayo
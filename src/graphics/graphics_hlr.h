@@ -0,0 +1,67 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/tkernel_utils.h"
+
+#include <AIS_InteractiveObject.hxx>
+#include <Graphic3d_ArrayOfSegments.hxx>
+#include <Prs3d_Presentation.hxx>
+#include <PrsMgr_PresentationManager3d.hxx>
+#include <SelectMgr_Selection.hxx>
+#include <TopoDS_Shape.hxx>
+#include <gp_Dir.hxx>
+#include <gp_Trsf.hxx>
+#include <vector>
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+#  include <Prs3d_Projector.hxx>
+#endif
+
+namespace Mayo {
+
+// Hidden line removal computed apart from the "computed mode" of OpenCascade views, so it doesn't
+// have to run in the GUI thread
+struct GraphicsHlr {
+    // Visible edges of 'shape' moved by 'trsf', seen in parallel projection along 'viewProj'(ie
+    // direction pointing to the eye, see V3d_View::Proj()). Computed from the triangulations of the
+    // faces(HLRBRep_PolyAlgo), can be called from any thread
+    // Returns null if there is no visible edge
+    static Handle_Graphic3d_ArrayOfSegments visibleEdges(
+            const TopoDS_Shape& shape, const gp_Trsf& trsf, const gp_Dir& viewProj);
+};
+
+// Non-selectable object drawing hidden line removal results, coordinates are in world space
+class GraphicsHlrObject : public AIS_InteractiveObject {
+public:
+    GraphicsHlrObject();
+
+    // Presentation has then to be recomputed
+    void setEdges(std::vector<Handle_Graphic3d_ArrayOfSegments> vecEdges) { m_vecEdges = std::move(vecEdges); }
+
+    void ComputeSelection(const opencascade::handle<SelectMgr_Selection>&, const int) override {}
+
+    DEFINE_STANDARD_RTTI_INLINE(GraphicsHlrObject, AIS_InteractiveObject)
+
+protected:
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& prsMgr,
+            const opencascade::handle<Prs3d_Presentation>& prs,
+            const int mode) override;
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+    void Compute(
+            const opencascade::handle<Prs3d_Projector>&,
+            const opencascade::handle<Prs3d_Presentation>&) override
+    {}
+#endif
+
+private:
+    std::vector<Handle_Graphic3d_ArrayOfSegments> m_vecEdges;
+};
+
+} // namespace Mayo
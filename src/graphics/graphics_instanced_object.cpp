@@ -0,0 +1,80 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "graphics_instanced_object.h"
+
+#include <AIS_InteractiveContext.hxx>
+#include <SelectMgr_SelectionManager.hxx>
+
+namespace Mayo {
+
+GraphicsInstancedObject::GraphicsInstancedObject(const GraphicsObjectPtr& product)
+    : m_product(product)
+{
+    this->SetDisplayMode(product->DisplayMode());
+    this->Attributes()->SetFaceBoundaryDraw(product->Attributes()->FaceBoundaryDraw());
+    this->SetOwner(product->GetOwner());
+}
+
+GraphicsObjectPtr GraphicsInstancedObject::addInstance(const TopLoc_Location& loc)
+{
+    // Note: AIS_MultipleConnectedInteractive::Connect() isn't used because it may bind instances
+    //       to the assembly owner, per-instance picking would be lost
+    opencascade::handle<Instance> gfxInstance = new Instance(this);
+    gfxInstance->Connect(m_product, loc);
+    gfxInstance->SetDisplayMode(m_product->DisplayMode());
+    gfxInstance->Attributes()->SetFaceBoundaryDraw(m_product->Attributes()->FaceBoundaryDraw());
+    gfxInstance->SetOwner(m_product->GetOwner());
+    this->AddChild(gfxInstance);
+    if (!this->GetContext().IsNull())
+        gfxInstance->SetContext(this->GetContext());
+
+    m_vecInstance.push_back(gfxInstance);
+    return m_vecInstance.back();
+}
+
+bool GraphicsInstancedObject::isInstanceVisible(const GraphicsObjectPtr& instance) const
+{
+    return instance && instance->Parent() == this;
+}
+
+void GraphicsInstancedObject::setInstanceVisible(const GraphicsObjectPtr& instance, bool on)
+{
+    if (!this->hasInstance(instance) || this->isInstanceVisible(instance) == on)
+        return;
+
+    // Presentations and selections of children are handled recursively by the managers, so hidden
+    // instances are simply detached from the group
+    const Handle_AIS_InteractiveContext context = this->GetContext();
+    if (on) {
+        this->AddChild(instance);
+        if (context) {
+            context->MainPrsMgr()->Display(instance, this->DisplayMode());
+            context->SelectionManager()->Activate(instance, 0);
+        }
+    }
+    else {
+        if (context) {
+            context->SelectionManager()->Deactivate(instance);
+            context->MainPrsMgr()->Erase(instance, this->DisplayMode());
+        }
+
+        this->RemoveChild(instance);
+    }
+}
+
+GraphicsInstancedObject* GraphicsInstancedObject::fromInstance(const GraphicsObjectPtr& object)
+{
+    auto gfxInstance = opencascade::handle<Instance>::DownCast(object);
+    return gfxInstance ? gfxInstance->group() : nullptr;
+}
+
+bool GraphicsInstancedObject::hasInstance(const GraphicsObjectPtr& instance) const
+{
+    return GraphicsInstancedObject::fromInstance(instance) == this;
+}
+
+} // namespace Mayo
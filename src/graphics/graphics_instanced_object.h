@@ -0,0 +1,67 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "graphics_object_ptr.h"
+
+#include <AIS_ConnectedInteractive.hxx>
+#include <AIS_MultipleConnectedInteractive.hxx>
+#include <TopLoc_Location.hxx>
+#include <vector>
+
+namespace Mayo {
+
+// Single interactive object gathering all the instances of a shared product
+// Each instance is a connected presentation of the product placed by its own transformation, so
+// the product graphics are computed once and the AIS context manages one object for the whole
+// group. Instances keep their own selection owner and can be shown/hidden individually
+class GraphicsInstancedObject : public AIS_MultipleConnectedInteractive {
+public:
+    class Instance;
+
+    GraphicsInstancedObject(const GraphicsObjectPtr& product);
+
+    const GraphicsObjectPtr& product() const { return m_product; }
+
+    // Adds an instance of the product located at 'loc', returns the graphics object of the instance
+    GraphicsObjectPtr addInstance(const TopLoc_Location& loc);
+
+    int instanceCount() const { return int(m_vecInstance.size()); }
+    const GraphicsObjectPtr& instance(int i) const { return m_vecInstance.at(i); }
+
+    bool isInstanceVisible(const GraphicsObjectPtr& instance) const;
+    void setInstanceVisible(const GraphicsObjectPtr& instance, bool on);
+
+    // Returns the group owning graphics 'object', or null if 'object' isn't a grouped instance
+    static GraphicsInstancedObject* fromInstance(const GraphicsObjectPtr& object);
+
+    // Instances are displayed in the mode of the group, which must then be one of the product
+    bool AcceptDisplayMode(const int mode) const override { return m_product->AcceptDisplayMode(mode); }
+
+    DEFINE_STANDARD_RTTI_INLINE(GraphicsInstancedObject, AIS_MultipleConnectedInteractive)
+
+private:
+    bool hasInstance(const GraphicsObjectPtr& instance) const;
+
+    GraphicsObjectPtr m_product;
+    std::vector<GraphicsObjectPtr> m_vecInstance;
+};
+
+class GraphicsInstancedObject::Instance : public AIS_ConnectedInteractive {
+public:
+    Instance(GraphicsInstancedObject* group) : m_group(group) {}
+
+    // Group is still known while the instance is hidden, ie detached from the group's children
+    GraphicsInstancedObject* group() const { return m_group; }
+
+    DEFINE_STANDARD_RTTI_INLINE(GraphicsInstancedObject::Instance, AIS_ConnectedInteractive)
+
+private:
+    GraphicsInstancedObject* m_group = nullptr;
+};
+
+} // namespace Mayo
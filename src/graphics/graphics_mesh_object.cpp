@@ -0,0 +1,315 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "graphics_mesh_object.h"
+
+#include "../base/cpp_utils.h"
+#include "../base/mesh_utils.h"
+
+#include <Graphic3d_AspectFillArea3d.hxx>
+#include <Graphic3d_AspectLine3d.hxx>
+#include <Graphic3d_AspectMarker3d.hxx>
+#include <Graphic3d_Group.hxx>
+#include <MeshVS_DisplayModeFlags.hxx>
+#include <Select3D_SensitiveTriangulation.hxx>
+#include <SelectMgr_EntityOwner.hxx>
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+#  include <TShort_Array1OfShortReal.hxx>
+#endif
+#include <algorithm>
+
+namespace Mayo {
+
+namespace {
+
+// Count of triangles(or nodes) filled at once by a worker thread
+constexpr int MeshChunkItemCount = 65536;
+
+// Calls 'fn(first, last)' concurrently on the chunks of range [0, count[
+template<typename FUNCTION>
+void parallelForChunks(int count, FUNCTION fn)
+{
+    const int chunkCount = (count + MeshChunkItemCount - 1) / MeshChunkItemCount;
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        const int first = iChunk * MeshChunkItemCount;
+        fn(first, std::min(first + MeshChunkItemCount, count));
+    });
+}
+
+// Writes vertex attributes directly in the interleaved buffer of a primitive array, so distinct
+// vertices can be written concurrently(unlike AddVertex() which appends them)
+// Position is the first attribute, normal(if any) is the second one, followed by color(if any)
+class VertexBufferWriter {
+public:
+    VertexBufferWriter(const Handle_Graphic3d_ArrayOfPrimitives& array, int vertexCount)
+        : m_attribs(array->Attributes().get())
+    {
+        m_attribs->NbElements = vertexCount;
+        m_normalOffset = m_attribs->NbAttributes > 1 ? m_attribs->AttributeOffset(1) : 0;
+        for (int i = 1; i < m_attribs->NbAttributes; ++i) {
+            if (m_attribs->Attribute(i).Id == Graphic3d_TOA_COLOR)
+                m_colorOffset = m_attribs->AttributeOffset(i);
+        }
+    }
+
+    // 'index' is zero-based
+    void setPosition(int index, const Graphic3d_Vec3& pnt) {
+        m_attribs->ChangeValue<Graphic3d_Vec3>(index) = pnt;
+    }
+
+    void setNormal(int index, const Graphic3d_Vec3& normal) {
+        *reinterpret_cast<Graphic3d_Vec3*>(m_attribs->changeValue(index) + m_normalOffset) = normal;
+    }
+
+    // 'rgb' is packed as 0xRRGGBB
+    void setColor(int index, uint32_t rgb) {
+        *reinterpret_cast<Graphic3d_Vec4ub*>(m_attribs->changeValue(index) + m_colorOffset) =
+                Graphic3d_Vec4ub(uint8_t(rgb >> 16), uint8_t(rgb >> 8), uint8_t(rgb), 255);
+    }
+
+private:
+    Graphic3d_Buffer* m_attribs = nullptr;
+    size_t m_normalOffset = 0;
+    size_t m_colorOffset = 0;
+};
+
+Graphic3d_Vec3 toVec3(const gp_XYZ& coords)
+{
+    return Graphic3d_Vec3(float(coords.X()), float(coords.Y()), float(coords.Z()));
+}
+
+Graphic3d_Vec3 nodeNormal(const Poly_Triangulation& mesh, int nodeId)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    gp_Vec3f normal;
+    mesh.Normal(nodeId, normal);
+    return normal;
+#else
+    const TShort_Array1OfShortReal& vecNormal = mesh.Normals();
+    const int i = (nodeId - 1) * 3 + vecNormal.Lower();
+    return Graphic3d_Vec3(vecNormal.Value(i), vecNormal.Value(i + 1), vecNormal.Value(i + 2));
+#endif
+}
+
+void fillNodePositions(VertexBufferWriter* writer, const Poly_Triangulation& mesh)
+{
+    parallelForChunks(mesh.NbNodes(), [&](int first, int last) {
+        for (int i = first; i < last; ++i)
+            writer->setPosition(i, toVec3(mesh.Node(i + 1).XYZ()));
+    });
+}
+
+} // namespace
+
+GraphicsMeshObject::GraphicsMeshObject(const Handle_Poly_Triangulation& mesh)
+    : m_mesh(mesh)
+{
+    this->SetDisplayMode(MeshVS_DMF_Shading);
+}
+
+void GraphicsMeshObject::setEdgeCreaseAngle(double angle)
+{
+    if (angle != m_edgeCreaseAngle) {
+        m_edgeCreaseAngle = angle;
+        m_featureEdges.Nullify();
+    }
+}
+
+void GraphicsMeshObject::prepareFeatureEdges()
+{
+    if (!m_featureEdges)
+        m_featureEdges = GraphicsMeshObject::createFeatureEdges(m_mesh, m_edgeCreaseAngle);
+}
+
+bool GraphicsMeshObject::AcceptDisplayMode(const int mode) const
+{
+    return mode == MeshVS_DMF_WireFrame || mode == MeshVS_DMF_Shading || mode == MeshVS_DMF_Shrink;
+}
+
+void GraphicsMeshObject::ComputeSelection(const opencascade::handle<SelectMgr_Selection>& sel, const int mode)
+{
+    if (mode != 0 || !m_mesh || m_mesh->NbTriangles() <= 0)
+        return;
+
+    Handle_SelectMgr_EntityOwner owner = new SelectMgr_EntityOwner(this);
+    sel->Add(new Select3D_SensitiveTriangulation(owner, m_mesh, TopLoc_Location(), true));
+}
+
+Handle_Graphic3d_ArrayOfTriangles GraphicsMeshObject::createTriangles(
+        const Handle_Poly_Triangulation& mesh, double shrinkFactor, Span<const uint32_t> spanNodeColor)
+{
+    if (!mesh || mesh->NbTriangles() <= 0)
+        return {};
+
+    const int triangleCount = mesh->NbTriangles();
+    const bool hasColors = !spanNodeColor.empty() && int(spanNodeColor.size()) == mesh->NbNodes();
+    if (mesh->HasNormals() && shrinkFactor >= 1.) {
+        const int nodeCount = mesh->NbNodes();
+        Handle_Graphic3d_ArrayOfTriangles array =
+                new Graphic3d_ArrayOfTriangles(nodeCount, 3 * triangleCount, true, hasColors);
+        VertexBufferWriter writer(array, nodeCount);
+        fillNodePositions(&writer, *mesh);
+        parallelForChunks(nodeCount, [&](int first, int last) {
+            for (int i = first; i < last; ++i) {
+                writer.setNormal(i, nodeNormal(*mesh, i + 1));
+                if (hasColors)
+                    writer.setColor(i, spanNodeColor[i]);
+            }
+        });
+
+        Graphic3d_IndexBuffer* indices = array->Indices().get();
+        indices->NbElements = 3 * triangleCount;
+        parallelForChunks(triangleCount, [&](int first, int last) {
+            for (int i = first; i < last; ++i) {
+                int n1, n2, n3;
+                mesh->Triangle(i + 1).Get(n1, n2, n3);
+                indices->SetIndex(3 * i, n1 - 1);
+                indices->SetIndex(3 * i + 1, n2 - 1);
+                indices->SetIndex(3 * i + 2, n3 - 1);
+            }
+        });
+        return array;
+    }
+
+    const MeshUtils::VectorArrays vecTriangleNormal = MeshUtils::triangleNormals(mesh);
+    Handle_Graphic3d_ArrayOfTriangles array = new Graphic3d_ArrayOfTriangles(3 * triangleCount, 0, true, hasColors);
+    VertexBufferWriter writer(array, 3 * triangleCount);
+    parallelForChunks(triangleCount, [&](int first, int last) {
+        for (int i = first; i < last; ++i) {
+            int nodeIds[3];
+            mesh->Triangle(i + 1).Get(nodeIds[0], nodeIds[1], nodeIds[2]);
+            gp_XYZ pnts[3];
+            for (int j = 0; j < 3; ++j)
+                pnts[j] = mesh->Node(nodeIds[j]).XYZ();
+
+            if (shrinkFactor < 1.) {
+                const gp_XYZ center = (pnts[0] + pnts[1] + pnts[2]) / 3.;
+                for (gp_XYZ& pnt : pnts)
+                    pnt = center + shrinkFactor * (pnt - center);
+            }
+
+            const Graphic3d_Vec3 normal(vecTriangleNormal.x[i], vecTriangleNormal.y[i], vecTriangleNormal.z[i]);
+            for (int j = 0; j < 3; ++j) {
+                writer.setPosition(3 * i + j, toVec3(pnts[j]));
+                writer.setNormal(3 * i + j, normal);
+                if (hasColors)
+                    writer.setColor(3 * i + j, spanNodeColor[nodeIds[j] - 1]);
+            }
+        }
+    });
+    return array;
+}
+
+Handle_Graphic3d_ArrayOfSegments GraphicsMeshObject::createTriangleEdges(const Handle_Poly_Triangulation& mesh)
+{
+    if (!mesh || mesh->NbTriangles() <= 0)
+        return {};
+
+    const int triangleCount = mesh->NbTriangles();
+    Handle_Graphic3d_ArrayOfSegments array = new Graphic3d_ArrayOfSegments(mesh->NbNodes(), 6 * triangleCount);
+    VertexBufferWriter writer(array, mesh->NbNodes());
+    fillNodePositions(&writer, *mesh);
+    Graphic3d_IndexBuffer* indices = array->Indices().get();
+    indices->NbElements = 6 * triangleCount;
+    parallelForChunks(triangleCount, [&](int first, int last) {
+        for (int i = first; i < last; ++i) {
+            int nodeIds[3];
+            mesh->Triangle(i + 1).Get(nodeIds[0], nodeIds[1], nodeIds[2]);
+            for (int j = 0; j < 3; ++j) {
+                indices->SetIndex(6 * i + 2 * j, nodeIds[j] - 1);
+                indices->SetIndex(6 * i + 2 * j + 1, nodeIds[(j + 1) % 3] - 1);
+            }
+        }
+    });
+    return array;
+}
+
+Handle_Graphic3d_ArrayOfPoints GraphicsMeshObject::createNodes(const Handle_Poly_Triangulation& mesh)
+{
+    if (!mesh || mesh->NbNodes() <= 0)
+        return {};
+
+    Handle_Graphic3d_ArrayOfPoints array = new Graphic3d_ArrayOfPoints(mesh->NbNodes());
+    VertexBufferWriter writer(array, mesh->NbNodes());
+    fillNodePositions(&writer, *mesh);
+    return array;
+}
+
+Handle_Graphic3d_ArrayOfSegments GraphicsMeshObject::createFeatureEdges(
+        const Handle_Poly_Triangulation& mesh, double creaseAngle)
+{
+    const std::vector<MeshUtils::Edge> vecEdge = MeshUtils::featureEdges(mesh, creaseAngle);
+    if (vecEdge.empty())
+        return {};
+
+    // Vertex index of each node used by the edges, -1 if not used
+    std::vector<int> vecNodeVertex(mesh->NbNodes() + 1, -1);
+    int vertexCount = 0;
+    for (const MeshUtils::Edge& edge : vecEdge) {
+        for (int nodeId : { edge.node1, edge.node2 }) {
+            if (vecNodeVertex.at(nodeId) < 0)
+                vecNodeVertex[nodeId] = vertexCount++;
+        }
+    }
+
+    Handle_Graphic3d_ArrayOfSegments array = new Graphic3d_ArrayOfSegments(vertexCount, 2 * int(vecEdge.size()));
+    VertexBufferWriter writer(array, vertexCount);
+    for (int nodeId = 1; nodeId <= mesh->NbNodes(); ++nodeId) {
+        if (vecNodeVertex.at(nodeId) >= 0)
+            writer.setPosition(vecNodeVertex.at(nodeId), toVec3(mesh->Node(nodeId).XYZ()));
+    }
+
+    for (const MeshUtils::Edge& edge : vecEdge)
+        array->AddEdges(vecNodeVertex.at(edge.node1) + 1, vecNodeVertex.at(edge.node2) + 1);
+
+    return array;
+}
+
+void GraphicsMeshObject::Compute(
+        const opencascade::handle<PrsMgr_PresentationManager3d>&,
+        const opencascade::handle<Prs3d_Presentation>& prs,
+        const int mode)
+{
+    if (!m_mesh || m_mesh->NbTriangles() <= 0)
+        return;
+
+    if (mode == MeshVS_DMF_WireFrame) {
+        opencascade::handle<Graphic3d_Group> group = prs->NewGroup();
+        group->SetGroupPrimitivesAspect(new Graphic3d_AspectLine3d(m_edgeColor, Aspect_TOL_SOLID, 1.));
+        group->AddPrimitiveArray(GraphicsMeshObject::createTriangleEdges(m_mesh));
+    }
+    else if (mode == MeshVS_DMF_Shading || mode == MeshVS_DMF_Shrink) {
+        const Graphic3d_MaterialAspect material(m_material);
+        opencascade::handle<Graphic3d_AspectFillArea3d> aspect = new Graphic3d_AspectFillArea3d(
+                    Aspect_IS_SOLID, m_color, m_edgeColor, Aspect_TOL_SOLID, 1., material, material);
+        // Shrunk triangles are outlined each, feature edges wouldn't match them
+        if (m_showEdges && mode == MeshVS_DMF_Shrink)
+            aspect->SetEdgeOn();
+        else
+            aspect->SetEdgeOff();
+
+        const double shrinkFactor = mode == MeshVS_DMF_Shrink ? m_shrinkFactor : 1.;
+        opencascade::handle<Graphic3d_Group> group = prs->NewGroup();
+        group->SetGroupPrimitivesAspect(aspect);
+        group->AddPrimitiveArray(GraphicsMeshObject::createTriangles(m_mesh, shrinkFactor, m_vecNodeColor));
+        if (m_showEdges && mode == MeshVS_DMF_Shading) {
+            this->prepareFeatureEdges();
+            if (m_featureEdges) {
+                opencascade::handle<Graphic3d_Group> groupEdges = prs->NewGroup();
+                groupEdges->SetGroupPrimitivesAspect(new Graphic3d_AspectLine3d(m_edgeColor, Aspect_TOL_SOLID, 1.));
+                groupEdges->AddPrimitiveArray(m_featureEdges);
+            }
+        }
+    }
+
+    if (m_showNodes) {
+        opencascade::handle<Graphic3d_Group> group = prs->NewGroup();
+        group->SetGroupPrimitivesAspect(new Graphic3d_AspectMarker3d(Aspect_TOM_POINT, Quantity_NOC_YELLOW, 1.));
+        group->AddPrimitiveArray(GraphicsMeshObject::createNodes(m_mesh));
+    }
+}
+
+} // namespace Mayo
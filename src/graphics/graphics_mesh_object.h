@@ -0,0 +1,124 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/quantity.h"
+#include "../base/span.h"
+#include "../base/tkernel_utils.h"
+
+#include <AIS_InteractiveObject.hxx>
+#include <Graphic3d_ArrayOfPoints.hxx>
+#include <Graphic3d_ArrayOfSegments.hxx>
+#include <Graphic3d_ArrayOfTriangles.hxx>
+#include <Graphic3d_NameOfMaterial.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Prs3d_Presentation.hxx>
+#include <PrsMgr_PresentationManager3d.hxx>
+#include <Quantity_Color.hxx>
+#include <SelectMgr_Selection.hxx>
+#include <cstdint>
+#include <vector>
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+#  include <Prs3d_Projector.hxx>
+#endif
+
+namespace Mayo {
+
+// Presentation of a Poly_Triangulation, primitive arrays are filled directly from the buffers of
+// the triangulation by chunks of triangles processed concurrently
+// Display modes are the MeshVS ones: MeshVS_DMF_WireFrame, MeshVS_DMF_Shading and MeshVS_DMF_Shrink
+// The whole mesh is selected in mode 0, picking is precise at triangle level(BVH of the triangles)
+class GraphicsMeshObject : public AIS_InteractiveObject {
+public:
+    GraphicsMeshObject(const Handle_Poly_Triangulation& mesh);
+
+    // Presentations and selections have then to be recomputed
+    const Handle_Poly_Triangulation& mesh() const { return m_mesh; }
+    void setMesh(const Handle_Poly_Triangulation& mesh) { m_mesh = mesh; m_featureEdges.Nullify(); }
+
+    // Attributes, presentations have then to be recomputed
+    const Quantity_Color& color() const { return m_color; }
+    void setColor(const Quantity_Color& color) { m_color = color; }
+
+    // Colors at nodes(packed as 0xRRGGBB, see MeshNodeColors) replacing color() in shaded modes
+    // Ignored if the count of colors isn't the count of mesh nodes
+    const std::vector<uint32_t>& nodeColors() const { return m_vecNodeColor; }
+    void setNodeColors(std::vector<uint32_t> vecRgb) { m_vecNodeColor = std::move(vecRgb); }
+
+    const Quantity_Color& edgeColor() const { return m_edgeColor; }
+    void setEdgeColor(const Quantity_Color& color) { m_edgeColor = color; }
+
+    Graphic3d_NameOfMaterial material() const { return m_material; }
+    void setMaterial(Graphic3d_NameOfMaterial material) { m_material = material; }
+
+    // Edges shown in shaded mode are the feature edges of the mesh, see MeshUtils::featureEdges()
+    bool isShowEdgesOn() const { return m_showEdges; }
+    void setShowEdges(bool on) { m_showEdges = on; }
+
+    // Minimum dihedral angle(radians) of the crease edges shown
+    double edgeCreaseAngle() const { return m_edgeCreaseAngle; }
+    void setEdgeCreaseAngle(double angle);
+
+    // Computes the feature edges once for all, can be called from a worker thread if the object
+    // isn't displayed yet. Otherwise they are computed along with the presentation
+    void prepareFeatureEdges();
+
+    bool isShowNodesOn() const { return m_showNodes; }
+    void setShowNodes(bool on) { m_showNodes = on; }
+
+    // Scaling of the triangles about their centroid in shrink mode, in ]0,1]
+    double shrinkFactor() const { return m_shrinkFactor; }
+    void setShrinkFactor(double factor) { m_shrinkFactor = factor; }
+
+    bool AcceptDisplayMode(const int mode) const override;
+    void ComputeSelection(const opencascade::handle<SelectMgr_Selection>& sel, const int mode) override;
+
+    // Primitive arrays, can be called from any thread
+    // Triangles share the nodes if 'mesh' has normals(and 'shrinkFactor' is 1), otherwise each
+    // triangle has its own vertices with the normal of the triangle
+    // Vertices get colors 'spanNodeColor'(see nodeColors()) if it's the size of the mesh nodes
+    static Handle_Graphic3d_ArrayOfTriangles createTriangles(
+            const Handle_Poly_Triangulation& mesh,
+            double shrinkFactor = 1.,
+            Span<const uint32_t> spanNodeColor = {});
+    // Three segments per triangle, edges shared by triangles are drawn once per triangle
+    static Handle_Graphic3d_ArrayOfSegments createTriangleEdges(const Handle_Poly_Triangulation& mesh);
+    static Handle_Graphic3d_ArrayOfPoints createNodes(const Handle_Poly_Triangulation& mesh);
+    // Segments of the feature edges, vertices are only the nodes at the ends of the edges
+    static Handle_Graphic3d_ArrayOfSegments createFeatureEdges(
+            const Handle_Poly_Triangulation& mesh, double creaseAngle);
+
+    DEFINE_STANDARD_RTTI_INLINE(GraphicsMeshObject, AIS_InteractiveObject)
+
+protected:
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& prsMgr,
+            const opencascade::handle<Prs3d_Presentation>& prs,
+            const int mode) override;
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+    void Compute(
+            const opencascade::handle<Prs3d_Projector>&,
+            const opencascade::handle<Prs3d_Presentation>&) override
+    {}
+#endif
+
+private:
+    Handle_Poly_Triangulation m_mesh;
+    Quantity_Color m_color = Quantity_NOC_BISQUE;
+    Quantity_Color m_edgeColor = Quantity_NOC_BLACK;
+    std::vector<uint32_t> m_vecNodeColor;
+    Graphic3d_NameOfMaterial m_material = Graphic3d_NOM_PLASTIC;
+    bool m_showEdges = false;
+    bool m_showNodes = false;
+    double m_shrinkFactor = 0.8;
+    double m_edgeCreaseAngle = 30 * Quantity_Degree.value();
+    Handle_Graphic3d_ArrayOfSegments m_featureEdges; // Cache, null if not computed
+};
+
+} // namespace Mayo
@@ -13,12 +13,47 @@
 
 namespace Mayo {
 
+namespace Internal {
+
+static Enumeration displayModesWithMixed(Span<const GraphicsObjectPtr> spanObject)
+{
+    Enumeration enumDisplayMode;
+    GraphicsObjectDriverPtr gfxDriver = GraphicsObjectDriver::getCommon(spanObject);
+    if (gfxDriver) {
+        for (const Enumeration::Item& item : gfxDriver->displayModes().items())
+            enumDisplayMode.addItem(item.value, item.name);
+    }
+
+    enumDisplayMode.addItem(
+                GraphicsObjectBasePropertyGroup::MixedValue,
+                GraphicsObjectBasePropertyGroup::textId("mixed"));
+    return enumDisplayMode;
+}
+
+} // namespace Internal
+
 GraphicsObjectBasePropertyGroup::GraphicsObjectBasePropertyGroup(Span<const GraphicsObjectPtr> spanObject)
     : m_vecObject(spanObject.begin(), spanObject.end())/*,
-      m_propertyVisibleState(this, textId("visible"))*/
+      m_propertyVisibleState(this, textId("visible"))*/,
+      m_enumDisplayMode(Internal::displayModesWithMixed(spanObject)),
+      m_propertyDisplayMode(this, textId("displayMode"), m_enumDisplayMode)
 {
     // Init properties
     Mayo_PropertyChangedBlocker(this);
+
+    GraphicsObjectDriverPtr gfxDriver = GraphicsObjectDriver::getCommon(spanObject);
+    Enumeration::Value displayMode = MixedValue;
+    for (const GraphicsObjectPtr& object : spanObject) {
+        const Enumeration::Value objectDisplayMode = gfxDriver ? gfxDriver->currentDisplayMode(object) : MixedValue;
+        if (&object != &spanObject.front() && objectDisplayMode != displayMode) {
+            displayMode = MixedValue;
+            break;
+        }
+
+        displayMode = objectDisplayMode;
+    }
+
+    m_propertyDisplayMode.setValue(m_enumDisplayMode.findIndex(displayMode) != -1 ? displayMode : MixedValue);
 #if 0
     int visibleCount = 0;
     for (const GraphicsObjectPtr& object : spanObject) {
@@ -35,6 +70,16 @@ GraphicsObjectBasePropertyGroup::GraphicsObjectBasePropertyGroup(Span<const Grap
 
 void GraphicsObjectBasePropertyGroup::onPropertyChanged(Property* prop)
 {
+    if (prop == &m_propertyDisplayMode && m_propertyDisplayMode.value() != MixedValue) {
+        // Presentations are computed on next redraw, once for all objects
+        const Enumeration::Value displayMode = m_propertyDisplayMode.value();
+        GraphicsObjectDriverPtr gfxDriver = GraphicsObjectDriver::getCommon(m_vecObject);
+        for (const GraphicsObjectPtr& object : m_vecObject) {
+            if (gfxDriver && gfxDriver->currentDisplayMode(object) != displayMode)
+                gfxDriver->applyDisplayMode(object, displayMode);
+        }
+    }
+
 #if 0
     if (prop == &m_propertyVisibleState) {
         if (m_propertyVisibleState != Qt::PartiallyChecked) {
@@ -8,11 +8,16 @@
 
 #include "../base/span.h"
 #include "../base/property_builtins.h"
+#include "../base/property_enumeration.h"
 #include "graphics_object_ptr.h"
 #include <vector>
 
 namespace Mayo {
 
+// Properties of graphics objects sharing the same driver, typically the current selection
+// Values are aggregated over the objects, a property whose value differs from one object to the
+// other gets a "mixed" value(eg PartiallyChecked, MixedValue). Changing a property applies the
+// new value to all the objects at once, redraw is then up to the listeners of propertyChanged()
 class GraphicsObjectBasePropertyGroup : public PropertyGroupSignals {
     Q_OBJECT
     MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::GraphicsObjectBasePropertyGroup)
@@ -20,12 +25,19 @@ public:
     GraphicsObjectBasePropertyGroup(Span<const GraphicsObjectPtr> spanObject);
     void onPropertyChanged(Property* prop) override;
 
+    Span<const GraphicsObjectPtr> objects() const { return m_vecObject; }
+
+    // Value of enumeration properties when objects don't share the same value
+    static constexpr Enumeration::Value MixedValue = -1;
+
 //signals:
 //    void visibilityToggled(bool on);
 
 private:
     std::vector<GraphicsObjectPtr> m_vecObject;
     //PropertyCheckState m_propertyVisibleState;
+    Enumeration m_enumDisplayMode; // Display modes of the driver, plus MixedValue
+    PropertyEnumeration m_propertyDisplayMode;
 };
 
 } // namespace Mayo
@@ -8,9 +8,12 @@
 
 #include "../base/document.h"
 #include "../base/caf_utils.h"
+#include "../base/mesh_node_colors.h"
+#include "../base/point_cloud.h"
 #include "../base/property_enumeration.h"
 #include "graphics_object_base_property_group.h"
-#include "graphics_mesh_data_source.h"
+#include "graphics_mesh_object.h"
+#include "graphics_point_cloud_object.h"
 #include "graphics_scene.h"
 #include "graphics_utils.h"
 
@@ -18,22 +21,79 @@
 #include <AIS_DisplayMode.hxx>
 #include <AIS_InteractiveContext.hxx>
 #include <BRep_TFace.hxx>
+#include <BRep_Tool.hxx>
 #include <MeshVS_DisplayModeFlags.hxx>
-#include <MeshVS_DrawerAttribute.hxx>
-#include <MeshVS_Drawer.hxx>
-#include <MeshVS_Mesh.hxx>
-#include <MeshVS_MeshPrsBuilder.hxx>
+#include <Poly_Connect.hxx>
 #include <Prs3d_LineAspect.hxx>
-#include <V3d_View.hxx>
-#include <V3d_Viewer.hxx>
+#include <PrsMgr_PresentationManager3d.hxx>
+#include <StdPrs_ToolTriangulatedShape.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
 #include <TDataXtd_Triangulation.hxx>
+#include <TNaming_NamedShape.hxx>
+#include <XCAFDoc.hxx>
 #include <XCAFPrs_AISObject.hxx>
 #include <stdexcept>
 
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+#  include <BRepLib_ToolTriangulatedShape.hxx>
+#endif
+
 namespace Mayo {
 
 namespace { struct GraphicsObjectDriverI18N { MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::GraphicsObjectDriver) }; }
 
+namespace Internal {
+
+// AIS display mode of shapes shaded with face boundaries, next to AIS_Shape modes(0 to 2)
+constexpr int AisShadedWithFaceBoundary = 3;
+// AIS display mode of shapes in hidden line removal, its presentation is empty as the lines are
+// drawn by a GraphicsHlrObject computed for the current view(see GuiDocument)
+constexpr int AisHiddenLineRemoval = 4;
+
+// XCAF shape object providing face boundaries as a separate display mode, so switching between
+// plain shaded and shaded with face boundaries just shows another precomputed presentation
+class ShapeObject : public XCAFPrs_AISObject {
+public:
+    ShapeObject(const TDF_Label& label) : XCAFPrs_AISObject(label) {}
+
+    bool AcceptDisplayMode(const int mode) const override {
+        return mode == AisShadedWithFaceBoundary
+                || mode == AisHiddenLineRemoval
+                || XCAFPrs_AISObject::AcceptDisplayMode(mode);
+    }
+
+    DEFINE_STANDARD_RTTI_INLINE(ShapeObject, XCAFPrs_AISObject)
+
+protected:
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& prsMgr,
+            const opencascade::handle<Prs3d_Presentation>& prs,
+            const int mode) override
+    {
+        if (mode == AisHiddenLineRemoval)
+            return;
+
+        // Face boundaries are drawn only by the dedicated mode, whatever the drawer
+        const bool faceBoundaryDraw = mode == AisShadedWithFaceBoundary;
+        myDrawer->SetFaceBoundaryDraw(faceBoundaryDraw);
+        XCAFPrs_AISObject::Compute(prsMgr, prs, faceBoundaryDraw ? int(AIS_Shaded) : mode);
+        myDrawer->SetFaceBoundaryDraw(false);
+    }
+};
+
+static int aisDisplayMode(Enumeration::Value mode)
+{
+    switch (mode) {
+    case GraphicsShapeObjectDriver::DisplayMode_Wireframe: return AIS_WireFrame;
+    case GraphicsShapeObjectDriver::DisplayMode_ShadedWithFaceBoundary: return AisShadedWithFaceBoundary;
+    case GraphicsShapeObjectDriver::DisplayMode_HiddenLineRemoval: return AisHiddenLineRemoval;
+    default: return AIS_Shaded;
+    }
+}
+
+} // namespace Internal
+
 GraphicsObjectDriverPtr GraphicsObjectDriver::get(const GraphicsObjectPtr& object)
 {
     if (object)
@@ -83,6 +143,9 @@ GraphicsShapeObjectDriver::GraphicsShapeObjectDriver()
         { DisplayMode_ShadedWithFaceBoundary, GraphicsObjectDriverI18N::textId("Shape_ShadedWithFaceBoundary") }
     });
     this->setDefaultDisplayMode(DisplayMode_ShadedWithFaceBoundary);
+    // XCAFDoc_ShapeTool::IsShape() : simple shape, assembly or reference
+    this->setAttributeSignature({
+        TNaming_NamedShape::GetID(), XCAFDoc::AssemblyGUID(), XCAFDoc::ShapeRefGUID() });
 }
 
 GraphicsObjectDriver::Support GraphicsShapeObjectDriver::supportStatus(const TDF_Label& label) const
@@ -104,12 +167,14 @@ GraphicsObjectPtr GraphicsShapeObjectDriver::createObject(const TDF_Label& label
 {
     if (XCaf::isShape(label)) {
 //        Handle_AIS_Shape object = new AIS_Shape(XCaf::shape(label));
-        Handle_XCAFPrs_AISObject object = new XCAFPrs_AISObject(label);
-        object->SetDisplayMode(AIS_Shaded);
-        object->Attributes()->SetFaceBoundaryDraw(true);
+        Handle_XCAFPrs_AISObject object = new Internal::ShapeObject(label);
+        object->SetDisplayMode(Internal::aisDisplayMode(this->defaultDisplayMode()));
         object->Attributes()->SetFaceBoundaryAspect(
                     new Prs3d_LineAspect(Quantity_NOC_BLACK, Aspect_TOL_SOLID, 1.));
         object->Attributes()->SetIsoOnTriangulation(true);
+        // Shapes are meshed by the application(which might refine meshes later), presentations
+        // must not re-tessellate on their own
+        object->Attributes()->SetAutoTriangulation(false);
         object->SetOwner(this);
         return object;
     }
@@ -119,70 +184,71 @@ GraphicsObjectPtr GraphicsShapeObjectDriver::createObject(const TDF_Label& label
     return {};
 }
 
-void GraphicsShapeObjectDriver::applyDisplayMode(GraphicsObjectPtr object, Enumeration::Value mode) const
+void GraphicsShapeObjectDriver::prepareObject(const GraphicsObjectPtr& object) const
 {
     this->throwIf_differentDriver(object);
-    this->throwIf_invalidDisplayMode(mode);
-
-    if (mode == this->currentDisplayMode(object))
-        return;
-
-    AIS_InteractiveContext* context = GraphicsUtils::AisObject_contextPtr(object);
-    if (!context)
+    auto shapeObject = Handle_AIS_Shape::DownCast(object);
+    if (!shapeObject)
         return;
 
-    auto fnSetViewComputedMode = [=](bool on) {
-        V3d_ListOfViewIterator viewIter = context->CurrentViewer()->DefinedViewIterator();
-        while (viewIter.More()) {
-            viewIter.Value()->SetComputedMode(on);
-            viewIter.Next();
+    // Auto-triangulation is off, so faces the application didn't mesh get the StdPrs mesh here
+    // Normals are stored in the triangulations, so they aren't computed at presentation time
+    const TopoDS_Shape& shape = shapeObject->Shape();
+    for (TopExp_Explorer expFace(shape, TopAbs_FACE); expFace.More(); expFace.Next()) {
+        const TopoDS_Face& face = TopoDS::Face(expFace.Current());
+        TopLoc_Location loc;
+        Handle_Poly_Triangulation triangulation = BRep_Tool::Triangulation(face, loc);
+        if (triangulation.IsNull()) {
+            StdPrs_ToolTriangulatedShape::Tessellate(face, shapeObject->Attributes());
+            triangulation = BRep_Tool::Triangulation(face, loc);
         }
-    };
 
-    if (mode == DisplayMode_HiddenLineRemoval) {
-        context->DefaultDrawer()->SetTypeOfHLR(Prs3d_TOH_PolyAlgo);
-        context->DefaultDrawer()->EnableDrawHiddenLine();
-        fnSetViewComputedMode(true);
-    }
-    else {
-        context->DefaultDrawer()->SetTypeOfHLR(Prs3d_TOH_NotSet);
-        context->DefaultDrawer()->DisableDrawHiddenLine();
-        fnSetViewComputedMode(false);
-        const AIS_DisplayMode aisDispMode = mode == DisplayMode_Wireframe ? AIS_WireFrame : AIS_Shaded;
-        const bool showFaceBounds = mode == DisplayMode_ShadedWithFaceBoundary;
-        if (object->DisplayMode() != aisDispMode)
-            context->SetDisplayMode(object, aisDispMode, false);
-
-        if (object->Attributes()->FaceBoundaryDraw() != showFaceBounds) {
-            object->Attributes()->SetFaceBoundaryDraw(showFaceBounds);
-            auto aisLink = Handle_AIS_ConnectedInteractive::DownCast(object);
-            if (aisLink && aisLink->HasConnection()) {
-                aisLink->ConnectedTo()->Attributes()->SetFaceBoundaryDraw(showFaceBounds);
-                aisLink->ConnectedTo()->Redisplay(true);
-            }
-            else {
-                object->Redisplay(true);
-            }
-        }
+        if (triangulation.IsNull() || triangulation->HasNormals())
+            continue;
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+        BRepLib_ToolTriangulatedShape::ComputeNormals(face, triangulation);
+#else
+        Poly_Connect polyConnect(triangulation);
+        StdPrs_ToolTriangulatedShape::ComputeNormals(face, polyConnect);
+#endif
     }
 
-    // context->UpdateCurrentViewer();
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    // XCAF styles are fetched from the document, avoid that at presentation time
+    auto xcafObject = Handle_XCAFPrs_AISObject::DownCast(object);
+    if (xcafObject)
+        xcafObject->DispatchStyles();
+#endif
 }
 
-Enumeration::Value GraphicsShapeObjectDriver::currentDisplayMode(const GraphicsObjectPtr& object) const
+void GraphicsShapeObjectDriver::applyDisplayMode(GraphicsObjectPtr object, Enumeration::Value mode) const
 {
     this->throwIf_differentDriver(object);
-    if (GraphicsUtils::AisObject_contextPtr(object)->DrawHiddenLine())
-        return DisplayMode_HiddenLineRemoval;
+    this->throwIf_invalidDisplayMode(mode);
+
+    AIS_InteractiveContext* context = GraphicsUtils::AisObject_contextPtr(object);
+    if (!context) {
+        // Object not displayed yet, selecting its mode avoids computing another presentation
+        object->SetDisplayMode(Internal::aisDisplayMode(mode));
+        return;
+    }
 
-    const int displayMode = object->DisplayMode();
-    if (displayMode == AIS_WireFrame)
-        return DisplayMode_Wireframe;
+    // Presentations of the display modes are kept once computed, so switching back and forth
+    // doesn't recompute anything
+    const int aisDispMode = Internal::aisDisplayMode(mode);
+    if (object->DisplayMode() != aisDispMode)
+        context->SetDisplayMode(object, aisDispMode, false);
+}
 
-    if (displayMode == AIS_Shaded) {
-        return object->Attributes()->FaceBoundaryDraw() ?
-                    DisplayMode_ShadedWithFaceBoundary :
-                    DisplayMode_Shaded;
+Enumeration::Value GraphicsShapeObjectDriver::currentDisplayMode(const GraphicsObjectPtr& object) const
+{
+    this->throwIf_differentDriver(object);
+    switch (object->DisplayMode()) {
+    case AIS_WireFrame: return DisplayMode_Wireframe;
+    case AIS_Shaded: return DisplayMode_Shaded;
+    case Internal::AisShadedWithFaceBoundary: return DisplayMode_ShadedWithFaceBoundary;
+    case Internal::AisHiddenLineRemoval: return DisplayMode_HiddenLineRemoval;
     }
 
     return -1;
@@ -192,8 +258,7 @@ std::unique_ptr<GraphicsObjectBasePropertyGroup>
 GraphicsShapeObjectDriver::properties(Span<const GraphicsObjectPtr> spanObject) const
 {
     this->throwIf_differentDriver(spanObject);
-    //return std::make_unique<GraphicsObjectBasePropertyGroup>(spanObject);
-    return {};
+    return std::make_unique<GraphicsObjectBasePropertyGroup>(spanObject);
 }
 
 GraphicsMeshObjectDriver::GraphicsMeshObjectDriver()
@@ -204,6 +269,9 @@ GraphicsMeshObjectDriver::GraphicsMeshObjectDriver()
         { MeshVS_DMF_Shrink, GraphicsObjectDriverI18N::textId("Mesh_Shrink") } // MeshVS_DA_ShrinkCoeff
     });
     this->setDefaultDisplayMode(MeshVS_DMF_Shading);
+    // Triangulation attribute, or XCAF face shape(simple or referenced)
+    this->setAttributeSignature({
+        TDataXtd_Triangulation::GetID(), TNaming_NamedShape::GetID(), XCAFDoc::ShapeRefGUID() });
 }
 
 GraphicsObjectDriver::Support GraphicsMeshObjectDriver::supportStatus(const TDF_Label& label) const
@@ -223,10 +291,12 @@ GraphicsObjectDriver::Support GraphicsMeshObjectDriver::supportStatus(const TDF_
 GraphicsObjectPtr GraphicsMeshObjectDriver::createObject(const TDF_Label& label) const
 {
     Handle_Poly_Triangulation polyTri;
+    std::vector<uint32_t> vecNodeColor;
     //const TopLoc_Location* ptrLocationPolyTri = nullptr;
     auto attrTriangulation = CafUtils::findAttribute<TDataXtd_Triangulation>(label);
     if (attrTriangulation) {
         polyTri = attrTriangulation->Get();
+        vecNodeColor = MeshNodeColors::get(label);
     }
     else if (XCaf::isShape(label)) {
         const TopoDS_Shape shape = XCaf::shape(label);
@@ -240,24 +310,15 @@ GraphicsObjectPtr GraphicsMeshObjectDriver::createObject(const TDF_Label& label)
     }
 
     if (polyTri) {
-        Handle_MeshVS_Mesh object = new MeshVS_Mesh;
-        object->SetDataSource(new GraphicsMeshDataSource(polyTri));
-        // meshVisu->AddBuilder(..., false); -> No selection
-        object->AddBuilder(new MeshVS_MeshPrsBuilder(object), true);
-
-        // -- MeshVS_DrawerAttribute
-        object->GetDrawer()->SetBoolean(MeshVS_DA_ShowEdges, defaultValues().showEdges);
-        object->GetDrawer()->SetBoolean(MeshVS_DA_DisplayNodes, defaultValues().showNodes);
-        object->GetDrawer()->SetMaterial(MeshVS_DA_FrontMaterial, Graphic3d_NOM_PLASTIC);
-        object->GetDrawer()->SetColor(MeshVS_DA_InteriorColor, defaultValues().color);
-        object->GetDrawer()->SetMaterial(
-                    MeshVS_DA_FrontMaterial, Graphic3d_MaterialAspect(defaultValues().material));
-        object->GetDrawer()->SetColor(MeshVS_DA_EdgeColor, defaultValues().edgeColor);
+        opencascade::handle<GraphicsMeshObject> object = new GraphicsMeshObject(polyTri);
+        object->setShowEdges(defaultValues().showEdges);
+        object->setShowNodes(defaultValues().showNodes);
+        object->setColor(defaultValues().color);
+        object->setNodeColors(std::move(vecNodeColor));
+        object->setMaterial(defaultValues().material);
+        object->setEdgeColor(defaultValues().edgeColor);
+        object->setEdgeCreaseAngle(defaultValues().edgeCreaseAngle);
         object->SetDisplayMode(MeshVS_DMF_Shading);
-
-        //object->SetHilightMode(MeshVS_DMF_WireFrame);
-        object->SetMeshSelMethod(MeshVS_MSM_PRECISE);
-
         object->SetOwner(this);
         return object;
     }
@@ -265,11 +326,23 @@ GraphicsObjectPtr GraphicsMeshObjectDriver::createObject(const TDF_Label& label)
     return {};
 }
 
+void GraphicsMeshObjectDriver::prepareObject(const GraphicsObjectPtr& object) const
+{
+    // Feature edges are computed once at loading, not when the object gets displayed
+    auto meshObject = opencascade::handle<GraphicsMeshObject>::DownCast(object);
+    if (meshObject && meshObject->isShowEdgesOn())
+        meshObject->prepareFeatureEdges();
+}
+
 void GraphicsMeshObjectDriver::applyDisplayMode(GraphicsObjectPtr object, Enumeration::Value mode) const
 {
     this->throwIf_differentDriver(object);
     this->throwIf_invalidDisplayMode(mode);
-    GraphicsUtils::AisObject_contextPtr(object)->SetDisplayMode(object, mode, false);
+    AIS_InteractiveContext* context = GraphicsUtils::AisObject_contextPtr(object);
+    if (context)
+        context->SetDisplayMode(object, mode, false);
+    else
+        object->SetDisplayMode(mode);
 }
 
 Enumeration::Value GraphicsMeshObjectDriver::currentDisplayMode(const GraphicsObjectPtr& object) const
@@ -278,6 +351,13 @@ Enumeration::Value GraphicsMeshObjectDriver::currentDisplayMode(const GraphicsOb
     return object->DisplayMode();
 }
 
+void GraphicsMeshObjectDriver::setObjectMesh(const GraphicsObjectPtr& object, const Handle_Poly_Triangulation& mesh)
+{
+    auto meshObject = opencascade::handle<GraphicsMeshObject>::DownCast(object);
+    if (meshObject && mesh)
+        meshObject->setMesh(mesh);
+}
+
 class GraphicsMeshObjectDriver::ObjectProperties : public GraphicsObjectBasePropertyGroup {
     MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::GraphicsMeshObjectDriver_ObjectProperties)
 public:
@@ -289,23 +369,12 @@ public:
         int countShowEdges = 0;
         int countShowNodes = 0;
         for (const GraphicsObjectPtr& object : spanObject) {
-            auto meshVisu = Handle_MeshVS_Mesh::DownCast(object);
-            // Color
-            Quantity_Color color;
-            meshVisu->GetDrawer()->GetColor(MeshVS_DA_InteriorColor, color);
-            sumColor += color;
-            // Edge color
-            meshVisu->GetDrawer()->GetColor(MeshVS_DA_EdgeColor, color);
-            sumEdgeColor += color;
-            // Show edges
-            bool boolVal;
-            meshVisu->GetDrawer()->GetBoolean(MeshVS_DA_ShowEdges, boolVal);
-            countShowEdges += boolVal ? 1 : 0;
-            // Show nodes
-            meshVisu->GetDrawer()->GetBoolean(MeshVS_DA_DisplayNodes, boolVal);
-            countShowNodes += boolVal ? 1 : 0;
-
-            m_vecMeshVisu.push_back(meshVisu);
+            auto meshObject = opencascade::handle<GraphicsMeshObject>::DownCast(object);
+            sumColor += meshObject->color();
+            sumEdgeColor += meshObject->edgeColor();
+            countShowEdges += meshObject->isShowEdgesOn() ? 1 : 0;
+            countShowNodes += meshObject->isShowNodesOn() ? 1 : 0;
+            m_vecMeshObject.push_back(meshObject);
         }
 
         auto fnCheckState = [&](int count) {
@@ -331,37 +400,37 @@ public:
 
         if (prop == &m_propertyShowEdges) {
             if (m_propertyShowEdges != Qt::PartiallyChecked) {
-                for (const Handle_MeshVS_Mesh& meshVisu : m_vecMeshVisu) {
-                    meshVisu->GetDrawer()->SetBoolean(MeshVS_DA_ShowEdges, m_propertyShowEdges == Qt::Checked);
-                    fnRedisplay(meshVisu);
+                for (const opencascade::handle<GraphicsMeshObject>& meshObject : m_vecMeshObject) {
+                    meshObject->setShowEdges(m_propertyShowEdges == Qt::Checked);
+                    fnRedisplay(meshObject);
                 }
             }
         }
         else if (prop == &m_propertyShowNodes) {
             if (m_propertyShowNodes != Qt::PartiallyChecked) {
-                for (const Handle_MeshVS_Mesh& meshVisu : m_vecMeshVisu) {
-                    meshVisu->GetDrawer()->SetBoolean(MeshVS_DA_DisplayNodes, m_propertyShowNodes == Qt::Checked);
-                    fnRedisplay(meshVisu);
+                for (const opencascade::handle<GraphicsMeshObject>& meshObject : m_vecMeshObject) {
+                    meshObject->setShowNodes(m_propertyShowNodes == Qt::Checked);
+                    fnRedisplay(meshObject);
                 }
             }
         }
         else if (prop == &m_propertyColor) {
-            for (const Handle_MeshVS_Mesh& meshVisu : m_vecMeshVisu) {
-                meshVisu->GetDrawer()->SetColor(MeshVS_DA_InteriorColor, m_propertyColor);
-                fnRedisplay(meshVisu);
+            for (const opencascade::handle<GraphicsMeshObject>& meshObject : m_vecMeshObject) {
+                meshObject->setColor(m_propertyColor);
+                fnRedisplay(meshObject);
             }
         }
         else if (prop == &m_propertyEdgeColor) {
-            for (const Handle_MeshVS_Mesh& meshVisu : m_vecMeshVisu) {
-                meshVisu->GetDrawer()->SetColor(MeshVS_DA_EdgeColor, m_propertyEdgeColor);
-                fnRedisplay(meshVisu);
+            for (const opencascade::handle<GraphicsMeshObject>& meshObject : m_vecMeshObject) {
+                meshObject->setEdgeColor(m_propertyEdgeColor);
+                fnRedisplay(meshObject);
             }
         }
 
         GraphicsObjectBasePropertyGroup::onPropertyChanged(prop);
     }
 
-    std::vector<Handle_MeshVS_Mesh> m_vecMeshVisu;
+    std::vector<opencascade::handle<GraphicsMeshObject>> m_vecMeshObject;
     PropertyOccColor m_propertyColor{ this, textId("color") };
     PropertyOccColor m_propertyEdgeColor{ this, textId("edgeColor") };
     PropertyCheckState m_propertyShowEdges{ this, textId("showEdges") };
@@ -389,4 +458,108 @@ void GraphicsMeshObjectDriver::setDefaultValues(const DefaultValues& values) {
     *Internal::graphicsMeshDefaultValues = values;
 }
 
+GraphicsPointCloudObjectDriver::GraphicsPointCloudObjectDriver()
+{
+    this->setDisplayModes({
+        { DisplayMode_Points, GraphicsObjectDriverI18N::textId("PointCloud_Points") }
+    });
+    this->setDefaultDisplayMode(DisplayMode_Points);
+    this->setAttributeSignature({ PointCloudAttribute::GetID() });
+}
+
+GraphicsObjectDriver::Support GraphicsPointCloudObjectDriver::supportStatus(const TDF_Label& label) const
+{
+    return CafUtils::hasAttribute<PointCloudAttribute>(label) ? Support::Complete : Support::None;
+}
+
+GraphicsObjectPtr GraphicsPointCloudObjectDriver::createObject(const TDF_Label& label) const
+{
+    auto attrCloud = CafUtils::findAttribute<PointCloudAttribute>(label);
+    if (!attrCloud || !attrCloud->get())
+        return {};
+
+    opencascade::handle<GraphicsPointCloudObject> object = new GraphicsPointCloudObject(attrCloud->get());
+    object->SetDisplayMode(DisplayMode_Points);
+    object->SetOwner(this);
+    return object;
+}
+
+void GraphicsPointCloudObjectDriver::prepareObject(const GraphicsObjectPtr& object) const
+{
+    // Coarse nodes are loaded once at loading, so the cloud shows up before the view refines it
+    auto cloudObject = opencascade::handle<GraphicsPointCloudObject>::DownCast(object);
+    if (cloudObject)
+        cloudObject->initLod(InitialPointBudget);
+}
+
+void GraphicsPointCloudObjectDriver::applyDisplayMode(GraphicsObjectPtr object, Enumeration::Value mode) const
+{
+    this->throwIf_differentDriver(object);
+    this->throwIf_invalidDisplayMode(mode);
+    AIS_InteractiveContext* context = GraphicsUtils::AisObject_contextPtr(object);
+    if (context)
+        context->SetDisplayMode(object, mode, false);
+    else
+        object->SetDisplayMode(mode);
+}
+
+Enumeration::Value GraphicsPointCloudObjectDriver::currentDisplayMode(const GraphicsObjectPtr& object) const
+{
+    this->throwIf_differentDriver(object);
+    return object->DisplayMode();
+}
+
+class GraphicsPointCloudObjectDriver::ObjectProperties : public GraphicsObjectBasePropertyGroup {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::GraphicsPointCloudObjectDriver_ObjectProperties)
+public:
+    ObjectProperties(Span<const GraphicsObjectPtr> spanObject)
+        : GraphicsObjectBasePropertyGroup(spanObject)
+    {
+        NCollection_Vec3<float> sumColor = {};
+        double sumPointSize = 0;
+        for (const GraphicsObjectPtr& object : spanObject) {
+            auto cloudObject = opencascade::handle<GraphicsPointCloudObject>::DownCast(object);
+            sumColor += cloudObject->color();
+            sumPointSize += cloudObject->pointSize();
+            m_vecCloudObject.push_back(cloudObject);
+        }
+
+        // Init properties
+        Mayo_PropertyChangedBlocker(this);
+
+        m_propertyColor.setValue(Quantity_Color(sumColor / float(spanObject.size())));
+        m_propertyPointSize.setValue(sumPointSize / spanObject.size());
+        m_propertyPointSize.setRange(1., 10.);
+        m_propertyPointSize.setConstraintsEnabled(true);
+    }
+
+    void onPropertyChanged(Property* prop) override {
+        if (prop == &m_propertyColor) {
+            for (const opencascade::handle<GraphicsPointCloudObject>& cloudObject : m_vecCloudObject) {
+                cloudObject->setColor(m_propertyColor);
+                cloudObject->Redisplay(true);
+            }
+        }
+        else if (prop == &m_propertyPointSize) {
+            for (const opencascade::handle<GraphicsPointCloudObject>& cloudObject : m_vecCloudObject) {
+                cloudObject->setPointSize(m_propertyPointSize);
+                cloudObject->Redisplay(true);
+            }
+        }
+
+        GraphicsObjectBasePropertyGroup::onPropertyChanged(prop);
+    }
+
+    std::vector<opencascade::handle<GraphicsPointCloudObject>> m_vecCloudObject;
+    PropertyOccColor m_propertyColor{ this, textId("color") };
+    PropertyDouble m_propertyPointSize{ this, textId("pointSize") };
+};
+
+std::unique_ptr<GraphicsObjectBasePropertyGroup>
+GraphicsPointCloudObjectDriver::properties(Span<const GraphicsObjectPtr> spanObject) const
+{
+    this->throwIf_differentDriver(spanObject);
+    return std::make_unique<ObjectProperties>(spanObject);
+}
+
 } // namespace Mayo
@@ -10,11 +10,15 @@
 #include "graphics_object_base_property_group.h"
 #include "../base/enumeration.h"
 #include "../base/property.h"
+#include "../base/quantity.h"
 #include "../base/span.h"
 
+#include <Poly_Triangulation.hxx>
+#include <Standard_GUID.hxx>
 #include <Standard_Transient.hxx>
 #include <TDF_Label.hxx>
 #include <memory>
+#include <vector>
 
 namespace Mayo {
 
@@ -32,8 +36,16 @@ public:
 
     virtual Support supportStatus(const TDF_Label& label) const = 0;
 
+    // IDs of attributes such that a label must hold at least one of them to be supported
+    // Allows to discard the driver without calling supportStatus(), empty means no requirement
+    Span<const Standard_GUID> attributeSignature() const { return m_vecAttributeSignature; }
+
     virtual GraphicsObjectPtr createObject(const TDF_Label& label) const = 0;
 
+    // Computes in advance the data needed by the presentation of 'object'(mesh, styles, ...)
+    // Might be called from a worker thread, so the AIS context must not be accessed
+    virtual void prepareObject(const GraphicsObjectPtr& object) const { (void)object; }
+
     Enumeration::Value defaultDisplayMode() const { return m_defaultDisplayMode; }
     const Enumeration& displayModes() const { return m_enumDisplayModes; }
     virtual void applyDisplayMode(GraphicsObjectPtr object, Enumeration::Value mode) const = 0;
@@ -49,6 +61,7 @@ public:
 protected:
     void setDisplayModes(Enumeration enumeration) { m_enumDisplayModes = std::move(enumeration); }
     void setDefaultDisplayMode(Enumeration::Value mode) { m_defaultDisplayMode = mode; }
+    void setAttributeSignature(std::vector<Standard_GUID> vecAttrId) { m_vecAttributeSignature = std::move(vecAttrId); }
     void throwIf_invalidDisplayMode(Enumeration::Value mode) const;
     void throwIf_differentDriver(const GraphicsObjectPtr& object) const;
     void throwIf_differentDriver(Span<const GraphicsObjectPtr> objects) const;
@@ -56,6 +69,7 @@ protected:
 private:
     Enumeration m_enumDisplayModes;
     Enumeration::Value m_defaultDisplayMode = -1;
+    std::vector<Standard_GUID> m_vecAttributeSignature;
 };
 
 class GraphicsShapeObjectDriver : public GraphicsObjectDriver {
@@ -64,6 +78,7 @@ public:
 
     Support supportStatus(const TDF_Label& label) const override;
     GraphicsObjectPtr createObject(const TDF_Label& label) const override;
+    void prepareObject(const GraphicsObjectPtr& object) const override;
     void applyDisplayMode(GraphicsObjectPtr object, Enumeration::Value mode) const override;
     Enumeration::Value currentDisplayMode(const GraphicsObjectPtr& object) const override;
     std::unique_ptr<GraphicsObjectBasePropertyGroup> properties(Span<const GraphicsObjectPtr> spanObject) const override;
@@ -82,12 +97,14 @@ public:
 
     Support supportStatus(const TDF_Label& label) const override;
     GraphicsObjectPtr createObject(const TDF_Label& label) const override;
+    void prepareObject(const GraphicsObjectPtr& object) const override;
     void applyDisplayMode(GraphicsObjectPtr object, Enumeration::Value mode) const override;
     Enumeration::Value currentDisplayMode(const GraphicsObjectPtr& object) const override;
     std::unique_ptr<GraphicsObjectBasePropertyGroup> properties(Span<const GraphicsObjectPtr> spanObject) const override;
 
     struct DefaultValues {
-        bool showEdges = false;
+        bool showEdges = false; // Feature edges, see MeshUtils::featureEdges()
+        double edgeCreaseAngle = 30 * Quantity_Degree.value(); // Radians
         bool showNodes = false;
         Graphic3d_NameOfMaterial material = Graphic3d_NOM_PLASTIC;
         Quantity_Color color = Quantity_NOC_BISQUE;
@@ -96,6 +113,32 @@ public:
     static const DefaultValues& defaultValues();
     static void setDefaultValues(const DefaultValues& values);
 
+    // Makes mesh 'object' display 'mesh' instead, presentation has then to be recomputed
+    static void setObjectMesh(const GraphicsObjectPtr& object, const Handle_Poly_Triangulation& mesh);
+
+private:
+    class ObjectProperties;
+};
+
+// Driver of labels holding a PointCloudAttribute, see GraphicsPointCloudObject
+class GraphicsPointCloudObjectDriver : public GraphicsObjectDriver {
+public:
+    GraphicsPointCloudObjectDriver();
+
+    Support supportStatus(const TDF_Label& label) const override;
+    GraphicsObjectPtr createObject(const TDF_Label& label) const override;
+    void prepareObject(const GraphicsObjectPtr& object) const override;
+    void applyDisplayMode(GraphicsObjectPtr object, Enumeration::Value mode) const override;
+    Enumeration::Value currentDisplayMode(const GraphicsObjectPtr& object) const override;
+    std::unique_ptr<GraphicsObjectBasePropertyGroup> properties(Span<const GraphicsObjectPtr> spanObject) const override;
+
+    enum DisplayMode {
+        DisplayMode_Points
+    };
+
+    // Count of points displayed by an object before the view refines it, see GraphicsPointCloudObject::initLod()
+    static constexpr uint64_t InitialPointBudget = 1000 * 1000;
+
 private:
     class ObjectProperties;
 };
@@ -7,6 +7,10 @@
 #include "graphics_object_driver_table.h"
 #include "graphics_object_driver.h"
 
+#include <TDF_Attribute.hxx>
+#include <algorithm>
+#include <utility>
+
 namespace Mayo {
 
 void GraphicsObjectDriverTable::addDriver(DriverPtr driver)
@@ -19,22 +23,46 @@ void GraphicsObjectDriverTable::addDriver(std::unique_ptr<GraphicsObjectDriver>
     m_vecDriver.push_back(driver.release());
 }
 
-GraphicsObjectPtr GraphicsObjectDriverTable::createObject(const TDF_Label& label) const
+GraphicsObjectDriverTable::DriverPtr GraphicsObjectDriverTable::findDriver(const TDF_Label& label) const
 {
-    GraphicsObjectDriver* driverPartialSupport = nullptr;
+    // Drivers usually share attributes in their signatures, presence is looked up once per ID
+    std::vector<std::pair<Standard_GUID, bool>> vecAttrPresence;
+    auto fnHasAttribute = [&](const Standard_GUID& attrId) {
+        for (const auto& pairAttr : vecAttrPresence) {
+            if (pairAttr.first == attrId)
+                return pairAttr.second;
+        }
+
+        Handle_TDF_Attribute attr;
+        const bool hasAttr = label.FindAttribute(attrId, attr);
+        vecAttrPresence.push_back({ attrId, hasAttr });
+        return hasAttr;
+    };
+    auto fnMatchSignature = [&](const DriverPtr& driver) {
+        const Span<const Standard_GUID> signature = driver->attributeSignature();
+        return signature.empty() || std::any_of(signature.begin(), signature.end(), fnHasAttribute);
+    };
+
+    DriverPtr driverPartialSupport;
     for (const DriverPtr& driver : m_vecDriver) {
+        if (!fnMatchSignature(driver))
+            continue;
+
         const GraphicsObjectDriver::Support support = driver->supportStatus(label);
         if (support == GraphicsObjectDriver::Support::Complete)
-            return driver->createObject(label);
+            return driver;
 
         if (support == GraphicsObjectDriver::Support::Partial)
-            driverPartialSupport = driver.get();
+            driverPartialSupport = driver;
     }
 
-    if (driverPartialSupport)
-        return driverPartialSupport->createObject(label);
-    else
-        return {};
+    return driverPartialSupport;
+}
+
+GraphicsObjectPtr GraphicsObjectDriverTable::createObject(const TDF_Label& label) const
+{
+    const DriverPtr driver = this->findDriver(label);
+    return driver ? driver->createObject(label) : GraphicsObjectPtr();
 }
 
 } // namespace Mayo
@@ -21,6 +21,8 @@ public:
     void addDriver(std::unique_ptr<GraphicsObjectDriver> driver);
     Span<const DriverPtr> drivers() const { return m_vecDriver; }
 
+    // Returns the driver best supporting 'label'(complete support first), null if none
+    DriverPtr findDriver(const TDF_Label& label) const;
     GraphicsObjectPtr createObject(const TDF_Label& label) const;
 
 private:
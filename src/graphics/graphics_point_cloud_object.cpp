@@ -0,0 +1,274 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "graphics_point_cloud_object.h"
+
+#include "../base/cpp_utils.h"
+#include "../base/quantity.h"
+
+#include <Graphic3d_AspectMarker3d.hxx>
+#include <Graphic3d_Group.hxx>
+#include <Select3D_SensitiveBox.hxx>
+#include <SelectMgr_EntityOwner.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <unordered_set>
+#include <utility>
+
+namespace Mayo {
+
+namespace {
+
+// Size(in pixels) of the bounding sphere of a node cube projected in the view
+double projectedNodeSize(const Graphic3d_Camera& camera, const gp_Pnt& center, double halfSize, int viewHeight)
+{
+    const double radius = halfSize * std::sqrt(3.);
+    double viewPlaneHeight = camera.Scale(); // Height of the view plane in model units
+    if (!camera.IsOrthographic()) {
+        const double distance = camera.Eye().Distance(center);
+        if (distance <= radius)
+            return std::numeric_limits<double>::max(); // Camera inside the node
+
+        viewPlaneHeight = 2 * distance * std::tan(0.5 * camera.FOVy() * Quantity_Degree.value());
+    }
+
+    return viewPlaneHeight > 0 ? (2 * radius * viewHeight) / viewPlaneHeight : 0.;
+}
+
+// Whether the node cube is fully outside the side planes of the view frustum. Corners of the cube
+// are projected in normalized device coordinates, the cube is outside if all corners are beyond
+// a same side. Cubes crossing the camera plane are considered visible
+bool isNodeOutsideView(const Graphic3d_Camera& camera, const gp_Pnt& center, double halfSize)
+{
+    int outsideMask = 0xF;
+    for (int i = 0; i < 8; ++i) {
+        const gp_Pnt corner(
+                    center.X() + ((i & 1) ? halfSize : -halfSize),
+                    center.Y() + ((i & 2) ? halfSize : -halfSize),
+                    center.Z() + ((i & 4) ? halfSize : -halfSize));
+        if (!camera.IsOrthographic() && gp_Vec(camera.Eye(), corner).Dot(gp_Vec(camera.Direction())) <= 0)
+            return false;
+
+        const gp_Pnt ndc = camera.Project(corner);
+        const int cornerMask =
+                (ndc.X() < -1 ? 1 : 0) | (ndc.X() > 1 ? 2 : 0) | (ndc.Y() < -1 ? 4 : 0) | (ndc.Y() > 1 ? 8 : 0);
+        outsideMask &= cornerMask;
+        if (!outsideMask)
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+GraphicsPointCloudObject::GraphicsPointCloudObject(const PointCloudPtr& cloud)
+    : m_cloud(cloud)
+{
+}
+
+void GraphicsPointCloudObject::initLod(uint64_t pointBudget)
+{
+    m_vecDisplayedNodeId.clear();
+    m_displayedPointCount = 0;
+    if (!m_cloud || m_cloud->rootNodeId() < 0)
+        return;
+
+    // Breadth-first, so the whole cloud is covered by coarse nodes
+    std::vector<int> vecNodeId;
+    std::queue<int> queueNodeId;
+    queueNodeId.push(m_cloud->rootNodeId());
+    uint64_t pointCount = 0;
+    while (!queueNodeId.empty()) {
+        const PointCloud::Node& node = m_cloud->node(queueNodeId.front());
+        if (pointCount + node.pointCount > pointBudget)
+            break;
+
+        vecNodeId.push_back(queueNodeId.front());
+        pointCount += node.pointCount;
+        queueNodeId.pop();
+        for (int childId : node.children) {
+            if (childId >= 0)
+                queueNodeId.push(childId);
+        }
+    }
+
+    std::vector<Handle_Graphic3d_ArrayOfPoints> vecArray(vecNodeId.size());
+    CppUtils::parallelFor(int(vecNodeId.size()), [&](int i) {
+        vecArray.at(i) = GraphicsPointCloudObject::createNodePoints(*m_cloud, vecNodeId.at(i));
+    });
+
+    for (unsigned i = 0; i < vecNodeId.size(); ++i) {
+        m_mapNodeArray.insert({ vecNodeId.at(i), vecArray.at(i) });
+        m_cachedPointCount += m_cloud->node(vecNodeId.at(i)).pointCount;
+    }
+
+    std::sort(vecNodeId.begin(), vecNodeId.end());
+    m_vecDisplayedNodeId = std::move(vecNodeId);
+    m_displayedPointCount = pointCount;
+}
+
+GraphicsPointCloudObject::LodResult GraphicsPointCloudObject::updateLod(
+        const Handle_Graphic3d_Camera& camera, int viewHeight, const LodParameters& params)
+{
+    LodResult result;
+    if (!m_cloud || m_cloud->rootNodeId() < 0 || !camera || viewHeight <= 0)
+        return result;
+
+    const PointCloud& cloud = *m_cloud;
+    const gp_Trsf& trsf = this->Transformation();
+    const double trsfScale = std::abs(trsf.ScaleFactor());
+
+    // Nodes appearing the biggest are selected first, until the point budget is reached
+    using NodeItem = std::pair<double, int>; // Projected size and node id
+    std::priority_queue<NodeItem> queueNode;
+    auto fnPushNode = [&](int nodeId) {
+        const PointCloud::Node& node = cloud.node(nodeId);
+        const gp_Pnt center = node.center.Transformed(trsf);
+        const double halfSize = node.halfSize * trsfScale;
+        if (!isNodeOutsideView(*camera, center, halfSize))
+            queueNode.push({ projectedNodeSize(*camera, center, halfSize, viewHeight), nodeId });
+    };
+
+    std::vector<int> vecNodeId;
+    fnPushNode(cloud.rootNodeId());
+    while (!queueNode.empty()) {
+        const NodeItem item = queueNode.top();
+        queueNode.pop();
+        const PointCloud::Node& node = cloud.node(item.second);
+        if (result.pointCount + node.pointCount > params.pointBudget)
+            break;
+
+        vecNodeId.push_back(item.second);
+        result.pointCount += node.pointCount;
+        if (item.first < params.minNodePixelSize)
+            continue;
+
+        for (int childId : node.children) {
+            if (childId >= 0)
+                fnPushNode(childId);
+        }
+    }
+
+    // Load the nodes not cached yet, in order of priority within the load budget. Nodes left are
+    // loaded by next updates
+    std::vector<int> vecLoadNodeId;
+    uint64_t loadPointCount = 0;
+    for (int nodeId : vecNodeId) {
+        if (m_mapNodeArray.find(nodeId) != m_mapNodeArray.cend())
+            continue;
+
+        const uint64_t nodePointCount = cloud.node(nodeId).pointCount;
+        if (!vecLoadNodeId.empty() && loadPointCount + nodePointCount > params.loadBudget) {
+            result.pending = true;
+            break;
+        }
+
+        vecLoadNodeId.push_back(nodeId);
+        loadPointCount += nodePointCount;
+    }
+
+    std::vector<Handle_Graphic3d_ArrayOfPoints> vecArray(vecLoadNodeId.size());
+    CppUtils::parallelFor(int(vecLoadNodeId.size()), [&](int i) {
+        vecArray.at(i) = GraphicsPointCloudObject::createNodePoints(cloud, vecLoadNodeId.at(i));
+    });
+
+    for (unsigned i = 0; i < vecLoadNodeId.size(); ++i) {
+        m_mapNodeArray.insert({ vecLoadNodeId.at(i), vecArray.at(i) });
+        m_cachedPointCount += cloud.node(vecLoadNodeId.at(i)).pointCount;
+    }
+
+    // Only cached nodes are displayed
+    vecNodeId.erase(std::remove_if(vecNodeId.begin(), vecNodeId.end(), [=](int nodeId) {
+        return m_mapNodeArray.find(nodeId) == m_mapNodeArray.cend();
+    }), vecNodeId.end());
+
+    std::sort(vecNodeId.begin(), vecNodeId.end());
+    result.changed = vecNodeId != m_vecDisplayedNodeId;
+    if (result.changed) {
+        m_displayedPointCount = 0;
+        for (int nodeId : vecNodeId)
+            m_displayedPointCount += cloud.node(nodeId).pointCount;
+
+        m_vecDisplayedNodeId = std::move(vecNodeId);
+    }
+
+    this->releaseCache(2 * params.pointBudget);
+    return result;
+}
+
+void GraphicsPointCloudObject::ComputeSelection(const opencascade::handle<SelectMgr_Selection>& sel, const int mode)
+{
+    if (mode != 0 || !m_cloud || m_cloud->boundingBox().IsVoid())
+        return;
+
+    Handle_SelectMgr_EntityOwner owner = new SelectMgr_EntityOwner(this);
+    sel->Add(new Select3D_SensitiveBox(owner, m_cloud->boundingBox()));
+}
+
+Handle_Graphic3d_ArrayOfPoints GraphicsPointCloudObject::createNodePoints(const PointCloud& cloud, int nodeId)
+{
+    const std::vector<PointCloud::Point> vecPoint = cloud.nodePoints(nodeId);
+    if (vecPoint.empty())
+        return {};
+
+    const bool hasColors = cloud.hasColors();
+    const gp_Pnt& origin = cloud.origin();
+    Handle_Graphic3d_ArrayOfPoints array = new Graphic3d_ArrayOfPoints(int(vecPoint.size()), hasColors);
+    for (const PointCloud::Point& point : vecPoint) {
+        const int index = array->AddVertex(origin.X() + point.x, origin.Y() + point.y, origin.Z() + point.z);
+        if (hasColors) {
+            const Graphic3d_Vec4ub color(
+                        Standard_Byte((point.rgb >> 16) & 0xFF),
+                        Standard_Byte((point.rgb >> 8) & 0xFF),
+                        Standard_Byte(point.rgb & 0xFF),
+                        255);
+            array->SetVertexColor(index, color);
+        }
+    }
+
+    return array;
+}
+
+void GraphicsPointCloudObject::Compute(
+        const opencascade::handle<PrsMgr_PresentationManager3d>&,
+        const opencascade::handle<Prs3d_Presentation>& prs,
+        const int mode)
+{
+    if (mode != 0 || m_vecDisplayedNodeId.empty())
+        return;
+
+    opencascade::handle<Graphic3d_Group> group = prs->NewGroup();
+    group->SetGroupPrimitivesAspect(new Graphic3d_AspectMarker3d(Aspect_TOM_POINT, m_color, m_pointSize));
+    for (int nodeId : m_vecDisplayedNodeId) {
+        auto itArray = m_mapNodeArray.find(nodeId);
+        if (itArray != m_mapNodeArray.cend() && itArray->second)
+            group->AddPrimitiveArray(itArray->second);
+    }
+}
+
+void GraphicsPointCloudObject::releaseCache(uint64_t maxPointCount)
+{
+    if (m_cachedPointCount <= maxPointCount)
+        return;
+
+    // Arrays of the nodes not displayed are released
+    const std::unordered_set<int> setDisplayedNodeId(m_vecDisplayedNodeId.cbegin(), m_vecDisplayedNodeId.cend());
+    for (auto it = m_mapNodeArray.begin(); it != m_mapNodeArray.end();) {
+        if (setDisplayedNodeId.find(it->first) == setDisplayedNodeId.cend()) {
+            m_cachedPointCount -= m_cloud->node(it->first).pointCount;
+            it = m_mapNodeArray.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+} // namespace Mayo
@@ -0,0 +1,105 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/point_cloud.h"
+#include "../base/tkernel_utils.h"
+
+#include <AIS_InteractiveObject.hxx>
+#include <Graphic3d_ArrayOfPoints.hxx>
+#include <Graphic3d_Camera.hxx>
+#include <Prs3d_Presentation.hxx>
+#include <PrsMgr_PresentationManager3d.hxx>
+#include <Quantity_Color.hxx>
+#include <SelectMgr_Selection.hxx>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+#  include <Prs3d_Projector.hxx>
+#endif
+
+namespace Mayo {
+
+// Presentation of a PointCloud, only a subset of the octree nodes is displayed: the ones visible
+// in the view camera, coarse nodes first, refined while their projected size is big enough and
+// the point budget isn't reached. See updateLod()
+// Points of displayed nodes are cached as primitive arrays, the whole cloud is selected in mode 0
+// with its bounding box
+class GraphicsPointCloudObject : public AIS_InteractiveObject {
+public:
+    GraphicsPointCloudObject(const PointCloudPtr& cloud);
+
+    const PointCloudPtr& cloud() const { return m_cloud; }
+
+    // Attributes, presentations have then to be recomputed
+    // Color of the points if the cloud has no colors
+    const Quantity_Color& color() const { return m_color; }
+    void setColor(const Quantity_Color& color) { m_color = color; }
+
+    double pointSize() const { return m_pointSize; }
+    void setPointSize(double size) { m_pointSize = size; }
+
+    struct LodParameters {
+        uint64_t pointBudget = 5 * 1000 * 1000; // Maximum count of points displayed
+        uint64_t loadBudget = 1000 * 1000; // Maximum count of points loaded by one update
+        double minNodePixelSize = 96; // Nodes whose projected size is smaller aren't refined
+    };
+
+    struct LodResult {
+        bool changed = false; // Displayed nodes changed, presentation has to be recomputed
+        bool pending = false; // Some nodes still have to be loaded, another update is needed
+        uint64_t pointCount = 0; // Count of points selected for display
+    };
+
+    // Selects the coarse nodes of the octree(breadth-first) within 'pointBudget' and loads them, so
+    // the cloud can be displayed before any view is known. Can be called from a worker thread if
+    // the object isn't displayed yet
+    void initLod(uint64_t pointBudget);
+
+    // Selects the octree nodes to display for 'camera' and a view of 'viewHeight' pixels
+    // Nodes not cached yet are loaded concurrently, within 'params.loadBudget'
+    LodResult updateLod(const Handle_Graphic3d_Camera& camera, int viewHeight, const LodParameters& params);
+
+    // Count of the points currently displayed
+    uint64_t displayedPointCount() const { return m_displayedPointCount; }
+
+    bool AcceptDisplayMode(const int mode) const override { return mode == 0; }
+    void ComputeSelection(const opencascade::handle<SelectMgr_Selection>& sel, const int mode) override;
+
+    // Primitive array of the points of node 'nodeId', can be called from any thread
+    static Handle_Graphic3d_ArrayOfPoints createNodePoints(const PointCloud& cloud, int nodeId);
+
+    DEFINE_STANDARD_RTTI_INLINE(GraphicsPointCloudObject, AIS_InteractiveObject)
+
+protected:
+    void Compute(
+            const opencascade::handle<PrsMgr_PresentationManager3d>& prsMgr,
+            const opencascade::handle<Prs3d_Presentation>& prs,
+            const int mode) override;
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 5, 0)
+    void Compute(
+            const opencascade::handle<Prs3d_Projector>&,
+            const opencascade::handle<Prs3d_Presentation>&) override
+    {}
+#endif
+
+private:
+    void releaseCache(uint64_t maxPointCount);
+
+    PointCloudPtr m_cloud;
+    Quantity_Color m_color = Quantity_NOC_WHITE;
+    double m_pointSize = 2.;
+    std::vector<int> m_vecDisplayedNodeId;
+    uint64_t m_displayedPointCount = 0;
+    std::unordered_map<int, Handle_Graphic3d_ArrayOfPoints> m_mapNodeArray; // Cache
+    uint64_t m_cachedPointCount = 0;
+};
+
+} // namespace Mayo
@@ -7,21 +7,38 @@
 #include "graphics_scene.h"
 
 #include "../base/tkernel_utils.h"
+#include "graphics_mesh_object.h"
 #include "graphics_utils.h"
 
-#include <Graphic3d_GraphicDriver.hxx>
+#include <AIS_Shape.hxx>
+#include <Graphic3d_AspectFillArea3d.hxx>
+#include <Graphic3d_PresentationAttributes.hxx>
+#include <Graphic3d_WorldViewProjState.hxx>
+#include <Image_PixMap.hxx>
+#include <SelectMgr_Selection.hxx>
+#include <SelectMgr_SelectionManager.hxx>
+#include <StdSelect_ViewerSelector3d.hxx>
+#include <TColgp_Array1OfPnt2d.hxx>
+#include <TColStd_ListOfInteger.hxx>
+#include <V3d_ImageDumpOptions.hxx>
 #include <V3d_TypeOfOrientation.hxx>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QPoint>
+#include <QtCore/QTimer>
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <vector>
 
 namespace Mayo {
 namespace Internal {
 
-// Defined in graphics_create_driver.cpp
+// Defined in gui_create_gfx_driver.cpp
 Handle_Graphic3d_GraphicDriver createGfxDriver();
 
-static Handle_V3d_Viewer createOccViewer()
+static Handle_V3d_Viewer createOccViewer(const Handle_Graphic3d_GraphicDriver& gfxDriver)
 {
-    Handle_V3d_Viewer viewer = new V3d_Viewer(createGfxDriver());
+    Handle_V3d_Viewer viewer = new V3d_Viewer(gfxDriver);
     viewer->SetDefaultViewSize(1000.);
     viewer->SetDefaultViewProj(V3d_XposYnegZpos);
     viewer->SetComputedMode(true);
@@ -45,10 +62,63 @@ public:
     {}
 
     constexpr const GraphicsOwnerPtr& member_myLastPicked() const { return myLastPicked; }
+    const auto& member_myFilters() const { return myFilters; }
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    // Makes 'owner' the detected owner, as MoveTo() does with the owner found by the main selector
+    void setDetectedOwner(const GraphicsOwnerPtr& owner, const Handle_V3d_View& view)
+    {
+        if (owner == myLastPicked)
+            return;
+
+        if (!myLastPicked.IsNull() && myAutoHilight)
+            this->clearDynamicHighlight();
+
+        myDetectedSeq.Clear();
+        myCurDetected = 0;
+        myLastPicked = owner;
+        if (!owner.IsNull() && myAutoHilight && (!owner->IsSelected() || myToHilightSelected))
+            this->highlightWithColor(owner, view->Viewer());
+
+        view->Viewer()->RedrawImmediate();
+    }
+#endif
 };
 
 DEFINE_STANDARD_HANDLE(InteractiveContext, AIS_InteractiveContext)
 
+// Object ids are encoded in the 24 bits of RGB colors: 20 bits for the id and 4 bits of checksum,
+// so pixels not drawn with an id color(eg text, highlighted sub-shapes) are most likely rejected
+constexpr uint32_t IdBuffer_NullId = 0; // Background
+constexpr uint32_t IdBuffer_CpuPickingId = (1 << 20) - 1; // Object requiring the selection BVH
+constexpr uint32_t IdBuffer_InvalidId = std::numeric_limits<uint32_t>::max();
+
+uint32_t IdBuffer_checksum(uint32_t id)
+{
+    return ((id ^ (id >> 4) ^ (id >> 8) ^ (id >> 12) ^ (id >> 16)) & 0xF) ^ 0xA;
+}
+
+Quantity_Color IdBuffer_color(uint32_t id)
+{
+    const uint32_t rgb = id != IdBuffer_NullId ? (id << 4) | IdBuffer_checksum(id) : 0;
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    constexpr Quantity_TypeOfColor colorType = Quantity_TOC_sRGB; // Framebuffer is sRGB
+#else
+    constexpr Quantity_TypeOfColor colorType = Quantity_TOC_RGB;
+#endif
+    return Quantity_Color(((rgb >> 16) & 0xFF) / 255., ((rgb >> 8) & 0xFF) / 255., (rgb & 0xFF) / 255., colorType);
+}
+
+uint32_t IdBuffer_decode(const uint8_t* rgb)
+{
+    const uint32_t value = (uint32_t(rgb[0]) << 16) | (uint32_t(rgb[1]) << 8) | uint32_t(rgb[2]);
+    const uint32_t id = value >> 4;
+    if (value == 0)
+        return IdBuffer_NullId;
+
+    return (value & 0xF) == IdBuffer_checksum(id) ? id : IdBuffer_InvalidId;
+}
+
 } // namespace
 
 class GraphicsScene::Private {
@@ -57,15 +127,423 @@ public:
     Handle_InteractiveContext m_aisContext;
     std::unordered_set<const AIS_InteractiveObject*> m_setClipPlaneSensitive;
     bool m_isRedrawBlocked = false;
+    QTimer* m_timerRedraw = nullptr;
+    QElapsedTimer m_chronoRedraw;
+    int m_redrawInterval = 16;
     SelectionMode m_selectionMode = SelectionMode::Single;
+    TransparencyMethod m_transparencyMethod = TransparencyMethod::Blended;
+
+    // Objects made transparent by ghostNonSelectedObjects(), with their transparency on entry
+    struct GhostedObject {
+        GraphicsObjectPtr object;
+        bool hadTransparency;
+        double transparency;
+    };
+    std::vector<GhostedObject> m_vecGhostedObject;
+
+    void applyTransparencyMethod(const Handle_V3d_View& view) const;
+
+    // Last highlightAt() query, detection can't change until the cursor, the camera or the scene changes
+    struct HighlightQuery {
+        QPoint pos;
+        const V3d_View* view = nullptr;
+        Graphic3d_WorldViewProjState cameraState;
+    };
+    std::optional<HighlightQuery> m_lastHighlightQuery;
+
+    // Offscreen rendering of object ids, see GraphicsScene::setIdBufferPickingEnabled()
+    struct IdBuffer {
+        Image_PixMap colorImage;
+        Image_PixMap depthImage;
+        const V3d_View* view = nullptr;
+        Graphic3d_WorldViewProjState cameraState;
+        std::vector<GraphicsObjectPtr> vecObject; // Object of id 'i' is at index 'i - 1'
+        bool isValid = false;
+    };
+    bool m_isIdBufferPickingEnabled = false;
+    IdBuffer m_idBuffer;
+    // Camera at previous highlightAt() call, the id buffer is rendered only if the camera didn't move
+    std::optional<Graphic3d_WorldViewProjState> m_prevHighlightCameraState;
+    bool m_isHighlightFromIdBuffer = false;
+    std::optional<gp_Pnt> m_idBufferHighlightedPoint;
+
+    void resetPickingCache() {
+        m_lastHighlightQuery.reset();
+        m_idBuffer.isValid = false;
+    }
+
+    // Objects where the lazy sub-shape selection mode is active
+    int m_lazySubShapeMode = -1;
+    std::vector<GraphicsObjectPtr> m_vecLazyActivatedObject;
+    // Selection modes to be deactivated in the background
+    struct LazyModeRelease {
+        GraphicsObjectPtr object;
+        int mode;
+    };
+    std::vector<LazyModeRelease> m_vecLazyModeRelease;
+    QTimer* m_timerLazyModeRelease = nullptr;
+
+    bool isLazyActivated(const GraphicsObjectPtr& object) const {
+        const auto& vec = m_vecLazyActivatedObject;
+        return std::find(vec.cbegin(), vec.cend(), object) != vec.cend();
+    }
+
+    GraphicsObjectPtr lazySubShapeCandidate(const GraphicsOwnerPtr& owner) const;
+    void activateLazySubShapeMode(const GraphicsObjectPtr& object);
+    void releaseLazyModes(int maxCount);
+
+    // Objects drawn with a silhouette, see GraphicsScene::setSelectionOutlineEnabled()
+    struct OutlinedObject {
+        GraphicsObjectPtr object;
+        struct GroupAspects {
+            Handle_Graphic3d_Group group;
+            Handle_Graphic3d_Aspects aspects; // On entry
+        };
+        std::vector<GroupAspects> vecGroupAspects;
+    };
+    bool m_isSelectionOutlineEnabled = false;
+    bool m_isSelectionOutlineDirty = false;
+    std::vector<OutlinedObject> m_vecOutlinedObject;
+
+    void updateSelectionOutlines();
+    // Restores aspects of 'object' if outlined, must be called when its presentations change
+    void dropOutline(const GraphicsObjectPtr& object);
+    void outlineObject(const GraphicsObjectPtr& object);
+    static void restoreOutlinedObject(const OutlinedObject& outlined);
+
+    bool isIdBufferPickable(const GraphicsObjectPtr& object) const;
+    bool renderIdBuffer(const Handle_V3d_View& view);
+    bool highlightWithIdBuffer(const QPoint& pos, const Handle_V3d_View& view);
 };
 
+void GraphicsScene::Private::applyTransparencyMethod(const Handle_V3d_View& view) const
+{
+    Graphic3d_RenderingParams& params = view->ChangeRenderingParams();
+    switch (m_transparencyMethod) {
+    case TransparencyMethod::Blended:
+        params.TransparencyMethod = Graphic3d_RTM_BLEND_UNORDERED;
+        break;
+    case TransparencyMethod::WeightedOit:
+        params.TransparencyMethod = Graphic3d_RTM_BLEND_OIT;
+        break;
+    case TransparencyMethod::DepthPeeling:
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+        params.TransparencyMethod = Graphic3d_RTM_DEPTH_PEELING_OIT;
+#else
+        params.TransparencyMethod = Graphic3d_RTM_BLEND_OIT;
+#endif
+        break;
+    }
+
+    view->Invalidate();
+}
+
+GraphicsObjectPtr GraphicsScene::Private::lazySubShapeCandidate(const GraphicsOwnerPtr& owner) const
+{
+    if (m_lazySubShapeMode < 0 || !owner)
+        return {};
+
+    auto object = GraphicsObjectPtr::DownCast(owner->Selectable());
+    if (!object || !object->IsKind(STANDARD_TYPE(AIS_Shape)) || this->isLazyActivated(object))
+        return {};
+
+    return object;
+}
+
+void GraphicsScene::Private::activateLazySubShapeMode(const GraphicsObjectPtr& object)
+{
+    const int globalMode = object->GlobalSelectionMode();
+    if (m_lazySubShapeMode != globalMode)
+        m_aisContext->Deactivate(object, globalMode);
+
+    m_aisContext->Activate(object, m_lazySubShapeMode);
+    // Sensitive entities might have been cleared by releaseLazyModes()
+    const Handle_SelectMgr_Selection& selection = object->Selection(m_lazySubShapeMode);
+    if (!selection.IsNull() && selection->IsEmpty())
+        m_aisContext->SelectionManager()->RecomputeSelection(object, true, m_lazySubShapeMode);
+
+    m_vecLazyActivatedObject.push_back(object);
+}
+
+void GraphicsScene::Private::releaseLazyModes(int maxCount)
+{
+    const Handle_SelectMgr_SelectionManager& selMgr = m_aisContext->SelectionManager();
+    for (int i = 0; i < maxCount && !m_vecLazyModeRelease.empty(); ++i) {
+        const LazyModeRelease release = m_vecLazyModeRelease.back();
+        m_vecLazyModeRelease.pop_back();
+        if (release.mode == m_lazySubShapeMode && this->isLazyActivated(release.object))
+            continue; // Activated again meanwhile
+
+        if (release.mode == release.object->GlobalSelectionMode())
+            continue;
+
+        m_aisContext->Deactivate(release.object, release.mode);
+        if (release.object->HasSelection(release.mode)) {
+            if (selMgr->Contains(release.object))
+                selMgr->ClearSelectionStructures(release.object, release.mode);
+
+            release.object->Selection(release.mode)->Clear();
+        }
+    }
+}
+
+void GraphicsScene::Private::updateSelectionOutlines()
+{
+    m_isSelectionOutlineDirty = false;
+    std::unordered_set<const AIS_InteractiveObject*> setSelectedObject;
+    if (m_isSelectionOutlineEnabled) {
+        for (m_aisContext->InitSelected(); m_aisContext->MoreSelected(); m_aisContext->NextSelected()) {
+            const GraphicsOwnerPtr& owner = m_aisContext->SelectedOwner();
+            auto object = GraphicsObjectPtr::DownCast(owner->Selectable());
+            // Objects not auto-highlighted(eg batched objects) draw their own selection
+            if (object && object->IsAutoHilight() && owner == object->GlobalSelOwner())
+                setSelectedObject.insert(object.get());
+        }
+    }
+
+    // Outline of objects no longer selected
+    auto itOutlinedEnd = std::remove_if(
+                m_vecOutlinedObject.begin(), m_vecOutlinedObject.end(), [&](const OutlinedObject& outlined) {
+        if (setSelectedObject.erase(outlined.object.get()) != 0)
+            return false; // Still selected and already outlined
+
+        Private::restoreOutlinedObject(outlined);
+        return true;
+    });
+    m_vecOutlinedObject.erase(itOutlinedEnd, m_vecOutlinedObject.end());
+
+    // Outline of newly selected objects, 'setSelectedObject' only contains them now
+    if (!setSelectedObject.empty()) {
+        for (m_aisContext->InitSelected(); m_aisContext->MoreSelected(); m_aisContext->NextSelected()) {
+            auto object = GraphicsObjectPtr::DownCast(m_aisContext->SelectedOwner()->Selectable());
+            if (object && setSelectedObject.erase(object.get()) != 0)
+                this->outlineObject(object);
+        }
+    }
+}
+
+void GraphicsScene::Private::outlineObject(const GraphicsObjectPtr& object)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    const Quantity_Color outlineColor = m_aisContext->SelectionStyle()->Color();
+    OutlinedObject outlined;
+    outlined.object = object;
+    for (const Handle_PrsMgr_Presentation& prs : object->Presentations()) {
+        // Silhouette replaces the highlight color set by AIS, no extra presentation is drawn
+        if (prs->IsHighlighted())
+            prs->Graphic3d_Structure::UnHighlight();
+
+        for (const Handle_Graphic3d_Group& group : prs->Groups()) {
+            auto fillAreaAspects = Handle_Graphic3d_AspectFillArea3d::DownCast(group->Aspects());
+            if (!fillAreaAspects || !group->ContainsFacet())
+                continue;
+
+            // Aspects are usually shared by many objects(eg default drawer), so they are copied
+            Handle_Graphic3d_AspectFillArea3d outlineAspects = new Graphic3d_AspectFillArea3d(*fillAreaAspects);
+            outlineAspects->SetDrawSilhouette(true);
+            outlineAspects->SetEdgeColor(outlineColor);
+            outlineAspects->SetEdgeWidth(2.);
+            group->SetGroupPrimitivesAspect(outlineAspects);
+            outlined.vecGroupAspects.push_back({ group, fillAreaAspects });
+        }
+    }
+
+    m_vecOutlinedObject.push_back(std::move(outlined));
+#else
+    Q_UNUSED(object);
+#endif
+}
+
+void GraphicsScene::Private::dropOutline(const GraphicsObjectPtr& object)
+{
+    auto itOutlined = std::find_if(
+                m_vecOutlinedObject.begin(), m_vecOutlinedObject.end(), [&](const OutlinedObject& outlined) {
+        return outlined.object == object;
+    });
+    if (itOutlined != m_vecOutlinedObject.end()) {
+        Private::restoreOutlinedObject(*itOutlined);
+        m_vecOutlinedObject.erase(itOutlined);
+        m_isSelectionOutlineDirty = true;
+    }
+}
+
+void GraphicsScene::Private::restoreOutlinedObject(const OutlinedObject& outlined)
+{
+    for (const OutlinedObject::GroupAspects& groupAspects : outlined.vecGroupAspects)
+        groupAspects.group->SetGroupPrimitivesAspect(groupAspects.aspects);
+}
+
+bool GraphicsScene::Private::isIdBufferPickable(const GraphicsObjectPtr& object) const
+{
+    if (!object->IsKind(STANDARD_TYPE(AIS_Shape)) && !object->IsKind(STANDARD_TYPE(GraphicsMeshObject)))
+        return false;
+
+    TColStd_ListOfInteger listMode;
+    m_aisContext->ActivatedModes(object, listMode);
+    return listMode.Size() == 1 && listMode.First() == object->GlobalSelectionMode();
+}
+
+bool GraphicsScene::Private::renderIdBuffer(const Handle_V3d_View& view)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    if (view->Window().IsNull())
+        return false;
+
+    IdBuffer& buffer = m_idBuffer;
+    buffer.isValid = false;
+    buffer.vecObject.clear();
+    m_aisContext->ClearDetected(false);
+
+    // Displayed presentations are temporarily highlighted with the flat color of their object id
+    // Note: PrsMgr_Presentation::Highlight() would also display the presentation
+    struct PrsHighlight {
+        Handle_PrsMgr_Presentation prs;
+        Handle_Graphic3d_PresentationAttributes style; // Null if not highlighted
+    };
+    std::vector<PrsHighlight> vecPrsHighlight;
+    auto fnIdStyle = [](uint32_t id) {
+        Handle_Graphic3d_PresentationAttributes style = new Graphic3d_PresentationAttributes;
+        style->SetMethod(Aspect_TOHM_COLOR);
+        style->SetColor(IdBuffer_color(id));
+        return style;
+    };
+    const Handle_Graphic3d_PresentationAttributes cpuPickingStyle = fnIdStyle(IdBuffer_CpuPickingId);
+    AIS_ListOfInteractive listObject;
+    m_aisContext->DisplayedObjects(listObject);
+    for (const GraphicsObjectPtr& object : listObject) {
+        Handle_Graphic3d_PresentationAttributes style = cpuPickingStyle;
+        if (this->isIdBufferPickable(object) && buffer.vecObject.size() + 1 < IdBuffer_CpuPickingId) {
+            buffer.vecObject.push_back(object);
+            style = fnIdStyle(uint32_t(buffer.vecObject.size()));
+        }
+
+        for (const Handle_PrsMgr_Presentation& prs : object->Presentations()) {
+            if (prs->IsDisplayed()) {
+                vecPrsHighlight.push_back({ prs, prs->IsHighlighted() ? prs->HighlightStyle() : Handle_Graphic3d_PresentationAttributes() });
+                prs->Graphic3d_Structure::Highlight(style, false);
+            }
+        }
+    }
+
+    // Background, antialiasing and statistics would alter the id colors
+    const Quantity_Color onEntryBgColor = view->BackgroundColor();
+    const Aspect_GradientBackground onEntryBgGradient = view->GradientBackground();
+    const Graphic3d_RenderingParams onEntryParams = view->RenderingParams();
+    view->SetBgGradientStyle(Aspect_GFM_NONE, false);
+    view->SetBackgroundColor(IdBuffer_color(IdBuffer_NullId));
+    view->ChangeRenderingParams().IsAntialiasingEnabled = false;
+    view->ChangeRenderingParams().NbMsaaSamples = 0;
+    view->ChangeRenderingParams().ToShowStats = false;
+
+    int width = 0;
+    int height = 0;
+    view->Window()->Size(width, height);
+    V3d_ImageDumpOptions dumpOptions;
+    dumpOptions.Width = width;
+    dumpOptions.Height = height;
+    dumpOptions.BufferType = Graphic3d_BT_RGB;
+    buffer.colorImage.Clear();
+    buffer.colorImage.SetTopDown(true);
+    bool ok = view->ToPixMap(buffer.colorImage, dumpOptions);
+    dumpOptions.BufferType = Graphic3d_BT_Depth;
+    buffer.depthImage.Clear();
+    buffer.depthImage.SetTopDown(true);
+    ok = ok && view->ToPixMap(buffer.depthImage, dumpOptions);
+
+    // Restore view and presentations
+    view->ChangeRenderingParams() = onEntryParams;
+    view->SetBackgroundColor(onEntryBgColor);
+    Quantity_Color bgColor1, bgColor2;
+    onEntryBgGradient.Colors(bgColor1, bgColor2);
+    view->SetBgGradientColors(bgColor1, bgColor2, onEntryBgGradient.BgGradientFillMethod(), false);
+    for (const PrsHighlight& prsHighlight : vecPrsHighlight) {
+        if (prsHighlight.style)
+            prsHighlight.prs->Graphic3d_Structure::Highlight(prsHighlight.style, false);
+        else
+            prsHighlight.prs->Graphic3d_Structure::UnHighlight();
+    }
+
+    buffer.view = view.get();
+    buffer.cameraState = view->Camera()->WorldViewProjState();
+    buffer.isValid = ok && buffer.colorImage.Format() == Image_Format_RGB;
+    return buffer.isValid;
+#else
+    return false;
+#endif
+}
+
+// Returns true if detection at 'pos' could be resolved with the id buffer, false if the selection
+// BVH has to be used
+bool GraphicsScene::Private::highlightWithIdBuffer(const QPoint& pos, const Handle_V3d_View& view)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    const Handle_Graphic3d_Camera& camera = view->Camera();
+    const Graphic3d_WorldViewProjState& cameraState = camera->WorldViewProjState();
+    const bool isCameraIdle = m_prevHighlightCameraState && !m_prevHighlightCameraState->IsChanged(cameraState);
+    m_prevHighlightCameraState = cameraState;
+    IdBuffer& buffer = m_idBuffer;
+    const bool isBufferValid =
+            buffer.isValid && buffer.view == view.get() && !buffer.cameraState.IsChanged(cameraState);
+    if (!isBufferValid && (!isCameraIdle || !this->renderIdBuffer(view)))
+        return false;
+
+    const Image_PixMap& image = buffer.colorImage;
+    if (pos.x() < 0 || pos.y() < 0 || size_t(pos.x()) >= image.SizeX() || size_t(pos.y()) >= image.SizeY())
+        return false;
+
+    const uint32_t id = IdBuffer_decode(image.RawValue(pos.y(), pos.x()));
+    if (id != IdBuffer_NullId && id > buffer.vecObject.size())
+        return false; // CPU picking or invalid id
+
+    GraphicsOwnerPtr owner;
+    std::optional<gp_Pnt> point;
+    if (id != IdBuffer_NullId) {
+        const GraphicsObjectPtr& object = buffer.vecObject.at(id - 1);
+        if (!m_aisContext->IsDisplayed(object))
+            return false;
+
+        if (!this->isIdBufferPickable(object))
+            return false; // Selection modes changed since rendering
+
+        owner = object->GlobalSelOwner();
+        if (!owner || !m_aisContext->member_myFilters()->IsOk(owner))
+            return false; // Owner behind might be detected
+
+        const float depth = buffer.depthImage.Value<float>(pos.y(), pos.x());
+        const double ndcX = 2. * (pos.x() + 0.5) / image.SizeX() - 1.;
+        const double ndcY = 1. - 2. * (pos.y() + 0.5) / image.SizeY();
+        point = camera->UnProject(gp_Pnt(ndcX, ndcY, 2. * depth - 1.));
+    }
+
+    m_aisContext->setDetectedOwner(owner, view);
+    m_idBufferHighlightedPoint = point;
+    return true;
+#else
+    return false;
+#endif
+}
+
 GraphicsScene::GraphicsScene(QObject* parent)
+    : GraphicsScene(Handle_Graphic3d_GraphicDriver(), parent)
+{
+}
+
+GraphicsScene::GraphicsScene(const Handle_Graphic3d_GraphicDriver& gfxDriver, QObject* parent)
     : QObject(parent),
       d(new Private)
 {
-    d->m_v3dViewer = Internal::createOccViewer();
+    d->m_v3dViewer = Internal::createOccViewer(!gfxDriver.IsNull() ? gfxDriver : Internal::createGfxDriver());
     d->m_aisContext = new InteractiveContext(d->m_v3dViewer);
+    d->m_timerRedraw = new QTimer(this);
+    d->m_timerRedraw->setSingleShot(true);
+    QObject::connect(d->m_timerRedraw, &QTimer::timeout, this, &GraphicsScene::flushRedraw);
+    d->m_timerLazyModeRelease = new QTimer(this);
+    d->m_timerLazyModeRelease->setSingleShot(true);
+    QObject::connect(d->m_timerLazyModeRelease, &QTimer::timeout, this, [=]{
+        d->releaseLazyModes(64);
+        if (!d->m_vecLazyModeRelease.empty())
+            d->m_timerLazyModeRelease->start();
+    });
 }
 
 GraphicsScene::~GraphicsScene()
@@ -75,7 +553,9 @@ GraphicsScene::~GraphicsScene()
 
 opencascade::handle<V3d_View> GraphicsScene::createV3dView()
 {
-    return d->m_v3dViewer->CreateView();
+    Handle_V3d_View view = d->m_v3dViewer->CreateView();
+    d->applyTransparencyMethod(view);
+    return view;
 }
 
 const opencascade::handle<V3d_Viewer>& GraphicsScene::v3dViewer() const
@@ -108,12 +588,64 @@ void GraphicsScene::eraseObject(const GraphicsObjectPtr& object)
 {
     GraphicsUtils::AisContext_eraseObject(d->m_aisContext, object);
     d->m_setClipPlaneSensitive.erase(object.get());
+    auto& vecLazyObject = d->m_vecLazyActivatedObject;
+    vecLazyObject.erase(std::remove(vecLazyObject.begin(), vecLazyObject.end(), object), vecLazyObject.end());
+    auto& vecGhosted = d->m_vecGhostedObject;
+    auto itGhosted = std::remove_if(vecGhosted.begin(), vecGhosted.end(), [&](const Private::GhostedObject& ghosted) {
+        return ghosted.object == object;
+    });
+    vecGhosted.erase(itGhosted, vecGhosted.end());
+    d->dropOutline(object);
+}
+
+void GraphicsScene::clear()
+{
+    d->m_aisContext->RemoveAll(false);
+    d->m_setClipPlaneSensitive.clear();
+    d->m_vecLazyActivatedObject.clear();
+    d->m_vecLazyModeRelease.clear();
+    d->m_vecGhostedObject.clear();
+    d->m_vecOutlinedObject.clear();
+    d->resetPickingCache();
 }
 
 void GraphicsScene::redraw()
 {
-    if (!d->m_isRedrawBlocked)
-        d->m_aisContext->UpdateCurrentViewer();
+    // Redraw is requested after scene changes, so previous detection may be obsolete
+    d->resetPickingCache();
+    if (d->m_isRedrawBlocked || d->m_timerRedraw->isActive())
+        return;
+
+    const qint64 elapsed = d->m_chronoRedraw.isValid() ? d->m_chronoRedraw.elapsed() : d->m_redrawInterval;
+    d->m_timerRedraw->start(int(std::max<qint64>(0, d->m_redrawInterval - elapsed)));
+}
+
+void GraphicsScene::flushRedraw()
+{
+    d->m_timerRedraw->stop();
+    d->m_chronoRedraw.start();
+    if (d->m_isSelectionOutlineDirty)
+        d->updateSelectionOutlines();
+
+    // Views share the structures of the viewer, but a view not invalidated(eg by changes of its
+    // camera or of structures it displays) would be redrawn for nothing(other split views)
+    for (V3d_ListOfViewIterator it = d->m_v3dViewer->ActiveViewIterator(); it.More(); it.Next()) {
+        const Handle_V3d_View& view = it.Value();
+        if (view->IsInvalidated())
+            view->Redraw();
+        else
+            view->RedrawImmediate();
+    }
+}
+
+int GraphicsScene::redrawInterval() const
+{
+    return d->m_redrawInterval;
+}
+
+void GraphicsScene::setRedrawInterval(int ms)
+{
+    d->m_redrawInterval = ms;
 }
 
 bool GraphicsScene::isRedrawBlocked() const
@@ -126,38 +658,182 @@ void GraphicsScene::blockRedraw(bool on)
     d->m_isRedrawBlocked = on;
 }
 
+GraphicsScene::TransparencyMethod GraphicsScene::transparencyMethod() const
+{
+    return d->m_transparencyMethod;
+}
+
+void GraphicsScene::setTransparencyMethod(TransparencyMethod method)
+{
+    if (method == d->m_transparencyMethod)
+        return;
+
+    d->m_transparencyMethod = method;
+    for (V3d_ListOfViewIterator it = d->m_v3dViewer->DefinedViewIterator(); it.More(); it.Next())
+        d->applyTransparencyMethod(it.Value());
+
+    this->redraw();
+}
+
+void GraphicsScene::ghostNonSelectedObjects(double transparency)
+{
+    this->unghostObjects();
+    std::unordered_set<const SelectMgr_SelectableObject*> setSelectedObject;
+    this->foreachSelectedOwner([&](const GraphicsOwnerPtr& owner) {
+        setSelectedObject.insert(owner->Selectable().get());
+    });
+
+    this->foreachDisplayedObject([&](const GraphicsObjectPtr& object) {
+        if (setSelectedObject.find(object.get()) != setSelectedObject.cend())
+            return;
+
+        d->m_vecGhostedObject.push_back({ object, object->HasTransparency(), object->Transparency() });
+        d->m_aisContext->SetTransparency(object, transparency, false);
+    });
+
+    this->redraw();
+}
+
+void GraphicsScene::unghostObjects()
+{
+    if (d->m_vecGhostedObject.empty())
+        return;
+
+    for (const Private::GhostedObject& ghosted : d->m_vecGhostedObject) {
+        if (ghosted.hadTransparency)
+            d->m_aisContext->SetTransparency(ghosted.object, ghosted.transparency, false);
+        else
+            d->m_aisContext->UnsetTransparency(ghosted.object, false);
+    }
+
+    d->m_vecGhostedObject.clear();
+    this->redraw();
+}
+
+bool GraphicsScene::hasGhostedObjects() const
+{
+    return !d->m_vecGhostedObject.empty();
+}
+
 void GraphicsScene::recomputeObjectPresentation(const GraphicsObjectPtr& object)
 {
+    d->dropOutline(object);
     d->m_aisContext->Redisplay(object, false);
 }
 
+void GraphicsScene::releaseObjectGraphicsData(const GraphicsObjectPtr& object)
+{
+    if (!object || this->isObjectVisible(object))
+        return;
+
+    // Presentation modes are collected first, clearing a presentation removes it from the list
+    std::vector<int> vecMode;
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    for (const Handle_PrsMgr_Presentation& prs : object->Presentations())
+        vecMode.push_back(prs->Mode());
+#else
+    for (const PrsMgr_ModedPresentation& prs : object->Presentations())
+        vecMode.push_back(prs.Mode());
+#endif
+
+    for (int mode : vecMode)
+        d->m_aisContext->MainPrsMgr()->Clear(object, mode);
+
+    const int selMode = object->GlobalSelectionMode();
+    if (object->HasSelection(selMode)) {
+        const Handle_SelectMgr_SelectionManager& selMgr = d->m_aisContext->SelectionManager();
+        if (selMgr->Contains(object))
+            selMgr->ClearSelectionStructures(object, selMode);
+
+        object->Selection(selMode)->Clear();
+    }
+}
+
+void GraphicsScene::restoreObjectGraphicsData(const GraphicsObjectPtr& object)
+{
+    if (!object)
+        return;
+
+    const int selMode = object->GlobalSelectionMode();
+    const Handle_SelectMgr_SelectionManager& selMgr = d->m_aisContext->SelectionManager();
+    if (selMgr->Contains(object))
+        selMgr->RecomputeSelection(object, true, selMode);
+    else
+        object->RecomputePrimitives(selMode);
+}
+
 void GraphicsScene::activateObjectSelection(const GraphicsObjectPtr& object, int mode)
 {
     d->m_aisContext->Activate(object, mode);
+    d->resetPickingCache();
 }
 
 void GraphicsScene::deactivateObjectSelection(const Mayo::GraphicsObjectPtr &object, int mode)
 {
     d->m_aisContext->Deactivate(object, mode);
+    d->resetPickingCache();
+}
+
+int GraphicsScene::lazySubShapeSelectionMode() const
+{
+    return d->m_lazySubShapeMode;
+}
+
+void GraphicsScene::setLazySubShapeSelectionMode(int mode)
+{
+    if (mode == d->m_lazySubShapeMode)
+        return;
+
+    // Objects currently selected get the new mode right away
+    std::vector<GraphicsObjectPtr> vecSelectedObject;
+    if (mode >= 0) {
+        this->foreachSelectedOwner([&](const GraphicsOwnerPtr& owner) {
+            auto object = GraphicsObjectPtr::DownCast(owner->Selectable());
+            if (object && std::find(vecSelectedObject.cbegin(), vecSelectedObject.cend(), object) == vecSelectedObject.cend())
+                vecSelectedObject.push_back(object);
+        });
+    }
+
+    this->clearSelection();
+    for (const GraphicsObjectPtr& object : d->m_vecLazyActivatedObject) {
+        d->m_aisContext->Activate(object, object->GlobalSelectionMode());
+        d->m_vecLazyModeRelease.push_back({ object, d->m_lazySubShapeMode });
+    }
+
+    d->m_vecLazyActivatedObject.clear();
+    d->m_lazySubShapeMode = mode;
+    for (const GraphicsObjectPtr& object : vecSelectedObject) {
+        if (d->lazySubShapeCandidate(object->GlobalSelOwner()))
+            d->activateLazySubShapeMode(object);
+    }
+
+    if (!d->m_vecLazyModeRelease.empty())
+        d->m_timerLazyModeRelease->start(0);
+
+    d->resetPickingCache();
 }
 
 void GraphicsScene::addSelectionFilter(const Handle_SelectMgr_Filter& filter)
 {
     d->m_aisContext->AddFilter(filter);
+    d->resetPickingCache();
 }
 
 void GraphicsScene::removeSelectionFilter(const Handle_SelectMgr_Filter& filter)
 {
     d->m_aisContext->RemoveFilter(filter);
+    d->resetPickingCache();
 }
 
 void GraphicsScene::clearSelectionFilters()
 {
     d->m_aisContext->RemoveFilters();
+    d->resetPickingCache();
 }
 
 void GraphicsScene::setObjectDisplayMode(const GraphicsObjectPtr& object, int displayMode)
 {
+    d->dropOutline(object);
     d->m_aisContext->SetDisplayMode(object, displayMode, false);
 }
 
@@ -190,6 +866,12 @@ void GraphicsScene::setObjectVisible(const GraphicsObjectPtr& object, bool on)
     GraphicsUtils::AisContext_setObjectVisible(d->m_aisContext, object, on);
 }
 
+void GraphicsScene::setObjectVisibleInView(const GraphicsObjectPtr& object, const Handle_V3d_View& view, bool on)
+{
+    if (object && view)
+        d->m_aisContext->SetViewAffinity(object, view, on);
+}
+
 gp_Trsf GraphicsScene::objectTransformation(const GraphicsObjectPtr& object) const
 {
     return d->m_aisContext->Location(object);
@@ -213,6 +895,7 @@ void GraphicsScene::clearSelection()
 {
     d->m_aisContext->ClearDetected(false);
     d->m_aisContext->ClearSelected(false);
+    d->m_isSelectionOutlineDirty = d->m_isSelectionOutlineEnabled;
 }
 
 AIS_InteractiveContext* GraphicsScene::aisContextPtr() const
@@ -224,13 +907,84 @@ void GraphicsScene::toggleOwnerSelection(const GraphicsOwnerPtr& gfxOwner)
 {
     auto gfxObject = GraphicsObjectPtr::DownCast(
                 gfxOwner ? gfxOwner->Selectable() : Handle_SelectMgr_SelectableObject());
-    if (GraphicsUtils::AisObject_isVisible(gfxObject))
+    if (GraphicsUtils::AisObject_isVisible(gfxObject)) {
         d->m_aisContext->AddOrRemoveSelected(gfxOwner, false);
+        d->m_isSelectionOutlineDirty = d->m_isSelectionOutlineEnabled;
+    }
+}
+
+bool GraphicsScene::highlightAt(const QPoint& pos, const Handle_V3d_View& view)
+{
+    const Graphic3d_WorldViewProjState& cameraState = view->Camera()->WorldViewProjState();
+    const auto& lastQuery = d->m_lastHighlightQuery;
+    if (lastQuery
+            && lastQuery->pos == pos
+            && lastQuery->view == view.get()
+            && !lastQuery->cameraState.IsChanged(cameraState))
+    {
+        return false;
+    }
+
+    d->m_isHighlightFromIdBuffer = d->m_isIdBufferPickingEnabled && d->highlightWithIdBuffer(pos, view);
+    if (!d->m_isHighlightFromIdBuffer)
+        d->m_aisContext->MoveTo(pos.x(), pos.y(), view, true);
+
+    // Hovered object detected with its global mode: activate lazy sub-shape mode and pick again
+    const GraphicsObjectPtr lazyObject = d->lazySubShapeCandidate(this->currentHighlightedOwner());
+    if (lazyObject) {
+        d->activateLazySubShapeMode(lazyObject);
+        d->m_isHighlightFromIdBuffer = false;
+        d->m_aisContext->MoveTo(pos.x(), pos.y(), view, true);
+    }
+
+    d->m_lastHighlightQuery = Private::HighlightQuery{ pos, view.get(), cameraState };
+    return true;
+}
+
+bool GraphicsScene::isIdBufferPickingEnabled() const
+{
+    return d->m_isIdBufferPickingEnabled;
+}
+
+void GraphicsScene::setIdBufferPickingEnabled(bool on)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    d->m_isIdBufferPickingEnabled = on;
+#else
+    d->m_isIdBufferPickingEnabled = false;
+#endif
+    d->resetPickingCache();
+    d->m_idBuffer.colorImage.Clear();
+    d->m_idBuffer.depthImage.Clear();
+    d->m_idBuffer.vecObject.clear();
 }
 
-void GraphicsScene::highlightAt(const QPoint& pos, const Handle_V3d_View& view)
+bool GraphicsScene::isSelectionOutlineEnabled() const
 {
-    d->m_aisContext->MoveTo(pos.x(), pos.y(), view, true);
+    return d->m_isSelectionOutlineEnabled;
+}
+
+void GraphicsScene::setSelectionOutlineEnabled(bool on)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    if (on == d->m_isSelectionOutlineEnabled)
+        return;
+
+    d->m_isSelectionOutlineEnabled = on;
+    if (!on) {
+        // Get back highlight colors of selected objects
+        for (const Private::OutlinedObject& outlined : d->m_vecOutlinedObject)
+            Private::restoreOutlinedObject(outlined);
+
+        d->m_vecOutlinedObject.clear();
+        d->m_aisContext->UpdateSelected(false);
+    }
+
+    d->m_isSelectionOutlineDirty = on;
+    this->redraw();
+#else
+    Q_UNUSED(on);
+#endif
 }
 
 void GraphicsScene::select()
@@ -238,10 +992,73 @@ void GraphicsScene::select()
     if (d->m_selectionMode == SelectionMode::None)
         return;
 
+    // With outlines, viewer update is deferred so objects aren't drawn first with highlight color
+    const bool toUpdateViewer = !d->m_isSelectionOutlineEnabled;
     if (d->m_selectionMode == SelectionMode::Single)
-        d->m_aisContext->Select(true);
+        d->m_aisContext->Select(toUpdateViewer);
     else if (d->m_selectionMode == SelectionMode::Multi)
-        d->m_aisContext->ShiftSelect(true);
+        d->m_aisContext->ShiftSelect(toUpdateViewer);
+
+    if (d->m_isSelectionOutlineEnabled) {
+        d->m_isSelectionOutlineDirty = true;
+        this->redraw();
+    }
+
+    emit this->selectionChanged();
+}
+
+void GraphicsScene::selectInRect(const QPoint& posStart, const QPoint& posEnd, const Handle_V3d_View& view)
+{
+    if (d->m_selectionMode == SelectionMode::None)
+        return;
+
+    const int xMin = std::min(posStart.x(), posEnd.x());
+    const int yMin = std::min(posStart.y(), posEnd.y());
+    const int xMax = std::max(posStart.x(), posEnd.x());
+    const int yMax = std::max(posStart.y(), posEnd.y());
+    // Overlap detection is disabled by default for the main selector
+    const Handle_StdSelect_ViewerSelector3d& selector = this->mainSelector();
+    selector->AllowOverlapDetection(posEnd.x() < posStart.x());
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    const AIS_SelectionScheme scheme =
+            d->m_selectionMode == SelectionMode::Multi ? AIS_SelectionScheme_XOR : AIS_SelectionScheme_Replace;
+    d->m_aisContext->SelectRectangle(Graphic3d_Vec2i(xMin, yMin), Graphic3d_Vec2i(xMax, yMax), view, scheme);
+#else
+    if (d->m_selectionMode == SelectionMode::Single)
+        d->m_aisContext->Select(xMin, yMin, xMax, yMax, view, false);
+    else if (d->m_selectionMode == SelectionMode::Multi)
+        d->m_aisContext->ShiftSelect(xMin, yMin, xMax, yMax, view, false);
+#endif
+
+    d->m_isSelectionOutlineDirty = d->m_isSelectionOutlineEnabled;
+    this->redraw();
+
+    selector->AllowOverlapDetection(false);
+    emit this->selectionChanged();
+}
+
+void GraphicsScene::selectInPolygon(Span<const QPoint> polygon, const Handle_V3d_View& view)
+{
+    if (d->m_selectionMode == SelectionMode::None || polygon.size() < 3)
+        return;
+
+    TColgp_Array1OfPnt2d arrayPnt(1, int(polygon.size()));
+    for (int i = 0; i < int(polygon.size()); ++i)
+        arrayPnt.ChangeValue(i + 1).SetCoord(polygon[i].x(), polygon[i].y());
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    const AIS_SelectionScheme scheme =
+            d->m_selectionMode == SelectionMode::Multi ? AIS_SelectionScheme_XOR : AIS_SelectionScheme_Replace;
+    d->m_aisContext->SelectPolygon(arrayPnt, view, scheme);
+#else
+    if (d->m_selectionMode == SelectionMode::Single)
+        d->m_aisContext->Select(arrayPnt, view, false);
+    else if (d->m_selectionMode == SelectionMode::Multi)
+        d->m_aisContext->ShiftSelect(arrayPnt, view, false);
+#endif
+
+    d->m_isSelectionOutlineDirty = d->m_isSelectionOutlineEnabled;
+    this->redraw();
 
     emit this->selectionChanged();
 }
@@ -260,6 +1077,18 @@ const GraphicsOwnerPtr& GraphicsScene::currentHighlightedOwner() const
 #endif
 }
 
+std::optional<gp_Pnt> GraphicsScene::currentHighlightedPoint() const
+{
+    if (d->m_isHighlightFromIdBuffer)
+        return d->m_idBufferHighlightedPoint;
+
+    const Handle_StdSelect_ViewerSelector3d& selector = this->mainSelector();
+    if (selector->NbPicked() > 0)
+        return selector->PickedPoint(1);
+
+    return {};
+}
+
 GraphicsScene::SelectionMode GraphicsScene::selectionMode() const {
     return d->m_selectionMode;
 }
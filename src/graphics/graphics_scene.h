@@ -8,11 +8,14 @@
 
 #include "graphics_object_ptr.h"
 #include "graphics_owner_ptr.h"
+#include "../base/span.h"
 
 #include <AIS_InteractiveContext.hxx>
+#include <Graphic3d_GraphicDriver.hxx>
 #include <V3d_Viewer.hxx>
 #include <V3d_View.hxx>
 #include <QtCore/QObject>
+#include <optional>
 #include <unordered_set>
 class QPoint;
 
@@ -24,6 +27,10 @@ class GraphicsScene : public QObject {
     Q_OBJECT
 public:
     GraphicsScene(QObject* parent = nullptr);
+    // Scene whose viewer is created on top of existing 'gfxDriver', so GL contexts and resources
+    // (eg shader programs, textures) are shared with the other scenes using it
+    // A new graphic driver is created if 'gfxDriver' is null
+    GraphicsScene(const opencascade::handle<Graphic3d_GraphicDriver>& gfxDriver, QObject* parent = nullptr);
     ~GraphicsScene();
 
     opencascade::handle<V3d_View> createV3dView();
@@ -35,16 +42,65 @@ public:
 
     void addObject(const GraphicsObjectPtr& object);
     void eraseObject(const GraphicsObjectPtr& object);
+    // Removes all the objects in a single context operation, much faster than eraseObject() on
+    // each of them
+    void clear();
 
+    // Requests redraw of the views, actual redraw is deferred so that all requests within a frame
+    // interval are collapsed into a single one
     void redraw();
+    // Redraws now pending changes if any, instead of waiting next frame
+    // Only views invalidated(eg by changes of displayed objects or of their camera) are redrawn
+    void flushRedraw();
     bool isRedrawBlocked() const;
     void blockRedraw(bool on);
 
+    // Minimum time interval(milliseconds) between two actual redraws, typically display frame duration
+    int redrawInterval() const;
+    void setRedrawInterval(int ms);
+
+    // Method used by all the views of the scene to render transparent objects
+    enum class TransparencyMethod {
+        // Blending in the order objects are drawn, fastest but wrong where transparent objects overlap
+        Blended,
+        // Weighted blended order-independent transparency, single pass whatever the count of
+        // overlapping objects. Approximation of the actual order
+        WeightedOit,
+        // Depth peeling order-independent transparency, exact up to a few layers but costly
+        // Requires OpenCascade >= v7.5.0, WeightedOit is used otherwise
+        DepthPeeling
+    };
+    TransparencyMethod transparencyMethod() const;
+    void setTransparencyMethod(TransparencyMethod method);
+
+    // Sets 'transparency'(in [0, 1]) to all the displayed objects not owning a selected entity,
+    // with a single redraw. Ghosting is undone by unghostObjects(), which restores the previous
+    // transparency of the objects
+    void ghostNonSelectedObjects(double transparency);
+    void unghostObjects();
+    bool hasGhostedObjects() const;
+
     void recomputeObjectPresentation(const GraphicsObjectPtr& object);
 
+    // Clears the computed presentations and sensitive entities of 'object' to release memory.
+    // Object must not be visible, it also doesn't need to be in the scene(eg product of instances)
+    void releaseObjectGraphicsData(const GraphicsObjectPtr& object);
+    // Recomputes sensitive entities cleared by releaseObjectGraphicsData(), presentations are
+    // recomputed anyway when the object gets visible
+    void restoreObjectGraphicsData(const GraphicsObjectPtr& object);
+
     void activateObjectSelection(const GraphicsObjectPtr& object, int mode);
     void deactivateObjectSelection(const GraphicsObjectPtr& object, int mode);
 
+    // Sub-shape selection mode(eg AIS_Shape::SelectionMode(TopAbs_FACE)) activated only on the
+    // relevant shape objects: the ones currently selected and the ones getting hovered by
+    // highlightAt(). So sensitive entities are built lazily per object instead of for the whole
+    // scene with activateObjectSelection(). Such objects are detected with the sub-shape mode only
+    // Changing the mode(value -1 to leave it) restores the global selection mode, previous mode is
+    // then deactivated and its sensitive entities cleared in the background by small batches
+    int lazySubShapeSelectionMode() const;
+    void setLazySubShapeSelectionMode(int mode);
+
     void addSelectionFilter(const Handle_SelectMgr_Filter& filter);
     void removeSelectionFilter(const Handle_SelectMgr_Filter& filter);
     void clearSelectionFilters();
@@ -56,6 +112,8 @@ public:
 
     bool isObjectVisible(const GraphicsObjectPtr& object) const;
     void setObjectVisible(const GraphicsObjectPtr& object, bool on);
+    // Object is displayed in all views of the scene by default
+    void setObjectVisibleInView(const GraphicsObjectPtr& object, const Handle_V3d_View& view, bool on);
 
     gp_Trsf objectTransformation(const GraphicsObjectPtr& object) const;
     void setObjectTransformation(const GraphicsObjectPtr& object, const gp_Trsf& trsf);
@@ -67,8 +125,38 @@ public:
     void setSelectionMode(SelectionMode mode);
 
     const GraphicsOwnerPtr& currentHighlightedOwner() const;
-    void highlightAt(const QPoint& pos, const Handle_V3d_View& view);
+    // 3D point under the cursor on the current highlighted owner, as found by last highlightAt()
+    std::optional<gp_Pnt> currentHighlightedPoint() const;
+    // Detects and highlights the owner at position 'pos' in 'view'
+    // Returns false if picking was skipped because cursor, camera and scene didn't change since the
+    // last call, meaning current detection is still valid
+    bool highlightAt(const QPoint& pos, const Handle_V3d_View& view);
+
+    // GPU picking for highlightAt(): once the camera is idle, the ids of the displayed objects are
+    // rendered into an offscreen buffer kept until the view or the scene changes. Then detection
+    // is a single pixel read instead of a traversal of the selection BVH
+    // Only objects having a single owner(shapes and meshes with global selection mode) are picked
+    // this way, the others(eg sub-shape selection modes used for measurements) are still picked
+    // with the selection BVH
+    // Requires OpenCascade >= v7.4.0
+    bool isIdBufferPickingEnabled() const;
+    void setIdBufferPickingEnabled(bool on);
+
+    // Objects entirely selected(ie their global owner is selected) are drawn with a silhouette in
+    // the selection color instead of being recolored by the highlight of their presentations. The
+    // GPU outline pass reuses the geometry of the presentations, so selecting thousands of objects
+    // just tags their aspects. Sub-shape owners are still highlighted with a color
+    // Outlines are updated at next redraw after selection changes
+    // Requires OpenCascade >= v7.5.0
+    bool isSelectionOutlineEnabled() const;
+    void setSelectionOutlineEnabled(bool on);
+
     void select();
+    // Selects in one picking query all owners within the rectangle defined by 'posStart' and 'posEnd'
+    // Dragging from right to left also selects owners overlapping the rectangle(crossing selection)
+    void selectInRect(const QPoint& posStart, const QPoint& posEnd, const Handle_V3d_View& view);
+    // Selects in one picking query all owners within closed polygon 'polygon'(view coordinates)
+    void selectInPolygon(Span<const QPoint> polygon, const Handle_V3d_View& view);
 
     int selectedCount() const;
 
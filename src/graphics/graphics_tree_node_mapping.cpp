@@ -13,6 +13,7 @@
 #include <AIS_Shape.hxx>
 #include <StdSelect_BRepOwner.hxx>
 #include <TopoDS_Solid.hxx>
+#include <climits>
 
 namespace Mayo {
 
@@ -41,9 +42,10 @@ GraphicsShapeTreeNodeMapping::findGraphicsOwners(const DocumentTreeNode& treeNod
         vecShape.push_back(shape);
     }
 
+    this->buildMapGraphicsOwner();
     std::vector<GraphicsOwnerPtr> vecGfxOwner;
     for (const TopoDS_Shape& shape : vecShape) {
-        auto it = m_mapGfxOwner.find(BRepUtils::hashCode(shape));
+        auto it = m_mapGfxOwner.find(shape);
         if (it != m_mapGfxOwner.cend())
             vecGfxOwner.push_back(it->second);
     }
@@ -60,8 +62,32 @@ bool GraphicsShapeTreeNodeMapping::mapGraphicsOwner(const GraphicsOwnerPtr& gfxO
     if (brepOwner->Shape().ShapeType() != m_shapeType)
         return false;
 
-    auto result = m_mapGfxOwner.emplace(BRepUtils::hashCode(brepOwner->Shape()), brepOwner);
-    return result.second;
+    m_vecGfxOwnerPending.push_back(brepOwner);
+    return true;
+}
+
+size_t GraphicsShapeTreeNodeMapping::ShapeHasher::operator()(const TopoDS_Shape& shape) const
+{
+    size_t hash = std::hash<const void*>{}(shape.TShape().get());
+    auto fnCombine = [&](size_t value) { hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2); };
+    fnCombine(size_t(shape.Location().HashCode(INT_MAX)));
+    fnCombine(size_t(shape.Orientation()));
+    return hash;
+}
+
+void GraphicsShapeTreeNodeMapping::buildMapGraphicsOwner() const
+{
+    if (m_vecGfxOwnerPending.empty())
+        return;
+
+    m_mapGfxOwner.reserve(m_mapGfxOwner.size() + m_vecGfxOwnerPending.size());
+    for (const GraphicsOwnerPtr& gfxOwner : m_vecGfxOwnerPending) {
+        auto brepOwner = Handle_StdSelect_BRepOwner::DownCast(gfxOwner);
+        m_mapGfxOwner.emplace(brepOwner->Shape(), brepOwner);
+    }
+
+    m_vecGfxOwnerPending.clear();
+    m_vecGfxOwnerPending.shrink_to_fit();
 }
 
 } // namespace Mayo
@@ -8,8 +8,10 @@
 
 #include "graphics_owner_ptr.h"
 #include <TopAbs_ShapeEnum.hxx>
+#include <TopoDS_Shape.hxx>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace Mayo {
 
@@ -32,7 +34,16 @@ public:
     bool mapGraphicsOwner(const GraphicsOwnerPtr& gfxOwner) override;
 
 private:
-    std::unordered_map<int, GraphicsOwnerPtr> m_mapGfxOwner;
+    // Collision-free key: TShape pointer, location and orientation are all compared(TopoDS_Shape::IsEqual())
+    struct ShapeHasher {
+        size_t operator()(const TopoDS_Shape& shape) const;
+    };
+
+    void buildMapGraphicsOwner() const;
+
+    // Owners are just collected by mapGraphicsOwner(), the index is built on first lookup
+    mutable std::vector<GraphicsOwnerPtr> m_vecGfxOwnerPending;
+    mutable std::unordered_map<TopoDS_Shape, GraphicsOwnerPtr, ShapeHasher> m_mapGfxOwner;
     TopAbs_ShapeEnum m_shapeType;
 };
 
@@ -5,14 +5,25 @@
 ****************************************************************************/
 
 #include "graphics_utils.h"
+#include "graphics_batched_object.h"
+#include "graphics_instanced_object.h"
+#include "graphics_mesh_object.h"
 #include "../base/bnd_utils.h"
+#include "../base/brep_utils.h"
 #include "../base/math_utils.h"
+#include "../base/memory_stats.h"
 #include "../base/tkernel_utils.h"
 
 #include <algorithm>
+#include <AIS_ConnectedInteractive.hxx>
+#include <AIS_Shape.hxx>
+#include <BRep_Tool.hxx>
 #include <Bnd_Box.hxx>
 #include <ElSLib.hxx>
+#include <Graphic3d_Vec3.hxx>
 #include <ProjLib.hxx>
+#include <Select3D_BndBox3d.hxx>
+#include <SelectMgr_Selection.hxx>
 #include <SelectMgr_SelectionManager.hxx>
 #include <Standard_Version.hxx>
 
@@ -110,13 +121,29 @@ AIS_InteractiveContext* GraphicsUtils::AisObject_contextPtr(const GraphicsObject
 
 bool GraphicsUtils::AisObject_isVisible(const GraphicsObjectPtr& object)
 {
+    // Grouped instances aren't displayed on their own
+    const GraphicsInstancedObject* group = GraphicsInstancedObject::fromInstance(object);
+    if (group)
+        return group->isInstanceVisible(object) && AisObject_isVisible(GraphicsObjectPtr(group));
+
+    const GraphicsBatchedObject* batch = GraphicsBatchedObject::fromMember(object);
+    if (batch)
+        return batch->isMemberVisible(object) && AisObject_isVisible(GraphicsObjectPtr(batch));
+
     const AIS_InteractiveContext* ptrContext = AisObject_contextPtr(object);
     return ptrContext ? ptrContext->IsDisplayed(object) : false;
 }
 
 void GraphicsUtils::AisObject_setVisible(const GraphicsObjectPtr& object, bool on)
 {
-    Internal::AisContext_setObjectVisible(AisObject_contextPtr(object), object, on);
+    GraphicsInstancedObject* group = GraphicsInstancedObject::fromInstance(object);
+    GraphicsBatchedObject* batch = GraphicsBatchedObject::fromMember(object);
+    if (group)
+        group->setInstanceVisible(object, on);
+    else if (batch)
+        batch->setMemberVisible(object, on); // See GraphicsBatchedObject::updateMembersVisibility()
+    else
+        Internal::AisContext_setObjectVisible(AisObject_contextPtr(object), object, on);
 }
 
 Bnd_Box GraphicsUtils::AisObject_boundingBox(const GraphicsObjectPtr& object)
@@ -145,6 +172,50 @@ Bnd_Box GraphicsUtils::AisObject_boundingBox(const GraphicsObjectPtr& object)
     return box;
 }
 
+void GraphicsUtils::AisObject_addMemoryStats(const GraphicsObjectPtr& object, MemoryAccounting* accounting)
+{
+    auto gfxInstance = Handle_AIS_ConnectedInteractive::DownCast(object);
+    const GraphicsObjectPtr product =
+            gfxInstance && gfxInstance->HasConnection() ? gfxInstance->ConnectedTo() : object;
+    if (!accounting || !accounting->markVisited(product.get()))
+        return;
+
+    MemoryStats& stats = accounting->stats();
+    stats.presentation += product->DynamicType()->Size();
+
+    // Shaded presentations hold a position and a normal per node, and three indices per triangle
+    auto fnAddTriangulation = [&](const Handle_Poly_Triangulation& triangulation) {
+        if (triangulation) {
+            stats.presentation += triangulation->NbNodes() * int64_t(2 * sizeof(Graphic3d_Vec3));
+            stats.presentation += triangulation->NbTriangles() * int64_t(3 * sizeof(int));
+        }
+    };
+    if (!product->Presentations().IsEmpty()) {
+        if (auto aisShape = Handle_AIS_Shape::DownCast(product)) {
+            BRepUtils::forEachSubFace(aisShape->Shape(), [&](const TopoDS_Face& face) {
+                TopLoc_Location loc;
+                fnAddTriangulation(BRep_Tool::Triangulation(face, loc));
+            });
+        }
+        else if (auto meshObject = opencascade::handle<GraphicsMeshObject>::DownCast(product)) {
+            fnAddTriangulation(meshObject->mesh());
+        }
+    }
+
+    // Each sub-element of a sensitive entity has a bounding box and an index in the BVH tree,
+    // inner nodes of the tree take about half a box per sub-element
+    constexpr int64_t bvhSizePerElement = int64_t(sizeof(Select3D_BndBox3d) * 3 / 2 + sizeof(int));
+    const int mode = product->GlobalSelectionMode();
+    if (product->HasSelection(mode)) {
+        for (const Handle_SelectMgr_SensitiveEntity& entity : product->Selection(mode)->Entities()) {
+            if (entity && entity->BaseSensitive()) {
+                stats.selection += entity->BaseSensitive()->DynamicType()->Size();
+                stats.selection += entity->BaseSensitive()->NbSubElements() * bvhSizePerElement;
+            }
+        }
+    }
+}
+
 int GraphicsUtils::AspectWindow_width(const Handle_Aspect_Window& wnd)
 {
     if (wnd.IsNull())
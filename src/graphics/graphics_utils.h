@@ -14,6 +14,8 @@
 
 namespace Mayo {
 
+class MemoryAccounting;
+
 struct GraphicsUtils {
     static void V3dView_fitAll(const Handle_V3d_View& view);
     static bool V3dView_hasClipPlane(
@@ -34,6 +36,9 @@ struct GraphicsUtils {
     static bool AisObject_isVisible(const GraphicsObjectPtr& object);
     static void AisObject_setVisible(const GraphicsObjectPtr& object, bool on);
     static Bnd_Box AisObject_boundingBox(const GraphicsObjectPtr& object);
+    // Adds estimations of the presentation arrays and sensitive entities of 'object'. Connected
+    // objects are accounted through the object they're connected to
+    static void AisObject_addMemoryStats(const GraphicsObjectPtr& object, MemoryAccounting* accounting);
 
     static int AspectWindow_width(const Handle_Aspect_Window& wnd);
     static int AspectWindow_height(const Handle_Aspect_Window& wnd);
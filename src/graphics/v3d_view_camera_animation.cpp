@@ -6,6 +6,8 @@
 
 #include "v3d_view_camera_animation.h"
 
+#include <algorithm>
+
 namespace Mayo {
 
 V3dViewCameraAnimation::V3dViewCameraAnimation(const Handle_V3d_View& view, QObject* parent)
@@ -59,9 +61,16 @@ void V3dViewCameraAnimation::configure(const std::function<void(Handle_V3d_View)
     m_view->SetImmediateUpdate(wasImmediateUpdateOn);
 }
 
+void V3dViewCameraAnimation::setRedrawFunction(const std::function<void()>& fnRedraw)
+{
+    m_fnRedraw = fnRedraw;
+}
+
 void V3dViewCameraAnimation::updateCurrentTime(int currentTime)
 {
-    const double t = m_easingCurve.valueForProgress(currentTime / double(m_duration_ms));
+    // 'currentTime' is the wall-clock time elapsed since start, not an accumulated step count
+    const double progress = m_duration_ms > 0 ? std::min(currentTime / double(m_duration_ms), 1.) : 1.;
+    const double t = m_easingCurve.valueForProgress(progress);
     const bool prevImmediateUpdate = m_view->SetImmediateUpdate(false);
     const Graphic3d_CameraLerp cameraLerp(m_cameraStart, m_cameraEnd);
     Handle_Graphic3d_Camera camera = m_view->Camera();
@@ -69,7 +78,10 @@ void V3dViewCameraAnimation::updateCurrentTime(int currentTime)
     m_view->SetCamera(camera);
     m_view->ZFitAll();
     m_view->SetImmediateUpdate(prevImmediateUpdate);
-    m_view->Update();
+    if (m_fnRedraw)
+        m_fnRedraw();
+    else
+        m_view->Update();
 }
 
 } // namespace Mayo
@@ -4,6 +4,8 @@
 ** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
 ****************************************************************************/
 
+#pragma once
+
 #include <V3d_View.hxx>
 #include <QtCore/QAbstractAnimation>
 #include <QtCore/QEasingCurve>
@@ -11,6 +13,8 @@
 
 namespace Mayo {
 
+// Camera transition driven by wall-clock time: each step interpolates the camera at the actual
+// elapsed time, so when rendering can't keep up frames are skipped and the duration is honored
 class V3dViewCameraAnimation : public QAbstractAnimation {
 public:
     V3dViewCameraAnimation(const Handle_V3d_View& view, QObject* parent = nullptr);
@@ -26,6 +30,10 @@ public:
 
     void configure(const std::function<void(Handle_V3d_View)>& fnViewChange);
 
+    // Function called after each camera step to get the view redrawn, by default V3d_View::Update()
+    // Typically set to a deferred redraw so that consecutive steps collapse into a single frame
+    void setRedrawFunction(const std::function<void()>& fnRedraw);
+
 protected:
     void updateCurrentTime(int currentTime) override;
 
@@ -35,6 +43,7 @@ private:
     Handle_Graphic3d_Camera m_cameraEnd;
     QEasingCurve m_easingCurve; // Linear by default
     int m_duration_ms = 1000;
+    std::function<void()> m_fnRedraw;
 };
 
 } // namespace Mayo
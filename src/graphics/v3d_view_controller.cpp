@@ -8,14 +8,22 @@
 
 #include <QtCore/QDebug>
 #include <QtCore/QRect>
+#include <QtCore/QTimer>
 #include <V3d_View.hxx>
+#include <algorithm>
 
 namespace Mayo {
 
 V3dViewController::V3dViewController(const Handle_V3d_View& view, QObject* parent)
     : QObject(parent),
-      m_view(view)
+      m_view(view),
+      m_timerMouseMoved(new QTimer(this))
 {
+    m_timerMouseMoved->setSingleShot(true);
+    QObject::connect(m_timerMouseMoved, &QTimer::timeout, this, [=]{
+        m_chronoMouseMoved.start();
+        emit mouseMoved(m_posMouseMovedPending);
+    });
 }
 
 V3dViewController::~V3dViewController()
@@ -44,6 +52,7 @@ void V3dViewController::startDynamicAction(DynamicAction dynAction)
         return;
 
     m_dynamicAction = dynAction;
+    m_timerMouseMoved->stop(); // Pending mouse position is stale now
     emit dynamicActionStarted(dynAction);
 }
 
@@ -55,6 +64,16 @@ void V3dViewController::stopDynamicAction()
     }
 }
 
+void V3dViewController::notifyMouseMoved(const QPoint& posMouseInView)
+{
+    m_posMouseMovedPending = posMouseInView;
+    if (m_timerMouseMoved->isActive())
+        return; // Already scheduled, will use the latest position
+
+    const qint64 elapsed = m_chronoMouseMoved.isValid() ? m_chronoMouseMoved.elapsed() : m_mouseMovedInterval;
+    m_timerMouseMoved->start(int(std::max<qint64>(0, m_mouseMovedInterval - elapsed)));
+}
+
 bool V3dViewController::isRotationStarted() const
 {
     return m_dynamicAction == DynamicAction::Rotation;
@@ -70,6 +89,11 @@ bool V3dViewController::isWindowZoomingStarted() const
     return m_dynamicAction == DynamicAction::WindowZoom;
 }
 
+bool V3dViewController::isRubberBandSelectionStarted() const
+{
+    return m_dynamicAction == DynamicAction::RubberBandSelection;
+}
+
 void V3dViewController::drawRubberBand(const QPoint& posMin, const QPoint& posMax)
 {
     if (!m_rubberBand)
@@ -8,8 +8,10 @@
 
 #include <Graphic3d_Camera.hxx>
 #include <V3d_View.hxx>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QObject>
 #include <QtCore/QPoint>
+class QTimer;
 
 namespace Mayo {
 
@@ -21,7 +23,8 @@ public:
         Panning,
         Rotation,
         WindowZoom,
-        InstantZoom
+        InstantZoom,
+        RubberBandSelection
     };
 
     struct AbstractRubberBand {
@@ -42,6 +45,11 @@ public:
     double instantZoomFactor() const { return m_instantZoomFactor; }
     void setInstantZoomFactor(double factor) { m_instantZoomFactor = factor; }
 
+    // Minimum time interval(milliseconds) between two mouseMoved() signals, typically the duration
+    // of a display frame. Intermediate mouse positions are coalesced, only the latest one is kept
+    int mouseMovedInterval() const { return m_mouseMovedInterval; }
+    void setMouseMovedInterval(int ms) { m_mouseMovedInterval = ms; }
+
 signals:
     void dynamicActionStarted(DynamicAction dynAction);
     void dynamicActionEnded(DynamicAction dynAction);
@@ -49,14 +57,20 @@ signals:
 
     void mouseMoved(const QPoint& posMouseInView);
     void mouseClicked(Qt::MouseButton btn);
+    // Emitted when a rubber band selection ends, positions are in view coordinates
+    void rubberBandSelectionRequested(const QPoint& posStart, const QPoint& posEnd);
 
 protected:
     void startDynamicAction(DynamicAction dynAction);
     void stopDynamicAction();
 
+    // Schedules emission of mouseMoved() signal, at most once per mouseMovedInterval()
+    void notifyMouseMoved(const QPoint& posMouseInView);
+
     bool isRotationStarted() const;
     bool isPanningStarted() const;
     bool isWindowZoomingStarted() const;
+    bool isRubberBandSelectionStarted() const;
 
     void instantZoomAt(const QPoint& pos);
     void windowFitAll(const QPoint& posMin, const QPoint& posMax);
@@ -74,6 +88,10 @@ private:
     AbstractRubberBand* m_rubberBand = nullptr;
     double m_instantZoomFactor = 5.;
     Handle_Graphic3d_Camera m_cameraBackup;
+    QTimer* m_timerMouseMoved = nullptr;
+    QElapsedTimer m_chronoMouseMoved;
+    QPoint m_posMouseMovedPending;
+    int m_mouseMovedInterval = 16;
 };
 
 } // namespace Mayo
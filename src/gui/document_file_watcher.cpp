@@ -0,0 +1,352 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "document_file_watcher.h"
+
+#include "../base/application.h"
+#include "../base/application_item_selection_model.h"
+#include "../base/document.h"
+#include "../base/io_system.h"
+#include "../base/reimport_diff.h"
+#include "../base/span.h"
+#include "../base/task_manager.h"
+#include "gui_application.h"
+#include "gui_document.h"
+#include "gui_document_view_state.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QTimer>
+#include <algorithm>
+#include <vector>
+
+namespace Mayo {
+
+namespace {
+
+std::vector<TreeNodeId> documentEntities(const DocumentPtr& doc)
+{
+    std::vector<TreeNodeId> vecEntityId;
+    for (int i = 0; i < doc->entityCount(); ++i)
+        vecEntityId.push_back(doc->entityTreeNodeId(i));
+
+    return vecEntityId;
+}
+
+} // namespace
+
+// State of the view of a document before reload
+struct DocumentFileWatcher::ViewState {
+    GuiDocumentViewState view;
+    std::vector<TreeNodeId> vecEntityId;
+};
+
+DocumentFileWatcher::DocumentFileWatcher(GuiApplication* guiApp)
+    : QObject(guiApp),
+      m_guiApp(guiApp)
+{
+    auto app = guiApp->application();
+    QObject::connect(app.get(), &Application::documentAdded, this, [=](const DocumentPtr& doc) {
+        if (this->isEnabled())
+            this->watchDocument(doc);
+    });
+    QObject::connect(app.get(), &Application::documentAboutToClose, this, [=](const DocumentPtr& doc) {
+        this->unwatchDocument(doc);
+    });
+    QObject::connect(app.get(), &Application::documentFilePathChanged, this, [=](const DocumentPtr& doc) {
+        if (this->isEnabled()) {
+            this->unwatchDocument(doc);
+            this->watchDocument(doc);
+        }
+    });
+}
+
+DocumentFileWatcher::~DocumentFileWatcher() = default;
+
+void DocumentFileWatcher::setEnabled(bool on)
+{
+    if (on == this->isEnabled())
+        return;
+
+    if (on) {
+        m_fsWatcher = new QFileSystemWatcher(this);
+        QObject::connect(
+                    m_fsWatcher, &QFileSystemWatcher::fileChanged,
+                    this, &DocumentFileWatcher::onFileChanged);
+        for (Application::DocumentIterator it(m_guiApp->application()); it.hasNext(); it.next())
+            this->watchDocument(it.current());
+    }
+    else {
+        for (auto& [key, watched] : m_mapWatchedFile)
+            delete watched.debounceTimer;
+
+        m_mapWatchedFile.clear();
+        delete m_fsWatcher;
+        m_fsWatcher = nullptr;
+    }
+}
+
+std::optional<DocumentFileWatcher::FileStamp> DocumentFileWatcher::fileStamp(const FilePath& fp)
+{
+    std::error_code ec;
+    FileStamp stamp;
+    stamp.lastWriteTime = std::filesystem::last_write_time(fp, ec);
+    if (!ec)
+        stamp.size = std::filesystem::file_size(fp, ec);
+
+    if (ec)
+        return {};
+
+    return stamp;
+}
+
+void DocumentFileWatcher::watchDocument(const DocumentPtr& doc)
+{
+    const FilePath fp = doc->filePath();
+    if (fp.empty() || m_mapWatchedFile.find(fp.native()) != m_mapWatchedFile.cend())
+        return;
+
+    const std::optional<FileStamp> stamp = DocumentFileWatcher::fileStamp(fp);
+    if (!stamp)
+        return;
+
+    WatchedFile watched;
+    watched.doc = doc;
+    watched.filepath = fp;
+    watched.stampLoaded = stamp.value();
+    watched.stampChecked = stamp.value();
+    watched.debounceTimer = new QTimer(this);
+    watched.debounceTimer->setSingleShot(true);
+    const QString strFilepath = filepathTo<QString>(fp);
+    QObject::connect(watched.debounceTimer, &QTimer::timeout, this, [=]{
+        this->onDebounceTimeout(strFilepath);
+    });
+    m_mapWatchedFile.insert({ fp.native(), std::move(watched) });
+    m_fsWatcher->addPath(strFilepath);
+}
+
+void DocumentFileWatcher::unwatchDocument(const DocumentPtr& doc)
+{
+    for (auto it = m_mapWatchedFile.begin(); it != m_mapWatchedFile.end(); ++it) {
+        if (it->second.doc == doc) {
+            if (m_fsWatcher)
+                m_fsWatcher->removePath(filepathTo<QString>(it->second.filepath));
+
+            delete it->second.debounceTimer;
+            m_mapWatchedFile.erase(it);
+            return;
+        }
+    }
+}
+
+void DocumentFileWatcher::onFileChanged(const QString& strFilepath)
+{
+    auto it = m_mapWatchedFile.find(filepathFrom(strFilepath).native());
+    if (it != m_mapWatchedFile.end())
+        it->second.debounceTimer->start(m_debounceDelay); // Restarted on each notification
+}
+
+void DocumentFileWatcher::onDebounceTimeout(const QString& strFilepath)
+{
+    auto it = m_mapWatchedFile.find(filepathFrom(strFilepath).native());
+    if (it == m_mapWatchedFile.end())
+        return;
+
+    WatchedFile& watched = it->second;
+    // Writers replacing the file(eg write to temporary file then rename) cause the path to be
+    // dropped by QFileSystemWatcher
+    const std::optional<FileStamp> stamp = DocumentFileWatcher::fileStamp(watched.filepath);
+    if (!stamp) {
+        // File may be created again shortly, otherwise it's considered deleted
+        constexpr int maxMissingCheckCount = 20;
+        if (++watched.missingCheckCount < maxMissingCheckCount)
+            watched.debounceTimer->start(m_debounceDelay);
+
+        return;
+    }
+
+    watched.missingCheckCount = 0;
+
+    if (!m_fsWatcher->files().contains(strFilepath))
+        m_fsWatcher->addPath(strFilepath);
+
+    // Write is considered finished once the stamp didn't change during a debounce delay, and the
+    // file can be opened(writers may hold an exclusive lock on Windows)
+    const bool isStable = stamp.value() == watched.stampChecked && QFile(strFilepath).open(QIODevice::ReadOnly);
+    watched.stampChecked = stamp.value();
+    if (!isStable) {
+        watched.debounceTimer->start(m_debounceDelay);
+        return;
+    }
+
+    if (stamp.value() == watched.stampLoaded)
+        return; // Contents not modified(eg file being only opened by another program)
+
+    if (watched.isReloading) {
+        watched.isReloadPending = true;
+        return;
+    }
+
+    watched.stampLoaded = stamp.value();
+    this->reloadDocument(watched.doc, &watched);
+}
+
+std::shared_ptr<DocumentFileWatcher::ViewState> DocumentFileWatcher::saveViewState(GuiDocument* guiDoc) const
+{
+    auto state = std::make_shared<ViewState>();
+    state->view = GuiDocumentViewState::save(guiDoc);
+    state->vecEntityId = documentEntities(guiDoc->document());
+    return state;
+}
+
+void DocumentFileWatcher::restoreViewState(GuiDocument* guiDoc, const ViewState& state)
+{
+    state.view.restore(guiDoc);
+}
+
+void DocumentFileWatcher::withReimportDiff(
+        IO::System::Operation_ImportInDocument& op,
+        ReloadContext* context,
+        EntitiesPostProcessFunction fnPostProcess)
+{
+    auto diff = std::make_shared<ReimportDiff>(context->doc);
+    op.withEntitiesPostProcess([=](Span<const IO::System::ImportedFileEntities> spanFileEntities, TaskProgress* progress) {
+        std::vector<TDF_Label> vecNewEntity;
+        for (const IO::System::ImportedFileEntities& fileEntities : spanFileEntities) {
+            for (const TDF_Label& labelEntity : fileEntities.seqEntity)
+                vecNewEntity.push_back(labelEntity);
+        }
+
+        {
+            TaskProgress diffProgress(progress, fnPostProcess ? 20 : 100);
+            diff->compare(context->vecPreviousEntity, vecNewEntity, &diffProgress);
+            diff->carryOverTriangulations();
+        }
+
+        if (fnPostProcess) {
+            TaskProgress postProcessProgress(progress, 80);
+            fnPostProcess(spanFileEntities, &postProcessProgress);
+        }
+    });
+    op.withEntityFilter([=](const TDF_Label& labelEntity) {
+        const TDF_Label labelPrevious = diff->findIdenticalPreviousEntity(labelEntity);
+        if (labelPrevious.IsNull())
+            return true;
+
+        context->vecKeptEntity.push_back(labelPrevious);
+        return false;
+    });
+}
+
+void DocumentFileWatcher::reloadDocument(const DocumentPtr& doc, WatchedFile* watched)
+{
+    GuiDocument* guiDoc = m_guiApp->findGuiDocument(doc);
+    if (!guiDoc)
+        return;
+
+    watched->isReloading = true;
+    emit this->documentReloadStarted(doc);
+    const std::shared_ptr<ViewState> state = this->saveViewState(guiDoc);
+    auto app = m_guiApp->application();
+    ImportFunction fnImport = m_fnImport;
+    if (!fnImport) {
+        fnImport = [=](ReloadContext* context, TaskProgress* progress) {
+            auto op = app->ioSystem()->importInDocument();
+            op.targetDocument(context->doc)
+                    .withFilepath(context->filepath)
+                    .withEntityPostProcessRequiredIf([](const IO::Format&) { return true; })
+                    .withEntityPostProcessInfoProgress(10, tr("Compare with previous entities"))
+                    .withTaskProgress(progress);
+            DocumentFileWatcher::withReimportDiff(op, context);
+            return op.execute();
+        };
+    }
+
+    auto context = std::make_shared<ReloadContext>();
+    context->doc = doc;
+    context->filepath = watched->filepath;
+    for (TreeNodeId entityId : state->vecEntityId)
+        context->vecPreviousEntity.push_back(doc->modelTree().nodeData(entityId));
+
+    const FilePath fp = watched->filepath;
+    auto ptrOk = std::make_shared<bool>(false);
+    auto taskMgr = TaskManager::globalInstance();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        *ptrOk = fnImport(context.get(), progress);
+    });
+    taskMgr->setTitle(taskId, tr("Reload %1").arg(filepathTo<QString>(fp.filename())));
+    taskMgr->onEnded(taskId, this, [=]{
+        auto itWatched = m_mapWatchedFile.find(fp.native());
+        GuiDocument* guiDocReloaded = m_guiApp->findGuiDocument(doc);
+        if (itWatched == m_mapWatchedFile.end() || !guiDocReloaded)
+            return; // Document closed or watching disabled meanwhile
+
+        // Entities added by the import are the ones not existing before, they are destroyed on
+        // failure so the document is left as it was
+        const std::vector<TreeNodeId> vecEntityIdNow = documentEntities(doc);
+        std::vector<TreeNodeId> vecEntityIdNew;
+        for (TreeNodeId entityId : vecEntityIdNow) {
+            auto itOld = std::find(state->vecEntityId.cbegin(), state->vecEntityId.cend(), entityId);
+            if (itOld == state->vecEntityId.cend())
+                vecEntityIdNew.push_back(entityId);
+        }
+
+        // Previous entities identical to imported ones are kept as is
+        const bool ok = *ptrOk;
+        std::vector<TreeNodeId> vecEntityIdToDestroy;
+        if (ok) {
+            const auto& vecKept = context->vecKeptEntity;
+            for (TreeNodeId entityId : state->vecEntityId) {
+                const TDF_Label labelEntity = doc->modelTree().nodeData(entityId);
+                if (std::find(vecKept.cbegin(), vecKept.cend(), labelEntity) == vecKept.cend())
+                    vecEntityIdToDestroy.push_back(entityId);
+            }
+        }
+        else {
+            vecEntityIdToDestroy = vecEntityIdNew;
+        }
+
+        std::vector<ApplicationItem> vecDeselectedItem;
+        for (const ApplicationItem& item : m_guiApp->selectionModel()->selectedItems()) {
+            if (item.document() == doc)
+                vecDeselectedItem.push_back(item);
+        }
+
+        if (ok && !vecDeselectedItem.empty())
+            m_guiApp->selectionModel()->remove(vecDeselectedItem);
+
+        if (!vecEntityIdToDestroy.empty())
+            doc->destroyEntities(vecEntityIdToDestroy);
+
+        if (ok) {
+            // Graphics of new entities are mapped asynchronously, view state is restored once done
+            auto fnRestore = [=]{ this->restoreViewState(guiDocReloaded, *state); };
+            if (!guiDocReloaded->isMappingEntityGraphics()) {
+                fnRestore();
+            }
+            else {
+                auto conn = std::make_shared<QMetaObject::Connection>();
+                *conn = QObject::connect(guiDocReloaded, &GuiDocument::entityGraphicsMapped, this, [=]{
+                    if (!guiDocReloaded->isMappingEntityGraphics()) {
+                        QObject::disconnect(*conn);
+                        fnRestore();
+                    }
+                });
+            }
+        }
+
+        WatchedFile& watchedNow = itWatched->second;
+        watchedNow.isReloading = false;
+        emit this->documentReloaded(doc, ok);
+        if (watchedNow.isReloadPending) {
+            watchedNow.isReloadPending = false;
+            watchedNow.debounceTimer->start(m_debounceDelay);
+        }
+    });
+    taskMgr->run(taskId);
+}
+
+} // namespace Mayo
@@ -0,0 +1,124 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/document_ptr.h"
+#include "../base/filepath.h"
+#include "../base/io_system.h"
+
+#include <QtCore/QObject>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+class QFileSystemWatcher;
+class QTimer;
+
+namespace Mayo {
+
+class GuiApplication;
+class GuiDocument;
+class TaskProgress;
+
+// Watches the source files of documents(see Document::filePath()) and reloads the documents whose
+// file is modified by another program, eg an export pipeline rewriting files in place
+// A change is taken into account once the file is stable(same size and modification time) for
+// debounceDelay(), so a file still being written isn't read. The file is then imported again in
+// background into the same document and old entities are destroyed, except the ones identical to
+// imported entities which are kept along with their graphics(see ReimportDiff). View camera, hidden nodes and
+// selection are restored on the new tree nodes whose path of label names still match(see GuiDocumentViewState)
+// Nothing is done for files not modified: changes are notified by the operating system
+// Disabled by default
+class DocumentFileWatcher : public QObject {
+    Q_OBJECT
+public:
+    DocumentFileWatcher(GuiApplication* guiApp);
+    ~DocumentFileWatcher();
+
+    bool isEnabled() const { return m_fsWatcher != nullptr; }
+    void setEnabled(bool on);
+
+    // In milliseconds, default is 500ms
+    int debounceDelay() const { return m_debounceDelay; }
+    void setDebounceDelay(int msecs) { m_debounceDelay = msecs; }
+
+    struct ReloadContext {
+        DocumentPtr doc;
+        FilePath filepath;
+        std::vector<TDF_Label> vecPreviousEntity; // Entities of 'doc' before reload
+        // Previous entities identical to imported ones, filled by the import function. They are
+        // kept instead of the imported duplicates, so their graphics don't have to be mapped again
+        std::vector<TDF_Label> vecKeptEntity;
+    };
+
+    // Imports file 'context->filepath' into 'context->doc', called from a worker thread
+    // Returns false if the file couldn't be imported(or must not be, eg unsupported format)
+    // Default function imports with IO::System and withReimportDiff(), no other post-processing
+    using ImportFunction = std::function<bool (ReloadContext* context, TaskProgress* progress)>;
+    void setImportFunction(ImportFunction fn) { m_fnImport = std::move(fn); }
+
+    // Makes import operation 'op' reuse data of the previous entities of 'context', see ReimportDiff
+    // Triangulations of unchanged products are carried over before 'fnPostProcess' is called(so
+    // they aren't meshed again) and imported entities identical to previous ones are dropped, see
+    // ReloadContext::vecKeptEntity
+    // Overrides options withEntitiesPostProcess() and withEntityFilter() of 'op', 'context' must
+    // stay valid until 'op' is executed
+    using EntitiesPostProcessFunction =
+            std::function<void(Span<const IO::System::ImportedFileEntities>, TaskProgress*)>;
+    static void withReimportDiff(
+            IO::System::Operation_ImportInDocument& op,
+            ReloadContext* context,
+            EntitiesPostProcessFunction fnPostProcess = {});
+
+signals:
+    void documentReloadStarted(const Mayo::DocumentPtr& doc);
+    // Entities of 'doc' are left unchanged if 'ok' is false
+    void documentReloaded(const Mayo::DocumentPtr& doc, bool ok);
+
+private:
+    struct FileStamp {
+        std::filesystem::file_time_type lastWriteTime;
+        uint64_t size = 0;
+        bool operator==(const FileStamp& other) const {
+            return this->lastWriteTime == other.lastWriteTime && this->size == other.size;
+        }
+        bool operator!=(const FileStamp& other) const { return !(*this == other); }
+    };
+
+    struct WatchedFile {
+        DocumentPtr doc;
+        FilePath filepath;
+        FileStamp stampLoaded; // Stamp of the file when it was last loaded
+        FileStamp stampChecked; // Stamp found by the last debounce check
+        QTimer* debounceTimer = nullptr;
+        bool isReloading = false;
+        bool isReloadPending = false; // File changed again while reloading
+        int missingCheckCount = 0; // Debounce checks done while the file doesn't exist
+    };
+
+    static std::optional<FileStamp> fileStamp(const FilePath& fp);
+
+    void watchDocument(const DocumentPtr& doc);
+    void unwatchDocument(const DocumentPtr& doc);
+    void onFileChanged(const QString& strFilepath);
+    void onDebounceTimeout(const QString& strFilepath);
+    void reloadDocument(const DocumentPtr& doc, WatchedFile* watched);
+    struct ViewState;
+    std::shared_ptr<ViewState> saveViewState(GuiDocument* guiDoc) const;
+    void restoreViewState(GuiDocument* guiDoc, const ViewState& state);
+
+    GuiApplication* m_guiApp = nullptr;
+    QFileSystemWatcher* m_fsWatcher = nullptr;
+    int m_debounceDelay = 500;
+    ImportFunction m_fnImport;
+    // Key is the native path of the file
+    std::unordered_map<FilePath::string_type, WatchedFile> m_mapWatchedFile;
+};
+
+} // namespace Mayo
@@ -9,12 +9,22 @@
 #include "../base/application.h"
 #include "../base/application_item_selection_model.h"
 #include "../base/document.h"
+#include "../base/memory_stats.h"
+#include "document_file_watcher.h"
 #include "gui_document.h"
 
+#include <QtCore/QTimer>
+#include <algorithm>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace Mayo {
 
+namespace Internal {
+// Defined in gui_create_gfx_driver.cpp
+Handle_Graphic3d_GraphicDriver createGfxDriver();
+} // namespace Internal
+
 GuiApplication::GuiApplication(const ApplicationPtr& app)
     : QObject(app.get()),
       m_app(app),
@@ -29,6 +39,7 @@ GuiApplication::GuiApplication(const ApplicationPtr& app)
                 app.get(), &Application::documentAboutToClose,
                 this, &GuiApplication::onDocumentAboutToClose);
     this->connectApplicationItemSelectionChanged(true);
+    m_documentFileWatcher = new DocumentFileWatcher(this);
 }
 
 GuiApplication::~GuiApplication()
@@ -62,6 +73,103 @@ GraphicsTreeNodeMappingDriverTable* GuiApplication::graphicsTreeNodeMappingDrive
     return m_gfxTreeNodeMappingDriverTable.get();
 }
 
+const opencascade::handle<Graphic3d_GraphicDriver>& GuiApplication::graphicDriver() const
+{
+    if (m_gfxDriver.IsNull())
+        m_gfxDriver = Internal::createGfxDriver();
+
+    return m_gfxDriver;
+}
+
+void GuiApplication::setActiveGuiDocument(GuiDocument* guiDoc)
+{
+    if (guiDoc == m_activeGuiDoc)
+        return;
+
+    if (m_activeGuiDoc)
+        m_activeGuiDoc->m_viewTick = this->newViewTick();
+
+    m_activeGuiDoc = guiDoc;
+    if (guiDoc) {
+        guiDoc->m_viewTick = this->newViewTick();
+        guiDoc->restoreReleasedVisibleGraphics();
+    }
+
+    this->enforceGraphicsMemoryBudget();
+}
+
+void GuiApplication::setGraphicsMemoryBudget(int64_t bytes)
+{
+    m_gfxMemoryBudget = std::max(bytes, int64_t(0));
+    this->enforceGraphicsMemoryBudget();
+}
+
+void GuiApplication::enforceGraphicsMemoryBudget()
+{
+    if (m_gfxMemoryBudget <= 0)
+        return;
+
+    struct Candidate {
+        GuiDocument* guiDoc;
+        GuiDocument::ReleasableGraphics gfx;
+    };
+    std::vector<Candidate> vecCandidate;
+    int64_t memoryUsed = 0;
+    for (GuiDocument* guiDoc : m_vecGuiDocument) {
+        MemoryAccounting accounting;
+        const DocumentPtr& doc = guiDoc->document();
+        for (int i = 0; i < doc->entityCount(); ++i)
+            guiDoc->addMemoryStats(doc->entityTreeNodeId(i), &accounting);
+
+        memoryUsed += accounting.stats().presentation + accounting.stats().selection;
+        for (GuiDocument::ReleasableGraphics& gfx : guiDoc->releasableGraphics())
+            vecCandidate.push_back({ guiDoc, std::move(gfx) });
+    }
+
+    if (memoryUsed <= m_gfxMemoryBudget)
+        return;
+
+    // Least recently viewed first
+    std::sort(vecCandidate.begin(), vecCandidate.end(), [](const Candidate& lhs, const Candidate& rhs) {
+        return lhs.gfx.viewTick < rhs.gfx.viewTick;
+    });
+    std::unordered_map<GuiDocument*, std::vector<GraphicsObjectPtr>> mapGuiDocProducts;
+    for (const Candidate& candidate : vecCandidate) {
+        if (memoryUsed <= m_gfxMemoryBudget)
+            break;
+
+        mapGuiDocProducts[candidate.guiDoc].push_back(candidate.gfx.product);
+        memoryUsed -= candidate.gfx.memory;
+    }
+
+    for (const auto& pairGuiDocProducts : mapGuiDocProducts)
+        pairGuiDocProducts.first->releaseGraphics(pairGuiDocProducts.second);
+}
+
+void GuiApplication::setHiddenMeshesCompactionDelay(std::chrono::seconds delay)
+{
+    m_hiddenMeshesCompactionDelay = std::max(delay, std::chrono::seconds(0));
+    if (m_hiddenMeshesCompactionDelay.count() == 0) {
+        if (m_timerCompactHiddenMeshes)
+            m_timerCompactHiddenMeshes->stop();
+
+        return;
+    }
+
+    if (!m_timerCompactHiddenMeshes) {
+        m_timerCompactHiddenMeshes = new QTimer(this);
+        QObject::connect(m_timerCompactHiddenMeshes, &QTimer::timeout, this, [=]{
+            for (GuiDocument* guiDoc : m_vecGuiDocument)
+                guiDoc->compactHiddenMeshes(m_hiddenMeshesCompactionDelay);
+        });
+    }
+
+    // Meshes get compacted no later than 1.5 times the delay(or 30s) after being hidden
+    const auto interval = std::clamp(
+                m_hiddenMeshesCompactionDelay / 2, std::chrono::seconds(1), std::chrono::seconds(30));
+    m_timerCompactHiddenMeshes->start(std::chrono::duration_cast<std::chrono::milliseconds>(interval).count());
+}
+
 void GuiApplication::onDocumentAdded(const DocumentPtr& doc)
 {
     m_vecGuiDocument.push_back(new GuiDocument(doc, this));
@@ -77,7 +185,11 @@ void GuiApplication::onDocumentAboutToClose(const DocumentPtr& doc)
     if (itFound != m_vecGuiDocument.end()) {
         GuiDocument* guiDoc = *itFound;
         m_vecGuiDocument.erase(itFound);
+        if (guiDoc == m_activeGuiDoc)
+            m_activeGuiDoc = nullptr;
+
         emit guiDocumentErased(guiDoc);
+        guiDoc->detach();
         delete guiDoc;
     }
 }
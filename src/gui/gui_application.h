@@ -13,11 +13,17 @@
 #include "../graphics/graphics_tree_node_mapping_driver_table.h"
 #include "gui_document.h"
 
+#include <Graphic3d_GraphicDriver.hxx>
 #include <QtCore/QObject>
+#include <chrono>
+#include <cstdint>
 #include <memory>
 
+class QTimer;
+
 namespace Mayo {
 
+class DocumentFileWatcher;
 class GuiDocument;
 
 class GuiApplication : public QObject {
@@ -37,6 +43,36 @@ public:
     GraphicsObjectDriverTable* graphicsObjectDriverTable() const;
     GraphicsTreeNodeMappingDriverTable* graphicsTreeNodeMappingDriverTable() const;
 
+    // Graphic driver shared by the viewers of all documents, created on first call
+    // GL contexts of the views are then shared, as well as GPU resources(shaders, textures, ...)
+    const opencascade::handle<Graphic3d_GraphicDriver>& graphicDriver() const;
+
+    // Document currently viewed, its visible objects are never released
+    GuiDocument* activeGuiDocument() const { return m_activeGuiDoc; }
+    void setActiveGuiDocument(GuiDocument* guiDoc);
+
+    // -- Memory budget(in bytes) of graphics data, ie presentations and sensitive entities
+    // When the estimated memory of all documents exceeds the budget, data of hidden and not selected
+    // objects is released in least recently viewed order, as well as data of documents not active
+    // Released data is computed again when objects get visible. Budget 0 means no limit(default)
+    int64_t graphicsMemoryBudget() const { return m_gfxMemoryBudget; }
+    void setGraphicsMemoryBudget(int64_t bytes);
+    void enforceGraphicsMemoryBudget();
+
+    // -- Compaction of the meshes hidden for 'delay' at least, see GuiDocument::compactHiddenMeshes()
+    // Documents are checked periodically. Delay 0 means no compaction(default)
+    std::chrono::seconds hiddenMeshesCompactionDelay() const { return m_hiddenMeshesCompactionDelay; }
+    void setHiddenMeshesCompactionDelay(std::chrono::seconds delay);
+
+    // -- Static batching, see GraphicsBatchedObject
+    // Small parts instantiated once are merged by style into a few objects, so thousands of parts
+    // don't take thousands of draw calls. Applies to the document entities mapped afterwards
+    bool isStaticBatchingEnabled() const { return m_isStaticBatchingEnabled; }
+    void setStaticBatchingEnabled(bool on) { m_isStaticBatchingEnabled = on; }
+
+    // -- Auto-reload of documents whose source file is modified by another program
+    DocumentFileWatcher* documentFileWatcher() const { return m_documentFileWatcher; }
+
 signals:
     void guiDocumentAdded(Mayo::GuiDocument* guiDoc);
     void guiDocumentErased(Mayo::GuiDocument* guiDoc);
@@ -51,13 +87,22 @@ private:
     void onApplicationItemSelectionCleared();
     void onApplicationItemSelectionChanged(
             Span<const ApplicationItem> selected, Span<const ApplicationItem> deselected);
+    uint64_t newViewTick() { return ++m_viewTick; }
 
     ApplicationPtr m_app;
     std::vector<GuiDocument*> m_vecGuiDocument;
     ApplicationItemSelectionModel* m_selectionModel = nullptr;
+    DocumentFileWatcher* m_documentFileWatcher = nullptr;
     std::unique_ptr<GraphicsObjectDriverTable> m_gfxObjectDriverTable;
     std::unique_ptr<GraphicsTreeNodeMappingDriverTable> m_gfxTreeNodeMappingDriverTable;
+    mutable opencascade::handle<Graphic3d_GraphicDriver> m_gfxDriver;
     QMetaObject::Connection m_connApplicationItemSelectionChanged;
+    GuiDocument* m_activeGuiDoc = nullptr;
+    int64_t m_gfxMemoryBudget = 0;
+    std::chrono::seconds m_hiddenMeshesCompactionDelay = {};
+    QTimer* m_timerCompactHiddenMeshes = nullptr;
+    bool m_isStaticBatchingEnabled = false;
+    uint64_t m_viewTick = 0; // Logical clock ordering document activations and object hidings
 };
 
 } // namespace Mayo
@@ -8,33 +8,170 @@
 
 #include "../app/theme.h" // TODO Remove this dependency
 #include "../base/application_item.h"
+#include "../base/brep_utils.h"
 #include "../base/bnd_utils.h"
+#include "../base/brep_mesh_priorities.h"
 #include "../base/caf_utils.h"
 #include "../base/cpp_utils.h"
 #include "../base/document.h"
+#include "../base/global.h"
+#include "../base/memory_stats.h"
+#include "../base/perf_stats.h"
+#include "../base/task_manager.h"
 #include "../base/tkernel_utils.h"
 #include "../gui/gui_application.h"
 #include "../gui/qtgui_utils.h"
+#include "../graphics/graphics_batched_object.h"
+#include "../graphics/graphics_instanced_object.h"
+#include "../graphics/graphics_mesh_object.h"
 #include "../graphics/graphics_object_driver_table.h"
+#include "../graphics/graphics_point_cloud_object.h"
 #include "../graphics/graphics_utils.h"
 #include "../graphics/v3d_view_camera_animation.h"
 
 #include <QtCore/QtDebug>
+#include <QtCore/QTimer>
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
 #  include <AIS_ViewCube.hxx>
 #endif
 #include <AIS_ConnectedInteractive.hxx>
+#include <AIS_Shape.hxx>
 #include <AIS_Trihedron.hxx>
+#include <BRep_Tool.hxx>
 #include <Geom_Axis2Placement.hxx>
+#include <Graphic3d_Camera.hxx>
 #include <Graphic3d_GraphicDriver.hxx>
+#include <Precision.hxx>
+#include <SelectMgr_Selection.hxx>
+#include <V3d.hxx>
 #include <V3d_TypeOfOrientation.hxx>
+#include <XCAFPrs_AISObject.hxx>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <mutex>
 
 namespace Mayo {
 
 namespace Internal {
 
-// Defined in gui_create_gfx_driver.cpp
-Handle_Graphic3d_GraphicDriver createGfxDriver();
+// Minimum count of instances of a product to have them grouped into a GraphicsInstancedObject
+constexpr int InstancedObjectMinCount = 16;
+
+// Maximum count of triangles of a part to be merged into a GraphicsBatchedObject
+constexpr int BatchedPartMaxTriangleCount = 5000;
+
+// Maximum count of triangles of a GraphicsBatchedObject, a style can then get several batches
+constexpr int BatchedObjectMaxTriangleCount = 1 << 20;
+
+// Count of graphics objects added to the scene before the event loop gets control back
+constexpr int PublishBatchSize = 500;
+
+// Minimum size(in pixels) of shapes projected in the view for each mesh level of detail, shapes
+// smaller than the last size use the next level
+constexpr int MeshLodPixelSizes[] = { 128, 32 };
+
+// Returns the product displayed by 'object', which is 'object' itself if not an instance
+static GraphicsObjectPtr graphicsProduct(const GraphicsObjectPtr& object)
+{
+    auto gfxInstance = Handle_AIS_ConnectedInteractive::DownCast(object);
+    return gfxInstance ? gfxInstance->ConnectedTo() : object;
+}
+
+// Bounding box of 'product' computed from its data and not from its presentation, so it can be
+// called from any thread. Box of a product shape is taken from the cache of its document(if
+// 'productLabel' isn't null). Returns a void box if not supported for the type of object
+static Bnd_Box productBoundingBox(const GraphicsObjectPtr& product, const TDF_Label& productLabel)
+{
+    auto shapeObject = Handle_AIS_Shape::DownCast(product);
+    auto batchMember = opencascade::handle<GraphicsBatchedObject::Member>::DownCast(product);
+    if (!shapeObject && !batchMember)
+        return Bnd_Box();
+
+    DocumentPtr doc = !productLabel.IsNull() ? Document::findFrom(productLabel) : DocumentPtr();
+    if (!doc.IsNull())
+        return doc->shapeBoundingBox(productLabel);
+    else
+        return BRepUtils::boundingBox(shapeObject ? shapeObject->Shape() : batchMember->shape());
+}
+
+// Whether the part 'shape' can be merged into a GraphicsBatchedObject: all its faces are
+// triangulated(without levels of detail) and the count of triangles is small enough
+static bool isShapeBatchable(const TopoDS_Shape& shape)
+{
+    if (BRepUtils::meshLodCount(shape) > 1)
+        return false;
+
+    int triangleCount = 0;
+    bool isMeshed = true;
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        if (triangulation)
+            triangleCount += triangulation->NbTriangles();
+        else
+            isMeshed = false;
+    });
+
+    return isMeshed && triangleCount > 0 && triangleCount <= BatchedPartMaxTriangleCount;
+}
+
+// Returns the part shape of 'product', null if 'product' isn't a shape object nor a batch member
+static TopoDS_Shape productShape(const GraphicsObjectPtr& product)
+{
+    auto shapeObject = Handle_AIS_Shape::DownCast(product);
+    if (shapeObject)
+        return shapeObject->Shape();
+
+    auto batchMember = opencascade::handle<GraphicsBatchedObject::Member>::DownCast(product);
+    return batchMember ? batchMember->shape() : TopoDS_Shape();
+}
+
+// Meshing priority of an object having bounding box 'bndBox', for the view 'camera'
+// Priority is in [2,3] for a visible object within the view frustum, in [1,1.5] for a visible
+// object out of the frustum and in [0,0.5] for a hidden one, then grows with the projected area
+// The frustum test is conservative, it's done on the projected corners of the box
+static double meshPriority(const Handle_Graphic3d_Camera& camera, const Bnd_Box& bndBox, bool isVisible)
+{
+    const double priorityBase = isVisible ? 1. : 0.;
+    if (bndBox.IsVoid())
+        return priorityBase;
+
+    // Bounding rectangle of the projected box, in normalized device coordinates([-1,1] in view)
+    double xMin = RealLast(), yMin = RealLast();
+    double xMax = RealFirst(), yMax = RealFirst();
+    bool isInDepthRange = false;
+    for (const gp_Pnt& pnt : BndBoxCoords::get(bndBox).vertices()) {
+        const gp_Pnt pntProj = camera->Project(pnt);
+        xMin = std::min(xMin, pntProj.X());
+        yMin = std::min(yMin, pntProj.Y());
+        xMax = std::max(xMax, pntProj.X());
+        yMax = std::max(yMax, pntProj.Y());
+        isInDepthRange = isInDepthRange || std::abs(pntProj.Z()) <= 1.;
+    }
+
+    // Areas are relative to the view area
+    const double area = (xMax - xMin) * (yMax - yMin) / 4.;
+    const double clippedWidth = std::min(xMax, 1.) - std::max(xMin, -1.);
+    const double clippedHeight = std::min(yMax, 1.) - std::max(yMin, -1.);
+    if (isVisible && isInDepthRange && clippedWidth >= 0 && clippedHeight >= 0)
+        return 2. + std::min(clippedWidth * clippedHeight / 4., 1.);
+
+    return priorityBase + 0.5 * std::min(area, 1.);
+}
+
+// Standard orientation(see V3d_TypeOfOrientation) whose projection is 'viewProj', -1 if none
+static int standardViewOrientation(const gp_Dir& viewProj)
+{
+    for (int i = V3d_Xpos; i <= V3d_XnegYnegZneg; ++i) {
+        if (V3d::GetProjAxis(V3d_TypeOfOrientation(i)).IsEqual(viewProj, Precision::Angular()))
+            return i;
+    }
+
+    return -1;
+}
 
 static Handle_AIS_Trihedron createOriginTrihedron()
 {
@@ -66,7 +203,7 @@ GuiDocument::GuiDocument(const DocumentPtr& doc, GuiApplication* guiApp)
     : QObject(guiApp),
       m_guiApp(guiApp),
       m_document(doc),
-      m_gfxScene(this),
+      m_gfxScene(guiApp->graphicDriver(), this),
       m_v3dView(m_gfxScene.createV3dView()),
       m_aisOriginTrihedron(Internal::createOriginTrihedron()),
       m_cameraAnimation(new V3dViewCameraAnimation(m_v3dView, this))
@@ -97,17 +234,55 @@ GuiDocument::GuiDocument(const DocumentPtr& doc, GuiApplication* guiApp)
                 Aspect_GFM_VER);
 
     m_cameraAnimation->setEasingCurve(QEasingCurve::OutExpo);
+    m_cameraAnimation->setRedrawFunction([=]{ m_gfxScene.redraw(); });
 
     for (int i = 0; i < doc->entityCount(); ++i)
         this->mapEntity(doc->entityTreeNodeId(i));
 
     QObject::connect(doc.get(), &Document::entityAdded, this, &GuiDocument::onDocumentEntityAdded);
+    QObject::connect(doc.get(), &Document::entitiesAdded, this, [=](const std::vector<TreeNodeId>& vecEntityId) {
+        for (TreeNodeId entityId : vecEntityId)
+            this->onDocumentEntityAdded(entityId);
+    });
     QObject::connect(
                 doc.get(), &Document::entityAboutToBeDestroyed,
                 this, &GuiDocument::onDocumentEntityAboutToBeDestroyed);
+    QObject::connect(
+                doc.get(), &Document::entitiesAboutToBeDestroyed,
+                this, [=](const std::vector<TreeNodeId>& vecEntityId) {
+        this->onDocumentEntitiesAboutToBeDestroyed(vecEntityId);
+    });
     QObject::connect(
                 &m_gfxScene, &GraphicsScene::selectionChanged,
                 this, &GuiDocument::onGraphicsSelectionChanged);
+    QObject::connect(this, &GuiDocument::nodesVisibilityChanged, this, &GuiDocument::updateMeshPriorities);
+}
+
+Handle_V3d_View GuiDocument::createSecondaryV3dView(V3d_TypeOfOrientation proj)
+{
+    Handle_V3d_View view = m_gfxScene.createV3dView();
+    view->ChangeRenderingParams() = m_v3dView->RenderingParams();
+    view->ChangeRenderingParams().CollectedStats = Graphic3d_RenderingParams::PerfCounters_NONE;
+    const Aspect_GradientBackground bkgGradient = m_v3dView->GradientBackground();
+    Quantity_Color bkgGradientStart, bkgGradientEnd;
+    bkgGradient.Colors(bkgGradientStart, bkgGradientEnd);
+    view->SetBgGradientColors(bkgGradientStart, bkgGradientEnd, bkgGradient.BgGradientFillMethod());
+    view->SetProj(proj);
+    if (m_gfxHlrObject)
+        m_gfxScene.setObjectVisibleInView(m_gfxHlrObject, view, false);
+
+    m_vecSecondaryV3dView.push_back(view);
+    return view;
+}
+
+void GuiDocument::destroySecondaryV3dView(const Handle_V3d_View& view)
+{
+    auto itView = std::find(m_vecSecondaryV3dView.begin(), m_vecSecondaryV3dView.end(), view);
+    if (itView == m_vecSecondaryV3dView.end())
+        return;
+
+    m_vecSecondaryV3dView.erase(itView);
+    view->Remove();
 }
 
 void GuiDocument::foreachGraphicsObject(
@@ -128,18 +303,92 @@ void GuiDocument::foreachGraphicsObject(
     });
 }
 
+void GuiDocument::addMemoryStats(TreeNodeId nodeId, MemoryAccounting* accounting) const
+{
+    this->foreachGraphicsObject(nodeId, [=](GraphicsObjectPtr object) {
+        GraphicsUtils::AisObject_addMemoryStats(object, accounting);
+    });
+}
+
 TreeNodeId GuiDocument::nodeFromGraphicsObject(const GraphicsObjectPtr& object) const
 {
     if (!object)
         return 0;
 
-    for (const GraphicsEntity& gfxEntity: m_vecGraphicsEntity) {
-        auto it = gfxEntity.mapGfxObjectTreeNode.find(object);
-        if (it != gfxEntity.mapGfxObjectTreeNode.cend())
-            return it->second;
+    auto itFound = m_mapGfxObjectTreeNode.find(object);
+    return itFound != m_mapGfxObjectTreeNode.cend() ? itFound->second : 0;
+}
+
+void GuiDocument::updateProductGraphics(const TDF_Label& labelProduct)
+{
+    const Tree<TDF_Label>& docModelTree = m_document->modelTree();
+    auto fnNodeProductLabel = [&](TreeNodeId nodeId) {
+        const TDF_Label& nodeLabel = docModelTree.nodeData(nodeId);
+        return XCaf::isShapeReference(nodeLabel) ? XCaf::shapeReferred(nodeLabel) : nodeLabel;
+    };
+
+    bool isBoundingBoxChanged = false;
+    std::unordered_set<GraphicsObjectPtr> setObjectRecomputed;
+    GraphicsSceneRedrawBlocker redrawBlocker(&m_gfxScene);
+    for (GraphicsEntity& gfxEntity : m_vecGraphicsEntity) {
+        std::unordered_set<GraphicsObjectPtr> setEntityObject;
+        for (const auto& [nodeId, gfxObject] : gfxEntity.mapTreeNodeGfxObject) {
+            if (fnNodeProductLabel(nodeId) == labelProduct)
+                setEntityObject.insert(gfxObject);
+        }
+
+        if (setEntityObject.empty())
+            continue;
+
+        for (GraphicsEntity::Object& object : gfxEntity.vecObject) {
+            if (setEntityObject.find(object.ptr) == setEntityObject.cend())
+                continue;
+
+            // Members are drawn by their batch, which merges the triangulations again
+            GraphicsBatchedObject* gfxBatched = GraphicsBatchedObject::fromMember(object.ptr);
+            if (gfxBatched && setObjectRecomputed.insert(gfxBatched).second) {
+                gfxBatched->prepare();
+                m_gfxScene.recomputeObjectPresentation(gfxBatched);
+            }
+
+            // Product comes first, presentations of instances are computed from the product one
+            GraphicsInstancedObject* gfxInstanced = GraphicsInstancedObject::fromInstance(object.ptr);
+            const GraphicsObjectPtr product =
+                    gfxInstanced ? gfxInstanced->product() : Internal::graphicsProduct(object.ptr);
+            if (!gfxBatched && setObjectRecomputed.insert(product).second) {
+                auto xcafObject = Handle_XCAFPrs_AISObject::DownCast(product);
+                if (xcafObject)
+                    xcafObject->DispatchStyles(true);
+
+                auto driver = GraphicsObjectDriver::get(product);
+                if (driver)
+                    driver->prepareObject(product);
+
+                m_gfxScene.recomputeObjectPresentation(product);
+            }
+
+            const GraphicsObjectPtr displayedObject = gfxInstanced ? GraphicsObjectPtr(gfxInstanced) : object.ptr;
+            if (!gfxBatched && setObjectRecomputed.insert(displayedObject).second)
+                m_gfxScene.recomputeObjectPresentation(displayedObject);
+
+            object.bndBox = Internal::productBoundingBox(product, labelProduct).Transformed(object.trsfOriginal);
+            BndUtils::add(&gfxEntity.bndBox, object.bndBox);
+            BndUtils::add(&m_gfxBoundingBox, object.bndBox);
+            isBoundingBoxChanged = true;
+        }
+
+        m_partBvh.addEntity(m_document, gfxEntity.treeNodeId); // Replaces the outdated part boxes
     }
 
-    return 0;
+    if (isBoundingBoxChanged) {
+        m_vecExplodeItem.clear();
+        emit graphicsBoundingBoxChanged(m_gfxBoundingBox);
+    }
+
+    if (!setObjectRecomputed.empty()) {
+        this->clearHiddenLinesCache();
+        this->updateHiddenLines();
+    }
 }
 
 void GuiDocument::toggleItemSelected(const ApplicationItem& appItem)
@@ -184,121 +433,896 @@ void GuiDocument::setActiveDisplayMode(const GraphicsObjectDriverPtr& driver, in
         return;
 
     m_mapGfxDriverDisplayMode.insert_or_assign(driver, mode);
+    this->applyDisplayMode(driver, mode);
+}
+
+void GuiDocument::beginViewInteraction(const ViewInteractionOptions& options)
+{
+    if (m_isViewInteractionActive)
+        return;
+
+    m_isViewInteractionActive = true;
+    // Size culling is provided by the Z-layer of the objects
+    const Handle_V3d_Viewer& viewer = m_gfxScene.v3dViewer();
+    m_defaultZLayerSettingsBackup = viewer->ZLayerSettings(Graphic3d_ZLayerId_Default);
+    if (options.cullingPixelSize > 0) {
+        Graphic3d_ZLayerSettings settings = m_defaultZLayerSettingsBackup;
+        settings.SetCullingSize(options.cullingPixelSize);
+        viewer->SetZLayerSettings(Graphic3d_ZLayerId_Default, settings);
+    }
+
+    if (options.plainShaded) {
+        for (const GraphicsObjectDriverPtr& driver : m_guiApp->graphicsObjectDriverTable()->drivers()) {
+            auto shapeDriver = opencascade::handle<GraphicsShapeObjectDriver>::DownCast(driver);
+            if (shapeDriver
+                    && this->activeDisplayMode(driver) == GraphicsShapeObjectDriver::DisplayMode_ShadedWithFaceBoundary)
+            {
+                this->applyDisplayMode(driver, GraphicsShapeObjectDriver::DisplayMode_Shaded);
+                m_vecInteractionPlainShadedDriver.push_back(driver);
+            }
+        }
+    }
+}
+
+void GuiDocument::endViewInteraction()
+{
+    if (!m_isViewInteractionActive)
+        return;
+
+    m_isViewInteractionActive = false;
+    m_gfxScene.v3dViewer()->SetZLayerSettings(Graphic3d_ZLayerId_Default, m_defaultZLayerSettingsBackup);
+    for (const GraphicsObjectDriverPtr& driver : m_vecInteractionPlainShadedDriver)
+        this->applyDisplayMode(driver, this->activeDisplayMode(driver));
+
+    m_vecInteractionPlainShadedDriver.clear();
+    m_gfxScene.redraw();
+}
+
+void GuiDocument::applyDisplayMode(const GraphicsObjectDriverPtr& driver, int mode)
+{
+    if (opencascade::handle<GraphicsShapeObjectDriver>::DownCast(driver)) {
+        if (mode == GraphicsShapeObjectDriver::DisplayMode_HiddenLineRemoval) {
+            if (!m_gfxHlrObject) {
+                // Objects keep their current presentation until the first edges are ready
+                this->beginHiddenLineRemoval(driver);
+                return;
+            }
+        }
+        else if (m_gfxHlrObject) {
+            this->endHiddenLineRemoval();
+        }
+    }
+
+    this->applyObjectsDisplayMode(driver, mode);
+}
+
+void GuiDocument::applyObjectsDisplayMode(const GraphicsObjectDriverPtr& driver, int mode)
+{
     for (const TreeNodeId entityNodeId : m_document->modelTree().roots()) {
         this->foreachGraphicsObject(entityNodeId, [&](GraphicsObjectPtr object) {
             if (GraphicsObjectDriver::get(object) == driver)
                 driver->applyDisplayMode(object, mode);
         });
     }
+
+    // Instances are presented through their group
+    for (const GraphicsEntity& gfxEntity : m_vecGraphicsEntity) {
+        for (const GraphicsObjectPtr& object : gfxEntity.vecInstancedObject) {
+            if (GraphicsObjectDriver::get(object) == driver)
+                driver->applyDisplayMode(object, mode);
+        }
+    }
+}
+
+void GuiDocument::beginHiddenLineRemoval(const GraphicsObjectDriverPtr& driver)
+{
+    m_gfxHlrObject = new GraphicsHlrObject;
+    m_gfxScene.addObject(m_gfxHlrObject);
+    for (const Handle_V3d_View& view : m_vecSecondaryV3dView)
+        m_gfxScene.setObjectVisibleInView(m_gfxHlrObject, view, false);
+
+    m_hlrPendingDriver = driver;
+    this->updateHiddenLines();
+}
+
+void GuiDocument::endHiddenLineRemoval()
+{
+    if (m_hlrTaskId)
+        TaskManager::globalInstance()->requestAbort(*m_hlrTaskId);
+
+    m_hlrTaskId.reset();
+    m_hlrPendingDriver.Nullify();
+    m_gfxScene.eraseObject(m_gfxHlrObject);
+    m_gfxHlrObject.Nullify();
+    m_mapOrientationHlrEdges.clear();
+}
+
+void GuiDocument::clearHiddenLinesCache()
+{
+    m_mapOrientationHlrEdges.clear();
+}
+
+void GuiDocument::updateHiddenLines()
+{
+    if (!m_gfxHlrObject)
+        return;
+
+    double projX, projY, projZ;
+    m_v3dView->Proj(projX, projY, projZ);
+    const gp_Dir viewProj(projX, projY, projZ);
+    const int orientation = Internal::standardViewOrientation(viewProj);
+    if (orientation < 0 && !viewProj.IsEqual(m_hlrViewProj, Precision::Angular()))
+        m_mapOrientationHlrEdges.erase(-1);
+
+    m_hlrViewProj = viewProj;
+
+    // Visible shapes, only the ones not cached yet have to be computed
+    struct HlrJob {
+        GraphicsObjectPtr object;
+        TopoDS_Shape shape;
+        gp_Trsf trsf;
+        Handle_Graphic3d_ArrayOfSegments edges;
+    };
+    struct HlrResult {
+        std::vector<HlrJob> vecJob;
+        QMetaObject::Connection connTaskEnded;
+    };
+    auto result = std::make_shared<HlrResult>();
+    std::vector<GraphicsObjectPtr> vecVisibleObject;
+    const MapGfxObjectHlrEdges& mapEdges = m_mapOrientationHlrEdges[orientation];
+    for (const GraphicsEntity& gfxEntity : m_vecGraphicsEntity) {
+        for (const GraphicsEntity::Object& object : gfxEntity.vecObject) {
+            auto shapeObject = Handle_AIS_Shape::DownCast(Internal::graphicsProduct(object.ptr));
+            if (!shapeObject || !GraphicsUtils::AisObject_isVisible(object.ptr))
+                continue;
+
+            vecVisibleObject.push_back(object.ptr);
+            if (mapEdges.find(object.ptr) == mapEdges.cend())
+                result->vecJob.push_back({ object.ptr, shapeObject->Shape(), object.ptr->Transformation(), {} });
+        }
+    }
+
+    auto taskMgr = TaskManager::globalInstance();
+    if (m_hlrTaskId)
+        taskMgr->requestAbort(*m_hlrTaskId);
+
+    m_hlrTaskId.reset();
+    if (result->vecJob.empty()) {
+        this->showHiddenLines(orientation, vecVisibleObject);
+        return;
+    }
+
+    const DocumentPtr doc = m_document;
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        // Triangulations must not be replaced meanwhile
+        std::lock_guard<std::mutex> lockData(doc->dataMutex()); MAYO_UNUSED(lockData);
+        const int jobCount = int(result->vecJob.size());
+        std::atomic<int> jobDoneCount = 0;
+        std::mutex mutexProgress;
+        CppUtils::parallelFor(jobCount, [&](int i) {
+            if (TaskProgress::isAbortRequested(progress))
+                return;
+
+            HlrJob& job = result->vecJob.at(i);
+            job.edges = GraphicsHlr::visibleEdges(job.shape, job.trsf, viewProj);
+            const int doneCount = ++jobDoneCount;
+            std::lock_guard<std::mutex> lock(mutexProgress);
+            const int pct = (doneCount * 100) / jobCount;
+            if (pct > progress->value())
+                progress->setValue(pct);
+        });
+    });
+    m_hlrTaskId = taskId;
+    result->connTaskEnded = QObject::connect(
+                taskMgr, &TaskManager::ended,
+                this, [=](TaskId endedTaskId) {
+        if (endedTaskId != taskId)
+            return;
+
+        QObject::disconnect(result->connTaskEnded);
+        if (m_hlrTaskId != taskId)
+            return; // Aborted, or hidden line removal is no longer active
+
+        m_hlrTaskId.reset();
+        MapGfxObjectHlrEdges& mapOrientationEdges = m_mapOrientationHlrEdges[orientation];
+        for (const HlrJob& job : result->vecJob)
+            mapOrientationEdges.insert({ job.object, job.edges });
+
+        this->showHiddenLines(orientation, vecVisibleObject);
+    });
+    taskMgr->setTitle(taskId, tr("Hidden line removal"));
+    taskMgr->run(taskId);
+}
+
+void GuiDocument::setMeshProblemsHighlighted(bool on)
+{
+    if (on == m_isMeshProblemsHighlighted)
+        return;
+
+    m_isMeshProblemsHighlighted = on;
+    this->updateMeshProblemsHighlight();
+}
+
+void GuiDocument::updateMeshProblemsHighlight()
+{
+    for (const auto& [entityTreeNodeId, gfxObject] : m_mapEntityMeshProblems)
+        m_gfxScene.eraseObject(gfxObject);
+
+    m_mapEntityMeshProblems.clear();
+    if (m_isMeshProblemsHighlighted) {
+        for (const GraphicsEntity& gfxEntity : m_vecGraphicsEntity) {
+            const TDF_Label entityLabel = m_document->modelTree().nodeData(gfxEntity.treeNodeId);
+            auto report = m_document->findMeshQualityReport(entityLabel);
+            if (!report || report->vecProblemTriangle.empty())
+                continue;
+
+            // Triangles don't share nodes, so problems stay visible even if mesh is non-manifold
+            const int triangleCount = int(report->vecProblemTriangle.size());
+            Handle_Poly_Triangulation mesh = new Poly_Triangulation(3 * triangleCount, triangleCount, false);
+            TColgp_Array1OfPnt& vecMeshNode = mesh->ChangeNodes();
+            Poly_Array1OfTriangle& vecMeshTriangle = mesh->ChangeTriangles();
+            for (int i = 0; i < triangleCount; ++i) {
+                const std::array<gp_XYZ, 3>& triangle = report->vecProblemTriangle.at(i);
+                for (int j = 0; j < 3; ++j)
+                    vecMeshNode.ChangeValue(3 * i + j + 1).SetXYZ(triangle.at(j));
+
+                vecMeshTriangle.ChangeValue(i + 1).Set(3 * i + 1, 3 * i + 2, 3 * i + 3);
+            }
+
+            opencascade::handle<GraphicsMeshObject> gfxObject = new GraphicsMeshObject(mesh);
+            gfxObject->setColor(Quantity_NOC_RED);
+            // Drawn over the faces of the entity
+            gfxObject->SetPolygonOffsets(Aspect_POM_Fill, -1.f, -1.f);
+            m_gfxScene.addObject(gfxObject);
+            m_gfxScene.deactivateObjectSelection(gfxObject, 0);
+            m_mapEntityMeshProblems.emplace(gfxEntity.treeNodeId, gfxObject);
+        }
+    }
+
+    m_gfxScene.redraw();
+}
+
+void GuiDocument::showHiddenLines(int orientation, Span<const GraphicsObjectPtr> spanObject)
+{
+    const MapGfxObjectHlrEdges& mapEdges = m_mapOrientationHlrEdges[orientation];
+    std::vector<Handle_Graphic3d_ArrayOfSegments> vecEdges;
+    for (const GraphicsObjectPtr& object : spanObject) {
+        Handle_Graphic3d_ArrayOfSegments edges = CppUtils::findValue(object, mapEdges);
+        if (edges)
+            vecEdges.push_back(edges);
+    }
+
+    m_gfxHlrObject->setEdges(std::move(vecEdges));
+    m_gfxScene.recomputeObjectPresentation(m_gfxHlrObject);
+    if (m_hlrPendingDriver) {
+        this->applyObjectsDisplayMode(m_hlrPendingDriver, GraphicsShapeObjectDriver::DisplayMode_HiddenLineRemoval);
+        m_hlrPendingDriver.Nullify();
+    }
+
+    m_gfxScene.redraw();
 }
 
 Qt::CheckState GuiDocument::nodeVisibleState(TreeNodeId nodeId) const
 {
-    auto itFound = m_mapTreeNodeCheckState.find(nodeId);
-    return itFound != m_mapTreeNodeCheckState.cend() ? itFound->second : Qt::Unchecked;
+    if (!this->isNodeVisibleStateMapped(nodeId))
+        return Qt::Unchecked;
+
+    if (m_vecTreeNodePartiallyChecked.at(nodeId))
+        return Qt::PartiallyChecked;
+
+    return m_vecTreeNodeChecked.at(nodeId) ? Qt::Checked : Qt::Unchecked;
 }
 
 void GuiDocument::setNodeVisible(TreeNodeId nodeId, bool on)
 {
-    auto itNode = m_mapTreeNodeCheckState.find(nodeId);
-    if (itNode == m_mapTreeNodeCheckState.end())
-        return; // Error: unknown tree node
+    this->setNodesVisible(Span<const TreeNodeId>(&nodeId, 1), on);
+}
 
+void GuiDocument::setNodesVisible(Span<const TreeNodeId> spanNodeId, bool on)
+{
+    // Keep track of all the nodes whose visibility state are altered
+    std::unordered_map<TreeNodeId, Qt::CheckState> mapNodeIdVisibleState;
+    std::vector<TreeNodeId> vecChangedNodeId;
     const Qt::CheckState nodeVisibleState = on ? Qt::Checked : Qt::Unchecked;
-    if (itNode->second == nodeVisibleState)
-        return; // Same visible state
+    const Tree<TDF_Label>& docModelTree = m_document->modelTree();
+    if (on && !m_setShapeCompacted.empty()) {
+        // Compacted meshes of all the objects are expanded at once, concurrently
+        std::vector<GraphicsObjectPtr> vecObject;
+        for (TreeNodeId nodeId : spanNodeId) {
+            if (this->isNodeVisibleStateMapped(nodeId)) {
+                this->foreachGraphicsObject(nodeId, [&](GraphicsObjectPtr gfxObject){
+                    vecObject.push_back(gfxObject);
+                });
+            }
+        }
+
+        this->expandCompactedMeshes(vecObject);
+    }
+
+    {
+        GraphicsSceneRedrawBlocker redrawBlocker(&m_gfxScene);
+        for (TreeNodeId nodeId : spanNodeId) {
+            if (!this->isNodeVisibleStateMapped(nodeId))
+                continue; // Error: unknown tree node
+
+            if (this->nodeVisibleState(nodeId) == nodeVisibleState)
+                continue; // Same visible state(maybe already set as child of a previous node)
+
+            // Recursive show/hide of the node graphics
+            traverseTree(nodeId, docModelTree, [&](TreeNodeId id) {
+                if (this->updateNodeVisibleState(id, nodeVisibleState))
+                    mapNodeIdVisibleState[id] = nodeVisibleState;
+            });
+            this->foreachGraphicsObject(nodeId, [=](GraphicsObjectPtr gfxObject){
+                this->setGraphicsObjectVisible(gfxObject, on);
+            });
+            vecChangedNodeId.push_back(nodeId);
+        }
+
+        this->updateBatchedObjects();
+        if (on)
+            this->restoreNodesSelection(vecChangedNodeId);
+    }
+
+    this->updateParentNodesVisibleState(vecChangedNodeId, &mapNodeIdVisibleState);
+
+    // Notify all node visibility changes at once
+    if (!mapNodeIdVisibleState.empty())
+        emit nodesVisibilityChanged(mapNodeIdVisibleState);
+
+    this->updateHiddenLines();
+    if (!on)
+        m_guiApp->enforceGraphicsMemoryBudget();
+}
+
+void GuiDocument::isolate(Span<const TreeNodeId> spanNodeId)
+{
+    // Nodes to be shown are the input nodes and their children, all the others get hidden
+    std::vector<bool> vecNodeShown(m_vecTreeNodeMapped.size(), false);
+    std::vector<TreeNodeId> vecIsolatedNodeId;
+    std::vector<TreeNodeId> vecShownNodeId; // Isolated nodes which were not fully visible
+    for (TreeNodeId nodeId : spanNodeId) {
+        if (this->isNodeVisibleStateMapped(nodeId)) {
+            vecNodeShown[nodeId] = true;
+            vecIsolatedNodeId.push_back(nodeId);
+            if (this->nodeVisibleState(nodeId) != Qt::Checked)
+                vecShownNodeId.push_back(nodeId);
+        }
+    }
 
-    // Helper data/function to keep track of all the nodes whose visibility state are altered
     std::unordered_map<TreeNodeId, Qt::CheckState> mapNodeIdVisibleState;
-    auto fnSetNodeVisibleState = [&](TreeNodeId id, Qt::CheckState state) {
-        auto it = m_mapTreeNodeCheckState.find(id);
-        if (it == m_mapTreeNodeCheckState.cend()) {
-            m_mapTreeNodeCheckState[id] = state;
-            mapNodeIdVisibleState[id] = state;
+    const Tree<TDF_Label>& docModelTree = m_document->modelTree();
+    {
+        GraphicsSceneRedrawBlocker redrawBlocker(&m_gfxScene);
+        for (const GraphicsEntity& gfxEntity : m_vecGraphicsEntity) {
+            if (!this->isNodeVisibleStateMapped(gfxEntity.treeNodeId))
+                continue; // Graphics of entity not published yet
+
+            // Pre-order traversal: parent node is visited before its children
+            traverseTree(gfxEntity.treeNodeId, docModelTree, [&](TreeNodeId id) {
+                const TreeNodeId parentId = docModelTree.nodeParent(id);
+                if (parentId != 0 && vecNodeShown.at(parentId))
+                    vecNodeShown[id] = true;
+
+                const bool show = vecNodeShown.at(id);
+                const Qt::CheckState state = show ? Qt::Checked : Qt::Unchecked;
+                if (this->updateNodeVisibleState(id, state))
+                    mapNodeIdVisibleState[id] = state;
+
+                GraphicsObjectPtr gfxObject = CppUtils::findValue(id, gfxEntity.mapTreeNodeGfxObject);
+                if (gfxObject && GraphicsUtils::AisObject_isVisible(gfxObject) != show)
+                    this->setGraphicsObjectVisible(gfxObject, show);
+            });
+        }
+
+        this->updateBatchedObjects();
+        this->restoreNodesSelection(vecShownNodeId);
+    }
+
+    this->updateParentNodesVisibleState(vecIsolatedNodeId, &mapNodeIdVisibleState);
+    if (!mapNodeIdVisibleState.empty())
+        emit nodesVisibilityChanged(mapNodeIdVisibleState);
+
+    this->updateHiddenLines();
+    m_guiApp->enforceGraphicsMemoryBudget();
+}
+
+void GuiDocument::setExplodingFactor(double t)
+{
+    m_explodingFactor = t;
+    if (m_vecExplodeItem.empty())
+        this->computeExplodeItems();
+
+    // Translation applied after original transformation: only the translation part changes
+    for (const ExplodeItem& item : m_vecExplodeItem) {
+        if (GraphicsBatchedObject::fromMember(item.object))
+            continue; // Batched parts are static
+
+        gp_Trsf trsfObject = item.trsfOriginal;
+        trsfObject.SetTranslationPart(item.trsfOriginal.TranslationPart() + t * item.vecMove);
+        m_gfxScene.setObjectTransformation(item.object, trsfObject);
+    }
+
+    m_gfxScene.redraw();
+    if (m_gfxHlrObject) {
+        this->clearHiddenLinesCache();
+        this->updateHiddenLines();
+    }
+}
+
+void GuiDocument::setExplodingMode(ExplodingMode mode)
+{
+    if (mode == m_explodingMode)
+        return;
+
+    m_explodingMode = mode;
+    m_vecExplodeItem.clear();
+    this->setExplodingFactor(m_explodingFactor);
+}
+
+void GuiDocument::setExplodingLevelFactors(Span<const double> spanFactor)
+{
+    m_vecExplodingLevelFactor.assign(spanFactor.begin(), spanFactor.end());
+    if (m_vecExplodingLevelFactor.empty())
+        m_vecExplodingLevelFactor.push_back(1.);
+
+    if (m_explodingMode == ExplodingMode::Hierarchical) {
+        m_vecExplodeItem.clear();
+        this->setExplodingFactor(m_explodingFactor);
+    }
+}
+
+void GuiDocument::updateMeshLods()
+{
+    // Triangulations must not be switched while a worker thread replaces them
+    std::unique_lock<std::mutex> lock(m_document->dataMutex(), std::try_to_lock);
+    if (!lock.owns_lock())
+        return;
+
+    std::unordered_map<GraphicsObjectPtr, int> mapProductPixelSize;
+    for (const GraphicsEntity& entity : m_vecGraphicsEntity) {
+        for (const GraphicsEntity::Object& object : entity.vecObject) {
+            if (object.bndBox.IsVoid())
+                continue;
+
+            const int pixelSize = m_v3dView->Convert(std::sqrt(object.bndBox.SquareExtent()));
+            int& productPixelSize = mapProductPixelSize[Internal::graphicsProduct(object.ptr)];
+            productPixelSize = std::max(productPixelSize, pixelSize);
+        }
+    }
+
+    bool changed = false;
+    for (const auto& pairProductPixelSize : mapProductPixelSize) {
+        const GraphicsObjectPtr& product = pairProductPixelSize.first;
+        const int pixelSize = pairProductPixelSize.second;
+        auto shapeObject = Handle_AIS_Shape::DownCast(product);
+        if (!shapeObject)
+            continue;
+
+        const TopoDS_Shape& shape = shapeObject->Shape();
+        const int lodCount = BRepUtils::meshLodCount(shape);
+        if (lodCount <= 1)
+            continue;
+
+        int lod = 0;
+        while (lod < int(std::size(Internal::MeshLodPixelSizes))
+               && pixelSize < Internal::MeshLodPixelSizes[lod])
+        {
+            ++lod;
+        }
+
+        lod = std::min(lod, lodCount - 1);
+        if (lod != BRepUtils::activeMeshLod(shape) && BRepUtils::activateMeshLod(shape, lod)) {
+            m_gfxScene.recomputeObjectPresentation(product);
+            changed = true;
+        }
+    }
+
+    if (changed)
+        m_gfxScene.redraw();
+}
+
+void GuiDocument::resetMeshLods()
+{
+    std::lock_guard<std::mutex> lock(m_document->dataMutex()); MAYO_UNUSED(lock);
+    std::unordered_set<GraphicsObjectPtr> setProduct;
+    bool changed = false;
+    for (const GraphicsEntity& entity : m_vecGraphicsEntity) {
+        for (const GraphicsEntity::Object& object : entity.vecObject) {
+            const GraphicsObjectPtr product = Internal::graphicsProduct(object.ptr);
+            auto shapeObject = Handle_AIS_Shape::DownCast(product);
+            if (shapeObject && setProduct.insert(product).second) {
+                if (BRepUtils::activeMeshLod(shapeObject->Shape()) != 0
+                        && BRepUtils::activateMeshLod(shapeObject->Shape(), 0))
+                {
+                    m_gfxScene.recomputeObjectPresentation(product);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    if (changed)
+        m_gfxScene.redraw();
+}
+
+std::shared_ptr<BRepMeshPriorities> GuiDocument::beginMeshPriorities()
+{
+    std::vector<GraphicsObjectPtr> vecProduct;
+    std::vector<TopoDS_Shape> vecPart;
+    std::unordered_set<GraphicsObjectPtr> setProduct;
+    for (const GraphicsEntity& entity : m_vecGraphicsEntity) {
+        for (const GraphicsEntity::Object& object : entity.vecObject) {
+            const GraphicsObjectPtr product = Internal::graphicsProduct(object.ptr);
+            const TopoDS_Shape shape = Internal::productShape(product);
+            if (!shape.IsNull() && setProduct.insert(product).second) {
+                vecProduct.push_back(product);
+                vecPart.push_back(shape);
+            }
+        }
+    }
+
+    m_meshPriorities = std::make_shared<BRepMeshPriorities>(std::move(vecPart));
+    m_vecMeshPriorityProduct = std::move(vecProduct);
+    m_setMeshPriorityRecomputed.clear();
+    this->updateMeshPriorities();
+    if (!m_timerMeshPartsDone) {
+        m_timerMeshPartsDone = new QTimer(this);
+        m_timerMeshPartsDone->setInterval(100);
+        QObject::connect(m_timerMeshPartsDone, &QTimer::timeout, this, &GuiDocument::recomputeMeshPartsDone);
+    }
+
+    m_timerMeshPartsDone->start();
+    return m_meshPriorities;
+}
+
+void GuiDocument::updateMeshPriorities()
+{
+    if (!m_meshPriorities)
+        return;
+
+    // Product shared by instances follows its most relevant instance
+    std::unordered_map<GraphicsObjectPtr, double> mapProductPriority;
+    const Handle_Graphic3d_Camera& camera = m_v3dView->Camera();
+    for (const GraphicsEntity& entity : m_vecGraphicsEntity) {
+        for (const GraphicsEntity::Object& object : entity.vecObject) {
+            const bool isVisible = GraphicsUtils::AisObject_isVisible(object.ptr);
+            const double priority = Internal::meshPriority(camera, object.bndBox, isVisible);
+            auto [it, isInserted] = mapProductPriority.insert({ Internal::graphicsProduct(object.ptr), priority });
+            if (!isInserted)
+                it->second = std::max(it->second, priority);
         }
-        else if (it->second != state) {
-            it->second = state;
-            mapNodeIdVisibleState[id] = state;
+    }
+
+    std::vector<double> vecPriority;
+    for (const GraphicsObjectPtr& product : m_vecMeshPriorityProduct) {
+        auto it = mapProductPriority.find(product);
+        vecPriority.push_back(it != mapProductPriority.cend() ? it->second : 0.);
+    }
+
+    m_meshPriorities->setPriorities(vecPriority);
+}
+
+std::unordered_set<GraphicsObjectPtr> GuiDocument::endMeshPriorities(
+        const std::shared_ptr<BRepMeshPriorities>& priorities)
+{
+    if (!priorities || priorities != m_meshPriorities)
+        return {};
+
+    this->recomputeMeshPartsDone();
+    m_timerMeshPartsDone->stop();
+    m_meshPriorities.reset();
+    m_vecMeshPriorityProduct.clear();
+    std::unordered_set<GraphicsObjectPtr> setRecomputed;
+    setRecomputed.swap(m_setMeshPriorityRecomputed);
+    return setRecomputed;
+}
+
+void GuiDocument::recomputeMeshPartsDone()
+{
+    if (!m_meshPriorities)
+        return;
+
+    std::unordered_set<GraphicsObjectPtr> setProductDone;
+    for (int partIndex : m_meshPriorities->takePartsDone())
+        setProductDone.insert(m_vecMeshPriorityProduct.at(partIndex));
+
+    if (setProductDone.empty())
+        return;
+
+    // Objects of entities destroyed in the meantime aren't found
+    for (const GraphicsEntity& entity : m_vecGraphicsEntity) {
+        for (const GraphicsEntity::Object& object : entity.vecObject) {
+            // Batches merge the triangulations of all their members, they're recomputed at the end
+            if (GraphicsBatchedObject::fromMember(object.ptr))
+                continue;
+
+            // Product comes first, presentations of instances are computed from the product one
+            GraphicsInstancedObject* gfxInstanced = GraphicsInstancedObject::fromInstance(object.ptr);
+            const GraphicsObjectPtr product = Internal::graphicsProduct(object.ptr);
+            if (setProductDone.find(product) == setProductDone.cend())
+                continue;
+
+            if (m_setMeshPriorityRecomputed.insert(product).second)
+                m_gfxScene.recomputeObjectPresentation(product);
+
+            const GraphicsObjectPtr displayedObject = gfxInstanced ? GraphicsObjectPtr(gfxInstanced) : object.ptr;
+            if (m_setMeshPriorityRecomputed.insert(displayedObject).second)
+                m_gfxScene.recomputeObjectPresentation(displayedObject);
         }
+    }
+
+    m_gfxScene.redraw();
+}
+
+bool GuiDocument::updatePointCloudLods(uint64_t pointBudget)
+{
+    std::vector<opencascade::handle<GraphicsPointCloudObject>> vecCloudObject;
+    for (const GraphicsEntity& entity : m_vecGraphicsEntity) {
+        for (const GraphicsEntity::Object& object : entity.vecObject) {
+            auto cloudObject = opencascade::handle<GraphicsPointCloudObject>::DownCast(object.ptr);
+            if (cloudObject && m_gfxScene.isObjectVisible(cloudObject))
+                vecCloudObject.push_back(cloudObject);
+        }
+    }
+
+    if (vecCloudObject.empty())
+        return false;
+
+    int viewWidth = 0;
+    int viewHeight = 0;
+    m_v3dView->Window()->Size(viewWidth, viewHeight);
+    GraphicsPointCloudObject::LodParameters params;
+    params.pointBudget = std::max<uint64_t>(pointBudget / vecCloudObject.size(), 1);
+    params.loadBudget = std::min(params.loadBudget, params.pointBudget);
+    bool changed = false;
+    bool pending = false;
+    for (const opencascade::handle<GraphicsPointCloudObject>& cloudObject : vecCloudObject) {
+        const GraphicsPointCloudObject::LodResult result =
+                cloudObject->updateLod(m_v3dView->Camera(), viewHeight, params);
+        if (result.changed) {
+            m_gfxScene.recomputeObjectPresentation(cloudObject);
+            changed = true;
+        }
+
+        pending = pending || result.pending;
+    }
+
+    if (changed)
+        m_gfxScene.redraw();
+
+    return pending;
+}
+
+std::vector<GuiDocument::ReleasableGraphics> GuiDocument::releasableGraphics() const
+{
+    std::unordered_set<TreeNodeId> setSelectedNodeId;
+    for (const ApplicationItem& appItem : m_guiApp->selectionModel()->selectedItems()) {
+        if (appItem.isDocumentTreeNode() && appItem.document() == m_document)
+            setSelectedNodeId.insert(appItem.documentTreeNode().id());
+    }
+
+    const Tree<TDF_Label>& docModelTree = m_document->modelTree();
+    auto fnIsNodeSelected = [&](TreeNodeId id) {
+        while (id != 0 && setSelectedNodeId.find(id) == setSelectedNodeId.cend())
+            id = docModelTree.nodeParent(id);
+
+        return id != 0;
     };
 
-    // Recursive show/hide of the input node graphics
+    // A product is pinned as soon as one of its objects can't be released
+    const bool isActive = m_guiApp->activeGuiDocument() == this;
+    std::unordered_map<GraphicsObjectPtr, ReleasableGraphics> mapProductItem;
+    std::unordered_set<GraphicsObjectPtr> setPinnedProduct;
+    for (const GraphicsEntity& gfxEntity : m_vecGraphicsEntity) {
+        if (!this->isNodeVisibleStateMapped(gfxEntity.treeNodeId))
+            continue; // Graphics of entity not published yet
+
+        for (const GraphicsEntity::Object& object : gfxEntity.vecObject) {
+            if (GraphicsInstancedObject::fromInstance(object.ptr) || GraphicsBatchedObject::fromMember(object.ptr))
+                continue;
+
+            const GraphicsObjectPtr product = Internal::graphicsProduct(object.ptr);
+            const bool isVisible = m_gfxScene.isObjectVisible(object.ptr);
+            if ((isActive && isVisible) || fnIsNodeSelected(this->nodeFromGraphicsObject(object.ptr))) {
+                setPinnedProduct.insert(product);
+                continue;
+            }
+
+            ReleasableGraphics& item = mapProductItem[product];
+            item.product = product;
+            const uint64_t viewTick =
+                    isVisible ? m_viewTick : CppUtils::findValue(object.ptr, m_mapGfxObjectHiddenTick);
+            item.viewTick = std::max(item.viewTick, viewTick);
+        }
+    }
+
+    std::vector<ReleasableGraphics> vecItem;
+    for (auto& pairProductItem : mapProductItem) {
+        if (setPinnedProduct.find(pairProductItem.first) != setPinnedProduct.cend())
+            continue;
+
+        MemoryAccounting accounting;
+        GraphicsUtils::AisObject_addMemoryStats(pairProductItem.first, &accounting);
+        ReleasableGraphics& item = pairProductItem.second;
+        item.memory = accounting.stats().presentation + accounting.stats().selection;
+        if (item.memory > 0) // Otherwise already released
+            vecItem.push_back(std::move(item));
+    }
+
+    return vecItem;
+}
+
+void GuiDocument::releaseGraphics(Span<const GraphicsObjectPtr> spanProduct)
+{
+    if (spanProduct.empty())
+        return;
+
+    const std::unordered_set<GraphicsObjectPtr> setProduct(spanProduct.begin(), spanProduct.end());
+    GraphicsSceneRedrawBlocker redrawBlocker(&m_gfxScene);
+    for (const GraphicsEntity& gfxEntity : m_vecGraphicsEntity) {
+        for (const GraphicsEntity::Object& object : gfxEntity.vecObject) {
+            if (GraphicsInstancedObject::fromInstance(object.ptr) || GraphicsBatchedObject::fromMember(object.ptr))
+                continue;
+
+            if (setProduct.find(Internal::graphicsProduct(object.ptr)) == setProduct.cend())
+                continue;
+
+            if (m_gfxScene.isObjectVisible(object.ptr)) {
+                // Document isn't the active one, see restoreReleasedVisibleGraphics()
+                m_gfxScene.setObjectVisible(object.ptr, false);
+                m_setGfxObjectReleasedVisible.insert(object.ptr);
+            }
+
+            m_gfxScene.releaseObjectGraphicsData(object.ptr);
+            m_setGfxObjectReleased.insert(object.ptr);
+        }
+    }
+
+    // Products of instances aren't in the scene
+    std::vector<TDF_Label> vecLabelProduct;
+    for (const GraphicsObjectPtr& product : spanProduct) {
+        if (m_setGfxObjectReleased.insert(product).second)
+            m_gfxScene.releaseObjectGraphicsData(product);
+
+        for (const GraphicsEntity& gfxEntity : m_vecGraphicsEntity) {
+            const TDF_Label labelProduct = CppUtils::findValue(product, gfxEntity.mapGfxProductLabel);
+            if (!labelProduct.IsNull()) {
+                vecLabelProduct.push_back(labelProduct);
+                break;
+            }
+        }
+    }
+
+    emit this->productGraphicsReleased(vecLabelProduct);
+}
+
+void GuiDocument::compactHiddenMeshes(std::chrono::seconds hiddenDelay)
+{
+    if (m_compactTaskId)
+        return; // Previous compaction still running
+
+    std::unordered_set<TreeNodeId> setSelectedNodeId;
+    for (const ApplicationItem& appItem : m_guiApp->selectionModel()->selectedItems()) {
+        if (appItem.isDocumentTreeNode() && appItem.document() == m_document)
+            setSelectedNodeId.insert(appItem.documentTreeNode().id());
+    }
+
     const Tree<TDF_Label>& docModelTree = m_document->modelTree();
-    traverseTree(nodeId, docModelTree , [=](TreeNodeId id) {
-        fnSetNodeVisibleState(id, nodeVisibleState);
-    });
-    this->foreachGraphicsObject(nodeId, [=](GraphicsObjectPtr gfxObject){
-        GraphicsUtils::AisObject_setVisible(gfxObject, on);
-    });
+    auto fnIsNodeSelected = [&](TreeNodeId id) {
+        while (id != 0 && setSelectedNodeId.find(id) == setSelectedNodeId.cend())
+            id = docModelTree.nodeParent(id);
 
-    // Keep selection state of the input node: in case the node graphics are "shown" back again then
-    // AIS object selection status is lost
-    const ApplicationItem appItem({ m_document, nodeId });
-    bool isAppItemSelected = m_guiApp->selectionModel()->isSelected(appItem);
-    if (!isAppItemSelected) { // Check if a parent is selected
-        TreeNodeId parentId = docModelTree.nodeParent(nodeId);
-        while (parentId != 0 && !isAppItemSelected) {
-            const ApplicationItem parentAppItem({ m_document, parentId });
-            isAppItemSelected = m_guiApp->selectionModel()->isSelected(parentAppItem);
-            parentId = docModelTree.nodeParent(parentId);
+        return id != 0;
+    };
+
+    // A product is pinned as soon as one of its objects is visible, selected or hidden recently
+    const auto timeHiddenMax = std::chrono::steady_clock::now() - hiddenDelay;
+    std::unordered_set<GraphicsObjectPtr> setCandidateProduct;
+    std::unordered_set<GraphicsObjectPtr> setPinnedProduct;
+    for (const GraphicsEntity& gfxEntity : m_vecGraphicsEntity) {
+        if (!this->isNodeVisibleStateMapped(gfxEntity.treeNodeId))
+            continue; // Graphics of entity not published yet
+
+        for (const GraphicsEntity::Object& object : gfxEntity.vecObject) {
+            if (GraphicsInstancedObject::fromInstance(object.ptr) || GraphicsBatchedObject::fromMember(object.ptr))
+                continue;
+
+            const GraphicsObjectPtr product = Internal::graphicsProduct(object.ptr);
+            auto itHiddenTime = m_mapGfxObjectHiddenTime.find(object.ptr);
+            if (m_gfxScene.isObjectVisible(object.ptr)
+                    || itHiddenTime == m_mapGfxObjectHiddenTime.cend()
+                    || itHiddenTime->second > timeHiddenMax
+                    || fnIsNodeSelected(this->nodeFromGraphicsObject(object.ptr)))
+            {
+                setPinnedProduct.insert(product);
+                continue;
+            }
+
+            setCandidateProduct.insert(product);
         }
     }
 
-    if (on && isAppItemSelected)
-        this->toggleItemSelected(appItem);
+    std::vector<TopoDS_Shape> vecShape;
+    for (const GraphicsObjectPtr& product : setCandidateProduct) {
+        if (setPinnedProduct.find(product) != setPinnedProduct.cend())
+            continue;
+
+        const TopoDS_Shape shape = Internal::productShape(product);
+        if (!shape.IsNull() && m_setShapeCompacted.find(shape.TShape()) == m_setShapeCompacted.cend())
+            m_vecShapeCompacting.push_back(shape);
+    }
+
+    if (m_vecShapeCompacting.empty())
+        return;
 
-    // Keep selection state of input node children
-    traverseTree(nodeId, docModelTree, [=](TreeNodeId id) {
-        if (id != nodeId) {
-            const ApplicationItem childAppItem({ m_document, id });
-            if (on && m_guiApp->selectionModel()->isSelected(childAppItem))
-                this->toggleItemSelected(childAppItem);
+    const DocumentPtr doc = m_document;
+    const std::vector<TopoDS_Shape> vecShape = m_vecShapeCompacting;
+    auto compactedCount = std::make_shared<std::atomic<int>>(0);
+    m_shapeCompactedCount = compactedCount;
+    auto taskMgr = TaskManager::globalInstance();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        for (const TopoDS_Shape& shape : vecShape) {
+            // Locked per shape, so the main thread doesn't wait long when showing objects again
+            std::lock_guard<std::mutex> lockData(doc->dataMutex()); MAYO_UNUSED(lockData);
+            if (TaskProgress::isAbortRequested(progress) || doc->isDataInUse())
+                return; // Remaining shapes are candidates of the next compaction
+
+            doc->compactTriangulations().compact(shape);
+            const int count = ++(*compactedCount);
+            progress->setValue(int((count * 100) / vecShape.size()));
         }
     });
+    m_compactTaskId = taskId;
+    taskMgr->onEnded(taskId, this, [=]{
+        if (m_compactTaskId == taskId)
+            this->endCompactHiddenMeshes();
+    });
+    taskMgr->setTitle(taskId, tr("Compact hidden meshes"));
+    taskMgr->run(taskId);
+}
 
-    // Parent nodes check state
-    TreeNodeId parentId = docModelTree.nodeParent(nodeId);
-    while (parentId != 0) {
-        int childCount = 0;
-        int checkedCount = 0;
-        int uncheckedCount = 0;
-        visitDirectChildren(parentId, docModelTree, [&](TreeNodeId id) {
-            ++childCount;
-            const Qt::CheckState childState = this->nodeVisibleState(id);
-            if (childState == Qt::Checked)
-                ++checkedCount;
-            else if (childState == Qt::Unchecked)
-                ++uncheckedCount;
-        });
-        Qt::CheckState parentVisibleState = Qt::PartiallyChecked;
-        if (checkedCount == childCount)
-            parentVisibleState = Qt::Checked;
-        else if (uncheckedCount == childCount)
-            parentVisibleState = Qt::Unchecked;
+void GuiDocument::expandCompactedMeshes(Span<const GraphicsObjectPtr> spanObject)
+{
+    if (m_setShapeCompacted.empty() && !m_compactTaskId)
+        return;
 
-        fnSetNodeVisibleState(parentId, parentVisibleState);
-        parentId = docModelTree.nodeParent(parentId);
+    // Shapes may be compacted by the running task, it's stopped first
+    this->stopCompactHiddenMeshes();
+    std::vector<TopoDS_Shape> vecShape;
+    for (const GraphicsObjectPtr& object : spanObject) {
+        const TopoDS_Shape shape = Internal::productShape(Internal::graphicsProduct(object));
+        if (!shape.IsNull() && m_setShapeCompacted.erase(shape.TShape()) != 0)
+            vecShape.push_back(shape);
     }
 
-    // Notify all node visibility changes
-    if (!mapNodeIdVisibleState.empty())
-        emit nodesVisibilityChanged(mapNodeIdVisibleState);
+    if (vecShape.empty())
+        return;
+
+    std::lock_guard<std::mutex> lockData(m_document->dataMutex()); MAYO_UNUSED(lockData);
+    m_document->compactTriangulations().expand(vecShape);
 }
 
-void GuiDocument::setExplodingFactor(double t)
+void GuiDocument::stopCompactHiddenMeshes()
 {
-    m_explodingFactor = t;
-    for (const GraphicsEntity& entity : m_vecGraphicsEntity) {
-        const gp_Pnt entityCenter = BndBoxCoords::get(entity.bndBox).center();
-        for (const GraphicsEntity::Object& object : entity.vecObject) {
-            const gp_Vec vecDirection(entityCenter, BndBoxCoords::get(object.bndBox).center());
-            gp_Trsf trsfMove;
-            trsfMove.SetTranslation(2 * t * vecDirection);
-            m_gfxScene.setObjectTransformation(object.ptr, trsfMove * object.trsfOriginal);
-        }
-    }
+    if (!m_compactTaskId)
+        return;
 
-    m_gfxScene.redraw();
+    auto taskMgr = TaskManager::globalInstance();
+    taskMgr->requestAbort(*m_compactTaskId);
+    taskMgr->waitForDone(*m_compactTaskId);
+    this->endCompactHiddenMeshes();
+}
+
+void GuiDocument::endCompactHiddenMeshes()
+{
+    const int compactedCount = m_shapeCompactedCount ? m_shapeCompactedCount->load() : 0;
+    for (int i = 0; i < compactedCount; ++i)
+        m_setShapeCompacted.insert(m_vecShapeCompacting.at(i).TShape());
+
+    m_vecShapeCompacting.clear();
+    m_shapeCompactedCount.reset();
+    m_compactTaskId.reset();
 }
 
 bool GuiDocument::isOriginTrihedronVisible() const
@@ -460,15 +1484,71 @@ int GuiDocument::aisViewCubeBoundingSize() const
 
 void GuiDocument::onDocumentEntityAdded(TreeNodeId entityTreeNodeId)
 {
-    this->mapEntity(entityTreeNodeId);
-    BndUtils::add(&m_gfxBoundingBox, m_vecGraphicsEntity.back().bndBox);
-    emit graphicsBoundingBoxChanged(m_gfxBoundingBox);
+    this->mapEntityAsync(entityTreeNodeId);
+}
+
+void GuiDocument::detach()
+{
+    // Document data gets released by a background thread once closed, see Application::closeDocument()
+    TaskManager* taskMgr = TaskManager::globalInstance();
+    for (const auto& [entityTreeNodeId, taskId] : m_mapEntityPendingTask)
+        taskMgr->requestAbort(taskId);
+
+    if (m_hlrTaskId)
+        taskMgr->requestAbort(*m_hlrTaskId);
+
+    for (const auto& [entityTreeNodeId, taskId] : m_mapEntityPendingTask)
+        taskMgr->waitForDone(taskId);
+
+    if (m_hlrTaskId)
+        taskMgr->waitForDone(*m_hlrTaskId);
+
+    this->stopCompactHiddenMeshes();
+    m_mapEntityPendingTask.clear();
+    m_setEntityGraphicsPending.clear();
+    m_hlrTaskId.reset();
+    m_mapEntityMeshProblems.clear();
+    m_gfxScene.clear();
 }
 
 void GuiDocument::onDocumentEntityAboutToBeDestroyed(TreeNodeId entityTreeNodeId)
 {
-    this->unmapEntity(entityTreeNodeId);
-    // Recompute bounding box
+    this->onDocumentEntitiesAboutToBeDestroyed(Span<const TreeNodeId>(&entityTreeNodeId, 1));
+}
+
+void GuiDocument::onDocumentEntitiesAboutToBeDestroyed(Span<const TreeNodeId> spanEntityTreeNodeId)
+{
+    // Background tasks read the model tree of the entities, wait before it gets destroyed
+    // All tasks are requested to abort first, so they stop concurrently
+    TaskManager* taskMgr = TaskManager::globalInstance();
+    std::vector<TaskId> vecPendingTaskId;
+    for (TreeNodeId entityTreeNodeId : spanEntityTreeNodeId) {
+        auto itPending = m_mapEntityPendingTask.find(entityTreeNodeId);
+        if (itPending != m_mapEntityPendingTask.end()) {
+            taskMgr->requestAbort(itPending->second);
+            vecPendingTaskId.push_back(itPending->second);
+            m_mapEntityPendingTask.erase(itPending);
+        }
+
+        m_setEntityGraphicsPending.erase(entityTreeNodeId);
+    }
+
+    for (TaskId taskId : vecPendingTaskId)
+        taskMgr->waitForDone(taskId);
+
+    // Triangulations may be shared with other entities, so compacted ones are restored
+    std::vector<GraphicsObjectPtr> vecObject;
+    for (TreeNodeId entityTreeNodeId : spanEntityTreeNodeId) {
+        const GraphicsEntity* gfxEntity = this->findGraphicsEntity(entityTreeNodeId);
+        if (gfxEntity) {
+            for (const GraphicsEntity::Object& object : gfxEntity->vecObject)
+                vecObject.push_back(object.ptr);
+        }
+    }
+
+    this->expandCompactedMeshes(vecObject);
+    this->unmapEntities(spanEntityTreeNodeId);
+    // Recompute bounding box, once for all the entities
     m_gfxBoundingBox.SetVoid();
     for (const GraphicsEntity& gfxEntity : m_vecGraphicsEntity)
         BndUtils::add(&m_gfxBoundingBox, gfxEntity.bndBox);
@@ -488,11 +1568,17 @@ void GuiDocument::onGraphicsSelectionChanged()
     }
 
     std::vector<ApplicationItem> vecSelected;
+    std::unordered_set<TreeNodeId> setSelectedNodeId;
     m_gfxScene.foreachSelectedOwner([&](const GraphicsOwnerPtr& gfxOwner) {
-        auto gfxObject = GraphicsObjectPtr::DownCast(
-                    gfxOwner ? gfxOwner->Selectable() : Handle_SelectMgr_SelectableObject());
+        // Owners of batch members are the batch ones, members are resolved from the owner
+        GraphicsObjectPtr gfxObject = GraphicsBatchedObject::memberFromOwner(gfxOwner);
+        if (!gfxObject) {
+            gfxObject = GraphicsObjectPtr::DownCast(
+                        gfxOwner ? gfxOwner->Selectable() : Handle_SelectMgr_SelectableObject());
+        }
+
         const TreeNodeId nodeId = this->nodeFromGraphicsObject(gfxObject);
-        if (nodeId != 0) {
+        if (nodeId != 0 && setSelectedNodeId.insert(nodeId).second) {
             const ApplicationItem appItem({ m_document, nodeId });
             vecSelected.push_back(std::move(appItem));
         }
@@ -503,8 +1589,10 @@ void GuiDocument::onGraphicsSelectionChanged()
         if (appItem.document() != m_document)
             continue;
 
-        auto it = std::find(vecSelected.cbegin(), vecSelected.cend(), appItem);
-        if (it == vecSelected.cend())
+        const bool isSelected =
+                appItem.isDocumentTreeNode()
+                && setSelectedNodeId.find(appItem.documentTreeNode().id()) != setSelectedNodeId.cend();
+        if (!isSelected)
             vecRemoved.push_back(appItem);
     }
 
@@ -517,30 +1605,210 @@ void GuiDocument::onGraphicsSelectionChanged()
 
 void GuiDocument::mapEntity(TreeNodeId entityTreeNodeId)
 {
-    const Tree<TDF_Label>& docModelTree = m_document->modelTree();
+    PerfStats* perfStats = PerfStats::isEnabled() ? PerfStats::global() : nullptr;
+    GraphicsEntity gfxEntity;
+    {
+        PerfScopedTimer timer(perfStats, "gui.createGraphics");
+        gfxEntity = GuiDocument::createGraphicsEntity(
+                    m_document,
+                    m_guiApp->graphicsObjectDriverTable(),
+                    entityTreeNodeId,
+                    m_guiApp->isStaticBatchingEnabled());
+    }
+
+    {
+        PerfScopedTimer timer(perfStats, "gui.prepareGraphics");
+        GuiDocument::prepareGraphicsEntity(&gfxEntity);
+    }
+
+    {
+        PerfScopedTimer timer(perfStats, "gui.prepareSelection");
+        GuiDocument::prepareGraphicsEntitySelection(&gfxEntity);
+    }
+
+    {
+        PerfScopedTimer timer(perfStats, "gui.buildPartBvh");
+        m_partBvh.addEntity(m_document, entityTreeNodeId);
+    }
+
+    PerfScopedTimer timer(perfStats, "gui.publishGraphics");
+    this->addGraphicsEntity(std::move(gfxEntity));
+    this->publishGraphicsObjects(entityTreeNodeId, 0);
+    if (perfStats)
+        perfStats->addCounter("gui.mappedEntities");
+}
+
+void GuiDocument::mapEntityAsync(TreeNodeId entityTreeNodeId)
+{
+    struct MapResult {
+        GraphicsEntity gfxEntity;
+        PartBvh::EntityTree partTree;
+        QMetaObject::Connection connTaskEnded;
+    };
+    auto result = std::make_shared<MapResult>();
+    const DocumentPtr doc = m_document;
+    const GraphicsObjectDriverTable* gfxDriverTable = m_guiApp->graphicsObjectDriverTable();
+    const bool staticBatching = m_guiApp->isStaticBatchingEnabled();
+    auto taskMgr = TaskManager::globalInstance();
+    const TaskId taskId = taskMgr->newTask([=](TaskProgress* progress) {
+        PerfStats* perfStats = PerfStats::of(progress);
+        {
+            PerfScopedTimer timer(perfStats, "gui.createGraphics");
+            result->gfxEntity = GuiDocument::createGraphicsEntity(
+                        doc, gfxDriverTable, entityTreeNodeId, staticBatching);
+        }
+
+        {
+            TaskProgress graphicsProgress(progress, 70, tr("Prepare graphics"));
+            PerfScopedTimer timer(perfStats, "gui.prepareGraphics");
+            GuiDocument::prepareGraphicsEntity(&result->gfxEntity, &graphicsProgress);
+        }
+
+        if (!progress->isAbortRequested()) {
+            TaskProgress selectionProgress(progress, 30, tr("Prepare selection"));
+            PerfScopedTimer timer(perfStats, "gui.prepareSelection");
+            GuiDocument::prepareGraphicsEntitySelection(&result->gfxEntity, &selectionProgress);
+        }
+
+        if (!progress->isAbortRequested()) {
+            // Product bounding boxes were cached while preparing graphics
+            PerfScopedTimer timer(perfStats, "gui.buildPartBvh");
+            result->partTree = PartBvh::buildEntityTree(doc, entityTreeNodeId);
+        }
+    });
+    m_mapEntityPendingTask.insert({ entityTreeNodeId, taskId });
+    m_setEntityGraphicsPending.insert(entityTreeNodeId);
+    // Graphics objects must be added to the scene in the GUI thread, once the task is over
+    result->connTaskEnded = QObject::connect(
+                taskMgr, &TaskManager::ended,
+                this, [=](TaskId endedTaskId) {
+        if (endedTaskId != taskId)
+            return;
+
+        QObject::disconnect(result->connTaskEnded);
+        auto itPending = m_mapEntityPendingTask.find(entityTreeNodeId);
+        if (itPending == m_mapEntityPendingTask.end() || itPending->second != taskId)
+            return; // Entity was destroyed meanwhile
+
+        m_mapEntityPendingTask.erase(itPending);
+        PerfStats* perfStats = PerfStats::isEnabled() ? PerfStats::global() : nullptr;
+        PerfScopedTimer timer(perfStats, "gui.publishGraphics");
+        m_partBvh.addEntity(std::move(result->partTree));
+        this->addGraphicsEntity(std::move(result->gfxEntity));
+        this->publishGraphicsObjects(entityTreeNodeId, 0);
+        if (perfStats)
+            perfStats->addCounter("gui.mappedEntities");
+    });
+    taskMgr->setTitle(taskId, tr("Create graphics"));
+    taskMgr->run(taskId);
+}
+
+GuiDocument::GraphicsEntity GuiDocument::createGraphicsEntity(
+        const DocumentPtr& doc,
+        const GraphicsObjectDriverTable* gfxDriverTable,
+        TreeNodeId entityTreeNodeId,
+        bool staticBatching)
+{
+    const Tree<TDF_Label>& docModelTree = doc->modelTree();
     GraphicsEntity gfxEntity;
     gfxEntity.treeNodeId = entityTreeNodeId;
-    std::unordered_map<TDF_Label, GraphicsObjectPtr> mapLabelGfxProduct;
+    FlatHashMap<TDF_Label, GraphicsObjectPtr> mapLabelGfxProduct;
+    std::unordered_set<TDF_Label> setLabelUnsupported; // Products having no graphics driver
+    std::unordered_map<TDF_Label, opencascade::handle<GraphicsInstancedObject>> mapLabelGfxInstanced;
+    std::unordered_map<uint32_t, opencascade::handle<GraphicsBatchedObject>> mapStyleGfxBatched;
+
+    // Count instances of each product, the most repeated ones are grouped into a single object
+    std::unordered_map<TDF_Label, int> mapLabelInstanceCount;
+    traverseTree(entityTreeNodeId, docModelTree, [&](TreeNodeId id) {
+        if (docModelTree.nodeIsLeaf(id) && !docModelTree.nodeIsRoot(id))
+            ++mapLabelInstanceCount[docModelTree.nodeData(id)];
+    });
+
+    // Parts instantiated once are merged by style, no graphics object is created for their product
+    // Checks are read-only(triangulations of the faces are explored), so leaves are checked
+    // concurrently
+    std::vector<uint8_t> vecNodeBatchable;
+    if (staticBatching) {
+        vecNodeBatchable.resize(docModelTree.nodeCount() + 1, 0);
+        traverseTree_parallel(entityTreeNodeId, docModelTree, [&](TreeNodeId id) {
+            if (!docModelTree.nodeIsLeaf(id) || docModelTree.nodeIsRoot(id))
+                return;
+
+            const TDF_Label& nodeLabel = docModelTree.nodeData(id);
+            const bool isBatchable =
+                    CppUtils::findValue(nodeLabel, mapLabelInstanceCount) == 1
+                    && XCaf::isShape(nodeLabel)
+                    && XCaf::shapeSubs(nodeLabel).IsEmpty() // Sub-shapes may have their own style
+                    && Internal::isShapeBatchable(XCaf::shape(nodeLabel));
+            vecNodeBatchable[id] = isBatchable ? 1 : 0;
+        });
+    }
+
+    auto fnIsBatchable = [&](TreeNodeId id) {
+        return staticBatching && vecNodeBatchable.at(id) != 0;
+    };
 
     traverseTree(entityTreeNodeId, docModelTree, [&](TreeNodeId id) {
         const TDF_Label nodeLabel = docModelTree.nodeData(id);
-        if (docModelTree.nodeIsLeaf(id)) {
+        if (docModelTree.nodeIsLeaf(id) && fnIsBatchable(id)) {
+            const uint32_t styleIndex = doc->xcaf().shapeStyleIndex(id);
+            opencascade::handle<GraphicsBatchedObject>& gfxBatched = mapStyleGfxBatched[styleIndex];
+            if (!gfxBatched || gfxBatched->triangleCount() >= Internal::BatchedObjectMaxTriangleCount) {
+                // Parts without style get the default surface color of XCAFPrs_AISObject
+                const XCaf::ShapeStyle& style = doc->xcaf().shapeStyleAt(styleIndex);
+                gfxBatched = new GraphicsBatchedObject(style.hasColor ? style.color : Quantity_NOC_WHITE);
+                gfxEntity.vecBatchedObject.push_back(gfxBatched);
+            }
+
+            const TopLoc_Location instanceLoc = doc->xcaf().shapeAbsoluteLocation(id);
+            const GraphicsObjectPtr gfxMember = gfxBatched->addMember(XCaf::shape(nodeLabel), instanceLoc);
+            gfxEntity.vecObject.push_back(gfxMember);
+            gfxEntity.vecObject.back().trsfOriginal = instanceLoc.Transformation();
+            gfxEntity.mapGfxProductLabel.insert({ gfxMember, nodeLabel });
+            if (XCaf::isShapeReference(docModelTree.nodeData(docModelTree.nodeParent(id))))
+                id = docModelTree.nodeParent(id);
+
+            gfxEntity.mapTreeNodeGfxObject.insert({ id, gfxMember });
+        }
+        else if (docModelTree.nodeIsLeaf(id)) {
             GraphicsObjectPtr gfxProduct = CppUtils::findValue(nodeLabel, mapLabelGfxProduct);
             if (!gfxProduct) {
-                gfxProduct = m_guiApp->graphicsObjectDriverTable()->createObject(nodeLabel);
-                if (!gfxProduct)
+                if (setLabelUnsupported.find(nodeLabel) != setLabelUnsupported.cend())
+                    return;
+
+                gfxProduct = gfxDriverTable->createObject(nodeLabel);
+                if (!gfxProduct) {
+                    setLabelUnsupported.insert(nodeLabel);
                     return;
+                }
 
                 mapLabelGfxProduct.insert({ nodeLabel, gfxProduct });
+                gfxEntity.mapGfxProductLabel.insert({ gfxProduct, nodeLabel });
             }
 
+            gp_Trsf trsfObject;
             if (!docModelTree.nodeIsRoot(id)) {
-                Handle_AIS_ConnectedInteractive gfxInstance = new AIS_ConnectedInteractive;
-                gfxInstance->Connect(gfxProduct, XCaf::shapeAbsoluteLocation(docModelTree, id));
-                gfxInstance->SetDisplayMode(gfxProduct->DisplayMode());
-                gfxInstance->Attributes()->SetFaceBoundaryDraw(gfxProduct->Attributes()->FaceBoundaryDraw());
-                gfxInstance->SetOwner(gfxProduct->GetOwner());
-                gfxEntity.vecObject.push_back(GraphicsObjectPtr(gfxInstance));
+                const TopLoc_Location instanceLoc = doc->xcaf().shapeAbsoluteLocation(id);
+                if (mapLabelInstanceCount[nodeLabel] >= Internal::InstancedObjectMinCount) {
+                    auto gfxInstanced = CppUtils::findValue(nodeLabel, mapLabelGfxInstanced);
+                    if (!gfxInstanced) {
+                        gfxInstanced = new GraphicsInstancedObject(gfxProduct);
+                        mapLabelGfxInstanced.insert({ nodeLabel, gfxInstanced });
+                        gfxEntity.vecInstancedObject.push_back(gfxInstanced);
+                    }
+
+                    gfxEntity.vecObject.push_back(gfxInstanced->addInstance(instanceLoc));
+                }
+                else {
+                    Handle_AIS_ConnectedInteractive gfxInstance = new AIS_ConnectedInteractive;
+                    gfxInstance->Connect(gfxProduct, instanceLoc);
+                    gfxInstance->SetDisplayMode(gfxProduct->DisplayMode());
+                    gfxInstance->Attributes()->SetFaceBoundaryDraw(gfxProduct->Attributes()->FaceBoundaryDraw());
+                    gfxInstance->SetOwner(gfxProduct->GetOwner());
+                    gfxEntity.vecObject.push_back(GraphicsObjectPtr(gfxInstance));
+                }
+
+                trsfObject = instanceLoc.Transformation();
                 if (XCaf::isShapeReference(docModelTree.nodeData(docModelTree.nodeParent(id))))
                     id = docModelTree.nodeParent(id);
             }
@@ -548,55 +1816,539 @@ void GuiDocument::mapEntity(TreeNodeId entityTreeNodeId)
                 gfxEntity.vecObject.push_back(gfxProduct);
             }
 
-            const GraphicsEntity::Object& lastGfxObject = gfxEntity.vecObject.back();
+            GraphicsEntity::Object& lastGfxObject = gfxEntity.vecObject.back();
+            lastGfxObject.trsfOriginal = trsfObject;
             gfxEntity.mapTreeNodeGfxObject.insert({ id, lastGfxObject.ptr });
-            gfxEntity.mapGfxObjectTreeNode.insert({ lastGfxObject.ptr, id });
         }
     });
 
-    for (const GraphicsEntity::Object& object : gfxEntity.vecObject) {
-        m_gfxScene.addObject(object.ptr);
-        auto driver = GraphicsObjectDriver::get(object.ptr);
+    return gfxEntity;
+}
+
+void GuiDocument::prepareGraphicsEntity(GraphicsEntity* gfxEntity, TaskProgress* progress)
+{
+    auto fnProduct = &Internal::graphicsProduct;
+
+    std::vector<GraphicsObjectPtr> vecProduct;
+    std::unordered_map<GraphicsObjectPtr, int> mapProductIndex;
+    for (const GraphicsEntity::Object& object : gfxEntity->vecObject) {
+        const GraphicsObjectPtr product = fnProduct(object.ptr);
+        if (mapProductIndex.insert({ product, int(vecProduct.size()) }).second)
+            vecProduct.push_back(product);
+    }
+
+    // Products are independent, prepare them concurrently
+    std::vector<Bnd_Box> vecProductBndBox(vecProduct.size());
+    std::atomic<int> productDoneCount = 0;
+    std::mutex mutexProgress;
+    const int productCount = int(vecProduct.size());
+    CppUtils::parallelFor(productCount, [&](int i) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        const GraphicsObjectPtr& product = vecProduct.at(i);
+        auto driver = GraphicsObjectDriver::get(product);
         if (driver)
-            driver->applyDisplayMode(object.ptr, this->activeDisplayMode(driver));
+            driver->prepareObject(product);
+
+        const TDF_Label productLabel = CppUtils::findValue(product, gfxEntity->mapGfxProductLabel);
+        vecProductBndBox.at(i) = Internal::productBoundingBox(product, productLabel);
+        const int doneCount = ++productDoneCount;
+        if (progress) {
+            std::lock_guard<std::mutex> lock(mutexProgress);
+            const int pct = (doneCount * 100) / productCount;
+            if (pct > progress->value())
+                progress->setValue(pct);
+        }
+    });
+
+    // Each batch fills its merged buffers concurrently
+    for (const GraphicsObjectPtr& object : gfxEntity->vecBatchedObject) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        auto gfxBatched = opencascade::handle<GraphicsBatchedObject>::DownCast(object);
+        if (gfxBatched)
+            gfxBatched->prepare();
     }
 
-    for (GraphicsEntity::Object& object : gfxEntity.vecObject) {
-        object.bndBox = GraphicsUtils::AisObject_boundingBox(object.ptr);
-        object.trsfOriginal = m_gfxScene.objectTransformation(object.ptr);
-        BndUtils::add(&gfxEntity.bndBox, object.bndBox);
+    // Bounding boxes not computed here are taken from the presentations, once published
+    for (GraphicsEntity::Object& object : gfxEntity->vecObject) {
+        const Bnd_Box& productBndBox = vecProductBndBox.at(mapProductIndex.at(fnProduct(object.ptr)));
+        if (!productBndBox.IsVoid()) {
+            object.bndBox = productBndBox.Transformed(object.trsfOriginal);
+            BndUtils::add(&gfxEntity->bndBox, object.bndBox);
+        }
     }
+}
 
-    m_gfxScene.redraw();
+void GuiDocument::prepareGraphicsEntitySelection(GraphicsEntity* gfxEntity, TaskProgress* progress)
+{
+    // Products first, then the connected instances whose selections are copied from the products
+    std::vector<GraphicsObjectPtr> vecProduct;
+    std::vector<GraphicsObjectPtr> vecInstance;
+    std::unordered_set<GraphicsObjectPtr> setProduct;
+    for (const GraphicsEntity::Object& object : gfxEntity->vecObject) {
+        if (GraphicsInstancedObject::fromInstance(object.ptr))
+            continue; // Selection of grouped instances is managed by their group
+
+        if (GraphicsBatchedObject::fromMember(object.ptr))
+            continue; // Members are picked through the selection of their batch
+
+        auto gfxInstance = Handle_AIS_ConnectedInteractive::DownCast(object.ptr);
+        const GraphicsObjectPtr product = gfxInstance ? gfxInstance->ConnectedTo() : object.ptr;
+        if (setProduct.insert(product).second)
+            vecProduct.push_back(product);
+
+        if (gfxInstance)
+            vecInstance.push_back(gfxInstance);
+    }
 
-    traverseTree(entityTreeNodeId, docModelTree, [=](TreeNodeId id) {
-        m_mapTreeNodeCheckState.insert({ id, Qt::Checked });
-    });
+    vecProduct.insert(vecProduct.end(), gfxEntity->vecBatchedObject.cbegin(), gfxEntity->vecBatchedObject.cend());
+    std::atomic<int> objectDoneCount = 0;
+    std::mutex mutexProgress;
+    const int objectCount = int(vecProduct.size() + vecInstance.size());
+    auto fnPrepareSelection = [&](const GraphicsObjectPtr& object) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        const int mode = object->GlobalSelectionMode();
+        if (!object->HasSelection(mode))
+            object->RecomputePrimitives(mode);
+
+        const Handle_SelectMgr_Selection& selection = object->Selection(mode);
+        if (selection) {
+            for (const Handle_SelectMgr_SensitiveEntity& entity : selection->Entities()) {
+                if (entity && entity->BaseSensitive())
+                    entity->BaseSensitive()->BVH();
+            }
+        }
+
+        const int doneCount = ++objectDoneCount;
+        if (progress) {
+            std::lock_guard<std::mutex> lock(mutexProgress);
+            const int pct = (doneCount * 100) / objectCount;
+            if (pct > progress->value())
+                progress->setValue(pct);
+        }
+    };
+
+    CppUtils::parallelFor(int(vecProduct.size()), [&](int i) { fnPrepareSelection(vecProduct.at(i)); });
+    CppUtils::parallelFor(int(vecInstance.size()), [&](int i) { fnPrepareSelection(vecInstance.at(i)); });
+}
+
+void GuiDocument::publishGraphicsObjects(TreeNodeId entityTreeNodeId, int indexFirst)
+{
+    auto itEntity = std::find_if(
+                m_vecGraphicsEntity.begin(),
+                m_vecGraphicsEntity.end(),
+                [=](const GraphicsEntity& item) { return item.treeNodeId == entityTreeNodeId; });
+    if (itEntity == m_vecGraphicsEntity.end())
+        return; // Entity was unmapped meanwhile
+
+    GraphicsEntity& gfxEntity = *itEntity;
+    // Display mode is applied first, so only the presentation of the active mode gets computed
+    auto fnSetupSceneObject = [=](const GraphicsObjectPtr& object, bool display) {
+        auto driver = GraphicsObjectDriver::get(object);
+        if (driver)
+            driver->applyDisplayMode(object, this->activeDisplayMode(driver));
+
+        if (display) {
+            m_gfxScene.addObject(object);
+            m_gfxScene.setObjectClipPlaneSensitive(object, true);
+            if (driver)
+                driver->applyDisplayMode(object, this->activeDisplayMode(driver));
+        }
+    };
+
+    const int objectCount = int(gfxEntity.vecObject.size());
+    const int indexEnd = std::min(indexFirst + Internal::PublishBatchSize, objectCount);
+    {
+        GraphicsSceneRedrawBlocker redrawBlocker(&m_gfxScene);
+        // Grouped instances and batch members are displayed along with their group or batch
+        for (int i = indexFirst; i < indexEnd; ++i) {
+            const GraphicsObjectPtr& object = gfxEntity.vecObject.at(i).ptr;
+            if (!GraphicsBatchedObject::fromMember(object))
+                fnSetupSceneObject(object, !GraphicsInstancedObject::fromInstance(object));
+        }
+
+        if (indexEnd == objectCount) {
+            for (const GraphicsObjectPtr& object : gfxEntity.vecInstancedObject)
+                fnSetupSceneObject(object, true);
+
+            for (const GraphicsObjectPtr& object : gfxEntity.vecBatchedObject)
+                fnSetupSceneObject(object, true);
+        }
+    }
+
+    if (indexEnd < objectCount) {
+        // Let the event loop run between batches
+        QTimer::singleShot(0, this, [=]{ this->publishGraphicsObjects(entityTreeNodeId, indexEnd); });
+        return;
+    }
+
+    for (GraphicsEntity::Object& object : gfxEntity.vecObject) {
+        if (object.bndBox.IsVoid()) {
+            object.bndBox = GraphicsUtils::AisObject_boundingBox(object.ptr);
+            BndUtils::add(&gfxEntity.bndBox, object.bndBox);
+        }
+    }
 
+    this->mapNodeVisibleStates(entityTreeNodeId);
+    BndUtils::add(&m_gfxBoundingBox, gfxEntity.bndBox);
+    m_gfxScene.redraw();
     GraphicsUtils::V3dView_fitAll(m_v3dView);
-    m_vecGraphicsEntity.push_back(std::move(gfxEntity));
+    m_setEntityGraphicsPending.erase(entityTreeNodeId);
+    m_vecExplodeItem.clear(); // Bounding boxes are now complete
+    emit graphicsBoundingBoxChanged(m_gfxBoundingBox);
+    emit entityGraphicsMapped(entityTreeNodeId);
+    this->updateHiddenLines();
+    m_guiApp->enforceGraphicsMemoryBudget();
 }
 
 void GuiDocument::unmapEntity(TreeNodeId entityTreeNodeId)
 {
-    {   // Delete entity graphics
-        const GraphicsEntity* ptrItem = this->findGraphicsEntity(entityTreeNodeId);
-        if (!ptrItem)
+    this->unmapEntities(Span<const TreeNodeId>(&entityTreeNodeId, 1));
+}
+
+void GuiDocument::unmapEntities(Span<const TreeNodeId> spanEntityTreeNodeId)
+{
+    const std::unordered_set<TreeNodeId> setEntityTreeNodeId(spanEntityTreeNodeId.begin(), spanEntityTreeNodeId.end());
+    auto fnIsUnmapped = [&](const GraphicsEntity& gfxEntity) {
+        return setEntityTreeNodeId.find(gfxEntity.treeNodeId) != setEntityTreeNodeId.cend();
+    };
+
+    {   // Delete entities graphics
+        const bool onEntryRedrawBlocked = m_gfxScene.isRedrawBlocked();
+        m_gfxScene.blockRedraw(true);
+        auto _ = gsl::finally([=]{ m_gfxScene.blockRedraw(onEntryRedrawBlocked); });
+        int unmappedCount = 0;
+        for (const GraphicsEntity& gfxEntity : m_vecGraphicsEntity) {
+            if (!fnIsUnmapped(gfxEntity))
+                continue;
+
+            for (const GraphicsEntity::Object& object : gfxEntity.vecObject) {
+                if (!GraphicsInstancedObject::fromInstance(object.ptr) && !GraphicsBatchedObject::fromMember(object.ptr))
+                    m_gfxScene.eraseObject(object.ptr);
+            }
+
+            for (const GraphicsObjectPtr& object : gfxEntity.vecInstancedObject)
+                m_gfxScene.eraseObject(object);
+
+            for (const GraphicsObjectPtr& object : gfxEntity.vecBatchedObject)
+                m_gfxScene.eraseObject(object);
+
+            for (const auto& pairNodeGfxObject : gfxEntity.mapTreeNodeGfxObject)
+                m_mapGfxObjectTreeNode.erase(pairNodeGfxObject.second);
+
+            for (const GraphicsEntity::Object& object : gfxEntity.vecObject) {
+                m_mapGfxObjectHiddenTick.erase(object.ptr);
+                m_mapGfxObjectHiddenTime.erase(object.ptr);
+                m_setGfxObjectReleased.erase(object.ptr);
+                m_setGfxObjectReleased.erase(Internal::graphicsProduct(object.ptr));
+                m_setGfxObjectReleasedVisible.erase(object.ptr);
+            }
+
+            auto itMeshProblems = m_mapEntityMeshProblems.find(gfxEntity.treeNodeId);
+            if (itMeshProblems != m_mapEntityMeshProblems.end()) {
+                m_gfxScene.eraseObject(itMeshProblems->second);
+                m_mapEntityMeshProblems.erase(itMeshProblems);
+            }
+
+            m_partBvh.removeEntity(gfxEntity.treeNodeId);
+            this->unmapNodeVisibleStates(gfxEntity.treeNodeId);
+            ++unmappedCount;
+        }
+
+        if (unmappedCount == 0)
             return;
 
-        for (const GraphicsEntity::Object& object : ptrItem->vecObject)
-            m_gfxScene.eraseObject(object.ptr);
+        m_vecGraphicsEntity.erase(
+                    std::remove_if(m_vecGraphicsEntity.begin(), m_vecGraphicsEntity.end(), fnIsUnmapped),
+                    m_vecGraphicsEntity.end());
+    }
 
-        const int indexItem = ptrItem - &m_vecGraphicsEntity.front();
-        m_vecGraphicsEntity.erase(m_vecGraphicsEntity.begin() + indexItem);
-        m_gfxScene.redraw();
+    m_gfxScene.redraw();
+    m_vecExplodeItem.clear();
+    this->clearHiddenLinesCache();
+    this->updateHiddenLines();
+}
+
+void GuiDocument::computeExplodeItems()
+{
+    m_vecExplodeItem.clear();
+    size_t objectCount = 0;
+    for (const GraphicsEntity& entity : m_vecGraphicsEntity)
+        objectCount += entity.vecObject.size();
+
+    m_vecExplodeItem.reserve(objectCount);
+    if (m_explodingMode == ExplodingMode::Hierarchical)
+        this->computeExplodeItemsHierarchical();
+    else
+        this->computeExplodeItemsFlat();
+}
+
+void GuiDocument::computeExplodeItemsFlat()
+{
+    for (const GraphicsEntity& entity : m_vecGraphicsEntity) {
+        const gp_Pnt entityCenter = BndBoxCoords::get(entity.bndBox).center();
+        for (const GraphicsEntity::Object& object : entity.vecObject) {
+            const gp_Vec vecDirection(entityCenter, BndBoxCoords::get(object.bndBox).center());
+            m_vecExplodeItem.push_back({ object.ptr, object.trsfOriginal, 2 * vecDirection });
+        }
+    }
+}
+
+void GuiDocument::computeExplodeItemsHierarchical()
+{
+    // Tables indexed by tree node identifier
+    const Tree<TDF_Label>& modelTree = m_document->modelTree();
+    const size_t tableSize = modelTree.nodeCount() + 1;
+    std::vector<Bnd_Box> vecNodeBndBox(tableSize);
+    std::vector<gp_Vec> vecNodeMove(tableSize, gp_Vec(0, 0, 0));
+    std::vector<unsigned> vecNodeDepth(tableSize, 0);
+    auto fnLevelFactor = [=](unsigned depth) {
+        const size_t level = std::min<size_t>(depth - 1, m_vecExplodingLevelFactor.size() - 1);
+        return m_vecExplodingLevelFactor.at(level);
+    };
+
+    for (const GraphicsEntity& entity : m_vecGraphicsEntity) {
+        std::unordered_map<GraphicsObjectPtr, const GraphicsEntity::Object*> mapObject;
+        for (const GraphicsEntity::Object& object : entity.vecObject)
+            mapObject.insert({ object.ptr, &object });
+
+        // Post-order: bounding box of a node is the union of the boxes of its graphics objects
+        traverseTree_postOrder(entity.treeNodeId, modelTree, [&](TreeNodeId id) {
+            const GraphicsObjectPtr gfxObject = CppUtils::findValue(id, entity.mapTreeNodeGfxObject);
+            const GraphicsEntity::Object* object = gfxObject ? CppUtils::findValue(gfxObject, mapObject) : nullptr;
+            if (object)
+                BndUtils::add(&vecNodeBndBox.at(id), object->bndBox);
+
+            const TreeNodeId parentId = modelTree.nodeParent(id);
+            if (parentId != 0)
+                BndUtils::add(&vecNodeBndBox.at(parentId), vecNodeBndBox.at(id));
+        });
+
+        // Pre-order: move of a node is its parent's move plus the scaled offset from parent center
+        traverseTree_preOrder(entity.treeNodeId, modelTree, [&](TreeNodeId id) {
+            const TreeNodeId parentId = id != entity.treeNodeId ? modelTree.nodeParent(id) : 0;
+            if (parentId != 0) {
+                const unsigned depth = vecNodeDepth.at(parentId) + 1;
+                vecNodeDepth.at(id) = depth;
+                vecNodeMove.at(id) = vecNodeMove.at(parentId);
+                const Bnd_Box& bndBox = vecNodeBndBox.at(id);
+                const Bnd_Box& parentBndBox = vecNodeBndBox.at(parentId);
+                if (!bndBox.IsVoid() && !parentBndBox.IsVoid()) {
+                    const gp_Vec vecDirection(
+                                BndBoxCoords::get(parentBndBox).center(),
+                                BndBoxCoords::get(bndBox).center());
+                    vecNodeMove.at(id) += 2 * fnLevelFactor(depth) * vecDirection;
+                }
+            }
+
+            const GraphicsObjectPtr gfxObject = CppUtils::findValue(id, entity.mapTreeNodeGfxObject);
+            const GraphicsEntity::Object* object = gfxObject ? CppUtils::findValue(gfxObject, mapObject) : nullptr;
+            if (object)
+                m_vecExplodeItem.push_back({ object->ptr, object->trsfOriginal, vecNodeMove.at(id) });
+        });
     }
+}
+
+bool GuiDocument::isNodeVisibleStateMapped(TreeNodeId nodeId) const
+{
+    return nodeId < m_vecTreeNodeMapped.size() && m_vecTreeNodeMapped.at(nodeId);
+}
 
+void GuiDocument::mapNodeVisibleStates(TreeNodeId entityTreeNodeId)
+{
+    const Tree<TDF_Label>& modelTree = m_document->modelTree();
+    traverseTree(entityTreeNodeId, modelTree, [&](TreeNodeId id) {
+        if (id >= m_vecTreeNodeMapped.size()) {
+            const size_t size = id + 1;
+            m_vecTreeNodeMapped.resize(size, false);
+            m_vecTreeNodeChecked.resize(size, false);
+            m_vecTreeNodePartiallyChecked.resize(size, false);
+            m_vecTreeNodeChildCount.resize(size, 0);
+            m_vecTreeNodeCheckedChildCount.resize(size, 0);
+            m_vecTreeNodeUncheckedChildCount.resize(size, 0);
+        }
+
+        // Pre-order traversal: parent node is already initialized
+        m_vecTreeNodeMapped[id] = true;
+        m_vecTreeNodeChecked[id] = true;
+        m_vecTreeNodePartiallyChecked[id] = false;
+        m_vecTreeNodeChildCount[id] = 0;
+        m_vecTreeNodeCheckedChildCount[id] = 0;
+        m_vecTreeNodeUncheckedChildCount[id] = 0;
+        const TreeNodeId parentId = modelTree.nodeParent(id);
+        if (parentId != 0) {
+            ++m_vecTreeNodeChildCount[parentId];
+            ++m_vecTreeNodeCheckedChildCount[parentId];
+        }
+    });
+}
+
+void GuiDocument::unmapNodeVisibleStates(TreeNodeId entityTreeNodeId)
+{
     traverseTree(entityTreeNodeId, m_document->modelTree(), [=](TreeNodeId id) {
-        m_mapTreeNodeCheckState.erase(id);
+        if (id < m_vecTreeNodeMapped.size())
+            m_vecTreeNodeMapped[id] = false;
     });
 }
 
+bool GuiDocument::updateNodeVisibleState(TreeNodeId nodeId, Qt::CheckState state)
+{
+    const Qt::CheckState oldState = this->nodeVisibleState(nodeId);
+    if (oldState == state)
+        return false;
+
+    m_vecTreeNodeChecked[nodeId] = state == Qt::Checked;
+    m_vecTreeNodePartiallyChecked[nodeId] = state == Qt::PartiallyChecked;
+
+    // Keep in sync the children counters of the parent node
+    const TreeNodeId parentId = m_document->modelTree().nodeParent(nodeId);
+    if (parentId != 0) {
+        if (oldState == Qt::Checked)
+            --m_vecTreeNodeCheckedChildCount[parentId];
+        else if (oldState == Qt::Unchecked)
+            --m_vecTreeNodeUncheckedChildCount[parentId];
+
+        if (state == Qt::Checked)
+            ++m_vecTreeNodeCheckedChildCount[parentId];
+        else if (state == Qt::Unchecked)
+            ++m_vecTreeNodeUncheckedChildCount[parentId];
+    }
+
+    return true;
+}
+
+void GuiDocument::updateParentNodesVisibleState(
+        Span<const TreeNodeId> spanNodeId,
+        std::unordered_map<TreeNodeId, Qt::CheckState>* ptrMapNodeIdVisibleState)
+{
+    // Parent nodes check state, deduced from the counters of checked/unchecked children
+    const Tree<TDF_Label>& docModelTree = m_document->modelTree();
+    for (TreeNodeId nodeId : spanNodeId) {
+        TreeNodeId parentId = docModelTree.nodeParent(nodeId);
+        while (parentId != 0) {
+            const uint32_t childCount = m_vecTreeNodeChildCount.at(parentId);
+            Qt::CheckState parentVisibleState = Qt::PartiallyChecked;
+            if (m_vecTreeNodeCheckedChildCount.at(parentId) == childCount)
+                parentVisibleState = Qt::Checked;
+            else if (m_vecTreeNodeUncheckedChildCount.at(parentId) == childCount)
+                parentVisibleState = Qt::Unchecked;
+
+            if (!this->updateNodeVisibleState(parentId, parentVisibleState))
+                break; // Upper parents aren't affected
+
+            (*ptrMapNodeIdVisibleState)[parentId] = parentVisibleState;
+            parentId = docModelTree.nodeParent(parentId);
+        }
+    }
+}
+
+void GuiDocument::restoreNodesSelection(Span<const TreeNodeId> spanNodeId)
+{
+    // In case the node graphics are "shown" back again then AIS object selection status is lost
+    const Span<const ApplicationItem> spanSelected = m_guiApp->selectionModel()->selectedItems();
+    if (spanNodeId.empty() || spanSelected.empty())
+        return;
+
+    std::unordered_set<TreeNodeId> setSelectedNodeId;
+    for (const ApplicationItem& appItem : spanSelected) {
+        if (appItem.isDocumentTreeNode() && appItem.document() == m_document)
+            setSelectedNodeId.insert(appItem.documentTreeNode().id());
+    }
+
+    const Tree<TDF_Label>& docModelTree = m_document->modelTree();
+    auto fnToggleNodeSelected = [=](TreeNodeId id) {
+        this->toggleItemSelected(ApplicationItem(DocumentTreeNode(m_document, id)));
+    };
+
+    // Input nodes having a selected parent
+    for (TreeNodeId nodeId : spanNodeId) {
+        if (setSelectedNodeId.find(nodeId) != setSelectedNodeId.cend())
+            continue; // Handled below
+
+        TreeNodeId parentId = docModelTree.nodeParent(nodeId);
+        while (parentId != 0 && setSelectedNodeId.find(parentId) == setSelectedNodeId.cend())
+            parentId = docModelTree.nodeParent(parentId);
+
+        if (parentId != 0)
+            fnToggleNodeSelected(nodeId);
+    }
+
+    // Selected input nodes and selected children of input nodes
+    const std::unordered_set<TreeNodeId> setNodeId(spanNodeId.begin(), spanNodeId.end());
+    for (TreeNodeId selectedNodeId : setSelectedNodeId) {
+        TreeNodeId id = selectedNodeId;
+        while (id != 0 && setNodeId.find(id) == setNodeId.cend())
+            id = docModelTree.nodeParent(id);
+
+        if (id != 0)
+            fnToggleNodeSelected(selectedNodeId);
+    }
+}
+
+void GuiDocument::setGraphicsObjectVisible(const GraphicsObjectPtr& object, bool on)
+{
+    m_setGfxObjectReleasedVisible.erase(object);
+    if (on) {
+        this->expandCompactedMeshes(Span<const GraphicsObjectPtr>(&object, 1));
+        this->restoreGraphics(object);
+        m_mapGfxObjectHiddenTime.erase(object);
+    }
+    else {
+        m_mapGfxObjectHiddenTick[object] = m_guiApp->newViewTick();
+        m_mapGfxObjectHiddenTime[object] = std::chrono::steady_clock::now();
+    }
+
+    GraphicsUtils::AisObject_setVisible(object, on);
+}
+
+void GuiDocument::restoreGraphics(const GraphicsObjectPtr& object)
+{
+    if (m_setGfxObjectReleased.empty())
+        return;
+
+    // Product comes first, sensitive entities of instances are computed from the product ones
+    const GraphicsObjectPtr product = Internal::graphicsProduct(object);
+    if (product != object && m_setGfxObjectReleased.erase(product) != 0)
+        m_gfxScene.restoreObjectGraphicsData(product);
+
+    if (m_setGfxObjectReleased.erase(object) != 0)
+        m_gfxScene.restoreObjectGraphicsData(object);
+}
+
+void GuiDocument::restoreReleasedVisibleGraphics()
+{
+    if (m_setGfxObjectReleasedVisible.empty())
+        return;
+
+    const std::vector<GraphicsObjectPtr> vecObject(
+                m_setGfxObjectReleasedVisible.cbegin(), m_setGfxObjectReleasedVisible.cend());
+    {
+        GraphicsSceneRedrawBlocker redrawBlocker(&m_gfxScene);
+        for (const GraphicsObjectPtr& object : vecObject)
+            this->setGraphicsObjectVisible(object, true);
+
+        this->updateBatchedObjects();
+    }
+
+    m_gfxScene.redraw();
+}
+
+void GuiDocument::updateBatchedObjects()
+{
+    for (const GraphicsEntity& gfxEntity : m_vecGraphicsEntity) {
+        for (const GraphicsObjectPtr& object : gfxEntity.vecBatchedObject) {
+            auto gfxBatched = opencascade::handle<GraphicsBatchedObject>::DownCast(object);
+            if (gfxBatched)
+                gfxBatched->updateMembersVisibility();
+        }
+    }
+}
+
 const GuiDocument::GraphicsEntity* GuiDocument::findGraphicsEntity(TreeNodeId entityTreeNodeId) const
 {
     auto itFound = std::find_if(
@@ -606,6 +2358,15 @@ const GuiDocument::GraphicsEntity* GuiDocument::findGraphicsEntity(TreeNodeId en
     return itFound != m_vecGraphicsEntity.cend() ? &(*itFound) : nullptr;
 }
 
+void GuiDocument::addGraphicsEntity(GraphicsEntity&& gfxEntity)
+{
+    for (const auto& pairNodeGfxObject : gfxEntity.mapTreeNodeGfxObject)
+        m_mapGfxObjectTreeNode.insert({ pairNodeGfxObject.second, pairNodeGfxObject.first });
+
+    m_vecGraphicsEntity.push_back(std::move(gfxEntity));
+    m_vecExplodeItem.clear();
+}
+
 void GuiDocument::v3dViewTrihedronDisplay(Qt::Corner corner)
 {
     constexpr double scale = 0.075;
@@ -7,22 +7,39 @@
 #pragma once
 
 #include "../base/document.h"
+#include "../base/flat_hash_map.h"
+#include "../base/part_bvh.h"
+#include "../base/task_common.h"
 #include "../base/tkernel_utils.h"
+#include "../graphics/graphics_hlr.h"
 #include "../graphics/graphics_object_driver.h"
 #include "../graphics/graphics_scene.h"
 
 #include <QtCore/QObject>
 #include <Bnd_Box.hxx>
+#include <Graphic3d_ZLayerSettings.hxx>
+#include <TopoDS_Shape.hxx>
 #include <V3d_View.hxx>
+#include <gp_Vec.hxx>
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+class QTimer;
+
 namespace Mayo {
 
 class ApplicationItem;
+class BRepMeshPriorities;
+class GraphicsObjectDriverTable;
 class GuiApplication;
+class MemoryAccounting;
+class TaskProgress;
 class V3dViewCameraAnimation;
 
 // Provides the link between Base::Document and graphical representations
@@ -36,16 +53,36 @@ public:
     GuiApplication* guiApplication() const { return m_guiApp; }
 
     const Handle_V3d_View& v3dView() const { return m_v3dView; }
+
+    // Secondary views(eg split views) of the graphics scene, sharing viewer, interactive context
+    // and GPU resources with v3dView(). They have their own camera and clip planes, hidden line
+    // removal is computed for v3dView() only
+    Handle_V3d_View createSecondaryV3dView(V3d_TypeOfOrientation proj);
+    void destroySecondaryV3dView(const Handle_V3d_View& view);
+    Span<const Handle_V3d_View> secondaryV3dViews() const { return m_vecSecondaryV3dView; }
     GraphicsScene* graphicsScene() { return &m_gfxScene; }
     const Bnd_Box& graphicsBoundingBox() const { return m_gfxBoundingBox; }
+    // Spatial index of the parts of the mapped entities
+    const PartBvh& partBvh() const { return m_partBvh; }
+
+    // Whether graphics of some entities are still being created or added to the scene
+    bool isMappingEntityGraphics() const { return !m_setEntityGraphicsPending.empty(); }
 
     // Executes callback 'fn' on all graphics objects associated to tree node 'nodeId'
     // This also includes all children(deep node traversal)
     void foreachGraphicsObject(TreeNodeId nodeId, const std::function<void(GraphicsObjectPtr)>& fn) const;
 
+    // Adds memory estimations of the graphics objects associated to tree node 'nodeId'(deep
+    // node traversal), see GraphicsUtils::AisObject_addMemoryStats()
+    void addMemoryStats(TreeNodeId nodeId, MemoryAccounting* accounting) const;
+
     // Finds the tree node id associated to graphics object
     TreeNodeId nodeFromGraphicsObject(const GraphicsObjectPtr& object) const;
 
+    // Recomputes the graphics of product 'labelProduct' and of its instances, to be called once
+    // the shape of the product was changed(eg loaded by a DeferredShapeLoader)
+    void updateProductGraphics(const TDF_Label& labelProduct);
+
     // Toggles selected status of an application item(doesn't affect Application's selection model)
     void toggleItemSelected(const ApplicationItem& appItem);
 
@@ -56,14 +93,97 @@ public:
     int activeDisplayMode(const GraphicsObjectDriverPtr& driver) const;
     void setActiveDisplayMode(const GraphicsObjectDriverPtr& driver, int mode);
 
+    // -- Fast interaction mode, meant to be active while the view camera is moved(rotation, panning)
+    struct ViewInteractionOptions {
+        int cullingPixelSize = 0; // Objects whose projected size is below are not drawn, 0 to disable
+        bool plainShaded = false; // Shapes shaded with face boundaries are drawn plain shaded
+    };
+    bool isViewInteractionActive() const { return m_isViewInteractionActive; }
+    void beginViewInteraction(const ViewInteractionOptions& options);
+    void endViewInteraction(); // Restores culling and display modes
+
     // -- Visible state of document's tree nodes
     Qt::CheckState nodeVisibleState(TreeNodeId nodeId) const;
     void setNodeVisible(TreeNodeId nodeId, bool on);
+    // Bulk operations, signal nodesVisibilityChanged() is emitted once
+    void setNodesVisible(Span<const TreeNodeId> spanNodeId, bool on);
+    // Shows the input nodes(and their children) and hides all the other ones
+    void isolate(Span<const TreeNodeId> spanNodeId);
 
     // -- Exploding
     double explodingFactor() const { return m_explodingFactor; }
     void setExplodingFactor(double t); // Must be in [0,1]
 
+    enum class ExplodingMode {
+        Flat, // Leaf objects move away from the center of their entity
+        Hierarchical // Each sub-assembly moves away from the center of its parent assembly
+    };
+    ExplodingMode explodingMode() const { return m_explodingMode; }
+    void setExplodingMode(ExplodingMode mode);
+
+    // Scaling factors of the moves in hierarchical mode, one per assembly level(index 0 is for the
+    // direct children of entities). The last factor applies to all deeper levels
+    const std::vector<double>& explodingLevelFactors() const { return m_vecExplodingLevelFactor; }
+    void setExplodingLevelFactors(Span<const double> spanFactor);
+
+    // -- Mesh levels of detail
+    // Activates for each shape product the mesh level matching its size projected in the view,
+    // see BRepUtils::computeMeshLods(). A product shared by instances follows its largest instance
+    void updateMeshLods();
+    // Activates the finest mesh level of all shape products
+    void resetMeshLods();
+
+    // -- Prioritized meshing, see AppModule::recomputeBRepMesh()
+    // Returns the meshing priorities of the shape products for the current view: visible products
+    // within the view frustum first, then by decreasing projected size. Priorities are updated
+    // when the visibility of nodes changes(eg isolation) and by updateMeshPriorities(). Products
+    // reported done are recomputed right away, except the members of batches
+    std::shared_ptr<BRepMeshPriorities> beginMeshPriorities();
+    // To be called once the view camera moved, does nothing if meshing isn't in progress
+    void updateMeshPriorities();
+    // To be called once meshing is over, returns the objects whose presentation was recomputed
+    // since beginMeshPriorities()
+    std::unordered_set<GraphicsObjectPtr> endMeshPriorities(const std::shared_ptr<BRepMeshPriorities>& priorities);
+
+    // -- Point clouds levels of detail, see GraphicsPointCloudObject::updateLod()
+    // Selects the octree nodes of the visible point clouds for the current view, 'pointBudget' is
+    // shared by all the clouds. Returns true if nodes are still to be loaded, function has then to
+    // be called again(eg from a timer) so the clouds get refined progressively
+    bool updatePointCloudLods(uint64_t pointBudget);
+
+    // -- Hidden line removal, active with GraphicsShapeObjectDriver::DisplayMode_HiddenLineRemoval
+    // Visible edges of the shapes are computed by a background task for the current view direction,
+    // previous edges stay displayed until then. Edges are kept for the standard orientations(see
+    // setViewCameraOrientation()), to be called once the view camera stopped moving
+    void updateHiddenLines();
+
+    // -- Highlight of mesh problems, see Document::meshQualityReport()
+    // Problem triangles of the entities already analyzed are overlaid in red
+    bool isMeshProblemsHighlighted() const { return m_isMeshProblemsHighlighted; }
+    void setMeshProblemsHighlighted(bool on);
+    // To be called once entities are (re)analyzed
+    void updateMeshProblemsHighlight();
+
+    // -- Release of graphics data, see GuiApplication::setGraphicsMemoryBudget()
+    // Product(the connected object of instances, or the object itself) whose presentations and
+    // sensitive entities can be released
+    struct ReleasableGraphics {
+        GraphicsObjectPtr product;
+        uint64_t viewTick = 0; // When some object of the product was visible for the last time
+        int64_t memory = 0; // Estimation of presentation and selection data
+    };
+    // Products whose objects are all hidden and not selected, visible objects are also candidates
+    // if the document isn't the active one. Grouped instances are excluded
+    std::vector<ReleasableGraphics> releasableGraphics() const;
+    // Objects of the released products are recomputed when shown again
+    void releaseGraphics(Span<const GraphicsObjectPtr> spanProduct);
+
+    // -- Compaction of meshes, see Document::compactTriangulations()
+    // Triangulations of the products whose objects are all hidden for 'hiddenDelay' at least and
+    // not selected are compressed by a background task. Grouped instances and batched parts are
+    // excluded. Triangulations are expanded back(concurrently) when objects get visible
+    void compactHiddenMeshes(std::chrono::seconds hiddenDelay);
+
     // -- Visibility of trihedron at world origin
     bool isOriginTrihedronVisible() const;
     void toggleOriginTrihedronVisibility();
@@ -92,18 +212,31 @@ signals:
     void nodesVisibilityChanged(const std::unordered_map<TreeNodeId, Qt::CheckState>& mapNodeId);
 
     void graphicsBoundingBoxChanged(const Bnd_Box& bndBox);
+    void entityGraphicsMapped(Mayo::TreeNodeId entityTreeNodeId);
+    // Emitted by releaseGraphics(), shapes of the products can be released as well
+    void productGraphicsReleased(const std::vector<TDF_Label>& vecLabelProduct);
 
     void viewTrihedronModeChanged(ViewTrihedronMode mode);
     void viewTrihedronCornerChanged(Qt::Corner corner);
 
     // -- Implementation
 private:
+    friend class GuiApplication;
+
     void onDocumentEntityAdded(TreeNodeId entityTreeNodeId);
     void onDocumentEntityAboutToBeDestroyed(TreeNodeId entityTreeNodeId);
+    void onDocumentEntitiesAboutToBeDestroyed(Span<const TreeNodeId> spanEntityTreeNodeId);
     void onGraphicsSelectionChanged();
 
+    // Called by GuiApplication before deletion when the document is closed: tasks reading the
+    // document are stopped and graphics objects are all removed from the scene at once
+    void detach();
+
     void mapEntity(TreeNodeId entityTreeNodeId);
+    void mapEntityAsync(TreeNodeId entityTreeNodeId);
     void unmapEntity(TreeNodeId entityTreeNodeId);
+    // Objects of all the entities are erased from the scene with a single redraw
+    void unmapEntities(Span<const TreeNodeId> spanEntityTreeNodeId);
 
     struct GraphicsEntity {
         struct Object {
@@ -115,19 +248,71 @@ private:
 
         TreeNodeId treeNodeId;
         std::vector<Object> vecObject;
-        std::unordered_map<TreeNodeId, GraphicsObjectPtr> mapTreeNodeGfxObject;
-        std::unordered_map<GraphicsObjectPtr, TreeNodeId> mapGfxObjectTreeNode;
+        std::vector<GraphicsObjectPtr> vecInstancedObject; // Groups of instances listed in 'vecObject'
+        std::vector<GraphicsObjectPtr> vecBatchedObject; // Batches of the members listed in 'vecObject'
+        FlatHashMap<TreeNodeId, GraphicsObjectPtr> mapTreeNodeGfxObject;
+        FlatHashMap<GraphicsObjectPtr, TDF_Label> mapGfxProductLabel;
         Bnd_Box bndBox;
     };
 
     const GraphicsEntity* findGraphicsEntity(TreeNodeId entityTreeNodeId) const;
+    void addGraphicsEntity(GraphicsEntity&& gfxEntity);
+
+    // Graphics scene isn't accessed, so these functions can be called from a worker thread
+    // With 'staticBatching', small parts instantiated once are merged by style into batches, see
+    // GraphicsBatchedObject
+    static GraphicsEntity createGraphicsEntity(
+            const DocumentPtr& doc,
+            const GraphicsObjectDriverTable* gfxDriverTable,
+            TreeNodeId entityTreeNodeId,
+            bool staticBatching);
+    static void prepareGraphicsEntity(GraphicsEntity* gfxEntity, TaskProgress* progress = nullptr);
+    // Computes sensitive entities and their BVH trees for the default selection mode, so first
+    // picking in the view doesn't stall the GUI thread. Objects must not be in the scene yet
+    static void prepareGraphicsEntitySelection(GraphicsEntity* gfxEntity, TaskProgress* progress = nullptr);
+
+    // Adds to the scene the objects of entity starting at 'indexFirst', by batches
+    void publishGraphicsObjects(TreeNodeId entityTreeNodeId, int indexFirst);
 
     void v3dViewTrihedronDisplay(Qt::Corner corner);
 
+    void applyDisplayMode(const GraphicsObjectDriverPtr& driver, int mode);
+    void applyObjectsDisplayMode(const GraphicsObjectDriverPtr& driver, int mode);
+
+    void beginHiddenLineRemoval(const GraphicsObjectDriverPtr& driver);
+    void endHiddenLineRemoval();
+    void clearHiddenLinesCache();
+    void showHiddenLines(int orientation, Span<const GraphicsObjectPtr> spanObject);
+
+    void computeExplodeItems();
+    void computeExplodeItemsFlat();
+    void computeExplodeItemsHierarchical();
+
+    bool isNodeVisibleStateMapped(TreeNodeId nodeId) const;
+    void mapNodeVisibleStates(TreeNodeId entityTreeNodeId);
+    void unmapNodeVisibleStates(TreeNodeId entityTreeNodeId);
+    // Returns true if visible state of the node was actually changed
+    bool updateNodeVisibleState(TreeNodeId nodeId, Qt::CheckState state);
+    void updateParentNodesVisibleState(
+            Span<const TreeNodeId> spanNodeId,
+            std::unordered_map<TreeNodeId, Qt::CheckState>* ptrMapNodeIdVisibleState);
+    void restoreNodesSelection(Span<const TreeNodeId> spanNodeId);
+
+    // Shows or hides graphics object, data previously released is restored before showing
+    void setGraphicsObjectVisible(const GraphicsObjectPtr& object, bool on);
+    void restoreGraphics(const GraphicsObjectPtr& object);
+    // Recomputes the batches whose members were shown or hidden
+    void updateBatchedObjects();
+    // Displays back the objects erased by releaseGraphics() while the document wasn't active
+    void restoreReleasedVisibleGraphics();
+    // Recomputes the presentations of the products reported done by 'm_meshPriorities'
+    void recomputeMeshPartsDone();
+
     GuiApplication* m_guiApp = nullptr;
     DocumentPtr m_document;
     GraphicsScene m_gfxScene;
     Handle_V3d_View m_v3dView;
+    std::vector<Handle_V3d_View> m_vecSecondaryV3dView;
     Handle_AIS_InteractiveObject m_aisOriginTrihedron;
 
     V3dViewCameraAnimation* m_cameraAnimation;
@@ -136,12 +321,72 @@ private:
     Handle_AIS_InteractiveObject m_aisViewCube;
 
     std::vector<GraphicsEntity> m_vecGraphicsEntity;
+    FlatHashMap<GraphicsObjectPtr, TreeNodeId> m_mapGfxObjectTreeNode; // All entities
+    std::unordered_map<TreeNodeId, TaskId> m_mapEntityPendingTask;
+    std::unordered_set<TreeNodeId> m_setEntityGraphicsPending;
     Bnd_Box m_gfxBoundingBox;
+    PartBvh m_partBvh;
 
     std::unordered_map<GraphicsObjectDriverPtr, int> m_mapGfxDriverDisplayMode;
-    std::unordered_map<TreeNodeId, Qt::CheckState> m_mapTreeNodeCheckState;
+
+    // Hidden line removal, overlay object is null if not active
+    using MapGfxObjectHlrEdges = std::unordered_map<GraphicsObjectPtr, Handle_Graphic3d_ArrayOfSegments>;
+    opencascade::handle<GraphicsHlrObject> m_gfxHlrObject;
+    GraphicsObjectDriverPtr m_hlrPendingDriver; // Display mode applied once first edges are shown
+    std::optional<TaskId> m_hlrTaskId;
+    gp_Dir m_hlrViewProj;
+    // Edges per V3d_TypeOfOrientation, key -1 is for the last non-standard view direction
+    std::unordered_map<int, MapGfxObjectHlrEdges> m_mapOrientationHlrEdges;
+
+    // Overlay objects of mesh problem triangles, per entity tree node
+    bool m_isMeshProblemsHighlighted = false;
+    std::unordered_map<TreeNodeId, GraphicsObjectPtr> m_mapEntityMeshProblems;
+
+    // Prioritized meshing, products are indexed as the parts of 'm_meshPriorities'
+    std::shared_ptr<BRepMeshPriorities> m_meshPriorities;
+    std::vector<GraphicsObjectPtr> m_vecMeshPriorityProduct;
+    std::unordered_set<GraphicsObjectPtr> m_setMeshPriorityRecomputed;
+    QTimer* m_timerMeshPartsDone = nullptr;
+
+    // Compaction of hidden meshes, shapes are the ones of the products
+    void expandCompactedMeshes(Span<const GraphicsObjectPtr> spanObject);
+    void stopCompactHiddenMeshes();
+    void endCompactHiddenMeshes();
+    std::optional<TaskId> m_compactTaskId;
+    std::vector<TopoDS_Shape> m_vecShapeCompacting; // Input of the running task
+    std::shared_ptr<std::atomic<int>> m_shapeCompactedCount; // Progress of the running task
+    std::unordered_set<Handle_TopoDS_TShape> m_setShapeCompacted;
+    std::unordered_map<GraphicsObjectPtr, std::chrono::steady_clock::time_point> m_mapGfxObjectHiddenTime;
+
+    // Visible state of the document tree nodes, indexed by TreeNodeId
+    std::vector<bool> m_vecTreeNodeMapped;
+    std::vector<bool> m_vecTreeNodeChecked;
+    std::vector<bool> m_vecTreeNodePartiallyChecked;
+    // Count of direct children per tree node, and among them the checked/unchecked ones
+    std::vector<uint32_t> m_vecTreeNodeChildCount;
+    std::vector<uint32_t> m_vecTreeNodeCheckedChildCount;
+    std::vector<uint32_t> m_vecTreeNodeUncheckedChildCount;
+
+    bool m_isViewInteractionActive = false;
+    Graphic3d_ZLayerSettings m_defaultZLayerSettingsBackup;
+    std::vector<GraphicsObjectDriverPtr> m_vecInteractionPlainShadedDriver;
 
     double m_explodingFactor = 0.;
+    ExplodingMode m_explodingMode = ExplodingMode::Flat;
+    std::vector<double> m_vecExplodingLevelFactor = { 1. };
+    // Exploding data computed once for all the graphics objects, cleared when entities change
+    struct ExplodeItem {
+        GraphicsObjectPtr object;
+        gp_Trsf trsfOriginal;
+        gp_Vec vecMove; // Translation at exploding factor 1
+    };
+    std::vector<ExplodeItem> m_vecExplodeItem;
+
+    // Released graphics data, ticks are provided by GuiApplication
+    uint64_t m_viewTick = 0; // When the document was active for the last time
+    std::unordered_map<GraphicsObjectPtr, uint64_t> m_mapGfxObjectHiddenTick;
+    std::unordered_set<GraphicsObjectPtr> m_setGfxObjectReleased; // Including products
+    std::unordered_set<GraphicsObjectPtr> m_setGfxObjectReleasedVisible;
 };
 
 } // namespace Mayo
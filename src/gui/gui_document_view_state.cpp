@@ -0,0 +1,182 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "gui_document_view_state.h"
+
+#include "../base/application_item_selection_model.h"
+#include "../base/caf_utils.h"
+#include "../base/document.h"
+#include "gui_application.h"
+#include "gui_document.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDataStream>
+#include <gp.hxx>
+#include <vector>
+
+namespace Mayo {
+
+namespace {
+
+std::vector<TreeNodeId> documentEntities(const DocumentPtr& doc)
+{
+    std::vector<TreeNodeId> vecEntityId;
+    for (int i = 0; i < doc->entityCount(); ++i)
+        vecEntityId.push_back(doc->entityTreeNodeId(i));
+
+    return vecEntityId;
+}
+
+void writeXYZ(QDataStream& stream, const gp_XYZ& coords)
+{
+    stream << coords.X() << coords.Y() << coords.Z();
+}
+
+gp_XYZ readXYZ(QDataStream& stream)
+{
+    double x = 0, y = 0, z = 0;
+    stream >> x >> y >> z;
+    return { x, y, z };
+}
+
+void writeKeys(QDataStream& stream, const std::unordered_set<std::string>& setKey)
+{
+    stream << uint32_t(setKey.size());
+    for (const std::string& key : setKey)
+        stream << QByteArray::fromStdString(key);
+}
+
+void readKeys(QDataStream& stream, std::unordered_set<std::string>* ptrSetKey)
+{
+    uint32_t count = 0;
+    stream >> count;
+    ptrSetKey->clear();
+    for (uint32_t i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QByteArray key;
+        stream >> key;
+        ptrSetKey->insert(key.toStdString());
+    }
+}
+
+} // namespace
+
+GuiDocumentViewState GuiDocumentViewState::save(GuiDocument* guiDoc)
+{
+    GuiDocumentViewState state;
+    const DocumentPtr& doc = guiDoc->document();
+    state.camera = new Graphic3d_Camera;
+    state.camera->Copy(guiDoc->v3dView()->Camera());
+    const auto mapNodeKey = GuiDocumentViewState::nodePathKeys(doc, documentEntities(doc));
+    for (const auto& [nodeId, key] : mapNodeKey) {
+        if (guiDoc->nodeVisibleState(nodeId) == Qt::Unchecked)
+            state.setHiddenNodeKey.insert(key);
+    }
+
+    for (const ApplicationItem& item : guiDoc->guiApplication()->selectionModel()->selectedItems()) {
+        if (item.document() == doc && item.isDocumentTreeNode()) {
+            auto itKey = mapNodeKey.find(item.documentTreeNode().id());
+            if (itKey != mapNodeKey.cend())
+                state.setSelectedNodeKey.insert(itKey->second);
+        }
+    }
+
+    return state;
+}
+
+void GuiDocumentViewState::restore(GuiDocument* guiDoc) const
+{
+    const DocumentPtr& doc = guiDoc->document();
+    const auto mapNodeKey = GuiDocumentViewState::nodePathKeys(doc, documentEntities(doc));
+    std::vector<TreeNodeId> vecHiddenNodeId;
+    std::vector<ApplicationItem> vecSelectedItem;
+    for (const auto& [nodeId, key] : mapNodeKey) {
+        if (this->setHiddenNodeKey.find(key) != this->setHiddenNodeKey.cend())
+            vecHiddenNodeId.push_back(nodeId);
+
+        if (this->setSelectedNodeKey.find(key) != this->setSelectedNodeKey.cend())
+            vecSelectedItem.push_back(DocumentTreeNode(doc, nodeId));
+    }
+
+    if (!vecHiddenNodeId.empty())
+        guiDoc->setNodesVisible(vecHiddenNodeId, false);
+
+    if (!vecSelectedItem.empty())
+        guiDoc->guiApplication()->selectionModel()->add(vecSelectedItem);
+
+    if (!this->camera.IsNull())
+        guiDoc->v3dView()->Camera()->Copy(this->camera);
+
+    guiDoc->graphicsScene()->redraw();
+}
+
+std::unordered_map<TreeNodeId, std::string> GuiDocumentViewState::nodePathKeys(
+        const DocumentPtr& doc, Span<const TreeNodeId> spanEntityId)
+{
+    std::unordered_map<TreeNodeId, std::string> mapNodeKey;
+    std::unordered_map<std::string, int> mapPathCount;
+    const Tree<TDF_Label>& modelTree = doc->modelTree();
+    for (TreeNodeId entityId : spanEntityId) {
+        traverseTree(entityId, modelTree, [&](TreeNodeId nodeId) {
+            const std::string parentKey = nodeId != entityId ? mapNodeKey[modelTree.nodeParent(nodeId)] : std::string();
+            const std::string path =
+                    parentKey + "/" + CafUtils::labelAttrStdName(modelTree.nodeData(nodeId)).toStdString();
+            const int index = mapPathCount[path]++;
+            mapNodeKey.insert({ nodeId, path + "#" + std::to_string(index) });
+        });
+    }
+
+    return mapNodeKey;
+}
+
+// Camera is written with the parameters defining the view, not its matrices
+QDataStream& operator<<(QDataStream& stream, const GuiDocumentViewState& state)
+{
+    const bool hasCamera = !state.camera.IsNull();
+    stream << hasCamera;
+    if (hasCamera) {
+        writeXYZ(stream, state.camera->Eye().XYZ());
+        writeXYZ(stream, state.camera->Center().XYZ());
+        writeXYZ(stream, state.camera->Up().XYZ());
+        stream << state.camera->Scale();
+        stream << state.camera->FOVy();
+        stream << int32_t(state.camera->ProjectionType());
+    }
+
+    writeKeys(stream, state.setHiddenNodeKey);
+    writeKeys(stream, state.setSelectedNodeKey);
+    return stream;
+}
+
+QDataStream& operator>>(QDataStream& stream, GuiDocumentViewState& state)
+{
+    bool hasCamera = false;
+    stream >> hasCamera;
+    state.camera.Nullify();
+    if (hasCamera) {
+        const gp_XYZ eye = readXYZ(stream);
+        const gp_XYZ center = readXYZ(stream);
+        const gp_XYZ up = readXYZ(stream);
+        double scale = 1;
+        double fovy = 45;
+        int32_t projectionType = 0;
+        stream >> scale >> fovy >> projectionType;
+        if (stream.status() == QDataStream::Ok && up.Modulus() > gp::Resolution() && scale > 0) {
+            state.camera = new Graphic3d_Camera;
+            state.camera->SetProjectionType(Graphic3d_Camera::Projection(projectionType));
+            state.camera->SetEye(gp_Pnt(eye));
+            state.camera->SetCenter(gp_Pnt(center));
+            state.camera->SetUp(gp_Dir(up));
+            state.camera->SetScale(scale);
+            state.camera->SetFOVy(fovy);
+        }
+    }
+
+    readKeys(stream, &state.setHiddenNodeKey);
+    readKeys(stream, &state.setSelectedNodeKey);
+    return stream;
+}
+
+} // namespace Mayo
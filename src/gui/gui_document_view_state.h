@@ -0,0 +1,46 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/document_ptr.h"
+#include "../base/libtree.h"
+#include "../base/span.h"
+
+#include <Graphic3d_Camera.hxx>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+class QDataStream;
+
+namespace Mayo {
+
+class GuiDocument;
+
+// State of the view of a GuiDocument: camera, hidden tree nodes and selected tree nodes
+// Tree nodes are referenced by their path keys and not by TreeNodeId, so the state can be restored
+// on the nodes of entities imported again(eg file reloaded, or opened in a later session)
+struct GuiDocumentViewState {
+    Handle_Graphic3d_Camera camera;
+    std::unordered_set<std::string> setHiddenNodeKey;
+    std::unordered_set<std::string> setSelectedNodeKey;
+
+    // Selection is taken from the selection model of the GuiApplication owning 'guiDoc'
+    static GuiDocumentViewState save(GuiDocument* guiDoc);
+    // Nodes whose key isn't found in 'guiDoc' are ignored, camera is left unchanged if null
+    void restore(GuiDocument* guiDoc) const;
+
+    // Keys identifying the tree nodes of entities 'spanEntityId' independently of their labels
+    // Key is the path of label names from the entity root, siblings sharing the same name are
+    // numbered in order of appearance
+    static std::unordered_map<TreeNodeId, std::string> nodePathKeys(
+            const DocumentPtr& doc, Span<const TreeNodeId> spanEntityId);
+};
+
+QDataStream& operator<<(QDataStream& stream, const GuiDocumentViewState& state);
+QDataStream& operator>>(QDataStream& stream, GuiDocumentViewState& state);
+
+} // namespace Mayo
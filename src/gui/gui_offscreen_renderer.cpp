@@ -0,0 +1,110 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "gui_offscreen_renderer.h"
+
+#include "gui_document.h"
+#include "qtgui_utils.h"
+#include "../graphics/graphics_utils.h"
+
+#include <gsl/util>
+#include <QtGui/QWindow>
+#include <Aspect_NeutralWindow.hxx>
+#include <Image_PixMap.hxx>
+#include <V3d_ImageDumpOptions.hxx>
+#include <algorithm>
+
+namespace Mayo {
+
+GuiOffscreenRenderer::GuiOffscreenRenderer() = default;
+GuiOffscreenRenderer::~GuiOffscreenRenderer() = default;
+
+QImage GuiOffscreenRenderer::render(GuiDocument* guiDoc, const Options& options)
+{
+    if (!guiDoc || options.size.isEmpty())
+        return {};
+
+    const GuiDocument::ViewTrihedronMode onEntryTrihedronMode = guiDoc->viewTrihedronMode();
+    const bool onEntryOriginTrihedronVisible = guiDoc->isOriginTrihedronVisible();
+    guiDoc->graphicsScene()->clearSelection();
+    guiDoc->setViewTrihedronMode(GuiDocument::ViewTrihedronMode::None);
+    if (guiDoc->isOriginTrihedronVisible())
+        guiDoc->toggleOriginTrihedronVisibility();
+
+    Handle_V3d_View view = this->createView(guiDoc, options);
+    auto _ = gsl::finally([=]{
+        guiDoc->graphicsScene()->v3dViewer()->SetViewOff(view);
+        guiDoc->setViewTrihedronMode(onEntryTrihedronMode);
+        if (guiDoc->isOriginTrihedronVisible() != onEntryOriginTrihedronVisible)
+            guiDoc->toggleOriginTrihedronVisibility();
+    });
+
+    Image_PixMap pixmap;
+    pixmap.SetTopDown(true);
+    V3d_ImageDumpOptions dumpOptions;
+    dumpOptions.BufferType = Graphic3d_BT_RGB;
+    dumpOptions.Width = options.size.width();
+    dumpOptions.Height = options.size.height();
+    if (!view->ToPixMap(pixmap, dumpOptions))
+        return {};
+
+    const QImage img(pixmap.Data(),
+                     int(pixmap.Width()),
+                     int(pixmap.Height()),
+                     int(pixmap.SizeRowBytes()),
+                     QImage::Format_RGB888);
+    return img.copy(); // Detach from 'pixmap' data
+}
+
+Handle_V3d_View GuiOffscreenRenderer::createView(GuiDocument* guiDoc, const Options& options)
+{
+    Handle_V3d_View view = guiDoc->graphicsScene()->createV3dView();
+    view->ChangeRenderingParams().IsAntialiasingEnabled = options.msaaSampleCount > 0;
+    view->ChangeRenderingParams().NbMsaaSamples = std::max(options.msaaSampleCount, 0);
+    view->SetBackgroundColor(QtGuiUtils::toPreferredColorSpace(options.backgroundColor));
+
+    // Window is never shown, it only provides the GL context. Rendering is done by ToPixMap()
+    // into an offscreen framebuffer of the requested size
+    if (!m_window) {
+        m_window = std::make_unique<QWindow>();
+        m_window->setBaseSize(options.size);
+        m_window->create();
+    }
+
+    Handle_Aspect_NeutralWindow hWnd = new Aspect_NeutralWindow;
+    hWnd->SetSize(options.size.width(), options.size.height());
+    hWnd->SetNativeHandle(Aspect_Drawable(m_window->winId()));
+    hWnd->SetVirtual(true);
+    view->SetWindow(hWnd);
+
+    if (options.viewOrientation)
+        view->SetProj(options.viewOrientation.value());
+
+    GraphicsUtils::V3dView_fitAll(view);
+    return view;
+}
+
+std::optional<V3d_TypeOfOrientation> GuiOffscreenRenderer::viewOrientationFromName(std::string_view name)
+{
+    if (name == "iso")
+        return V3d_XposYnegZpos;
+    else if (name == "front")
+        return V3d_Yneg;
+    else if (name == "back")
+        return V3d_Ypos;
+    else if (name == "left")
+        return V3d_Xneg;
+    else if (name == "right")
+        return V3d_Xpos;
+    else if (name == "top")
+        return V3d_Zpos;
+    else if (name == "bottom")
+        return V3d_Zneg;
+
+    return {};
+}
+
+} // namespace Mayo
@@ -0,0 +1,59 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QSize>
+#include <QtGui/QColor>
+#include <QtGui/QImage>
+#include <V3d_TypeOfOrientation.hxx>
+#include <V3d_View.hxx>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+class QWindow;
+
+namespace Mayo {
+
+class GuiDocument;
+
+// Renders the graphics scene of documents into images, no window is shown
+// A single hidden window provides the GL context, it's kept for all the renderings done by the
+// same renderer(eg thumbnails, CLI batch rendering). As documents share the graphic driver of
+// GuiApplication, GPU resources are also reused from one rendering to the other
+// Note: must be used in the GUI thread, QGuiApplication is required
+class GuiOffscreenRenderer {
+public:
+    struct Options {
+        QSize size = { 800, 600 };
+        QColor backgroundColor = Qt::white;
+        // Camera orientation, the view is then fitted to all visible objects
+        // If empty then default orientation of the viewer is used
+        std::optional<V3d_TypeOfOrientation> viewOrientation;
+        int msaaSampleCount = 4; // Antialiasing is disabled if <= 0
+    };
+
+    GuiOffscreenRenderer();
+    ~GuiOffscreenRenderer();
+
+    // Render objects of 'guiDoc' with a view created for the occasion, returns null image on error
+    // Selection is cleared and trihedrons are hidden during rendering, they are restored afterwards
+    QImage render(GuiDocument* guiDoc, const Options& options);
+
+    // Create a view of 'guiDoc' attached to the hidden window, configured with 'options' and fitted
+    // to all visible objects. Can be used to render multiple frames(eg benchmark)
+    // Note: caller has to call V3d_Viewer::SetViewOff() when done with the view
+    opencascade::handle<V3d_View> createView(GuiDocument* guiDoc, const Options& options);
+
+    // Standard orientation from name("iso", "front", "back", "left", "right", "top" or "bottom")
+    static std::optional<V3d_TypeOfOrientation> viewOrientationFromName(std::string_view name);
+
+private:
+    std::unique_ptr<QWindow> m_window;
+};
+
+} // namespace Mayo
@@ -143,6 +143,13 @@ QSize screenPixelSize(double widthRatio, double heightRatio, const QScreen* scre
                  QtGuiUtils::screenPixelHeight(heightRatio, screen));
 }
 
+int screenFrameInterval(const QScreen* screen)
+{
+    screen = !screen ? QGuiApplication::primaryScreen() : screen;
+    const double refreshRate = screen ? screen->refreshRate() : 60.;
+    return refreshRate > 1. ? int(std::floor(1000. / refreshRate)) : 16;
+}
+
 FontChange::FontChange(const QFont& font)
     : m_font(font)
 {}
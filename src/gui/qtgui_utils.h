@@ -49,6 +49,9 @@ int screenPixelWidth(double screenRatio, const QScreen* screen = nullptr);
 int screenPixelHeight(double screenRatio, const QScreen* screen = nullptr);
 QSize screenPixelSize(double widthRatio, double heightRatio, const QScreen* screen = nullptr);
 
+// Returns duration in milliseconds of a display frame, based on 'screen' refresh rate
+int screenFrameInterval(const QScreen* screen = nullptr);
+
 // Fluent-like helper to change font properties
 class FontChange {
 public:
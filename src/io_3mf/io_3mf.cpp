@@ -0,0 +1,38 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_3mf.h"
+
+#include "io_3mf_writer.h"
+
+namespace Mayo {
+namespace IO {
+
+Span<const Format> ThreeMfFactoryWriter::formats() const
+{
+    static const Format array[] = { Format_3MF };
+    return array;
+}
+
+std::unique_ptr<Writer> ThreeMfFactoryWriter::create(const Format& format) const
+{
+    if (format == Format_3MF)
+        return std::make_unique<ThreeMfWriter>();
+
+    return {};
+}
+
+std::unique_ptr<PropertyGroup>
+ThreeMfFactoryWriter::createProperties(const Format& format, PropertyGroup* parentGroup) const
+{
+    if (format == Format_3MF)
+        return ThreeMfWriter::createProperties(parentGroup);
+
+    return {};
+}
+
+} // namespace IO
+} // namespace Mayo
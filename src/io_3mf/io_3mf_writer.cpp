@@ -0,0 +1,516 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_3mf_writer.h"
+
+#include "../base/async_file_stream.h"
+#include "../base/cpp_utils.h"
+#include "../base/global.h"
+#include "../base/property_builtins.h"
+#include "../base/string_utils.h"
+#include "../base/task_progress.h"
+
+#include <QtCore/QDateTime>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+const char ThreeMfContentTypesXml[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">\n"
+        " <Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>\n"
+        " <Default Extension=\"model\" ContentType=\"application/vnd.ms-package.3dmanufacturing-3dmodel+xml\"/>\n"
+        "</Types>\n";
+
+const char ThreeMfRelationshipsXml[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">\n"
+        " <Relationship Target=\"/3D/3dmodel.model\" Id=\"rel0\""
+        " Type=\"http://schemas.microsoft.com/3dmanufacturing/2013/01/3dmodel\"/>\n"
+        "</Relationships>\n";
+
+// Resource id of the base materials group, objects get ids following it
+constexpr int ThreeMfBaseMaterialsId = 1;
+
+int threeMfObjectId(int objectId)
+{
+    return ThreeMfBaseMaterialsId + 1 + objectId;
+}
+
+std::string xmlEscaped(std::string_view str)
+{
+    std::string result;
+    result.reserve(str.size());
+    for (char c : str) {
+        switch (c) {
+        case '&': result += "&amp;"; break;
+        case '<': result += "&lt;"; break;
+        case '>': result += "&gt;"; break;
+        case '"': result += "&quot;"; break;
+        case '\'': result += "&apos;"; break;
+        default: result += c;
+        }
+    }
+
+    return result;
+}
+
+// Not to be used with floating point numbers, decimal point of printf() depends on C locale while
+// 3MF requires '.', see StringUtils::appendNumber()
+template<typename... ARGS>
+void appendFormatted(std::string* ptrStr, const char* format, ARGS... args)
+{
+    char buffer[256];
+    const int len = std::snprintf(buffer, sizeof(buffer), format, args...);
+    ptrStr->append(buffer, std::clamp(len, 0, int(sizeof(buffer)) - 1));
+}
+
+// Piece of the data of a zip entry, compressed independently so chunks can be compressed
+// concurrently
+// Chunks are raw deflate streams flushed to a byte boundary(Z_SYNC_FLUSH), only the last one of
+// an entry is ended(Z_FINISH). Hence the concatenation of chunks is a valid deflate stream
+struct ZipChunk {
+    std::string data; // Compressed
+    uint32_t crc = 0; // CRC-32 of the uncompressed data
+    uint64_t uncompressedSize = 0;
+    bool ok = true;
+};
+
+ZipChunk zipCompressChunk(std::string_view data, int level, bool isLast)
+{
+    ZipChunk chunk;
+    chunk.crc = crc32(0, reinterpret_cast<const Bytef*>(data.data()), uInt(data.size()));
+    chunk.uncompressedSize = data.size();
+    if (level <= 0) { // Stored
+        chunk.data = data;
+        return chunk;
+    }
+
+    z_stream zs = {};
+    if (deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        chunk.ok = false;
+        return chunk;
+    }
+
+    // Extra bytes for the empty stored block appended by Z_SYNC_FLUSH
+    chunk.data.resize(deflateBound(&zs, uLong(data.size())) + 16);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = uInt(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(chunk.data.data());
+    zs.avail_out = uInt(chunk.data.size());
+    const int ret = deflate(&zs, isLast ? Z_FINISH : Z_SYNC_FLUSH);
+    chunk.ok = isLast ? ret == Z_STREAM_END : (ret == Z_OK && zs.avail_in == 0);
+    chunk.data.resize(chunk.data.size() - zs.avail_out);
+    deflateEnd(&zs);
+    return chunk;
+}
+
+// Zip entry made of chunks, in sequence
+struct ZipEntry {
+    std::string name;
+    uint16_t method = 0; // 0: stored, 8: deflated
+    uint32_t crc = 0;
+    uint64_t compressedSize = 0;
+    uint64_t uncompressedSize = 0;
+    std::vector<ZipChunk> vecChunk;
+    bool ok = true;
+
+    ZipEntry(std::string_view entryName, int level)
+        : name(entryName), method(level > 0 ? 8 : 0)
+    {}
+
+    void addChunk(ZipChunk&& chunk) {
+        this->crc = crc32_combine(this->crc, chunk.crc, z_off_t(chunk.uncompressedSize));
+        this->compressedSize += chunk.data.size();
+        this->uncompressedSize += chunk.uncompressedSize;
+        this->ok = this->ok && chunk.ok;
+        this->vecChunk.push_back(std::move(chunk));
+    }
+};
+
+// Sequential writer of zip archive, seeking isn't required as entries are fully compressed
+// before being written
+// ZIP64 extensions aren't supported, so archive size is limited to 4GiB
+class ZipWriter {
+public:
+    ZipWriter(std::ostream& ostr)
+        : m_ostr(ostr)
+    {
+        const QDateTime dateTime = QDateTime::currentDateTime();
+        const QDate date = dateTime.date();
+        const QTime time = dateTime.time();
+        m_dosDate = uint16_t(((std::max(date.year(), 1980) - 1980) << 9) | (date.month() << 5) | date.day());
+        m_dosTime = uint16_t((time.hour() << 11) | (time.minute() << 5) | (time.second() / 2));
+    }
+
+    bool addEntry(const ZipEntry& entry)
+    {
+        constexpr uint64_t maxSize = 0xFFFFFFFF;
+        if (!entry.ok
+                || entry.compressedSize > maxSize
+                || entry.uncompressedSize > maxSize
+                || m_offset + entry.compressedSize > maxSize)
+        {
+            return false;
+        }
+
+        CentralRecord record;
+        record.entryName = entry.name;
+        record.method = entry.method;
+        record.crc = entry.crc;
+        record.compressedSize = uint32_t(entry.compressedSize);
+        record.uncompressedSize = uint32_t(entry.uncompressedSize);
+        record.localHeaderOffset = uint32_t(m_offset);
+
+        std::string header;
+        appendLe32(&header, 0x04034b50);
+        appendLe16(&header, 20); // Version needed to extract
+        appendLe16(&header, 0); // Flags
+        this->appendCommonFields(&header, record);
+        appendLe16(&header, 0); // Extra field length
+        header += entry.name;
+        this->writeBytes(header);
+        for (const ZipChunk& chunk : entry.vecChunk)
+            this->writeBytes(chunk.data);
+
+        m_vecRecord.push_back(std::move(record));
+        return m_ostr.good();
+    }
+
+    // Writes central directory
+    bool finish()
+    {
+        const uint64_t centralDirOffset = m_offset;
+        for (const CentralRecord& record : m_vecRecord) {
+            std::string header;
+            appendLe32(&header, 0x02014b50);
+            appendLe16(&header, 20); // Version made by
+            appendLe16(&header, 20); // Version needed to extract
+            appendLe16(&header, 0); // Flags
+            this->appendCommonFields(&header, record);
+            appendLe16(&header, 0); // Extra field length
+            appendLe16(&header, 0); // File comment length
+            appendLe16(&header, 0); // Disk number start
+            appendLe16(&header, 0); // Internal file attributes
+            appendLe32(&header, 0); // External file attributes
+            appendLe32(&header, record.localHeaderOffset);
+            header += record.entryName;
+            this->writeBytes(header);
+        }
+
+        const uint64_t centralDirSize = m_offset - centralDirOffset;
+        if (m_offset > 0xFFFFFFFF)
+            return false;
+
+        std::string endRecord;
+        appendLe32(&endRecord, 0x06054b50);
+        appendLe16(&endRecord, 0); // Number of this disk
+        appendLe16(&endRecord, 0); // Disk where central directory starts
+        appendLe16(&endRecord, uint16_t(m_vecRecord.size()));
+        appendLe16(&endRecord, uint16_t(m_vecRecord.size()));
+        appendLe32(&endRecord, uint32_t(centralDirSize));
+        appendLe32(&endRecord, uint32_t(centralDirOffset));
+        appendLe16(&endRecord, 0); // Comment length
+        this->writeBytes(endRecord);
+        m_ostr.flush();
+        return m_ostr.good();
+    }
+
+private:
+    struct CentralRecord {
+        std::string entryName;
+        uint16_t method = 0;
+        uint32_t crc = 0;
+        uint32_t compressedSize = 0;
+        uint32_t uncompressedSize = 0;
+        uint32_t localHeaderOffset = 0;
+    };
+
+    static void appendLe16(std::string* ptrBytes, uint16_t value) {
+        ptrBytes->push_back(char(value & 0xFF));
+        ptrBytes->push_back(char(value >> 8));
+    }
+
+    static void appendLe32(std::string* ptrBytes, uint32_t value) {
+        appendLe16(ptrBytes, uint16_t(value & 0xFFFF));
+        appendLe16(ptrBytes, uint16_t(value >> 16));
+    }
+
+    // Fields from "compression method" to "file name length", shared by local and central headers
+    void appendCommonFields(std::string* ptrBytes, const CentralRecord& record) const {
+        appendLe16(ptrBytes, record.method);
+        appendLe16(ptrBytes, m_dosTime);
+        appendLe16(ptrBytes, m_dosDate);
+        appendLe32(ptrBytes, record.crc);
+        appendLe32(ptrBytes, record.compressedSize);
+        appendLe32(ptrBytes, record.uncompressedSize);
+        appendLe16(ptrBytes, uint16_t(record.entryName.size()));
+    }
+
+    void writeBytes(std::string_view bytes) {
+        m_ostr.write(bytes.data(), std::streamsize(bytes.size()));
+        m_offset += bytes.size();
+    }
+
+    std::ostream& m_ostr;
+    uint64_t m_offset = 0;
+    uint16_t m_dosDate = 0;
+    uint16_t m_dosTime = 0;
+    std::vector<CentralRecord> m_vecRecord;
+};
+
+// Key to merge coincident mesh nodes, coordinates are compared exactly
+using NodeKey = std::array<double, 3>;
+
+struct NodeKeyHash {
+    size_t operator()(const NodeKey& key) const {
+        const std::hash<double> hasher;
+        size_t seed = hasher(key[0]);
+        for (int i = 1; i < 3; ++i)
+            seed ^= hasher(key[i]) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+
+        return seed;
+    }
+};
+
+} // namespace
+
+class ThreeMfWriter::Properties : public PropertyGroup {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::ThreeMfWriter::Properties)
+public:
+    Properties(PropertyGroup* parentGroup)
+        : PropertyGroup(parentGroup)
+    {
+        this->zlibCompressionLevel.setConstraintsEnabled(true);
+        this->zlibCompressionLevel.setRange(0, 9);
+        this->zlibCompressionLevel.setDescription(
+                    textIdTr("Compression level of the 3MF package entries, from 0(no compression) to "
+                             "9(best size)"));
+
+        this->float64Precision.setConstraintsEnabled(true);
+        this->float64Precision.setRange(1, 17);
+        this->float64Precision.setDescription(
+                    textIdTr("Maximum number of significant digits when writting vertex coordinates"));
+    }
+
+    void restoreDefaults() override {
+        const ThreeMfWriter::Parameters params;
+        this->zlibCompressionLevel.setValue(params.zlibCompressionLevel);
+        this->float64Precision.setValue(params.float64Precision);
+    }
+
+    PropertyInt zlibCompressionLevel{ this, textId("zlibCompressionLevel") };
+    PropertyInt float64Precision{ this, textId("float64Precision") };
+};
+
+bool ThreeMfWriter::writeFile(const FilePath& filepath, TaskProgress* progress)
+{
+    // Archive entries are compressed while the previous block is written into the file
+    AsyncFileOutputStream outs(filepath);
+    if (!outs.isOpen())
+        return false;
+
+    const bool okWrite = this->write(outs, progress);
+    return outs.close() && okWrite;
+}
+
+bool ThreeMfWriter::writeStream(std::ostream& ostr, TaskProgress* progress)
+{
+    return this->write(ostr, progress);
+}
+
+std::unique_ptr<PropertyGroup> ThreeMfWriter::createProperties(PropertyGroup* parentGroup)
+{
+    return std::make_unique<Properties>(parentGroup);
+}
+
+void ThreeMfWriter::applyProperties(const PropertyGroup* group)
+{
+    auto ptr = dynamic_cast<const Properties*>(group);
+    if (ptr) {
+        m_params.zlibCompressionLevel = ptr->zlibCompressionLevel;
+        m_params.float64Precision = ptr->float64Precision;
+    }
+}
+
+bool ThreeMfWriter::write(std::ostream& ostr, TaskProgress* progress)
+{
+    const int level = std::clamp(m_params.zlibCompressionLevel, 0, 9);
+    ZipWriter zip(ostr);
+    auto fnAddEntry = [&](std::string_view name, std::string_view data) {
+        ZipEntry entry(name, level);
+        entry.addChunk(zipCompressChunk(data, level, true));
+        return zip.addEntry(entry);
+    };
+    if (!fnAddEntry("[Content_Types].xml", ThreeMfContentTypesXml)
+            || !fnAddEntry("_rels/.rels", ThreeMfRelationshipsXml))
+    {
+        return false;
+    }
+
+    // Model part starts with the base materials
+    std::string modelHead =
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<model unit=\"millimeter\" xml:lang=\"en-US\""
+            " xmlns=\"http://schemas.microsoft.com/3dmanufacturing/core/2015/02\">\n"
+            " <metadata name=\"Application\">Mayo</metadata>\n"
+            " <resources>\n";
+    appendFormatted(&modelHead, "  <basematerials id=\"%d\">\n", ThreeMfBaseMaterialsId);
+    for (const Material& material : m_vecMaterial) {
+        appendFormatted(
+                    &modelHead,
+                    "   <base name=\"Material%d\" displaycolor=\"#%02X%02X%02X\"/>\n",
+                    material.id,
+                    qRound(material.color.Red() * 255),
+                    qRound(material.color.Green() * 255),
+                    qRound(material.color.Blue() * 255));
+    }
+
+    modelHead += "  </basematerials>\n";
+
+    // Objects are independent, their XML is generated and compressed concurrently
+    const int objectCount = int(m_vecObject.size());
+    std::vector<ZipChunk> vecObjectChunk(objectCount);
+    std::atomic<int> doneCount = 0;
+    std::mutex mutexProgress;
+    CppUtils::parallelFor(objectCount, [&](int i) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        vecObjectChunk.at(i) = zipCompressChunk(this->objectXml(m_vecObject.at(i)), level, false);
+        const int count = ++doneCount;
+        if (progress) {
+            std::lock_guard<std::mutex> lock(mutexProgress);
+            MAYO_UNUSED(lock);
+            const int pct = (count * 90) / objectCount;
+            if (pct > progress->value())
+                progress->setValue(pct);
+        }
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
+    // Build items, objects without instance(eg free shapes at tree root) are placed as is
+    std::string modelTail = " </resources>\n <build>\n";
+    std::vector<bool> vecObjectInstantiated(objectCount, false);
+    for (const Instance& instance : m_vecInstance) {
+        vecObjectInstantiated.at(instance.objectId) = true;
+        // 3MF matrix is applied to row vectors [x y z 1], so it's the transpose of gp_Trsf
+        const gp_Trsf& trsf = instance.trsf;
+        appendFormatted(&modelTail, "  <item objectid=\"%d\" transform=\"", threeMfObjectId(instance.objectId));
+        for (int col = 1; col <= 4; ++col) {
+            for (int row = 1; row <= 3; ++row) {
+                if (col != 1 || row != 1)
+                    modelTail += ' ';
+
+                StringUtils::appendNumber(
+                            &modelTail, trsf.Value(row, col), std::chars_format::general, m_params.float64Precision);
+            }
+        }
+
+        modelTail += "\"/>\n";
+    }
+
+    for (int i = 0; i < objectCount; ++i) {
+        if (!vecObjectInstantiated.at(i))
+            appendFormatted(&modelTail, "  <item objectid=\"%d\"/>\n", threeMfObjectId(i));
+    }
+
+    modelTail += " </build>\n</model>\n";
+
+    ZipEntry entryModel("3D/3dmodel.model", level);
+    entryModel.addChunk(zipCompressChunk(modelHead, level, false));
+    for (ZipChunk& chunk : vecObjectChunk)
+        entryModel.addChunk(std::move(chunk));
+
+    entryModel.addChunk(zipCompressChunk(modelTail, level, true));
+    const bool ok = zip.addEntry(entryModel) && zip.finish();
+    if (progress)
+        progress->setValue(100);
+
+    return ok;
+}
+
+std::string ThreeMfWriter::objectXml(const Object& object) const
+{
+    std::string xml;
+    appendFormatted(&xml, "  <object id=\"%d\" type=\"model\"", threeMfObjectId(object.id));
+    if (!object.name.empty())
+        xml += " name=\"" + xmlEscaped(object.name) + "\"";
+
+    if (object.materialId >= 0)
+        appendFormatted(&xml, " pid=\"%d\" pindex=\"%d\"", ThreeMfBaseMaterialsId, object.materialId);
+
+    xml += ">\n   <mesh>\n    <vertices>\n";
+
+    // Triangulations of the faces are merged in a single mesh, nodes shared by adjacent faces
+    // are written once
+    std::string xmlTriangles;
+    std::unordered_map<NodeKey, int, NodeKeyHash> mapNodeIndex;
+    std::vector<int> vecNodeIndex;
+    const int precision = m_params.float64Precision;
+    for (int meshId = object.firstMeshId; meshId <= object.lastMeshId; ++meshId) {
+        const Mesh& mesh = m_vecMesh.at(meshId);
+        const gp_Trsf& trsf = mesh.location.Transformation();
+        const int nodeCount = mesh.triangulation->NbNodes();
+        vecNodeIndex.resize(nodeCount);
+        for (int i = 1; i <= nodeCount; ++i) {
+            const gp_Pnt pnt = mesh.triangulation->Node(i).Transformed(trsf);
+            auto [it, isNew] = mapNodeIndex.insert({ { pnt.X(), pnt.Y(), pnt.Z() }, int(mapNodeIndex.size()) });
+            if (isNew) {
+                xml += "     <vertex x=\"";
+                StringUtils::appendNumber(&xml, pnt.X(), std::chars_format::general, precision);
+                xml += "\" y=\"";
+                StringUtils::appendNumber(&xml, pnt.Y(), std::chars_format::general, precision);
+                xml += "\" z=\"";
+                StringUtils::appendNumber(&xml, pnt.Z(), std::chars_format::general, precision);
+                xml += "\"/>\n";
+            }
+
+            vecNodeIndex.at(i - 1) = it->second;
+        }
+
+        const int triangleCount = mesh.triangulation->NbTriangles();
+        for (int i = 1; i <= triangleCount; ++i) {
+            int n1, n2, n3;
+            mesh.triangulation->Triangle(i).Get(n1, n2, n3);
+            if (mesh.isReversed)
+                std::swap(n2, n3);
+
+            const int v1 = vecNodeIndex.at(n1 - 1);
+            const int v2 = vecNodeIndex.at(n2 - 1);
+            const int v3 = vecNodeIndex.at(n3 - 1);
+            // Degenerated triangles are forbidden by 3MF specification
+            if (v1 != v2 && v2 != v3 && v1 != v3)
+                appendFormatted(&xmlTriangles, "     <triangle v1=\"%d\" v2=\"%d\" v3=\"%d\"/>\n", v1, v2, v3);
+        }
+    }
+
+    xml += "    </vertices>\n    <triangles>\n";
+    xml += xmlTriangles;
+    xml += "    </triangles>\n   </mesh>\n  </object>\n";
+    return xml;
+}
+
+} // namespace IO
+} // namespace Mayo
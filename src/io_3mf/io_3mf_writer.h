@@ -0,0 +1,50 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/io_mesh_instances_writer.h"
+
+#include <string>
+
+namespace Mayo {
+namespace IO {
+
+// Native writer for 3MF format(core specification v1.2.3), requires zlib
+// Each object gets a single mesh merging the triangulations of its faces, coincident nodes being
+// shared. Objects and base materials are written in the "3D/3dmodel.model" part, instances as
+// build items
+// XML of the objects is generated and deflate-compressed concurrently, the compressed chunks are
+// then written sequentially as a single zip entry
+class ThreeMfWriter : public MeshInstancesWriter {
+public:
+    bool writeFile(const FilePath& filepath, TaskProgress* progress) override;
+    bool writeStream(std::ostream& ostr, TaskProgress* progress) override;
+
+    static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
+    void applyProperties(const PropertyGroup* group) override;
+
+    // Parameters
+
+    struct Parameters {
+        int zlibCompressionLevel = 6; // 0: no compression, 1: best speed, 9: best size
+        int float64Precision = 9; // Maximum number of significant digits of coordinates
+    };
+    Parameters& parameters() { return m_params; }
+    const Parameters& constParameters() const { return m_params; }
+
+private:
+    bool write(std::ostream& ostr, TaskProgress* progress);
+
+    // XML element <object> of 'object', with its mesh
+    std::string objectXml(const Object& object) const;
+
+    class Properties;
+    Parameters m_params;
+};
+
+} // namespace IO
+} // namespace Mayo
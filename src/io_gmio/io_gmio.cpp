@@ -7,13 +7,37 @@
 #include "io_gmio.h"
 
 #include "io_gmio_amf_writer.h"
+#include "io_gmio_stl.h"
 
 namespace Mayo {
 namespace IO {
 
+Span<const Format> GmioFactoryReader::formats() const
+{
+    static const Format array[] = { Format_STL };
+    return array;
+}
+
+std::unique_ptr<Reader> GmioFactoryReader::create(const Format& format) const
+{
+    if (format == Format_STL)
+        return std::make_unique<GmioStlReader>();
+
+    return {};
+}
+
+std::unique_ptr<PropertyGroup>
+GmioFactoryReader::createProperties(const Format& format, PropertyGroup* parentGroup) const
+{
+    if (format == Format_STL)
+        return GmioStlReader::createProperties(parentGroup);
+
+    return {};
+}
+
 Span<const Format> GmioFactoryWriter::formats() const
 {
-    static const Format array[] = { Format_AMF };
+    static const Format array[] = { Format_AMF, Format_STL };
     return array;
 }
 
@@ -22,6 +46,9 @@ std::unique_ptr<Writer> GmioFactoryWriter::create(const Format& format) const
     if (format == Format_AMF)
         return std::make_unique<GmioAmfWriter>();
 
+    if (format == Format_STL)
+        return std::make_unique<GmioStlWriter>();
+
     return {};
 }
 
@@ -31,6 +58,9 @@ GmioFactoryWriter::createProperties(const Format& format, PropertyGroup* parentG
     if (format == Format_AMF)
         return GmioAmfWriter::createProperties(parentGroup);
 
+    if (format == Format_STL)
+        return GmioStlWriter::createProperties(parentGroup);
+
     return {};
 }
 
@@ -5,11 +5,11 @@
 ****************************************************************************/
 
 #include "io_gmio_amf_writer.h"
+#include "io_gmio_utils.h"
 
-#include "../base/application_item.h"
-#include "../base/brep_utils.h"
-#include "../base/caf_utils.h"
-#include "../base/math_utils.h"
+#include "../base/async_file_stream.h"
+#include "../base/cpp_utils.h"
+#include "../base/mesh_utils.h"
 #include "../base/meta_enum.h"
 #include "../base/property_builtins.h"
 #include "../base/property_enumeration.h"
@@ -17,107 +17,22 @@
 #include "../base/unit_system.h"
 #include "../base/xcaf.h"
 
-#include <BRep_Tool.hxx>
 #include <Poly_Triangulation.hxx>
-#include <TDataXtd_Triangulation.hxx>
 #include <gp_Quaternion.hxx>
 
 #include <gmio_amf/amf_error.h>
 #include <gmio_amf/amf_io.h>
 #include <gmio_core/error.h>
+#include <gmio_core/stream.h>
 #include <gmio_stl/stl_error.h>
 
-#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <ostream>
 
 namespace Mayo {
 namespace IO {
 
-namespace {
-
-bool gmio_taskIsStopRequested(void* cookie)
-{
-    auto progress = static_cast<const TaskProgress*>(cookie);
-    return progress ? progress->isAbortRequested() : false;
-}
-
-void gmio_handleProgress(void* cookie, intmax_t value, intmax_t maxValue)
-{
-    auto progress = static_cast<TaskProgress*>(cookie);
-    if (progress && maxValue > 0) {
-        const auto pctNorm = value / double(maxValue);
-        const auto pct = qRound(pctNorm * 100);
-        progress->setValue(pct);
-    }
-}
-
-gmio_task_iface gmio_createTask(TaskProgress* progress)
-{
-    gmio_task_iface task = {};
-    task.cookie = progress;
-    task.func_is_stop_requested = gmio_taskIsStopRequested;
-    task.func_handle_progress = gmio_handleProgress;
-    return task;
-}
-
-//#ifdef HAVE_GMIO
-#if 0
-Format System::probeFormat(const QString& filepath) const
-{
-    QFile file(filepath);
-    if (file.open(QIODevice::ReadOnly)) {
-//#ifdef HAVE_GMIO
-        gmio_stream qtstream = gmio_stream_qiodevice(&file);
-       const gmio_stl_format stlFormat = gmio_stl_format_probe(&qtstream);
-        if (stlFormat != GMIO_STL_FORMAT_UNKNOWN)
-            return Format_STL;
-//#endif
-}
-
-IO::Result IO::exportStl_gmio(ExportData data)
-{
-    QFile file(data.filepath);
-    if (file.open(QIODevice::WriteOnly)) {
-        gmio_stream stream = gmio_stream_qiodevice(&file);
-        gmio_stl_write_options gmioOptions = {};
-        gmioOptions.stla_float32_format = options.stlaFloat32Format;
-        gmioOptions.stla_float32_prec = options.stlaFloat32Precision;
-        gmioOptions.stla_solid_name = options.stlaSolidName.c_str();
-        gmioOptions.task_iface = Internal::gmio_qttask_create_task_iface(progress);
-        for (const DocumentItem* item : docItems) {
-            if (progress) {
-                progress->setStep(
-                            QString("Writing item %1")
-                            .arg(item->propertyLabel.value()));
-            }
-
-            int error = GMIO_ERROR_OK;
-            if (sameType<XdeDocumentItem>(item)) {
-                auto xdeDocItem = static_cast<const XdeDocumentItem*>(item);
-                const TopoDS_Shape shape = Internal::xdeDocumentWholeShape(xdeDocItem);
-                const gmio_stl_mesh_occshape gmioMesh(shape);
-                error = gmio_stl_write(
-                            options.stlFormat, &stream, &gmioMesh, &gmioOptions);
-            }
-            else if (sameType<MeshItem>(item)) {
-                auto meshItem = static_cast<const MeshItem*>(item);
-                const gmio_stl_mesh_occpolytri gmioMesh(meshItem->triangulation());
-                error = gmio_stl_write(
-                            options.stlFormat, &stream, &gmioMesh, &gmioOptions);
-            }
-
-            if (error != GMIO_ERROR_OK)
-                return IoResult::error(Internal::gmioErrorToQString(error));
-        }
-
-        return IoResult::ok();
-    }
-
-    return Result::error(file.errorString());
-}
-#endif // HAVE_GMIO
-
-} // namespace
-
 class GmioAmfWriter::Properties : public PropertyGroup {
     MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::GmioAmfWriter::Properties)
 public:
@@ -148,6 +63,21 @@ public:
         this->useZip64.setDescription(
                     textIdTr("Use the ZIP64 format extensions.\n"
                              "Only applicable if option `%1` is on").arg(this->createZipArchive.label()));
+
+        this->optimizeVertexCache.setDescription(
+                    textIdTr("Reorder mesh triangles and vertices for vertex cache locality, so exported "
+                             "meshes render faster in GPU-based viewers"));
+
+        this->zlibCompressionLevel.setConstraintsEnabled(true);
+        this->zlibCompressionLevel.setRange(0, 9);
+        this->zlibCompressionLevel.setDescription(
+                    textIdTr("Compression level of the ZIP entry, from 0(no compression) to 9(best size).\n"
+                             "Only applicable if option `%1` is on").arg(this->createZipArchive.label()));
+
+        this->zlibCompressionStrategy.mutableEnumeration().changeTrContext(this->textIdContext());
+        this->zlibCompressionStrategy.setDescription(
+                    textIdTr("Strategy used to tune the compression algorithm of the ZIP entry.\n"
+                             "Only applicable if option `%1` is on").arg(this->createZipArchive.label()));
     }
 
     void restoreDefaults() override {
@@ -157,9 +87,14 @@ public:
         this->createZipArchive.setValue(params.createZipArchive);
         this->zipEntryFilename.setValue(QString::fromStdString(params.zipEntryFilename));
         this->useZip64.setValue(params.useZip64);
+        this->zlibCompressionLevel.setValue(params.zlibCompressionLevel);
+        this->zlibCompressionStrategy.setValue(params.zlibCompressionStrategy);
+        this->optimizeVertexCache.setValue(params.optimizeVertexCache);
 
         this->zipEntryFilename.setEnabled(this->createZipArchive);
         this->useZip64.setEnabled(this->createZipArchive);
+        this->zlibCompressionLevel.setEnabled(this->createZipArchive);
+        this->zlibCompressionStrategy.setEnabled(this->createZipArchive);
     }
 
     void onPropertyChanged(Property* prop) override
@@ -167,6 +102,8 @@ public:
         if (prop == &this->createZipArchive) {
             this->zipEntryFilename.setEnabled(this->createZipArchive);
             this->useZip64.setEnabled(this->createZipArchive);
+            this->zlibCompressionLevel.setEnabled(this->createZipArchive);
+            this->zlibCompressionStrategy.setEnabled(this->createZipArchive);
         }
 
         PropertyGroup::onPropertyChanged(prop);
@@ -177,79 +114,58 @@ public:
     PropertyBool createZipArchive{ this, textId("createZipArchive") };
     PropertyQString zipEntryFilename{ this, textId("zipEntryFilename") };
     PropertyBool useZip64{ this, textId("useZip64") };
+    PropertyBool optimizeVertexCache{ this, textId("optimizeVertexCache") };
+    PropertyInt zlibCompressionLevel{ this, textId("zlibCompressionLevel") };
+    PropertyEnum<GmioAmfWriter::ZlibCompressionStrategy> zlibCompressionStrategy{ this, textId("zlibCompressionStrategy") };
 };
 
 bool GmioAmfWriter::transfer(Span<const ApplicationItem> spanAppItem, TaskProgress* progress)
 {
-    m_vecMaterial.clear();
-    m_vecMesh.clear();
-    m_vecObject.clear();
-    m_vecInstance.clear();
-
-    Material defaultMaterial = {};
-    defaultMaterial.id = 0;
-    defaultMaterial.color.SetValues(Quantity_NOC_WHITE);
-    defaultMaterial.isColor = true;
-    m_vecMaterial.push_back(std::move(defaultMaterial));
-
-    std::unordered_map<TDF_Label, int> mapLabelObjectId;
-    auto fnFindObjectId = [&](const TDF_Label& label) {
-        auto it = mapLabelObjectId.find(label);
-        return it != mapLabelObjectId.cend() ? it->second : -1;
-    };
-    auto fnCreateObject = [&](const Tree<TDF_Label>& modelTree, TreeNodeId id) {
-        const TDF_Label nodeLabel = modelTree.nodeData(id);
-        if (modelTree.nodeIsLeaf(id)) {
-            int objectId = fnFindObjectId(nodeLabel);
-            if (objectId == -1) {
-                objectId = this->createObject(nodeLabel);
-                if (objectId == -1)
-                    return;
-
-                mapLabelObjectId.insert({ nodeLabel, objectId });
-            }
-
-            QStringList absoluteName;
-            TreeNodeId itParent = id;
-            do {
-                itParent = modelTree.nodeParent(itParent);
-                if (itParent != 0) {
-                    const QString name = CafUtils::labelAttrStdName(modelTree.nodeData(itParent));
-                    if (!name.trimmed().isEmpty())
-                        absoluteName += name;
-                    else
-                        absoluteName += "anonymous";
-                }
-            } while (itParent != 0);
-
-            if (!absoluteName.isEmpty()) {
-                Instance instance;
-                instance.objectId = objectId;
-                instance.trsf = XCaf::shapeAbsoluteLocation(modelTree, id);
-                instance.name = absoluteName.join('/').toStdString();
-                m_vecInstance.push_back(std::move(instance));
-            }
-        }
-    };
-
-    for (const ApplicationItem& appItem : spanAppItem) {
-        const int appItemIndex = &appItem - &spanAppItem.front();
-        progress->setValue(MathUtils::mappedValue(appItemIndex, 0, spanAppItem.size() - 1, 0, 100));
-        const Tree<TDF_Label>& modelTree = appItem.document()->modelTree();
-        if (appItem.isDocument()) {
-            traverseTree(modelTree, [&](TreeNodeId id) { fnCreateObject(modelTree, id); });
-        }
-        else if (appItem.isDocumentTreeNode()) {
-            traverseTree(appItem.documentTreeNode().id(), modelTree, [&](TreeNodeId id) {
-                fnCreateObject(modelTree, id);
-            });
-        }
+    if (!MeshInstancesWriter::transfer(spanAppItem, progress))
+        return false;
+
+    if (m_params.optimizeVertexCache) {
+        // Optimized copies are written, triangulations of the document are left untouched
+        CppUtils::parallelFor(int(m_vecMesh.size()), [&](int i) {
+            Mesh& mesh = m_vecMesh.at(i);
+            mesh.triangulation = MeshUtils::vertexCacheOptimized(mesh.triangulation);
+        });
     }
 
     return true;
 }
 
 bool GmioAmfWriter::writeFile(const FilePath& filepath, TaskProgress* progress)
+{
+    if (m_params.createZipArchive) {
+        return this->write([&](const gmio_amf_document* amfDoc, const gmio_amf_write_options* amfOptions) {
+            return gmio_amf_write_file(filepath.u8string().c_str(), amfDoc, amfOptions);
+        }, progress);
+    }
+
+    AsyncFileOutputStream outs(filepath);
+    if (!outs.isOpen())
+        return false;
+
+    const bool okWrite = this->writeStream(outs, progress);
+    return outs.close() && okWrite;
+}
+
+bool GmioAmfWriter::writeStream(std::ostream& ostr, TaskProgress* progress)
+{
+    // Make no assumption about the ZIP writer of gmio requiring seekable streams
+    if (m_params.createZipArchive)
+        return Writer::writeStream(ostr, progress);
+
+    gmio_stream stream = GmioUtils::ostream(&ostr);
+    const bool okWrite = this->write([&](const gmio_amf_document* amfDoc, const gmio_amf_write_options* amfOptions) {
+        return gmio_amf_write(&stream, amfDoc, amfOptions);
+    }, progress);
+    ostr.flush();
+    return okWrite && ostr.good();
+}
+
+bool GmioAmfWriter::write(const FunctionGmioWrite& fnWrite, TaskProgress* progress)
 {
     gmio_amf_document amfDoc = {};
     amfDoc.cookie = this;
@@ -273,17 +189,23 @@ bool GmioAmfWriter::writeFile(const FilePath& filepath, TaskProgress* progress)
     };
 
     gmio_amf_write_options amfOptions = {};
-    amfOptions.task_iface.cookie = progress;
-    amfOptions.task_iface.func_handle_progress = &gmio_handleProgress;
-    amfOptions.task_iface.func_is_stop_requested = &gmio_taskIsStopRequested;
+    amfOptions.task_iface = GmioUtils::createTask(progress);
     amfOptions.float64_format = fnAmfFloat64Format(m_params.float64Format);
     amfOptions.float64_prec = m_params.float64Precision;
     amfOptions.create_zip_archive = m_params.createZipArchive;
     amfOptions.dont_use_zip64_extensions = !m_params.useZip64;
     amfOptions.zip_entry_filename = m_params.zipEntryFilename.c_str();
     amfOptions.zip_entry_filename_len = m_params.zipEntryFilename.size();
-    // TODO Handle gmio_amf_write_options::z_compress_options
-    const int error = gmio_amf_write_file(filepath.u8string().c_str(), &amfDoc, &amfOptions);
+    // Enumerators of GmioAmfWriter::ZlibCompressionStrategy have the same values as gmio ones
+    using gmio_zlib_level_type = decltype(amfOptions.z_compress_options.level);
+    using gmio_zlib_strategy_type = decltype(amfOptions.z_compress_options.strategy);
+    amfOptions.z_compress_options.level =
+            m_params.zlibCompressionLevel > 0 ?
+                static_cast<gmio_zlib_level_type>(m_params.zlibCompressionLevel) :
+                static_cast<gmio_zlib_level_type>(-1); // -> GMIO_ZLIB_COMPRESS_LEVEL_NONE
+    amfOptions.z_compress_options.strategy =
+            static_cast<gmio_zlib_strategy_type>(m_params.zlibCompressionStrategy);
+    const int error = fnWrite(&amfDoc, &amfOptions);
     return gmio_no_error(error);
 }
 
@@ -301,77 +223,12 @@ void GmioAmfWriter::applyProperties(const PropertyGroup* group)
         m_params.createZipArchive = ptr->createZipArchive;
         m_params.zipEntryFilename = ptr->zipEntryFilename.value().toStdString();
         m_params.useZip64 = ptr->useZip64;
+        m_params.zlibCompressionLevel = ptr->zlibCompressionLevel;
+        m_params.zlibCompressionStrategy = ptr->zlibCompressionStrategy;
+        m_params.optimizeVertexCache = ptr->optimizeVertexCache;
     }
 }
 
-int GmioAmfWriter::createObject(const TDF_Label& labelShape)
-{
-    // Object meshes
-    const int meshCount = int(m_vecMesh.size());
-
-    auto fnAddMesh = [&](const Handle_Poly_Triangulation& polyTri, const TopLoc_Location& loc) {
-        if (!polyTri.IsNull()) {
-            Mesh mesh;
-            mesh.id = int(m_vecMesh.size());
-            mesh.triangulation = polyTri;
-            mesh.location = loc;
-            // TODO mesh.materialId = ?
-            m_vecMesh.push_back(std::move(mesh));
-        }
-    };
-
-    // -- Shape ?
-    const TopoDS_Shape shape = XCaf::shape(labelShape);
-    if (!shape.IsNull()) {
-        BRepUtils::forEachSubFace(shape, [=](const TopoDS_Face& face){
-            TopLoc_Location loc;
-            const Handle_Poly_Triangulation& polyTri = BRep_Tool::Triangulation(face, loc);
-            fnAddMesh(polyTri, loc);
-        });
-    }
-
-    // -- Triangulation ?
-    auto attrPolyTri = CafUtils::findAttribute<TDataXtd_Triangulation>(labelShape);
-    if (!attrPolyTri.IsNull()) {
-        fnAddMesh(attrPolyTri->Get(), TopLoc_Location());
-    }
-
-    if (m_vecMesh.size() == meshCount)
-        return -1;
-
-    // Object material
-    int materialId = -1;
-    DocumentPtr doc = Document::findFrom(labelShape);
-    if (doc && doc->xcaf().hasShapeColor(labelShape)) {
-        const Quantity_Color color = doc->xcaf().shapeColor(labelShape);
-        auto itColor = std::find_if(
-                    m_vecMaterial.cbegin(), m_vecMaterial.cend(), [=](const Material& mat) {
-            return mat.color == color;
-        });
-        if (itColor != m_vecMaterial.cend()) {
-            materialId = itColor - m_vecMaterial.cbegin();
-        }
-        else {
-            materialId = m_vecMaterial.size();
-            Material material;
-            material.id = materialId;
-            material.color = color;
-            material.isColor = true;
-            m_vecMaterial.push_back(std::move(material));
-        }
-    }
-
-    // Add object
-    Object object;
-    object.id = m_vecObject.size();
-    object.firstMeshId = meshCount;
-    object.lastMeshId = m_vecMesh.size() - 1;
-    object.name = CafUtils::labelAttrStdName(labelShape).toStdString();
-    object.materialId = materialId;
-    m_vecObject.push_back(std::move(object));
-    return m_vecObject.back().id;
-}
-
 const GmioAmfWriter* GmioAmfWriter::from(const void* cookie) {
     return static_cast<const GmioAmfWriter*>(cookie);
 }
@@ -6,26 +6,25 @@
 
 #pragma once
 
-#include "../base/document_ptr.h"
-#include "../base/io_writer.h"
-
-#include <Poly_Triangulation.hxx>
-#include <Quantity_Color.hxx>
-#include <TopLoc_Location.hxx>
+#include "../base/io_mesh_instances_writer.h"
 
 #include <gmio_amf/amf_document.h>
+#include <functional>
 #include <string>
-#include <vector>
+
+struct gmio_amf_write_options;
 
 namespace Mayo {
 namespace IO {
 
 // gmio-based writer for AMF format
 // Requires gmio >= v0.4.0
-class GmioAmfWriter : public Writer {
+class GmioAmfWriter : public MeshInstancesWriter {
 public:
     bool transfer(Span<const ApplicationItem> spanAppItem, TaskProgress* progress) override;
     bool writeFile(const FilePath& filepath, TaskProgress* progress) override;
+    // Writes directly into the stream, unless a ZIP archive is created
+    bool writeStream(std::ostream& ostr, TaskProgress* progress) override;
 
     static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
     void applyProperties(const PropertyGroup* group) override;
@@ -38,6 +37,14 @@ public:
         Shortest // -> GMIO_FLOAT_TEXT_FORMAT_SHORTEST_UPPERCASE
     };
 
+    enum class ZlibCompressionStrategy {
+        Default, // -> GMIO_ZLIB_COMPRESSION_STRATEGY_DEFAULT
+        Filtered, // -> GMIO_ZLIB_COMPRESSION_STRATEGY_FILTERED
+        HuffmanOnly, // -> GMIO_ZLIB_COMPRESSION_STRATEGY_HUFFMAN_ONLY
+        Rle, // -> GMIO_ZLIB_COMPRESSION_STRATEGY_RLE
+        Fixed // -> GMIO_ZLIB_COMPRESSION_STRATEGY_FIXED
+    };
+
     struct Parameters {
         // TODO gmio_amf_unit
         FloatTextFormat float64Format = FloatTextFormat::Decimal;
@@ -45,12 +52,18 @@ public:
         bool createZipArchive = false;
         bool useZip64 = true;
         std::string zipEntryFilename; // UTF8
+        int zlibCompressionLevel = 6; // 0: no compression, 1: best speed, 9: best size
+        ZlibCompressionStrategy zlibCompressionStrategy = ZlibCompressionStrategy::Default;
+        // Triangles and vertices of meshes are reordered for GPU vertex cache and fetch locality
+        bool optimizeVertexCache = false;
     };
     Parameters& parameters() { return m_params; }
     const Parameters& constParameters() const { return m_params; }
 
 private:
-    int createObject(const TDF_Label& labelShape);
+    // Prepares the gmio document and options, then calls 'fnWrite' returning a gmio error code
+    using FunctionGmioWrite = std::function<int(const gmio_amf_document*, const gmio_amf_write_options*)>;
+    bool write(const FunctionGmioWrite& fnWrite, TaskProgress* progress);
 
     static const GmioAmfWriter* from(const void* cookie);
 
@@ -90,39 +103,8 @@ private:
             uint32_t instanceIndex,
             struct gmio_amf_instance* ptrInstance);
 
-    struct Instance {
-        int objectId = -1;
-        gp_Trsf trsf;
-        std::string name;
-    };
-
-    struct Material {
-        int id = -1;
-        Quantity_Color color;
-        bool isColor = false;
-    };
-
-    struct Object {
-        int id = -1;
-        int firstMeshId = 0;
-        int lastMeshId = -1;
-        int materialId = -1;
-        std::string name;
-    };
-
-    struct Mesh {
-        int id = -1;
-        Handle_Poly_Triangulation triangulation;
-        TopLoc_Location location;
-        int materialId = -1;
-    };
-
     class Properties;
     Parameters m_params;
-    std::vector<Material> m_vecMaterial;
-    std::vector<Mesh> m_vecMesh;
-    std::vector<Object> m_vecObject;
-    std::vector<Instance> m_vecInstance;
 };
 
 } // namespace IO
@@ -0,0 +1,494 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_gmio_stl.h"
+#include "io_gmio_utils.h"
+
+#include "../base/application_item.h"
+#include "../base/brep_utils.h"
+#include "../base/caf_utils.h"
+#include "../base/document.h"
+#include "../base/mesh_utils.h"
+#include "../base/property_builtins.h"
+#include "../base/task_progress.h"
+#include "../base/tkernel_utils.h"
+#include "../base/unit_system.h"
+#include "../base/xcaf.h"
+
+#include <BRep_Tool.hxx>
+#include <TDataXtd_Triangulation.hxx>
+#include <TopoDS_Face.hxx>
+#include <gp_Vec.hxx>
+#include <TShort_HArray1OfShortReal.hxx>
+
+#include <gmio_core/error.h>
+#include <gmio_stl/stl_format.h>
+#include <gmio_stl/stl_io.h>
+#include <gmio_stl/stl_io_options.h>
+#include <gmio_stl/stl_mesh.h>
+#include <gmio_stl/stl_mesh_creator.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <system_error>
+#include <unordered_map>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+// Facets received from gmio, nodes are merged on the fly unless a "triangle soup" is requested
+class GmioStlMeshBuilder {
+public:
+    GmioStlMeshBuilder(bool mergeNodes) : m_mergeNodes(mergeNodes) {}
+
+    void beginSolid(const gmio_stl_mesh_creator_infos* infos) {
+        if (infos->format == GMIO_STL_FORMAT_BINARY_LE || infos->format == GMIO_STL_FORMAT_BINARY_BE) {
+            m_vecTriangle.reserve(infos->stlb_triangle_count);
+            m_vecNode.reserve(m_mergeNodes ? infos->stlb_triangle_count / 2 : 3 * infos->stlb_triangle_count);
+        }
+    }
+
+    void addTriangle(const gmio_stl_triangle* triangle) {
+        const gmio_vec3f* vertices[] = { &triangle->v1, &triangle->v2, &triangle->v3 };
+        std::array<int, 3> nodes;
+        for (int i = 0; i < 3; ++i)
+            nodes[i] = this->nodeIndex(*vertices[i]);
+
+        if (m_mergeNodes && (nodes[0] == nodes[1] || nodes[1] == nodes[2] || nodes[0] == nodes[2]))
+            return; // Degenerated
+
+        m_vecTriangle.push_back(nodes);
+        if (!m_mergeNodes)
+            m_vecNormal.push_back(triangle->n);
+    }
+
+    Handle_Poly_Triangulation createMesh() const {
+        if (m_vecTriangle.empty())
+            return {};
+
+        const int nodeCount = int(m_vecNode.size());
+        Handle_Poly_Triangulation mesh = new Poly_Triangulation(nodeCount, int(m_vecTriangle.size()), false);
+        TColgp_Array1OfPnt& vecMeshNode = mesh->ChangeNodes();
+        for (int i = 0; i < nodeCount; ++i) {
+            const gmio_vec3f& node = m_vecNode.at(i);
+            vecMeshNode.ChangeValue(i + 1).SetCoord(node.x, node.y, node.z);
+        }
+
+        Poly_Array1OfTriangle& vecMeshTriangle = mesh->ChangeTriangles();
+        for (unsigned i = 0; i < m_vecTriangle.size(); ++i) {
+            const std::array<int, 3>& nodes = m_vecTriangle.at(i);
+            vecMeshTriangle.ChangeValue(int(i) + 1).Set(nodes[0] + 1, nodes[1] + 1, nodes[2] + 1);
+        }
+
+        if (!m_mergeNodes) {
+            // Each node gets the normal of its facet
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+            mesh->AddNormals();
+#else
+            Handle_TShort_HArray1OfShortReal vecMeshNormal = new TShort_HArray1OfShortReal(1, 3 * nodeCount);
+#endif
+            for (int iNode = 1; iNode <= nodeCount; ++iNode) {
+                const gmio_vec3f& n = m_vecNormal.at((iNode - 1) / 3);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+                mesh->SetNormal(iNode, gp_Vec3f(n.x, n.y, n.z));
+#else
+                vecMeshNormal->SetValue((iNode - 1) * 3 + 1, n.x);
+                vecMeshNormal->SetValue((iNode - 1) * 3 + 2, n.y);
+                vecMeshNormal->SetValue((iNode - 1) * 3 + 3, n.z);
+#endif
+            }
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+            mesh->SetNormals(vecMeshNormal);
+#endif
+        }
+
+        return mesh;
+    }
+
+private:
+    struct NodeHash {
+        size_t operator()(const gmio_vec3f& v) const {
+            uint32_t bits[3];
+            std::memcpy(bits, &v.x, sizeof(float));
+            std::memcpy(bits + 1, &v.y, sizeof(float));
+            std::memcpy(bits + 2, &v.z, sizeof(float));
+            return (size_t(bits[0]) * 73856093) ^ (size_t(bits[1]) * 19349663) ^ (size_t(bits[2]) * 83492791);
+        }
+    };
+
+    struct NodeEqual {
+        bool operator()(const gmio_vec3f& lhs, const gmio_vec3f& rhs) const {
+            return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+        }
+    };
+
+    int nodeIndex(const gmio_vec3f& v) {
+        if (m_mergeNodes) {
+            auto itNode = m_mapNodeIndex.find(v);
+            if (itNode != m_mapNodeIndex.cend())
+                return itNode->second;
+
+            m_mapNodeIndex.insert({ v, int(m_vecNode.size()) });
+        }
+
+        m_vecNode.push_back(v);
+        return int(m_vecNode.size()) - 1;
+    }
+
+    bool m_mergeNodes = true;
+    std::vector<gmio_vec3f> m_vecNode;
+    std::vector<gmio_vec3f> m_vecNormal; // Facet normals, only if nodes aren't merged
+    std::vector<std::array<int, 3>> m_vecTriangle;
+    std::unordered_map<gmio_vec3f, int, NodeHash, NodeEqual> m_mapNodeIndex;
+};
+
+gmio_vec3f gmio_toVec3f(const gp_XYZ& coords)
+{
+    return { float(coords.X()), float(coords.Y()), float(coords.Z()) };
+}
+
+} // namespace
+
+class GmioStlReader::Properties : public PropertyGroup {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::GmioStlReader::Properties)
+public:
+    Properties(PropertyGroup* parentGroup)
+        : PropertyGroup(parentGroup)
+    {
+        this->backend.mutableEnumeration().changeTrContext(this->textIdContext());
+        this->backend.setDescription(
+                    textIdTr("Parser of the STL files. gmio reads files sequentially with a small buffer, "
+                             "OpenCascade-based parser splits the facets over threads"));
+        this->backend.setDescriptions({
+                    { GmioStlBackend::Auto, textIdTr("gmio for files up to the size threshold, "
+                      "OpenCascade-based parser for bigger files") }
+        });
+        this->autoGmioMaxFileSize.setConstraintsEnabled(true);
+        this->autoGmioMaxFileSize.setRange(0, 64 * 1024);
+        this->autoGmioMaxFileSize.setDescription(
+                    textIdTr("Size threshold(in megabytes) used by `Auto` backend"));
+        this->mergeNodes.setDescription(
+                    textIdTr("Merge coincident vertices of facets into single mesh nodes"));
+        this->smoothNormals.setDescription(
+                    textIdTr("Compute normals at mesh nodes so curved surfaces are smoothly shaded. "
+                             "Requires merging of coincident vertices"));
+        this->smoothCreaseAngle.setDescription(
+                    textIdTr("Maximum angle between adjacent facets smoothed out by normals at nodes"));
+    }
+
+    void restoreDefaults() override {
+        const GmioStlReader::Parameters params;
+        this->backend.setValue(params.backend);
+        this->autoGmioMaxFileSize.setValue(int(params.autoGmioMaxFileSize / (1024 * 1024)));
+        this->mergeNodes.setValue(params.mesh.mergeNodes);
+        this->smoothNormals.setValue(params.mesh.smoothNormals);
+        this->smoothCreaseAngle.setQuantity(params.mesh.smoothCreaseAngle * Quantity_Radian);
+    }
+
+    PropertyEnum<GmioStlBackend> backend{ this, textId("backend") };
+    PropertyInt autoGmioMaxFileSize{ this, textId("autoGmioMaxFileSize") };
+    PropertyBool mergeNodes{ this, textId("mergeNodes") };
+    PropertyBool smoothNormals{ this, textId("smoothNormals") };
+    PropertyAngle smoothCreaseAngle{ this, textId("smoothCreaseAngle") };
+};
+
+GmioStlBackend GmioStlReader::selectBackend(const Parameters& params, const FilePath& filepath)
+{
+    if (params.backend != GmioStlBackend::Auto)
+        return params.backend;
+
+    std::error_code ec;
+    const auto fileSize = std::filesystem::file_size(filepath, ec);
+    if (ec)
+        return GmioStlBackend::OpenCascade;
+
+    return int64_t(fileSize) <= params.autoGmioMaxFileSize ? GmioStlBackend::Gmio : GmioStlBackend::OpenCascade;
+}
+
+bool GmioStlReader::readFile(const FilePath& filepath, TaskProgress* progress)
+{
+    m_mesh.Nullify();
+    m_baseFilename = filepath.stem();
+    m_isOccReaderUsed = GmioStlReader::selectBackend(m_params, filepath) == GmioStlBackend::OpenCascade;
+    if (m_isOccReaderUsed) {
+        m_occReader.parameters() = m_params.mesh;
+        return m_occReader.readFile(filepath, progress);
+    }
+
+    GmioStlMeshBuilder builder(m_params.mesh.mergeNodes);
+    gmio_stl_mesh_creator creator = {};
+    creator.cookie = &builder;
+    creator.func_begin_solid = [](void* cookie, const gmio_stl_mesh_creator_infos* infos) {
+        static_cast<GmioStlMeshBuilder*>(cookie)->beginSolid(infos);
+    };
+    creator.func_add_triangle = [](void* cookie, uint32_t, const gmio_stl_triangle* triangle) {
+        static_cast<GmioStlMeshBuilder*>(cookie)->addTriangle(triangle);
+    };
+
+    gmio_stl_read_options options = {};
+    options.task_iface = GmioUtils::createTask(progress);
+    const int error = gmio_stl_read_file(filepath.u8string().c_str(), &creator, &options);
+    if (!gmio_no_error(error))
+        return false;
+
+    m_mesh = builder.createMesh();
+    if (!m_mesh.IsNull() && m_params.mesh.mergeNodes && m_params.mesh.smoothNormals)
+        m_mesh = MeshUtils::smoothNormals(m_mesh, m_params.mesh.smoothCreaseAngle);
+
+    return !m_mesh.IsNull();
+}
+
+bool GmioStlReader::readStream(std::istream& istr, const FilePath& name, TaskProgress* progress)
+{
+    m_mesh.Nullify();
+    m_isOccReaderUsed = true;
+    m_occReader.parameters() = m_params.mesh;
+    return m_occReader.readStream(istr, name, progress);
+}
+
+TDF_LabelSequence GmioStlReader::transfer(DocumentPtr doc, TaskProgress* progress)
+{
+    if (m_isOccReaderUsed)
+        return m_occReader.transfer(doc, progress);
+
+    if (m_mesh.IsNull() || TaskProgress::isAbortRequested(progress))
+        return {};
+
+    const TDF_Label entityLabel = doc->newEntityLabel();
+    TDataXtd_Triangulation::Set(entityLabel, m_mesh);
+    CafUtils::setLabelAttrStdName(entityLabel, filepathTo<QString>(m_baseFilename));
+    return CafUtils::makeLabelSequence({ entityLabel });
+}
+
+std::unique_ptr<PropertyGroup> GmioStlReader::createProperties(PropertyGroup* parentGroup)
+{
+    return std::make_unique<Properties>(parentGroup);
+}
+
+void GmioStlReader::applyProperties(const PropertyGroup* params)
+{
+    auto ptr = dynamic_cast<const Properties*>(params);
+    if (ptr) {
+        m_params.backend = ptr->backend;
+        m_params.autoGmioMaxFileSize = int64_t(ptr->autoGmioMaxFileSize.value()) * 1024 * 1024;
+        m_params.mesh.mergeNodes = ptr->mergeNodes;
+        m_params.mesh.smoothNormals = ptr->smoothNormals;
+        m_params.mesh.smoothCreaseAngle = UnitSystem::radians(ptr->smoothCreaseAngle.quantity());
+    }
+}
+
+class GmioStlWriter::Properties : public PropertyGroup {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::GmioStlWriter::Properties)
+public:
+    Properties(PropertyGroup* parentGroup)
+        : PropertyGroup(parentGroup)
+    {
+        this->backend.mutableEnumeration().changeTrContext(this->textIdContext());
+        this->backend.setDescription(
+                    textIdTr("Writer of the STL files. gmio writes facets sequentially with a small "
+                             "buffer, OpenCascade-based writer serializes the facets over threads"));
+        this->backend.setDescriptions({
+                    { GmioStlBackend::Auto, textIdTr("gmio up to the facet count threshold, "
+                      "OpenCascade-based writer for bigger meshes or if decimation is requested") }
+        });
+        this->targetFormat.mutableEnumeration().changeTrContext(this->textIdContext());
+        this->autoGmioMaxFacetCount.setConstraintsEnabled(true);
+        this->autoGmioMaxFacetCount.setRange(0, std::numeric_limits<int>::max());
+        this->autoGmioMaxFacetCount.setDescription(
+                    textIdTr("Facet count threshold used by `Auto` backend"));
+        this->decimationRatio.setConstraintsEnabled(true);
+        this->decimationRatio.setRange(0.01, 1.);
+        this->decimationRatio.setSingleStep(0.05);
+        this->decimationRatio.setDescription(
+                    textIdTr("Targeted count of facets relative to the input count, 1 means no decimation. "
+                             "Decimation is done with the OpenCascade-based writer"));
+    }
+
+    void restoreDefaults() override {
+        const GmioStlWriter::Parameters params;
+        this->backend.setValue(params.backend);
+        this->autoGmioMaxFacetCount.setValue(int(params.autoGmioMaxFacetCount));
+        this->targetFormat.setValue(params.mesh.format);
+        this->decimationRatio.setValue(params.mesh.decimationRatio);
+    }
+
+    PropertyEnum<GmioStlBackend> backend{ this, textId("backend") };
+    PropertyInt autoGmioMaxFacetCount{ this, textId("autoGmioMaxFacetCount") };
+    PropertyEnum<OccStlWriter::Format> targetFormat{ this, textId("targetFormat") };
+    PropertyDouble decimationRatio{ this, textId("decimationRatio") };
+};
+
+bool GmioStlWriter::transfer(Span<const ApplicationItem> appItems, TaskProgress* progress)
+{
+    m_vecMesh.clear();
+    m_facetCount = 0;
+    m_lastMeshIndex = 0;
+    auto fnAddMesh = [&](const Handle_Poly_Triangulation& triangulation, const gp_Trsf& trsf, bool isReversed) {
+        if (!triangulation.IsNull() && triangulation->NbTriangles() > 0) {
+            m_vecMesh.push_back({ triangulation, trsf, isReversed, m_facetCount });
+            m_facetCount += triangulation->NbTriangles();
+        }
+    };
+    auto fnAddShape = [&](const TopoDS_Shape& shape) {
+        BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+            fnAddMesh(triangulation, loc.Transformation(), face.Orientation() == TopAbs_REVERSED);
+        });
+    };
+
+    for (const ApplicationItem& item : appItems) {
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+
+        if (item.isDocument()) {
+            for (const TDF_Label& label : item.document()->xcaf().topLevelFreeShapes())
+                fnAddShape(XCaf::shape(label));
+        }
+        else if (item.isDocumentTreeNode()) {
+            const TDF_Label label = item.documentTreeNode().label();
+            if (XCaf::isShape(label)) {
+                fnAddShape(XCaf::shape(label));
+            }
+            else {
+                auto attrPolyTri = CafUtils::findAttribute<TDataXtd_Triangulation>(label);
+                if (!attrPolyTri.IsNull())
+                    fnAddMesh(attrPolyTri->Get(), gp_Trsf(), false);
+            }
+        }
+    }
+
+    // Cheap: OccStlWriter only collects the shapes and meshes of the items
+    return m_occWriter.transfer(appItems, progress) && !m_vecMesh.empty();
+}
+
+GmioStlBackend GmioStlWriter::selectBackend() const
+{
+    if (m_params.mesh.decimationRatio < 1. || m_facetCount > std::numeric_limits<uint32_t>::max())
+        return GmioStlBackend::OpenCascade;
+
+    if (m_params.backend != GmioStlBackend::Auto)
+        return m_params.backend;
+
+    return m_facetCount <= m_params.autoGmioMaxFacetCount ? GmioStlBackend::Gmio : GmioStlBackend::OpenCascade;
+}
+
+bool GmioStlWriter::writeFile(const FilePath& filepath, TaskProgress* progress)
+{
+    if (this->selectBackend() == GmioStlBackend::OpenCascade) {
+        m_occWriter.parameters() = m_params.mesh;
+        return m_occWriter.writeFile(filepath, progress);
+    }
+
+    return this->write(filepath.stem().u8string(), progress, [&](
+                       gmio_stl_format format, const gmio_stl_mesh* mesh, const gmio_stl_write_options* options)
+    {
+        return gmio_stl_write_file(format, filepath.u8string().c_str(), mesh, options);
+    });
+}
+
+bool GmioStlWriter::writeStream(std::ostream& ostr, TaskProgress* progress)
+{
+    if (this->selectBackend() == GmioStlBackend::OpenCascade) {
+        m_occWriter.parameters() = m_params.mesh;
+        return m_occWriter.writeStream(ostr, progress);
+    }
+
+    gmio_stream stream = GmioUtils::ostream(&ostr);
+    const bool okWrite = this->write("", progress, [&](
+                                     gmio_stl_format format, const gmio_stl_mesh* mesh, const gmio_stl_write_options* options)
+    {
+        return gmio_stl_write(format, &stream, mesh, options);
+    });
+    ostr.flush();
+    return okWrite && ostr.good();
+}
+
+template<typename FunctionGmioWrite>
+bool GmioStlWriter::write(const std::string& solidName, TaskProgress* progress, FunctionGmioWrite fnWrite)
+{
+    m_lastMeshIndex = 0;
+    gmio_stl_mesh mesh = {};
+    mesh.cookie = this;
+    mesh.triangle_count = uint32_t(m_facetCount);
+    mesh.func_get_triangle = &GmioStlWriter::stl_getTriangle;
+
+    gmio_stl_write_options options = {};
+    options.task_iface = GmioUtils::createTask(progress);
+    options.stla_solid_name = solidName.c_str();
+    options.stla_float32_format = GMIO_FLOAT_TEXT_FORMAT_SHORTEST_LOWERCASE;
+    options.stla_float32_prec = 9;
+    const gmio_stl_format format =
+            m_params.mesh.format == OccStlWriter::Format::Ascii ? GMIO_STL_FORMAT_ASCII : GMIO_STL_FORMAT_BINARY_LE;
+    const int error = fnWrite(format, &mesh, &options);
+    return gmio_no_error(error);
+}
+
+void GmioStlWriter::stl_getTriangle(const void* cookie, uint32_t triangleIndex, gmio_stl_triangle* triangle)
+{
+    auto writer = static_cast<const GmioStlWriter*>(cookie);
+    const std::vector<Mesh>& vecMesh = writer->m_vecMesh;
+    // Facets are usually requested in order, otherwise find the mesh owning the facet
+    int iMesh = writer->m_lastMeshIndex;
+    auto fnMeshContains = [&](int i) {
+        const Mesh& mesh = vecMesh.at(i);
+        return triangleIndex >= mesh.firstFacetIndex
+                && triangleIndex < mesh.firstFacetIndex + mesh.triangulation->NbTriangles();
+    };
+    if (!fnMeshContains(iMesh)) {
+        auto itMesh = std::upper_bound(
+                    vecMesh.cbegin(), vecMesh.cend(), int64_t(triangleIndex), [](int64_t index, const Mesh& mesh) {
+            return index < mesh.firstFacetIndex;
+        });
+        iMesh = int(itMesh - vecMesh.cbegin()) - 1;
+        writer->m_lastMeshIndex = iMesh;
+    }
+
+    const Mesh& mesh = vecMesh.at(iMesh);
+    int n1, n2, n3;
+    mesh.triangulation->Triangle(int(triangleIndex - mesh.firstFacetIndex) + 1).Get(n1, n2, n3);
+    if (mesh.isReversed)
+        std::swap(n2, n3);
+
+    const gp_Pnt p1 = mesh.triangulation->Node(n1).Transformed(mesh.trsf);
+    const gp_Pnt p2 = mesh.triangulation->Node(n2).Transformed(mesh.trsf);
+    const gp_Pnt p3 = mesh.triangulation->Node(n3).Transformed(mesh.trsf);
+    const gp_Vec vec12(p1, p2);
+    const gp_Vec vec13(p1, p3);
+    gp_Vec normal = vec12.Crossed(vec13);
+    const double normalLength = normal.Magnitude();
+    normal = normalLength > gp::Resolution() ? normal / normalLength : gp_Vec(0, 0, 0);
+
+    *triangle = {};
+    triangle->n = gmio_toVec3f(normal.XYZ());
+    triangle->v1 = gmio_toVec3f(p1.XYZ());
+    triangle->v2 = gmio_toVec3f(p2.XYZ());
+    triangle->v3 = gmio_toVec3f(p3.XYZ());
+}
+
+std::unique_ptr<PropertyGroup> GmioStlWriter::createProperties(PropertyGroup* parentGroup)
+{
+    return std::make_unique<Properties>(parentGroup);
+}
+
+void GmioStlWriter::applyProperties(const PropertyGroup* params)
+{
+    auto ptr = dynamic_cast<const Properties*>(params);
+    if (ptr) {
+        m_params.backend = ptr->backend;
+        m_params.autoGmioMaxFacetCount = ptr->autoGmioMaxFacetCount.value();
+        m_params.mesh.format = ptr->targetFormat;
+        m_params.mesh.decimationRatio = ptr->decimationRatio;
+    }
+}
+
+} // namespace IO
+} // namespace Mayo
@@ -0,0 +1,122 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/property_enumeration.h"
+#include "../io_occ/io_occ_stl.h"
+
+#include <gp_Trsf.hxx>
+#include <cstdint>
+#include <vector>
+
+struct gmio_stl_triangle;
+
+namespace Mayo {
+namespace IO {
+
+// Backend used by the gmio-based STL reader/writer
+enum class GmioStlBackend {
+    Auto, // Chosen from the size of the data, see parameters 'autoGmioMax*'
+    Gmio, // Buffered sequential parsing/writing of gmio
+    OpenCascade // Concurrent parsing/writing of OccStlReader/OccStlWriter
+};
+
+// STL reader selecting gmio or OccStlReader for each file
+// Requires gmio >= v0.4.0
+class GmioStlReader : public Reader {
+public:
+    bool readFile(const FilePath& filepath, TaskProgress* progress) override;
+    // Stream data is always parsed by OccStlReader
+    bool readStream(std::istream& istr, const FilePath& name, TaskProgress* progress) override;
+    bool readsStream() const override { return true; }
+    TDF_LabelSequence transfer(DocumentPtr doc, TaskProgress* progress) override;
+
+    static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
+    void applyProperties(const PropertyGroup* params) override;
+
+    // Parameters
+    struct Parameters {
+        GmioStlBackend backend = GmioStlBackend::Auto;
+        // With Auto backend, gmio parses the files up to this size(in bytes). Bigger files get
+        // split over threads by OccStlReader, which pays off once its setup cost is amortized
+        // Meant to be the crossover point of the "read" rows of Bench::IO_gmioStlBackend_bench,
+        // to be revisited from its results(8MB is about 168k binary facets)
+        int64_t autoGmioMaxFileSize = 8 * 1024 * 1024;
+        // Settings shared by both backends
+        OccStlReader::Parameters mesh;
+    };
+    Parameters& parameters() { return m_params; }
+    const Parameters& constParameters() const { return m_params; }
+
+    // Backend actually used to read 'filepath'
+    static GmioStlBackend selectBackend(const Parameters& params, const FilePath& filepath);
+
+private:
+    class Properties;
+    Parameters m_params;
+    OccStlReader m_occReader;
+    bool m_isOccReaderUsed = false;
+    Handle_Poly_Triangulation m_mesh;
+    FilePath m_baseFilename;
+};
+
+// STL writer selecting gmio or OccStlWriter from the count of facets to be written
+// Requires gmio >= v0.4.0
+class GmioStlWriter : public Writer {
+public:
+    bool transfer(Span<const ApplicationItem> appItems, TaskProgress* progress) override;
+    bool writeFile(const FilePath& filepath, TaskProgress* progress) override;
+    bool writeStream(std::ostream& ostr, TaskProgress* progress) override;
+
+    static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
+    void applyProperties(const PropertyGroup* params) override;
+
+    // Parameters
+    struct Parameters {
+        GmioStlBackend backend = GmioStlBackend::Auto;
+        // With Auto backend, gmio writes up to this count of facets(if no decimation requested)
+        // Meant to be the crossover point of the "write" rows of Bench::IO_gmioStlBackend_bench,
+        // to be revisited from its results
+        int64_t autoGmioMaxFacetCount = 200 * 1000;
+        // Settings shared by both backends, decimation is done by OccStlWriter only
+        OccStlWriter::Parameters mesh;
+    };
+    Parameters& parameters() { return m_params; }
+    const Parameters& constParameters() const { return m_params; }
+
+    // Backend actually used to write the transferred items
+    GmioStlBackend selectBackend() const;
+
+private:
+    struct Mesh {
+        Handle_Poly_Triangulation triangulation;
+        gp_Trsf trsf;
+        bool isReversed = false;
+        int64_t firstFacetIndex = 0; // Global to the file
+    };
+
+    // 'fnWrite' calls the gmio write function with the gmio mesh and options created here
+    template<typename FunctionGmioWrite>
+    bool write(const std::string& solidName, TaskProgress* progress, FunctionGmioWrite fnWrite);
+    static void stl_getTriangle(const void* cookie, uint32_t triangleIndex, gmio_stl_triangle* triangle);
+
+    class Properties;
+    Parameters m_params;
+    OccStlWriter m_occWriter;
+    std::vector<Mesh> m_vecMesh;
+    int64_t m_facetCount = 0;
+    mutable int m_lastMeshIndex = 0; // Cache for stl_getTriangle(), facets are requested in order
+};
+
+} // namespace IO
+
+template<> struct EnumNames<IO::GmioStlBackend> {
+    inline static const QByteArray trContext = "Mayo::IO::GmioStl";
+    inline static const std::string_view junkPrefix = "";
+};
+
+} // namespace Mayo
@@ -0,0 +1,62 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_gmio_utils.h"
+
+#include "../base/task_progress.h"
+
+#include <QtCore/QtGlobal>
+#include <ostream>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+bool gmio_taskIsStopRequested(void* cookie)
+{
+    auto progress = static_cast<const TaskProgress*>(cookie);
+    return progress ? progress->isAbortRequested() : false;
+}
+
+void gmio_handleProgress(void* cookie, intmax_t value, intmax_t maxValue)
+{
+    auto progress = static_cast<TaskProgress*>(cookie);
+    if (progress && maxValue > 0) {
+        const auto pctNorm = value / double(maxValue);
+        const auto pct = qRound(pctNorm * 100);
+        progress->setValue(pct);
+    }
+}
+
+} // namespace
+
+gmio_stream GmioUtils::ostream(std::ostream* ostr)
+{
+    gmio_stream stream = gmio_stream_null();
+    stream.cookie = ostr;
+    stream.func_error = [](void* cookie) {
+        return static_cast<std::ostream*>(cookie)->good() ? 0 : -1;
+    };
+    stream.func_write = [](void* cookie, const void* ptr, size_t size, size_t count) -> size_t {
+        auto ostr = static_cast<std::ostream*>(cookie);
+        ostr->write(static_cast<const char*>(ptr), std::streamsize(size * count));
+        return ostr->good() ? count : 0;
+    };
+    return stream;
+}
+
+gmio_task_iface GmioUtils::createTask(TaskProgress* progress)
+{
+    gmio_task_iface task = {};
+    task.cookie = progress;
+    task.func_is_stop_requested = gmio_taskIsStopRequested;
+    task.func_handle_progress = gmio_handleProgress;
+    return task;
+}
+
+} // namespace IO
+} // namespace Mayo
@@ -0,0 +1,30 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <gmio_core/stream.h>
+#include <gmio_core/task_iface.h>
+#include <iosfwd>
+
+namespace Mayo {
+
+class TaskProgress;
+
+namespace IO {
+
+// Helper functions shared by gmio-based readers/writers
+struct GmioUtils {
+    // gmio stream writing into 'ostr', reading isn't supported
+    static gmio_stream ostream(std::ostream* ostr);
+
+    // gmio task reporting progress to 'progress' and checking its abort requests, 'progress' can
+    // be null
+    static gmio_task_iface createTask(TaskProgress* progress);
+};
+
+} // namespace IO
+} // namespace Mayo
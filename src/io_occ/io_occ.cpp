@@ -10,6 +10,7 @@
 #include "../base/tkernel_utils.h"
 #include "io_occ_brep.h"
 #include "io_occ_iges.h"
+#include "io_occ_obj_writer.h"
 #include "io_occ_step.h"
 #include "io_occ_stl.h"
 #include "io_occ_vrml.h"
@@ -69,6 +70,8 @@ PtrPropertyGroup OccFactoryReader::createProperties(const Format& format, Proper
         return OccStepReader::createProperties(parentGroup);
     if (format == Format_IGES)
         return OccIgesReader::createProperties(parentGroup);
+    if (format == Format_STL)
+        return OccStlReader::createProperties(parentGroup);
 
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
     if (format == Format_GLTF)
@@ -83,7 +86,7 @@ PtrPropertyGroup OccFactoryReader::createProperties(const Format& format, Proper
 Span<const Format> OccFactoryWriter::formats() const
 {
     static const Format arrayFormat[] = {
-        Format_STEP, Format_IGES, Format_OCCBREP, Format_STL, Format_VRML
+        Format_STEP, Format_IGES, Format_OCCBREP, Format_STL, Format_VRML, Format_OBJ
     #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
         , Format_GLTF
     #endif
@@ -103,6 +106,8 @@ std::unique_ptr<Writer> OccFactoryWriter::create(const Format& format) const
         return std::make_unique<OccStlWriter>();
     if (format == Format_VRML)
         return std::make_unique<OccVrmlWriter>();
+    if (format == Format_OBJ)
+        return std::make_unique<OccObjWriter>();
 
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
     if (format == Format_GLTF)
@@ -118,10 +123,14 @@ PtrPropertyGroup OccFactoryWriter::createProperties(const Format& format, Proper
         return OccStepWriter::createProperties(parentGroup);
     if (format == Format_IGES)
         return OccIgesWriter::createProperties(parentGroup);
+    if (format == Format_OCCBREP)
+        return OccBRepWriter::createProperties(parentGroup);
     if (format == Format_STL)
         return OccStlWriter::createProperties(parentGroup);
     if (format == Format_VRML)
         return OccVrmlWriter::createProperties(parentGroup);
+    if (format == Format_OBJ)
+        return OccObjWriter::createProperties(parentGroup);
 
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
     if (format == Format_GLTF)
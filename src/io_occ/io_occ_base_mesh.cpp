@@ -13,6 +13,11 @@
 #include "../base/tkernel_utils.h"
 
 #include <RWMesh_CafReader.hxx>
+#include <XCAFDoc_DocumentTool.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+#  include <XCAFDoc_Editor.hxx>
+#endif
 
 namespace Mayo {
 namespace IO {
@@ -66,20 +71,47 @@ OccBaseMeshReaderProperties::LengthUnit OccBaseMeshReaderProperties::lengthUnit(
     return LengthUnit::Undefined;
 }
 
-bool OccBaseMeshReader::readFile(const FilePath& filepath, TaskProgress* /*progress*/)
+bool OccBaseMeshReader::readFile(const FilePath& filepath, TaskProgress* progress)
 {
     m_filepath = filepath;
-    return true;
+    m_tempDoc.Nullify();
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    // Parse now(concurrently with other readers) into a document owned by this reader, it's not
+    // registered in any application
+    this->applyParameters();
+    m_tempDoc = new TDocStd_Document(Document::NameFormatBinary);
+    XCAFDoc_DocumentTool::Set(m_tempDoc->Main(), false);
+    m_reader.SetDocument(m_tempDoc);
+    Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
+    const bool okPerform = m_reader.Perform(m_filepath.u8string().c_str(), TKernelUtils::start(indicator));
+    m_reader.SetDocument(Handle_TDocStd_Document());
+    if (!okPerform)
+        m_tempDoc.Nullify();
+
+    return okPerform && !TaskProgress::isAbortRequested(progress);
+#else
+    return !TaskProgress::isAbortRequested(progress);
+#endif
 }
 
 TDF_LabelSequence OccBaseMeshReader::transfer(DocumentPtr doc, TaskProgress* progress)
 {
+    const int shapesTagMark = doc->xcaf().shapesTagWatermark();
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    if (m_tempDoc.IsNull() || TaskProgress::isAbortRequested(progress))
+        return {};
+
+    TDF_LabelSequence seqTempShape;
+    XCAFDoc_DocumentTool::ShapeTool(m_tempDoc->Main())->GetFreeShapes(seqTempShape);
+    XCAFDoc_Editor::Extract(seqTempShape, doc->Main());
+    m_tempDoc.Nullify();
+#else
     this->applyParameters();
     m_reader.SetDocument(doc);
-    const TDF_LabelSequence seqMark = doc->xcaf().topLevelFreeShapes();
     Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
     m_reader.Perform(m_filepath.u8string().c_str(), TKernelUtils::start(indicator));
-    return doc->xcaf().diffTopLevelFreeShapes(seqMark);
+#endif
+    return doc->xcaf().topLevelFreeShapesAfter(shapesTagMark);
 }
 
 void OccBaseMeshReader::applyProperties(const PropertyGroup* params)
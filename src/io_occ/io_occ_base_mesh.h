@@ -12,6 +12,7 @@
 #include "../base/property_enumeration.h"
 
 #include <RWMesh_CoordinateSystem.hxx>
+#include <TDocStd_Document.hxx>
 class RWMesh_CafReader;
 
 #include <QtCore/QCoreApplication>
@@ -20,6 +21,8 @@ namespace Mayo {
 namespace IO {
 
 // Base class around OpenCascade RWMesh_CafReader
+// With OpenCascade >= v7.6.0 the file is parsed in readFile() into a private XCAF document, then
+// transfer() just copies the resulting shapes into the target document
 class OccBaseMeshReader : public Reader {
 public:
     bool readFile(const FilePath& filepath, TaskProgress* progress) override;
@@ -43,6 +46,7 @@ protected:
 private:
     FilePath m_filepath;
     RWMesh_CafReader& m_reader;
+    Handle_TDocStd_Document m_tempDoc; // Holds the result of readFile()
 };
 
 // Common properties for OccBaseMeshReader
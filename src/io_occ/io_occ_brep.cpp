@@ -10,22 +10,55 @@
 #include "../base/caf_utils.h"
 #include "../base/document.h"
 #include "../base/occ_progress_indicator.h"
+#include "../base/property_builtins.h"
+#include "../base/property_enumeration.h"
+#include "../base/stream_utils.h"
 #include "../base/string_utils.h"
 #include "../base/task_progress.h"
 #include "../base/tkernel_utils.h"
 
+#include <BinTools.hxx>
 #include <BRep_Builder.hxx>
 #include <BRepTools.hxx>
+#include <QtCore/QFile>
 
 namespace Mayo {
 namespace IO {
 
+namespace {
+
+// Binary BRep contents start with the version string of BinTools_ShapeSet, eg
+// "Open CASCADE Topology V3 (c)"
+bool isBinaryBRepContents(const QByteArray& contentsBegin)
+{
+    return contentsBegin.trimmed().startsWith("Open CASCADE Topology V");
+}
+
+bool isBinaryBRepFile(const FilePath& filepath)
+{
+    QFile file(filepathTo<QString>(filepath));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    return isBinaryBRepContents(file.read(64));
+}
+
+} // namespace
+
 bool OccBRepReader::readFile(const FilePath& filepath, TaskProgress* progress)
 {
     m_shape.Nullify();
     m_baseFilename = filepath.stem();
-    BRep_Builder brepBuilder;
     Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
+    if (isBinaryBRepFile(filepath)) {
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+        return BinTools::Read(m_shape, filepath.u8string().c_str(), TKernelUtils::start(indicator));
+#else
+        return BinTools::Read(m_shape, filepath.u8string().c_str());
+#endif
+    }
+
+    BRep_Builder brepBuilder;
     return BRepTools::Read(
                 m_shape,
                 filepath.u8string().c_str(),
@@ -33,9 +66,44 @@ bool OccBRepReader::readFile(const FilePath& filepath, TaskProgress* progress)
                 TKernelUtils::start(indicator));
 }
 
-TDF_LabelSequence OccBRepReader::transfer(DocumentPtr doc, TaskProgress* /*progress*/)
+bool OccBRepReader::readStream(std::istream& istr, const FilePath& name, TaskProgress* progress)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    // Variant is probed from the first bytes, so the stream has to be rewound
+    if (!StreamUtils::isSeekable(istr))
+        return Reader::readStream(istr, name, progress);
+
+    m_shape.Nullify();
+    m_baseFilename = name.stem();
+    const std::streampos posStart = istr.tellg();
+    char contentsBegin[64] = {};
+    istr.read(contentsBegin, sizeof(contentsBegin));
+    const bool isBinary = isBinaryBRepContents(QByteArray(contentsBegin, int(istr.gcount())));
+    istr.clear();
+    istr.seekg(posStart);
+    Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
+    if (isBinary) {
+        BinTools::Read(m_shape, istr, TKernelUtils::start(indicator));
+    }
+    else {
+        BRep_Builder brepBuilder;
+        BRepTools::Read(m_shape, istr, brepBuilder, TKernelUtils::start(indicator));
+    }
+
+    return !m_shape.IsNull();
+#else
+    return Reader::readStream(istr, name, progress);
+#endif
+}
+
+bool OccBRepReader::readsStream() const
+{
+    return OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0);
+}
+
+TDF_LabelSequence OccBRepReader::transfer(DocumentPtr doc, TaskProgress* progress)
 {
-    if (m_shape.IsNull())
+    if (m_shape.IsNull() || TaskProgress::isAbortRequested(progress))
         return {};
 
     const Handle_XCAFDoc_ShapeTool shapeTool = doc->xcaf().shapeTool();
@@ -45,13 +113,16 @@ TDF_LabelSequence OccBRepReader::transfer(DocumentPtr doc, TaskProgress* /*progr
     return CafUtils::makeLabelSequence({ labelShape });
 }
 
-bool OccBRepWriter::transfer(Span<const ApplicationItem> appItems, TaskProgress* /*progress*/)
+bool OccBRepWriter::transfer(Span<const ApplicationItem> appItems, TaskProgress* progress)
 {
     m_shape = TopoDS_Shape();
 
     std::vector<TopoDS_Shape> vecShape;
     vecShape.reserve(appItems.size());
     for (const ApplicationItem& item : appItems) {
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+
         if (item.isDocument()) {
             for (const TDF_Label& label : item.document()->xcaf().topLevelFreeShapes())
                 vecShape.push_back(XCaf::shape(label));
@@ -81,7 +152,77 @@ bool OccBRepWriter::transfer(Span<const ApplicationItem> appItems, TaskProgress*
 bool OccBRepWriter::writeFile(const FilePath& filepath, TaskProgress* progress)
 {
     Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
-    return BRepTools::Write(m_shape, filepath.u8string().c_str(), TKernelUtils::start(indicator));
+    const std::string strFilepath = filepath.u8string();
+    if (m_params.format == Format::Binary) {
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+        return BinTools::Write(
+                    m_shape,
+                    strFilepath.c_str(),
+                    m_params.withTriangles,
+                    m_params.withTriangles, // With normals
+                    BinTools_FormatVersion_CURRENT,
+                    TKernelUtils::start(indicator));
+#elif OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+        return BinTools::Write(m_shape, strFilepath.c_str(), TKernelUtils::start(indicator));
+#else
+        return BinTools::Write(m_shape, strFilepath.c_str());
+#endif
+    }
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    return BRepTools::Write(
+                m_shape,
+                strFilepath.c_str(),
+                m_params.withTriangles,
+                m_params.withTriangles, // With normals
+                TopTools_FormatVersion_CURRENT,
+                TKernelUtils::start(indicator));
+#else
+    return BRepTools::Write(m_shape, strFilepath.c_str(), TKernelUtils::start(indicator));
+#endif
+}
+
+class OccBRepWriter::Properties : public PropertyGroup {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::OccBRepWriter::Properties)
+public:
+    Properties(PropertyGroup* parentGroup)
+        : PropertyGroup(parentGroup)
+    {
+        this->format.mutableEnumeration().changeTrContext(this->textIdContext());
+        this->format.setDescription(
+                    textIdTr("Binary format is much faster to write and read back than text format, "
+                             "but it's not human readable"));
+        this->withTriangles.setDescription(
+                    textIdTr("Write triangulations of faces, so shapes are displayed without being "
+                             "meshed again when read back"));
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+        // Triangulations are always written
+        this->withTriangles.setEnabled(false);
+#endif
+    }
+
+    void restoreDefaults() override {
+        const OccBRepWriter::Parameters params;
+        this->format.setValue(params.format);
+        this->withTriangles.setValue(params.withTriangles);
+    }
+
+    PropertyEnum<OccBRepWriter::Format> format{ this, textId("format") };
+    PropertyBool withTriangles{ this, textId("withTriangles") };
+};
+
+std::unique_ptr<PropertyGroup> OccBRepWriter::createProperties(PropertyGroup* parentGroup)
+{
+    return std::make_unique<Properties>(parentGroup);
+}
+
+void OccBRepWriter::applyProperties(const PropertyGroup* params)
+{
+    auto ptr = dynamic_cast<const Properties*>(params);
+    if (ptr) {
+        m_params.format = ptr->format;
+        m_params.withTriangles = ptr->withTriangles;
+    }
 }
 
 } // namespace IO
@@ -13,10 +13,12 @@
 namespace Mayo {
 namespace IO {
 
-// Reader for OpenCascade BRep file format
+// Reader for OpenCascade BRep file format, text and binary variants are both supported
 class OccBRepReader : public Reader {
 public:
     bool readFile(const FilePath& filepath, TaskProgress* progress) override;
+    bool readStream(std::istream& istr, const FilePath& name, TaskProgress* progress) override;
+    bool readsStream() const override;
     TDF_LabelSequence transfer(DocumentPtr doc, TaskProgress* progress) override;
 
 private:
@@ -30,7 +32,25 @@ public:
     bool transfer(Span<const ApplicationItem> appItems, TaskProgress* progress) override;
     bool writeFile(const FilePath& filepath, TaskProgress* progress) override;
 
+    static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
+    void applyProperties(const PropertyGroup* params) override;
+
+    // Parameters
+    enum class Format { Text, Binary };
+
+    struct Parameters {
+        // Binary format(BinTools) is much faster to write and read back than text format
+        Format format = Format::Text;
+        // Write triangulations of faces, so shapes can be displayed without being meshed again
+        // Note: requires OpenCascade >= 7.6, triangulations are always written with older versions
+        bool withTriangles = true;
+    };
+    Parameters& parameters() { return m_params; }
+    const Parameters& constParameters() const { return m_params; }
+
 private:
+    class Properties;
+    Parameters m_params;
     TopoDS_Shape m_shape;
 };
 
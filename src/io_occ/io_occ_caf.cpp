@@ -24,18 +24,22 @@ namespace IO {
 namespace {
 
 template<typename CAF_READER>
-bool cafGenericReadFile(CAF_READER& reader, const FilePath& filepath, TaskProgress* /*progress*/)
+bool cafGenericReadFile(CAF_READER& reader, const FilePath& filepath, TaskProgress* progress)
 {
+    // OpenCascade ReadFile() doesn't report progress nor check user break
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
     //readFile_prepare(reader);
     const IFSelect_ReturnStatus error = reader.ReadFile(filepath.u8string().c_str());
-    return error == IFSelect_RetDone;
+    return error == IFSelect_RetDone && !TaskProgress::isAbortRequested(progress);
 }
 
 template<typename CAF_READER>
 TDF_LabelSequence cafGenericReadTransfer(CAF_READER& reader, DocumentPtr doc, TaskProgress* progress)
 {
     Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
-    const TDF_LabelSequence seqMark = doc->xcaf().topLevelFreeShapes();
+    const int shapesTagMark = doc->xcaf().shapesTagWatermark();
     Handle_TDocStd_Document stdDoc = doc;
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
     const bool okTransfer = reader.Transfer(stdDoc, indicator->Start());
@@ -46,7 +50,7 @@ TDF_LabelSequence cafGenericReadTransfer(CAF_READER& reader, DocumentPtr doc, Ta
     const bool okTransfer = reader.Transfer(stdDoc);
 #endif
     MAYO_UNUSED(okTransfer);
-    return doc->xcaf().diffTopLevelFreeShapes(seqMark);
+    return doc->xcaf().topLevelFreeShapesAfter(shapesTagMark);
 }
 
 template<typename CAF_WRITER>
@@ -76,7 +80,25 @@ bool cafGenericWriteTransfer(CAF_WRITER& writer, Span<const ApplicationItem> app
 
 namespace Private {
 
-std::mutex& cafGlobalMutex()
+std::mutex& cafStaticVariablesMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::mutex& cafIgesParserMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::mutex& cafStepParserMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::mutex& cafStepUnitsMutex()
 {
     static std::mutex mutex;
     return mutex;
@@ -98,6 +120,18 @@ bool cafReadFile(STEPCAFControl_Reader& reader, const FilePath& filepath, TaskPr
     return cafGenericReadFile(reader, filepath, progress);
 }
 
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 7, 0)
+bool cafReadStream(STEPCAFControl_Reader& reader, std::istream& istr, const FilePath& name, TaskProgress* progress)
+{
+    // Like ReadFile(), no progress reported nor user break checked
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
+    const IFSelect_ReturnStatus error = reader.ReadStream(name.u8string().c_str(), istr);
+    return error == IFSelect_RetDone && !TaskProgress::isAbortRequested(progress);
+}
+#endif
+
 TDF_LabelSequence cafTransfer(IGESCAFControl_Reader& reader, DocumentPtr doc, TaskProgress* progress) {
     return cafGenericReadTransfer(reader, doc, progress);
 }
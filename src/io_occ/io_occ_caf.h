@@ -14,9 +14,12 @@
 #include "../base/document_ptr.h"
 #include "../base/filepath.h"
 #include "../base/span.h"
+#include "../base/tkernel_utils.h"
 
+#include <Standard_Version.hxx>
 #include <Transfer_FinderProcess.hxx>
 #include <XSControl_WorkSession.hxx>
+#include <iosfwd>
 #include <mutex>
 class IGESCAFControl_Reader;
 class STEPCAFControl_Reader;
@@ -33,11 +36,53 @@ class TaskProgress;
 namespace IO {
 namespace Private {
 
-std::mutex& cafGlobalMutex();
+// Guards the initialization of XSControl controllers, which registers OpenCascade static
+// variables(see Interface_Static)
+// Values of static variables required by IGES/STEP translations are applied with
+// OccStaticVariablesScope
+std::mutex& cafStaticVariablesMutex();
+
+// Guards the IGES/STEP file parsers of OpenCascade, which rely on process-global state
+std::mutex& cafIgesParserMutex();
+std::mutex& cafStepParserMutex();
+// Guards the STEP transfers, which rely on process-global unit factors before OpenCascade 7.8.0
+// (STEPControl_ActorRead::PrepareUnits() and the writer actor set UnitsMethods/StepData_GlobalFactors)
+std::mutex& cafStepUnitsMutex();
+
+#define MayoIO_CafStaticVariablesScopedLock(name) \
+    std::lock_guard<std::mutex> name(Mayo::IO::Private::cafStaticVariablesMutex()); \
+    Q_UNUSED(name);
+
+#define MayoIO_CafIgesParserScopedLock(name) \
+    std::lock_guard<std::mutex> name(Mayo::IO::Private::cafIgesParserMutex()); \
+    Q_UNUSED(name);
 
-#define MayoIO_CafGlobalScopedLock(name) \
-    std::lock_guard<std::mutex> name(Mayo::IO::Private::cafGlobalMutex()); \
+// STEP parser is reentrant since OpenCascade 7.6.0
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+#  define MayoIO_CafStepParserScopedLock(name)
+#else
+#  define MayoIO_CafStepParserScopedLock(name) \
+    std::lock_guard<std::mutex> name(Mayo::IO::Private::cafStepParserMutex()); \
+    Q_UNUSED(name);
+#endif
+
+// Unit factors are held by the STEP transfer since OpenCascade 7.8.0
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 8, 0)
+#  define MayoIO_CafStepUnitsScopedLock(name)
+#else
+#  define MayoIO_CafStepUnitsScopedLock(name) \
+    std::lock_guard<std::mutex> name(Mayo::IO::Private::cafStepUnitsMutex()); \
     Q_UNUSED(name);
+#endif
+
+// Serializes the transfers targeting the same document, transfers into distinct documents
+// can run concurrently unless they share process-global state(see MayoIO_CafStepUnitsScopedLock)
+#define MayoIO_CafDocumentScopedLock(name, doc) \
+    std::lock_guard<std::mutex> name((doc)->dataMutex()); \
+    Q_UNUSED(name);
+
+// Lock ordering to prevent deadlocks: document/parser locks, then STEP units lock, must be
+// acquired before the static variables lock or any OccStaticVariablesScope
 
 Handle_XSControl_WorkSession cafWorkSession(const IGESCAFControl_Reader& reader);
 Handle_XSControl_WorkSession cafWorkSession(const STEPCAFControl_Reader& reader);
@@ -47,6 +92,10 @@ Handle_Transfer_FinderProcess cafFinderProcess(const STEPCAFControl_Writer& writ
 
 bool cafReadFile(IGESCAFControl_Reader& reader, const FilePath& filepath, TaskProgress* progress);
 bool cafReadFile(STEPCAFControl_Reader& reader, const FilePath& filepath, TaskProgress* progress);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 7, 0)
+// 'name' identifies the stream in the messages of the reader
+bool cafReadStream(STEPCAFControl_Reader& reader, std::istream& istr, const FilePath& name, TaskProgress* progress);
+#endif
 
 TDF_LabelSequence cafTransfer(IGESCAFControl_Reader& reader, DocumentPtr doc, TaskProgress* progress);
 TDF_LabelSequence cafTransfer(STEPCAFControl_Reader& reader, DocumentPtr doc, TaskProgress* progress);
@@ -5,11 +5,123 @@
 ****************************************************************************/
 
 #include "io_occ_common.h"
+#include "../base/occ_static_variables_context.h"
+#include "../base/perf_stats.h"
 #include "../base/text_id.h"
 
+#include <ShapeProcess.hxx>
+#include <ShapeProcess_Context.hxx>
+#include <ShapeProcess_UOperator.hxx>
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+#  include <Message_ProgressRange.hxx>
+#endif
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <chrono>
+#include <mutex>
+#include <string>
+
 namespace Mayo {
 namespace IO {
 
+namespace {
+
+// Name of the resource file defining the shape healing sequences, it's found by OpenCascade
+// with environment variable CSF_<name>Defaults
+const char ShapeHealingResourceName[] = "MayoShapeHealing";
+
+thread_local PerfStats* threadHealingPerfStats = nullptr;
+thread_local std::chrono::steady_clock::time_point threadHealingStartTime;
+
+// Operators bracketing the fixes of each sequence, so healing can be timed apart the translation
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+Standard_Boolean healingBeginOperator(const Handle_ShapeProcess_Context&, const Message_ProgressRange&)
+#else
+Standard_Boolean healingBeginOperator(const Handle_ShapeProcess_Context&)
+#endif
+{
+    threadHealingStartTime = std::chrono::steady_clock::now();
+    return Standard_True;
+}
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+Standard_Boolean healingEndOperator(const Handle_ShapeProcess_Context&, const Message_ProgressRange&)
+#else
+Standard_Boolean healingEndOperator(const Handle_ShapeProcess_Context&)
+#endif
+{
+    if (threadHealingPerfStats) {
+        threadHealingPerfStats->addStageDuration(
+                    "io.healing", std::chrono::steady_clock::now() - threadHealingStartTime);
+    }
+
+    return Standard_True;
+}
+
+const char* shapeHealingSequence(OccCommon::ShapeHealing healing)
+{
+    switch (healing) {
+    case OccCommon::ShapeHealing::Full: return "Full";
+    case OccCommon::ShapeHealing::Fast: return "Fast";
+    case OccCommon::ShapeHealing::None: return "None";
+    }
+
+    Q_UNREACHABLE();
+}
+
+// Content of the resource file, FixShape modes not specified are left to their default value(-1)
+std::string shapeHealingResource()
+{
+    std::string str;
+    auto fnAddFixShapeSequence = [&](const char* seq) {
+        str += std::string(seq) + ".exec.op : MayoHealingBegin FixShape MayoHealingEnd\n";
+        str += std::string(seq) + ".FixShape.Tolerance3d : &Runtime.Tolerance\n";
+        str += std::string(seq) + ".FixShape.MaxTolerance3d : &Runtime.MaxTolerance\n";
+        str += std::string(seq) + ".FixShape.MinTolerance3d : 1.e-7\n";
+    };
+    fnAddFixShapeSequence("Full");
+    fnAddFixShapeSequence("Fast");
+    str += "Fast.FixShape.FixShellMode : 0\n";
+    str += "Fast.FixShape.FixConnectedMode : 0\n";
+    str += "Fast.FixShape.FixSmallMode : 0\n";
+    str += "Fast.FixShape.FixSmallAreaWireMode : 0\n";
+    // A sequence must exist, otherwise OpenCascade applies default fixes
+    str += "None.exec.op : MayoHealingBegin MayoHealingEnd\n";
+    return str;
+}
+
+// Registers the timing operators and creates the resource file, returns false on failure
+bool initShapeHealingResource()
+{
+    static std::once_flag onceFlag;
+    static bool okInit = false;
+    std::call_once(onceFlag, []{
+        ShapeProcess::RegisterOperator("MayoHealingBegin", new ShapeProcess_UOperator(healingBeginOperator));
+        ShapeProcess::RegisterOperator("MayoHealingEnd", new ShapeProcess_UOperator(healingEndOperator));
+        static QTemporaryDir resourceDir;
+        if (!resourceDir.isValid())
+            return;
+
+        QFile file(resourceDir.filePath(ShapeHealingResourceName));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+            return;
+
+        const std::string strResource = shapeHealingResource();
+        okInit = file.write(strResource.c_str(), strResource.size()) == qint64(strResource.size());
+        file.close();
+        if (okInit) {
+            const QByteArray envVar = QByteArray("CSF_") + ShapeHealingResourceName + "Defaults";
+            qputenv(envVar.constData(), QDir::toNativeSeparators(resourceDir.path()).toLocal8Bit());
+        }
+    });
+
+    return okInit;
+}
+
+} // namespace
+
 const char* OccCommon::toCafString(OccCommon::LengthUnit unit)
 {
     switch (unit) {
@@ -26,5 +138,41 @@ const char* OccCommon::toCafString(OccCommon::LengthUnit unit)
     Q_UNREACHABLE();
 }
 
+void OccCommon::changeShapeHealingVariables(
+        std::string_view format, ShapeHealing healing, OccStaticVariablesContext* context)
+{
+    if (!initShapeHealingResource())
+        return;
+
+    const std::string strKeyPrefix = "read." + std::string(format);
+    context->change((strKeyPrefix + ".resource.name").c_str(), ShapeHealingResourceName);
+    context->change((strKeyPrefix + ".sequence").c_str(), shapeHealingSequence(healing));
+}
+
+void OccCommon::setShapeHealingDescriptions(PropertyEnum<ShapeHealing>* prop)
+{
+    prop->setDescription(
+                textIdTr("Fixes applied to the shapes after translation. Healing can take longer "
+                         "than the translation itself on faulty files"));
+    prop->setDescriptions({
+                { ShapeHealing::Full, textIdTr("All fixes, as done by default by OpenCascade") },
+                { ShapeHealing::Fast, textIdTr("Sewing of faces into shells and fixes of small "
+                  "edges are skipped") },
+                { ShapeHealing::None, textIdTr("Shapes are kept as translated, meshing may fail "
+                  "on faulty geometry") }
+    });
+}
+
+OccShapeHealingPerfScope::OccShapeHealingPerfScope(PerfStats* stats)
+    : m_previousStats(threadHealingPerfStats)
+{
+    threadHealingPerfStats = stats;
+}
+
+OccShapeHealingPerfScope::~OccShapeHealingPerfScope()
+{
+    threadHealingPerfStats = m_previousStats;
+}
+
 } // namespace IO
 } // namespace Mayo
@@ -13,9 +13,16 @@
 #  include <RWMesh_CoordinateSystem.hxx>
 #endif
 
+#include <string_view>
+
 namespace Mayo {
+
+class PerfStats;
+
 namespace IO {
 
+class OccStaticVariablesContext;
+
 class OccCommon {
     MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::OccCommon)
 public:
@@ -32,6 +39,37 @@ public:
     };
 
     static const char* toCafString(LengthUnit unit);
+
+    // Shape healing(ShapeProcess sequence) run by OpenCascade on the shapes translated from
+    // STEP/IGES files
+    enum class ShapeHealing {
+        Full, // All ShapeFix_Shape fixes, like the default sequence of OpenCascade
+        Fast, // Sewing of faces into shells and fixes of small edges are skipped
+        None  // Shapes are kept as translated
+    };
+
+    // Changes the "read.<format>.resource.name" and "read.<format>.sequence" static variables so
+    // the sequence of 'healing' gets applied. 'format' is the prefix of the variables("step", "iges")
+    // Sequences are defined by a resource file created at first call, if this fails then the default
+    // sequence of OpenCascade is left
+    static void changeShapeHealingVariables(
+            std::string_view format, ShapeHealing healing, OccStaticVariablesContext* context);
+
+    static void setShapeHealingDescriptions(PropertyEnum<ShapeHealing>* prop);
+};
+
+// Adds the time spent in the shape healing sequences run in the current thread as stage
+// "io.healing" of 'stats', for the lifetime of the scope object. Does nothing if 'stats' is null
+class OccShapeHealingPerfScope {
+public:
+    OccShapeHealingPerfScope(PerfStats* stats);
+    ~OccShapeHealingPerfScope();
+
+    OccShapeHealingPerfScope(const OccShapeHealingPerfScope&) = delete;
+    OccShapeHealingPerfScope& operator=(const OccShapeHealingPerfScope&) = delete;
+
+private:
+    PerfStats* m_previousStats = nullptr;
 };
 
 } // namespace IO
@@ -41,6 +79,11 @@ template<> struct EnumNames<IO::OccCommon::LengthUnit> {
     inline static const std::string_view junkPrefix = "";
 };
 
+template<> struct EnumNames<IO::OccCommon::ShapeHealing> {
+    inline static const QByteArray trContext = IO::OccCommon::textIdContext();
+    inline static const std::string_view junkPrefix = "";
+};
+
 #if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
 template<> struct EnumNames<RWMesh_CoordinateSystem> {
     inline static const QByteArray trContext = IO::OccCommon::textIdContext();
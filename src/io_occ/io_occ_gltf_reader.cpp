@@ -5,7 +5,27 @@
 ****************************************************************************/
 
 #include "io_occ_gltf_reader.h"
+#include "io_occ_caf.h"
+#include "../base/caf_utils.h"
+#include "../base/cpp_utils.h"
+#include "../base/deferred_shape_loader.h"
+#include "../base/document.h"
+#include "../base/global.h"
 #include "../base/property_builtins.h"
+#include "../base/task_progress.h"
+#include "../base/tkernel_utils.h"
+
+#include <BRepTools_ReShape.hxx>
+#include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace Mayo {
 namespace IO {
@@ -20,23 +40,143 @@ public:
                     textIdTr("Ignore nodes without geometry(`Yes` by default)"));
         this->useMeshNameAsFallback.setDescription(
                     textIdTr("Use mesh name in case if node name is empty(`Yes` by default)"));
+        this->loadDataOnDemand.setDescription(
+                    textIdTr("Don't decode vertex and index buffers on import, parts are loaded when "
+                             "they are shown. The glTF file must remain available afterwards\n\n"
+                             "Requires OpenCascade >= v7.6.0"));
     }
 
     void restoreDefaults() override {
         OccBaseMeshReaderProperties::restoreDefaults();
         this->skipEmptyNodes.setValue(true);
         this->useMeshNameAsFallback.setValue(true);
+        this->loadDataOnDemand.setValue(false);
     }
 
     PropertyBool skipEmptyNodes{ this, textId("skipEmptyNodes") };
     PropertyBool useMeshNameAsFallback{ this, textId("useMeshNameAsFallback") };
+    PropertyBool loadDataOnDemand{ this, textId("loadDataOnDemand") };
+};
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+// Decodes the deferred triangulations of the products imported with late data loading skipped
+// Faces of the imported shapes hold proxies knowing where buffers are located in the glTF file,
+// loaded shapes are copies of them with decoded triangulations so proxies can be restored later
+class OccGltfReader::ShapeLoader : public DeferredShapeLoader {
+public:
+    static bool hasDeferredData(const TopoDS_Shape& shape) {
+        for (TopExp_Explorer expl(shape, TopAbs_FACE); expl.More(); expl.Next()) {
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(TopoDS::Face(expl.Current()), loc);
+            if (!triangulation.IsNull() && triangulation->HasDeferredData())
+                return true;
+        }
+
+        return false;
+    }
+
+    void addProduct(const TDF_Label& label, const TopoDS_Shape& shape) {
+        if (m_mapLabelShape.insert({ label, shape }).second)
+            m_vecProductLabel.push_back(label);
+    }
+
+    bool isEmpty() const { return m_vecProductLabel.empty(); }
+
+    std::vector<TDF_Label> deferredProducts() const override {
+        return m_vecProductLabel;
+    }
+
+    bool isLoadedInBackground() const override { return false; }
+    bool isShapeTriangulated() const override { return true; }
+
+    TopoDS_Shape unloadedShape(const TDF_Label& labelProduct) const override {
+        auto itShape = m_mapLabelShape.find(labelProduct);
+        return itShape != m_mapLabelShape.cend() ? itShape->second : TopoDS_Shape();
+    }
+
+    TopoDS_Shape loadShape(const TDF_Label& labelProduct, TaskProgress* progress) override
+    {
+        auto itShape = m_mapLabelShape.find(labelProduct);
+        if (itShape == m_mapLabelShape.cend() || TaskProgress::isAbortRequested(progress))
+            return {};
+
+        // Faces can be instantiated many times within the product, decode them once
+        const TopoDS_Shape& proxyShape = itShape->second;
+        TopTools_IndexedMapOfShape mapFace;
+        for (TopExp_Explorer expl(proxyShape, TopAbs_FACE); expl.More(); expl.Next())
+            mapFace.Add(expl.Current().Located(TopLoc_Location()).Oriented(TopAbs_FORWARD));
+
+        // Each proxy reads its own buffers from the file, so faces can be decoded concurrently
+        const int faceCount = mapFace.Extent();
+        std::vector<TopoDS_Face> vecLoadedFace(faceCount);
+        std::atomic<int> doneCount = 0;
+        std::mutex mutexProgress;
+        CppUtils::parallelFor(faceCount, [&](int i) {
+            if (TaskProgress::isAbortRequested(progress))
+                return;
+
+            TopLoc_Location loc;
+            const TopoDS_Face& face = TopoDS::Face(mapFace.FindKey(i + 1));
+            const Handle_Poly_Triangulation& proxy = BRep_Tool::Triangulation(face, loc);
+            if (!proxy.IsNull() && proxy->HasDeferredData()) {
+                const Handle_Poly_Triangulation triangulation = proxy->DetachedLoadDeferredData();
+                if (!triangulation.IsNull()) {
+                    BRep_Builder().MakeFace(vecLoadedFace.at(i), triangulation);
+                    vecLoadedFace.at(i).Location(loc);
+                }
+            }
+
+            const int count = ++doneCount;
+            if (progress) {
+                std::lock_guard<std::mutex> lock(mutexProgress); MAYO_UNUSED(lock);
+                const int pct = (count * 100) / faceCount;
+                if (pct > progress->value())
+                    progress->setValue(pct);
+            }
+        });
+
+        if (TaskProgress::isAbortRequested(progress))
+            return {};
+
+        Handle_BRepTools_ReShape reshape = new BRepTools_ReShape;
+        for (int i = 0; i < faceCount; ++i) {
+            if (!vecLoadedFace.at(i).IsNull())
+                reshape->Replace(mapFace.FindKey(i + 1), vecLoadedFace.at(i));
+        }
+
+        return reshape->Apply(proxyShape);
+    }
+
+private:
+    std::vector<TDF_Label> m_vecProductLabel;
+    std::unordered_map<TDF_Label, TopoDS_Shape> m_mapLabelShape; // Shapes holding the proxies
 };
+#endif
 
 OccGltfReader::OccGltfReader()
     : OccBaseMeshReader(m_reader)
 {
 }
 
+bool OccGltfReader::readStream(std::istream& istr, const FilePath& name, TaskProgress* progress)
+{
+    // Temporary file is removed along with the reader, buffers can't be decoded on demand later
+    const bool loadDataOnDemand = m_params.loadDataOnDemand;
+    m_params.loadDataOnDemand = false;
+    const bool okRead = OccBaseMeshReader::readStream(istr, name, progress);
+    m_params.loadDataOnDemand = loadDataOnDemand;
+    return okRead;
+}
+
+TDF_LabelSequence OccGltfReader::transfer(DocumentPtr doc, TaskProgress* progress)
+{
+    const TDF_LabelSequence seqEntity = OccBaseMeshReader::transfer(doc, progress);
+    if (m_params.loadDataOnDemand && !TaskProgress::isAbortRequested(progress))
+        this->attachShapeLoader(doc, seqEntity);
+
+    return seqEntity;
+}
+
 std::unique_ptr<PropertyGroup> OccGltfReader::createProperties(PropertyGroup* parentGroup)
 {
     return std::make_unique<Properties>(parentGroup);
@@ -49,6 +189,7 @@ void OccGltfReader::applyProperties(const PropertyGroup* params)
     if (ptr) {
         m_params.useMeshNameAsFallback = ptr->useMeshNameAsFallback;
         m_params.skipEmptyNodes = ptr->skipEmptyNodes;
+        m_params.loadDataOnDemand = ptr->loadDataOnDemand;
     }
 }
 
@@ -57,6 +198,49 @@ void OccGltfReader::applyParameters()
     OccBaseMeshReader::applyParameters();
     m_reader.SetSkipEmptyNodes(m_params.skipEmptyNodes);
     m_reader.SetMeshNameAsFallback(m_params.useMeshNameAsFallback);
+    // Buffers are decoded concurrently, progress reported from worker threads is supported by
+    // OccProgressIndicator
+    m_reader.SetParallel(true);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    // Proxies must keep their late data so buffers can still be decoded after the import
+    m_reader.SetToSkipLateDataLoading(m_params.loadDataOnDemand);
+    m_reader.SetToKeepLateData(true);
+#endif
+}
+
+void OccGltfReader::attachShapeLoader(const DocumentPtr& doc, const TDF_LabelSequence& seqEntity)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    // Products are the simple shapes of the imported assemblies, sub-assemblies can be
+    // instantiated many times
+    auto loader = std::make_shared<ShapeLoader>();
+    std::unordered_set<TDF_Label> setLabelVisited;
+    std::function<void(const TDF_Label&)> fnAddProducts;
+    fnAddProducts = [&](const TDF_Label& label) {
+        if (!setLabelVisited.insert(label).second)
+            return;
+
+        if (XCaf::isShapeAssembly(label)) {
+            for (const TDF_Label& lblComponent : XCaf::shapeComponents(label))
+                fnAddProducts(XCaf::shapeReferred(lblComponent));
+        }
+        else {
+            const TopoDS_Shape shape = XCaf::shape(label);
+            if (ShapeLoader::hasDeferredData(shape))
+                loader->addProduct(label, shape);
+        }
+    };
+    for (const TDF_Label& labelEntity : seqEntity)
+        fnAddProducts(labelEntity);
+
+    if (!loader->isEmpty()) {
+        MayoIO_CafDocumentScopedLock(docLock, doc);
+        doc->addDeferredShapeLoader(loader);
+    }
+#else
+    MAYO_UNUSED(doc);
+    MAYO_UNUSED(seqEntity);
+#endif
 }
 
 } // namespace IO
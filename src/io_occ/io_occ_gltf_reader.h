@@ -18,6 +18,10 @@ class OccGltfReader : public OccBaseMeshReader {
 public:
     OccGltfReader();
 
+    // Stream is copied into a temporary file, so only self-contained data can be read(eg GLB)
+    bool readStream(std::istream& istr, const FilePath& name, TaskProgress* progress) override;
+    TDF_LabelSequence transfer(DocumentPtr doc, TaskProgress* progress) override;
+
     static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
     void applyProperties(const PropertyGroup* params) override;
 
@@ -26,6 +30,10 @@ public:
     struct Parameters : public OccBaseMeshReader::Parameters {
         bool skipEmptyNodes = true;
         bool useMeshNameAsFallback = true;
+        // Vertex and index buffers aren't decoded on import, faces hold triangulation proxies with
+        // bounding boxes only. Buffers are decoded with the DeferredShapeLoader attached to the
+        // document. Requires OpenCascade >= v7.6.0
+        bool loadDataOnDemand = false;
     };
     OccGltfReader::Parameters& parameters() override { return m_params; }
     const OccGltfReader::Parameters& constParameters() const override { return m_params; }
@@ -34,7 +42,10 @@ protected:
     void applyParameters() override;
 
 private:
+    void attachShapeLoader(const DocumentPtr& doc, const TDF_LabelSequence& seqEntity);
+
     class Properties;
+    class ShapeLoader;
     Parameters m_params;
     mutable RWGltf_CafReader m_reader;
 };
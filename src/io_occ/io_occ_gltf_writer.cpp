@@ -7,15 +7,22 @@
 #include "io_occ_gltf_writer.h"
 
 #include "../base/application_item.h"
+#include "../base/brep_utils.h"
+#include "../base/document.h"
+#include "../base/global.h"
 #include "../base/occ_progress_indicator.h"
 #include "../base/property_builtins.h"
 #include "../base/property_enumeration.h"
 #include "../base/enumeration_fromenum.h"
 #include "../base/string_utils.h"
+#include "../base/task_progress.h"
 #include "../base/text_id.h"
 #include "io_occ_common.h"
 
 #include <RWGltf_CafWriter.hxx>
+#include <Standard_Version.hxx>
+#include <array>
+#include <mutex>
 
 namespace Mayo {
 namespace IO {
@@ -41,6 +48,35 @@ public:
                     { RWGltf_WriterTrsfFormat_TRS, textIdTr("Transformation decomposed into Translation "
                       "vector, Rotation quaternion and Scale factor(T * R * S)") }
         });
+
+        this->mergeFaces.setDescription(
+                    textIdTr("Merge the faces of a product into a single glTF primitive.\n"
+                             "Geometry of a product is written once and shared by all its "
+                             "instances, this option reduces further the count of primitives.\n"
+                             "Requires OpenCascade >= v7.6.0"));
+        this->optimizeVertexCache.setDescription(
+                    textIdTr("Reorder mesh triangles for vertex cache locality, so exported meshes "
+                             "render faster in GPU-based viewers"));
+        this->dracoCompression.setDescription(
+                    textIdTr("Compress meshes with Draco(KHR_draco_mesh_compression extension).\n"
+                             "Requires OpenCascade >= v7.6.0 built with Draco"));
+        this->dracoCompressionLevel.setDescription(
+                    textIdTr("Draco compression level, from 0(fastest) to 10(best size)"));
+        this->dracoQuantizePositionBits.setDescription(
+                    textIdTr("Number of quantization bits used for mesh positions"));
+        this->dracoQuantizeNormalBits.setDescription(
+                    textIdTr("Number of quantization bits used for mesh normals"));
+        this->dracoQuantizeTexcoordBits.setDescription(
+                    textIdTr("Number of quantization bits used for mesh texture coordinates"));
+        this->parallelCompression.setDescription(
+                    textIdTr("Compress meshes concurrently on multiple threads"));
+
+        for (PropertyInt* prop : this->dracoIntProperties()) {
+            prop->setConstraintsEnabled(true);
+            prop->setRange(1, 30);
+        }
+
+        this->dracoCompressionLevel.setRange(0, 10);
     }
 
     void restoreDefaults() override {
@@ -49,15 +85,54 @@ public:
         this->transformationFormat.setValue(defaults.transformationFormat);
         this->format.setValue(defaults.format);
         this->forceExportUV.setValue(defaults.forceExportUV);
+        this->mergeFaces.setValue(defaults.mergeFaces);
+        this->optimizeVertexCache.setValue(defaults.optimizeVertexCache);
+        this->dracoCompression.setValue(defaults.dracoCompression);
+        this->dracoCompressionLevel.setValue(defaults.dracoCompressionLevel);
+        this->dracoQuantizePositionBits.setValue(defaults.dracoQuantizePositionBits);
+        this->dracoQuantizeNormalBits.setValue(defaults.dracoQuantizeNormalBits);
+        this->dracoQuantizeTexcoordBits.setValue(defaults.dracoQuantizeTexcoordBits);
+        this->parallelCompression.setValue(defaults.parallelCompression);
+        this->updateDracoPropertiesEnabled();
+    }
+
+    void onPropertyChanged(Property* prop) override
+    {
+        if (prop == &this->dracoCompression)
+            this->updateDracoPropertiesEnabled();
+
+        PropertyGroup::onPropertyChanged(prop);
+    }
+
+    std::array<PropertyInt*, 4> dracoIntProperties() {
+        return { &this->dracoCompressionLevel,
+                 &this->dracoQuantizePositionBits,
+                 &this->dracoQuantizeNormalBits,
+                 &this->dracoQuantizeTexcoordBits };
+    }
+
+    void updateDracoPropertiesEnabled() {
+        for (PropertyInt* prop : this->dracoIntProperties())
+            prop->setEnabled(this->dracoCompression);
+
+        this->parallelCompression.setEnabled(this->dracoCompression);
     }
 
     PropertyEnum<RWMesh_CoordinateSystem> coordinatesConverter{ this, textId("coordinatesConverter") };
     PropertyEnum<RWGltf_WriterTrsfFormat> transformationFormat{ this, textId("transformationFormat") };
     PropertyEnum<Format> format{ this, textId("format") };
     PropertyBool forceExportUV{ this, textId("forceExportUV") };
+    PropertyBool mergeFaces{ this, textId("mergeFaces") };
+    PropertyBool optimizeVertexCache{ this, textId("optimizeVertexCache") };
+    PropertyBool dracoCompression{ this, textId("dracoCompression") };
+    PropertyInt dracoCompressionLevel{ this, textId("dracoCompressionLevel") };
+    PropertyInt dracoQuantizePositionBits{ this, textId("dracoQuantizePositionBits") };
+    PropertyInt dracoQuantizeNormalBits{ this, textId("dracoQuantizeNormalBits") };
+    PropertyInt dracoQuantizeTexcoordBits{ this, textId("dracoQuantizeTexcoordBits") };
+    PropertyBool parallelCompression{ this, textId("parallelCompression") };
 };
 
-bool OccGltfWriter::transfer(Span<const ApplicationItem> spanAppItem, TaskProgress*)
+bool OccGltfWriter::transfer(Span<const ApplicationItem> spanAppItem, TaskProgress* progress)
 {
     m_document.Nullify();
     m_seqRootLabel.Clear();
@@ -74,7 +149,7 @@ bool OccGltfWriter::transfer(Span<const ApplicationItem> spanAppItem, TaskProgre
         }
     }
 
-    if (!m_document)
+    if (!m_document || TaskProgress::isAbortRequested(progress))
         return false;
 
     return true;
@@ -85,9 +160,43 @@ bool OccGltfWriter::writeFile(const FilePath& filepath, TaskProgress* progress)
     if (!m_document)
         return false;
 
-    Handle_Message_ProgressIndicator occProgress = new OccProgressIndicator(progress);
+    if (m_params.optimizeVertexCache) {
+        // Triangle order is irrelevant to the document, but triangulations mustn't be changed while
+        // other tasks(eg meshing) are using them
+        TaskProgress optimizeProgress(progress, 10);
+        std::lock_guard<std::mutex> lock(m_document->dataMutex()); MAYO_UNUSED(lock);
+        if (m_seqRootLabel.IsEmpty()) {
+            for (const TDF_Label& label : m_document->xcaf().topLevelFreeShapes())
+                BRepUtils::optimizeMeshVertexCache(XCaf::shape(label), &optimizeProgress);
+        }
+        else {
+            for (const TDF_Label& label : m_seqRootLabel)
+                BRepUtils::optimizeMeshVertexCache(XCaf::shape(label), &optimizeProgress);
+        }
+    }
+
+    // RWGltf_CafWriter maps mesh data by product shape(referred label without instance location),
+    // so triangulations of repeated components are written once and instances become glTF nodes
+    TaskProgress writeProgress(progress, m_params.optimizeVertexCache ? 90 : 100);
+    Handle_Message_ProgressIndicator occProgress = new OccProgressIndicator(&writeProgress);
     const bool isBinary = m_params.format == Format::Binary;
     RWGltf_CafWriter writer(filepath.u8string().c_str(), isBinary);
+    writer.ChangeCoordinateSystemConverter().SetInputCoordinateSystem(m_params.coordinatesConverter);
+    writer.SetTransformationFormat(m_params.transformationFormat);
+    writer.SetForcedUVExport(m_params.forceExportUV);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    writer.SetMergeFaces(m_params.mergeFaces);
+    writer.SetSplitIndices16(m_params.mergeFaces); // Keep 16-bit indices for merged primitives
+    RWGltf_DracoParameters dracoParams;
+    dracoParams.DracoCompression = m_params.dracoCompression;
+    dracoParams.CompressionLevel = m_params.dracoCompressionLevel;
+    dracoParams.QuantizePositionBits = m_params.dracoQuantizePositionBits;
+    dracoParams.QuantizeNormalBits = m_params.dracoQuantizeNormalBits;
+    dracoParams.QuantizeTexcoordBits = m_params.dracoQuantizeTexcoordBits;
+    writer.SetCompressionParameters(dracoParams);
+    writer.SetParallel(m_params.parallelCompression);
+#endif
+
     const TColStd_IndexedDataMapOfStringString fileInfo;
     if (m_seqRootLabel.IsEmpty())
         return writer.Perform(m_document, fileInfo, occProgress->Start());
@@ -95,6 +204,15 @@ bool OccGltfWriter::writeFile(const FilePath& filepath, TaskProgress* progress)
         return writer.Perform(m_document, m_seqRootLabel, nullptr, fileInfo, occProgress->Start());
 }
 
+bool OccGltfWriter::writeStream(std::ostream& ostr, TaskProgress* progress)
+{
+    // RWGltf_CafWriter writes text format along with a separate ".bin" file
+    if (m_params.format != Format::Binary)
+        return false;
+
+    return Writer::writeStream(ostr, progress);
+}
+
 std::unique_ptr<PropertyGroup> OccGltfWriter::createProperties(PropertyGroup* parentGroup)
 {
     return std::make_unique<Properties>(parentGroup);
@@ -106,8 +224,16 @@ void OccGltfWriter::applyProperties(const PropertyGroup* params)
     if (ptr) {
         m_params.coordinatesConverter = ptr->coordinatesConverter;
         m_params.forceExportUV = ptr->forceExportUV;
+        m_params.mergeFaces = ptr->mergeFaces;
+        m_params.optimizeVertexCache = ptr->optimizeVertexCache;
         m_params.format = ptr->format;
         m_params.transformationFormat = ptr->transformationFormat;
+        m_params.dracoCompression = ptr->dracoCompression;
+        m_params.dracoCompressionLevel = ptr->dracoCompressionLevel;
+        m_params.dracoQuantizePositionBits = ptr->dracoQuantizePositionBits;
+        m_params.dracoQuantizeNormalBits = ptr->dracoQuantizeNormalBits;
+        m_params.dracoQuantizeTexcoordBits = ptr->dracoQuantizeTexcoordBits;
+        m_params.parallelCompression = ptr->parallelCompression;
     }
 }
 
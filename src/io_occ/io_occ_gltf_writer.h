@@ -22,9 +22,12 @@ class OccGltfWriter : public Writer {
 public:
     bool transfer(Span<const ApplicationItem> spanAppItem, TaskProgress* progress) override;
     bool writeFile(const FilePath& filepath, TaskProgress* progress) override;
+    // Only binary format(GLB) can be written into a stream, text format needs buffer files
+    bool writeStream(std::ostream& ostr, TaskProgress* progress) override;
 
     static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
     void applyProperties(const PropertyGroup* params) override;
+    bool modifiesItemsData() const override { return m_params.optimizeVertexCache; }
 
     // Parameters
 
@@ -35,6 +38,17 @@ public:
         RWGltf_WriterTrsfFormat transformationFormat = RWGltf_WriterTrsfFormat_Compact;
         Format format = Format::Binary;
         bool forceExportUV = false;
+        // Faces of a product are merged into a single primitive, requires OpenCascade >= v7.6.0
+        bool mergeFaces = false;
+        // Face triangles are reordered for GPU vertex cache locality before writing
+        bool optimizeVertexCache = false;
+        // Draco mesh compression, requires OpenCascade >= v7.6.0 built with Draco
+        bool dracoCompression = false;
+        int dracoCompressionLevel = 7; // 0: fastest, 10: best size
+        int dracoQuantizePositionBits = 14;
+        int dracoQuantizeNormalBits = 10;
+        int dracoQuantizeTexcoordBits = 12;
+        bool parallelCompression = true; // Meshes are compressed on worker threads
     };
     Parameters& parameters() { return m_params; }
     const Parameters& constParameters() const { return m_params; }
@@ -6,14 +6,27 @@
 
 #include "io_occ_iges.h"
 #include "io_occ_caf.h"
-#include "../base/occ_static_variables_rollback.h"
+#include "../base/cpp_utils.h"
+#include "../base/document.h"
+#include "../base/occ_static_variables_context.h"
+#include "../base/perf_stats.h"
 #include "../base/property_builtins.h"
 #include "../base/property_enumeration.h"
 #include "../base/task_progress.h"
 #include "../base/enumeration_fromenum.h"
 
 #include <IGESControl_Controller.hxx>
+#include <IGESData_IGESModel.hxx>
+#include <IGESToBRep_Actor.hxx>
 #include <Interface_Static.hxx>
+#include <TColStd_HSequenceOfTransient.hxx>
+#include <Transfer_TransientProcess.hxx>
+#include <XSControl_TransferReader.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 namespace Mayo {
 namespace IO {
@@ -52,6 +65,11 @@ public:
                              "in the same point (note that this case is incorrect according to the IGES standard)"));
 
         this->readFaultyEntities.setDescription(textIdTr("Read failed entities"));
+        OccCommon::setShapeHealingDescriptions(&this->shapeHealing);
+        this->parallelEntityTransfer.setDescription(
+                    textIdTr("Translate the root entities over worker threads before building the "
+                             "document, names, colors and layers.\n"
+                             "Speeds up IGES files made of many independent surfaces"));
 
         this->bsplineContinuity.setDescriptions({
                     { BSplineContinuity::NoChange, textIdTr("Curves are taken as they are in the IGES "
@@ -81,17 +99,21 @@ public:
         this->surfaceCurveMode.setValue(params.surfaceCurveMode);
         this->readFaultyEntities.setValue(params.readFaultyEntities);
         this->readOnlyVisibleEntities.setValue(params.readOnlyVisibleEntities);
+        this->shapeHealing.setValue(params.shapeHealing);
+        this->parallelEntityTransfer.setValue(params.parallelEntityTransfer);
     }
 
     PropertyEnum<BSplineContinuity> bsplineContinuity{ this, textId("bsplineContinuity") };
     PropertyEnum<SurfaceCurveMode> surfaceCurveMode{ this, textId("surfaceCurveMode") };
     PropertyBool readFaultyEntities{ this, textId("readFaultyEntities") };
     PropertyBool readOnlyVisibleEntities{ this, textId("readOnlyVisibleEntities") };
+    PropertyEnum<OccCommon::ShapeHealing> shapeHealing{ this, textId("shapeHealing") };
+    PropertyBool parallelEntityTransfer{ this, textId("parallelEntityTransfer") };
 };
 
 OccIgesReader::OccIgesReader()
 {
-    MayoIO_CafGlobalScopedLock(cafLock);
+    MayoIO_CafStaticVariablesScopedLock(cafLock);
     m_reader = new(&m_readerStorage) IGESCAFControl_Reader();
     IGESControl_Controller::Init();
     m_reader->SetColorMode(true);
@@ -104,20 +126,121 @@ OccIgesReader::~OccIgesReader()
     m_reader->~IGESCAFControl_Reader();
 }
 
+bool OccIgesReader::resetSession()
+{
+    MayoIO_CafStaticVariablesScopedLock(cafLock);
+    // Creates a new empty model and clears the transfer maps, reader modes are kept
+    m_reader->SetWS(Private::cafWorkSession(*m_reader), true/*scratch*/);
+    m_reader->ClearShapes();
+    m_params = {};
+    this->removeSpoolFile();
+    return true;
+}
+
 bool OccIgesReader::readFile(const FilePath& filepath, TaskProgress* progress)
 {
-    MayoIO_CafGlobalScopedLock(cafLock);
-    OccStaticVariablesRollback rollback;
-    this->changeStaticVariables(&rollback);
+    MayoIO_CafIgesParserScopedLock(parserLock);
+    OccStaticVariablesContext context;
+    this->changeStaticVariables(&context);
+    OccStaticVariablesScope staticVarsScope(context);
     return Private::cafReadFile(*m_reader, filepath, progress);
 }
 
 TDF_LabelSequence OccIgesReader::transfer(DocumentPtr doc, TaskProgress* progress)
 {
-    MayoIO_CafGlobalScopedLock(cafLock);
-    OccStaticVariablesRollback rollback;
-    this->changeStaticVariables(&rollback);
-    return Private::cafTransfer(*m_reader, doc, progress);
+    MayoIO_CafDocumentScopedLock(docLock, doc);
+    OccStaticVariablesContext context;
+    this->changeStaticVariables(&context);
+    OccStaticVariablesScope staticVarsScope(context);
+    OccShapeHealingPerfScope healingPerfScope(PerfStats::of(progress));
+    if (!m_params.parallelEntityTransfer)
+        return Private::cafTransfer(*m_reader, doc, progress);
+
+    TaskProgress entitiesProgress(progress, 60);
+    this->transferRootEntitiesInParallel(&entitiesProgress);
+    TaskProgress cafProgress(progress, 40);
+    return Private::cafTransfer(*m_reader, doc, &cafProgress);
+}
+
+void OccIgesReader::transferRootEntitiesInParallel(TaskProgress* progress)
+{
+    // Root entities are translated here over worker threads, then bound into the transient process
+    // of the reader. IGESCAFControl_Reader::Transfer() afterwards finds them already translated and
+    // only builds the document in the order of roots, with names, colors and layers
+    Handle_XSControl_WorkSession ws = Private::cafWorkSession(*m_reader);
+    const Handle_XSControl_TransferReader& transferReader = ws->TransferReader();
+    auto model = Handle_IGESData_IGESModel::DownCast(ws->Model());
+    if (!model || !transferReader->BeginTransfer())
+        return;
+
+    // Same selection of roots as the standard transfer(eg only visible entities)
+    const Handle_TColStd_HSequenceOfTransient seqRoot = ws->GiveList("xst-transferrable-roots");
+    const Handle_Transfer_TransientProcess mainTp = transferReader->TransientProcess();
+    std::vector<Handle_Standard_Transient> vecRoot;
+    for (int i = 1; seqRoot && i <= seqRoot->Length(); ++i) {
+        if (!mainTp->IsBound(seqRoot->Value(i)))
+            vecRoot.push_back(seqRoot->Value(i));
+    }
+
+    if (vecRoot.size() < 2)
+        return;
+
+    // Roots are dispatched by chunks, small enough to balance the load of workers
+    const int threadCount = std::max(int(std::thread::hardware_concurrency()), 1);
+    const int rootCount = int(vecRoot.size());
+    const int workerCount = std::min(threadCount, rootCount);
+    const int chunkSize = std::clamp(rootCount / (8 * workerCount), 1, 256);
+    const int continuity = Interface_Static::IVal("read.iges.bspline.continuity");
+    std::vector<Handle_Transfer_TransientProcess> vecTp;
+    for (int i = 0; i < workerCount; ++i) {
+        Handle_Transfer_TransientProcess tp = new Transfer_TransientProcess(model->NbEntities());
+        tp->SetModel(model);
+        tp->SetGraph(ws->HGraph());
+        vecTp.push_back(tp);
+    }
+
+    std::atomic<int> chunkIndexSeq = 0;
+    std::atomic<int> rootDoneCount = 0;
+    CppUtils::parallelFor(workerCount, [&](int iWorker) {
+        OccShapeHealingPerfScope healingPerfScope(PerfStats::of(progress));
+        const Handle_Transfer_TransientProcess& tp = vecTp.at(iWorker);
+        Handle_IGESToBRep_Actor actor = new IGESToBRep_Actor;
+        actor->SetModel(model);
+        actor->SetContinuity(continuity);
+        for (int iChunk = chunkIndexSeq++; iChunk * chunkSize < rootCount; iChunk = chunkIndexSeq++) {
+            if (TaskProgress::isAbortRequested(progress))
+                return;
+
+            const int iRootEnd = std::min(rootCount, (iChunk + 1) * chunkSize);
+            for (int i = iChunk * chunkSize; i < iRootEnd; ++i) {
+                const Handle_Standard_Transient& root = vecRoot.at(i);
+                try {
+                    Handle_Transfer_Binder binder = actor->Transfer(root, tp);
+                    if (binder && binder->HasResult() && !tp->IsBound(root))
+                        tp->Bind(root, binder);
+                } catch (const Standard_Failure&) {
+                    // Root is left to the standard transfer, which reports the failure
+                }
+            }
+
+            const int doneCount = rootDoneCount += iRootEnd - iChunk * chunkSize;
+            if (progress && iWorker == 0)
+                progress->setValue((doneCount * 100) / rootCount);
+        }
+    });
+
+    // Merge the bindings of workers(roots and their sub-entities) into the reader
+    for (const Handle_Transfer_TransientProcess& tp : vecTp) {
+        for (int i = 1; i <= tp->NbMapped(); ++i) {
+            const Handle_Transfer_Binder binder = tp->MapItem(i);
+            const Handle_Standard_Transient& entity = tp->Mapped(i);
+            if (binder && binder->HasResult() && !mainTp->IsBound(entity))
+                mainTp->Bind(entity, binder);
+        }
+    }
+
+    if (progress)
+        progress->setValue(100);
 }
 
 std::unique_ptr<PropertyGroup> OccIgesReader::createProperties(PropertyGroup* parentGroup)
@@ -133,15 +256,18 @@ void OccIgesReader::applyProperties(const PropertyGroup* group)
         m_params.surfaceCurveMode = ptr->surfaceCurveMode;
         m_params.readFaultyEntities = ptr->readFaultyEntities;
         m_params.readOnlyVisibleEntities = ptr->readOnlyVisibleEntities;
+        m_params.shapeHealing = ptr->shapeHealing;
+        m_params.parallelEntityTransfer = ptr->parallelEntityTransfer;
     }
 }
 
-void OccIgesReader::changeStaticVariables(OccStaticVariablesRollback* rollback) const
+void OccIgesReader::changeStaticVariables(OccStaticVariablesContext* context) const
 {
-    rollback->change("read.iges.bspline.continuity", int(m_params.bsplineContinuity));
-    rollback->change("read.surfacecurve.mode", int(m_params.surfaceCurveMode));
-    rollback->change("read.iges.faulty.entities", int(m_params.readFaultyEntities ? 1 : 0));
-    rollback->change("read.iges.onlyvisible", int(m_params.readOnlyVisibleEntities ? 1 : 0));
+    context->change("read.iges.bspline.continuity", int(m_params.bsplineContinuity));
+    context->change("read.surfacecurve.mode", int(m_params.surfaceCurveMode));
+    context->change("read.iges.faulty.entities", int(m_params.readFaultyEntities ? 1 : 0));
+    context->change("read.iges.onlyvisible", int(m_params.readOnlyVisibleEntities ? 1 : 0));
+    OccCommon::changeShapeHealingVariables("iges", m_params.shapeHealing, context);
 }
 
 class OccIgesWriter::Properties : public PropertyGroup {
@@ -177,7 +303,7 @@ public:
 
 OccIgesWriter::OccIgesWriter()
 {
-    MayoIO_CafGlobalScopedLock(cafLock);
+    MayoIO_CafStaticVariablesScopedLock(cafLock);
     m_writer = new(&m_writerStorage) IGESCAFControl_Writer();
     IGESControl_Controller::Init();
     m_writer->SetColorMode(true);
@@ -192,17 +318,21 @@ OccIgesWriter::~OccIgesWriter()
 
 bool OccIgesWriter::transfer(Span<const ApplicationItem> appItems, TaskProgress* progress)
 {
-    MayoIO_CafGlobalScopedLock(cafLock);
-    OccStaticVariablesRollback rollback;
-    this->changeStaticVariables(&rollback);
+    OccStaticVariablesContext context;
+    this->changeStaticVariables(&context);
+    OccStaticVariablesScope staticVarsScope(context);
     return Private::cafTransfer(*m_writer, appItems, progress);
 }
 
-bool OccIgesWriter::writeFile(const FilePath& filepath, TaskProgress* /*progress*/)
+bool OccIgesWriter::writeFile(const FilePath& filepath, TaskProgress* progress)
 {
-    MayoIO_CafGlobalScopedLock(cafLock);
-    OccStaticVariablesRollback rollback;
-    this->changeStaticVariables(&rollback);
+    // OpenCascade writer doesn't check user break
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
+    OccStaticVariablesContext context;
+    this->changeStaticVariables(&context);
+    OccStaticVariablesScope staticVarsScope(context);
     m_writer->ComputeModel();
     const bool ok = m_writer->Write(filepath.u8string().c_str());
     return ok;
@@ -223,11 +353,11 @@ void OccIgesWriter::applyProperties(const PropertyGroup* group)
     }
 }
 
-void OccIgesWriter::changeStaticVariables(OccStaticVariablesRollback* rollback)
+void OccIgesWriter::changeStaticVariables(OccStaticVariablesContext* context) const
 {
-    rollback->change("write.iges.brep.mode", int(m_params.brepMode));
-    rollback->change("write.iges.plane.mode", int(m_params.planeMode));
-    rollback->change("write.iges.unit", OccCommon::toCafString(m_params.lengthUnit));
+    context->change("write.iges.brep.mode", int(m_params.brepMode));
+    context->change("write.iges.plane.mode", int(m_params.planeMode));
+    context->change("write.iges.unit", OccCommon::toCafString(m_params.lengthUnit));
 }
 
 } // namespace IO
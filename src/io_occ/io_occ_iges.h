@@ -15,7 +15,7 @@
 namespace Mayo {
 namespace IO {
 
-class OccStaticVariablesRollback;
+class OccStaticVariablesContext;
 
 // Opencascade-based reader for IGES file format
 class OccIgesReader : public Reader {
@@ -42,11 +42,14 @@ public:
         Force3D = -3
     };
 
+    using ShapeHealing = OccCommon::ShapeHealing;
     struct Parameters {
         BSplineContinuity bsplineContinuity = BSplineContinuity::BreakIntoC1Pieces;
         SurfaceCurveMode surfaceCurveMode = SurfaceCurveMode::Default;
         bool readFaultyEntities = false;
         bool readOnlyVisibleEntities = false;
+        ShapeHealing shapeHealing = ShapeHealing::Full;
+        bool parallelEntityTransfer = false;
     };
     Parameters& parameters() { return m_params; }
     const Parameters& constParameters() const { return m_params; }
@@ -54,8 +57,11 @@ public:
     static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
     void applyProperties(const PropertyGroup* group) override;
 
+    bool resetSession() override;
+
 private:
-    void changeStaticVariables(OccStaticVariablesRollback* rollback) const;
+    void changeStaticVariables(OccStaticVariablesContext* context) const;
+    void transferRootEntitiesInParallel(TaskProgress* progress);
 
     class Properties;
     IGESCAFControl_Reader* m_reader = nullptr;
@@ -99,7 +105,7 @@ public:
     void applyProperties(const PropertyGroup* group) override;
 
 private:
-    void changeStaticVariables(OccStaticVariablesRollback* rollback);
+    void changeStaticVariables(OccStaticVariablesContext* context) const;
 
     class Properties;
     IGESCAFControl_Writer* m_writer = nullptr;
@@ -5,11 +5,478 @@
 ****************************************************************************/
 
 #include "io_occ_obj.h"
+#include "../base/caf_utils.h"
+#include "../base/cpp_utils.h"
+#include "../base/document.h"
+#include "../base/mapped_file.h"
 #include "../base/property_builtins.h"
+#include "../base/task_progress.h"
+
+#include <BRep_Builder.hxx>
+#include <QtCore/QFile>
+#include <RWMesh_CoordinateSystemConverter.hxx>
+#include <TDataXtd_Triangulation.hxx>
+#include <TopoDS_Face.hxx>
+#include <XCAFDoc_ColorTool.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+#include <fast_float/fast_float.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace Mayo {
 namespace IO {
 
+namespace {
+
+// Index of vertex referenced by a face
+// Negative OBJ indices are relative to the vertices defined so far, they are resolved once all
+// chunks are parsed
+struct ObjVertexRef {
+    int index; // Absolute(0-based) or relative to the first vertex of the chunk
+    bool isChunkRelative;
+};
+
+// Statement changing the current group or material, or referencing a material library
+struct ObjStatement {
+    enum class Type { Group, Material, MaterialLib };
+    Type type;
+    std::string arg;
+    size_t triangleVertexPos; // Count of triangle vertices in the chunk before the statement
+    size_t trianglePos; // Count of valid triangles in the chunk before the statement
+};
+
+// Results of the parsing of a chunk of lines
+struct ObjChunk {
+    std::vector<gp_XYZ> vecPosition;
+    std::vector<ObjVertexRef> vecTriangleVertex; // Polygons are fan-triangulated
+    std::vector<ObjStatement> vecStatement;
+};
+
+// Triangles of a group with a single material, maybe spanning several chunks
+struct ObjPrimitive {
+    struct Range {
+        int iChunk;
+        size_t triangleBegin;
+        size_t triangleEnd;
+    };
+
+    std::string groupName;
+    std::string materialName;
+    std::vector<Range> vecRange;
+    Handle_Poly_Triangulation mesh;
+};
+
+// Result of objReadFileFast()
+struct ObjFastResult {
+    std::vector<ObjPrimitive> vecPrimitive;
+    std::vector<std::string> vecMaterialLib;
+};
+
+bool objIsBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+const char* objSkipBlanks(const char* it, const char* itEnd)
+{
+    while (it < itEnd && objIsBlank(*it))
+        ++it;
+
+    return it;
+}
+
+// Start of the arguments if line [it, itLineEnd) is a 'keyword' statement, nullptr otherwise
+const char* objStatementArgs(const char* it, const char* itLineEnd, std::string_view keyword)
+{
+    if (size_t(itLineEnd - it) < keyword.size() || std::memcmp(it, keyword.data(), keyword.size()) != 0)
+        return nullptr;
+
+    it += keyword.size();
+    if (it < itLineEnd && !objIsBlank(*it))
+        return nullptr;
+
+    return objSkipBlanks(it, itLineEnd);
+}
+
+std::string objTrimmedString(const char* it, const char* itEnd)
+{
+    while (itEnd > it && objIsBlank(*(itEnd - 1)))
+        --itEnd;
+
+    return std::string(it, itEnd);
+}
+
+// Parses "v", "f", "o", "g", "usemtl" and "mtllib" statements of lines in [itBegin, itEnd), which
+// must start at a line boundary
+void objParseChunk(const char* itBegin, const char* itEnd, ObjChunk* chunk)
+{
+    std::vector<ObjVertexRef> vecPolygonVertex;
+    const char* itLine = itBegin;
+    while (itLine < itEnd) {
+        const char* itLineEnd = static_cast<const char*>(std::memchr(itLine, '\n', itEnd - itLine));
+        itLineEnd = itLineEnd ? itLineEnd : itEnd;
+        const char* it = objSkipBlanks(itLine, itLineEnd);
+        const bool isVertex = itLineEnd - it > 1 && it[0] == 'v' && objIsBlank(it[1]);
+        const bool isFace = itLineEnd - it > 1 && it[0] == 'f' && objIsBlank(it[1]);
+        if (isVertex) {
+            double coords[3] = {};
+            bool ok = true;
+            it += 2;
+            for (int i = 0; i < 3 && ok; ++i) {
+                it = objSkipBlanks(it, itLineEnd);
+                const fast_float::from_chars_result res = fast_float::from_chars(it, itLineEnd, coords[i]);
+                ok = res.ec == std::errc();
+                it = res.ptr;
+            }
+
+            // Keep vertex even if invalid, so indices of the next ones are preserved
+            chunk->vecPosition.emplace_back(coords[0], coords[1], coords[2]);
+        }
+        else if (isFace) {
+            // Each vertex is "v", "v/vt", "v//vn" or "v/vt/vn", only "v" is read
+            vecPolygonVertex.clear();
+            it += 2;
+            bool ok = true;
+            while (ok) {
+                it = objSkipBlanks(it, itLineEnd);
+                if (it >= itLineEnd)
+                    break;
+
+                int index = 0;
+                const std::from_chars_result res = std::from_chars(it, itLineEnd, index);
+                ok = res.ec == std::errc() && index != 0;
+                if (ok) {
+                    const int chunkVertexCount = int(chunk->vecPosition.size());
+                    if (index > 0)
+                        vecPolygonVertex.push_back({ index - 1, false });
+                    else
+                        vecPolygonVertex.push_back({ chunkVertexCount + index, true });
+                }
+
+                it = res.ptr;
+                while (it < itLineEnd && !objIsBlank(*it))
+                    ++it;
+            }
+
+            if (ok) {
+                for (size_t i = 2; i < vecPolygonVertex.size(); ++i) {
+                    chunk->vecTriangleVertex.push_back(vecPolygonVertex.front());
+                    chunk->vecTriangleVertex.push_back(vecPolygonVertex.at(i - 1));
+                    chunk->vecTriangleVertex.push_back(vecPolygonVertex.at(i));
+                }
+            }
+        }
+        else if (itLineEnd - it > 0 && (it[0] == 'o' || it[0] == 'g' || it[0] == 'u' || it[0] == 'm')) {
+            auto fnAddStatement = [&](ObjStatement::Type type, const char* itArgs) {
+                const std::string arg = objTrimmedString(itArgs, itLineEnd);
+                chunk->vecStatement.push_back({ type, arg, chunk->vecTriangleVertex.size(), 0 });
+            };
+            const char* itArgs = nullptr;
+            if ((itArgs = objStatementArgs(it, itLineEnd, "o")) || (itArgs = objStatementArgs(it, itLineEnd, "g")))
+                fnAddStatement(ObjStatement::Type::Group, itArgs);
+            else if ((itArgs = objStatementArgs(it, itLineEnd, "usemtl")))
+                fnAddStatement(ObjStatement::Type::Material, itArgs);
+            else if ((itArgs = objStatementArgs(it, itLineEnd, "mtllib")))
+                fnAddStatement(ObjStatement::Type::MaterialLib, itArgs);
+        }
+
+        itLine = itLineEnd + 1;
+    }
+}
+
+// Splits the triangles of the chunks into primitives, a new one is started each time the group or
+// the material changes. Primitives without triangles are discarded
+std::vector<ObjPrimitive> objSplitPrimitives(
+        const std::vector<ObjChunk>& vecChunk,
+        const std::vector<std::vector<Poly_Triangle>>& vecChunkTriangle)
+{
+    std::vector<ObjPrimitive> vecPrimitive;
+    ObjPrimitive current;
+    auto fnHasTriangles = [](const ObjPrimitive& primitive) {
+        return !primitive.vecRange.empty();
+    };
+    auto fnAddRange = [&](int iChunk, size_t triangleBegin, size_t triangleEnd) {
+        if (triangleEnd > triangleBegin)
+            current.vecRange.push_back({ iChunk, triangleBegin, triangleEnd });
+    };
+    for (int iChunk = 0; iChunk < int(vecChunk.size()); ++iChunk) {
+        size_t trianglePos = 0;
+        for (const ObjStatement& stmt : vecChunk.at(iChunk).vecStatement) {
+            if (stmt.type == ObjStatement::Type::MaterialLib)
+                continue;
+
+            fnAddRange(iChunk, trianglePos, stmt.trianglePos);
+            trianglePos = stmt.trianglePos;
+            if (fnHasTriangles(current)) {
+                ObjPrimitive next;
+                next.groupName = current.groupName;
+                next.materialName = current.materialName;
+                vecPrimitive.push_back(std::move(current));
+                current = std::move(next);
+            }
+
+            if (stmt.type == ObjStatement::Type::Group)
+                current.groupName = stmt.arg;
+            else
+                current.materialName = stmt.arg;
+        }
+
+        fnAddRange(iChunk, trianglePos, vecChunkTriangle.at(iChunk).size());
+    }
+
+    if (fnHasTriangles(current))
+        vecPrimitive.push_back(std::move(current));
+
+    return vecPrimitive;
+}
+
+// Reads OBJ file mapped in memory, lines are split in chunks parsed concurrently
+// Chunks are then stitched: vertex indices are offset with the prefix sums of vertex counts
+// Triangles are split into primitives(see objSplitPrimitives()), then the triangulation of each
+// primitive is built concurrently
+// Returns no primitive if there's no valid triangle or reading was aborted
+ObjFastResult objReadFileFast(
+        const FilePath& filepath,
+        const RWMesh_CoordinateSystemConverter& converter,
+        TaskProgress* progress)
+{
+    MappedFile file;
+    if (!file.open(filepath) || !file.data())
+        return {};
+
+    const char* data = file.data();
+    const qint64 size = file.size();
+
+    // Chunks start at line boundaries
+    constexpr qint64 chunkSize = 4 * 1024 * 1024;
+    const char* itEnd = data + size;
+    std::vector<const char*> vecChunkStart;
+    vecChunkStart.push_back(data);
+    for (qint64 pos = chunkSize; pos < size; pos += chunkSize) {
+        auto itNewLine = static_cast<const char*>(std::memchr(data + pos, '\n', size - pos));
+        if (!itNewLine)
+            break;
+
+        if (itNewLine + 1 > vecChunkStart.back() && itNewLine + 1 < itEnd)
+            vecChunkStart.push_back(itNewLine + 1);
+    }
+
+    vecChunkStart.push_back(itEnd);
+    const int chunkCount = int(vecChunkStart.size()) - 1;
+    std::vector<ObjChunk> vecChunk(chunkCount);
+    TaskChunkProgress parseProgress(progress, chunkCount, 0, 70);
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        objParseChunk(vecChunkStart.at(iChunk), vecChunkStart.at(iChunk + 1), &vecChunk.at(iChunk));
+        parseProgress.chunkDone();
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    // Offsets of the first vertex of each chunk
+    std::vector<int64_t> vecChunkVertexOffset(chunkCount + 1, 0);
+    for (int i = 0; i < chunkCount; ++i)
+        vecChunkVertexOffset.at(i + 1) = vecChunkVertexOffset.at(i) + vecChunk.at(i).vecPosition.size();
+
+    const int64_t nodeCount = vecChunkVertexOffset.back();
+    if (nodeCount > std::numeric_limits<int>::max())
+        return {};
+
+    // Resolve vertex indices, triangles referencing undefined vertices are discarded
+    std::vector<std::vector<Poly_Triangle>> vecChunkTriangle(chunkCount);
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        const std::vector<ObjVertexRef>& vecVertexRef = vecChunk.at(iChunk).vecTriangleVertex;
+        std::vector<ObjStatement>& vecStatement = vecChunk.at(iChunk).vecStatement;
+        size_t iStatement = 0;
+        std::vector<Poly_Triangle>& vecTriangle = vecChunkTriangle.at(iChunk);
+        vecTriangle.reserve(vecVertexRef.size() / 3);
+        for (size_t i = 0; i + 2 < vecVertexRef.size(); i += 3) {
+            while (iStatement < vecStatement.size() && vecStatement.at(iStatement).triangleVertexPos <= i)
+                vecStatement.at(iStatement++).trianglePos = vecTriangle.size();
+
+            int nodeIds[3];
+            bool ok = true;
+            for (int j = 0; j < 3 && ok; ++j) {
+                const ObjVertexRef& ref = vecVertexRef.at(i + j);
+                const int64_t index = ref.isChunkRelative ? vecChunkVertexOffset.at(iChunk) + ref.index : ref.index;
+                ok = index >= 0 && index < nodeCount;
+                nodeIds[j] = int(index) + 1;
+            }
+
+            if (ok && nodeIds[0] != nodeIds[1] && nodeIds[1] != nodeIds[2] && nodeIds[2] != nodeIds[0])
+                vecTriangle.emplace_back(nodeIds[0], nodeIds[1], nodeIds[2]);
+        }
+
+        while (iStatement < vecStatement.size())
+            vecStatement.at(iStatement++).trianglePos = vecTriangle.size();
+
+        std::vector<ObjVertexRef>().swap(vecChunk.at(iChunk).vecTriangleVertex);
+    });
+
+    ObjFastResult result;
+    for (const ObjChunk& chunk : vecChunk) {
+        for (const ObjStatement& stmt : chunk.vecStatement) {
+            if (stmt.type == ObjStatement::Type::MaterialLib)
+                result.vecMaterialLib.push_back(stmt.arg);
+        }
+    }
+
+    std::vector<ObjPrimitive> vecPrimitive = objSplitPrimitives(vecChunk, vecChunkTriangle);
+    const int primitiveCount = int(vecPrimitive.size());
+    for (const ObjPrimitive& primitive : vecPrimitive) {
+        int64_t triangleCount = 0;
+        for (const ObjPrimitive::Range& range : primitive.vecRange)
+            triangleCount += range.triangleEnd - range.triangleBegin;
+
+        if (triangleCount > std::numeric_limits<int>::max())
+            return {};
+    }
+
+    if (primitiveCount == 0)
+        return {};
+
+    if (progress)
+        progress->setValue(75);
+
+    // Converted positions of all the vertices, referenced by the primitives
+    std::vector<gp_XYZ> vecNode(size_t(nodeCount));
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        const size_t nodeOffset = size_t(vecChunkVertexOffset.at(iChunk));
+        std::vector<gp_XYZ>& vecPosition = vecChunk.at(iChunk).vecPosition;
+        for (size_t i = 0; i < vecPosition.size(); ++i) {
+            gp_XYZ pos = vecPosition.at(i);
+            converter.TransformPosition(pos);
+            vecNode[nodeOffset + i] = pos;
+        }
+
+        std::vector<gp_XYZ>().swap(vecPosition);
+    });
+
+    if (progress)
+        progress->setValue(80);
+
+    // A single primitive keeps all the vertices, otherwise each primitive gets the vertices it
+    // references, renumbered in increasing order
+    TaskChunkProgress buildProgress(progress, primitiveCount, 80, 100);
+    CppUtils::parallelFor(primitiveCount, [&](int iPrimitive) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        ObjPrimitive& primitive = vecPrimitive.at(iPrimitive);
+        int triangleCount = 0;
+        for (const ObjPrimitive::Range& range : primitive.vecRange)
+            triangleCount += int(range.triangleEnd - range.triangleBegin);
+
+        std::vector<int> vecNodeId; // Sorted identifiers(1-based) of the referenced vertices
+        if (primitiveCount > 1) {
+            vecNodeId.reserve(size_t(triangleCount) * 3);
+            for (const ObjPrimitive::Range& range : primitive.vecRange) {
+                const std::vector<Poly_Triangle>& vecTriangle = vecChunkTriangle.at(range.iChunk);
+                for (size_t i = range.triangleBegin; i < range.triangleEnd; ++i) {
+                    int n1, n2, n3;
+                    vecTriangle.at(i).Get(n1, n2, n3);
+                    vecNodeId.insert(vecNodeId.end(), { n1, n2, n3 });
+                }
+            }
+
+            std::sort(vecNodeId.begin(), vecNodeId.end());
+            vecNodeId.erase(std::unique(vecNodeId.begin(), vecNodeId.end()), vecNodeId.end());
+        }
+
+        auto fnMeshNodeId = [&](int nodeId) {
+            if (primitiveCount == 1)
+                return nodeId;
+
+            return int(std::lower_bound(vecNodeId.cbegin(), vecNodeId.cend(), nodeId) - vecNodeId.cbegin()) + 1;
+        };
+        const int meshNodeCount = primitiveCount > 1 ? int(vecNodeId.size()) : int(nodeCount);
+        Handle_Poly_Triangulation mesh = new Poly_Triangulation(meshNodeCount, triangleCount, false);
+        TColgp_Array1OfPnt& vecMeshNode = mesh->ChangeNodes();
+        for (int i = 0; i < meshNodeCount; ++i) {
+            const int nodeId = primitiveCount > 1 ? vecNodeId.at(i) : i + 1;
+            vecMeshNode.ChangeValue(i + 1).SetXYZ(vecNode.at(nodeId - 1));
+        }
+
+        Poly_Array1OfTriangle& vecMeshTriangle = mesh->ChangeTriangles();
+        int meshTriangleId = 1;
+        for (const ObjPrimitive::Range& range : primitive.vecRange) {
+            const std::vector<Poly_Triangle>& vecTriangle = vecChunkTriangle.at(range.iChunk);
+            for (size_t i = range.triangleBegin; i < range.triangleEnd; ++i) {
+                int n1, n2, n3;
+                vecTriangle.at(i).Get(n1, n2, n3);
+                vecMeshTriangle.ChangeValue(meshTriangleId++) =
+                        Poly_Triangle(fnMeshNodeId(n1), fnMeshNodeId(n2), fnMeshNodeId(n3));
+            }
+        }
+
+        primitive.mesh = mesh;
+        buildProgress.chunkDone();
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    result.vecPrimitive = std::move(vecPrimitive);
+    return result;
+}
+
+// Diffuse colors("Kd" statements) of the materials defined in MTL file
+void objReadMaterialColors(
+        const FilePath& filepath, std::unordered_map<std::string, Quantity_Color>* ptrMapColor)
+{
+    QFile file(filepathTo<QString>(filepath));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    std::string materialName;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        const char* itLineEnd = line.constData() + line.size();
+        while (itLineEnd > line.constData() && (*(itLineEnd - 1) == '\n' || objIsBlank(*(itLineEnd - 1))))
+            --itLineEnd;
+
+        const char* it = objSkipBlanks(line.constData(), itLineEnd);
+        const char* itArgs = nullptr;
+        if ((itArgs = objStatementArgs(it, itLineEnd, "newmtl"))) {
+            materialName = objTrimmedString(itArgs, itLineEnd);
+        }
+        else if ((itArgs = objStatementArgs(it, itLineEnd, "Kd")) && !materialName.empty()) {
+            double rgb[3] = {};
+            bool ok = true;
+            for (int i = 0; i < 3 && ok; ++i) {
+                itArgs = objSkipBlanks(itArgs, itLineEnd);
+                const fast_float::from_chars_result res = fast_float::from_chars(itArgs, itLineEnd, rgb[i]);
+                ok = res.ec == std::errc();
+                itArgs = res.ptr;
+                rgb[i] = std::clamp(rgb[i], 0., 1.);
+            }
+
+            if (ok) {
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+                constexpr Quantity_TypeOfColor colorType = Quantity_TOC_sRGB; // As RWObj_MtlReader
+#else
+                constexpr Quantity_TypeOfColor colorType = Quantity_TOC_RGB;
+#endif
+                ptrMapColor->insert_or_assign(materialName, Quantity_Color(rgb[0], rgb[1], rgb[2], colorType));
+            }
+        }
+    }
+}
+
+} // namespace
+
 class OccObjReader::Properties : public OccBaseMeshReaderProperties {
     MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::OccObjReader::Properties)
 public:
@@ -18,14 +485,21 @@ public:
     {
         this->singlePrecisionVertexCoords.setDescription(
                     textId("Single precision flag for reading vertex data(coordinates)").tr());
+        this->fastParsing.setDescription(
+                    textId("Parse lines of the file concurrently, much faster for big files.\n\n"
+                           "Only vertex positions, faces, groups and material colors are read: "
+                           "normals and texture coordinates are ignored").tr());
     }
 
     void restoreDefaults() override {
         OccBaseMeshReaderProperties::restoreDefaults();
-        this->singlePrecisionVertexCoords.setValue(false);
+        const OccObjReader::Parameters params;
+        this->singlePrecisionVertexCoords.setValue(params.singlePrecisionVertexCoords);
+        this->fastParsing.setValue(params.fastParsing);
     }
 
     PropertyBool singlePrecisionVertexCoords{ this, textId("singlePrecisionVertexCoords") };
+    PropertyBool fastParsing{ this, textId("fastParsing") };
 };
 
 OccObjReader::OccObjReader()
@@ -33,6 +507,85 @@ OccObjReader::OccObjReader()
 {
 }
 
+bool OccObjReader::readFile(const FilePath& filepath, TaskProgress* progress)
+{
+    m_vecFastPrimitive.clear();
+    if (!m_params.fastParsing)
+        return OccBaseMeshReader::readFile(filepath, progress);
+
+    // Same conversion of coordinates as RWObj_CafReader
+    this->applyParameters();
+    m_baseFilename = filepath.stem();
+    ObjFastResult result = objReadFileFast(filepath, m_reader.CoordinateSystemConverter(), progress);
+    std::unordered_map<std::string, Quantity_Color> mapMaterialColor;
+    for (const std::string& materialLib : result.vecMaterialLib) {
+        const FilePath filepathMaterialLib = filepath.parent_path() / std::filesystem::u8path(materialLib);
+        objReadMaterialColors(filepathMaterialLib, &mapMaterialColor);
+    }
+
+    for (ObjPrimitive& primitive : result.vecPrimitive) {
+        FastPrimitive fastPrimitive;
+        fastPrimitive.name = !primitive.groupName.empty() ? primitive.groupName : primitive.materialName;
+        auto itColor = mapMaterialColor.find(primitive.materialName);
+        fastPrimitive.hasColor = itColor != mapMaterialColor.cend();
+        if (fastPrimitive.hasColor)
+            fastPrimitive.color = itColor->second;
+
+        fastPrimitive.mesh = std::move(primitive.mesh);
+        m_vecFastPrimitive.push_back(std::move(fastPrimitive));
+    }
+
+    return !m_vecFastPrimitive.empty();
+}
+
+TDF_LabelSequence OccObjReader::transfer(DocumentPtr doc, TaskProgress* progress)
+{
+    if (!m_params.fastParsing)
+        return OccBaseMeshReader::transfer(doc, progress);
+
+    if (m_vecFastPrimitive.empty() || TaskProgress::isAbortRequested(progress))
+        return {};
+
+    const QString baseName = filepathTo<QString>(m_baseFilename);
+    if (m_vecFastPrimitive.size() == 1) {
+        const TDF_Label entityLabel = doc->newEntityLabel();
+        TDataXtd_Triangulation::Set(entityLabel, m_vecFastPrimitive.front().mesh);
+        CafUtils::setLabelAttrStdName(entityLabel, baseName);
+        m_vecFastPrimitive.clear();
+        return CafUtils::makeLabelSequence({ entityLabel });
+    }
+
+    // Serial pass: each primitive becomes a mesh part(single face carrying the triangulation) of
+    // an assembly named after the file
+    const Handle_XCAFDoc_ShapeTool shapeTool = doc->xcaf().shapeTool();
+    const Handle_XCAFDoc_ColorTool colorTool = doc->xcaf().colorTool();
+    const TDF_Label labelAssembly = shapeTool->NewShape();
+    CafUtils::setLabelAttrStdName(labelAssembly, baseName);
+    const int primitiveCount = int(m_vecFastPrimitive.size());
+    for (int i = 0; i < primitiveCount; ++i) {
+        if (TaskProgress::isAbortRequested(progress))
+            return {};
+
+        const FastPrimitive& primitive = m_vecFastPrimitive.at(i);
+        TopoDS_Face face;
+        BRep_Builder().MakeFace(face, primitive.mesh);
+        const TDF_Label labelPart = shapeTool->AddShape(face, false);
+        const TDF_Label labelComponent = shapeTool->AddComponent(labelAssembly, labelPart, TopLoc_Location());
+        const QString name = !primitive.name.empty() ? QString::fromStdString(primitive.name) : baseName;
+        CafUtils::setLabelAttrStdName(labelPart, name);
+        CafUtils::setLabelAttrStdName(labelComponent, name);
+        if (primitive.hasColor)
+            colorTool->SetColor(labelPart, primitive.color, XCAFDoc_ColorSurf);
+
+        if (progress)
+            progress->setValue(((i + 1) * 100) / primitiveCount);
+    }
+
+    shapeTool->UpdateAssemblies();
+    m_vecFastPrimitive.clear();
+    return CafUtils::makeLabelSequence({ labelAssembly });
+}
+
 std::unique_ptr<PropertyGroup> OccObjReader::createProperties(PropertyGroup* parentGroup)
 {
     return std::make_unique<Properties>(parentGroup);
@@ -44,6 +597,7 @@ void OccObjReader::applyProperties(const PropertyGroup* params)
     auto ptr = dynamic_cast<const Properties*>(params);
     if (ptr) {
         m_params.singlePrecisionVertexCoords = ptr->singlePrecisionVertexCoords;
+        m_params.fastParsing = ptr->fastParsing;
     }
 }
 
@@ -7,7 +7,11 @@
 #pragma once
 
 #include "io_occ_base_mesh.h"
+#include <Poly_Triangulation.hxx>
+#include <Quantity_Color.hxx>
 #include <RWObj_CafReader.hxx>
+#include <string>
+#include <vector>
 
 namespace Mayo {
 namespace IO {
@@ -18,6 +22,9 @@ class OccObjReader : public OccBaseMeshReader {
 public:
     OccObjReader();
 
+    bool readFile(const FilePath& filepath, TaskProgress* progress) override;
+    TDF_LabelSequence transfer(DocumentPtr doc, TaskProgress* progress) override;
+
     static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
     void applyProperties(const PropertyGroup* params) override;
 
@@ -25,6 +32,12 @@ public:
 
     struct Parameters : public OccBaseMeshReader::Parameters {
         bool singlePrecisionVertexCoords = false;
+        // File is memory-mapped and its lines are parsed concurrently, bypassing RWObj_CafReader
+        // Only vertex positions, faces, groups("o"/"g") and diffuse colors of materials are read:
+        // normals and texture coordinates are ignored. Triangulations of the primitives(a group
+        // with a single material) are built concurrently, a single primitive gives a mesh entity
+        // otherwise primitives are the parts of an assembly
+        bool fastParsing = false;
     };
     OccObjReader::Parameters& parameters() override { return m_params; }
     const OccObjReader::Parameters& constParameters() const override { return m_params; }
@@ -36,6 +49,15 @@ private:
     class Properties;
     Parameters m_params;
     RWObj_CafReader m_reader;
+    // Result of "fast parsing" mode
+    struct FastPrimitive {
+        std::string name;
+        bool hasColor = false;
+        Quantity_Color color;
+        Handle_Poly_Triangulation mesh;
+    };
+    std::vector<FastPrimitive> m_vecFastPrimitive;
+    FilePath m_baseFilename;
 };
 
 } // namespace IO
@@ -0,0 +1,418 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_occ_obj_writer.h"
+
+#include "../base/async_file_stream.h"
+#include "../base/cpp_utils.h"
+#include "../base/property_builtins.h"
+#include "../base/string_utils.h"
+#include "../base/task_progress.h"
+#include "../base/tkernel_utils.h"
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+#  include <TShort_Array1OfShortReal.hxx>
+#endif
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+// Count of items(vertices, normals, texture coordinates or faces) in a chunk of serialization
+constexpr int ObjWriterChunkItemCount = 64 * 1024;
+
+enum class ObjSection { Vertices, Normals, TextureCoords, Faces };
+
+// Triangulation of an instance, with the global(zero-based) index of its first vertex, normal and
+// texture coordinates
+struct ObjWriterPart {
+    Handle_Poly_Triangulation triangulation;
+    gp_Trsf trsf;
+    bool isReversed = false;
+    bool hasNormals = false;
+    bool hasTextureCoords = false;
+    int64_t vertexOffset = 0;
+    int64_t normalOffset = 0;
+    int64_t textureCoordOffset = 0;
+};
+
+// Excerpt of a section of a part. The first chunk of an instance starts with statement "o", the
+// first chunk of a part whose material differs from the previous part starts with "usemtl"
+struct ObjWriterChunk {
+    ObjSection section = ObjSection::Vertices;
+    int iPart = 0;
+    int iItemBegin = 0; // Zero-based
+    int itemCount = 0;
+    std::string head;
+    int materialId = -1; // Material referred by 'head', if any
+};
+
+gp_Vec objNodeNormal(const Poly_Triangulation& mesh, int nodeId)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    gp_Vec3f normal;
+    mesh.Normal(nodeId, normal);
+    return gp_Vec(normal.x(), normal.y(), normal.z());
+#else
+    const TShort_Array1OfShortReal& vecNormal = mesh.Normals();
+    const int i = (nodeId - 1) * 3 + vecNormal.Lower();
+    return gp_Vec(vecNormal.Value(i), vecNormal.Value(i + 1), vecNormal.Value(i + 2));
+#endif
+}
+
+// Appends numbers and text to a string, decimal point is '.' whatever the C locale
+class ObjWriterBuffer {
+public:
+    ObjWriterBuffer(std::string* ptrStr, int precision) : m_str(*ptrStr), m_precision(precision) {}
+
+    void appendDouble(double value) {
+        StringUtils::appendNumber(&m_str, value, std::chars_format::general, m_precision);
+    }
+
+    void appendInt(int64_t value) {
+        char buff[24];
+        const std::to_chars_result res = std::to_chars(std::begin(buff), std::end(buff), value);
+        m_str.append(buff, res.ptr);
+    }
+
+    void appendChar(char c) { m_str.push_back(c); }
+    void appendText(std::string_view str) { m_str.append(str); }
+
+private:
+    std::string& m_str;
+    int m_precision = 9;
+};
+
+// Name of an OBJ object or material, which is a single word
+std::string objName(std::string_view name)
+{
+    std::string result(name);
+    for (char& c : result) {
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+            c = '_';
+    }
+
+    return !result.empty() ? result : "anonymous";
+}
+
+std::string objMaterialName(int materialId)
+{
+    return "material_" + std::to_string(materialId);
+}
+
+int objSectionItemCount(const ObjWriterPart& part, ObjSection section)
+{
+    switch (section) {
+    case ObjSection::Vertices: return part.triangulation->NbNodes();
+    case ObjSection::Normals: return part.hasNormals ? part.triangulation->NbNodes() : 0;
+    case ObjSection::TextureCoords: return part.hasTextureCoords ? part.triangulation->NbNodes() : 0;
+    case ObjSection::Faces: return part.triangulation->NbTriangles();
+    }
+
+    return 0;
+}
+
+// Serializes the items of 'chunk' into 'ptrStr'
+void objWriteChunk(Span<const ObjWriterPart> spanPart, const ObjWriterChunk& chunk, int precision, std::string* ptrStr)
+{
+    ptrStr->clear();
+    ptrStr->reserve(chunk.head.size() + size_t(chunk.itemCount) * (chunk.section == ObjSection::Faces ? 48 : 40));
+    ObjWriterBuffer buffer(ptrStr, precision);
+    buffer.appendText(chunk.head);
+    const ObjWriterPart& part = spanPart[chunk.iPart];
+    const Poly_Triangulation& mesh = *part.triangulation;
+    const int iItemEnd = chunk.iItemBegin + chunk.itemCount;
+    for (int i = chunk.iItemBegin; i < iItemEnd; ++i) {
+        if (chunk.section == ObjSection::Vertices) {
+            const gp_Pnt pnt = mesh.Node(i + 1).Transformed(part.trsf);
+            buffer.appendText("v ");
+            buffer.appendDouble(pnt.X());
+            buffer.appendChar(' ');
+            buffer.appendDouble(pnt.Y());
+            buffer.appendChar(' ');
+            buffer.appendDouble(pnt.Z());
+        }
+        else if (chunk.section == ObjSection::Normals) {
+            gp_Vec normal = objNodeNormal(mesh, i + 1).Transformed(part.trsf);
+            const double normalLength = normal.Magnitude();
+            normal = normalLength > gp::Resolution() ? normal / normalLength : gp_Vec(0, 0, 0);
+            if (part.isReversed)
+                normal.Reverse();
+
+            buffer.appendText("vn ");
+            buffer.appendDouble(normal.X());
+            buffer.appendChar(' ');
+            buffer.appendDouble(normal.Y());
+            buffer.appendChar(' ');
+            buffer.appendDouble(normal.Z());
+        }
+        else if (chunk.section == ObjSection::TextureCoords) {
+            const gp_Pnt2d uv = mesh.UVNode(i + 1);
+            buffer.appendText("vt ");
+            buffer.appendDouble(uv.X());
+            buffer.appendChar(' ');
+            buffer.appendDouble(uv.Y());
+        }
+        else if (chunk.section == ObjSection::Faces) {
+            int n[3];
+            mesh.Triangle(i + 1).Get(n[0], n[1], n[2]);
+            if (part.isReversed)
+                std::swap(n[1], n[2]);
+
+            buffer.appendChar('f');
+            for (int nodeId : n) {
+                // OBJ indices are one-based
+                buffer.appendChar(' ');
+                buffer.appendInt(part.vertexOffset + nodeId);
+                if (part.hasTextureCoords || part.hasNormals) {
+                    buffer.appendChar('/');
+                    if (part.hasTextureCoords)
+                        buffer.appendInt(part.textureCoordOffset + nodeId);
+
+                    if (part.hasNormals) {
+                        buffer.appendChar('/');
+                        buffer.appendInt(part.normalOffset + nodeId);
+                    }
+                }
+            }
+        }
+
+        buffer.appendChar('\n');
+    }
+}
+
+} // namespace
+
+class OccObjWriter::Properties : public PropertyGroup {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::OccObjWriter::Properties)
+public:
+    Properties(PropertyGroup* parentGroup)
+        : PropertyGroup(parentGroup)
+    {
+        this->writeMaterials.setDescription(
+                    textIdTr("Write the colors of the objects as materials, in a MTL file created "
+                             "next to the OBJ file"));
+        this->float64Precision.setConstraintsEnabled(true);
+        this->float64Precision.setRange(1, 17);
+        this->float64Precision.setDescription(
+                    textIdTr("Maximum number of significant digits when writting vertex coordinates"));
+    }
+
+    void restoreDefaults() override {
+        const OccObjWriter::Parameters params;
+        this->writeNormals.setValue(params.writeNormals);
+        this->writeTextureCoords.setValue(params.writeTextureCoords);
+        this->writeMaterials.setValue(params.writeMaterials);
+        this->float64Precision.setValue(params.float64Precision);
+    }
+
+    PropertyBool writeNormals{ this, textId("writeNormals") };
+    PropertyBool writeTextureCoords{ this, textId("writeTextureCoords") };
+    PropertyBool writeMaterials{ this, textId("writeMaterials") };
+    PropertyInt float64Precision{ this, textId("float64Precision") };
+};
+
+bool OccObjWriter::writeFile(const FilePath& filepath, TaskProgress* progress)
+{
+    AsyncFileOutputStream outs(filepath);
+    if (!outs.isOpen())
+        return false;
+
+    std::ofstream outsMtl;
+    FilePath mtlFilepath = filepath;
+    mtlFilepath.replace_extension(".mtl");
+    if (m_params.writeMaterials) {
+        outsMtl.open(mtlFilepath, std::ios::out | std::ios::binary);
+        if (!outsMtl.is_open())
+            return false;
+    }
+
+    const std::string mtlFilename = m_params.writeMaterials ? mtlFilepath.filename().u8string() : std::string();
+    const bool okWrite = this->write(outs, mtlFilename, m_params.writeMaterials ? &outsMtl : nullptr, progress);
+    const bool okClose = outs.close();
+    if (outsMtl.is_open())
+        outsMtl.close();
+
+    return okWrite && okClose && (!m_params.writeMaterials || outsMtl.good());
+}
+
+bool OccObjWriter::writeStream(std::ostream& ostr, TaskProgress* progress)
+{
+    const bool okWrite = this->write(ostr, std::string(), nullptr, progress);
+    ostr.flush();
+    return okWrite && ostr.good();
+}
+
+std::unique_ptr<PropertyGroup> OccObjWriter::createProperties(PropertyGroup* parentGroup)
+{
+    return std::make_unique<Properties>(parentGroup);
+}
+
+void OccObjWriter::applyProperties(const PropertyGroup* group)
+{
+    auto ptr = dynamic_cast<const Properties*>(group);
+    if (ptr) {
+        m_params.writeNormals = ptr->writeNormals;
+        m_params.writeTextureCoords = ptr->writeTextureCoords;
+        m_params.writeMaterials = ptr->writeMaterials;
+        m_params.float64Precision = ptr->float64Precision;
+    }
+}
+
+bool OccObjWriter::write(
+        std::ostream& outs, const std::string& mtlFilename, std::ostream* ptrMtlStream, TaskProgress* progress)
+{
+    // Instances to be written, objects without instance(eg free shapes at tree root) are placed as is
+    std::vector<Instance> vecInstance = m_vecInstance;
+    std::vector<bool> vecObjectInstantiated(m_vecObject.size(), false);
+    for (const Instance& instance : m_vecInstance)
+        vecObjectInstantiated.at(instance.objectId) = true;
+
+    for (const Object& object : m_vecObject) {
+        if (!vecObjectInstantiated.at(object.id)) {
+            Instance instance;
+            instance.objectId = object.id;
+            instance.name = object.name;
+            vecInstance.push_back(std::move(instance));
+        }
+    }
+
+    // Parts and chunks in the order they are written. Global offsets of the parts are computed
+    // upfront, so chunks can be serialized independently
+    std::vector<ObjWriterPart> vecPart;
+    std::vector<ObjWriterChunk> vecChunk;
+    int64_t vertexCount = 0;
+    int64_t normalCount = 0;
+    int64_t textureCoordCount = 0;
+    int64_t itemCount = 0;
+    for (const Instance& instance : vecInstance) {
+        const Object& object = m_vecObject.at(instance.objectId);
+        bool isInstanceHeadPending = true;
+        int currentMaterialId = -1;
+        for (int meshId = object.firstMeshId; meshId <= object.lastMeshId; ++meshId) {
+            const Mesh& mesh = m_vecMesh.at(meshId);
+            if (mesh.triangulation.IsNull() || mesh.triangulation->NbTriangles() <= 0)
+                continue;
+
+            ObjWriterPart part;
+            part.triangulation = mesh.triangulation;
+            part.trsf = instance.trsf * mesh.location.Transformation();
+            part.isReversed = mesh.isReversed;
+            part.hasNormals = m_params.writeNormals && mesh.triangulation->HasNormals();
+            part.hasTextureCoords = m_params.writeTextureCoords && mesh.triangulation->HasUVNodes();
+            part.vertexOffset = vertexCount;
+            part.normalOffset = normalCount;
+            part.textureCoordOffset = textureCoordCount;
+            const int nodeCount = mesh.triangulation->NbNodes();
+            vertexCount += nodeCount;
+            normalCount += part.hasNormals ? nodeCount : 0;
+            textureCoordCount += part.hasTextureCoords ? nodeCount : 0;
+            vecPart.push_back(std::move(part));
+
+            // Faces having no color get the one of the object, or else the default material
+            const int meshMaterialId = mesh.materialId >= 0 ? mesh.materialId : std::max(object.materialId, 0);
+            bool isMaterialPending = meshMaterialId != currentMaterialId;
+            currentMaterialId = meshMaterialId;
+            const int iPart = int(vecPart.size()) - 1;
+            for (ObjSection section : {
+                 ObjSection::Vertices, ObjSection::Normals, ObjSection::TextureCoords, ObjSection::Faces })
+            {
+                const int sectionItemCount = objSectionItemCount(vecPart.back(), section);
+                for (int iItem = 0; iItem < sectionItemCount; iItem += ObjWriterChunkItemCount) {
+                    ObjWriterChunk chunk;
+                    chunk.section = section;
+                    chunk.iPart = iPart;
+                    chunk.iItemBegin = iItem;
+                    chunk.itemCount = std::min(ObjWriterChunkItemCount, sectionItemCount - iItem);
+                    if (isInstanceHeadPending) {
+                        chunk.head = "o " + objName(instance.name) + "\n";
+                        isInstanceHeadPending = false;
+                    }
+
+                    if (isMaterialPending) {
+                        chunk.materialId = meshMaterialId;
+                        chunk.head += "usemtl " + objMaterialName(meshMaterialId) + "\n";
+                        isMaterialPending = false;
+                    }
+
+                    itemCount += chunk.itemCount;
+                    vecChunk.push_back(std::move(chunk));
+                }
+            }
+        }
+    }
+
+    outs << "# Exported by Mayo\n";
+    if (!mtlFilename.empty())
+        outs << "mtllib " << mtlFilename << "\n";
+
+    // Serialize batches of chunks in parallel, then write them in order. A batch gathers enough
+    // items to keep all threads busy even if the meshes are small
+    const int threadCount = std::max(int(std::thread::hardware_concurrency()), 1);
+    const int64_t batchItemCount = int64_t(2 * threadCount) * ObjWriterChunkItemCount;
+    const Span<const ObjWriterPart> spanPart = vecPart;
+    const int chunkCount = int(vecChunk.size());
+    std::vector<std::string> vecBuffer;
+    std::vector<bool> vecMaterialWritten(m_vecMaterial.size(), false);
+    int64_t doneItemCount = 0;
+    int iChunk = 0;
+    while (iChunk < chunkCount && outs) {
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+
+        int iChunkEnd = iChunk;
+        int64_t batchCount = 0;
+        while (iChunkEnd < chunkCount && batchCount < batchItemCount)
+            batchCount += vecChunk.at(iChunkEnd++).itemCount;
+
+        const int batchChunkCount = iChunkEnd - iChunk;
+        if (int(vecBuffer.size()) < batchChunkCount)
+            vecBuffer.resize(batchChunkCount);
+
+        CppUtils::parallelFor(batchChunkCount, [&](int i) {
+            objWriteChunk(spanPart, vecChunk.at(iChunk + i), m_params.float64Precision, &vecBuffer.at(i));
+        });
+
+        for (int i = 0; i < batchChunkCount && outs; ++i) {
+            // Material is defined in the MTL file as it gets used
+            const int materialId = vecChunk.at(iChunk + i).materialId;
+            if (ptrMtlStream && materialId >= 0 && !vecMaterialWritten.at(materialId)) {
+                const Quantity_Color& color = m_vecMaterial.at(materialId).color;
+                std::string strMtl;
+                ObjWriterBuffer bufferMtl(&strMtl, 6);
+                bufferMtl.appendText("newmtl " + objMaterialName(materialId) + "\nKd ");
+                bufferMtl.appendDouble(color.Red());
+                bufferMtl.appendChar(' ');
+                bufferMtl.appendDouble(color.Green());
+                bufferMtl.appendChar(' ');
+                bufferMtl.appendDouble(color.Blue());
+                bufferMtl.appendText("\nKa 0 0 0\nd 1\nillum 1\n\n");
+                ptrMtlStream->write(strMtl.data(), strMtl.size());
+                vecMaterialWritten.at(materialId) = true;
+            }
+
+            outs.write(vecBuffer.at(i).data(), vecBuffer.at(i).size());
+        }
+
+        doneItemCount += batchCount;
+        iChunk = iChunkEnd;
+        if (progress)
+            progress->setValue(int((doneItemCount * 100) / std::max<int64_t>(itemCount, 1)));
+    }
+
+    return bool(outs) && (!ptrMtlStream || ptrMtlStream->good());
+}
+
+} // namespace IO
+} // namespace Mayo
@@ -0,0 +1,50 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/io_mesh_instances_writer.h"
+
+#include <iosfwd>
+
+namespace Mayo {
+namespace IO {
+
+// Writer for Wavefront OBJ format, each instance of the model tree is written as an object("o")
+// with the triangulations of its faces placed in world coordinates
+// Face and object colors of XCAF are written as materials in a MTL file next to the OBJ file(not by
+// writeStream()), material definitions are emitted as soon as an object refers to them
+// Vertices, normals, texture coordinates and faces are serialized concurrently by chunks, chunks
+// are then written in order. Indices are global to the file
+class OccObjWriter : public MeshInstancesWriter {
+public:
+    bool writeFile(const FilePath& filepath, TaskProgress* progress) override;
+    bool writeStream(std::ostream& ostr, TaskProgress* progress) override;
+
+    static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
+    void applyProperties(const PropertyGroup* group) override;
+
+    // Parameters
+
+    struct Parameters {
+        bool writeNormals = true; // For meshes having normals at nodes
+        bool writeTextureCoords = true; // For meshes having UV nodes
+        bool writeMaterials = true; // MTL file, ignored by writeStream()
+        int float64Precision = 9; // Maximum number of significant digits of coordinates
+    };
+    Parameters& parameters() { return m_params; }
+    const Parameters& constParameters() const { return m_params; }
+
+private:
+    // 'mtlFilename' is the file name written with "mtllib", 'ptrMtlStream' can be null
+    bool write(std::ostream& outs, const std::string& mtlFilename, std::ostream* ptrMtlStream, TaskProgress* progress);
+
+    class Properties;
+    Parameters m_params;
+};
+
+} // namespace IO
+} // namespace Mayo
@@ -6,7 +6,13 @@
 
 #include "io_occ_step.h"
 #include "io_occ_caf.h"
-#include "../base/occ_static_variables_rollback.h"
+#include "../base/caf_utils.h"
+#include "../base/cpp_utils.h"
+#include "../base/deferred_shape_loader.h"
+#include "../base/document.h"
+#include "../base/global.h"
+#include "../base/occ_static_variables_context.h"
+#include "../base/perf_stats.h"
 #include "../base/property_builtins.h"
 #include "../base/property_enumeration.h"
 #include "../base/string_utils.h"
@@ -16,12 +22,156 @@
 
 #include <APIHeaderSection_MakeHeader.hxx>
 #include <Interface_Static.hxx>
+#include <OSD_OpenFile.hxx>
 #include <Interface_Version.hxx>
 #include <STEPCAFControl_Controller.hxx>
+#include <STEPControl_ActorRead.hxx>
+#include <StepBasic_ProductDefinition.hxx>
+#include <StepBasic_UncertaintyMeasureWithUnit.hxx>
+#include <StepData_Protocol.hxx>
+#include <StepData_StepModel.hxx>
+#include <StepData_StepWriter.hxx>
+#include <StepData_WriterLib.hxx>
+#include <StepGeom_GeomRepContextAndGlobUnitAssCtxAndGlobUncertaintyAssCtx.hxx>
+#include <StepRepr_GlobalUncertaintyAssignedContext.hxx>
+#include <StepRepr_Representation.hxx>
+#include <StepShape_ManifoldSolidBrep.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <TransferBRep.hxx>
+#include <Transfer_TransientProcess.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+#include <XSControl_TransferReader.hxx>
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 7, 0) && OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 8, 0)
+#  include <StepData_GlobalFactors.hxx>
+#elif OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 7, 0)
+#  include <UnitsMethods.hxx>
+#endif
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace Mayo {
 namespace IO {
 
+namespace {
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 8, 0)
+// Unit factors and uncertainty that STEPControl_ActorRead::PrepareUnits() derives from a
+// representation context. Items whose contexts have the same key can be translated with the
+// same prepared actors
+// stepPreparedUnitsKey() requires the units of 'context' to be the last ones prepared
+using StepUnitsKey = std::tuple<double, double, double, double>;
+
+StepUnitsKey stepPreparedUnitsKey(const Handle_StepRepr_RepresentationContext& context)
+{
+    Handle_StepRepr_GlobalUncertaintyAssignedContext uncertaintyCtx;
+    auto complexCtx = Handle_StepGeom_GeomRepContextAndGlobUnitAssCtxAndGlobUncertaintyAssCtx::DownCast(context);
+    if (complexCtx)
+        uncertaintyCtx = complexCtx->GlobalUncertaintyAssignedContext();
+    else
+        uncertaintyCtx = Handle_StepRepr_GlobalUncertaintyAssignedContext::DownCast(context);
+
+    double uncertainty = -1.;
+    if (uncertaintyCtx && uncertaintyCtx->NbUncertainty() > 0)
+        uncertainty = uncertaintyCtx->UncertaintyValue(1)->ValueComponent();
+
+#  if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 7, 0)
+    const StepData_GlobalFactors& factors = StepData_GlobalFactors::Intance();
+    return { factors.LengthFactor(), factors.PlaneAngleFactor(), factors.SolidAngleFactor(), uncertainty };
+#  else
+    return { UnitsMethods::LengthFactor(), UnitsMethods::PlaneAngleFactor(), UnitsMethods::SolidAngleFactor(), uncertainty };
+#  endif
+}
+
+struct StepItemShapeJob {
+    Handle_StepRepr_Representation representation;
+    Handle_StepShape_ManifoldSolidBrep item;
+};
+#endif
+
+// Count of entities formatted by a StepData_StepWriter before its text is written out
+constexpr int StepWriterChunkSize = 4096;
+
+// Writes STEP 'model' into 'outs' by chunks of entities, so the text of the whole model never
+// exists in memory at once. Chunks of a batch are formatted concurrently, then written in order
+// Output is the same as StepData_StepWriter::SendModel(), without SCOPE sections nor global
+// check comments
+bool stepWriteModelChunked(
+        const Handle_StepData_StepModel& model,
+        const Handle_StepData_Protocol& protocol,
+        std::ostream& outs,
+        TaskProgress* progress)
+{
+    // Header section only, depending on OpenCascade version it may come with file delimiters
+    {
+        StepData_StepWriter writer(model);
+        writer.SendModel(protocol, true);
+        std::ostringstream ostrHeader;
+        writer.Print(ostrHeader);
+        std::string strHeader = ostrHeader.str();
+        const std::string strFileEnd = "END-ISO-10303-21;";
+        const size_t posFileEnd = strHeader.rfind(strFileEnd);
+        if (posFileEnd != std::string::npos)
+            strHeader.erase(posFileEnd);
+
+        if (strHeader.compare(0, 13, "ISO-10303-21;") != 0)
+            outs << "ISO-10303-21;\n";
+
+        outs << strHeader << "DATA;\n";
+    }
+
+    const int entityCount = model->NbEntities();
+    const int chunkCount = (entityCount + StepWriterChunkSize - 1) / StepWriterChunkSize;
+    const int threadCount = std::max(int(std::thread::hardware_concurrency()), 1);
+    const int batchSize = std::min(2 * threadCount, std::max(chunkCount, 1));
+    // StepData_WriterLib constructor updates global state, create them upfront here
+    std::vector<StepData_WriterLib> vecLib;
+    for (int i = 0; i < batchSize; ++i)
+        vecLib.emplace_back(protocol);
+
+    std::vector<std::string> vecBuffer(batchSize);
+    for (int iBatch = 0; iBatch < chunkCount && outs; iBatch += batchSize) {
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+
+        const int batchChunkCount = std::min(batchSize, chunkCount - iBatch);
+        CppUtils::parallelFor(batchChunkCount, [&](int i) {
+            const int iChunk = iBatch + i;
+            const int iEntityFirst = 1 + iChunk * StepWriterChunkSize;
+            const int iEntityLast = std::min(entityCount, iEntityFirst + StepWriterChunkSize - 1);
+            StepData_StepWriter writer(model);
+            for (int iEntity = iEntityFirst; iEntity <= iEntityLast; ++iEntity)
+                writer.SendEntity(iEntity, vecLib.at(i));
+
+            writer.NewLine(false);
+            std::ostringstream ostrChunk;
+            writer.Print(ostrChunk);
+            vecBuffer.at(i) = ostrChunk.str();
+        });
+        for (int i = 0; i < batchChunkCount && outs; ++i) {
+            outs << vecBuffer.at(i);
+            std::string().swap(vecBuffer.at(i));
+        }
+
+        if (progress)
+            progress->setValue(((iBatch + batchChunkCount) * 100) / chunkCount);
+    }
+
+    outs << "ENDSEC;\nEND-ISO-10303-21;\n";
+    outs.flush();
+    return outs.good();
+}
+
+} // namespace
+
 class OccStepReader::Properties : public PropertyGroup {
     MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::OccStepReader::Properties)
 public:
@@ -56,6 +206,35 @@ public:
                     textIdTr("Indicates whether to read sub-shape names from 'Name' attributes of "
                              "STEP Representation Items"));
 
+        this->profile.setDescription(
+                    textIdTr("Predefined set of data to be translated.\n"
+                             "`FastViewing` profile translates only shapes, names and colors, which is "
+                             "suitable for visualization of large STEP files carrying PMI and saved views"));
+        this->profile.setDescriptions({
+                    { Profile::Default, textIdTr("Translate data selected with the other parameters") },
+                    { Profile::FastViewing, textIdTr("Translate only shapes, names and colors. "
+                      "Layers, validation properties, GD&T, materials and saved views are skipped") }
+        });
+
+        this->readLayers.setDescription(textIdTr("Indicates whether layers should be translated"));
+        this->readProperties.setDescription(
+                    textIdTr("Indicates whether validation properties(area, volume, centroid) should be translated"));
+        this->readGdt.setDescription(
+                    textIdTr("Indicates whether GD&T(Geometric Dimensioning and Tolerancing) data should be translated"));
+        this->readMaterials.setDescription(textIdTr("Indicates whether materials should be translated"));
+        this->readViews.setDescription(textIdTr("Indicates whether saved views should be translated"));
+
+        this->parallelShapeTransfer.setDescription(
+                    textIdTr("Translate the solids of products over worker threads before building "
+                             "the assembly structure, names and colors.\n"
+                             "Speeds up STEP files made of many independent products"));
+
+        this->loadShapesOnDemand.setDescription(
+                    textIdTr("Read only the assembly structure of the STEP file, so the model tree is "
+                             "available quickly. Shapes of parts are translated afterwards, on demand"));
+
+        OccCommon::setShapeHealingDescriptions(&this->shapeHealing);
+
         this->productContext.setDescriptions({
                     { ProductContext::Design, textIdTr("Translate only products that have "
                       "`PRODUCT_DEFINITION_CONTEXT` with field `life_cycle_stage` set to `design`")
@@ -104,28 +283,118 @@ public:
         this->readShapeAspect.setValue(params.readShapeAspect);
         this->readSubShapesNames.setValue(params.readSubShapesNames);
         this->encoding.setValue(params.encoding);
+        this->readLayers.setValue(params.readLayers);
+        this->readProperties.setValue(params.readProperties);
+        this->readGdt.setValue(params.readGdt);
+        this->readMaterials.setValue(params.readMaterials);
+        this->readViews.setValue(params.readViews);
+        this->profile.setValue(params.profile);
+        this->parallelShapeTransfer.setValue(params.parallelShapeTransfer);
+        this->loadShapesOnDemand.setValue(params.loadShapesOnDemand);
+        this->shapeHealing.setValue(params.shapeHealing);
+        this->updateReadPropertiesEnabled();
     }
 
+    void onPropertyChanged(Property* prop) override
+    {
+        if (prop == &this->profile)
+            this->updateReadPropertiesEnabled();
+
+        PropertyGroup::onPropertyChanged(prop);
+    }
+
+    void updateReadPropertiesEnabled() {
+        const bool isDefaultProfile = this->profile.value() == Profile::Default;
+        this->readLayers.setEnabled(isDefaultProfile);
+        this->readProperties.setEnabled(isDefaultProfile);
+        this->readGdt.setEnabled(isDefaultProfile);
+        this->readMaterials.setEnabled(isDefaultProfile);
+        this->readViews.setEnabled(isDefaultProfile);
+    }
+
+    PropertyEnum<Profile> profile{ this, textId("profile") };
     PropertyEnum<ProductContext> productContext{ this, textId("productContext") };
     PropertyEnum<AssemblyLevel> assemblyLevel{ this, textId("assemblyLevel") };
     PropertyEnum<ShapeRepresentation> preferredShapeRepresentation{ this, textId("preferredShapeRepresentation") };
     PropertyBool readShapeAspect{ this, textId("readShapeAspect") };
     PropertyBool readSubShapesNames{ this, textId("readSubShapesNames") };
     PropertyEnum<Encoding> encoding{ this, textId("encoding") };
+    PropertyBool readLayers{ this, textId("readLayers") };
+    PropertyBool readProperties{ this, textId("readProperties") };
+    PropertyBool readGdt{ this, textId("readGdt") };
+    PropertyBool readMaterials{ this, textId("readMaterials") };
+    PropertyBool readViews{ this, textId("readViews") };
+    PropertyBool parallelShapeTransfer{ this, textId("parallelShapeTransfer") };
+    PropertyBool loadShapesOnDemand{ this, textId("loadShapesOnDemand") };
+    PropertyEnum<OccCommon::ShapeHealing> shapeHealing{ this, textId("shapeHealing") };
+};
+
+// Translates the shapes of the parts imported as empty compounds in structure-only mode
+// Each product is translated in a fresh transient process bound to the STEP model of the import
+class OccStepReader::ShapeLoader : public DeferredShapeLoader {
+public:
+    ShapeLoader(const Handle_XSControl_WorkSession& ws, const OccStepReader::Parameters& params)
+        : m_model(ws->Model()),
+          m_graph(ws->HGraph()),
+          m_params(params)
+    {
+        m_params.assemblyLevel = AssemblyLevel::Shape;
+        m_params.loadShapesOnDemand = false;
+    }
+
+    void addProduct(const TDF_Label& label, const Handle_StepBasic_ProductDefinition& product) {
+        if (m_mapLabelProduct.insert({ label, product }).second)
+            m_vecProductLabel.push_back(label);
+    }
+
+    bool isEmpty() const { return m_vecProductLabel.empty(); }
+
+    std::vector<TDF_Label> deferredProducts() const override {
+        return m_vecProductLabel;
+    }
+
+    TopoDS_Shape loadShape(const TDF_Label& labelProduct, TaskProgress* progress) override
+    {
+        auto itProduct = m_mapLabelProduct.find(labelProduct);
+        if (itProduct == m_mapLabelProduct.cend() || TaskProgress::isAbortRequested(progress))
+            return {};
+
+        // STEP actor applies the units of representations to process-global factors, shared
+        // with the transfers of other files
+        std::lock_guard<std::mutex> lock(m_mutex); MAYO_UNUSED(lock);
+        MayoIO_CafStepUnitsScopedLock(unitsLock);
+        OccStaticVariablesContext context;
+        OccStepReader::changeStaticVariables(m_params, &context);
+        OccStaticVariablesScope staticVarsScope(context);
+        OccShapeHealingPerfScope healingPerfScope(PerfStats::of(progress));
+        Handle_Transfer_TransientProcess tp = new Transfer_TransientProcess(m_model->NbEntities());
+        tp->SetModel(m_model);
+        tp->SetGraph(m_graph);
+        Handle_STEPControl_ActorRead actor = new STEPControl_ActorRead;
+        try {
+            return TransferBRep::ShapeResult(actor->TransferShape(itProduct->second, tp));
+        } catch (const Standard_Failure&) {
+            return {};
+        }
+    }
+
+private:
+    Handle_Interface_InterfaceModel m_model;
+    Handle_Interface_HGraph m_graph;
+    OccStepReader::Parameters m_params;
+    std::vector<TDF_Label> m_vecProductLabel;
+    std::unordered_map<TDF_Label, Handle_StepBasic_ProductDefinition> m_mapLabelProduct;
+    std::mutex m_mutex;
 };
 
 OccStepReader::OccStepReader()
 {
-    MayoIO_CafGlobalScopedLock(cafLock);
+    MayoIO_CafStaticVariablesScopedLock(cafLock);
     m_reader = new(&m_readerStorage) STEPCAFControl_Reader();
     STEPCAFControl_Controller::Init();
     m_reader->SetColorMode(true);
     m_reader->SetNameMode(true);
-    m_reader->SetLayerMode(true);
-    m_reader->SetPropsMode(true);
-    m_reader->SetGDTMode(true);
-    m_reader->SetMatMode(true);
-    m_reader->SetViewMode(true);
+    this->changeReaderModes();
 }
 
 OccStepReader::~OccStepReader()
@@ -135,18 +404,54 @@ OccStepReader::~OccStepReader()
 
 bool OccStepReader::readFile(const FilePath& filepath, TaskProgress* progress)
 {
-    MayoIO_CafGlobalScopedLock(cafLock);
-    OccStaticVariablesRollback rollback;
-    this->changeStaticVariables(&rollback);
+    MayoIO_CafStepParserScopedLock(parserLock);
+    OccStaticVariablesContext context;
+    OccStepReader::changeStaticVariables(m_params, &context);
+    OccStaticVariablesScope staticVarsScope(context);
     return Private::cafReadFile(*m_reader, filepath, progress);
 }
 
+bool OccStepReader::readStream(std::istream& istr, const FilePath& name, TaskProgress* progress)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 7, 0)
+    MayoIO_CafStepParserScopedLock(parserLock);
+    OccStaticVariablesContext context;
+    OccStepReader::changeStaticVariables(m_params, &context);
+    OccStaticVariablesScope staticVarsScope(context);
+    return Private::cafReadStream(*m_reader, istr, name, progress);
+#else
+    return Reader::readStream(istr, name, progress);
+#endif
+}
+
+bool OccStepReader::readsStream() const
+{
+    return OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 7, 0);
+}
+
 TDF_LabelSequence OccStepReader::transfer(DocumentPtr doc, TaskProgress* progress)
 {
-    MayoIO_CafGlobalScopedLock(cafLock);
-    OccStaticVariablesRollback rollback;
-    this->changeStaticVariables(&rollback);
-    return Private::cafTransfer(*m_reader, doc, progress);
+    MayoIO_CafDocumentScopedLock(docLock, doc);
+    MayoIO_CafStepUnitsScopedLock(unitsLock);
+    OccStaticVariablesContext context;
+    OccStepReader::changeStaticVariables(m_params, &context);
+    OccStaticVariablesScope staticVarsScope(context);
+    OccShapeHealingPerfScope healingPerfScope(PerfStats::of(progress));
+    this->changeReaderModes();
+    if (m_params.loadShapesOnDemand) {
+        const TDF_LabelSequence seqLabel = Private::cafTransfer(*m_reader, doc, progress);
+        this->attachShapeLoader(doc);
+        return seqLabel;
+    }
+
+    if (!m_params.parallelShapeTransfer)
+        return Private::cafTransfer(*m_reader, doc, progress);
+
+    // Still under 'unitsLock', required by transferItemShapesInParallel()
+    TaskProgress shapesProgress(progress, 60);
+    this->transferItemShapesInParallel(&shapesProgress);
+    TaskProgress cafProgress(progress, 40);
+    return Private::cafTransfer(*m_reader, doc, &cafProgress);
 }
 
 std::unique_ptr<PropertyGroup> OccStepReader::createProperties(PropertyGroup* parentGroup)
@@ -164,10 +469,182 @@ void OccStepReader::applyProperties(const PropertyGroup* group)
         m_params.readShapeAspect = ptr->readShapeAspect;
         m_params.readSubShapesNames = ptr->readSubShapesNames;
         m_params.encoding = ptr->encoding;
+        m_params.readLayers = ptr->readLayers;
+        m_params.readProperties = ptr->readProperties;
+        m_params.readGdt = ptr->readGdt;
+        m_params.readMaterials = ptr->readMaterials;
+        m_params.readViews = ptr->readViews;
+        m_params.profile = ptr->profile;
+        m_params.parallelShapeTransfer = ptr->parallelShapeTransfer;
+        m_params.loadShapesOnDemand = ptr->loadShapesOnDemand;
+        m_params.shapeHealing = ptr->shapeHealing;
+    }
+}
+
+bool OccStepReader::resetSession()
+{
+    if (m_isWorkSessionShared)
+        return false;
+
+    MayoIO_CafStaticVariablesScopedLock(cafLock);
+    // Creates a new empty model and clears the transfer maps, reader modes are kept
+    m_reader->Init(Private::cafWorkSession(*m_reader), true/*scratch*/);
+    m_reader->ChangeReader().ClearShapes();
+    m_params = {};
+    this->changeReaderModes();
+    this->removeSpoolFile();
+    return true;
+}
+
+void OccStepReader::changeReaderModes()
+{
+    // Shapes, names and colors are always translated, other data can be skipped
+    const bool isDefaultProfile = m_params.profile == Profile::Default;
+    m_reader->SetLayerMode(isDefaultProfile && m_params.readLayers);
+    m_reader->SetPropsMode(isDefaultProfile && m_params.readProperties);
+    m_reader->SetGDTMode(isDefaultProfile && m_params.readGdt);
+    m_reader->SetMatMode(isDefaultProfile && m_params.readMaterials);
+    m_reader->SetViewMode(isDefaultProfile && m_params.readViews);
+}
+
+void OccStepReader::attachShapeLoader(const DocumentPtr& doc)
+{
+    // Parts are the products the structure-only transfer bound to empty compounds
+    Handle_XSControl_WorkSession ws = Private::cafWorkSession(*m_reader);
+    const Handle_Transfer_TransientProcess tp = ws->TransferReader()->TransientProcess();
+    if (!tp)
+        return;
+
+    auto loader = std::make_shared<ShapeLoader>(ws, m_params);
+    m_isWorkSessionShared = true;
+    const Handle_XCAFDoc_ShapeTool shapeTool = doc->xcaf().shapeTool();
+    for (int i = 1; i <= tp->NbMapped(); ++i) {
+        auto product = Handle_StepBasic_ProductDefinition::DownCast(tp->Mapped(i));
+        if (!product)
+            continue;
+
+        const TopoDS_Shape shape = TransferBRep::ShapeResult(tp->MapItem(i));
+        TDF_Label label;
+        if (!shape.IsNull() && !TopoDS_Iterator(shape).More() && shapeTool->FindShape(shape, label))
+            loader->addProduct(label, product);
     }
+
+    if (!loader->isEmpty())
+        doc->addDeferredShapeLoader(loader);
 }
 
-void OccStepReader::changeStaticVariables(OccStaticVariablesRollback* rollback) const
+void OccStepReader::transferItemShapesInParallel(TaskProgress* progress)
+{
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 8, 0)
+    // Solid items of products are translated here over worker threads, then bound into the
+    // transient process of the reader. STEPCAFControl_Reader::Transfer() afterwards finds them
+    // already translated and only builds the assembly structure, names, colors, ...
+    // Non-manifold mode translates solids differently, keep it on the standard path
+    Handle_XSControl_WorkSession ws = Private::cafWorkSession(*m_reader);
+    const Handle_XSControl_TransferReader& transferReader = ws->TransferReader();
+    if (!ws->Model() || Interface_Static::IVal("read.step.nonmanifold") != 0 || !transferReader->BeginTransfer())
+        return;
+
+    const Handle_Interface_InterfaceModel model = ws->Model();
+    const Handle_Transfer_TransientProcess mainTp = transferReader->TransientProcess();
+    std::vector<StepItemShapeJob> vecJob;
+    std::unordered_set<const Standard_Transient*> setItem;
+    for (int i = 1; i <= model->NbEntities(); ++i) {
+        auto representation = Handle_StepRepr_Representation::DownCast(model->Value(i));
+        if (!representation || !representation->Items())
+            continue;
+
+        for (int j = 1; j <= representation->NbItems(); ++j) {
+            auto item = Handle_StepShape_ManifoldSolidBrep::DownCast(representation->ItemsValue(j));
+            if (item && !mainTp->IsBound(item) && setItem.insert(item.get()).second)
+                vecJob.push_back({ representation, item });
+        }
+    }
+
+    // Actors apply the units of the representation context to process-global factors, so jobs
+    // are grouped by units and each group is translated while its units are the active ones
+    // The factors are shared with any other STEP transfer of the process: the caller holds the
+    // STEP units lock(see MayoIO_CafStepUnitsScopedLock) from this grouping until the last group
+    // is translated, otherwise a concurrent transfer could change them in between
+    std::map<StepUnitsKey, std::vector<const StepItemShapeJob*>> mapUnitsJobs;
+    {
+        std::unordered_map<const Standard_Transient*, StepUnitsKey> mapContextUnitsKey;
+        Handle_STEPControl_ActorRead probeActor = new STEPControl_ActorRead;
+        Handle_Transfer_TransientProcess probeTp = new Transfer_TransientProcess;
+        probeTp->SetModel(model);
+        for (const StepItemShapeJob& job : vecJob) {
+            const Handle_StepRepr_RepresentationContext& context = job.representation->ContextOfItems();
+            auto itUnitsKey = mapContextUnitsKey.find(context.get());
+            if (itUnitsKey == mapContextUnitsKey.cend()) {
+                probeActor->PrepareUnits(job.representation, probeTp);
+                itUnitsKey = mapContextUnitsKey.insert({ context.get(), stepPreparedUnitsKey(context) }).first;
+            }
+
+            mapUnitsJobs[itUnitsKey->second].push_back(&job);
+        }
+    }
+
+    const int threadCount = std::max(int(std::thread::hardware_concurrency()), 1);
+    int jobDoneCount = 0;
+    for (const auto& [unitsKey, vecGroupJob] : mapUnitsJobs) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        // Prepare one actor and transient process by worker, sequentially as units are global
+        const int workerCount = std::clamp(int(vecGroupJob.size()), 1, threadCount);
+        std::vector<Handle_STEPControl_ActorRead> vecActor;
+        std::vector<Handle_Transfer_TransientProcess> vecTp;
+        for (int i = 0; i < workerCount; ++i) {
+            Handle_Transfer_TransientProcess tp = new Transfer_TransientProcess(model->NbEntities());
+            tp->SetModel(model);
+            tp->SetGraph(ws->HGraph());
+            Handle_STEPControl_ActorRead actor = new STEPControl_ActorRead;
+            actor->PrepareUnits(vecGroupJob.front()->representation, tp);
+            vecActor.push_back(actor);
+            vecTp.push_back(tp);
+        }
+
+        std::atomic<int> jobIndexSeq = 0;
+        CppUtils::parallelFor(workerCount, [&](int iWorker) {
+            OccShapeHealingPerfScope healingPerfScope(PerfStats::of(progress));
+            const Handle_STEPControl_ActorRead& actor = vecActor.at(iWorker);
+            const Handle_Transfer_TransientProcess& tp = vecTp.at(iWorker);
+            const int jobCount = int(vecGroupJob.size());
+            for (int i = jobIndexSeq++; i < jobCount; i = jobIndexSeq++) {
+                if (TaskProgress::isAbortRequested(progress))
+                    return;
+
+                const Handle_StepShape_ManifoldSolidBrep& item = vecGroupJob.at(i)->item;
+                try {
+                    Handle_Transfer_Binder binder = actor->TransferShape(item, tp);
+                    if (binder && binder->HasResult() && !tp->IsBound(item))
+                        tp->Bind(item, binder);
+                } catch (const Standard_Failure&) {
+                    // Item is left to the standard transfer, which reports the failure
+                }
+            }
+        });
+
+        // Merge the bindings of workers(items and their sub-entities) into the reader
+        for (const Handle_Transfer_TransientProcess& tp : vecTp) {
+            for (int i = 1; i <= tp->NbMapped(); ++i) {
+                const Handle_Transfer_Binder binder = tp->MapItem(i);
+                const Handle_Standard_Transient& entity = tp->Mapped(i);
+                if (binder && binder->HasResult() && !mainTp->IsBound(entity))
+                    mainTp->Bind(entity, binder);
+            }
+        }
+
+        jobDoneCount += int(vecGroupJob.size());
+        if (progress)
+            progress->setValue((jobDoneCount * 100) / int(vecJob.size()));
+    }
+#else
+    MAYO_UNUSED(progress);
+#endif
+}
+
+void OccStepReader::changeStaticVariables(const Parameters& params, OccStaticVariablesContext* context)
 {
     auto fnOccEncoding = [](Encoding code) {
         switch (code) {
@@ -209,12 +686,14 @@ void OccStepReader::changeStaticVariables(OccStaticVariablesRollback* rollback)
         "read.stepcaf.codepage";
 #endif
 
-    rollback->change("read.step.product.context", int(m_params.productContext));
-    rollback->change("read.step.assembly.level", int(m_params.assemblyLevel));
-    rollback->change("read.step.shape.repr", int(m_params.preferredShapeRepresentation));
-    rollback->change("read.step.shape.aspect", int(m_params.readShapeAspect ? 1 : 0));
-    rollback->change("read.stepcaf.subshapes.name", int(m_params.readSubShapesNames ? 1 : 0));
-    rollback->change(strKeyReadStepCodePage, fnOccEncoding(m_params.encoding));
+    const AssemblyLevel assemblyLevel = params.loadShapesOnDemand ? AssemblyLevel::Structure : params.assemblyLevel;
+    context->change("read.step.product.context", int(params.productContext));
+    context->change("read.step.assembly.level", int(assemblyLevel));
+    context->change("read.step.shape.repr", int(params.preferredShapeRepresentation));
+    context->change("read.step.shape.aspect", int(params.readShapeAspect ? 1 : 0));
+    context->change("read.stepcaf.subshapes.name", int(params.readSubShapesNames ? 1 : 0));
+    context->change(strKeyReadStepCodePage, fnOccEncoding(params.encoding));
+    OccCommon::changeShapeHealingVariables("step", params.shapeHealing, context);
 }
 
 class OccStepWriter::Properties : public PropertyGroup {
@@ -287,7 +766,7 @@ public:
 
 OccStepWriter::OccStepWriter()
 {
-    MayoIO_CafGlobalScopedLock(cafLock);
+    MayoIO_CafStaticVariablesScopedLock(cafLock);
     m_writer = new(&m_writerStorage) STEPCAFControl_Writer();
     STEPCAFControl_Controller::Init();
     m_writer->SetColorMode(true);
@@ -303,19 +782,49 @@ OccStepWriter::~OccStepWriter()
     m_writer->~STEPCAFControl_Writer();
 }
 
+bool OccStepWriter::resetSession()
+{
+    MayoIO_CafStaticVariablesScopedLock(cafLock);
+    // Clears the label maps of the previous transfer, a new model is created by transfer() anyway
+    m_writer->Init(m_writer->ChangeWriter().WS(), true/*scratch*/);
+    m_params = {};
+    return true;
+}
+
 bool OccStepWriter::transfer(Span<const ApplicationItem> appItems, TaskProgress* progress)
 {
-    MayoIO_CafGlobalScopedLock(cafLock);
-    OccStaticVariablesRollback rollback;
-    this->changeStaticVariables(&rollback);
+    MayoIO_CafStepUnitsScopedLock(unitsLock);
+    OccStaticVariablesContext context;
+    this->changeStaticVariables(&context);
+    OccStaticVariablesScope staticVarsScope(context);
+    // NOTE from $OCC_7.4.0_DIR/doc/pdf/user_guides/occt_step.pdf (page 26)
+    // For the parameter "write.step.schema" to take effect, method STEPControl_Writer::Model(true)
+    // should be called after changing this parameter (corresponding command in DRAW is "newmodel")
+    // Previous value of "write.step.schema" can't be known here(it depends on the other active
+    // contexts), so a new model is always created before transfer
+    m_writer->ChangeWriter().Model(true);
     return Private::cafTransfer(*m_writer, appItems, progress);
 }
 
-bool OccStepWriter::writeFile(const FilePath& filepath, TaskProgress* /*progress*/)
+bool OccStepWriter::writeFile(const FilePath& filepath, TaskProgress* progress)
 {
-    MayoIO_CafGlobalScopedLock(cafLock);
-    OccStaticVariablesRollback rollback;
-    this->changeStaticVariables(&rollback);
+    return this->write(filepath, nullptr, progress);
+}
+
+bool OccStepWriter::writeStream(std::ostream& ostr, TaskProgress* progress)
+{
+    return this->write({}, &ostr, progress);
+}
+
+bool OccStepWriter::write(const FilePath& filepath, std::ostream* ostr, TaskProgress* progress)
+{
+    // OpenCascade writer doesn't check user break
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
+    OccStaticVariablesContext context;
+    this->changeStaticVariables(&context);
+    OccStaticVariablesScope staticVarsScope(context);
 
     APIHeaderSection_MakeHeader makeHeader(m_writer->ChangeWriter().Model());
     makeHeader.SetAuthorValue(
@@ -327,8 +836,34 @@ bool OccStepWriter::writeFile(const FilePath& filepath, TaskProgress* /*progress
     makeHeader.SetDescriptionValue(
                 1, StringUtils::toUtf8<Handle_TCollection_HAsciiString>(m_params.headerDescription));
 
-    const IFSelect_ReturnStatus err = m_writer->Write(filepath.u8string().c_str());
-    return err == IFSelect_RetDone;
+    const Handle_XSControl_WorkSession ws = m_writer->ChangeWriter().WS();
+    auto protocol = Handle_StepData_Protocol::DownCast(ws->Protocol());
+    const Handle_StepData_StepModel model = m_writer->ChangeWriter().Model();
+    if (!protocol || !model) {
+        if (ostr) {
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 7, 0)
+            return m_writer->ChangeWriter().WriteStream(*ostr) == IFSelect_RetDone;
+#else
+            return false;
+#endif
+        }
+
+        const IFSelect_ReturnStatus err = m_writer->Write(filepath.u8string().c_str());
+        return err == IFSelect_RetDone;
+    }
+
+    if (ostr) {
+        const bool okWrite = stepWriteModelChunked(model, protocol, *ostr, progress);
+        ostr->flush();
+        return okWrite && ostr->good();
+    }
+
+    std::ofstream outs;
+    OSD_OpenStream(outs, filepath.u8string().c_str(), std::ios::out | std::ios::trunc);
+    if (!outs)
+        return false;
+
+    return stepWriteModelChunked(model, protocol, outs, progress);
 }
 
 std::unique_ptr<PropertyGroup> OccStepWriter::createProperties(PropertyGroup* parentGroup)
@@ -353,22 +888,14 @@ void OccStepWriter::applyProperties(const PropertyGroup* group)
     }
 }
 
-void OccStepWriter::changeStaticVariables(OccStaticVariablesRollback* rollback)
+void OccStepWriter::changeStaticVariables(OccStaticVariablesContext* context) const
 {
-    const int previousSchema = Interface_Static::IVal("write.step.schema");
-    rollback->change("write.step.schema", int(m_params.schema));
-    if (int(m_params.schema) != previousSchema) {
-        // NOTE from $OCC_7.4.0_DIR/doc/pdf/user_guides/occt_step.pdf (page 26)
-        // For the parameter "write.step.schema" to take effect, method STEPControl_Writer::Model(true)
-        // should be called after changing this parameter (corresponding command in DRAW is "newmodel")
-        m_writer->ChangeWriter().Model(true);
-    }
-
-    rollback->change("write.step.unit", OccCommon::toCafString(m_params.lengthUnit));
-    rollback->change("write.step.assembly", int(m_params.assemblyMode));
-    rollback->change("write.step.vertex.mode", int(m_params.freeVertexMode));
-    rollback->change("write.surfacecurve.mode", int(m_params.writeParametricCurves ? 1 : 0));
-    rollback->change("write.stepcaf.subshapes.name", int(m_params.writeSubShapesNames ? 1 : 0));
+    context->change("write.step.schema", int(m_params.schema));
+    context->change("write.step.unit", OccCommon::toCafString(m_params.lengthUnit));
+    context->change("write.step.assembly", int(m_params.assemblyMode));
+    context->change("write.step.vertex.mode", int(m_params.freeVertexMode));
+    context->change("write.surfacecurve.mode", int(m_params.writeParametricCurves ? 1 : 0));
+    context->change("write.stepcaf.subshapes.name", int(m_params.writeSubShapesNames ? 1 : 0));
 }
 
 } // namespace IO
@@ -19,7 +19,7 @@
 namespace Mayo {
 namespace IO {
 
-class OccStaticVariablesRollback;
+class OccStaticVariablesContext;
 
 // Opencascade-based reader for STEP file format
 class OccStepReader : public Reader {
@@ -28,6 +28,9 @@ public:
     ~OccStepReader();
 
     bool readFile(const FilePath& filepath, TaskProgress* progress) override;
+    // Parses the stream directly with OpenCascade >= v7.7.0
+    bool readStream(std::istream& istr, const FilePath& name, TaskProgress* progress) override;
+    bool readsStream() const override;
     TDF_LabelSequence transfer(DocumentPtr doc, TaskProgress* progress) override;
 
     // Parameters
@@ -81,13 +84,31 @@ public:
 #endif
     };
 
+    // Predefined set of data to be translated
+    enum class Profile {
+        Default,    // Data selected by the `read*` parameters
+        FastViewing // Only shapes, names and colors, `read*` parameters for other data are ignored
+    };
+
+    using ShapeHealing = OccCommon::ShapeHealing;
     struct Parameters {
+        Profile profile = Profile::Default;
         ProductContext productContext = ProductContext::Both;
         AssemblyLevel assemblyLevel = AssemblyLevel::All;
         ShapeRepresentation preferredShapeRepresentation = ShapeRepresentation::All;
         bool readShapeAspect = true;
         bool readSubShapesNames = false;
         Encoding encoding = Encoding::UTF8;
+        bool readLayers = true;
+        bool readProperties = true;
+        bool readGdt = true;
+        bool readMaterials = true;
+        bool readViews = true;
+        bool parallelShapeTransfer = false;
+        ShapeHealing shapeHealing = ShapeHealing::Full;
+        // Transfers only the assembly structure, shapes of parts are translated later with the
+        // DeferredShapeLoader attached to the document
+        bool loadShapesOnDemand = false;
     };
     Parameters& parameters() { return m_params; }
     const Parameters& constParameters() const { return m_params; }
@@ -95,13 +116,22 @@ public:
     static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
     void applyProperties(const PropertyGroup* params) override;
 
+    // Not reusable once the work session was handed over to a DeferredShapeLoader
+    bool resetSession() override;
+
 private:
-    void changeStaticVariables(OccStaticVariablesRollback* rollback) const;
+    static void changeStaticVariables(const Parameters& params, OccStaticVariablesContext* context);
+    void changeReaderModes();
+    void attachShapeLoader(const DocumentPtr& doc);
+    // Requires the STEP units lock to be held by the caller(see MayoIO_CafStepUnitsScopedLock)
+    void transferItemShapesInParallel(TaskProgress* progress);
 
     class Properties;
+    class ShapeLoader;
     STEPCAFControl_Reader* m_reader = nullptr;
     std::aligned_storage_t<sizeof(STEPCAFControl_Reader)> m_readerStorage;
     Parameters m_params;
+    bool m_isWorkSessionShared = false;
 };
 
 // Opencascade-based writer for STEP file format
@@ -112,6 +142,7 @@ public:
 
     bool transfer(Span<const ApplicationItem> appItems, TaskProgress* progress) override;
     bool writeFile(const FilePath& filepath, TaskProgress* progress) override;
+    bool writeStream(std::ostream& ostr, TaskProgress* progress) override;
 
     // Parameters
 
@@ -150,8 +181,12 @@ public:
     static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
     void applyProperties(const PropertyGroup* params) override;
 
+    bool resetSession() override;
+
 private:
-    void changeStaticVariables(OccStaticVariablesRollback* rollback);
+    void changeStaticVariables(OccStaticVariablesContext* context) const;
+    // Writes into 'ostr' if not null, otherwise into file 'filepath'
+    bool write(const FilePath& filepath, std::ostream* ostr, TaskProgress* progress);
 
     class Properties;
     STEPCAFControl_Writer* m_writer = nullptr;
@@ -7,46 +7,640 @@
 #include "io_occ_stl.h"
 
 #include "../base/application_item.h"
+#include "../base/async_file_stream.h"
 #include "../base/brep_utils.h"
 #include "../base/document.h"
+#include "../base/mapped_file.h"
+#include "../base/mesh_decimation.h"
+#include "../base/mesh_utils.h"
 #include "../base/caf_utils.h"
-#include "../base/occ_progress_indicator.h"
+#include "../base/cpp_utils.h"
+#include "../base/property_builtins.h"
 #include "../base/property_enumeration.h"
+#include "../base/stream_utils.h"
 #include "../base/string_utils.h"
 #include "../base/task_progress.h"
 #include "../base/tkernel_utils.h"
+#include "../base/unit_system.h"
 
 #include <QtCore/QtDebug>
-#include <BRep_Builder.hxx>
-#include <BRepTools.hxx>
-#include <RWStl.hxx>
-#include <StlAPI_Writer.hxx>
+#include <QtCore/QtEndian>
 #include <TDataXtd_Triangulation.hxx>
-#include <TopoDS_Compound.hxx>
+#include <TopoDS.hxx>
+#include <TShort_HArray1OfShortReal.hxx>
+#include <fast_float/fast_float.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace Mayo {
 namespace IO {
 
 namespace {
 
-static TopoDS_Shape asShape(const DocumentPtr& doc)
+// Single-precision vertex, as found in binary STL files
+struct StlVertex {
+    float coords[3];
+};
+
+// Count of facets in a chunk of work(parsing, merging of vertices, ...)
+constexpr int StlChunkFacetCount = 64 * 1024;
+
+// Vertices are merged in independent partitions, selected by the high bits of the vertex hash
+constexpr int StlPartitionBits = 6;
+constexpr int StlPartitionCount = 1 << StlPartitionBits;
+
+uint64_t stlVertexHash(const StlVertex& vertex)
+{
+    uint32_t bits[3];
+    std::memcpy(bits, vertex.coords, sizeof(bits));
+    constexpr uint64_t k = 0x9E3779B97F4A7C15ull;
+    uint64_t h = bits[0];
+    h = (h * k) ^ bits[1];
+    h = (h * k) ^ bits[2];
+    h *= k;
+    return h ^ (h >> 29);
+}
+
+bool stlVertexEqual(const StlVertex& lhs, const StlVertex& rhs)
+{
+    return std::memcmp(lhs.coords, rhs.coords, sizeof(lhs.coords)) == 0;
+}
+
+// Normalizes -0 to +0, so coincident vertices have the same binary representation
+float stlCoord(float value)
+{
+    return value == 0.f ? 0.f : value;
+}
+
+float stlReadFloatLE(const uchar* data)
+{
+    const quint32 bits = qFromLittleEndian<quint32>(data);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return stlCoord(value);
+}
+
+// Binary STL: 80 bytes header, facet count(uint32) then facet records of 50 bytes
+constexpr qint64 StlBinaryHeaderSize = 84;
+constexpr qint64 StlBinaryFacetSize = 50;
+
+bool stlIsBinary(const uchar* data, qint64 size)
+{
+    if (size < StlBinaryHeaderSize)
+        return false;
+
+    const qint64 facetCount = qFromLittleEndian<quint32>(data + 80);
+    if (StlBinaryHeaderSize + facetCount * StlBinaryFacetSize == size)
+        return true;
+
+    // Not a valid binary file size, then the contents must start with "solid" to be ASCII
+    const uchar* it = data;
+    const uchar* itEnd = data + size;
+    while (it != itEnd && std::isspace(*it))
+        ++it;
+
+    return itEnd - it < 5 || std::strncmp(reinterpret_cast<const char*>(it), "solid", 5) != 0;
+}
+
+// Parses facets of binary STL contents, three vertices are added per facet
+bool stlParseBinary(
+        const uchar* data, qint64 size, std::vector<StlVertex>* ptrVecVertex, TaskProgress* progress)
+{
+    // Tolerate truncated files: only the complete facets are read
+    const qint64 facetCount = std::min<qint64>(
+                qFromLittleEndian<quint32>(data + 80),
+                (size - StlBinaryHeaderSize) / StlBinaryFacetSize);
+    if (facetCount * 3 > std::numeric_limits<int>::max())
+        return false;
+
+    std::vector<StlVertex>& vecVertex = *ptrVecVertex;
+    vecVertex.resize(facetCount * 3);
+    const int chunkCount = int((facetCount + StlChunkFacetCount - 1) / StlChunkFacetCount);
+    TaskChunkProgress chunkProgress(progress, chunkCount, 0, 60);
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        const qint64 iFacetBegin = qint64(iChunk) * StlChunkFacetCount;
+        const qint64 iFacetEnd = std::min<qint64>(iFacetBegin + StlChunkFacetCount, facetCount);
+        for (qint64 iFacet = iFacetBegin; iFacet < iFacetEnd; ++iFacet) {
+            // Skip facet normal, it's recomputed from vertices when needed
+            const uchar* facetData = data + StlBinaryHeaderSize + iFacet * StlBinaryFacetSize + 12;
+            for (int i = 0; i < 3; ++i) {
+                StlVertex& vertex = vecVertex[iFacet * 3 + i];
+                for (int j = 0; j < 3; ++j)
+                    vertex.coords[j] = stlReadFloatLE(facetData + (i * 3 + j) * 4);
+            }
+        }
+
+        chunkProgress.chunkDone();
+    });
+
+    return !TaskProgress::isAbortRequested(progress);
+}
+
+bool stlIsSpace(char c)
+{
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+// Finds the first "facet" keyword in [itBegin, itEnd), or returns itEnd
+const char* stlFindFacetStart(const char* itBegin, const char* itFrom, const char* itEnd)
 {
-    TopoDS_Shape shape;
-    const TDF_LabelSequence seqFreeShape = doc->xcaf().topLevelFreeShapes();
-    if (seqFreeShape.Size() > 1) {
-        TopoDS_Compound cmpd;
-        BRep_Builder builder;
-        builder.MakeCompound(cmpd);
-        for (const TDF_Label& label : seqFreeShape)
-            builder.Add(cmpd, XCaf::shape(label));
+    const char* it = itFrom;
+    while (it < itEnd) {
+        it = static_cast<const char*>(std::memchr(it, 'f', itEnd - it));
+        if (!it)
+            return itEnd;
+
+        // Note: "endfacet" is rejected as it's not preceded by a space
+        const bool isKeyword =
+                itEnd - it >= 5
+                && std::strncmp(it, "facet", 5) == 0
+                && (it == itBegin || stlIsSpace(*(it - 1)));
+        if (isKeyword)
+            return it;
+
+        ++it;
+    }
+
+    return itEnd;
+}
 
-        shape = cmpd;
+// Parses facets in ASCII STL excerpt, only facets having exactly three vertices are kept
+void stlParseAsciiChunk(const char* itBegin, const char* itEnd, std::vector<StlVertex>* ptrVecVertex)
+{
+    auto fnIsWord = [](const char* it, const char* itWordEnd, const char* keyword) {
+        const size_t len = std::strlen(keyword);
+        return size_t(itWordEnd - it) == len && std::strncmp(it, keyword, len) == 0;
+    };
+
+    StlVertex facet[3];
+    int facetVertexCount = 0;
+    const char* it = itBegin;
+    while (it < itEnd) {
+        while (it < itEnd && stlIsSpace(*it))
+            ++it;
+
+        const char* itWordEnd = it;
+        while (itWordEnd < itEnd && !stlIsSpace(*itWordEnd))
+            ++itWordEnd;
+
+        if (fnIsWord(it, itWordEnd, "vertex")) {
+            it = itWordEnd;
+            StlVertex vertex;
+            bool ok = true;
+            for (int i = 0; i < 3 && ok; ++i) {
+                while (it < itEnd && stlIsSpace(*it))
+                    ++it;
+
+                const fast_float::from_chars_result res = fast_float::from_chars(it, itEnd, vertex.coords[i]);
+                ok = res.ec == std::errc();
+                vertex.coords[i] = stlCoord(vertex.coords[i]);
+                it = ok ? res.ptr : it;
+            }
+
+            if (ok && facetVertexCount < 3)
+                facet[facetVertexCount] = vertex;
+
+            facetVertexCount = ok ? facetVertexCount + 1 : 4; // Invalid facet
+        }
+        else if (fnIsWord(it, itWordEnd, "endfacet")) {
+            if (facetVertexCount == 3)
+                ptrVecVertex->insert(ptrVecVertex->end(), std::begin(facet), std::end(facet));
+
+            facetVertexCount = 0;
+            it = itWordEnd;
+        }
+        else {
+            if (fnIsWord(it, itWordEnd, "facet"))
+                facetVertexCount = 0;
+
+            it = itWordEnd;
+        }
     }
-    else if (seqFreeShape.Size() == 1) {
-        shape = XCaf::shape(seqFreeShape.First());
+}
+
+// Parses facets of ASCII STL contents, three vertices are added per facet
+// Contents are split in chunks starting at "facet" keywords, chunks are then parsed concurrently
+bool stlParseAscii(
+        const char* data, qint64 size, std::vector<StlVertex>* ptrVecVertex, TaskProgress* progress)
+{
+    constexpr qint64 chunkSize = 4 * 1024 * 1024;
+    const char* itEnd = data + size;
+    std::vector<const char*> vecChunkStart;
+    vecChunkStart.push_back(data);
+    for (qint64 pos = chunkSize; pos < size; pos += chunkSize) {
+        const char* itChunkStart = stlFindFacetStart(data, data + pos, itEnd);
+        if (itChunkStart > vecChunkStart.back() && itChunkStart < itEnd)
+            vecChunkStart.push_back(itChunkStart);
     }
 
-    return shape;
+    vecChunkStart.push_back(itEnd);
+    const int chunkCount = int(vecChunkStart.size()) - 1;
+    std::vector<std::vector<StlVertex>> vecChunkVertex(chunkCount);
+    TaskChunkProgress chunkProgress(progress, chunkCount, 0, 50);
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        stlParseAsciiChunk(vecChunkStart.at(iChunk), vecChunkStart.at(iChunk + 1), &vecChunkVertex.at(iChunk));
+        chunkProgress.chunkDone();
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
+    // Concatenate vertices of all chunks, preserving facet order
+    std::vector<size_t> vecChunkOffset(chunkCount + 1, 0);
+    for (int i = 0; i < chunkCount; ++i)
+        vecChunkOffset.at(i + 1) = vecChunkOffset.at(i) + vecChunkVertex.at(i).size();
+
+    if (vecChunkOffset.back() > size_t(std::numeric_limits<int>::max()))
+        return false;
+
+    std::vector<StlVertex>& vecVertex = *ptrVecVertex;
+    vecVertex.resize(vecChunkOffset.back());
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        std::vector<StlVertex>& vecChunk = vecChunkVertex.at(iChunk);
+        std::copy(vecChunk.cbegin(), vecChunk.cend(), vecVertex.begin() + vecChunkOffset.at(iChunk));
+        std::vector<StlVertex>().swap(vecChunk);
+    });
+
+    if (progress)
+        progress->setValue(60);
+
+    return true;
+}
+
+// Creates mesh where coincident vertices are merged into single nodes. Degenerated facets are
+// discarded
+// Vertices are dispatched in partitions(per hash value), each partition is merged independently
+// with its own hash table, so the merge runs concurrently without any locking
+Handle_Poly_Triangulation stlCreateIndexedMesh(const std::vector<StlVertex>& vecVertex, TaskProgress* progress)
+{
+    const int vertexCount = int(vecVertex.size());
+    const int facetCount = vertexCount / 3;
+    const int chunkCount = (facetCount + StlChunkFacetCount - 1) / StlChunkFacetCount;
+    auto fnPartition = [](uint64_t hash) { return int(hash >> (64 - StlPartitionBits)); };
+    auto fnIsDegenerated = [&](int iFacet) {
+        const StlVertex& v1 = vecVertex[iFacet * 3];
+        const StlVertex& v2 = vecVertex[iFacet * 3 + 1];
+        const StlVertex& v3 = vecVertex[iFacet * 3 + 2];
+        return stlVertexEqual(v1, v2) || stlVertexEqual(v2, v3) || stlVertexEqual(v1, v3);
+    };
+
+    // Dispatch vertices to partitions. Each chunk has its own bins to avoid locking
+    std::vector<std::vector<uint32_t>> vecBin(size_t(chunkCount) * StlPartitionCount);
+    std::vector<int> vecChunkFacetCount(chunkCount, 0);
+    TaskChunkProgress binProgress(progress, chunkCount, 60, 70);
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        std::vector<uint32_t>* bins = &vecBin.at(size_t(iChunk) * StlPartitionCount);
+        const int iFacetBegin = iChunk * StlChunkFacetCount;
+        const int iFacetEnd = std::min(iFacetBegin + StlChunkFacetCount, facetCount);
+        for (int iFacet = iFacetBegin; iFacet < iFacetEnd; ++iFacet) {
+            if (fnIsDegenerated(iFacet))
+                continue;
+
+            ++vecChunkFacetCount.at(iChunk);
+            for (int i = iFacet * 3; i < iFacet * 3 + 3; ++i)
+                bins[fnPartition(stlVertexHash(vecVertex[i]))].push_back(uint32_t(i));
+        }
+
+        binProgress.chunkDone();
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    // Merge vertices of each partition, vecNodeId receives the node index(local to partition)
+    constexpr uint32_t EmptySlot = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> vecNodeId(vertexCount, 0);
+    std::vector<std::vector<uint32_t>> vecPartitionNode(StlPartitionCount);
+    TaskChunkProgress mergeProgress(progress, StlPartitionCount, 70, 90);
+    CppUtils::parallelFor(StlPartitionCount, [&](int iPartition) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        size_t partitionVertexCount = 0;
+        for (int iChunk = 0; iChunk < chunkCount; ++iChunk)
+            partitionVertexCount += vecBin.at(size_t(iChunk) * StlPartitionCount + iPartition).size();
+
+        // Open addressing, load factor is kept below 2/3 even if no vertex is shared
+        size_t tableSize = 16;
+        while (tableSize < partitionVertexCount + partitionVertexCount / 2)
+            tableSize *= 2;
+
+        const uint64_t tableMask = tableSize - 1;
+        std::vector<uint32_t> vecSlot(tableSize, EmptySlot);
+        std::vector<uint32_t>& vecNode = vecPartitionNode.at(iPartition);
+        for (int iChunk = 0; iChunk < chunkCount; ++iChunk) {
+            for (uint32_t iVertex : vecBin.at(size_t(iChunk) * StlPartitionCount + iPartition)) {
+                const StlVertex& vertex = vecVertex[iVertex];
+                uint64_t iSlot = stlVertexHash(vertex) & tableMask;
+                while (vecSlot[iSlot] != EmptySlot && !stlVertexEqual(vecVertex[vecNode[vecSlot[iSlot]]], vertex))
+                    iSlot = (iSlot + 1) & tableMask;
+
+                if (vecSlot[iSlot] == EmptySlot) {
+                    vecSlot[iSlot] = uint32_t(vecNode.size());
+                    vecNode.push_back(iVertex);
+                }
+
+                vecNodeId[iVertex] = vecSlot[iSlot];
+            }
+        }
+
+        mergeProgress.chunkDone();
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+    std::vector<int> vecPartitionOffset(StlPartitionCount + 1, 0);
+    for (int i = 0; i < StlPartitionCount; ++i)
+        vecPartitionOffset.at(i + 1) = vecPartitionOffset.at(i) + int(vecPartitionNode.at(i).size());
+
+    std::vector<int> vecChunkFacetOffset(chunkCount + 1, 0);
+    for (int i = 0; i < chunkCount; ++i)
+        vecChunkFacetOffset.at(i + 1) = vecChunkFacetOffset.at(i) + vecChunkFacetCount.at(i);
+
+    const int nodeCount = vecPartitionOffset.back();
+    const int triangleCount = vecChunkFacetOffset.back();
+    if (nodeCount == 0 || triangleCount == 0)
+        return {};
+
+    Handle_Poly_Triangulation mesh = new Poly_Triangulation(nodeCount, triangleCount, false);
+    TColgp_Array1OfPnt& vecMeshNode = mesh->ChangeNodes();
+    Poly_Array1OfTriangle& vecMeshTriangle = mesh->ChangeTriangles();
+
+    // Write nodes and make node indices global
+    CppUtils::parallelFor(StlPartitionCount, [&](int iPartition) {
+        const int offset = vecPartitionOffset.at(iPartition);
+        const std::vector<uint32_t>& vecNode = vecPartitionNode.at(iPartition);
+        for (size_t i = 0; i < vecNode.size(); ++i) {
+            const StlVertex& vertex = vecVertex[vecNode[i]];
+            vecMeshNode.ChangeValue(offset + int(i) + 1).SetCoord(vertex.coords[0], vertex.coords[1], vertex.coords[2]);
+        }
+
+        for (int iChunk = 0; iChunk < chunkCount; ++iChunk) {
+            for (uint32_t iVertex : vecBin.at(size_t(iChunk) * StlPartitionCount + iPartition))
+                vecNodeId[iVertex] += offset;
+        }
+    });
+
+    // Write triangles(indices are 1-based)
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        int iTriangle = vecChunkFacetOffset.at(iChunk) + 1;
+        const int iFacetBegin = iChunk * StlChunkFacetCount;
+        const int iFacetEnd = std::min(iFacetBegin + StlChunkFacetCount, facetCount);
+        for (int iFacet = iFacetBegin; iFacet < iFacetEnd; ++iFacet) {
+            if (fnIsDegenerated(iFacet))
+                continue;
+
+            const uint32_t* nodeId = &vecNodeId[iFacet * 3];
+            vecMeshTriangle.ChangeValue(iTriangle++).Set(int(nodeId[0]) + 1, int(nodeId[1]) + 1, int(nodeId[2]) + 1);
+        }
+    });
+
+    if (progress)
+        progress->setValue(100);
+
+    return mesh;
+}
+
+// Creates mesh where each facet has its own three nodes("triangle soup"), nodes are given the
+// normal of their facet. Degenerated facets are discarded
+Handle_Poly_Triangulation stlCreateSoupMesh(const std::vector<StlVertex>& vecVertex, TaskProgress* progress)
+{
+    const int facetCount = int(vecVertex.size()) / 3;
+    const int chunkCount = (facetCount + StlChunkFacetCount - 1) / StlChunkFacetCount;
+    auto fnFacetNormal = [&](int iFacet, float* normal) {
+        const float* v1 = vecVertex[iFacet * 3].coords;
+        const float* v2 = vecVertex[iFacet * 3 + 1].coords;
+        const float* v3 = vecVertex[iFacet * 3 + 2].coords;
+        const float u[] = { v2[0] - v1[0], v2[1] - v1[1], v2[2] - v1[2] };
+        const float v[] = { v3[0] - v1[0], v3[1] - v1[1], v3[2] - v1[2] };
+        normal[0] = u[1] * v[2] - u[2] * v[1];
+        normal[1] = u[2] * v[0] - u[0] * v[2];
+        normal[2] = u[0] * v[1] - u[1] * v[0];
+        const float len = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        for (int i = 0; i < 3 && len > 0.f; ++i)
+            normal[i] /= len;
+
+        return len > 0.f;
+    };
+
+    std::vector<int> vecChunkFacetOffset(chunkCount + 1, 0);
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        const int iFacetBegin = iChunk * StlChunkFacetCount;
+        const int iFacetEnd = std::min(iFacetBegin + StlChunkFacetCount, facetCount);
+        float normal[3];
+        for (int iFacet = iFacetBegin; iFacet < iFacetEnd; ++iFacet)
+            vecChunkFacetOffset.at(iChunk + 1) += fnFacetNormal(iFacet, normal) ? 1 : 0;
+    });
+
+    for (int i = 0; i < chunkCount; ++i)
+        vecChunkFacetOffset.at(i + 1) += vecChunkFacetOffset.at(i);
+
+    const int triangleCount = vecChunkFacetOffset.back();
+    if (triangleCount == 0 || TaskProgress::isAbortRequested(progress))
+        return {};
+
+    const int nodeCount = triangleCount * 3;
+    Handle_Poly_Triangulation mesh = new Poly_Triangulation(nodeCount, triangleCount, false);
+    TColgp_Array1OfPnt& vecMeshNode = mesh->ChangeNodes();
+    Poly_Array1OfTriangle& vecMeshTriangle = mesh->ChangeTriangles();
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    mesh->AddNormals();
+#else
+    Handle_TShort_HArray1OfShortReal vecMeshNormal = new TShort_HArray1OfShortReal(1, 3 * nodeCount);
+#endif
+
+    TaskChunkProgress chunkProgress(progress, chunkCount, 60, 100);
+    CppUtils::parallelFor(chunkCount, [&](int iChunk) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        int iTriangle = vecChunkFacetOffset.at(iChunk) + 1;
+        const int iFacetBegin = iChunk * StlChunkFacetCount;
+        const int iFacetEnd = std::min(iFacetBegin + StlChunkFacetCount, facetCount);
+        for (int iFacet = iFacetBegin; iFacet < iFacetEnd; ++iFacet) {
+            float normal[3];
+            if (!fnFacetNormal(iFacet, normal))
+                continue;
+
+            const int iNodeFirst = (iTriangle - 1) * 3 + 1;
+            for (int i = 0; i < 3; ++i) {
+                const int iNode = iNodeFirst + i;
+                const StlVertex& vertex = vecVertex[iFacet * 3 + i];
+                vecMeshNode.ChangeValue(iNode).SetCoord(vertex.coords[0], vertex.coords[1], vertex.coords[2]);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+                mesh->SetNormal(iNode, gp_Vec3f(normal[0], normal[1], normal[2]));
+#else
+                for (int j = 0; j < 3; ++j)
+                    vecMeshNormal->SetValue((iNode - 1) * 3 + j + 1, normal[j]);
+#endif
+            }
+
+            vecMeshTriangle.ChangeValue(iTriangle++).Set(iNodeFirst, iNodeFirst + 1, iNodeFirst + 2);
+        }
+
+        chunkProgress.chunkDone();
+    });
+
+    if (TaskProgress::isAbortRequested(progress))
+        return {};
+
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+    mesh->SetNormals(vecMeshNormal);
+#endif
+    return mesh;
+}
+
+// Reads STL file(binary or ASCII) with contents mapped in memory
+// Returns null mesh if contents couldn't be parsed or reading was aborted
+Handle_Poly_Triangulation stlReadData(
+        const uchar* data, qint64 size, const OccStlReader::Parameters& params, TaskProgress* progress)
+{
+    if (!data)
+        return {};
+
+    std::vector<StlVertex> vecVertex;
+    const bool ok = stlIsBinary(data, size) ?
+                stlParseBinary(data, size, &vecVertex, progress) :
+                stlParseAscii(reinterpret_cast<const char*>(data), size, &vecVertex, progress);
+    if (!ok || vecVertex.empty())
+        return {};
+
+    if (!params.mergeNodes)
+        return stlCreateSoupMesh(vecVertex, progress);
+
+    const Handle_Poly_Triangulation mesh = stlCreateIndexedMesh(vecVertex, progress);
+    if (mesh.IsNull() || !params.smoothNormals || TaskProgress::isAbortRequested(progress))
+        return mesh;
+
+    return MeshUtils::smoothNormals(mesh, params.smoothCreaseAngle);
+}
+
+Handle_Poly_Triangulation stlReadFile(
+        const FilePath& filepath, const OccStlReader::Parameters& params, TaskProgress* progress)
+{
+    MappedFile file;
+    if (!file.open(filepath))
+        return {};
+
+    return stlReadData(reinterpret_cast<const uchar*>(file.data()), file.size(), params, progress);
+}
+
+// Triangulation to be written
+using StlWriterMesh = BRepUtils::FaceTriangulation;
+
+// Excerpt of the facets to be written
+struct StlWriterChunk {
+    int iMeshBegin = 0;
+    int iTriangleBegin = 0; // Index of the first triangle within mesh 'iMeshBegin'
+    int triangleCount = 0;
+};
+
+// Appends the facets of chunk to buffer, as binary or ASCII records
+void stlWriteChunk(
+        Span<const StlWriterMesh> spanMesh,
+        const StlWriterChunk& chunk,
+        OccStlWriter::Format format,
+        std::vector<char>* ptrBuffer)
+{
+    std::vector<char>& buffer = *ptrBuffer;
+    buffer.clear();
+    if (format == OccStlWriter::Format::Binary)
+        buffer.reserve(size_t(chunk.triangleCount) * StlBinaryFacetSize);
+    else
+        buffer.reserve(size_t(chunk.triangleCount) * 256);
+
+    auto fnAppendFloat = [&](double value) {
+        const float fvalue = float(value);
+        quint32 bits;
+        std::memcpy(&bits, &fvalue, sizeof(bits));
+        bits = qToLittleEndian(bits);
+        const char* bytes = reinterpret_cast<const char*>(&bits);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(bits));
+    };
+    auto fnAppendText = [&](std::string_view str) {
+        buffer.insert(buffer.end(), str.cbegin(), str.cend());
+    };
+    // Same output as "%12e" format of printf(), but independent of the C locale
+    auto fnAppendCoords = [&](double x, double y, double z) {
+        for (double value : { x, y, z }) {
+            char str[64];
+            const int len = StringUtils::formatNumber(str, int(sizeof(str)), value, std::chars_format::scientific, 6);
+            buffer.insert(buffer.end(), size_t(1 + std::max(12 - len, 0)), ' ');
+            buffer.insert(buffer.end(), str, str + len);
+        }
+
+        buffer.push_back('\n');
+    };
+
+    int iMesh = chunk.iMeshBegin;
+    int iTriangle = chunk.iTriangleBegin;
+    for (int i = 0; i < chunk.triangleCount; ++i) {
+        while (iTriangle >= spanMesh[iMesh].triangulation->NbTriangles()) {
+            ++iMesh;
+            iTriangle = 0;
+        }
+
+        const StlWriterMesh& mesh = spanMesh[iMesh];
+        int n1, n2, n3;
+        mesh.triangulation->Triangles().Value(iTriangle + 1).Get(n1, n2, n3);
+        if (mesh.isReversed)
+            std::swap(n2, n3);
+
+        const gp_Pnt pnts[] = {
+            mesh.triangulation->Node(n1).Transformed(mesh.trsf),
+            mesh.triangulation->Node(n2).Transformed(mesh.trsf),
+            mesh.triangulation->Node(n3).Transformed(mesh.trsf)
+        };
+        gp_XYZ normal = (pnts[1].XYZ() - pnts[0].XYZ()).Crossed(pnts[2].XYZ() - pnts[0].XYZ());
+        const double normalLength = normal.Modulus();
+        normal = normalLength > gp::Resolution() ? normal / normalLength : gp_XYZ(0, 0, 0);
+        if (format == OccStlWriter::Format::Binary) {
+            fnAppendFloat(normal.X());
+            fnAppendFloat(normal.Y());
+            fnAppendFloat(normal.Z());
+            for (const gp_Pnt& pnt : pnts) {
+                fnAppendFloat(pnt.X());
+                fnAppendFloat(pnt.Y());
+                fnAppendFloat(pnt.Z());
+            }
+
+            buffer.push_back(0); // Attribute byte count(uint16)
+            buffer.push_back(0);
+        }
+        else {
+            fnAppendText(" facet normal");
+            fnAppendCoords(normal.X(), normal.Y(), normal.Z());
+            fnAppendText("   outer loop\n");
+            for (const gp_Pnt& pnt : pnts) {
+                fnAppendText("     vertex");
+                fnAppendCoords(pnt.X(), pnt.Y(), pnt.Z());
+            }
+
+            fnAppendText("   endloop\n endfacet\n");
+        }
+
+        ++iTriangle;
+    }
 }
 
 } // namespace
@@ -58,26 +652,78 @@ public:
         : PropertyGroup(parentGroup)
     {
         this->targetFormat.mutableEnumeration().changeTrContext(this->textIdContext());
+        this->decimationRatio.setDescription(
+                    textIdTr("Targeted count of facets relative to the count of the source meshes.\n\n"
+                             "Value below 1 simplifies meshes by collapsing their edges with lowest geometric "
+                             "error, borders are kept so the facets of adjacent faces stay connected"));
+        this->decimationRatio.setConstraintsEnabled(true);
+        this->decimationRatio.setRange(0.01, 1.);
+        this->decimationRatio.setSingleStep(0.05);
     }
 
     void restoreDefaults() override {
-        this->targetFormat.setValue(Format::Binary);
+        const OccStlWriter::Parameters params;
+        this->targetFormat.setValue(params.format);
+        this->decimationRatio.setValue(params.decimationRatio);
     }
 
     PropertyEnum<OccStlWriter::Format> targetFormat{ this, textId("targetFormat") };
+    PropertyDouble decimationRatio{ this, textId("decimationRatio") };
+};
+
+class OccStlReader::Properties : public PropertyGroup {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::OccStlReader::Properties)
+public:
+    Properties(PropertyGroup* parentGroup)
+        : PropertyGroup(parentGroup)
+    {
+        this->mergeNodes.setDescription(
+                    textIdTr("Merge coincident vertices of facets into single mesh nodes.\n\n"
+                             "When disabled, each facet gets its own three nodes along with a flat normal "
+                             "(\"triangle soup\"). It's faster to import and requires much less memory, "
+                             "suitable for pure visualization"));
+        this->smoothNormals.setDescription(
+                    textIdTr("Compute normals at mesh nodes so curved surfaces are smoothly shaded.\n\n"
+                             "Normals are kept sharp across the edges where adjacent facets make an angle "
+                             "greater than the crease angle. Requires merging of coincident vertices"));
+        this->smoothCreaseAngle.setDescription(
+                    textIdTr("Maximum angle between adjacent facets smoothed out by normals at nodes"));
+    }
+
+    void restoreDefaults() override {
+        const OccStlReader::Parameters params;
+        this->mergeNodes.setValue(params.mergeNodes);
+        this->smoothNormals.setValue(params.smoothNormals);
+        this->smoothCreaseAngle.setQuantity(params.smoothCreaseAngle * Quantity_Radian);
+    }
+
+    PropertyBool mergeNodes{ this, textId("mergeNodes") };
+    PropertyBool smoothNormals{ this, textId("smoothNormals") };
+    PropertyAngle smoothCreaseAngle{ this, textId("smoothCreaseAngle") };
 };
 
 bool OccStlReader::readFile(const FilePath& filepath, TaskProgress* progress)
 {
-    Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
     m_baseFilename = filepath.stem();
-    m_mesh = RWStl::ReadFile(filepath.u8string().c_str(), TKernelUtils::start(indicator));
+    m_mesh = stlReadFile(filepath, m_params, progress);
     return !m_mesh.IsNull();
 }
 
-TDF_LabelSequence OccStlReader::transfer(DocumentPtr doc, TaskProgress* /*progress*/)
+bool OccStlReader::readStream(std::istream& istr, const FilePath& name, TaskProgress* progress)
 {
-    if (m_mesh.IsNull())
+    // Parsers need random access to the facets, data is gathered in memory(no temporary file)
+    m_baseFilename = name.stem();
+    std::string data;
+    if (!StreamUtils::readAll(istr, &data))
+        return false;
+
+    m_mesh = stlReadData(reinterpret_cast<const uchar*>(data.data()), qint64(data.size()), m_params, progress);
+    return !m_mesh.IsNull();
+}
+
+TDF_LabelSequence OccStlReader::transfer(DocumentPtr doc, TaskProgress* progress)
+{
+    if (m_mesh.IsNull() || TaskProgress::isAbortRequested(progress))
         return {};
 
     const TDF_Label entityLabel = doc->newEntityLabel();
@@ -86,68 +732,168 @@ TDF_LabelSequence OccStlReader::transfer(DocumentPtr doc, TaskProgress* /*progre
     return CafUtils::makeLabelSequence({ entityLabel });
 }
 
-bool OccStlWriter::transfer(Span<const ApplicationItem> appItems, TaskProgress* /*progress*/)
+std::unique_ptr<PropertyGroup> OccStlReader::createProperties(PropertyGroup* parentGroup)
 {
-//    if (appItems.size() > 1)
-//        return Result::error(tr("OpenCascade RWStl does not support multi-solids"));
+    return std::make_unique<Properties>(parentGroup);
+}
+
+void OccStlReader::applyProperties(const PropertyGroup* params)
+{
+    auto ptr = dynamic_cast<const Properties*>(params);
+    if (ptr) {
+        m_params.mergeNodes = ptr->mergeNodes;
+        m_params.smoothNormals = ptr->smoothNormals;
+        m_params.smoothCreaseAngle = UnitSystem::radians(ptr->smoothCreaseAngle.quantity());
+    }
+}
+
+bool OccStlWriter::transfer(Span<const ApplicationItem> appItems, TaskProgress* progress)
+{
+    m_vecShape.clear();
+    m_vecMesh.clear();
+    for (const ApplicationItem& item : appItems) {
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
 
-    m_shape = {};
-    m_mesh = {};
-    if (!appItems.empty()) {
-        const ApplicationItem& item = appItems.front();
         if (item.isDocument()) {
-            m_shape = asShape(item.document());
+            for (const TDF_Label& label : item.document()->xcaf().topLevelFreeShapes())
+                m_vecShape.push_back(XCaf::shape(label));
         }
         else if (item.isDocumentTreeNode()) {
             const TDF_Label label = item.documentTreeNode().label();
             if (XCaf::isShape(label)) {
-                m_shape = XCaf::shape(label);
+                m_vecShape.push_back(XCaf::shape(label));
             }
             else {
                 auto attrPolyTri = CafUtils::findAttribute<TDataXtd_Triangulation>(label);
-                if (!attrPolyTri.IsNull())
-                    m_mesh = attrPolyTri->Get();
+                if (!attrPolyTri.IsNull() && !attrPolyTri->Get().IsNull())
+                    m_vecMesh.push_back(attrPolyTri->Get());
             }
         }
     }
 
-    return !m_shape.IsNull() || !m_mesh.IsNull();
+    return !m_vecShape.empty() || !m_vecMesh.empty();
 }
 
 bool OccStlWriter::writeFile(const FilePath& filepath, TaskProgress* progress)
 {
-    if (!m_shape.IsNull()) {
-        bool facesMeshed = true;
-        BRepUtils::forEachSubFace(m_shape, [&](const TopoDS_Face& face) {
-            TopLoc_Location loc;
-            Handle_Poly_Triangulation mesh = BRep_Tool::Triangulation(face, loc);
-            if (mesh.IsNull())
-                facesMeshed = false;
+    AsyncFileOutputStream outs(filepath);
+    if (!outs.isOpen())
+        return false;
+
+    const bool okWrite = this->write(outs, filepath.stem().u8string(), progress);
+    return outs.close() && okWrite;
+}
+
+bool OccStlWriter::writeStream(std::ostream& ostr, TaskProgress* progress)
+{
+    const bool okWrite = this->write(ostr, "", progress);
+    ostr.flush();
+    return okWrite && ostr.good();
+}
+
+bool OccStlWriter::write(std::ostream& outs, const std::string& solidName, TaskProgress* progress)
+{
+    // Gather triangulations to be written, faces not meshed are skipped
+    std::vector<StlWriterMesh> vecMesh;
+    for (const TopoDS_Shape& shape : m_vecShape) {
+        BRepUtils::forEachFaceTriangulation(shape, [&](const StlWriterMesh& mesh) {
+            vecMesh.push_back(mesh);
         });
-        if (!facesMeshed) {
-#if OCC_VERSION_HEX <= OCC_VERSION_CHECK(7, 3, 0)
-            //qCritical() << "Not all BRep faces are meshed";
-            return false; // Continuing would crash
-#else
-            //qWarning() << "Not all BRep faces are meshed";
-#endif
+    }
+
+    for (const Handle_Poly_Triangulation& triangulation : m_vecMesh) {
+        if (triangulation->NbTriangles() > 0)
+            vecMesh.push_back({ triangulation, gp_Trsf(), false });
+    }
+
+    // Decimate copies of the meshes, they are still owned by the application items
+    if (m_params.decimationRatio < 1.) {
+        std::vector<Handle_Poly_Triangulation> vecTriangulation;
+        for (const StlWriterMesh& mesh : vecMesh)
+            vecTriangulation.push_back(mesh.triangulation);
+
+        MeshDecimation::Parameters decimationParams;
+        decimationParams.targetRatio = m_params.decimationRatio;
+        TaskProgress decimationProgress(progress, 40);
+        const std::vector<Handle_Poly_Triangulation> vecDecimated =
+                MeshDecimation::decimated(vecTriangulation, decimationParams, &decimationProgress);
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+
+        for (int i = 0; i < int(vecMesh.size()); ++i)
+            vecMesh.at(i).triangulation = vecDecimated.at(i);
+    }
+
+    TaskProgress writeProgress(progress, m_params.decimationRatio < 1. ? 60 : 100);
+
+    // Split facets in chunks of fixed size, so they can be serialized concurrently
+    int64_t facetCount = 0;
+    for (const StlWriterMesh& mesh : vecMesh)
+        facetCount += mesh.triangulation->NbTriangles();
+
+    if (m_params.format == Format::Binary && facetCount > std::numeric_limits<quint32>::max())
+        return false;
+
+    std::vector<StlWriterChunk> vecChunk;
+    StlWriterChunk chunk;
+    for (int iMesh = 0; iMesh < int(vecMesh.size()); ++iMesh) {
+        const int meshTriangleCount = vecMesh.at(iMesh).triangulation->NbTriangles();
+        int iTriangle = 0;
+        while (iTriangle < meshTriangleCount) {
+            if (chunk.triangleCount == 0) {
+                chunk.iMeshBegin = iMesh;
+                chunk.iTriangleBegin = iTriangle;
+            }
+
+            const int count = std::min(meshTriangleCount - iTriangle, StlChunkFacetCount - chunk.triangleCount);
+            chunk.triangleCount += count;
+            iTriangle += count;
+            if (chunk.triangleCount == StlChunkFacetCount) {
+                vecChunk.push_back(chunk);
+                chunk = {};
+            }
         }
+    }
+
+    if (chunk.triangleCount > 0)
+        vecChunk.push_back(chunk);
 
-        StlAPI_Writer writer;
-        writer.ASCIIMode() = m_params.format == Format::Ascii;
-        return writer.Write(m_shape, filepath.u8string().c_str());
+    if (m_params.format == Format::Binary) {
+        char header[StlBinaryHeaderSize] = {};
+        std::snprintf(header, 80, "STL binary file exported by Mayo, solid %s", solidName.c_str());
+        const quint32 facetCountLE = qToLittleEndian(quint32(facetCount));
+        std::memcpy(header + 80, &facetCountLE, sizeof(facetCountLE));
+        outs.write(header, sizeof(header));
     }
-    else if (!m_mesh.IsNull()) {
-        Handle_Message_ProgressIndicator indicator = new OccProgressIndicator(progress);
-        const std::string filepathUtf8 = filepath.u8string();
-        const OSD_Path osdFilepath(filepathUtf8.c_str());
-        if (m_params.format == Format::Ascii)
-            return RWStl::WriteAscii(m_mesh, osdFilepath, TKernelUtils::start(indicator));
-        else
-            return RWStl::WriteBinary(m_mesh, osdFilepath, TKernelUtils::start(indicator));
+    else {
+        outs << "solid " << solidName << "\n";
     }
 
-    return false;
+    // Serialize batches of chunks in parallel, then write them in order with one pass
+    const int threadCount = std::max(int(std::thread::hardware_concurrency()), 1);
+    const int batchSize = 2 * threadCount;
+    const Span<const StlWriterMesh> spanMesh = vecMesh;
+    std::vector<std::vector<char>> vecBuffer(std::min<size_t>(batchSize, vecChunk.size()));
+    const int chunkCount = int(vecChunk.size());
+    for (int iBatch = 0; iBatch < chunkCount && outs; iBatch += batchSize) {
+        if (TaskProgress::isAbortRequested(&writeProgress))
+            return false;
+
+        const int batchChunkCount = std::min(batchSize, chunkCount - iBatch);
+        CppUtils::parallelFor(batchChunkCount, [&](int i) {
+            stlWriteChunk(spanMesh, vecChunk.at(iBatch + i), m_params.format, &vecBuffer.at(i));
+        });
+        for (int i = 0; i < batchChunkCount && outs; ++i)
+            outs.write(vecBuffer.at(i).data(), vecBuffer.at(i).size());
+
+        writeProgress.setValue(((iBatch + batchChunkCount) * 100) / chunkCount);
+    }
+
+    if (m_params.format == Format::Ascii)
+        outs << "endsolid " << solidName << "\n";
+
+    return outs.good();
 }
 
 std::unique_ptr<PropertyGroup> OccStlWriter::createProperties(PropertyGroup* parentGroup)
@@ -158,8 +904,10 @@ std::unique_ptr<PropertyGroup> OccStlWriter::createProperties(PropertyGroup* par
 void OccStlWriter::applyProperties(const PropertyGroup* params)
 {
     auto ptr = dynamic_cast<const Properties*>(params);
-    if (ptr)
+    if (ptr) {
         m_params.format = ptr->targetFormat;
+        m_params.decimationRatio = ptr->decimationRatio;
+    }
 }
 
 } // namespace IO
@@ -8,28 +8,54 @@
 
 #include "../base/io_reader.h"
 #include "../base/io_writer.h"
+#include "../base/quantity.h"
 #include <Poly_Triangulation.hxx>
 #include <TopoDS_Shape.hxx>
+#include <string>
+#include <vector>
 
 namespace Mayo {
 namespace IO {
 
-// Opencascade-based reader for STL file format
+// Reader for STL file format(binary and ASCII), facets are parsed concurrently
 class OccStlReader : public Reader {
 public:
     bool readFile(const FilePath& filepath, TaskProgress* progress) override;
+    bool readStream(std::istream& istr, const FilePath& name, TaskProgress* progress) override;
+    bool readsStream() const override { return true; }
     TDF_LabelSequence transfer(DocumentPtr doc, TaskProgress* progress) override;
 
+    static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
+    void applyProperties(const PropertyGroup* params) override;
+
+    // Parameters
+    struct Parameters {
+        // If false then coincident vertices aren't merged("triangle soup"): each facet gets its
+        // own three nodes along with the facet normal
+        bool mergeNodes = true;
+        // Computes normals at nodes for smooth shading, see MeshUtils::smoothNormals()
+        // Nodes are duplicated along the edges where adjacent facets make an angle greater than
+        // 'smoothCreaseAngle'(radians). Ignored if 'mergeNodes' is false
+        bool smoothNormals = false;
+        double smoothCreaseAngle = 40 * Quantity_Degree.value();
+    };
+    Parameters& parameters() { return m_params; }
+    const Parameters& constParameters() const { return m_params; }
+
 private:
+    class Properties;
+    Parameters m_params;
     Handle_Poly_Triangulation m_mesh;
     FilePath m_baseFilename;
 };
 
-// Opencascade-based writer for STL file format
+// Writer for STL file format, facets are serialized concurrently
+// Multiple shapes and meshes are written in a single solid
 class OccStlWriter : public Writer {
 public:
     bool transfer(Span<const ApplicationItem> appItems, TaskProgress* progress) override;
     bool writeFile(const FilePath& filepath, TaskProgress* progress) override;
+    bool writeStream(std::ostream& ostr, TaskProgress* progress) override;
 
     static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
     void applyProperties(const PropertyGroup* params) override;
@@ -39,15 +65,20 @@ public:
 
     struct Parameters {
         Format format = Format::Binary;
+        // Targeted count of facets relative to the input count, in ]0,1], 1 means no decimation
+        // Meshes are simplified before being written, the application items are left untouched
+        double decimationRatio = 1.;
     };
     Parameters& parameters() { return m_params; }
     const Parameters& constParameters() const { return m_params; }
 
 private:
+    bool write(std::ostream& outs, const std::string& solidName, TaskProgress* progress);
+
     class Properties;
     Parameters m_params;
-    TopoDS_Shape m_shape;
-    Handle_Poly_Triangulation m_mesh;
+    std::vector<TopoDS_Shape> m_vecShape;
+    std::vector<Handle_Poly_Triangulation> m_vecMesh;
 };
 
 } // namespace IO
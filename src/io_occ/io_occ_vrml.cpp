@@ -7,21 +7,339 @@
 #include "io_occ_vrml.h"
 
 #include "../base/application_item.h"
+#include "../base/brep_utils.h"
 #include "../base/caf_utils.h"
 #include "../base/document.h"
 #include "../base/math_utils.h"
 #include "../base/property_builtins.h"
 #include "../base/property_enumeration.h"
+#include "../base/string_utils.h"
 #include "../base/task_progress.h"
 #include "../base/tkernel_utils.h"
 
+#include <BRep_Tool.hxx>
 #include <OSD_OpenFile.hxx>
-#include <VrmlData_ShapeConvert.hxx>
+#include <Poly_Polygon3D.hxx>
+#include <Poly_PolygonOnTriangulation.hxx>
+#include <Standard_Version.hxx>
+#include <TDataXtd_Triangulation.hxx>
+#include <TopExp.hxx>
+#include <TopoDS.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <TShort_Array1OfShortReal.hxx>
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
 
 namespace Mayo {
 namespace IO {
 
+namespace {
+
+// Size of the output file buffer, VRML text is produced by many small pieces
+constexpr size_t VrmlOutputBufferSize = 1024 * 1024;
+
+// Triangulation to be written
+using VrmlFaceMesh = BRepUtils::FaceTriangulation;
+
+// Streams model tree nodes as VRML nodes
+// Products(parts and assemblies) met more than once are written once with DEF, then with USE if
+// their effective style is the same
+class VrmlStreamWriter {
+public:
+    VrmlStreamWriter(std::ostream& outs, OccVrmlWriter::Parameters params, TaskProgress* progress)
+        : m_outs(outs), m_params(params), m_progress(progress)
+    {}
+
+    void setTotalNodeCount(int count) { m_totalNodeCount = count; }
+
+    bool writeRoot(const DocumentTreeNode& node)
+    {
+        const Tree<TDF_Label>& modelTree = node.document()->modelTree();
+        m_doc = node.document();
+        const TreeNodeId parentId = modelTree.nodeParent(node.id());
+        if (parentId != 0) {
+            // Tree node is not an entity, so place it as in the assembly tree
+            this->writeTransformBegin(XCaf::shapeAbsoluteLocation(modelTree, parentId).Transformation());
+            this->writeNode(node.id());
+            this->writeTransformEnd();
+        }
+        else {
+            this->writeNode(node.id());
+        }
+
+        return !m_isAborted;
+    }
+
+private:
+    template<typename... ARGS>
+    void writeFormat(const char* format, ARGS... args)
+    {
+        char str[256];
+        const int len = std::snprintf(str, sizeof(str), format, args...);
+        m_outs.write(str, std::clamp(len, 0, int(sizeof(str)) - 1));
+    }
+
+    void write(const char* str) { m_outs << str; }
+
+    // Numbers separated by a space, not using printf() whose decimal point depends on C locale
+    void writeNumbers(std::initializer_list<double> values, int precision)
+    {
+        m_strNumbers.clear();
+        for (double value : values) {
+            if (!m_strNumbers.empty())
+                m_strNumbers += ' ';
+
+            StringUtils::appendNumber(&m_strNumbers, value, std::chars_format::general, precision);
+        }
+
+        m_outs.write(m_strNumbers.data(), std::streamsize(m_strNumbers.size()));
+    }
+
+    void writeNode(TreeNodeId nodeId)
+    {
+        if (m_isAborted)
+            return;
+
+        if (TaskProgress::isAbortRequested(m_progress)) {
+            m_isAborted = true;
+            return;
+        }
+
+        const Tree<TDF_Label>& modelTree = m_doc->modelTree();
+        const TDF_Label& label = modelTree.nodeData(nodeId);
+        this->advanceProgress(1);
+        if (XCaf::isShapeReference(label)) {
+            this->writeTransformBegin(XCaf::shapeReferenceLocation(label).Transformation());
+            visitDirectChildren(nodeId, modelTree, [=](TreeNodeId childId) { this->writeNode(childId); });
+            this->writeTransformEnd();
+            return;
+        }
+
+        // Product can be reused only if its effective style is the same
+        const uint32_t styleIndex = m_doc->xcaf().shapeStyleIndex(nodeId);
+        auto itDef = m_mapProductDef.find(label);
+        if (itDef != m_mapProductDef.cend() && itDef->second.styleIndex == styleIndex) {
+            this->writeFormat("USE %s\n", itDef->second.name.c_str());
+            int subNodeCount = 0;
+            traverseTree(nodeId, modelTree, [&](TreeNodeId) { ++subNodeCount; });
+            this->advanceProgress(subNodeCount - 1);
+            return;
+        }
+
+        const std::string defName = "Product" + std::to_string(++m_productDefCount);
+        m_mapProductDef.insert_or_assign(label, ProductDef{ defName, styleIndex });
+        this->writeFormat("DEF %s Group {\nchildren [\n", defName.c_str());
+        if (XCaf::isShapeAssembly(label))
+            visitDirectChildren(nodeId, modelTree, [=](TreeNodeId childId) { this->writeNode(childId); });
+        else
+            this->writeProduct(label, m_doc->xcaf().shapeStyleAt(styleIndex));
+
+        this->write("]\n}\n");
+    }
+
+    void writeProduct(const TDF_Label& label, const XCaf::ShapeStyle& style)
+    {
+        std::vector<VrmlFaceMesh> vecMesh;
+        TopoDS_Shape shape;
+        if (XCaf::isShape(label)) {
+            shape = XCaf::shape(label);
+            BRepUtils::forEachFaceTriangulation(shape, [&](const VrmlFaceMesh& mesh) {
+                vecMesh.push_back(mesh);
+            });
+        }
+        else {
+            auto attrPolyTri = CafUtils::findAttribute<TDataXtd_Triangulation>(label);
+            if (!attrPolyTri.IsNull() && !attrPolyTri->Get().IsNull())
+                vecMesh.push_back({ attrPolyTri->Get(), gp_Trsf(), false });
+        }
+
+        const Quantity_Color color =
+                style.hasColor ? style.color : Quantity_Color(0.8, 0.8, 0.8, Quantity_TOC_RGB);
+        const auto rep = m_params.shapeRepresentation;
+        if (rep == VrmlAPI_ShadedRepresentation || rep == VrmlAPI_BothRepresentation)
+            this->writeFaceSet(vecMesh, color);
+
+        if ((rep == VrmlAPI_WireFrameRepresentation || rep == VrmlAPI_BothRepresentation) && !shape.IsNull())
+            this->writeLineSet(shape, color);
+    }
+
+    void writeFaceSet(Span<const VrmlFaceMesh> spanMesh, const Quantity_Color& color)
+    {
+        if (spanMesh.empty())
+            return;
+
+        bool hasNormals = true;
+        for (const VrmlFaceMesh& mesh : spanMesh)
+            hasNormals = hasNormals && mesh.triangulation->HasNormals();
+
+        this->write("Shape {\nappearance Appearance { material Material { diffuseColor ");
+        this->writeNumbers({ color.Red(), color.Green(), color.Blue() }, 6);
+        this->write(" } }\n");
+        this->write("geometry IndexedFaceSet {\nsolid FALSE\ncoord Coordinate { point [\n");
+        for (const VrmlFaceMesh& mesh : spanMesh) {
+            for (int i = 1; i <= mesh.triangulation->NbNodes(); ++i) {
+                const gp_Pnt pnt = mesh.triangulation->Node(i).Transformed(mesh.trsf);
+                this->writeNumbers({ pnt.X(), pnt.Y(), pnt.Z() }, 9);
+                this->write(",\n");
+            }
+        }
+
+        this->write("] }\n");
+        if (hasNormals) {
+            this->write("normal Normal { vector [\n");
+            for (const VrmlFaceMesh& mesh : spanMesh) {
+                for (int i = 1; i <= mesh.triangulation->NbNodes(); ++i) {
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+                    gp_Vec normal = mesh.triangulation->Normal(i);
+#else
+                    const TShort_Array1OfShortReal& vecNormalCoord = mesh.triangulation->Normals();
+                    const int iCoord = 3 * (i - 1) + vecNormalCoord.Lower();
+                    gp_Vec normal(
+                                vecNormalCoord.Value(iCoord),
+                                vecNormalCoord.Value(iCoord + 1),
+                                vecNormalCoord.Value(iCoord + 2));
+#endif
+                    normal.Transform(mesh.trsf);
+                    if (mesh.isReversed)
+                        normal.Reverse();
+
+                    this->writeNumbers({ normal.X(), normal.Y(), normal.Z() }, 6);
+                    this->write(",\n");
+                }
+            }
+
+            this->write("] }\n");
+        }
+
+        this->write("coordIndex [\n");
+        int nodeOffset = 0;
+        for (const VrmlFaceMesh& mesh : spanMesh) {
+            const Poly_Array1OfTriangle& vecTriangle = mesh.triangulation->Triangles();
+            for (int i = vecTriangle.Lower(); i <= vecTriangle.Upper(); ++i) {
+                int n1, n2, n3;
+                vecTriangle.Value(i).Get(n1, n2, n3);
+                if (mesh.isReversed)
+                    std::swap(n2, n3);
+
+                // Poly_Triangulation node indices are 1-based
+                this->writeFormat("%d,%d,%d,-1,\n", nodeOffset + n1 - 1, nodeOffset + n2 - 1, nodeOffset + n3 - 1);
+            }
+
+            nodeOffset += mesh.triangulation->NbNodes();
+        }
+
+        this->write("]\n}\n}\n");
+    }
+
+    void writeLineSet(const TopoDS_Shape& shape, const Quantity_Color& color)
+    {
+        // Polylines of the edges, taken from 3D polygons or else from polygons on triangulation
+        std::vector<std::vector<gp_Pnt>> vecPolyline;
+        TopTools_IndexedMapOfShape mapEdge;
+        TopExp::MapShapes(shape, TopAbs_EDGE, mapEdge);
+        for (int i = 1; i <= mapEdge.Extent(); ++i) {
+            const TopoDS_Edge& edge = TopoDS::Edge(mapEdge.FindKey(i));
+            std::vector<gp_Pnt> polyline;
+            TopLoc_Location loc;
+            const Handle_Poly_Polygon3D& polygon = BRep_Tool::Polygon3D(edge, loc);
+            if (!polygon.IsNull()) {
+                const TColgp_Array1OfPnt& vecNode = polygon->Nodes();
+                for (int j = vecNode.Lower(); j <= vecNode.Upper(); ++j)
+                    polyline.push_back(vecNode.Value(j).Transformed(loc.Transformation()));
+            }
+            else {
+                Handle_Poly_PolygonOnTriangulation polygonOnTri;
+                Handle_Poly_Triangulation triangulation;
+                BRep_Tool::PolygonOnTriangulation(edge, polygonOnTri, triangulation, loc);
+                if (!polygonOnTri.IsNull() && !triangulation.IsNull()) {
+                    const TColStd_Array1OfInteger& vecNodeIndex = polygonOnTri->Nodes();
+                    for (int j = vecNodeIndex.Lower(); j <= vecNodeIndex.Upper(); ++j)
+                        polyline.push_back(triangulation->Node(vecNodeIndex.Value(j)).Transformed(loc.Transformation()));
+                }
+            }
+
+            if (polyline.size() > 1)
+                vecPolyline.push_back(std::move(polyline));
+        }
+
+        if (vecPolyline.empty())
+            return;
+
+        this->write("Shape {\nappearance Appearance { material Material { emissiveColor ");
+        this->writeNumbers({ color.Red(), color.Green(), color.Blue() }, 6);
+        this->write(" } }\n");
+        this->write("geometry IndexedLineSet {\ncoord Coordinate { point [\n");
+        for (const std::vector<gp_Pnt>& polyline : vecPolyline) {
+            for (const gp_Pnt& pnt : polyline) {
+                this->writeNumbers({ pnt.X(), pnt.Y(), pnt.Z() }, 9);
+                this->write(",\n");
+            }
+        }
+
+        this->write("] }\ncoordIndex [\n");
+        int pntOffset = 0;
+        for (const std::vector<gp_Pnt>& polyline : vecPolyline) {
+            for (size_t j = 0; j < polyline.size(); ++j)
+                this->writeFormat("%d,", pntOffset + int(j));
+
+            this->write("-1,\n");
+            pntOffset += int(polyline.size());
+        }
+
+        this->write("]\n}\n}\n");
+    }
+
+    void writeTransformBegin(const gp_Trsf& trsf)
+    {
+        gp_XYZ axis(0, 0, 1);
+        double angle = 0.;
+        if (!trsf.GetRotation(axis, angle)) {
+            axis = gp_XYZ(0, 0, 1);
+            angle = 0.;
+        }
+
+        const gp_XYZ& translation = trsf.TranslationPart();
+        const double scale = trsf.ScaleFactor();
+        this->write("Transform {\ntranslation ");
+        this->writeNumbers({ translation.X(), translation.Y(), translation.Z() }, 9);
+        this->write("\nrotation ");
+        this->writeNumbers({ axis.X(), axis.Y(), axis.Z(), angle }, 9);
+        this->write("\nscale ");
+        this->writeNumbers({ scale, scale, scale }, 9);
+        this->write("\nchildren [\n");
+    }
+
+    void writeTransformEnd() { this->write("]\n}\n"); }
+
+    void advanceProgress(int nodeCount)
+    {
+        m_visitedNodeCount += nodeCount;
+        if (m_progress && m_totalNodeCount > 0)
+            m_progress->setValue(MathUtils::mappedValue(m_visitedNodeCount, 0, m_totalNodeCount, 0, 100));
+    }
+
+    std::ostream& m_outs;
+    OccVrmlWriter::Parameters m_params;
+    TaskProgress* m_progress = nullptr;
+    DocumentPtr m_doc;
+    struct ProductDef {
+        std::string name;
+        uint32_t styleIndex;
+    };
+    std::unordered_map<TDF_Label, ProductDef> m_mapProductDef;
+    int m_productDefCount = 0;
+    int m_totalNodeCount = 0;
+    int m_visitedNodeCount = 0;
+    bool m_isAborted = false;
+    std::string m_strNumbers; // Buffer of writeNumbers()
+};
+
+} // namespace
+
 class OccVrmlWriter::Properties : public PropertyGroup {
     MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::OccVrmlWriter::Properties)
 public:
@@ -44,47 +362,54 @@ public:
 
 bool OccVrmlWriter::transfer(Span<const ApplicationItem> spanAppItem, TaskProgress* progress)
 {
-    m_scene.reset(new VrmlData_Scene);
-    VrmlData_ShapeConvert converter(*m_scene);
+    m_vecRootNode.clear();
     for (const ApplicationItem& appItem : spanAppItem) {
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+
         if (appItem.isDocument()) {
-#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
-            converter.ConvertDocument(appItem.document());
-#else
-            // TODO Call VrmlData_ShapeConvert::AddShape() on each child entity of "shape" type
-#endif
+            const DocumentPtr doc = appItem.document();
+            for (int i = 0; i < doc->entityCount(); ++i)
+                m_vecRootNode.emplace_back(doc, doc->entityTreeNodeId(i));
         }
         else if (appItem.isDocumentTreeNode()) {
-            const TDF_Label label = appItem.documentTreeNode().label();
-            if (XCaf::isShape(label))
-                converter.AddShape(XCaf::shape(label));
+            m_vecRootNode.push_back(appItem.documentTreeNode());
         }
 
         const int index = &appItem - &spanAppItem.front();
         progress->setValue(MathUtils::mappedValue(index, 0, spanAppItem.size() - 1, 0, 100));
     }
 
-    const auto rep = m_shapeRepresentation;
-    converter.Convert(
-                rep == VrmlAPI_ShadedRepresentation || rep == VrmlAPI_BothRepresentation,
-                rep == VrmlAPI_WireFrameRepresentation || rep == VrmlAPI_BothRepresentation);
     return true;
 }
 
-bool OccVrmlWriter::writeFile(const FilePath& filepath, TaskProgress*)
+bool OccVrmlWriter::writeFile(const FilePath& filepath, TaskProgress* progress)
 {
-    if (!m_scene)
+    if (TaskProgress::isAbortRequested(progress))
         return false;
 
+    // Buffer has to be installed before the file is opened
+    std::vector<char> outsBuffer(VrmlOutputBufferSize);
     std::ofstream outs;
-    OSD_OpenStream(outs, filepath.u8string().c_str(), std::ios::out);
-    if (outs) {
-        outs << *m_scene;
-        outs.close();
-        return outs.good();
+    outs.rdbuf()->pubsetbuf(outsBuffer.data(), outsBuffer.size());
+    OSD_OpenStream(outs, filepath.u8string().c_str(), std::ios::out | std::ios::binary);
+    if (!outs)
+        return false;
+
+    int totalNodeCount = 0;
+    for (const DocumentTreeNode& node : m_vecRootNode)
+        traverseTree(node.id(), node.document()->modelTree(), [&](TreeNodeId) { ++totalNodeCount; });
+
+    VrmlStreamWriter writer(outs, m_params, progress);
+    writer.setTotalNodeCount(totalNodeCount);
+    outs << "#VRML V2.0 utf8\n";
+    for (const DocumentTreeNode& node : m_vecRootNode) {
+        if (!writer.writeRoot(node))
+            return false;
     }
 
-    return false;
+    outs.close();
+    return outs.good();
 }
 
 std::unique_ptr<PropertyGroup> OccVrmlWriter::createProperties(PropertyGroup* parentGroup)
@@ -6,15 +6,18 @@
 
 #pragma once
 
+#include "../base/document_tree_node.h"
 #include "../base/io_writer.h"
 #include <VrmlAPI_RepresentationOfShape.hxx>
-#include <VrmlData_Scene.hxx>
 #include <memory>
+#include <vector>
 
 namespace Mayo {
 namespace IO {
 
-// Opencascade-based writer for VRML(v2.0 UTF8) file format
+// Writer for VRML(v2.0 UTF8) file format
+// Model tree is streamed to the output file: IndexedFaceSet nodes are written straight from face
+// triangulations and products instanced more than once are written once(DEF) then referenced(USE)
 class OccVrmlWriter : public Writer {
 public:
     bool transfer(Span<const ApplicationItem> appItems, TaskProgress* progress) override;
@@ -34,8 +37,7 @@ public:
 private:
     class Properties;
     Parameters m_params;
-    std::unique_ptr<VrmlData_Scene> m_scene;
-    VrmlAPI_RepresentationOfShape m_shapeRepresentation = VrmlAPI_BothRepresentation;
+    std::vector<DocumentTreeNode> m_vecRootNode;
 };
 
 } // namespace IO
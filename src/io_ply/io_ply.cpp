@@ -0,0 +1,58 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_ply.h"
+
+#include "io_ply_reader.h"
+#include "io_ply_writer.h"
+
+namespace Mayo {
+namespace IO {
+
+Span<const Format> PlyFactoryReader::formats() const
+{
+    static const Format array[] = { Format_PLY };
+    return array;
+}
+
+std::unique_ptr<Reader> PlyFactoryReader::create(const Format& format) const
+{
+    if (format == Format_PLY)
+        return std::make_unique<PlyReader>();
+
+    return {};
+}
+
+std::unique_ptr<PropertyGroup> PlyFactoryReader::createProperties(const Format&, PropertyGroup*) const
+{
+    return {};
+}
+
+Span<const Format> PlyFactoryWriter::formats() const
+{
+    static const Format array[] = { Format_PLY };
+    return array;
+}
+
+std::unique_ptr<Writer> PlyFactoryWriter::create(const Format& format) const
+{
+    if (format == Format_PLY)
+        return std::make_unique<PlyWriter>();
+
+    return {};
+}
+
+std::unique_ptr<PropertyGroup>
+PlyFactoryWriter::createProperties(const Format& format, PropertyGroup* parentGroup) const
+{
+    if (format == Format_PLY)
+        return PlyWriter::createProperties(parentGroup);
+
+    return {};
+}
+
+} // namespace IO
+} // namespace Mayo
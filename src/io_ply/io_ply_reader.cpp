@@ -0,0 +1,1008 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_ply_reader.h"
+
+#include "../base/caf_utils.h"
+#include "../base/cpp_utils.h"
+#include "../base/document.h"
+#include "../base/mapped_file.h"
+#include "../base/mesh_node_colors.h"
+#include "../base/stream_utils.h"
+#include "../base/task_progress.h"
+#include "../base/tkernel_utils.h"
+
+#include <QtCore/QtEndian>
+#include <TDataXtd_Triangulation.hxx>
+#include <TShort_HArray1OfShortReal.hxx>
+#include <fast_float/fast_float.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+// Count of records(vertices, faces) in a chunk of work
+constexpr int PlyChunkItemCount = 64 * 1024;
+
+enum class PlyFormat { Ascii, BinaryLittleEndian, BinaryBigEndian };
+
+enum class PlyType { Unknown, Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+PlyType plyType(std::string_view name)
+{
+    if (name == "char" || name == "int8")
+        return PlyType::Int8;
+    else if (name == "uchar" || name == "uint8")
+        return PlyType::UInt8;
+    else if (name == "short" || name == "int16")
+        return PlyType::Int16;
+    else if (name == "ushort" || name == "uint16")
+        return PlyType::UInt16;
+    else if (name == "int" || name == "int32")
+        return PlyType::Int32;
+    else if (name == "uint" || name == "uint32")
+        return PlyType::UInt32;
+    else if (name == "float" || name == "float32")
+        return PlyType::Float32;
+    else if (name == "double" || name == "float64")
+        return PlyType::Float64;
+
+    return PlyType::Unknown;
+}
+
+int plyTypeSize(PlyType type)
+{
+    switch (type) {
+    case PlyType::Int8:
+    case PlyType::UInt8: return 1;
+    case PlyType::Int16:
+    case PlyType::UInt16: return 2;
+    case PlyType::Int32:
+    case PlyType::UInt32:
+    case PlyType::Float32: return 4;
+    case PlyType::Float64: return 8;
+    case PlyType::Unknown: break;
+    }
+
+    return 0;
+}
+
+bool plyIsFloatType(PlyType type)
+{
+    return type == PlyType::Float32 || type == PlyType::Float64;
+}
+
+template<typename T> T plyLoad(const uchar* ptr, bool isBigEndian)
+{
+    return isBigEndian ? qFromBigEndian<T>(ptr) : qFromLittleEndian<T>(ptr);
+}
+
+// Reads binary value of 'type' at 'ptr', byte-swapped if the byte order isn't the host one
+double plyReadBinaryValue(const uchar* ptr, PlyType type, bool isBigEndian)
+{
+    switch (type) {
+    case PlyType::Int8: return static_cast<qint8>(*ptr);
+    case PlyType::UInt8: return *ptr;
+    case PlyType::Int16: return plyLoad<qint16>(ptr, isBigEndian);
+    case PlyType::UInt16: return plyLoad<quint16>(ptr, isBigEndian);
+    case PlyType::Int32: return plyLoad<qint32>(ptr, isBigEndian);
+    case PlyType::UInt32: return plyLoad<quint32>(ptr, isBigEndian);
+    case PlyType::Float32: {
+        const quint32 bits = plyLoad<quint32>(ptr, isBigEndian);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    case PlyType::Float64: {
+        const quint64 bits = plyLoad<quint64>(ptr, isBigEndian);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    case PlyType::Unknown: break;
+    }
+
+    return 0.;
+}
+
+struct PlyProperty {
+    std::string name;
+    PlyType type = PlyType::Unknown; // Type of the values
+    PlyType listCountType = PlyType::Unknown; // Type of the value count, Unknown if not a list
+    bool isList() const { return this->listCountType != PlyType::Unknown; }
+};
+
+struct PlyElement {
+    std::string name;
+    int64_t count = 0;
+    std::vector<PlyProperty> vecProperty;
+
+    // Returns the index of the property called 'name', -1 if not found
+    int findProperty(std::string_view name, bool isList) const {
+        for (int i = 0; i < int(this->vecProperty.size()); ++i) {
+            const PlyProperty& prop = this->vecProperty.at(i);
+            if (prop.name == name && prop.isList() == isList)
+                return i;
+        }
+
+        return -1;
+    }
+
+    // Size in bytes of the binary records, -1 if variable(ie some properties are lists)
+    int recordSize() const {
+        int size = 0;
+        for (const PlyProperty& prop : this->vecProperty) {
+            if (prop.isList())
+                return -1;
+
+            size += plyTypeSize(prop.type);
+        }
+
+        return size;
+    }
+};
+
+struct PlyHeader {
+    PlyFormat format = PlyFormat::Ascii;
+    std::vector<PlyElement> vecElement;
+    size_t dataOffset = 0; // Position of the first byte following "end_header" line
+
+    int findElement(std::string_view name) const {
+        for (int i = 0; i < int(this->vecElement.size()); ++i) {
+            if (this->vecElement.at(i).name == name)
+                return i;
+        }
+
+        return -1;
+    }
+};
+
+bool plyIsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+std::vector<std::string_view> plySplitWords(std::string_view line)
+{
+    std::vector<std::string_view> vecWord;
+    size_t pos = 0;
+    while (pos < line.size()) {
+        while (pos < line.size() && plyIsSpace(line[pos]))
+            ++pos;
+
+        const size_t posWordBegin = pos;
+        while (pos < line.size() && !plyIsSpace(line[pos]))
+            ++pos;
+
+        if (pos > posWordBegin)
+            vecWord.push_back(line.substr(posWordBegin, pos - posWordBegin));
+    }
+
+    return vecWord;
+}
+
+// Parses the header lines, from "ply" magic to "end_header". Lines "comment" and "obj_info" are
+// ignored
+bool plyParseHeader(const char* data, size_t size, PlyHeader* header)
+{
+    size_t pos = 0;
+    bool isFirstLine = true;
+    bool hasFormat = false;
+    while (pos < size) {
+        const char* itLineEnd = static_cast<const char*>(std::memchr(data + pos, '\n', size - pos));
+        if (!itLineEnd)
+            return false; // Header not terminated
+
+        const std::string_view line(data + pos, itLineEnd - (data + pos));
+        pos = size_t(itLineEnd - data) + 1;
+        const std::vector<std::string_view> vecWord = plySplitWords(line);
+        if (isFirstLine) {
+            if (vecWord.size() != 1 || vecWord.front() != "ply")
+                return false;
+
+            isFirstLine = false;
+            continue;
+        }
+
+        if (vecWord.empty())
+            continue;
+
+        const std::string_view keyword = vecWord.front();
+        if (keyword == "format") {
+            if (vecWord.size() < 2)
+                return false;
+
+            if (vecWord.at(1) == "ascii")
+                header->format = PlyFormat::Ascii;
+            else if (vecWord.at(1) == "binary_little_endian")
+                header->format = PlyFormat::BinaryLittleEndian;
+            else if (vecWord.at(1) == "binary_big_endian")
+                header->format = PlyFormat::BinaryBigEndian;
+            else
+                return false;
+
+            hasFormat = true;
+        }
+        else if (keyword == "element") {
+            if (vecWord.size() < 3)
+                return false;
+
+            PlyElement element;
+            element.name = std::string(vecWord.at(1));
+            const std::string_view strCount = vecWord.at(2);
+            const std::from_chars_result res = std::from_chars(strCount.data(), strCount.data() + strCount.size(), element.count);
+            if (res.ec != std::errc() || element.count < 0)
+                return false;
+
+            header->vecElement.push_back(std::move(element));
+        }
+        else if (keyword == "property") {
+            if (header->vecElement.empty())
+                return false;
+
+            PlyProperty prop;
+            if (vecWord.size() >= 5 && vecWord.at(1) == "list") {
+                prop.listCountType = plyType(vecWord.at(2));
+                prop.type = plyType(vecWord.at(3));
+                prop.name = std::string(vecWord.at(4));
+                if (prop.listCountType == PlyType::Unknown || plyIsFloatType(prop.listCountType))
+                    return false;
+            }
+            else if (vecWord.size() >= 3) {
+                prop.type = plyType(vecWord.at(1));
+                prop.name = std::string(vecWord.at(2));
+            }
+
+            if (prop.type == PlyType::Unknown)
+                return false;
+
+            header->vecElement.back().vecProperty.push_back(std::move(prop));
+        }
+        else if (keyword == "end_header") {
+            header->dataOffset = pos;
+            return hasFormat;
+        }
+    }
+
+    return false;
+}
+
+// Properties of element "vertex" giving the attributes of the mesh nodes, -1 if missing
+struct PlyVertexLayout {
+    int coords[3] = { -1, -1, -1 };
+    int normal[3] = { -1, -1, -1 };
+    int color[3] = { -1, -1, -1 };
+
+    bool hasCoords() const { return this->coords[0] >= 0 && this->coords[1] >= 0 && this->coords[2] >= 0; }
+    bool hasNormals() const { return this->normal[0] >= 0 && this->normal[1] >= 0 && this->normal[2] >= 0; }
+    bool hasColors() const { return this->color[0] >= 0 && this->color[1] >= 0 && this->color[2] >= 0; }
+};
+
+PlyVertexLayout plyVertexLayout(const PlyElement& element)
+{
+    constexpr std::string_view coordNames[] = { "x", "y", "z" };
+    constexpr std::string_view normalNames[] = { "nx", "ny", "nz" };
+    constexpr std::string_view colorNames[] = { "red", "green", "blue" };
+    constexpr std::string_view diffuseColorNames[] = { "diffuse_red", "diffuse_green", "diffuse_blue" };
+    PlyVertexLayout layout;
+    for (int i = 0; i < 3; ++i) {
+        layout.coords[i] = element.findProperty(coordNames[i], false);
+        layout.normal[i] = element.findProperty(normalNames[i], false);
+        layout.color[i] = element.findProperty(colorNames[i], false);
+        if (layout.color[i] < 0)
+            layout.color[i] = element.findProperty(diffuseColorNames[i], false);
+    }
+
+    return layout;
+}
+
+// Returns the index of the list property of element "face" giving the polygon vertices, -1 if none
+int plyFaceIndicesProperty(const PlyElement& element)
+{
+    const int index = element.findProperty("vertex_indices", true);
+    return index >= 0 ? index : element.findProperty("vertex_index", true);
+}
+
+// Color component in [0,255] from PLY value, floating point values are expected in [0,1]
+uint8_t plyColorComponent(double value, PlyType type)
+{
+    if (plyIsFloatType(type))
+        value *= 255.;
+
+    return uint8_t(std::clamp<long>(std::lround(value), 0, 255));
+}
+
+int plyFanTriangleCount(int polygonNodeCount)
+{
+    return std::max(polygonNodeCount - 2, 0);
+}
+
+// Target of the nodes and triangles read, can be filled concurrently at distinct indices
+// Indices are zero-based
+class PlyMeshBuilder {
+public:
+    PlyMeshBuilder(int nodeCount, int triangleCount, const PlyVertexLayout& layout)
+        : m_nodeCount(nodeCount),
+          m_mesh(new Poly_Triangulation(nodeCount, triangleCount, false)),
+          m_vecMeshTriangle(m_mesh->ChangeTriangles())
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+          , m_vecMeshNode(m_mesh->ChangeNodes())
+#endif
+    {
+        if (layout.hasNormals()) {
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+            m_mesh->AddNormals();
+#else
+            m_vecMeshNormal = new TShort_HArray1OfShortReal(1, 3 * nodeCount);
+#endif
+            m_hasNormals = true;
+        }
+
+        if (layout.hasColors())
+            m_vecNodeColor.resize(nodeCount);
+    }
+
+    bool hasNormals() const { return m_hasNormals; }
+    bool hasColors() const { return !m_vecNodeColor.empty(); }
+
+    void setNode(int i, double x, double y, double z) {
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+        m_mesh->SetNode(i + 1, gp_Pnt(x, y, z));
+#else
+        m_vecMeshNode.ChangeValue(i + 1).SetCoord(x, y, z);
+#endif
+    }
+
+    void setNormal(int i, float nx, float ny, float nz) {
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+        m_mesh->SetNormal(i + 1, gp_Vec3f(nx, ny, nz));
+#else
+        m_vecMeshNormal->SetValue(3 * i + 1, nx);
+        m_vecMeshNormal->SetValue(3 * i + 2, ny);
+        m_vecMeshNormal->SetValue(3 * i + 3, nz);
+#endif
+    }
+
+    void setColor(int i, uint32_t rgb) { m_vecNodeColor[i] = rgb; }
+
+    // Returns false if some node index is out of range
+    bool setTriangle(int i, int n1, int n2, int n3) {
+        auto fnIsValid = [=](int n) { return n >= 0 && n < m_nodeCount; };
+        if (!fnIsValid(n1) || !fnIsValid(n2) || !fnIsValid(n3))
+            return false;
+
+        m_vecMeshTriangle.ChangeValue(i + 1).Set(n1 + 1, n2 + 1, n3 + 1);
+        return true;
+    }
+
+    Handle_Poly_Triangulation mesh() {
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+        if (m_hasNormals)
+            m_mesh->SetNormals(m_vecMeshNormal);
+#endif
+        return m_mesh;
+    }
+
+    std::vector<uint32_t>& nodeColors() { return m_vecNodeColor; }
+
+private:
+    int m_nodeCount = 0;
+    Handle_Poly_Triangulation m_mesh;
+    Poly_Array1OfTriangle& m_vecMeshTriangle;
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+    TColgp_Array1OfPnt& m_vecMeshNode;
+    Handle_TShort_HArray1OfShortReal m_vecMeshNormal;
+#endif
+    bool m_hasNormals = false;
+    std::vector<uint32_t> m_vecNodeColor;
+};
+
+// Sets the normal and color of node 'iNode', 'fnValue(iProperty)' gives the value of a vertex property
+template<typename FUNCTION>
+void plySetNodeAttributes(
+        PlyMeshBuilder* builder,
+        int iNode,
+        const PlyElement& element,
+        const PlyVertexLayout& layout,
+        FUNCTION fnValue)
+{
+    if (builder->hasNormals()) {
+        builder->setNormal(
+                    iNode,
+                    float(fnValue(layout.normal[0])),
+                    float(fnValue(layout.normal[1])),
+                    float(fnValue(layout.normal[2])));
+    }
+
+    if (builder->hasColors()) {
+        uint8_t rgb[3];
+        for (int i = 0; i < 3; ++i)
+            rgb[i] = plyColorComponent(fnValue(layout.color[i]), element.vecProperty.at(layout.color[i]).type);
+
+        builder->setColor(iNode, MeshNodeColors::packRgb(rgb[0], rgb[1], rgb[2]));
+    }
+}
+
+// Adds the triangles of polygon 'vecIndex'(fan triangulation) from triangle 'iTriangle'
+// Returns false if some node index is out of range
+bool plySetPolygon(PlyMeshBuilder* builder, int iTriangle, const std::vector<int>& vecIndex)
+{
+    bool ok = true;
+    const int triangleCount = plyFanTriangleCount(int(vecIndex.size()));
+    for (int i = 0; i < triangleCount; ++i)
+        ok = builder->setTriangle(iTriangle + i, vecIndex[0], vecIndex[i + 1], vecIndex[i + 2]) && ok;
+
+    return ok;
+}
+
+//
+// Binary contents
+//
+
+// Records of an element in binary contents
+struct PlyBinaryElementData {
+    const uchar* begin = nullptr;
+    const uchar* end = nullptr;
+    std::vector<const uchar*> vecChunkBegin; // Start of each chunk of PlyChunkItemCount records
+};
+
+// Returns the size in bytes of the record starting at 'ptr', -1 if it overflows 'ptrEnd'
+int64_t plyBinaryRecordSize(const uchar* ptr, const uchar* ptrEnd, const PlyElement& element, bool isBigEndian)
+{
+    const int64_t maxSize = ptrEnd - ptr;
+    int64_t size = 0;
+    for (const PlyProperty& prop : element.vecProperty) {
+        if (prop.isList()) {
+            const int countSize = plyTypeSize(prop.listCountType);
+            if (size + countSize > maxSize)
+                return -1;
+
+            const double count = plyReadBinaryValue(ptr + size, prop.listCountType, isBigEndian);
+            if (count < 0)
+                return -1;
+
+            size += countSize + int64_t(count) * plyTypeSize(prop.type);
+        }
+        else {
+            size += plyTypeSize(prop.type);
+        }
+    }
+
+    return size <= maxSize ? size : -1;
+}
+
+// Locates the records of the first 'elementCount' elements, records of fixed size are located
+// arithmetically, others are skimmed to find their size
+bool plyScanBinaryElements(
+        const uchar* data,
+        size_t size,
+        const PlyHeader& header,
+        int elementCount,
+        std::vector<PlyBinaryElementData>* ptrVecElementData)
+{
+    const bool isBigEndian = header.format == PlyFormat::BinaryBigEndian;
+    const uchar* ptrEnd = data + size;
+    const uchar* ptr = data + header.dataOffset;
+    for (int iElement = 0; iElement < elementCount; ++iElement) {
+        const PlyElement& element = header.vecElement.at(iElement);
+        PlyBinaryElementData elementData;
+        elementData.begin = ptr;
+        const int recordSize = element.recordSize();
+        if (recordSize >= 0) {
+            if (recordSize > 0 && element.count > (ptrEnd - ptr) / recordSize)
+                return false; // Truncated contents
+
+            for (int64_t i = 0; i < element.count; i += PlyChunkItemCount)
+                elementData.vecChunkBegin.push_back(ptr + i * recordSize);
+
+            ptr += element.count * recordSize;
+        }
+        else {
+            for (int64_t i = 0; i < element.count; ++i) {
+                if (i % PlyChunkItemCount == 0)
+                    elementData.vecChunkBegin.push_back(ptr);
+
+                const int64_t recordSize = plyBinaryRecordSize(ptr, ptrEnd, element, isBigEndian);
+                if (recordSize < 0)
+                    return false;
+
+                ptr += recordSize;
+            }
+        }
+
+        elementData.end = ptr;
+        ptrVecElementData->push_back(std::move(elementData));
+    }
+
+    return true;
+}
+
+// Calls 'fn(vecIndex)' for each of the 'recordCount' records starting at 'ptr', 'vecIndex' being
+// the values of list property 'iIndicesProperty'. Records must have been validated
+// Fast path when node indices are 32bit integers in the byte order of the host
+template<typename FUNCTION>
+void plyForEachBinaryPolygon(
+        const uchar* ptr,
+        int64_t recordCount,
+        const PlyElement& element,
+        int iIndicesProperty,
+        bool isBigEndian,
+        FUNCTION fn)
+{
+    const PlyProperty& propIndices = element.vecProperty.at(iIndicesProperty);
+    const bool isHostByteOrder = isBigEndian == (Q_BYTE_ORDER == Q_BIG_ENDIAN);
+    const bool isNativeIndex =
+            isHostByteOrder && (propIndices.type == PlyType::Int32 || propIndices.type == PlyType::UInt32);
+    const int propCount = int(element.vecProperty.size());
+    std::vector<int> vecIndex;
+    for (int64_t iRecord = 0; iRecord < recordCount; ++iRecord) {
+        vecIndex.clear();
+        for (int iProp = 0; iProp < propCount; ++iProp) {
+            const PlyProperty& prop = element.vecProperty[iProp];
+            if (!prop.isList()) {
+                ptr += plyTypeSize(prop.type);
+                continue;
+            }
+
+            const int count = int(plyReadBinaryValue(ptr, prop.listCountType, isBigEndian));
+            const int valueSize = plyTypeSize(prop.type);
+            ptr += plyTypeSize(prop.listCountType);
+            if (iProp == iIndicesProperty) {
+                vecIndex.resize(count);
+                if (isNativeIndex) {
+                    std::memcpy(vecIndex.data(), ptr, size_t(count) * sizeof(int));
+                }
+                else {
+                    for (int i = 0; i < count; ++i)
+                        vecIndex[i] = int(plyReadBinaryValue(ptr + i * valueSize, prop.type, isBigEndian));
+                }
+            }
+
+            ptr += int64_t(count) * valueSize;
+        }
+
+        fn(vecIndex);
+    }
+}
+
+bool plyReadBinary(
+        const uchar* data,
+        size_t size,
+        const PlyHeader& header,
+        Handle_Poly_Triangulation* ptrMesh,
+        std::vector<uint32_t>* ptrVecNodeColor,
+        TaskProgress* progress)
+{
+    const bool isBigEndian = header.format == PlyFormat::BinaryBigEndian;
+    const int iVertexElement = header.findElement("vertex");
+    const int iFaceElement = header.findElement("face");
+    const PlyElement& vertexElement = header.vecElement.at(iVertexElement);
+    const PlyVertexLayout layout = plyVertexLayout(vertexElement);
+    const int vertexRecordSize = vertexElement.recordSize();
+    if (vertexRecordSize < 0)
+        return false; // Variable-size vertex records aren't supported
+
+    std::vector<PlyBinaryElementData> vecElementData;
+    const int scanElementCount = std::max(iVertexElement, iFaceElement) + 1;
+    if (!plyScanBinaryElements(data, size, header, scanElementCount, &vecElementData))
+        return false;
+
+    if (progress)
+        progress->setValue(10);
+
+    // Count triangles of each chunk of faces
+    const PlyElement* faceElement = iFaceElement >= 0 ? &header.vecElement.at(iFaceElement) : nullptr;
+    const int iIndicesProperty = faceElement ? plyFaceIndicesProperty(*faceElement) : -1;
+    const std::vector<const uchar*> vecFaceChunkBegin =
+            iIndicesProperty >= 0 ? vecElementData.at(iFaceElement).vecChunkBegin : std::vector<const uchar*>{};
+    const int faceChunkCount = int(vecFaceChunkBegin.size());
+    auto fnFaceChunkRecordCount = [&](int iChunk) {
+        return std::min<int64_t>(PlyChunkItemCount, faceElement->count - int64_t(iChunk) * PlyChunkItemCount);
+    };
+    std::vector<int64_t> vecChunkTriangleOffset(faceChunkCount + 1, 0);
+    CppUtils::parallelFor(faceChunkCount, [&](int iChunk) {
+        int64_t triangleCount = 0;
+        plyForEachBinaryPolygon(
+                    vecFaceChunkBegin.at(iChunk), fnFaceChunkRecordCount(iChunk),
+                    *faceElement, iIndicesProperty, isBigEndian,
+                    [&](const std::vector<int>& vecIndex) {
+            triangleCount += plyFanTriangleCount(int(vecIndex.size()));
+        });
+        vecChunkTriangleOffset.at(iChunk + 1) = triangleCount;
+    });
+
+    for (int i = 0; i < faceChunkCount; ++i)
+        vecChunkTriangleOffset.at(i + 1) += vecChunkTriangleOffset.at(i);
+
+    const int64_t nodeCount = vertexElement.count;
+    const int64_t triangleCount = vecChunkTriangleOffset.back();
+    if (nodeCount == 0 || triangleCount == 0 || nodeCount > std::numeric_limits<int>::max()
+            || triangleCount > std::numeric_limits<int>::max())
+    {
+        return false;
+    }
+
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
+    PlyMeshBuilder builder(int(nodeCount), int(triangleCount), layout);
+
+    // Decode vertices, properties are at fixed offsets within records
+    std::vector<int> vecPropOffset;
+    {
+        int offset = 0;
+        for (const PlyProperty& prop : vertexElement.vecProperty) {
+            vecPropOffset.push_back(offset);
+            offset += plyTypeSize(prop.type);
+        }
+    }
+
+    const bool isHostByteOrder = isBigEndian == (Q_BYTE_ORDER == Q_BIG_ENDIAN);
+    const bool isNativeCoords =
+            isHostByteOrder
+            && vertexElement.vecProperty.at(layout.coords[0]).type == PlyType::Float32
+            && vertexElement.vecProperty.at(layout.coords[1]).type == PlyType::Float32
+            && vertexElement.vecProperty.at(layout.coords[2]).type == PlyType::Float32;
+    const uchar* vertexData = vecElementData.at(iVertexElement).begin;
+    const int vertexChunkCount = int((nodeCount + PlyChunkItemCount - 1) / PlyChunkItemCount);
+    TaskChunkProgress vertexProgress(progress, vertexChunkCount, 10, 50);
+    CppUtils::parallelFor(vertexChunkCount, [&](int iChunk) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        const int iNodeBegin = iChunk * PlyChunkItemCount;
+        const int iNodeEnd = int(std::min<int64_t>(iNodeBegin + PlyChunkItemCount, nodeCount));
+        for (int iNode = iNodeBegin; iNode < iNodeEnd; ++iNode) {
+            const uchar* record = vertexData + int64_t(iNode) * vertexRecordSize;
+            auto fnValue = [&](int iProp) {
+                const PlyProperty& prop = vertexElement.vecProperty[iProp];
+                return plyReadBinaryValue(record + vecPropOffset[iProp], prop.type, isBigEndian);
+            };
+            if (isNativeCoords) {
+                float coords[3];
+                for (int i = 0; i < 3; ++i)
+                    std::memcpy(&coords[i], record + vecPropOffset[layout.coords[i]], sizeof(float));
+
+                builder.setNode(iNode, coords[0], coords[1], coords[2]);
+            }
+            else {
+                builder.setNode(iNode, fnValue(layout.coords[0]), fnValue(layout.coords[1]), fnValue(layout.coords[2]));
+            }
+
+            plySetNodeAttributes(&builder, iNode, vertexElement, layout, fnValue);
+        }
+
+        vertexProgress.chunkDone();
+    });
+
+    // Decode faces
+    std::atomic<bool> okIndices = true;
+    TaskChunkProgress faceProgress(progress, faceChunkCount, 50, 100);
+    CppUtils::parallelFor(faceChunkCount, [&](int iChunk) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        int iTriangle = int(vecChunkTriangleOffset.at(iChunk));
+        plyForEachBinaryPolygon(
+                    vecFaceChunkBegin.at(iChunk), fnFaceChunkRecordCount(iChunk),
+                    *faceElement, iIndicesProperty, isBigEndian,
+                    [&](const std::vector<int>& vecIndex) {
+            if (!plySetPolygon(&builder, iTriangle, vecIndex))
+                okIndices = false;
+
+            iTriangle += plyFanTriangleCount(int(vecIndex.size()));
+        });
+        faceProgress.chunkDone();
+    });
+
+    if (!okIndices || TaskProgress::isAbortRequested(progress))
+        return false;
+
+    *ptrMesh = builder.mesh();
+    ptrVecNodeColor->swap(builder.nodeColors());
+    return true;
+}
+
+//
+// ASCII contents
+//
+
+// Records of an element in ASCII contents, each record is a line
+struct PlyAsciiElementData {
+    std::vector<const char*> vecChunkBegin; // Start of each chunk of PlyChunkItemCount records
+    const char* end = nullptr;
+};
+
+// Locates the records of the first 'elementCount' elements, blank lines are skipped
+bool plyScanAsciiElements(
+        const char* data,
+        size_t size,
+        const PlyHeader& header,
+        int elementCount,
+        std::vector<PlyAsciiElementData>* ptrVecElementData)
+{
+    const char* itEnd = data + size;
+    const char* it = data + header.dataOffset;
+    for (int iElement = 0; iElement < elementCount; ++iElement) {
+        const PlyElement& element = header.vecElement.at(iElement);
+        PlyAsciiElementData elementData;
+        for (int64_t i = 0; i < element.count; ++i) {
+            while (it < itEnd && plyIsSpace(*it))
+                ++it;
+
+            if (it == itEnd)
+                return false; // Truncated contents
+
+            if (i % PlyChunkItemCount == 0)
+                elementData.vecChunkBegin.push_back(it);
+
+            const char* itLineEnd = static_cast<const char*>(std::memchr(it, '\n', itEnd - it));
+            it = itLineEnd ? itLineEnd + 1 : itEnd;
+        }
+
+        elementData.end = it;
+        ptrVecElementData->push_back(std::move(elementData));
+    }
+
+    return true;
+}
+
+// Parses the record of ASCII line [it, itEnd), scalar values are stored in 'values'(one slot per
+// property) at the index of their property. Values of list property 'iListProperty' are stored in 'vecListValue', other
+// lists are skipped
+bool plyParseAsciiRecord(
+        const char* it,
+        const char* itEnd,
+        const PlyElement& element,
+        int iListProperty,
+        double* values,
+        std::vector<int>* vecListValue)
+{
+    auto fnParseValue = [&](double* value) {
+        while (it < itEnd && plyIsSpace(*it))
+            ++it;
+
+        const fast_float::from_chars_result res = fast_float::from_chars(it, itEnd, *value);
+        if (res.ec != std::errc())
+            return false;
+
+        it = res.ptr;
+        return true;
+    };
+
+    const int propCount = int(element.vecProperty.size());
+    for (int iProp = 0; iProp < propCount; ++iProp) {
+        const PlyProperty& prop = element.vecProperty[iProp];
+        if (!prop.isList()) {
+            if (!fnParseValue(&values[iProp]))
+                return false;
+
+            continue;
+        }
+
+        double count = 0;
+        if (!fnParseValue(&count) || count < 0)
+            return false;
+
+        if (iProp == iListProperty)
+            vecListValue->resize(size_t(count));
+
+        for (int i = 0; i < int(count); ++i) {
+            double value = 0;
+            if (!fnParseValue(&value))
+                return false;
+
+            if (iProp == iListProperty)
+                (*vecListValue)[i] = int(value);
+        }
+    }
+
+    return true;
+}
+
+// Calls 'fn(itLine, itLineEnd)' for each of the 'recordCount' records(lines) starting at 'it'
+template<typename FUNCTION>
+void plyForEachAsciiRecord(const char* it, const char* itEnd, int64_t recordCount, FUNCTION fn)
+{
+    for (int64_t i = 0; i < recordCount && it < itEnd; ++i) {
+        while (it < itEnd && plyIsSpace(*it))
+            ++it;
+
+        const char* itLineEnd = static_cast<const char*>(std::memchr(it, '\n', itEnd - it));
+        itLineEnd = itLineEnd ? itLineEnd : itEnd;
+        fn(it, itLineEnd);
+        it = itLineEnd;
+    }
+}
+
+bool plyReadAscii(
+        const char* data,
+        size_t size,
+        const PlyHeader& header,
+        Handle_Poly_Triangulation* ptrMesh,
+        std::vector<uint32_t>* ptrVecNodeColor,
+        TaskProgress* progress)
+{
+    const char* itEnd = data + size;
+    const int iVertexElement = header.findElement("vertex");
+    const int iFaceElement = header.findElement("face");
+    const PlyElement& vertexElement = header.vecElement.at(iVertexElement);
+    const PlyVertexLayout layout = plyVertexLayout(vertexElement);
+    std::vector<PlyAsciiElementData> vecElementData;
+    const int scanElementCount = std::max(iVertexElement, iFaceElement) + 1;
+    if (!plyScanAsciiElements(data, size, header, scanElementCount, &vecElementData))
+        return false;
+
+    if (progress)
+        progress->setValue(10);
+
+    // Parse faces first, the count of triangles is required to create the mesh
+    const PlyElement* faceElement = iFaceElement >= 0 ? &header.vecElement.at(iFaceElement) : nullptr;
+    const int iIndicesProperty = faceElement ? plyFaceIndicesProperty(*faceElement) : -1;
+    const std::vector<const char*> vecFaceChunkBegin =
+            iIndicesProperty >= 0 ? vecElementData.at(iFaceElement).vecChunkBegin : std::vector<const char*>{};
+    const int faceChunkCount = int(vecFaceChunkBegin.size());
+    std::vector<std::vector<int>> vecChunkPolygon(faceChunkCount); // Sequences of "count i1 i2 ..."
+    std::vector<int64_t> vecChunkTriangleOffset(faceChunkCount + 1, 0);
+    std::atomic<bool> okParse = true;
+    TaskChunkProgress faceProgress(progress, faceChunkCount, 10, 40);
+    CppUtils::parallelFor(faceChunkCount, [&](int iChunk) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        const int64_t recordCount =
+                std::min<int64_t>(PlyChunkItemCount, faceElement->count - int64_t(iChunk) * PlyChunkItemCount);
+        std::vector<double> vecValue(faceElement->vecProperty.size());
+        std::vector<int> vecIndex;
+        std::vector<int>& vecPolygon = vecChunkPolygon.at(iChunk);
+        int64_t triangleCount = 0;
+        plyForEachAsciiRecord(vecFaceChunkBegin.at(iChunk), itEnd, recordCount, [&](const char* it, const char* itLineEnd) {
+            if (!plyParseAsciiRecord(it, itLineEnd, *faceElement, iIndicesProperty, vecValue.data(), &vecIndex)) {
+                okParse = false;
+                return;
+            }
+
+            vecPolygon.push_back(int(vecIndex.size()));
+            vecPolygon.insert(vecPolygon.end(), vecIndex.cbegin(), vecIndex.cend());
+            triangleCount += plyFanTriangleCount(int(vecIndex.size()));
+        });
+        vecChunkTriangleOffset.at(iChunk + 1) = triangleCount;
+        faceProgress.chunkDone();
+    });
+
+    for (int i = 0; i < faceChunkCount; ++i)
+        vecChunkTriangleOffset.at(i + 1) += vecChunkTriangleOffset.at(i);
+
+    const int64_t nodeCount = vertexElement.count;
+    const int64_t triangleCount = vecChunkTriangleOffset.back();
+    if (!okParse || nodeCount == 0 || triangleCount == 0 || nodeCount > std::numeric_limits<int>::max()
+            || triangleCount > std::numeric_limits<int>::max())
+    {
+        return false;
+    }
+
+    if (TaskProgress::isAbortRequested(progress))
+        return false;
+
+    PlyMeshBuilder builder(int(nodeCount), int(triangleCount), layout);
+
+    // Parse vertices straight into the mesh
+    const std::vector<const char*>& vecVertexChunkBegin = vecElementData.at(iVertexElement).vecChunkBegin;
+    const int vertexChunkCount = int(vecVertexChunkBegin.size());
+    TaskChunkProgress vertexProgress(progress, vertexChunkCount, 40, 90);
+    CppUtils::parallelFor(vertexChunkCount, [&](int iChunk) {
+        if (TaskProgress::isAbortRequested(progress))
+            return;
+
+        const int iNodeBegin = iChunk * PlyChunkItemCount;
+        const int64_t recordCount = std::min<int64_t>(PlyChunkItemCount, nodeCount - iNodeBegin);
+        std::vector<double> vecValue(vertexElement.vecProperty.size());
+        std::vector<int> vecUnused;
+        int iNode = iNodeBegin;
+        plyForEachAsciiRecord(vecVertexChunkBegin.at(iChunk), itEnd, recordCount, [&](const char* it, const char* itLineEnd) {
+            if (!plyParseAsciiRecord(it, itLineEnd, vertexElement, -1, vecValue.data(), &vecUnused))
+                okParse = false;
+
+            auto fnValue = [&](int iProp) { return vecValue[iProp]; };
+            builder.setNode(iNode, fnValue(layout.coords[0]), fnValue(layout.coords[1]), fnValue(layout.coords[2]));
+            plySetNodeAttributes(&builder, iNode, vertexElement, layout, fnValue);
+            ++iNode;
+        });
+        vertexProgress.chunkDone();
+    });
+
+    // Move polygons into the mesh
+    std::atomic<bool> okIndices = true;
+    CppUtils::parallelFor(faceChunkCount, [&](int iChunk) {
+        std::vector<int> vecIndex;
+        const std::vector<int>& vecPolygon = vecChunkPolygon.at(iChunk);
+        int iTriangle = int(vecChunkTriangleOffset.at(iChunk));
+        for (size_t pos = 0; pos < vecPolygon.size(); ) {
+            const int count = vecPolygon[pos];
+            vecIndex.assign(vecPolygon.begin() + pos + 1, vecPolygon.begin() + pos + 1 + count);
+            if (!plySetPolygon(&builder, iTriangle, vecIndex))
+                okIndices = false;
+
+            iTriangle += plyFanTriangleCount(count);
+            pos += 1 + count;
+        }
+    });
+
+    if (!okParse || !okIndices || TaskProgress::isAbortRequested(progress))
+        return false;
+
+    if (progress)
+        progress->setValue(100);
+
+    *ptrMesh = builder.mesh();
+    ptrVecNodeColor->swap(builder.nodeColors());
+    return true;
+}
+
+} // namespace
+
+bool PlyReader::readFile(const FilePath& filepath, TaskProgress* progress)
+{
+    m_baseFilename = filepath.stem();
+    MappedFile file;
+    if (!file.open(filepath))
+        return false;
+
+    return this->readData(file.data(), size_t(file.size()), progress);
+}
+
+bool PlyReader::readStream(std::istream& istr, const FilePath& name, TaskProgress* progress)
+{
+    // Records are located before being decoded, data is gathered in memory(no temporary file)
+    m_baseFilename = name.stem();
+    std::string data;
+    if (!StreamUtils::readAll(istr, &data))
+        return false;
+
+    return this->readData(data.data(), data.size(), progress);
+}
+
+bool PlyReader::readData(const char* data, size_t size, TaskProgress* progress)
+{
+    m_mesh.Nullify();
+    m_vecNodeColor.clear();
+    PlyHeader header;
+    if (!data || !plyParseHeader(data, size, &header))
+        return false;
+
+    const int iVertexElement = header.findElement("vertex");
+    if (iVertexElement < 0 || !plyVertexLayout(header.vecElement.at(iVertexElement)).hasCoords())
+        return false;
+
+    if (header.format == PlyFormat::Ascii)
+        return plyReadAscii(data, size, header, &m_mesh, &m_vecNodeColor, progress);
+    else
+        return plyReadBinary(reinterpret_cast<const uchar*>(data), size, header, &m_mesh, &m_vecNodeColor, progress);
+}
+
+TDF_LabelSequence PlyReader::transfer(DocumentPtr doc, TaskProgress* progress)
+{
+    if (m_mesh.IsNull() || TaskProgress::isAbortRequested(progress))
+        return {};
+
+    const TDF_Label entityLabel = doc->newEntityLabel();
+    TDataXtd_Triangulation::Set(entityLabel, m_mesh);
+    MeshNodeColors::set(entityLabel, m_vecNodeColor);
+    CafUtils::setLabelAttrStdName(entityLabel, filepathTo<QString>(m_baseFilename));
+    return CafUtils::makeLabelSequence({ entityLabel });
+}
+
+} // namespace IO
+} // namespace Mayo
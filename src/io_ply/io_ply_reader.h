@@ -0,0 +1,41 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/io_reader.h"
+#include <Poly_Triangulation.hxx>
+#include <cstdint>
+#include <vector>
+
+namespace Mayo {
+namespace IO {
+
+// Native reader for PLY(Polygon File Format) files, ASCII and binary(little or big endian)
+// Element "vertex" gives the mesh nodes with their normals(nx ny nz) and colors(red green blue)
+// if any, element "face" gives the polygons which are fan-triangulated. Other elements and
+// properties are skipped
+// Binary records are decoded straight from the file mapped in memory into the buffers of the
+// triangulation, by chunks processed concurrently. ASCII contents are split in chunks of lines
+// parsed concurrently
+// Colors are stored as node colors of the mesh entity, see MeshNodeColors
+class PlyReader : public Reader {
+public:
+    bool readFile(const FilePath& filepath, TaskProgress* progress) override;
+    bool readStream(std::istream& istr, const FilePath& name, TaskProgress* progress) override;
+    bool readsStream() const override { return true; }
+    TDF_LabelSequence transfer(DocumentPtr doc, TaskProgress* progress) override;
+
+private:
+    bool readData(const char* data, size_t size, TaskProgress* progress);
+
+    Handle_Poly_Triangulation m_mesh;
+    std::vector<uint32_t> m_vecNodeColor; // Packed as 0xRRGGBB
+    FilePath m_baseFilename;
+};
+
+} // namespace IO
+} // namespace Mayo
@@ -0,0 +1,458 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_ply_writer.h"
+
+#include "../base/application_item.h"
+#include "../base/async_file_stream.h"
+#include "../base/brep_utils.h"
+#include "../base/caf_utils.h"
+#include "../base/cpp_utils.h"
+#include "../base/document.h"
+#include "../base/mesh_node_colors.h"
+#include "../base/property_enumeration.h"
+#include "../base/string_utils.h"
+#include "../base/task_progress.h"
+#include "../base/tkernel_utils.h"
+
+#include <QtCore/QtEndian>
+#include <TDataXtd_Triangulation.hxx>
+#include <TopoDS.hxx>
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+#  include <TShort_Array1OfShortReal.hxx>
+#endif
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <thread>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+// Count of items(nodes or triangles) in a chunk of serialization
+constexpr int PlyWriterChunkItemCount = 64 * 1024;
+
+// Triangulation to be written, with the colors of its nodes(if any)
+struct PlyWriterMesh : BRepUtils::FaceTriangulation {
+    const std::vector<uint32_t>* ptrVecNodeColor = nullptr;
+    int nodeOffset = 0; // Index of the first node of the triangulation in element "vertex"
+};
+
+// Excerpt of the nodes or triangles to be written
+struct PlyWriterChunk {
+    int iMeshBegin = 0;
+    int iItemBegin = 0; // Index of the first item within mesh 'iMeshBegin'
+    int itemCount = 0;
+};
+
+// Splits the items of the meshes in chunks of fixed size, 'fnItemCount(mesh)' gives the count of
+// items of a mesh. A chunk can span many meshes
+template<typename FUNCTION>
+std::vector<PlyWriterChunk> plyWriterChunks(Span<const PlyWriterMesh> spanMesh, FUNCTION fnItemCount)
+{
+    std::vector<PlyWriterChunk> vecChunk;
+    PlyWriterChunk chunk;
+    for (int iMesh = 0; iMesh < int(spanMesh.size()); ++iMesh) {
+        const int meshItemCount = fnItemCount(spanMesh[iMesh]);
+        int iItem = 0;
+        while (iItem < meshItemCount) {
+            if (chunk.itemCount == 0) {
+                chunk.iMeshBegin = iMesh;
+                chunk.iItemBegin = iItem;
+            }
+
+            const int count = std::min(meshItemCount - iItem, PlyWriterChunkItemCount - chunk.itemCount);
+            chunk.itemCount += count;
+            iItem += count;
+            if (chunk.itemCount == PlyWriterChunkItemCount) {
+                vecChunk.push_back(chunk);
+                chunk = {};
+            }
+        }
+    }
+
+    if (chunk.itemCount > 0)
+        vecChunk.push_back(chunk);
+
+    return vecChunk;
+}
+
+// Calls 'fn(mesh, iItem)' for each item of 'chunk', 'iItem' being zero-based within 'mesh'
+template<typename COUNT_FUNCTION, typename FUNCTION>
+void plyForEachChunkItem(
+        Span<const PlyWriterMesh> spanMesh,
+        const PlyWriterChunk& chunk,
+        COUNT_FUNCTION fnItemCount,
+        FUNCTION fn)
+{
+    int iMesh = chunk.iMeshBegin;
+    int iItem = chunk.iItemBegin;
+    for (int i = 0; i < chunk.itemCount; ++i) {
+        while (iItem >= fnItemCount(spanMesh[iMesh])) {
+            ++iMesh;
+            iItem = 0;
+        }
+
+        fn(spanMesh[iMesh], iItem);
+        ++iItem;
+    }
+}
+
+gp_Vec plyNodeNormal(const Poly_Triangulation& mesh, int nodeId)
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    gp_Vec3f normal;
+    mesh.Normal(nodeId, normal);
+    return gp_Vec(normal.x(), normal.y(), normal.z());
+#else
+    const TShort_Array1OfShortReal& vecNormal = mesh.Normals();
+    const int i = (nodeId - 1) * 3 + vecNormal.Lower();
+    return gp_Vec(vecNormal.Value(i), vecNormal.Value(i + 1), vecNormal.Value(i + 2));
+#endif
+}
+
+// Appends binary values(little-endian) or text to a buffer
+class PlyWriterBuffer {
+public:
+    PlyWriterBuffer(std::vector<char>* ptrBuffer) : m_buffer(*ptrBuffer) {}
+
+    void appendFloat(double value) {
+        const float fvalue = float(value);
+        quint32 bits;
+        std::memcpy(&bits, &fvalue, sizeof(bits));
+        this->appendBytes(qToLittleEndian(bits));
+    }
+
+    void appendInt(int value) { this->appendBytes(qToLittleEndian(qint32(value))); }
+    void appendUChar(uint8_t value) { m_buffer.push_back(char(value)); }
+
+    // Decimal point is '.' whatever the C locale
+    void appendNumber(double value, int precision) {
+        char str[64];
+        const int len = StringUtils::formatNumber(str, sizeof(str), value, std::chars_format::general, precision);
+        m_buffer.insert(m_buffer.end(), str, str + len);
+    }
+
+    void appendNumber(int value) {
+        char str[16];
+        const auto res = std::to_chars(str, str + sizeof(str), value);
+        m_buffer.insert(m_buffer.end(), str, res.ptr);
+    }
+
+private:
+    template<typename T> void appendBytes(T value) {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + sizeof(value));
+    }
+
+    std::vector<char>& m_buffer;
+};
+
+int plyNodeCount(const PlyWriterMesh& mesh)
+{
+    return mesh.triangulation->NbNodes();
+}
+
+int plyTriangleCount(const PlyWriterMesh& mesh)
+{
+    return mesh.triangulation->NbTriangles();
+}
+
+// Appends the records of the nodes of 'chunk' to buffer
+void plyWriteVertexChunk(
+        Span<const PlyWriterMesh> spanMesh,
+        const PlyWriterChunk& chunk,
+        PlyWriter::Format format,
+        bool hasNormals,
+        bool hasColors,
+        std::vector<char>* ptrBuffer)
+{
+    ptrBuffer->clear();
+    ptrBuffer->reserve(size_t(chunk.itemCount) * (format == PlyWriter::Format::Ascii ? 96 : 27));
+    PlyWriterBuffer buffer(ptrBuffer);
+    plyForEachChunkItem(spanMesh, chunk, plyNodeCount, [&](const PlyWriterMesh& mesh, int iNode) {
+        const gp_Pnt pnt = mesh.triangulation->Node(iNode + 1).Transformed(mesh.trsf);
+        gp_Vec normal;
+        if (hasNormals) {
+            normal = plyNodeNormal(*mesh.triangulation, iNode + 1).Transformed(mesh.trsf);
+            const double normalLength = normal.Magnitude();
+            normal = normalLength > gp::Resolution() ? normal / normalLength : gp_Vec(0, 0, 0);
+            if (mesh.isReversed)
+                normal.Reverse();
+        }
+
+        const uint32_t rgb = hasColors ? (*mesh.ptrVecNodeColor)[iNode] : 0;
+        if (format == PlyWriter::Format::BinaryLittleEndian) {
+            buffer.appendFloat(pnt.X());
+            buffer.appendFloat(pnt.Y());
+            buffer.appendFloat(pnt.Z());
+            if (hasNormals) {
+                buffer.appendFloat(normal.X());
+                buffer.appendFloat(normal.Y());
+                buffer.appendFloat(normal.Z());
+            }
+
+            if (hasColors) {
+                buffer.appendUChar(MeshNodeColors::red(rgb));
+                buffer.appendUChar(MeshNodeColors::green(rgb));
+                buffer.appendUChar(MeshNodeColors::blue(rgb));
+            }
+        }
+        else {
+            buffer.appendNumber(pnt.X(), 9);
+            buffer.appendUChar(' ');
+            buffer.appendNumber(pnt.Y(), 9);
+            buffer.appendUChar(' ');
+            buffer.appendNumber(pnt.Z(), 9);
+            if (hasNormals) {
+                for (double coord : { normal.X(), normal.Y(), normal.Z() }) {
+                    buffer.appendUChar(' ');
+                    buffer.appendNumber(coord, 7);
+                }
+            }
+
+            if (hasColors) {
+                const uint8_t components[] = {
+                    MeshNodeColors::red(rgb), MeshNodeColors::green(rgb), MeshNodeColors::blue(rgb)
+                };
+                for (uint8_t component : components) {
+                    buffer.appendUChar(' ');
+                    buffer.appendNumber(int(component));
+                }
+            }
+
+            buffer.appendUChar('\n');
+        }
+    });
+}
+
+// Appends the records of the triangles of 'chunk' to buffer, node indices are zero-based and
+// global to element "vertex"
+void plyWriteFaceChunk(
+        Span<const PlyWriterMesh> spanMesh,
+        const PlyWriterChunk& chunk,
+        PlyWriter::Format format,
+        std::vector<char>* ptrBuffer)
+{
+    ptrBuffer->clear();
+    ptrBuffer->reserve(size_t(chunk.itemCount) * (format == PlyWriter::Format::Ascii ? 40 : 13));
+    PlyWriterBuffer buffer(ptrBuffer);
+    plyForEachChunkItem(spanMesh, chunk, plyTriangleCount, [&](const PlyWriterMesh& mesh, int iTriangle) {
+        int n1, n2, n3;
+        mesh.triangulation->Triangles().Value(iTriangle + 1).Get(n1, n2, n3);
+        if (mesh.isReversed)
+            std::swap(n2, n3);
+
+        n1 += mesh.nodeOffset - 1;
+        n2 += mesh.nodeOffset - 1;
+        n3 += mesh.nodeOffset - 1;
+        if (format == PlyWriter::Format::BinaryLittleEndian) {
+            buffer.appendUChar(3);
+            buffer.appendInt(n1);
+            buffer.appendInt(n2);
+            buffer.appendInt(n3);
+        }
+        else {
+            buffer.appendUChar('3');
+            for (int n : { n1, n2, n3 }) {
+                buffer.appendUChar(' ');
+                buffer.appendNumber(n);
+            }
+
+            buffer.appendUChar('\n');
+        }
+    });
+}
+
+} // namespace
+
+class PlyWriter::Properties : public PropertyGroup {
+    MAYO_DECLARE_TEXT_ID_FUNCTIONS(Mayo::IO::PlyWriter::Properties)
+public:
+    Properties(PropertyGroup* parentGroup)
+        : PropertyGroup(parentGroup)
+    {
+        this->targetFormat.mutableEnumeration().changeTrContext(this->textIdContext());
+        this->targetFormat.setDescription(
+                    textIdTr("Binary files are smaller and much faster to read, ASCII files are "
+                             "human-readable"));
+    }
+
+    void restoreDefaults() override {
+        const PlyWriter::Parameters params;
+        this->targetFormat.setValue(params.format);
+    }
+
+    PropertyEnum<PlyWriter::Format> targetFormat{ this, textId("targetFormat") };
+};
+
+bool PlyWriter::transfer(Span<const ApplicationItem> appItems, TaskProgress* progress)
+{
+    m_vecShape.clear();
+    m_vecMesh.clear();
+    auto fnAddMeshEntity = [=](const TDF_Label& label) {
+        auto attrPolyTri = CafUtils::findAttribute<TDataXtd_Triangulation>(label);
+        if (!attrPolyTri.IsNull() && !attrPolyTri->Get().IsNull())
+            m_vecMesh.push_back({ attrPolyTri->Get(), MeshNodeColors::get(label) });
+    };
+
+    for (const ApplicationItem& item : appItems) {
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+
+        if (item.isDocument()) {
+            for (const TDF_Label& label : item.document()->xcaf().topLevelFreeShapes())
+                m_vecShape.push_back(XCaf::shape(label));
+
+            for (int i = 0; i < item.document()->entityCount(); ++i)
+                fnAddMeshEntity(item.document()->entityLabel(i));
+        }
+        else if (item.isDocumentTreeNode()) {
+            const TDF_Label label = item.documentTreeNode().label();
+            if (XCaf::isShape(label))
+                m_vecShape.push_back(XCaf::shape(label));
+            else
+                fnAddMeshEntity(label);
+        }
+    }
+
+    return !m_vecShape.empty() || !m_vecMesh.empty();
+}
+
+bool PlyWriter::writeFile(const FilePath& filepath, TaskProgress* progress)
+{
+    AsyncFileOutputStream outs(filepath);
+    if (!outs.isOpen())
+        return false;
+
+    const bool okWrite = this->write(outs, progress);
+    return outs.close() && okWrite;
+}
+
+bool PlyWriter::writeStream(std::ostream& ostr, TaskProgress* progress)
+{
+    const bool okWrite = this->write(ostr, progress);
+    ostr.flush();
+    return okWrite && ostr.good();
+}
+
+bool PlyWriter::write(std::ostream& outs, TaskProgress* progress)
+{
+    // Gather triangulations to be written, faces not meshed are skipped
+    std::vector<PlyWriterMesh> vecMesh;
+    for (const TopoDS_Shape& shape : m_vecShape) {
+        BRepUtils::forEachFaceTriangulation(shape, [&](const BRepUtils::FaceTriangulation& faceMesh) {
+            PlyWriterMesh mesh;
+            static_cast<BRepUtils::FaceTriangulation&>(mesh) = faceMesh;
+            vecMesh.push_back(std::move(mesh));
+        });
+    }
+
+    const bool hasShapeMeshes = !vecMesh.empty();
+    for (const Mesh& mesh : m_vecMesh) {
+        if (mesh.triangulation->NbTriangles() > 0) {
+            PlyWriterMesh writerMesh;
+            writerMesh.triangulation = mesh.triangulation;
+            writerMesh.ptrVecNodeColor = &mesh.vecNodeColor;
+            vecMesh.push_back(std::move(writerMesh));
+        }
+    }
+
+    // Attributes are written only if all the triangulations provide them
+    bool hasNormals = !vecMesh.empty();
+    bool hasColors = !vecMesh.empty() && !hasShapeMeshes;
+    int64_t nodeCount = 0;
+    int64_t triangleCount = 0;
+    for (PlyWriterMesh& mesh : vecMesh) {
+        hasNormals = hasNormals && mesh.triangulation->HasNormals();
+        hasColors = hasColors
+                && mesh.ptrVecNodeColor
+                && int(mesh.ptrVecNodeColor->size()) == mesh.triangulation->NbNodes();
+        mesh.nodeOffset = int(std::min<int64_t>(nodeCount, std::numeric_limits<int>::max()));
+        nodeCount += mesh.triangulation->NbNodes();
+        triangleCount += mesh.triangulation->NbTriangles();
+    }
+
+    if (nodeCount > std::numeric_limits<int>::max() || triangleCount > std::numeric_limits<int>::max())
+        return false; // Node indices are written as 32bit integers
+
+    // Header
+    outs << "ply\n";
+    outs << (m_params.format == Format::Ascii ? "format ascii 1.0\n" : "format binary_little_endian 1.0\n");
+    outs << "comment Exported by Mayo\n";
+    outs << "element vertex " << nodeCount << "\n";
+    outs << "property float x\nproperty float y\nproperty float z\n";
+    if (hasNormals)
+        outs << "property float nx\nproperty float ny\nproperty float nz\n";
+
+    if (hasColors)
+        outs << "property uchar red\nproperty uchar green\nproperty uchar blue\n";
+
+    outs << "element face " << triangleCount << "\n";
+    outs << "property list uchar int vertex_indices\n";
+    outs << "end_header\n";
+
+    // Serialize batches of chunks in parallel, then write them in order with one pass
+    const Span<const PlyWriterMesh> spanMesh = vecMesh;
+    const std::vector<PlyWriterChunk> vecVertexChunk = plyWriterChunks(spanMesh, plyNodeCount);
+    const std::vector<PlyWriterChunk> vecFaceChunk = plyWriterChunks(spanMesh, plyTriangleCount);
+    const int totalChunkCount = std::max(int(vecVertexChunk.size() + vecFaceChunk.size()), 1);
+    const int threadCount = std::max(int(std::thread::hardware_concurrency()), 1);
+    const int batchSize = 2 * threadCount;
+    std::vector<std::vector<char>> vecBuffer(batchSize);
+    int doneChunkCount = 0;
+    auto fnWriteChunks = [&](const std::vector<PlyWriterChunk>& vecChunk, auto fnSerializeChunk) {
+        const int chunkCount = int(vecChunk.size());
+        for (int iBatch = 0; iBatch < chunkCount && outs; iBatch += batchSize) {
+            if (TaskProgress::isAbortRequested(progress))
+                return false;
+
+            const int batchChunkCount = std::min(batchSize, chunkCount - iBatch);
+            CppUtils::parallelFor(batchChunkCount, [&](int i) {
+                fnSerializeChunk(vecChunk.at(iBatch + i), &vecBuffer.at(i));
+            });
+            for (int i = 0; i < batchChunkCount && outs; ++i)
+                outs.write(vecBuffer.at(i).data(), vecBuffer.at(i).size());
+
+            doneChunkCount += batchChunkCount;
+            if (progress)
+                progress->setValue((doneChunkCount * 100) / totalChunkCount);
+        }
+
+        return bool(outs);
+    };
+
+    const bool okVertices = fnWriteChunks(vecVertexChunk, [&](const PlyWriterChunk& chunk, std::vector<char>* buffer) {
+        plyWriteVertexChunk(spanMesh, chunk, m_params.format, hasNormals, hasColors, buffer);
+    });
+    if (!okVertices)
+        return false;
+
+    const bool okFaces = fnWriteChunks(vecFaceChunk, [&](const PlyWriterChunk& chunk, std::vector<char>* buffer) {
+        plyWriteFaceChunk(spanMesh, chunk, m_params.format, buffer);
+    });
+    return okFaces && outs.good();
+}
+
+std::unique_ptr<PropertyGroup> PlyWriter::createProperties(PropertyGroup* parentGroup)
+{
+    return std::make_unique<Properties>(parentGroup);
+}
+
+void PlyWriter::applyProperties(const PropertyGroup* params)
+{
+    auto ptr = dynamic_cast<const Properties*>(params);
+    if (ptr)
+        m_params.format = ptr->targetFormat;
+}
+
+} // namespace IO
+} // namespace Mayo
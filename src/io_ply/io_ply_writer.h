@@ -0,0 +1,57 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/io_writer.h"
+#include <Poly_Triangulation.hxx>
+#include <TopoDS_Shape.hxx>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Mayo {
+namespace IO {
+
+// Native writer for PLY(Polygon File Format), ASCII or binary little-endian
+// Triangulations of the shapes and meshes are merged in single "vertex" and "face" elements.
+// Normals are written if all the triangulations have normals at nodes, colors if all of them are
+// meshes with node colors(see MeshNodeColors)
+// Vertices and faces are serialized concurrently by chunks, chunks are then written in order
+class PlyWriter : public Writer {
+public:
+    bool transfer(Span<const ApplicationItem> appItems, TaskProgress* progress) override;
+    bool writeFile(const FilePath& filepath, TaskProgress* progress) override;
+    bool writeStream(std::ostream& ostr, TaskProgress* progress) override;
+
+    static std::unique_ptr<PropertyGroup> createProperties(PropertyGroup* parentGroup);
+    void applyProperties(const PropertyGroup* params) override;
+
+    // Parameters
+    enum class Format { Ascii, BinaryLittleEndian };
+
+    struct Parameters {
+        Format format = Format::BinaryLittleEndian;
+    };
+    Parameters& parameters() { return m_params; }
+    const Parameters& constParameters() const { return m_params; }
+
+private:
+    bool write(std::ostream& outs, TaskProgress* progress);
+
+    struct Mesh {
+        Handle_Poly_Triangulation triangulation;
+        std::vector<uint32_t> vecNodeColor; // Empty if none
+    };
+
+    class Properties;
+    Parameters m_params;
+    std::vector<TopoDS_Shape> m_vecShape;
+    std::vector<Mesh> m_vecMesh;
+};
+
+} // namespace IO
+} // namespace Mayo
@@ -0,0 +1,34 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_point_cloud.h"
+
+#include "io_point_cloud_reader.h"
+
+namespace Mayo {
+namespace IO {
+
+Span<const Format> PointCloudFactoryReader::formats() const
+{
+    static const Format array[] = { Format_XYZ, Format_PTS, Format_LAS };
+    return array;
+}
+
+std::unique_ptr<Reader> PointCloudFactoryReader::create(const Format& format) const
+{
+    if (format == Format_XYZ || format == Format_PTS || format == Format_LAS)
+        return std::make_unique<PointCloudReader>(format);
+
+    return {};
+}
+
+std::unique_ptr<PropertyGroup> PointCloudFactoryReader::createProperties(const Format&, PropertyGroup*) const
+{
+    return {};
+}
+
+} // namespace IO
+} // namespace Mayo
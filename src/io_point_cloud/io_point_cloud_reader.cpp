@@ -0,0 +1,414 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "io_point_cloud_reader.h"
+
+#include "../base/caf_utils.h"
+#include "../base/cpp_utils.h"
+#include "../base/document.h"
+#include "../base/task_progress.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QtEndian>
+#include <fast_float/fast_float.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <thread>
+
+namespace Mayo {
+namespace IO {
+
+namespace {
+
+// Size of the blocks of bytes read from the file
+constexpr qint64 PointCloudBlockSize = 32 * 1024 * 1024;
+
+// Points decoded from a chunk of block
+struct PointCloudChunk {
+    std::vector<gp_Pnt> vecPnt;
+    std::vector<uint32_t> vecRgb; // Empty if no colors
+};
+
+int pointCloudChunkCount()
+{
+    return 4 * std::max(int(std::thread::hardware_concurrency()), 1);
+}
+
+uint32_t pointCloudPackRgb(double r, double g, double b)
+{
+    auto fnComponent = [](double c) { return uint32_t(std::clamp(c, 0., 255.)); };
+    return (fnComponent(r) << 16) | (fnComponent(g) << 8) | fnComponent(b);
+}
+
+// Inserts the points of 'vecChunk' in 'cloud', in the order of the chunks so the octree doesn't
+// depend on threads scheduling
+void pointCloudAddChunks(PointCloud* cloud, const std::vector<PointCloudChunk>& vecChunk)
+{
+    for (const PointCloudChunk& chunk : vecChunk)
+        cloud->addPoints(chunk.vecPnt, chunk.vecRgb);
+}
+
+// --
+// -- ASCII(XYZ, PTS)
+// --
+
+bool asciiIsSeparator(char c)
+{
+    return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r';
+}
+
+// Parses the leading numbers of line [it, itEnd) into 'fields', stops at the first item not
+// being a number. Returns the count of numbers parsed
+int asciiParseFields(const char* it, const char* itEnd, double* fields, int maxCount)
+{
+    int count = 0;
+    while (count < maxCount) {
+        while (it < itEnd && asciiIsSeparator(*it))
+            ++it;
+
+        if (it >= itEnd)
+            break;
+
+        const fast_float::from_chars_result res = fast_float::from_chars(it, itEnd, fields[count]);
+        if (res.ec != std::errc())
+            break;
+
+        it = res.ptr;
+        ++count;
+    }
+
+    return count;
+}
+
+constexpr int AsciiMaxFieldCount = 8;
+
+// Index of the first color field in the lines, -1 if none
+int asciiDetectRgbField(const char* data, const char* dataEnd)
+{
+    auto fnIsColorComponent = [](double v) {
+        return v >= 0 && v <= 255 && std::floor(v) == v;
+    };
+    auto fnIsRgb = [&](const double* fields) {
+        return fnIsColorComponent(fields[0]) && fnIsColorComponent(fields[1]) && fnIsColorComponent(fields[2]);
+    };
+
+    const char* itLine = data;
+    while (itLine < dataEnd) {
+        const char* itLineEnd = std::find(itLine, dataEnd, '\n');
+        double fields[AsciiMaxFieldCount] = {};
+        const int count = asciiParseFields(itLine, itLineEnd, fields, AsciiMaxFieldCount);
+        if (count >= 3) {
+            if (count >= 7 && fnIsRgb(fields + 4))
+                return 4; // x y z intensity r g b
+            else if (count >= 6 && fnIsRgb(fields + 3))
+                return 3; // x y z r g b
+            else
+                return -1;
+        }
+
+        itLine = itLineEnd < dataEnd ? itLineEnd + 1 : dataEnd;
+    }
+
+    return -1;
+}
+
+void asciiParseChunk(const char* it, const char* itEnd, int rgbField, PointCloudChunk* chunk)
+{
+    const int fieldCount = rgbField >= 0 ? rgbField + 3 : 3;
+    while (it < itEnd) {
+        const char* itLineEnd = std::find(it, itEnd, '\n');
+        double fields[AsciiMaxFieldCount] = {};
+        const int count = asciiParseFields(it, itLineEnd, fields, fieldCount);
+        if (count >= 3) {
+            chunk->vecPnt.emplace_back(fields[0], fields[1], fields[2]);
+            if (rgbField >= 0) {
+                const double* rgb = fields + rgbField;
+                // Lines with missing color fields are given white color
+                chunk->vecRgb.push_back(count >= fieldCount ? pointCloudPackRgb(rgb[0], rgb[1], rgb[2]) : 0xFFFFFF);
+            }
+        }
+
+        it = itLineEnd < itEnd ? itLineEnd + 1 : itEnd;
+    }
+}
+
+bool readAscii(QFile* file, PointCloud* cloud, TaskProgress* progress)
+{
+    const qint64 fileSize = file->size();
+    QByteArray block;
+    QByteArray blockTail; // Incomplete last line of previous block
+    int rgbField = -2; // Not detected yet
+    while (!file->atEnd()) {
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+
+        block = blockTail + file->read(PointCloudBlockSize);
+        blockTail.clear();
+        if (!file->atEnd()) {
+            const int posLastLineEnd = block.lastIndexOf('\n');
+            if (posLastLineEnd >= 0) {
+                blockTail = block.mid(posLastLineEnd + 1);
+                block.truncate(posLastLineEnd + 1);
+            }
+        }
+
+        const char* data = block.constData();
+        const char* dataEnd = data + block.size();
+        if (rgbField == -2)
+            rgbField = asciiDetectRgbField(data, dataEnd);
+
+        // Split block in chunks of complete lines
+        const int chunkCount = pointCloudChunkCount();
+        std::vector<const char*> vecChunkBegin;
+        vecChunkBegin.push_back(data);
+        for (int i = 1; i < chunkCount; ++i) {
+            const char* it = std::max(data + (block.size() * qint64(i)) / chunkCount, vecChunkBegin.back());
+            it = std::find(it, dataEnd, '\n');
+            vecChunkBegin.push_back(it != dataEnd ? it + 1 : dataEnd);
+        }
+
+        vecChunkBegin.push_back(dataEnd);
+        std::vector<PointCloudChunk> vecChunk(chunkCount);
+        CppUtils::parallelFor(chunkCount, [&](int i) {
+            asciiParseChunk(vecChunkBegin.at(i), vecChunkBegin.at(i + 1), rgbField, &vecChunk.at(i));
+        });
+
+        pointCloudAddChunks(cloud, vecChunk);
+        if (progress && fileSize > 0)
+            progress->setValue(int((100 * file->pos()) / fileSize));
+    }
+
+    return true;
+}
+
+// --
+// -- LAS
+// --
+
+template<typename T> T lasValue(const uchar* data, int offset)
+{
+    return qFromLittleEndian<T>(data + offset);
+}
+
+double lasDouble(const uchar* data, int offset)
+{
+    const uint64_t bits = qFromLittleEndian<quint64>(data + offset);
+    double value;
+    std::memcpy(&value, &bits, sizeof(double));
+    return value;
+}
+
+// Offset of the RGB fields in point records of format 'recordFormat', -1 if none
+int lasRgbOffset(int recordFormat)
+{
+    switch (recordFormat) {
+    case 2: return 20;
+    case 3: case 5: return 28;
+    case 7: case 8: case 10: return 30;
+    default: return -1;
+    }
+}
+
+// Size of point records of format 'recordFormat' defined by the LAS specification
+int lasMinRecordLength(int recordFormat)
+{
+    static const int sizes[] = { 20, 28, 26, 34, 57, 63, 30, 36, 38, 59, 67 };
+    return recordFormat >= 0 && recordFormat < int(std::size(sizes)) ? sizes[recordFormat] : -1;
+}
+
+struct LasHeader {
+    uint32_t pointDataOffset = 0;
+    int recordFormat = -1;
+    int recordLength = 0;
+    uint64_t pointCount = 0;
+    double scale[3] = {};
+    double offset[3] = {};
+    Bnd_Box bndBox;
+};
+
+bool lasReadHeader(QFile* file, LasHeader* header)
+{
+    // LAS 1.0 .. 1.3 header is 227 bytes, 375 bytes for LAS 1.4
+    const QByteArray bytes = file->read(375);
+    if (bytes.size() < 227 || !bytes.startsWith("LASF"))
+        return false;
+
+    auto data = reinterpret_cast<const uchar*>(bytes.constData());
+    const int versionMinor = data[25];
+    const int recordFormatByte = data[104];
+    if (recordFormatByte & 0xC0)
+        return false; // Compressed records(LAZ), not supported
+
+    header->pointDataOffset = lasValue<quint32>(data, 96);
+    header->recordFormat = recordFormatByte & 0x3F;
+    header->recordLength = lasValue<quint16>(data, 105);
+    header->pointCount = lasValue<quint32>(data, 107);
+    if (header->pointCount == 0 && versionMinor >= 4 && bytes.size() >= 255)
+        header->pointCount = lasValue<quint64>(data, 247);
+
+    for (int i = 0; i < 3; ++i) {
+        header->scale[i] = lasDouble(data, 131 + 8 * i);
+        header->offset[i] = lasDouble(data, 155 + 8 * i);
+    }
+
+    const gp_Pnt pntMax(lasDouble(data, 179), lasDouble(data, 195), lasDouble(data, 211));
+    const gp_Pnt pntMin(lasDouble(data, 187), lasDouble(data, 203), lasDouble(data, 219));
+    if (pntMin.X() <= pntMax.X() && pntMin.Y() <= pntMax.Y() && pntMin.Z() <= pntMax.Z()) {
+        header->bndBox.Add(pntMin);
+        header->bndBox.Add(pntMax);
+    }
+
+    const int minRecordLength = lasMinRecordLength(header->recordFormat);
+    return minRecordLength > 0 && header->recordLength >= minRecordLength;
+}
+
+// Decodes 'recordCount' records starting at 'data'. Colors are stored with 16 bits components in
+// 'vecRgb16', see lasPackRgb()
+void lasDecodeChunk(
+        const uchar* data,
+        int recordCount,
+        const LasHeader& header,
+        PointCloudChunk* chunk,
+        std::vector<uint64_t>* vecRgb16)
+{
+    const int rgbOffset = lasRgbOffset(header.recordFormat);
+    chunk->vecPnt.resize(recordCount);
+    if (rgbOffset >= 0)
+        vecRgb16->resize(recordCount);
+
+    for (int i = 0; i < recordCount; ++i) {
+        const uchar* record = data + size_t(i) * header.recordLength;
+        chunk->vecPnt[i].SetCoord(
+                    lasValue<qint32>(record, 0) * header.scale[0] + header.offset[0],
+                    lasValue<qint32>(record, 4) * header.scale[1] + header.offset[1],
+                    lasValue<qint32>(record, 8) * header.scale[2] + header.offset[2]);
+        if (rgbOffset >= 0) {
+            const uint64_t r = lasValue<quint16>(record, rgbOffset);
+            const uint64_t g = lasValue<quint16>(record, rgbOffset + 2);
+            const uint64_t b = lasValue<quint16>(record, rgbOffset + 4);
+            (*vecRgb16)[i] = (r << 32) | (g << 16) | b;
+        }
+    }
+}
+
+bool lasHasRgb16(const std::vector<uint64_t>& vecRgb16)
+{
+    return std::any_of(vecRgb16.cbegin(), vecRgb16.cend(), [](uint64_t rgb16) {
+        return (rgb16 & 0xFF00FF00FF00) != 0;
+    });
+}
+
+// Components are either 8 or 16 bits(specification asks for 16 bits, but both are found), which
+// is given by 'isRgb16'
+void lasPackRgb(const std::vector<uint64_t>& vecRgb16, bool isRgb16, std::vector<uint32_t>* vecRgb)
+{
+    const int shift = isRgb16 ? 8 : 0;
+    vecRgb->resize(vecRgb16.size());
+    for (size_t i = 0; i < vecRgb16.size(); ++i) {
+        const uint64_t rgb16 = vecRgb16[i];
+        const uint32_t r = uint32_t(rgb16 >> (32 + shift)) & 0xFF;
+        const uint32_t g = uint32_t(rgb16 >> (16 + shift)) & 0xFF;
+        const uint32_t b = uint32_t(rgb16 >> shift) & 0xFF;
+        (*vecRgb)[i] = (r << 16) | (g << 8) | b;
+    }
+}
+
+bool readLas(QFile* file, PointCloud* cloud, TaskProgress* progress)
+{
+    LasHeader header;
+    if (!lasReadHeader(file, &header) || !file->seek(header.pointDataOffset))
+        return false;
+
+    cloud->setBoundsHint(header.bndBox);
+    const uint64_t blockRecordCount = std::max<uint64_t>(PointCloudBlockSize / header.recordLength, 1);
+    uint64_t recordDoneCount = 0;
+    bool isRgb16 = false; // Sticky, so all the points are given the same conversion
+    QByteArray block;
+    while (recordDoneCount < header.pointCount) {
+        if (TaskProgress::isAbortRequested(progress))
+            return false;
+
+        const uint64_t recordCount = std::min(blockRecordCount, header.pointCount - recordDoneCount);
+        block = file->read(qint64(recordCount * header.recordLength));
+        const int blockRecordReadCount = int(block.size() / header.recordLength);
+        if (blockRecordReadCount == 0)
+            break; // Truncated file, points read so far are kept
+
+        const int chunkCount = std::min(pointCloudChunkCount(), blockRecordReadCount);
+        std::vector<PointCloudChunk> vecChunk(chunkCount);
+        std::vector<std::vector<uint64_t>> vecChunkRgb16(chunkCount);
+        auto data = reinterpret_cast<const uchar*>(block.constData());
+        CppUtils::parallelFor(chunkCount, [&](int i) {
+            const int iRecordBegin = int((int64_t(blockRecordReadCount) * i) / chunkCount);
+            const int iRecordEnd = int((int64_t(blockRecordReadCount) * (i + 1)) / chunkCount);
+            lasDecodeChunk(
+                        data + size_t(iRecordBegin) * header.recordLength,
+                        iRecordEnd - iRecordBegin,
+                        header,
+                        &vecChunk.at(i),
+                        &vecChunkRgb16.at(i));
+        });
+
+        for (const std::vector<uint64_t>& vecRgb16 : vecChunkRgb16)
+            isRgb16 = isRgb16 || lasHasRgb16(vecRgb16);
+
+        CppUtils::parallelFor(chunkCount, [&](int i) {
+            lasPackRgb(vecChunkRgb16.at(i), isRgb16, &vecChunk.at(i).vecRgb);
+        });
+
+        pointCloudAddChunks(cloud, vecChunk);
+        recordDoneCount += blockRecordReadCount;
+        if (progress)
+            progress->setValue(int((100 * recordDoneCount) / header.pointCount));
+
+        if (uint64_t(blockRecordReadCount) < recordCount)
+            break;
+    }
+
+    return true;
+}
+
+} // namespace
+
+PointCloudReader::PointCloudReader(const Format& format)
+    : m_format(format)
+{
+}
+
+bool PointCloudReader::readFile(const FilePath& filepath, TaskProgress* progress)
+{
+    m_cloud.reset();
+    m_baseFilename = filepath.stem();
+    QFile file(filepathTo<QString>(filepath));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    auto cloud = std::make_shared<PointCloud>(m_cloudOptions);
+    const bool ok = m_format == Format_LAS ? readLas(&file, cloud.get(), progress) : readAscii(&file, cloud.get(), progress);
+    if (!ok || cloud->pointCount() == 0)
+        return false;
+
+    cloud->finishBuild();
+    m_cloud = std::move(cloud);
+    return true;
+}
+
+TDF_LabelSequence PointCloudReader::transfer(DocumentPtr doc, TaskProgress* progress)
+{
+    if (!m_cloud || TaskProgress::isAbortRequested(progress))
+        return {};
+
+    const TDF_Label entityLabel = doc->newEntityLabel();
+    PointCloudAttribute::Set(entityLabel, m_cloud);
+    CafUtils::setLabelAttrStdName(entityLabel, filepathTo<QString>(m_baseFilename));
+    return CafUtils::makeLabelSequence({ entityLabel });
+}
+
+} // namespace IO
+} // namespace Mayo
@@ -0,0 +1,39 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include "../base/io_reader.h"
+#include "../base/point_cloud.h"
+
+namespace Mayo {
+namespace IO {
+
+// Native reader for point cloud files: XYZ, PTS(ASCII) and LAS(binary, uncompressed)
+// Files are streamed by blocks inserted in a PointCloud octree, so the whole contents never has
+// to be in memory. Lines of an ASCII block, records of a LAS block, are decoded concurrently
+// ASCII lines are "x y z", optionally followed by "r g b" or "intensity r g b", lines that aren't
+// starting with three numbers are skipped(eg point counts of PTS files, headers, comments)
+class PointCloudReader : public Reader {
+public:
+    PointCloudReader(const Format& format);
+
+    bool readFile(const FilePath& filepath, TaskProgress* progress) override;
+    TDF_LabelSequence transfer(DocumentPtr doc, TaskProgress* progress) override;
+
+    // Options of the octree built by readFile()
+    const PointCloud::Options& cloudOptions() const { return m_cloudOptions; }
+    void setCloudOptions(const PointCloud::Options& options) { m_cloudOptions = options; }
+
+private:
+    Format m_format;
+    PointCloud::Options m_cloudOptions;
+    PointCloudPtr m_cloud;
+    FilePath m_baseFilename;
+};
+
+} // namespace IO
+} // namespace Mayo
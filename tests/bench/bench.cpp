@@ -0,0 +1,921 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "bench.h"
+#include "../../src/base/application.h"
+#include "../../src/base/application_item.h"
+#include "../../src/base/bnd_utils.h"
+#include "../../src/base/brep_utils.h"
+#include "../../src/base/cpp_utils.h"
+#include "../../src/base/document.h"
+#include "../../src/base/filepath.h"
+#include "../../src/base/global.h"
+#include "../../src/base/io_system.h"
+#include "../../src/base/libtree.h"
+#include "../../src/base/memory_stats.h"
+#include "../../src/base/string_utils.h"
+#include "../../src/base/task_progress.h"
+#include "../../src/base/unit_system.h"
+#include "../../src/base/xcaf.h"
+#include "../../src/graphics/graphics_object_driver.h"
+#include "../../src/graphics/graphics_tree_node_mapping_driver.h"
+#include "../../src/gui/gui_application.h"
+#include "../../src/gui/gui_document.h"
+#include "../../src/io_gmio/io_gmio.h"
+#include "../../src/io_gmio/io_gmio_stl.h"
+#include "../../src/io_occ/io_occ.h"
+#include "../../src/io_occ/io_occ_stl.h"
+
+#include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <BRepBndLib.hxx>
+#include <BRepBuilderAPI_MakeFace.hxx>
+#include <BRepTools.hxx>
+#include <Geom_SphericalSurface.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Precision.hxx>
+#include <Standard_Version.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopoDS_Shell.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryDir>
+#include <gsl/util>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <locale>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Mayo {
+
+namespace {
+
+struct ProbeFunction {
+    const char* name;
+    IO::Format (*fn)(const IO::System::FormatProbeInput&);
+};
+
+const ProbeFunction predefinedProbes[] = {
+    { "STEP", IO::probeFormat_STEP },
+    { "IGES", IO::probeFormat_IGES },
+    { "OCCBREP", IO::probeFormat_OCCBREP },
+    { "STL", IO::probeFormat_STL },
+    { "OBJ", IO::probeFormat_OBJ }
+};
+
+// Same settings as IO::System::probeFormat(), but contents come from memory
+IO::System::FormatProbeInput createProbeInput(const QByteArray& contents, qint64 fileSize)
+{
+    IO::System::FormatProbeInput input = {};
+    input.filepath = "bench";
+    input.contentsWindow = contents.left(int(IO::System::ProbeWindowSize));
+    input.contentsBegin = contents.left(int(IO::System::ProbeExcerptSize));
+    input.contentsBegin.append(int(IO::System::ProbeExcerptSize) - input.contentsBegin.size(), '\0');
+    input.hintFullSize = uint64_t(fileSize);
+    return input;
+}
+
+// Inputs crafted to drive probes into their worst paths
+std::vector<std::pair<QString, QByteArray>> adversarialInputs()
+{
+    const int size = int(IO::System::ProbeExcerptSize);
+    return {
+        { "empty", QByteArray() },
+        { "zeros", QByteArray(size, '\0') },
+        { "bytes_ff", QByteArray(size, '\xff') },
+        { "spaces", QByteArray(size, ' ') },
+        { "newlines", QByteArray(size, '\n') },
+        { "long_line", QByteArray(size, 'v') },
+        { "obj_no_number", QByteArray("v \n").repeated(size / 3) },
+        { "obj_late_vertex", QByteArray("# comment\n").repeated(size / 10 - 2) + "v 1.0 2.0 3.0\n" },
+        { "step_no_header", QByteArray("ISO-10303-21") + QByteArray(size, ' ') },
+        { "stl_solid_spaces", QByteArray(size - 5, ' ') + "solid" }
+    };
+}
+
+// --
+// -- Synthetic models
+// --
+
+// Assembly of 'depth' levels, whose components of the last level are instances of 'partCount'
+// distinct parts, each part being a shell of 'faceCount' spherical faces
+struct SyntheticModelSpec {
+    int partCount;
+    int depth;
+    int faceCount;
+};
+
+const SyntheticModelSpec syntheticModelSpecs[] = {
+    { 10, 2, 24 },
+    { 50, 3, 96 },
+    { 200, 4, 24 }
+};
+
+QString toString(const SyntheticModelSpec& spec)
+{
+    return QString("n%1_d%2_f%3").arg(spec.partCount).arg(spec.depth).arg(spec.faceCount);
+}
+
+// Faces don't share any edge, so they can be meshed concurrently
+TopoDS_Shape createSyntheticPart(int partIndex, int faceCount)
+{
+    const double radius = 10. + partIndex;
+    const double uStep = UnitSystem::radians(360 * Quantity_Degree) / faceCount;
+    const double vMax = UnitSystem::radians(80 * Quantity_Degree); // Avoid degenerated edges at poles
+    Handle_Geom_SphericalSurface sphere = new Geom_SphericalSurface(gp::XOY(), radius);
+    BRep_Builder builder;
+    TopoDS_Shell shell;
+    builder.MakeShell(shell);
+    for (int i = 0; i < faceCount; ++i) {
+        BRepBuilderAPI_MakeFace makeFace(sphere, i * uStep, (i + 1) * uStep, -vMax, vMax, Precision::Confusion());
+        builder.Add(shell, makeFace.Face());
+    }
+
+    return shell;
+}
+
+// Nested compounds, converted to an XCAF assembly by XCAFDoc_ShapeTool::AddShape()
+// The count of components per assembly is the smallest one providing at least 'partCount' leaves
+TopoDS_Shape createSyntheticShape(const SyntheticModelSpec& spec)
+{
+    std::vector<TopoDS_Shape> vecPart;
+    for (int i = 0; i < spec.partCount; ++i)
+        vecPart.push_back(createSyntheticPart(i, spec.faceCount));
+
+    const int branchCount = std::max(2, int(std::ceil(std::pow(spec.partCount, 1. / spec.depth))));
+    const double partSize = 2 * (10. + spec.partCount);
+    BRep_Builder builder;
+    int leafIndex = 0;
+    std::function<TopoDS_Shape(int)> fnCreateAssembly = [&](int level) -> TopoDS_Shape {
+        TopoDS_Compound comp;
+        builder.MakeCompound(comp);
+        const double spacing = partSize * std::pow(branchCount, (spec.depth - level - 1) / 3);
+        for (int i = 0; i < branchCount; ++i) {
+            const bool isLastLevel = level + 1 == spec.depth;
+            const TopoDS_Shape child =
+                    isLastLevel ? vecPart.at(leafIndex++ % vecPart.size()) : fnCreateAssembly(level + 1);
+            gp_Vec vecTranslation;
+            vecTranslation.SetCoord((level % 3) + 1, i * spacing);
+            gp_Trsf trsf;
+            trsf.SetTranslation(vecTranslation);
+            builder.Add(comp, child.Located(TopLoc_Location(trsf)));
+        }
+
+        return comp;
+    };
+
+    return fnCreateAssembly(0);
+}
+
+// Mirrors the presets of AppModule::BRepMeshQuality
+struct MeshQuality {
+    const char* name;
+    double chordalDeflectionCoeff;
+    double angularDeflectionCoeff;
+};
+
+const MeshQuality meshQualities[] = {
+    { "VeryCoarse", 8, 4 },
+    { "Coarse", 4, 2 },
+    { "Normal", 1, 1 },
+    { "Precise", 1/4., 1/2. },
+    { "VeryPrecise", 1/8., 1/4. }
+};
+
+// Same as AppModule::brepMeshParameters(), for a given meshing quality
+OccBRepMeshParameters meshParameters(const TopoDS_Shape& shape, const MeshQuality& quality)
+{
+    Bnd_Box bndBox;
+    BRepBndLib::Add(shape, bndBox, false);
+    const auto coords = BndBoxCoords::get(bndBox);
+    const gp_XYZ diag = coords.maxVertex().XYZ() - coords.minVertex().XYZ();
+    const double diagMaxComp = std::max({ diag.X(), diag.Y(), diag.Z() });
+    const QuantityLength shapeDeflection = 4 * diagMaxComp * Quantity_Millimeter;
+
+    OccBRepMeshParameters params;
+    params.InParallel = true;
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 5, 0)
+    params.AllowQualityDecrease = true;
+#endif
+    params.Deflection = UnitSystem::meters(quality.chordalDeflectionCoeff * shapeDeflection);
+    params.Angle = UnitSystem::radians(quality.angularDeflectionCoeff * (20 * Quantity_Degree));
+    return params;
+}
+
+// Count of triangles over all the face instances of 'shape'
+int64_t triangleCount(const TopoDS_Shape& shape)
+{
+    int64_t count = 0;
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        if (!triangulation.IsNull())
+            count += triangulation->NbTriangles();
+    });
+    return count;
+}
+
+std::map<int, DocumentPtr>& syntheticDocuments()
+{
+    static std::map<int, DocumentPtr> mapDocument;
+    return mapDocument;
+}
+
+// Documents are created once per model spec and meshed with "Normal" quality, so mesh-based
+// writers(STL, glTF, ...) have something to export
+DocumentPtr syntheticDocument(int specIndex)
+{
+    std::map<int, DocumentPtr>& mapDocument = syntheticDocuments();
+    auto it = mapDocument.find(specIndex);
+    if (it != mapDocument.end())
+        return it->second;
+
+    const TopoDS_Shape shape = createSyntheticShape(syntheticModelSpecs[specIndex]);
+    BRepUtils::computeMesh(shape, meshParameters(shape, meshQualities[2]));
+    DocumentPtr doc = Application::instance()->newDocument();
+    doc->setName(toString(syntheticModelSpecs[specIndex]));
+    const TDF_Label labelRoot = doc->xcaf().shapeTool()->AddShape(shape, true/*makeAssembly*/);
+    doc->xcaf().shapeTool()->UpdateAssemblies();
+    doc->addEntityTreeNode(labelRoot);
+    mapDocument.insert({ specIndex, doc });
+    return doc;
+}
+
+// There is no OBJ writer in OpenCascade, so OBJ inputs are written here from face triangulations
+bool writeObjFile(const TopoDS_Shape& shape, const FilePath& filepath)
+{
+    std::ofstream fstr(filepath, std::ios::out | std::ios::binary);
+    fstr.imbue(std::locale::classic());
+    int nodeOffset = 1;
+    BRepUtils::forEachSubFace(shape, [&](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        if (triangulation.IsNull())
+            return;
+
+        const gp_Trsf& trsf = loc.Transformation();
+        const TColgp_Array1OfPnt& vecNode = triangulation->Nodes();
+        for (int i = vecNode.Lower(); i <= vecNode.Upper(); ++i) {
+            const gp_Pnt pnt = vecNode(i).Transformed(trsf);
+            fstr << "v " << pnt.X() << ' ' << pnt.Y() << ' ' << pnt.Z() << '\n';
+        }
+
+        const Poly_Array1OfTriangle& vecTriangle = triangulation->Triangles();
+        for (int i = vecTriangle.Lower(); i <= vecTriangle.Upper(); ++i) {
+            int n1, n2, n3;
+            vecTriangle(i).Get(n1, n2, n3);
+            const int offset = nodeOffset - vecNode.Lower();
+            fstr << "f " << n1 + offset << ' ' << n2 + offset << ' ' << n3 + offset << '\n';
+        }
+
+        nodeOffset += triangulation->NbNodes();
+    });
+    return fstr.good();
+}
+
+// Face carrying a bare grid triangulation of at least 'facetCount' triangles, rows of 500 quads
+TopoDS_Face createGridMeshFace(int facetCount)
+{
+    const int quadCountX = 500;
+    const int quadCountY = std::max((facetCount + 2 * quadCountX - 1) / (2 * quadCountX), 1);
+    const int nodeCountX = quadCountX + 1;
+    Handle_Poly_Triangulation mesh =
+            new Poly_Triangulation(nodeCountX * (quadCountY + 1), 2 * quadCountX * quadCountY, false);
+    for (int j = 0; j <= quadCountY; ++j) {
+        for (int i = 0; i < nodeCountX; ++i)
+            mesh->ChangeNode(1 + i + j * nodeCountX) = gp_Pnt(i, j, 0.01 * ((i * 7 + j * 13) % 17));
+    }
+
+    int iTriangle = 1;
+    for (int j = 0; j < quadCountY; ++j) {
+        for (int i = 0; i < quadCountX; ++i) {
+            const int n = 1 + i + j * nodeCountX;
+            mesh->ChangeTriangle(iTriangle++) = Poly_Triangle(n, n + 1, n + 1 + nodeCountX);
+            mesh->ChangeTriangle(iTriangle++) = Poly_Triangle(n, n + 1 + nodeCountX, n + nodeCountX);
+        }
+    }
+
+    TopoDS_Face face;
+    BRep_Builder().MakeFace(face, mesh);
+    return face;
+}
+
+// --
+// -- IO factories
+// --
+
+struct NamedFactoryReader {
+    QString name;
+    std::unique_ptr<IO::FactoryReader> factory;
+};
+
+struct NamedFactoryWriter {
+    QString name;
+    std::unique_ptr<IO::FactoryWriter> factory;
+};
+
+std::vector<NamedFactoryReader>& readerFactories()
+{
+    static std::vector<NamedFactoryReader> vec;
+    return vec;
+}
+
+std::vector<NamedFactoryWriter>& writerFactories()
+{
+    static std::vector<NamedFactoryWriter> vec;
+    return vec;
+}
+
+QTemporaryDir& benchTempDir()
+{
+    static QTemporaryDir tempDir;
+    return tempDir;
+}
+
+// Input file of the read benchmarks, written once per format and model spec with the OpenCascade
+// writers
+FilePath syntheticInputFile(const IO::Format& format, int specIndex)
+{
+    const QString fileName = toString(syntheticModelSpecs[specIndex]) + "." + format.fileSuffixes.front();
+    const QString filepath = benchTempDir().filePath(fileName);
+    if (QFileInfo::exists(filepath))
+        return filepathFrom(filepath);
+
+    const DocumentPtr doc = syntheticDocument(specIndex);
+    if (format == IO::Format_OBJ) {
+        writeObjFile(XCaf::shape(doc->entityLabel(0)), filepathFrom(filepath));
+        return filepathFrom(filepath);
+    }
+
+    for (const NamedFactoryWriter& writerFactory : writerFactories()) {
+        std::unique_ptr<IO::Writer> writer = writerFactory.factory->create(format);
+        if (writer) {
+            TaskProgress progress;
+            const ApplicationItem appItem(doc);
+            if (writer->transfer(Span<const ApplicationItem>(&appItem, 1), &progress))
+                writer->writeFile(filepathFrom(filepath), &progress);
+
+            break;
+        }
+    }
+
+    return filepathFrom(filepath);
+}
+
+// --
+// -- JSON report
+// --
+
+// Durations of the iterations of a benchmark row, along with other measures(eg triangle count)
+struct BenchRecord {
+    std::string benchmark;
+    std::string row;
+    std::vector<double> vecDurationMs;
+    std::vector<std::pair<std::string, int64_t>> vecMetric;
+};
+
+std::vector<BenchRecord>& benchRecords()
+{
+    static std::vector<BenchRecord> vec;
+    return vec;
+}
+
+// Returned reference is valid until next call
+BenchRecord& newBenchRecord()
+{
+    BenchRecord record;
+    record.benchmark = QTest::currentTestFunction();
+    record.row = QTest::currentDataTag() ? QTest::currentDataTag() : "";
+    benchRecords().push_back(std::move(record));
+    return benchRecords().back();
+}
+
+// Adds to some BenchRecord object the time elapsed during its lifetime
+// Meant to be declared inside QBENCHMARK blocks, so setup code of an iteration can be excluded
+class BenchIterationTimer {
+public:
+    BenchIterationTimer(BenchRecord& record)
+        : m_record(record), m_startTime(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~BenchIterationTimer() {
+        const auto duration = std::chrono::steady_clock::now() - m_startTime;
+        m_record.vecDurationMs.push_back(std::chrono::duration<double, std::milli>(duration).count());
+    }
+
+private:
+    BenchRecord& m_record;
+    std::chrono::steady_clock::time_point m_startTime;
+};
+
+// Example: {"occVersion":"7.6.0","qtVersion":"5.15.2","occMemoryManager":"optimized","benchmarks":[{"name":"IO_read_bench",
+//           "row":"OCC/STEP/n10_d2_f24","iterations":1,"minMs":12.5,"medianMs":12.5,
+//           "metrics":{"fileSize":123456}}]}
+std::string benchRecordsToJson()
+{
+    std::ostringstream ostr;
+    ostr.imbue(std::locale::classic());
+    ostr << "{\"occVersion\":" << StringUtils::jsonQuoted(OCC_VERSION_STRING_EXT)
+         << ",\"qtVersion\":" << StringUtils::jsonQuoted(qVersion())
+         << ",\"occMemoryManager\":" << StringUtils::jsonQuoted(Application::openCascadeMemoryManager().toStdString())
+         << ",\"benchmarks\":[";
+    bool isFirstRecord = true;
+    for (const BenchRecord& record : benchRecords()) {
+        if (record.vecDurationMs.empty())
+            continue; // Skipped or failed benchmark
+
+        std::vector<double> vecDurationMs = record.vecDurationMs;
+        std::sort(vecDurationMs.begin(), vecDurationMs.end());
+        ostr << (isFirstRecord ? "\n" : ",\n");
+        ostr << "{\"name\":" << StringUtils::jsonQuoted(record.benchmark)
+             << ",\"row\":" << StringUtils::jsonQuoted(record.row)
+             << ",\"iterations\":" << vecDurationMs.size()
+             << ",\"minMs\":" << vecDurationMs.front()
+             << ",\"medianMs\":" << vecDurationMs.at(vecDurationMs.size() / 2)
+             << ",\"metrics\":{";
+        for (const auto& [name, value] : record.vecMetric) {
+            if (&name != &record.vecMetric.front().first)
+                ostr << ',';
+
+            ostr << StringUtils::jsonQuoted(name) << ':' << value;
+        }
+
+        ostr << "}}";
+        isFirstRecord = false;
+    }
+
+    ostr << "\n]}\n";
+    return ostr.str();
+}
+
+} // namespace
+
+void Bench::IO_probeFormat_bench()
+{
+    QFETCH(QByteArray, contents);
+    QFETCH(qint64, fileSize);
+    QFETCH(int, probeIndex);
+
+    const ProbeFunction& probe = predefinedProbes[probeIndex];
+    const IO::System::FormatProbeInput input = createProbeInput(contents, fileSize);
+    BenchRecord& record = newBenchRecord();
+    IO::Format format;
+    QBENCHMARK {
+        BenchIterationTimer timer(record);
+        format = probe.fn(input);
+    }
+
+    Q_UNUSED(format);
+}
+
+void Bench::IO_probeFormat_bench_data()
+{
+    QTest::addColumn<QByteArray>("contents");
+    QTest::addColumn<qint64>("fileSize");
+    QTest::addColumn<int>("probeIndex");
+
+    std::vector<std::pair<QString, QByteArray>> vecInput;
+    std::vector<qint64> vecFileSize;
+    auto fnAddFilesInDir = [&](const QDir& dir) {
+        const QFileInfoList listFileInfo = dir.entryInfoList(QDir::Files, QDir::Name);
+        for (const QFileInfo& fileInfo : listFileInfo) {
+            QFile file(fileInfo.filePath());
+            if (file.open(QIODevice::ReadOnly)) {
+                vecInput.emplace_back(fileInfo.fileName(), file.read(IO::System::ProbeWindowSize));
+                vecFileSize.push_back(fileInfo.size());
+            }
+        }
+    };
+
+    fnAddFilesInDir(QDir("inputs"));
+    const QString extraInputsDir = qEnvironmentVariable("MAYO_BENCH_INPUTS_DIR");
+    if (!extraInputsDir.isEmpty())
+        fnAddFilesInDir(QDir(extraInputsDir));
+
+    for (auto&& [name, contents] : adversarialInputs()) {
+        vecInput.emplace_back(name, contents);
+        vecFileSize.push_back(contents.size());
+    }
+
+    for (unsigned i = 0; i < vecInput.size(); ++i) {
+        for (int probeIndex = 0; probeIndex < int(std::size(predefinedProbes)); ++probeIndex) {
+            const QString rowName = vecInput.at(i).first + "/" + predefinedProbes[probeIndex].name;
+            QTest::newRow(qUtf8Printable(rowName))
+                    << vecInput.at(i).second << vecFileSize.at(i) << probeIndex;
+        }
+    }
+}
+
+void Bench::IO_read_bench()
+{
+    QFETCH(int, factoryIndex);
+    QFETCH(int, formatIndex);
+    QFETCH(int, specIndex);
+    QFETCH(bool, viewerOnly);
+
+    const IO::FactoryReader* factory = readerFactories().at(factoryIndex).factory.get();
+    const IO::Format format = factory->formats()[formatIndex];
+    const FilePath filepath = syntheticInputFile(format, specIndex);
+    QVERIFY(filepathIsRegularFile(filepath));
+
+    auto app = Application::instance();
+    BenchRecord& record = newBenchRecord();
+    record.vecMetric.push_back({ "fileSize", filepathTo<QFileInfo>(filepath).size() });
+    int64_t ocafDataSize = 0;
+    QBENCHMARK {
+        DocumentPtr doc = app->newDocument();
+        doc->setViewerOnly(viewerOnly);
+        {
+            BenchIterationTimer timer(record);
+            TaskProgress progress;
+            std::unique_ptr<IO::Reader> reader = factory->create(format);
+            QVERIFY(reader->readFile(filepath, &progress));
+            const TDF_LabelSequence seqLabel = reader->transfer(doc, &progress);
+            QVERIFY(!seqLabel.IsEmpty());
+        }
+
+        MemoryAccounting accounting;
+        accounting.addDocument(doc);
+        ocafDataSize = accounting.stats().ocafData;
+        app->closeDocument(doc);
+    }
+
+    record.vecMetric.push_back({ "ocafData", ocafDataSize });
+}
+
+void Bench::IO_read_bench_data()
+{
+    QTest::addColumn<int>("factoryIndex");
+    QTest::addColumn<int>("formatIndex");
+    QTest::addColumn<int>("specIndex");
+    QTest::addColumn<bool>("viewerOnly");
+
+    for (unsigned i = 0; i < readerFactories().size(); ++i) {
+        const NamedFactoryReader& reader = readerFactories().at(i);
+        const Span<const IO::Format> spanFormat = reader.factory->formats();
+        for (int j = 0; j < int(spanFormat.size()); ++j) {
+            for (int k = 0; k < int(std::size(syntheticModelSpecs)); ++k) {
+                const QString rowName = reader.name + "/" + QString::fromUtf8(spanFormat[j].identifier)
+                        + "/" + toString(syntheticModelSpecs[k]);
+                QTest::newRow(qUtf8Printable(rowName)) << int(i) << j << k << false;
+                // Documents of the CLI, see Document::setViewerOnly()
+                if (spanFormat[j] == IO::Format_STEP)
+                    QTest::newRow(qUtf8Printable(rowName + "/viewerOnly")) << int(i) << j << k << true;
+            }
+        }
+    }
+}
+
+void Bench::IO_write_bench()
+{
+    QFETCH(int, factoryIndex);
+    QFETCH(int, formatIndex);
+    QFETCH(int, specIndex);
+
+    const IO::FactoryWriter* factory = writerFactories().at(factoryIndex).factory.get();
+    const IO::Format format = factory->formats()[formatIndex];
+    const DocumentPtr doc = syntheticDocument(specIndex);
+    const ApplicationItem appItem(doc);
+    const QString fileName =
+            QString("write_%1.%2").arg(toString(syntheticModelSpecs[specIndex]), format.fileSuffixes.front());
+    const FilePath filepath = filepathFrom(benchTempDir().filePath(fileName));
+
+    BenchRecord& record = newBenchRecord();
+    QBENCHMARK {
+        BenchIterationTimer timer(record);
+        TaskProgress progress;
+        std::unique_ptr<IO::Writer> writer = factory->create(format);
+        QVERIFY(writer->transfer(Span<const ApplicationItem>(&appItem, 1), &progress));
+        QVERIFY(writer->writeFile(filepath, &progress));
+    }
+
+    record.vecMetric.push_back({ "fileSize", filepathTo<QFileInfo>(filepath).size() });
+}
+
+void Bench::IO_write_bench_data()
+{
+    QTest::addColumn<int>("factoryIndex");
+    QTest::addColumn<int>("formatIndex");
+    QTest::addColumn<int>("specIndex");
+
+    for (unsigned i = 0; i < writerFactories().size(); ++i) {
+        const NamedFactoryWriter& writer = writerFactories().at(i);
+        const Span<const IO::Format> spanFormat = writer.factory->formats();
+        for (int j = 0; j < int(spanFormat.size()); ++j) {
+            for (int k = 0; k < int(std::size(syntheticModelSpecs)); ++k) {
+                const QString rowName = writer.name + "/" + QString::fromUtf8(spanFormat[j].identifier)
+                        + "/" + toString(syntheticModelSpecs[k]);
+                QTest::newRow(qUtf8Printable(rowName)) << int(i) << j << k;
+            }
+        }
+    }
+}
+
+void Bench::IO_gmioStlBackend_bench()
+{
+#ifdef HAVE_GMIO
+    QFETCH(bool, isRead);
+    QFETCH(int, backend);
+    QFETCH(int, facetCount);
+
+    // Document and binary input file are shared by the rows of a same facet count
+    const QString baseName = QString("grid_%1").arg(facetCount);
+    const FilePath filepathInput = filepathFrom(benchTempDir().filePath(baseName + ".stl"));
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const TDF_Label labelMesh = doc->xcaf().shapeTool()->AddShape(createGridMeshFace(facetCount), false);
+    doc->addEntityTreeNode(labelMesh);
+    const ApplicationItem appItem(doc);
+    if (!filepathIsRegularFile(filepathInput)) {
+        TaskProgress progress;
+        IO::OccStlWriter writer;
+        QVERIFY(writer.transfer(Span<const ApplicationItem>(&appItem, 1), &progress));
+        QVERIFY(writer.writeFile(filepathInput, &progress));
+    }
+
+    BenchRecord& record = newBenchRecord();
+    record.vecMetric.push_back({ "facetCount", facetCount });
+    record.vecMetric.push_back({ "fileSize", filepathTo<QFileInfo>(filepathInput).size() });
+    if (isRead) {
+        QBENCHMARK {
+            DocumentPtr docRead = app->newDocument();
+            {
+                BenchIterationTimer timer(record);
+                TaskProgress progress;
+                IO::GmioStlReader reader;
+                reader.parameters().backend = IO::GmioStlBackend(backend);
+                QVERIFY(reader.readFile(filepathInput, &progress));
+                QVERIFY(!reader.transfer(docRead, &progress).IsEmpty());
+            }
+
+            app->closeDocument(docRead);
+        }
+    }
+    else {
+        const FilePath filepathOutput = filepathFrom(benchTempDir().filePath(baseName + "_out.stl"));
+        QBENCHMARK {
+            BenchIterationTimer timer(record);
+            TaskProgress progress;
+            IO::GmioStlWriter writer;
+            writer.parameters().backend = IO::GmioStlBackend(backend);
+            QVERIFY(writer.transfer(Span<const ApplicationItem>(&appItem, 1), &progress));
+            QVERIFY(writer.writeFile(filepathOutput, &progress));
+        }
+    }
+#else
+    QSKIP("Mayo built without gmio");
+#endif
+}
+
+void Bench::IO_gmioStlBackend_bench_data()
+{
+    QTest::addColumn<bool>("isRead");
+    QTest::addColumn<int>("backend");
+    QTest::addColumn<int>("facetCount");
+
+    // Binary STL takes 50 bytes per facet, so 8MB is about 168k facets
+    const int arrayFacetCount[] = { 10 * 1000, 50 * 1000, 100 * 1000, 200 * 1000, 400 * 1000, 1000 * 1000 };
+    const std::pair<const char*, IO::GmioStlBackend> arrayBackend[] = {
+        { "gmio", IO::GmioStlBackend::Gmio }, { "OCC", IO::GmioStlBackend::OpenCascade }
+    };
+    for (bool isRead : { true, false }) {
+        for (int facetCount : arrayFacetCount) {
+            for (const auto& [backendName, backend] : arrayBackend) {
+                const QString rowName = QString("%1/%2/%3").arg(isRead ? "read" : "write", backendName).arg(facetCount);
+                QTest::newRow(qUtf8Printable(rowName)) << isRead << int(backend) << facetCount;
+            }
+        }
+    }
+}
+
+void Bench::BRepUtils_computeMesh_bench()
+{
+    QFETCH(int, qualityIndex);
+    QFETCH(int, specIndex);
+
+    const TopoDS_Shape shape = createSyntheticShape(syntheticModelSpecs[specIndex]);
+    const OccBRepMeshParameters params = meshParameters(shape, meshQualities[qualityIndex]);
+    BenchRecord& record = newBenchRecord();
+    QBENCHMARK {
+        BRepTools::Clean(shape);
+        BenchIterationTimer timer(record);
+        BRepUtils::computeMesh(shape, params);
+    }
+
+    record.vecMetric.push_back({ "triangles", triangleCount(shape) });
+}
+
+void Bench::BRepUtils_computeMesh_bench_data()
+{
+    QTest::addColumn<int>("qualityIndex");
+    QTest::addColumn<int>("specIndex");
+
+    for (int i = 0; i < int(std::size(meshQualities)); ++i) {
+        for (int j = 0; j < int(std::size(syntheticModelSpecs)); ++j) {
+            const QString rowName = QString(meshQualities[i].name) + "/" + toString(syntheticModelSpecs[j]);
+            QTest::newRow(qUtf8Printable(rowName)) << i << j;
+        }
+    }
+}
+
+void Bench::IO_importMeshParallel_bench()
+{
+    QFETCH(int, jobCount);
+    QFETCH(int, specIndex);
+
+    const IO::FactoryReader* factory = readerFactories().front().factory.get();
+    const FilePath filepath = syntheticInputFile(IO::Format_STEP, specIndex);
+    QVERIFY(filepathIsRegularFile(filepath));
+
+    auto app = Application::instance();
+    BenchRecord& record = newBenchRecord();
+    record.vecMetric.push_back({ "jobs", jobCount });
+    QBENCHMARK {
+        std::vector<DocumentPtr> vecDoc;
+        for (int i = 0; i < jobCount; ++i)
+            vecDoc.push_back(app->newDocument());
+
+        {
+            BenchIterationTimer timer(record);
+            std::atomic<int> jobDoneCount = 0;
+            CppUtils::parallelFor(jobCount, [&](int iJob) {
+                TaskProgress progress;
+                std::unique_ptr<IO::Reader> reader = factory->create(IO::Format_STEP);
+                if (!reader->readFile(filepath, &progress))
+                    return;
+
+                for (const TDF_Label& label : reader->transfer(vecDoc.at(iJob), &progress)) {
+                    const TopoDS_Shape shape = XCaf::shape(label);
+                    BRepUtils::computeMesh(shape, meshParameters(shape, meshQualities[2]));
+                }
+
+                ++jobDoneCount;
+            });
+            QCOMPARE(jobDoneCount.load(), jobCount);
+        }
+
+        // Deallocations are part of the allocator workload, but happen in a background thread
+        for (const DocumentPtr& doc : vecDoc)
+            app->closeDocument(doc);
+
+        app->waitForClosedDocumentsReleased();
+    }
+}
+
+void Bench::IO_importMeshParallel_bench_data()
+{
+    QTest::addColumn<int>("jobCount");
+    QTest::addColumn<int>("specIndex");
+
+    const int threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+    for (int jobCount : { 1, threadCount }) {
+        for (int i = 0; i < int(std::size(syntheticModelSpecs)); ++i) {
+            const QString rowName = QString("j%1/%2").arg(jobCount).arg(toString(syntheticModelSpecs[i]));
+            QTest::newRow(qUtf8Printable(rowName)) << jobCount << i;
+        }
+    }
+}
+
+void Bench::LibTree_traversal_bench()
+{
+    QFETCH(int, branchCount);
+    QFETCH(int, depth);
+    QFETCH(int, traversal);
+
+    Tree<int> tree;
+    std::function<void(TreeNodeId, int)> fnAppendChildren = [&](TreeNodeId parentId, int level) {
+        if (level == depth)
+            return;
+
+        for (int i = 0; i < branchCount; ++i)
+            fnAppendChildren(tree.appendChild(parentId, i), level + 1);
+    };
+    fnAppendChildren(tree.appendChild(0, 0), 1);
+
+    BenchRecord& record = newBenchRecord();
+    record.vecMetric.push_back({ "nodes", int64_t(tree.nodeCount()) });
+    int64_t sum = 0;
+    auto fnVisit = [&](TreeNodeId id) { sum += tree.nodeData(id); };
+    QBENCHMARK {
+        BenchIterationTimer timer(record);
+        if (traversal == 0)
+            traverseTree_unorder(tree, fnVisit);
+        else if (traversal == 1)
+            traverseTree_preOrder(tree, fnVisit);
+        else if (traversal == 2)
+            traverseTree_postOrder(tree, fnVisit);
+        else
+            sum += reduceTree(tree, int64_t(0), [&](TreeNodeId id) { return int64_t(tree.nodeData(id)); }, std::plus<>());
+    }
+
+    QVERIFY(sum >= 0);
+}
+
+void Bench::LibTree_traversal_bench_data()
+{
+    QTest::addColumn<int>("branchCount");
+    QTest::addColumn<int>("depth");
+    QTest::addColumn<int>("traversal");
+
+    const std::pair<int, int> shapes[] = { { 2, 17 }, { 4, 9 }, { 16, 5 }, { 1024, 2 } };
+    const char* traversals[] = { "unorder", "preOrder", "postOrder", "parallelReduce" };
+    for (const auto& [branchCount, depth] : shapes) {
+        for (int i = 0; i < int(std::size(traversals)); ++i) {
+            const QString rowName = QString("b%1_d%2/%3").arg(branchCount).arg(depth).arg(traversals[i]);
+            QTest::newRow(qUtf8Printable(rowName)) << branchCount << depth << i;
+        }
+    }
+}
+
+void Bench::GuiDocument_mapEntity_bench()
+{
+#if (!defined(Q_OS_WIN) && !defined(Q_OS_MAC))
+    if (qEnvironmentVariableIsEmpty("DISPLAY"))
+        QSKIP("OpenGL graphic driver requires a X11 display");
+#endif
+
+    QFETCH(int, specIndex);
+
+    // Document has to be created before GuiApplication, which maps documents added afterwards
+    auto app = Application::instance();
+    const DocumentPtr doc = specIndex >= 0 ? syntheticDocument(specIndex) : app->newDocument();
+    BenchRecord& record = newBenchRecord();
+    {
+        GuiApplication guiApp(app);
+        guiApp.graphicsTreeNodeMappingDriverTable()->addDriver(
+                    std::make_unique<GraphicsShapeTreeNodeMappingDriver>());
+        guiApp.graphicsObjectDriverTable()->addDriver(std::make_unique<GraphicsShapeObjectDriver>());
+        guiApp.graphicsObjectDriverTable()->addDriver(std::make_unique<GraphicsMeshObjectDriver>());
+        QBENCHMARK {
+            BenchIterationTimer timer(record);
+            GuiDocument guiDoc(doc, &guiApp);
+        }
+    }
+
+    if (specIndex < 0)
+        app->closeDocument(doc);
+}
+
+void Bench::GuiDocument_mapEntity_bench_data()
+{
+    QTest::addColumn<int>("specIndex");
+
+    // Baseline: creation of the 3D viewer, without any entity
+    QTest::newRow("empty") << -1;
+    for (int i = 0; i < int(std::size(syntheticModelSpecs)); ++i)
+        QTest::newRow(qUtf8Printable(toString(syntheticModelSpecs[i]))) << i;
+}
+
+void Bench::initTestCase()
+{
+    readerFactories().push_back({ "OCC", std::make_unique<IO::OccFactoryReader>() });
+    writerFactories().push_back({ "OCC", std::make_unique<IO::OccFactoryWriter>() });
+    std::unique_ptr<IO::FactoryWriter> gmioFactoryWriter = IO::GmioFactoryWriter::create();
+    if (gmioFactoryWriter)
+        writerFactories().push_back({ "gmio", std::move(gmioFactoryWriter) });
+
+    QVERIFY(benchTempDir().isValid());
+}
+
+void Bench::cleanupTestCase()
+{
+    const QString filepath = qEnvironmentVariable("MAYO_BENCH_JSON");
+    if (!filepath.isEmpty()) {
+        QFile file(filepath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QByteArray::fromStdString(benchRecordsToJson()));
+    }
+
+    for (const auto& [specIndex, doc] : syntheticDocuments()) {
+        MAYO_UNUSED(specIndex);
+        Application::instance()->closeDocument(doc);
+    }
+
+    syntheticDocuments().clear();
+    readerFactories().clear();
+    writerFactories().clear();
+}
+
+} // namespace Mayo
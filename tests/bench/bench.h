@@ -0,0 +1,56 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QObject>
+#include <QtTest/QtTest>
+
+namespace Mayo {
+
+// Benchmarks, run with QtTest options(eg -tickcounter, -iterations)
+// Extra real files can be provided with environment variable MAYO_BENCH_INPUTS_DIR
+// Results are also written as JSON into the file specified by environment variable MAYO_BENCH_JSON
+// OpenCascade memory manager can be chosen with environment variable MMGT_OPT(0, 1 or 2)
+// Synthetic models are named "n<parts>_d<depth>_f<faces>": assemblies nested over 'depth' levels,
+// instantiating 'parts' distinct parts with 'faces' faces each
+// Headless runs need QT_QPA_PLATFORM=offscreen, GuiDocument benchmark is then skipped on X11
+class Bench : public QObject {
+    Q_OBJECT
+private slots:
+    void IO_probeFormat_bench();
+    void IO_probeFormat_bench_data();
+
+    void IO_read_bench();
+    void IO_read_bench_data();
+
+    void IO_write_bench();
+    void IO_write_bench_data();
+
+    // Both backends of GmioStlReader/GmioStlWriter over plain triangulations of increasing size
+    // Crossover points are the defaults of the 'autoGmioMax*' parameters(requires gmio)
+    void IO_gmioStlBackend_bench();
+    void IO_gmioStlBackend_bench_data();
+
+    void BRepUtils_computeMesh_bench();
+    void BRepUtils_computeMesh_bench_data();
+
+    // STEP import followed by meshing, for several files at once as in batch conversion
+    // Meant to compare OpenCascade memory managers, see Application::openCascadeMemoryManager()
+    void IO_importMeshParallel_bench();
+    void IO_importMeshParallel_bench_data();
+
+    void LibTree_traversal_bench();
+    void LibTree_traversal_bench_data();
+
+    void GuiDocument_mapEntity_bench();
+    void GuiDocument_mapEntity_bench_data();
+
+    void initTestCase();
+    void cleanupTestCase();
+};
+
+} // namespace Mayo
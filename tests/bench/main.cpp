@@ -0,0 +1,36 @@
+/****************************************************************************
+** Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+** All rights reserved.
+** See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+****************************************************************************/
+
+#include "bench.h"
+#include "../../src/app/theme.h"
+
+#include <QtWidgets/QApplication>
+#include <memory>
+#include <vector>
+
+namespace Mayo {
+
+// Declared in theme.h, required by GuiDocument
+Theme* mayoTheme()
+{
+    static std::unique_ptr<Theme> globalTheme(createTheme("classic"));
+    return globalTheme.get();
+}
+
+} // namespace Mayo
+
+int main(int argc, char** argv)
+{
+    // QApplication is needed by GuiDocument benchmarks(theme colors from application palette)
+    QApplication app(argc, argv);
+    int retcode = 0;
+    std::vector<std::unique_ptr<QObject>> vecBench;
+    vecBench.emplace_back(new Mayo::Bench);
+    for (const std::unique_ptr<QObject>& bench : vecBench)
+        retcode += QTest::qExec(bench.get(), argc, argv);
+
+    return retcode;
+}
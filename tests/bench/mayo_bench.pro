@@ -0,0 +1,79 @@
+TARGET = mayo_bench
+TEMPLATE = app
+
+CONFIG += c++17 no_batch
+
+QT += gui widgets testlib
+
+*msvc*:QMAKE_CXXFLAGS += /std:c++17
+*g++*:QMAKE_CXXFLAGS += -std=c++17
+
+INCLUDEPATH += \
+    ../../src/app \
+    ../../src/3rdparty
+
+HEADERS += \
+    bench.h \
+    $$files(../../src/base/*.h) \
+    $$files(../../src/io_occ/*.h) \
+    $$files(../../src/graphics/*.h) \
+    $$files(../../src/gui/*.h) \
+    ../../src/app/theme.h \
+
+SOURCES += \
+    bench.cpp \
+    main.cpp \
+    \
+    $$files(../../src/base/*.cpp) \
+    $$files(../../src/io_occ/*.cpp) \
+    $$files(../../src/graphics/*.cpp) \
+    $$files(../../src/gui/*.cpp) \
+    ../../src/app/theme.cpp \
+
+CONFIG += file_copies
+COPIES += MayoInputs
+MayoInputs.files = $$files(../inputs/*.*)
+MayoInputs.path = $$OUT_PWD/inputs
+
+# OpenCascade
+include(../../opencascade.pri)
+LIBS += -lTKernel -lTKMath -lTKBRep -lTKGeomBase -lTKGeomAlgo -lTKTopAlgo -lTKPrim -lTKMesh -lTKG2d -lTKG3d
+LIBS += -lTKBO -lTKBool -lTKHLR -lTKShHealing
+LIBS += -lTKService -lTKV3d -lTKOpenGl -lTKMeshVS
+LIBS += -lTKXSBase
+LIBS += -lTKLCAF -lTKXCAF -lTKCAF -lTKVCAF
+LIBS += -lTKCDF -lTKBin -lTKBinL -lTKBinXCAF -lTKXml -lTKXmlL -lTKXmlXCAF
+# -- IGES support
+LIBS += -lTKIGES -lTKXDEIGES
+# -- STEP support
+LIBS += -lTKSTEP -lTKSTEP209 -lTKSTEPAttr -lTKSTEPBase -lTKXDESTEP
+# -- STL support
+LIBS += -lTKSTL
+# -- OBJ/glTF support
+minOpenCascadeVersion(7, 4, 0) {
+    LIBS += -lTKRWMesh
+} else {
+    SOURCES -= \
+        ../../src/io_occ/io_occ_base_mesh.cpp \
+        ../../src/io_occ/io_occ_gltf_reader.cpp \
+        ../../src/io_occ/io_occ_obj.cpp
+}
+
+!minOpenCascadeVersion(7, 5, 0) {
+    SOURCES -= ../../src/io_occ/io_occ_gltf_writer.cpp
+}
+# -- VRML support
+LIBS += -lTKVRML
+
+# Scalable malloc
+include(../../malloc.pri)
+
+# gmio
+!isEmpty(GMIO_ROOT) {
+    HEADERS += $$files(../../src/io_gmio/*.h)
+    SOURCES += $$files(../../src/io_gmio/*.cpp)
+    INCLUDEPATH += $$GMIO_ROOT/include
+    LIBS += -L$$GMIO_ROOT/lib -lgmio_static -lzlibstatic
+    SOURCES += $$GMIO_ROOT/src/gmio_support/stream_qt.cpp
+    DEFINES += HAVE_GMIO
+}
@@ -15,6 +15,8 @@ HEADERS += \
     test.h \
     $$files(../src/base/*.h) \
     $$files(../src/io_occ/*.h) \
+    $$files(../src/io_ply/*.h) \
+    $$files(../src/io_point_cloud/*.h) \
     ../src/gui/qtgui_utils.h \
 
 SOURCES += \
@@ -23,6 +25,8 @@ SOURCES += \
     \
     $$files(../src/base/*.cpp) \
     $$files(../src/io_occ/*.cpp) \
+    $$files(../src/io_ply/*.cpp) \
+    $$files(../src/io_point_cloud/*.cpp) \
     ../src/gui/qtgui_utils.cpp \
 
 CONFIG += file_copies
@@ -32,7 +36,8 @@ MayoInputs.path = $$OUT_PWD/inputs
 
 # OpenCascade
 include(../opencascade.pri)
-LIBS += -lTKernel -lTKMath -lTKBRep -lTKGeomBase -lTKTopAlgo -lTKPrim -lTKMesh -lTKG3d
+LIBS += -lTKernel -lTKMath -lTKBRep -lTKGeomBase -lTKTopAlgo -lTKPrim -lTKMesh -lTKG2d -lTKG3d
+LIBS += -lTKShHealing -lTKBO -lTKBool
 LIBS += -lTKXSBase
 LIBS += -lTKLCAF -lTKXCAF -lTKCAF
 LIBS += -lTKCDF -lTKBin -lTKBinL -lTKBinXCAF -lTKXml -lTKXmlL -lTKXmlXCAF
@@ -57,3 +62,13 @@ minOpenCascadeVersion(7, 4, 0) {
 }
 # -- VRML support
 LIBS += -lTKVRML
+
+# zlib
+include(../zlib.pri)
+contains(DEFINES, HAVE_ZLIB) {
+    HEADERS += $$files(../src/io_3mf/*.h)
+    SOURCES += $$files(../src/io_3mf/*.cpp)
+}
+
+# Scalable malloc
+include(../malloc.pri)
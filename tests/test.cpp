@@ -9,51 +9,148 @@
 
 #include "test.h"
 #include "../src/base/application.h"
+#include "../src/base/application_item.h"
+#include "../src/base/application_item_selection_model.h"
+#include "../src/base/bnd_utils.h"
+#include "../src/base/brep_mesh_cache.h"
+#include "../src/base/brep_mesh_budget.h"
+#include "../src/base/brep_mesh_priorities.h"
+#include "../src/base/brep_mesh_quality.h"
 #include "../src/base/brep_utils.h"
 #include "../src/base/caf_utils.h"
+#include "../src/base/clash_detection.h"
+#include "../src/base/compact_triangulation_store.h"
+#include "../src/base/cross_section.h"
+#include "../src/base/cpp_utils.h"
+#include "../src/base/decompression_stream.h"
+#include "../src/base/async_file_stream.h"
 #include "../src/base/filepath.h"
+#include "../src/base/flat_hash_map.h"
 #include "../src/base/geom_utils.h"
+#include "../src/base/geometry_dedup.h"
+#include "../src/base/reimport_diff.h"
+#include "../src/base/io_export_split.h"
 #include "../src/base/io_system.h"
+#include "../src/base/job_arena.h"
+#include "../src/base/occ_static_variables_context.h"
 #include "../src/base/occ_static_variables_rollback.h"
 #include "../src/base/libtree.h"
+#include "../src/base/mass_properties.h"
+#include "../src/base/memory_stats.h"
+#include "../src/base/mesh_compression.h"
+#include "../src/base/mesh_decimation.h"
+#include "../src/base/mesh_node_colors.h"
+#include "../src/base/mesh_quality_analysis.h"
 #include "../src/base/mesh_utils.h"
+#include "../src/base/messenger.h"
 #include "../src/base/meta_enum.h"
+#include "../src/base/part_bvh.h"
+#include "../src/base/perf_stats.h"
+#include "../src/base/point_cloud.h"
+#include "../src/base/process_utils.h"
 #include "../src/base/property_builtins.h"
 #include "../src/base/property_enumeration.h"
 #include "../src/base/property_value_conversion.h"
 #include "../src/base/result.h"
+#include "../src/base/settings.h"
+#include "../src/base/shape_distance.h"
+#include "../src/base/stream_utils.h"
 #include "../src/base/string_utils.h"
 #include "../src/base/task_manager.h"
 #include "../src/base/tkernel_utils.h"
+#include "../src/base/trace_recorder.h"
+#include "../src/base/tree_name_index.h"
 #include "../src/base/unit.h"
 #include "../src/base/unit_system.h"
+#ifdef HAVE_ZLIB
+#  include "../src/io_3mf/io_3mf_writer.h"
+#endif
 #include "../src/io_occ/io_occ.h"
+#include "../src/io_occ/io_occ_brep.h"
+#include "../src/io_occ/io_occ_iges.h"
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+#  include "../src/io_occ/io_occ_obj.h"
+#endif
+#include "../src/io_occ/io_occ_obj_writer.h"
+#include "../src/io_occ/io_occ_step.h"
+#include "../src/io_occ/io_occ_stl.h"
+#include "../src/io_occ/io_occ_vrml.h"
+#include "../src/io_ply/io_ply.h"
+#include "../src/io_ply/io_ply_reader.h"
+#include "../src/io_ply/io_ply_writer.h"
+#include "../src/io_point_cloud/io_point_cloud.h"
+#include "../src/io_point_cloud/io_point_cloud_reader.h"
 #include "../src/gui/qtgui_utils.h"
 
+#include <BRep_Builder.hxx>
 #include <BRep_Tool.hxx>
 #include <BRepAdaptor_Curve.hxx>
+#include <BRepBuilderAPI_MakeFace.hxx>
 #include <BRepMesh_IncrementalMesh.hxx>
+#include <BRepPrimAPI_MakeSphere.hxx>
+#include <BRepTools.hxx>
 #include <GCPnts_TangentialDeflection.hxx>
+#include <gp.hxx>
+#include <gp_Pln.hxx>
+#include <gp_Vec.hxx>
 #include <Interface_ParamType.hxx>
 #include <Interface_Static.hxx>
+#include <Precision.hxx>
+#include <RWStl.hxx>
+#include <Standard_Version.hxx>
+#include <TDataXtd_Triangulation.hxx>
 #include <TopAbs_ShapeEnum.hxx>
+#include <TopTools_MapOfShape.hxx>
+#include <TopoDS_Compound.hxx>
+#include <XCAFDoc_ColorTool.hxx>
+#if OCC_VERSION_HEX < OCC_VERSION_CHECK(7, 6, 0)
+#  include <TShort_Array1OfShortReal.hxx>
+#endif
 #include <QtCore/QtDebug>
+#include <QtCore/QCoreApplication>
 #include <QtCore/QFile>
+#include <QtCore/QSettings>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QtEndian>
 #include <QtCore/QVariant>
 #include <QtTest/QSignalSpy>
 #include <gsl/util>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <clocale>
 #include <cmath>
 #include <cstring>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <set>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 Q_DECLARE_METATYPE(Mayo::UnitSystem::TranslateResult)
 // For Application_test()
 Q_DECLARE_METATYPE(Mayo::IO::Format)
+// For Test::IO_OccShapeHealing_test()
+Q_DECLARE_METATYPE(Mayo::IO::OccCommon::ShapeHealing)
+// For Test::IO_OccStlWriter_test()
+Q_DECLARE_METATYPE(Mayo::IO::OccStlWriter::Format)
+// For Test::IO_OccBRepWriter_test()
+Q_DECLARE_METATYPE(Mayo::IO::OccBRepWriter::Format)
+// For Test::IO_PlyReaderWriter_test()
+Q_DECLARE_METATYPE(Mayo::IO::PlyWriter::Format)
 // For MeshUtils_orientation_test()
 Q_DECLARE_METATYPE(std::vector<gp_Pnt2d>)
 Q_DECLARE_METATYPE(Mayo::MeshUtils::Orientation)
@@ -70,6 +167,20 @@ static bool operator==(
             && std::abs(lhs.factor - rhs.factor) < 1e-6;
 }
 
+// Adds to 'doc' an assembly made of two instances of 'part', the second one being translated
+// For GeometryDedup_test() and ReimportDiff_test()
+static TDF_Label addTwoInstancesAssembly(const DocumentPtr& doc, const TopoDS_Shape& part)
+{
+    TopoDS_Compound compound;
+    BRep_Builder builder;
+    builder.MakeCompound(compound);
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(50, 0, 0));
+    builder.Add(compound, part);
+    builder.Add(compound, part.Moved(TopLoc_Location(trsf)));
+    return doc->xcaf().shapeTool()->AddShape(compound, true/*makeAssembly*/);
+}
+
 void Test::Application_test()
 {
     auto app = Application::instance();
@@ -98,22 +209,113 @@ void Test::Application_test()
         QCOMPARE(app->documentCount(), 0);
     }
 
+    {   // Find document by location
+        DocumentPtr doc = app->newDocument();
+        QVERIFY(app->findDocumentByLocation(FilePath()).IsNull());
+        doc->setFilePath("inputs/cube.step");
+        QCOMPARE(app->findDocumentByLocation("inputs/cube.step").get(), doc.get());
+        QCOMPARE(app->findDocumentByLocation("inputs/../inputs/cube.step").get(), doc.get());
+        QCOMPARE(app->findDocumentByLocation(std::filesystem::absolute("inputs/cube.step")).get(), doc.get());
+        doc->setFilePath("inputs/cube.stlb");
+        QVERIFY(app->findDocumentByLocation("inputs/cube.step").IsNull());
+        QCOMPARE(app->findDocumentByLocation("inputs/cube.stlb").get(), doc.get());
+        app->closeDocument(doc);
+        QVERIFY(app->findDocumentByLocation("inputs/cube.stlb").IsNull());
+        QCOMPARE(app->documentCount(), 0);
+    }
+
+    {   // Name table of document labels
+        DocumentPtr doc = app->newDocument();
+        QVERIFY(fnImportInDocument(doc, "inputs/cube.step"));
+        QVERIFY(doc->entityCount() > 0);
+        const TDF_Label entityLabel = doc->entityLabel(0);
+        QCOMPARE(doc->labelName(entityLabel), CafUtils::labelAttrStdName(entityLabel));
+        doc->setLabelName(entityLabel, "renamed");
+        QCOMPARE(doc->labelName(entityLabel), QString("renamed"));
+        QCOMPARE(CafUtils::labelAttrStdName(entityLabel), QString("renamed"));
+        app->closeDocument(doc);
+        QCOMPARE(app->documentCount(), 0);
+    }
+
+    {   // Data of closed document is released in background
+        DocumentPtr doc = app->newDocument();
+        QVERIFY(fnImportInDocument(doc, "inputs/cube.step"));
+        const TDF_Label entityLabel = doc->entityLabel(0);
+        QVERIFY(entityLabel.NbAttributes() > 0);
+        app->closeDocument(doc);
+        QCOMPARE(app->documentCount(), 0);
+        app->waitForClosedDocumentsReleased();
+        QCOMPARE(entityLabel.NbAttributes(), 0);
+    }
+
+    {   // Data of closed document is kept while used by an items snapshot
+        DocumentPtr doc = app->newDocument();
+        QVERIFY(fnImportInDocument(doc, "inputs/cube.step"));
+        const TDF_Label entityLabel = doc->entityLabel(0);
+        auto snapshot = std::make_unique<ApplicationItemsSnapshot>(
+                    std::vector<ApplicationItem>{ ApplicationItem(doc), ApplicationItem(doc->entityTreeNode(0)) });
+        QCOMPARE(snapshot->items().size(), size_t(2));
+        const ApplicationItemsSnapshot snapshotCopy = *snapshot;
+        QCOMPARE(snapshotCopy.items().data(), snapshot->items().data());
+        app->closeDocument(doc);
+        QCOMPARE(app->documentCount(), 0);
+        QTest::qWait(50);
+        QVERIFY(entityLabel.NbAttributes() > 0);
+        snapshot.reset();
+        QVERIFY(entityLabel.NbAttributes() > 0);
+    }
+    app->waitForClosedDocumentsReleased();
+
+    {   // Effective styles of model tree nodes
+        DocumentPtr doc = app->newDocument();
+        auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+        QVERIFY(fnImportInDocument(doc, "inputs/cube.step"));
+        const XCaf& xcaf = doc->xcaf();
+        const Tree<TDF_Label>& modelTree = doc->modelTree();
+        QCOMPARE(xcaf.shapeStyleIndex(0), uint32_t(0));
+        QVERIFY(!xcaf.shapeStyleAt(0).hasColor);
+        traverseTree(modelTree, [&](TreeNodeId id) {
+            const TDF_Label& label = modelTree.nodeData(id);
+            const TreeNodeId parentId = modelTree.nodeParent(id);
+            const XCaf::ShapeStyle& style = xcaf.shapeStyle(id);
+            QVERIFY(xcaf.shapeStyleIndex(id) < xcaf.shapeStyleCount());
+            const bool isReferredByParent = parentId != 0 && XCaf::isShapeReference(modelTree.nodeData(parentId));
+            if (xcaf.hasShapeColor(label) && !isReferredByParent) {
+                QVERIFY(style.hasColor);
+                QVERIFY(style.color.IsEqual(xcaf.shapeColor(label)));
+            }
+            else if (!xcaf.hasShapeColor(label)) {
+                QCOMPARE(xcaf.shapeStyleIndex(id), xcaf.shapeStyleIndex(parentId));
+            }
+        });
+    }
+
     {   // Add & remove an entity
         DocumentPtr doc = app->newDocument();
         auto _ = gsl::finally([=]{ app->closeDocument(doc); });
         QCOMPARE(doc->entityCount(), 0);
-        QSignalSpy sigSpy_docEntityAdded(doc.get(), &Document::entityAdded);
+        // Entities transferred by import are added at once
+        QSignalSpy sigSpy_docEntitiesAdded(doc.get(), &Document::entitiesAdded);
         const bool okImport = fnImportInDocument(doc, "inputs/cube.step");
         QVERIFY(okImport);
-        QCOMPARE(sigSpy_docEntityAdded.count(), 1);
+        QCOMPARE(sigSpy_docEntitiesAdded.count(), 1);
         QCOMPARE(doc->entityCount(), 1);
         QVERIFY(XCaf::isShape(doc->entityLabel(0)));
         QCOMPARE(CafUtils::labelAttrStdName(doc->entityLabel(0)), QLatin1String("Cube"));
+        QCOMPARE(doc->findEntityTreeNodeId(doc->entityLabel(0)), doc->entityTreeNodeId(0));
+
+        // Label already registered as an entity is ignored
+        QSignalSpy sigSpy_docEntityAdded(doc.get(), &Document::entityAdded);
+        doc->addEntityTreeNode(doc->entityLabel(0));
+        QCOMPARE(sigSpy_docEntityAdded.count(), 0);
+        QCOMPARE(doc->entityCount(), 1);
 
         QSignalSpy sigSpy_docEntityAboutToBeDestroyed(doc.get(), &Document::entityAboutToBeDestroyed);
+        const TDF_Label entityLabel = doc->entityLabel(0);
         doc->destroyEntity(doc->entityTreeNodeId(0));
         QCOMPARE(sigSpy_docEntityAboutToBeDestroyed.count(), 1);
         QCOMPARE(doc->entityCount(), 0);
+        QCOMPARE(doc->findEntityTreeNodeId(entityLabel), TreeNodeId(0));
     }
 
     {   // Add mesh entity
@@ -138,9 +340,151 @@ void Test::Application_test()
         QCOMPARE(doc->entityCount(), 0);
     }
 
+    {   // Remove many entities at once
+        DocumentPtr doc = app->newDocument();
+        auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+        QVERIFY(fnImportInDocument(doc, "inputs/cube.stlb"));
+        QVERIFY(fnImportInDocument(doc, "inputs/cube.step"));
+        QCOMPARE(doc->entityCount(), 2);
+
+        QSignalSpy sigSpy_docEntityAboutToBeDestroyed(doc.get(), &Document::entityAboutToBeDestroyed);
+        QSignalSpy sigSpy_docEntitiesAboutToBeDestroyed(doc.get(), &Document::entitiesAboutToBeDestroyed);
+        const TreeNodeId arrayEntityId[] = { doc->entityTreeNodeId(0), doc->entityTreeNodeId(1) };
+        doc->destroyEntities(arrayEntityId);
+        QCOMPARE(sigSpy_docEntityAboutToBeDestroyed.count(), 0);
+        QCOMPARE(sigSpy_docEntitiesAboutToBeDestroyed.count(), 1);
+        QCOMPARE(doc->entityCount(), 0);
+    }
+
+    {   // Import in a task
+        DocumentPtr doc = app->newDocument();
+        auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+        TaskManager taskMgr;
+        const TaskFuture<bool> future = ioSystem->importInDocument()
+                .targetDocument(doc)
+                .withFilepath("inputs/cube.step")
+                .executeAsync(&taskMgr);
+        QVERIFY(future.waitForReady(10000));
+        QVERIFY(future.hasValue());
+        QVERIFY(future.value());
+        QCOMPARE(doc->entityCount(), 1);
+    }
+
+    {   // Import of a prefetched file only transfers the warm reader
+        QVERIFY(ioSystem->prefetchFile("inputs/cube.step", nullptr));
+        QVERIFY(ioSystem->prefetchFile("inputs/cube.step", nullptr)); // Already warm
+        DocumentPtr doc = app->newDocument();
+        auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+        QVERIFY(fnImportInDocument(doc, "inputs/cube.step"));
+        QCOMPARE(doc->entityCount(), 1);
+        ioSystem->clearPrefetches();
+    }
+
+    {   // Save & open back a document, triangulations of shape faces are kept
+        QCOMPARE(app->documentCount(), 0);
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        const QString filepath = tempDir.filePath("cube.myb");
+        {
+            DocumentPtr doc = app->newDocument();
+            auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+            QVERIFY(fnImportInDocument(doc, "inputs/cube.step"));
+            QVERIFY(fnImportInDocument(doc, "inputs/cube.stlb"));
+            QCOMPARE(doc->entityCount(), 2);
+            BRepMesh_IncrementalMesh mesher(XCaf::shape(doc->entityLabel(0)), 1.);
+            QCOMPARE(app->saveDocumentAs(doc, filepath), PCDM_SS_OK);
+            QVERIFY(filepathEquivalent(doc->filePath(), filepathFrom(filepath)));
+        }
+
+        QSignalSpy sigSpy_documentAdded(app.get(), &Application::documentAdded);
+        PCDM_ReaderStatus readStatus = PCDM_RS_OpenError;
+        DocumentPtr doc = app->openDocument(filepath, &readStatus);
+        QVERIFY(!doc.IsNull());
+        auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+        QCOMPARE(readStatus, PCDM_RS_OK);
+        QCOMPARE(sigSpy_documentAdded.count(), 1);
+        QCOMPARE(doc->name(), QLatin1String("cube"));
+        QCOMPARE(doc->entityCount(), 2);
+        int shapeEntityCount = 0;
+        int meshEntityCount = 0;
+        for (int i = 0; i < doc->entityCount(); ++i) {
+            const TDF_Label labelEntity = doc->entityLabel(i);
+            if (XCaf::isShape(labelEntity)) {
+                ++shapeEntityCount;
+                BRepUtils::forEachSubFace(XCaf::shape(labelEntity), [](const TopoDS_Face& face) {
+                    TopLoc_Location loc;
+                    QVERIFY(!BRep_Tool::Triangulation(face, loc).IsNull());
+                });
+            }
+            else if (CafUtils::hasAttribute<TDataXtd_Triangulation>(labelEntity)) {
+                ++meshEntityCount;
+                QCOMPARE(CafUtils::findAttribute<TDataXtd_Triangulation>(labelEntity)->Get()->NbTriangles(), 12);
+            }
+        }
+
+        QCOMPARE(shapeEntityCount, 1);
+        QCOMPARE(meshEntityCount, 1);
+    }
+
+    {   // Viewer-only document, pending command is dropped and no undo is recorded
+        DocumentPtr doc = app->newDocument();
+        auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+        doc->SetUndoLimit(10);
+        doc->OpenCommand();
+        doc->setViewerOnly(true);
+        QVERIFY(doc->isViewerOnly());
+        QVERIFY(!doc->HasOpenCommand());
+        QCOMPARE(doc->GetUndoLimit(), 0);
+        doc->addEntityTreeNode(doc->xcaf().shapeTool()->AddShape(BRepPrimAPI_MakeBox(1, 1, 1), false));
+        QCOMPARE(doc->entityCount(), 1);
+        QCOMPARE(doc->GetAvailableUndos(), 0);
+    }
+
     QCOMPARE(app->documentCount(), 0);
 }
 
+void Test::ApplicationItemSelectionModel_test()
+{
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    ApplicationItemSelectionModel selectionModel;
+    QSignalSpy sigSpy_changed(&selectionModel, &ApplicationItemSelectionModel::changed);
+
+    std::vector<ApplicationItem> vecItem;
+    for (TreeNodeId id = 1; id <= 1000; ++id)
+        vecItem.push_back(DocumentTreeNode(doc, id));
+
+    selectionModel.add(vecItem);
+    selectionModel.add(vecItem.front()); // Already selected
+    selectionModel.add(ApplicationItem(doc));
+    QCOMPARE(sigSpy_changed.count(), 2);
+    QCOMPARE(selectionModel.selectedItems().size(), vecItem.size() + 1);
+    QVERIFY(selectionModel.isSelected(ApplicationItem(doc)));
+    QVERIFY(selectionModel.isSelected(DocumentTreeNode(doc, 500)));
+    QVERIFY(!selectionModel.isSelected(DocumentTreeNode(doc, 1001)));
+
+    // Remove every even node, selection order of remaining items must be kept
+    std::vector<ApplicationItem> vecItemRemoved;
+    for (TreeNodeId id = 2; id <= 1000; id += 2)
+        vecItemRemoved.push_back(DocumentTreeNode(doc, id));
+
+    selectionModel.remove(vecItemRemoved);
+    QCOMPARE(sigSpy_changed.count(), 3);
+    QCOMPARE(selectionModel.selectedItems().size(), size_t(501));
+    for (size_t i = 0; i < 500; ++i)
+        QCOMPARE(selectionModel.selectedItems()[i].documentTreeNode().id(), TreeNodeId(2 * i + 1));
+
+    QVERIFY(selectionModel.selectedItems().back().isDocument());
+    QVERIFY(!selectionModel.isSelected(DocumentTreeNode(doc, 2)));
+
+    selectionModel.remove(ApplicationItem(doc));
+    QVERIFY(!selectionModel.isSelected(ApplicationItem(doc)));
+    selectionModel.clear();
+    QVERIFY(selectionModel.selectedItems().empty());
+    QVERIFY(!selectionModel.isSelected(DocumentTreeNode(doc, 1)));
+}
+
 void Test::TextId_test()
 {
     QVERIFY(TextId(MAYO_TEXT_ID("Mayo::Test", "foobar")).key == "foobar");
@@ -267,6 +611,7 @@ void Test::IO_test_data()
     QTest::newRow("cube.stla") << "inputs/cube.stla" << IO::Format_STL;
     QTest::newRow("cube.stlb") << "inputs/cube.stlb" << IO::Format_STL;
     QTest::newRow("cube.obj") << "inputs/cube.obj" << IO::Format_OBJ;
+    QTest::newRow("cube.ply") << "inputs/cube.ply" << IO::Format_PLY;
 }
 
 void Test::IO_OccStaticVariablesRollback_test()
@@ -329,177 +674,2356 @@ void Test::IO_OccStaticVariablesRollback_test_data()
     QTest::newRow("var_str2") << "mayo.test.variable_str2" << QVariant("foo") << QVariant("blah");
 }
 
-void Test::BRepUtils_test()
+void Test::IO_OccStaticVariablesContext_test()
 {
-    QVERIFY(BRepUtils::moreComplex(TopAbs_COMPOUND, TopAbs_SOLID));
-    QVERIFY(BRepUtils::moreComplex(TopAbs_SOLID, TopAbs_SHELL));
-    QVERIFY(BRepUtils::moreComplex(TopAbs_SHELL, TopAbs_FACE));
-    QVERIFY(BRepUtils::moreComplex(TopAbs_FACE, TopAbs_EDGE));
-    QVERIFY(BRepUtils::moreComplex(TopAbs_EDGE, TopAbs_VERTEX));
+    Interface_Static::Init("MAYO", "mayo.test.context_int", Interface_ParamInteger, "0");
+    Interface_Static::Init("MAYO", "mayo.test.context_str", Interface_ParamText, "foo");
+
+    IO::OccStaticVariablesContext contextA;
+    contextA.change("mayo.test.context_int", 5);
+    IO::OccStaticVariablesContext contextB;
+    contextB.change("mayo.test.context_int", 5);
+    contextB.change("mayo.test.context_str", "blah");
+    IO::OccStaticVariablesContext contextC;
+    contextC.change("mayo.test.context_int", 8);
+    QVERIFY(contextA.isCompatible(contextB));
+    QVERIFY(contextB.isCompatible(contextA));
+    QVERIFY(!contextA.isCompatible(contextC));
 
+    std::future<int> futureC;
     {
-        const TopoDS_Shape shapeNull;
-        const TopoDS_Shape shapeBase = BRepPrimAPI_MakeBox(25, 25, 25);
-        const TopoDS_Shape shapeCopy = shapeBase;
-        QCOMPARE(BRepUtils::hashCode(shapeNull), -1);
-        QVERIFY(BRepUtils::hashCode(shapeBase) >= 0);
-        QCOMPARE(BRepUtils::hashCode(shapeBase), BRepUtils::hashCode(shapeCopy));
+        // Compatible scopes are active at the same time
+        IO::OccStaticVariablesScope scopeA(contextA);
+        IO::OccStaticVariablesScope scopeB(contextB);
+        QCOMPARE(Interface_Static::IVal("mayo.test.context_int"), 5);
+        QCOMPARE(Interface_Static::CVal("mayo.test.context_str"), "blah");
+
+        // Conflicting scope is blocked until scopes A and B are released
+        futureC = std::async(std::launch::async, [&]{
+            IO::OccStaticVariablesScope scopeC(contextC);
+            return Interface_Static::IVal("mayo.test.context_int");
+        });
+        QVERIFY(futureC.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
     }
+
+    QCOMPARE(futureC.get(), 8);
+    QCOMPARE(Interface_Static::IVal("mayo.test.context_int"), 0);
+    QCOMPARE(Interface_Static::CVal("mayo.test.context_str"), "foo");
 }
 
-void Test::CafUtils_test()
+void Test::IO_OccShapeHealing_test()
 {
-    // TODO Add CafUtils::labelTag() test for multi-threaded safety
+    QFETCH(QString, filepath);
+    QFETCH(IO::OccCommon::ShapeHealing, shapeHealing);
+    auto _ = gsl::finally([]{ PerfStats::setEnabled(false); });
+    PerfStats::setEnabled(true);
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _2 = gsl::finally([=]{ app->closeDocument(doc); });
+
+    std::unique_ptr<IO::Reader> reader;
+    if (filepath.endsWith(".step")) {
+        auto stepReader = std::make_unique<IO::OccStepReader>();
+        stepReader->parameters().shapeHealing = shapeHealing;
+        reader = std::move(stepReader);
+    }
+    else {
+        auto igesReader = std::make_unique<IO::OccIgesReader>();
+        igesReader->parameters().shapeHealing = shapeHealing;
+        reader = std::move(igesReader);
+    }
+
+    const std::string strSequenceBefore = Interface_Static::CVal("read.step.sequence");
+    TDF_LabelSequence seqLabel;
+    TaskManager taskMgr;
+    const TaskId taskId = taskMgr.newTask([&](TaskProgress* progress) {
+        if (reader->readFile(filepathFrom(filepath), progress))
+            seqLabel = reader->transfer(doc, progress);
+    });
+    taskMgr.exec(taskId, TaskAutoDestroy::Off);
+    QVERIFY(!seqLabel.IsEmpty());
+    int faceCount = 0;
+    for (const TDF_Label& label : seqLabel)
+        BRepUtils::forEachSubFace(XCaf::shape(label), [&](const TopoDS_Face&) { ++faceCount; });
+
+    QCOMPARE(faceCount, 6);
+
+    // Healing is timed apart the translation, even when no fix is applied
+    const PerfStats* stats = taskMgr.perfStats(taskId);
+    QVERIFY(stats != nullptr);
+    const std::vector<PerfStats::Stage> vecStage = stats->stages();
+    QVERIFY(std::any_of(vecStage.cbegin(), vecStage.cend(), [](const PerfStats::Stage& stage) {
+        return stage.name == "io.healing" && stage.callCount > 0;
+    }));
+
+    // Static variables selecting the sequence are restored
+    QCOMPARE(Interface_Static::CVal("read.step.sequence"), strSequenceBefore.c_str());
 }
 
-void Test::MeshUtils_orientation_test()
+void Test::IO_OccShapeHealing_test_data()
 {
-    struct BasicPolyline2d : public Mayo::MeshUtils::AdaptorPolyline2d {
-        gp_Pnt2d pointAt(int index) const override { return this->vecPoint.at(index); }
-        int pointCount() const override { return int(this->vecPoint.size()); }
-        std::vector<gp_Pnt2d> vecPoint;
+    QTest::addColumn<QString>("filepath");
+    QTest::addColumn<IO::OccCommon::ShapeHealing>("shapeHealing");
+    for (const char* filepath : { "inputs/cube.step", "inputs/cube.iges" }) {
+        auto fnRowName = [=](const char* healing) { return QByteArray(filepath) + " " + healing; };
+        QTest::newRow(fnRowName("full").constData()) << QString(filepath) << IO::OccCommon::ShapeHealing::Full;
+        QTest::newRow(fnRowName("fast").constData()) << QString(filepath) << IO::OccCommon::ShapeHealing::Fast;
+        QTest::newRow(fnRowName("none").constData()) << QString(filepath) << IO::OccCommon::ShapeHealing::None;
+    }
+}
+
+void Test::IO_OccIgesReader_parallelTransfer_test()
+{
+    auto app = Application::instance();
+    auto fnTransfer = [=](bool parallel) {
+        DocumentPtr doc = app->newDocument();
+        auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+        IO::OccIgesReader reader;
+        reader.parameters().parallelEntityTransfer = parallel;
+        std::vector<int> vecFaceCount;
+        if (reader.readFile(filepathFrom("inputs/cube.iges"), nullptr)) {
+            for (const TDF_Label& label : reader.transfer(doc, nullptr)) {
+                int faceCount = 0;
+                BRepUtils::forEachSubFace(XCaf::shape(label), [&](const TopoDS_Face&) { ++faceCount; });
+                vecFaceCount.push_back(faceCount);
+            }
+        }
+
+        return vecFaceCount;
     };
 
-    QFETCH(std::vector<gp_Pnt2d>, vecPoint);
-    QFETCH(Mayo::MeshUtils::Orientation, orientation);
-    BasicPolyline2d polyline2d;
-    polyline2d.vecPoint = std::move(vecPoint);
-    QCOMPARE(Mayo::MeshUtils::orientation(polyline2d), orientation);
+    // Same entities in the same order
+    const std::vector<int> vecFaceCount = fnTransfer(false);
+    QVERIFY(!vecFaceCount.empty());
+    QVERIFY(fnTransfer(true) == vecFaceCount);
 }
 
-void Test::MeshUtils_orientation_test_data()
+void Test::IO_OccStepReader_concurrentUnits_test()
 {
-    QTest::addColumn<std::vector<gp_Pnt2d>>("vecPoint");
-    QTest::addColumn<Mayo::MeshUtils::Orientation>("orientation");
+    // Copy of "cube.step" whose length unit is inch instead of millimeter
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString inchFilepath = tempDir.filePath("cube_inch.step");
+    {
+        std::ifstream ifs("inputs/cube.step");
+        std::string contents((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        const std::string mmUnit = "#346 = ( LENGTH_UNIT() NAMED_UNIT(*) SI_UNIT(.MILLI.,.METRE.) );";
+        const size_t posUnit = contents.find(mmUnit);
+        QVERIFY(posUnit != std::string::npos);
+        contents.replace(
+                    posUnit,
+                    mmUnit.size(),
+                    "#346 = ( CONVERSION_BASED_UNIT('INCH',#900) LENGTH_UNIT() NAMED_UNIT(#901) );\n"
+                    "#900 = LENGTH_MEASURE_WITH_UNIT(LENGTH_MEASURE(25.4),#902);\n"
+                    "#901 = DIMENSIONAL_EXPONENTS(1.,0.,0.,0.,0.,0.,0.);\n"
+                    "#902 = ( LENGTH_UNIT() NAMED_UNIT(*) SI_UNIT(.MILLI.,.METRE.) );");
+        std::ofstream ofs(inchFilepath.toStdString());
+        ofs << contents;
+        ofs.close();
+        QVERIFY(ofs.good());
+    }
 
-    std::vector<gp_Pnt2d> vecPoint;
-    vecPoint.push_back(gp_Pnt2d(0, 0));
-    vecPoint.push_back(gp_Pnt2d(0, 10));
-    vecPoint.push_back(gp_Pnt2d(10, 10));
-    vecPoint.push_back(gp_Pnt2d(10, 0));
-    vecPoint.push_back(gp_Pnt2d(0, 0)); // Closed polyline
-    QTest::newRow("case1") << vecPoint << Mayo::MeshUtils::Orientation::Clockwise;
+    // Documents are created in the main thread, transfers run in worker threads
+    auto app = Application::instance();
+    auto fnBoxSize = [](const DocumentPtr& doc, const QString& filepath) {
+        IO::OccStepReader reader;
+        if (!reader.readFile(filepathFrom(filepath), nullptr))
+            return -1.;
 
-    vecPoint.erase(std::prev(vecPoint.end())); // Open polyline
-    QTest::newRow("case2") << vecPoint << Mayo::MeshUtils::Orientation::Clockwise;
+        const TDF_LabelSequence seqLabel = reader.transfer(doc, nullptr);
+        const Bnd_Box bndBox = !seqLabel.IsEmpty() ? BRepUtils::boundingBox(XCaf::shape(seqLabel.First())) : Bnd_Box();
+        return !bndBox.IsVoid() ? std::sqrt(bndBox.SquareExtent()) : -1.;
+    };
 
-    std::reverse(vecPoint.begin(), vecPoint.end());
-    QTest::newRow("case3") << vecPoint << Mayo::MeshUtils::Orientation::CounterClockwise;
+    std::vector<DocumentPtr> vecDoc;
+    auto _ = gsl::finally([&]{
+        for (const DocumentPtr& doc : vecDoc)
+            app->closeDocument(doc);
+    });
+    auto fnNewDocument = [&]{
+        vecDoc.push_back(app->newDocument());
+        return vecDoc.back();
+    };
 
-    vecPoint.clear();
-    vecPoint.push_back(gp_Pnt2d(0, 0));
-    vecPoint.push_back(gp_Pnt2d(0, 10));
-    vecPoint.push_back(gp_Pnt2d(10, 10));
-    QTest::newRow("case4") << vecPoint << Mayo::MeshUtils::Orientation::Clockwise;
+    const double mmSize = fnBoxSize(fnNewDocument(), "inputs/cube.step");
+    const double inchSize = fnBoxSize(fnNewDocument(), inchFilepath);
+    QVERIFY(mmSize > 0);
+    QVERIFY(std::abs(inchSize - 25.4 * mmSize) < 1e-6 * inchSize);
 
-    vecPoint.clear();
-    vecPoint.push_back(gp_Pnt2d(0, 0));
-    vecPoint.push_back(gp_Pnt2d(0, 10));
-    vecPoint.push_back(gp_Pnt2d(-10, 10));
-    vecPoint.push_back(gp_Pnt2d(-10, 0));
-    QTest::newRow("case5") << vecPoint << Mayo::MeshUtils::Orientation::CounterClockwise;
+    // Unit factors of one transfer must not be applied to the geometry of the other one
+    for (int i = 0; i < 4; ++i) {
+        const DocumentPtr mmDoc = fnNewDocument();
+        const DocumentPtr inchDoc = fnNewDocument();
+        auto mmFuture = std::async(std::launch::async, [=]{ return fnBoxSize(mmDoc, "inputs/cube.step"); });
+        auto inchFuture = std::async(std::launch::async, [=]{ return fnBoxSize(inchDoc, inchFilepath); });
+        QVERIFY(std::abs(mmFuture.get() - mmSize) < 1e-6 * mmSize);
+        QVERIFY(std::abs(inchFuture.get() - inchSize) < 1e-6 * inchSize);
+    }
+}
 
-    std::reverse(vecPoint.begin(), vecPoint.end());
-    QTest::newRow("case6") << vecPoint << Mayo::MeshUtils::Orientation::Clockwise;
+void Test::IO_OccStlReader_test()
+{
+    QFETCH(QString, filepath);
+    QFETCH(bool, mergeNodes);
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
 
-    {
-        QFile file("inputs/mayo_bezier_curve.brep");
-        QVERIFY(file.open(QIODevice::ReadOnly));
+    IO::OccStlReader reader;
+    reader.parameters().mergeNodes = mergeNodes;
+    QVERIFY(reader.readFile(filepathFrom(filepath), nullptr));
+    const TDF_LabelSequence seqLabel = reader.transfer(doc, nullptr);
+    QCOMPARE(seqLabel.Size(), 1);
+    auto attrTriangulation = CafUtils::findAttribute<TDataXtd_Triangulation>(seqLabel.First());
+    QVERIFY(!attrTriangulation.IsNull());
+    const Handle_Poly_Triangulation mesh = attrTriangulation->Get();
+    QVERIFY(!mesh.IsNull());
 
-        const TopoDS_Shape shape = BRepUtils::shapeFromString(file.readAll().toStdString());
-        QVERIFY(!shape.IsNull());
+    // Merged nodes and triangles must match the ones of OpenCascade reader
+    const Handle_Poly_Triangulation meshOcc = RWStl::ReadFile(filepath.toUtf8().constData());
+    QVERIFY(!meshOcc.IsNull());
+    QCOMPARE(mesh->NbTriangles(), meshOcc->NbTriangles());
+    if (mergeNodes) {
+        QCOMPARE(mesh->NbNodes(), meshOcc->NbNodes());
+    }
+    else {
+        QCOMPARE(mesh->NbNodes(), 3 * mesh->NbTriangles());
+        QVERIFY(mesh->HasNormals());
+    }
 
-        TopoDS_Edge edge;
-        BRepUtils::forEachSubShape(shape, TopAbs_EDGE, [&](const TopoDS_Shape& subShape) {
-            edge = TopoDS::Edge(subShape);
-        });
-        QVERIFY(!edge.IsNull());
+    for (const Poly_Triangle& tri : mesh->Triangles()) {
+        int n1, n2, n3;
+        tri.Get(n1, n2, n3);
+        QVERIFY(n1 >= 1 && n1 <= mesh->NbNodes());
+        QVERIFY(n2 >= 1 && n2 <= mesh->NbNodes());
+        QVERIFY(n3 >= 1 && n3 <= mesh->NbNodes());
+        QVERIFY(n1 != n2 && n2 != n3 && n1 != n3);
+    }
+}
 
-        const GCPnts_TangentialDeflection discr(BRepAdaptor_Curve(edge), 0.1, 0.1);
-        vecPoint.clear();
-        for (int i = 1; i <= discr.NbPoints(); ++i) {
-            const gp_Pnt pnt = discr.Value(i);
-            vecPoint.push_back(gp_Pnt2d(pnt.X(), pnt.Y()));
-        }
+void Test::IO_OccStlReader_test_data()
+{
+    QTest::addColumn<QString>("filepath");
+    QTest::addColumn<bool>("mergeNodes");
+    QTest::newRow("cube.stla") << "inputs/cube.stla" << true;
+    QTest::newRow("cube.stlb") << "inputs/cube.stlb" << true;
+    QTest::newRow("cube.stla-soup") << "inputs/cube.stla" << false;
+    QTest::newRow("cube.stlb-soup") << "inputs/cube.stlb" << false;
+}
 
-        QTest::newRow("case7") << vecPoint << Mayo::MeshUtils::Orientation::CounterClockwise;
+void Test::IO_OccStlWriter_test()
+{
+    QFETCH(IO::OccStlWriter::Format, format);
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
 
-        std::reverse(vecPoint.begin(), vecPoint.end());
-        QTest::newRow("case8") << vecPoint << Mayo::MeshUtils::Orientation::Clockwise;
+    // Two free shapes, written without being gathered in a compound
+    const TopoDS_Shape boxA = BRepPrimAPI_MakeBox(10, 10, 10);
+    const TopoDS_Shape boxB = BRepPrimAPI_MakeBox(gp_Pnt(20, 0, 0), 5, 5, 5);
+    for (const TopoDS_Shape& box : { boxA, boxB }) {
+        BRepMesh_IncrementalMesh mesher(box, 1.);
+        doc->xcaf().shapeTool()->SetShape(doc->xcaf().shapeTool()->NewShape(), box);
     }
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString filepath = tempDir.filePath("boxes.stl");
+    IO::OccStlWriter writer;
+    writer.parameters().format = format;
+    const ApplicationItem appItem(doc);
+    QVERIFY(writer.transfer(Span<const ApplicationItem>(&appItem, 1), nullptr));
+    QVERIFY(writer.writeFile(filepathFrom(filepath), nullptr));
+
+    const Handle_Poly_Triangulation mesh = RWStl::ReadFile(filepath.toUtf8().constData());
+    QVERIFY(!mesh.IsNull());
+    QCOMPARE(mesh->NbTriangles(), 2 * 12);
+    QCOMPARE(mesh->NbNodes(), 2 * 8);
 }
 
-void Test::MetaEnum_test()
+void Test::IO_OccStlWriter_test_data()
 {
-    QCOMPARE(MetaEnum::name(TopAbs_VERTEX), "TopAbs_VERTEX");
-    QCOMPARE(MetaEnum::name(TopAbs_EDGE), "TopAbs_EDGE");
-    QCOMPARE(MetaEnum::name(TopAbs_WIRE), "TopAbs_WIRE");
-    QCOMPARE(MetaEnum::name(TopAbs_FACE), "TopAbs_FACE");
-    QCOMPARE(MetaEnum::name(TopAbs_SHELL), "TopAbs_SHELL");
-    QCOMPARE(MetaEnum::nameWithoutPrefix(TopAbs_SOLID, "TopAbs_"), "SOLID");
-    QCOMPARE(MetaEnum::nameWithoutPrefix(TopAbs_COMPOUND, "TopAbs_"), "COMPOUND");
-
-    QCOMPARE(MetaEnum::nameWithoutPrefix(TopAbs_VERTEX, "Abs"), "TopAbs_VERTEX");
-    QCOMPARE(MetaEnum::nameWithoutPrefix(TopAbs_VERTEX, ""), "TopAbs_VERTEX");
+    QTest::addColumn<IO::OccStlWriter::Format>("format");
+    QTest::newRow("binary") << IO::OccStlWriter::Format::Binary;
+    QTest::newRow("ascii") << IO::OccStlWriter::Format::Ascii;
 }
 
-void Test::MeshUtils_test()
+void Test::IO_streams_test()
 {
-    // Create box
-    QFETCH(double, boxDx);
-    QFETCH(double, boxDy);
-    QFETCH(double, boxDz);
-    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(boxDx, boxDy, boxDz);
+    auto app = Application::instance();
+    auto ioSystem = app->ioSystem();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
 
-    // Mesh box
-    {
-        BRepMesh_IncrementalMesh mesher(shapeBox, 0.1);
-        mesher.Perform();
-        QVERIFY(mesher.IsDone());
-    }
+    const TopoDS_Shape box = BRepPrimAPI_MakeBox(10, 10, 10);
+    BRepMesh_IncrementalMesh mesher(box, 1.);
+    doc->xcaf().shapeTool()->SetShape(doc->xcaf().shapeTool()->NewShape(), box);
 
-    // Count nodes and triangles
-    int countNode = 0;
-    int countTriangle = 0;
-    BRepUtils::forEachSubFace(shapeBox, [&](const TopoDS_Face& face) {
-        TopLoc_Location loc;
-        const Handle_Poly_Triangulation& polyTri = BRep_Tool::Triangulation(face, loc);
-        if (!polyTri.IsNull()) {
-            countNode += polyTri->NbNodes();
-            countTriangle += polyTri->NbTriangles();
-        }
-    });
+    // Write to memory stream
+    std::ostringstream ostr(std::ios::out | std::ios::binary);
+    IO::OccStlWriter writer;
+    const ApplicationItem appItem(doc);
+    QVERIFY(writer.transfer(Span<const ApplicationItem>(&appItem, 1), nullptr));
+    QVERIFY(writer.writeStream(ostr, nullptr));
+    const std::string data = ostr.str();
+    QVERIFY(!data.empty());
 
-    // Merge all face triangulations into one
-    Handle_Poly_Triangulation polyTriBox = new Poly_Triangulation(countNode, countTriangle, false);
-    {
-        int idNodeOffset = 0;
-        int idTriangleOffset = 0;
-        BRepUtils::forEachSubFace(shapeBox, [&](const TopoDS_Face& face) {
-            TopLoc_Location loc;
-            const Handle_Poly_Triangulation& polyTri = BRep_Tool::Triangulation(face, loc);
-            if (!polyTri.IsNull()) {
-                for (int i = 1; i <= polyTri->NbNodes(); ++i)
-                    polyTriBox->ChangeNode(idNodeOffset + i) = polyTri->Node(i);
+    // Probing must not consume the stream
+    StreamUtils::MemoryInputBuffer buffer(data.data(), data.size());
+    std::istream istr(&buffer);
+    QVERIFY(StreamUtils::isSeekable(istr));
+    QCOMPARE(ioSystem->probeFormat(istr), IO::Format_STL);
+    QCOMPARE(int(istr.tellg()), 0);
 
-                for (int i = 1; i <= polyTri->NbTriangles(); ++i) {
-                    int n1, n2, n3;
-                    polyTri->Triangle(i).Get(n1, n2, n3);
-                    polyTriBox->ChangeTriangle(idTriangleOffset + i).Set(
-                                idNodeOffset + n1, idNodeOffset + n2, idNodeOffset + n3);
-                }
+    // Read back from memory stream
+    IO::OccStlReader reader;
+    QVERIFY(reader.readStream(istr, "box.stl", nullptr));
+    const TDF_LabelSequence seqLabel = reader.transfer(doc, nullptr);
+    QCOMPARE(seqLabel.Size(), 1);
+    auto attrTriangulation = CafUtils::findAttribute<TDataXtd_Triangulation>(seqLabel.First());
+    QVERIFY(!attrTriangulation.IsNull());
+    QCOMPARE(attrTriangulation->Get()->NbTriangles(), 12);
 
-                idNodeOffset += polyTri->NbNodes();
-                idTriangleOffset += polyTri->NbTriangles();
+    {   // Non-seekable stream(like a pipe) is gathered in memory before format probing
+        struct PipeBuffer : public std::streambuf {
+            PipeBuffer(const std::string& data) {
+                char* ptr = const_cast<char*>(data.data());
+                this->setg(ptr, ptr, ptr + data.size());
             }
-        });
+        };
+        PipeBuffer pipeBuffer(data);
+        std::istream pipeStream(&pipeBuffer);
+        QVERIFY(!StreamUtils::isSeekable(pipeStream));
+        DocumentPtr docPipe = app->newDocument();
+        auto _ = gsl::finally([=]{ app->closeDocument(docPipe); });
+        const bool ok = ioSystem->importInDocument()
+                .targetDocument(docPipe)
+                .withInputStream(&pipeStream, "stdin")
+                .execute();
+        QVERIFY(ok);
+        QCOMPARE(docPipe->entityCount(), 1);
     }
 
-    // Checks
-    QCOMPARE(MeshUtils::triangulationVolume(polyTriBox),
-             double(boxDx * boxDy * boxDz));
+    {   // Default readStream() implementation spools to a temporary file
+        std::ifstream ifs("inputs/cube.brep", std::ios::in | std::ios::binary);
+        QVERIFY(ifs.is_open());
+        IO::OccBRepReader reader;
+        QVERIFY(reader.readStream(ifs, "cube.brep", nullptr));
+        QCOMPARE(reader.transfer(doc, nullptr).Size(), 1);
+    }
+}
+
+void Test::IO_compressedInput_test()
+{
+    QCOMPARE(DecompressionUtils::probe(std::string_view("\x1f\x8b\x08\x00", 4)), CompressionFormat::Gzip);
+    QCOMPARE(DecompressionUtils::probe(std::string_view("PK\x03\x04", 4)), CompressionFormat::Zip);
+    QCOMPARE(DecompressionUtils::probe(std::string_view("solid")), CompressionFormat::None);
+    QCOMPARE(DecompressionUtils::probe(std::string_view()), CompressionFormat::None);
+    QCOMPARE(DecompressionUtils::innerFilepath("part.stp.gz"), FilePath("part.stp"));
+    QCOMPARE(DecompressionUtils::innerFilepath("part.stpZ"), FilePath("part.stp"));
+    QCOMPARE(DecompressionUtils::innerFilepath("parts.zip"), FilePath("parts"));
+    QCOMPARE(DecompressionUtils::innerFilepath("part.step"), FilePath("part.step"));
+
+    // Zip archive holding "cube.stla" stored without compression
+    QFile fileStl("inputs/cube.stla");
+    QVERIFY(fileStl.open(QIODevice::ReadOnly));
+    const QByteArray bytesStl = fileStl.readAll();
+    auto fnLe16 = [](uint16_t v) {
+        QByteArray bytes;
+        bytes.append(char(v & 0xFF)).append(char(v >> 8));
+        return bytes;
+    };
+    auto fnLe32 = [=](uint32_t v) { return fnLe16(v & 0xFFFF) + fnLe16(v >> 16); };
+    const QByteArray entryName = "cube.stla";
+    QByteArray bytesZip;
+    bytesZip += fnLe32(0x04034b50) + fnLe16(10) + fnLe16(0) + fnLe16(0); // Signature, version, flags, method
+    bytesZip += fnLe16(0) + fnLe16(0) + fnLe32(0); // Time, date, crc(not checked)
+    bytesZip += fnLe32(bytesStl.size()) + fnLe32(bytesStl.size());
+    bytesZip += fnLe16(entryName.size()) + fnLe16(0) + entryName + bytesStl;
+    const std::string_view zipData(bytesZip.constData(), bytesZip.size());
+    QCOMPARE(DecompressionUtils::probe(zipData), CompressionFormat::Zip);
+    QCOMPARE(DecompressionUtils::uncompressedSizeHint(zipData, {}, CompressionFormat::Zip), uint64_t(bytesStl.size()));
+
+    FilePath innerName;
+    const std::string head = DecompressionUtils::decompressHead(zipData, CompressionFormat::Zip, 64, &innerName);
+    QCOMPARE(innerName, FilePath("cube.stla"));
+    QCOMPARE(QByteArray::fromStdString(head), bytesStl.left(64));
+
+    {   // Stream through the worker thread
+        std::istringstream source(std::string(zipData), std::ios::in | std::ios::binary);
+        DecompressionInputStream istr(source, CompressionFormat::Zip);
+        std::string data;
+        QVERIFY(StreamUtils::readAll(istr, &data));
+        QVERIFY(!istr.buffer().hasError());
+        QCOMPARE(QByteArray::fromStdString(data), bytesStl);
+    }
+
+    {   // Truncated data
+        std::istringstream source(std::string(zipData.substr(0, zipData.size() / 2)));
+        DecompressionInputStream istr(source, CompressionFormat::Zip);
+        std::string data;
+        StreamUtils::readAll(istr, &data);
+        QVERIFY(istr.buffer().hasError());
+    }
+
+    if (DecompressionUtils::isAvailable()) {
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        const QString filepath = tempDir.filePath("cube.zip");
+        QFile fileZip(filepath);
+        QVERIFY(fileZip.open(QIODevice::WriteOnly));
+        fileZip.write(bytesZip);
+        fileZip.close();
+        auto app = Application::instance();
+        QCOMPARE(app->ioSystem()->probeFormat(filepathFrom(filepath)), IO::Format_STL);
+        DocumentPtr doc = app->newDocument();
+        auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+        const bool ok = app->ioSystem()->importInDocument()
+                .targetDocument(doc)
+                .withFilepath(filepathFrom(filepath))
+                .execute();
+        QVERIFY(ok);
+        QCOMPARE(doc->entityCount(), 1);
+    }
+}
+
+void Test::IO_asyncFileStreams_test()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const FilePath filepath = filepathFrom(tempDir.filePath("data.bin"));
+    std::string data(100 * 1000 + 17, '\0');
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = char((i * 7919) % 251);
+
+    {   // Small blocks, so the buffers are swapped many times
+        std::ofstream ofs(filepath, std::ios::out | std::ios::binary);
+        AsyncOutputBuffer buffer(ofs, 1000);
+        std::ostream ostr(&buffer);
+        ostr.write(data.data(), 50 * 1000);
+        for (size_t i = 50 * 1000; i < data.size(); ++i)
+            ostr.put(data[i]);
+
+        QVERIFY(ostr.flush().good());
+        QVERIFY(!buffer.hasError());
+    }
+
+    {
+        ReadAheadInputBuffer buffer(filepath, 4096, 2);
+        QVERIFY(buffer.isOpen());
+        std::istream istr(&buffer);
+        std::string dataRead;
+        QVERIFY(StreamUtils::readAll(istr, &dataRead));
+        QVERIFY(!buffer.hasError());
+        QVERIFY(dataRead == data);
+
+        // Seeking restarts the read-ahead, or moves within the current block
+        istr.clear();
+        QCOMPARE(int64_t(istr.seekg(0, std::ios::end).tellg()), int64_t(data.size()));
+        for (size_t pos : { size_t(50 * 1000), size_t(50 * 1000 + 10), size_t(5), data.size() - 3 }) {
+            char bytes[3] = {};
+            istr.seekg(pos);
+            istr.read(bytes, sizeof(bytes));
+            QCOMPARE(int(istr.gcount()), 3);
+            QCOMPARE(std::string_view(bytes, 3), std::string_view(data).substr(pos, 3));
+            QCOMPARE(int64_t(istr.tellg()), int64_t(pos + 3));
+        }
+    }
+
+    QVERIFY(!ReadAheadInputStream(filepathFrom(tempDir.filePath("unknown.bin"))).good());
+
+    {   // File is complete once closed
+        const FilePath filepathCopy = filepathFrom(tempDir.filePath("copy.bin"));
+        AsyncFileOutputStream outs(filepathCopy);
+        QVERIFY(outs.isOpen());
+        outs.write(data.data(), data.size());
+        QVERIFY(outs.close());
+        QCOMPARE(int64_t(std::filesystem::file_size(filepathCopy)), int64_t(data.size()));
+    }
+
+    QVERIFY(!AsyncFileOutputStream(filepathFrom(tempDir.filePath("unknown_dir/out.bin"))).isOpen());
+
+    // Import through the read-ahead stream
+    auto app = Application::instance();
+    auto ioSystem = app->ioSystem();
+    ioSystem->setFileReadAheadEnabled(true);
+    auto _ = gsl::finally([=]{ ioSystem->setFileReadAheadEnabled(false); });
+    DocumentPtr doc = app->newDocument();
+    auto _doc = gsl::finally([=]{ app->closeDocument(doc); });
+    const bool ok = ioSystem->importInDocument()
+            .targetDocument(doc)
+            .withFilepath("inputs/cube.stla")
+            .execute();
+    QVERIFY(ok);
+    QCOMPARE(doc->entityCount(), 1);
+}
+
+void Test::IO_scanMetadata_STEP_test()
+{
+    auto ioSystem = Application::instance()->ioSystem();
+    const std::optional<IO::System::FileMetadata> metadata = ioSystem->scanMetadata("inputs/cube.step");
+    QVERIFY(metadata.has_value());
+    QCOMPARE(metadata->format, IO::Format_STEP);
+    QCOMPARE(metadata->name, QString("D:/dev/projects/fougue/mayo/tests/inputs/cube.step"));
+    QCOMPARE(metadata->description, QString("FreeCAD Model"));
+    QCOMPARE(metadata->timestamp, QString("2020-03-05T17:54:24"));
+    QCOMPARE(metadata->author, QString("Author"));
+    QVERIFY(metadata->organization.isEmpty());
+    QCOMPARE(metadata->authoringSystem, QString("FreeCAD"));
+    QCOMPARE(metadata->preprocessorVersion, QString("Open CASCADE STEP processor 7.3"));
+    QCOMPARE(metadata->schemas, QStringList("AUTOMOTIVE_DESIGN { 1 0 10303 214 1 1 1 1 }"));
+    QCOMPARE(metadata->productNames, QStringList("Cube"));
+    QCOMPARE(metadata->entityCount, int64_t(361));
+
+    // Not a STEP file
+    QVERIFY(!ioSystem->scanMetadata("inputs/cube.stla").has_value());
+
+    // Encoded strings, comments and quotes
+    std::istringstream istr(
+                "ISO-10303-21;\n"
+                "HEADER;\n"
+                "/* comment; with semicolon */\n"
+                "FILE_DESCRIPTION(('It''s; fine'),'2;1');\n"
+                "FILE_NAME('\\X2\\00E9\\X0\\t\\X\\E9','',(''),(''),'','Sys\\\\','');\n"
+                "FILE_SCHEMA(('CONFIG_CONTROL_DESIGN'));\n"
+                "ENDSEC;\n"
+                "DATA;\n"
+                "#1=PRODUCT('id1','Part;1','',(#2));\n"
+                "#2=(NAMED_UNIT(*)SI_UNIT($,.METRE.));\n"
+                "#3 = PRODUCT('id3','','',(#2));\n"
+                "ENDSEC;\n"
+                "END-ISO-10303-21;\n");
+    IO::System::FileMetadata metadataStream;
+    QVERIFY(IO::scanMetadata_STEP(istr, &metadataStream));
+    QCOMPARE(metadataStream.description, QString("It's; fine"));
+    QCOMPARE(metadataStream.name, QString::fromUtf8("\xc3\xa9t\xc3\xa9"));
+    QCOMPARE(metadataStream.authoringSystem, QString("Sys\\"));
+    QCOMPARE(metadataStream.schemas, QStringList("CONFIG_CONTROL_DESIGN"));
+    QCOMPARE(metadataStream.productNames, QStringList({ "Part;1", "id3" }));
+    QCOMPARE(metadataStream.entityCount, int64_t(3));
+}
+
+void Test::IO_readerPool_test()
+{
+    auto app = Application::instance();
+    IO::System system;
+    system.addFactoryReader(std::make_unique<IO::OccFactoryReader>());
+    for (const IO::Format& format : { IO::Format_STEP, IO::Format_IGES }) {
+        const FilePath filepath = format == IO::Format_STEP ? "inputs/cube.step" : "inputs/cube.iges";
+        std::unique_ptr<IO::Reader> reader = system.takeReader(format);
+        QVERIFY(reader);
+        const IO::Reader* ptrReader = reader.get();
+        int firstEntityCount = 0;
+        for (int i = 0; i < 2; ++i) {
+            DocumentPtr doc = app->newDocument();
+            auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+            QVERIFY(reader->readFile(filepath, nullptr));
+            const int entityCount = reader->transfer(doc, nullptr).Size();
+            QVERIFY(entityCount > 0);
+            // Entities of the previous session must not be transferred again
+            if (i == 0)
+                firstEntityCount = entityCount;
+            else
+                QCOMPARE(entityCount, firstEntityCount);
+
+            system.recycleReader(format, std::move(reader));
+            reader = system.takeReader(format);
+            QCOMPARE(reader.get(), ptrReader);
+        }
+    }
+}
+
+void Test::IO_ThreeMfWriter_test()
+{
+#ifdef HAVE_ZLIB
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const TopoDS_Shape boxA = BRepPrimAPI_MakeBox(10, 10, 10);
+    const TopoDS_Shape boxB = BRepPrimAPI_MakeBox(gp_Pnt(20, 0, 0), 5, 5, 5);
+    for (const TopoDS_Shape& box : { boxA, boxB }) {
+        BRepMesh_IncrementalMesh mesher(box, 1.);
+        const TDF_Label label = doc->xcaf().shapeTool()->NewShape();
+        doc->xcaf().shapeTool()->SetShape(label, box);
+        doc->addEntityTreeNode(label);
+    }
+
+    std::ostringstream ostr(std::ios::out | std::ios::binary);
+    IO::ThreeMfWriter writer;
+    const ApplicationItem appItem(doc);
+    QVERIFY(writer.transfer(Span<const ApplicationItem>(&appItem, 1), nullptr));
+    QVERIFY(writer.writeStream(ostr, nullptr));
+    const std::string data = ostr.str();
+    QCOMPARE(DecompressionUtils::probe(data), CompressionFormat::Zip);
+
+    // Decompress the model part, found from its local header
+    const std::string modelEntryName = "3D/3dmodel.model";
+    const size_t posModelName = data.find(modelEntryName);
+    QVERIFY(posModelName != std::string::npos && posModelName >= 30);
+    std::istringstream source(data.substr(posModelName - 30), std::ios::in | std::ios::binary);
+    DecompressionInputStream istr(source, CompressionFormat::Zip);
+    std::string model;
+    QVERIFY(StreamUtils::readAll(istr, &model));
+    QVERIFY(!istr.buffer().hasError());
+
+    auto fnCount = [&](std::string_view token) {
+        int count = 0;
+        for (size_t pos = model.find(token); pos != std::string::npos; pos = model.find(token, pos + 1))
+            ++count;
+
+        return count;
+    };
+    QCOMPARE(fnCount("<object "), 2);
+    QCOMPARE(fnCount("<item "), 2);
+    // Nodes shared by the faces are merged
+    QCOMPARE(fnCount("<vertex "), 2 * 8);
+    QCOMPARE(fnCount("<triangle "), 2 * 12);
+    QVERIFY(model.find("</model>") != std::string::npos);
+#else
+    QSKIP("3MF writer requires zlib");
+#endif
+}
+
+void Test::IO_OccObjWriter_test()
+{
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const TopoDS_Shape boxA = BRepPrimAPI_MakeBox(10, 10, 10);
+    const TopoDS_Shape boxB = BRepPrimAPI_MakeBox(gp_Pnt(20, 0, 0), 5, 5, 5);
+    for (const TopoDS_Shape& box : { boxA, boxB }) {
+        BRepMesh_IncrementalMesh mesher(box, 1.);
+        const TDF_Label label = doc->xcaf().shapeTool()->NewShape();
+        doc->xcaf().shapeTool()->SetShape(label, box);
+        doc->addEntityTreeNode(label);
+    }
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString filepath = tempDir.filePath("boxes.obj");
+    IO::OccObjWriter writer;
+    writer.parameters().writeNormals = false;
+    const ApplicationItem appItem(doc);
+    QVERIFY(writer.transfer(Span<const ApplicationItem>(&appItem, 1), nullptr));
+    QVERIFY(writer.writeFile(filepathFrom(filepath), nullptr));
+    QVERIFY(QFileInfo::exists(tempDir.filePath("boxes.mtl")));
+
+    QFile file(filepath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    auto fnCount = [&](const char* prefix) {
+        return int(std::count_if(lines.cbegin(), lines.cend(), [=](const QByteArray& line) {
+            return line.startsWith(prefix);
+        }));
+    };
+    QCOMPARE(fnCount("mtllib boxes.mtl"), 1);
+    QCOMPARE(fnCount("o "), 2);
+    QCOMPARE(fnCount("usemtl "), 2);
+    QCOMPARE(fnCount("vn "), 0);
+    // Each box face has its own triangulation of 4 nodes and 2 triangles
+    QCOMPARE(fnCount("v "), 2 * 6 * 4);
+    QCOMPARE(fnCount("f "), 2 * 12);
+
+    // Indices are global to the file
+    const QByteArray lastFace = *std::find_if(lines.crbegin(), lines.crend(), [](const QByteArray& line) {
+        return line.startsWith("f ");
+    });
+    int maxIndex = 0;
+    for (const QByteArray& token : lastFace.mid(2).split(' '))
+        maxIndex = std::max(maxIndex, token.split('/').front().toInt());
+
+    QVERIFY(maxIndex > 6 * 4 && maxIndex <= 2 * 6 * 4);
+
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    // Read back
+    DocumentPtr docCopy = app->newDocument();
+    auto _2 = gsl::finally([=]{ app->closeDocument(docCopy); });
+    IO::OccObjReader reader;
+    QVERIFY(reader.readFile(filepathFrom(filepath), nullptr));
+    const TDF_LabelSequence seqLabel = reader.transfer(docCopy, nullptr);
+    int triangleCount = 0;
+    for (const TDF_Label& label : seqLabel) {
+        BRepUtils::forEachSubFace(XCaf::shape(label), [&](const TopoDS_Face& face) {
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation& mesh = BRep_Tool::Triangulation(face, loc);
+            triangleCount += !mesh.IsNull() ? mesh->NbTriangles() : 0;
+        });
+    }
+
+    QCOMPARE(triangleCount, 2 * 12);
+#endif
+}
+
+void Test::IO_PlyReaderWriter_test()
+{
+    QFETCH(IO::PlyWriter::Format, format);
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+
+    auto fnReadMeshEntity = [=](const FilePath& filepath) {
+        IO::PlyReader reader;
+        TDF_Label label;
+        if (reader.readFile(filepath, nullptr)) {
+            const TDF_LabelSequence seqLabel = reader.transfer(doc, nullptr);
+            if (seqLabel.Size() == 1)
+                label = seqLabel.First();
+        }
+
+        return label;
+    };
+
+    // Quads are fan-triangulated, colors are stored at nodes
+    const TDF_Label labelCube = fnReadMeshEntity(filepathFrom("inputs/cube.ply"));
+    QVERIFY(!labelCube.IsNull());
+    doc->addEntityTreeNode(labelCube);
+    const Handle_Poly_Triangulation meshCube = CafUtils::findAttribute<TDataXtd_Triangulation>(labelCube)->Get();
+    QCOMPARE(meshCube->NbNodes(), 8);
+    QCOMPARE(meshCube->NbTriangles(), 12);
+    QVERIFY(meshCube->Node(7).IsEqual(gp_Pnt(10, 10, 10), Precision::Confusion()));
+    const std::vector<uint32_t> vecCubeColor = MeshNodeColors::get(labelCube);
+    QCOMPARE(int(vecCubeColor.size()), 8);
+    QCOMPARE(vecCubeColor.at(0), MeshNodeColors::packRgb(255, 0, 0));
+    QCOMPARE(vecCubeColor.at(5), MeshNodeColors::packRgb(0, 255, 255));
+    QVERIFY(std::abs(MeshUtils::triangulationVolume(meshCube) - 1000.) < 1e-6); // Faces are outward
+
+    // Round trip
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString filepath = tempDir.filePath("cube.ply");
+    IO::PlyWriter writer;
+    writer.parameters().format = format;
+    const ApplicationItem appItem(doc);
+    QVERIFY(writer.transfer(Span<const ApplicationItem>(&appItem, 1), nullptr));
+    QVERIFY(writer.writeFile(filepathFrom(filepath), nullptr));
+    QCOMPARE(app->ioSystem()->probeFormat(filepathFrom(filepath)), IO::Format_PLY);
+
+    const TDF_Label labelCopy = fnReadMeshEntity(filepathFrom(filepath));
+    QVERIFY(!labelCopy.IsNull());
+    const Handle_Poly_Triangulation meshCopy = CafUtils::findAttribute<TDataXtd_Triangulation>(labelCopy)->Get();
+    QCOMPARE(meshCopy->NbNodes(), meshCube->NbNodes());
+    QCOMPARE(meshCopy->NbTriangles(), meshCube->NbTriangles());
+    for (int i = 1; i <= meshCube->NbNodes(); ++i)
+        QVERIFY(meshCopy->Node(i).IsEqual(meshCube->Node(i), Precision::Confusion()));
+
+    for (int i = 1; i <= meshCube->NbTriangles(); ++i) {
+        int n1, n2, n3;
+        meshCube->Triangle(i).Get(n1, n2, n3);
+        int m1, m2, m3;
+        meshCopy->Triangle(i).Get(m1, m2, m3);
+        QCOMPARE(m1, n1);
+        QCOMPARE(m2, n2);
+        QCOMPARE(m3, n3);
+    }
+
+    QVERIFY(MeshNodeColors::get(labelCopy) == vecCubeColor);
+}
+
+void Test::IO_PlyReaderWriter_test_data()
+{
+    QTest::addColumn<IO::PlyWriter::Format>("format");
+    QTest::newRow("binary") << IO::PlyWriter::Format::BinaryLittleEndian;
+    QTest::newRow("ascii") << IO::PlyWriter::Format::Ascii;
+}
+
+void Test::IO_PointCloudReader_test()
+{
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    auto fnNodePointCount = [](const PointCloud& cloud) {
+        uint64_t count = 0;
+        for (int i = 0; i < cloud.nodeCount(); ++i) {
+            const uint64_t nodeCount = cloud.nodePoints(i).size();
+            if (nodeCount != cloud.node(i).pointCount)
+                return std::numeric_limits<uint64_t>::max();
+
+            count += nodeCount;
+        }
+
+        return count;
+    };
+
+    // XYZ grid of 20x20x20 colored points, octree is small enough to require several levels
+    // and to move points out to the page file
+    {
+        const QString filepath = tempDir.filePath("grid.xyz");
+        QFile file(filepath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("// x y z r g b\n");
+        for (int i = 0; i < 20; ++i) {
+            for (int j = 0; j < 20; ++j) {
+                for (int k = 0; k < 20; ++k)
+                    file.write(QString("%1 %2 %3 %4 %5 %6\n").arg(i).arg(j).arg(k).arg(10 * i).arg(10 * j).arg(10 * k).toUtf8());
+            }
+        }
+
+        file.close();
+        IO::PointCloudReader reader(IO::Format_XYZ);
+        PointCloud::Options options;
+        options.nodeGridSize = 4;
+        options.maxInMemoryPointCount = 1000;
+        reader.setCloudOptions(options);
+        QVERIFY(reader.readFile(filepathFrom(filepath), nullptr));
+        const TDF_LabelSequence seqLabel = reader.transfer(doc, nullptr);
+        QCOMPARE(seqLabel.Size(), 1);
+        auto attrCloud = CafUtils::findAttribute<PointCloudAttribute>(seqLabel.First());
+        QVERIFY(attrCloud && attrCloud->get());
+        const PointCloud& cloud = *attrCloud->get();
+        QCOMPARE(cloud.pointCount(), uint64_t(8000));
+        QVERIFY(cloud.hasColors());
+        QVERIFY(cloud.nodeCount() > 1);
+        QVERIFY(cloud.node(cloud.rootNodeId()).pointCount <= 4 * 4 * 4);
+        QVERIFY(cloud.inMemoryPointCount() < cloud.pointCount());
+        QCOMPARE(fnNodePointCount(cloud), uint64_t(8000));
+        QVERIFY(cloud.boundingBox().CornerMin().IsEqual(gp_Pnt(0, 0, 0), Precision::Confusion()));
+        QVERIFY(cloud.boundingBox().CornerMax().IsEqual(gp_Pnt(19, 19, 19), Precision::Confusion()));
+
+        // Point(19, 0, 5) is somewhere in the octree with its color
+        bool found = false;
+        for (int i = 0; i < cloud.nodeCount() && !found; ++i) {
+            for (const PointCloud::Point& point : cloud.nodePoints(i)) {
+                const gp_Pnt pnt(cloud.origin().X() + point.x, cloud.origin().Y() + point.y, cloud.origin().Z() + point.z);
+                if (pnt.IsEqual(gp_Pnt(19, 0, 5), 1e-4)) {
+                    QCOMPARE(point.rgb, uint32_t((190 << 16) | (0 << 8) | 50));
+                    found = true;
+                }
+            }
+        }
+
+        QVERIFY(found);
+    }
+
+    // LAS 1.2, point data record format 2(with 16 bits RGB)
+    {
+        const int headerSize = 227;
+        const int recordLength = 26;
+        const int pointCount = 3;
+        QByteArray bytes(headerSize + pointCount * recordLength, '\0');
+        auto data = reinterpret_cast<uchar*>(bytes.data());
+        auto fnSetDouble = [=](int offset, double value) {
+            quint64 bits;
+            std::memcpy(&bits, &value, sizeof(double));
+            qToLittleEndian<quint64>(bits, data + offset);
+        };
+        std::memcpy(data, "LASF", 4);
+        data[24] = 1;
+        data[25] = 2;
+        qToLittleEndian<quint16>(headerSize, data + 94);
+        qToLittleEndian<quint32>(headerSize, data + 96);
+        data[104] = 2;
+        qToLittleEndian<quint16>(recordLength, data + 105);
+        qToLittleEndian<quint32>(pointCount, data + 107);
+        for (int i = 0; i < 3; ++i) {
+            fnSetDouble(131 + 8 * i, 0.01); // Scale
+            fnSetDouble(155 + 8 * i, 100.); // Offset
+        }
+
+        fnSetDouble(179, 102.); fnSetDouble(187, 100.); // X max/min
+        fnSetDouble(195, 102.); fnSetDouble(203, 100.); // Y max/min
+        fnSetDouble(211, 102.); fnSetDouble(219, 100.); // Z max/min
+        for (int i = 0; i < pointCount; ++i) {
+            uchar* record = data + headerSize + i * recordLength;
+            qToLittleEndian<qint32>(100 * i, record);
+            qToLittleEndian<qint32>(50 * i, record + 4);
+            qToLittleEndian<qint32>(0, record + 8);
+            qToLittleEndian<quint16>(0xFF00, record + 20); // R
+            qToLittleEndian<quint16>(0x8000, record + 22); // G
+            qToLittleEndian<quint16>(0, record + 24); // B
+        }
+
+        const QString filepath = tempDir.filePath("points.las");
+        QFile file(filepath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(bytes);
+        file.close();
+        QCOMPARE(app->ioSystem()->probeFormat(filepathFrom(filepath)), IO::Format_LAS);
+
+        IO::PointCloudReader reader(IO::Format_LAS);
+        QVERIFY(reader.readFile(filepathFrom(filepath), nullptr));
+        const TDF_LabelSequence seqLabel = reader.transfer(doc, nullptr);
+        QCOMPARE(seqLabel.Size(), 1);
+        const PointCloud& cloud = *CafUtils::findAttribute<PointCloudAttribute>(seqLabel.First())->get();
+        QCOMPARE(cloud.pointCount(), uint64_t(pointCount));
+        QVERIFY(cloud.hasColors());
+        QCOMPARE(fnNodePointCount(cloud), uint64_t(pointCount));
+        const std::vector<PointCloud::Point> vecPoint = cloud.nodePoints(cloud.rootNodeId());
+        QCOMPARE(int(vecPoint.size()), pointCount); // Distinct cells of the root node
+        const gp_Pnt pnt2(cloud.origin().X() + vecPoint.at(2).x, cloud.origin().Y() + vecPoint.at(2).y, cloud.origin().Z() + vecPoint.at(2).z);
+        QVERIFY(pnt2.IsEqual(gp_Pnt(102., 101., 100.), 1e-4));
+        QCOMPARE(vecPoint.at(2).rgb, uint32_t((0xFF << 16) | (0x80 << 8)));
+    }
+}
+
+void Test::IO_ExportSplitUtils_test()
+{
+    QCOMPARE(IO::ExportSplitUtils::modeFromString("parts"), IO::ExportSplitMode::LeafParts);
+    QCOMPARE(IO::ExportSplitUtils::modeFromString("Products"), IO::ExportSplitMode::TopLevelProducts);
+    QCOMPARE(IO::ExportSplitUtils::modeFromString("other"), IO::ExportSplitMode::None);
+    QVERIFY(IO::ExportSplitUtils::isFilepathTemplate("lib/%name%.stl"));
+    QVERIFY(!IO::ExportSplitUtils::isFilepathTemplate("lib/part.stl"));
+    QCOMPARE(IO::ExportSplitUtils::expandFilepathTemplate("%path%/%name%.stl", "a:b", {}), FilePath("a_b.stl"));
+    QCOMPARE(IO::ExportSplitUtils::expandFilepathTemplate("lib/%path%/%name%.stl", "", { "Asm", "Sub" }),
+             FilePath("lib/Asm/Sub/item.stl").lexically_normal());
+
+    // Assembly with two instances of a box and one instance of another box, both named "Box"
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const TopoDS_Shape boxA = BRepPrimAPI_MakeBox(10, 10, 10);
+    const TopoDS_Shape boxB = BRepPrimAPI_MakeBox(5, 5, 5);
+    TopoDS_Compound compound;
+    BRep_Builder builder;
+    builder.MakeCompound(compound);
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(50, 0, 0));
+    builder.Add(compound, boxA);
+    builder.Add(compound, boxA.Moved(TopLoc_Location(trsf)));
+    builder.Add(compound, boxB);
+    const TDF_Label labelAssembly = doc->xcaf().shapeTool()->AddShape(compound, true/*makeAssembly*/);
+    doc->addEntityTreeNode(labelAssembly);
+    const TDF_LabelSequence seqComponent = XCaf::shapeComponents(labelAssembly);
+    QCOMPARE(seqComponent.Size(), 3);
+    doc->setLabelName(labelAssembly, "Asm");
+    doc->setLabelName(XCaf::shapeReferred(seqComponent.First()), "Box");
+    doc->setLabelName(XCaf::shapeReferred(seqComponent.Last()), "Box");
+
+    const ApplicationItem appItem(doc);
+    const Span<const ApplicationItem> spanAppItem(&appItem, 1);
+    for (IO::ExportSplitMode mode : { IO::ExportSplitMode::LeafParts, IO::ExportSplitMode::TopLevelProducts }) {
+        const std::vector<IO::ExportSplitTarget> vecTarget =
+                IO::ExportSplitUtils::split(spanAppItem, mode, "lib/%path%/%name%.stl");
+        QCOMPARE(vecTarget.size(), size_t(2));
+        QCOMPARE(vecTarget.at(0).filepath, FilePath("lib/Asm/Box.stl").lexically_normal());
+        QCOMPARE(vecTarget.at(1).filepath, FilePath("lib/Asm/Box_2.stl").lexically_normal());
+        QVERIFY(vecTarget.at(0).item.isDocumentTreeNode());
+        QCOMPARE(vecTarget.at(0).item.documentTreeNode().label(), XCaf::shapeReferred(seqComponent.First()));
+    }
+
+    // File path without placeholder
+    const std::vector<IO::ExportSplitTarget> vecTarget =
+            IO::ExportSplitUtils::split(spanAppItem, IO::ExportSplitMode::LeafParts, "lib/part.stl");
+    QCOMPARE(vecTarget.size(), size_t(2));
+    QCOMPARE(vecTarget.at(0).filepath, FilePath("lib/part_Box.stl").lexically_normal());
+    QVERIFY(IO::ExportSplitUtils::split(spanAppItem, IO::ExportSplitMode::None, "lib/part.stl").empty());
+}
+
+void Test::IO_OccBRepWriter_test()
+{
+    QFETCH(IO::OccBRepWriter::Format, format);
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const TopoDS_Shape box = BRepPrimAPI_MakeBox(10, 10, 10);
+    BRepMesh_IncrementalMesh mesher(box, 1.);
+    doc->xcaf().shapeTool()->SetShape(doc->xcaf().shapeTool()->NewShape(), box);
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const FilePath filepath = filepathFrom(tempDir.filePath("box.brep"));
+    IO::OccBRepWriter writer;
+    writer.parameters().format = format;
+    writer.parameters().withTriangles = true;
+    const ApplicationItem appItem(doc);
+    QVERIFY(writer.transfer(Span<const ApplicationItem>(&appItem, 1), nullptr));
+    QVERIFY(writer.writeFile(filepath, nullptr));
+    QCOMPARE(app->ioSystem()->probeFormat(filepath), IO::Format_OCCBREP);
+
+    // Shape is read back along with the triangulations of its faces
+    IO::OccBRepReader reader;
+    QVERIFY(reader.readFile(filepath, nullptr));
+    const TDF_LabelSequence seqLabel = reader.transfer(doc, nullptr);
+    QCOMPARE(seqLabel.Size(), 1);
+    int faceCount = 0;
+    BRepUtils::forEachSubFace(XCaf::shape(seqLabel.First()), [&](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        QVERIFY(!BRep_Tool::Triangulation(face, loc).IsNull());
+        ++faceCount;
+    });
+    QCOMPARE(faceCount, 6);
+}
+
+void Test::IO_OccBRepWriter_test_data()
+{
+    QTest::addColumn<IO::OccBRepWriter::Format>("format");
+    QTest::newRow("text") << IO::OccBRepWriter::Format::Text;
+    QTest::newRow("binary") << IO::OccBRepWriter::Format::Binary;
+}
+
+void Test::IO_OccVrmlWriter_test()
+{
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const TopoDS_Shape box = BRepPrimAPI_MakeBox(10, 10, 10);
+    BRepMesh_IncrementalMesh mesher(box, 1.);
+    doc->xcaf().shapeTool()->SetShape(doc->xcaf().shapeTool()->NewShape(), box);
+
+    // Same product is exported twice, second one must be a reference to the first
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString filepath = tempDir.filePath("box.wrl");
+    IO::OccVrmlWriter writer;
+    writer.parameters().shapeRepresentation = VrmlAPI_ShadedRepresentation;
+    const ApplicationItem appItems[] = {
+        ApplicationItem(doc), ApplicationItem(DocumentTreeNode(doc, doc->entityTreeNodeId(0)))
+    };
+    QVERIFY(writer.transfer(appItems, nullptr));
+    QVERIFY(writer.writeFile(filepathFrom(filepath), nullptr));
+
+    QFile file(filepath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray contents = file.readAll();
+    QVERIFY(contents.startsWith("#VRML V2.0 utf8\n"));
+    QCOMPARE(contents.count("IndexedFaceSet"), 1);
+    QCOMPARE(contents.count("DEF Product1"), 1);
+    QCOMPARE(contents.count("USE Product1"), 1);
+    QCOMPARE(contents.count(",-1,"), 12);
+    QCOMPARE(contents.count("IndexedLineSet"), 0);
+}
+
+void Test::IO_OccObjReader_test()
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+
+    IO::OccObjReader reader;
+    QVERIFY(reader.readFile(filepathFrom("inputs/cube.obj"), nullptr));
+    // Target document must not be modified by the read phase
+    QVERIFY(doc->xcaf().topLevelFreeShapes().IsEmpty());
+    const TDF_LabelSequence seqLabel = reader.transfer(doc, nullptr);
+    QVERIFY(!seqLabel.IsEmpty());
+    QCOMPARE(seqLabel.Size(), doc->xcaf().topLevelFreeShapes().Size());
+
+    int triangleCount = 0;
+    for (const TDF_Label& label : seqLabel) {
+        QVERIFY(XCaf::isShape(label));
+        BRepUtils::forEachSubFace(XCaf::shape(label), [&](const TopoDS_Face& face) {
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation& mesh = BRep_Tool::Triangulation(face, loc);
+            triangleCount += !mesh.IsNull() ? mesh->NbTriangles() : 0;
+        });
+    }
+
+    QCOMPARE(triangleCount, 12);
+#else
+    QSKIP("Requires OpenCascade >= v7.4.0");
+#endif
+}
+
+void Test::IO_OccObjReader_fastParsing_test()
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    // Quad and triangle(with negative indices), then an invalid face which must be skipped
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString filepath = tempDir.filePath("quad.obj");
+    {
+        QFile file(filepath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("# Comment\n"
+                   "v 0 0 0\n"
+                   "v 1 0 0\r\n"
+                   "v 1 1 0\n"
+                   "v 0 1 0\n"
+                   "vt 0 0\n"
+                   "vn 0 0 1\n"
+                   "f 1/1/1 2/1/1 3/1/1 4/1/1\n"
+                   "f -4 -3 -2\n"
+                   "f 1//1 x 3\n");
+    }
+
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    IO::OccObjReader reader;
+    reader.parameters().fastParsing = true;
+    QVERIFY(reader.readFile(filepathFrom(filepath), nullptr));
+    const TDF_LabelSequence seqLabel = reader.transfer(doc, nullptr);
+    QCOMPARE(seqLabel.Size(), 1);
+    auto attrTriangulation = CafUtils::findAttribute<TDataXtd_Triangulation>(seqLabel.First());
+    QVERIFY(!attrTriangulation.IsNull());
+    const Handle_Poly_Triangulation mesh = attrTriangulation->Get();
+    QCOMPARE(mesh->NbNodes(), 4);
+    QCOMPARE(mesh->NbTriangles(), 3);
+    QCOMPARE(MeshUtils::triangulationArea(mesh), 1.5);
+#else
+    QSKIP("Requires OpenCascade >= v7.4.0");
+#endif
+}
+
+void Test::IO_OccObjReader_fastParsingGroups_test()
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 4, 0)
+    // Two groups, the second one switching material: three primitives
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    {
+        QFile file(tempDir.filePath("colors.mtl"));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("newmtl red\n"
+                   "Kd 1 0 0\n"
+                   "newmtl blue\n"
+                   "Kd 0 0 1\n");
+    }
+
+    const QString filepath = tempDir.filePath("groups.obj");
+    {
+        QFile file(filepath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("mtllib colors.mtl\n"
+                   "v 0 0 0\n"
+                   "v 1 0 0\n"
+                   "v 1 1 0\n"
+                   "v 0 1 0\n"
+                   "o first\n"
+                   "usemtl red\n"
+                   "f 1 2 3 4\n"
+                   "o second\n"
+                   "f 1 2 3\n"
+                   "usemtl blue\n"
+                   "f 1 3 4\n"
+                   "o empty\n");
+    }
+
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    IO::OccObjReader reader;
+    reader.parameters().fastParsing = true;
+    QVERIFY(reader.readFile(filepathFrom(filepath), nullptr));
+    const TDF_LabelSequence seqLabel = reader.transfer(doc, nullptr);
+    QCOMPARE(seqLabel.Size(), 1);
+    QCOMPARE(CafUtils::labelAttrStdName(seqLabel.First()), QString("groups"));
+    const TDF_LabelSequence seqComponent = XCaf::shapeComponents(seqLabel.First());
+    QCOMPARE(seqComponent.Size(), 3);
+
+    const QString expectedNames[] = { "first", "second", "second" };
+    const int expectedTriangleCounts[] = { 2, 1, 1 };
+    const int expectedNodeCounts[] = { 4, 3, 3 };
+    const Quantity_Color expectedColors[] = {
+        Quantity_Color(1, 0, 0, Quantity_TOC_RGB),
+        Quantity_Color(1, 0, 0, Quantity_TOC_RGB),
+        Quantity_Color(0, 0, 1, Quantity_TOC_RGB)
+    };
+    for (int i = 0; i < seqComponent.Size(); ++i) {
+        const TDF_Label labelPart = XCaf::shapeReferred(seqComponent.Value(i + 1));
+        QCOMPARE(CafUtils::labelAttrStdName(labelPart), expectedNames[i]);
+        int triangleCount = 0;
+        int nodeCount = 0;
+        BRepUtils::forEachSubFace(XCaf::shape(labelPart), [&](const TopoDS_Face& face) {
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation& mesh = BRep_Tool::Triangulation(face, loc);
+            triangleCount += !mesh.IsNull() ? mesh->NbTriangles() : 0;
+            nodeCount += !mesh.IsNull() ? mesh->NbNodes() : 0;
+        });
+        QCOMPARE(triangleCount, expectedTriangleCounts[i]);
+        QCOMPARE(nodeCount, expectedNodeCounts[i]);
+
+        Quantity_Color color;
+        QVERIFY(doc->xcaf().colorTool()->GetColor(labelPart, XCAFDoc_ColorSurf, color));
+        QVERIFY(color.IsEqual(expectedColors[i]));
+    }
+#else
+    QSKIP("Requires OpenCascade >= v7.4.0");
+#endif
+}
+
+void Test::BRepUtils_test()
+{
+    QVERIFY(BRepUtils::moreComplex(TopAbs_COMPOUND, TopAbs_SOLID));
+    QVERIFY(BRepUtils::moreComplex(TopAbs_SOLID, TopAbs_SHELL));
+    QVERIFY(BRepUtils::moreComplex(TopAbs_SHELL, TopAbs_FACE));
+    QVERIFY(BRepUtils::moreComplex(TopAbs_FACE, TopAbs_EDGE));
+    QVERIFY(BRepUtils::moreComplex(TopAbs_EDGE, TopAbs_VERTEX));
+
+    {
+        const TopoDS_Shape shapeNull;
+        const TopoDS_Shape shapeBase = BRepPrimAPI_MakeBox(25, 25, 25);
+        const TopoDS_Shape shapeCopy = shapeBase;
+        QCOMPARE(BRepUtils::hashCode(shapeNull), -1);
+        QVERIFY(BRepUtils::hashCode(shapeBase) >= 0);
+        QCOMPARE(BRepUtils::hashCode(shapeBase), BRepUtils::hashCode(shapeCopy));
+    }
+}
+
+void Test::BRepUtils_meshJobs_test()
+{
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(10, 10, 10);
+    const TopoDS_Shape shapeOtherBox = BRepPrimAPI_MakeBox(5, 5, 5);
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(20, 0, 0));
+
+    BRep_Builder builder;
+    TopoDS_Compound compBoxes;
+    builder.MakeCompound(compBoxes);
+    builder.Add(compBoxes, shapeBox);
+    builder.Add(compBoxes, shapeBox.Located(TopLoc_Location(trsf)));
+    builder.Add(compBoxes, shapeOtherBox);
+
+    // Faces of the same box share edges, so they can't be meshed concurrently
+    const TopoDS_Shape shapeFacesBox = BRepPrimAPI_MakeBox(2, 2, 2);
+    TopoDS_Compound compFaces;
+    builder.MakeCompound(compFaces);
+    BRepUtils::forEachSubFace(shapeFacesBox, [&](const TopoDS_Face& face) {
+        builder.Add(compFaces, face);
+    });
+
+    OccBRepMeshParameters params;
+    params.Deflection = 0.1;
+    params.Angle = 0.5;
+    const std::vector<TopoDS_Shape> vecShape = { compBoxes, shapeBox, compFaces };
+    const std::vector<OccBRepMeshParameters> vecParams = { params, params, params };
+    const std::vector<BRepUtils::MeshJob> vecJob = BRepUtils::createMeshJobs(vecShape, vecParams);
+    QCOMPARE(vecJob.size(), size_t(3));
+
+    BRepUtils::computeMesh(vecJob);
+    for (const TopoDS_Shape& shape : vecShape) {
+        BRepUtils::forEachSubFace(shape, [](const TopoDS_Face& face) {
+            TopLoc_Location loc;
+            QVERIFY(!BRep_Tool::Triangulation(face, loc).IsNull());
+        });
+    }
+}
+
+void Test::BRepUtils_meshJobsPriorities_test()
+{
+    std::vector<TopoDS_Shape> vecShape;
+    for (int i = 1; i <= 8; ++i)
+        vecShape.push_back(BRepPrimAPI_MakeBox(i, i, i));
+
+    BRepMeshPriorities priorities{ std::vector<TopoDS_Shape>(vecShape) };
+    QCOMPARE(priorities.partCount(), 8);
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(20, 0, 0));
+    QCOMPARE(priorities.findPart(vecShape.at(3).Located(TopLoc_Location(trsf))), 3);
+    QCOMPARE(priorities.findPart(BRepPrimAPI_MakeBox(1, 1, 1)), -1);
+
+    // Last parts have highest priority
+    const int revision = priorities.revision();
+    const std::vector<double> vecPriority = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    priorities.setPriorities(vecPriority);
+    QVERIFY(priorities.revision() != revision);
+    QCOMPARE(priorities.priority(7), 7.);
+    QVERIFY(priorities.priority(-1) < priorities.priority(0));
+
+    OccBRepMeshParameters params;
+    params.Deflection = 0.1;
+    params.Angle = 0.5;
+    const std::vector<OccBRepMeshParameters> vecParams(vecShape.size(), params);
+    const std::vector<BRepUtils::MeshJob> vecJob = BRepUtils::createMeshJobs(vecShape, vecParams);
+    BRepUtils::MeshJobScheduling scheduling;
+    scheduling.fnPriority = [&](const BRepUtils::MeshJob& job) {
+        return priorities.priority(priorities.findPart(job.shape));
+    };
+    scheduling.fnPriorityRevision = [&]{ return priorities.revision(); };
+    scheduling.fnJobDone = [&](const BRepUtils::MeshJob& job) {
+        priorities.addPartDone(priorities.findPart(job.shape));
+    };
+    BRepUtils::computeMesh(vecJob, scheduling);
+
+    // Each part is reported once
+    std::vector<int> vecPartDone = priorities.takePartsDone();
+    std::sort(vecPartDone.begin(), vecPartDone.end());
+    QCOMPARE(vecPartDone, std::vector<int>({ 0, 1, 2, 3, 4, 5, 6, 7 }));
+    QVERIFY(priorities.takePartsDone().empty());
+    for (const TopoDS_Shape& shape : vecShape) {
+        BRepUtils::forEachSubFace(shape, [](const TopoDS_Face& face) {
+            TopLoc_Location loc;
+            QVERIFY(!BRep_Tool::Triangulation(face, loc).IsNull());
+        });
+    }
+}
+
+void Test::BRepUtils_findCoarseMeshFaces_test()
+{
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(10, 10, 10);
+    OccBRepMeshParameters params;
+    params.Deflection = 0.5;
+    params.Angle = 0.5;
+    QCOMPARE(BRepUtils::findCoarseMeshFaces(shapeBox, params).size(), size_t(6));
+
+    BRepUtils::computeMesh(shapeBox, params);
+    QVERIFY(BRepUtils::findCoarseMeshFaces(shapeBox, params).empty());
+
+    params.Deflection = 2.;
+    QVERIFY(BRepUtils::findCoarseMeshFaces(shapeBox, params).empty());
+
+    params.Deflection = 0.01;
+    const std::vector<TopoDS_Face> vecFace = BRepUtils::findCoarseMeshFaces(shapeBox, params);
+    QCOMPARE(vecFace.size(), size_t(6));
+
+    // Instances of the same shape report their faces once
+    BRep_Builder builder;
+    TopoDS_Compound compBoxes;
+    builder.MakeCompound(compBoxes);
+    builder.Add(compBoxes, shapeBox);
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(20, 0, 0));
+    builder.Add(compBoxes, shapeBox.Located(TopLoc_Location(trsf)));
+    QCOMPARE(BRepUtils::findCoarseMeshFaces(compBoxes, params).size(), size_t(6));
+}
+
+void Test::BRepUtils_addEdgeNeighbourFaces_test()
+{
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(10, 10, 10);
+    std::vector<TopoDS_Face> vecBoxFace;
+    BRepUtils::forEachSubFace(shapeBox, [&](const TopoDS_Face& face) { vecBoxFace.push_back(face); });
+    QCOMPARE(vecBoxFace.size(), size_t(6));
+
+    // Face of a box shares its edges with 4 faces, the opposite face is left out
+    const TopoDS_Face& faceXMin = vecBoxFace.at(0);
+    const TopoDS_Face& faceXMax = vecBoxFace.at(1);
+    const std::vector<TopoDS_Face> vecFace =
+            BRepUtils::addEdgeNeighbourFaces(shapeBox, Span<const TopoDS_Face>(&faceXMin, 1));
+    QCOMPARE(vecFace.size(), size_t(5));
+    QVERIFY(vecFace.front().IsSame(faceXMin));
+    for (const TopoDS_Face& face : vecFace)
+        QVERIFY(!face.IsSame(faceXMax));
+
+    QVERIFY(BRepUtils::addEdgeNeighbourFaces(shapeBox, {}).empty());
+    QCOMPARE(BRepUtils::addEdgeNeighbourFaces(shapeBox, vecBoxFace).size(), size_t(6));
+}
+
+void Test::BRepUtils_boundingBox_test()
+{
+    auto fnCheckBox = [](const Bnd_Box& bndBox, const gp_Pnt& pntMin, const gp_Pnt& pntMax) {
+        QVERIFY(!bndBox.IsVoid());
+        const auto coords = BndBoxCoords::get(bndBox);
+        QVERIFY(coords.minVertex().Distance(pntMin) < 1e-3);
+        QVERIFY(coords.maxVertex().Distance(pntMax) < 1e-3);
+    };
+
+    // Without triangulation, box is computed from geometry
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(gp_Pnt(1, 2, 3), 10, 10, 10);
+    fnCheckBox(BRepUtils::boundingBox(shapeBox), gp_Pnt(1, 2, 3), gp_Pnt(11, 12, 13));
+
+    // With triangulation, box is computed from triangulation nodes
+    OccBRepMeshParameters params;
+    params.Deflection = 0.5;
+    params.Angle = 0.5;
+    BRepUtils::computeMesh(shapeBox, params);
+    fnCheckBox(BRepUtils::boundingBox(shapeBox), gp_Pnt(1, 2, 3), gp_Pnt(11, 12, 13));
+
+    // Location of the faces applies to triangulation nodes
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(20, 0, 0));
+    const TopoDS_Shape shapeMovedBox = shapeBox.Located(TopLoc_Location(trsf));
+    fnCheckBox(BRepUtils::boundingBox(shapeMovedBox), gp_Pnt(21, 2, 3), gp_Pnt(31, 12, 13));
+
+    QVERIFY(BRepUtils::boundingBox(TopoDS_Shape()).IsVoid());
+}
+
+void Test::BRepUtils_meshLods_test()
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    const TopoDS_Shape shapeSphere = BRepPrimAPI_MakeSphere(10);
+    OccBRepMeshParameters params;
+    params.Deflection = 0.01;
+    params.Angle = 0.2;
+    BRepUtils::computeMesh(shapeSphere, params);
+    QCOMPARE(BRepUtils::meshLodCount(shapeSphere), 1);
+
+    std::vector<OccBRepMeshParameters> vecLodParams(2, params);
+    vecLodParams.at(0).Deflection = 0.5;
+    vecLodParams.at(1).Deflection = 2.;
+    vecLodParams.at(1).Angle = 0.8;
+    BRepUtils::computeMeshLods(shapeSphere, vecLodParams);
+    QCOMPARE(BRepUtils::meshLodCount(shapeSphere), 3);
+    QCOMPARE(BRepUtils::activeMeshLod(shapeSphere), 0);
+
+    auto fnTriangleCount = [&]{
+        int count = 0;
+        BRepUtils::forEachSubFace(shapeSphere, [&](const TopoDS_Face& face) {
+            TopLoc_Location loc;
+            count += BRep_Tool::Triangulation(face, loc)->NbTriangles();
+        });
+        return count;
+    };
+    const int triangleCountLod0 = fnTriangleCount();
+    QVERIFY(BRepUtils::activateMeshLod(shapeSphere, 2));
+    QCOMPARE(BRepUtils::activeMeshLod(shapeSphere), 2);
+    QVERIFY(fnTriangleCount() < triangleCountLod0);
+    QVERIFY(!BRepUtils::activateMeshLod(shapeSphere, 5)); // Clamped to level 2, already active
+    QVERIFY(BRepUtils::activateMeshLod(shapeSphere, 0));
+    QCOMPARE(fnTriangleCount(), triangleCountLod0);
+#else
+    QSKIP("Mesh levels of detail require OpenCascade >= v7.6.0");
+#endif
+}
+
+void Test::BRepMeshCache_test()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const BRepMeshCache cache(filepathFrom(tempDir.path()));
+    const QByteArray sourceHash = BRepMeshCache::sourceHash("inputs/cube.step");
+    QVERIFY(!sourceHash.isEmpty());
+    QVERIFY(BRepMeshCache::sourceHash("inputs/file_not_existing.step").isEmpty());
+
+    OccBRepMeshParameters params;
+    params.Deflection = 0.1;
+    params.Angle = 0.5;
+    const BRepMeshCache::Key key = { sourceHash, 0, params };
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(10, 10, 10);
+    QVERIFY(!cache.attachTriangulations(key, shapeBox));
+    BRepUtils::computeMesh(shapeBox, params);
+    std::vector<int> vecNodeCount;
+    BRepUtils::forEachSubFace(shapeBox, [&](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        vecNodeCount.push_back(BRep_Tool::Triangulation(face, loc)->NbNodes());
+    });
+    QVERIFY(cache.storeTriangulations(key, shapeBox));
+
+    // Cached triangulations are assigned back
+    BRepTools::Clean(shapeBox);
+    QVERIFY(cache.attachTriangulations(key, shapeBox));
+    std::vector<int> vecCachedNodeCount;
+    BRepUtils::forEachSubFace(shapeBox, [&](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        vecCachedNodeCount.push_back(!triangulation.IsNull() ? triangulation->NbNodes() : 0);
+    });
+    QCOMPARE(vecCachedNodeCount, vecNodeCount);
+
+    // Key mismatch or topology mismatch
+    BRepMeshCache::Key otherKey = key;
+    otherKey.params.Deflection = 0.2;
+    QVERIFY(!cache.attachTriangulations(otherKey, shapeBox));
+    const TopoDS_Shape shapeSphere = BRepPrimAPI_MakeSphere(10);
+    QVERIFY(!cache.attachTriangulations(key, shapeSphere));
+
+    // Entry with a node index out of range is evicted, shape is left untouched
+    const BRepMeshCache::Key corruptedKey = { sourceHash, 1, params };
+    const TopoDS_Shape shapeCorrupted = BRepPrimAPI_MakeBox(10, 10, 10);
+    BRepUtils::computeMesh(shapeCorrupted, params);
+    BRepUtils::forEachSubFace(shapeCorrupted, [](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& triangulation = BRep_Tool::Triangulation(face, loc);
+        triangulation->ChangeTriangles().ChangeValue(1).Set(1, 2, triangulation->NbNodes() + 1);
+    });
+    QVERIFY(cache.storeTriangulations(corruptedKey, shapeCorrupted));
+    const QString corruptedEntryPath = filepathTo<QString>(cache.entryFilePath(corruptedKey));
+    QVERIFY(QFile::exists(corruptedEntryPath));
+    BRepTools::Clean(shapeCorrupted);
+    QVERIFY(!cache.attachTriangulations(corruptedKey, shapeCorrupted));
+    QVERIFY(!QFile::exists(corruptedEntryPath));
+    BRepUtils::forEachSubFace(shapeCorrupted, [](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        QVERIFY(BRep_Tool::Triangulation(face, loc).IsNull());
+    });
+}
+
+void Test::BRepMeshQuality_test()
+{
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(10, 20, 40);
+    const OccBRepMeshParameters paramsCoarse = brepMeshQualityParameters(shapeBox, BRepMeshQuality::Coarse);
+    const OccBRepMeshParameters paramsNormal = brepMeshQualityParameters(shapeBox, BRepMeshQuality::Normal);
+    const OccBRepMeshParameters paramsPrecise = brepMeshQualityParameters(shapeBox, BRepMeshQuality::Precise);
+    QVERIFY(paramsNormal.InParallel);
+    QVERIFY(paramsCoarse.Deflection > paramsNormal.Deflection);
+    QVERIFY(paramsNormal.Deflection > paramsPrecise.Deflection);
+    QVERIFY(paramsCoarse.Angle > paramsNormal.Angle);
+    QVERIFY(paramsNormal.Angle > paramsPrecise.Angle);
+
+    // Deflection is proportional to the largest dimension of the bounding box
+    const TopoDS_Shape shapeBigBox = BRepPrimAPI_MakeBox(20, 40, 80);
+    const OccBRepMeshParameters paramsBigNormal = brepMeshQualityParameters(shapeBigBox, BRepMeshQuality::Normal);
+    QVERIFY(std::abs(paramsBigNormal.Deflection - 2 * paramsNormal.Deflection) < Precision::Confusion());
+    QCOMPARE(paramsBigNormal.Angle, paramsNormal.Angle);
+}
+
+void Test::BRepMeshBudget_test()
+{
+    // Big part and small "fastener"
+    const TopoDS_Shape shapeBigSphere = BRepPrimAPI_MakeSphere(100);
+    const TopoDS_Shape shapeSmallSphere = BRepPrimAPI_MakeSphere(1);
+    const TopoDS_Shape arrayShape[] = { shapeBigSphere, shapeSmallSphere };
+
+    const BRepMeshBudget::ShapeEstimate estimate = BRepMeshBudget::estimate(shapeBigSphere);
+    QCOMPARE(int(estimate.vecFace.size()), 1);
+    QVERIFY(std::abs(estimate.size - 200) < 5.);
+    QVERIFY(std::abs(estimate.vecFace.front().curvature - 0.01) < 1e-6);
+    const double angle = BRepMeshBudget::Parameters().angularDeflection;
+    QVERIFY(BRepMeshBudget::estimatedTriangleCount(estimate, 0.1, angle)
+            > BRepMeshBudget::estimatedTriangleCount(estimate, 1., angle));
+
+    // Deflection of small shapes is clamped relatively to their size
+    BRepMeshBudget::Parameters params;
+    QCOMPARE(BRepMeshBudget::shapeDeflection(10., 2., params), 2. * params.maxRelativeDeflection);
+    QCOMPARE(BRepMeshBudget::shapeDeflection(0.01, 2., params), 0.01);
+
+    // Actual count of triangles is close to the budget, bigger budget gives more triangles
+    params.triangleCount = 5000;
+    const BRepMeshBudget::Result resultCoarse = BRepMeshBudget::computeMesh(arrayShape, params);
+    params.triangleCount = 20000;
+    const BRepMeshBudget::Result result = BRepMeshBudget::computeMesh(arrayShape, params);
+    QVERIFY(result.globalDeflection > 0);
+    QVERIFY(result.globalDeflection < resultCoarse.globalDeflection);
+    QVERIFY(result.triangleCount > resultCoarse.triangleCount);
+    QCOMPARE(result.triangleCount, BRepMeshBudget::triangleCount(arrayShape));
+    QVERIFY(result.triangleCount > params.triangleCount / 2);
+    QVERIFY(result.triangleCount < params.triangleCount * 2);
+    const Span<const TopoDS_Shape> spanBigSphere(&shapeBigSphere, 1);
+    const Span<const TopoDS_Shape> spanSmallSphere(&shapeSmallSphere, 1);
+    QVERIFY(BRepMeshBudget::triangleCount(spanBigSphere) > BRepMeshBudget::triangleCount(spanSmallSphere));
+}
+
+void Test::CafUtils_test()
+{
+    // TODO Add CafUtils::labelTag() test for multi-threaded safety
+}
+
+void Test::XCaf_topLevelFreeShapesAfter_test()
+{
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    XCaf& xcaf = doc->xcaf();
+    QCOMPARE(xcaf.topLevelFreeShapesAfter(xcaf.shapesTagWatermark()).Size(), 0);
+
+    const TDF_Label labelBoxA = xcaf.shapeTool()->AddShape(BRepPrimAPI_MakeBox(10, 10, 10), false);
+    const int watermark = xcaf.shapesTagWatermark();
+    QCOMPARE(watermark, labelBoxA.Tag());
+
+    // Only shapes added after the watermark are returned, as top-level free shapes
+    const TopoDS_Shape boxB = BRepPrimAPI_MakeBox(5, 5, 5);
+    TopoDS_Compound compound;
+    BRep_Builder builder;
+    builder.MakeCompound(compound);
+    builder.Add(compound, boxB);
+    const TDF_Label labelAssembly = xcaf.shapeTool()->AddShape(compound, true/*makeAssembly*/);
+    const TDF_Label labelBoxC = xcaf.shapeTool()->AddShape(BRepPrimAPI_MakeBox(1, 1, 1), false);
+    const TDF_LabelSequence seqNew = xcaf.topLevelFreeShapesAfter(watermark);
+    QCOMPARE(seqNew.Size(), 2);
+    QCOMPARE(seqNew.First(), labelAssembly);
+    QCOMPARE(seqNew.Last(), labelBoxC);
+    QCOMPARE(xcaf.topLevelFreeShapesAfter(0).Size(), xcaf.topLevelFreeShapes().Size());
+}
+
+void Test::FlatHashMap_test()
+{
+    // Random insertions/erasures/lookups checked against std::unordered_map
+    FlatHashMap<int, std::string> map;
+    std::unordered_map<int, std::string> mapRef;
+    uint32_t seed = 42;
+    auto fnRandom = [&]{ seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    for (int i = 0; i < 20000; ++i) {
+        const int key = fnRandom() % 500;
+        const uint32_t op = fnRandom() % 3;
+        if (op == 0) {
+            const bool inserted = map.insert({ key, std::to_string(i) }).second;
+            QCOMPARE(inserted, mapRef.insert({ key, std::to_string(i) }).second);
+        }
+        else if (op == 1) {
+            QCOMPARE(map.erase(key), mapRef.erase(key));
+        }
+        else {
+            auto it = map.find(key);
+            auto itRef = mapRef.find(key);
+            QCOMPARE(it == map.cend(), itRef == mapRef.cend());
+            if (itRef != mapRef.cend())
+                QCOMPARE(it->second, itRef->second);
+        }
+
+        QCOMPARE(map.size(), mapRef.size());
+    }
+
+    size_t itemCount = 0;
+    for (const auto& [key, value] : map) {
+        QCOMPARE(value, mapRef.at(key));
+        ++itemCount;
+    }
+
+    QCOMPARE(itemCount, mapRef.size());
+    map[1000] = "value";
+    QCOMPARE(CppUtils::findValue(1000, map), std::string("value"));
+    QCOMPARE(CppUtils::findValue(-1, map), std::string());
+    map.clear();
+    QVERIFY(map.empty());
+    QVERIFY(map.begin() == map.end());
+}
+
+void Test::MeshUtils_normals_test()
+{
+    // Unit square in XY plane(two triangles) plus one degenerated triangle
+    Handle_Poly_Triangulation mesh = new Poly_Triangulation(5, 3, false);
+    mesh->ChangeNode(1) = gp_Pnt(0, 0, 0);
+    mesh->ChangeNode(2) = gp_Pnt(1, 0, 0);
+    mesh->ChangeNode(3) = gp_Pnt(1, 1, 0);
+    mesh->ChangeNode(4) = gp_Pnt(0, 1, 0);
+    mesh->ChangeNode(5) = gp_Pnt(2, 0, 0);
+    mesh->ChangeTriangle(1) = Poly_Triangle(1, 2, 3);
+    mesh->ChangeTriangle(2) = Poly_Triangle(1, 3, 4);
+    mesh->ChangeTriangle(3) = Poly_Triangle(1, 2, 5);
+
+    const MeshUtils::VectorArrays vecTriangleNormal = MeshUtils::triangleNormals(mesh);
+    QCOMPARE(vecTriangleNormal.size(), 3);
+    for (int i = 0; i < 2; ++i) {
+        QCOMPARE(vecTriangleNormal.x.at(i), 0.f);
+        QCOMPARE(vecTriangleNormal.y.at(i), 0.f);
+        QCOMPARE(vecTriangleNormal.z.at(i), 1.f);
+    }
+
+    QCOMPARE(vecTriangleNormal.z.at(2), 0.f);
+
+    const MeshUtils::VectorArrays vecNodeNormal = MeshUtils::nodeNormals(mesh);
+    QCOMPARE(vecNodeNormal.size(), 5);
+    for (int i = 0; i < 4; ++i)
+        QCOMPARE(vecNodeNormal.z.at(i), 1.f);
+
+    QCOMPARE(vecNodeNormal.z.at(4), 0.f);
+}
+
+void Test::MeshUtils_vertexCache_test()
+{
+    // Grid of quads split in two triangles, shuffled so the initial order has poor locality
+    constexpr int gridSize = 40;
+    constexpr int nodeCount = (gridSize + 1) * (gridSize + 1);
+    constexpr int triangleCount = gridSize * gridSize * 2;
+    std::vector<Poly_Triangle> vecTriangle;
+    for (int i = 0; i < gridSize; ++i) {
+        for (int j = 0; j < gridSize; ++j) {
+            const int n1 = i * (gridSize + 1) + j + 1;
+            const int n2 = n1 + 1;
+            const int n3 = n1 + gridSize + 1;
+            const int n4 = n3 + 1;
+            vecTriangle.emplace_back(n1, n2, n4);
+            vecTriangle.emplace_back(n1, n4, n3);
+        }
+    }
+
+    std::mt19937 randomEngine(1234);
+    std::shuffle(vecTriangle.begin(), vecTriangle.end(), randomEngine);
+    Handle_Poly_Triangulation mesh = new Poly_Triangulation(nodeCount, triangleCount, false);
+    for (int i = 0; i < nodeCount; ++i)
+        mesh->ChangeNode(i + 1) = gp_Pnt(i % (gridSize + 1), i / (gridSize + 1), 0);
+
+    for (int i = 0; i < triangleCount; ++i)
+        mesh->ChangeTriangle(i + 1) = vecTriangle.at(i);
+
+    // Average cache miss ratio(count of vertex transforms per triangle) with a FIFO cache
+    auto fnAcmr = [](const Handle_Poly_Triangulation& triangulation) {
+        std::vector<int> cache;
+        int missCount = 0;
+        for (int i = 1; i <= triangulation->NbTriangles(); ++i) {
+            int nodeIds[3];
+            triangulation->Triangle(i).Get(nodeIds[0], nodeIds[1], nodeIds[2]);
+            for (int nodeId : nodeIds) {
+                if (std::find(cache.cbegin(), cache.cend(), nodeId) == cache.cend()) {
+                    ++missCount;
+                    cache.push_back(nodeId);
+                    if (cache.size() > 16)
+                        cache.erase(cache.begin());
+                }
+            }
+        }
+
+        return missCount / double(triangulation->NbTriangles());
+    };
+
+    const double acmrInitial = fnAcmr(mesh);
+    const double areaInitial = MeshUtils::triangulationArea(mesh);
+    const Handle_Poly_Triangulation meshCopy = MeshUtils::vertexCacheOptimized(mesh);
+    MeshUtils::optimizeVertexCache(mesh);
+    QCOMPARE(mesh->NbTriangles(), triangleCount);
+    QVERIFY(fnAcmr(mesh) < acmrInitial * 0.6);
+    QVERIFY(std::is_permutation(
+                vecTriangle.cbegin(), vecTriangle.cend(),
+                mesh->Triangles().begin(),
+                [](const Poly_Triangle& lhs, const Poly_Triangle& rhs) {
+        return lhs.Value(1) == rhs.Value(1) && lhs.Value(2) == rhs.Value(2) && lhs.Value(3) == rhs.Value(3);
+    }));
+
+    // Copy has the same geometry, with nodes numbered in order of first use
+    QCOMPARE(meshCopy->NbNodes(), nodeCount);
+    QCOMPARE(meshCopy->NbTriangles(), triangleCount);
+    QCOMPARE(MeshUtils::triangulationArea(meshCopy), areaInitial);
+    QCOMPARE(fnAcmr(meshCopy), fnAcmr(mesh));
+    int maxNodeId = 0;
+    for (int i = 1; i <= meshCopy->NbTriangles(); ++i) {
+        int nodeIds[3];
+        meshCopy->Triangle(i).Get(nodeIds[0], nodeIds[1], nodeIds[2]);
+        for (int nodeId : nodeIds) {
+            QVERIFY(nodeId <= maxNodeId + 1);
+            maxNodeId = std::max(maxNodeId, nodeId);
+        }
+    }
+}
+
+void Test::MeshUtils_featureEdges_test()
+{
+    // Unit cube, node id is 1 + x + 2y + 4z
+    Handle_Poly_Triangulation mesh = new Poly_Triangulation(8, 12, false);
+    for (int i = 0; i < 8; ++i)
+        mesh->ChangeNode(i + 1) = gp_Pnt(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+
+    const Poly_Triangle cubeTriangles[] = {
+        { 1, 3, 4 }, { 1, 4, 2 }, // Bottom
+        { 5, 6, 8 }, { 5, 8, 7 }, // Top
+        { 1, 2, 6 }, { 1, 6, 5 }, // Front
+        { 3, 7, 8 }, { 3, 8, 4 }, // Back
+        { 1, 5, 7 }, { 1, 7, 3 }, // Left
+        { 2, 4, 8 }, { 2, 8, 6 }  // Right
+    };
+    for (int i = 0; i < 12; ++i)
+        mesh->ChangeTriangle(i + 1) = cubeTriangles[i];
+
+    auto fnEdgesToString = [](const std::vector<MeshUtils::Edge>& vecEdge) {
+        QStringList strEdges;
+        for (const MeshUtils::Edge& edge : vecEdge)
+            strEdges.push_back(QString("%1-%2").arg(edge.node1).arg(edge.node2));
+
+        return strEdges.join(' ');
+    };
+
+    // Diagonals of the sides are flat, the twelve edges of the cube make right angles
+    QCOMPARE(fnEdgesToString(MeshUtils::featureEdges(mesh, UnitSystem::radians(30 * Quantity_Degree))),
+             QString("1-2 1-3 1-5 2-4 2-6 3-4 3-7 4-8 5-6 5-7 6-8 7-8"));
+    QVERIFY(MeshUtils::featureEdges(mesh, UnitSystem::radians(100 * Quantity_Degree)).empty());
+
+    // Single quad: boundary edges only
+    Handle_Poly_Triangulation meshQuad = new Poly_Triangulation(4, 2, false);
+    meshQuad->ChangeNode(1) = gp_Pnt(0, 0, 0);
+    meshQuad->ChangeNode(2) = gp_Pnt(1, 0, 0);
+    meshQuad->ChangeNode(3) = gp_Pnt(1, 1, 0);
+    meshQuad->ChangeNode(4) = gp_Pnt(0, 1, 0);
+    meshQuad->ChangeTriangle(1) = Poly_Triangle(1, 2, 3);
+    meshQuad->ChangeTriangle(2) = Poly_Triangle(1, 3, 4);
+    QCOMPARE(fnEdgesToString(MeshUtils::featureEdges(meshQuad, UnitSystem::radians(30 * Quantity_Degree))),
+             QString("1-2 1-4 2-3 3-4"));
+
+    // Sides of the quad diagonal are grouped, triangle referencing a missing node is ignored
+    Handle_Poly_Triangulation meshInvalid = new Poly_Triangulation(4, 3, false);
+    for (int i = 1; i <= 4; ++i)
+        meshInvalid->ChangeNode(i) = meshQuad->Node(i);
+
+    meshInvalid->ChangeTriangle(1) = Poly_Triangle(1, 2, 3);
+    meshInvalid->ChangeTriangle(2) = Poly_Triangle(1, 3, 4);
+    meshInvalid->ChangeTriangle(3) = Poly_Triangle(1, 3, 5);
+    const MeshUtils::EdgeSides edgeSides = MeshUtils::edgeSides(meshInvalid);
+    QCOMPARE(edgeSides.invalidTriangleCount, 1);
+    QCOMPARE(edgeSides.edgeCount(), 5);
+    const Span<const MeshUtils::TriangleSide> spanDiagonalSide = edgeSides.sidesOfEdge(1);
+    QCOMPARE(int(spanDiagonalSide.size()), 2);
+    QCOMPARE(spanDiagonalSide[0].node1, 1);
+    QCOMPARE(spanDiagonalSide[0].node2, 3);
+    QCOMPARE(spanDiagonalSide[0].triangle, 0);
+    QVERIFY(spanDiagonalSide[0].reversed);
+    QCOMPARE(spanDiagonalSide[1].triangle, 1);
+    QVERIFY(!spanDiagonalSide[1].reversed);
+}
+
+void Test::MeshUtils_smoothNormals_test()
+{
+    // Unit cube, node id is 1 + x + 2y + 4z
+    Handle_Poly_Triangulation mesh = new Poly_Triangulation(8, 12, false);
+    for (int i = 0; i < 8; ++i)
+        mesh->ChangeNode(i + 1) = gp_Pnt(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+
+    const Poly_Triangle cubeTriangles[] = {
+        { 1, 3, 4 }, { 1, 4, 2 }, { 5, 6, 8 }, { 5, 8, 7 }, { 1, 2, 6 }, { 1, 6, 5 },
+        { 3, 7, 8 }, { 3, 8, 4 }, { 1, 5, 7 }, { 1, 7, 3 }, { 2, 4, 8 }, { 2, 8, 6 }
+    };
+    for (int i = 0; i < 12; ++i)
+        mesh->ChangeTriangle(i + 1) = cubeTriangles[i];
+
+    auto fnNormal = [](const Handle_Poly_Triangulation& triangulation, int nodeId) {
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+        return gp_Vec(triangulation->Normal(nodeId));
+#else
+        const TShort_Array1OfShortReal& vecNormal = triangulation->Normals();
+        return gp_Vec(vecNormal.Value(nodeId * 3 - 2), vecNormal.Value(nodeId * 3 - 1), vecNormal.Value(nodeId * 3));
+#endif
+    };
+
+    // Sides of the cube make right angles, so each node is split in three with the normal of its side
+    {
+        const Handle_Poly_Triangulation meshSmooth =
+                MeshUtils::smoothNormals(mesh, UnitSystem::radians(30 * Quantity_Degree));
+        QVERIFY(meshSmooth->HasNormals());
+        QCOMPARE(meshSmooth->NbNodes(), 24);
+        QCOMPARE(meshSmooth->NbTriangles(), 12);
+        for (int i = 1; i <= 12; ++i) {
+            int nodeIds[3];
+            meshSmooth->Triangle(i).Get(nodeIds[0], nodeIds[1], nodeIds[2]);
+            int cubeNodeIds[3];
+            cubeTriangles[i - 1].Get(cubeNodeIds[0], cubeNodeIds[1], cubeNodeIds[2]);
+            const gp_Vec triangleNormal =
+                    gp_Vec(mesh->Node(cubeNodeIds[0]), mesh->Node(cubeNodeIds[1]))
+                    .Crossed(gp_Vec(mesh->Node(cubeNodeIds[0]), mesh->Node(cubeNodeIds[2])));
+            for (int j = 0; j < 3; ++j) {
+                QVERIFY(meshSmooth->Node(nodeIds[j]).IsEqual(mesh->Node(cubeNodeIds[j]), Precision::Confusion()));
+                QVERIFY(fnNormal(meshSmooth, nodeIds[j]).IsEqual(triangleNormal, Precision::Confusion(), Precision::Angular()));
+            }
+        }
+    }
+
+    // Crease angle above right angle, nodes are kept with the normal along the diagonal of the cube
+    {
+        const Handle_Poly_Triangulation meshSmooth =
+                MeshUtils::smoothNormals(mesh, UnitSystem::radians(100 * Quantity_Degree));
+        QCOMPARE(meshSmooth->NbNodes(), 8);
+        for (int i = 1; i <= 8; ++i) {
+            const gp_Vec vecDiagonal(gp_Pnt(0.5, 0.5, 0.5), meshSmooth->Node(i));
+            QVERIFY(fnNormal(meshSmooth, i).IsParallel(vecDiagonal, Precision::Angular()));
+            QVERIFY(fnNormal(meshSmooth, i).Dot(vecDiagonal) > 0);
+        }
+    }
+}
+
+void Test::MeshUtils_singlePrecision_test()
+{
+    Handle_Poly_Triangulation mesh = new Poly_Triangulation(4, 2, false);
+    mesh->ChangeNode(1) = gp_Pnt(0, 0, 0);
+    mesh->ChangeNode(2) = gp_Pnt(1000.25, 0, 0);
+    mesh->ChangeNode(3) = gp_Pnt(1000.25, 1.5, 0);
+    mesh->ChangeNode(4) = gp_Pnt(0, 1.5, -0.125);
+    mesh->ChangeTriangle(1) = Poly_Triangle(1, 2, 3);
+    mesh->ChangeTriangle(2) = Poly_Triangle(1, 3, 4);
+    QVERIFY(!MeshUtils::isSinglePrecision(mesh));
+
+    const Handle_Poly_Triangulation meshCopy = MeshUtils::singlePrecisionCopy(mesh);
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    QVERIFY(meshCopy != mesh);
+    QVERIFY(MeshUtils::isSinglePrecision(meshCopy));
+    QCOMPARE(meshCopy->NbNodes(), mesh->NbNodes());
+    QCOMPARE(meshCopy->NbTriangles(), mesh->NbTriangles());
+    // Coordinates above are exact in single precision
+    for (int i = 1; i <= mesh->NbNodes(); ++i)
+        QVERIFY(meshCopy->Node(i).IsEqual(mesh->Node(i), Precision::Confusion()));
+
+    for (int i = 1; i <= mesh->NbTriangles(); ++i) {
+        int n1, n2, n3;
+        int m1, m2, m3;
+        mesh->Triangle(i).Get(n1, n2, n3);
+        meshCopy->Triangle(i).Get(m1, m2, m3);
+        QCOMPARE(m1, n1);
+        QCOMPARE(m2, n2);
+        QCOMPARE(m3, n3);
+    }
+
+    // Already single precision, no copy
+    QVERIFY(MeshUtils::singlePrecisionCopy(meshCopy) == meshCopy);
+#else
+    // Node arrays are always double precision
+    QVERIFY(meshCopy == mesh);
+#endif
+}
+
+void Test::MeshUtils_orientation_test()
+{
+    struct BasicPolyline2d : public Mayo::MeshUtils::AdaptorPolyline2d {
+        gp_Pnt2d pointAt(int index) const override { return this->vecPoint.at(index); }
+        int pointCount() const override { return int(this->vecPoint.size()); }
+        std::vector<gp_Pnt2d> vecPoint;
+    };
+
+    QFETCH(std::vector<gp_Pnt2d>, vecPoint);
+    QFETCH(Mayo::MeshUtils::Orientation, orientation);
+    BasicPolyline2d polyline2d;
+    polyline2d.vecPoint = std::move(vecPoint);
+    QCOMPARE(Mayo::MeshUtils::orientation(polyline2d), orientation);
+}
+
+void Test::MeshUtils_orientation_test_data()
+{
+    QTest::addColumn<std::vector<gp_Pnt2d>>("vecPoint");
+    QTest::addColumn<Mayo::MeshUtils::Orientation>("orientation");
+
+    std::vector<gp_Pnt2d> vecPoint;
+    vecPoint.push_back(gp_Pnt2d(0, 0));
+    vecPoint.push_back(gp_Pnt2d(0, 10));
+    vecPoint.push_back(gp_Pnt2d(10, 10));
+    vecPoint.push_back(gp_Pnt2d(10, 0));
+    vecPoint.push_back(gp_Pnt2d(0, 0)); // Closed polyline
+    QTest::newRow("case1") << vecPoint << Mayo::MeshUtils::Orientation::Clockwise;
+
+    vecPoint.erase(std::prev(vecPoint.end())); // Open polyline
+    QTest::newRow("case2") << vecPoint << Mayo::MeshUtils::Orientation::Clockwise;
+
+    std::reverse(vecPoint.begin(), vecPoint.end());
+    QTest::newRow("case3") << vecPoint << Mayo::MeshUtils::Orientation::CounterClockwise;
+
+    vecPoint.clear();
+    vecPoint.push_back(gp_Pnt2d(0, 0));
+    vecPoint.push_back(gp_Pnt2d(0, 10));
+    vecPoint.push_back(gp_Pnt2d(10, 10));
+    QTest::newRow("case4") << vecPoint << Mayo::MeshUtils::Orientation::Clockwise;
+
+    vecPoint.clear();
+    vecPoint.push_back(gp_Pnt2d(0, 0));
+    vecPoint.push_back(gp_Pnt2d(0, 10));
+    vecPoint.push_back(gp_Pnt2d(-10, 10));
+    vecPoint.push_back(gp_Pnt2d(-10, 0));
+    QTest::newRow("case5") << vecPoint << Mayo::MeshUtils::Orientation::CounterClockwise;
+
+    std::reverse(vecPoint.begin(), vecPoint.end());
+    QTest::newRow("case6") << vecPoint << Mayo::MeshUtils::Orientation::Clockwise;
+
+    {
+        QFile file("inputs/mayo_bezier_curve.brep");
+        QVERIFY(file.open(QIODevice::ReadOnly));
+
+        const TopoDS_Shape shape = BRepUtils::shapeFromString(file.readAll().toStdString());
+        QVERIFY(!shape.IsNull());
+
+        TopoDS_Edge edge;
+        BRepUtils::forEachSubShape(shape, TopAbs_EDGE, [&](const TopoDS_Shape& subShape) {
+            edge = TopoDS::Edge(subShape);
+        });
+        QVERIFY(!edge.IsNull());
+
+        const GCPnts_TangentialDeflection discr(BRepAdaptor_Curve(edge), 0.1, 0.1);
+        vecPoint.clear();
+        for (int i = 1; i <= discr.NbPoints(); ++i) {
+            const gp_Pnt pnt = discr.Value(i);
+            vecPoint.push_back(gp_Pnt2d(pnt.X(), pnt.Y()));
+        }
+
+        QTest::newRow("case7") << vecPoint << Mayo::MeshUtils::Orientation::CounterClockwise;
+
+        std::reverse(vecPoint.begin(), vecPoint.end());
+        QTest::newRow("case8") << vecPoint << Mayo::MeshUtils::Orientation::Clockwise;
+    }
+}
+
+void Test::Messenger_batch_test()
+{
+    MessengerQtSignal messenger;
+    messenger.setBatchInterval(20);
+    messenger.setMaxMessagesPerSecond(5);
+    QSignalSpy sigSpy_messagesBatched(&messenger, &MessengerQtSignal::messagesBatched);
+    QSignalSpy sigSpy_message(&messenger, &MessengerQtSignal::message);
+
+    // Messages are emitted concurrently, then signaled in batch by the thread of the messenger
+    std::vector<std::thread> vecThread;
+    for (int i = 0; i < 4; ++i) {
+        vecThread.emplace_back([&]{
+            for (int j = 0; j < 250; ++j)
+                messenger.emitError("Failure");
+
+            messenger.emitInfo("Done");
+        });
+    }
+
+    for (std::thread& thread : vecThread)
+        thread.join();
+
+    QTRY_VERIFY(!sigSpy_messagesBatched.isEmpty());
+    int errorCount = 0;
+    int infoCount = 0;
+    for (const QList<QVariant>& args : sigSpy_messagesBatched) {
+        const auto vecMessage = args.at(0).value<std::vector<MessengerQtSignal::Message>>();
+        // Identical messages are coalesced
+        QVERIFY(vecMessage.size() <= 2);
+        for (const MessengerQtSignal::Message& msg : vecMessage) {
+            if (msg.type == Messenger::MessageType::Error)
+                errorCount += msg.count;
+            else if (msg.type == Messenger::MessageType::Info)
+                infoCount += msg.count;
+        }
+    }
+
+    QCOMPARE(errorCount, 1000);
+    QCOMPARE(infoCount, 4);
+    QVERIFY(sigSpy_message.count() <= 5);
+}
+
+void Test::MetaEnum_test()
+{
+    QCOMPARE(MetaEnum::name(TopAbs_VERTEX), "TopAbs_VERTEX");
+    QCOMPARE(MetaEnum::name(TopAbs_EDGE), "TopAbs_EDGE");
+    QCOMPARE(MetaEnum::name(TopAbs_WIRE), "TopAbs_WIRE");
+    QCOMPARE(MetaEnum::name(TopAbs_FACE), "TopAbs_FACE");
+    QCOMPARE(MetaEnum::name(TopAbs_SHELL), "TopAbs_SHELL");
+    QCOMPARE(MetaEnum::nameWithoutPrefix(TopAbs_SOLID, "TopAbs_"), "SOLID");
+    QCOMPARE(MetaEnum::nameWithoutPrefix(TopAbs_COMPOUND, "TopAbs_"), "COMPOUND");
+
+    QCOMPARE(MetaEnum::nameWithoutPrefix(TopAbs_VERTEX, "Abs"), "TopAbs_VERTEX");
+    QCOMPARE(MetaEnum::nameWithoutPrefix(TopAbs_VERTEX, ""), "TopAbs_VERTEX");
+}
+
+void Test::MassProperties_test()
+{
+    const TopoDS_Shape box = BRepPrimAPI_MakeBox(gp_Pnt(0, 0, 0), 10, 20, 30);
+    const MassProperties props = MassProperties::compute(box);
+    QCOMPARE(props.volume, 6000.);
+    QCOMPARE(props.area, 2 * (10 * 20 + 20 * 30 + 10 * 30.));
+    QVERIFY(props.centroid.IsEqual(gp_Pnt(5, 10, 15), Precision::Confusion()));
+    // Moment of inertia along X axis of a cuboid: m(b² + c²)/12
+    QVERIFY(std::abs(props.matrixOfInertia.Value(1, 1) - 6000. * (20 * 20 + 30 * 30) / 12.) < 1e-3);
+
+    // Shape without solid
+    const TopoDS_Shape face = BRepBuilderAPI_MakeFace(gp_Pln(gp::XOY()), 0, 4, 0, 2);
+    const MassProperties faceProps = MassProperties::compute(face);
+    QCOMPARE(faceProps.volume, 0.);
+    QCOMPARE(faceProps.area, 8.);
+    QVERIFY(faceProps.centroid.IsEqual(gp_Pnt(2, 1, 0), Precision::Confusion()));
+
+    QCOMPARE(MassProperties::compute(TopoDS_Shape()).volume, 0.);
+}
+
+void Test::ShapeDistance_test()
+{
+    const TopoDS_Shape box1 = BRepPrimAPI_MakeBox(gp_Pnt(0, 0, 0), 10, 10, 10);
+    const TopoDS_Shape box2 = BRepPrimAPI_MakeBox(gp_Pnt(13, 2, 0), 10, 10, 10);
+    // Without triangulation, distance is computed on exact geometry
+    const ShapeDistance exactDist = ShapeDistance::compute(box1, box2);
+    QVERIFY(exactDist.isExact);
+    QVERIFY(std::abs(exactDist.value - 3.) < Precision::Confusion());
+
+    // With triangulation, same result after refinement of the closest faces
+    OccBRepMeshParameters params;
+    params.Deflection = 0.5;
+    params.Angle = 0.5;
+    BRepUtils::computeMesh(box1, params);
+    BRepUtils::computeMesh(box2, params);
+    const ShapeDistance dist = ShapeDistance::compute(box1, box2);
+    QVERIFY(dist.isExact);
+    QVERIFY(std::abs(dist.value - 3.) < Precision::Confusion());
+    QVERIFY(std::abs(dist.pnt1.X() - 10.) < Precision::Confusion());
+    QVERIFY(std::abs(dist.pnt2.X() - 13.) < Precision::Confusion());
+
+    // Location of the shapes applies
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(5, 0, 0));
+    const ShapeDistance movedDist = ShapeDistance::compute(box1, box2.Moved(TopLoc_Location(trsf)));
+    QVERIFY(std::abs(movedDist.value - 8.) < Precision::Confusion());
+
+    QVERIFY(ShapeDistance::compute(box1, TopoDS_Shape()).value < 0);
+}
+
+void Test::GeometryDedup_test()
+{
+    // Fingerprints match for shapes built separately, not for different sizes or positions
+    const TopoDS_Shape box = BRepPrimAPI_MakeBox(10, 20, 30);
+    const TopoDS_Shape boxCopy = BRepPrimAPI_MakeBox(10, 20, 30);
+    const double tol = 1e-4;
+    QVERIFY(box.TShape() != boxCopy.TShape());
+    QVERIFY(GeometryDedup::fingerprint(box, tol) == GeometryDedup::fingerprint(boxCopy, tol));
+    QVERIFY(!(GeometryDedup::fingerprint(box, tol) == GeometryDedup::fingerprint(BRepPrimAPI_MakeBox(10, 20, 31), tol)));
+    QVERIFY(!(GeometryDedup::fingerprint(box, tol) == GeometryDedup::fingerprint(BRepPrimAPI_MakeBox(gp_Pnt(1, 0, 0), 10, 20, 30), tol)));
+
+    // Two "files" each having an assembly with instances of its own box
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const TDF_Label labelAssembly1 = addTwoInstancesAssembly(doc, box);
+    const TDF_Label labelAssembly2 = addTwoInstancesAssembly(doc, boxCopy);
+    const TDF_LabelSequence seqComponent1 = XCaf::shapeComponents(labelAssembly1);
+    const TDF_LabelSequence seqComponent2 = XCaf::shapeComponents(labelAssembly2);
+    QCOMPARE(seqComponent2.Size(), 2);
+    const TDF_Label labelProduct1 = XCaf::shapeReferred(seqComponent1.First());
+    QVERIFY(XCaf::shapeReferred(seqComponent2.First()) != labelProduct1);
+
+    // Single file: nothing merged
+    const TDF_LabelSequence seqFile[] = {
+        CafUtils::makeLabelSequence({ labelAssembly1 }), CafUtils::makeLabelSequence({ labelAssembly2 })
+    };
+    QCOMPARE(GeometryDedup::mergeProducts(doc, Span<const TDF_LabelSequence>(seqFile, 1), tol), 0);
+
+    // Product of second file is replaced by the one of first file, locations are kept
+    const TopLoc_Location locComponent = XCaf::shapeReferenceLocation(seqComponent2.Last());
+    QCOMPARE(GeometryDedup::mergeProducts(doc, seqFile, tol), 1);
+    for (const TDF_Label& labelComponent : seqComponent2) {
+        QCOMPARE(XCaf::shapeReferred(labelComponent), labelProduct1);
+        QVERIFY(XCaf::shape(labelComponent).TShape() == box.TShape());
+    }
+
+    QVERIFY(XCaf::shapeReferenceLocation(seqComponent2.Last()).IsEqual(locComponent));
+    QCOMPARE(doc->xcaf().topLevelFreeShapes().Size(), 2);
+}
+
+void Test::ReimportDiff_test()
+{
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    const TopoDS_Shape box = BRepPrimAPI_MakeBox(10, 20, 30);
+    const TDF_Label labelPrevious = addTwoInstancesAssembly(doc, box);
+    BRepMesh_IncrementalMesh mesher(box, 1.);
+
+    // Same geometry imported again: triangulations are carried over, entity is identical
+    const TopoDS_Shape boxCopy = BRepPrimAPI_MakeBox(10, 20, 30);
+    const TDF_Label labelNew = addTwoInstancesAssembly(doc, boxCopy);
+    ReimportDiff diff(doc);
+    diff.compare(std::vector<TDF_Label>{ labelPrevious }, std::vector<TDF_Label>{ labelNew });
+    QCOMPARE(diff.unchangedProductCount(), 1);
+    QCOMPARE(diff.changedProductCount(), 0);
+    QCOMPARE(diff.findIdenticalPreviousEntity(labelNew), labelPrevious);
+    QCOMPARE(diff.carryOverTriangulations(), 1);
+    BRepUtils::forEachSubFace(boxCopy, [](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        QVERIFY(!BRep_Tool::Triangulation(face, loc).IsNull());
+    });
+
+    // Modified geometry: nothing reused
+    const TDF_Label labelModified = addTwoInstancesAssembly(doc, BRepPrimAPI_MakeBox(10, 20, 31));
+    diff.compare(std::vector<TDF_Label>{ labelPrevious }, std::vector<TDF_Label>{ labelModified });
+    QCOMPARE(diff.unchangedProductCount(), 0);
+    QCOMPARE(diff.changedProductCount(), 1);
+    QVERIFY(diff.findIdenticalPreviousEntity(labelModified).IsNull());
+    QCOMPARE(diff.carryOverTriangulations(), 0);
+}
+
+void Test::MemoryStats_test()
+{
+    const TopoDS_Shape box = BRepPrimAPI_MakeBox(10, 10, 10);
+    {
+        MemoryAccounting accounting;
+        accounting.addShape(box);
+        const MemoryStats stats = accounting.stats();
+        QVERIFY(stats.brepGeometry > 0);
+        QCOMPARE(stats.triangulation, int64_t(0));
+        QCOMPARE(stats.total(), stats.brepGeometry);
+
+        // Shape already visited
+        accounting.addShape(box.Moved(TopLoc_Location(gp_Trsf())));
+        QCOMPARE(accounting.stats().brepGeometry, stats.brepGeometry);
+    }
+
+    BRepMesh_IncrementalMesh mesher(box, 1.);
+    int64_t boxTriangulationSize = 0;
+    {
+        MemoryAccounting accounting;
+        accounting.addShape(box);
+        boxTriangulationSize = accounting.stats().triangulation;
+        // At least nodes and triangles of the 6 faces
+        QVERIFY(boxTriangulationSize >= 6 * int64_t(4 * sizeof(gp_Pnt) + 2 * sizeof(Poly_Triangle)));
+    }
+
+    // Product shared by two instances is accounted once
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+    TopoDS_Compound compound;
+    BRep_Builder builder;
+    builder.MakeCompound(compound);
+    gp_Trsf trsf;
+    trsf.SetTranslation(gp_Vec(20, 0, 0));
+    builder.Add(compound, box);
+    builder.Add(compound, box.Moved(TopLoc_Location(trsf)));
+    const TDF_Label labelAssembly = doc->xcaf().shapeTool()->AddShape(compound, true/*makeAssembly*/);
+    doc->addEntityTreeNode(labelAssembly);
+    MemoryAccounting docAccounting;
+    docAccounting.addDocument(doc);
+    QCOMPARE(docAccounting.stats().triangulation, boxTriangulationSize);
+    QVERIFY(docAccounting.stats().ocafData > 0);
+    QCOMPARE(docAccounting.stats().presentation, int64_t(0));
+    QVERIFY(docAccounting.stats().toJson().find("\"total\":") != std::string::npos);
+}
+
+void Test::ProcessUtils_test()
+{
+#if defined(Q_OS_LINUX) || defined(Q_OS_WIN) || defined(Q_OS_MACOS)
+    const int64_t currentSize = ProcessUtils::currentResidentMemorySize();
+    QVERIFY(currentSize > 0);
+    QVERIFY(ProcessUtils::residentMemorySize(QCoreApplication::applicationPid()) > 0);
+#endif
+    QCOMPARE(ProcessUtils::residentMemorySize(-1), int64_t(-1));
+}
+
+void Test::MeshCompression_test()
+{
+#if OCC_VERSION_HEX >= OCC_VERSION_CHECK(7, 6, 0)
+    const TopoDS_Shape shapeSphere = BRepPrimAPI_MakeSphere(10);
+    OccBRepMeshParameters params;
+    params.Deflection = 0.01;
+    params.Angle = 0.2;
+    BRepUtils::computeMesh(shapeSphere, params);
+    const TopoDS_Face face = TopoDS::Face(TopExp_Explorer(shapeSphere, TopAbs_FACE).Current());
+    TopLoc_Location loc;
+    const Handle_Poly_Triangulation triangulation = BRep_Tool::Triangulation(face, loc);
+    QVERIFY(!triangulation.IsNull());
+    triangulation->ComputeNormals();
+    const Handle_Poly_Triangulation triangulationCopy = triangulation->Copy();
+
+    const MeshCompression::Data data = MeshCompression::compress(triangulation);
+    QCOMPARE(data.nodeCount, triangulation->NbNodes());
+    QCOMPARE(data.triangleCount, triangulation->NbTriangles());
+    MemoryAccounting accounting;
+    accounting.addTriangulation(triangulationCopy);
+    QVERIFY(data.memorySize() < accounting.stats().triangulation);
+
+    // Triangulation object is kept, so is the link with the face
+    MeshCompression::releaseArrays(triangulation);
+    QCOMPARE(triangulation->NbNodes(), 0);
+    QCOMPARE(triangulation->NbTriangles(), 0);
+    MeshCompression::decompress(data, triangulation);
+    QVERIFY(BRep_Tool::Triangulation(face, loc) == triangulation);
+    QCOMPARE(triangulation->NbNodes(), triangulationCopy->NbNodes());
+    QCOMPARE(triangulation->NbTriangles(), triangulationCopy->NbTriangles());
+    QVERIFY(triangulation->HasNormals());
+    QCOMPARE(triangulation->HasUVNodes(), triangulationCopy->HasUVNodes());
+
+    // Triangles are exact, nodes are within the quantization step
+    for (int i = 1; i <= triangulation->NbTriangles(); ++i) {
+        int n1, n2, n3;
+        int m1, m2, m3;
+        triangulation->Triangle(i).Get(n1, n2, n3);
+        triangulationCopy->Triangle(i).Get(m1, m2, m3);
+        QVERIFY(n1 == m1 && n2 == m2 && n3 == m3);
+    }
+
+    const double stepMax = std::max({ data.nodeStep.X(), data.nodeStep.Y(), data.nodeStep.Z() });
+    for (int i = 1; i <= triangulation->NbNodes(); ++i) {
+        QVERIFY(triangulation->Node(i).Distance(triangulationCopy->Node(i)) <= stepMax);
+        QVERIFY(triangulation->Normal(i).Angle(triangulationCopy->Normal(i)) < 0.001);
+    }
+
+    // Store keeps the compressed data until shape is expanded
+    CompactTriangulationStore store;
+    QCOMPARE(store.compact(shapeSphere), 1);
+    QVERIFY(store.isCompacted(triangulation));
+    QVERIFY(!store.isEmpty());
+    QCOMPARE(triangulation->NbNodes(), 0);
+    QVERIFY(store.compressedMemorySize(triangulation) > 0);
+    QCOMPARE(store.compact(shapeSphere), 0);
+    store.expand(Span<const TopoDS_Shape>(&shapeSphere, 1));
+    QVERIFY(store.isEmpty());
+    QCOMPARE(triangulation->NbNodes(), triangulationCopy->NbNodes());
+    QCOMPARE(store.compressedMemorySize(triangulation), int64_t(0));
+#endif
+}
+
+void Test::MeshDecimation_test()
+{
+    // Slightly curved grid, so edge collapses have non-zero quadric errors
+    constexpr int gridSize = 40;
+    constexpr int nodeCount = (gridSize + 1) * (gridSize + 1);
+    constexpr int triangleCount = gridSize * gridSize * 2;
+    Handle_Poly_Triangulation mesh = new Poly_Triangulation(nodeCount, triangleCount, false);
+    for (int i = 0; i < nodeCount; ++i) {
+        const int x = i % (gridSize + 1);
+        const int y = i / (gridSize + 1);
+        mesh->ChangeNode(i + 1) = gp_Pnt(x, y, 0.05 * std::sin(x * 0.3) * std::cos(y * 0.2));
+    }
+
+    int iTriangle = 1;
+    for (int i = 0; i < gridSize; ++i) {
+        for (int j = 0; j < gridSize; ++j) {
+            const int n1 = i * (gridSize + 1) + j + 1;
+            const int n2 = n1 + 1;
+            const int n3 = n1 + gridSize + 1;
+            const int n4 = n3 + 1;
+            mesh->ChangeTriangle(iTriangle++) = Poly_Triangle(n1, n2, n4);
+            mesh->ChangeTriangle(iTriangle++) = Poly_Triangle(n1, n4, n3);
+        }
+    }
+
+    MeshDecimation::Parameters params;
+    params.targetRatio = 0.25;
+    params.preserveBorders = true;
+    const Handle_Poly_Triangulation meshDecimated = MeshDecimation::decimated(mesh, params);
+    QVERIFY(meshDecimated != mesh);
+    QVERIFY(meshDecimated->NbTriangles() <= triangleCount / 4);
+    QVERIFY(meshDecimated->NbTriangles() > 0);
+    // Source mesh is left untouched
+    QCOMPARE(mesh->NbTriangles(), triangleCount);
+
+    // All the nodes on the grid border are kept, and no triangle is flipped
+    int borderNodeCount = 0;
+    for (int i = 1; i <= meshDecimated->NbNodes(); ++i) {
+        const gp_Pnt& pnt = meshDecimated->Node(i);
+        if (pnt.X() == 0 || pnt.Y() == 0 || pnt.X() == gridSize || pnt.Y() == gridSize)
+            ++borderNodeCount;
+    }
+
+    QCOMPARE(borderNodeCount, 4 * gridSize);
+    for (int i = 1; i <= meshDecimated->NbTriangles(); ++i) {
+        int n1, n2, n3;
+        meshDecimated->Triangle(i).Get(n1, n2, n3);
+        const gp_Vec vec12(meshDecimated->Node(n1), meshDecimated->Node(n2));
+        const gp_Vec vec13(meshDecimated->Node(n1), meshDecimated->Node(n3));
+        QVERIFY(vec12.Crossed(vec13).Z() > 0);
+    }
+
+    // Nothing to do with ratio 1
+    params.targetRatio = 1.;
+    QVERIFY(MeshDecimation::decimated(mesh, params) == mesh);
+
+    // Concurrent decimation of multiple meshes gives the same results
+    params.targetRatio = 0.25;
+    const std::vector<Handle_Poly_Triangulation> vecMesh = { mesh, mesh };
+    const std::vector<Handle_Poly_Triangulation> vecMeshDecimated = MeshDecimation::decimated(vecMesh, params);
+    QCOMPARE(vecMeshDecimated.size(), vecMesh.size());
+    for (const Handle_Poly_Triangulation& triangulation : vecMeshDecimated)
+        QCOMPARE(triangulation->NbTriangles(), meshDecimated->NbTriangles());
+}
+
+void Test::MeshUtils_test()
+{
+    // Create box
+    QFETCH(double, boxDx);
+    QFETCH(double, boxDy);
+    QFETCH(double, boxDz);
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(boxDx, boxDy, boxDz);
+
+    // Mesh box
+    {
+        BRepMesh_IncrementalMesh mesher(shapeBox, 0.1);
+        mesher.Perform();
+        QVERIFY(mesher.IsDone());
+    }
+
+    // Count nodes and triangles
+    int countNode = 0;
+    int countTriangle = 0;
+    BRepUtils::forEachSubFace(shapeBox, [&](const TopoDS_Face& face) {
+        TopLoc_Location loc;
+        const Handle_Poly_Triangulation& polyTri = BRep_Tool::Triangulation(face, loc);
+        if (!polyTri.IsNull()) {
+            countNode += polyTri->NbNodes();
+            countTriangle += polyTri->NbTriangles();
+        }
+    });
+
+    // Merge all face triangulations into one
+    Handle_Poly_Triangulation polyTriBox = new Poly_Triangulation(countNode, countTriangle, false);
+    {
+        int idNodeOffset = 0;
+        int idTriangleOffset = 0;
+        BRepUtils::forEachSubFace(shapeBox, [&](const TopoDS_Face& face) {
+            TopLoc_Location loc;
+            const Handle_Poly_Triangulation& polyTri = BRep_Tool::Triangulation(face, loc);
+            if (!polyTri.IsNull()) {
+                for (int i = 1; i <= polyTri->NbNodes(); ++i)
+                    polyTriBox->ChangeNode(idNodeOffset + i) = polyTri->Node(i);
+
+                for (int i = 1; i <= polyTri->NbTriangles(); ++i) {
+                    int n1, n2, n3;
+                    polyTri->Triangle(i).Get(n1, n2, n3);
+                    polyTriBox->ChangeTriangle(idTriangleOffset + i).Set(
+                                idNodeOffset + n1, idNodeOffset + n2, idNodeOffset + n3);
+                }
+
+                idNodeOffset += polyTri->NbNodes();
+                idTriangleOffset += polyTri->NbTriangles();
+            }
+        });
+    }
+
+    // Checks
+    QCOMPARE(MeshUtils::triangulationVolume(polyTriBox),
+             double(boxDx * boxDy * boxDz));
     QCOMPARE(MeshUtils::triangulationArea(polyTriBox),
              double(2 * boxDx * boxDy + 2 * boxDy * boxDz + 2 * boxDx * boxDz));
+
+    const MeshUtils::TriangulationProperties props = MeshUtils::triangulationProperties(polyTriBox);
+    QCOMPARE(props.volume, double(boxDx * boxDy * boxDz));
+    QCOMPARE(props.area, double(2 * boxDx * boxDy + 2 * boxDy * boxDz + 2 * boxDx * boxDz));
+    QCOMPARE(props.centroid.X(), boxDx / 2.);
+    QCOMPARE(props.centroid.Y(), boxDy / 2.);
+    QCOMPARE(props.centroid.Z(), boxDz / 2.);
+    QVERIFY(!props.boundingBox.IsVoid());
+    QVERIFY(props.boundingBox.CornerMin().IsEqual(gp_Pnt(0, 0, 0), Precision::Confusion()));
+    QVERIFY(props.boundingBox.CornerMax().IsEqual(gp_Pnt(boxDx, boxDy, boxDz), Precision::Confusion()));
 }
 
 void Test::MeshUtils_test_data()
@@ -514,6 +3038,59 @@ void Test::MeshUtils_test_data()
     QTest::newRow("case4") << 40. << 50. << 70.;
 }
 
+void Test::PerfStats_test()
+{
+    auto _ = gsl::finally([]{ PerfStats::setEnabled(false); });
+    PerfStats stats;
+
+    // Nothing recorded while disabled
+    PerfStats::setEnabled(false);
+    {
+        PerfScopedTimer timer(&stats, "stage");
+    }
+    QVERIFY(stats.isEmpty());
+
+    PerfStats::setEnabled(true);
+    auto fnRecord = [&]{
+        PerfScopedTimer timer(&stats, "stage");
+        stats.addCounter("counter");
+    };
+    std::thread thread(fnRecord);
+    fnRecord();
+    thread.join();
+    stats.addStageDuration("other", std::chrono::milliseconds(5));
+    stats.addCounter("counter", 3);
+
+    const std::vector<PerfStats::Stage> vecStage = stats.stages();
+    QCOMPARE(int(vecStage.size()), 2);
+    QVERIFY(vecStage.at(0).name == "stage");
+    QCOMPARE(vecStage.at(0).callCount, 2);
+    QCOMPARE(vecStage.at(0).threadCount, 2);
+    QVERIFY(vecStage.at(0).maxDuration <= vecStage.at(0).totalDuration);
+    QVERIFY(vecStage.at(1).name == "other");
+    QVERIFY(vecStage.at(1).totalDuration == std::chrono::milliseconds(5));
+    const std::vector<PerfStats::Counter> vecCounter = stats.counters();
+    QCOMPARE(int(vecCounter.size()), 1);
+    QCOMPARE(vecCounter.at(0).value, int64_t(5));
+
+    const std::string json = stats.toJson("task");
+    QVERIFY(json.find("\"name\":\"task\"") != std::string::npos);
+    QVERIFY(json.find("{\"name\":\"other\",\"calls\":1,\"totalMs\":5,") != std::string::npos);
+    QVERIFY(json.find("{\"name\":\"counter\",\"value\":5}") != std::string::npos);
+
+    // Stats of a task are bound to its TaskProgress
+    TaskManager taskMgr;
+    const TaskId taskId = taskMgr.newTask([](TaskProgress* progress) {
+        PerfScopedTimer timer(PerfStats::of(progress), "job");
+    });
+    taskMgr.exec(taskId, TaskAutoDestroy::Off);
+    QVERIFY(taskMgr.perfStats(taskId) != nullptr);
+    QCOMPARE(int(taskMgr.perfStats(taskId)->stages().size()), 1);
+
+    stats.clear();
+    QVERIFY(stats.isEmpty());
+}
+
 void Test::Quantity_test()
 {
     const QuantityArea area = (10 * Quantity_Millimeter) * (5 * Quantity_Centimeter);
@@ -564,15 +3141,159 @@ void Test::Result_test()
         QCOMPARE(sstr.str().c_str(), "02");
     }
     {
-        std::ostringstream sstr;
-        Result::Data::data_ostr = &sstr;
-        Result::Data data;
-        data.foo = "FooData";
-        const Result res = Result::ok(std::move(data));
-        QVERIFY(res.valid());
-        QVERIFY(res.get().foo == "FooData");
-        QCOMPARE(sstr.str().c_str(), "0042");
+        std::ostringstream sstr;
+        Result::Data::data_ostr = &sstr;
+        Result::Data data;
+        data.foo = "FooData";
+        const Result res = Result::ok(std::move(data));
+        QVERIFY(res.valid());
+        QVERIFY(res.get().foo == "FooData");
+        QCOMPARE(sstr.str().c_str(), "0042");
+    }
+}
+
+void Test::Settings_pendingValues_test()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString strFilepathIni = tempDir.filePath("settings.ini");
+    {
+        QSettings fileSettings(strFilepathIni, QSettings::IniFormat);
+        fileSettings.setValue("import/STEP/intProp", 42);
+        fileSettings.setValue("import/STEP/boolProp", true);
+        fileSettings.setValue("import/STEP/hiddenProp", 7);
+        fileSettings.sync();
+    }
+
+    Settings settings;
+    const Settings::GroupIndex groupId = settings.addGroup(QByteArray("import"));
+    const Settings::SectionIndex sectionId = settings.addSection(groupId, QByteArray("STEP"));
+    PropertyInt propInt(nullptr, MAYO_TEXT_ID("Mayo::Test", "intProp"));
+    settings.addSetting(&propInt, sectionId);
+
+    const QSettings fileSettings(strFilepathIni, QSettings::IniFormat);
+    settings.loadFrom(fileSettings, [](const Property& prop) { return !prop.isUserVisible(); });
+    QCOMPARE(propInt.value(), 42);
+
+    // Settings added after loading get their stored values
+    PropertyBool propBool(nullptr, MAYO_TEXT_ID("Mayo::Test", "boolProp"));
+    settings.addSetting(&propBool, sectionId);
+    QCOMPARE(propBool.value(), true);
+
+    // Exclusion predicate still applies
+    PropertyInt propHidden(nullptr, MAYO_TEXT_ID("Mayo::Test", "hiddenProp"));
+    propHidden.setUserVisible(false);
+    settings.addSetting(&propHidden, sectionId);
+    QCOMPARE(propHidden.value(), 0);
+
+    // Pending value is consumed once
+    PropertyBool propBoolOther(nullptr, MAYO_TEXT_ID("Mayo::Test", "boolProp"));
+    settings.addSetting(&propBoolOther, sectionId);
+    QCOMPARE(propBoolOther.value(), false);
+}
+
+void Test::Settings_applyValue_test()
+{
+    Settings settings;
+    const Settings::GroupIndex groupId_meshing = settings.addGroup(QByteArray("meshing"));
+    PropertyInt propQuality(nullptr, MAYO_TEXT_ID("Mayo::Test", "quality"));
+    settings.addSetting(&propQuality, groupId_meshing);
+    const Settings::GroupIndex groupId_import = settings.addGroup(QByteArray("import"));
+    const Settings::SectionIndex sectionId_STEP = settings.addSection(groupId_import, QByteArray("STEP"));
+
+    // Path without section targets the default section
+    QVERIFY(settings.applyValue("meshing/quality", "3"));
+    QCOMPARE(propQuality.value(), 3);
+    QVERIFY(settings.applyValue("meshing/DEFAULT/quality", 5));
+    QCOMPARE(propQuality.value(), 5);
+
+    // Value of setting not added yet is applied on addSetting()
+    QVERIFY(settings.applyValue("import/STEP/boolProp", "true"));
+    PropertyBool propBool(nullptr, MAYO_TEXT_ID("Mayo::Test", "boolProp"));
+    settings.addSetting(&propBool, sectionId_STEP);
+    QCOMPARE(propBool.value(), true);
+
+    // Conversion failure
+    enum class MayoTest_Mode { Fast, Precise };
+    PropertyEnum<MayoTest_Mode> propEnum(nullptr, MAYO_TEXT_ID("Mayo::Test", "enumProp"));
+    settings.addSetting(&propEnum, sectionId_STEP);
+    QVERIFY(!settings.applyValue("import/STEP/enumProp", "NotAnEnumItem"));
+    QVERIFY(settings.applyValue("import/STEP/enumProp", "Precise"));
+    QVERIFY(propEnum.value() == MayoTest_Mode::Precise);
+}
+
+void Test::Settings_unsavedChanges_test()
+{
+    Settings settings;
+    PropertyGroup group(&settings);
+    PropertyInt propQuality(&group, MAYO_TEXT_ID("Mayo::Test", "quality"));
+    PropertyInt propNotSetting(&group, MAYO_TEXT_ID("Mayo::Test", "notSetting"));
+    const Settings::GroupIndex groupId_meshing = settings.addGroup(QByteArray("meshing"));
+    settings.addSetting(&propQuality, groupId_meshing);
+    QVERIFY(!settings.hasUnsavedChanges());
+
+    // Overriden values are not changes to be saved
+    QVERIFY(settings.applyValue("meshing/quality", 3));
+    QCOMPARE(propQuality.value(), 3);
+    QVERIFY(!settings.hasUnsavedChanges());
+
+    // Only properties registered as settings are tracked
+    propNotSetting.setValue(2);
+    QVERIFY(!settings.hasUnsavedChanges());
+
+    propQuality.setValue(4);
+    QVERIFY(settings.hasUnsavedChanges());
+    QCOMPARE(settings.autoSaveDelay(), 0);
+}
+
+void Test::Settings_changedBatch_test()
+{
+    Settings settings;
+    PropertyGroup group(&settings);
+    PropertyInt propQuality(&group, MAYO_TEXT_ID("Mayo::Test", "quality"));
+    PropertyBool propRelative(&group, MAYO_TEXT_ID("Mayo::Test", "relative"));
+    const Settings::GroupIndex groupId_meshing = settings.addGroup(QByteArray("meshing"));
+    settings.addSetting(&propQuality, groupId_meshing);
+    settings.addSetting(&propRelative, groupId_meshing);
+    settings.addResetFunction(groupId_meshing, [&]{
+        propQuality.setValue(1);
+        propRelative.setValue(true);
+        propQuality.setValue(2);
+    });
+
+    int changedCount = 0;
+    std::vector<std::vector<Property*>> vecChangedMany;
+    QObject::connect(&settings, &Settings::changed, [&]{ ++changedCount; });
+    QObject::connect(&settings, &Settings::changedMany, [&](Span<Property* const> props) {
+        vecChangedMany.emplace_back(props.begin(), props.end());
+    });
+
+    // Single change outside of a batch
+    propQuality.setValue(5);
+    QCOMPARE(changedCount, 1);
+    QVERIFY(vecChangedMany.empty());
+
+    // Reset is a batch: one notification, each changed setting listed once
+    settings.resetGroup(groupId_meshing);
+    QCOMPARE(changedCount, 1);
+    QCOMPARE(int(vecChangedMany.size()), 1);
+    const std::vector<Property*> vecExpected = { &propQuality, &propRelative };
+    QVERIFY(vecChangedMany.front() == vecExpected);
+    QCOMPARE(propQuality.value(), 2);
+
+    // Nested batches notify once, when the outermost one ends
+    {
+        PropertyChangedBatch batch(&settings);
+        {
+            PropertyChangedBatch nestedBatch(&settings);
+            propRelative.setValue(false);
+        }
+
+        QCOMPARE(int(vecChangedMany.size()), 1);
     }
+
+    QCOMPARE(int(vecChangedMany.size()), 2);
+    QCOMPARE(changedCount, 1);
 }
 
 void Test::StringUtils_append_test()
@@ -646,6 +3367,26 @@ void Test::StringUtils_text_test_data()
     QTest::newRow("c_pnt0.55,4.8977,15.1445")
             << StringUtils::text(gp_Pnt(0.55, 4.8977, 15.1445), opts_c_si_2)
             << QStringLiteral("(0.55mm 4.9mm 15.14mm)");
+    QTest::newRow("c_-2.5")
+            << StringUtils::text(-2.5, opts_c_si_2)
+            << QStringLiteral("-2.5");
+    QTest::newRow("c_1234.5678")
+            << StringUtils::text(1234.5678, opts_c_si_2)
+            << QStringLiteral("1234.57");
+    QTest::newRow("c_100")
+            << StringUtils::text(100., opts_c_si_2)
+            << QStringLiteral("100");
+    QTest::newRow("fr_-1234.5")
+            << StringUtils::text(-1234.5, opts_fr_si_2)
+            << opts_fr_si_2.locale.toString(-1234.5, 'f', 1);
+    {
+        gp_Trsf trsf;
+        trsf.SetRotation(gp::OZ(), M_PI / 2.);
+        trsf.SetTranslationPart(gp_Vec(1, 2, 3));
+        QTest::newRow("c_trsf")
+                << StringUtils::text(trsf, opts_c_si_2)
+                << QString::fromUtf8("[(0 0 1); 90°; (1mm 2mm 3mm)]");
+    }
 }
 
 void Test::StringUtils_stringConversion_test()
@@ -657,6 +3398,76 @@ void Test::StringUtils_stringConversion_test()
     QCOMPARE(StringUtils::fromUtf16(StringUtils::toUtf16<TCollection_ExtendedString>(text)), text);
 }
 
+void Test::StringUtils_appendNumber_test()
+{
+    auto fnNumber = [](double value, std::chars_format fmt, int precision) {
+        std::string str;
+        StringUtils::appendNumber(&str, value, fmt, precision);
+        return str;
+    };
+
+    // Decimal point must not depend on the C locale, if a comma-decimal locale is available
+    const std::string oldLocale = std::setlocale(LC_NUMERIC, nullptr);
+    auto _ = gsl::finally([=]{ std::setlocale(LC_NUMERIC, oldLocale.c_str()); });
+    for (const char* locale : { "C", "de_DE.UTF-8", "fr_FR.UTF-8" }) {
+        if (!std::setlocale(LC_NUMERIC, locale))
+            continue;
+
+        QCOMPARE(fnNumber(1.5, std::chars_format::general, 9), std::string("1.5"));
+        QCOMPARE(fnNumber(0.1, std::chars_format::general, 9), std::string("0.1"));
+        QCOMPARE(fnNumber(-2.25, std::chars_format::scientific, 6), std::string("-2.250000e+00"));
+        QCOMPARE(fnNumber(1234.5, std::chars_format::fixed, 2), std::string("1234.50"));
+        QCOMPARE(fnNumber(1e-7, std::chars_format::general, 6), std::string("1e-07"));
+    }
+
+    char buff[4];
+    QCOMPARE(StringUtils::formatNumber(buff, int(sizeof(buff)), 123456., std::chars_format::general, 9), 0);
+}
+
+void Test::TraceRecorder_test()
+{
+    auto _ = gsl::finally([]{
+        TraceRecorder::global()->stop();
+        PerfStats::setEnabled(false);
+    });
+    PerfStats::setEnabled(true);
+    TraceRecorder* recorder = TraceRecorder::global();
+    recorder->start();
+    QVERIFY(TraceRecorder::isRecording());
+    QCOMPARE(recorder->eventCount(), 0);
+
+    // Task manager created while recording is attached
+    {
+        TaskManager taskMgr;
+        const TaskId taskId = taskMgr.newTask([](TaskProgress* progress) {
+            PerfScopedTimer timer(PerfStats::of(progress), "job \"scope\"");
+            progress->setStep("Step");
+        });
+        taskMgr.setTitle(taskId, "Traced");
+        taskMgr.exec(taskId);
+    }
+
+    recorder->stop();
+    QVERIFY(!TraceRecorder::isRecording());
+    const int eventCount = recorder->eventCount();
+    recorder->addScope("ignored", TraceRecorder::Clock::now(), TraceRecorder::Clock::now());
+    QCOMPARE(recorder->eventCount(), eventCount);
+
+    const std::string json = recorder->toJson();
+    QVERIFY(json.find("{\"ph\":\"B\",\"name\":\"Traced\"") != std::string::npos);
+    QVERIFY(json.find("{\"ph\":\"E\",\"name\":\"Traced\"") != std::string::npos);
+    QVERIFY(json.find("{\"ph\":\"X\",\"name\":\"job \\\"scope\\\"\"") != std::string::npos);
+    QVERIFY(json.find("{\"ph\":\"i\",\"name\":\"Step\"") != std::string::npos);
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const FilePath filepathTrace = filepathFrom(tempDir.filePath("trace.json"));
+    QVERIFY(recorder->writeFile(filepathTrace));
+    QFile file(filepathTo<QString>(filepathTrace));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.readAll().toStdString() == json);
+}
+
 void Test::TKernelUtils_colorToHex_test()
 {
     QFETCH(int, red);
@@ -788,6 +3599,392 @@ void Test::LibTask_test()
     QCOMPARE(vecProgressRec.back().value, 100);
 }
 
+void Test::LibTask_pool_test()
+{
+    TaskManager taskMgr;
+    taskMgr.setPoolSize(2);
+    QCOMPARE(taskMgr.poolSize(), 2);
+
+    std::mutex mutexWeight;
+    int runningWeight = 0;
+    int maxRunningWeight = 0;
+    auto fnJob = [&](int weight) {
+        return [&, weight](TaskProgress*) {
+            {
+                std::lock_guard<std::mutex> lock(mutexWeight);
+                runningWeight += weight;
+                maxRunningWeight = std::max(maxRunningWeight, runningWeight);
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            std::lock_guard<std::mutex> lock(mutexWeight);
+            runningWeight -= weight;
+        };
+    };
+
+    // Light tasks run at most two at a time
+    std::vector<TaskId> vecTaskId;
+    for (int i = 0; i < 6; ++i)
+        vecTaskId.push_back(taskMgr.newTask(fnJob(1)));
+
+    for (TaskId taskId : vecTaskId)
+        taskMgr.run(taskId, TaskAutoDestroy::Off);
+
+    for (TaskId taskId : vecTaskId)
+        QVERIFY(taskMgr.waitForDone(taskId));
+
+    QCOMPARE(maxRunningWeight, 2);
+
+    // Heavy task runs alone
+    maxRunningWeight = 0;
+    vecTaskId.clear();
+    vecTaskId.push_back(taskMgr.newTask(fnJob(1)));
+    vecTaskId.push_back(taskMgr.newTask(fnJob(2)));
+    vecTaskId.push_back(taskMgr.newTask(fnJob(1)));
+    taskMgr.setWeight(vecTaskId.at(1), 2);
+    QCOMPARE(taskMgr.weight(vecTaskId.at(1)), 2);
+    for (TaskId taskId : vecTaskId)
+        taskMgr.run(taskId, TaskAutoDestroy::Off);
+
+    for (TaskId taskId : vecTaskId)
+        QVERIFY(taskMgr.waitForDone(taskId));
+
+    QCOMPARE(maxRunningWeight, 2);
+    for (TaskId taskId : vecTaskId)
+        QCOMPARE(taskMgr.progress(taskId), 100);
+}
+
+void Test::LibTask_registry_test()
+{
+    TaskManager taskMgr;
+    // Create tasks concurrently while querying the registry
+    std::vector<std::future<std::vector<TaskId>>> vecFuture;
+    for (int i = 0; i < 4; ++i) {
+        vecFuture.push_back(std::async(std::launch::async, [&]{
+            std::vector<TaskId> vecTaskId;
+            for (int j = 0; j < 500; ++j) {
+                vecTaskId.push_back(taskMgr.newTask([](TaskProgress*) {}));
+                taskMgr.globalProgress();
+            }
+
+            return vecTaskId;
+        }));
+    }
+
+    std::vector<TaskId> vecTaskId;
+    for (auto& future : vecFuture) {
+        const std::vector<TaskId> vecThreadTaskId = future.get();
+        vecTaskId.insert(vecTaskId.end(), vecThreadTaskId.cbegin(), vecThreadTaskId.cend());
+    }
+
+    int taskCount = 0;
+    taskMgr.foreachTask([&](TaskId) { ++taskCount; });
+    QCOMPARE(taskCount, 2000);
+    std::sort(vecTaskId.begin(), vecTaskId.end());
+    QVERIFY(std::adjacent_find(vecTaskId.cbegin(), vecTaskId.cend()) == vecTaskId.cend());
+
+    // Slot of a destroyed task is reused, but the stale id doesn't match the new task
+    const TaskId taskId = taskMgr.newTask([](TaskProgress*) {});
+    taskMgr.setTitle(taskId, "first");
+    taskMgr.exec(taskId);
+    // Finished tasks are destroyed on next call to run()/exec()
+    const TaskId otherTaskId = taskMgr.newTask([](TaskProgress*) {});
+    taskMgr.setTitle(otherTaskId, "other");
+    taskMgr.exec(otherTaskId, TaskAutoDestroy::Off);
+    const TaskId reusedTaskId = taskMgr.newTask([](TaskProgress*) {});
+    QVERIFY(reusedTaskId != taskId);
+    QVERIFY(uint32_t(reusedTaskId) == uint32_t(taskId));
+    QVERIFY(taskMgr.title(taskId).isEmpty());
+    QCOMPARE(taskMgr.title(otherTaskId), QString("other"));
+    QCOMPARE(taskMgr.progress(taskId), 0);
+}
+
+void Test::LibTask_progress_test()
+{
+    TaskManager taskMgr;
+    taskMgr.setProgressSignalInterval(60 * 1000);
+    // Sibling progress objects are updated concurrently
+    std::atomic<int> rootValue = 0;
+    const TaskId taskId = taskMgr.newTask([&](TaskProgress* progress) {
+        auto fnSubProgress = [=]{
+            TaskProgress subProgress(progress, 50);
+            for (int i = 0; i <= 100; ++i)
+                subProgress.setValue(i);
+        };
+        auto future = std::async(std::launch::async, fnSubProgress);
+        fnSubProgress();
+        future.get();
+        rootValue = progress->value();
+    });
+
+    std::vector<int> vecProgressValue;
+    std::mutex mutexProgressValue;
+    QObject::connect(&taskMgr, &TaskManager::progressChanged, [&](TaskId, int pct) {
+        std::lock_guard<std::mutex> lock(mutexProgressValue);
+        vecProgressValue.push_back(pct);
+    });
+    taskMgr.run(taskId, TaskAutoDestroy::Off);
+    taskMgr.waitForDone(taskId);
+
+    QCOMPARE(rootValue.load(), 100);
+    // Intermediate values are coalesced, final one is always signaled
+    // Count of signals isn't checked exactly, it depends on the timing of the threads
+    QVERIFY(!vecProgressValue.empty());
+    QVERIFY(vecProgressValue.size() < 100);
+    QCOMPARE(vecProgressValue.back(), 100);
+}
+
+void Test::LibTask_abort_test()
+{
+    TaskManager taskMgr;
+    // Abort request on the task must be visible from nested progress scopes
+    std::atomic<bool> subAbortSeen = false;
+    const TaskId taskId = taskMgr.newTask([&](TaskProgress* progress) {
+        TaskProgress subProgress(progress, 50);
+        TaskProgress subSubProgress(&subProgress, 50);
+        const auto timeStart = std::chrono::steady_clock::now();
+        while (!subSubProgress.isAbortRequested()) {
+            if (std::chrono::steady_clock::now() - timeStart > std::chrono::seconds(5))
+                return;
+
+            std::this_thread::yield();
+        }
+
+        subAbortSeen = true;
+    });
+
+    taskMgr.run(taskId, TaskAutoDestroy::Off);
+    taskMgr.requestAbort(taskId);
+    taskMgr.waitForDone(taskId);
+    QVERIFY(subAbortSeen);
+    QVERIFY(taskMgr.progress(taskId) < 100);
+}
+
+void Test::LibTask_limit_test()
+{
+    TaskManager taskMgr;
+    // Task running longer than its time limit is aborted by the watchdog
+    const TaskId taskId = taskMgr.newTask([&](TaskProgress* progress) {
+        const auto timeStart = std::chrono::steady_clock::now();
+        while (!progress->isAbortRequested()) {
+            if (std::chrono::steady_clock::now() - timeStart > std::chrono::seconds(5))
+                return;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+
+    QCOMPARE(taskMgr.limitExceeded(taskId), TaskLimit::None);
+    taskMgr.setTimeLimit(taskId, 100);
+    taskMgr.run(taskId, TaskAutoDestroy::Off);
+    taskMgr.waitForDone(taskId);
+    QCOMPARE(taskMgr.limitExceeded(taskId), TaskLimit::Time);
+    QVERIFY(taskMgr.progress(taskId) < 100);
+
+    // Limits not reached
+    const TaskId taskOkId = taskMgr.newTask([](TaskProgress*) {});
+    taskMgr.setTimeLimit(taskOkId, 60 * 1000);
+    taskMgr.setMemoryLimit(taskOkId, std::numeric_limits<int64_t>::max());
+    taskMgr.exec(taskOkId, TaskAutoDestroy::Off);
+    QCOMPARE(taskMgr.limitExceeded(taskOkId), TaskLimit::None);
+    QCOMPARE(taskMgr.progress(taskOkId), 100);
+}
+
+void Test::LibTask_dependency_test()
+{
+    TaskManager taskMgr;
+    taskMgr.setPoolSize(4);
+    std::mutex mutexEndOrder;
+    std::vector<int> vecEndOrder;
+    auto fnJob = [&](int value, int msecs) {
+        return [&, value, msecs](TaskProgress*) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(msecs));
+            std::lock_guard<std::mutex> lock(mutexEndOrder);
+            vecEndOrder.push_back(value);
+        };
+    };
+
+    {   // Dependent task is started once all its dependencies are ended
+        const TaskId taskAId = taskMgr.newTask(fnJob(1, 50));
+        const TaskId taskBId = taskMgr.newTask(fnJob(2, 100));
+        const TaskId taskCId = taskMgr.newTask(fnJob(3, 0), { taskAId, taskBId });
+        // Run dependent first, it's held until dependencies are ended
+        taskMgr.run(taskCId, TaskAutoDestroy::Off);
+        taskMgr.run(taskAId, TaskAutoDestroy::Off);
+        taskMgr.run(taskBId, TaskAutoDestroy::Off);
+        const TaskId taskAllId = taskMgr.whenAll({ taskAId, taskBId, taskCId }, {}, TaskAutoDestroy::Off);
+        QVERIFY(taskMgr.waitForDone(taskAllId, 5000));
+        QCOMPARE(vecEndOrder.size(), size_t(3));
+        QCOMPARE(vecEndOrder.back(), 3);
+        QCOMPARE(taskMgr.progress(taskAllId), 100);
+    }
+
+    {   // Continuation of an ended task is started right away
+        vecEndOrder.clear();
+        const TaskId taskAId = taskMgr.newTask(fnJob(1, 0));
+        taskMgr.exec(taskAId, TaskAutoDestroy::Off);
+        const TaskId taskBId = taskMgr.continueWith(taskAId, fnJob(2, 0), TaskAutoDestroy::Off);
+        QVERIFY(taskMgr.waitForDone(taskBId, 5000));
+        QCOMPARE(vecEndOrder, std::vector<int>({ 1, 2 }));
+    }
+
+    {   // Continuation is started even if its dependency was aborted
+        std::atomic<bool> continued = false;
+        const TaskId taskAId = taskMgr.newTask([](TaskProgress* progress) {
+            while (!progress->isAbortRequested())
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        });
+        const TaskId taskBId = taskMgr.continueWith(taskAId, [&](TaskProgress*) { continued = true; }, TaskAutoDestroy::Off);
+        taskMgr.run(taskAId, TaskAutoDestroy::Off);
+        taskMgr.requestAbort(taskAId);
+        QVERIFY(taskMgr.waitForDone(taskBId, 5000));
+        QVERIFY(continued);
+    }
+}
+
+void Test::LibTask_future_test()
+{
+    TaskManager taskMgr;
+    {   // Value is passed along continuations
+        const TaskFuture<int> futureA = taskMgr.newTaskFuture([](TaskProgress*) { return 20; });
+        const TaskFuture<std::string> futureB = taskMgr.continueWith(futureA, [](int value, TaskProgress*) {
+            return std::to_string(value + 1);
+        });
+        QVERIFY(!futureA.isReady());
+        taskMgr.run(futureA.taskId());
+        QVERIFY(futureB.waitForReady(5000));
+        QVERIFY(futureA.hasValue());
+        QCOMPARE(futureA.value(), 20);
+        QVERIFY(futureB.hasValue());
+        QCOMPARE(futureB.value(), std::string("21"));
+    }
+
+    {   // Exception thrown by a job is an error, propagated to continuations
+        const TaskFuture<int> futureA = taskMgr.newTaskFuture([](TaskProgress*) -> int {
+            throw std::runtime_error("Failure");
+        });
+        std::atomic<bool> continued = false;
+        const TaskFuture<int> futureB = taskMgr.continueWith(futureA, [&](int value, TaskProgress*) {
+            continued = true;
+            return value;
+        });
+        taskMgr.exec(futureA.taskId());
+        QVERIFY(futureA.hasError());
+        QCOMPARE(futureA.errorMessage(), QString("Failure"));
+        QVERIFY(futureB.waitForReady(5000));
+        QVERIFY(futureB.hasError());
+        QCOMPARE(futureB.errorMessage(), QString("Failure"));
+        QVERIFY(!continued);
+    }
+
+    {   // Abort requested
+        const TaskFuture<int> future = taskMgr.newTaskFuture([](TaskProgress* progress) {
+            while (!progress->isAbortRequested())
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+            return 0;
+        });
+        taskMgr.run(future.taskId());
+        taskMgr.requestAbort(future.taskId());
+        QVERIFY(future.waitForReady(5000));
+        QVERIFY(future.isAborted());
+    }
+
+    {   // Resume in the thread of a context object, also when the task is already ended
+        QObject context;
+        int readyCount = 0;
+        const TaskFuture<int> future = taskMgr.newTaskFuture([](TaskProgress*) { return 1; });
+        taskMgr.onReady(future, &context, [&](const TaskFuture<int>& f) { readyCount += f.value(); });
+        taskMgr.run(future.taskId(), TaskAutoDestroy::Off);
+        QTRY_COMPARE(readyCount, 1);
+        taskMgr.onReady(future, &context, [&](const TaskFuture<int>& f) { readyCount += f.value(); });
+        QTRY_COMPARE(readyCount, 2);
+    }
+
+    {   // Task destroyed without being run, waiting for the result doesn't block
+        TaskFuture<int> future;
+        {
+            TaskManager otherTaskMgr;
+            future = otherTaskMgr.newTaskFuture([](TaskProgress*) { return 1; });
+            QVERIFY(!future.isReady());
+        }
+
+        QVERIFY(future.waitForReady(5000));
+        QVERIFY(future.isAborted());
+    }
+}
+
+void Test::LibTask_priority_test()
+{
+    TaskManager taskMgr;
+    taskMgr.setPoolSize(1);
+    auto fnWaitFor = [](const std::atomic<bool>& flag) {
+        const auto timeStart = std::chrono::steady_clock::now();
+        while (!flag && std::chrono::steady_clock::now() - timeStart < std::chrono::seconds(5))
+            std::this_thread::yield();
+    };
+
+    {   // Queued tasks are started by priority
+        std::atomic<bool> blockerStarted = false;
+        std::atomic<bool> blockerReleased = false;
+        std::mutex mutexStartOrder;
+        std::vector<TaskPriority> vecStartOrder;
+        auto fnJob = [&](TaskPriority priority) {
+            return [&, priority](TaskProgress*) {
+                std::lock_guard<std::mutex> lock(mutexStartOrder);
+                vecStartOrder.push_back(priority);
+            };
+        };
+
+        const TaskId blockerId = taskMgr.newTask([&](TaskProgress*) {
+            blockerStarted = true;
+            fnWaitFor(blockerReleased);
+        });
+        taskMgr.run(blockerId, TaskAutoDestroy::Off);
+        fnWaitFor(blockerStarted);
+        std::vector<TaskId> vecTaskId = { blockerId };
+        for (TaskPriority priority : { TaskPriority::Background, TaskPriority::Normal, TaskPriority::Interactive }) {
+            vecTaskId.push_back(taskMgr.newTask(fnJob(priority), priority));
+            QCOMPARE(taskMgr.priority(vecTaskId.back()), priority);
+            taskMgr.run(vecTaskId.back(), TaskAutoDestroy::Off);
+        }
+
+        blockerReleased = true;
+        for (TaskId taskId : vecTaskId)
+            QVERIFY(taskMgr.waitForDone(taskId));
+
+        const std::vector<TaskPriority> vecExpectedOrder = {
+            TaskPriority::Interactive, TaskPriority::Normal, TaskPriority::Background
+        };
+        QVERIFY(vecStartOrder == vecExpectedOrder);
+    }
+
+    {   // Background task is preempted at progress checkpoints
+        std::atomic<bool> backgroundStarted = false;
+        std::atomic<bool> interactiveDone = false;
+        std::atomic<bool> backgroundSawInteractiveDone = false;
+        const TaskId backgroundId = taskMgr.newTask([&](TaskProgress* progress) {
+            backgroundStarted = true;
+            const auto timeStart = std::chrono::steady_clock::now();
+            int i = 0;
+            while (!interactiveDone && std::chrono::steady_clock::now() - timeStart < std::chrono::seconds(5))
+                progress->setValue(++i % 100);
+
+            backgroundSawInteractiveDone = interactiveDone.load();
+        }, TaskPriority::Background);
+        taskMgr.run(backgroundId, TaskAutoDestroy::Off);
+        fnWaitFor(backgroundStarted);
+
+        const TaskId interactiveId = taskMgr.newTask([&](TaskProgress*) {
+            interactiveDone = true;
+        }, TaskPriority::Interactive);
+        taskMgr.run(interactiveId, TaskAutoDestroy::Off);
+        QVERIFY(taskMgr.waitForDone(interactiveId));
+        QVERIFY(taskMgr.waitForDone(backgroundId));
+        QVERIFY(backgroundSawInteractiveDone);
+    }
+}
+
 void Test::LibTree_test()
 {
     const TreeNodeId nullptrId = 0;
@@ -841,6 +4038,472 @@ void Test::LibTree_test()
     }
 }
 
+void Test::LibTree_appendTree_test()
+{
+    const TreeNodeId nullptrId = 0;
+    Tree<std::string> tree;
+    const TreeNodeId n0 = tree.appendChild(nullptrId, "0");
+    const TreeNodeId n0_1 = tree.appendChild(n0, "0-1");
+
+    Tree<std::string> subTree;
+    const TreeNodeId s0 = subTree.appendChild(nullptrId, "s0");
+    subTree.appendChild(s0, "s0-1");
+    subTree.appendChild(s0, "s0-2");
+    const TreeNodeId s1 = subTree.appendChild(nullptrId, "s1");
+
+    const TreeNodeId offset = tree.appendTree(n0, std::move(subTree));
+    QVERIFY(subTree.roots().empty());
+    QCOMPARE(int(tree.roots().size()), 1);
+    QCOMPARE(tree.nodeParent(s0 + offset), n0);
+    QCOMPARE(tree.nodeParent(s1 + offset), n0);
+    QCOMPARE(tree.nodeSiblingNext(n0_1), s0 + offset);
+    QCOMPARE(tree.nodeSiblingPrevious(s0 + offset), n0_1);
+    QCOMPARE(tree.nodeSiblingNext(s0 + offset), s1 + offset);
+    QCOMPARE(tree.nodeChildLast(n0), s1 + offset);
+    QCOMPARE(tree.nodeData(s1 + offset), std::string("s1"));
+
+    std::string strPreOrder;
+    traverseTree_preOrder(tree, [&](TreeNodeId id) {
+        strPreOrder += " " + tree.nodeData(id);
+    });
+    QCOMPARE(strPreOrder, " 0 0-1 s0 s0-1 s0-2 s1");
+
+    // Append as roots
+    Tree<std::string> rootTree;
+    rootTree.appendChild(nullptrId, "r0");
+    const TreeNodeId rootOffset = tree.appendTree(nullptrId, std::move(rootTree));
+    QCOMPARE(int(tree.roots().size()), 2);
+    QCOMPARE(tree.roots().back(), rootOffset + 1);
+    QVERIFY(tree.nodeIsRoot(rootOffset + 1));
+}
+
+void Test::LibTree_bulk_test()
+{
+    using PreOrderNode = Tree<std::string>::PreOrderNode;
+    const TreeNodeId nullptrId = 0;
+    Tree<std::string> tree;
+    tree.reserve(8);
+    const TreeNodeId n0 = tree.appendChild(nullptrId, "0");
+    const PreOrderNode arrayNode[] = {
+        { 0, "0-1" }, { 1, "0-1-1" }, { 1, "0-1-2" }, { 2, "0-1-2-1" }, { 0, "0-2" }
+    };
+    const TreeNodeId n0_1 = tree.appendChildren(n0, arrayNode);
+    const TreeNodeId n1 = tree.appendChild(nullptrId, "1");
+    tree.appendChild(n1, "1-1");
+    const TreeNodeId n2 = tree.appendChild(nullptrId, "2");
+    QCOMPARE(tree.nodeData(n0_1), std::string("0-1"));
+    QCOMPARE(tree.nodeCount(), size_t(9));
+
+    auto fnPreOrderString = [&]{
+        std::string str;
+        traverseTree_preOrder(tree, [&](TreeNodeId id) { str += " " + tree.nodeData(id); });
+        return str;
+    };
+    QCOMPARE(fnPreOrderString(), " 0 0-1 0-1-1 0-1-2 0-1-2-1 0-2 1 1-1 2");
+
+    // Remove an entity then reclaim its nodes
+    tree.removeRoot(n1);
+    const std::vector<TreeNodeId> vecIdRemap = tree.compact();
+    QCOMPARE(tree.nodeCount(), size_t(7));
+    QCOMPARE(vecIdRemap.at(n1), nullptrId);
+    QCOMPARE(vecIdRemap.at(n0), n0);
+    QCOMPARE(vecIdRemap.at(n2), TreeNodeId(7));
+    QCOMPARE(int(tree.roots().size()), 2);
+    QCOMPARE(tree.roots().back(), TreeNodeId(7));
+    QCOMPARE(fnPreOrderString(), " 0 0-1 0-1-1 0-1-2 0-1-2-1 0-2 2");
+}
+
+void Test::LibTree_deep_test()
+{
+    // Traversals must not recurse, whatever the depth of the tree
+    constexpr int depth = 200000;
+    Tree<int> tree;
+    tree.reserve(depth + 1);
+    TreeNodeId nodeId = 0;
+    for (int i = 0; i < depth; ++i)
+        nodeId = tree.appendChild(nodeId, i);
+
+    const TreeNodeId rootId = tree.roots().front();
+    QVERIFY(tree.hasPreOrderLayout());
+    QCOMPARE(tree.nodeSubTreeEnd(rootId), TreeNodeId(depth + 1));
+    QCOMPARE(tree.nodeSubTreeEnd(nodeId), nodeId + 1);
+
+    auto fnCheckTraversals = [&](int nodeCount) {
+        int preOrderCount = 0;
+        int previousData = -1;
+        bool isPreOrderOk = true;
+        traverseTree_preOrder(tree, [&](TreeNodeId id) {
+            isPreOrderOk = isPreOrderOk && tree.nodeData(id) > previousData;
+            previousData = tree.nodeData(id);
+            ++preOrderCount;
+        });
+        QVERIFY(isPreOrderOk);
+        QCOMPARE(preOrderCount, nodeCount);
+
+        int postOrderCount = 0;
+        TreeNodeId lastPostOrderId = 0;
+        traverseTree_postOrder(tree, [&](TreeNodeId id) {
+            lastPostOrderId = id;
+            ++postOrderCount;
+        });
+        QCOMPARE(postOrderCount, nodeCount);
+        QCOMPARE(lastPostOrderId, tree.roots().back());
+    };
+
+    fnCheckTraversals(depth);
+
+    // Appending a child to the first root once another root exists breaks the pre-order layout
+    tree.appendChild(0, depth + 1);
+    QVERIFY(tree.hasPreOrderLayout());
+    tree.appendChild(rootId, depth);
+    QVERIFY(!tree.hasPreOrderLayout());
+    fnCheckTraversals(depth + 2);
+}
+
+void Test::LibTree_parallel_test()
+{
+    // Tree big enough to be split into several chunks
+    constexpr int rootCount = 4;
+    constexpr int childCount = 1000;
+    constexpr TreeNodeId grainSize = 64;
+    Tree<int> tree;
+    for (int i = 0; i < rootCount; ++i) {
+        const TreeNodeId rootId = tree.appendChild(0, 1);
+        for (int j = 0; j < childCount; ++j)
+            tree.appendChild(tree.appendChild(rootId, 2), 3);
+    }
+
+    const int64_t expectedSum = rootCount * (1 + childCount * (2 + 3));
+    auto fnCheck = [&](int64_t nodeCount, int64_t sum) {
+        // Each node is visited once
+        std::vector<int> vecVisitCount(tree.nodeCount() + 1, 0);
+        traverseTree_parallel(tree, [&](TreeNodeId id) { ++vecVisitCount[id]; }, grainSize);
+        QCOMPARE(int64_t(std::count(vecVisitCount.cbegin(), vecVisitCount.cend(), 1)), nodeCount);
+
+        auto fnNodeData = [&](TreeNodeId id) { return int64_t(tree.nodeData(id)); };
+        QCOMPARE(reduceTree(tree, int64_t(0), fnNodeData, std::plus<>(), grainSize), sum);
+
+        // Subtrees, merged in the order of the input roots
+        std::vector<TreeNodeId> vecRootId(tree.roots().begin(), tree.roots().end());
+        const std::string strRoots = mapSubtrees(
+                    tree, vecRootId, std::string(),
+                    [&](TreeNodeId rootId) {
+                        std::atomic<int> subtreeNodeCount = 0;
+                        traverseTree_parallel(rootId, tree, [&](TreeNodeId) { ++subtreeNodeCount; }, grainSize);
+                        return std::to_string(rootId) + ":" + std::to_string(subtreeNodeCount) + " ";
+                    },
+                    std::plus<>(),
+                    grainSize);
+        std::string strExpected;
+        for (TreeNodeId rootId : vecRootId) {
+            int subtreeNodeCount = 0;
+            traverseTree(rootId, tree, [&](TreeNodeId) { ++subtreeNodeCount; });
+            strExpected += std::to_string(rootId) + ":" + std::to_string(subtreeNodeCount) + " ";
+        }
+
+        QCOMPARE(strRoots, strExpected);
+    };
+
+    const int64_t nodeCount = rootCount * (1 + 2 * childCount);
+    fnCheck(nodeCount, expectedSum);
+
+    // Deleted nodes are skipped
+    tree.removeRoot(tree.roots().front());
+    fnCheck(nodeCount - (1 + 2 * childCount), expectedSum - (1 + childCount * (2 + 3)));
+
+    // Subtree isn't a contiguous range of identifiers anymore
+    tree.appendChild(tree.roots().front(), 4);
+    QVERIFY(!tree.hasPreOrderLayout());
+    fnCheck(nodeCount - 2 * childCount, expectedSum - (1 + childCount * (2 + 3)) + 4);
+}
+
+void Test::PartBvh_test()
+{
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+
+    // Grid of 10x10 unit boxes, each box is an entity
+    std::vector<TreeNodeId> vecFirstRowId;
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(gp_Pnt(2 * i, 2 * j, 0), 1, 1, 1);
+            doc->addEntityTreeNode(doc->xcaf().shapeTool()->AddShape(shapeBox, false));
+            if (j == 0)
+                vecFirstRowId.push_back(doc->entityTreeNodeId(doc->entityCount() - 1));
+        }
+    }
+
+    PartBvh bvh;
+    for (int i = 0; i < doc->entityCount(); ++i)
+        bvh.addEntity(doc, doc->entityTreeNodeId(i));
+
+    QCOMPARE(bvh.partCount(), size_t(100));
+    QCOMPARE(bvh.findInBox(bvh.boundingBox()).size(), size_t(100));
+
+    Bnd_Box queryBox;
+    queryBox.Update(0.25, 0.25, 0.25, 0.75, 0.75, 0.75);
+    QVERIFY(bvh.findInBox(queryBox) == std::vector<TreeNodeId>({ vecFirstRowId.front() }));
+
+    // Ray along the first row, parts are sorted by distance
+    const gp_Ax1 ray(gp_Pnt(-5, 0.5, 0.5), gp::DX());
+    QVERIFY(bvh.findAlongRay(ray) == vecFirstRowId);
+    QVERIFY(bvh.findAlongRay(ray.Reversed()).empty());
+    QVERIFY(bvh.findAlongRay(gp_Ax1(gp_Pnt(-5, 1.5, 0.5), gp::DX())).empty());
+
+    // Frustum keeping the first two columns
+    const gp_Pln planes[] = {
+        gp_Pln(gp_Pnt(-0.5, 0, 0), gp::DX()),
+        gp_Pln(gp_Pnt(2.5, 0, 0), -gp::DX())
+    };
+    QCOMPARE(bvh.findInFrustum(planes).size(), size_t(20));
+
+    bvh.removeEntity(vecFirstRowId.front());
+    QCOMPARE(bvh.partCount(), size_t(99));
+    QVERIFY(bvh.findInBox(queryBox).empty());
+    bvh.clear();
+    QCOMPARE(bvh.partCount(), size_t(0));
+}
+
+void Test::ClashDetection_trianglesIntersect_test()
+{
+    const gp_XYZ triA[] = { { 0, 0, 0 }, { 2, 0, 0 }, { 0, 2, 0 } };
+    // Crossing the plane of 'triA' through its interior
+    const gp_XYZ triCrossing[] = { { 0.5, 0.5, -1 }, { 0.5, 0.5, 1 }, { 1, 0.25, 1 } };
+    QVERIFY(ClashDetection::trianglesIntersect(triA, triCrossing));
+    QVERIFY(ClashDetection::trianglesIntersect(triCrossing, triA));
+
+    // Crossing the plane of 'triA' outside of it
+    const gp_XYZ triSeparated[] = { { 5, 5, -1 }, { 5, 5, 1 }, { 6, 5, 1 } };
+    QVERIFY(!ClashDetection::trianglesIntersect(triA, triSeparated));
+
+    // Touching 'triA' by a vertex, and coplanar overlapping
+    const gp_XYZ triTouching[] = { { 0.5, 0.5, 0 }, { 0.5, 0.5, 1 }, { 1, 0.25, 1 } };
+    QVERIFY(!ClashDetection::trianglesIntersect(triA, triTouching));
+    const gp_XYZ triCoplanar[] = { { 0.5, 0.5, 0 }, { 3, 0.5, 0 }, { 0.5, 3, 0 } };
+    QVERIFY(!ClashDetection::trianglesIntersect(triA, triCoplanar));
+
+    // Degenerated triangle
+    const gp_XYZ triFlat[] = { { 0.5, 0.5, -1 }, { 0.5, 0.5, 1 }, { 0.5, 0.5, 0 } };
+    QVERIFY(!ClashDetection::trianglesIntersect(triA, triFlat));
+}
+
+void Test::ClashDetection_test()
+{
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+
+    OccBRepMeshParameters params;
+    params.Deflection = 0.1;
+    params.Angle = 0.5;
+    auto fnAddBox = [&](const gp_Pnt& pnt, double size) {
+        const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(pnt, size, size, size);
+        BRepUtils::computeMesh(shapeBox, params);
+        doc->addEntityTreeNode(doc->xcaf().shapeTool()->AddShape(shapeBox, false));
+        return doc->entityTreeNodeId(doc->entityCount() - 1);
+    };
+
+    // Overlapping boxes
+    const TreeNodeId boxAId = fnAddBox(gp_Pnt(0, 0, 0), 2);
+    const TreeNodeId boxBId = fnAddBox(gp_Pnt(1, 1, 1), 2);
+    // Boxes in flush contact, their boxes overlap but they don't clash
+    fnAddBox(gp_Pnt(10, 0, 0), 2);
+    fnAddBox(gp_Pnt(12, 0, 0), 2);
+    // Separated box
+    fnAddBox(gp_Pnt(20, 0, 0), 2);
+
+    PartBvh bvh;
+    for (int i = 0; i < doc->entityCount(); ++i)
+        bvh.addEntity(doc, doc->entityTreeNodeId(i));
+
+    QCOMPARE(bvh.findOverlappingPairs().size(), size_t(2));
+    const std::vector<ClashDetection::Clash> vecClash = ClashDetection::findClashes(doc, bvh);
+    QCOMPARE(vecClash.size(), size_t(1));
+    const std::set<TreeNodeId> setClashNodeId = { vecClash.front().firstNodeId, vecClash.front().secondNodeId };
+    QVERIFY(setClashNodeId == std::set<TreeNodeId>({ boxAId, boxBId }));
+}
+
+void Test::CrossSection_test()
+{
+    auto app = Application::instance();
+    DocumentPtr doc = app->newDocument();
+    auto _ = gsl::finally([=]{ app->closeDocument(doc); });
+
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(2, 2, 2);
+    doc->addEntityTreeNode(doc->xcaf().shapeTool()->AddShape(shapeBox, false));
+    const TreeNodeId boxId = doc->entityTreeNodeId(0);
+    const std::vector<TreeNodeId> vecPartId = { boxId };
+    auto fnSectionLength = [](const CrossSection::PartSection& partSection) {
+        double length = 0.;
+        for (const CrossSection::Segment& segment : partSection.vecSegment)
+            length += segment.start.Distance(segment.end);
+
+        return length;
+    };
+
+    // Plane at mid-height of the box, section is a square of side 2
+    const gp_Pln planeMid(gp_Pnt(0, 0, 1), gp::DZ());
+    {
+        const auto vecSection = CrossSection::compute(doc, vecPartId, planeMid, {});
+        QCOMPARE(vecSection.size(), size_t(1));
+        QCOMPARE(vecSection.front().partId, boxId);
+        QVERIFY(std::abs(fnSectionLength(vecSection.front()) - 8.) < Precision::Confusion());
+    }
+
+    // Triangulation slicing gives the same square
+    OccBRepMeshParameters params;
+    params.Deflection = 0.1;
+    params.Angle = 0.5;
+    BRepUtils::computeMesh(shapeBox, params);
+    {
+        CrossSection::Parameters sectionParams;
+        sectionParams.useTriangulation = true;
+        const auto vecSection = CrossSection::compute(doc, vecPartId, planeMid, sectionParams);
+        QCOMPARE(vecSection.size(), size_t(1));
+        QVERIFY(std::abs(fnSectionLength(vecSection.front()) - 8.) < Precision::Confusion());
+    }
+
+    // Plane not crossing the box
+    QVERIFY(CrossSection::compute(doc, vecPartId, gp_Pln(gp_Pnt(0, 0, 5), gp::DZ()), {}).empty());
+
+    // Export
+    const auto vecSection = CrossSection::compute(doc, vecPartId, planeMid, {});
+    std::ostringstream svg;
+    QVERIFY(CrossSection::write(svg, CrossSection::FileFormat::Svg, planeMid, vecSection));
+    QVERIFY(svg.str().find("<path") != std::string::npos);
+    std::ostringstream dxf;
+    QVERIFY(CrossSection::write(dxf, CrossSection::FileFormat::Dxf, planeMid, vecSection));
+    QVERIFY(dxf.str().find("LINE") != std::string::npos);
+    QCOMPARE(CrossSection::fileFormat("section.SVG"), CrossSection::FileFormat::Svg);
+    QCOMPARE(CrossSection::fileFormat("section.dxf"), CrossSection::FileFormat::Dxf);
+    QCOMPARE(CrossSection::fileFormat("section.txt"), CrossSection::FileFormat::Unknown);
+}
+
+void Test::MeshQualityAnalysis_test()
+{
+    // Aspect ratio
+    const double sqrt3 = std::sqrt(3.);
+    QVERIFY(std::abs(MeshQualityAnalysis::triangleAspectRatio({ 0, 0, 0 }, { 1, 0, 0 }, { 0.5, sqrt3 / 2, 0 }) - 1.) < 1e-9);
+    QCOMPARE(MeshQualityAnalysis::triangleAspectRatio({ 0, 0, 0 }, { 1, 0, 0 }, { 2, 0, 0 }), RealLast());
+
+    // Square made of two triangles with consistent orientation
+    Handle_Poly_Triangulation mesh = new Poly_Triangulation(4, 2, false);
+    mesh->ChangeNode(1) = gp_Pnt(0, 0, 0);
+    mesh->ChangeNode(2) = gp_Pnt(1, 0, 0);
+    mesh->ChangeNode(3) = gp_Pnt(1, 1, 0);
+    mesh->ChangeNode(4) = gp_Pnt(0, 1, 0);
+    mesh->ChangeTriangle(1) = Poly_Triangle(1, 2, 3);
+    mesh->ChangeTriangle(2) = Poly_Triangle(1, 3, 4);
+    {
+        const MeshQualityAnalysis::Report report = MeshQualityAnalysis::analyze(mesh);
+        QCOMPARE(report.nodeCount, 4);
+        QCOMPARE(report.triangleCount, 2);
+        QCOMPARE(report.boundaryEdgeCount, 4);
+        QCOMPARE(report.inconsistentEdgeCount, 0);
+        QCOMPARE(report.nonManifoldEdgeCount, 0);
+        QCOMPARE(report.degenerateTriangleCount, 0);
+        QCOMPARE(report.sliverTriangleCount, 0);
+        QCOMPARE(report.duplicateNodeCount, 0);
+        QVERIFY(report.vecProblemTriangle.empty());
+        QCOMPARE(std::accumulate(report.aspectRatioHistogram.cbegin(), report.aspectRatioHistogram.cend(), 0), 2);
+    }
+
+    // Second triangle flipped
+    mesh->ChangeTriangle(2) = Poly_Triangle(1, 4, 3);
+    {
+        const MeshQualityAnalysis::Report report = MeshQualityAnalysis::analyze(mesh);
+        QCOMPARE(report.inconsistentEdgeCount, 1);
+        QCOMPARE(report.vecProblemTriangle.size(), size_t(2));
+        QVERIFY(report.hasProblems());
+    }
+
+    // Non-manifold edge, duplicate node and degenerate triangle
+    Handle_Poly_Triangulation meshBad = new Poly_Triangulation(6, 4, false);
+    meshBad->ChangeNode(1) = gp_Pnt(0, 0, 0);
+    meshBad->ChangeNode(2) = gp_Pnt(1, 0, 0);
+    meshBad->ChangeNode(3) = gp_Pnt(0, 1, 0);
+    meshBad->ChangeNode(4) = gp_Pnt(0, -1, 0);
+    meshBad->ChangeNode(5) = gp_Pnt(0, 0, 1);
+    meshBad->ChangeNode(6) = gp_Pnt(1, 0, 0); // Same as node 2
+    meshBad->ChangeTriangle(1) = Poly_Triangle(1, 2, 3);
+    meshBad->ChangeTriangle(2) = Poly_Triangle(2, 1, 4);
+    meshBad->ChangeTriangle(3) = Poly_Triangle(2, 1, 5);
+    meshBad->ChangeTriangle(4) = Poly_Triangle(1, 2, 6);
+    {
+        const MeshQualityAnalysis::Report report = MeshQualityAnalysis::analyze(meshBad);
+        QCOMPARE(report.duplicateNodeCount, 1);
+        QCOMPARE(report.degenerateTriangleCount, 1);
+        QVERIFY(report.nonManifoldEdgeCount >= 1);
+        QCOMPARE(report.vecProblemTriangle.size(), size_t(4));
+    }
+
+    // Meshed BRep faces
+    const TopoDS_Shape shapeBox = BRepPrimAPI_MakeBox(2, 2, 2);
+    BRepUtils::computeMesh(shapeBox, OccBRepMeshParameters{});
+    {
+        const MeshQualityAnalysis::Report report = MeshQualityAnalysis::analyze(shapeBox);
+        QCOMPARE(report.triangleCount, 12);
+        QVERIFY(!report.hasProblems());
+    }
+}
+
+void Test::JobArena_test()
+{
+    QVERIFY(JobArena::current().IsNull());
+    const NCollection_IncAllocator* ptrArena = nullptr;
+    {
+        const JobArena::Scope scope;
+        QVERIFY(!JobArena::current().IsNull());
+        ptrArena = JobArena::current().get();
+        // Collections accept the arena
+        TopTools_MapOfShape mapShape(1, JobArena::current());
+        mapShape.Add(BRepPrimAPI_MakeBox(1, 1, 1));
+        QCOMPARE(mapShape.Extent(), 1);
+        {
+            const JobArena::Scope scopeNested;
+            QVERIFY(JobArena::current().get() != ptrArena);
+        }
+
+        QCOMPARE(JobArena::current().get(), ptrArena);
+        // Arena isn't visible from other threads
+        bool isNullInOtherThread = false;
+        std::thread([&]{ isNullInOtherThread = JobArena::current().IsNull(); }).join();
+        QVERIFY(isNullInOtherThread);
+    }
+
+    QVERIFY(JobArena::current().IsNull());
+    QVERIFY(JobArena::pooledCount() >= 2);
+    // Arenas are recycled, last released first
+    const JobArena::Scope scope;
+    QCOMPARE(JobArena::current().get(), ptrArena);
+}
+
+void Test::TreeNameIndex_test()
+{
+    TreeNameIndex index;
+    index.add(1, "Bolt M8");
+    index.add(2, "Nut");
+    index.add(3, "bracket_left");
+    index.add(4, "BRACKET right");
+    index.add(5, "Brace");
+    QCOMPARE(index.size(), size_t(5));
+
+    using VecNodeId = std::vector<TreeNodeId>;
+    // Trigram search, case is ignored
+    QVERIFY(index.find("bracket") == VecNodeId({ 3, 4 }));
+    QVERIFY(index.find("BOLT") == VecNodeId({ 1 }));
+    QVERIFY(index.find("et r") == VecNodeId({ 4 }));
+    QVERIFY(index.find("brac") == VecNodeId({ 3, 4, 5 }));
+    // Some trigrams of the query aren't contained in any name
+    QVERIFY(index.find("nutbolt").empty());
+    QVERIFY(index.find("xyz").empty());
+    // Queries shorter than a trigram
+    QVERIFY(index.find("br") == VecNodeId({ 3, 4, 5 }));
+    QVERIFY(index.find("t") == VecNodeId({ 1, 2, 3, 4 }));
+    QVERIFY(index.find("").empty());
+}
+
 void Test::QtGuiUtils_test()
 {
     const QColor qtColor(51, 75, 128);
@@ -856,7 +4519,11 @@ void Test::initTestCase()
     IO::System* ioSystem = Application::instance()->ioSystem();
     ioSystem->addFactoryReader(std::make_unique<IO::OccFactoryReader>());
     ioSystem->addFactoryWriter(std::make_unique<IO::OccFactoryWriter>());
+    ioSystem->addFactoryReader(std::make_unique<IO::PlyFactoryReader>());
+    ioSystem->addFactoryWriter(std::make_unique<IO::PlyFactoryWriter>());
+    ioSystem->addFactoryReader(std::make_unique<IO::PointCloudFactoryReader>());
     IO::addPredefinedFormatProbes(ioSystem);
+    IO::addPredefinedMetadataScanners(ioSystem);
 }
 
 } // namespace Mayo
@@ -15,6 +15,7 @@ class Test : public QObject {
     Q_OBJECT
 private slots:
     void Application_test();
+    void ApplicationItemSelectionModel_test();
 
     void TextId_test();
 
@@ -29,27 +30,94 @@ private slots:
     void IO_test_data();
     void IO_OccStaticVariablesRollback_test();
     void IO_OccStaticVariablesRollback_test_data();
+    void IO_OccStaticVariablesContext_test();
+    void IO_OccShapeHealing_test();
+    void IO_OccShapeHealing_test_data();
+    void IO_OccIgesReader_parallelTransfer_test();
+    void IO_OccStepReader_concurrentUnits_test();
+    void IO_OccStlReader_test();
+    void IO_OccStlReader_test_data();
+    void IO_OccStlWriter_test();
+    void IO_OccStlWriter_test_data();
+    void IO_streams_test();
+    void IO_compressedInput_test();
+    void IO_asyncFileStreams_test();
+    void IO_scanMetadata_STEP_test();
+    void IO_readerPool_test();
+    void IO_ThreeMfWriter_test();
+    void IO_OccObjWriter_test();
+    void IO_PlyReaderWriter_test();
+    void IO_PlyReaderWriter_test_data();
+    void IO_PointCloudReader_test();
+    void IO_ExportSplitUtils_test();
+    void IO_OccBRepWriter_test();
+    void IO_OccBRepWriter_test_data();
+    void IO_OccVrmlWriter_test();
+    void IO_OccObjReader_test();
+    void IO_OccObjReader_fastParsing_test();
+    void IO_OccObjReader_fastParsingGroups_test();
 
     void BRepUtils_test();
+    void BRepUtils_meshJobs_test();
+    void BRepUtils_meshJobsPriorities_test();
+    void BRepUtils_findCoarseMeshFaces_test();
+    void BRepUtils_addEdgeNeighbourFaces_test();
+    void BRepUtils_boundingBox_test();
+    void BRepUtils_meshLods_test();
+
+    void BRepMeshCache_test();
+    void BRepMeshQuality_test();
+    void BRepMeshBudget_test();
 
     void CafUtils_test();
+    void XCaf_topLevelFreeShapesAfter_test();
+
+    void FlatHashMap_test();
+
+    void MassProperties_test();
+    void ShapeDistance_test();
+    void GeometryDedup_test();
+    void ReimportDiff_test();
+
+    void MemoryStats_test();
+    void ProcessUtils_test();
+
+    void MeshCompression_test();
+    void MeshDecimation_test();
 
     void MeshUtils_test();
     void MeshUtils_test_data();
     void MeshUtils_orientation_test();
     void MeshUtils_orientation_test_data();
+    void MeshUtils_normals_test();
+    void MeshUtils_vertexCache_test();
+    void MeshUtils_featureEdges_test();
+    void MeshUtils_smoothNormals_test();
+    void MeshUtils_singlePrecision_test();
+
+    void Messenger_batch_test();
 
     void MetaEnum_test();
 
+    void PerfStats_test();
+
     void Quantity_test();
 
     void Result_test();
 
+    void Settings_pendingValues_test();
+    void Settings_applyValue_test();
+    void Settings_changedBatch_test();
+    void Settings_unsavedChanges_test();
+
     void StringUtils_append_test();
     void StringUtils_append_test_data();
     void StringUtils_text_test();
     void StringUtils_text_test_data();
     void StringUtils_stringConversion_test();
+    void StringUtils_appendNumber_test();
+
+    void TraceRecorder_test();
 
     void TKernelUtils_colorToHex_test();
     void TKernelUtils_colorToHex_test_data();
@@ -60,7 +128,26 @@ private slots:
     void UnitSystem_test_data();
 
     void LibTask_test();
+    void LibTask_pool_test();
+    void LibTask_registry_test();
+    void LibTask_progress_test();
+    void LibTask_abort_test();
+    void LibTask_limit_test();
+    void LibTask_dependency_test();
+    void LibTask_future_test();
+    void LibTask_priority_test();
     void LibTree_test();
+    void LibTree_appendTree_test();
+    void LibTree_bulk_test();
+    void LibTree_deep_test();
+    void LibTree_parallel_test();
+    void PartBvh_test();
+    void ClashDetection_trianglesIntersect_test();
+    void ClashDetection_test();
+    void CrossSection_test();
+    void MeshQualityAnalysis_test();
+    void JobArena_test();
+    void TreeNameIndex_test();
 
     void QtGuiUtils_test();
 
@@ -0,0 +1,18 @@
+#****************************************************************************
+#* Copyright (c) 2021, Fougue Ltd. <http://www.fougue.pro>
+#* All rights reserved.
+#* See license at https://github.com/fougue/mayo/blob/master/LICENSE.txt
+#****************************************************************************
+
+# Optional zlib, needed to read compressed input files(eg .stp.gz, .stpZ, zipped STL/OBJ)
+# Enabled with ZLIB_ROOT set to the zlib install prefix(eg /usr on Linux)
+isEmpty(ZLIB_ROOT) {
+    message(zlib OFF)
+} else {
+    message(zlib ON)
+    INCLUDEPATH += $$ZLIB_ROOT/include
+    LIBS += -L$$ZLIB_ROOT/lib
+    win*:LIBS += -lzlib
+    else:LIBS += -lz
+    DEFINES += HAVE_ZLIB
+}